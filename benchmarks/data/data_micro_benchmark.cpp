@@ -0,0 +1,332 @@
+/*******************************************************************************
+ * benchmarks/data/data_micro_benchmark.cpp
+ *
+ * Micro benchmarks of the data path: BlockWriter::Put() and BlockReader::Next()
+ * of File for POD, string, pair, and tuple items, keep and consume reads,
+ * CatStream versus MixStream local loopback, and Scatter() with block aligned
+ * and unaligned offsets. Each benchmark is repeated until a minimum time has
+ * passed and reports ns/item and GB/s.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/context.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/stats_timer.hpp>
+#include <thrill/data/cat_stream.hpp>
+#include <thrill/data/file.hpp>
+#include <thrill/data/mix_stream.hpp>
+#include <tlx/cmdline_parser.hpp>
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "data_generators.hpp"
+
+using namespace thrill; // NOLINT
+
+using PodPair = std::pair<size_t, size_t>;
+
+//! bytes of items generated per worker
+static size_t g_bytes = 16 * 1024 * 1024;
+//! minimum and maximum length of generated strings
+static size_t g_min_size = 8, g_max_size = 64;
+//! minimum time to repeat each benchmark
+static double g_min_time = 0.5;
+//! number of workers of the stream benchmarks
+static size_t g_workers = 4;
+//! run only benchmarks whose name contains this string
+static std::string g_filter;
+
+//! keep the compiler from discarding a value read in a benchmark loop
+template <typename Type>
+static inline void DoNotOptimize(const Type& value) {
+    asm volatile ("" : : "r" (&value) : "memory");
+}
+
+template <typename Type>
+std::vector<Type> GenerateItems() {
+    return generate<Type>(g_bytes, g_min_size, g_max_size);
+}
+
+template <>
+std::vector<PodPair> GenerateItems<PodPair>() {
+    std::vector<PodPair> items(g_bytes / sizeof(PodPair));
+    for (size_t i = 0; i < items.size(); ++i)
+        items[i] = PodPair(i, 42 + i);
+    return items;
+}
+
+//! names of item types
+template <typename Type>
+struct TypeName;
+
+template <>
+struct TypeName<size_t> {
+    static const char * name() { return "size_t"; }
+};
+template <>
+struct TypeName<std::string> {
+    static const char * name() { return "string"; }
+};
+template <>
+struct TypeName<PodPair> {
+    static const char * name() { return "pod_pair"; }
+};
+template <>
+struct TypeName<Tuple> {
+    static const char * name() { return "pair"; }
+};
+template <>
+struct TypeName<Triple> {
+    static const char * name() { return "tuple"; }
+};
+
+/*!
+ * Repeats run() until g_min_time has passed, like Google Benchmark does. run()
+ * returns the seconds of the timed part of one iteration, which excludes its
+ * setup. items and bytes are those processed by one iteration on each worker;
+ * the slowest worker determines the time, such that all workers run the same
+ * number of iterations.
+ */
+template <typename Run>
+void Measure(api::Context& ctx, const std::string& name, const char* type,
+             size_t items, size_t bytes, const Run& run) {
+    if (!g_filter.empty() && name.find(g_filter) == std::string::npos)
+        return;
+
+    size_t iterations = 0;
+    double seconds = 0;
+    do {
+        seconds += ctx.net.AllReduce(run(), common::maximum<double>());
+        ++iterations;
+    } while (seconds < g_min_time);
+
+    if (ctx.my_rank() != 0) return;
+
+    double total_items = static_cast<double>(iterations * items);
+    double total_bytes =
+        static_cast<double>(iterations * bytes * ctx.num_workers());
+
+    std::cout << "RESULT"
+              << " benchmark=" << name
+              << " type=" << type
+              << " workers=" << ctx.num_workers()
+              << " items=" << items
+              << " bytes=" << bytes
+              << " iterations=" << iterations
+              << " time=" << seconds
+              << " ns_per_item=" << seconds * 1e9 / total_items
+              << " GBs=" << total_bytes / seconds / 1e9
+              << std::endl;
+}
+
+/******************************************************************************/
+// File: BlockWriter::Put(), BlockReader::Next() with keep and consume
+
+template <typename Type>
+void FileBenchmarks(api::Context& ctx) {
+    const char* type = TypeName<Type>::name();
+    std::vector<Type> items = GenerateItems<Type>();
+
+    auto fill =
+        [&](data::File& file) {
+            data::File::Writer writer = file.GetWriter();
+            for (const Type& item : items)
+                writer.Put(item);
+        };
+
+    data::File file = ctx.GetFile(0);
+    fill(file);
+    const size_t bytes = file.size_bytes();
+
+    Measure(ctx, "put", type, items.size(), bytes,
+            [&]() {
+                data::File f = ctx.GetFile(0);
+                common::StatsTimerStart timer;
+                fill(f);
+                return timer.SecondsDouble();
+            });
+
+    Measure(ctx, "next_keep", type, items.size(), bytes,
+            [&]() {
+                common::StatsTimerStart timer;
+                data::File::KeepReader reader = file.GetKeepReader();
+                size_t count = 0;
+                for ( ; reader.HasNext(); ++count)
+                    DoNotOptimize(reader.template Next<Type>());
+                timer.Stop();
+                die_unequal(items.size(), count);
+                return timer.SecondsDouble();
+            });
+
+    Measure(ctx, "next_consume", type, items.size(), bytes,
+            [&]() {
+                data::File f = ctx.GetFile(0);
+                fill(f);
+                common::StatsTimerStart timer;
+                data::File::ConsumeReader reader = f.GetConsumeReader();
+                size_t count = 0;
+                for ( ; reader.HasNext(); ++count)
+                    DoNotOptimize(reader.template Next<Type>());
+                timer.Stop();
+                die_unequal(items.size(), count);
+                return timer.SecondsDouble();
+            });
+}
+
+/******************************************************************************/
+// Streams: CatStream vs MixStream all-to-all on local workers
+
+template <typename Type, typename StreamPtr>
+double StreamLoopback(api::Context& ctx, const std::vector<Type>& items,
+                      StreamPtr stream) {
+    common::StatsTimerStart timer;
+    {
+        auto writers = stream->GetWriters();
+        for (size_t i = 0; i < items.size(); ++i)
+            writers[i % writers.size()].Put(items[i]);
+        writers.Close();
+    }
+    auto reader = stream->GetReader(/* consume */ true);
+    size_t count = 0;
+    for ( ; reader.HasNext(); ++count)
+        DoNotOptimize(reader.template Next<Type>());
+    stream->Close();
+    timer.Stop();
+
+    // all workers send the same number of items
+    die_unequal(items.size() * ctx.num_workers(), ctx.net.AllReduce(count));
+    return timer.SecondsDouble();
+}
+
+template <typename Type>
+void StreamBenchmarks(api::Context& ctx) {
+    const char* type = TypeName<Type>::name();
+    std::vector<Type> items = GenerateItems<Type>();
+
+    data::File file = ctx.GetFile(0);
+    {
+        data::File::Writer writer = file.GetWriter();
+        for (const Type& item : items)
+            writer.Put(item);
+    }
+    const size_t bytes = file.size_bytes();
+
+    Measure(ctx, "cat_stream", type, items.size(), bytes,
+            [&]() {
+                return StreamLoopback(ctx, items, ctx.GetNewCatStream(0));
+            });
+
+    Measure(ctx, "mix_stream", type, items.size(), bytes,
+            [&]() {
+                return StreamLoopback(ctx, items, ctx.GetNewMixStream(0));
+            });
+}
+
+/******************************************************************************/
+// Scatter() with offsets on block boundaries and off by one item
+
+void ScatterBenchmarks(api::Context& ctx) {
+    std::vector<size_t> items = GenerateItems<size_t>();
+    const size_t num_workers = ctx.num_workers();
+    const size_t block_items = data::default_block_size / sizeof(size_t);
+
+    data::File file = ctx.GetFile(0);
+    {
+        data::File::Writer writer = file.GetWriter();
+        for (const size_t& item : items)
+            writer.Put(item);
+    }
+    const size_t bytes = file.size_bytes();
+
+    for (bool aligned : { true, false }) {
+        std::vector<size_t> offsets(num_workers + 1);
+        for (size_t w = 1; w < num_workers; ++w) {
+            size_t offset = w * items.size() / num_workers;
+            offset -= offset % block_items;
+            if (!aligned) offset = std::min(offset + 1, items.size());
+            offsets[w] = offset;
+        }
+        offsets[num_workers] = items.size();
+
+        Measure(ctx, aligned ? "scatter_aligned" : "scatter_unaligned",
+                "size_t", items.size(), bytes,
+                [&]() {
+                    common::StatsTimerStart timer;
+                    data::CatStreamPtr stream = ctx.GetNewCatStream(0);
+                    stream->Scatter<size_t>(file, offsets, /* consume */ false);
+                    data::CatStream::CatReader reader =
+                        stream->GetCatReader(/* consume */ true);
+                    size_t count = 0;
+                    for ( ; reader.HasNext(); ++count)
+                        DoNotOptimize(reader.Next<size_t>());
+                    stream->Close();
+                    timer.Stop();
+
+                    // the workers receive the items of their offset ranges
+                    die_unequal(items.size() * num_workers,
+                                ctx.net.AllReduce(count));
+                    return timer.SecondsDouble();
+                });
+    }
+}
+
+/******************************************************************************/
+
+int main(int argc, char* argv[]) {
+
+    tlx::CmdlineParser clp;
+
+    clp.set_description("thrill::data micro benchmarks of the data path");
+
+    clp.add_bytes('b', "bytes", g_bytes,
+                  "bytes of items per worker, default: 16 MiB");
+    clp.add_size_t('l', "lower", g_min_size,
+                   "minimum length of strings, default: 8");
+    clp.add_size_t('u', "upper", g_max_size,
+                   "maximum length of strings, default: 64");
+    clp.add_double('t', "min_time", g_min_time,
+                   "minimum seconds to repeat each benchmark, default: 0.5");
+    clp.add_size_t('w', "workers", g_workers,
+                   "number of local workers of stream benchmarks, default: 4");
+    clp.add_string('f', "filter", g_filter,
+                   "only run benchmarks whose name contains this string");
+
+    if (!clp.process(argc, argv)) return -1;
+
+    api::MemoryConfig mem_config;
+    mem_config.setup(4 * 1024 * 1024 * 1024llu);
+
+    // single threaded File benchmarks
+    api::RunLocalMock(
+        mem_config, 1, 1,
+        [](api::Context& ctx) {
+            FileBenchmarks<size_t>(ctx);
+            FileBenchmarks<std::string>(ctx);
+            FileBenchmarks<PodPair>(ctx);
+            FileBenchmarks<Tuple>(ctx);
+            FileBenchmarks<Triple>(ctx);
+        });
+
+    // Streams and Scatter between the workers of one host
+    api::RunLocalMock(
+        mem_config, 1, g_workers,
+        [](api::Context& ctx) {
+            StreamBenchmarks<size_t>(ctx);
+            StreamBenchmarks<std::string>(ctx);
+            StreamBenchmarks<Tuple>(ctx);
+            ScatterBenchmarks(ctx);
+        });
+
+    return 0;
+}
+
+/******************************************************************************/
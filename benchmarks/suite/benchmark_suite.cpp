@@ -0,0 +1,391 @@
+/*******************************************************************************
+ * benchmarks/suite/benchmark_suite.cpp
+ *
+ * Regression benchmark suite: runs a fixed matrix of benchmarks of the DIA
+ * operations, the data streams, the collectives, and the reduce hash table, and
+ * writes the results with environment metadata as JSON lines. Given the output
+ * of a previous run with --baseline, the medians are compared and regressions
+ * beyond a threshold are reported and set the exit code.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/context.hpp>
+#include <thrill/api/generate.hpp>
+#include <thrill/api/group_by_key.hpp>
+#include <thrill/api/inner_join.hpp>
+#include <thrill/api/reduce_by_key.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/api/sort.hpp>
+#include <thrill/common/json_logger.hpp>
+#include <thrill/common/stats_timer.hpp>
+#include <thrill/core/reduce_by_hash_post_phase.hpp>
+#include <thrill/data/mix_stream.hpp>
+#include <tlx/cmdline_parser.hpp>
+#include <tlx/die.hpp>
+
+#include <cereal/external/rapidjson/document.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace thrill; // NOLINT
+
+//! number of operations timed per repetition of the collectives benchmarks
+static const size_t kCollectiveRounds = 1000;
+
+//! scramble an index into a pseudo-random value, deterministic across runs
+static size_t Scramble(size_t x) {
+    uint64_t z = static_cast<uint64_t>(x) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<size_t>(z ^ (z >> 31));
+}
+
+class BenchmarkSuite
+{
+public:
+    int Run(int argc, char* argv[]) {
+        tlx::CmdlineParser clp;
+        clp.set_description(
+            "Thrill regression benchmark suite: runs sort, reduce, join, "
+            "groupby, shuffle bandwidth, collectives latency, and hash table "
+            "inserts, and writes JSON lines of results.");
+
+        clp.add_bytes('s', "size", size_,
+                      "bytes of input per worker, default: 16 MiB");
+        clp.add_unsigned('r', "repeats", repeats_,
+                         "repetitions of each benchmark, default: 5");
+        clp.add_string('o', "output", output_,
+                       "write JSON results to file, default: stdout");
+        clp.add_string('b', "baseline", baseline_,
+                       "compare to JSON results of a previous run");
+        clp.add_double('t', "threshold", threshold_,
+                       "relative slowdown of the median reported as "
+                       "regression, default: 0.1");
+        clp.add_string('T', "tag", tag_,
+                       "label of the run, e.g. the release or commit");
+        clp.add_string('f', "filter", filter_,
+                       "only run benchmarks whose name contains this string");
+
+        if (!clp.process(argc, argv)) return -1;
+
+        die_unless(repeats_ > 0);
+
+        if (!baseline_.empty())
+            ReadBaseline();
+
+        api::Run([this](api::Context& ctx) { RunAll(ctx); });
+
+        return regressions_ == 0 ? 0 : 1;
+    }
+
+private:
+    //! \name Parameters
+    //! \{
+
+    uint64_t size_ = 16 * 1024 * 1024;
+    unsigned repeats_ = 5;
+    std::string output_ = "/dev/stdout";
+    std::string baseline_;
+    double threshold_ = 0.1;
+    std::string tag_;
+    std::string filter_;
+
+    //! \}
+
+    //! median seconds of the baseline by benchmark name
+    std::map<std::string, double> baseline_median_;
+
+    //! JSON output, only opened by worker 0
+    std::unique_ptr<common::JsonLogger> logger_;
+
+    //! number of regressions found, written by worker 0
+    std::atomic<size_t> regressions_ { 0 };
+
+    //! read the result lines of a previous run
+    void ReadBaseline() {
+        std::ifstream in(baseline_);
+        die_unless(in.good() && "could not open baseline file");
+
+        std::string line;
+        while (std::getline(in, line)) {
+            rapidjson::Document doc;
+            doc.Parse<0>(line.c_str());
+            if (doc.HasParseError() || !doc.IsObject()) continue;
+            if (!doc.HasMember("event") || !doc["event"].IsString() ||
+                std::string(doc["event"].GetString()) != "result")
+                continue;
+            if (!doc.HasMember("benchmark") || !doc["benchmark"].IsString() ||
+                !doc.HasMember("median") || !doc["median"].IsNumber())
+                continue;
+            baseline_median_[doc["benchmark"].GetString()] =
+                doc["median"].GetDouble();
+        }
+    }
+
+    //! write the environment metadata line
+    void ReportEnvironment(api::Context& ctx) {
+        char hostname[256] = "";
+        gethostname(hostname, sizeof(hostname) - 1);
+
+        char date[32] = "";
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ",
+                      std::gmtime(&now));
+
+#if defined(__clang__)
+        std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+        std::string compiler = "gcc " __VERSION__;
+#else
+        std::string compiler = "unknown";
+#endif
+
+#if defined(NDEBUG)
+        std::string build = "release";
+#else
+        std::string build = "debug";
+#endif
+
+        *logger_
+            << "class" << "BenchmarkSuite"
+            << "event" << "environment"
+            << "tag" << tag_
+            << "date" << date
+            << "hostname" << hostname
+            << "compiler" << compiler
+            << "build" << build
+            << "num_hosts" << ctx.num_hosts()
+            << "workers_per_host" << ctx.workers_per_host()
+            << "hardware_concurrency" << std::thread::hardware_concurrency()
+            << "mem_limit" << ctx.mem_limit()
+            << "size" << size_
+            << "repeats" << repeats_;
+    }
+
+    //! run bench() repeats_ times between barriers and report the timings.
+    //! items and bytes are the global amount processed by one run of bench().
+    template <typename Benchmark>
+    void Measure(api::Context& ctx, const std::string& name,
+                 size_t items, size_t bytes, const Benchmark& bench) {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos)
+            return;
+
+        std::vector<double> seconds;
+        for (size_t r = 0; r < repeats_; ++r) {
+            ctx.net.Barrier();
+            common::StatsTimerStart timer;
+            bench();
+            ctx.net.Barrier();
+            timer.Stop();
+            seconds.push_back(timer.SecondsDouble());
+        }
+
+        if (ctx.my_rank() != 0) return;
+
+        std::sort(seconds.begin(), seconds.end());
+        double median = seconds.size() % 2 == 1
+                        ? seconds[seconds.size() / 2]
+                        : (seconds[seconds.size() / 2 - 1]
+                           + seconds[seconds.size() / 2]) / 2.0;
+        double mean = std::accumulate(seconds.begin(), seconds.end(), 0.0)
+                      / static_cast<double>(seconds.size());
+        double var = 0.0;
+        for (const double& s : seconds) var += (s - mean) * (s - mean);
+        double stdev = seconds.size() > 1
+                       ? std::sqrt(var / static_cast<double>(seconds.size() - 1))
+                       : 0.0;
+
+        common::JsonLine line = logger_->line();
+        line << "class" << "BenchmarkSuite"
+             << "event" << "result"
+             << "tag" << tag_
+             << "benchmark" << name
+             << "items" << items
+             << "bytes" << bytes
+             << "repeats" << repeats_
+             << "median" << median
+             << "min" << seconds.front()
+             << "max" << seconds.back()
+             << "mean" << mean
+             << "stdev" << stdev
+             << "items_per_second" << static_cast<double>(items) / median
+             << "MiBs" << static_cast<double>(bytes) / 1024.0 / 1024.0 / median;
+
+        auto it = baseline_median_.find(name);
+        if (it != baseline_median_.end() && it->second > 0) {
+            double ratio = median / it->second;
+            bool regression = ratio > 1.0 + threshold_;
+            line << "baseline_median" << it->second
+                 << "ratio" << ratio
+                 << "regression" << regression;
+            if (regression) {
+                ++regressions_;
+                std::cerr << "Thrill: regression in " << name
+                          << ": median " << median << " s vs. baseline "
+                          << it->second << " s (" << ratio << "x)"
+                          << std::endl;
+            }
+        }
+    }
+
+    void RunAll(api::Context& ctx) {
+        if (ctx.my_rank() == 0) {
+            logger_ = std::make_unique<common::JsonLogger>(output_);
+            ReportEnvironment(ctx);
+        }
+
+        const size_t workers = ctx.num_workers();
+        const size_t local_items = std::max<size_t>(1, size_ / sizeof(size_t));
+        const size_t items = local_items * workers;
+        const size_t bytes = items * sizeof(size_t);
+        const size_t num_keys = std::max<size_t>(1, items / 16);
+
+        Measure(ctx, "sort", items, bytes,
+                [&]() {
+                    size_t n = api::Generate(
+                        ctx, items,
+                        [](const size_t& i) { return Scramble(i); })
+                    .Sort().Size();
+                    die_unequal(items, n);
+                });
+
+        using Pair = std::pair<size_t, size_t>;
+
+        Measure(ctx, "reduce", items, bytes,
+                [&]() {
+                    size_t n = api::Generate(
+                        ctx, items,
+                        [num_keys](const size_t& i) {
+                            return Pair(Scramble(i) % num_keys, 1);
+                        })
+                    .ReducePair(
+                        [](const size_t& a, const size_t& b) { return a + b; })
+                    .Size();
+                    die_unless(n <= num_keys);
+                });
+
+        Measure(ctx, "join", 2 * items, 2 * items * sizeof(Pair),
+                [&]() {
+                    auto left = api::Generate(
+                        ctx, items,
+                        [items](const size_t& i) {
+                            return Pair(Scramble(i) % items, i);
+                        });
+                    auto right = api::Generate(
+                        ctx, items,
+                        [](const size_t& i) { return Pair(i, i); });
+                    size_t n = api::InnerJoin(
+                        left, right,
+                        [](const Pair& p) { return p.first; },
+                        [](const Pair& p) { return p.first; },
+                        [](const Pair& a, const Pair& b) {
+                            return a.second + b.second;
+                        })
+                    .Size();
+                    // each left key matches exactly one right item
+                    die_unequal(items, n);
+                });
+
+        Measure(ctx, "groupby", items, bytes,
+                [&]() {
+                    size_t n = api::Generate(
+                        ctx, items,
+                        [](const size_t& i) { return Scramble(i); })
+                    .GroupByKey<size_t>(
+                        [num_keys](const size_t& x) { return x % num_keys; },
+                        [](auto& r, const size_t&) {
+                            size_t sum = 0;
+                            while (r.HasNext()) sum += r.Next();
+                            return sum;
+                        })
+                    .Size();
+                    die_unless(n <= num_keys);
+                });
+
+        Measure(ctx, "shuffle", items, bytes,
+                [&]() {
+                    data::MixStreamPtr stream = ctx.GetNewMixStream(0);
+                    data::MixStream::Writers writers = stream->GetWriters();
+                    for (size_t i = 0; i < local_items; ++i)
+                        writers[i % workers].Put(Scramble(i));
+                    writers.Close();
+
+                    size_t count = 0;
+                    data::MixStream::MixReader reader =
+                        stream->GetMixReader(/* consume */ true);
+                    while (reader.HasNext()) {
+                        reader.Next<size_t>();
+                        ++count;
+                    }
+                    die_unless(ctx.net.AllReduce(count) == items);
+                });
+
+        Measure(ctx, "allreduce", kCollectiveRounds, 0,
+                [&]() {
+                    size_t value = ctx.my_rank();
+                    for (size_t i = 0; i < kCollectiveRounds; ++i)
+                        value = ctx.net.AllReduce(value);
+                });
+
+        Measure(ctx, "broadcast", kCollectiveRounds, 0,
+                [&]() {
+                    size_t value = ctx.my_rank();
+                    for (size_t i = 0; i < kCollectiveRounds; ++i)
+                        value = ctx.net.Broadcast(value);
+                });
+
+        Measure(ctx, "prefixsum", kCollectiveRounds, 0,
+                [&]() {
+                    size_t value = ctx.my_rank();
+                    for (size_t i = 0; i < kCollectiveRounds; ++i)
+                        value = ctx.net.PrefixSum(value);
+                });
+
+        Measure(ctx, "hashtable", items, bytes,
+                [&]() {
+                    auto key_ex = [](const size_t& x) { return x; };
+                    auto red_fn = [](const size_t& a, const size_t&) {
+                                      return a;
+                                  };
+                    auto emit_fn = [](const size_t&) { };
+
+                    core::ReduceByHashPostPhase<
+                        size_t, size_t, size_t,
+                        decltype(key_ex), decltype(red_fn), decltype(emit_fn),
+                        /* VolatileKey */ false>
+                    phase(ctx, 0, key_ex, red_fn, emit_fn);
+                    phase.Initialize(ctx.mem_limit() / 2);
+
+                    for (size_t i = 0; i < local_items; ++i)
+                        phase.Insert(Scramble(i) % num_keys);
+                    phase.PushData(/* consume */ true);
+                });
+
+        if (ctx.my_rank() == 0)
+            logger_.reset();
+    }
+};
+
+int main(int argc, char* argv[]) {
+    return BenchmarkSuite().Run(argc, argv);
+}
+
+/******************************************************************************/
@@ -10,11 +10,13 @@
 
 #include "bfs.hpp"
 
+#include <thrill/api/all_gather.hpp>
 #include <thrill/api/cache.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/group_by_iterator.hpp>
 #include <thrill/api/group_by_key.hpp>
 #include <thrill/api/group_to_index.hpp>
+#include <thrill/api/map_partitions.hpp>
 #include <thrill/api/min.hpp>
 #include <thrill/api/print.hpp>
 #include <thrill/api/read_lines.hpp>
@@ -28,19 +30,17 @@
 #include <tlx/cmdline_parser.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <iterator>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 using thrill::DIA;
 using namespace examples::bfs;
 
-struct BfsResult {
-    DIA<BfsNode>          graph;
-    std::vector<TreeInfo> treeInfos;
-};
-
 // load graph from file
 DIA<BfsNode> LoadBFSGraph(thrill::Context& ctx, size_t& graphSize,
                           const std::string& path, VertexId startIndex) {
@@ -80,87 +80,6 @@ DIA<BfsNode> LoadBFSGraph(thrill::Context& ctx, size_t& graphSize,
     return graph.Cache();
 }
 
-// returns true if new nodes have been possibly added to the next BFS level
-bool BFSNextLevel(DIA<BfsNode>& graph, size_t& currentLevel,
-                  const size_t currentTreeIndex, const size_t graphSize) {
-
-    auto neighbors =
-        graph
-        .FlatMap<NodeParentPair>(
-            [=](const BfsNode& node, auto emit) {
-                if (node.level == currentLevel && node.treeIndex == currentTreeIndex) {
-                    for (auto neighbor : node.edges) {
-                        emit(NodeParentPair { neighbor, node.nodeIndex });
-                    }
-                }
-            });
-
-    if (neighbors.Size() == 0)
-        return false;
-
-    auto reducedNeighbors = neighbors.ReduceToIndex(
-        [](const NodeParentPair& pair) {
-            return pair.node == INVALID ? 0 : pair.node;
-        },
-        [](const NodeParentPair& pair1, const NodeParentPair& pair2) {
-            // pair1.node is INVALID iff it is the default constructed value for
-            // its index
-            return pair1.node == INVALID ? pair2 : pair1;
-        },
-        graphSize,
-        NodeParentPair { INVALID, INVALID });
-
-    currentLevel++;
-
-    graph = Zip(
-        [=](BfsNode node, NodeParentPair pair) {
-            if (pair.node != INVALID && node.level == INVALID) {
-                node.level = currentLevel;
-                node.parent = pair.parent;
-                node.treeIndex = currentTreeIndex;
-            }
-            return node;
-        },
-        graph,
-        reducedNeighbors);
-
-    return true;
-}
-
-// returns true if not all nodes have been reached yet
-bool PrepareNextTree(DIA<BfsNode>& graph, size_t& startIndex,
-                     const size_t currentTreeIndex) {
-
-    BfsNode validDummy;
-    validDummy.level = 0;
-
-    // find a node which has not yet been traversed (level == INVALID)
-    auto node = graph.Sum(
-        [](const BfsNode& node1, const BfsNode& node2) {
-            return node1.level == INVALID ? node1 : node2;
-        },
-        validDummy);
-
-    if (node.level != INVALID)
-        return false;   // all nodes have already been traversed
-
-    startIndex = node.nodeIndex;
-
-    // initialize start index
-    graph = graph.Map(
-        [=](BfsNode node) {
-            if (node.nodeIndex == startIndex) {
-                node.level = 0;
-                node.parent = node.nodeIndex;
-                node.treeIndex = currentTreeIndex;
-            }
-
-            return node;
-        }).Collapse();
-
-    return true;
-}
-
 void outputBFSResult(DIA<BfsNode>& graph, size_t num_trees,
                      std::string output_path) {
 
@@ -209,39 +128,16 @@ void outputBFSResult(DIA<BfsNode>& graph, size_t num_trees,
     grouped.WriteLines(output_path);
 }
 
-/*!
- * runs A BFS on graph starting at startIndex. If full_bfs is true then all
- * nodes will eventually be reached possibly resulting in a forest instead of a
- * simple tree
-*/
-BfsResult BFS(DIA<BfsNode>& graph, size_t graphSize,
-              VertexId startIndex, bool full_bfs = false) {
-
-    std::vector<TreeInfo> treeInfos;
-    size_t currentTreeIndex = 0;
-
-    do {
-        size_t currentLevel = 0;
-
-        while (BFSNextLevel(graph, currentLevel, currentTreeIndex, graphSize))
-        { }
-
-        treeInfos.emplace_back(TreeInfo { startIndex, currentLevel });
-
-        currentTreeIndex++;
-    } while (full_bfs && PrepareNextTree(graph, startIndex, currentTreeIndex));
-
-    return BfsResult({ graph, treeInfos });
-}
-
 BfsResult BFS(thrill::Context& ctx,
               std::string input_path, std::string output_path,
-              VertexId startIndex, bool full_bfs = false) {
+              VertexId startIndex, bool full_bfs = false,
+              bool direction_optimizing = false) {
 
     size_t graphSize;
     DIA<BfsNode> graph = LoadBFSGraph(ctx, graphSize, input_path, startIndex);
 
-    auto result = BFS(graph, graphSize, startIndex, full_bfs);
+    auto result = BFS(graph, graphSize, startIndex, full_bfs,
+                      direction_optimizing);
     outputBFSResult(result.graph, result.treeInfos.size(), output_path);
     return result;
 }
@@ -249,11 +145,12 @@ BfsResult BFS(thrill::Context& ctx,
 size_t doubleSweepDiameter(
     thrill::Context& ctx,
     std::string input_path, std::string output_path, std::string output_path2,
-    VertexId startIndex) {
+    VertexId startIndex, bool direction_optimizing = false) {
 
     size_t graphSize;
     DIA<BfsNode> graph = LoadBFSGraph(ctx, graphSize, input_path, startIndex);
-    auto firstBFS = BFS(graph, graphSize, startIndex);
+    auto firstBFS = BFS(graph, graphSize, startIndex, /* full_bfs */ false,
+                        direction_optimizing);
 
     outputBFSResult(firstBFS.graph, firstBFS.treeInfos.size(), output_path);
 
@@ -286,7 +183,8 @@ size_t doubleSweepDiameter(
                  return emitNode;
              }).Collapse();
 
-    auto secondBFS = BFS(secondGraph, graphSize, startIndex);
+    auto secondBFS = BFS(secondGraph, graphSize, startIndex,
+                         /* full_bfs */ false, direction_optimizing);
 
     auto diameter = secondBFS.treeInfos.front().levels;
 
@@ -325,6 +223,11 @@ int main(int argc, char* argv[]) {
     clp.add_flag('d', "diameter", diameter,
                  "calculate approximate diameter using two BFS sweeps");
 
+    bool direction_optimizing = false;
+    clp.add_flag('o', "direction-optimizing", direction_optimizing,
+                 "switch between top-down and bottom-up BFS steps, "
+                 "requires an undirected graph");
+
     if (!clp.process(argc, argv))
         return -1;
 
@@ -333,10 +236,11 @@ int main(int argc, char* argv[]) {
     return thrill::Run(
         [&](thrill::Context& ctx) {
             if (!diameter)
-                BFS(ctx, input_path, output_path, /* startIndex */ 0, full_bfs);
+                BFS(ctx, input_path, output_path, /* startIndex */ 0, full_bfs,
+                    direction_optimizing);
             else
                 doubleSweepDiameter(ctx, input_path, output_path, output_path2,
-                                    /* startIndex */ 0);
+                                    /* startIndex */ 0, direction_optimizing);
         });
 }
 
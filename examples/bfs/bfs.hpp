@@ -12,10 +12,22 @@
 #ifndef THRILL_EXAMPLES_BFS_BFS_HEADER
 #define THRILL_EXAMPLES_BFS_BFS_HEADER
 
+#include <thrill/api/all_gather.hpp>
+#include <thrill/api/cache.hpp>
+#include <thrill/api/collapse.hpp>
+#include <thrill/api/map_partitions.hpp>
+#include <thrill/api/reduce_to_index.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/api/sum.hpp>
+#include <thrill/api/zip.hpp>
+
 #include <cereal/types/vector.hpp>
 #include <thrill/data/serialization_cereal.hpp>
 
+#include <cstdint>
 #include <limits>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace examples {
@@ -70,6 +82,259 @@ struct TreeInfo {
     size_t levels;
 };
 
+using thrill::DIA;
+
+struct BfsResult {
+    DIA<BfsNode>          graph;
+    std::vector<TreeInfo> treeInfos;
+};
+
+// returns true if new nodes have been possibly added to the next BFS level
+bool BFSNextLevel(DIA<BfsNode>& graph, size_t& currentLevel,
+                  const size_t currentTreeIndex, const size_t graphSize) {
+
+    auto neighbors =
+        graph
+        .FlatMap<NodeParentPair>(
+            [=](const BfsNode& node, auto emit) {
+                if (node.level == currentLevel && node.treeIndex == currentTreeIndex) {
+                    for (auto neighbor : node.edges) {
+                        emit(NodeParentPair { neighbor, node.nodeIndex });
+                    }
+                }
+            });
+
+    if (neighbors.Size() == 0)
+        return false;
+
+    auto reducedNeighbors = neighbors.ReduceToIndex(
+        [](const NodeParentPair& pair) {
+            return pair.node == INVALID ? 0 : pair.node;
+        },
+        [](const NodeParentPair& pair1, const NodeParentPair& pair2) {
+            // pair1.node is INVALID iff it is the default constructed value for
+            // its index
+            return pair1.node == INVALID ? pair2 : pair1;
+        },
+        graphSize,
+        NodeParentPair { INVALID, INVALID });
+
+    currentLevel++;
+
+    graph = Zip(
+        [=](BfsNode node, NodeParentPair pair) {
+            if (pair.node != INVALID && node.level == INVALID) {
+                node.level = currentLevel;
+                node.parent = pair.parent;
+                node.treeIndex = currentTreeIndex;
+            }
+            return node;
+        },
+        graph,
+        reducedNeighbors);
+
+    return true;
+}
+
+//! sizes of a BFS level, which decide the direction of the next step
+struct LevelStats {
+    size_t frontierNodes;
+    size_t frontierEdges;
+    size_t unvisitedEdges;
+};
+
+using Bitmap = std::vector<uint64_t>;
+
+// direction-optimizing variant of BFSNextLevel() for undirected graphs: small
+// frontiers are expanded top-down by gathering their (neighbor, parent) pairs
+// on all workers, large frontiers bottom-up by checking the edges of unvisited
+// nodes against a bitmap of the frontier, which is combined by an AllReduce.
+// Both update the graph locally, without shuffling it.
+bool BFSNextLevelDirectionOptimizing(
+    DIA<BfsNode>& graph, size_t& currentLevel, const size_t currentTreeIndex,
+    const size_t graphSize, bool& bottomUp) {
+
+    const size_t level = currentLevel;
+    auto isFrontier = [=](const BfsNode& node) {
+                          return node.level == level &&
+                                 node.treeIndex == currentTreeIndex;
+                      };
+
+    LevelStats stats =
+        graph
+        .Map([=](const BfsNode& node) {
+                 LevelStats s { 0, 0, 0 };
+                 if (isFrontier(node)) {
+                     s.frontierNodes = 1;
+                     s.frontierEdges = node.edges.size();
+                 }
+                 else if (node.level == INVALID) {
+                     s.unvisitedEdges = node.edges.size();
+                 }
+                 return s;
+             })
+        .Sum([](const LevelStats& a, const LevelStats& b) {
+                 return LevelStats {
+                     a.frontierNodes + b.frontierNodes,
+                     a.frontierEdges + b.frontierEdges,
+                     a.unvisitedEdges + b.unvisitedEdges
+                 };
+             },
+             LevelStats { 0, 0, 0 });
+
+    if (stats.frontierNodes == 0)
+        return false;
+
+    // switching heuristic of Beamer et al.: go bottom-up once the frontier's
+    // edges are a large fraction of the unvisited ones, and top-down again
+    // once the frontier is small.
+    if (!bottomUp && stats.frontierEdges > stats.unvisitedEdges / 14)
+        bottomUp = true;
+    else if (bottomUp && stats.frontierNodes < graphSize / 24)
+        bottomUp = false;
+
+    currentLevel++;
+    const size_t nextLevel = currentLevel;
+
+    if (bottomUp) {
+        const size_t words = (graphSize + 63) / 64;
+
+        auto frontier = std::make_shared<const Bitmap>(
+            graph
+            .Filter(isFrontier)
+            .Map([](const BfsNode& node) { return node.nodeIndex; })
+            .MapPartitions<Bitmap>(
+                [words](auto& reader, const auto& emit) {
+                    Bitmap bits(words, 0);
+                    while (reader.HasNext()) {
+                        VertexId v = reader.Next();
+                        bits[v / 64] |= uint64_t(1) << (v % 64);
+                    }
+                    emit(bits);
+                })
+            .Sum([](Bitmap a, const Bitmap& b) {
+                     for (size_t i = 0; i < a.size(); ++i) a[i] |= b[i];
+                     return a;
+                 },
+                 Bitmap(words, 0)));
+
+        graph = graph.Map(
+            [=](BfsNode node) {
+                if (node.level != INVALID) return node;
+                for (VertexId neighbor : node.edges) {
+                    if (((*frontier)[neighbor / 64] >> (neighbor % 64)) & 1) {
+                        node.level = nextLevel;
+                        node.parent = neighbor;
+                        node.treeIndex = currentTreeIndex;
+                        break;
+                    }
+                }
+                return node;
+            }).Cache();
+    }
+    else {
+        std::vector<NodeParentPair> pairs =
+            graph
+            .FlatMap<NodeParentPair>(
+                [=](const BfsNode& node, auto emit) {
+                    if (isFrontier(node)) {
+                        for (auto neighbor : node.edges) {
+                            emit(NodeParentPair { neighbor, node.nodeIndex });
+                        }
+                    }
+                })
+            .AllGather();
+
+        auto parents =
+            std::make_shared<std::unordered_map<VertexId, VertexId> >();
+        for (const NodeParentPair& pair : pairs)
+            parents->emplace(pair.node, pair.parent);
+
+        graph = graph.Map(
+            [=](BfsNode node) {
+                if (node.level != INVALID) return node;
+                auto it = parents->find(node.nodeIndex);
+                if (it != parents->end()) {
+                    node.level = nextLevel;
+                    node.parent = it->second;
+                    node.treeIndex = currentTreeIndex;
+                }
+                return node;
+            }).Cache();
+    }
+
+    return true;
+}
+
+// returns true if not all nodes have been reached yet
+bool PrepareNextTree(DIA<BfsNode>& graph, size_t& startIndex,
+                     const size_t currentTreeIndex) {
+
+    BfsNode validDummy;
+    validDummy.level = 0;
+
+    // find a node which has not yet been traversed (level == INVALID)
+    auto node = graph.Sum(
+        [](const BfsNode& node1, const BfsNode& node2) {
+            return node1.level == INVALID ? node1 : node2;
+        },
+        validDummy);
+
+    if (node.level != INVALID)
+        return false;   // all nodes have already been traversed
+
+    startIndex = node.nodeIndex;
+
+    // initialize start index
+    graph = graph.Map(
+        [=](BfsNode node) {
+            if (node.nodeIndex == startIndex) {
+                node.level = 0;
+                node.parent = node.nodeIndex;
+                node.treeIndex = currentTreeIndex;
+            }
+
+            return node;
+        }).Collapse();
+
+    return true;
+}
+
+/*!
+ * runs A BFS on graph starting at startIndex. If full_bfs is true then all
+ * nodes will eventually be reached possibly resulting in a forest instead of a
+ * simple tree
+*/
+BfsResult BFS(DIA<BfsNode>& graph, size_t graphSize,
+              VertexId startIndex, bool full_bfs = false,
+              bool direction_optimizing = false) {
+
+    std::vector<TreeInfo> treeInfos;
+    size_t currentTreeIndex = 0;
+
+    do {
+        size_t currentLevel = 0;
+
+        if (direction_optimizing) {
+            bool bottomUp = false;
+            while (BFSNextLevelDirectionOptimizing(
+                       graph, currentLevel, currentTreeIndex, graphSize,
+                       bottomUp))
+            { }
+        }
+        else {
+            while (BFSNextLevel(graph, currentLevel, currentTreeIndex, graphSize))
+            { }
+        }
+
+        treeInfos.emplace_back(TreeInfo { startIndex, currentLevel });
+
+        currentTreeIndex++;
+    } while (full_bfs && PrepareNextTree(graph, startIndex, currentTreeIndex));
+
+    return BfsResult({ graph, treeInfos });
+}
+
 } // namespace bfs
 } // namespace examples
 
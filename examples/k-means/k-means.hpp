@@ -24,6 +24,8 @@
 #include <cereal/types/vector.hpp>
 #include <thrill/data/serialization_cereal.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <string>
 #include <utility>
@@ -68,6 +70,90 @@ struct ClosestCentroid {
     }
 };
 
+//! A point with its assigned cluster and the distance bounds of Hamerly's
+//! algorithm, which are kept across iterations.
+template <typename Point>
+struct HamerlyPoint {
+    Point  p;
+    size_t cluster_id;
+    //! upper bound of the distance to the assigned centroid
+    double upper;
+    //! lower bound of the distance to all other centroids
+    double lower;
+
+    template <typename Archive>
+    void serialize(Archive& archive) {
+        archive(p, cluster_id, upper, lower);
+    }
+};
+
+/*!
+ * Centroids in a contiguous array, transposed such that coordinate i of all
+ * centroids is consecutive. The distances of a point to all centroids are
+ * then computed by loops over contiguous arrays, which compilers vectorize.
+ */
+class CentroidArray
+{
+public:
+    template <typename Point>
+    explicit CentroidArray(const std::vector<Point>& centroids)
+        : num_(centroids.size()),
+          dim_(centroids.empty() ? 0 : centroids[0].size()),
+          coords_(num_ * dim_), dist_(num_) {
+        for (size_t j = 0; j < num_; ++j) {
+            for (size_t i = 0; i < dim_; ++i)
+                coords_[i * num_ + j] = centroids[j].x[i];
+        }
+    }
+
+    //! number of centroids
+    size_t size() const { return num_; }
+
+    //! distance of p to centroid j
+    template <typename Point>
+    double Distance(const Point& p, size_t j) const {
+        double sum = 0.0;
+        for (size_t i = 0; i < dim_; ++i) {
+            double d = p.x[i] - coords_[i * num_ + j];
+            sum += d * d;
+        }
+        return std::sqrt(sum);
+    }
+
+    //! find the nearest centroid of p, and the distances to the nearest and
+    //! the second nearest centroid.
+    template <typename Point>
+    size_t Nearest(const Point& p, double& first, double& second) const {
+        double* dist = dist_.data();
+        std::fill(dist, dist + num_, 0.0);
+        for (size_t i = 0; i < dim_; ++i) {
+            const double* col = coords_.data() + i * num_;
+            const double x = p.x[i];
+            for (size_t j = 0; j < num_; ++j)
+                dist[j] += (x - col[j]) * (x - col[j]);
+        }
+        size_t nearest = 0;
+        first = second = std::numeric_limits<double>::infinity();
+        for (size_t j = 0; j < num_; ++j) {
+            if (dist[j] < first) {
+                second = first, first = dist[j], nearest = j;
+            }
+            else if (dist[j] < second) {
+                second = dist[j];
+            }
+        }
+        first = std::sqrt(first), second = std::sqrt(second);
+        return nearest;
+    }
+
+private:
+    size_t num_;
+    size_t dim_;
+    std::vector<double> coords_;
+    //! scratch space for the squared distances
+    mutable std::vector<double> dist_;
+};
+
 //! Model returned by KMeans algorithm containing results.
 template <typename Point>
 class KMeansModel
@@ -253,6 +339,134 @@ auto KMeans(const DIA<Point, InStack>& input_points, size_t dimensions,
         local_centroids);
 }
 
+/*!
+ * Calculate k-Means using Hamerly's variant of Lloyd's Algorithm, which assigns
+ * the points to the same centroids. Each point carries an upper bound of the distance to its
+ * centroid and a lower bound of the distance to all others in a cached DIA
+ * across iterations. The bounds are loosened by the centroids' movements, and
+ * the distances to all centroids are computed only for points whose bounds
+ * overlap. After the first few iterations, most points keep their centroid
+ * without computing any distance.
+ */
+template <typename Point, typename InStack>
+auto KMeansHamerly(const DIA<Point, InStack>& input_points, size_t dimensions,
+                   size_t num_clusters, size_t iterations,
+                   double epsilon = 0.0) {
+
+    auto points = input_points.Cache();
+
+    bool break_condition = false;
+
+    using HamerlyPoint = HamerlyPoint<Point>;
+    using ClosestCentroid = ClosestCentroid<Point>;
+    using CentroidAccumulated = CentroidAccumulated<Point>;
+
+    std::vector<Point> local_centroids =
+        points.Keep().Sample(num_clusters).AllGather();
+
+    // the bounds are infinitely loose at first
+    DIA<HamerlyPoint> bounded =
+        points.Map([](const Point& p) {
+                       return HamerlyPoint {
+                           p, 0, std::numeric_limits<double>::infinity(), 0.0
+                       };
+                   })
+        .Cache();
+
+    assert(local_centroids.size());
+
+    // distance moved by each centroid in the previous iteration
+    std::vector<double> moved(local_centroids.size(), 0.0);
+
+    for (size_t iter = 0; iter < iterations && !break_condition; ++iter) {
+
+        std::vector<Point> old_centroids = local_centroids;
+        CentroidArray centroids(local_centroids);
+
+        // half the distance of each centroid to its nearest other centroid:
+        // closer points cannot be closer to another centroid.
+        std::vector<double> half_gap(centroids.size());
+        for (size_t j = 0; j < centroids.size(); ++j) {
+            double first, second;
+            centroids.Nearest(local_centroids[j], first, second);
+            half_gap[j] = second / 2.0;
+        }
+
+        // the largest movement decreases the lower bounds, except of points
+        // assigned to the moved centroid, for which the second largest does.
+        size_t max_id =
+            std::max_element(moved.begin(), moved.end()) - moved.begin();
+        double max_moved = moved[max_id], second_moved = 0.0;
+        for (size_t j = 0; j < moved.size(); ++j) {
+            if (j != max_id) second_moved = std::max(second_moved, moved[j]);
+        }
+
+        // update the bounds, and reassign points whose bounds overlap
+        bounded = bounded.Map(
+            [&](const HamerlyPoint& hp) {
+                HamerlyPoint q = hp;
+                q.upper += moved[q.cluster_id];
+                q.lower -= q.cluster_id == max_id ? second_moved : max_moved;
+
+                double bound = std::max(half_gap[q.cluster_id], q.lower);
+                if (q.upper <= bound) return q;
+
+                // tighten the upper bound and test again
+                q.upper = centroids.Distance(q.p, q.cluster_id);
+                if (q.upper <= bound) return q;
+
+                q.cluster_id = centroids.Nearest(q.p, q.upper, q.lower);
+                return q;
+            })
+                  .Cache();
+
+        // Calculate new centroids as the mean of all points associated with it.
+        auto new_centroids =
+            bounded.Keep()
+            .Map([](const HamerlyPoint& hp) {
+                     return ClosestCentroid {
+                         hp.cluster_id, CentroidAccumulated { hp.p, 1 }
+                     };
+                 })
+            .ReduceByKey(
+                [](const ClosestCentroid& cc) { return cc.cluster_id; },
+                [](const ClosestCentroid& a, const ClosestCentroid& b) {
+                    return ClosestCentroid {
+                        a.cluster_id,
+                        CentroidAccumulated { a.center.p + b.center.p,
+                                              a.center.count + b.center.count }
+                    };
+                })
+            .Map([](const ClosestCentroid& cc) {
+                     return CentroidAccumulated {
+                         cc.center.p / static_cast<double>(cc.center.count),
+                         cc.cluster_id
+                     };
+                 })
+            .Collapse();
+
+        // collect centroids again, and put back into cluster order
+        for (const CentroidAccumulated& uc : new_centroids.AllGather()) {
+            local_centroids[uc.count] = uc.p;
+        }
+
+        for (size_t i = 0; i < local_centroids.size(); ++i)
+            moved[i] = local_centroids[i].Distance(old_centroids[i]);
+
+        // Check whether centroid positions changed significantly, if yes do
+        // another iteration. only check if epsilon > 0, otherwise we run a
+        // fixed number of iterations.
+        if (epsilon > 0) {
+            break_condition =
+                *std::max_element(moved.begin(), moved.end()) <= epsilon;
+        }
+    }
+
+    return KMeansModel<Point>(
+        dimensions, num_clusters, iterations,
+        local_centroids);
+}
+
 //! Calculate k-Means using bisecting method
 template <typename Point, typename InStack>
 auto BisecKMeans(const DIA<Point, InStack>& input_points, size_t dimensions,
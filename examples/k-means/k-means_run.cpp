@@ -107,7 +107,7 @@ void OutputSVG(const std::string& svg_path, double svg_scale,
 
 template <typename Point>
 static void RunKMeansGenerated(
-    thrill::Context& ctx, bool bisecting,
+    thrill::Context& ctx, bool bisecting, bool hamerly,
     size_t dimensions, size_t num_clusters, size_t iterations, double eps,
     const std::string& svg_path, double svg_scale,
     const std::vector<std::string>& input_paths) {
@@ -132,6 +132,8 @@ static void RunKMeansGenerated(
 
     auto result = bisecting ?
                   BisecKMeans(points.Keep(), dimensions, num_clusters, iterations, eps) :
+                  hamerly ?
+                  KMeansHamerly(points.Keep(), dimensions, num_clusters, iterations, eps) :
                   KMeans(points.Keep(), dimensions, num_clusters, iterations, eps);
 
     double cost = result.ComputeCost(points);
@@ -148,6 +150,7 @@ static void RunKMeansGenerated(
         LOG1 << "RESULT"
              << " benchmark=k-means"
              << " bisecting=" << bisecting
+             << " hamerly=" << hamerly
              << " dimensions=" << dimensions
              << " num_clusters=" << num_clusters
              << " iterations=" << iterations
@@ -161,7 +164,7 @@ static void RunKMeansGenerated(
 
 template <typename Point>
 static void RunKMeansFile(
-    thrill::Context& ctx, bool bisecting,
+    thrill::Context& ctx, bool bisecting, bool hamerly,
     size_t dimensions, size_t num_clusters, size_t iterations, double eps,
     const std::string& svg_path, double svg_scale,
     const std::vector<std::string>& input_paths) {
@@ -190,6 +193,8 @@ static void RunKMeansFile(
 
     auto result = bisecting ?
                   BisecKMeans(points.Keep(), dimensions, num_clusters, iterations, eps) :
+                  hamerly ?
+                  KMeansHamerly(points.Keep(), dimensions, num_clusters, iterations, eps) :
                   KMeans(points.Keep(), dimensions, num_clusters, iterations, eps);
 
     double cost = result.ComputeCost(points.Keep());
@@ -206,6 +211,7 @@ static void RunKMeansFile(
         LOG1 << "RESULT"
              << " benchmark=k-means"
              << " bisecting=" << bisecting
+             << " hamerly=" << hamerly
              << " dimensions=" << dimensions
              << " num_clusters=" << num_clusters
              << " iterations=" << iterations
@@ -229,6 +235,10 @@ int main(int argc, char* argv[]) {
     clp.add_bool('b', "bisecting", bisecting,
                  "enable bisecting k-Means");
 
+    bool hamerly = false;
+    clp.add_bool('H', "hamerly", hamerly,
+                 "prune distance computations with Hamerly's bounds");
+
     size_t iterations = 10;
     clp.add_size_t('n', "iterations", iterations,
                    "iterations, default: 10");
@@ -272,18 +282,18 @@ int main(int argc, char* argv[]) {
                     die("Zero dimensional clustering is easy.");
                 case 2:
                     RunKMeansGenerated<Point<2> >(
-                        ctx, bisecting, dimensions, num_clusters, iterations,
-                        epsilon, svg_path, svg_scale, input_paths);
+                        ctx, bisecting, hamerly, dimensions, num_clusters,
+                        iterations, epsilon, svg_path, svg_scale, input_paths);
                     break;
                 case 3:
                     RunKMeansGenerated<Point<3> >(
-                        ctx, bisecting, dimensions, num_clusters, iterations,
-                        epsilon, svg_path, svg_scale, input_paths);
+                        ctx, bisecting, hamerly, dimensions, num_clusters,
+                        iterations, epsilon, svg_path, svg_scale, input_paths);
                     break;
                 default:
                     RunKMeansGenerated<VPoint>(
-                        ctx, bisecting, dimensions, num_clusters, iterations,
-                        epsilon, svg_path, svg_scale, input_paths);
+                        ctx, bisecting, hamerly, dimensions, num_clusters,
+                        iterations, epsilon, svg_path, svg_scale, input_paths);
                 }
             }
             else {
@@ -292,18 +302,18 @@ int main(int argc, char* argv[]) {
                     die("Zero dimensional clustering is easy.");
                 case 2:
                     RunKMeansFile<Point<2> >(
-                        ctx, bisecting, dimensions, num_clusters, iterations,
-                        epsilon, svg_path, svg_scale, input_paths);
+                        ctx, bisecting, hamerly, dimensions, num_clusters,
+                        iterations, epsilon, svg_path, svg_scale, input_paths);
                     break;
                 case 3:
                     RunKMeansFile<Point<3> >(
-                        ctx, bisecting, dimensions, num_clusters, iterations,
-                        epsilon, svg_path, svg_scale, input_paths);
+                        ctx, bisecting, hamerly, dimensions, num_clusters,
+                        iterations, epsilon, svg_path, svg_scale, input_paths);
                     break;
                 default:
                     RunKMeansFile<VPoint>(
-                        ctx, bisecting, dimensions, num_clusters, iterations,
-                        epsilon, svg_path, svg_scale, input_paths);
+                        ctx, bisecting, hamerly, dimensions, num_clusters,
+                        iterations, epsilon, svg_path, svg_scale, input_paths);
                 }
             }
         };
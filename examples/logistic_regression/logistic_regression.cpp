@@ -110,13 +110,15 @@ static auto GenerateTestData(api::Context& ctx, size_t size) {
 template <typename InputDIA>
 auto TrainLogit(api::Context& ctx,
                 const InputDIA& input_dia,
-                size_t max_iterations, double gamma, double epsilon) {
+                size_t max_iterations, double gamma, double epsilon,
+                double mini_batch_fraction, size_t local_steps) {
 
     Element weights;
     double norm;
     size_t iterations;
     std::tie(weights, norm, iterations) =
-        logit_train<T, dim>(input_dia.Keep(), max_iterations, gamma, epsilon);
+        logit_train<T, dim>(input_dia.Keep(), max_iterations, gamma, epsilon,
+                            mini_batch_fraction, local_steps);
 
     LOGM << "Iterations: " << iterations;
     LOGM << "Norm: " << norm;
@@ -158,6 +160,15 @@ int main(int argc, char* argv[]) {
     clp.add_double('g', "gamma", gamma, "Gamma, default: 0.002");
     clp.add_double('e', "epsilon", epsilon, "Epsilon, default: 0.0001");
 
+    double mini_batch_fraction = 1.0;
+    clp.add_double('f', "fraction", mini_batch_fraction,
+                   "Fraction of the data sampled per iteration, default: 1");
+
+    size_t local_steps = 1;
+    clp.add_size_t('l', "local-steps", local_steps,
+                   "Local steps of each worker between model averaging, "
+                   "default: 1");
+
     bool generate = false;
     clp.add_bool('G', "generate", generate,
                  "Generate some random data to train and classify");
@@ -177,14 +188,16 @@ int main(int argc, char* argv[]) {
             if (generate) {
                 size_t size = common::from_cstr<size_t>(training_path.c_str());
                 weights = TrainLogit(ctx, GenerateInput(ctx, size),
-                                     max_iterations, gamma, epsilon);
+                                     max_iterations, gamma, epsilon,
+                                     mini_batch_fraction, local_steps);
 
                 TestLogit(ctx, "generated",
                           GenerateTestData(ctx, size / 10), weights);
             }
             else {
                 weights = TrainLogit(ctx, ReadInputFile(ctx, training_path),
-                                     max_iterations, gamma, epsilon);
+                                     max_iterations, gamma, epsilon,
+                                     mini_batch_fraction, local_steps);
 
                 for (const auto& test_file : test_path) {
                     auto data = ReadInputFile(ctx, test_file);
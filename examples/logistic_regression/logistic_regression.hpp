@@ -13,8 +13,10 @@
 #ifndef THRILL_EXAMPLES_LOGISTIC_REGRESSION_LOGISTIC_REGRESSION_HEADER
 #define THRILL_EXAMPLES_LOGISTIC_REGRESSION_LOGISTIC_REGRESSION_HEADER
 
+#include <thrill/api/bernoulli_sample.hpp>
 #include <thrill/api/cache.hpp>
 #include <thrill/api/dia.hpp>
+#include <thrill/api/map_partitions.hpp>
 #include <thrill/api/size.hpp>
 #include <thrill/api/sum.hpp>
 #include <thrill/common/logger.hpp>
@@ -25,6 +27,7 @@
 #include <functional>
 #include <numeric>
 #include <utility>
+#include <vector>
 
 #define LOGM LOGC(debug && ctx.my_rank() == 0)
 
@@ -62,34 +65,181 @@ auto gradient(const bool& y, const std::array<T, dim>& x,
     return grad;
 }
 
+/*!
+ * A block of labeled points in columnar layout: coordinate i of the r-th point
+ * is column(i)[r], such that the gradient kernel loops over contiguous arrays,
+ * which compilers vectorize.
+ */
+template <typename T, size_t dim>
+class LogitBlock
+{
+public:
+    explicit LogitBlock(size_t capacity)
+        : capacity_(capacity), coords_(dim * capacity),
+          labels_(capacity), scratch_(capacity) { }
+
+    size_t rows() const { return rows_; }
+    bool full() const { return rows_ == capacity_; }
+    void clear() { rows_ = 0; }
+
+    void Push(const std::pair<bool, std::array<T, dim> >& elem) {
+        for (size_t i = 0; i < dim; ++i)
+            coords_[i * capacity_ + rows_] = elem.second[i];
+        labels_[rows_++] = elem.first;
+    }
+
+    //! add the gradients of the rows [begin,end) at w to grad
+    void Gradient(size_t begin, size_t end, const std::array<T, dim>& w,
+                  std::array<T, dim>& grad) {
+        T* s = scratch_.data();
+        for (size_t r = begin; r < end; ++r)
+            s[r] = 0;
+        for (size_t i = 0; i < dim; ++i) {
+            const T* col = coords_.data() + i * capacity_;
+            for (size_t r = begin; r < end; ++r)
+                s[r] += w[i] * col[r];
+        }
+        for (size_t r = begin; r < end; ++r)
+            s[r] = sigmoid(s[r]) - labels_[r];
+        for (size_t i = 0; i < dim; ++i) {
+            const T* col = coords_.data() + i * capacity_;
+            T g = 0;
+            for (size_t r = begin; r < end; ++r)
+                g += s[r] * col[r];
+            grad[i] += g;
+        }
+    }
+
+private:
+    size_t capacity_;
+    size_t rows_ = 0;
+    std::vector<T> coords_;
+    std::vector<T> labels_;
+    std::vector<T> scratch_;
+};
+
+//! sum of the gradients of all points at weights, computed by each worker in
+//! columnar blocks.
+template <typename T, size_t dim, typename InputDIA,
+          typename Element = std::array<T, dim> >
+Element logit_gradient_sum(const InputDIA& data, const Element& weights) {
+    return data
+           .template MapPartitions<Element>(
+        [&weights](auto& reader, auto emit) {
+            Element grad;
+            grad.fill(0);
+            LogitBlock<T, dim> block(1024);
+            while (reader.HasNext()) {
+                block.Push(reader.Next());
+                if (block.full()) {
+                    block.Gradient(0, block.rows(), weights, grad);
+                    block.clear();
+                }
+            }
+            block.Gradient(0, block.rows(), weights, grad);
+            emit(grad);
+        })
+           .Sum([](const Element& a, const Element& b) -> Element {
+                    Element result;
+                    std::transform(a.begin(), a.end(), b.begin(),
+                                   result.begin(), std::plus<T>());
+                    return result;
+                });
+}
+
+//! average of the local models after local_steps steps of each worker on its
+//! points, weighted by the number of points. Each local step has step size
+//! gamma * num_workers, such that the average of one local step on equally
+//! large parts equals a full gradient step.
+template <typename T, size_t dim, typename InputDIA,
+          typename Element = std::array<T, dim> >
+Element logit_local_average(const InputDIA& data, const Element& weights,
+                            size_t local_steps, double gamma) {
+    using Model = std::pair<Element, double>;
+    double local_gamma = gamma * data.ctx().num_workers();
+    Model sum =
+        data
+        .template MapPartitions<Model>(
+            [&weights, local_steps, local_gamma](auto& reader, auto emit) {
+                size_t count = reader.size();
+                LogitBlock<T, dim> block(count);
+                while (reader.HasNext())
+                    block.Push(reader.Next());
+
+                Element local = weights;
+                for (size_t s = 0; s < local_steps; ++s) {
+                    size_t begin = s * count / local_steps;
+                    size_t end = (s + 1) * count / local_steps;
+                    Element grad;
+                    grad.fill(0);
+                    block.Gradient(begin, end, local, grad);
+                    for (size_t i = 0; i < dim; ++i)
+                        local[i] -= local_gamma * grad[i];
+                }
+                for (size_t i = 0; i < dim; ++i)
+                    local[i] *= count;
+                emit(Model(local, count));
+            })
+        .Sum([](const Model& a, const Model& b) -> Model {
+                 Model result;
+                 std::transform(a.first.begin(), a.first.end(),
+                                b.first.begin(), result.first.begin(),
+                                std::plus<T>());
+                 result.second = a.second + b.second;
+                 return result;
+             });
+
+    if (sum.second == 0) return weights;
+    for (size_t i = 0; i < dim; ++i)
+        sum.first[i] /= sum.second;
+    return sum.first;
+}
+
+/*!
+ * Train a logistic regression model by gradient descent. Each iteration uses
+ * a mini-batch drawn with BernoulliSample from the data, which should be
+ * cached, unless mini_batch_fraction is one. With local_steps = 1, a step is
+ * taken along the summed gradient of the mini-batch, scaled up by the
+ * fraction. With local_steps > 1 (local SGD, or model averaging), each worker
+ * takes local_steps steps on parts of its share of the mini-batch without
+ * communication, and the local models are averaged at the end of the
+ * iteration.
+ */
 template <typename T, size_t dim, typename InStack,
           typename Element = std::array<T, dim> >
 auto logit_train(const DIA<std::pair<bool, Element>, InStack>& data,
                  size_t max_iterations, double gamma = 0.002,
-                 double epsilon = 0.0001) {
+                 double epsilon = 0.0001, double mini_batch_fraction = 1.0,
+                 size_t local_steps = 1) {
     // weights, initialized to zero
     Element weights, new_weights;
-    weights[0] = weights[1] = weights[2] = 0;
+    weights.fill(0);
     size_t iter = 0;
     T norm = 0.0;
 
+    // the mini-batch's gradient estimates the full gradient sum
+    double step = gamma / mini_batch_fraction;
+
+    auto next_weights =
+        [&](const auto& batch) -> Element {
+            if (local_steps > 1)
+                return logit_local_average<T, dim>(
+                    batch, weights, local_steps, step);
+            Element grad = logit_gradient_sum<T, dim>(batch, weights);
+            Element result;
+            std::transform(weights.begin(), weights.end(), grad.begin(),
+                           result.begin(),
+                           [step](const T& a, const T& b) -> T
+                           { return a - step * b; });
+            return result;
+        };
+
     while (iter < max_iterations) {
-        Element grad =
-            data.Keep()
-            .Map([&weights](const std::pair<bool, Element>& elem) -> Element {
-                     return gradient(elem.first, elem.second, weights);
-                 })
-            .Sum([](const Element& a, const Element& b) -> Element {
-                     Element result;
-                     std::transform(a.begin(), a.end(), b.begin(),
-                                    result.begin(), std::plus<T>());
-                     return result;
-                 });
-
-        std::transform(weights.begin(), weights.end(), grad.begin(),
-                       new_weights.begin(),
-                       [&gamma](const T& a, const T& b) -> T
-                       { return a - gamma * b; });
+        if (mini_batch_fraction < 1.0)
+            new_weights = next_weights(
+                data.Keep().BernoulliSample(mini_batch_fraction));
+        else
+            new_weights = next_weights(data.Keep());
 
         norm = calc_norm(new_weights, weights);
         weights = new_weights;
@@ -105,14 +255,14 @@ template <typename T, size_t dim, typename InStack,
           typename Element = std::array<T, dim> >
 auto logit_test(const DIA<std::pair<bool, Element>, InStack>& data,
                 const Element& weights) {
-    size_t expected_true =
+    auto expected_true =
         data.Keep()
         .Filter([](const std::pair<T, Element>& elem) -> bool {
                     return elem.first;
                 })
-        .Size();
+        .SizeFuture();
 
-    size_t expected_false = data.Keep().Size() - expected_true;
+    auto total = data.Keep().SizeFuture();
 
     using Prediction = std::pair<bool, bool>;
     auto classification =
@@ -127,18 +277,22 @@ auto logit_test(const DIA<std::pair<bool, Element>, InStack>& data,
              })
         .Collapse();                   // don't evaluate this twice
 
-    size_t true_trues =
+    auto true_trues =
         classification.Keep()
         .Filter([](const Prediction& p) { return p.first && p.second; })
-        .Size();
+        .SizeFuture();
 
-    size_t true_falses =
+    auto true_falses =
         classification
         .Filter([](const Prediction& p) { return !p.first && !p.second; })
-        .Size();
+        .SizeFuture();
+
+    // evaluate all four sizes with a single collective
+    WaitAll(expected_true, total, true_trues, true_falses);
 
-    return std::make_tuple(expected_true, true_trues,
-                           expected_false, true_falses);
+    return std::make_tuple(expected_true.get(), true_trues.get(),
+                           total.get() - expected_true.get(),
+                           true_falses.get());
 }
 
 } // namespace logistic_regression
@@ -13,19 +13,26 @@
 #ifndef THRILL_EXAMPLES_PAGE_RANK_PAGE_RANK_HEADER
 #define THRILL_EXAMPLES_PAGE_RANK_PAGE_RANK_HEADER
 
+#include <thrill/api/cache.hpp>
 #include <thrill/api/collapse.hpp>
+#include <thrill/api/concat_to_dia.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/inner_join.hpp>
 #include <thrill/api/print.hpp>
 #include <thrill/api/reduce_by_key.hpp>
 #include <thrill/api/reduce_to_index.hpp>
 #include <thrill/api/size.hpp>
+#include <thrill/api/sum.hpp>
 #include <thrill/api/zip.hpp>
+#include <thrill/api/zip_with_index.hpp>
 #include <thrill/common/logger.hpp>
 
 #include <tlx/string/join_generic.hpp>
 
 #include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -139,6 +146,105 @@ auto PageRank(const DIA<OutgoingLinks, InStack>& links,
     return ranks;
 }
 
+//! ReduceToIndex configuration, which reduces in the dense pre-phase whenever
+//! its array fits in the memory limit. Either pre-phase locates the output of
+//! the range CalculateLocalRange(size) on each worker.
+class DenseReduceToIndexConfig : public api::DefaultReduceToIndexConfig
+{
+public:
+    DenseReduceToIndexConfig() {
+        dense_pre_phase_max_bytes_ = std::numeric_limits<size_t>::max();
+    }
+};
+
+/*!
+ * PageRank variant, which moves the outgoing links of the pages once to the
+ * worker whose range CalculateLocalRange(num_pages) contains them, keeps them
+ * there in a cached DIA, and keeps the ranks of these pages in a local array,
+ * which is updated in place. Each iteration only the rank contributions are
+ * exchanged by a ReduceToIndex, whose dense pre-phase adds the contributions
+ * to the same target before sending them. Its output on each worker is the
+ * worker's range of pages, hence the ranks need no Zip with the links. The
+ * dense pre-phase needs an array of num_pages items on each worker.
+ */
+template <typename InStack>
+auto PageRankDense(const DIA<OutgoingLinks, InStack>& links,
+                   size_t num_pages, size_t iterations) {
+
+    api::Context& ctx = links.context();
+    double num_pages_d = static_cast<double>(num_pages);
+
+    // move the outgoing links to the workers of the pages: (url, links)
+
+    auto adjacency =
+        links
+        .ZipWithIndex(
+            [](const OutgoingLinks& ol, const PageId& p) {
+                return LinkedPage(p, ol);
+            })
+        .ReduceToIndex(
+            [](const LinkedPage& lp) { return lp.first; },
+            [](const LinkedPage& a, const LinkedPage&) { return a; },
+            num_pages, LinkedPage(), DenseReduceToIndexConfig())
+        .Cache();
+    adjacency.KeepForever();
+
+    // initialize the ranks of the local pages to 1.0 / n
+
+    common::Range range = ctx.CalculateLocalRange(num_pages);
+    std::vector<Rank> ranks(range.size(), Rank(1.0) / num_pages_d);
+
+    // do iterations
+    for (size_t iter = 0; iter < iterations; ++iter) {
+
+        // compute rank contribution for each linked_url from the local ranks:
+        // (linked_url, rank / outgoing.size)
+
+        auto contribs = adjacency.template FlatMap<PageRankPair>(
+            [&ranks, begin = range.begin](const LinkedPage& lp, auto emit) {
+                if (lp.second.size() == 0)
+                    return;
+
+                Rank rank_contrib =
+                    ranks[lp.first - begin]
+                    / static_cast<double>(lp.second.size());
+                for (const PageId& tgt : lp.second)
+                    emit(PageRankPair { tgt, rank_contrib });
+            });
+
+        // reduce all rank contributions by adding them, and compute the new
+        // ranks in place. The ReduceToIndex delivers the local pages in order,
+        // and the Sum returns the L1 norm of the change.
+
+        size_t index = 0;
+        double change =
+            contribs
+            .ReduceToIndex(
+                [](const PageRankPair& p) { return p.page; },
+                [](const PageRankPair& p1, const PageRankPair& p2) {
+                    return PageRankPair { p1.page, p1.rank + p2.rank };
+                },
+                num_pages, PageRankPair { 0, 0.0 },
+                DenseReduceToIndexConfig())
+            .Map([&ranks, &index, num_pages_d](const PageRankPair& p) {
+                     Rank rank =
+                         dampening * p.rank + (1 - dampening) / num_pages_d;
+                     assert(index < ranks.size());
+                     double diff = std::abs(rank - ranks[index]);
+                     ranks[index++] = rank;
+                     return diff;
+                 })
+            .Sum();
+
+        die_unless(index == ranks.size());
+
+        if (ctx.my_rank() == 0)
+            sLOG << "PageRankDense iteration" << iter << "change" << change;
+    }
+
+    return ConcatToDIA(ctx, std::move(ranks));
+}
+
 template <const bool UseLocationDetection = true, typename InStack>
 auto PageRankJoinSelf(const DIA<LinkedPage, InStack>& links, size_t iterations) {
 
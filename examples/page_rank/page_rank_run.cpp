@@ -49,7 +49,7 @@ struct PageRankLineParser {
 static void RunPageRankEdgePerLine(
     api::Context& ctx,
     const std::vector<std::string>& input_path, const std::string& output_path,
-    size_t iterations) {
+    size_t iterations, bool dense) {
     ctx.enable_consume();
 
     common::StatsTimerStart timer;
@@ -89,7 +89,8 @@ static void RunPageRankEdgePerLine(
 
     // perform actual page rank calculation iterations
 
-    auto ranks = PageRank(links, num_pages, iterations);
+    DIA<Rank> ranks = dense ? PageRankDense(links, num_pages, iterations)
+                      : PageRank(links, num_pages, iterations);
 
     // construct output as "pageid: rank"
 
@@ -199,7 +200,7 @@ static void RunJoinPageRankEdgePerLine(
 static void RunPageRankGenerated(
     api::Context& ctx,
     const std::string& input_path, const ZipfGraphGen& base_graph_gen,
-    const std::string& output_path, size_t iterations) {
+    const std::string& output_path, size_t iterations, bool dense) {
     ctx.enable_consume();
 
     common::StatsTimerStart timer;
@@ -222,7 +223,8 @@ static void RunPageRankGenerated(
 
     // perform actual page rank calculation iterations
 
-    auto ranks = PageRank(links, num_pages, iterations);
+    DIA<Rank> ranks = dense ? PageRankDense(links, num_pages, iterations)
+                      : PageRank(links, num_pages, iterations);
 
     // construct output as "pageid: rank"
 
@@ -318,6 +320,10 @@ int main(int argc, char* argv[]) {
     bool use_join = false;
     clp.add_bool('j', "join", use_join,
                  "use Join() instead of *ByIndex()");
+    bool dense = false;
+    clp.add_bool('d', "dense", dense,
+                 "keep the ranks in local arrays and exchange only "
+                 "contributions with a dense ReduceToIndex()");
 
     // Graph Generator
     ZipfGraphGen gg(1);
@@ -361,10 +367,10 @@ int main(int argc, char* argv[]) {
         [&](api::Context& ctx) {
             if (generate && !use_join)
                 return RunPageRankGenerated(
-                    ctx, input_path[0], gg, output_path, iter);
+                    ctx, input_path[0], gg, output_path, iter, dense);
             else if (!generate && !use_join)
                 return RunPageRankEdgePerLine(
-                    ctx, input_path, output_path, iter);
+                    ctx, input_path, output_path, iter, dense);
             else if (generate && use_join)
                 return RunPageRankJoinGenerated(
                     ctx, input_path[0], gg, output_path, iter);
@@ -15,6 +15,7 @@
 
 #include <thrill/api/bernoulli_sample.hpp>
 #include <thrill/api/dia.hpp>
+#include <thrill/api/map_partitions.hpp>
 #include <thrill/api/sum.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/vector.hpp>
@@ -23,7 +24,9 @@
 #include <thrill/data/serialization_cereal.hpp>
 
 #include <algorithm>
+#include <cassert>
 #include <utility>
+#include <vector>
 
 namespace examples {
 namespace stochastic_gradient_descent {
@@ -80,6 +83,49 @@ struct SumResult {
     }
 };
 
+/*!
+ * A block of data points in columnar layout: feature f of the r-th point is
+ * column(f)[r]. The gradient kernels loop over contiguous columns, which
+ * compilers vectorize, instead of over the points' separate Vectors.
+ */
+class ColumnarBlock
+{
+public:
+    ColumnarBlock(size_t dim, size_t capacity)
+        : dim_(dim), capacity_(capacity),
+          features_(dim * capacity), labels_(capacity), residual_(capacity) { }
+
+    size_t dim() const { return dim_; }
+    size_t rows() const { return rows_; }
+    bool full() const { return rows_ == capacity_; }
+    void clear() { rows_ = 0; }
+
+    //! append a point, the block must not be full
+    template <typename Vector>
+    void Push(const DataPoint<Vector>& p) {
+        assert(!full());
+        for (size_t f = 0; f < dim_; ++f)
+            features_[f * capacity_ + rows_] = p.data.x[f];
+        labels_[rows_++] = p.label;
+    }
+
+    const double * column(size_t f) const {
+        return features_.data() + f * capacity_;
+    }
+    const double * labels() const { return labels_.data(); }
+
+    //! scratch space of one double per row for the kernels
+    double * residual() { return residual_.data(); }
+
+private:
+    size_t dim_;
+    size_t capacity_;
+    size_t rows_ = 0;
+    std::vector<double> features_;
+    std::vector<double> labels_;
+    std::vector<double> residual_;
+};
+
 //! simple implementation of a gradient computation class using a least squares
 //! cost function and a linear model (y = w*x)
 template <typename Vector>
@@ -93,18 +139,55 @@ public:
         auto gradient = diff * data;
         return GradientResult<Vector>({ gradient, loss });
     }
+
+    //! add the gradients of the rows [begin,end) of a block to grad and return
+    //! their loss, computing the residuals column by column.
+    static double ComputeBlock(ColumnarBlock& block, size_t begin, size_t end,
+                               const Vector& weights, Vector& grad) {
+        double* residual = block.residual();
+        const double* labels = block.labels();
+        for (size_t r = begin; r < end; ++r)
+            residual[r] = -labels[r];
+        for (size_t f = 0; f < block.dim(); ++f) {
+            const double* col = block.column(f);
+            const double w = weights.x[f];
+            for (size_t r = begin; r < end; ++r)
+                residual[r] += w * col[r];
+        }
+        double loss = 0.0;
+        for (size_t r = begin; r < end; ++r)
+            loss += residual[r] * residual[r];
+        for (size_t f = 0; f < block.dim(); ++f) {
+            const double* col = block.column(f);
+            double g = 0.0;
+            for (size_t r = begin; r < end; ++r)
+                g += residual[r] * col[r];
+            grad.x[f] += g;
+        }
+        return 0.5 * loss;
+    }
 };
 
+/*!
+ * Gradient descent of a least squares linear model. Each iteration draws a
+ * mini-batch with BernoulliSample from the (cached) input points. With
+ * local_steps = 1, the gradients of the mini-batch are summed globally and one
+ * step is taken. With local_steps > 1 (local SGD, or model averaging), each
+ * worker takes local_steps steps on parts of its share of the mini-batch
+ * without communication, and the models are averaged, weighted by the number
+ * of points, at the end of the iteration.
+ */
 template <typename Vector>
 class StochasticGradientDescent
 {
 public:
     StochasticGradientDescent(
         size_t num_iterations, double mini_batch_fraction,
-        double step_size, double tolerance)
+        double step_size, double tolerance, size_t local_steps = 1)
         : num_iterations(num_iterations),
           mini_batch_fraction(mini_batch_fraction),
-          step_size(step_size), tolerance(tolerance)
+          step_size(step_size), tolerance(tolerance),
+          local_steps(std::max<size_t>(local_steps, 1))
     { }
 
     //! do the actual computation
@@ -117,40 +200,34 @@ public:
             LOG1 << "weights: " << weights;
             auto old_weights = weights;
             auto sample = input_points.BernoulliSample(mini_batch_fraction);
-            auto sum_result =
-                sample
-                .Map([&weights](const DataPoint<Vector>& p) {
-                         auto grad = LeastSquaresGradient<Vector>::Compute(
-                             p.data, p.label, weights);
-                         return SumResult<Vector>({ grad, 1 });
-                     })
-                .Sum(
-                    [](const SumResult<Vector>& a, const SumResult<Vector>& b) {
-                        return SumResult<Vector>(
-                            {
-                                a.grad + b.grad,
-                                // number of data points (BernoulliSample yields
-                                // only an approximate fraction)
-                                a.count + b.count
-                            });
-                    },
-                    SumResult<Vector>{
-                        GradientResult<Vector>{
-                            Vector::Make(weights.size()).fill(0.0), 0.0
-                        }, 0
-                    });
+            double eta = step_size / sqrt(i);
+
+            if (local_steps == 1) {
+                auto sum_result = GradientSum(sample, weights);
+                auto weight_gradient_sum = sum_result.grad;
+
+                LOG1 << "n: " << sum_result.count;
+                LOG1 << "grad: " << weight_gradient_sum.weights;
+                LOG1 << "loss: " << weight_gradient_sum.loss;
 
-            auto weight_gradient_sum = sum_result.grad;
+                // w = w - eta sum_i=0^n Q(w_i) / n
+                // with adaptive step_size eta, and gradient Q(w_i)
+                if (sum_result.count != 0) {
+                    weights = weights -
+                              eta * weight_gradient_sum.weights
+                              / sum_result.count;
+                }
+            }
+            else {
+                auto sum_result = LocalModelSum(sample, weights, eta);
 
-            LOG1 << "n: " << sum_result.count;
-            LOG1 << "grad: " << weight_gradient_sum.weights;
-            LOG1 << "loss: " << weight_gradient_sum.loss;
+                LOG1 << "n: " << sum_result.count;
+                LOG1 << "loss: " << sum_result.grad.loss;
 
-            // w = w - eta sum_i=0^n Q(w_i) / n
-            // with adaptive step_size eta, and gradient Q(w_i)
-            weights = weights -
-                      (step_size / sqrt(i))
-                      * weight_gradient_sum.weights / sum_result.count;
+                // average of the local models weighted by their points
+                if (sum_result.count != 0)
+                    weights = sum_result.grad.weights / sum_result.count;
+            }
             ++i;
             converged = is_converged(old_weights, weights, tolerance);
         }
@@ -163,6 +240,95 @@ private:
     double mini_batch_fraction;
     double step_size;
     double tolerance;
+    size_t local_steps;
+
+    //! rows of the columnar blocks of the gradient kernel
+    static constexpr size_t block_size = 1024;
+
+    static Vector Zero(const Vector& like) {
+        return Vector::Make(like.size()).fill(0.0);
+    }
+
+    static SumResult<Vector> Add(
+        const SumResult<Vector>& a, const SumResult<Vector>& b) {
+        return SumResult<Vector>(
+            {
+                a.grad + b.grad,
+                // number of data points (BernoulliSample yields only an
+                // approximate fraction)
+                a.count + b.count
+            });
+    }
+
+    //! sum of the gradients of the sample at weights, computed by each worker
+    //! in columnar blocks.
+    template <typename SampleDIA>
+    SumResult<Vector> GradientSum(const SampleDIA& sample,
+                                  const Vector& weights) {
+        return sample
+               .template MapPartitions<SumResult<Vector> >(
+            [&weights](auto& reader, auto emit) {
+                Vector grad = Zero(weights);
+                double loss = 0.0;
+                ColumnarBlock block(weights.size(), block_size);
+                auto flush = [&]() {
+                                 loss += LeastSquaresGradient<Vector>::
+                                         ComputeBlock(block, 0, block.rows(),
+                                                      weights, grad);
+                                 block.clear();
+                             };
+                size_t count = reader.size();
+                while (reader.HasNext()) {
+                    block.Push(reader.Next());
+                    if (block.full()) flush();
+                }
+                flush();
+                emit(SumResult<Vector>(
+                         { GradientResult<Vector>{ grad, loss },
+                           static_cast<double>(count) }));
+            })
+               .Sum([](const SumResult<Vector>& a,
+                       const SumResult<Vector>& b) { return Add(a, b); },
+                    SumResult<Vector>{
+                        GradientResult<Vector>{ Zero(weights), 0.0 }, 0
+                    });
+    }
+
+    //! sum of the local models, each multiplied by its number of points, after
+    //! local_steps steps of each worker on its share of the sample.
+    template <typename SampleDIA>
+    SumResult<Vector> LocalModelSum(const SampleDIA& sample,
+                                    const Vector& weights, double eta) {
+        size_t steps = local_steps;
+        return sample
+               .template MapPartitions<SumResult<Vector> >(
+            [&weights, steps, eta](auto& reader, auto emit) {
+                size_t count = reader.size();
+                ColumnarBlock block(weights.size(), count);
+                while (reader.HasNext())
+                    block.Push(reader.Next());
+
+                Vector local = weights;
+                double loss = 0.0;
+                for (size_t s = 0; s < steps; ++s) {
+                    size_t begin = s * count / steps;
+                    size_t end = (s + 1) * count / steps;
+                    if (begin == end) continue;
+                    Vector grad = Zero(weights);
+                    loss += LeastSquaresGradient<Vector>::ComputeBlock(
+                        block, begin, end, local, grad);
+                    local = local - eta * grad / static_cast<double>(end - begin);
+                }
+                double n = static_cast<double>(count);
+                emit(SumResult<Vector>(
+                         { GradientResult<Vector>{ n * local, loss }, n }));
+            })
+               .Sum([](const SumResult<Vector>& a,
+                       const SumResult<Vector>& b) { return Add(a, b); },
+                    SumResult<Vector>{
+                        GradientResult<Vector>{ Zero(weights), 0.0 }, 0
+                    });
+    }
 
     bool is_converged(Vector& old, Vector& curr, double tolerance) {
         return old.Distance(curr) < tolerance* std::max(curr.Norm(), 1.0);
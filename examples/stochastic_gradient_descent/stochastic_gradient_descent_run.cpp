@@ -96,7 +96,7 @@ template <typename Vector>
 static void RunStochasticGradGenerated(
     thrill::Context& ctx, size_t dimensions, size_t iterations,
     size_t num_points, double mini_batch_fraction,
-    double step_size, double tolerance,
+    double step_size, double tolerance, size_t local_steps,
     const std::string& svg_path, double svg_scale, size_t repetitions) {
 
     std::default_random_engine rng(2342);
@@ -124,7 +124,8 @@ static void RunStochasticGradGenerated(
 
     for (size_t r = 0; r < repetitions; r++) {
         auto grad_descent = StochasticGradientDescent<Vector>(
-            iterations, mini_batch_fraction, step_size, tolerance);
+            iterations, mini_batch_fraction, step_size, tolerance,
+            local_steps);
 
         auto initial_weights = Vector::Make(dimensions).fill(1.0);
         result = grad_descent.optimize(points, initial_weights);
@@ -145,7 +146,7 @@ template <typename Vector>
 static void RunStochasticGradFile(
     thrill::Context& ctx, size_t dimensions, size_t iterations,
     double mini_batch_fraction, double step_size, double tolerance,
-    const std::string& svg_path, double svg_scale,
+    size_t local_steps, const std::string& svg_path, double svg_scale,
     const std::string& input_path, size_t repetitions) {
 
     auto points =
@@ -187,7 +188,8 @@ static void RunStochasticGradFile(
 
     for (size_t r = 0; r < repetitions; r++) {
         auto grad_descent = StochasticGradientDescent<Vector>(
-            iterations, mini_batch_fraction, step_size, tolerance);
+            iterations, mini_batch_fraction, step_size, tolerance,
+            local_steps);
 
         auto initial_weights = Vector::Make(dimensions).fill(1.0);
         result = grad_descent.optimize(points, initial_weights);
@@ -241,6 +243,11 @@ int main(int argc, char* argv[]) {
     cp.add_double('t', "tolerance", tolerance,
                   "tolerance, default: 0.01");
 
+    size_t local_steps = 1;
+    cp.add_size_t('l', "local-steps", local_steps,
+                  "local steps of each worker between model averaging, "
+                  "default: 1 (synchronous mini-batch SGD)");
+
     std::string input_path = "";
     cp.add_string('p', "paths", input_path,
                   "input file");
@@ -272,13 +279,13 @@ int main(int argc, char* argv[]) {
                     die("Zero dimensional gradient descent doesn't seem very useful.");
                     break;
                 case 1:
-                    RunStochasticGradGenerated<Vector<1> >(ctx, dimensions, iterations, num, mini_batch_fraction, step_size, tolerance, svg_path, svg_scale, repetitions);
+                    RunStochasticGradGenerated<Vector<1> >(ctx, dimensions, iterations, num, mini_batch_fraction, step_size, tolerance, local_steps, svg_path, svg_scale, repetitions);
                     break;
                 case 2:
-                    RunStochasticGradGenerated<Vector<2> >(ctx, dimensions, iterations, num, mini_batch_fraction, step_size, tolerance, svg_path, svg_scale, repetitions);
+                    RunStochasticGradGenerated<Vector<2> >(ctx, dimensions, iterations, num, mini_batch_fraction, step_size, tolerance, local_steps, svg_path, svg_scale, repetitions);
                     break;
                 default:
-                    RunStochasticGradGenerated<VVector>(ctx, dimensions, iterations, num, mini_batch_fraction, step_size, tolerance, svg_path, svg_scale, repetitions);
+                    RunStochasticGradGenerated<VVector>(ctx, dimensions, iterations, num, mini_batch_fraction, step_size, tolerance, local_steps, svg_path, svg_scale, repetitions);
                     break;
                 }
             }
@@ -288,13 +295,13 @@ int main(int argc, char* argv[]) {
                     die("Zero dimensional gradient descent doesn't seem very useful.");
                     break;
                 case 1:
-                    RunStochasticGradFile<Vector<1> >(ctx, dimensions, iterations, mini_batch_fraction, step_size, tolerance, svg_path, svg_scale, input_path, repetitions);
+                    RunStochasticGradFile<Vector<1> >(ctx, dimensions, iterations, mini_batch_fraction, step_size, tolerance, local_steps, svg_path, svg_scale, input_path, repetitions);
                     break;
                 case 2:
-                    RunStochasticGradFile<Vector<2> >(ctx, dimensions, iterations, mini_batch_fraction, step_size, tolerance, svg_path, svg_scale, input_path, repetitions);
+                    RunStochasticGradFile<Vector<2> >(ctx, dimensions, iterations, mini_batch_fraction, step_size, tolerance, local_steps, svg_path, svg_scale, input_path, repetitions);
                     break;
                 default:
-                    RunStochasticGradFile<VVector>(ctx, dimensions, iterations, mini_batch_fraction, step_size, tolerance, svg_path, svg_scale, input_path, repetitions);
+                    RunStochasticGradFile<VVector>(ctx, dimensions, iterations, mini_batch_fraction, step_size, tolerance, local_steps, svg_path, svg_scale, input_path, repetitions);
                     break;
                 }
             }
@@ -28,6 +28,7 @@
 #include <thrill/api/zip.hpp>
 #include <thrill/api/zip_window.hpp>
 #include <thrill/api/zip_with_index.hpp>
+#include <thrill/common/lsd_radix_sort.hpp>
 #include <thrill/common/radix_sort.hpp>
 #include <thrill/common/uint_types.hpp>
 
@@ -401,7 +402,12 @@ DC3Recursive(const InputDIA& input_dia, size_t input_size, size_t K) {
                           return a.index < b.index;
                       else
                           return a.index % 3 < b.index % 3;
-                  });
+                  },
+                  // the same order as integer keys, indexes are below 2^62
+                  common::MakeLsdRadixSort(
+                      [](const IndexRank& a) {
+                          return uint64_t(a.index % 3) << 62 | uint64_t(a.index);
+                      }, ctx.num_threads_per_worker()));
 
         if (debug_print)
             triple_ranks_sorted.Keep().Print("triple_ranks_sorted");
@@ -439,7 +445,14 @@ DC3Recursive(const InputDIA& input_dia, size_t input_size, size_t K) {
                       return a.index % size_mod1 < b.index % size_mod1 || (
                           a.index % size_mod1 == b.index % size_mod1 &&
                           a.index < b.index);
-                  });
+                  },
+                  // the same order as integer keys, indexes are below
+                  // 2 * size_mod1
+                  common::MakeLsdRadixSort(
+                      [size_mod1](const IndexRank& a) {
+                          return 2 * uint64_t(a.index % size_mod1) +
+                          (a.index >= size_mod1 ? 1 : 0);
+                      }, ctx.num_threads_per_worker()));
 
         if (debug_print) {
             // check that ranks are correctly interleaved
@@ -474,7 +487,11 @@ DC3Recursive(const InputDIA& input_dia, size_t input_size, size_t K) {
                       return a.index / 3 < b.index / 3 || (
                           a.index / 3 == b.index / 3 &&
                           a.index < b.index);
-                  });
+                  },
+                  // which is the order of the indexes
+                  common::MakeLsdRadixSort(
+                      [](const IndexRank& a) { return uint64_t(a.index); },
+                      ctx.num_threads_per_worker()));
 
         if (debug_print) {
             // check that ranks are correctly interleaved
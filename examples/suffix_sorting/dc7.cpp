@@ -27,6 +27,7 @@
 #include <thrill/api/window.hpp>
 #include <thrill/api/zip_window.hpp>
 #include <thrill/api/zip_with_index.hpp>
+#include <thrill/common/lsd_radix_sort.hpp>
 #include <thrill/common/radix_sort.hpp>
 #include <thrill/common/uint_types.hpp>
 #include <tlx/cmdline_parser.hpp>
@@ -562,7 +563,12 @@ DC7Recursive(const InputDIA& input_dia, size_t input_size, size_t K) {
                           return a.index < b.index;
                       else
                           return a.index % 7 < b.index % 7;
-                  })
+                  },
+                  // the same order as integer keys, indexes are below 2^61
+                  common::MakeLsdRadixSort(
+                      [](const IndexRank& a) {
+                          return uint64_t(a.index % 7) << 61 | uint64_t(a.index);
+                      }, ctx.num_threads_per_worker()))
             .Map([](const IndexRank& tr) {
                      return tr.rank;
                  })
@@ -604,7 +610,16 @@ DC7Recursive(const InputDIA& input_dia, size_t input_size, size_t K) {
 
                       // use sort order to interleave ranks mod 0/1/3
                       return ai < bi || (ai == bi && a.index < b.index);
-                  });
+                  },
+                  // the same order as integer keys of ai and the part
+                  common::MakeLsdRadixSort(
+                      [size_mod0, size_mod01](const IndexRank& a) {
+                          return a.index < size_mod0 ?
+                          3 * uint64_t(a.index) :
+                          a.index < size_mod01 ?
+                          3 * uint64_t(a.index - size_mod0) + 1 :
+                          3 * uint64_t(a.index - size_mod01) + 2;
+                      }, ctx.num_threads_per_worker()));
 
         if (debug_print) {
             // check that ranks are correctly interleaved
@@ -641,7 +656,11 @@ DC7Recursive(const InputDIA& input_dia, size_t input_size, size_t K) {
                       return a.index / 7 < b.index / 7 || (
                           a.index / 7 == b.index / 7 &&
                           a.index < b.index);
-                  });
+                  },
+                  // which is the order of the indexes
+                  common::MakeLsdRadixSort(
+                      [](const IndexRank& a) { return uint64_t(a.index); },
+                      ctx.num_threads_per_worker()));
 
         if (debug_print) {
             // check that ranks are correctly interleaved
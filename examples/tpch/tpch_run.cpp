@@ -1,6 +1,9 @@
 /*******************************************************************************
  * examples/tpch/tpch_run.cpp
  *
+ * TPC-H queries 1, 3, 4, 5, 6, and 9 on tables stored as Arrow IPC streams.
+ * The tables generated by dbgen are converted once with --convert.
+ *
  * Part of Project Thrill - http://project-thrill.org
  *
  * Copyright (C) 2016 Alexander Noe <aleexnoe@gmail.com>
@@ -8,297 +11,755 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
-#include <examples/page_rank/zipf_graph_gen.hpp>
-#include <examples/triangles/triangles.hpp>
-
-#include <thrill/api/cache.hpp>
+#include <thrill/api/all_gather.hpp>
 #include <thrill/api/dia.hpp>
-#include <thrill/api/generate.hpp>
 #include <thrill/api/inner_join.hpp>
+#include <thrill/api/map_partitions.hpp>
+#include <thrill/api/read_arrow_stream.hpp>
 #include <thrill/api/read_lines.hpp>
-#include <thrill/api/size.hpp>
+#include <thrill/api/reduce_by_key.hpp>
+#include <thrill/api/semi_join.hpp>
+#include <thrill/api/sum.hpp>
+#include <thrill/api/top_k.hpp>
+#include <thrill/api/write_arrow_stream.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/stats_timer.hpp>
-#include <thrill/common/string.hpp>
 #include <tlx/cmdline_parser.hpp>
+#include <tlx/die.hpp>
 
 #include <tlx/string/split.hpp>
 
 #include <algorithm>
-#include <cmath>
-#include <ctime>
+#include <cstdlib>
+#include <fstream>
 #include <functional>
+#include <map>
+#include <sstream>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 using namespace thrill;              // NOLINT
 
-struct LineItem {
-    size_t orderkey;
-    size_t partkey;
-    size_t suppkey;
-    size_t linenumber;
-    size_t quantity;
-    double extendedprice;
-    double discount;
-    double tax;
-    char   returnflag;
-    char   linestatus;
-    time_t ship;
-    time_t commit;
-    time_t receipt;
-    char   shipinstruct[25];
-    char   shipmode[10];
-    char   comment[44];
-} TLX_ATTRIBUTE_PACKED;
-
-struct Order {
-    size_t orderkey;
-    size_t custkey;
-    char   orderstatus;
-    double totalprice;
-    time_t ordertime;
-    char   orderpriority[16];
-    char   clerk[16];
-    bool   priority;
-    char   comment[79];
-
-    friend std::ostream& operator << (std::ostream& os, const Order& o) {
-        os << '(' << o.orderpriority << "|" << o.clerk << "|" << o.comment;
-        return os << ')';
+/******************************************************************************/
+// Tables: only the columns used by the queries, with dates as days since
+// 1970-01-01 and decimals as doubles.
+
+using LineItem = std::tuple<
+    int64_t, int64_t, int64_t, double, double, double, double,
+    char, char, int32_t, int32_t, int32_t>;
+enum {
+    L_ORDERKEY, L_PARTKEY, L_SUPPKEY, L_QUANTITY, L_EXTENDEDPRICE,
+    L_DISCOUNT, L_TAX, L_RETURNFLAG, L_LINESTATUS, L_SHIPDATE,
+    L_COMMITDATE, L_RECEIPTDATE
+};
+
+using Order = std::tuple<int64_t, int64_t, int32_t, std::string, int32_t>;
+enum {
+    O_ORDERKEY, O_CUSTKEY, O_ORDERDATE, O_ORDERPRIORITY, O_SHIPPRIORITY
+};
+
+using Customer = std::tuple<int64_t, int64_t, std::string>;
+enum { C_CUSTKEY, C_NATIONKEY, C_MKTSEGMENT };
+
+using Supplier = std::tuple<int64_t, int64_t>;
+enum { S_SUPPKEY, S_NATIONKEY };
+
+using Nation = std::tuple<int64_t, int64_t, std::string>;
+enum { N_NATIONKEY, N_REGIONKEY, N_NAME };
+
+using Region = std::tuple<int64_t, std::string>;
+enum { R_REGIONKEY, R_NAME };
+
+using Part = std::tuple<int64_t, std::string>;
+enum { P_PARTKEY, P_NAME };
+
+using PartSupp = std::tuple<int64_t, int64_t, double>;
+enum { PS_PARTKEY, PS_SUPPKEY, PS_SUPPLYCOST };
+
+//! days since 1970-01-01 of a date "YYYY-MM-DD"
+static int32_t ParseDate(const std::string& str) {
+    int y = std::atoi(str.c_str());
+    int m = std::atoi(str.c_str() + 5);
+    int d = std::atoi(str.c_str() + 8);
+    // count years from March, such that the leap day is last
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+//! year of a date in days since 1970-01-01
+static int32_t YearOfDate(int32_t days) {
+    int z = days + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int doe = z - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    return yoe + era * 400 + (mp >= 10);
+}
+
+static std::string ArrowPath(const std::string& prefix,
+                             const std::string& table) {
+    return prefix + table + ".arrow-$$$$$";
+}
+
+template <typename Row>
+static auto ReadTable(api::Context& ctx, const std::string& prefix,
+                      const std::string& table) {
+    return ReadArrowStream<Row>(ctx, prefix + table + ".arrow-*");
+}
+
+/******************************************************************************/
+// Conversion of dbgen's text tables
+
+//! parse the '|' separated lines of prefix + table into rows, and write them
+//! as one Arrow stream per worker.
+template <typename Parse>
+static void ConvertTable(
+    api::Context& ctx, const std::string& prefix, const std::string& table,
+    const std::vector<std::string>& column_names, const Parse& parse) {
+    ReadLines(ctx, prefix + table)
+    .Map([parse](const std::string& line) {
+             return parse(tlx::split('|', line));
+         })
+    .WriteArrowStream(ArrowPath(prefix, table), column_names);
+}
+
+static void ConvertTables(api::Context& ctx, const std::string& prefix) {
+    using Fields = std::vector<std::string>;
+    auto i64 = [](const std::string& s) {
+                   return static_cast<int64_t>(
+                       std::strtoll(s.c_str(), nullptr, 10));
+               };
+    auto dbl = [](const std::string& s) {
+                   return std::strtod(s.c_str(), nullptr);
+               };
+
+    ConvertTable(
+        ctx, prefix, "lineitem",
+        { "orderkey", "partkey", "suppkey", "quantity", "extendedprice",
+          "discount", "tax", "returnflag", "linestatus", "shipdate",
+          "commitdate", "receiptdate" },
+        [=](const Fields& f) {
+            return LineItem(
+                i64(f[0]), i64(f[1]), i64(f[2]), dbl(f[4]), dbl(f[5]),
+                dbl(f[6]), dbl(f[7]), f[8][0], f[9][0], ParseDate(f[10]),
+                ParseDate(f[11]), ParseDate(f[12]));
+        });
+    ConvertTable(
+        ctx, prefix, "orders",
+        { "orderkey", "custkey", "orderdate", "orderpriority",
+          "shippriority" },
+        [=](const Fields& f) {
+            return Order(i64(f[0]), i64(f[1]), ParseDate(f[4]), f[5],
+                         static_cast<int32_t>(i64(f[7])));
+        });
+    ConvertTable(
+        ctx, prefix, "customer", { "custkey", "nationkey", "mktsegment" },
+        [=](const Fields& f) {
+            return Customer(i64(f[0]), i64(f[3]), f[6]);
+        });
+    ConvertTable(
+        ctx, prefix, "supplier", { "suppkey", "nationkey" },
+        [=](const Fields& f) { return Supplier(i64(f[0]), i64(f[3])); });
+    ConvertTable(
+        ctx, prefix, "nation", { "nationkey", "regionkey", "name" },
+        [=](const Fields& f) { return Nation(i64(f[0]), i64(f[2]), f[1]); });
+    ConvertTable(
+        ctx, prefix, "region", { "regionkey", "name" },
+        [=](const Fields& f) { return Region(i64(f[0]), f[1]); });
+    ConvertTable(
+        ctx, prefix, "part", { "partkey", "name" },
+        [=](const Fields& f) { return Part(i64(f[0]), f[1]); });
+    ConvertTable(
+        ctx, prefix, "partsupp", { "partkey", "suppkey", "supplycost" },
+        [=](const Fields& f) {
+            return PartSupp(i64(f[0]), i64(f[1]), dbl(f[3]));
+        });
+}
+
+/******************************************************************************/
+// Vectorized scan operators
+
+/*!
+ * Columns of a batch of lineitem rows. The scans of Q1 and Q6 evaluate their
+ * predicates and aggregates by branch-free loops over these arrays, which
+ * compilers vectorize, instead of item by item.
+ */
+struct LineItemBatch {
+    static constexpr size_t capacity = 1024;
+
+    size_t size = 0;
+    std::vector<double> quantity, extendedprice, discount, tax;
+    std::vector<int32_t> shipdate;
+    //! Q1 group of (returnflag, linestatus)
+    std::vector<uint8_t> group;
+
+    LineItemBatch()
+        : quantity(capacity), extendedprice(capacity), discount(capacity),
+          tax(capacity), shipdate(capacity), group(capacity) { }
+
+    void Push(const LineItem& l) {
+        quantity[size] = std::get<L_QUANTITY>(l);
+        extendedprice[size] = std::get<L_EXTENDEDPRICE>(l);
+        discount[size] = std::get<L_DISCOUNT>(l);
+        tax[size] = std::get<L_TAX>(l);
+        shipdate[size] = std::get<L_SHIPDATE>(l);
+        group[size] = GroupOf(std::get<L_RETURNFLAG>(l),
+                              std::get<L_LINESTATUS>(l));
+        ++size;
+    }
+
+    //! returnflags A, N, R times linestatus F, O
+    static constexpr size_t num_groups = 6;
+    static const char* flags() { return "ANR"; }
+    static const char* statuses() { return "FO"; }
+
+    static uint8_t GroupOf(char returnflag, char linestatus) {
+        return static_cast<uint8_t>(
+            2 * (returnflag == 'N' ? 1 : returnflag == 'R' ? 2 : 0) +
+            (linestatus == 'O' ? 1 : 0));
     }
-} TLX_ATTRIBUTE_PACKED;
-
-struct JoinedElement {
-    size_t orderkey;
-    size_t partkey;
-    size_t suppkey;
-    size_t linenumber;
-    size_t quantity;
-    double extendedprice;
-    double discount;
-    double tax;
-    char   returnflag;
-    char   linestatus;
-    time_t ship;
-    time_t commit;
-    time_t receipt;
-    char   shipinstruct[25];
-    char   shipmode[10];
-    char   lineitem_comment[44];
-    size_t custkey;
-    char   orderstatus;
-    double totalprice;
-    time_t ordertime;
-    char   orderpriority[16];
-    char   clerk[16];
-    bool   priority;
-    char   order_comment[79];
-} TLX_ATTRIBUTE_PACKED;
-
-JoinedElement ConstructJoinedElement(const struct LineItem& li, const struct Order& o) {
-    JoinedElement je;
-    je.orderkey = li.orderkey;
-    je.partkey = li.partkey;
-    je.suppkey = li.suppkey;
-    je.linenumber = li.linenumber;
-    je.quantity = li.quantity;
-    je.extendedprice = li.extendedprice;
-    je.discount = li.discount;
-    je.tax = li.tax;
-    je.returnflag = li.returnflag;
-    je.linestatus = li.linestatus;
-    je.ship = li.ship;
-    je.commit = li.commit;
-    je.receipt = li.receipt;
-    snprintf(je.shipinstruct, sizeof(je.shipinstruct),
-             "%s", li.shipinstruct);
-    snprintf(je.shipmode, sizeof(je.shipmode),
-             "%s", li.shipmode);
-    snprintf(je.lineitem_comment, sizeof(je.lineitem_comment),
-             "%s", li.comment);
-    je.custkey = o.custkey;
-    je.orderstatus = o.orderstatus;
-    je.totalprice = o.totalprice;
-    je.ordertime = o.ordertime;
-    snprintf(je.orderpriority, sizeof(je.orderpriority),
-             "%s", o.orderpriority);
-    snprintf(je.clerk, sizeof(je.clerk),
-             "%s", o.clerk);
-    je.priority = o.priority;
-    snprintf(je.order_comment, sizeof(je.order_comment),
-             "%s", o.comment);
-    return je;
+};
+
+//! call kernel on batches of the reader's lineitems
+template <typename Reader, typename Kernel>
+static void ForEachBatch(Reader& reader, const Kernel& kernel) {
+    LineItemBatch batch;
+    while (reader.HasNext()) {
+        batch.Push(reader.Next());
+        if (batch.size == LineItemBatch::capacity) {
+            kernel(batch);
+            batch.size = 0;
+        }
+    }
+    if (batch.size != 0) kernel(batch);
 }
 
-// adapted from:
-// https://gmbabar.wordpress.com/2010/12/01/mktime-slow-use-custom-function/
-// removed time of day as we dont need that
-time_t time_to_epoch(const std::string& str) {
-    char* end;
-
-    struct tm ltm;
-    ltm.tm_year = std::strtoul(str.substr(0, 4).c_str(),
-                               &end, 10) - 1900;
-    ltm.tm_mon = std::strtoul(str.substr(5, 2).c_str(),
-                              &end, 10);
-    ltm.tm_mday = std::strtoul(str.substr(8).c_str(),
-                               &end, 10);
-
-    const int mon_days[] =
-    { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-    long tyears, tdays, leaps;
-    int i;
-
-    tyears = ltm.tm_year - 70; // tm->tm_year is from 1900.
-    leaps = (tyears + 2) / 4;  // no of next two lines until year 2100.
-    // i = (ltm->tm_year – 100) / 100;
-    // leaps -= ( (i/4)*3 + i%4 );
-    tdays = 0;
-    for (i = 0; i < ltm.tm_mon; i++) tdays += mon_days[i];
-
-    tdays += ltm.tm_mday - 1; // days of month passed.
-    tdays = tdays + (tyears * 365) + leaps;
-
-    return (tdays * 86400);
+/******************************************************************************/
+
+//! names of the nations, which are gathered on all workers
+static std::map<int64_t, std::string> NationNames(
+    api::Context& ctx, const std::string& prefix) {
+    std::map<int64_t, std::string> names;
+    for (const Nation& n : ReadTable<Nation>(ctx, prefix, "nation").AllGather())
+        names[std::get<N_NATIONKEY>(n)] = std::get<N_NAME>(n);
+    return names;
 }
 
-static size_t JoinTPCH4(
-    api::Context& ctx,
-    const std::vector<std::string>& input_path) {
-    ctx.enable_consume();
-    std::vector<std::string> splitted;
-    splitted.resize(17);
-    std::string s_lineitems = input_path[0] + std::string("lineitem");
-
-    auto lineitems = ReadLines(ctx, s_lineitems).FlatMap<struct LineItem>(
-        [&splitted](const std::string& input, auto emit) {
-
-            LineItem li;
-            char* end;
-            tlx::split(&splitted, '|', input);
-
-            li.commit = time_to_epoch(splitted[11]);
-            li.receipt = time_to_epoch(splitted[12]);
-
-            if (li.commit < li.receipt) {
-
-                li.orderkey = std::strtoul(splitted[0].c_str(), &end, 10);
-                li.partkey = std::strtoul(splitted[1].c_str(), &end, 10);
-                li.suppkey = std::strtoul(splitted[2].c_str(), &end, 10);
-                li.linenumber = std::strtoul(splitted[3].c_str(), &end, 10);
-                li.quantity = std::strtoul(splitted[4].c_str(), &end, 10);
-                li.extendedprice = std::strtod(splitted[5].c_str(), &end);
-                li.discount = std::strtod(splitted[6].c_str(), &end);
-                li.tax = std::strtod(splitted[7].c_str(), &end);
-                li.returnflag = splitted[8][0];
-                li.linestatus = splitted[9][0];
-
-                li.ship = time_to_epoch(splitted[10]);
-
-                snprintf(li.shipinstruct, sizeof(li.shipinstruct),
-                         "%s", splitted[13].data());
-                snprintf(li.shipmode, sizeof(li.shipmode),
-                         "%s", splitted[14].data());
-                snprintf(li.comment, sizeof(li.comment),
-                         "%s", splitted[15].data());
-
-                emit(li);
-            }
-        }).Cache().Keep().Execute();
-
-    size_t num_items = lineitems.Size();
-
-    time_t starttime = time_to_epoch("1993-07-01");
-    time_t stoptime = time_to_epoch("1993-10-01");
-
-    std::string s_orders = input_path[0] + std::string("orders");
-    auto orders = ReadLines(ctx, s_orders).FlatMap<struct Order>(
-        [&splitted, &starttime, &stoptime](const std::string& input, auto emit) {
-            Order o;
-
-            char* end;
-            tlx::split(&splitted, '|', input);
-
-            o.ordertime = time_to_epoch(splitted[4]);
-            if (o.ordertime >= starttime && o.ordertime < stoptime) {
-                o.orderkey = std::strtoul(splitted[0].c_str(), &end, 10);
-                o.custkey = std::strtoul(splitted[1].c_str(), &end, 10);
-                o.orderstatus = splitted[2][0];
-                o.totalprice = std::strtod(splitted[3].c_str(), &end);
-                snprintf(o.orderpriority, sizeof(o.orderpriority),
-                         "%s", splitted[5].data());
-                snprintf(o.clerk, sizeof(o.clerk),
-                         "%s", splitted[6].data());
-                o.priority = (splitted[7][0] != '0');
-                snprintf(o.comment, sizeof(o.comment),
-                         "%s", splitted[8].data());
-
-                emit(o);
-            }
-        }).Cache().Keep().Execute();
+/******************************************************************************/
+// Queries, which return their result lines on worker 0
+
+using Lines = std::vector<std::string>;
+
+//! Q1: pricing summary report, a vectorized scan and aggregation.
+static Lines Query1(api::Context& ctx, const std::string& prefix) {
+    struct Q1Group {
+        size_t group;
+        double sum_qty, sum_base_price, sum_disc_price, sum_charge, sum_disc;
+        size_t count;
+    };
+
+    const int32_t date = ParseDate("1998-12-01") - 90;
+
+    std::vector<Q1Group> groups =
+        ReadTable<LineItem>(ctx, prefix, "lineitem")
+        .MapPartitions<Q1Group>(
+            [date](auto& reader, auto emit) {
+                Q1Group sums[LineItemBatch::num_groups] = { };
+                ForEachBatch(
+                    reader, [&](const LineItemBatch& b) {
+                        for (size_t g = 0; g < LineItemBatch::num_groups; ++g) {
+                            Q1Group& s = sums[g];
+                            for (size_t r = 0; r < b.size; ++r) {
+                                double m = (b.shipdate[r] <= date) &
+                                           (b.group[r] == g);
+                                double disc_price =
+                                    b.extendedprice[r] * (1 - b.discount[r]);
+                                s.sum_qty += m * b.quantity[r];
+                                s.sum_base_price += m * b.extendedprice[r];
+                                s.sum_disc_price += m * disc_price;
+                                s.sum_charge += m * disc_price * (1 + b.tax[r]);
+                                s.sum_disc += m * b.discount[r];
+                                s.count += static_cast<size_t>(m);
+                            }
+                        }
+                    });
+                for (size_t g = 0; g < LineItemBatch::num_groups; ++g) {
+                    sums[g].group = g;
+                    if (sums[g].count != 0) emit(sums[g]);
+                }
+            })
+        .ReduceByKey(
+            [](const Q1Group& a) { return a.group; },
+            [](const Q1Group& a, const Q1Group& b) {
+                return Q1Group {
+                    a.group, a.sum_qty + b.sum_qty,
+                    a.sum_base_price + b.sum_base_price,
+                    a.sum_disc_price + b.sum_disc_price,
+                    a.sum_charge + b.sum_charge, a.sum_disc + b.sum_disc,
+                    a.count + b.count
+                };
+            })
+        .AllGather();
+
+    std::sort(groups.begin(), groups.end(),
+              [](const Q1Group& a, const Q1Group& b) {
+                  return a.group < b.group;
+              });
+
+    Lines lines;
+    if (ctx.my_rank() != 0) return lines;
+    for (const Q1Group& g : groups) {
+        std::ostringstream os;
+        os << "Q1 " << LineItemBatch::flags()[g.group / 2]
+           << ' ' << LineItemBatch::statuses()[g.group % 2]
+           << " sum_qty=" << g.sum_qty
+           << " sum_base_price=" << g.sum_base_price
+           << " sum_disc_price=" << g.sum_disc_price
+           << " sum_charge=" << g.sum_charge
+           << " avg_qty=" << g.sum_qty / g.count
+           << " avg_price=" << g.sum_base_price / g.count
+           << " avg_disc=" << g.sum_disc / g.count
+           << " count_order=" << g.count;
+        lines.push_back(os.str());
+    }
+    return lines;
+}
 
-    ctx.net.Barrier();
+//! Q3: shipping priority, the top ten unshipped orders by revenue.
+static Lines Query3(api::Context& ctx, const std::string& prefix) {
+    struct Q3Order {
+        int64_t orderkey;
+        int32_t orderdate, shippriority;
+        double  revenue;
+    };
+
+    const int32_t date = ParseDate("1995-03-15");
+
+    auto customers =
+        ReadTable<Customer>(ctx, prefix, "customer")
+        .Filter([](const Customer& c) {
+                    return std::get<C_MKTSEGMENT>(c) == "BUILDING";
+                });
+
+    // orders of the segment's customers: only keys are exchanged.
+    auto orders =
+        ReadTable<Order>(ctx, prefix, "orders")
+        .Filter([date](const Order& o) {
+                    return std::get<O_ORDERDATE>(o) < date;
+                })
+        .SemiJoin(customers,
+                  [](const Order& o) { return std::get<O_CUSTKEY>(o); },
+                  [](const Customer& c) { return std::get<C_CUSTKEY>(c); })
+        .Map([](const Order& o) {
+                 return Q3Order {
+                     std::get<O_ORDERKEY>(o), std::get<O_ORDERDATE>(o),
+                     std::get<O_SHIPPRIORITY>(o), 0.0
+                 };
+             });
+
+    // aggregate the revenue per order before the join
+    auto revenue =
+        ReadTable<LineItem>(ctx, prefix, "lineitem")
+        .Filter([date](const LineItem& l) {
+                    return std::get<L_SHIPDATE>(l) > date;
+                })
+        .Map([](const LineItem& l) {
+                 return std::make_pair(
+                     std::get<L_ORDERKEY>(l),
+                     std::get<L_EXTENDEDPRICE>(l) *
+                     (1 - std::get<L_DISCOUNT>(l)));
+             })
+        .ReducePair([](const double& a, const double& b) { return a + b; });
+
+    auto joined = InnerJoin(
+        revenue, orders,
+        [](const std::pair<int64_t, double>& r) { return r.first; },
+        [](const Q3Order& o) { return o.orderkey; },
+        [](const std::pair<int64_t, double>& r, const Q3Order& o) {
+            return Q3Order {
+                o.orderkey, o.orderdate, o.shippriority, r.second
+            };
+        });
 
-    common::StatsTimerStart timer;
+    std::vector<Q3Order> top =
+        joined.TopK(10, [](const Q3Order& a, const Q3Order& b) {
+                        return a.revenue > b.revenue ||
+                        (a.revenue == b.revenue && a.orderdate < b.orderdate);
+                    })
+        .AllGather();
+
+    Lines lines;
+    if (ctx.my_rank() != 0) return lines;
+    for (const Q3Order& o : top) {
+        std::ostringstream os;
+        os << "Q3 orderkey=" << o.orderkey << " revenue=" << o.revenue
+           << " orderdate=" << o.orderdate
+           << " shippriority=" << o.shippriority;
+        lines.push_back(os.str());
+    }
+    return lines;
+}
 
-    const bool use_detection = false;
-    auto joined =
+//! Q4: order priority checking, orders with a late lineitem per priority.
+static Lines Query4(api::Context& ctx, const std::string& prefix) {
+    const int32_t start = ParseDate("1993-07-01");
+    const int32_t stop = ParseDate("1993-10-01");
+
+    auto late =
+        ReadTable<LineItem>(ctx, prefix, "lineitem")
+        .Filter([](const LineItem& l) {
+                    return std::get<L_COMMITDATE>(l) <
+                    std::get<L_RECEIPTDATE>(l);
+                });
+
+    std::vector<std::pair<std::string, size_t> > counts =
+        ReadTable<Order>(ctx, prefix, "orders")
+        .Filter([start, stop](const Order& o) {
+                    return std::get<O_ORDERDATE>(o) >= start &&
+                    std::get<O_ORDERDATE>(o) < stop;
+                })
+        .SemiJoin(late,
+                  [](const Order& o) { return std::get<O_ORDERKEY>(o); },
+                  [](const LineItem& l) { return std::get<L_ORDERKEY>(l); })
+        .Map([](const Order& o) {
+                 return std::make_pair(std::get<O_ORDERPRIORITY>(o),
+                                       size_t(1));
+             })
+        .ReducePair([](const size_t& a, const size_t& b) { return a + b; })
+        .AllGather();
+
+    std::sort(counts.begin(), counts.end());
+
+    Lines lines;
+    if (ctx.my_rank() != 0) return lines;
+    for (const std::pair<std::string, size_t>& c : counts) {
+        std::ostringstream os;
+        os << "Q4 " << c.first << " order_count=" << c.second;
+        lines.push_back(os.str());
+    }
+    return lines;
+}
+
+//! Q5: local supplier volume, revenue of suppliers and customers within the
+//! same nation of ASIA.
+static Lines Query5(api::Context& ctx, const std::string& prefix) {
+    const int32_t start = ParseDate("1994-01-01");
+    const int32_t stop = ParseDate("1995-01-01");
+
+    // nations of the region: both tables are tiny and gathered everywhere
+    std::vector<Nation> nations =
+        ReadTable<Nation>(ctx, prefix, "nation").AllGather();
+    std::vector<Region> regions =
+        ReadTable<Region>(ctx, prefix, "region").AllGather();
+    int64_t regionkey = -1;
+    for (const Region& r : regions) {
+        if (std::get<R_NAME>(r) == "ASIA")
+            regionkey = std::get<R_REGIONKEY>(r);
+    }
+    std::map<int64_t, std::string> names;
+    std::vector<bool> in_region;
+    for (const Nation& n : nations) {
+        int64_t nationkey = std::get<N_NATIONKEY>(n);
+        names[nationkey] = std::get<N_NAME>(n);
+        if (in_region.size() <= static_cast<size_t>(nationkey))
+            in_region.resize(nationkey + 1);
+        in_region[nationkey] = std::get<N_REGIONKEY>(n) == regionkey;
+    }
+    auto is_in_region = [in_region](int64_t nationkey) {
+                            return static_cast<size_t>(nationkey) <
+                                   in_region.size() && in_region[nationkey];
+                        };
+
+    // (custkey, nationkey) of the region's customers
+    auto customers =
+        ReadTable<Customer>(ctx, prefix, "customer")
+        .Filter([is_in_region](const Customer& c) {
+                    return is_in_region(std::get<C_NATIONKEY>(c));
+                });
+
+    // (orderkey, nationkey) of their orders
+    auto orders = InnerJoin(
+        ReadTable<Order>(ctx, prefix, "orders")
+        .Filter([start, stop](const Order& o) {
+                    return std::get<O_ORDERDATE>(o) >= start &&
+                    std::get<O_ORDERDATE>(o) < stop;
+                }),
+        customers,
+        [](const Order& o) { return std::get<O_CUSTKEY>(o); },
+        [](const Customer& c) { return std::get<C_CUSTKEY>(c); },
+        [](const Order& o, const Customer& c) {
+            return std::make_pair(std::get<O_ORDERKEY>(o),
+                                  std::get<C_NATIONKEY>(c));
+        });
+
+    // revenue of the orders' lineitems, keyed by supplier and the customer's
+    // nation, such that the supplier join matches only equal nations. There
+    // are 25 nations.
+    auto lineitems = InnerJoin(
+        ReadTable<LineItem>(ctx, prefix, "lineitem"), orders,
+        [](const LineItem& l) { return std::get<L_ORDERKEY>(l); },
+        [](const std::pair<int64_t, int64_t>& o) { return o.first; },
+        [](const LineItem& l, const std::pair<int64_t, int64_t>& o) {
+            return std::make_pair(
+                std::get<L_SUPPKEY>(l) * 32 + o.second,
+                std::get<L_EXTENDEDPRICE>(l) * (1 - std::get<L_DISCOUNT>(l)));
+        });
+
+    auto suppliers =
+        ReadTable<Supplier>(ctx, prefix, "supplier")
+        .Filter([is_in_region](const Supplier& s) {
+                    return is_in_region(std::get<S_NATIONKEY>(s));
+                });
+
+    std::vector<std::pair<int64_t, double> > revenue =
         InnerJoin(
-            LocationDetectionFlag<use_detection>(),
-            lineitems, orders,
-            [](const LineItem& li) { return li.orderkey; },
-            [](const Order& o) { return o.orderkey; },
-            [](const LineItem& li, const Order& o) {
-                return ConstructJoinedElement(li, o);
-            }).Size();
-
-    ctx.net.Barrier();
-
-    if (ctx.my_rank() == 0) {
-        if (use_detection) {
-            LOG1 << "RESULT " << "benchmark=tpch " << "detection=ON"
-                 << " items=" << num_items
-                 << " time=" << timer
-                 << " traffic=" << ctx.net_manager().Traffic()
-                 << " hosts=" << ctx.num_hosts();
-        }
-        else {
-            LOG1 << "RESULT " << "benchmark=tpch " << "detection=OFF"
-                 << " items=" << num_items
-                 << " time=" << timer
-                 << " traffic=" << ctx.net_manager().Traffic()
-                 << " hosts=" << ctx.num_hosts();
-        }
+            lineitems, suppliers,
+            [](const std::pair<int64_t, double>& l) { return l.first; },
+            [](const Supplier& s) {
+                return std::get<S_SUPPKEY>(s) * 32 + std::get<S_NATIONKEY>(s);
+            },
+            [](const std::pair<int64_t, double>& l, const Supplier& s) {
+                return std::make_pair(std::get<S_NATIONKEY>(s), l.second);
+            })
+        .ReducePair([](const double& a, const double& b) { return a + b; })
+        .AllGather();
+
+    std::sort(revenue.begin(), revenue.end(),
+              [](const std::pair<int64_t, double>& a,
+                 const std::pair<int64_t, double>& b) {
+                  return a.second > b.second;
+              });
+
+    Lines lines;
+    if (ctx.my_rank() != 0) return lines;
+    for (const std::pair<int64_t, double>& r : revenue) {
+        std::ostringstream os;
+        os << "Q5 " << names[r.first] << " revenue=" << r.second;
+        lines.push_back(os.str());
     }
+    return lines;
+}
+
+//! Q6: forecasting revenue change, a vectorized scan with a selective filter.
+static Lines Query6(api::Context& ctx, const std::string& prefix) {
+    const int32_t start = ParseDate("1994-01-01");
+    const int32_t stop = ParseDate("1995-01-01");
+
+    double revenue =
+        ReadTable<LineItem>(ctx, prefix, "lineitem")
+        .MapPartitions<double>(
+            [start, stop](auto& reader, auto emit) {
+                double sum = 0.0;
+                ForEachBatch(
+                    reader, [&](const LineItemBatch& b) {
+                        for (size_t r = 0; r < b.size; ++r) {
+                            bool keep = (b.shipdate[r] >= start) &
+                                        (b.shipdate[r] < stop) &
+                                        (b.discount[r] >= 0.05 - 1e-9) &
+                                        (b.discount[r] <= 0.07 + 1e-9) &
+                                        (b.quantity[r] < 24);
+                            sum += keep ? b.extendedprice[r] * b.discount[r]
+                                   : 0.0;
+                        }
+                    });
+                emit(sum);
+            })
+        .Sum();
+
+    Lines lines;
+    if (ctx.my_rank() != 0) return lines;
+    std::ostringstream os;
+    os << "Q6 revenue=" << revenue;
+    lines.push_back(os.str());
+    return lines;
+}
+
+//! Q9: product type profit measure, the profit of green parts per nation and
+//! year.
+static Lines Query9(api::Context& ctx, const std::string& prefix) {
+    struct Q9Line {
+        int64_t orderkey, partkey, suppkey;
+        double  quantity, amount;
+    };
+
+    auto parts =
+        ReadTable<Part>(ctx, prefix, "part")
+        .Filter([](const Part& p) {
+                    return std::get<P_NAME>(p).find("green") !=
+                    std::string::npos;
+                });
+
+    // lineitems of green parts: only keys are exchanged.
+    auto lineitems =
+        ReadTable<LineItem>(ctx, prefix, "lineitem")
+        .SemiJoin(parts,
+                  [](const LineItem& l) { return std::get<L_PARTKEY>(l); },
+                  [](const Part& p) { return std::get<P_PARTKEY>(p); })
+        .Map([](const LineItem& l) {
+                 return Q9Line {
+                     std::get<L_ORDERKEY>(l), std::get<L_PARTKEY>(l),
+                     std::get<L_SUPPKEY>(l), std::get<L_QUANTITY>(l),
+                     std::get<L_EXTENDEDPRICE>(l) *
+                     (1 - std::get<L_DISCOUNT>(l))
+                 };
+             });
+
+    // subtract the supply cost, joining by partkey and suppkey
+    auto profit = InnerJoin(
+        lineitems, ReadTable<PartSupp>(ctx, prefix, "partsupp"),
+        [](const Q9Line& l) { return (l.partkey << 32) | l.suppkey; },
+        [](const PartSupp& ps) {
+            return (std::get<PS_PARTKEY>(ps) << 32) | std::get<PS_SUPPKEY>(ps);
+        },
+        [](const Q9Line& l, const PartSupp& ps) {
+            Q9Line r = l;
+            r.amount -= std::get<PS_SUPPLYCOST>(ps) * l.quantity;
+            return r;
+        });
+
+    // (orderkey, nationkey, amount)
+    auto with_nation = InnerJoin(
+        profit, ReadTable<Supplier>(ctx, prefix, "supplier"),
+        [](const Q9Line& l) { return l.suppkey; },
+        [](const Supplier& s) { return std::get<S_SUPPKEY>(s); },
+        [](const Q9Line& l, const Supplier& s) {
+            return std::make_tuple(l.orderkey, std::get<S_NATIONKEY>(s),
+                                   l.amount);
+        });
 
-    return joined;
+    using OrderNationAmount = std::tuple<int64_t, int64_t, double>;
+    std::vector<std::pair<int64_t, double> > sums =
+        InnerJoin(
+            with_nation, ReadTable<Order>(ctx, prefix, "orders"),
+            [](const OrderNationAmount& l) { return std::get<0>(l); },
+            [](const Order& o) { return std::get<O_ORDERKEY>(o); },
+            [](const OrderNationAmount& l, const Order& o) {
+                // key: nation and year
+                return std::make_pair(
+                    std::get<1>(l) * 10000 +
+                    YearOfDate(std::get<O_ORDERDATE>(o)),
+                    std::get<2>(l));
+            })
+        .ReducePair([](const double& a, const double& b) { return a + b; })
+        .AllGather();
+
+    std::map<int64_t, std::string> names = NationNames(ctx, prefix);
+
+    // by nation name and descending year
+    std::sort(sums.begin(), sums.end(),
+              [&names](const std::pair<int64_t, double>& a,
+                       const std::pair<int64_t, double>& b) {
+                  const std::string& na = names[a.first / 10000];
+                  const std::string& nb = names[b.first / 10000];
+                  return na < nb || (na == nb && a.first > b.first);
+              });
+
+    Lines lines;
+    if (ctx.my_rank() != 0) return lines;
+    for (const std::pair<int64_t, double>& s : sums) {
+        std::ostringstream os;
+        os << "Q9 " << names[s.first / 10000] << ' ' << s.first % 10000
+           << " sum_profit=" << s.second;
+        lines.push_back(os.str());
+    }
+    return lines;
 }
 
+/******************************************************************************/
+
 int main(int argc, char* argv[]) {
 
     tlx::CmdlineParser clp;
 
-    std::vector<std::string> input_path;
-    clp.add_param_stringlist("input", input_path,
-                             "input file pattern");
+    std::string prefix;
+    clp.add_param_string("prefix", prefix,
+                         "path prefix of the tables, e.g. /data/tpch/");
+
+    bool convert = false;
+    clp.add_bool('c', "convert", convert,
+                 "convert dbgen's text tables <prefix><table> to Arrow "
+                 "streams <prefix><table>.arrow-<worker> first");
+
+    std::string queries = "1,3,4,5,6,9";
+    clp.add_string('q', "queries", queries,
+                   "comma separated queries to run, default: 1,3,4,5,6,9");
+
+    std::string expect_path;
+    clp.add_string('e', "expect", expect_path,
+                   "compare the result lines of the queries with this file");
 
     if (!clp.process(argc, argv)) {
         return -1;
     }
 
-    die_unless(input_path.size() == 1);
-
     clp.print_result();
 
+    using Query = std::function<Lines(api::Context&, const std::string&)>;
+    const std::map<std::string, Query> all_queries = {
+        { "1", Query1 }, { "3", Query3 }, { "4", Query4 },
+        { "5", Query5 }, { "6", Query6 }, { "9", Query9 }
+    };
+
+    std::vector<std::string> query_list = tlx::split(',', queries);
+    for (const std::string& q : query_list) {
+        if (all_queries.count(q) == 0)
+            die("Unknown query \"" << q << "\"");
+    }
+
+    Lines expected;
+    if (!expect_path.empty()) {
+        std::ifstream in(expect_path);
+        if (!in.good())
+            die("Could not open expected results \"" << expect_path << "\"");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty()) expected.push_back(line);
+        }
+    }
+
     return api::Run(
         [&](api::Context& ctx) {
             ctx.enable_consume();
 
-            LOG1 << JoinTPCH4(ctx, input_path);
+            if (convert) {
+                common::StatsTimerStart timer;
+                ConvertTables(ctx, prefix);
+                if (ctx.my_rank() == 0)
+                    LOG1 << "RESULT benchmark=tpch query=convert"
+                         << " time=" << timer;
+            }
+
+            Lines results;
+            for (const std::string& q : query_list) {
+                ctx.net.Barrier();
+                common::StatsTimerStart timer;
+
+                Lines lines = all_queries.at(q)(ctx, prefix);
+
+                ctx.net.Barrier();
+                if (ctx.my_rank() == 0) {
+                    for (const std::string& line : lines)
+                        LOG1 << line;
+                    LOG1 << "RESULT benchmark=tpch query=Q" << q
+                         << " time=" << timer
+                         << " traffic=" << ctx.net_manager().Traffic()
+                         << " hosts=" << ctx.num_hosts();
+                }
+                results.insert(results.end(), lines.begin(), lines.end());
+            }
 
-            return 42;
+            if (ctx.my_rank() == 0 && !expect_path.empty()) {
+                die_unequal(expected.size(), results.size());
+                for (size_t i = 0; i < results.size(); ++i)
+                    die_unequal(expected[i], results[i]);
+            }
         });
 }
 
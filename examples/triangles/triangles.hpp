@@ -12,10 +12,17 @@
 #ifndef THRILL_EXAMPLES_TRIANGLES_TRIANGLES_HEADER
 #define THRILL_EXAMPLES_TRIANGLES_TRIANGLES_HEADER
 
+#include <thrill/api/cache.hpp>
+#include <thrill/api/distinct.hpp>
+#include <thrill/api/group_by_key.hpp>
 #include <thrill/api/inner_join.hpp>
+#include <thrill/api/reduce_by_key.hpp>
 #include <thrill/api/size.hpp>
+#include <thrill/api/sum.hpp>
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 using Node = size_t;
 using Edge = std::pair<Node, Node>;
@@ -69,6 +76,121 @@ size_t CountTriangles(const DIA<Edge, Stack>& edges) {
     return triangles.Size();
 }
 
+//! Size of the intersection of two sorted lists: by a branch-free merge, or,
+//! if the sizes differ much, by binary searches in the longer list.
+static inline size_t IntersectionSize(const std::vector<Node>& a,
+                                      const std::vector<Node>& b) {
+    if (a.size() > b.size()) return IntersectionSize(b, a);
+
+    size_t count = 0;
+    if (a.size() * 32 < b.size()) {
+        auto it = b.begin();
+        for (const Node& x : a) {
+            it = std::lower_bound(it, b.end(), x);
+            if (it == b.end()) break;
+            count += (*it == x);
+        }
+        return count;
+    }
+
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        Node x = a[i], y = b[j];
+        count += (x == y);
+        i += (x <= y);
+        j += (y <= x);
+    }
+    return count;
+}
+
+/*!
+ * Count the triangles of the undirected simple graph of edges, i.e. self-loops
+ * and multi-edges are ignored, without materializing wedges: each edge is
+ * oriented from the endpoint of lower to higher (degree, id), such that every
+ * node has at most sqrt(2m) out-neighbors. The sorted out-neighbor list of each
+ * node u is then shipped to the members v of the list, and each triangle is
+ * counted exactly once as intersection of the lists of u and v.
+ */
+template <bool UseDetection = false, typename Stack>
+size_t CountTrianglesOriented(const DIA<Edge, Stack>& edges) {
+
+    using NodeDegree = std::pair<Node, size_t>;
+    using EdgeDegree = std::pair<Edge, size_t>;
+    using Adjacency = std::pair<Node, std::vector<Node> >;
+
+    auto simple_edges =
+        edges.template FlatMap<Edge>(
+            [](const Edge& e, auto emit) {
+                if (e.first < e.second) emit(e);
+                else if (e.second < e.first) emit(Edge(e.second, e.first));
+            })
+        .Distinct([](const Edge& e) { return e; })
+        .Cache();
+
+    auto degrees =
+        simple_edges.Keep().template FlatMap<NodeDegree>(
+            [](const Edge& e, auto emit) {
+                emit(NodeDegree(e.first, 1));
+                emit(NodeDegree(e.second, 1));
+            })
+        .ReducePair([](const size_t& a, const size_t& b) { return a + b; })
+        .Cache();
+
+    auto edges_degree =
+        InnerJoin(
+            LocationDetectionFlag<UseDetection>(),
+            simple_edges, degrees.Keep(),
+            [](const Edge& e) { return e.first; },
+            [](const NodeDegree& d) { return d.first; },
+            [](const Edge& e, const NodeDegree& d) {
+                return EdgeDegree(e, d.second);
+            });
+
+    auto oriented_edges =
+        InnerJoin(
+            LocationDetectionFlag<UseDetection>(),
+            edges_degree, degrees,
+            [](const EdgeDegree& e) { return e.first.second; },
+            [](const NodeDegree& d) { return d.first; },
+            [](const EdgeDegree& e, const NodeDegree& d) {
+                if (std::make_pair(e.second, e.first.first) <
+                    std::make_pair(d.second, e.first.second))
+                    return e.first;
+                return Edge(e.first.second, e.first.first);
+            });
+
+    auto adjacency =
+        oriented_edges.template GroupByKey<Adjacency>(
+            [](const Edge& e) { return e.first; },
+            [](auto& r, const Node& u) {
+                std::vector<Node> out;
+                while (r.HasNext())
+                    out.push_back(r.Next().second);
+                std::sort(out.begin(), out.end());
+                return Adjacency(u, std::move(out));
+            })
+        .Cache();
+
+    auto requests =
+        adjacency.Keep().template FlatMap<Adjacency>(
+            [](const Adjacency& a, auto emit) {
+                for (const Node& v : a.second)
+                    emit(Adjacency(v, a.second));
+            });
+
+    auto triangles =
+        InnerJoin(
+            LocationDetectionFlag<UseDetection>(),
+            requests, adjacency,
+            [](const Adjacency& a) { return a.first; },
+            [](const Adjacency& a) { return a.first; },
+            [](const Adjacency& a, const Adjacency& b) {
+                return IntersectionSize(a.second, b.second);
+            });
+
+    return triangles.Sum();
+}
+
 } // namespace triangles
 } // namespace examples
 
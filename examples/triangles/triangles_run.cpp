@@ -33,7 +33,7 @@ using Edge = std::pair<Node, Node>;
 
 static size_t CountTrianglesPerLine(
     api::Context& ctx,
-    const std::vector<std::string>& input_path) {
+    const std::vector<std::string>& input_path, bool oriented) {
     auto edges = ReadLines(ctx, input_path).template FlatMap<Edge>(
         [](const std::string& input, auto emit) {
             // parse "source\ttarget\ttarget...\n" lines
@@ -54,13 +54,15 @@ static size_t CountTrianglesPerLine(
             }
         }).Keep();
 
+    if (oriented)
+        return examples::triangles::CountTrianglesOriented(edges);
     return examples::triangles::CountTriangles(edges);
 }
 
 static size_t CountTrianglesGenerated(
     api::Context& ctx,
     const ZipfGraphGen& base_graph_gen,
-    const size_t& num_vertices) {
+    const size_t& num_vertices, bool oriented) {
 
     auto edge_lists = Generate(
         ctx, num_vertices,
@@ -90,13 +92,17 @@ static size_t CountTrianglesGenerated(
 
     const bool use_detection = true;
 
-    size_t triangles = examples::triangles::CountTriangles<use_detection>(edges);
+    size_t triangles =
+        oriented
+        ? examples::triangles::CountTrianglesOriented<use_detection>(edges)
+        : examples::triangles::CountTriangles<use_detection>(edges);
 
     ctx.net.Barrier();
 
     if (ctx.my_rank() == 0) {
         if (use_detection) {
             LOG1 << "RESULT " << "benchmark=triangles " << "detection=ON"
+                 << " oriented=" << oriented
                  << " vertices=" << num_vertices
                  << " time=" << timer
                  << " traffic=" << ctx.net_manager().Traffic()
@@ -104,6 +110,7 @@ static size_t CountTrianglesGenerated(
         }
         else {
             LOG1 << "RESULT " << "benchmark=triangles " << "detection=OFF"
+                 << " oriented=" << oriented
                  << " vertices=" << num_vertices
                  << " time=" << timer
                  << " traffic=" << ctx.net_manager().Traffic()
@@ -122,6 +129,11 @@ int main(int argc, char* argv[]) {
     clp.add_bool('g', "generate", generate,
                  "generate graph data, set input = #pages");
 
+    bool oriented = false;
+    clp.add_bool('o', "oriented", oriented,
+                 "count by intersecting degree-oriented adjacency lists "
+                 "instead of joining wedges");
+
     size_t num_vertices;
 
     clp.add_size_t('n', "vertices", num_vertices, "Number of vertices");
@@ -164,11 +176,11 @@ int main(int argc, char* argv[]) {
             size_t triangles;
             if (generate) {
                 triangles = CountTrianglesGenerated(
-                    ctx, gg, num_vertices);
+                    ctx, gg, num_vertices, oriented);
             }
             else {
                 triangles = CountTrianglesPerLine(
-                    ctx, input_path);
+                    ctx, input_path, oriented);
             }
 
             return triangles;
@@ -35,7 +35,7 @@ int main(int argc, char* argv[]) {
 
     auto start_func =
         [input](api::Context& ctx) {
-            size_t line_count = api::ReadLines(ctx, input).Size();
+            size_t line_count = api::ReadLinesView(ctx, input).Size();
             sLOG1 << "counted" << line_count << "lines in total";
         };
 
@@ -16,11 +16,19 @@
 #ifndef THRILL_EXAMPLES_WORD_COUNT_WORD_COUNT_HEADER
 #define THRILL_EXAMPLES_WORD_COUNT_WORD_COUNT_HEADER
 
+#include <thrill/api/all_gather.hpp>
+#include <thrill/api/map_partitions.hpp>
 #include <thrill/api/reduce_by_key.hpp>
+#include <thrill/api/top_k.hpp>
+#include <thrill/common/hash.hpp>
+#include <tlx/math/round_to_power_of_two.hpp>
 #include <tlx/string/split_view.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace examples {
 namespace word_count {
@@ -105,6 +113,132 @@ auto HashWordCountExample(const DIA<std::string, InputStack>& input) {
     return r;
 }
 
+/******************************************************************************/
+
+//! Hash of a word, which mixes it in eight byte words, hence short words need
+//! one or two multiplicative rounds.
+static inline size_t WordHash(const char* data, size_t size) {
+    uint64_t h = size;
+    for ( ; size >= 8; data += 8, size -= 8) {
+        uint64_t w;
+        std::memcpy(&w, data, 8);
+        h = common::Hash128to64(h, w);
+    }
+    if (size != 0) {
+        uint64_t w = 0;
+        std::memcpy(&w, data, size);
+        h = common::Hash128to64(h, w);
+    }
+    return static_cast<size_t>(h);
+}
+
+/*!
+ * Direct-mapped cache of word counts, which combines the occurrences of
+ * frequent words before they become items. A word displaced from its slot by
+ * another word is emitted with its count so far, and Flush() emits the rest,
+ * hence each count reaches the emit function exactly once. The words are
+ * copied into the slots, whose strings keep their capacity.
+ */
+class WordCountCache
+{
+public:
+    explicit WordCountCache(size_t size)
+        : slots_(tlx::round_up_to_power_of_two(std::max<size_t>(size, 1))),
+          mask_(slots_.size() - 1) { }
+
+    //! count an occurrence of the word with the given hash
+    template <typename Emit>
+    void Add(const char* word, size_t size, size_t hash, const Emit& emit) {
+        Slot& s = slots_[hash & mask_];
+        if (s.count != 0) {
+            if (s.hash == hash && s.word.size() == size &&
+                std::memcmp(s.word.data(), word, size) == 0) {
+                ++s.count;
+                return;
+            }
+            emit(HashWordCount(HashWord(s.hash, s.word), s.count));
+        }
+        s.hash = hash;
+        s.word.assign(word, size);
+        s.count = 1;
+    }
+
+    //! emit the counts of all cached words and clear the cache
+    template <typename Emit>
+    void Flush(const Emit& emit) {
+        for (Slot& s : slots_) {
+            if (s.count == 0) continue;
+            emit(HashWordCount(HashWord(s.hash, s.word), s.count));
+            s.count = 0;
+        }
+    }
+
+private:
+    struct Slot {
+        size_t hash = 0;
+        std::string word;
+        //! zero for empty slots
+        size_t count = 0;
+    };
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+};
+
+//! The fast WordCount user program: the words of each worker's lines are
+//! tokenized in place and counted in a WordCountCache, hence only the
+//! displaced and the remaining words become HashWordCount items, whose
+//! precomputed hashes are used by ReducePair. Returns a DIA containing
+//! HashWordCounts.
+template <typename InputStack>
+auto FastWordCount(const DIA<std::string, InputStack>& input,
+                   size_t cache_size = 64 * 1024) {
+
+    return input
+           .template MapPartitions<HashWordCount>(
+               [cache_size](auto& reader, auto emit) {
+                   WordCountCache cache(cache_size);
+                   while (reader.HasNext()) {
+                       std::string line = reader.Next();
+                       const char* begin = line.data();
+                       const char* end = begin + line.size();
+                       while (begin != end) {
+                           const char* word = begin;
+                           while (begin != end && *begin != ' ') ++begin;
+                           size_t size = begin - word;
+                           if (size != 0) {
+                               cache.Add(word, size, WordHash(word, size),
+                                         emit);
+                           }
+                           if (begin != end) ++begin;
+                       }
+                   }
+                   cache.Flush(emit);
+               })
+           .ReducePair(
+               [](const size_t& a, const size_t& b) {
+                   /* associative reduction operator: add counters */
+                   return a + b;
+               },
+               api::DefaultReduceConfig(), HashWordHasher());
+}
+
+//! Returns the n most frequent words of the counted words on all workers,
+//! ordered by decreasing count and then by word, without sorting all words.
+template <typename HashWordCountDIA>
+std::vector<WordCountPair> TopWords(const HashWordCountDIA& counts, size_t n) {
+    return counts
+           .TopK(n,
+                 [](const HashWordCount& a, const HashWordCount& b) {
+                     return a.second > b.second ||
+                     (a.second == b.second && a.first.second < b.first.second);
+                 })
+           .Map([](const HashWordCount& in) {
+                    return WordCountPair(in.first.second, in.second);
+                })
+           .AllGather();
+}
+
 } // namespace word_count
 } // namespace examples
 
@@ -153,6 +153,48 @@ static void RunHashWordCountGenerated(
     }
 }
 
+/******************************************************************************/
+// Run method of the fast WordCount, for lines from files or generated lines.
+
+template <typename InputDIA>
+static void RunFastWordCount(
+    api::Context& ctx, const InputDIA& lines, size_t cache_size, size_t top,
+    const std::string& output) {
+
+    common::StatsTimerStart timer;
+
+    auto word_counts = FastWordCount(lines, cache_size);
+
+    if (top != 0) {
+        std::vector<WordCountPair> top_words = TopWords(word_counts, top);
+        if (ctx.my_rank() == 0) {
+            for (const WordCountPair& wc : top_words)
+                LOG1 << wc.first << ": " << wc.second;
+        }
+    }
+    else if (output.size()) {
+        word_counts
+        .Map([](const HashWordCount& wc) {
+                 return wc.first.second + ": " + std::to_string(wc.second);
+             })
+        .WriteLines(output);
+    }
+    else {
+        word_counts.Execute();
+    }
+
+    ctx.net.Barrier();
+    if (ctx.my_rank() == 0) {
+        LOG1 << "RESULT"
+             << " benchmark=wordcount_fast"
+             << " cache_size=" << cache_size
+             << " top=" << top
+             << " time=" << timer
+             << " traffic=" << ctx.net_manager().Traffic()
+             << " hosts=" << ctx.num_hosts();
+    }
+}
+
 /******************************************************************************/
 
 int main(int argc, char* argv[]) {
@@ -177,6 +219,20 @@ int main(int argc, char* argv[]) {
                  "explicitly calculate hash values for words "
                  "to accelerate reduction.");
 
+    bool fast = false;
+    clp.add_bool('f', "fast", fast,
+                 "count words with the fast WordCount, which tokenizes lines "
+                 "in place and combines frequent words in a cache.");
+
+    size_t cache_size = 64 * 1024;
+    clp.add_size_t('c', "cache_size", cache_size,
+                   "number of words in the cache of the fast WordCount, "
+                   "default: 65536");
+
+    size_t top = 0;
+    clp.add_size_t('t', "top", top,
+                   "with --fast, print only the top most frequent words.");
+
     if (!clp.process(argc, argv)) {
         return -1;
     }
@@ -190,13 +246,28 @@ int main(int argc, char* argv[]) {
                 if (!common::from_str<size_t>(input[0], num_words))
                     die("For generated word data, set input to the number of words.");
 
-                if (hash_words)
+                if (fast) {
+                    ctx.enable_consume();
+                    std::default_random_engine rng(std::random_device { } ());
+                    auto lines = Generate(
+                        ctx, num_words / 10,
+                        [&](size_t /* index */) {
+                            return RandomTextWriterGenerate(10, rng);
+                        });
+                    RunFastWordCount(ctx, lines, cache_size, top, output);
+                }
+                else if (hash_words)
                     RunHashWordCountGenerated(ctx, num_words, output);
                 else
                     RunWordCountGenerated(ctx, num_words, output);
             }
             else {
-                if (hash_words)
+                if (fast) {
+                    ctx.enable_consume();
+                    RunFastWordCount(ctx, ReadLines(ctx, input),
+                                     cache_size, top, output);
+                }
+                else if (hash_words)
                     RunHashWordCount(ctx, input, output);
                 else
                     RunWordCount(ctx, input, output);
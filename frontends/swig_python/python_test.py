@@ -9,9 +9,12 @@
 # All rights reserved. Published under the BSD-2 license in the LICENSE file.
 ##########################################################################
 
-import unittest
-import threading
+import array
+import os
 import sys
+import tempfile
+import threading
+import unittest
 
 import thrill
 
@@ -145,6 +148,104 @@ class TestOperations(unittest.TestCase):
     def notest_operations(self):
         run_thrill_threads(4, self.my_thread)
 
+
+class TestColumnOperations(unittest.TestCase):
+
+    def test_range_map_batches(self):
+
+        def test(ctx):
+            test_size = 10000
+
+            dia1 = ctx.Range(test_size)
+            self.assertEqual(dia1.Size(), test_size)
+
+            # square each batch of at most 100 items as a whole
+            dia2 = dia1.MapBatches(lambda b: [x * x for x in b], 100)
+            self.assertEqual(dia2.Size(), test_size)
+            self.assertEqual(dia2.Sum(),
+                             sum(x * x for x in range(0, test_size)))
+
+            dia3 = dia2.FilterBatches(lambda b: [x % 3 == 0 for x in b], 100)
+            check = [x * x for x in range(0, test_size) if x * x % 3 == 0]
+            self.assertEqual(list(dia3.AllGather()), check)
+
+        run_tests(test)
+
+    def test_distribute_doubles_sort(self):
+
+        def test(ctx):
+            data = [float((x * 7919) % 1000) / 8 for x in range(0, 1000)]
+
+            dia1 = ctx.DistributeDoubles(data)
+            self.assertEqual(dia1.Size(), len(data))
+            self.assertEqual(dia1.Min(), min(data))
+            self.assertEqual(dia1.Max(), max(data))
+
+            dia2 = dia1.MapBatches(lambda b: [2 * x for x in b]).Sort()
+            self.assertEqual(list(dia2.AllGather()),
+                             sorted(2 * x for x in data))
+
+        run_tests(test)
+
+    def test_distribute_strings_batches(self):
+
+        def test(ctx):
+            data = ["word %d" % ((x * 31) % 200) for x in range(0, 1000)]
+
+            dia1 = ctx.DistributeStrings(data)
+            self.assertEqual(dia1.Size(), len(data))
+
+            dia2 = dia1.FilterBatches(
+                lambda b: [s.endswith("7") for s in b], 64)
+            dia3 = dia2.MapBatches(lambda b: [s.upper() for s in b]).Sort()
+
+            check = sorted(s.upper() for s in data if s.endswith("7"))
+            self.assertEqual(dia3.AllGather(), check)
+
+        run_tests(test)
+
+    def test_int64_buffer_batches(self):
+
+        def test(ctx):
+            data = [(x * 7919) % 1000 - 500 for x in range(0, 1000)]
+
+            # read from a buffer of int64, not as a sequence
+            dia1 = ctx.DistributeInt64(array.array('q', data))
+            self.assertEqual(dia1.Size(), len(data))
+            self.assertEqual(dia1.Sum(), sum(data))
+
+            # return the batches as buffers, and the masks as bytes
+            dia2 = dia1.MapBatches(
+                lambda b: array.array('q', [x + 1 for x in b]), 50)
+            dia3 = dia2.FilterBatches(
+                lambda b: bytes([int(x) % 2 == 0 for x in b]), 50).Sort()
+
+            check = sorted(x + 1 for x in data if (x + 1) % 2 == 0)
+            self.assertEqual([int(x) for x in dia3.AllGather()], check)
+
+        run_tests(test)
+
+    def test_read_lines_bytes_batches(self):
+
+        data = ["line %d" % x for x in range(0, 500)]
+        with tempfile.NamedTemporaryFile(
+                mode="w", suffix=".txt", delete=False) as f:
+            f.write("\n".join(data) + "\n")
+
+        def test(ctx):
+            dia1 = ctx.ReadLines(f.name)
+            self.assertEqual(dia1.Size(), len(data))
+
+            # return the batches as bytes instead of str
+            dia2 = dia1.MapBatches(
+                lambda b: [s[5:].encode("utf-8") for s in b], 32).Sort()
+            self.assertEqual(dia2.AllGather(), sorted(s[5:] for s in data))
+
+        try:
+            run_tests(test)
+        finally:
+            os.remove(f.name)
+
 if __name__ == '__main__':
     unittest.main()
 
@@ -12,21 +12,32 @@
 #ifndef THRILL_FRONTENDS_SWIG_PYTHON_THRILL_PYTHON_HEADER
 #define THRILL_FRONTENDS_SWIG_PYTHON_THRILL_PYTHON_HEADER
 
-#include <thrill/api/allgather.hpp>
+#include <thrill/api/all_gather.hpp>
 #include <thrill/api/cache.hpp>
 #include <thrill/api/collapse.hpp>
 #include <thrill/api/context.hpp>
 #include <thrill/api/dia.hpp>
 #include <thrill/api/distribute.hpp>
 #include <thrill/api/generate.hpp>
-#include <thrill/api/reduce.hpp>
+#include <thrill/api/map_partitions.hpp>
+#include <thrill/api/max.hpp>
+#include <thrill/api/min.hpp>
+#include <thrill/api/read_lines.hpp>
+#include <thrill/api/reduce_by_key.hpp>
 #include <thrill/api/size.hpp>
+#include <thrill/api/sort.hpp>
+#include <thrill/api/sum.hpp>
 #include <thrill/common/string.hpp>
 
+#include <tlx/die.hpp>
+
 #include <bytesobject.h>
 #include <marshal.h>
 #include <Python.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <string>
 #include <vector>
@@ -193,6 +204,18 @@ public:
     virtual PyObjectVarRef operator () (PyObject* obj1, PyObject* obj2) = 0;
 };
 
+/*!
+ * Callback of the typed columnar DIAs, which is called once per batch of
+ * items: numeric batches are passed as memoryviews (NumPy arrays in Python),
+ * string batches as lists of str.
+ */
+class BatchFunction
+{
+public:
+    virtual ~BatchFunction() { }
+    virtual PyObjectVarRef operator () (PyObject* batch) = 0;
+};
+
 } // namespace thrill
 
 // import Swig Director classes.
@@ -218,6 +241,237 @@ struct hash<thrill::PyObjectRef>
 
 #endif
 
+#ifndef SWIG
+
+namespace thrill {
+
+//! strip the native byte order character of a buffer format string
+static inline const char * PyBufferFormat(const char* format) {
+    if (format == nullptr) return "B";
+    if (*format == '@' || *format == '=') ++format;
+    return format;
+}
+
+/*!
+ * Conversion of batches of the typed columnar DIAs from and to Python objects.
+ * All functions must be called while holding the GIL, and return nullptr or
+ * false with a Python error set on failure.
+ */
+template <typename Type>
+struct PyColumnTraits;
+
+/*!
+ * Numeric batches are passed to Python as a typed memoryview of a bytearray,
+ * which NumPy wraps without copying, and are read back from any object
+ * exposing a contiguous buffer of the same item type, e.g. a NumPy array, with
+ * a single memcpy, or else from a sequence of numbers.
+ */
+template <typename Type>
+struct PyNumericColumnTraits {
+    static PyObject * ToPython(const std::vector<Type>& batch) {
+        PyObject* bytes = PyByteArray_FromStringAndSize(
+            reinterpret_cast<const char*>(batch.data()),
+            batch.size() * sizeof(Type));
+        if (bytes == nullptr) return nullptr;
+        PyObject* view = PyMemoryView_FromObject(bytes);
+        Py_DECREF(bytes);
+        if (view == nullptr) return nullptr;
+        PyObject* typed = PyObject_CallMethod(
+            view, "cast", "s", PyColumnTraits<Type>::format);
+        Py_DECREF(view);
+        return typed;
+    }
+
+    static bool FromPython(PyObject* obj, std::vector<Type>& out) {
+        out.clear();
+        if (PyObject_CheckBuffer(obj)) {
+            Py_buffer view;
+            if (PyObject_GetBuffer(
+                    obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) == 0) {
+                bool match =
+                    view.itemsize == sizeof(Type) &&
+                    PyColumnTraits<Type>::IsFormat(PyBufferFormat(view.format));
+                if (match) {
+                    out.resize(view.len / sizeof(Type));
+                    std::memcpy(out.data(), view.buf, view.len);
+                }
+                PyBuffer_Release(&view);
+                if (match) return true;
+            }
+            else {
+                PyErr_Clear();
+            }
+        }
+        // fall back to a sequence of numbers
+        PyObject* seq = PySequence_Fast(
+            obj, "batch is neither a buffer nor a sequence");
+        if (seq == nullptr) return false;
+        Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+        out.reserve(size);
+        for (Py_ssize_t i = 0; i < size; ++i) {
+            Type item = PyColumnTraits<Type>::FromObject(
+                PySequence_Fast_GET_ITEM(seq, i));
+            if (PyErr_Occurred()) {
+                Py_DECREF(seq);
+                return false;
+            }
+            out.push_back(item);
+        }
+        Py_DECREF(seq);
+        return true;
+    }
+};
+
+template <>
+struct PyColumnTraits<double>: public PyNumericColumnTraits<double> {
+    static constexpr const char* format = "d";
+    static bool IsFormat(const char* f) {
+        return f[0] == 'd' && f[1] == 0;
+    }
+    static double FromObject(PyObject* obj) {
+        return PyFloat_AsDouble(obj);
+    }
+};
+
+template <>
+struct PyColumnTraits<int64_t>: public PyNumericColumnTraits<int64_t> {
+    static constexpr const char* format = "q";
+    static bool IsFormat(const char* f) {
+        // NumPy's int64 is 'l' on LP64 platforms
+        return (f[0] == 'q' || f[0] == 'l') && f[1] == 0;
+    }
+    static int64_t FromObject(PyObject* obj) {
+        return PyLong_AsLongLong(obj);
+    }
+};
+
+/*!
+ * String batches are passed to Python as lists of str, decoded as UTF-8 with
+ * surrogateescape, and read back from sequences of str or bytes.
+ */
+template <>
+struct PyColumnTraits<std::string> {
+    static PyObject * ToPython(const std::vector<std::string>& batch) {
+        PyObject* list = PyList_New(batch.size());
+        if (list == nullptr) return nullptr;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            PyObject* str = PyUnicode_DecodeUTF8(
+                batch[i].data(), batch[i].size(), "surrogateescape");
+            if (str == nullptr) {
+                Py_DECREF(list);
+                return nullptr;
+            }
+            PyList_SET_ITEM(list, i, str);
+        }
+        return list;
+    }
+
+    static bool FromPython(PyObject* obj, std::vector<std::string>& out) {
+        out.clear();
+        PyObject* seq = PySequence_Fast(obj, "batch is not a sequence");
+        if (seq == nullptr) return false;
+        Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+        out.reserve(size);
+        for (Py_ssize_t i = 0; i < size; ++i) {
+            PyObject* item = PySequence_Fast_GET_ITEM(seq, i);
+            PyObject* bytes =
+                PyUnicode_Check(item)
+                ? PyUnicode_AsEncodedString(item, "utf-8", "surrogateescape")
+                : (Py_INCREF(item), item);
+            char* data;
+            Py_ssize_t len;
+            if (bytes == nullptr ||
+                PyBytes_AsStringAndSize(bytes, &data, &len) != 0) {
+                Py_XDECREF(bytes);
+                Py_DECREF(seq);
+                return false;
+            }
+            out.emplace_back(data, len);
+            Py_DECREF(bytes);
+        }
+        Py_DECREF(seq);
+        return true;
+    }
+};
+
+//! Read a filter mask from a buffer of bools or bytes, e.g. a NumPy bool
+//! array, or else from a sequence of truth values.
+static inline bool PyMaskFromPython(PyObject* obj, std::vector<char>& out) {
+    out.clear();
+    if (PyObject_CheckBuffer(obj)) {
+        Py_buffer view;
+        if (PyObject_GetBuffer(
+                obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) == 0) {
+            bool match = view.itemsize == 1;
+            if (match) {
+                const char* data = static_cast<const char*>(view.buf);
+                out.assign(data, data + view.len);
+            }
+            PyBuffer_Release(&view);
+            if (match) return true;
+        }
+        else {
+            PyErr_Clear();
+        }
+    }
+    PyObject* seq = PySequence_Fast(
+        obj, "filter mask is neither a buffer nor a sequence");
+    if (seq == nullptr) return false;
+    Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+    out.reserve(size);
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        int truth = PyObject_IsTrue(PySequence_Fast_GET_ITEM(seq, i));
+        if (truth < 0) {
+            Py_DECREF(seq);
+            return false;
+        }
+        out.push_back(static_cast<char>(truth));
+    }
+    Py_DECREF(seq);
+    return true;
+}
+
+/*!
+ * Call the batch function on a batch and convert its result with from_python.
+ * This is the only place where the worker threads of the typed DIAs take the
+ * GIL; all other work of the native stages runs without it.
+ */
+template <typename Type, typename FromPython>
+static void CallBatchFunction(BatchFunction& batch_function,
+                              const std::vector<Type>& batch,
+                              const FromPython& from_python) {
+    bool ok;
+    {
+        SWIG_PYTHON_THREAD_BEGIN_BLOCK;
+        PyObject* obj = PyColumnTraits<Type>::ToPython(batch);
+        ok = (obj != nullptr);
+        if (ok) {
+            // the director takes over the reference to obj
+            PyObjectVarRef result = batch_function(obj);
+            ok = from_python(static_cast<PyObject*>(result));
+        }
+        if (!ok) PyErr_PrintEx(0);
+        SWIG_PYTHON_THREAD_END_BLOCK;
+    }
+    if (!ok)
+        die("Invalid batch passed to or returned from a BatchFunction");
+}
+
+//! Read the next batch of at most batch_size items, returns false if the
+//! reader is exhausted.
+template <typename Reader, typename Type>
+static bool ReadBatch(Reader& reader, std::vector<Type>& batch,
+                      size_t batch_size) {
+    batch.clear();
+    while (batch.size() < batch_size && reader.HasNext())
+        batch.emplace_back(reader.Next());
+    return !batch.empty();
+}
+
+} // namespace thrill
+
+#endif
+
 namespace thrill {
 
 //! all DIAs used in the python code contain PyObjectRefs, which are reference
@@ -302,7 +556,7 @@ public:
             *dynamic_cast<SwigDirector_ReduceFunction*>(&reduce_function);
 
         return PyDIA(
-            dia_.ReduceBy(
+            dia_.ReduceByKey(
                 [&key_extractor,
                  // this holds a reference count to the callback object for the
                  // lifetime of the capture object.
@@ -353,6 +607,128 @@ public:
     }
 };
 
+/*!
+ * Wrapper around a typed C++ DIA of numbers or strings, whose items are stored
+ * natively instead of as PyObjects. Python functions are called only once per
+ * batch of items via MapBatches() and FilterBatches(), and all other
+ * operations run natively without holding the GIL.
+ */
+template <typename Type>
+class PyColumnDIA
+{
+public:
+    //! underlying C++ DIA class, which can be freely copied by the object.
+    api::DIA<Type> dia_;
+
+    explicit PyColumnDIA(const api::DIA<Type>& dia)
+        : dia_(dia) { }
+
+    //! Call batch_function on batches of at most batch_size items, and
+    //! concatenate the returned batches, which may have any size.
+    PyColumnDIA MapBatches(BatchFunction& batch_function,
+                           size_t batch_size = 65536) const {
+        assert(dia_.IsValid());
+
+        // the object BatchFunction is actually an instance of the Director
+        SwigDirector_BatchFunction& director =
+            *dynamic_cast<SwigDirector_BatchFunction*>(&batch_function);
+
+        return PyColumnDIA(
+            dia_.template MapPartitions<Type>(
+                [&batch_function,
+                 batch_size = std::max<size_t>(batch_size, 1),
+                 // this holds a reference count to the callback object for the
+                 // lifetime of the capture object.
+                 ref = PyObjectRef(director.swig_get_self())
+                ](auto& reader, const auto& emit) {
+                    std::vector<Type> batch, result;
+                    while (ReadBatch(reader, batch, batch_size)) {
+                        CallBatchFunction(
+                            batch_function, batch, [&](PyObject* obj) {
+                                return PyColumnTraits<Type>::FromPython(
+                                    obj, result);
+                            });
+                        for (const Type& item : result)
+                            emit(item);
+                    }
+                }));
+    }
+
+    //! Call batch_function on batches of at most batch_size items, which
+    //! returns a mask of the same size selecting the items to keep.
+    PyColumnDIA FilterBatches(BatchFunction& batch_function,
+                              size_t batch_size = 65536) const {
+        assert(dia_.IsValid());
+
+        // the object BatchFunction is actually an instance of the Director
+        SwigDirector_BatchFunction& director =
+            *dynamic_cast<SwigDirector_BatchFunction*>(&batch_function);
+
+        return PyColumnDIA(
+            dia_.template MapPartitions<Type>(
+                [&batch_function,
+                 batch_size = std::max<size_t>(batch_size, 1),
+                 // this holds a reference count to the callback object for the
+                 // lifetime of the capture object.
+                 ref = PyObjectRef(director.swig_get_self())
+                ](auto& reader, const auto& emit) {
+                    std::vector<Type> batch;
+                    std::vector<char> mask;
+                    while (ReadBatch(reader, batch, batch_size)) {
+                        CallBatchFunction(
+                            batch_function, batch, [&](PyObject* obj) {
+                                return PyMaskFromPython(obj, mask);
+                            });
+                        die_unequal(mask.size(), batch.size());
+                        for (size_t i = 0; i < batch.size(); ++i) {
+                            if (mask[i]) emit(batch[i]);
+                        }
+                    }
+                }));
+    }
+
+    PyColumnDIA Sort() const {
+        assert(dia_.IsValid());
+        return PyColumnDIA(dia_.Sort());
+    }
+
+    PyColumnDIA Cache() const {
+        assert(dia_.IsValid());
+        return PyColumnDIA(dia_.Cache());
+    }
+
+    size_t Size() const {
+        assert(dia_.IsValid());
+        return dia_.Size();
+    }
+
+    Type Sum() const {
+        assert(dia_.IsValid());
+        return dia_.Sum();
+    }
+
+    Type Min() const {
+        assert(dia_.IsValid());
+        return dia_.Min();
+    }
+
+    Type Max() const {
+        assert(dia_.IsValid());
+        return dia_.Max();
+    }
+
+    //! gather all items on all workers, as a NumPy array or a list of str.
+    PyObject * AllGather() const {
+        assert(dia_.IsValid());
+        std::vector<Type> vec = dia_.AllGather();
+
+        SWIG_PYTHON_THREAD_BEGIN_BLOCK;
+        PyObject* batch = PyColumnTraits<Type>::ToPython(vec);
+        SWIG_PYTHON_THREAD_END_BLOCK;
+        return batch;
+    }
+};
+
 class PyContext : public api::Context
 {
     static const bool debug = true;
@@ -399,13 +775,14 @@ public:
             *dynamic_cast<SwigDirector_GeneratorFunction*>(&generator_function);
 
         PyObjDIA dia = api::Generate(
-            *this, [&generator_function,
-                    // this holds a reference count to the callback object for the
-                    // lifetime of the capture object.
-                    ref = PyObjectRef(director.swig_get_self())
+            *this, size,
+            [&generator_function,
+             // this holds a reference count to the callback object for the
+             // lifetime of the capture object.
+             ref = PyObjectRef(director.swig_get_self())
             ](size_t index) {
                 return PyObjectRef(generator_function(index), true);
-            }, size);
+            });
 
         return PyDIA(dia);
     }
@@ -420,8 +797,54 @@ public:
         return PyDIA(dia);
     }
 
+    //! DIA of the integers [0,size), generated natively.
+    PyColumnDIA<int64_t> Range(size_t size) {
+        return PyColumnDIA<int64_t>(
+            api::Generate(*this, size, [](size_t index) {
+                              return static_cast<int64_t>(index);
+                          }));
+    }
+
+    //! Distribute a buffer (e.g. NumPy array) or sequence of numbers from
+    //! worker 0.
+    PyColumnDIA<double> DistributeDoubles(PyObject* batch) {
+        return DistributeColumn<double>(batch);
+    }
+
+    //! Distribute a buffer (e.g. NumPy array) or sequence of integers from
+    //! worker 0.
+    PyColumnDIA<int64_t> DistributeInt64(PyObject* batch) {
+        return DistributeColumn<int64_t>(batch);
+    }
+
+    //! Distribute a sequence of str or bytes from worker 0.
+    PyColumnDIA<std::string> DistributeStrings(PyObject* batch) {
+        return DistributeColumn<std::string>(batch);
+    }
+
+    //! Read the lines of the files matching filepath natively.
+    PyColumnDIA<std::string> ReadLines(const std::string& filepath) {
+        return PyColumnDIA<std::string>(api::ReadLines(*this, filepath));
+    }
+
 protected:
     std::unique_ptr<HostContext> host_context_;
+
+#ifndef SWIG
+    template <typename Type>
+    PyColumnDIA<Type> DistributeColumn(PyObject* batch) {
+        std::vector<Type> vec;
+        bool ok;
+        {
+            SWIG_PYTHON_THREAD_BEGIN_BLOCK;
+            ok = PyColumnTraits<Type>::FromPython(batch, vec);
+            if (!ok) PyErr_PrintEx(0);
+            SWIG_PYTHON_THREAD_END_BLOCK;
+        }
+        if (!ok) die("Invalid batch passed to Distribute");
+        return PyColumnDIA<Type>(api::Distribute(*this, std::move(vec)));
+    }
+#endif
 };
 
 } // namespace thrill
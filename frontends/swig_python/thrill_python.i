@@ -28,6 +28,8 @@ using namespace thrill;
 %feature("director") KeyExtractorFunction;
 %feature("director") ReduceFunction;
 
+%feature("director") BatchFunction;
+
 %feature("director:except") {
     if ($error != NULL) {
         // print backtrace
@@ -154,7 +156,43 @@ callback_wrapper('thrill::PyDIA::Filter(FilterFunction&) const',
 %feature("pythonprepend") thrill::PyDIA::ReduceBy(KeyExtractorFunction&, ReduceFunction&) const
 CallbackHelper2(KeyExtractorFunction, key_extractor, ReduceFunction, reduce_function)
 
+// batch callbacks receive NumPy arrays instead of memoryviews, if available,
+// and AllGather() of typed DIAs delivers NumPy arrays.
+%pythoncode %{
+try:
+  import numpy as _numpy
+except ImportError:
+  _numpy = None
+
+def _as_batch(batch):
+  if _numpy is not None and isinstance(batch, memoryview):
+    return _numpy.asarray(batch)
+  return batch
+
+def _batch_callback(function):
+  if isinstance(function, BatchFunction) or not callable(function):
+    return function
+  class CallableWrapper(BatchFunction):
+    def __init__(self, f):
+      super(CallableWrapper, self).__init__()
+      self.f_ = f
+    def __call__(self, batch):
+      return self.f_(_as_batch(batch))
+  return CallableWrapper(function)
+%}
+
+%feature("pythonprepend") thrill::PyColumnDIA::MapBatches %{
+  args = (_batch_callback(args[0]),) + tuple(args[1:])
+%}
+%feature("pythonprepend") thrill::PyColumnDIA::FilterBatches %{
+  args = (_batch_callback(args[0]),) + tuple(args[1:])
+%}
+%feature("pythonappend") thrill::PyColumnDIA::AllGather %{
+  val = _as_batch(val)
+%}
+
 %include <std_string.i>
+%include <stdint.i>
 %include <std_vector.i>
 %include <std_shared_ptr.i>
 
@@ -181,6 +219,10 @@ CallbackHelper2(KeyExtractorFunction, key_extractor, ReduceFunction, reduce_func
 %include <thrill/api/context.hpp>
 %include "thrill_python.hpp"
 
+%template(PyDoubleDIA) thrill::PyColumnDIA<double>;
+%template(PyInt64DIA) thrill::PyColumnDIA<int64_t>;
+%template(PyStringDIA) thrill::PyColumnDIA<std::string>;
+
 // Local Variables:
 // mode: c++
 // mode: mmm
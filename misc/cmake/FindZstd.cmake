@@ -0,0 +1,48 @@
+################################################################################
+#
+# - Try to find Zstandard (zstd) headers and libraries.
+#
+# Usage of this module as follows:
+#
+#     find_package(Zstd)
+#
+# Variables used by this module, they can change the default behaviour and need
+# to be set before calling find_package:
+#
+#  ZSTD_ROOT_DIR Set this variable to the root installation of
+#                Zstandard (zstd) if the module has problems finding
+#                the proper installation path.
+#
+# Variables defined by this module:
+#
+#  ZSTD_FOUND             System has zstd libs/headers
+#  ZSTD_LIBRARIES         The zstd library/libraries
+#  ZSTD_INCLUDE_DIRS      The location of zstd headers
+
+find_path(ZSTD_ROOT_DIR
+  NAMES include/zstd.h
+  )
+
+find_library(ZSTD_LIBRARIES
+  NAMES zstd
+  HINTS ${ZSTD_ROOT_DIR}/lib
+  )
+
+find_path(ZSTD_INCLUDE_DIRS
+  NAMES zstd.h
+  HINTS ${ZSTD_ROOT_DIR}/include
+  )
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Zstd DEFAULT_MSG
+  ZSTD_LIBRARIES
+  ZSTD_INCLUDE_DIRS
+  )
+
+mark_as_advanced(
+  ZSTD_ROOT_DIR
+  ZSTD_LIBRARIES
+  ZSTD_INCLUDE_DIRS
+  )
+
+################################################################################
@@ -9,6 +9,7 @@
  ******************************************************************************/
 
 #include <thrill/common/json_logger.hpp>
+#include <thrill/common/json_trace.hpp>
 #include <thrill/common/logger.hpp>
 #include <tlx/cmdline_parser.hpp>
 #include <tlx/string/ends_with.hpp>
@@ -21,9 +22,12 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <sstream>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -283,6 +287,10 @@ public:
     uint64_t rx_int_bytes;
     uint64_t tx_int_bytes;
 
+    //! items and bytes sent to each worker, including loopback
+    std::vector<uint64_t> tx_items_per_worker;
+    std::vector<uint64_t> tx_bytes_per_worker;
+
     explicit CStream(const rapidjson::Document& d)
         : CEvent(d),
           event(GetString(d, "event")),
@@ -296,8 +304,19 @@ public:
           rx_int_items(GetUint64(d, "rx_int_items")),
           tx_int_items(GetUint64(d, "tx_int_items")),
           rx_int_bytes(GetUint64(d, "rx_int_bytes")),
-          tx_int_bytes(GetUint64(d, "tx_int_bytes"))
-    { }
+          tx_int_bytes(GetUint64(d, "tx_int_bytes")) {
+        // extract per worker arrays
+        if (d["tx_items_per_worker"].IsArray()) {
+            for (auto it = d["tx_items_per_worker"].Begin();
+                 it != d["tx_items_per_worker"].End(); ++it)
+                tx_items_per_worker.emplace_back(it->GetUint64());
+        }
+        if (d["tx_bytes_per_worker"].IsArray()) {
+            for (auto it = d["tx_bytes_per_worker"].Begin();
+                 it != d["tx_bytes_per_worker"].End(); ++it)
+                tx_bytes_per_worker.emplace_back(it->GetUint64());
+        }
+    }
 
     bool operator < (const CStream& o) const {
         return std::tie(id, host_rank, worker_rank)
@@ -433,6 +452,84 @@ public:
     }
 };
 
+//! traffic between all pairs of workers in the streams of one DIA node
+class CTrafficMatrix
+{
+public:
+    uint32_t dia_id = 0;
+    size_t num_workers = 0;
+    //! items and bytes sent from worker i to j at [i * num_workers + j]
+    std::vector<uint64_t> items, bytes;
+
+    void Add(const CStream& s) {
+        dia_id = s.dia_id;
+        if (s.tx_bytes_per_worker.size() > num_workers) {
+            // grow matrix, keeping the existing entries
+            size_t p = s.tx_bytes_per_worker.size();
+            std::vector<uint64_t> new_items(p * p), new_bytes(p * p);
+            for (size_t i = 0; i < num_workers; ++i) {
+                for (size_t j = 0; j < num_workers; ++j) {
+                    new_items[i * p + j] = items[i * num_workers + j];
+                    new_bytes[i * p + j] = bytes[i * num_workers + j];
+                }
+            }
+            items.swap(new_items), bytes.swap(new_bytes);
+            num_workers = p;
+        }
+        if (s.worker_rank >= num_workers) return;
+
+        for (size_t j = 0; j < s.tx_bytes_per_worker.size(); ++j) {
+            bytes[s.worker_rank * num_workers + j] += s.tx_bytes_per_worker[j];
+            if (j < s.tx_items_per_worker.size())
+                items[s.worker_rank * num_workers + j] +=
+                    s.tx_items_per_worker[j];
+        }
+    }
+
+    //! maximum and mean of the bytes received by a worker
+    std::pair<uint64_t, double> ReceivedMaxMean() const {
+        uint64_t max = 0, total = 0;
+        for (size_t j = 0; j < num_workers; ++j) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < num_workers; ++i)
+                sum += bytes[i * num_workers + j];
+            max = std::max(max, sum);
+            total += sum;
+        }
+        return std::make_pair(
+            max, num_workers ? static_cast<double>(total) / num_workers : 0.0);
+    }
+
+    //! output matrix as table with cells shaded by their bytes
+    void HtmlHeatmap(std::ostream& os) const {
+        uint64_t max = *std::max_element(bytes.begin(), bytes.end());
+        // print values only in small matrices
+        bool values = (num_workers <= 16);
+
+        os << "<table class=\"heatmap\">";
+        os << "<tr><th>src \\ tgt</th>";
+        for (size_t j = 0; j < num_workers; ++j)
+            os << "<th>" << j << "</th>";
+        os << "</tr>";
+        for (size_t i = 0; i < num_workers; ++i) {
+            os << "<tr><th>" << i << "</th>";
+            for (size_t j = 0; j < num_workers; ++j) {
+                uint64_t b = bytes[i * num_workers + j];
+                double alpha = max ? static_cast<double>(b) / max : 0.0;
+                os << "<td style=\"background-color: rgba(200,0,0,"
+                   << alpha << ")\" title=\"" << i << " &rarr; " << j << ": "
+                   << tlx::format_iec_units(b) << "B, "
+                   << items[i * num_workers + j] << " items\">";
+                if (values)
+                    os << tlx::format_iec_units(b);
+                os << "</td>";
+            }
+            os << "</tr>";
+        }
+        os << "</table>\n";
+    }
+};
+
 // {"ts":1461082954074899,"host_rank":0,"class":"File","event":"close","id":2261,"dia_id":4,"items":0,"bytes":0}
 
 class CFile : public CEvent
@@ -494,12 +591,24 @@ public:
     std::string event;
     std::vector<uint32_t> targets;
 
+    // fields of the done events
+    double elapsed;
+    double wait_net;
+    double wait_collective;
+    uint64_t spill_write_bytes;
+    uint64_t spill_read_bytes;
+
     explicit CStageBuilder(const rapidjson::Document& d)
         : CEvent(d),
           worker_rank(GetUint32(d, "worker_rank")),
           id(GetUint32(d, "dia_id")),
           label(GetString(d, "label")),
-          event(GetString(d, "event")) {
+          event(GetString(d, "event")),
+          elapsed(GetDouble(d, "elapsed")),
+          wait_net(GetDouble(d, "wait_net")),
+          wait_collective(GetDouble(d, "wait_collective")),
+          spill_write_bytes(GetUint64(d, "spill_write_bytes")),
+          spill_read_bytes(GetUint64(d, "spill_read_bytes")) {
         // extract targets array
         if (d["targets"].IsArray()) {
             for (auto it = d["targets"].Begin(); it != d["targets"].End(); ++it)
@@ -515,59 +624,432 @@ public:
 
 std::vector<CStageBuilder> c_StageBuilder;
 
+// {"ts":1461144110172911,"host_rank":0,"class":"PerfCounters","event":"profile","worker_rank":3,"dia_id":9,"cycles":192324413,"instructions":310512007,"llc_misses":1048576,"branch_misses":22537,"dtlb_misses":524288}
+
+class CPerfCounters : public CEvent
+{
+public:
+    uint32_t worker_rank;
+    uint32_t dia_id;
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t llc_misses;
+    uint64_t branch_misses;
+    uint64_t dtlb_misses;
+
+    explicit CPerfCounters(const rapidjson::Document& d)
+        : CEvent(d),
+          worker_rank(GetUint32(d, "worker_rank")),
+          dia_id(GetUint32(d, "dia_id")),
+          cycles(GetUint64(d, "cycles")),
+          instructions(GetUint64(d, "instructions")),
+          llc_misses(GetUint64(d, "llc_misses")),
+          branch_misses(GetUint64(d, "branch_misses")),
+          dtlb_misses(GetUint64(d, "dtlb_misses"))
+    { }
+};
+
+std::vector<CPerfCounters> c_PerfCounters;
+
+//! hardware counters of all workers summed per DIA node
+class CPerfSummary
+{
+public:
+    uint32_t dia_id = 0;
+    uint64_t cycles = 0, instructions = 0;
+    uint64_t llc_misses = 0, branch_misses = 0, dtlb_misses = 0;
+
+    CPerfSummary& operator += (const CPerfCounters& c) {
+        dia_id = c.dia_id;
+        cycles += c.cycles;
+        instructions += c.instructions;
+        llc_misses += c.llc_misses;
+        branch_misses += c.branch_misses;
+        dtlb_misses += c.dtlb_misses;
+        return *this;
+    }
+
+    //! instructions per cycle
+    double ipc() const {
+        return cycles ? static_cast<double>(instructions) / cycles : 0.0;
+    }
+
+    //! misses per kilo-instruction
+    double mpki(uint64_t misses) const {
+        return instructions ? misses * 1000.0 / instructions : 0.0;
+    }
+
+    static void HtmlHeader(std::ostream& os) {
+        os << "<tr>";
+        os << "<th>dia_id</th>";
+        os << "<th>cycles</th>";
+        os << "<th>instructions</th>";
+        os << "<th>IPC</th>";
+        os << "<th>LLC MPKI</th>";
+        os << "<th>branch MPKI</th>";
+        os << "<th>dTLB MPKI</th>";
+        os << "</tr>";
+    }
+
+    void HtmlRow(std::ostream& os) const {
+        os << "<tr>";
+        if (dia_id == 0)
+            os << "<td class=\"left\">outside stages</td>";
+        else
+            os << "<td class=\"left\">" << m_DIABase[dia_id] << "</td>";
+        os << "<td>" << tlx::format_si_units(cycles) << "</td>";
+        os << "<td>" << tlx::format_si_units(instructions) << "</td>";
+        os << "<td>" << ipc() << "</td>";
+        os << "<td>" << mpki(llc_misses) << "</td>";
+        os << "<td>" << mpki(branch_misses) << "</td>";
+        os << "<td>" << mpki(dtlb_misses) << "</td>";
+        os << "</tr>";
+    }
+};
+
+// {"ts":1461144110172911,"host_rank":0,"class":"StackSamples","event":"profile","worker_rank":3,"dia_id":9,"label":"Sort","samples":12,"stack":"start_thread;...;std::__introsort_loop<...>"}
+
+class CStackSamples : public CEvent
+{
+public:
+    uint32_t worker_rank;
+    uint32_t dia_id;
+    std::string label;
+    uint64_t samples;
+    std::string stack;
+
+    explicit CStackSamples(const rapidjson::Document& d)
+        : CEvent(d),
+          worker_rank(GetUint32(d, "worker_rank")),
+          dia_id(GetUint32(d, "dia_id")),
+          label(GetString(d, "label")),
+          samples(GetUint64(d, "samples")),
+          stack(GetString(d, "stack"))
+    { }
+
+    //! root frame of the folded stack: the DIA node
+    std::string root() const {
+        if (dia_id == 0) return "[outside stages]";
+        return label + '.' + std::to_string(dia_id);
+    }
+
+    //! innermost frame of the stack
+    std::string leaf() const {
+        std::string::size_type pos = stack.rfind(';');
+        return pos == std::string::npos ? stack : stack.substr(pos + 1);
+    }
+};
+
+std::vector<CStackSamples> c_StackSamples;
+
 /******************************************************************************/
 
-size_t s_num_events = 0;
+//! Straggler analysis of one stage: the done events of all workers for one
+//! execution of a stage, and the worker which took longest.
+class CStageStraggler
+{
+public:
+    explicit CStageStraggler(const CStageBuilder& s) : slowest(s) { }
 
-void LoadJsonProfile(FILE* in) {
-    char* line = nullptr;
-    size_t len = 0;
-    ssize_t rb;
+    //! the done event of the slowest worker
+    CStageBuilder slowest;
+    //! start of the stage on the slowest worker
+    uint64_t ts = 0;
+    //! number of workers which reported the stage
+    size_t num_workers = 0;
+    //! mean elapsed time and collective wait of the other workers
+    double others_elapsed = 0, others_wait_collective = 0;
+    //! items and bytes received and sent in the streams of the slowest
+    //! worker in the DIA node of the stage
+    uint64_t items_in = 0, items_out = 0, bytes_in = 0, bytes_out = 0;
+
+    //! time of the slowest worker not spent waiting
+    double compute() const {
+        return std::max(
+            0.0, slowest.elapsed - slowest.wait_net - slowest.wait_collective);
+    }
 
-    while ((rb = getline(&line, &len, in)) >= 0) {
-        rapidjson::Document d;
-        d.Parse<0>(line);
-        if (d.HasParseError() || !d["class"].IsString()) continue;
+    static void HtmlHeader(std::ostream& os) {
+        os << "<tr>";
+        os << "<th>ts</th>";
+        os << "<th>dia_id</th>";
+        os << "<th>event</th>";
+        os << "<th>slowest worker</th>";
+        os << "<th>elapsed (ms)</th>";
+        os << "<th>others mean (ms)</th>";
+        os << "<th>compute (ms)</th>";
+        os << "<th>net wait (ms)</th>";
+        os << "<th>collective wait (ms)</th>";
+        os << "<th>others collective wait (ms)</th>";
+        os << "<th>items in</th>";
+        os << "<th>items out</th>";
+        os << "<th>bytes in</th>";
+        os << "<th>bytes out</th>";
+        os << "<th>spill write</th>";
+        os << "<th>spill read</th>";
+        os << "</tr>";
+    }
 
-        std::string class_str = d["class"].GetString();
+    void HtmlRow(std::ostream& os) const {
+        os << "<tr>";
+        os << "<td>" << ts / 1000.0 << "</td>";
+        os << "<td class=\"left\">" << escape_html(slowest.label)
+           << "." << slowest.id << "</td>";
+        os << "<td class=\"left\">" << slowest.event << "</td>";
+        os << "<td>" << slowest.worker_rank << "</td>";
+        os << "<td>" << slowest.elapsed * 1e3 << "</td>";
+        os << "<td>" << others_elapsed * 1e3 << "</td>";
+        os << "<td>" << compute() * 1e3 << "</td>";
+        os << "<td>" << slowest.wait_net * 1e3 << "</td>";
+        os << "<td>" << slowest.wait_collective * 1e3 << "</td>";
+        os << "<td>" << others_wait_collective * 1e3 << "</td>";
+        os << "<td>" << items_in << "</td>";
+        os << "<td>" << items_out << "</td>";
+        os << "<td>" << tlx::format_iec_units(bytes_in) << "B</td>";
+        os << "<td>" << tlx::format_iec_units(bytes_out) << "B</td>";
+        os << "<td>" << tlx::format_iec_units(slowest.spill_write_bytes)
+           << "B</td>";
+        os << "<td>" << tlx::format_iec_units(slowest.spill_read_bytes)
+           << "B</td>";
+        os << "</tr>";
+    }
 
-        ++s_num_events;
+    static void TextHeader(std::ostream& os) {
+        os << std::left << std::setw(24) << "stage"
+           << std::setw(15) << "event" << std::right
+           << std::setw(7) << "worker"
+           << std::setw(11) << "elapsed"
+           << std::setw(11) << "others"
+           << std::setw(11) << "compute"
+           << std::setw(11) << "net_wait"
+           << std::setw(11) << "coll_wait"
+           << std::setw(11) << "oth_coll"
+           << std::setw(12) << "items_in"
+           << std::setw(12) << "items_out"
+           << std::setw(10) << "bytes_in"
+           << std::setw(10) << "bytes_out"
+           << std::setw(10) << "spill_wr"
+           << std::setw(10) << "spill_rd" << '\n';
+    }
 
-        if (class_str == "Cmdline") {
-            c_Cmdline.emplace_back(d);
-        }
-        else if (class_str == "NetManager") {
-            c_NetManager.emplace_back(d);
-        }
-        else if (class_str == "MemProfile") {
-            c_MemProfile.emplace_back(d);
+    void TextRow(std::ostream& os) const {
+        os << std::left << std::setw(24)
+           << slowest.label + "." + std::to_string(slowest.id)
+           << std::setw(15) << slowest.event << std::right
+           << std::fixed << std::setprecision(1)
+           << std::setw(7) << slowest.worker_rank
+           << std::setw(11) << slowest.elapsed * 1e3
+           << std::setw(11) << others_elapsed * 1e3
+           << std::setw(11) << compute() * 1e3
+           << std::setw(11) << slowest.wait_net * 1e3
+           << std::setw(11) << slowest.wait_collective * 1e3
+           << std::setw(11) << others_wait_collective * 1e3
+           << std::setw(12) << items_in
+           << std::setw(12) << items_out
+           << std::setw(10) << tlx::format_iec_units(bytes_in)
+           << std::setw(10) << tlx::format_iec_units(bytes_out)
+           << std::setw(10) << tlx::format_iec_units(slowest.spill_write_bytes)
+           << std::setw(10) << tlx::format_iec_units(slowest.spill_read_bytes)
+           << '\n';
+    }
+};
+
+/*!
+ * Match the done events of all workers for each stage execution, the k-th
+ * done event of a DIA node on one worker belongs to the k-th on all others,
+ * and find the slowest worker. Returns the stages in order of their start.
+ */
+std::vector<CStageStraggler> AnalyzeStragglers() {
+    using Key = std::tuple<uint32_t, std::string, size_t>;
+
+    // occurrence counter of (dia_id, event) on each worker
+    std::map<std::tuple<uint32_t, std::string, uint32_t>, size_t> occurrence;
+    std::map<Key, std::vector<const CStageBuilder*> > stages;
+    std::map<Key, uint64_t> stage_start;
+
+    for (const CStageBuilder& c : c_StageBuilder) {
+        bool done = (c.event == "execute-done" || c.event == "pushdata-done");
+        bool start = (c.event == "execute-start" || c.event == "pushdata-start");
+        if (!done && !start) continue;
+
+        // use the name of the done event for both
+        std::string event =
+            c.event.substr(0, c.event.find('-')) + "-done";
+        size_t& k = occurrence[
+            std::make_tuple(c.id, c.event, c.worker_rank)];
+        Key key(c.id, event, k++);
+
+        if (start) {
+            auto it = stage_start.find(key);
+            if (it == stage_start.end() || c.ts < it->second)
+                stage_start[key] = c.ts;
         }
-        else if (class_str == "BlockPool") {
-            c_BlockPool.emplace_back(d);
+        else {
+            stages[key].push_back(&c);
         }
-        else if (class_str == "LinuxProcStats") {
-            c_LinuxProcStats.emplace_back(d);
+    }
+
+    // stream volume of each (dia_id, worker)
+    std::map<std::pair<uint32_t, uint32_t>, CStreamSummary> streams;
+    for (const CStream& c : c_Stream) {
+        if (c.event != "close") continue;
+        auto key = std::make_pair(c.dia_id, c.worker_rank);
+        auto it = streams.find(key);
+        if (it == streams.end()) {
+            streams[key].Initialize(c);
         }
-        else if (class_str == "Stream") {
-            c_Stream.emplace_back(d);
+        else {
+            // sum all streams of the node
+            it->second.id = c.id;
+            it->second.Add(c);
         }
-        else if (class_str == "File") {
-            c_File.emplace_back(d);
+    }
+
+    std::vector<CStageStraggler> result;
+    for (const auto& s : stages) {
+        const std::vector<const CStageBuilder*>& events = s.second;
+
+        const CStageBuilder* slowest = events.front();
+        for (const CStageBuilder* c : events) {
+            if (c->elapsed > slowest->elapsed) slowest = c;
         }
-        else if (class_str == "DIABase") {
-            c_DIABase.emplace_back(d);
 
-            const CDIABase& db = c_DIABase.back();
-            if (m_DIABase.count(db.id) == 0)
-                m_DIABase.insert(std::make_pair(db.id, db));
+        CStageStraggler st(*slowest);
+        st.ts = stage_start.count(s.first) ? stage_start[s.first] : slowest->ts;
+        st.num_workers = events.size();
+
+        for (const CStageBuilder* c : events) {
+            if (c == slowest) continue;
+            st.others_elapsed += c->elapsed;
+            st.others_wait_collective += c->wait_collective;
         }
-        else if (class_str == "StageBuilder") {
-            c_StageBuilder.emplace_back(d);
+        if (events.size() > 1) {
+            st.others_elapsed /= events.size() - 1;
+            st.others_wait_collective /= events.size() - 1;
         }
-        else {
-            --s_num_events;
+
+        auto it = streams.find(
+            std::make_pair(slowest->id, slowest->worker_rank));
+        if (it != streams.end()) {
+            const CStreamSummary& ss = it->second;
+            st.items_in = ss.rx_net_items + ss.rx_int_items;
+            st.items_out = ss.tx_net_items + ss.tx_int_items;
+            st.bytes_in = ss.rx_net_bytes + ss.rx_int_bytes;
+            st.bytes_out = ss.tx_net_bytes + ss.tx_int_bytes;
         }
+
+        result.emplace_back(st);
+    }
+
+    std::sort(result.begin(), result.end(),
+              [](const CStageStraggler& a, const CStageStraggler& b) {
+                  return a.ts < b.ts;
+              });
+    return result;
+}
+
+//! output the straggler report as text table
+std::string StragglerTable() {
+    std::ostringstream oss;
+    std::vector<CStageStraggler> stragglers = AnalyzeStragglers();
+
+    double critical_path = 0;
+    oss << "Stage stragglers, times in ms:\n";
+    CStageStraggler::TextHeader(oss);
+    for (const CStageStraggler& s : stragglers) {
+        s.TextRow(oss);
+        critical_path += s.slowest.elapsed;
+    }
+    oss << "Critical path through the slowest workers: "
+        << std::fixed << std::setprecision(1)
+        << critical_path * 1e3 << " ms\n";
+    return oss.str();
+}
+
+/******************************************************************************/
+
+size_t s_num_events = 0;
+
+//! output the JSON lines instead of parsing them, converting binary traces
+bool s_output_json = false;
+
+void LoadJsonLine(const char* line) {
+    if (s_output_json) {
+        std::cout << line;
+        if (*line == 0 || line[strlen(line) - 1] != '\n')
+            std::cout << '\n';
+        return;
+    }
+
+    rapidjson::Document d;
+    d.Parse<0>(line);
+    if (d.HasParseError() || !d["class"].IsString()) return;
+
+    std::string class_str = d["class"].GetString();
+
+    ++s_num_events;
+
+    if (class_str == "Cmdline") {
+        c_Cmdline.emplace_back(d);
+    }
+    else if (class_str == "NetManager") {
+        c_NetManager.emplace_back(d);
+    }
+    else if (class_str == "MemProfile") {
+        c_MemProfile.emplace_back(d);
+    }
+    else if (class_str == "BlockPool") {
+        c_BlockPool.emplace_back(d);
+    }
+    else if (class_str == "LinuxProcStats") {
+        c_LinuxProcStats.emplace_back(d);
+    }
+    else if (class_str == "Stream" || class_str == "StreamData") {
+        c_Stream.emplace_back(d);
     }
+    else if (class_str == "File") {
+        c_File.emplace_back(d);
+    }
+    else if (class_str == "DIABase") {
+        c_DIABase.emplace_back(d);
+
+        const CDIABase& db = c_DIABase.back();
+        if (m_DIABase.count(db.id) == 0)
+            m_DIABase.insert(std::make_pair(db.id, db));
+    }
+    else if (class_str == "StageBuilder") {
+        c_StageBuilder.emplace_back(d);
+    }
+    else if (class_str == "PerfCounters") {
+        c_PerfCounters.emplace_back(d);
+    }
+    else if (class_str == "StackSamples") {
+        c_StackSamples.emplace_back(d);
+    }
+    else {
+        --s_num_events;
+    }
+}
+
+void LoadJsonProfile(FILE* in) {
+    // binary traces start with the magic, json logs with '{'
+    int first = getc(in);
+    if (first == EOF) return;
+    ungetc(first, in);
+
+    if (first == common::json_trace_magic[0]) {
+        common::JsonTraceReader reader(in);
+        std::string line;
+        while (reader.Next(line))
+            LoadJsonLine(line.c_str());
+        return;
+    }
+
+    char* line = nullptr;
+    size_t len = 0;
+
+    while (getline(&line, &len, in) >= 0)
+        LoadJsonLine(line);
 
     free(line);
 }
@@ -781,6 +1263,8 @@ std::string PageMain() {
     oss << "    <style type=\"text/css\">\n";
     oss << "table.dataframe td { text-align: right }\n";
     oss << "table.dataframe td.left { text-align: left }\n";
+    oss << "table.heatmap { border-collapse: collapse; font-size: small }\n";
+    oss << "table.heatmap td { min-width: 1em; text-align: right; border: 1px solid #eee }\n";
     oss << "    </style>\n";
     oss << "    \n";
     oss << "    <!-- SUPPORT FOR IE6-8 OF HTML5 ELEMENTS -->\n";
@@ -1259,6 +1743,111 @@ std::string PageMain() {
 
     /**************************************************************************/
 
+    {
+        std::vector<CStageStraggler> stragglers = AnalyzeStragglers();
+        double critical_path = 0;
+        for (const CStageStraggler& s : stragglers)
+            critical_path += s.slowest.elapsed;
+
+        oss << "<h2>Stage Stragglers</h2>\n";
+        oss << "<p>Slowest worker of each stage, its time spent waiting for "
+            << "stream data and in collectives, and the mean time of the "
+            << "other workers. Critical path through the slowest workers: "
+            << critical_path * 1e3 << " ms.</p>\n";
+
+        oss << "<table border=\"1\" class=\"dataframe\">";
+        oss << "<thead>";
+        CStageStraggler::HtmlHeader(oss);
+        oss << "</thead>";
+        oss << "<tbody>";
+        for (const CStageStraggler& s : stragglers)
+            s.HtmlRow(oss);
+        oss << "</tbody>";
+        oss << "</table>";
+        oss << "\n";
+    }
+
+    /**************************************************************************/
+
+    if (c_PerfCounters.size() != 0)
+    {
+        std::map<uint32_t, CPerfSummary> perf;
+        for (const CPerfCounters& c : c_PerfCounters)
+            perf[c.dia_id] += c;
+
+        oss << "<h2>Hardware Counters</h2>\n";
+        oss << "<p>Counters of all worker threads in user space summed per DIA "
+            << "node (THRILL_PERF_COUNTERS). A low IPC with many LLC or dTLB "
+            << "misses per kilo-instruction indicates a memory-bound "
+            << "operator.</p>\n";
+
+        oss << "<table border=\"1\" class=\"dataframe\">";
+        oss << "<thead>";
+        CPerfSummary::HtmlHeader(oss);
+        oss << "</thead>";
+        oss << "<tbody>";
+        for (const std::pair<const uint32_t, CPerfSummary>& p : perf)
+            p.second.HtmlRow(oss);
+        oss << "</tbody>";
+        oss << "</table>";
+        oss << "\n";
+    }
+
+    /**************************************************************************/
+
+    if (c_StackSamples.size() != 0)
+    {
+        // samples per DIA node, and per innermost function in each node
+        std::map<std::string, uint64_t> nodes;
+        std::map<std::string, std::map<std::string, uint64_t> > leaves;
+        uint64_t total = 0;
+        for (const CStackSamples& c : c_StackSamples) {
+            nodes[c.root()] += c.samples;
+            leaves[c.root()][c.leaf()] += c.samples;
+            total += c.samples;
+        }
+
+        oss << "<h2>Stack Samples</h2>\n";
+        oss << "<p>Call stacks of all worker threads sampled on CPU "
+            << "(THRILL_STACK_SAMPLES). Use json2profile -f to output them as "
+            << "folded stacks for flame graphs.</p>\n";
+
+        oss << "<table border=\"1\" class=\"dataframe\">";
+        oss << "<thead><tr>";
+        oss << "<th>DIA node</th>";
+        oss << "<th>samples</th>";
+        oss << "<th>share</th>";
+        oss << "<th>hottest function</th>";
+        oss << "<th>its samples</th>";
+        oss << "</tr></thead>";
+        oss << "<tbody>";
+        for (const std::pair<const std::string, uint64_t>& n : nodes) {
+            const std::map<std::string, uint64_t>& l = leaves[n.first];
+            auto hottest = std::max_element(
+                l.begin(), l.end(),
+                [](const std::pair<const std::string, uint64_t>& a,
+                   const std::pair<const std::string, uint64_t>& b) {
+                    return a.second < b.second;
+                });
+            oss << "<tr>";
+            oss << "<td class=\"left\">" << escape_html(n.first) << "</td>";
+            oss << "<td>" << n.second << "</td>";
+            std::ostringstream share;
+            share << std::fixed << std::setprecision(1)
+                  << 100.0 * n.second / total;
+            oss << "<td>" << share.str() << "%</td>";
+            oss << "<td class=\"left\">" << escape_html(hottest->first)
+                << "</td>";
+            oss << "<td>" << hottest->second << "</td>";
+            oss << "</tr>";
+        }
+        oss << "</tbody>";
+        oss << "</table>";
+        oss << "\n";
+    }
+
+    /**************************************************************************/
+
     if (c_Stream.size() != 0)
     {
         oss << "<h2>Stream Summary</h2>\n";
@@ -1290,6 +1879,33 @@ std::string PageMain() {
 
     /**************************************************************************/
 
+    {
+        std::map<uint32_t, CTrafficMatrix> traffic;
+        for (const CStream& c : c_Stream) {
+            if (c.event != "close" || c.tx_bytes_per_worker.empty()) continue;
+            traffic[c.dia_id].Add(c);
+        }
+
+        if (traffic.size() != 0) {
+            oss << "<h2>Stream Traffic</h2>\n";
+            oss << "<p>Bytes sent between each pair of workers in the streams "
+                << "of each DIA node, rows are senders, columns receivers. "
+                << "Hover over a cell for its items.</p>\n";
+        }
+
+        for (const std::pair<const uint32_t, CTrafficMatrix>& t : traffic) {
+            std::pair<uint64_t, double> recv = t.second.ReceivedMaxMean();
+            oss << "<h3>" << m_DIABase[t.first] << "</h3>\n";
+            oss << "<p>Maximum bytes received by a worker: "
+                << tlx::format_iec_units(recv.first) << "B, "
+                << (recv.second != 0 ? recv.first / recv.second : 0.0)
+                << " times the mean.</p>\n";
+            t.second.HtmlHeatmap(oss);
+        }
+    }
+
+    /**************************************************************************/
+
     if (s_detail_tables && c_Stream.size() != 0)
     {
         oss << "<h2>Stream Details</h2>\n";
@@ -1453,6 +2069,21 @@ std::string ResultLines() {
 
 /******************************************************************************/
 
+//! output the stack samples of all workers as folded stacks, with the DIA node
+//! as root frame, for flame graph tools.
+std::string FoldedStacks() {
+    std::map<std::string, uint64_t> folded;
+    for (const CStackSamples& c : c_StackSamples)
+        folded[c.root() + ';' + c.stack] += c.samples;
+
+    std::ostringstream oss;
+    for (const std::pair<const std::string, uint64_t>& f : folded)
+        oss << f.first << ' ' << f.second << '\n';
+    return oss.str();
+}
+
+/******************************************************************************/
+
 int main(int argc, char* argv[]) {
     tlx::CmdlineParser clp;
     clp.set_description("Thrill Json Profile Parser");
@@ -1468,6 +2099,18 @@ int main(int argc, char* argv[]) {
     clp.add_bool('r', "result", output_RESULT_lines,
                  "output data as RESULT lines");
 
+    bool output_stragglers = false;
+    clp.add_bool('s', "stragglers", output_stragglers,
+                 "output the slowest worker of each stage as text table");
+
+    bool output_folded = false;
+    clp.add_bool('f', "folded", output_folded,
+                 "output the stack samples as folded stacks for flame graphs");
+
+    clp.add_bool('j', "json", s_output_json,
+                 "output the events as JSON lines, e.g. to convert binary "
+                 "traces");
+
     if (!clp.process(argc, argv)) return -1;
 
     if (inputs.size() == 0) {
@@ -1508,12 +2151,18 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (s_output_json) return 0;
+
     ProcessJsonProfile();
 
     std::cerr << "Parsed " << s_num_events << " events "
               << "from " << inputs.size() << " files" << std::endl;
 
-    if (output_RESULT_lines)
+    if (output_stragglers)
+        std::cout << StragglerTable();
+    else if (output_folded)
+        std::cout << FoldedStacks();
+    else if (output_RESULT_lines)
         std::cout << ResultLines();
     else
         std::cout << PageMain();
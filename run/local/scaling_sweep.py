@@ -0,0 +1,299 @@
+#!/usr/bin/env python3
+##########################################################################
+# run/local/scaling_sweep.py
+#
+# Python script to run the TeraSort, PageRank and TPC-H examples over a sweep
+# of hosts x workers x input sizes on the local machine, using the mock
+# network, the TCP loopback network of one process, or real TCP between one
+# process per host. The JSON logs of all runs are collected and reduced to a
+# CSV table and scaling plots of throughput per core, shuffle bytes per item,
+# and spill volume.
+#
+# Part of Project Thrill - http://project-thrill.org
+#
+# All rights reserved. Published under the BSD-2 license in the LICENSE file.
+##########################################################################
+
+import argparse
+import csv
+import glob
+import json
+import os
+import socket
+import subprocess
+import sys
+import time
+
+# size of a TeraSort record in bytes
+TERASORT_RECORD = 100
+
+SI_UNITS = { "": 1, "k": 1000, "m": 1000**2, "g": 1000**3, "t": 1000**4,
+             "ki": 1024, "mi": 1024**2, "gi": 1024**3, "ti": 1024**4 }
+
+def parse_size(s):
+    """parse a size like 64MiB or 1G into bytes"""
+    s = s.strip().lower()
+    if s.endswith("b"): s = s[:-1]
+    num = s.rstrip("kmgti")
+    return int(float(num) * SI_UNITS[s[len(num):]])
+
+def parse_list(s, conv=int):
+    return [conv(x) for x in s.split(",") if x]
+
+def free_ports(n):
+    """reserve n free TCP ports on localhost"""
+    socks = [socket.socket() for _ in range(n)]
+    for s in socks: s.bind(("127.0.0.1", 0))
+    ports = [s.getsockname()[1] for s in socks]
+    for s in socks: s.close()
+    return ports
+
+##########################################################################
+# Running
+
+def make_command(args, bench, size):
+    """return command line and number of items processed"""
+    if bench == "terasort":
+        return ([args.terasort, "-g", str(size)], size // TERASORT_RECORD)
+    if bench == "pagerank":
+        return ([args.page_rank, "-g", "-n", str(args.iterations), str(size)],
+                size)
+    if bench == "tpch":
+        # items are counted from the ReadLinesNode events
+        return ([args.tpch, args.tpch_input], None)
+    raise ValueError(bench)
+
+def run_once(args, net, hosts, workers, cmd, log_prefix):
+    """run one configuration, returns wall time or None on failure"""
+    env = dict(os.environ)
+    env["THRILL_WORKERS_PER_HOST"] = str(workers)
+    env["THRILL_LOG"] = log_prefix
+    env["THRILL_DIE_WITH_PARENT"] = "1"
+    for key in ["THRILL_RANK", "THRILL_HOSTLIST", "THRILL_LOCAL"]:
+        env.pop(key, None)
+
+    start = time.time()
+    if net in ["mock", "local"]:
+        env["THRILL_NET"] = net
+        env["THRILL_LOCAL"] = str(hosts)
+        procs = [subprocess.Popen(cmd, env=env, stdout=subprocess.DEVNULL)]
+    elif net == "tcp":
+        env["THRILL_NET"] = "tcp"
+        env["THRILL_HOSTLIST"] = " ".join(
+            "127.0.0.1:%d" % p for p in free_ports(hosts))
+        procs = []
+        for rank in range(hosts):
+            penv = dict(env)
+            penv["THRILL_RANK"] = str(rank)
+            procs.append(subprocess.Popen(
+                cmd, env=penv, stdout=subprocess.DEVNULL))
+    else:
+        raise ValueError("unknown network " + net)
+
+    ok = True
+    for p in procs:
+        try:
+            ok = p.wait(timeout=args.timeout) == 0 and ok
+        except subprocess.TimeoutExpired:
+            p.kill()
+            ok = False
+    wall = time.time() - start
+    return wall if ok else None
+
+def parse_logs(log_prefix):
+    """reduce the JSON logs of all hosts of a run to its metrics"""
+    m = { "runtime": None, "net_traffic": 0, "io_volume": 0,
+          "shuffle_bytes": 0, "lines": 0 }
+    for path in glob.glob(log_prefix + "-host-*.json"):
+        with open(path, "r") as f:
+            for line in f:
+                try:
+                    d = json.loads(line)
+                except ValueError:
+                    continue
+                c, e = d.get("class"), d.get("event")
+                if c == "Context" and e == "summary":
+                    m["runtime"] = d["runtime"]
+                    m["net_traffic"] = d["net_traffic"]
+                    m["io_volume"] = d["io_volume"]
+                elif c == "StreamData" and e == "close":
+                    m["shuffle_bytes"] += d["tx_net_bytes"] + d["tx_int_bytes"]
+                elif c == "ReadLinesNode" and e == "done":
+                    m["lines"] += d["total_lines"]
+    return m
+
+def sweep(args):
+    """run all configurations, returns the rows and the number of failures"""
+    os.makedirs(args.output, exist_ok=True)
+    rows = []
+    failures = 0
+
+    benches = parse_list(args.benchmarks, str)
+    if "tpch" in benches and not args.tpch_input:
+        print("scaling_sweep: no --tpch-input given, skipping tpch")
+        benches.remove("tpch")
+
+    for bench in benches:
+        sizes = [None] if bench == "tpch" else \
+            parse_list(args.pages if bench == "pagerank" else args.sizes,
+                       parse_size)
+        for net in parse_list(args.nets, str):
+            for hosts in parse_list(args.hosts):
+                for workers in parse_list(args.workers):
+                    cores = hosts * workers
+                    for base_size in sizes:
+                        for mode in parse_list(args.mode, str):
+                            # tpch has fixed input files
+                            if base_size is None and mode == "weak":
+                                continue
+                            size = base_size
+                            if size is not None and mode == "weak":
+                                size *= cores
+                            cmd, items = make_command(args, bench, size)
+                            for rep in range(args.repeats):
+                                name = "%s-%s-%s-h%d-w%d-s%s-r%d" % (
+                                    bench, mode, net, hosts, workers,
+                                    size, rep)
+                                log_prefix = os.path.join(args.output, name)
+                                print("scaling_sweep: running " + name)
+                                wall = run_once(args, net, hosts, workers,
+                                                cmd, log_prefix)
+                                if wall is None:
+                                    print("scaling_sweep: " + name + " failed")
+                                    failures += 1
+                                    continue
+                                m = parse_logs(log_prefix)
+                                if m["runtime"] is None:
+                                    print("scaling_sweep: " + name +
+                                          " wrote no Context summary")
+                                    failures += 1
+                                runtime = m["runtime"] or wall
+                                n = items if items is not None else m["lines"]
+                                rows.append({
+                                    "benchmark": bench, "mode": mode,
+                                    "net": net, "hosts": hosts,
+                                    "workers": workers, "cores": cores,
+                                    "size": size or 0, "repeat": rep,
+                                    "items": n, "runtime": runtime,
+                                    "wall": wall,
+                                    "items_per_core_second":
+                                        n / runtime / cores if runtime else 0,
+                                    "shuffle_bytes": m["shuffle_bytes"],
+                                    "shuffle_bytes_per_item":
+                                        m["shuffle_bytes"] / n if n else 0,
+                                    "net_traffic": m["net_traffic"],
+                                    "spill_bytes": m["io_volume"] })
+    return rows, failures
+
+##########################################################################
+# Output
+
+def write_csv(rows, path):
+    if not rows: return
+    with open(path, "w") as f:
+        w = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+        w.writeheader()
+        for r in rows: w.writerow(r)
+
+def plot(rows, output):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("scaling_sweep: matplotlib not found, only writing CSV")
+        return
+
+    metrics = [("items_per_core_second", "throughput per core [items/s]"),
+               ("shuffle_bytes_per_item", "shuffle bytes per item"),
+               ("spill_bytes", "spill volume [bytes]")]
+
+    for bench in sorted(set(r["benchmark"] for r in rows)):
+        for mode in sorted(set(r["mode"] for r in rows)):
+            sel = [r for r in rows
+                   if r["benchmark"] == bench and r["mode"] == mode]
+            if not sel: continue
+            fig, axes = plt.subplots(1, len(metrics),
+                                     figsize=(6 * len(metrics), 4.5))
+            for ax, (key, title) in zip(axes, metrics):
+                series = {}
+                for r in sel:
+                    label = "%s h=%d s=%s" % (r["net"], r["hosts"], r["size"])
+                    series.setdefault(label, {}).setdefault(
+                        r["cores"], []).append(r[key])
+                for label, pts in sorted(series.items()):
+                    xs = sorted(pts)
+                    # median of repetitions
+                    ys = [sorted(pts[x])[len(pts[x]) // 2] for x in xs]
+                    ax.plot(xs, ys, marker="o", label=label)
+                ax.set_xscale("log", base=2)
+                ax.set_xlabel("cores (hosts x workers)")
+                ax.set_title(title)
+                ax.grid(True)
+            axes[0].legend(fontsize="small")
+            fig.suptitle("%s, %s scaling" % (bench, mode))
+            fig.tight_layout()
+            path = os.path.join(output, "%s-%s.png" % (bench, mode))
+            fig.savefig(path)
+            plt.close(fig)
+            print("scaling_sweep: wrote " + path)
+
+def main():
+    p = argparse.ArgumentParser(
+        description="Run Thrill examples over hosts x workers x sizes and "
+        "plot their scaling.")
+    p.add_argument("--terasort", default="examples/terasort/terasort",
+                   help="path of terasort binary")
+    p.add_argument("--page-rank", default="examples/page_rank/page_rank_run",
+                   help="path of page_rank_run binary")
+    p.add_argument("--tpch", default="examples/tpch/tpch_run",
+                   help="path of tpch_run binary")
+    p.add_argument("--tpch-input", default="",
+                   help="input file pattern of tpch_run, tpch is skipped "
+                   "if empty")
+    p.add_argument("--benchmarks", default="terasort,pagerank,tpch",
+                   help="comma separated list, default: %(default)s")
+    p.add_argument("--nets", default="mock,local,tcp",
+                   help="networks: mock, local (TCP loopback in one "
+                   "process), tcp (one process per host), "
+                   "default: %(default)s")
+    p.add_argument("--hosts", default="1,2,4",
+                   help="numbers of hosts, default: %(default)s")
+    p.add_argument("--workers", default="1,2",
+                   help="numbers of workers per host, default: %(default)s")
+    p.add_argument("--sizes", default="64MiB",
+                   help="terasort input bytes, per core for weak scaling, "
+                   "default: %(default)s")
+    p.add_argument("--pages", default="100k",
+                   help="pagerank pages, per core for weak scaling, "
+                   "default: %(default)s")
+    p.add_argument("--iterations", type=int, default=10,
+                   help="pagerank iterations, default: %(default)s")
+    p.add_argument("--mode", default="strong,weak",
+                   help="strong and/or weak scaling, default: %(default)s")
+    p.add_argument("--repeats", type=int, default=1,
+                   help="repetitions of each run, default: %(default)s")
+    p.add_argument("--timeout", type=float, default=3600,
+                   help="seconds until a run is killed, default: %(default)s")
+    p.add_argument("-o", "--output", default="scaling_sweep",
+                   help="directory of logs, CSV and plots, "
+                   "default: %(default)s")
+    p.add_argument("--strict", action="store_true",
+                   help="fail if any run fails or its log is incomplete")
+    args = p.parse_args()
+
+    rows, failures = sweep(args)
+    if not rows:
+        print("scaling_sweep: no successful runs")
+        return 1
+
+    path = os.path.join(args.output, "results.csv")
+    write_csv(rows, path)
+    print("scaling_sweep: wrote " + path)
+    plot(rows, args.output)
+    return 1 if args.strict and failures != 0 else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
+
+##########################################################################
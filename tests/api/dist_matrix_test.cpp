@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * tests/api/dist_matrix_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/all_gather.hpp>
+#include <thrill/api/dist_matrix.hpp>
+#include <thrill/api/generate.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+using Row = std::vector<double>;
+
+static Row MakeRow(size_t i, size_t columns) {
+    Row row(columns);
+    for (size_t j = 0; j < columns; ++j)
+        row[j] = static_cast<double>((i * 7 + j * 3) % 11);
+    return row;
+}
+
+TEST(DistMatrix, GemvAndGemm) {
+    auto start_func =
+        [](Context& ctx) {
+            const size_t m = 123, n = 9;
+
+            DistMatrix<double> a(
+                Generate(ctx, m, [](size_t i) { return MakeRow(i, n); }), n);
+            ASSERT_EQ(m, a.rows());
+            ASSERT_EQ(n, a.columns());
+
+            // sequential reference
+            std::vector<Row> ref(m);
+            for (size_t i = 0; i < m; ++i) ref[i] = MakeRow(i, n);
+
+            ASSERT_EQ(ref, a.Rows().AllGather());
+
+            Row x(n);
+            for (size_t j = 0; j < n; ++j) x[j] = static_cast<double>(j + 1);
+
+            // y = A * x
+            Row y = a.Gemv(x);
+            ASSERT_EQ(m, y.size());
+            for (size_t i = 0; i < m; ++i) {
+                double sum = 0;
+                for (size_t j = 0; j < n; ++j) sum += ref[i][j] * x[j];
+                ASSERT_DOUBLE_EQ(sum, y[i]);
+            }
+
+            // gradient-like aggregation: transpose(A) * (A * x)
+            Row local_y = a.LocalGemv(x);
+            ASSERT_EQ(a.local().rows(), local_y.size());
+            Row z = a.TransposeGemv(local_y);
+            for (size_t j = 0; j < n; ++j) {
+                double sum = 0;
+                for (size_t i = 0; i < m; ++i) sum += ref[i][j] * y[i];
+                ASSERT_DOUBLE_EQ(sum, z[j]);
+            }
+
+            // C = A * B and the Gram matrix transpose(A) * C
+            common::Matrix<double> b(n, 2);
+            for (size_t j = 0; j < n; ++j) b(j, 0) = 1, b(j, 1) = x[j];
+
+            DistMatrix<double> c = a.Gemm(b);
+            ASSERT_EQ(m, c.rows());
+            ASSERT_EQ(a.row_begin(), c.row_begin());
+
+            common::Matrix<double> g = a.TransposeGemm(c);
+            ASSERT_EQ(n, g.rows());
+            ASSERT_EQ(2u, g.columns());
+            for (size_t j = 0; j < n; ++j)
+                ASSERT_DOUBLE_EQ(z[j], g(j, 1));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+/******************************************************************************/
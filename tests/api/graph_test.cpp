@@ -0,0 +1,122 @@
+/*******************************************************************************
+ * tests/api/graph_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/all_gather.hpp>
+#include <thrill/api/generate.hpp>
+#include <thrill/api/graph.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+using Edge = std::pair<size_t, size_t>;
+
+TEST(Graph, BreadthFirstSearch) {
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 1000;
+            const size_t inf = std::numeric_limits<size_t>::max();
+
+            // a path 0 -> 1 -> ... -> n-1 with shortcuts i -> 2i
+            auto edges = Generate(
+                ctx, 2 * n,
+                [n](size_t i) {
+                    if (i < n) return Edge(i, (i + 1) % n);
+                    i -= n;
+                    return Edge(i, (2 * i) % n);
+                });
+
+            Graph<size_t> graph(edges, n, inf);
+            if (graph.local_range().Contains(0))
+                graph.value(0) = 0;
+
+            size_t rounds = 0;
+            while (graph.Superstep(
+                       [](size_t, const size_t& dist, size_t, size_t& msg) {
+                           msg = dist + 1;
+                           return dist != std::numeric_limits<size_t>::max();
+                       },
+                       [](const size_t& a, const size_t& b) {
+                           return std::min(a, b);
+                       },
+                       [](size_t, size_t& dist, const size_t& msg) {
+                           if (msg >= dist) return false;
+                           dist = msg;
+                           return true;
+                       },
+                       inf) != 0) {
+                ASSERT_LT(++rounds, n);
+            }
+
+            std::vector<size_t> dist = graph.Vertices().AllGather();
+            ASSERT_EQ(n, dist.size());
+
+            // check against a sequential BFS
+            std::vector<size_t> check(n, inf);
+            std::vector<size_t> queue = { 0 };
+            check[0] = 0;
+            for (size_t q = 0; q < queue.size(); ++q) {
+                size_t v = queue[q];
+                for (size_t w : { (v + 1) % n, (2 * v) % n }) {
+                    if (check[w] != inf) continue;
+                    check[w] = check[v] + 1;
+                    queue.push_back(w);
+                }
+            }
+            ASSERT_EQ(check, dist);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Graph, PageRankSums) {
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 500;
+
+            // every vertex links to the next three vertices
+            auto edges = Generate(
+                ctx, 3 * n,
+                [n](size_t i) { return Edge(i / 3, (i / 3 + i % 3 + 1) % n); });
+
+            Graph<double> graph(edges, n, 1.0 / static_cast<double>(n));
+            for (size_t v = graph.local_range().begin;
+                 v < graph.local_range().end; ++v) {
+                ASSERT_EQ(3u, graph.out_degree(v));
+            }
+
+            for (size_t iter = 0; iter < 5; ++iter) {
+                graph.Superstep(
+                    [](size_t, const double& rank, size_t degree, double& msg) {
+                        msg = rank / static_cast<double>(degree);
+                        return degree != 0;
+                    },
+                    [](const double& a, const double& b) { return a + b; },
+                    [n](size_t, double& rank, const double& msg) {
+                        rank = 0.85 * msg + 0.15 / static_cast<double>(n);
+                        return true;
+                    },
+                    0.0);
+            }
+
+            // regular graph: the ranks stay uniform
+            std::vector<double> ranks = graph.Vertices().AllGather();
+            ASSERT_EQ(n, ranks.size());
+            for (const double& r : ranks)
+                ASSERT_NEAR(1.0 / static_cast<double>(n), r, 1e-12);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+/******************************************************************************/
@@ -11,9 +11,12 @@
 
 #include <thrill/api/all_gather.hpp>
 #include <thrill/api/generate.hpp>
+#include <thrill/api/group_by_accumulate.hpp>
 #include <thrill/api/group_by_key.hpp>
 #include <thrill/api/group_to_index.hpp>
+#include <thrill/api/reduce_by_key.hpp>
 #include <thrill/api/size.hpp>
+#include <thrill/api/sort.hpp>
 #include <thrill/api/sum.hpp>
 #include <thrill/common/logger.hpp>
 
@@ -21,8 +24,10 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <functional>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace thrill; // NOLINT
@@ -125,6 +130,331 @@ TEST(GroupByNode, Median) {
     api::RunLocalTests(start_func);
 }
 
+TEST(GroupByNode, ReadGroup) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 100000;
+            static constexpr size_t m = 10000;
+
+            auto sizets = Generate(ctx, n);
+
+            auto modulo_keyfn = [](size_t in) { return (in % m); };
+
+            // read each group into the iterator's reused vector
+            auto size_sum_fn =
+                [](auto& r, size_t key) {
+                    const std::vector<size_t>& group = r.ReadGroup();
+                    size_t sum = 0;
+                    for (const size_t& v : group) {
+                        EXPECT_EQ(key, v % m);
+                        sum += v;
+                    }
+                    EXPECT_FALSE(r.HasNext());
+                    return std::make_pair(group.size(), sum);
+                };
+
+            auto reduced =
+                sizets.GroupByKey<std::pair<size_t, size_t> >(
+                    modulo_keyfn, size_sum_fn);
+            std::vector<std::pair<size_t, size_t> > out_vec =
+                reduced.AllGather();
+
+            ASSERT_EQ(m, out_vec.size());
+            size_t total_size = 0, total_sum = 0;
+            for (const std::pair<size_t, size_t>& p : out_vec) {
+                ASSERT_EQ(n / m, p.first);
+                total_size += p.first, total_sum += p.second;
+            }
+            ASSERT_EQ(n, total_size);
+            ASSERT_EQ(n * (n - 1) / 2, total_sum);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(GroupByNode, LocalPhases) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 9999;
+            static constexpr size_t m = 31;
+
+            auto sizets = Generate(ctx, n);
+
+            auto modulo_keyfn = [](size_t in) { return (in % m); };
+
+            // check that all items of a group arrive together
+            auto sum_fn =
+                [](auto& r, size_t key) {
+                    size_t res = 0, count = 0;
+                    while (r.HasNext()) {
+                        size_t x = r.Next();
+                        die_unless(x % m == key);
+                        res += x;
+                        ++count;
+                    }
+                    return std::make_pair(res, count);
+                };
+
+            // compute vector with expected results
+            std::vector<std::pair<size_t, size_t> > res_vec(m);
+            for (size_t t = 0; t < n; ++t) {
+                res_vec[t % m].first += t;
+                res_vec[t % m].second++;
+            }
+            std::sort(res_vec.begin(), res_vec.end());
+
+            for (api::GroupByLocalPhase phase :
+                 { api::GroupByLocalPhase::SORT, api::GroupByLocalPhase::HASH,
+                   api::GroupByLocalPhase::AUTO })
+            {
+                api::DefaultGroupByConfig config;
+                config.local_phase_ = phase;
+
+                auto reduced = sizets.GroupByKey<std::pair<size_t, size_t> >(
+                    NoLocationDetectionTag, modulo_keyfn, sum_fn,
+                    std::hash<size_t>(), config);
+                std::vector<std::pair<size_t, size_t> > out_vec =
+                    reduced.AllGather();
+
+                std::sort(out_vec.begin(), out_vec.end());
+                ASSERT_EQ(res_vec, out_vec);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(GroupByNode, LocationDetectionHashCache) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 9999;
+            static constexpr size_t m = 31;
+
+            auto sizets = Generate(ctx, n);
+
+            auto modulo_keyfn = [](size_t in) { return (in % m); };
+
+            auto sum_fn =
+                [](auto& r, size_t key) {
+                    size_t res = 0, count = 0;
+                    while (r.HasNext()) {
+                        size_t x = r.Next();
+                        die_unless(x % m == key);
+                        res += x;
+                        ++count;
+                    }
+                    return std::make_pair(res, count);
+                };
+
+            // compute vector with expected results
+            std::vector<std::pair<size_t, size_t> > res_vec(m);
+            for (size_t t = 0; t < n; ++t) {
+                res_vec[t % m].first += t;
+                res_vec[t % m].second++;
+            }
+            std::sort(res_vec.begin(), res_vec.end());
+
+            for (bool use_hash_cache : { false, true })
+            {
+                api::DefaultGroupByConfig config;
+                config.use_hash_cache_ = use_hash_cache;
+
+                auto reduced = sizets.GroupByKey<std::pair<size_t, size_t> >(
+                    LocationDetectionTag, modulo_keyfn, sum_fn,
+                    std::hash<size_t>(), config);
+                std::vector<std::pair<size_t, size_t> > out_vec =
+                    reduced.AllGather();
+
+                std::sort(out_vec.begin(), out_vec.end());
+                ASSERT_EQ(res_vec, out_vec);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(GroupByNode, PostThread) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 99999;
+            static constexpr size_t m = 31;
+
+            auto sizets = Generate(ctx, n);
+
+            auto modulo_keyfn = [](size_t in) { return (in % m); };
+
+            auto sum_fn =
+                [](auto& r, size_t key) {
+                    size_t res = 0, count = 0;
+                    while (r.HasNext()) {
+                        size_t x = r.Next();
+                        die_unless(x % m == key);
+                        res += x;
+                        ++count;
+                    }
+                    return std::make_pair(res, count);
+                };
+
+            // compute vector with expected results
+            std::vector<std::pair<size_t, size_t> > res_vec(m);
+            for (size_t t = 0; t < n; ++t) {
+                res_vec[t % m].first += t;
+                res_vec[t % m].second++;
+            }
+            std::sort(res_vec.begin(), res_vec.end());
+
+            for (api::GroupByLocalPhase phase :
+                 { api::GroupByLocalPhase::SORT, api::GroupByLocalPhase::HASH })
+            {
+                api::DefaultGroupByConfig config;
+                config.local_phase_ = phase;
+                config.use_post_thread_ = true;
+
+                // the items are received while Generate() pushes them
+                auto reduced = sizets.GroupByKey<std::pair<size_t, size_t> >(
+                    NoLocationDetectionTag, modulo_keyfn, sum_fn,
+                    std::hash<size_t>(), config);
+                std::vector<std::pair<size_t, size_t> > out_vec =
+                    reduced.AllGather();
+
+                std::sort(out_vec.begin(), out_vec.end());
+                ASSERT_EQ(res_vec, out_vec);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(GroupByNode, PartitionedInput) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 9999;
+            // few keys, such that keys span several workers after Sort()
+            static constexpr size_t m = 7;
+
+            auto sizets = Generate(
+                ctx, n, [n](size_t i) { return (i * 7919) % n; });
+
+            auto div_keyfn = [](size_t in) { return in / (9999 / m + 1); };
+
+            // check that all items of a group arrive together
+            auto sum_fn =
+                [](auto& r, size_t key) {
+                    size_t res = 0, count = 0;
+                    while (r.HasNext()) {
+                        size_t x = r.Next();
+                        die_unless(x / (9999 / m + 1) == key);
+                        res += x;
+                        ++count;
+                    }
+                    return std::make_pair(res, count);
+                };
+
+            // compute vector with expected results
+            std::vector<std::pair<size_t, size_t> > res_vec(m);
+            for (size_t t = 0; t < n; ++t) {
+                res_vec[t / (n / m + 1)].first += t;
+                res_vec[t / (n / m + 1)].second++;
+            }
+            std::sort(res_vec.begin(), res_vec.end());
+
+            // range partitioned: group only the keys spanning workers
+            auto sorted = sizets.Sort(api::LessByKey(div_keyfn));
+            ASSERT_EQ(api::DIAPartitioning::Type::RANGE,
+                      sorted.partitioning().type());
+            ASSERT_TRUE(sorted.partitioning().IsRange<decltype(div_keyfn)>());
+
+            std::vector<std::pair<size_t, size_t> > out_vec =
+                sorted.GroupByKey<std::pair<size_t, size_t> >(div_keyfn, sum_fn)
+                .AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+            ASSERT_EQ(res_vec, out_vec);
+
+            // hash partitioned: group locally, also after a Filter()
+            auto reduced = sizets.ReduceByKey(
+                div_keyfn, [](size_t a, size_t b) { return std::max(a, b); });
+            auto filtered = reduced.Filter([](size_t) { return true; });
+            ASSERT_TRUE(filtered.partitioning().IsHash<decltype(div_keyfn)>());
+            ASSERT_EQ(api::DIAPartitioning::Type::NONE,
+                      reduced.Map([](size_t x) { return x; })
+                      .partitioning().type());
+
+            out_vec = filtered.GroupByKey<std::pair<size_t, size_t> >(
+                div_keyfn, sum_fn).AllGather();
+            ASSERT_EQ(m, out_vec.size());
+            for (const std::pair<size_t, size_t>& p : out_vec)
+                ASSERT_EQ(1u, p.second);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+//! accumulator keeping the three largest values of each key
+class TopThreeAccumulator
+{
+public:
+    using State = std::vector<size_t>;
+
+    State Init(const size_t& /* key */) const { return State(); }
+
+    void Add(State& state, const size_t& value) const {
+        state.push_back(value);
+        Trim(state);
+    }
+
+    void Merge(State& state, const State& other) const {
+        state.insert(state.end(), other.begin(), other.end());
+        Trim(state);
+    }
+
+    std::pair<size_t, State> Finish(const size_t& key, const State& state) const {
+        return std::make_pair(key, state);
+    }
+
+private:
+    void Trim(State& state) const {
+        std::sort(state.begin(), state.end(), std::greater<size_t>());
+        if (state.size() > 3) state.resize(3);
+    }
+};
+
+TEST(GroupByNode, AccumulateTopThree) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 9999;
+            static constexpr size_t m = 31;
+
+            auto sizets = Generate(ctx, n);
+
+            auto modulo_keyfn = [](size_t in) { return (in % m); };
+
+            auto top = sizets.GroupByAccumulate(
+                modulo_keyfn, TopThreeAccumulator());
+            std::vector<std::pair<size_t, std::vector<size_t> > > out_vec =
+                top.AllGather();
+
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(m, out_vec.size());
+            for (size_t k = 0; k < m; ++k) {
+                // largest values t < n with t % m == k
+                size_t last = (n - 1) - ((n - 1 - k) % m);
+                ASSERT_EQ(k, out_vec[k].first);
+                ASSERT_EQ(std::vector<size_t>(
+                              { last, last - m, last - 2 * m }),
+                          out_vec[k].second);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(GroupByNode, GroupToIndexCorrectResults) {
 
     auto start_func =
@@ -9,6 +9,7 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
+#include <thrill/api/all_gather.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/hyperloglog.hpp>
 #include <tlx/math/clz.hpp>
@@ -16,6 +17,7 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <random>
 #include <string>
@@ -148,6 +150,39 @@ TEST(Operations, encodeHash) {
     ASSERT_EQ(manualEncoded, encoded);
 }
 
+TEST(Operations, HyperLogLogByKey) {
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 100000;
+
+            // key i % 4 has (i % 4 + 1) * 1000 distinct values
+            auto counts =
+                Generate(
+                    ctx, n,
+                    [](const size_t& i) {
+                        size_t key = i % 4;
+                        return std::make_pair(key, (i / 4) % ((key + 1) * 1000));
+                    })
+                .HyperLogLogByKey<10>(
+                    [](const std::pair<size_t, size_t>& p) { return p.first; })
+                .Map([](std::pair<size_t, core::HyperLogLogRegisters<10> > p) {
+                         return std::make_pair(p.first, p.second.result());
+                     })
+                .AllGather();
+
+            ASSERT_EQ(4u, counts.size());
+            std::sort(counts.begin(), counts.end());
+
+            for (size_t key = 0; key < 4; ++key) {
+                ASSERT_EQ(key, counts[key].first);
+                double distinct = (key + 1) * 1000.0;
+                ASSERT_LT(std::abs(relativeError(distinct, counts[key].second)),
+                          0.1);
+            }
+        };
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, decodeHash) {
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -202,4 +237,29 @@ TEST(Operations, sparseListEncoding) {
     }
 }
 
+TEST(Operations, HyperLogLogMerge) {
+    std::mt19937_64 gen(1234);
+    // sizes which yield sparse and dense registers
+    for (size_t na : { 10, 300, 5000 }) {
+        for (size_t nb : { 7, 400, 20000 }) {
+            core::HyperLogLogRegisters<10> a, b, all;
+            for (size_t i = 0; i < na; ++i) {
+                uint64_t hash = gen();
+                a.insert_hash(hash), all.insert_hash(hash);
+            }
+            for (size_t i = 0; i < nb; ++i) {
+                uint64_t hash = gen();
+                b.insert_hash(hash), all.insert_hash(hash);
+            }
+
+            // merging must yield the same registers as inserting all hashes
+            core::HyperLogLogRegisters<10> ab = a + b, ba = b + a;
+            double expected = all.result();
+            ASSERT_DOUBLE_EQ(expected, ab.result());
+            ASSERT_DOUBLE_EQ(expected, ba.result());
+            ASSERT_LT(std::abs(relativeError(na + nb, expected)), 0.1);
+        }
+    }
+}
+
 /******************************************************************************/
@@ -9,14 +9,20 @@
  ******************************************************************************/
 
 #include <thrill/api/all_gather.hpp>
+#include <thrill/api/cache.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/inner_join.hpp>
+#include <thrill/api/merge_join.hpp>
+#include <thrill/api/multiway_join.hpp>
+#include <thrill/api/semi_join.hpp>
+#include <thrill/api/sort.hpp>
 #include <thrill/api/sum.hpp>
 #include <thrill/common/logger.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <limits>
 #include <string>
@@ -168,6 +174,267 @@ TEST(Join, PairsSameKeyDiffSizes) {
     api::RunLocalTests(start_func);
 }
 
+//! join a large first DIA with a small second, which is broadcast, with the
+//! default config, hence a local hash join, and with a sort-merge join.
+TEST(Join, PairsUniqueBroadcastSecond) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            size_t n = 9999;
+            size_t m = 100;
+
+            auto dia1 = Generate(ctx, n, [](const size_t& e) {
+                                     return std::make_pair(e, e * e);
+                                 });
+
+            auto dia2 = Generate(ctx, m, [](const size_t& e) {
+                                     return std::make_pair(3 * e, e);
+                                 });
+
+            auto key_ex = [](const IntPair& input) {
+                              return input.first;
+                          };
+
+            auto join_fn = [](const IntPair& input1, const IntPair& input2) {
+                               return std::make_pair(input1.second,
+                                                     input2.second);
+                           };
+
+            api::DefaultJoinConfig broadcast;
+            broadcast.broadcast_max_bytes_ = 8 * 1024 * 1024;
+
+            api::DefaultJoinConfig sort_merge;
+            sort_merge.use_hash_join_ = false;
+
+            for (const api::DefaultJoinConfig& config :
+                 { broadcast, api::DefaultJoinConfig(), sort_merge })
+            {
+                auto joined = InnerJoin(
+                    LocationDetectionTag, dia1, dia2, key_ex, key_ex, join_fn,
+                    std::hash<size_t>(), config);
+                std::vector<IntPair> out_vec = joined.AllGather();
+
+                std::sort(out_vec.begin(), out_vec.end(),
+                          [](const IntPair& in1, const IntPair& in2) {
+                              return in1.second < in2.second;
+                          });
+
+                ASSERT_EQ(m, out_vec.size());
+                for (size_t i = 0; i < out_vec.size(); i++) {
+                    ASSERT_EQ(std::make_pair(9 * i * i, i), out_vec[i]);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+//! join a large first DIA with a small second, filtering either DIA by the
+//! keys of the other with a semi-join filter.
+TEST(Join, PairsUniqueSemiJoinFilter) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            size_t n = 9999;
+            size_t m = 100;
+
+            auto dia1 = Generate(ctx, n, [](const size_t& e) {
+                                     return std::make_pair(e, e * e);
+                                 });
+
+            auto dia2 = Generate(ctx, m, [](const size_t& e) {
+                                     return std::make_pair(3 * e, e);
+                                 });
+
+            auto key_ex = [](const IntPair& input) {
+                              return input.first;
+                          };
+
+            auto join_fn = [](const IntPair& input1, const IntPair& input2) {
+                               return std::make_pair(input1.second,
+                                                     input2.second);
+                           };
+
+            for (size_t side : { 1, 2 })
+            {
+                api::DefaultJoinConfig config;
+                config.semi_join_filter_ = side;
+
+                auto joined = InnerJoin(
+                    NoLocationDetectionTag, dia1, dia2, key_ex, key_ex, join_fn,
+                    std::hash<size_t>(), config);
+                std::vector<IntPair> out_vec = joined.AllGather();
+
+                std::sort(out_vec.begin(), out_vec.end(),
+                          [](const IntPair& in1, const IntPair& in2) {
+                              return in1.second < in2.second;
+                          });
+
+                ASSERT_EQ(m, out_vec.size());
+                for (size_t i = 0; i < out_vec.size(); i++) {
+                    ASSERT_EQ(std::make_pair(9 * i * i, i), out_vec[i]);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+//! join a first DIA in which half of the items have the same key, which is
+//! detected as heavy hitter, with a second DIA.
+TEST(Join, PairsSkewedHeavyHitters) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            size_t n = 9999;
+            size_t m = 100;
+
+            auto dia1 = Generate(ctx, n, [](const size_t& e) {
+                                     return std::make_pair(
+                                         e % 2 == 0 ? 0 : e, e);
+                                 });
+
+            auto dia2 = Generate(ctx, m, [](const size_t& e) {
+                                     return std::make_pair(e, e);
+                                 });
+
+            auto key_ex = [](const IntPair& input) {
+                              return input.first;
+                          };
+
+            auto join_fn = [](const IntPair& input1, const IntPair& input2) {
+                               return std::make_pair(input1.second,
+                                                     input2.second);
+                           };
+
+            api::DefaultJoinConfig config;
+            config.use_heavy_hitters_ = true;
+
+            auto joined = InnerJoin(
+                LocationDetectionTag, dia1, dia2, key_ex, key_ex, join_fn,
+                std::hash<size_t>(), config);
+            std::vector<IntPair> out_vec = joined.AllGather();
+
+            std::sort(out_vec.begin(), out_vec.end());
+
+            // all even items of dia1 join with key 0, and the odd keys < m
+            std::vector<IntPair> expected;
+            for (size_t e = 0; e < n; ++e) {
+                if (e % 2 == 0)
+                    expected.emplace_back(e, 0);
+                else if (e < m)
+                    expected.emplace_back(e, e);
+            }
+            std::sort(expected.begin(), expected.end());
+
+            ASSERT_EQ(expected, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Join, MergeJoinSorted) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            size_t n = 9999, m = 3333;
+
+            // sorted by key, with keys spanning workers
+            auto dia1 = Generate(ctx, n, [](const size_t& e) {
+                                     return std::make_pair(e / 7, e);
+                                 });
+
+            // sorted in reverse, then by key
+            auto dia2 = Generate(ctx, m, [m](const size_t& e) {
+                                     return std::make_pair((m - 1 - e) / 3, e);
+                                 });
+
+            auto key_ex = [](const IntPair& input) {
+                              return input.first;
+                          };
+
+            auto join_fn = [](const IntPair& input1, const IntPair& input2) {
+                               return std::make_pair(input1.second,
+                                                     input2.second);
+                           };
+
+            auto joined = dia1.MergeJoin(
+                dia2.Sort(api::LessByKey(key_ex)), key_ex, key_ex, join_fn);
+            std::vector<IntPair> out_vec = joined.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            std::vector<std::vector<size_t> > by_key(m / 3 + 1);
+            for (size_t j = 0; j < m; ++j)
+                by_key[(m - 1 - j) / 3].push_back(j);
+
+            std::vector<IntPair> res_vec;
+            for (size_t i = 0; i < n && i / 7 < by_key.size(); ++i) {
+                for (const size_t& j : by_key[i / 7])
+                    res_vec.emplace_back(i, j);
+            }
+            std::sort(res_vec.begin(), res_vec.end());
+
+            ASSERT_EQ(res_vec, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Join, SemiJoinAndAntiJoin) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using IntPair = std::pair<size_t, size_t>;
+
+            size_t n = 9999, m = 999;
+
+            auto dia1 = Generate(ctx, n, [](const size_t& e) {
+                                     return std::make_pair(e % 1000, e);
+                                 });
+
+            // keys divisible by 3, with duplicates
+            auto dia2 = Generate(ctx, m, [](const size_t& e) {
+                                     return (e * 3) % 1500;
+                                 });
+
+            auto key_ex1 = [](const IntPair& input) { return input.first; };
+            auto key_ex2 = [](const size_t& input) { return input; };
+
+            for (bool use_filter : { false, true }) {
+                api::DefaultSemiJoinConfig config;
+                config.use_filter_ = use_filter;
+
+                std::vector<IntPair> semi = dia1.SemiJoin(
+                    dia2, key_ex1, key_ex2, std::hash<size_t>(), config)
+                                            .AllGather();
+                std::vector<IntPair> anti = dia1.AntiJoin(
+                    dia2, key_ex1, key_ex2, std::hash<size_t>(), config)
+                                            .AllGather();
+
+                ASSERT_EQ(n, semi.size() + anti.size());
+                for (const IntPair& p : semi)
+                    ASSERT_EQ(0u, p.first % 3);
+                for (const IntPair& p : anti)
+                    ASSERT_NE(0u, p.first % 3);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Join, DifferentTypes) {
 
     auto start_func =
@@ -220,4 +487,79 @@ TEST(Join, DifferentTypes) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Join, MultiwayJoinTriangles) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using Edge = std::pair<size_t, size_t>;
+            using Triangle = std::tuple<size_t, size_t, size_t>;
+
+            size_t n = 120;
+            auto is_edge = [](size_t u, size_t v) {
+                               return u < v && (u * 31 + v * 17) % 5 == 0;
+                           };
+
+            auto edges = Generate(
+                ctx, n * n,
+                [n](const size_t& i) { return Edge(i / n, i % n); })
+                         .Filter([is_edge](const Edge& e) {
+                                     return is_edge(e.first, e.second);
+                                 })
+                         .Cache();
+
+            // triangles (a,b,c) with a < b < c of the relations R(a,b),
+            // S(b,c) and T(a,c), all three being the edges.
+            using Coordinates = std::array<size_t, 3>;
+            auto coordinates = std::make_tuple(
+                [](const Edge& e) {
+                    return Coordinates { { e.first, e.second, api::kJoinAnyCoordinate } };
+                },
+                [](const Edge& e) {
+                    return Coordinates { { api::kJoinAnyCoordinate, e.first, e.second } };
+                },
+                [](const Edge& e) {
+                    return Coordinates { { e.first, api::kJoinAnyCoordinate, e.second } };
+                });
+
+            auto join_fn =
+                [](const std::vector<Edge>& r, const std::vector<Edge>& s,
+                   const std::vector<Edge>& t, auto emit) {
+                    std::vector<Edge> t_sorted = t;
+                    std::sort(t_sorted.begin(), t_sorted.end());
+                    for (const Edge& ab : r) {
+                        for (const Edge& bc : s) {
+                            if (bc.first != ab.second) continue;
+                            if (std::binary_search(
+                                    t_sorted.begin(), t_sorted.end(),
+                                    Edge(ab.first, bc.second))) {
+                                emit(Triangle(ab.first, ab.second, bc.second));
+                            }
+                        }
+                    }
+                };
+
+            std::vector<Triangle> out_vec =
+                MultiwayJoin<Triangle>(coordinates, join_fn, edges, edges, edges)
+                .AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            std::vector<Triangle> check;
+            for (size_t a = 0; a < n; ++a) {
+                for (size_t b = a + 1; b < n; ++b) {
+                    if (!is_edge(a, b)) continue;
+                    for (size_t c = b + 1; c < n; ++c) {
+                        if (is_edge(b, c) && is_edge(a, c))
+                            check.emplace_back(a, b, c);
+                    }
+                }
+            }
+
+            ASSERT_LT(0u, check.size());
+            ASSERT_EQ(check, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 /******************************************************************************/
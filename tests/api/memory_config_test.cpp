@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * tests/api/memory_config_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/api/context.hpp>
+#include <thrill/data/block.hpp>
+#include <thrill/data/file.hpp>
+#include <thrill/vfs/temporary_directory.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+using namespace thrill;
+
+static constexpr size_t ram = 1024 * 1024 * 1024llu;
+
+// this runs in its own test program, since autotune() changes the global
+// default block and prefetch sizes.
+class MemoryConfig : public ::testing::Test
+{
+protected:
+    void SetUp() final {
+        block_size_ = data::default_block_size;
+        prefetch_size_ = data::File::default_prefetch_size_;
+        setenv("THRILL_DISKS", disk_.get().c_str(), /* overwrite */ 1);
+    }
+
+    void TearDown() final {
+        data::default_block_size = block_size_;
+        data::File::default_prefetch_size_ = prefetch_size_;
+        unsetenv("THRILL_DISKS");
+        unsetenv("THRILL_AUTOTUNE");
+        unsetenv("THRILL_RAM");
+    }
+
+    vfs::TemporaryDirectory disk_;
+    size_t block_size_, prefetch_size_;
+};
+
+//! check that apply() divided the RAM by the configured fractions
+static void CheckRamSplit(const api::MemoryConfig& mem_config) {
+    ASSERT_EQ(static_cast<size_t>(ram * mem_config.workers_fraction_),
+              mem_config.ram_workers_);
+    ASSERT_EQ(static_cast<size_t>(ram * mem_config.block_pool_fraction_),
+              mem_config.ram_block_pool_hard_ +
+              mem_config.ram_block_pool_compressed_);
+    ASSERT_EQ(ram, mem_config.ram_block_pool_hard_ +
+              mem_config.ram_block_pool_compressed_ +
+              mem_config.ram_workers_ + mem_config.ram_floating_);
+}
+
+TEST_F(MemoryConfig, AutotuneMeasuresDisk) {
+    api::MemoryConfig mem_config;
+    mem_config.verbose_ = false;
+    mem_config.ram_ = ram;
+    mem_config.autotune();
+    mem_config.apply();
+
+    ASSERT_LT(0.0, mem_config.mem_bandwidth_);
+    ASSERT_LT(0.0, mem_config.disk_bandwidth_);
+    ASSERT_LT(0.0, mem_config.disk_latency_);
+
+    // a power of two covering four latencies, within the bounds
+    size_t block_size = data::default_block_size;
+    ASSERT_EQ(0u, block_size & (block_size - 1));
+    ASSERT_LE(256 * 1024u, block_size);
+    ASSERT_GE(16 * 1024 * 1024u, block_size);
+    if (block_size < 16 * 1024 * 1024u) {
+        ASSERT_GE(static_cast<double>(block_size),
+                  4 * mem_config.disk_bandwidth_ * mem_config.disk_latency_);
+    }
+
+    // two blocks on the single disk
+    ASSERT_EQ(2 * block_size, data::File::default_prefetch_size_);
+
+    if (mem_config.disk_bandwidth_ < 512.0 * 1024 * 1024) {
+        ASSERT_DOUBLE_EQ(1.0 / 2.0, mem_config.block_pool_fraction_);
+        ASSERT_DOUBLE_EQ(1.0 / 4.0, mem_config.workers_fraction_);
+    }
+    else {
+        ASSERT_DOUBLE_EQ(1.0 / 3.0, mem_config.block_pool_fraction_);
+        ASSERT_DOUBLE_EQ(1.0 / 3.0, mem_config.workers_fraction_);
+    }
+    CheckRamSplit(mem_config);
+}
+
+TEST_F(MemoryConfig, AutotuneKeepsDefaultsWithoutDisk) {
+    // a file given as disk is never written to
+    std::string file = disk_.get() + "/disk";
+    std::ofstream(file) << "data";
+    setenv("THRILL_DISKS", file.c_str(), /* overwrite */ 1);
+
+    api::MemoryConfig mem_config;
+    mem_config.verbose_ = false;
+    mem_config.setup(ram);
+    mem_config.autotune();
+    mem_config.apply();
+
+    ASSERT_LT(0.0, mem_config.mem_bandwidth_);
+    ASSERT_EQ(0.0, mem_config.disk_bandwidth_);
+    ASSERT_EQ(0.0, mem_config.disk_latency_);
+
+    ASSERT_EQ(block_size_, data::default_block_size);
+    ASSERT_EQ(prefetch_size_, data::File::default_prefetch_size_);
+    ASSERT_DOUBLE_EQ(1.0 / 3.0, mem_config.block_pool_fraction_);
+    ASSERT_DOUBLE_EQ(1.0 / 3.0, mem_config.workers_fraction_);
+    CheckRamSplit(mem_config);
+
+    std::ifstream in(file);
+    std::string content;
+    in >> content;
+    ASSERT_EQ("data", content);
+}
+
+TEST_F(MemoryConfig, SetupDetectRunsAutotuneOnlyIfEnabled) {
+    setenv("THRILL_RAM", "1GiB", /* overwrite */ 1);
+
+    {
+        setenv("THRILL_AUTOTUNE", "0", /* overwrite */ 1);
+        api::MemoryConfig mem_config;
+        mem_config.verbose_ = false;
+        ASSERT_EQ(0, mem_config.setup_detect());
+        ASSERT_EQ(ram, mem_config.ram_);
+        ASSERT_EQ(0.0, mem_config.mem_bandwidth_);
+        ASSERT_EQ(block_size_, data::default_block_size);
+        CheckRamSplit(mem_config);
+    }
+    {
+        setenv("THRILL_AUTOTUNE", "1", /* overwrite */ 1);
+        api::MemoryConfig mem_config;
+        mem_config.verbose_ = false;
+        ASSERT_EQ(0, mem_config.setup_detect());
+        ASSERT_LT(0.0, mem_config.mem_bandwidth_);
+        ASSERT_LT(0.0, mem_config.disk_bandwidth_);
+        ASSERT_EQ(2 * data::default_block_size,
+                  data::File::default_prefetch_size_);
+        CheckRamSplit(mem_config);
+    }
+}
+
+/******************************************************************************/
@@ -179,4 +179,115 @@ TEST(MergeNode, TwoIntegerArraysOfDifferentSize) {
     api::RunLocalTests(start_func);
 }
 
+//! Merge and check that every worker received its exact share up to the
+//! accuracy of the splitter selection of kNumInputs + 1 ranks on each side.
+template <typename InputA, typename... MoreInputs>
+void DoMergeAndCheckTightBalance(
+    const std::vector<size_t>& expected,
+    const InputA& merge_input1, const MoreInputs& ... merge_inputs) {
+
+    Context& ctx = merge_input1.context();
+    size_t num_inputs = 1 + sizeof ... (MoreInputs);
+
+    auto merge_result = Merge(
+        std::less<size_t>(), merge_input1, merge_inputs...);
+
+    size_t count = 0;
+    auto res = merge_result
+               .Map([&count](size_t in) { count++; return in; })
+               .AllGather();
+
+    ASSERT_EQ(expected, res);
+
+    // the target rank of worker r is r * (n / p) + min(r, n % p)
+    size_t n = res.size(), p = ctx.num_workers(), r = ctx.my_rank();
+    size_t expected_count = n / p + (r < n % p ? 1 : 0);
+    ASSERT_LE(tlx::abs_diff(expected_count, count), 2 * (num_inputs + 1));
+}
+
+//! sorted values with random gaps, tagged in the low two bits such that the
+//! inputs do not share values.
+static std::vector<size_t> RandomSortedValues(
+    size_t size, size_t max_gap, size_t tag, size_t seed) {
+    std::default_random_engine rng(seed);
+    std::vector<size_t> values(size);
+    size_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+        value += 1 + rng() % max_gap;
+        values[i] = value * 4 + tag;
+    }
+    return values;
+}
+
+TEST(MergeNode, FourSkewedArrays) {
+
+    static constexpr size_t test_size = 20000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // dense, sparse, clustered at the end, and a few items which leave
+            // most workers' ranges empty.
+            std::vector<std::vector<size_t> > values = {
+                RandomSortedValues(test_size, 4, 0, 1),
+                RandomSortedValues(test_size / 10, 1000, 1, 2),
+                RandomSortedValues(test_size * 2, 2, 2, 3),
+                RandomSortedValues(3, 100000, 3, 4)
+            };
+            for (size_t& v : values[2]) v += 4 * 1000000;
+
+            auto generate =
+                [&ctx, &values](size_t q) {
+                    const std::vector<size_t>& vec = values[q];
+                    return Generate(
+                        ctx, vec.size(),
+                        [&vec](size_t index) { return vec[index]; });
+                };
+
+            std::vector<size_t> expected;
+            for (const std::vector<size_t>& vec : values)
+                expected.insert(expected.end(), vec.begin(), vec.end());
+            std::sort(expected.begin(), expected.end());
+
+            DoMergeAndCheckTightBalance(
+                expected, generate(0), generate(1), generate(2), generate(3));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(MergeNode, TwoRandomArraysOnManyWorkers) {
+
+    static constexpr size_t test_size = 50000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::vector<size_t> values1 =
+                RandomSortedValues(test_size, 16, 0, 5);
+            std::vector<size_t> values2 =
+                RandomSortedValues(test_size / 2, 32, 1, 6);
+
+            auto merge_input1 = Generate(
+                ctx, values1.size(),
+                [&values1](size_t index) { return values1[index]; });
+            auto merge_input2 = Generate(
+                ctx, values2.size(),
+                [&values2](size_t index) { return values2[index]; });
+
+            std::vector<size_t> expected = values1;
+            expected.insert(expected.end(), values2.begin(), values2.end());
+            std::sort(expected.begin(), expected.end());
+
+            DoMergeAndCheckTightBalance(expected, merge_input1, merge_input2);
+        };
+
+    // set fixed amount of RAM for testing
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    // 31 splitters, each selected concurrently
+    api::RunLocalMock(mem_config, 4, 8, start_func);
+}
+
 /******************************************************************************/
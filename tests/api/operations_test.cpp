@@ -10,35 +10,50 @@
  ******************************************************************************/
 
 #include <thrill/api/all_gather.hpp>
+#include <thrill/api/approx.hpp>
 #include <thrill/api/bernoulli_sample.hpp>
 #include <thrill/api/cache.hpp>
 #include <thrill/api/collapse.hpp>
 #include <thrill/api/concat.hpp>
 #include <thrill/api/concat_to_dia.hpp>
+#include <thrill/api/delta_iterate.hpp>
 #include <thrill/api/distribute.hpp>
 #include <thrill/api/equal_to_dia.hpp>
 #include <thrill/api/ex_prefix_sum.hpp>
 #include <thrill/api/gather.hpp>
 #include <thrill/api/generate.hpp>
+#include <thrill/api/iterate.hpp>
+#include <thrill/api/job_scheduler.hpp>
+#include <thrill/api/map_partitions.hpp>
 #include <thrill/api/max.hpp>
 #include <thrill/api/min.hpp>
 #include <thrill/api/prefix_sum.hpp>
 #include <thrill/api/print.hpp>
+#include <thrill/api/quantiles.hpp>
 #include <thrill/api/read_lines.hpp>
 #include <thrill/api/rebalance.hpp>
+#include <thrill/api/reduce_local.hpp>
+#include <thrill/api/repartition.hpp>
 #include <thrill/api/sample.hpp>
+#include <thrill/api/segmented_prefix_sum.hpp>
 #include <thrill/api/size.hpp>
 #include <thrill/api/sort.hpp>
 #include <thrill/api/sum.hpp>
+#include <thrill/api/top_k.hpp>
 #include <thrill/api/union.hpp>
+#include <thrill/api/weighted_sample.hpp>
 #include <thrill/api/window.hpp>
+#include <thrill/api/zip.hpp>
 
 #include <tlx/string/join_generic.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
+#include <map>
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
@@ -169,6 +184,47 @@ TEST(Operations, DistributeAndAllGatherElements) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, AllGatherUnevenStringsSeveralWorkersPerHost) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // every third worker is empty, the others hold a growing number of
+            // strings which together span many blocks.
+            auto local_strings =
+                [](size_t rank) {
+                    std::vector<std::string> vec;
+                    if (rank % 3 == 1) return vec;
+                    for (size_t i = 0; i < 500 * (rank + 1); ++i) {
+                        vec.emplace_back(
+                            std::to_string(rank) + ":" + std::to_string(i) +
+                            std::string(i % 300, 'a' + rank % 26));
+                    }
+                    return vec;
+                };
+
+            std::vector<std::string> expected;
+            for (size_t r = 0; r < ctx.num_workers(); ++r) {
+                std::vector<std::string> vec = local_strings(r);
+                expected.insert(expected.end(), vec.begin(), vec.end());
+            }
+
+            DIA<std::string> strings =
+                ConcatToDIA(ctx, local_strings(ctx.my_rank())).Collapse();
+
+            // once from the pushed items and once from the cached File's blocks
+            ASSERT_EQ(expected, strings.Keep().AllGather());
+            ASSERT_EQ(expected, strings.Cache().AllGather());
+        };
+
+    api::RunLocalTests(start_func);
+
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 4, start_func);
+}
+
 TEST(Operations, EqualToDIAAndGatherElements) {
 
     auto start_func =
@@ -207,6 +263,37 @@ TEST(Operations, EqualToDIAAndGatherElements) {
     api::RunLocalTests(start_func);
 }
 
+#if THRILL_HAVE_ZLIB
+TEST(Operations, GenerateStringsCacheCompressed) {
+
+    static constexpr size_t test_size = 100000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            CacheOptions options;
+            options.codec = "zlib";
+
+            auto strings = Generate(
+                ctx, test_size,
+                [](const size_t& index) {
+                    return "item " + std::to_string(index);
+                });
+            auto cached = strings.Cache(options).Keep();
+
+            // read the compressed cache twice
+            for (size_t r = 0; r < 2; ++r) {
+                std::vector<std::string> out_vec = cached.AllGather();
+                ASSERT_EQ(test_size, out_vec.size());
+                for (size_t i = 0; i < out_vec.size(); ++i)
+                    ASSERT_EQ("item " + std::to_string(i), out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+#endif // THRILL_HAVE_ZLIB
+
 TEST(Operations, GenerateIntegers) {
 
     static constexpr size_t test_size = 1000;
@@ -230,6 +317,130 @@ TEST(Operations, GenerateIntegers) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, GenerateIntegersAllGatherShared) {
+
+    static constexpr size_t test_size = 1000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx, test_size,
+                [](const size_t& index) { return index; });
+
+            std::shared_ptr<const std::vector<size_t> > out_vec =
+                integers.AllGatherShared();
+
+            ASSERT_EQ(test_size, out_vec->size());
+
+            for (size_t i = 0; i < test_size; ++i) {
+                ASSERT_EQ(i, (*out_vec)[i]);
+            }
+
+            // all workers of a host share the same vector
+            const void* ptr = out_vec.get();
+            ASSERT_EQ(ptr, ctx.net.LocalBroadcast(ptr));
+
+            // broadcast a lookup table from the last worker
+            std::vector<size_t> table;
+            if (ctx.my_rank() == ctx.num_workers() - 1)
+                table = { 1, 2, 3, ctx.my_rank() };
+
+            std::shared_ptr<const std::vector<size_t> > shared =
+                ctx.Broadcast(table, ctx.num_workers() - 1);
+
+            ASSERT_EQ(std::vector<size_t>(
+                          { 1, 2, 3, ctx.num_workers() - 1 }), *shared);
+
+            ptr = shared.get();
+            ASSERT_EQ(ptr, ctx.net.LocalBroadcast(ptr));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, GenerateUnorderedIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            for (size_t test_size : { size_t(0), size_t(3), size_t(10000) }) {
+                auto integers = Generate(
+                    ctx, UnorderedTag, test_size,
+                    [](const size_t& index) { return index; });
+
+                std::vector<size_t> out_vec =
+                    integers.Map([](const size_t& i) { return 2 * i; })
+                    .AllGather();
+                std::sort(out_vec.begin(), out_vec.end());
+
+                ASSERT_EQ(test_size, out_vec.size());
+                for (size_t i = 0; i < test_size; ++i) {
+                    ASSERT_EQ(2 * i, out_vec[i]);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, GenerateIntegersBatchedIntoTwoChildren) {
+
+    static constexpr size_t test_size = 1000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx, test_size,
+                [](const size_t& index) { return index; });
+
+            // both Maps are fused into the Zip, hence Generate has two children
+            // and pushes batches of items.
+            auto doubled = integers.Map([](const size_t& i) { return 2 * i; });
+            auto odd = integers.Filter([](const size_t& i) { return i % 2 == 1; });
+
+            std::vector<size_t> out_vec =
+                doubled.Zip(CutTag, odd,
+                            [](const size_t& a, const size_t& b) {
+                                return a + b;
+                            }).AllGather();
+
+            ASSERT_EQ(test_size / 2, out_vec.size());
+
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(2 * i + (2 * i + 1), out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, ApproxQuantilesOfPermutation) {
+
+    static constexpr size_t test_size = 100000;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx, test_size,
+                [](const size_t& index) {
+                    return (index * 7919) % test_size;
+                });
+
+            std::vector<size_t> q =
+                integers.ApproxQuantiles({ 0.5, 0.9, 0.99 });
+
+            ASSERT_EQ(3u, q.size());
+            ASSERT_NEAR(0.5 * test_size, q[0], 0.02 * test_size);
+            ASSERT_NEAR(0.9 * test_size, q[1], 0.02 * test_size);
+            ASSERT_NEAR(0.99 * test_size, q[2], 0.02 * test_size);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, GenerateAndConcatTwo) {
 
     static constexpr size_t test_size = 1024;
@@ -282,6 +493,41 @@ TEST(Operations, GenerateAndConcatThree) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, GenerateAndConcatUnordered) {
+
+    static constexpr size_t test_size = 1024;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // the items of dia2 are on the first half of the workers
+            auto dia1 = Generate(ctx, test_size).Cache();
+            auto dia2 = Generate(ctx, 2 * test_size)
+                        .Filter([](const size_t& i) { return i < test_size; });
+
+            auto cdia = dia1.Concat(UnorderedTag, dia2).Cache();
+
+            // every worker holds its share of the items
+            size_t local_size = 0;
+            cdia.Map([&local_size](const size_t& i) {
+                         ++local_size;
+                         return i;
+                     }).Size();
+            ASSERT_EQ(ctx.CalculateLocalRange(2 * test_size).size(),
+                      local_size);
+
+            std::vector<size_t> out_vec = cdia.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(2 * test_size, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(i / 2, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, GenerateAndUnionTwo) {
 
     static constexpr size_t test_size = 1024;
@@ -401,6 +647,88 @@ TEST(Operations, GenerateFilterRebalance) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, GenerateRepartition) {
+
+    static constexpr size_t test_size = 1024;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto dia1 = Generate(ctx, test_size);
+
+            auto rdia = dia1.Repartition(
+                [&ctx](size_t index) {
+                    return (index / 7) % ctx.num_workers();
+                });
+
+            // check that each worker received only its items
+            auto checked = rdia.Map(
+                [&ctx](size_t index) {
+                    die_unless((index / 7) % ctx.num_workers() == ctx.my_rank());
+                    return index;
+                });
+
+            std::vector<size_t> out_vec = checked.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(test_size, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(i, out_vec[i]);
+            }
+
+            auto key_fn = [](size_t index) { return index / 7; };
+            auto kdia = dia1.RepartitionByKey(key_fn);
+            ASSERT_TRUE(kdia.partitioning().IsHash<decltype(key_fn)>());
+            ASSERT_EQ(test_size, kdia.Size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, MapPartitionsAndReduceLocal) {
+
+    static constexpr size_t test_size = 1024;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto dia1 = Generate(ctx, test_size).Cache();
+
+            // local sort and scan: output the local prefix sums
+            auto scanned = dia1.MapPartitions(
+                [](auto& reader, auto emit) {
+                    std::vector<size_t> items;
+                    items.reserve(reader.size());
+                    while (reader.HasNext())
+                        items.push_back(reader.Next());
+                    die_unless(items.size() == reader.size());
+                    std::sort(items.begin(), items.end());
+                    size_t sum = 0;
+                    for (const size_t& i : items)
+                        emit(sum += i);
+                });
+            ASSERT_EQ(test_size, scanned.Size());
+
+            // count items per worker with a different output type
+            auto counts = dia1.MapPartitions<std::string>(
+                [](auto& reader, auto emit) {
+                    emit(std::to_string(reader.size()));
+                });
+            std::vector<std::string> count_vec = counts.AllGather();
+            ASSERT_EQ(ctx.num_workers(), count_vec.size());
+
+            // local sums add up to the global sum
+            std::vector<size_t> sums = dia1.ReduceLocal(
+                [](size_t a, size_t b) { return a + b; }).AllGather();
+            ASSERT_GE(ctx.num_workers(), sums.size());
+            size_t total = 0;
+            for (const size_t& s : sums) total += s;
+            ASSERT_EQ(test_size * (test_size - 1) / 2, total);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, MapResultsCorrectChangingType) {
 
     auto start_func =
@@ -498,6 +826,47 @@ TEST(Operations, BernoulliSampleCompileAndExecute) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, ApproxAggregations) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 100000;
+
+            auto sizets = Generate(ctx, n).Cache();
+
+            // sampling everything is exact
+            ApproxResult size1 = sizets.SizeApprox(1.0);
+            ASSERT_DOUBLE_EQ(static_cast<double>(n), size1.estimate);
+            ASSERT_DOUBLE_EQ(size1.estimate, size1.lower);
+            ASSERT_DOUBLE_EQ(size1.estimate, size1.upper);
+
+            // estimates are in a generous multiple of the interval
+            ApproxResult size = sizets.SizeApprox(0.1, 0.999);
+            LOG << "SizeApprox: " << size;
+            ASSERT_LT(size.lower, size.upper);
+            ASSERT_LE(std::abs(size.estimate - static_cast<double>(n)),
+                      2 * (size.upper - size.estimate));
+
+            double exact_sum = static_cast<double>(n) * (n - 1) / 2;
+            ApproxResult sum = sizets.SumApprox(0.1, 0.999);
+            LOG << "SumApprox: " << sum;
+            ASSERT_LE(std::abs(sum.estimate - exact_sum),
+                      2 * (sum.upper - sum.estimate));
+
+            auto by_key = sizets.SumByKeyApprox(
+                0.2, [](const size_t& i) { return i % 4; },
+                [](const size_t&) { return 1.0; }, 0.999).AllGather();
+
+            ASSERT_EQ(4u, by_key.size());
+            for (const std::pair<size_t, ApproxResult>& k : by_key) {
+                ASSERT_LE(std::abs(k.second.estimate - n / 4.0),
+                          2 * (k.second.upper - k.second.estimate));
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, PrefixSumCorrectResults) {
 
     auto start_func =
@@ -573,6 +942,37 @@ TEST(Operations, ExPrefixSumFacultyCorrectResults) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, SegmentedPrefixSumCorrectResults) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 1000;
+
+            // segments of 37 items, which span workers
+            auto integers = Generate(ctx, n).Cache();
+            auto key = [](const size_t& i) { return i / 37; };
+
+            std::vector<size_t> in_vec =
+                integers.SegmentedPrefixSum(key, std::plus<size_t>(), 42)
+                .AllGather();
+            std::vector<size_t> ex_vec =
+                integers.SegmentedExPrefixSum(key).AllGather();
+
+            ASSERT_EQ(n, in_vec.size());
+            ASSERT_EQ(n, ex_vec.size());
+
+            size_t sum = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (i % 37 == 0) sum = 0;
+                ASSERT_EQ(sum, ex_vec[i]);
+                sum += i;
+                ASSERT_EQ(42 + sum, in_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, GenerateAndSumHaveEqualAmount2) {
 
     auto start_func =
@@ -722,6 +1122,50 @@ TEST(Operations, WindowCorrectResultsPartialWindows) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, WindowReduceCorrectResults) {
+
+    auto test_func =
+        [](Context& ctx, size_t test_size, size_t window_size) {
+
+            auto integers = Generate(
+                ctx, test_size,
+                [](const size_t& input) { return input * input; });
+
+            // sliding sums and maxima of window_size items
+            std::vector<size_t> sum_vec =
+                integers.Keep().WindowReduce(
+                    window_size, std::plus<size_t>()).AllGather();
+
+            std::vector<size_t> max_vec =
+                integers.WindowReduce(
+                    window_size, [](const size_t& a, const size_t& b) {
+                        return std::max(a, b);
+                    }).AllGather();
+
+            ASSERT_EQ(test_size - window_size + 1, sum_vec.size());
+            ASSERT_EQ(test_size - window_size + 1, max_vec.size());
+
+            for (size_t r = 0; r < sum_vec.size(); ++r) {
+                size_t sum = 0;
+                for (size_t i = r; i < r + window_size; ++i)
+                    sum += i * i;
+                ASSERT_EQ(sum, sum_vec[r]);
+                size_t last = r + window_size - 1;
+                ASSERT_EQ(last * last, max_vec[r]);
+            }
+        };
+
+    auto start_func =
+        [&](Context& ctx) {
+            // window smaller than input
+            test_func(ctx, 144, 10);
+            // window matches input
+            test_func(ctx, 144, 144);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, DisjointWindowCorrectResults) {
 
     static constexpr bool debug = false;
@@ -880,6 +1324,98 @@ TEST(Operations, Sample) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, WeightedSample) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 9999;
+
+            // only items with positive weight are sampled
+            auto weight = [](const size_t& i) {
+                              return i % 3 == 0 ? 1.0 + i % 7 : 0.0;
+                          };
+
+            // test with sample smaller than the items with positive weight
+            {
+                auto sampled = Generate(ctx, n).WeightedSample(100, weight);
+
+                std::vector<size_t> vec = sampled.AllGather();
+                ASSERT_EQ(100u, vec.size());
+
+                std::sort(vec.begin(), vec.end());
+                ASSERT_EQ(vec.end(), std::unique(vec.begin(), vec.end()));
+                for (const size_t& i : vec)
+                    ASSERT_EQ(0u, i % 3);
+            }
+
+            // test with sample larger than the items with positive weight
+            {
+                auto sampled = Generate(ctx, n).WeightedSample(5000, weight);
+
+                std::vector<size_t> vec = sampled.AllGather();
+                ASSERT_EQ(3333u, vec.size());
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, StratifiedSample) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 9999;
+
+            // key 100 has only 5 items, keys 0..6 have more than 1000 items
+            auto key = [](const size_t& i) {
+                           return i < 5 ? size_t(100) : i % 7;
+                       };
+
+            std::vector<size_t> vec =
+                Generate(ctx, n).StratifiedSample(key, 20).AllGather();
+
+            std::map<size_t, size_t> count;
+            for (const size_t& i : vec)
+                ++count[key(i)];
+
+            ASSERT_EQ(8u, count.size());
+            for (size_t k = 0; k < 7; ++k)
+                ASSERT_EQ(20u, count[k]);
+            ASSERT_EQ(5u, count[100]);
+
+            std::sort(vec.begin(), vec.end());
+            ASSERT_EQ(vec.end(), std::unique(vec.begin(), vec.end()));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, TopK) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 10000;
+
+            auto integers = Generate(
+                ctx, n, [](const size_t& i) { return (i * 7919) % 10007; });
+
+            for (size_t k : { 0, 1, 10, 100 }) {
+                std::vector<size_t> out_vec = integers.Keep().TopK(
+                    k, std::greater<size_t>()).AllGather();
+
+                std::vector<size_t> check;
+                for (size_t i = 0; i < n; ++i)
+                    check.push_back((i * 7919) % 10007);
+                std::sort(check.begin(), check.end(), std::greater<size_t>());
+                check.resize(k);
+
+                ASSERT_EQ(check, out_vec);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, ForLoop) {
 
     auto start_func =
@@ -1010,6 +1546,112 @@ TEST(Operations, ActionFutures) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, IterateDoublesIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx, 1000,
+                [](const size_t& input) { return input; });
+
+            auto doubled = Iterate(
+                5, integers,
+                [](const DIA<size_t>& state, size_t /* iter */) {
+                    return state.Map([](const size_t& i) { return 2 * i; });
+                });
+
+            std::vector<size_t> out_vec = doubled.AllGather();
+
+            ASSERT_EQ(1000u, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(32 * i, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, DeltaIterateMinLabelOnChain) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            using Pair = std::pair<size_t, size_t>;
+            static constexpr size_t n = 20;
+
+            // each vertex of the chain 0 - 1 - ... - n-1 is labeled with its id
+            auto labels = Generate(
+                ctx, n,
+                [](const size_t& i) { return Pair(i, i); });
+
+            size_t steps = 0;
+
+            auto result = DeltaIterate(
+                labels,
+                [&steps](const DIA<Pair>& delta, size_t /* iter */) {
+                    ++steps;
+                    // send changed labels to both neighbors
+                    return delta.FlatMap<Pair>(
+                        [](const Pair& p, auto emit) {
+                            if (p.first > 0)
+                                emit(Pair(p.first - 1, p.second));
+                            if (p.first + 1 < n)
+                                emit(Pair(p.first + 1, p.second));
+                        });
+                },
+                [](const size_t& a, const size_t& b) { return std::min(a, b); },
+                [](size_t& value, const size_t& message) {
+                    if (message >= value) return false;
+                    value = message;
+                    return true;
+                });
+
+            std::vector<Pair> out_vec = result.AllGather();
+            ASSERT_EQ(n, out_vec.size());
+            for (const Pair& p : out_vec) {
+                ASSERT_EQ(0u, p.second);
+            }
+            // the label 0 travels one vertex per step, the last step finds
+            // no more changes.
+            ASSERT_EQ(n, steps);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, WaitAllBatchesActionFutures) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx, 16,
+                [](const size_t& input) {
+                    return long(input + 1);
+                });
+
+            Future<size_t> sizef = integers.SizeFuture();
+            Future<long> minf = integers.MinFuture(16);
+            Future<long> maxf = integers.MaxFuture();
+            Future<std::vector<long> > vecf = integers.AllGatherFuture();
+
+            WaitAll(sizef, minf, maxf, vecf, sizef);
+
+            ASSERT_TRUE(sizef.valid());
+            ASSERT_TRUE(minf.valid());
+            ASSERT_TRUE(maxf.valid());
+            ASSERT_TRUE(vecf.valid());
+
+            ASSERT_EQ(16u, sizef());
+            ASSERT_EQ(1u, minf());
+            ASSERT_EQ(16u, maxf());
+            ASSERT_EQ(16u, vecf().size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 namespace thrill {
 namespace api {
 
@@ -1019,4 +1661,117 @@ template class DIA<std::string>;
 } // namespace api
 } // namespace thrill
 
+TEST(Operations, ExchangeMemoryStats) {
+
+    auto start_func =
+        [](Context& ctx) {
+            // keep some data in the BlockPool
+            auto integers = Generate(ctx, 10000).Cache().Execute();
+
+            ClusterMemoryStats stats = ctx.ExchangeMemoryStats();
+
+            ASSERT_LE(stats.min_ram_bytes, stats.max_ram_bytes);
+            ASSERT_LE(stats.max_ram_bytes, stats.total_ram_bytes);
+            ASSERT_LE(stats.max_swapped_bytes, stats.total_swapped_bytes);
+            ASSERT_LE(stats.swapping_hosts, ctx.num_hosts());
+
+            // all workers receive the same result
+            size_t total = ctx.net.Broadcast(stats.total_ram_bytes);
+            ASSERT_EQ(total, stats.total_ram_bytes);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, ServeJobs) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t sum_runs = 0, size_runs = 0;
+
+            std::map<std::string, std::function<void(Context&)> > jobs;
+            jobs["sum"] = [&sum_runs](Context& ctx) {
+                              size_t sum = Generate(ctx, 1000).Sum();
+                              ASSERT_EQ(999u * 1000u / 2u, sum);
+                              ++sum_runs;
+                          };
+            jobs["size"] = [&size_runs](Context& ctx) {
+                               ASSERT_EQ(100u, Generate(ctx, 100).Size());
+                               ++size_runs;
+                           };
+
+            // only the master's job list is used
+            std::vector<std::string> names = {
+                "sum", "unknown", "size", "sum"
+            };
+            size_t next = 0;
+
+            size_t num_jobs = ctx.ServeJobs(
+                jobs, [&]() {
+                    return next < names.size() ? names[next++] : std::string();
+                });
+
+            ASSERT_EQ(3u, num_jobs);
+            ASSERT_EQ(2u, sum_runs);
+            ASSERT_EQ(1u, size_runs);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, ServeJobsScheduler) {
+
+    auto start_func =
+        [](Context& ctx) {
+            std::vector<std::string> order;
+
+            std::map<std::string, std::function<void(Context&)> > jobs;
+            for (const std::string name : { "long", "short", "mid" }) {
+                jobs[name] = [&order, name](Context& ctx) {
+                                 ASSERT_EQ(100u, Generate(ctx, 100).Size());
+                                 order.push_back(name);
+                             };
+            }
+
+            // only the master's scheduler is used
+            JobScheduler scheduler;
+            if (ctx.my_rank() == 0) {
+                ASSERT_TRUE(scheduler.Submit("long", 0, 10.0));
+                ASSERT_TRUE(scheduler.Submit("huge", size_t(1) << 62, 1.0));
+                ASSERT_TRUE(scheduler.Submit("short", 1024, 1.0));
+                ASSERT_TRUE(scheduler.Submit("mid", 0, 5.0));
+                scheduler.Close();
+                ASSERT_FALSE(scheduler.Submit("late"));
+            }
+
+            size_t num_jobs = ctx.ServeJobs(jobs, scheduler);
+
+            // short jobs first, the job needing too much RAM is rejected
+            ASSERT_EQ(3u, num_jobs);
+            ASSERT_EQ(
+                std::vector<std::string>({ "short", "mid", "long" }), order);
+            if (ctx.my_rank() == 0) {
+                ASSERT_EQ(2u, scheduler.num_rejected());
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Operations, ParallelFor) {
+
+    auto start_func =
+        [](Context& ctx) {
+            std::vector<size_t> vec(10000);
+            ctx.parallel_for(
+                0, vec.size(),
+                [&vec](size_t i) { vec[i] = i * i; }, /* min_chunk */ 100);
+
+            for (size_t i = 0; i < vec.size(); ++i)
+                ASSERT_EQ(i * i, vec[i]);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 /******************************************************************************/
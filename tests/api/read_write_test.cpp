@@ -12,10 +12,17 @@
 #include <gtest/gtest.h>
 #include <thrill/api/all_gather.hpp>
 #include <thrill/api/generate.hpp>
+#include <thrill/api/persist.hpp>
+#include <thrill/api/read_arrow_stream.hpp>
 #include <thrill/api/read_binary.hpp>
+#include <thrill/api/read_columnar.hpp>
 #include <thrill/api/read_lines.hpp>
+#include <thrill/api/read_stream.hpp>
+#include <thrill/api/reduce_by_key.hpp>
 #include <thrill/api/size.hpp>
+#include <thrill/api/write_arrow_stream.hpp>
 #include <thrill/api/write_binary.hpp>
+#include <thrill/api/write_columnar.hpp>
 #include <thrill/api/write_lines.hpp>
 #include <thrill/api/write_lines_one.hpp>
 #include <thrill/common/logger.hpp>
@@ -26,11 +33,13 @@
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <fstream>
 #include <functional>
 #include <random>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -87,7 +96,103 @@ TEST(IO, ReadFolder) {
     api::RunLocalTests(start_func);
 }
 
+TEST(IO, ReadLinesReducePair) {
+    auto start_func =
+        [](Context& ctx) {
+            // the pre-phase inserts items scanned by ReadLines in batches
+            auto sums = ReadLines(ctx, "inputs/test1")
+                        .Map([](const std::string& line) {
+                                 size_t v = std::stoul(line);
+                                 return std::make_pair(v % 3, v);
+                             })
+                        .ReducePair(std::plus<size_t>());
+
+            std::vector<std::pair<size_t, size_t> > out_vec = sums.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            // lines are the integers 1..16
+            std::vector<std::pair<size_t, size_t> > expected = {
+                { 0, 3 + 6 + 9 + 12 + 15 },
+                { 1, 1 + 4 + 7 + 10 + 13 + 16 },
+                { 2, 2 + 5 + 8 + 11 + 14 }
+            };
+            ASSERT_EQ(expected, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(IO, ReadLinesViewSingleFile) {
+    auto start_func =
+        [](Context& ctx) {
+            auto integers = ReadLinesView(ctx, "inputs/test1")
+                            .Map([](const tlx::string_view& line) {
+                                     return std::stoi(line.to_string());
+                                 });
+
+            std::vector<int> out_vec = integers.AllGather();
+
+            int i = 1;
+            for (int element : out_vec) {
+                ASSERT_EQ(element, i++);
+            }
+
+            ASSERT_EQ(16u, out_vec.size());
+
+            ASSERT_EQ(ReadLinesView(ctx, "inputs/read_folder/*").Size(), 20);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 // need all decompressors in folder
+TEST(IO, GenerateIntegerPersistAndReuse) {
+    vfs::TemporaryDirectory tmpdir;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            ctx.net.Barrier();
+
+            size_t generate_size = 32000;
+            std::atomic<size_t> generated { 0 };
+
+            auto persist =
+                [&](const std::string& version) {
+                    return Generate(
+                        ctx, generate_size,
+                        [&generated](const size_t index) {
+                            ++generated;
+                            return index + 42;
+                        })
+                    .Persist(tmpdir.get(), version).AllGather();
+                };
+
+            // first run computes and writes the DIA
+            std::vector<size_t> vec = persist("v1");
+            ASSERT_EQ(generate_size, vec.size());
+            for (size_t i = 0; i < vec.size(); ++i) {
+                ASSERT_EQ(42 + i, vec[i]);
+            }
+            size_t total = ctx.net.AllReduce(generated.exchange(0));
+            ASSERT_EQ(generate_size, total);
+
+            // second run with equal lineage reads the files
+            ASSERT_EQ(vec, persist("v1"));
+            total = ctx.net.AllReduce(generated.exchange(0));
+            ASSERT_EQ(0u, total);
+
+            // a new version recomputes the DIA
+            ASSERT_EQ(vec, persist("v2"));
+            total = ctx.net.AllReduce(generated.exchange(0));
+            ASSERT_EQ(generate_size, total);
+        });
+}
+
 #if THRILL_HAVE_ZLIB && THRILL_HAVE_BZIP2
 
 TEST(IO, ReadPartOfFolderCompressed) {
@@ -119,6 +224,36 @@ TEST(IO, ReadPartOfFolderCompressed) {
 
 #endif // THRILL_HAVE_ZLIB && THRILL_HAVE_BZIP2
 
+#if THRILL_HAVE_BZIP2
+
+TEST(IO, ReadLinesSplitBZip2) {
+    vfs::TemporaryDirectory tmpdir;
+    std::string path = tmpdir.get() + "/lines.txt.bz2";
+
+    // multiple bzip2 blocks, which are read in parallel
+    size_t num_lines = 400000;
+    {
+        vfs::WriteStreamPtr ws = vfs::OpenWriteStream(path);
+        for (size_t i = 0; i < num_lines; ++i) {
+            std::string line = std::to_string(i) + "\n";
+            ws->write(line.data(), line.size());
+        }
+        ws->close();
+    }
+
+    api::RunLocalTests(
+        [&](Context& ctx) {
+            std::vector<std::string> lines = ReadLines(ctx, path).AllGather();
+
+            ASSERT_EQ(num_lines, lines.size());
+            for (size_t i = 0; i < num_lines; ++i) {
+                ASSERT_EQ(std::to_string(i), lines[i]);
+            }
+        });
+}
+
+#endif // THRILL_HAVE_BZIP2
+
 TEST(IO, GenerateIntegerWriteReadBinary) {
     vfs::TemporaryDirectory tmpdir;
 
@@ -162,6 +297,52 @@ TEST(IO, GenerateIntegerWriteReadBinary) {
         });
 }
 
+TEST(IO, GenerateIntegerWriteReadBinaryMapped) {
+    vfs::TemporaryDirectory tmpdir;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            // read binary files zero-copy from memory mappings
+            if (ctx.local_worker_id() == 0) {
+                ctx.block_pool().set_map_files(true);
+            }
+            ctx.net.Barrier();
+
+            // generate a dia of integers and write them to disk
+            size_t generate_size = 32000;
+            {
+                auto dia = Generate(
+                    ctx, generate_size,
+                    [](const size_t index) { return index + 42; });
+
+                dia.WriteBinary(tmpdir.get() + "/IntegerBinary",
+                                16 * 1024);
+            }
+            ctx.net.Barrier();
+
+            // read the integers from disk (collectively) and compare
+            {
+                auto dia = api::ReadBinary<size_t>(
+                    ctx,
+                    tmpdir.get() + "/IntegerBinary*");
+
+                std::vector<size_t> vec = dia.AllGather();
+
+                ASSERT_EQ(generate_size, vec.size());
+                ASSERT_EQ(generate_size, dia.Size());
+
+                for (size_t i = 0; i < vec.size(); ++i) {
+                    ASSERT_EQ(42 + i, vec[i]);
+                }
+            }
+        });
+}
+
 #if THRILL_HAVE_ZLIB
 
 TEST(IO, GenerateIntegerWriteReadBinaryCompressed) {
@@ -267,6 +448,61 @@ TEST(IO, GenerateStringWriteBinary) {
         });
 }
 
+TEST(IO, GenerateStringWriteReadBinaryIndexed) {
+    vfs::TemporaryDirectory tmpdir;
+
+    using Item = std::pair<size_t, std::string>;
+
+    // small blocks, such that items span blocks inside the files
+    size_t old_block_size = data::default_block_size;
+    data::default_block_size = 4096;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            ctx.net.Barrier();
+
+            size_t generate_size = 32000;
+            {
+                auto dia = Generate(
+                    ctx, generate_size,
+                    [](const size_t index) {
+                        return Item(index, test_string(index));
+                    });
+
+                dia.WriteBinary(tmpdir.get() + "/StringBinary",
+                                16 * 1024, /* block_index */ true);
+            }
+            ctx.net.Barrier();
+
+            // read via foxxll files, then via memory mappings
+            for (bool map_files : { false, true }) {
+                if (ctx.local_worker_id() == 0) {
+                    ctx.block_pool().set_map_files(map_files);
+                }
+                ctx.net.Barrier();
+
+                auto dia = api::ReadBinary<Item>(
+                    ctx, tmpdir.get() + "/StringBinary*");
+
+                std::vector<Item> vec = dia.AllGather();
+
+                ASSERT_EQ(generate_size, vec.size());
+                ASSERT_EQ(generate_size, dia.Size());
+
+                for (size_t i = 0; i < vec.size(); ++i) {
+                    ASSERT_EQ(Item(i, test_string(i)), vec[i]);
+                }
+            }
+        });
+
+    data::default_block_size = old_block_size;
+}
+
 TEST(IO, WriteAndReadBinaryEqualDIAs) {
     vfs::TemporaryDirectory tmpdir;
 
@@ -362,6 +598,121 @@ TEST(IO, WriteAndReadBinaryEqualDIAsLocalStorage) {
     api::RunLocalTests(start_func);
 }
 
+TEST(IO, GenerateTupleWriteReadColumnar) {
+    vfs::TemporaryDirectory tmpdir;
+
+    using Row = std::tuple<size_t, double, std::string>;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            ctx.net.Barrier();
+
+            size_t generate_size = 32000;
+            {
+                auto dia = Generate(
+                    ctx, generate_size,
+                    [](const size_t index) {
+                        return Row(index, index * 0.5,
+                                   "s" + std::to_string(index));
+                    });
+
+                dia.WriteColumnar(tmpdir.get() + "/Columnar", 1000);
+            }
+            ctx.net.Barrier();
+
+            // read all columns and compare
+            {
+                auto dia = api::ReadColumnar<Row>(
+                    ctx, tmpdir.get() + "/Columnar*");
+
+                std::vector<Row> vec = dia.AllGather();
+
+                ASSERT_EQ(generate_size, vec.size());
+                for (size_t i = 0; i < vec.size(); ++i) {
+                    ASSERT_EQ(Row(i, i * 0.5, "s" + std::to_string(i)),
+                              vec[i]);
+                }
+            }
+
+            // read two columns in different order, skip row groups by max.
+            {
+                using Projected = std::tuple<std::string, size_t>;
+
+                auto dia = api::ReadColumnar<Projected>(
+                    ctx, tmpdir.get() + "/Columnar*", { 2, 0 },
+                    [](const Projected& /* min */, const Projected& max) {
+                        return std::get<1>(max) >= 30000;
+                    });
+
+                std::vector<Projected> vec = dia.AllGather();
+
+                // all rows in matching row groups, and not all row groups
+                ASSERT_GT(generate_size, vec.size());
+
+                size_t count = 0;
+                for (const Projected& p : vec) {
+                    ASSERT_EQ("s" + std::to_string(std::get<1>(p)),
+                              std::get<0>(p));
+                    if (std::get<1>(p) >= 30000) ++count;
+                }
+                ASSERT_EQ(2000u, count);
+            }
+        });
+}
+
+TEST(IO, GenerateTupleWriteReadArrowStream) {
+    vfs::TemporaryDirectory tmpdir;
+
+    using Row = std::tuple<int64_t, double, std::string>;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            ctx.net.Barrier();
+
+            size_t generate_size = 32000;
+            {
+                auto dia = Generate(
+                    ctx, generate_size,
+                    [](const size_t index) {
+                        return Row(static_cast<int64_t>(index) - 1000,
+                                   index * 0.5, "s" + std::to_string(index));
+                    });
+
+                dia.WriteArrowStream(tmpdir.get() + "/Arrow",
+                                     { "id", "value", "name" }, 1000);
+            }
+            ctx.net.Barrier();
+
+            // every worker wrote a stream, also the empty ones
+            ASSERT_EQ(ctx.num_workers(),
+                      vfs::Glob(tmpdir.get() + "/Arrow*").size());
+
+            {
+                auto dia = api::ReadArrowStream<Row>(
+                    ctx, tmpdir.get() + "/Arrow*");
+
+                std::vector<Row> vec = dia.AllGather();
+
+                ASSERT_EQ(generate_size, vec.size());
+                for (size_t i = 0; i < vec.size(); ++i) {
+                    ASSERT_EQ(Row(static_cast<int64_t>(i) - 1000, i * 0.5,
+                                  "s" + std::to_string(i)),
+                              vec[i]);
+                }
+            }
+        });
+}
+
 TEST(IO, IntegerWriteReadBinaryLinesFutures) {
     vfs::TemporaryDirectory tmpdir;
 
@@ -429,4 +780,41 @@ TEST(IO, IntegerWriteReadBinaryLinesFutures) {
         });
 }
 
+TEST(IO, ReadStreamMicroBatches) {
+    vfs::TemporaryDirectory tmpdir;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // write three partitions of 1000 lines each
+            std::vector<std::string> partitions;
+            for (size_t p = 0; p < 3; ++p)
+                partitions.push_back(
+                    tmpdir.get() + "/partition-" + std::to_string(p));
+
+            if (ctx.my_rank() == 0) {
+                for (size_t p = 0; p < 3; ++p) {
+                    std::ofstream of(partitions[p]);
+                    for (size_t i = 0; i < 1000; ++i)
+                        of << p << ' ' << i << '\n';
+                }
+            }
+            ctx.net.Barrier();
+
+            api::MicroBatchSource source(
+                ctx, partitions, /* max_batch_items */ 100);
+
+            size_t total = 0;
+            size_t batches = RunMicroBatches(
+                source, [&total](DIA<std::string> batch, size_t) {
+                    total += batch.Size();
+                    return true;
+                });
+
+            ASSERT_EQ(3000u, total);
+            ASSERT_LE(10u, batches);
+            ctx.net.Barrier();
+        });
+}
+
 /******************************************************************************/
@@ -12,6 +12,7 @@
 
 #include <gtest/gtest.h>
 #include <thrill/api/all_gather.hpp>
+#include <thrill/api/distinct.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/reduce_by_key.hpp>
 #include <thrill/api/reduce_to_index.hpp>
@@ -20,6 +21,7 @@
 #include <thrill/common/logger.hpp>
 
 #include <algorithm>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -87,10 +89,13 @@ TEST(ReduceNode, ReduceModulo2CorrectResults) {
         TestReduceModulo2CorrectResults<ReduceTableImpl::BUCKET>());
     api::RunLocalTests(
         TestReduceModulo2CorrectResults<ReduceTableImpl::OLD_PROBING>());
+    api::RunLocalTests(
+        TestReduceModulo2CorrectResults<ReduceTableImpl::SWISS>());
 }
 
 //! Test sums of integers 0..n-1 for n=100 in 1000 buckets in the reduce table
-template <ReduceTableImpl table_impl>
+template <ReduceTableImpl table_impl,
+          typename ReduceConfig = core::DefaultReduceConfigSelect<table_impl> >
 class TestReduceModuloPairsCorrectResults
 {
 public:
@@ -111,9 +116,7 @@ public:
                                 return in1 + in2;
                             };
 
-        auto reduced = integers.ReducePair(
-            add_function,
-            core::DefaultReduceConfigSelect<table_impl>());
+        auto reduced = integers.ReducePair(add_function, ReduceConfig());
 
         std::vector<IntPair> out_vec = reduced.AllGather();
 
@@ -136,6 +139,68 @@ TEST(ReduceNode, ReduceModuloPairsCorrectResults) {
         TestReduceModuloPairsCorrectResults<ReduceTableImpl::BUCKET>());
     api::RunLocalTests(
         TestReduceModuloPairsCorrectResults<ReduceTableImpl::OLD_PROBING>());
+    api::RunLocalTests(
+        TestReduceModuloPairsCorrectResults<ReduceTableImpl::SWISS>());
+}
+
+struct MySortReduceConfig : public core::DefaultReduceConfig {
+    static constexpr bool use_sort_post_phase_ = true;
+};
+
+TEST(ReduceNode, ReduceModuloPairsSortPostPhase) {
+    api::RunLocalTests(
+        TestReduceModuloPairsCorrectResults<
+            ReduceTableImpl::PROBING, MySortReduceConfig>());
+}
+
+struct MyHashCacheReduceConfig : public core::DefaultReduceConfig {
+    static constexpr bool use_hash_cache_ = true;
+};
+
+TEST(ReduceNode, ReduceModuloPairsHashCache) {
+    api::RunLocalTests(
+        TestReduceModuloPairsCorrectResults<
+            ReduceTableImpl::PROBING, MyHashCacheReduceConfig>());
+}
+
+struct MySharedReduceConfig : public core::DefaultReduceConfig {
+    static constexpr bool use_shared_pre_phase_ = true;
+};
+
+TEST(ReduceNode, ReduceModuloPairsSharedPrePhase) {
+    api::RunLocalTests(
+        TestReduceModuloPairsCorrectResults<
+            ReduceTableImpl::PROBING, MySharedReduceConfig>());
+}
+
+TEST(ReduceNode, ReduceStringPairsHashCache) {
+    static constexpr size_t test_size = 100000u;
+    static constexpr size_t mod_size = 1000u;
+
+    auto start_func =
+        [](Context& ctx) {
+            using StringPair = std::pair<std::string, size_t>;
+
+            auto words = Generate(
+                ctx, test_size,
+                [](const size_t& index) {
+                    return StringPair(
+                        "word" + std::to_string(index % mod_size), 1);
+                });
+
+            auto reduced = words.ReducePair(
+                [](const size_t& a, const size_t& b) { return a + b; },
+                MyHashCacheReduceConfig());
+
+            std::vector<StringPair> out_vec = reduced.AllGather();
+
+            ASSERT_EQ(mod_size, out_vec.size());
+            for (const StringPair& p : out_vec) {
+                ASSERT_EQ(test_size / mod_size, p.second);
+            }
+        };
+
+    api::RunLocalTests(start_func);
 }
 
 template <ReduceTableImpl table_impl>
@@ -205,6 +270,30 @@ public:
     }
 };
 
+TEST(ReduceNode, Distinct) {
+    auto start_func =
+        [](Context& ctx) {
+            // mostly unique items, and some duplicated across workers
+            auto input = Generate(
+                ctx, 10000,
+                [](const size_t index) {
+                    return index < 9000 ? index : index % 500;
+                });
+
+            std::vector<size_t> out_vec = input.Distinct().AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(9000u, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i)
+                ASSERT_EQ(i, out_vec[i]);
+
+            ASSERT_EQ(100u, input.CountDistinct(
+                          [](const size_t& x) { return x % 100; }));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(ReduceNode, ReduceToIndexCorrectResults) {
     api::RunLocalTests(
         TestReduceToIndexCorrectResults<ReduceTableImpl::PROBING>());
@@ -212,6 +301,52 @@ TEST(ReduceNode, ReduceToIndexCorrectResults) {
         TestReduceToIndexCorrectResults<ReduceTableImpl::BUCKET>());
     api::RunLocalTests(
         TestReduceToIndexCorrectResults<ReduceTableImpl::OLD_PROBING>());
+    api::RunLocalTests(
+        TestReduceToIndexCorrectResults<ReduceTableImpl::SWISS>());
+}
+
+//! ReduceToIndex of index % result_size with a config selecting the dense or
+//! the hash table pre-phase by dense_pre_phase_max_bytes.
+static void TestReduceToIndexPrePhase(size_t dense_pre_phase_max_bytes) {
+    static constexpr size_t test_size = 100000u;
+    static constexpr size_t result_size = 5000u;
+
+    auto start_func =
+        [dense_pre_phase_max_bytes](Context& ctx) {
+            core::DefaultReduceConfig config;
+            config.dense_pre_phase_max_bytes_ = dense_pre_phase_max_bytes;
+
+            // only even indexes are touched, odd ones get the neutral element
+            auto reduced =
+                Generate(ctx, test_size)
+                .Map([](const size_t& index) {
+                         return (2 * index) % result_size;
+                     })
+                .ReduceToIndex(
+                    [](const size_t& i) { return i; },
+                    [](const size_t& a, const size_t& b) { return a + b; },
+                    result_size, /* neutral_element */ size_t(42), config);
+
+            std::vector<size_t> out_vec = reduced.AllGather();
+            ASSERT_EQ(result_size, out_vec.size());
+            for (size_t i = 0; i < result_size; ++i) {
+                if (i % 2 == 0)
+                    ASSERT_EQ(i * test_size / (result_size / 2), out_vec[i]);
+                else
+                    ASSERT_EQ(42u, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(ReduceNode, ReduceToIndexDensePrePhase) {
+    TestReduceToIndexPrePhase(
+        /* dense_pre_phase_max_bytes */ std::numeric_limits<size_t>::max());
+}
+
+TEST(ReduceNode, ReduceToIndexTablePrePhase) {
+    TestReduceToIndexPrePhase(/* dense_pre_phase_max_bytes */ 0);
 }
 
 TEST(ReduceToIndexNode, OutputSizeCheck) {
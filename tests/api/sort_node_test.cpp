@@ -12,10 +12,17 @@
 #include <thrill/api/generate.hpp>
 #include <thrill/api/read_binary.hpp>
 #include <thrill/api/sort.hpp>
+#include <thrill/api/sort_by_key.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/gpu_sort.hpp>
+#include <thrill/common/lsd_radix_sort.hpp>
+#include <thrill/common/parallel_sort.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <functional>
+#include <random>
 #include <string>
 #include <utility>
 #include <vector>
@@ -159,6 +166,70 @@ TEST(Sort, SortRandomIntIntStructs) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Sort, SortRandomStrings) {
+
+    static constexpr size_t test_size = 100000u;
+
+    // strings with long common prefixes, such that the buckets' splitters
+    // share prefixes
+    auto make_string =
+        [](const size_t& index) {
+            std::minstd_rand rng(static_cast<unsigned>(index));
+            std::string s = "http://project-thrill.org/";
+            size_t len = rng() % 12;
+            for (size_t i = 0; i < len; ++i)
+                s += static_cast<char>('a' + rng() % 4);
+            return s;
+        };
+
+    auto start_func =
+        [&make_string](Context& ctx) {
+
+            auto strings = Generate(ctx, test_size, make_string);
+
+            std::vector<std::string> out_vec = strings.Sort().AllGather();
+
+            std::vector<std::string> check;
+            for (size_t i = 0; i < test_size; ++i)
+                check.push_back(make_string(i));
+            std::sort(check.begin(), check.end());
+
+            ASSERT_EQ(check, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortRandomIntegersParallelSort) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<size_t> distribution(0, 1000000);
+
+            auto integers = Generate(
+                ctx, 1000000,
+                [&distribution, &generator](const size_t&) -> size_t {
+                    return distribution(generator);
+                });
+
+            auto sorted = integers.Sort(
+                std::less<size_t>(),
+                common::ParallelSort(ctx.num_threads_per_worker()));
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+
+            ASSERT_EQ(1000000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Sort, SortZeros) {
 
     auto start_func =
@@ -364,6 +435,76 @@ TEST(SortStable, SortRandomIndexedIntegers) {
     api::RunLocalTests(start_func);
 }
 
+TEST(SortStable, SortRandomIndexedIntegersLsdRadixSort) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<size_t> distribution(0, 1000);
+
+            auto pairs = Generate(
+                ctx, 1000000,
+                [&distribution, &generator](const size_t& index) -> auto {
+                    return IVPair{ distribution(generator), index };
+                });
+
+            auto key = [](const IVPair& p) { return p.value; };
+
+            auto sorted = pairs.SortStable(
+                LessByKey(key),
+                common::MakeLsdRadixSort(key, ctx.num_threads_per_worker()));
+
+            std::vector<IVPair> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(1000000u, out_vec.size());
+            for (size_t i = 1; i < out_vec.size(); i++) {
+                ASSERT_LE(out_vec[i - 1].value, out_vec[i].value);
+
+                if (out_vec[i - 1].value == out_vec[i].value) {
+                    ASSERT_LT(out_vec[i - 1].index, out_vec[i].index);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(SortStable, SortRandomIndexedIntegersGpuSort) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<size_t> distribution(0, 1000);
+
+            auto pairs = Generate(
+                ctx, 100000,
+                [&distribution, &generator](const size_t& index) -> auto {
+                    return IVPair{ distribution(generator), index };
+                });
+
+            auto key = [](const IVPair& p) { return p.value; };
+
+            // small min_device_items, such that a device is used if present
+            auto sorted = pairs.SortStable(
+                LessByKey(key), common::MakeGpuSort(key, 1024));
+
+            std::vector<IVPair> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(100000u, out_vec.size());
+            for (size_t i = 1; i < out_vec.size(); i++) {
+                ASSERT_LE(out_vec[i - 1].value, out_vec[i].value);
+
+                if (out_vec[i - 1].value == out_vec[i].value) {
+                    ASSERT_LT(out_vec[i - 1].index, out_vec[i].index);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(SortStable, SortRandomIndexedIntegersCustomCompareFunction) {
 
     auto start_func =
@@ -403,4 +544,373 @@ TEST(SortStable, SortRandomIndexedIntegersCustomCompareFunction) {
     api::RunLocalTests(start_func);
 }
 
+TEST(SortStable, SortFewDistinctIndexedIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // few heavy keys, such that inner buckets have equal keys.
+            auto pairs = Generate(
+                ctx, 100000,
+                [](const size_t& index) {
+                    return IVPair{ (index * 7) % 3, index };
+                });
+
+            auto sorted = pairs.SortStable(
+                [](const IVPair& a, const IVPair& b) {
+                    return a.value < b.value;
+                });
+
+            std::vector<IVPair> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(100000u, out_vec.size());
+            for (size_t i = 1; i < out_vec.size(); i++) {
+                ASSERT_LE(out_vec[i - 1].value, out_vec[i].value);
+
+                if (out_vec[i - 1].value == out_vec[i].value) {
+                    ASSERT_LT(out_vec[i - 1].index, out_vec[i].index);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+class DetectPresortedSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr bool detect_presorted_ = true;
+};
+
+TEST(Sort, SortPresortedIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // already sorted: the exchange is skipped.
+            auto integers = Generate(
+                ctx, 100000, [](const size_t& index) { return index / 3; });
+
+            std::vector<size_t> out_vec =
+                integers.Sort(std::less<size_t>(), api::DefaultSortAlgorithm(),
+                              DetectPresortedSortConfig()).AllGather();
+
+            ASSERT_EQ(100000u, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                ASSERT_EQ(i / 3, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortSkewedPresortedIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // sorted, but most items are on the first workers: the items are
+            // exchanged to balance the output.
+            static constexpr size_t n = 100000;
+            auto integers = Generate(ctx, n).Filter(
+                [](const size_t& i) { return i < n / 4 || i % 16 == 0; });
+
+            size_t local_items = 0;
+            auto sorted = integers.Sort(
+                std::less<size_t>(), api::DefaultSortAlgorithm(),
+                DetectPresortedSortConfig()).Map(
+                [&local_items](const size_t& i) { ++local_items; return i; });
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(n / 4 + (n - n / 4) / 16, out_vec.size());
+            for (size_t i = 1; i < out_vec.size(); i++) {
+                ASSERT_LT(out_vec[i - 1], out_vec[i]);
+            }
+
+            size_t max_items = ctx.net.AllReduce(
+                local_items, common::maximum<size_t>());
+            ASSERT_LE(max_items,
+                      out_vec.size() / ctx.num_workers() * 3 / 2 + 1);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortLocallySortedIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // sorted on each worker, but the workers' ranges overlap: the
+            // unstable sort's MixStream interleaves the sources, hence the
+            // received items are sorted into runs as usual.
+            size_t offset = 10 * (ctx.num_workers() - ctx.my_rank());
+            auto integers = Generate(
+                ctx, 100000,
+                [offset](const size_t& index) { return offset + index / 5000; });
+
+            std::vector<size_t> out_vec =
+                integers.Sort(std::less<size_t>(), api::DefaultSortAlgorithm(),
+                              DetectPresortedSortConfig()).AllGather();
+
+            ASSERT_EQ(100000u, out_vec.size());
+            for (size_t i = 1; i < out_vec.size(); i++) {
+                ASSERT_LE(out_vec[i - 1], out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(SortStable, SortLocallySortedIndexedIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // sorted on each worker, but the workers' ranges overlap in
+            // reverse order: the natural runs are merged.
+            size_t offset = 10 * (ctx.num_workers() - ctx.my_rank());
+            auto pairs = Generate(
+                ctx, 100000,
+                [offset](const size_t& index) {
+                    return IVPair{ offset + index / 5000, index };
+                });
+
+            auto sorted = pairs.SortStable(
+                [](const IVPair& a, const IVPair& b) {
+                    return a.value < b.value;
+                },
+                api::DefaultStableSortAlgorithm(), DetectPresortedSortConfig());
+
+            std::vector<IVPair> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(100000u, out_vec.size());
+            for (size_t i = 1; i < out_vec.size(); i++) {
+                ASSERT_LE(out_vec[i - 1].value, out_vec[i].value);
+
+                if (out_vec[i - 1].value == out_vec[i].value) {
+                    ASSERT_LT(out_vec[i - 1].index, out_vec[i].index);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortByParsedKey) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto strings = Generate(
+                ctx, 10000,
+                [](const size_t& index) -> std::string {
+                    return "record " + std::to_string((index * 7919) % 10007);
+                });
+
+            auto sorted = strings.SortBy(
+                [](const std::string& s) { return std::stoul(s.substr(7)); });
+
+            std::vector<std::string> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(10000u, out_vec.size());
+            for (size_t i = 1; i < out_vec.size(); i++) {
+                ASSERT_LE(std::stoul(out_vec[i - 1].substr(7)),
+                          std::stoul(out_vec[i].substr(7)));
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(SortByKey, SortLargeRecordsByKey) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // records of 1 KiB with few distinct keys, whose payload contains
+            // the index to verify stability.
+            using Record = std::pair<size_t, std::string>;
+
+            auto records = Generate(
+                ctx, 2000,
+                [](const size_t& index) -> Record {
+                    std::string payload = std::to_string(index);
+                    payload.resize(1024, 'x');
+                    return Record((index * 7919) % 13, payload);
+                });
+
+            auto sorted = records.SortByKey(
+                [](const Record& r) { return r.first; },
+                [](const size_t& a, const size_t& b) { return a > b; });
+
+            std::vector<Record> out_vec = sorted.AllGather();
+
+            ASSERT_EQ(2000u, out_vec.size());
+            for (size_t i = 1; i < out_vec.size(); i++) {
+                ASSERT_GE(out_vec[i - 1].first, out_vec[i].first);
+                ASSERT_EQ(1024u, out_vec[i].second.size());
+
+                if (out_vec[i - 1].first == out_vec[i].first) {
+                    ASSERT_LT(std::stoul(out_vec[i - 1].second),
+                              std::stoul(out_vec[i].second));
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+
+//! Sort skewed integers with the methods enabled by SortConfig, with little
+//! RAM such that runs are written and merged, on two hosts with two workers.
+template <typename SortConfig>
+static void TestSortWithConfig() {
+
+    static constexpr size_t test_size = 4000000u;
+
+    auto item = [](const size_t& index) -> size_t {
+                    // a third of the items are equal, the others spread widely
+                    return index % 3 == 0 ? 42 : (index * 7919) % 1000003;
+                };
+
+    auto start_func =
+        [&item](Context& ctx) {
+
+            auto integers = Generate(ctx, test_size, item);
+
+            std::vector<size_t> out_vec =
+                integers.Sort(std::less<size_t>(), api::DefaultSortAlgorithm(),
+                              SortConfig()).AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+            size_t sum = 0, expected_sum = 0;
+            for (size_t i = 0; i < out_vec.size(); i++) {
+                if (i != 0) ASSERT_LE(out_vec[i - 1], out_vec[i]);
+                sum += out_vec[i];
+                expected_sum += item(i);
+            }
+            ASSERT_EQ(expected_sum, sum);
+        };
+
+    api::MemoryConfig mem_config;
+    mem_config.setup(64 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 2, start_func);
+}
+
+class RefineSplittersSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr bool refine_splitters_ = true;
+};
+
+TEST(SortConfig, RefineSplitters) {
+    TestSortWithConfig<RefineSplittersSortConfig>();
+}
+
+class TightImbalanceSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr bool refine_splitters_ = true;
+    static constexpr double desired_imbalance_ = 0.05;
+    static constexpr double max_imbalance_ = 0.01;
+    static constexpr size_t refine_oversampling_ = 8;
+};
+
+TEST(SortConfig, TightImbalance) {
+    TestSortWithConfig<TightImbalanceSortConfig>();
+}
+
+class ThinnedSampleSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr size_t max_gathered_samples_ = 64;
+};
+
+TEST(SortConfig, ThinnedSample) {
+    TestSortWithConfig<ThinnedSampleSortConfig>();
+}
+
+class ParallelMergeSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr bool use_parallel_merge_ = true;
+};
+
+TEST(SortConfig, ParallelMerge) {
+    TestSortWithConfig<ParallelMergeSortConfig>();
+}
+
+class ReplacementSelectionSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr bool use_replacement_selection_ = true;
+};
+
+TEST(SortConfig, ReplacementSelection) {
+    TestSortWithConfig<ReplacementSelectionSortConfig>();
+}
+
+class TwoLevelExchangeSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr bool use_two_level_exchange_ = true;
+};
+
+TEST(SortConfig, TwoLevelExchange) {
+    TestSortWithConfig<TwoLevelExchangeSortConfig>();
+}
+
+class PackedIntegerExchangeSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr bool use_packed_integer_exchange_ = true;
+};
+
+TEST(SortConfig, PackedIntegerExchange) {
+    TestSortWithConfig<PackedIntegerExchangeSortConfig>();
+}
+
+class FrontCodedRunsSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr bool use_front_coded_runs_ = true;
+};
+
+TEST(SortConfig, FrontCodedRuns) {
+
+    static constexpr size_t test_size = 400000u;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            // strings with long common prefixes
+            auto strings = Generate(
+                ctx, test_size,
+                [](const size_t& index) {
+                    return "http://example.org/page/" +
+                    std::to_string((index * 7919) % 1000);
+                });
+
+            std::vector<std::string> out_vec =
+                strings.Sort(std::less<std::string>(),
+                             api::DefaultSortAlgorithm(),
+                             FrontCodedRunsSortConfig()).AllGather();
+
+            ASSERT_EQ(test_size, out_vec.size());
+            for (size_t i = 1; i < out_vec.size(); i++) {
+                ASSERT_LE(out_vec[i - 1], out_vec[i]);
+            }
+            ASSERT_EQ("http://example.org/page/0", out_vec.front());
+            ASSERT_EQ("http://example.org/page/999", out_vec.back());
+        };
+
+    api::MemoryConfig mem_config;
+    mem_config.setup(64 * 1024 * 1024llu);
+
+    api::RunLocalMock(mem_config, 2, 2, start_func);
+}
+
 /******************************************************************************/
@@ -12,9 +12,11 @@
 #include <thrill/api/cache.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/reduce_by_key.hpp>
+#include <thrill/api/sort.hpp>
 
 #include <algorithm>
 #include <random>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -219,4 +221,133 @@ TEST(Stage, AdditionalChildReferences) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Stage, ConsumeUnreferencedNodes) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            DIA<int> data = Generate(
+                ctx, 1000,
+                [](const size_t& index) {
+                    return static_cast<int>(index);
+                }).Cache();
+
+            // the first Cache remains referenced by a DIA
+            DIA<int> kept = data;
+
+            for (size_t round = 0; round < 3; ++round) {
+                // after reassignment, the previous Cache is only referenced by
+                // its child, and is consumed while pushing into it.
+                data = data.Map([](int in) { return in + 1; }).Cache();
+            }
+
+            std::vector<int> out_vec = data.AllGather();
+            ASSERT_EQ(1000u, out_vec.size());
+            for (size_t i = 0; i < out_vec.size(); ++i) {
+                ASSERT_EQ(static_cast<int>(i) + 3, out_vec[i]);
+            }
+
+            // referenced DIAs are not consumed
+            std::vector<int> kept_vec = kept.AllGather();
+            ASSERT_EQ(1000u, kept_vec.size());
+            for (size_t i = 0; i < kept_vec.size(); ++i) {
+                ASSERT_EQ(static_cast<int>(i), kept_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Stage, RecomputableSourcesAreNotConsumed) {
+
+    auto start_func =
+        [](Context& ctx) {
+            ctx.enable_consume();
+
+            auto integers = Generate(
+                ctx, 1000,
+                [](const size_t& index) {
+                    return static_cast<int>(index);
+                });
+
+            // Generate regenerates its items, hence no Keep() is needed
+            for (size_t round = 0; round < 3; ++round) {
+                std::vector<int> out_vec = integers.AllGather();
+                ASSERT_EQ(1000u, out_vec.size());
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Stage, Explain) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            auto integers = Generate(
+                ctx, 1000,
+                [](const size_t& index) {
+                    return index;
+                });
+
+            auto reduced =
+                integers
+                .Map([](const size_t& i) { return i % 10; })
+                .Filter([](const size_t& i) { return i != 0; })
+                .ReduceByKey([](const size_t& i) { return i; },
+                             std::plus<size_t>());
+
+            auto sorted = reduced.Sort().Map(
+                [](const size_t& i) { return i + 1; });
+
+            // plan before execution
+            std::ostringstream plan;
+            sorted.Explain(plan);
+            std::string p = plan.str();
+
+            ASSERT_NE(std::string::npos, p.find(
+                          "stage 1: Generate.1 Execute(), PushData()"));
+            ASSERT_NE(std::string::npos, p.find(
+                          "stage 3: Sort.5 Execute()"));
+            ASSERT_NE(std::string::npos, p.find(
+                          "parent: Generate.1 -> Map.2 -> Filter.3"));
+            ASSERT_NE(std::string::npos, p.find("impl: pre-phase table"));
+            ASSERT_NE(std::string::npos, p.find("impl: sample sort"));
+            ASSERT_NE(std::string::npos, p.find("LOps: Sort.5 -> Map.6"));
+            ASSERT_EQ(std::string::npos, p.find("pushed"));
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+            ASSERT_EQ(9u, out_vec.size());
+
+            // all nodes after execution show the items they pushed
+            std::ostringstream nodes;
+            ctx.Explain(nodes);
+            std::string n = nodes.str();
+
+            ASSERT_NE(std::string::npos, n.find("Sort.5 [EXECUTED]"));
+            ASSERT_NE(std::string::npos, n.find("item 8 bytes, pushed "));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Stage, DistributeMaxMemUse) {
+    // equal shares if no weight is known
+    ASSERT_EQ(std::vector<size_t>({ 300, 300, 300 }),
+              api::DistributeMaxMemUse(900, { 0, 0, 0 }));
+
+    // shares in proportion to the weights
+    ASSERT_EQ(std::vector<size_t>({ 100, 300, 500 }),
+              api::DistributeMaxMemUse(900, { 8, 24, 40 }));
+
+    // unknown weights get the average of the known ones
+    ASSERT_EQ(std::vector<size_t>({ 200, 400, 600 }),
+              api::DistributeMaxMemUse(1200, { 8, 0, 24 }));
+
+    // a single node gets all remaining memory
+    ASSERT_EQ(std::vector<size_t>({ 1000 }),
+              api::DistributeMaxMemUse(1000, { 16 }));
+}
+
 /******************************************************************************/
@@ -22,6 +22,7 @@
 #include <random>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 using namespace thrill; // NOLINT
@@ -151,6 +152,43 @@ TEST(ZipNode, TwoDisbalancedIntegerArrays) {
     api::RunLocalTests(start_func);
 }
 
+TEST(ZipNode, TwoAlmostAlignedIntegerArrays) {
+
+    // both DIAs are filtered from the same DIA, and only differ by one item at
+    // the ends, hence they keep their distribution and only boundary items
+    // are moved.
+    auto start_func =
+        [](Context& ctx) {
+
+            auto input = Generate(
+                ctx, test_size,
+                [](size_t index) { return index; });
+
+            // numbers 1..999
+            auto zip_input1 = input.Filter(
+                [](size_t i) { return i != 0; });
+
+            // numbers 0..998
+            auto zip_input2 = input.Filter(
+                [](size_t i) { return i != test_size - 1; });
+
+            auto zip_result = zip_input1.Zip(
+                zip_input2, [](size_t a, size_t b) {
+                    return std::make_pair(a, b);
+                });
+
+            std::vector<std::pair<size_t, size_t> > res =
+                zip_result.AllGather();
+
+            ASSERT_EQ(test_size - 1, res.size());
+            for (size_t i = 0; i != res.size(); ++i) {
+                ASSERT_EQ(std::make_pair(i + 1, i), res[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(ZipNode, TwoDisbalancedIntegerArraysZipWithIndex) {
 
     // first DIA is heavily balanced to the first workers, second DIA is
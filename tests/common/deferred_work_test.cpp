@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * tests/common/deferred_work_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/concurrent_bounded_queue.hpp>
+#include <thrill/common/deferred_work.hpp>
+#include <thrill/common/thread_barrier.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace thrill;
+
+TEST(DeferredWork, RunInOrderWithoutNesting) {
+
+    std::vector<size_t> order;
+
+    common::DeferredWork::Post([&]() {
+                                   order.push_back(0);
+                                   // nested runs do nothing
+                                   ASSERT_FALSE(common::DeferredWork::RunOne());
+                                   common::DeferredWork::Post(
+                                       [&]() { order.push_back(2); });
+                               });
+    common::DeferredWork::Post([&]() { order.push_back(1); });
+    ASSERT_EQ(2u, common::DeferredWork::size());
+
+    ASSERT_TRUE(common::DeferredWork::RunOne());
+    common::DeferredWork::RunAll();
+
+    ASSERT_EQ(0u, common::DeferredWork::size());
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2 }), order);
+    ASSERT_FALSE(common::DeferredWork::RunOne());
+}
+
+TEST(DeferredWork, RunWhileWaitingInBarrier) {
+
+    static constexpr size_t num_threads = 4;
+    common::ThreadBarrierTree barrier(num_threads);
+    barrier.set_idle_function(
+        []() { return common::DeferredWork::RunOne(); });
+
+    common::ConcurrentBoundedQueue<size_t> release;
+    std::atomic<size_t> done { 0 };
+
+    std::vector<std::thread> threads;
+    for (size_t id = 0; id < num_threads; ++id) {
+        threads.emplace_back(
+            [&, id]() {
+                if (id == 0) {
+                    // the straggler arrives after all others ran their work
+                    size_t x;
+                    for (size_t i = 1; i < num_threads; ++i)
+                        release.pop(x);
+                }
+                else {
+                    common::DeferredWork::Post(
+                        [&]() { ++done; release.push(1); });
+                }
+                barrier.wait(id);
+                ASSERT_EQ(0u, common::DeferredWork::size());
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    ASSERT_EQ(num_threads - 1, done);
+}
+
+/******************************************************************************/
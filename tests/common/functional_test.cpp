@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * tests/common/functional_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/functional.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+TEST(Functional, ComponentSumArray) {
+    using Array = std::array<double, 5>;
+
+    Array a = { { 1, 5, 3, -2, 0 } };
+    Array b = { { 4, 2, 3, -1, 7 } };
+
+    Array sum = common::ComponentSum<Array>()(a, b);
+    ASSERT_EQ((Array { { 5, 7, 6, -3, 7 } }), sum);
+
+    Array min = a;
+    common::ComponentMin<Array>().Accumulate(min, b);
+    ASSERT_EQ((Array { { 1, 2, 3, -2, 0 } }), min);
+
+    Array max = a;
+    common::ComponentMax<Array>().Accumulate(max, b);
+    ASSERT_EQ((Array { { 4, 5, 3, -1, 7 } }), max);
+}
+
+TEST(Functional, ComponentSumVector) {
+    using Vector = std::vector<size_t>;
+
+    Vector a = { 1, 2, 3, 4 };
+    common::ComponentSum<Vector> sum_op;
+
+    Vector sum = a;
+    sum_op.Accumulate(sum, Vector { 10, 20, 30, 40 });
+    ASSERT_EQ((Vector { 11, 22, 33, 44 }), sum);
+    ASSERT_EQ(sum, sum_op(a, Vector { 10, 20, 30, 40 }));
+
+    // combine into a segment
+    sum_op.Accumulate(a, 1, Vector { 5, 5 });
+    ASSERT_EQ((Vector { 1, 7, 8, 4 }), a);
+}
+
+TEST(Functional, ReduceAssign) {
+    // functor with Accumulate() reduces in place
+    std::vector<int> v = { 1, 2, 3 };
+    common::ComponentSum<std::vector<int> > sum_op;
+    const int* data = v.data();
+    common::ReduceAssign(sum_op, v, std::vector<int>({ 3, 2, 1 }));
+    ASSERT_EQ((std::vector<int> { 4, 4, 4 }), v);
+    ASSERT_EQ(data, v.data());
+
+    // any other is called, in order
+    std::string s = "a";
+    auto concat = [](const std::string& x, const std::string& y) {
+                      return x + y;
+                  };
+    common::ReduceAssign(concat, s, std::string("b"));
+    ASSERT_EQ("ab", s);
+}
+
+/******************************************************************************/
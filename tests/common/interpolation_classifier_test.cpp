@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * tests/common/interpolation_classifier_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/interpolation_classifier.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace thrill;
+
+template <typename Integer>
+void TestClassifier(const std::vector<Integer>& splitters,
+                    const std::vector<Integer>& items) {
+    common::InterpolationClassifier<Integer> cls(
+        splitters.data(), splitters.size());
+
+    for (const Integer& x : items) {
+        size_t b = std::upper_bound(splitters.begin(), splitters.end(), x)
+                   - splitters.begin();
+        ASSERT_EQ(b, cls.Classify(x));
+    }
+}
+
+TEST(InterpolationClassifier, UniformUInt64) {
+    std::mt19937_64 rng(123);
+
+    std::vector<uint64_t> splitters(127), items(100000);
+    for (uint64_t& s : splitters) s = rng();
+    for (uint64_t& x : items) x = rng();
+    std::sort(splitters.begin(), splitters.end());
+
+    common::InterpolationClassifier<uint64_t> cls(
+        splitters.data(), splitters.size());
+    ASSERT_TRUE(cls.good());
+
+    items.push_back(0);
+    items.push_back(splitters.front());
+    items.push_back(splitters.back());
+    items.push_back(UINT64_MAX);
+    TestClassifier(splitters, items);
+}
+
+TEST(InterpolationClassifier, SignedWithDuplicates) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int32_t> dist(-1000, 1000);
+
+    std::vector<int32_t> splitters(63), items(100000);
+    for (int32_t& s : splitters) s = dist(rng);
+    for (int32_t& x : items) x = dist(rng) * 2;
+    std::sort(splitters.begin(), splitters.end());
+    splitters[10] = splitters[11] = splitters[12];
+
+    TestClassifier(splitters, items);
+}
+
+TEST(InterpolationClassifier, SkewedAndEqual) {
+    std::vector<uint32_t> splitters, items;
+    for (uint32_t i = 0; i < 31; ++i) splitters.push_back(i < 30 ? i : 1u << 31);
+    for (uint32_t i = 0; i < 100; ++i) items.push_back(i * 1234567u);
+
+    common::InterpolationClassifier<uint32_t> cls(
+        splitters.data(), splitters.size());
+    ASSERT_FALSE(cls.good());
+    TestClassifier(splitters, items);
+
+    std::vector<uint32_t> equal(15, 7);
+    TestClassifier(equal, items);
+}
+
+/******************************************************************************/
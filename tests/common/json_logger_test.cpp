@@ -11,8 +11,14 @@
 #include <thrill/common/json_logger.hpp>
 
 #include <gtest/gtest.h>
+#include <thrill/vfs/temporary_directory.hpp>
+#include <tlx/die.hpp>
+#include <tlx/string/ends_with.hpp>
 
+#include <cstdio>
+#include <fstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace thrill;
@@ -53,4 +59,101 @@ TEST(JsonLogger, Sublogger) {
     sub_sub_logger << "test" << "output";
 }
 
+//! write the same events to a logger
+static void WriteEvents(common::JsonLogger& logger) {
+    common::JsonLogger sub_logger(&logger, "host_rank", 3);
+
+    sub_logger << "Node" << "Sort\nNode \"quoted\""
+               << "bool" << false
+               << "int" << -5
+               << "size" << size_t(1) << "double" << 1.5
+               << "vector" << std::vector<int>({ 6, -9, 42 })
+               << "string vector" << std::vector<const char*>({ "a", "b" });
+
+    common::JsonLine line = sub_logger.line();
+    line << "Node" << "LongerLine";
+    {
+        common::JsonLine subitem = line.sub("sub");
+        subitem << "inside" << 0.25;
+    }
+    line << "more" << 42;
+}
+
+//! read lines, replacing the timestamps
+static std::vector<std::string> ReadEvents(const std::string& path) {
+    std::vector<std::string> lines;
+    FILE* in = fopen(path.c_str(), "rb");
+    die_unless(in);
+
+    std::string line;
+    if (tlx::ends_with(path, ".trace")) {
+        common::JsonTraceReader reader(in);
+        while (reader.Next(line))
+            lines.emplace_back(line.substr(line.find(',')));
+    }
+    else {
+        std::ifstream is(path);
+        while (std::getline(is, line))
+            lines.emplace_back(line.substr(line.find(',')));
+    }
+    fclose(in);
+    return lines;
+}
+
+TEST(JsonLogger, BinaryTraceMatchesJson) {
+    vfs::TemporaryDirectory tmpdir;
+    {
+        common::JsonLogger json_logger(tmpdir.get() + "/log.json");
+        WriteEvents(json_logger);
+        common::JsonLogger trace_logger(tmpdir.get() + "/log.trace");
+        WriteEvents(trace_logger);
+    }
+
+    std::vector<std::string> json = ReadEvents(tmpdir.get() + "/log.json");
+    std::vector<std::string> trace = ReadEvents(tmpdir.get() + "/log.trace");
+    ASSERT_EQ(2u, json.size());
+    ASSERT_EQ(json, trace);
+}
+
+TEST(JsonLogger, BinaryTraceThreads) {
+    vfs::TemporaryDirectory tmpdir;
+
+    const size_t num_threads = 4, num_lines = 20000;
+    {
+        // small rings to make the threads wait for the flusher
+        common::JsonLogger logger;
+        logger.trace_ = std::make_unique<common::JsonTraceWriter>(
+            std::make_unique<std::ofstream>(
+                tmpdir.get() + "/log.trace", std::ios::binary), 4096);
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back(
+                [&logger, t]() {
+                    for (size_t i = 0; i < num_lines; ++i)
+                        logger << "thread" << t << "i" << i;
+                });
+        }
+        for (std::thread& t : threads)
+            t.join();
+    }
+
+    FILE* in = fopen((tmpdir.get() + "/log.trace").c_str(), "rb");
+    common::JsonTraceReader reader(in);
+    std::vector<size_t> next(num_threads);
+    std::string line;
+    while (reader.Next(line)) {
+        size_t t, i;
+        ASSERT_EQ(2, sscanf(line.c_str() + line.find("\"thread\""),
+                            "\"thread\":%zu,\"i\":%zu", &t, &i));
+        // lines of each thread are in order
+        ASSERT_EQ(next[t], i);
+        ++next[t];
+    }
+    fclose(in);
+
+    for (size_t t = 0; t < num_threads; ++t)
+        ASSERT_EQ(num_lines, next[t]);
+}
+
 /******************************************************************************/
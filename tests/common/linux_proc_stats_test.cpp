@@ -0,0 +1,42 @@
+/*******************************************************************************
+ * tests/common/linux_proc_stats_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/linux_proc_stats.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace thrill;
+
+static size_t ParseLimit(const std::string& content) {
+    std::istringstream in(content);
+    return common::ParseCgroupMemoryLimit(in);
+}
+
+TEST(LinuxProcStats, CgroupV2MemoryMax) {
+    // memory.max: "max" if unlimited, else the limit in bytes
+    ASSERT_EQ(0u, ParseLimit("max\n"));
+    ASSERT_EQ(536870912u, ParseLimit("536870912\n"));
+    ASSERT_EQ(4096u, ParseLimit("4096"));
+}
+
+TEST(LinuxProcStats, CgroupV1MemoryLimitInBytes) {
+    // memory.limit_in_bytes: a page-aligned LONG_MAX if unlimited
+    ASSERT_EQ(0u, ParseLimit("9223372036854771712\n"));
+    ASSERT_EQ(2147483648u, ParseLimit("2147483648\n"));
+}
+
+TEST(LinuxProcStats, CgroupMemoryLimitGarbage) {
+    ASSERT_EQ(0u, ParseLimit(""));
+    ASSERT_EQ(0u, ParseLimit("\n"));
+    ASSERT_EQ(0u, ParseLimit("12k\n"));
+    ASSERT_EQ(0u, ParseLimit("0\n"));
+}
+
+/******************************************************************************/
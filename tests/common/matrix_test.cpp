@@ -33,4 +33,38 @@ TEST(Matrix, Simple) {
     ASSERT_EQ(matrix2, matrix1);
 }
 
+TEST(Matrix, Multiply) {
+    using DMatrix = common::Matrix<double>;
+
+    // sizes larger than the cache blocks
+    size_t m = 70, k = 300, n = 5;
+    DMatrix a(m, k), b(k, n);
+    for (size_t i = 0; i < m; ++i)
+        for (size_t j = 0; j < k; ++j) a(i, j) = static_cast<double>(i + j % 7);
+    for (size_t i = 0; i < k; ++i)
+        for (size_t j = 0; j < n; ++j) b(i, j) = static_cast<double>(i * j % 5);
+
+    DMatrix c = a.Multiply(b);
+    ASSERT_EQ(m, c.rows());
+    ASSERT_EQ(n, c.columns());
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double sum = 0;
+            for (size_t l = 0; l < k; ++l) sum += a(i, l) * b(l, j);
+            ASSERT_DOUBLE_EQ(sum, c(i, j));
+        }
+    }
+
+    // transpose(a) * a, and vector products
+    DMatrix g = a.TransposeMultiply(a);
+    std::vector<double> x(k, 1.0), y(m), z(k, 0.0);
+    a.MultiplyVector(x.data(), y.data());
+    a.TransposeMultiplyVector(y.data(), z.data());
+    for (size_t i = 0; i < k; ++i) {
+        double sum = 0;
+        for (size_t j = 0; j < k; ++j) sum += g(i, j);
+        ASSERT_NEAR(sum, z[i], 1e-9 * sum);
+    }
+}
+
 /******************************************************************************/
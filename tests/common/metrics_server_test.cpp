@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * tests/common/metrics_server_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/config.hpp>
+#include <thrill/common/metrics_server.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#if THRILL_HAVE_NET_TCP
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace thrill;
+
+TEST(MetricsServer, Render) {
+    common::MetricsServer metrics(0, "host_rank=\"1\"");
+
+    metrics.Set("thrill_block_pool_total_bytes", 4096);
+    metrics.Set("thrill_io_bytes_total{op=\"read\"}", 10);
+    metrics.Set("thrill_io_bytes_total{op=\"write\"}", 20);
+    metrics.SetWorkerStage(3, 7, "Sort \"x\"", "execute");
+
+    std::string text = metrics.Render();
+
+    EXPECT_NE(std::string::npos, text.find(
+                  "# TYPE thrill_block_pool_total_bytes gauge\n"
+                  "thrill_block_pool_total_bytes{host_rank=\"1\"} 4096\n"));
+    EXPECT_NE(std::string::npos, text.find(
+                  "# TYPE thrill_io_bytes_total gauge\n"
+                  "thrill_io_bytes_total{host_rank=\"1\",op=\"read\"} 10\n"
+                  "thrill_io_bytes_total{host_rank=\"1\",op=\"write\"} 20\n"));
+    EXPECT_NE(std::string::npos, text.find(
+                  "thrill_worker_stage{host_rank=\"1\",worker_rank=\"3\","
+                  "dia_id=\"7\",label=\"Sort \\\"x\\\"\",event=\"execute\"} 1\n"));
+
+    metrics.SetWorkerStage(3, 0, std::string(), "idle");
+    text = metrics.Render();
+    EXPECT_NE(std::string::npos, text.find(
+                  "thrill_worker_stages{host_rank=\"1\",worker_rank=\"3\"} 1\n"));
+}
+
+#if THRILL_HAVE_NET_TCP
+
+TEST(MetricsServer, Http) {
+    common::MetricsServer metrics(0, "host_rank=\"0\"");
+    ASSERT_NE(0u, metrics.port());
+
+    metrics.Set("thrill_test_gauge", 42);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(metrics.port());
+    ASSERT_EQ(0, connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                         sizeof(addr)));
+
+    std::string request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_EQ(static_cast<ssize_t>(request.size()),
+              send(fd, request.data(), request.size(), 0));
+
+    std::string response;
+    char buffer[1024];
+    ssize_t rb;
+    while ((rb = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        response.append(buffer, static_cast<size_t>(rb));
+    close(fd);
+
+    EXPECT_EQ(0u, response.find("HTTP/1.0 200 OK\r\n"));
+    EXPECT_NE(std::string::npos,
+              response.find("thrill_test_gauge{host_rank=\"0\"} 42\n"));
+}
+
+#endif
+
+/******************************************************************************/
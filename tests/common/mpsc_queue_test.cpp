@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * tests/common/mpsc_queue_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/mpsc_queue.hpp>
+#include <tlx/thread_pool.hpp>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+using namespace thrill::common;
+
+TEST(MpscQueue, ParallelPushPopAscIntegerAndCalculateTotalSum) {
+    tlx::ThreadPool pool(8);
+
+    MpscQueue<size_t> queue;
+    std::atomic<size_t> count(0);
+    std::atomic<size_t> total_sum(0);
+
+    static constexpr size_t num_threads = 4;
+    static constexpr size_t num_pushes = 10000;
+
+    // have threads push items
+
+    for (size_t i = 0; i != num_threads; ++i) {
+        pool.enqueue([&queue]() {
+                         for (size_t i = 0; i != num_pushes; ++i) {
+                             queue.push(i);
+                         }
+                     });
+    }
+
+    // have one thread pop() items, parking while the queue is empty.
+
+    pool.enqueue([&]() {
+                     while (count != num_threads * num_pushes) {
+                         size_t item;
+                         queue.pop(item);
+                         total_sum += item;
+                         ++count;
+                     }
+                 });
+
+    pool.loop_until_empty();
+
+    ASSERT_TRUE(queue.empty());
+    ASSERT_EQ(count, num_threads * num_pushes);
+    // check total sum, no item gets lost?
+    ASSERT_EQ(total_sum, num_threads * num_pushes * (num_pushes - 1) / 2);
+}
+
+TEST(MpscQueue, ItemsOfEachProducerInOrder) {
+    tlx::ThreadPool pool(8);
+
+    using Item = std::pair<size_t, size_t>;
+    MpscQueue<Item> queue;
+
+    static constexpr size_t num_threads = 4;
+    static constexpr size_t num_pushes = 10000;
+
+    for (size_t t = 0; t != num_threads; ++t) {
+        pool.enqueue([&queue, t]() {
+                         for (size_t i = 0; i != num_pushes; ++i) {
+                             queue.emplace(t, i);
+                         }
+                     });
+    }
+
+    // the items of each producer arrive in push order, possibly interleaved
+    std::vector<size_t> next(num_threads, 0);
+    for (size_t c = 0; c != num_threads * num_pushes; ++c) {
+        Item item;
+        queue.pop(item);
+        ASSERT_EQ(next[item.first], item.second);
+        ++next[item.first];
+    }
+
+    pool.loop_until_empty();
+
+    Item item;
+    ASSERT_FALSE(queue.try_pop(item));
+    ASSERT_TRUE(queue.empty());
+}
+
+/******************************************************************************/
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * tests/common/parallel_sort_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/parallel_sort.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace thrill;
+
+TEST(ParallelSort, RandomIntegers) {
+
+    std::default_random_engine rng(std::random_device { } ());
+
+    for (size_t threads : { 1, 2, 3, 4, 7, 8 }) {
+        size_t test_size = 1024000 + rng() % 20480;
+        std::vector<size_t> vec(test_size);
+        for (size_t i = 0; i < test_size; ++i)
+            vec[i] = rng() % 100000;
+
+        std::vector<size_t> check = vec;
+        std::sort(check.begin(), check.end());
+
+        common::ParallelSort sorter(threads);
+        sorter(vec.begin(), vec.end(), std::less<size_t>());
+
+        ASSERT_EQ(check, vec);
+    }
+}
+
+TEST(ParallelSort, StableOnEqualKeys) {
+
+    std::default_random_engine rng(std::random_device { } ());
+
+    using Pair = std::pair<size_t, size_t>;
+
+    auto cmp = [](const Pair& a, const Pair& b) { return a.first < b.first; };
+
+    for (size_t threads : { 2, 5, 8 }) {
+        size_t test_size = 512000 + rng() % 20480;
+        std::vector<Pair> vec(test_size);
+        for (size_t i = 0; i < test_size; ++i)
+            vec[i] = Pair(rng() % 100, i);
+
+        common::ParallelStableSort sorter(threads);
+        sorter(vec.begin(), vec.end(), cmp);
+
+        for (size_t i = 1; i < vec.size(); ++i) {
+            ASSERT_FALSE(cmp(vec[i], vec[i - 1]));
+            if (vec[i].first == vec[i - 1].first) {
+                ASSERT_LT(vec[i - 1].second, vec[i].second);
+            }
+        }
+    }
+}
+
+/******************************************************************************/
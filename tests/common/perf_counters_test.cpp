@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * tests/common/perf_counters_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/perf_counters.hpp>
+
+#include <gtest/gtest.h>
+#include <thrill/common/json_logger.hpp>
+#include <thrill/vfs/temporary_directory.hpp>
+
+#include <fstream>
+#include <string>
+
+using namespace thrill;
+
+TEST(PerfCounters, ScopesRestoreDIA) {
+    size_t outer = common::PerfCounterProfiler::SetThreadDIA(0);
+    {
+        common::PerfCounterScope scope1(5);
+        {
+            common::PerfCounterScope scope2(7);
+            ASSERT_EQ(7u, common::PerfCounterProfiler::SetThreadDIA(7));
+        }
+        ASSERT_EQ(5u, common::PerfCounterProfiler::SetThreadDIA(5));
+    }
+    ASSERT_EQ(0u, common::PerfCounterProfiler::SetThreadDIA(outer));
+}
+
+TEST(PerfCounters, AttributeCountsToDIA) {
+    vfs::TemporaryDirectory tmpdir;
+    const std::string path = tmpdir.get() + "/log.json";
+    {
+        common::JsonLogger logger(path);
+        common::PerfCounterProfiler profiler(logger);
+
+        // the kernel may refuse the counters, e.g. in containers
+        if (!profiler.AddThread(/* worker_rank */ 3)) return;
+
+        {
+            common::PerfCounterScope scope(42);
+            volatile size_t sum = 0;
+            for (size_t i = 0; i < 10000000; ++i) sum = sum + i;
+        }
+        profiler.RemoveThread();
+    }
+
+    bool found = false;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find("\"class\":\"PerfCounters\"") == std::string::npos)
+            continue;
+        ASSERT_NE(std::string::npos, line.find("\"worker_rank\":3"));
+        found = found || line.find("\"dia_id\":42") != std::string::npos;
+    }
+    ASSERT_TRUE(found);
+}
+
+/******************************************************************************/
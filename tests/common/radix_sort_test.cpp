@@ -8,12 +8,14 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
+#include <thrill/common/lsd_radix_sort.hpp>
 #include <thrill/common/radix_sort.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
 #include <random>
+#include <utility>
 #include <vector>
 
 using namespace thrill;
@@ -51,4 +53,57 @@ TEST(RadixSort, RandomStrings) {
     ASSERT_TRUE(std::is_sorted(vec.begin(), vec.end()));
 }
 
+template <typename Key>
+void TestLsdRadixSort(size_t test_size, size_t num_threads) {
+
+    std::default_random_engine rng(std::random_device { } ());
+
+    // pairs of random keys and their original position, for stability
+    std::vector<std::pair<Key, size_t> > vec(test_size);
+    for (size_t i = 0; i < test_size; ++i) {
+        vec[i].first = static_cast<Key>(
+            (static_cast<uint64_t>(rng()) << 32) ^ rng());
+        // some keys with few distinct values, to exercise skipped passes
+        if (i % 2 == 0) vec[i].first = static_cast<Key>(i % 7);
+        vec[i].second = i;
+    }
+
+    common::lsd_radix_sort(
+        vec.begin(), vec.end(),
+        [](const std::pair<Key, size_t>& p) { return p.first; }, num_threads);
+
+    ASSERT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+}
+
+TEST(LsdRadixSort, RandomKeys) {
+    TestLsdRadixSort<uint32_t>(1000000, 1);
+    TestLsdRadixSort<uint64_t>(1000000, 1);
+    TestLsdRadixSort<int64_t>(1000000, 1);
+    TestLsdRadixSort<int32_t>(33, 1);
+    TestLsdRadixSort<uint64_t>(1000000, 4);
+    TestLsdRadixSort<int64_t>(1000000, 3);
+}
+
+TEST(LsdRadixSort, SameKeys) {
+    std::vector<uint64_t> vec(100000, 42);
+    common::lsd_radix_sort(vec.begin(), vec.end(),
+                           [](const uint64_t& x) { return x; });
+    ASSERT_TRUE(std::all_of(vec.begin(), vec.end(),
+                            [](const uint64_t& x) { return x == 42; }));
+}
+
+#if defined(__SIZEOF_INT128__)
+TEST(LsdRadixSort, UInt128Keys) {
+    std::default_random_engine rng(std::random_device { } ());
+
+    std::vector<unsigned __int128> vec(100000);
+    for (unsigned __int128& x : vec)
+        x = (static_cast<unsigned __int128>(rng()) << 96) ^ rng();
+
+    common::lsd_radix_sort(vec.begin(), vec.end(),
+                           [](const unsigned __int128& x) { return x; });
+    ASSERT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+}
+#endif
+
 /******************************************************************************/
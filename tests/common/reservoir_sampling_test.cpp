@@ -16,6 +16,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <fstream>
 #include <vector>
 
@@ -70,4 +71,49 @@ TEST(ReservoirSampling, Simple) {
     // }
 }
 
+TEST(ReservoirSampling, Weighted) {
+
+    // item range inserted, with weights 0, 1, 2, 3 cycling
+    static const size_t range = 1000;
+    // number of rounds for histogram
+    static const size_t rounds = 100000;
+
+    std::default_random_engine rng(std::random_device { } ());
+    std::vector<size_t> histogram(4);
+
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        common::WeightedReservoirSampling<size_t> rs(1, rng);
+
+        for (size_t i = 0; i < range; ++i)
+            rs.add(i, static_cast<double>(i % 4));
+
+        ASSERT_EQ(1u, rs.samples().size());
+        histogram[rs.samples()[0].second % 4]++;
+    }
+
+    // a single sample is item i with probability weight(i) / total weight
+    ASSERT_EQ(0u, histogram[0]);
+    for (size_t w = 1; w < 4; ++w) {
+        double p = static_cast<double>(histogram[w]) / rounds;
+        sLOG1 << "weight" << w << "sampled with p =" << p;
+        ASSERT_NEAR(w / 6.0, p, 0.01);
+    }
+
+    // a larger sample contains distinct items with positive weight
+    common::WeightedReservoirSampling<size_t> rs(100, rng);
+    for (size_t i = 0; i < range; ++i)
+        rs.add(i, static_cast<double>(i % 4));
+
+    std::vector<size_t> samples;
+    for (const auto& x : rs.samples())
+        samples.push_back(x.second);
+    std::sort(samples.begin(), samples.end());
+
+    ASSERT_EQ(100u, samples.size());
+    ASSERT_EQ(samples.end(), std::unique(samples.begin(), samples.end()));
+    for (const size_t& x : samples)
+        ASSERT_NE(0u, x % 4);
+}
+
 /******************************************************************************/
@@ -0,0 +1,122 @@
+/*******************************************************************************
+ * tests/common/sample_sort_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/sample_sort.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+template <typename Type>
+static void test_sample_sort(std::vector<Type> vec) {
+    std::vector<Type> check = vec;
+    std::sort(check.begin(), check.end());
+
+    common::SampleSort()(vec.begin(), vec.end(), std::less<Type>());
+
+    ASSERT_EQ(check, vec);
+}
+
+TEST(SampleSort, RandomIntegers) {
+
+    std::default_random_engine rng(std::random_device { } ());
+
+    for (size_t test_size : { 0, 1, 100, 5000, 1024000 }) {
+        std::vector<size_t> vec(test_size);
+        for (size_t i = 0; i < test_size; ++i)
+            vec[i] = rng();
+        test_sample_sort(vec);
+    }
+}
+
+TEST(SampleSort, FewDistinctIntegers) {
+
+    std::default_random_engine rng(std::random_device { } ());
+
+    for (size_t distinct : { 1, 2, 10, 1000 }) {
+        size_t test_size = 1024000 + rng() % 20480;
+        std::vector<size_t> vec(test_size);
+        for (size_t i = 0; i < test_size; ++i)
+            vec[i] = rng() % distinct;
+        test_sample_sort(vec);
+    }
+}
+
+TEST(SampleSort, RandomStrings) {
+
+    std::default_random_engine rng(std::random_device { } ());
+
+    size_t test_size = 102400 + rng() % 20480;
+    std::vector<std::string> vec(test_size);
+    for (size_t i = 0; i < test_size; ++i)
+        vec[i] = std::to_string(rng() % 100000);
+    test_sample_sort(vec);
+}
+
+template <typename Type, typename Comparator>
+static void test_classify_batch(std::vector<Type> splitters,
+                                const std::vector<Type>& items,
+                                const Comparator& cmp) {
+    std::sort(splitters.begin(), splitters.end(), cmp);
+    size_t log_k = 0;
+    while ((size_t(1) << log_k) <= splitters.size()) ++log_k;
+    ASSERT_EQ((size_t(1) << log_k) - 1, splitters.size());
+
+    std::vector<Type> tree(splitters.size() + 1);
+    common::BuildSplitterTree(tree.data(), splitters.data(), splitters.size(),
+                              [](const Type& t) { return t; });
+
+    std::vector<size_t> bucket(items.size());
+    common::ClassifySplitterTreeBatch(
+        tree.data(), log_k, items.data(), items.size(), bucket.data(), cmp);
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        // bucket b contains items x with splitter[b-1] <= x < splitter[b]
+        size_t expected = std::upper_bound(
+            splitters.begin(), splitters.end(), items[i], cmp)
+                          - splitters.begin();
+        ASSERT_EQ(expected, bucket[i]);
+        ASSERT_EQ(expected, common::ClassifySplitterTree(
+                      tree.data(), log_k, items[i], cmp));
+    }
+}
+
+TEST(SampleSort, ClassifyBatch) {
+
+    std::default_random_engine rng(std::random_device { } ());
+
+    // odd batch sizes leave a remainder after the four-item AVX2 steps
+    for (size_t n : { 0, 1, 7, 16, 1001 }) {
+        for (size_t num_splitters : { 1, 3, 15, 127 }) {
+            std::vector<uint64_t> us(num_splitters), ui(n);
+            std::vector<int64_t> ss(num_splitters), si(n);
+            for (size_t i = 0; i < num_splitters; ++i) {
+                // large unsigned values test the flipped sign bit
+                us[i] = (uint64_t(rng()) << 32) ^ rng();
+                ss[i] = static_cast<int64_t>(us[i]);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                // some items equal a splitter
+                ui[i] = (i % 5 == 0) ? us[i % num_splitters]
+                        : (uint64_t(rng()) << 32) ^ rng();
+                si[i] = static_cast<int64_t>(ui[i]);
+            }
+            test_classify_batch(us, ui, std::less<uint64_t>());
+            test_classify_batch(ss, si, std::less<int64_t>());
+            test_classify_batch(us, ui, std::greater<uint64_t>());
+        }
+    }
+}
+
+/******************************************************************************/
@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * tests/common/sharded_counter_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/sharded_counter.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace thrill::common;
+
+TEST(ShardedCounter, ParallelAddsAreSummed) {
+    ShardedCounter counter;
+
+    static constexpr size_t num_threads = 48;
+    static constexpr size_t num_adds = 10000;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&counter, t]() {
+                for (size_t i = 0; i < num_adds; ++i) {
+                    ++counter;
+                    counter += t;
+                }
+            });
+    }
+    for (std::thread& t : threads)
+        t.join();
+
+    ASSERT_EQ(num_threads * num_adds
+              + num_adds * num_threads * (num_threads - 1) / 2,
+              counter.value());
+}
+
+TEST(ShardedCounter, ScopedTscTimerMeasuresSleep) {
+    using namespace std::literals;
+    ShardedCounter ticks;
+
+    {
+        ScopedTscTimer timer(ticks);
+        std::this_thread::sleep_for(10ms);
+    }
+
+    double seconds = static_cast<double>(ticks.value())
+                     * TscNanosPerTick() / 1e9;
+    ASSERT_GE(seconds, 0.009);
+    ASSERT_LT(seconds, 10.0);
+}
+
+/******************************************************************************/
@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * tests/common/stack_sampler_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/stack_sampler.hpp>
+
+#include <gtest/gtest.h>
+#include <thrill/common/json_logger.hpp>
+#include <thrill/vfs/temporary_directory.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+using namespace thrill;
+
+TEST(StackSampler, ScopesRestoreDIA) {
+    std::pair<size_t, const char*> outer =
+        common::StackSampler::SetThreadDIA(0, nullptr);
+    {
+        common::StackSamplerScope scope1(5, "Sort");
+        {
+            common::StackSamplerScope scope2(7, "Map");
+            std::pair<size_t, const char*> cur =
+                common::StackSampler::SetThreadDIA(7, "Map");
+            ASSERT_EQ(7u, cur.first);
+            ASSERT_STREQ("Map", cur.second);
+        }
+        std::pair<size_t, const char*> cur =
+            common::StackSampler::SetThreadDIA(5, "Sort");
+        ASSERT_EQ(5u, cur.first);
+        ASSERT_STREQ("Sort", cur.second);
+    }
+    ASSERT_EQ(0u, common::StackSampler::SetThreadDIA(
+                  outer.first, outer.second).first);
+}
+
+TEST(StackSampler, SampleStacksOfDIA) {
+    vfs::TemporaryDirectory tmpdir;
+    const std::string path = tmpdir.get() + "/log.json";
+    {
+        common::JsonLogger logger(path);
+        common::StackSampler sampler(logger, /* frequency */ 1000);
+
+        if (!sampler.AddThread(/* worker_rank */ 3)) return;
+
+        {
+            // burn about 200ms of CPU time, which yields many samples
+            common::StackSamplerScope scope(42, "Test");
+            std::chrono::steady_clock::time_point end =
+                std::chrono::steady_clock::now()
+                + std::chrono::milliseconds(200);
+            volatile size_t sum = 0;
+            while (std::chrono::steady_clock::now() < end)
+                sum = sum + 1;
+        }
+        sampler.RemoveThread();
+    }
+
+    bool found = false;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find("\"class\":\"StackSamples\"") == std::string::npos)
+            continue;
+        ASSERT_NE(std::string::npos, line.find("\"worker_rank\":3"));
+        found = found || (line.find("\"dia_id\":42") != std::string::npos &&
+                          line.find("\"label\":\"Test\"") != std::string::npos);
+    }
+    ASSERT_TRUE(found);
+}
+
+/******************************************************************************/
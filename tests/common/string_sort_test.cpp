@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * tests/common/string_sort_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/string_sort.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+//! random strings with an optional common prefix over an alphabet of size
+//! sigma, which contains all characters from 0 for sigma = 256.
+static std::vector<std::string> RandomStrings(
+    size_t n, size_t sigma, std::mt19937& rng) {
+    std::vector<std::string> out;
+    out.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        std::string s = rng() % 2 ? "http://www." : "";
+        size_t len = rng() % 12;
+        for (size_t j = 0; j < len; ++j) {
+            s += static_cast<char>(
+                sigma == 256 ? rng() % 256 : 'a' + rng() % sigma);
+        }
+        out.push_back(s);
+    }
+    return out;
+}
+
+TEST(StringSort, RandomStrings) {
+    std::mt19937 rng(42);
+
+    // sizes of insertion sort, multikey quicksort, and radix sort
+    for (size_t n : { 0, 1, 10, 1000, 100000 }) {
+        for (size_t sigma : { 2, 4, 256 }) {
+            std::vector<std::string> vec = RandomStrings(n, sigma, rng);
+            std::vector<std::string> check = vec;
+
+            common::string_sort(vec.begin(), vec.end());
+            std::sort(check.begin(), check.end());
+
+            ASSERT_EQ(check, vec);
+        }
+    }
+}
+
+TEST(StringSort, DistinguishingPrefixes) {
+    std::mt19937 rng(42);
+
+    std::vector<std::string> vec = RandomStrings(10000, 4, rng);
+    std::sort(vec.begin(), vec.end());
+
+    std::vector<std::string> prefixes = vec;
+    common::TruncateDistinguishingPrefixes(
+        prefixes.begin(), prefixes.end(),
+        [](std::string& s) -> std::string& { return s; });
+
+    for (size_t i = 0; i < vec.size(); ++i) {
+        // each prefix is a prefix of its string
+        ASSERT_EQ(0, vec[i].compare(0, prefixes[i].size(), prefixes[i]));
+        // the order of different strings is kept
+        if (i + 1 < vec.size()) {
+            ASSERT_EQ(vec[i] < vec[i + 1], prefixes[i] < prefixes[i + 1]);
+            ASSERT_FALSE(prefixes[i + 1] < prefixes[i]);
+        }
+    }
+}
+
+/******************************************************************************/
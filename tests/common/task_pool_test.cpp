@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * tests/common/task_pool_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/parallel_sort.hpp>
+#include <thrill/common/task_pool.hpp>
+#include <thrill/common/thread_barrier.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace thrill;
+
+TEST(TaskPool, ParallelForConcurrentCallers) {
+
+    for (size_t num_threads : { 0, 1, 3 }) {
+        common::TaskPool pool(num_threads);
+        ASSERT_EQ(num_threads, pool.num_threads());
+
+        std::atomic<size_t> total { 0 };
+
+        // several workers run loops on the pool concurrently
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < 4; ++w) {
+            workers.emplace_back(
+                [&]() {
+                    for (size_t r = 0; r < 50; ++r) {
+                        std::vector<size_t> vec(1000);
+                        pool.ParallelFor(
+                            0, vec.size(), [&](size_t i) { vec[i] = i; });
+                        for (size_t i = 0; i < vec.size(); ++i)
+                            ASSERT_EQ(i, vec[i]);
+
+                        pool.Run(7, [&](size_t) { ++total; });
+                    }
+                });
+        }
+        for (std::thread& t : workers) t.join();
+
+        ASSERT_EQ(4u * 50u * 7u, total);
+    }
+}
+
+TEST(TaskPool, ParallelSort) {
+
+    std::default_random_engine rng(std::random_device { } ());
+    common::TaskPool pool(3);
+
+    std::vector<size_t> vec(256000);
+    for (size_t& v : vec) v = rng() % 100000;
+
+    std::vector<size_t> check = vec;
+    std::sort(check.begin(), check.end());
+
+    common::ParallelSort sorter(pool);
+    sorter(vec.begin(), vec.end(), std::less<size_t>());
+
+    ASSERT_EQ(check, vec);
+}
+
+TEST(TaskPool, BarrierLendsWaitingThreads) {
+
+    static constexpr size_t num_workers = 4;
+
+    common::TaskPool pool(1);
+    common::ThreadBarrierTree barrier(num_workers);
+    barrier.set_idle_function([&pool]() { return pool.HelpOne(); });
+
+    std::atomic<size_t> done { 0 };
+
+    // worker 0 is a straggler with a parallel loop, the others wait in the
+    // barrier and run some of its tasks.
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < num_workers; ++w) {
+        workers.emplace_back(
+            [&, w]() {
+                if (w == 0) {
+                    pool.Run(64, [&](size_t) {
+                                 std::this_thread::sleep_for(
+                                     std::chrono::microseconds(100));
+                                 ++done;
+                             });
+                    ASSERT_EQ(64u, done);
+                }
+                barrier.wait(w);
+            });
+    }
+    for (std::thread& t : workers) t.join();
+
+    ASSERT_EQ(64u, done);
+}
+
+/******************************************************************************/
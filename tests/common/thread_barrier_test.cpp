@@ -15,6 +15,7 @@
 #include <cstdlib>
 #include <ctime>
 #include <random>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -74,4 +75,56 @@ TEST(ThreadBarrier, TestWaitFor) {
     TestWaitFor(32);
 }
 
+//! combine strings of all threads up the tree and check their order
+template <typename Barrier>
+static void TestCombine(Barrier& barrier, size_t count) {
+
+    std::vector<std::string> values(count), results(count);
+    std::vector<std::thread> threads(count);
+
+    std::string expected;
+    for (size_t i = 0; i < count; ++i)
+        expected += static_cast<char>('a' + i % 26);
+
+    for (size_t i = 0; i < count; ++i) {
+        threads[i] = std::thread(
+            [&, i] {
+                for (size_t round = 0; round < 4; ++round) {
+                    values[i] = std::string(1, 'a' + i % 26);
+
+                    barrier.wait_combine(
+                        i, [&](size_t child) { values[i] += values[child]; },
+                        [&]() {
+                            for (size_t j = 0; j < count; ++j)
+                                results[j] = values[0];
+                        });
+
+                    ASSERT_EQ(expected, results[i]);
+
+                    barrier.wait(i);
+                }
+            });
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        threads[i].join();
+    }
+}
+
+TEST(ThreadBarrierTree, TestCombine) {
+    for (size_t count = 1; count <= 9; ++count) {
+        ThreadBarrierTree barrier2(count, /* fan_in */ 2);
+        TestCombine(barrier2, count);
+        ThreadBarrierTree barrier4(count, /* fan_in */ 4);
+        TestCombine(barrier4, count);
+    }
+}
+
+TEST(ThreadBarrierCombineMutex, TestCombine) {
+    for (size_t count = 1; count <= 9; ++count) {
+        ThreadBarrierCombineMutex barrier(count);
+        TestCombine(barrier, count);
+    }
+}
+
 /******************************************************************************/
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * tests/common/wait_stats_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/wait_stats.hpp>
+
+#include <chrono>
+#include <thread>
+
+using namespace thrill;
+
+TEST(WaitStats, AccumulateWaitTimers) {
+    common::ThreadWaitStats& stats = common::ThreadWaitStats::Local();
+    uint64_t net_ns = stats.net_ns, collective_ns = stats.collective_ns;
+
+    {
+        common::NetWaitTimer timer;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_LE(net_ns + 10000000u, stats.net_ns);
+    ASSERT_EQ(collective_ns, stats.collective_ns);
+    ASSERT_EQ(0u, stats.depth);
+}
+
+TEST(WaitStats, NestedWaitIsCountedOnce) {
+    common::ThreadWaitStats& stats = common::ThreadWaitStats::Local();
+    uint64_t net_ns = stats.net_ns, collective_ns = stats.collective_ns;
+
+    {
+        // a stream wait inside a collective is counted as collective wait
+        common::CollectiveWaitTimer outer;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        {
+            common::NetWaitTimer inner;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    ASSERT_EQ(net_ns, stats.net_ns);
+    ASSERT_LE(collective_ns + 10000000u, stats.collective_ns);
+    ASSERT_EQ(0u, stats.depth);
+}
+
+TEST(WaitStats, ThreadLocal) {
+    common::ThreadWaitStats& stats = common::ThreadWaitStats::Local();
+    uint64_t net_ns = stats.net_ns;
+
+    std::thread thread(
+        []() {
+            common::NetWaitTimer timer;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        });
+    thread.join();
+
+    ASSERT_EQ(net_ns, stats.net_ns);
+}
+
+/******************************************************************************/
@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * tests/core/front_coded_string_stream_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <thrill/core/front_coded_string_stream.hpp>
+#include <thrill/core/lcp_multiway_merge.hpp>
+#include <thrill/data/file.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+//! generate sorted strings with long common prefixes, like URLs
+static std::vector<std::string> SortedStrings(size_t n, std::mt19937& rng) {
+    static const char* prefixes[] = {
+        "http://project-thrill.org/", "http://project-thrill.org/docs/",
+        "https://example.com/", ""
+    };
+    std::vector<std::string> out;
+    for (size_t i = 0; i < n; ++i) {
+        std::string s = prefixes[rng() % 4];
+        size_t len = rng() % 8;
+        for (size_t j = 0; j < len; ++j)
+            s.push_back("ab/\xff"[rng() % 4]);
+        out.push_back(s);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+//! write strings through a FrontCodedStringWriter into a File
+static void WriteFile(data::File& file, const std::vector<std::string>& v) {
+    core::FrontCodedStringWriter<data::File::Writer> writer(
+        file.GetWriter(256));
+    for (const std::string& s : v)
+        writer.Put(s);
+    writer.Close();
+}
+
+TEST(FrontCodedStringStream, Roundtrip) {
+    std::mt19937 rng(42);
+    std::vector<std::string> items = SortedStrings(10000, rng);
+
+    data::BlockPool block_pool;
+    data::File file(block_pool, 0, /* dia_id */ 0);
+    WriteFile(file, items);
+
+    ASSERT_EQ(items.size(), file.num_items());
+
+    data::File plain_file(block_pool, 0, /* dia_id */ 0);
+    {
+        auto writer = plain_file.GetWriter(256);
+        for (const std::string& s : items)
+            writer.Put(s);
+    }
+    // the common prefixes are not stored
+    ASSERT_LT(file.size_bytes(), plain_file.size_bytes() * 2 / 3);
+
+    std::vector<std::string> out;
+    auto reader = core::MakeFrontCodedStringReader(
+        file.GetReader(/* consume */ false));
+    while (reader.HasNext()) {
+        out.emplace_back(reader.template Next<std::string>());
+        ASSERT_EQ(out.size() == 1 ? 0 : core::StringLcp(
+                      out[out.size() - 2], out.back()), reader.lcp());
+    }
+    ASSERT_EQ(items, out);
+}
+
+TEST(FrontCodedStringStream, LcpMultiwayMerge) {
+    std::mt19937 rng(42);
+
+    for (size_t num_seqs : { 1, 2, 5, 16 }) {
+        data::BlockPool block_pool;
+        std::vector<data::File> files;
+        std::vector<std::string> all;
+
+        for (size_t i = 0; i < num_seqs; ++i) {
+            std::vector<std::string> v = SortedStrings(rng() % 1000, rng);
+            files.emplace_back(block_pool, 0, /* dia_id */ 0);
+            WriteFile(files.back(), v);
+            all.insert(all.end(), v.begin(), v.end());
+        }
+        std::sort(all.begin(), all.end());
+
+        std::vector<core::FrontCodedStringReader<data::File::ConsumeReader> >
+        seq;
+        for (data::File& f : files)
+            seq.emplace_back(f.GetConsumeReader());
+
+        auto puller = core::make_lcp_multiway_merge_tree<true>(
+            seq.begin(), seq.end());
+
+        // merge into front coded output with the merger's LCPs
+        data::File out_file(block_pool, 0, /* dia_id */ 0);
+        core::FrontCodedStringWriter<data::File::Writer> writer(
+            out_file.GetWriter());
+        std::vector<std::string> out;
+        while (puller.HasNext()) {
+            out.emplace_back(puller.Next());
+            ASSERT_EQ(out.size() == 1 ? 0 : core::StringLcp(
+                          out[out.size() - 2], out.back()), puller.lcp());
+            writer.Put(out.back(), puller.lcp());
+        }
+        writer.Close();
+        ASSERT_EQ(all, out);
+
+        std::vector<std::string> check;
+        auto reader = core::MakeFrontCodedStringReader(
+            out_file.GetConsumeReader());
+        while (reader.HasNext())
+            check.emplace_back(reader.template Next<std::string>());
+        ASSERT_EQ(all, check);
+    }
+}
+
+/******************************************************************************/
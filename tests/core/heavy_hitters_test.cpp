@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * tests/core/heavy_hitters_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/context.hpp>
+#include <thrill/core/heavy_hitters.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace thrill; // NOLINT
+
+TEST(HeavyHitterSummary, FindHotHashes) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 10000;
+
+            // on each worker, hash 42 occurs in a quarter of the items, hash
+            // 7 in an eighth, and all other hashes are unique.
+            core::HeavyHitterSummary summary(16);
+            for (size_t i = 0; i < n; ++i) {
+                if (i % 4 == 0)
+                    summary.Insert(42);
+                else if (i % 8 == 1)
+                    summary.Insert(7);
+                else
+                    summary.Insert(1000 + ctx.my_rank() * n + i);
+            }
+            ASSERT_EQ(n, summary.num_items());
+
+            core::HeavyHitterSummary::HashCountVector heavy =
+                summary.Flush(ctx, ctx.num_workers() * n / 16);
+
+            ASSERT_EQ(2u, heavy.size());
+            ASSERT_EQ(7u, heavy[0].first);
+            ASSERT_EQ(42u, heavy[1].first);
+
+            // counts are underestimated by at most n / 17 per worker
+            ASSERT_LE(heavy[1].second, ctx.num_workers() * n / 4);
+            ASSERT_GE(heavy[1].second, ctx.num_workers() * (n / 4 - n / 17));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+/******************************************************************************/
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * tests/core/location_detection_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/context.hpp>
+#include <thrill/core/location_detection.hpp>
+
+#include <gtest/gtest.h>
+
+#include <unordered_map>
+
+using namespace thrill; // NOLINT
+
+class TestHashCount
+{
+public:
+    using HashType = size_t;
+    using CounterType = uint16_t;
+
+    size_t hash;
+    CounterType count;
+
+    static constexpr size_t counter_bits_ = 8 * sizeof(CounterType);
+
+    TestHashCount operator + (const TestHashCount& b) const {
+        assert(hash == b.hash);
+        return TestHashCount { hash, CounterType(count + b.count) };
+    }
+
+    TestHashCount& operator += (const TestHashCount& b) {
+        assert(hash == b.hash);
+        count = CounterType(count + b.count);
+        return *this;
+    }
+
+    bool operator < (const TestHashCount& b) const { return hash < b.hash; }
+
+    bool NeedBroadcast() const { return true; }
+
+    template <typename BitReader>
+    void ReadBits(BitReader& reader) {
+        count = reader.GetBits(counter_bits_);
+    }
+
+    template <typename BitWriter>
+    void WriteBits(BitWriter& writer) const {
+        writer.PutBits(count, counter_bits_);
+    }
+};
+
+//! Every worker inserts each hash once, the worker h % p inserts it three more
+//! times, in single items which must be aggregated.
+static void TestLocationDetection(Context& ctx, size_t limit_memory_bytes) {
+    size_t n = 2000;
+
+    core::LocationDetection<TestHashCount> location_detection(ctx, 0);
+    location_detection.Initialize(limit_memory_bytes);
+
+    for (size_t h = 0; h < n; ++h) {
+        location_detection.Insert(TestHashCount { h, 1 });
+        if (h % ctx.num_workers() == ctx.my_rank()) {
+            for (size_t i = 0; i < 3; ++i)
+                location_detection.Insert(TestHashCount { h, 1 });
+        }
+    }
+
+    std::unordered_map<size_t, size_t> target_processors;
+    size_t max_hash = location_detection.Flush(target_processors);
+    location_detection.Dispose();
+
+    // all hashes are below max_hash, hence not reduced modulo it
+    ASSERT_LE(n, max_hash);
+    ASSERT_EQ(n, target_processors.size());
+    for (size_t h = 0; h < n; ++h) {
+        ASSERT_EQ(1u, target_processors.count(h));
+        ASSERT_EQ(h % ctx.num_workers(), target_processors[h]);
+    }
+}
+
+TEST(LocationDetection, DirectVector) {
+    api::RunLocalTests(
+        [](Context& ctx) {
+            TestLocationDetection(ctx, 64 * 1024 * 1024);
+        });
+}
+
+TEST(LocationDetection, TableFallback) {
+    api::RunLocalTests(
+        [](Context& ctx) {
+            // the vector overflows after 500 items
+            TestLocationDetection(ctx, 1000 * sizeof(TestHashCount));
+        });
+}
+
+TEST(LocationDetection, TableFallbackOnOneWorker) {
+    api::RunLocalTests(
+        [](Context& ctx) {
+            // only the first worker overflows, all others must follow it
+            TestLocationDetection(
+                ctx, ctx.my_rank() == 0
+                ? 1000 * sizeof(TestHashCount) : 64 * 1024 * 1024);
+        });
+}
+
+/******************************************************************************/
@@ -12,6 +12,7 @@
 
 #include <thrill/common/function_traits.hpp>
 #include <thrill/core/multiway_merge.hpp>
+#include <thrill/core/parallel_multiway_merge.hpp>
 #include <thrill/data/file.hpp>
 
 #include <thrill/common/logger.hpp>
@@ -87,4 +88,139 @@ TEST_F(MultiwayMerge, GetMultiwayMergePuller) {
     ASSERT_FALSE(puller.HasNext());
 }
 
+TEST_F(MultiwayMerge, BatchedAndParallelMerge) {
+    std::mt19937 gen(0);
+    size_t a = 7;
+    size_t b = 5000;
+
+    using File = data::File;
+    std::vector<File> in;
+    std::vector<size_t> ref;
+
+    for (size_t i = 0; i < a; ++i) {
+        std::vector<size_t> tmp;
+        for (size_t j = 0; j < b + i * 100; ++j)
+            tmp.push_back(gen() % 1000);
+        std::sort(tmp.begin(), tmp.end());
+        ref.insert(ref.end(), tmp.begin(), tmp.end());
+
+        File f(block_pool_, 0, /* dia_id */ 0);
+        {
+            auto w = f.GetWriter();
+            for (auto& t : tmp) w.Put(t);
+        }
+        in.emplace_back(std::move(f));
+    }
+    std::sort(ref.begin(), ref.end());
+
+    {
+        std::vector<File::KeepReader> seq;
+        for (size_t t = 0; t < in.size(); ++t)
+            seq.emplace_back(in[t].GetKeepReader());
+
+        auto puller = core::make_batched_multiway_merge_tree<size_t>(
+            seq.begin(), seq.end(), std::less<size_t>());
+
+        for (size_t i = 0; i < ref.size(); ++i) {
+            ASSERT_TRUE(puller.HasNext());
+            ASSERT_EQ(ref[i], puller.Next());
+        }
+        ASSERT_FALSE(puller.HasNext());
+    }
+
+    for (size_t threads : { 1, 2, 4 }) {
+        std::vector<File> pieces =
+            core::parallel_multiway_merge<size_t>(
+                in, std::less<size_t>(), threads,
+                [this]() { return File(block_pool_, 0, /* dia_id */ 0); });
+
+        std::vector<size_t> output;
+        for (File& f : pieces) {
+            auto r = f.GetConsumeReader();
+            while (r.HasNext()) output.push_back(r.Next<size_t>());
+        }
+        ASSERT_EQ(ref, output);
+    }
+}
+
+//! total volume of merging runs with the given sizes down to merge_degree
+//! runs, planned by core::PlanMergeBatch().
+static size_t PlannedMergeVolume(std::vector<size_t> sizes,
+                                 size_t merge_degree, bool consecutive) {
+    size_t volume = 0;
+    bool first = true;
+    while (sizes.size() > merge_degree) {
+        std::vector<size_t> batch =
+            core::PlanMergeBatch(sizes, merge_degree, consecutive);
+        // only the first merge may take fewer runs
+        if (!first) EXPECT_EQ(merge_degree, batch.size());
+        first = false;
+
+        size_t sum = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (consecutive && i > 0) EXPECT_EQ(batch[i - 1] + 1, batch[i]);
+            sum += sizes[batch[i]];
+        }
+        volume += sum;
+
+        std::vector<size_t> next;
+        for (size_t i = 0, b = 0; i < sizes.size(); ++i) {
+            if (b < batch.size() && batch[b] == i) {
+                if (b++ == 0) next.push_back(sum);
+            }
+            else {
+                next.push_back(sizes[i]);
+            }
+        }
+        sizes.swap(next);
+    }
+    // the final merge takes all remaining runs
+    EXPECT_EQ(merge_degree, sizes.size());
+    return volume;
+}
+
+TEST(MultiwayMergePlan, PlanMergeBatch) {
+    std::mt19937 rng(42);
+
+    for (size_t merge_degree : { 2, 3, 8 }) {
+        for (size_t n = merge_degree + 1; n < 40; ++n) {
+            std::vector<size_t> sizes(n);
+            for (size_t& s : sizes) s = 1 + rng() % 1000;
+
+            // FIFO batches of merge_degree runs, as merged before planning
+            size_t fifo_volume = 0;
+            std::vector<size_t> fifo = sizes;
+            while (fifo.size() > merge_degree) {
+                std::vector<size_t> next;
+                size_t i = 0;
+                for ( ; i + merge_degree < fifo.size(); i += merge_degree) {
+                    size_t sum = 0;
+                    for (size_t t = 0; t < merge_degree; ++t)
+                        sum += fifo[i + t];
+                    fifo_volume += sum;
+                    next.push_back(sum);
+                }
+                next.insert(next.end(), fifo.begin() + i, fifo.end());
+                fifo.swap(next);
+            }
+
+            size_t volume = PlannedMergeVolume(sizes, merge_degree, false);
+            PlannedMergeVolume(sizes, merge_degree, true);
+            ASSERT_LE(volume, fifo_volume);
+        }
+    }
+}
+
+TEST(MultiwayMergePlan, ProportionalPrefetch) {
+    std::vector<size_t> sizes = { 1000, 3000, 0, 6000 };
+    std::vector<size_t> prefetch = core::ProportionalPrefetch(sizes, 400, 10);
+
+    ASSERT_EQ(4u, prefetch.size());
+    ASSERT_EQ(160u, prefetch[0]);
+    ASSERT_EQ(480u, prefetch[1]);
+    // at least one block
+    ASSERT_EQ(10u, prefetch[2]);
+    ASSERT_EQ(960u, prefetch[3]);
+}
+
 /******************************************************************************/
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * tests/core/packed_integer_stream_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <thrill/core/packed_integer_stream.hpp>
+#include <thrill/data/file.hpp>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace thrill;
+
+using core::IntegerStreamCodec;
+
+//! write items through a PackedIntegerWriter into a File and read them back
+template <typename Type>
+static size_t TestRoundtrip(const std::vector<Type>& items,
+                            IntegerStreamCodec codec) {
+    data::BlockPool block_pool;
+    // construct File with small blocks, such that chunks span blocks
+    data::File file(block_pool, 0, /* dia_id */ 0);
+
+    {
+        core::PackedIntegerWriter<data::File::Writer, Type> writer(
+            file.GetWriter(256), codec);
+        for (const Type& t : items)
+            writer.Put(t);
+        writer.Close();
+    }
+
+    std::vector<Type> out;
+    {
+        auto reader = core::MakePackedIntegerReader<Type>(
+            file.GetReader(/* consume */ false));
+        while (reader.HasNext())
+            out.emplace_back(reader.template Next<Type>());
+    }
+
+    EXPECT_EQ(items, out);
+    return file.size_bytes();
+}
+
+TEST(PackedIntegerStream, SortedIntegers) {
+    std::vector<size_t> items;
+    for (size_t i = 0; i < 10000; ++i)
+        items.push_back(1000000 + 3 * i);
+
+    for (IntegerStreamCodec codec :
+         { IntegerStreamCodec::Raw, IntegerStreamCodec::DeltaVarint,
+           IntegerStreamCodec::BitPacked, IntegerStreamCodec::Auto }) {
+        size_t bytes = TestRoundtrip(items, codec);
+        if (codec != IntegerStreamCodec::Raw) {
+            // deltas of 3 fit into one byte, or two bits
+            ASSERT_LT(bytes, items.size() * 2);
+        }
+    }
+}
+
+TEST(PackedIntegerStream, RandomIntegers) {
+    std::mt19937_64 rng(42);
+
+    std::vector<uint64_t> full;
+    std::vector<uint32_t> small_range;
+    std::vector<int> negative;
+    for (size_t i = 0; i < 10000; ++i) {
+        full.push_back(rng());
+        small_range.push_back(50000 + rng() % 1000);
+        negative.push_back(static_cast<int>(rng() % 2000) - 1000);
+    }
+
+    for (IntegerStreamCodec codec :
+         { IntegerStreamCodec::Raw, IntegerStreamCodec::DeltaVarint,
+           IntegerStreamCodec::BitPacked, IntegerStreamCodec::Auto }) {
+        TestRoundtrip(full, codec);
+        TestRoundtrip(negative, codec);
+        size_t bytes = TestRoundtrip(small_range, codec);
+        if (codec == IntegerStreamCodec::BitPacked ||
+            codec == IntegerStreamCodec::Auto) {
+            // keys of the range are packed in 10 bits
+            ASSERT_LT(bytes, small_range.size() * sizeof(uint32_t) / 2);
+        }
+    }
+}
+
+TEST(PackedIntegerStream, PairsWithIntegerKeys) {
+    std::vector<std::pair<int64_t, std::string> > items;
+    for (int64_t i = -500; i < 500; ++i)
+        items.emplace_back(i * 7, std::to_string(i));
+
+    TestRoundtrip(items, IntegerStreamCodec::Auto);
+    TestRoundtrip(items, IntegerStreamCodec::BitPacked);
+}
+
+/******************************************************************************/
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * tests/core/quantile_sketch_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/core/quantile_sketch.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+TEST(QuantileSketch, RankErrorOfPermutation) {
+    size_t n = 100000;
+
+    std::vector<size_t> items(n);
+    std::iota(items.begin(), items.end(), 0);
+    std::shuffle(items.begin(), items.end(), std::default_random_engine(42));
+
+    core::QuantileSketch<size_t> sketch(200);
+    for (const size_t& i : items)
+        sketch.Insert(i);
+
+    ASSERT_EQ(n, sketch.num_items());
+    ASSERT_LT(sketch.num_retained(), 1000u);
+
+    // item i has rank i + 1, allow a rank error of 2%
+    for (double phi : { 0.0, 0.01, 0.25, 0.5, 0.75, 0.99, 1.0 }) {
+        double q = static_cast<double>(sketch.Quantile(phi));
+        ASSERT_NEAR(phi * n, q, 0.02 * n);
+    }
+}
+
+TEST(QuantileSketch, MergeSketches) {
+    size_t n = 50000;
+
+    // first sketch gets the even items, the second the odd, reversed
+    core::QuantileSketch<size_t, std::greater<size_t> > a, b;
+    for (size_t i = 0; i < n; ++i) {
+        a.Insert(2 * i);
+        b.Insert(2 * i + 1);
+    }
+
+    core::QuantileSketch<size_t, std::greater<size_t> > c = a + b;
+    ASSERT_EQ(2 * n, c.num_items());
+
+    std::vector<size_t> q = c.Quantiles({ 0.1, 0.5, 0.9 });
+    ASSERT_EQ(3u, q.size());
+    ASSERT_NEAR(0.9 * 2 * n, static_cast<double>(q[0]), 0.02 * 2 * n);
+    ASSERT_NEAR(0.5 * 2 * n, static_cast<double>(q[1]), 0.02 * 2 * n);
+    ASSERT_NEAR(0.1 * 2 * n, static_cast<double>(q[2]), 0.02 * 2 * n);
+}
+
+TEST(QuantileSketch, FewItemsAreExact) {
+    core::QuantileSketch<int> sketch;
+    for (int i : { 5, 3, 9, 1, 7 })
+        sketch.Insert(i);
+
+    ASSERT_EQ(1, sketch.Quantile(0.0));
+    ASSERT_EQ(5, sketch.Quantile(0.5));
+    ASSERT_EQ(9, sketch.Quantile(1.0));
+}
+
+/******************************************************************************/
@@ -11,14 +11,19 @@
 
 #include <thrill/core/reduce_bucket_hash_table.hpp>
 #include <thrill/core/reduce_old_probing_hash_table.hpp>
+#include <thrill/core/reduce_pod_probing_hash_table.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_swiss_hash_table.hpp>
 
+#include <thrill/core/reduce_functional.hpp>
 #include <thrill/core/reduce_pre_phase.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
 #include <functional>
+#include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -143,4 +148,146 @@ TEST(ReduceHashTable, OldProbingAddIntegers) {
         });
 }
 
+TEST(ReduceHashTable, PodProbingAddIntegers) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructModulo<core::ReducePodProbingHashTable>(ctx);
+        });
+}
+
+static_assert(core::ReduceUsePodProbingHashTable<
+                  size_t, std::equal_to<size_t> >::value,
+              "PROBING should select the POD table for size_t keys");
+
+static_assert(!core::ReduceUsePodProbingHashTable<
+                  std::string, std::equal_to<std::string> >::value,
+              "PROBING should not select the POD table for std::string keys");
+
+TEST(ReduceHashTable, SwissAddIntegers) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructModulo<core::ReduceSwissHashTable>(ctx);
+        });
+}
+
+TEST(ReduceHashTable, ProbingHeapLimitStrings) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            static constexpr size_t test_size = 200;
+            static constexpr size_t limit_memory_bytes = 1024 * 1024;
+
+            auto key_ex = [](const std::string& in) { return in; };
+
+            auto red_fn = [](const std::string& in1, const std::string&) {
+                              return in1;
+                          };
+
+            using Collector = TableCollector<std::string>;
+            Collector collector(4);
+
+            using Table = core::ReduceProbingHashTable<
+                std::string, std::string, std::string,
+                decltype(key_ex), decltype(red_fn), Collector,
+                /* VolatileKey */ false>;
+
+            Table table(ctx, 0, key_ex, red_fn, collector,
+                        /* num_partitions */ 4,
+                        typename Table::ReduceConfig(),
+                        /* immediate_flush */ true);
+            table.Initialize(limit_memory_bytes);
+
+            // the heap memory of the strings exceeds the limit, which must
+            // flush partitions.
+            for (size_t i = 0; i < test_size; ++i) {
+                std::string s = std::to_string(i) + std::string(10000, 'x');
+                table.Insert(s);
+                table.Insert(s);
+                ASSERT_LE(table.heap_bytes(), limit_memory_bytes / 2);
+            }
+
+            size_t flushed = 0;
+            for (const auto& partition : collector)
+                flushed += partition.size();
+            ASSERT_GT(flushed, 0u);
+
+            table.FlushAll();
+            ASSERT_EQ(0u, table.heap_bytes());
+
+            std::set<std::string> keys;
+            for (const auto& partition : collector)
+                keys.insert(partition.begin(), partition.end());
+            ASSERT_EQ(test_size, keys.size());
+        });
+}
+
+TEST(ReduceHashTable, ProbingHeapMemoryFraction) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            static constexpr size_t limit_memory_bytes = 1024 * 1024;
+
+            auto key_ex = [](const std::string& in) { return in; };
+
+            auto red_fn = [](const std::string& in1, const std::string&) {
+                              return in1;
+                          };
+
+            using Collector = TableCollector<std::string>;
+
+            using Table = core::ReduceProbingHashTable<
+                std::string, std::string, std::string,
+                decltype(key_ex), decltype(red_fn), Collector,
+                /* VolatileKey */ false>;
+
+            // a smaller heap reserve leaves more memory for the slots
+            size_t prev_buckets = 0;
+            for (double fraction : { 0.5, 0.25, 0.0 }) {
+                Collector collector(4);
+                core::DefaultReduceConfig config;
+                config.heap_memory_fraction_ = fraction;
+
+                Table table(ctx, 0, key_ex, red_fn, collector,
+                            /* num_partitions */ 4, config,
+                            /* immediate_flush */ true);
+                table.Initialize(limit_memory_bytes);
+
+                ASSERT_GT(table.num_buckets(), prev_buckets);
+                prev_buckets = table.num_buckets();
+
+                // long strings are flushed within the reserve
+                for (size_t i = 0; i < 100; ++i) {
+                    table.Insert(std::to_string(i) + std::string(10000, 'x'));
+                    ASSERT_LE(table.heap_bytes(),
+                              static_cast<size_t>(limit_memory_bytes * fraction));
+                }
+                table.FlushAll();
+                ASSERT_EQ(0u, table.heap_bytes());
+
+                size_t flushed = 0;
+                for (const auto& partition : collector)
+                    flushed += partition.size();
+                ASSERT_EQ(100u, flushed);
+            }
+        });
+}
+
+TEST(ReduceByHash, WeightedPartitions) {
+    core::ReduceByHash<size_t> index_function;
+    index_function.set_partition_weights({ 0.0, 0.5, 0.75, 1.0 });
+
+    static constexpr size_t test_size = 100000;
+    std::vector<size_t> counts(3);
+    for (size_t i = 0; i < test_size; ++i) {
+        size_t p = index_function(i, 3, 0, 0).partition_id;
+        ASSERT_LT(p, 3u);
+        ++counts[p];
+    }
+    ASSERT_NEAR(0.5, counts[0] / static_cast<double>(test_size), 0.02);
+    ASSERT_NEAR(0.25, counts[1] / static_cast<double>(test_size), 0.02);
+    ASSERT_NEAR(0.25, counts[2] / static_cast<double>(test_size), 0.02);
+
+    // other numbers of partitions ignore the weights.
+    for (size_t i = 0; i < 1000; ++i)
+        ASSERT_LT(index_function(i, 5, 0, 0).partition_id, 5u);
+}
+
 /******************************************************************************/
@@ -11,6 +11,7 @@
 
 #include <thrill/core/reduce_by_hash_post_phase.hpp>
 #include <thrill/core/reduce_by_index_post_phase.hpp>
+#include <thrill/core/reduce_by_sort_post_phase.hpp>
 
 #include <gtest/gtest.h>
 
@@ -111,6 +112,210 @@ TEST(ReduceHashPhase, ProbingAddMyStructByHash) {
         });
 }
 
+TEST(ReduceHashPhase, SwissAddMyStructByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByHash<core::ReduceTableImpl::SWISS>(ctx);
+        });
+}
+
+struct MyGraceReduceConfig : public core::DefaultReduceConfig {
+    static constexpr bool use_grace_post_phase_ = true;
+};
+
+//! insert keys 0..mod_size-1 twice with little memory, which spills
+template <typename ReduceConfig>
+static void TestSpilledReduce(Context& ctx, const ReduceConfig& config,
+                              size_t expected_passes) {
+    static constexpr size_t mod_size = 100000;
+    static constexpr size_t test_size = mod_size * 2;
+
+    auto key_ex = [](const MyStruct& in) {
+                      return in.key % mod_size;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                          in1.key, in1.value + in2.value
+                      };
+                  };
+
+    std::vector<MyStruct> result;
+
+    auto emit_fn = [&result](const MyStruct& in) {
+                       result.emplace_back(in);
+                   };
+
+    using Phase = core::ReduceByHashPostPhase<
+        MyStruct, size_t, MyStruct,
+        decltype(key_ex), decltype(red_fn), decltype(emit_fn),
+        /* VolatileKey */ false, ReduceConfig>;
+
+    Phase phase(ctx, 0, key_ex, red_fn, emit_fn, config);
+    phase.Initialize(/* limit_memory_bytes */ 64 * 1024);
+
+    for (size_t i = 0; i < test_size; ++i) {
+        phase.Insert(MyStruct { i % mod_size, 1 });
+    }
+
+    phase.PushData(/* consume */ true);
+
+    if (expected_passes != 0)
+        ASSERT_EQ(expected_passes, phase.num_passes());
+
+    std::sort(result.begin(), result.end());
+
+    ASSERT_EQ(mod_size, result.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+        ASSERT_EQ(i, result[i].key);
+        ASSERT_EQ(2u, result[i].value);
+    }
+}
+
+TEST(ReduceHashPhase, GraceSinglePassAfterSpill) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSpilledReduce(ctx, MyGraceReduceConfig(), /* passes */ 1);
+        });
+}
+
+TEST(ReduceHashPhase, ParallelReReduceAfterSpill) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            core::DefaultReduceConfig config;
+            config.post_phase_threads_ = 4;
+            TestSpilledReduce(ctx, config, /* passes */ 0);
+
+            MyGraceReduceConfig grace_config;
+            grace_config.post_phase_threads_ = 4;
+            TestSpilledReduce(ctx, grace_config, /* passes */ 0);
+        });
+}
+
+struct MyBatchReduceConfig : public core::DefaultReduceConfig {
+    static constexpr bool use_batch_insert_ = true;
+};
+
+//! insert keys 0..mod_size-1 twice from a File in batches, which spills and
+//! re-reduces the spilled files in batches as well
+TEST(ReduceHashPhase, BatchInsertAllAfterSpill) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            static constexpr size_t mod_size = 100000;
+            static constexpr size_t test_size = mod_size * 2 + 5;
+
+            auto key_ex = [](const MyStruct& in) {
+                              return in.key % mod_size;
+                          };
+
+            auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                              return MyStruct {
+                                  in1.key, in1.value + in2.value
+                              };
+                          };
+
+            std::vector<MyStruct> result;
+
+            auto emit_fn = [&result](const MyStruct& in) {
+                               result.emplace_back(in);
+                           };
+
+            data::File file = ctx.GetFile(nullptr);
+            {
+                data::File::Writer writer = file.GetWriter();
+                for (size_t i = 0; i < test_size; ++i)
+                    writer.Put(MyStruct { i % mod_size, 1 });
+            }
+
+            using Phase = core::ReduceByHashPostPhase<
+                MyStruct, size_t, MyStruct,
+                decltype(key_ex), decltype(red_fn), decltype(emit_fn),
+                /* VolatileKey */ false, MyBatchReduceConfig>;
+
+            Phase phase(ctx, 0, key_ex, red_fn, emit_fn);
+            phase.Initialize(/* limit_memory_bytes */ 64 * 1024);
+
+            data::File::ConsumeReader reader = file.GetConsumeReader();
+            phase.InsertAll(reader);
+
+            phase.PushData(/* consume */ true);
+
+            std::sort(result.begin(), result.end());
+
+            ASSERT_EQ(mod_size, result.size());
+            for (size_t i = 0; i < result.size(); ++i) {
+                ASSERT_EQ(i, result[i].key);
+                ASSERT_EQ(i < 5 ? 3u : 2u, result[i].value);
+            }
+        });
+}
+
+/******************************************************************************/
+
+//! insert keys 0..mod_size-1 twice, with little memory runs are written
+static void TestSortAddMyStruct(Context& ctx, size_t limit_memory_bytes,
+                                bool expect_runs) {
+    static constexpr size_t mod_size = 100000;
+    static constexpr size_t test_size = mod_size * 2;
+
+    auto key_ex = [](const MyStruct& in) {
+                      return in.key % mod_size;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                          in1.key, in1.value + in2.value
+                      };
+                  };
+
+    std::vector<MyStruct> result;
+
+    auto emit_fn = [&result](const MyStruct& in) {
+                       result.emplace_back(in);
+                   };
+
+    using Phase = core::ReduceBySortPostPhase<
+        MyStruct, size_t, MyStruct,
+        decltype(key_ex), decltype(red_fn), decltype(emit_fn),
+        /* VolatileKey */ false>;
+
+    Phase phase(ctx, 0, key_ex, red_fn, emit_fn);
+    phase.Initialize(limit_memory_bytes);
+
+    for (size_t i = 0; i < test_size; ++i) {
+        phase.Insert(MyStruct { (i * 7919) % mod_size, 1 });
+    }
+
+    // push twice, the second time from RAM or the cache
+    for (size_t round = 0; round < 2; ++round) {
+        result.clear();
+        phase.PushData(/* consume */ round == 1);
+
+        ASSERT_EQ(expect_runs, phase.num_runs() > 1);
+
+        // items are delivered in key order
+        ASSERT_EQ(mod_size, result.size());
+        for (size_t i = 0; i < result.size(); ++i) {
+            ASSERT_EQ(i, result[i].key);
+            ASSERT_EQ(2u, result[i].value);
+        }
+    }
+}
+
+TEST(ReduceHashPhase, SortAddMyStructInMemory) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSortAddMyStruct(ctx, 16 * 1024 * 1024, /* runs */ false);
+        });
+}
+
+TEST(ReduceHashPhase, SortAddMyStructWithRuns) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestSortAddMyStruct(ctx, 64 * 1024, /* runs */ true);
+        });
+}
+
 /******************************************************************************/
 
 TEST(ReduceHashPhase, PostReduceByIndex) {
@@ -223,6 +428,13 @@ TEST(ReduceHashPhase, ProbingAddMyStructByIndex) {
         });
 }
 
+TEST(ReduceHashPhase, SwissAddMyStructByIndex) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByIndex<core::ReduceTableImpl::SWISS>(ctx);
+        });
+}
+
 /******************************************************************************/
 
 template <core::ReduceTableImpl table_impl>
@@ -306,4 +518,11 @@ TEST(ReduceHashPhase, ProbingAddMyStructByIndexWithHoles) {
         });
 }
 
+TEST(ReduceHashPhase, SwissAddMyStructByIndexWithHoles) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByIndexWithHoles<core::ReduceTableImpl::SWISS>(ctx);
+        });
+}
+
 /******************************************************************************/
@@ -10,11 +10,13 @@
  ******************************************************************************/
 
 #include <thrill/core/reduce_pre_phase.hpp>
+#include <thrill/core/reduce_shared_pre_table.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
 #include <functional>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -126,6 +128,258 @@ TEST(ReducePrePhase, ProbingAddMyStructByHash) {
         });
 }
 
+TEST(ReducePrePhase, SwissAddMyStructByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByHash<core::ReduceTableImpl::SWISS>(ctx);
+        });
+}
+
+TEST(ReducePrePhase, AutoAddMyStructByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByHash<core::ReduceTableImpl::AUTO>(ctx);
+        });
+}
+
+TEST(ReducePrePhase, AutoPassThroughUniqueKeys) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            static constexpr size_t test_size = 60000;
+
+            auto key_ex = [](const MyStruct& in) { return in.key; };
+
+            auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                              return MyStruct {
+                                  in1.key, in1.value + in2.value
+                              };
+                          };
+
+            const size_t num_partitions = 13;
+
+            std::vector<data::File> files;
+            for (size_t i = 0; i < num_partitions; ++i)
+                files.emplace_back(ctx.GetFile(nullptr));
+
+            std::vector<data::File::Writer> emitters;
+            for (size_t i = 0; i < num_partitions; ++i)
+                emitters.emplace_back(files[i].GetWriter());
+
+            using Config = MyReduceConfig<core::ReduceTableImpl::AUTO>;
+            using Phase = core::ReducePrePhase<
+                MyStruct, size_t, MyStruct,
+                decltype(key_ex), decltype(red_fn),
+                /* VolatileKey */ false, data::File::Writer, Config>;
+
+            Config config;
+            config.auto_sample_size_ = 1000;
+
+            Phase phase(ctx, 0, num_partitions, key_ex, red_fn, emitters,
+                        config);
+
+            phase.Initialize(/* limit_memory_bytes */ 1024 * 1024);
+
+            for (size_t i = 0; i < test_size; ++i) {
+                phase.Insert(MyStruct { i, i });
+            }
+
+            ASSERT_TRUE(phase.pass_through());
+
+            phase.FlushAll();
+            phase.CloseAll();
+
+            std::vector<MyStruct> result;
+            for (size_t i = 0; i < num_partitions; ++i) {
+                data::File::Reader r = files[i].GetReader(/* consume */ true);
+                while (r.HasNext())
+                    result.emplace_back(r.Next<MyStruct>());
+            }
+
+            std::sort(result.begin(), result.end());
+
+            ASSERT_EQ(test_size, result.size());
+            for (size_t i = 0; i < result.size(); ++i) {
+                ASSERT_EQ(i, result[i].key);
+                ASSERT_EQ(i, result[i].value);
+            }
+        });
+}
+
+struct MyBypassReduceConfig : public core::DefaultReduceConfig {
+    static constexpr bool use_adaptive_bypass_ = true;
+};
+
+//! insert items with num_keys distinct keys, and check the reduced sums
+static void TestAdaptiveBypass(Context& ctx, size_t num_keys,
+                               bool expect_bypass) {
+    static constexpr size_t test_size = 60000;
+
+    auto key_ex = [num_keys](const MyStruct& in) {
+                      return in.key % num_keys;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                          in1.key, in1.value + in2.value
+                      };
+                  };
+
+    const size_t num_partitions = 13;
+
+    std::vector<data::File> files;
+    for (size_t i = 0; i < num_partitions; ++i)
+        files.emplace_back(ctx.GetFile(nullptr));
+
+    std::vector<data::File::Writer> emitters;
+    for (size_t i = 0; i < num_partitions; ++i)
+        emitters.emplace_back(files[i].GetWriter());
+
+    using Phase = core::ReducePrePhase<
+        MyStruct, size_t, MyStruct,
+        decltype(key_ex), decltype(red_fn),
+        /* VolatileKey */ false, data::File::Writer, MyBypassReduceConfig>;
+
+    MyBypassReduceConfig config;
+    config.bypass_window_ = 1000;
+
+    Phase phase(ctx, 0, num_partitions, key_ex, red_fn, emitters, config);
+
+    phase.Initialize(/* limit_memory_bytes */ 1024 * 1024);
+
+    for (size_t i = 0; i < test_size; ++i) {
+        phase.Insert(MyStruct { i, 1 });
+    }
+
+    for (size_t i = 0; i < num_partitions; ++i)
+        ASSERT_EQ(expect_bypass, phase.bypassed(i));
+
+    phase.FlushAll();
+    phase.CloseAll();
+
+    // sum up the emitted partial results per key
+    std::vector<size_t> sums(num_keys, 0);
+    for (size_t i = 0; i < num_partitions; ++i) {
+        data::File::Reader r = files[i].GetReader(/* consume */ true);
+        while (r.HasNext()) {
+            MyStruct m = r.Next<MyStruct>();
+            sums[m.key % num_keys] += m.value;
+        }
+    }
+
+    for (size_t k = 0; k < num_keys; ++k)
+        ASSERT_EQ(test_size / num_keys, sums[k]);
+}
+
+TEST(ReducePrePhase, AdaptiveBypassFewKeys) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAdaptiveBypass(ctx, /* num_keys */ 600, /* bypass */ false);
+        });
+}
+
+TEST(ReducePrePhase, AdaptiveBypassUniqueKeys) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAdaptiveBypass(ctx, /* num_keys */ 60000, /* bypass */ true);
+        });
+}
+
+template <core::ReduceTableImpl table_impl>
+struct MyBatchReduceConfig : public core::DefaultReduceConfig {
+    static constexpr bool use_batch_insert_ = true;
+
+    static constexpr core::ReduceTableImpl table_impl_ = table_impl;
+};
+
+//! insert items in batches with prefetching, and check the reduced sums
+template <core::ReduceTableImpl table_impl>
+static void TestBatchInsert(Context& ctx) {
+    static constexpr size_t test_size = 60000;
+    static constexpr size_t num_keys = 6001;
+
+    auto key_ex = [](const MyStruct& in) {
+                      return in.key % num_keys;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                          in1.key, in1.value + in2.value
+                      };
+                  };
+
+    const size_t num_partitions = 13;
+
+    std::vector<data::File> files;
+    for (size_t i = 0; i < num_partitions; ++i)
+        files.emplace_back(ctx.GetFile(nullptr));
+
+    std::vector<data::File::Writer> emitters;
+    for (size_t i = 0; i < num_partitions; ++i)
+        emitters.emplace_back(files[i].GetWriter());
+
+    using Config = MyBatchReduceConfig<table_impl>;
+    using Phase = core::ReducePrePhase<
+        MyStruct, size_t, MyStruct,
+        decltype(key_ex), decltype(red_fn),
+        /* VolatileKey */ false, data::File::Writer, Config>;
+
+    Phase phase(ctx, 0, num_partitions, key_ex, red_fn, emitters, Config());
+
+    // small memory limit, such that partitions grow and spill
+    phase.Initialize(/* limit_memory_bytes */ 64 * 1024);
+
+    // an odd number of items leaves a partial batch for FlushAll()
+    for (size_t i = 0; i < test_size + 7; ++i) {
+        phase.Insert(MyStruct { i, 1 });
+    }
+
+    phase.FlushAll();
+    phase.CloseAll();
+
+    std::vector<size_t> sums(num_keys, 0);
+    for (size_t i = 0; i < num_partitions; ++i) {
+        data::File::Reader r = files[i].GetReader(/* consume */ true);
+        while (r.HasNext()) {
+            MyStruct m = r.Next<MyStruct>();
+            sums[m.key % num_keys] += m.value;
+        }
+    }
+
+    for (size_t k = 0; k < num_keys; ++k) {
+        size_t expected = 0;
+        for (size_t i = k; i < test_size + 7; i += num_keys) ++expected;
+        ASSERT_EQ(expected, sums[k]);
+    }
+}
+
+TEST(ReducePrePhase, BatchInsertProbing) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestBatchInsert<core::ReduceTableImpl::PROBING>(ctx);
+        });
+}
+
+TEST(ReducePrePhase, BatchInsertOldProbing) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestBatchInsert<core::ReduceTableImpl::OLD_PROBING>(ctx);
+        });
+}
+
+TEST(ReducePrePhase, BatchInsertBucket) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestBatchInsert<core::ReduceTableImpl::BUCKET>(ctx);
+        });
+}
+
+TEST(ReducePrePhase, BatchInsertSwiss) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestBatchInsert<core::ReduceTableImpl::SWISS>(ctx);
+        });
+}
+
 /******************************************************************************/
 
 template <core::ReduceTableImpl table_impl>
@@ -217,4 +471,133 @@ TEST(ReducePrePhase, ProbingAddMyStructByIndex) {
         });
 }
 
+TEST(ReducePrePhase, SwissAddMyStructByIndex) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByIndex<core::ReduceTableImpl::SWISS>(ctx);
+        });
+}
+
+/******************************************************************************/
+
+//! collects items like a BlockWriter
+struct MyCollectWriter {
+    std::vector<MyStruct> items;
+
+    MyCollectWriter& Put(const MyStruct& item) {
+        items.push_back(item);
+        return *this;
+    }
+};
+
+//! records the order in which partitions are emitted into a shared log
+struct MyOrderWriter {
+    size_t partition_id;
+    std::vector<size_t>* log;
+
+    MyOrderWriter& Put(const MyStruct&) {
+        if (log->empty() || log->back() != partition_id)
+            log->push_back(partition_id);
+        return *this;
+    }
+
+    void Flush() { }
+    void Close() { }
+};
+
+TEST(ReducePrePhase, FlushAllStartsAtOwnPartition) {
+    api::RunLocalTests(
+        [](Context& ctx) {
+            static constexpr size_t mod_size = 601;
+            const size_t num_partitions = 13;
+
+            auto key_ex = [](const MyStruct& in) { return in.key; };
+
+            auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                              return MyStruct {
+                                  in1.key, in1.value + in2.value
+                              };
+                          };
+
+            std::vector<size_t> log;
+            std::vector<MyOrderWriter> emitters;
+            for (size_t i = 0; i < num_partitions; ++i)
+                emitters.emplace_back(MyOrderWriter { i, &log });
+
+            using Phase = core::ReducePrePhase<
+                MyStruct, size_t, MyStruct,
+                decltype(key_ex), decltype(red_fn),
+                /* VolatileKey */ false, MyOrderWriter,
+                MyReduceConfig<core::ReduceTableImpl::PROBING> >;
+
+            Phase phase(ctx, 0, num_partitions, key_ex, red_fn, emitters);
+
+            // room for all keys, which are emitted only by FlushAll()
+            phase.Initialize(/* limit_memory_bytes */ 1024 * 1024);
+
+            for (size_t i = 0; i < mod_size * 10; ++i)
+                phase.Insert(MyStruct { i % mod_size, 1 });
+            ASSERT_TRUE(log.empty());
+
+            phase.FlushAll();
+            phase.CloseAll();
+
+            // each partition is flushed once, starting at my_rank, such that
+            // the workers do not all send to the same worker at once.
+            ASSERT_EQ(num_partitions, log.size());
+            for (size_t r = 0; r < num_partitions; ++r)
+                ASSERT_EQ((ctx.my_rank() + r) % num_partitions, log[r]);
+        });
+}
+
+TEST(ReducePrePhase, SharedPreTableConcurrentInserts) {
+    static constexpr size_t num_threads = 4;
+    static constexpr size_t num_partitions = 8;
+    static constexpr size_t mod_size = 1000;
+    static constexpr size_t test_size = 100000;
+
+    auto key_ex = [](const MyStruct& in) { return in.key; };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct { in1.key, in1.value + in2.value };
+                  };
+
+    using Table = core::ReduceSharedPreTable<
+        MyStruct, size_t, MyStruct, decltype(key_ex), decltype(red_fn),
+        /* VolatileKey */ false,
+        core::ReduceByHash<size_t>, std::equal_to<size_t> >;
+
+    // room for all keys
+    Table table(num_partitions, num_threads, 1024 * 1024, 0.5,
+                key_ex, red_fn, core::ReduceByHash<size_t>(),
+                std::equal_to<size_t>());
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&table, t]() {
+                for (size_t i = t; i < test_size; i += num_threads)
+                    die_unless(table.Insert(MyStruct { i % mod_size, 1 }));
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    ASSERT_EQ(mod_size, table.num_items());
+
+    std::vector<MyCollectWriter> writers(num_partitions);
+    for (size_t t = 0; t < num_threads; ++t)
+        table.FlushSlice(t, writers);
+
+    std::vector<MyStruct> result;
+    for (const MyCollectWriter& w : writers)
+        result.insert(result.end(), w.items.begin(), w.items.end());
+    std::sort(result.begin(), result.end());
+
+    ASSERT_EQ(mod_size, result.size());
+    for (size_t i = 0; i < mod_size; ++i) {
+        ASSERT_EQ(i, result[i].key);
+        ASSERT_EQ(test_size / mod_size, result[i].value);
+    }
+}
+
 /******************************************************************************/
@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * tests/core/semi_join_filter_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/context.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/core/semi_join_filter.hpp>
+
+#include <gtest/gtest.h>
+
+#include <functional>
+
+using namespace thrill; // NOLINT
+
+TEST(SemiJoinFilter, NoFalseNegatives) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 10000;
+            std::hash<size_t> hash;
+
+            // each worker inserts the multiples of 3 in its range
+            common::Range range =
+                common::CalculateLocalRange(n, ctx.num_workers(), ctx.my_rank());
+
+            core::SemiJoinFilter filter(ctx, 0);
+            for (size_t i = range.begin; i < range.end; ++i) {
+                if (i % 3 == 0) filter.Insert(hash(i));
+            }
+            filter.Flush();
+
+            // all inserted keys of all workers pass, and most other keys fail
+            size_t num_passed = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (i % 3 == 0)
+                    ASSERT_TRUE(filter.Contains(hash(i)));
+                else if (filter.Contains(hash(i)))
+                    ++num_passed;
+            }
+            ASSERT_LT(num_passed, n / 3);
+
+            filter.Dispose();
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(SemiJoinFilter, Empty) {
+
+    auto start_func =
+        [](Context& ctx) {
+            core::SemiJoinFilter filter(ctx, 0);
+            filter.Flush();
+            ASSERT_FALSE(filter.Contains(42));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+/******************************************************************************/
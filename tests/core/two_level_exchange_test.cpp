@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * tests/core/two_level_exchange_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/context.hpp>
+#include <thrill/core/two_level_exchange.hpp>
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+TEST(TwoLevelExchange, AllToAll) {
+
+    auto start_func =
+        [](Context& ctx) {
+            static constexpr size_t items_per_worker = 100;
+
+            using Item = std::pair<size_t, size_t>;
+            core::TwoLevelExchange<Item> exchange(ctx, /* dia_id */ 0);
+
+            // send items_per_worker (source, destination) pairs to each worker
+            core::TwoLevelExchange<Item>::Writers writers =
+                exchange.GetWriters();
+            ASSERT_EQ(ctx.num_workers(), writers.size());
+
+            for (size_t w = 0; w < ctx.num_workers(); ++w) {
+                for (size_t i = 0; i < items_per_worker; ++i)
+                    writers[w].Put(Item(ctx.my_rank(), w));
+            }
+            for (size_t w = 0; w < ctx.num_workers(); ++w)
+                writers[w].Close();
+
+            std::vector<size_t> count(ctx.num_workers(), 0);
+
+            auto reader = exchange.GetReader(/* consume */ true);
+            while (reader.HasNext()) {
+                Item item = reader.Next<Item>();
+                ASSERT_EQ(ctx.my_rank(), item.second);
+                ASSERT_LT(item.first, ctx.num_workers());
+                ++count[item.first];
+            }
+
+            for (size_t w = 0; w < ctx.num_workers(); ++w)
+                ASSERT_EQ(items_per_worker, count[w]);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+/******************************************************************************/
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * tests/data/block_pool_disks_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/api/context.hpp>
+#include <thrill/data/block.hpp>
+#include <thrill/data/block_pool.hpp>
+#include <thrill/vfs/temporary_directory.hpp>
+
+#include <foxxll/io/file.hpp>
+#include <foxxll/mng/config.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+// this runs in its own test program, since foxxll's disk configuration must be
+// installed before the first block is evicted.
+TEST(BlockPoolDisks, StripeEvictedBlocksAcrossDisks) {
+    vfs::TemporaryDirectory disk0, disk1;
+    std::string disks = disk0.get() + "," + disk1.get();
+    setenv("THRILL_DISKS", disks.c_str(), /* overwrite */ 1);
+
+    api::RunSetupFoxxll();
+    ASSERT_EQ(2u, foxxll::config::get_instance()->disks_number());
+
+    static constexpr size_t num_blocks = 8;
+
+    data::BlockPool block_pool;
+    std::vector<data::Block> blocks;
+    for (size_t i = 0; i < num_blocks; ++i) {
+        data::PinnedByteBlockPtr block =
+            block_pool.AllocateByteBlock(4096, 0);
+        std::fill(block->begin(), block->end(), data::Byte(i));
+        data::PinnedBlock pinned(std::move(block), 0, 4096, 0, 0, false);
+        blocks.emplace_back(pinned.ToBlock());
+    }
+
+    for (size_t i = 0; i < num_blocks; ++i) {
+        foxxll::request_ptr req = block_pool.EvictBlockLRU();
+        if (req) req->wait();
+    }
+
+    // consecutively evicted blocks are striped round-robin across the disks
+    size_t on_disk[2] = { 0, 0 };
+    for (const data::Block& block : blocks) {
+        ASSERT_FALSE(block.byte_block()->in_memory());
+        int disk = block.byte_block()->em_bid().storage->get_allocator_id();
+        ASSERT_TRUE(disk == 0 || disk == 1);
+        ++on_disk[disk];
+    }
+    ASSERT_EQ(num_blocks / 2, on_disk[0]);
+    ASSERT_EQ(num_blocks / 2, on_disk[1]);
+
+    // and are read back from both
+    for (size_t i = 0; i < num_blocks; ++i) {
+        data::PinnedBlock pinned = blocks[i].PinWait(0);
+        ASSERT_EQ(data::Byte(i), pinned.data_begin()[0]);
+        ASSERT_EQ(data::Byte(i), pinned.data_end()[-1]);
+    }
+}
+
+/******************************************************************************/
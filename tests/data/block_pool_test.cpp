@@ -12,7 +12,9 @@
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_pool.hpp>
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 using namespace thrill;
 
@@ -109,4 +111,118 @@ TEST_F(BlockPoolTest, EvictBlock) {
     ASSERT_EQ(0u, block_pool_.writing_blocks() + block_pool_.swapped_blocks());
 }
 
+TEST_F(BlockPoolTest, CountSpilledBytes) {
+    ASSERT_EQ(0u, block_pool_.total_spill_write_bytes());
+    ASSERT_EQ(0u, block_pool_.total_spill_read_bytes());
+
+    data::Block unpinned_block;
+    {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(4096, 0);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        unpinned_block = pinned_block.ToBlock();
+    }
+
+    foxxll::request_ptr req = block_pool_.EvictBlockLRU();
+    if (req) req->wait();
+    ASSERT_EQ(4096u, block_pool_.total_spill_write_bytes());
+    ASSERT_EQ(0u, block_pool_.total_spill_read_bytes());
+
+    // pinning swaps the block back in
+    data::PinnedBlock pinned = unpinned_block.PinWait(0);
+    ASSERT_EQ(4096u, block_pool_.total_spill_write_bytes());
+    ASSERT_EQ(4096u, block_pool_.total_spill_read_bytes());
+}
+
+TEST_F(BlockPoolTest, EvictScannedBlocksFirst) {
+    data::Block reusable_block, scanned_block;
+    {
+        data::PinnedByteBlockPtr block1 = block_pool_.AllocateByteBlock(4096, 0);
+        data::PinnedBlock pinned1(std::move(block1), 0, 4096, 0, 0, false);
+        scanned_block = pinned1.ToBlock();
+        pinned1.byte_block()->set_eviction_hint(data::EvictionHint::Sequential);
+
+        data::PinnedByteBlockPtr block2 = block_pool_.AllocateByteBlock(4096, 0);
+        data::PinnedBlock pinned2(std::move(block2), 0, 4096, 0, 0, false);
+        reusable_block = pinned2.ToBlock();
+    }
+    ASSERT_EQ(2u, block_pool_.unpinned_blocks());
+
+    // the scanned block is evicted first, although it is not the LRU block
+    foxxll::request_ptr req = block_pool_.EvictBlockLRU();
+    if (req) req->wait();
+    ASSERT_FALSE(scanned_block.byte_block()->in_memory());
+    ASSERT_TRUE(reusable_block.byte_block()->in_memory());
+}
+
+TEST_F(BlockPoolTest, AllocateNumaLocalBlocks) {
+    block_pool_.set_numa_local(true);
+    for (size_t i = 0; i < 4; ++i) {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(8192, 0);
+        std::fill(block->data(), block->data() + 8192, data::Byte(i));
+        ASSERT_EQ(data::Byte(i), block->data()[8191]);
+    }
+    ASSERT_EQ(0u, block_pool_.total_blocks());
+}
+
+#if THRILL_HAVE_ZLIB
+TEST_F(BlockPoolTest, EvictCompressedBlock) {
+    static constexpr size_t size = 65536;
+    block_pool_.set_codec(data::BlockCodec::Create("zlib"));
+
+    data::Block unpinned_block;
+    {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(size, 0);
+        for (size_t i = 0; i < size; ++i)
+            block->data()[i] = static_cast<data::Byte>(i % 61);
+        data::PinnedBlock pinned_block(std::move(block), 0, size, 0, 0, false);
+        unpinned_block = pinned_block.ToBlock();
+    }
+    // evict block and wait for the write to complete
+    block_pool_.EvictBlock(unpinned_block.byte_block().get());
+    foxxll::request_ptr req = block_pool_.GetAnyWriting();
+    if (req) req->wait();
+    ASSERT_EQ(1u, block_pool_.swapped_blocks());
+
+    // swap block back in, which decompresses it.
+    data::PinnedBlock pinned = unpinned_block.PinWait(0);
+    ASSERT_EQ(0u, block_pool_.swapped_blocks());
+    for (size_t i = 0; i < size; ++i)
+        ASSERT_EQ(i % 61, pinned.byte_block()->data()[i]);
+}
+
+TEST_F(BlockPoolTest, EvictCompressedBlockToRAM) {
+    static constexpr size_t size = 65536;
+    block_pool_.set_codec(data::BlockCodec::Create("zlib"));
+    // room for one compressed block only
+    block_pool_.set_compressed_ram_limit(size / 2);
+
+    std::vector<data::Block> unpinned_blocks;
+    for (size_t b = 0; b < 2; ++b) {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(size, 0);
+        for (size_t i = 0; i < size; ++i)
+            block->data()[i] = static_cast<data::Byte>((i + b) % 61);
+        data::PinnedBlock pinned_block(std::move(block), 0, size, 0, 0, false);
+        unpinned_blocks.emplace_back(pinned_block.ToBlock());
+    }
+
+    // the first block is kept compressed in RAM, the second is written.
+    block_pool_.EvictBlock(unpinned_blocks[0].byte_block().get());
+    ASSERT_FALSE(block_pool_.GetAnyWriting());
+    ASSERT_EQ(0u, block_pool_.swapped_blocks());
+
+    block_pool_.EvictBlock(unpinned_blocks[1].byte_block().get());
+    foxxll::request_ptr req = block_pool_.GetAnyWriting();
+    if (req) req->wait();
+    ASSERT_EQ(1u, block_pool_.swapped_blocks());
+
+    // pin both blocks, which decompresses them from RAM and from disk.
+    for (size_t b = 0; b < 2; ++b) {
+        data::PinnedBlock pinned = unpinned_blocks[b].PinWait(0);
+        for (size_t i = 0; i < size; ++i)
+            ASSERT_EQ((i + b) % 61, pinned.byte_block()->data()[i]);
+    }
+    ASSERT_EQ(0u, block_pool_.swapped_blocks());
+}
+#endif
+
 /******************************************************************************/
@@ -10,11 +10,14 @@
  ******************************************************************************/
 
 #include <gtest/gtest.h>
+#include <thrill/common/deferred_work.hpp>
 #include <thrill/data/block_queue.hpp>
 #include <thrill/data/cat_block_source.hpp>
 #include <tlx/thread_pool.hpp>
 
+#include <atomic>
 #include <string>
+#include <thread>
 
 using namespace thrill;
 
@@ -204,4 +207,31 @@ TEST_F(BlockQueue, ThreadedParallelBlockWriterAndDynBlockReader) {
     pool.loop_until_empty();
 }
 
+TEST_F(BlockQueue, ConsumeReaderRunsDeferredWorkWhileWaiting) {
+    tlx::ThreadPool pool(2);
+    data::BlockQueue q(block_pool_, 0, /* dia_id */ 0);
+    std::atomic<bool> work_done { false };
+
+    pool.enqueue(
+        [&q, &work_done]() {
+            // the writer waits for the reader's deferred work
+            while (!work_done) std::this_thread::yield();
+            data::BlockQueue::Writer bw = q.GetWriter(16);
+            bw.Put(static_cast<int>(42));
+        });
+
+    pool.enqueue(
+        [&q, &work_done]() {
+            common::DeferredWork::Post([&work_done]() { work_done = true; });
+
+            data::BlockQueue::ConsumeReader br = q.GetConsumeReader(0);
+            ASSERT_TRUE(br.HasNext());
+            ASSERT_EQ(42, br.Next<int>());
+            ASSERT_FALSE(br.HasNext());
+            ASSERT_EQ(0u, common::DeferredWork::size());
+        });
+
+    pool.loop_until_empty();
+}
+
 /******************************************************************************/
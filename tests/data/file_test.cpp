@@ -120,6 +120,104 @@ TEST_F(File, PutSomeItemsGetItems) {
     }
 }
 
+TEST_F(File, WritersShareBlockSizeBudget) {
+    data::File heavy_file(block_pool_, 0, /* dia_id */ 0);
+    data::File sparse_file(block_pool_, 0, /* dia_id */ 0);
+
+    data::BlockWriterBudgetPtr budget =
+        tlx::make_counting<data::BlockWriterBudget>(16 * data::start_block_size);
+
+    size_t heavy_block_size, sparse_block_size;
+    {
+        data::File::Writer heavy_writer(
+            data::FileBlockSink(tlx::CountingPtrNoDelete<data::File>(&heavy_file)),
+            data::default_block_size, budget);
+        data::File::Writer sparse_writer(
+            data::FileBlockSink(tlx::CountingPtrNoDelete<data::File>(&sparse_file)),
+            data::default_block_size, budget);
+
+        for (size_t i = 0; i < 100000; ++i)
+            heavy_writer.Put<size_t>(i);
+        for (size_t i = 0; i < 10; ++i)
+            sparse_writer.Put<size_t>(i);
+
+        heavy_block_size = heavy_writer.block_size();
+        sparse_block_size = sparse_writer.block_size();
+        ASSERT_LE(budget->used(), budget->limit());
+    }
+
+    // the heavy writer got larger blocks, but only up to the budget
+    ASSERT_LT(sparse_block_size, heavy_block_size);
+    ASSERT_LE(sparse_block_size, 2 * data::start_block_size);
+    ASSERT_LE(heavy_block_size, budget->limit());
+    ASSERT_EQ(0u, budget->used());
+
+    ASSERT_EQ(100000u, heavy_file.num_items());
+    data::File::KeepReader fr = heavy_file.GetKeepReader();
+    for (size_t i = 0; i < 100000; ++i)
+        ASSERT_EQ(i, fr.Next<size_t>());
+}
+
+TEST(PrefetchBudget, TakeGive) {
+    data::PrefetchBudget budget;
+    ASSERT_FALSE(budget.Take(1));
+
+    budget.Give(10);
+    ASSERT_TRUE(budget.Take(4));
+    ASSERT_FALSE(budget.Take(7));
+    ASSERT_TRUE(budget.Take(6));
+    ASSERT_FALSE(budget.Take(1));
+}
+
+TEST_F(File, StartPrefetchAdaptsWithinBudget) {
+    static constexpr size_t num_files = 4;
+
+    // files of different lengths, the readers are consumed at different rates
+    std::vector<data::File> files;
+    for (size_t f = 0; f < num_files; ++f) {
+        files.emplace_back(block_pool_, 0, /* dia_id */ 0);
+        data::File::Writer fw = files.back().GetWriter(/* block_size */ 256);
+        for (size_t i = 0; i < 20000 * (f + 1); ++i)
+            fw.Put<size_t>(f * 1000000 + i);
+    }
+
+    // reader f advances f + 1 items per round, like a merge of files with
+    // different key densities.
+    auto check_readers =
+        [&](auto& readers) {
+            data::StartPrefetch(readers, 4 * data::default_block_size);
+
+            std::vector<size_t> pos(num_files);
+            bool more = true;
+            while (more) {
+                more = false;
+                for (size_t f = 0; f < num_files; ++f) {
+                    for (size_t k = 0; k <= f && readers[f].HasNext(); ++k) {
+                        ASSERT_EQ(f * 1000000 + pos[f],
+                                  readers[f].template Next<size_t>());
+                        ++pos[f];
+                    }
+                    more = more || readers[f].HasNext();
+                }
+            }
+            for (size_t f = 0; f < num_files; ++f)
+                ASSERT_EQ(20000 * (f + 1), pos[f]);
+        };
+
+    std::vector<data::File::KeepReader> keep_readers;
+    for (const data::File& f : files)
+        keep_readers.emplace_back(f.GetKeepReader(/* prefetch_size */ 0));
+    check_readers(keep_readers);
+
+    std::vector<data::File::ConsumeReader> consume_readers;
+    for (data::File& f : files)
+        consume_readers.emplace_back(f.GetConsumeReader(/* prefetch_size */ 0));
+    check_readers(consume_readers);
+
+    for (const data::File& f : files)
+        ASSERT_TRUE(f.empty());
+}
+
 TEST_F(File, WriteZeroItems) {
 
     // construct File with very small blocks for testing
@@ -254,6 +352,34 @@ TEST_F(File, SerializeSomeItemsConsumeReader) {
     ASSERT_EQ(0u, file.num_items());
 }
 
+TEST_F(File, SerializeSomeItemsVisitReader) {
+    static constexpr size_t size = 5000;
+
+    // construct File with very small blocks for testing
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+
+    {
+        data::File::Writer fw = file.GetWriter(53);
+        for (unsigned i = 0; i < size; ++i) {
+            fw.Put<unsigned>(i);
+        }
+    }
+
+    // read items with a keeping and then with a consuming reader.
+    for (bool consume : { false, true }) {
+        file.VisitReader(
+            consume, [](auto& reader) {
+                for (size_t i = 0; i < size; ++i) {
+                    ASSERT_TRUE(reader.HasNext());
+                    unsigned iread = reader.template Next<unsigned>();
+                    ASSERT_EQ(i, iread);
+                }
+                ASSERT_TRUE(!reader.HasNext());
+            });
+        ASSERT_EQ(consume, file.empty());
+    }
+}
+
 TEST_F(File, RandomGetIndexOf) {
     static constexpr size_t size = 500;
 
@@ -337,6 +463,40 @@ TEST_F(File, TieGetIndexOfWithDuplicates) {
     }
 }
 
+TEST_F(File, StringGetItemAtGetIndexOf) {
+    const size_t size = 500;
+
+    // Create test file with sorted strings of varying length.
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < size; i++) {
+        strings.emplace_back(
+            std::to_string(1000 + i / 3) + std::string(i % 7, 'x'));
+    }
+    std::sort(strings.begin(), strings.end());
+
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+
+    data::File::Writer fw = file.GetWriter(53);
+    for (const std::string& s : strings)
+        fw.Put(s);
+    fw.Close();
+
+    ASSERT_EQ(size, file.num_items());
+
+    for (size_t i = 0; i < size; i++) {
+        ASSERT_EQ(strings[i], file.GetItemAt<std::string>(i));
+
+        size_t lower = std::lower_bound(
+            strings.begin(), strings.end(), strings[i]) - strings.begin();
+        size_t upper = std::upper_bound(
+            strings.begin(), strings.end(), strings[i]) - strings.begin();
+
+        ASSERT_EQ(lower, file.GetIndexOf(strings[i], 0));
+        ASSERT_EQ(upper, file.GetIndexOf(strings[i], size));
+        ASSERT_EQ(i, file.GetIndexOf(strings[i], i));
+    }
+}
+
 TEST_F(File, SeekReadSlicesOfFiles) {
     static constexpr bool debug = false;
 
@@ -19,6 +19,7 @@
 #include <thrill/net/mock/group.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -119,6 +120,66 @@ TEST(StreamSet, TestLoopbacks) {
     disp.Terminate();
 }
 
+TEST(StreamSet, TestLocalBatches) {
+    size_t workers_per_host = 3;
+    size_t hosts = 1;
+    data::default_block_size = test_block_size;
+
+    auto groups = net::mock::Group::ConstructLoopbackMesh(hosts);
+    net::Group* group = groups[0].get();
+    mem::Manager mem_manager(nullptr, "Benchmark");
+    net::DispatcherThread disp(group->ConstructDispatcher(), 0);
+    data::BlockPool block_pool(workers_per_host);
+    data::Multiplexer multiplexer(mem_manager, block_pool, disp, *group, workers_per_host);
+
+    auto producer =
+        [workers_per_host](data::CatStreamDataPtr stream, size_t my_id) {
+            // move two batches to each worker, and write one item
+            auto writers = stream->GetWriters();
+            for (size_t j = 0; j < workers_per_host; j++) {
+                ASSERT_TRUE(stream->is_local_worker(j));
+                std::string msg = std::to_string(my_id) + "->" + std::to_string(j);
+                stream->PostLocal(j, std::vector<std::string>(3, msg));
+                stream->PostLocal(j, std::vector<std::string>(1, msg));
+                writers[j].Put(msg);
+                writers[j].Close();
+            }
+        };
+    auto consumer =
+        [workers_per_host](data::CatStreamDataPtr stream, size_t my_id) {
+            auto readers = stream->GetReaders();
+            for (size_t j = 0; j < workers_per_host; j++) {
+                std::string expected = std::to_string(j) + "->" + std::to_string(my_id);
+                ASSERT_EQ(expected, readers[j].Next<std::string>());
+                ASSERT_FALSE(readers[j].HasNext());
+
+                std::vector<std::vector<std::string> > batches =
+                    stream->TakeLocal<std::string>(j);
+                ASSERT_EQ(2u, batches.size());
+                ASSERT_EQ(std::vector<std::string>(3, expected), batches[0]);
+                ASSERT_EQ(std::vector<std::string>(1, expected), batches[1]);
+
+                // batches are taken only once
+                ASSERT_TRUE(stream->TakeLocal<std::string>(j).empty());
+            }
+        };
+
+    auto stream0 = multiplexer.GetOrCreateCatStreamData(0, 0, /* dia_id */ 0);
+    auto stream1 = multiplexer.GetOrCreateCatStreamData(0, 1, /* dia_id */ 0);
+    auto stream2 = multiplexer.GetOrCreateCatStreamData(0, 2, /* dia_id */ 0);
+    producer(stream0, 0);
+    producer(stream1, 1);
+    producer(stream2, 2);
+    consumer(stream0, 0);
+    consumer(stream1, 1);
+    consumer(stream2, 2);
+    stream0->Close();
+    stream1->Close();
+    stream2->Close();
+    // stop DispatcherThread before Multiplexer
+    disp.Terminate();
+}
+
 /******************************************************************************/
 // Multiplexer tests
 
@@ -170,8 +231,10 @@ struct Multiplexer : public ::testing::Test {
 };
 
 // open a Stream via data::Multiplexer, and send a short message to all workers,
-// receive and check the message.
-void TalkAllToAllViaCatStream(net::Group* net) {
+// receive and check the message. The multiplexer runs num_dispatchers
+// dispatcher threads.
+void TalkAllToAllViaCatStreamDispatchers(
+    net::Group* net, size_t num_dispatchers) {
     common::NameThisThread("chmp" + std::to_string(net->my_host_rank()));
 
     unsigned char send_buffer[123];
@@ -187,7 +250,8 @@ void TalkAllToAllViaCatStream(net::Group* net) {
     data::BlockPool block_pool(num_workers_per_host);
     net::DispatcherThread disp(net->ConstructDispatcher(), 0);
     data::Multiplexer multiplexer(
-        mem_manager, block_pool, disp, *net, num_workers_per_host);
+        mem_manager, block_pool, disp, *net, num_workers_per_host,
+        num_dispatchers);
 
     auto thread_func =
         [&](size_t my_local_worker_id) {
@@ -291,6 +355,10 @@ void TalkAllToAllViaCatStream(net::Group* net) {
     disp.Terminate();
 }
 
+void TalkAllToAllViaCatStream(net::Group* net) {
+    return TalkAllToAllViaCatStreamDispatchers(net, /* num_dispatchers */ 1);
+}
+
 TEST_F(Multiplexer, TalkAllToAllViaCatStreamForManyNetSizes) {
     data::default_block_size = test_block_size;
     // test for all network mesh sizes 1, 2, 5, 9:
@@ -300,6 +368,25 @@ TEST_F(Multiplexer, TalkAllToAllViaCatStreamForManyNetSizes) {
     net::RunLoopbackGroupTest(9, TalkAllToAllViaCatStream);
 }
 
+TEST_F(Multiplexer, TalkAllToAllViaCatStreamWithStripes) {
+    data::default_block_size = test_block_size;
+    for (size_t num_hosts : { 2, 5 }) {
+        // construct a mock mesh with two additional stripes per peer
+        auto groups = net::mock::Group::ConstructLoopbackMesh(num_hosts);
+        for (size_t s = 0; s < 2; ++s) {
+            auto stripe = net::mock::Group::ConstructLoopbackMesh(num_hosts);
+            for (size_t h = 0; h < num_hosts; ++h)
+                groups[h]->AddStripe(std::move(stripe[h]));
+        }
+
+        net::ExecuteGroupThreads(
+            groups, std::function<void(net::Group*)>(
+                [](net::Group* g) {
+                    TalkAllToAllViaCatStreamDispatchers(g, 3);
+                }));
+    }
+}
+
 TEST_F(Multiplexer, ReadCompleteCatStream) {
     data::default_block_size = test_block_size;
     auto w0 =
@@ -752,6 +839,48 @@ TEST_F(Multiplexer, Scatter_TwoWorkers_CompleteExchange) {
     Execute(w0, w1);
 }
 
+TEST_F(Multiplexer, Scatter_TwoWorkers_SwappedOutFile) {
+    data::default_block_size = test_block_size;
+    static constexpr size_t num_items = 100000;
+    auto w0 =
+        [](data::Multiplexer& multiplexer) {
+            data::File file(multiplexer.block_pool(), 0, /* dia_id */ 0);
+            {
+                auto writer = file.GetWriter();
+                for (size_t i = 0; i < num_items; ++i)
+                    writer.Put<size_t>(i);
+            }
+
+            // swap out the File, the StreamSink pins the blocks ahead while
+            // sending them.
+            data::BlockPool& block_pool = multiplexer.block_pool();
+            for (size_t n = file.num_blocks();
+                 n > 0 && block_pool.unpinned_blocks() > 0; --n) {
+                foxxll::request_ptr req = block_pool.EvictBlockLRU();
+                if (req) req->wait();
+            }
+
+            auto ch = multiplexer.GetNewCatStream(0, /* dia_id */ 0);
+            ch->Scatter<size_t>(file, { 0, 0, num_items });
+
+            auto res = ch->GetCatReader(true).ReadComplete<size_t>();
+            ASSERT_EQ(0u, res.size());
+        };
+    auto w1 =
+        [](data::Multiplexer& multiplexer) {
+            data::File file(multiplexer.block_pool(), 0, /* dia_id */ 0);
+
+            auto ch = multiplexer.GetNewCatStream(0, /* dia_id */ 0);
+            ch->Scatter<size_t>(file, { 0, 0, 0 });
+
+            auto res = ch->GetCatReader(true).ReadComplete<size_t>();
+            ASSERT_EQ(num_items, res.size());
+            for (size_t i = 0; i < num_items; ++i)
+                ASSERT_EQ(i, res[i]);
+        };
+    Execute(w0, w1);
+}
+
 TEST_F(Multiplexer, Scatter_ThreeWorkers_PartialExchange) {
     data::default_block_size = test_block_size;
     auto w0 =
@@ -808,4 +937,141 @@ TEST_F(Multiplexer, Scatter_ThreeWorkers_PartialExchange) {
     Execute(w0, w1, w2);
 }
 
+TEST_F(Multiplexer, ReceivedBlocksAreEvictedMostRecentFirst) {
+    data::default_block_size = test_block_size;
+    static constexpr size_t num_items = 10000;
+    auto w0 =
+        [](data::Multiplexer& multiplexer) {
+            auto c = multiplexer.GetNewCatStream(0, /* dia_id */ 0);
+            auto writers = c->GetWriters();
+            for (size_t i = 0; i < num_items; ++i)
+                writers[1].Put<size_t>(i);
+            for (auto& w : writers)
+                w.Close();
+        };
+    auto w1 =
+        [](data::Multiplexer& multiplexer) {
+            auto c = multiplexer.GetNewCatStream(0, /* dia_id */ 0);
+            auto writers = c->GetWriters();
+            for (auto& w : writers)
+                w.Close();
+
+            // all blocks received from worker 0 carry the Sequential hint,
+            // which places them in the BlockPool's MRU scan list.
+            auto source = c->GetConsumeCatBlockSource();
+            size_t num_blocks = 0;
+            for (data::PinnedBlock b = source.NextBlock(); b.IsValid();
+                 b = source.NextBlock()) {
+                ASSERT_EQ(data::EvictionHint::Sequential,
+                          b.byte_block()->eviction_hint());
+                ++num_blocks;
+            }
+            ASSERT_LT(1u, num_blocks);
+        };
+    Execute(w0, w1);
+}
+
+TEST_F(Multiplexer, CountTrafficPerWorker) {
+    data::default_block_size = test_block_size;
+    auto w =
+        [](data::Multiplexer& multiplexer) {
+            auto c = multiplexer.GetNewCatStream(0, /* dia_id */ 0);
+            size_t my_rank = multiplexer.my_host_rank();
+            auto writers = c->GetWriters();
+            // send 1000 * (peer + 1) items to each peer, including loopback
+            for (size_t p = 0; p < writers.size(); ++p) {
+                for (size_t i = 0; i < 1000 * (p + 1); ++i)
+                    writers[p].Put<size_t>(my_rank);
+            }
+            for (auto& w : writers)
+                w.Close();
+
+            const data::StreamData& data = c->data();
+            ASSERT_EQ(writers.size(), data.tx_items_per_worker_.size());
+            for (size_t p = 0; p < writers.size(); ++p) {
+                ASSERT_EQ(1000 * (p + 1), data.tx_items_per_worker_[p]);
+                ASSERT_LE(1000 * (p + 1) * sizeof(size_t),
+                          data.tx_bytes_per_worker_[p]);
+                ASSERT_LE(1u, data.tx_blocks_per_worker_[p]);
+            }
+
+            auto reader = c->GetCatReader(true);
+            size_t count = 0;
+            while (reader.HasNext()) {
+                reader.Next<size_t>();
+                ++count;
+            }
+            ASSERT_EQ(3 * 1000 * (my_rank + 1), count);
+        };
+    Execute(w, w, w);
+}
+
+//! seconds elapsed since start
+static double SecondsSince(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+TEST_F(Multiplexer, PaceSendReservesSlotsPerHost) {
+    auto w0 =
+        [](data::Multiplexer& multiplexer) {
+            static constexpr size_t size = 64 * 1024;
+            // 1 MiB/s, hence 62.5 ms per reservation
+            multiplexer.set_send_rate(1024 * 1024);
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < 5; ++i)
+                multiplexer.PaceSend(1, size);
+            // the fifth slot starts after the first four
+            ASSERT_LE(0.24, SecondsSince(start));
+
+            // the slots of another host are independent
+            start = std::chrono::steady_clock::now();
+            multiplexer.PaceSend(0, size);
+            ASSERT_GT(0.05, SecondsSince(start));
+
+            // and without a rate nothing is reserved
+            multiplexer.set_send_rate(0);
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < 100; ++i)
+                multiplexer.PaceSend(1, size);
+            ASSERT_GT(0.05, SecondsSince(start));
+        };
+    Execute(w0, [](data::Multiplexer&) { });
+}
+
+TEST_F(Multiplexer, PaceSendLimitsStreamRate) {
+    data::default_block_size = test_block_size;
+    static constexpr size_t num_items = 256 * 1024 / sizeof(size_t);
+    auto w0 =
+        [](data::Multiplexer& multiplexer) {
+            // 1 MiB/s for 256 KiB of Blocks
+            multiplexer.set_send_rate(1024 * 1024);
+
+            auto start = std::chrono::steady_clock::now();
+            auto c = multiplexer.GetNewCatStream(0, /* dia_id */ 0);
+            auto writers = c->GetWriters();
+            for (size_t i = 0; i < num_items; ++i)
+                writers[1].Put<size_t>(i);
+            for (auto& w : writers)
+                w.Close();
+            ASSERT_LE(0.24, SecondsSince(start));
+        };
+    auto w1 =
+        [](data::Multiplexer& multiplexer) {
+            auto c = multiplexer.GetNewCatStream(0, /* dia_id */ 0);
+            auto writers = c->GetWriters();
+            for (auto& w : writers)
+                w.Close();
+
+            auto reader = c->GetCatReader(/* consume */ true);
+            for (size_t i = 0; i < num_items; ++i) {
+                ASSERT_TRUE(reader.HasNext());
+                ASSERT_EQ(i, reader.Next<size_t>());
+            }
+            ASSERT_FALSE(reader.HasNext());
+        };
+    Execute(w0, w1);
+}
+
 /******************************************************************************/
@@ -10,6 +10,7 @@
 #include <gtest/gtest.h>
 #include <thrill/common/logger.hpp>
 #include <thrill/data/block_queue.hpp>
+#include <thrill/data/columnar_chunk.hpp>
 #include <thrill/data/file.hpp>
 #include <thrill/data/serialization.hpp>
 
@@ -236,4 +237,66 @@ TEST_F(Serialization, MethodStruct) {
         "Serialization::is_fixed_size is wrong");
 }
 
+TEST_F(Serialization, ColumnarChunk) {
+    using Chunk = data::ColumnarChunk<uint32_t, double, char>;
+
+    data::File f(block_pool_, 0, /* dia_id */ 0);
+    {
+        auto w = f.GetWriter(1024);
+        Chunk chunk;
+        for (size_t i = 0; i < 1000; ++i) {
+            chunk.push_back(Chunk::Tuple(i, i / 2.0, 'a' + i % 26));
+            if (chunk.size() == 300) {
+                w.Put(chunk);
+                chunk.clear();
+            }
+        }
+        w.Put(chunk);
+        // empty chunk
+        w.Put(Chunk());
+    }
+    ASSERT_EQ(5u, f.num_items());
+
+    auto r = f.GetKeepReader();
+    size_t i = 0;
+    while (r.HasNext()) {
+        Chunk chunk = r.Next<Chunk>();
+        // the key column is contiguous
+        const std::vector<uint32_t>& keys = chunk.column<0>();
+        for (size_t j = 0; j < chunk.size(); ++j, ++i) {
+            ASSERT_EQ(i, keys[j]);
+            ASSERT_EQ(Chunk::Tuple(i, i / 2.0, 'a' + i % 26), chunk[j]);
+        }
+    }
+    ASSERT_EQ(1000u, i);
+}
+
+TEST_F(Serialization, PodVectorAndItemSpans) {
+    std::vector<uint32_t> vec(10000);
+    for (size_t i = 0; i < vec.size(); ++i) vec[i] = i * 3;
+
+    data::File f(block_pool_, 0, /* dia_id */ 0);
+    {
+        // small blocks, such that items span block boundaries
+        auto w = f.GetWriter(1022);
+        w.Put(vec);
+        w.PutItems(vec.data(), vec.size());
+    }
+    ASSERT_EQ(1u + vec.size(), f.num_items());
+
+    auto r = f.GetKeepReader();
+    ASSERT_EQ(vec, r.Next<std::vector<uint32_t> >());
+
+    std::vector<uint32_t> out;
+    while (r.HasNext()) {
+        std::pair<const uint32_t*, size_t> span =
+            r.NextSpan<uint32_t>(vec.size());
+        if (span.second == 0)
+            out.push_back(r.Next<uint32_t>());
+        else
+            out.insert(out.end(), span.first, span.first + span.second);
+    }
+    ASSERT_EQ(vec, out);
+}
+
 /******************************************************************************/
@@ -0,0 +1,132 @@
+/*******************************************************************************
+ * tests/examples/bfs_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <examples/bfs/bfs.hpp>
+
+#include <thrill/api/all_gather.hpp>
+#include <thrill/api/cache.hpp>
+#include <thrill/api/generate.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+using namespace thrill; // NOLINT
+using namespace examples::bfs;
+
+//! random undirected graph of two components [0,n/2) and [n/2,n-1), and an
+//! isolated node n-1.
+static std::vector<EdgeList> MakeGraph(size_t n, size_t degree) {
+    std::vector<EdgeList> adj(n);
+    std::mt19937 rng(42);
+    size_t half = n / 2;
+    for (size_t v = 0; v + 1 < n; ++v) {
+        size_t begin = v < half ? 0 : half, end = v < half ? half : n - 1;
+        // a path keeps each component connected
+        if (v + 1 < end) {
+            adj[v].push_back(v + 1);
+            adj[v + 1].push_back(v);
+        }
+        for (size_t i = 0; i < degree / 2; ++i) {
+            size_t w = begin + rng() % (end - begin);
+            if (w == v) continue;
+            adj[v].push_back(w);
+            adj[w].push_back(v);
+        }
+    }
+    return adj;
+}
+
+static std::vector<size_t> SequentialBFS(
+    const std::vector<EdgeList>& adj, size_t start) {
+    std::vector<size_t> level(adj.size(), INVALID);
+    std::deque<size_t> queue { start };
+    level[start] = 0;
+    while (!queue.empty()) {
+        size_t v = queue.front();
+        queue.pop_front();
+        for (size_t w : adj[v]) {
+            if (level[w] != INVALID) continue;
+            level[w] = level[v] + 1;
+            queue.push_back(w);
+        }
+    }
+    return level;
+}
+
+static std::vector<BfsNode> RunBFS(
+    Context& ctx, const std::vector<EdgeList>& adj, bool direction_optimizing) {
+
+    DIA<BfsNode> graph =
+        Generate(ctx, adj.size(),
+                 [&adj](size_t index) {
+                     BfsNode node;
+                     node.edges = adj[index];
+                     node.nodeIndex = index;
+                     if (index == 0) {
+                         node.parent = 0;
+                         node.level = 0;
+                         node.treeIndex = 0;
+                     }
+                     return node;
+                 }).Cache();
+
+    BfsResult result = BFS(graph, adj.size(), /* startIndex */ 0,
+                           /* full_bfs */ true, direction_optimizing);
+    // two components and the isolated node
+    EXPECT_EQ(3u, result.treeInfos.size());
+
+    std::vector<BfsNode> nodes = result.graph.AllGather();
+    std::sort(nodes.begin(), nodes.end(),
+              [](const BfsNode& a, const BfsNode& b) {
+                  return a.nodeIndex < b.nodeIndex;
+              });
+    return nodes;
+}
+
+TEST(BFS, DirectionOptimizingMatchesTopDown) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 2000;
+            std::vector<EdgeList> adj = MakeGraph(n, 16);
+            std::vector<size_t> level = SequentialBFS(adj, 0);
+
+            std::vector<BfsNode> top_down = RunBFS(ctx, adj, false);
+            std::vector<BfsNode> optimized = RunBFS(ctx, adj, true);
+            ASSERT_EQ(n, top_down.size());
+            ASSERT_EQ(n, optimized.size());
+
+            for (size_t v = 0; v < n; ++v) {
+                const BfsNode& node = optimized[v];
+                ASSERT_EQ(v, node.nodeIndex);
+                ASSERT_EQ(top_down[v].treeIndex, node.treeIndex);
+                ASSERT_EQ(top_down[v].level, node.level);
+                // the first tree is the component of node 0
+                if (node.treeIndex == 0)
+                    ASSERT_EQ(level[v], node.level);
+                else
+                    ASSERT_EQ(INVALID, level[v]);
+                // the parent is a neighbor one level up in the same tree
+                if (node.level != 0) {
+                    const BfsNode& parent = optimized[node.parent];
+                    ASSERT_EQ(node.treeIndex, parent.treeIndex);
+                    ASSERT_EQ(node.level, parent.level + 1);
+                    ASSERT_TRUE(std::find(adj[v].begin(), adj[v].end(),
+                                          node.parent) != adj[v].end());
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+/******************************************************************************/
@@ -29,14 +29,13 @@ using namespace examples::k_means;
 
 using Point2D = Point<2>;
 
-TEST(KMeans, RandomPoints) {
-
-    static constexpr size_t iterations = 4;
-    static constexpr size_t num_points = 1000;
-    static constexpr size_t num_clusters = 20;
+//! generate some random points and centroids, and calculate the "correct"
+//! k-means cost after running Lloyd's Algorithm
+static double RandomPointsLloyd(
+    size_t iterations, size_t num_points, size_t num_clusters,
+    std::vector<Point2D>& points) {
 
-    // generate some random points and centroids
-    std::vector<Point2D> points, centroids;
+    std::vector<Point2D> centroids;
 
     std::default_random_engine rng(123456);
     std::uniform_real_distribution<float> coord_dist(0.0, 100000.0);
@@ -53,8 +52,6 @@ TEST(KMeans, RandomPoints) {
         centroids.emplace_back(points[rng() % points.size()]);
     }
 
-    const std::vector<Point2D> orig_centroids = centroids;
-
     double correct_cost = 0.0;
 
     // calculate "correct" results with Lloyd's Algorithm
@@ -106,12 +103,24 @@ TEST(KMeans, RandomPoints) {
         }
     }
 
+    return correct_cost;
+}
+
+TEST(KMeans, RandomPoints) {
+
+    static constexpr size_t iterations = 4;
+    static constexpr size_t num_points = 1000;
+    static constexpr size_t num_clusters = 20;
+
+    std::vector<Point2D> points;
+    double correct_cost =
+        RandomPointsLloyd(iterations, num_points, num_clusters, points);
+
     auto start_func =
         [&](Context& ctx) {
             ctx.enable_consume();
 
             auto input_points = EqualToDIA(ctx, points);
-            DIA<Point2D> centroids_dia = EqualToDIA(ctx, orig_centroids);
 
             auto means = KMeans(input_points.Keep(), 2, num_clusters, iterations);
 
@@ -128,4 +137,36 @@ TEST(KMeans, RandomPoints) {
     api::RunLocalTests(start_func);
 }
 
+TEST(KMeans, RandomPointsHamerly) {
+
+    static constexpr size_t iterations = 4;
+    static constexpr size_t num_points = 1000;
+    static constexpr size_t num_clusters = 20;
+
+    std::vector<Point2D> points;
+    double correct_cost =
+        RandomPointsLloyd(iterations, num_points, num_clusters, points);
+
+    auto start_func =
+        [&](Context& ctx) {
+            ctx.enable_consume();
+
+            auto input_points = EqualToDIA(ctx, points);
+
+            auto means = KMeansHamerly(
+                input_points.Keep(), 2, num_clusters, iterations);
+
+            double cost = means.ComputeCost(input_points);
+            if (ctx.my_rank() == 0) {
+                sLOG1 << "cost" << cost << "correct_cost" << correct_cost
+                      << "abs_diff_percent"
+                      << tlx::abs_diff(cost, correct_cost) / correct_cost;
+            }
+
+            ASSERT_LE(tlx::abs_diff(cost, correct_cost) / correct_cost, 0.4);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 /******************************************************************************/
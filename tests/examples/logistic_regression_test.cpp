@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * tests/examples/logistic_regression_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <examples/logistic_regression/logistic_regression.hpp>
+
+#include <thrill/api/cache.hpp>
+#include <thrill/api/collapse.hpp>
+#include <thrill/api/generate.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <random>
+#include <tuple>
+#include <utility>
+
+using namespace thrill; // NOLINT
+using namespace examples::logistic_regression;
+
+using Element = std::array<double, 3>;
+using DataObject = std::pair<bool, Element>;
+
+//! separable points with a bias coordinate, labeled by the side of a line
+static DataObject RandomObject(size_t index) {
+    std::default_random_engine rng(index);
+    std::uniform_real_distribution<double> uni_dist(-1.0, 1.0);
+    Element p { 1.0, uni_dist(rng), uni_dist(rng) };
+    return DataObject(p[1] + 2 * p[2] > 0.2, p);
+}
+
+TEST(LogisticRegression, LogitBlockGradient) {
+    Element weights { 0.1, -0.5, 1.5 };
+    LogitBlock<double, 3> block(100);
+
+    Element grad { 0.0, 0.0, 0.0 };
+    for (size_t i = 0; i < 100; ++i) {
+        DataObject obj = RandomObject(i);
+        block.Push(obj);
+        // compare the rows [10,90) against the per-point gradient
+        if (i < 10 || i >= 90) continue;
+        Element g = gradient<double, 3>(obj.first, obj.second, weights);
+        for (size_t d = 0; d < 3; ++d)
+            grad[d] += g[d];
+    }
+    ASSERT_TRUE(block.full());
+
+    Element block_grad { 0.0, 0.0, 0.0 };
+    block.Gradient(10, 90, weights, block_grad);
+
+    for (size_t d = 0; d < 3; ++d)
+        ASSERT_NEAR(grad[d], block_grad[d], 1e-9);
+}
+
+static void TestTraining(double mini_batch_fraction, size_t local_steps) {
+    api::RunLocalTests(
+        [&](Context& ctx) {
+            auto data =
+                Generate(ctx, 4000,
+                         [](size_t index) { return RandomObject(index); })
+                .Cache();
+
+            Element weights;
+            double norm;
+            size_t iterations;
+            std::tie(weights, norm, iterations) =
+                logit_train<double, 3>(data.Keep(), /* max_iterations */ 200,
+                                       /* gamma */ 0.0005, /* epsilon */ 1e-6,
+                                       mini_batch_fraction, local_steps);
+
+            size_t expected_true, true_trues, expected_false, true_falses;
+            std::tie(expected_true, true_trues, expected_false, true_falses) =
+                logit_test<double, 3>(data, weights);
+
+            ASSERT_EQ(4000u, expected_true + expected_false);
+            // the classes are separable, allow a few errors near the line
+            ASSERT_GE(true_trues + true_falses, 4000u * 95 / 100);
+        });
+}
+
+TEST(LogisticRegression, FullBatch) {
+    TestTraining(1.0, 1);
+}
+
+TEST(LogisticRegression, MiniBatch) {
+    TestTraining(0.25, 1);
+}
+
+TEST(LogisticRegression, LocalStepsModelAveraging) {
+    TestTraining(0.5, 4);
+}
+
+/******************************************************************************/
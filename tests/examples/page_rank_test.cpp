@@ -98,6 +98,75 @@ TEST(PageRank, RandomZipfGraph) {
     api::RunLocalTests(start_func);
 }
 
+TEST(PageRank, RandomZipfGraphDense) {
+    static constexpr bool debug = false;
+
+    static constexpr size_t iterations = 5;
+    static constexpr size_t num_pages = 10000;
+    static constexpr double dampening = 0.85;
+
+    // calculate correct result
+    std::vector<double> correct_page_rank;
+
+    // generated outgoing links graph
+    std::vector<OutgoingLinks> outlinks(num_pages);
+
+    {
+        ZipfGraphGen graph_gen(num_pages);
+        std::minstd_rand rng(123456);
+        for (size_t i = 0; i < num_pages; ++i) {
+            outlinks[i] = graph_gen.GenerateOutgoing(rng);
+        }
+
+        // initial ranks: 1 / n
+        std::vector<double> ranks(num_pages, 1.0 / num_pages);
+
+        // contribution of rank weight in each iteration
+        std::vector<double> contrib(num_pages, 0.0);
+
+        for (size_t iter = 0; iter < iterations; ++iter) {
+            // iterate over pages, send weight to targets
+            for (size_t p = 0; p < num_pages; ++p) {
+                OutgoingLinks& links = outlinks[p];
+                for (size_t t = 0; t < links.size(); ++t) {
+                    contrib[links[t]] +=
+                        ranks[p] / static_cast<double>(links.size());
+                }
+            }
+            // calculate new ranks from contributions
+            for (size_t p = 0; p < num_pages; ++p) {
+                ranks[p] = dampening * contrib[p] + (1 - dampening) / num_pages;
+                contrib[p] = 0.0;
+            }
+        }
+
+        for (size_t p = 0; p < num_pages; ++p) {
+            LOG << "pr[" << p << "] = " << ranks[p];
+        }
+
+        correct_page_rank = ranks;
+    }
+
+    auto start_func =
+        [&outlinks, &correct_page_rank](Context& ctx) {
+            ctx.enable_consume();
+
+            auto links = EqualToDIA(ctx, outlinks).Cache();
+
+            auto page_rank = PageRankDense(links, num_pages, iterations);
+
+            // compare results
+            std::vector<double> result = page_rank.AllGather();
+
+            ASSERT_EQ(correct_page_rank.size(), result.size());
+            for (size_t i = 0; i < result.size(); ++i) {
+                ASSERT_TRUE(std::abs(correct_page_rank[i] - result[i]) < 0.000001);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(PageRank, RandomZipfGraphJoin) {
     static constexpr bool debug = false;
 
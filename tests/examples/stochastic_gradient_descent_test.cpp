@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * tests/examples/stochastic_gradient_descent_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <examples/stochastic_gradient_descent/stochastic_gradient_descent.hpp>
+
+#include <thrill/api/cache.hpp>
+#include <thrill/api/generate.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace thrill; // NOLINT
+using namespace examples::stochastic_gradient_descent;
+
+using Vector3 = Vector<3>;
+
+static Vector3 RandomPoint(size_t index) {
+    std::default_random_engine rng(index);
+    std::uniform_real_distribution<double> uni_dist(-1.0, 1.0);
+    Vector3 x;
+    for (size_t f = 0; f < 3; ++f)
+        x.x[f] = uni_dist(rng);
+    return x;
+}
+
+static Vector3 TrueWeights() {
+    Vector3 w;
+    w.x[0] = 2.0;
+    w.x[1] = -1.0;
+    w.x[2] = 0.5;
+    return w;
+}
+
+TEST(StochasticGradientDescent, ColumnarBlockGradient) {
+    Vector3 weights = 0.5 * TrueWeights();
+    ColumnarBlock block(3, 100);
+
+    Vector3 grad = Vector3::Make(3).fill(0.0);
+    double loss = 0.0;
+    for (size_t i = 0; i < 100; ++i) {
+        DataPoint<Vector3> p { RandomPoint(i), static_cast<double>(i % 7) };
+        block.Push(p);
+        // compare the rows [10,90) against the per-point gradient
+        if (i < 10 || i >= 90) continue;
+        auto r = LeastSquaresGradient<Vector3>::Compute(
+            p.data, p.label, weights);
+        grad = grad + r.weights;
+        loss += r.loss;
+    }
+    ASSERT_TRUE(block.full());
+
+    Vector3 block_grad = Vector3::Make(3).fill(0.0);
+    double block_loss = LeastSquaresGradient<Vector3>::ComputeBlock(
+        block, 10, 90, weights, block_grad);
+
+    ASSERT_NEAR(loss, block_loss, 1e-9);
+    for (size_t f = 0; f < 3; ++f)
+        ASSERT_NEAR(grad.x[f], block_grad.x[f], 1e-9);
+}
+
+static void TestConvergence(double mini_batch_fraction, size_t local_steps) {
+    api::RunLocalTests(
+        [&](Context& ctx) {
+            Vector3 weights = TrueWeights();
+
+            auto points =
+                Generate(
+                    ctx, 4000,
+                    [weights](size_t index) {
+                        Vector3 x = RandomPoint(index);
+                        return DataPoint<Vector3>({ x, weights.dot(x) });
+                    })
+                .Cache().KeepForever().Execute();
+
+            StochasticGradientDescent<Vector3> sgd(
+                /* num_iterations */ 300, mini_batch_fraction,
+                /* step_size */ 1.0, /* tolerance */ 1e-9, local_steps);
+
+            Vector3 result =
+                sgd.optimize(points, Vector3::Make(3).fill(0.0));
+
+            for (size_t f = 0; f < 3; ++f)
+                ASSERT_NEAR(weights.x[f], result.x[f], 1e-3);
+        });
+}
+
+TEST(StochasticGradientDescent, FullBatch) {
+    TestConvergence(1.0, 1);
+}
+
+TEST(StochasticGradientDescent, MiniBatch) {
+    TestConvergence(0.25, 1);
+}
+
+TEST(StochasticGradientDescent, LocalStepsModelAveraging) {
+    TestConvergence(0.5, 4);
+}
+
+/******************************************************************************/
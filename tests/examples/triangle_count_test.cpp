@@ -99,4 +99,58 @@ TEST(TriangleCount, SomewhatSparse) {
     api::RunLocalTests(start_func);
 }
 
+TEST(TriangleCount, OrientedFullyConnectedWithMultiEdges) {
+
+    auto start_func =
+        [&](Context& ctx) {
+            size_t size = 100;
+
+            auto input = Generate(
+                ctx, size);
+
+            // each edge in both directions, twice, and self-loops
+            auto edges = input.template FlatMap<Edge>(
+                [&size](const size_t& index, auto emit) {
+                    emit(std::make_pair(index, index));
+                    for (size_t target = index + 1; target < size; ++target) {
+                        emit(std::make_pair(index, target));
+                        emit(std::make_pair(target, index));
+                    }
+                }).Cache();
+
+            size_t size_over_3 = size * (size - 1) * (size - 2) / 6;
+
+            // multi-edges count once in the simple graph
+            ASSERT_EQ(CountTrianglesOriented(edges), size_over_3);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(TriangleCount, OrientedSomewhatSparse) {
+
+    auto start_func =
+        [&](Context& ctx) {
+            size_t size = 1000;
+            size_t multiple = 10;
+
+            auto input = Generate(
+                ctx, size);
+
+            auto edges = input.template FlatMap<Edge>(
+                [&size, &multiple](const size_t& index, auto emit) {
+                    for (size_t target = index + multiple; target < size; target = target + multiple) {
+                        emit(std::make_pair(index, target));
+                    }
+                }).Cache();
+
+            size_t size_over_3 = multiple * (size / multiple) * ((size / multiple) - 1) * ((size / multiple) - 2) / 6;
+
+            ASSERT_EQ(CountTrianglesOriented(edges.Keep()), size_over_3);
+            ASSERT_EQ(CountTrianglesOriented(edges), CountTriangles(edges));
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 /******************************************************************************/
@@ -128,3 +128,53 @@ TEST(WordCount, RandomTextWriterTest) {
 }
 
 /******************************************************************************/
+// FastWordCount and TopWords
+
+TEST(WordCount, FastBaconIpsum) {
+
+    auto start_func =
+        [](Context& ctx) {
+            ctx.enable_consume();
+
+            // a tiny cache forces words to be displaced
+            for (size_t cache_size : { 4, 1024 }) {
+                auto lines = ReadLines(ctx, "inputs/wordcount.in");
+
+                std::vector<WordCountPair> result =
+                    FastWordCount(lines, cache_size)
+                    .Map([](const HashWordCount& wc) {
+                             return WordCountPair(wc.first.second, wc.second);
+                         })
+                    .AllGather();
+
+                std::sort(result.begin(), result.end());
+
+                ASSERT_EQ(bacon_ipsum_correct(), result);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(WordCount, TopWordsBaconIpsum) {
+
+    auto start_func =
+        [](Context& ctx) {
+            auto lines = ReadLines(ctx, "inputs/wordcount.in");
+
+            std::vector<WordCountPair> result =
+                TopWords(FastWordCount(lines, 16), 5);
+
+            // ties are ordered by word
+            std::vector<WordCountPair> correct = {
+                { "pork", 64 }, { "beef", 40 }, { "ham", 40 }, { "rump", 40 },
+                { "bacon", 36 }
+            };
+
+            ASSERT_EQ(correct, result);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+/******************************************************************************/
@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * tests/mem/huge_page_arena_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/mem/huge_page_arena.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+using namespace thrill;
+
+TEST(HugePageArena, AllocateAllSlots) {
+    static constexpr size_t slot_size = 64 * 1024;
+    static constexpr size_t num_slots = 40;
+
+    mem::HugePageArena arena(slot_size, num_slots);
+    ASSERT_EQ(num_slots, arena.num_slots());
+    ASSERT_EQ(num_slots, arena.free_slots());
+
+    std::vector<void*> slots;
+    for (size_t i = 0; i < num_slots; ++i) {
+        void* ptr = arena.allocate();
+        ASSERT_TRUE(ptr != nullptr);
+        ASSERT_TRUE(arena.contains(ptr));
+        std::fill(static_cast<char*>(ptr),
+                  static_cast<char*>(ptr) + slot_size, static_cast<char>(i));
+        slots.push_back(ptr);
+    }
+    ASSERT_EQ(nullptr, arena.allocate());
+    ASSERT_EQ(0u, arena.free_slots());
+
+    // all slots are distinct and keep their contents
+    ASSERT_EQ(num_slots, std::set<void*>(slots.begin(), slots.end()).size());
+    for (size_t i = 0; i < num_slots; ++i) {
+        ASSERT_EQ(static_cast<char>(i),
+                  static_cast<char*>(slots[i])[slot_size - 1]);
+    }
+
+    // freed slots are handed out again
+    arena.deallocate(slots[7]);
+    ASSERT_EQ(1u, arena.free_slots());
+    ASSERT_EQ(slots[7], arena.allocate());
+
+    for (void* ptr : slots)
+        arena.deallocate(ptr);
+    ASSERT_EQ(num_slots, arena.free_slots());
+
+    int stack_value = 0;
+    ASSERT_FALSE(arena.contains(&stack_value));
+}
+
+/******************************************************************************/
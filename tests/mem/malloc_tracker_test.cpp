@@ -35,4 +35,35 @@ TEST(MallocTracker, Test1) {
     ASSERT_LE(curr, curr2);
 }
 
+TEST(MallocTracker, TagAttribution) {
+
+    static constexpr size_t tag = 42;
+    mem::malloc_tracker_reset_tag(tag);
+
+    char* a = nullptr;
+    {
+        mem::MallocTagScope scope(tag);
+        a = reinterpret_cast<char*>(malloc(10240000));
+        a[0] = 0;
+    }
+
+    volatile char* av = a;
+    ASSERT_GE(mem::malloc_tracker_tag_current(tag) + av[0], 10240000);
+
+    {
+        mem::MallocTagScope scope(tag);
+        free(a);
+    }
+
+    ASSERT_LT(mem::malloc_tracker_tag_current(tag), 10240000);
+    ASSERT_GE(mem::malloc_tracker_tag_peak(tag), 10240000);
+
+    // allocations outside the scope are not counted for the tag
+    ssize_t tag_curr = mem::malloc_tracker_tag_current(tag);
+    av = reinterpret_cast<char*>(malloc(10240000));
+    av[0] = 0;
+    ASSERT_EQ(mem::malloc_tracker_tag_current(tag) + av[0], tag_curr);
+    free(const_cast<char*>(av));
+}
+
 /******************************************************************************/
@@ -14,11 +14,13 @@
 #include <thrill/common/logger.hpp>
 
 #include <algorithm>
+#include <cstring>
 #include <deque>
 #include <functional>
 #include <random>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -186,6 +188,59 @@ TEST(MemPool, UnorderedMap) {
     }
 }
 
+TEST(MemPool, ThreadCacheAllocDealloc) {
+    mem::Pool pool(16384, /* thread_cache */ true);
+
+    size_t num_threads = 4;
+    size_t iterations = 10000;
+
+    // items allocated by each thread, which are deallocated by the next one
+    std::vector<std::vector<std::pair<void*, size_t> > > lists(num_threads);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&, t]() {
+                std::default_random_engine rng(t);
+                std::vector<std::pair<void*, size_t> >& list = lists[t];
+
+                for (size_t i = 0; i < iterations; ++i) {
+                    if (rng() % 2 == 0 || list.empty()) {
+                        size_t size = (rng() % 256) + 1;
+                        void* ptr = pool.allocate(size);
+                        memset(ptr, static_cast<int>(t), size);
+                        list.emplace_back(ptr, size);
+                    }
+                    else {
+                        std::swap(list[rng() % list.size()], list.back());
+                        pool.deallocate(list.back().first,
+                                        list.back().second);
+                        list.pop_back();
+                    }
+                }
+            });
+    }
+    for (std::thread& t : threads)
+        t.join();
+
+    // the caches of the joined threads were flushed back into the pool
+    pool.self_verify();
+
+    // deallocate remaining items in other threads
+    threads.clear();
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&, t]() {
+                for (auto& p : lists[(t + 1) % num_threads])
+                    pool.deallocate(p.first, p.second);
+            });
+    }
+    for (std::thread& t : threads)
+        t.join();
+
+    pool.self_verify();
+}
+
 namespace thrill {
 namespace mem {
 
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * tests/mem/stage_arena_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/mem/stage_arena.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+TEST(StageArena, RewindWhenEmpty) {
+    mem::Manager manager(nullptr, "StageArenaTest");
+    mem::StageArena arena(manager, 4096);
+    mem::StageArenaAllocator<char> alloc(arena);
+
+    void* first = nullptr;
+    for (size_t i = 0; i < 100; ++i) {
+        mem::arena_string str(
+            "a string which is too long for small string optimization",
+            alloc);
+        for (size_t j = 0; j < 10; ++j) str.append(10, 'x');
+
+        mem::arena_vector<size_t> vec(alloc);
+        for (size_t j = 0; j < 100; ++j) vec.push_back(j);
+
+        ASSERT_EQ(99u, vec.back());
+        ASSERT_GE(arena.live(), 2u);
+
+        // all temporaries of an iteration reuse the same memory
+        if (i == 0) first = &str[0];
+        ASSERT_EQ(first, &str[0]);
+    }
+
+    ASSERT_EQ(0u, arena.live());
+    ASSERT_EQ(manager.total(), arena.capacity());
+    ASSERT_TRUE(arena.Reset());
+}
+
+TEST(StageArena, OversizedAndReset) {
+    mem::Manager manager(nullptr, "StageArenaTest");
+    mem::StageArena arena(manager, 4096);
+    mem::StageArenaAllocator<char> alloc(arena);
+
+    {
+        mem::arena_vector<size_t> small(16, 42, alloc);
+        mem::arena_vector<size_t> large(100000, 42, alloc);
+        ASSERT_EQ(42u, large[99999]);
+        ASSERT_GE(arena.capacity(), 100000 * sizeof(size_t));
+
+        // live allocations are kept
+        ASSERT_FALSE(arena.Reset());
+    }
+
+    ASSERT_TRUE(arena.Reset());
+    ASSERT_EQ(4096u, arena.capacity());
+    ASSERT_EQ(manager.total(), arena.capacity());
+}
+
+/******************************************************************************/
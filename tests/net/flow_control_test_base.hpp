@@ -139,6 +139,28 @@ static void TestMultiThreadBroadcast(net::Group* net) {
         });
 }
 
+/*!
+ * Broadcasts a value among the threads of each host, from each local id.
+ */
+static void TestMultiThreadLocalBroadcast(net::Group* net) {
+    const size_t count = 4;
+    const size_t magic = 1337;
+    ExecuteMultiThreads(
+        net, count, [=](net::FlowControlChannel& channel) {
+
+            for (size_t origin = 0; origin < count; ++origin) {
+
+                size_t local_id = channel.my_rank() % count;
+                size_t value = origin == local_id ?
+                               magic + channel.my_rank() : 0;
+
+                size_t res = channel.LocalBroadcast(value, origin);
+
+                ASSERT_EQ(res, magic + channel.my_rank() - local_id + origin);
+            }
+        });
+}
+
 /*!
  * Calculates a sum over all worker and thread ids.
  */
@@ -237,6 +259,45 @@ static void TestMultiThreadPrefixSum(net::Group* net) {
         });
 }
 
+/*!
+ * Executes AllReduces, a Broadcast, and prefix sums in one collective round.
+ */
+static void TestMultiThreadBatch(net::Group* net) {
+
+    const size_t count = 4;
+
+    ExecuteMultiThreads(
+        net, count, [=](net::FlowControlChannel& channel) {
+            size_t my_rank = channel.my_rank();
+            size_t num_workers = channel.num_workers();
+
+            size_t sum = my_rank, max = my_rank;
+            std::string str = "worker " + std::to_string(my_rank);
+
+            net::FlowControlChannel::Batch batch(channel);
+            batch.AllReduce(&sum);
+            batch.AllReduce(&max, common::maximum<size_t>());
+            batch.Broadcast(&str, num_workers - 1);
+            ASSERT_EQ(3u, batch.size());
+            batch.Execute();
+            ASSERT_EQ(0u, batch.size());
+
+            ASSERT_EQ(num_workers * (num_workers - 1) / 2, sum);
+            ASSERT_EQ(num_workers - 1, max);
+            ASSERT_EQ("worker " + std::to_string(num_workers - 1), str);
+
+            size_t total = my_rank, inclusive = my_rank, exclusive = my_rank;
+            batch.AllReduce(&total);
+            batch.PrefixSum(&inclusive, std::plus<size_t>(), size_t(42));
+            batch.ExPrefixSum(&exclusive, std::plus<size_t>(), size_t(42));
+            batch.Execute();
+
+            ASSERT_EQ(num_workers * (num_workers - 1) / 2, total);
+            ASSERT_EQ(42 + my_rank * (my_rank + 1) / 2, inclusive);
+            ASSERT_EQ(42 + my_rank * (my_rank - 1) / 2, exclusive);
+        });
+}
+
 // perform first test: PE must be items only from predecessor
 static void TestPredecessorManyItems(net::Group* net) {
 
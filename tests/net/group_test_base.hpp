@@ -13,9 +13,14 @@
 #define THRILL_TESTS_NET_GROUP_TEST_BASE_HEADER
 
 #include <thrill/common/math.hpp>
+#include <thrill/data/block.hpp>
+#include <thrill/data/block_pool.hpp>
+#include <thrill/net/dispatcher_thread.hpp>
 #include <thrill/net/group.hpp>
 #include <tlx/math/round_to_power_of_two.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <future>
 #include <string>
@@ -214,6 +219,23 @@ static void TestAllReduceEliminationString(net::Group* net) {
     ASSERT_EQ(result.substr(0, net->num_hosts()), local_value);
 }
 
+//! let group of p hosts perform a ring AllReduce on vectors of various sizes
+static void TestAllReduceRingVector(net::Group* net) {
+    const size_t p = net->num_hosts();
+    for (size_t n : { size_t(0), size_t(1), p + 1, size_t(1001) }) {
+        std::vector<size_t> local_value(n);
+        for (size_t i = 0; i < n; ++i)
+            local_value[i] = i * (net->my_host_rank() + 1);
+
+        net->AllReduceRing(
+            local_value, common::ComponentSum<std::vector<size_t> >());
+
+        ASSERT_EQ(n, local_value.size());
+        for (size_t i = 0; i < n; ++i)
+            ASSERT_EQ(i * p * (p + 1) / 2, local_value[i]);
+    }
+}
+
 /******************************************************************************/
 // Dispatcher Tests
 
@@ -261,6 +283,58 @@ static void TestDispatcherLaunchAndTerminate(net::Group* net) {
     std::this_thread::sleep_for(std::chrono::microseconds(1));
 }
 
+//! use DispatcherThread to send headers with small and large blocks, which are
+//! coalesced into one write on byte stream connections.
+static void TestDispatcherAsyncWriteHeaderAndBlock(net::Group* net) {
+    data::BlockPool block_pool;
+    net::DispatcherThread disp(net->ConstructDispatcher(), 0);
+
+    const size_t sizes[2] = {
+        100, net::DispatcherThread::coalesce_block_size + 100
+    };
+
+    // send a header and a small and a large block to all other hosts.
+    for (size_t i = 0; i < net->num_hosts(); ++i) {
+        if (i == net->my_host_rank()) continue;
+        for (size_t k = 0; k < 2; ++k) {
+            data::PinnedByteBlockPtr bytes =
+                block_pool.AllocateByteBlock(sizes[k], 0);
+            std::fill(bytes->begin(), bytes->begin() + sizes[k],
+                      static_cast<uint8_t>(net->my_host_rank() + k));
+            size_t header = sizes[k];
+            disp.AsyncWrite(
+                net->connection(i), /* seq */ 2 * k,
+                net::Buffer(&header, sizeof(header)),
+                data::PinnedBlock(std::move(bytes), 0, sizes[k], 0, 0, false));
+        }
+    }
+
+    std::atomic<size_t> received { 0 };
+
+    for (size_t i = 0; i < net->num_hosts(); ++i) {
+        if (i == net->my_host_rank()) continue;
+        for (size_t k = 0; k < 2; ++k) {
+            disp.AsyncRead(
+                net->connection(i), /* seq */ 2 * k, sizeof(size_t),
+                [k, &sizes](net::Connection&, net::Buffer&& b) {
+                    ASSERT_EQ(sizes[k],
+                              *reinterpret_cast<const size_t*>(b.data()));
+                });
+            disp.AsyncRead(
+                net->connection(i), /* seq */ 2 * k + 1, sizes[k],
+                [i, k, &sizes, &received](net::Connection&, net::Buffer&& b) {
+                    ASSERT_EQ(sizes[k], b.size());
+                    for (size_t j = 0; j < b.size(); ++j)
+                        ASSERT_EQ(static_cast<uint8_t>(i + k), b[j]);
+                    ++received;
+                });
+        }
+    }
+
+    while (received != 2 * (net->num_hosts() - 1))
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
 //! use DispatcherThread to send and receive messages asynchronously.
 //! this test produces a data race condition, which is probably a problem of
 //! std::future
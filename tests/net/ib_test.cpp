@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * tests/net/ib_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/logger.hpp>
+#include <thrill/net/ib/group.hpp>
+
+#include "flow_control_test_base.hpp"
+#include "group_test_base.hpp"
+
+using namespace thrill;      // NOLINT
+
+void IbTest(const std::function<void(net::Group*)>& thread_function) {
+
+    size_t num_hosts = net::ib::NumMpiProcesses();
+    sLOG0 << "IbTest num_hosts" << num_hosts;
+
+    // construct InfiniBand network group and run program
+    std::unique_ptr<net::ib::Group> group;
+
+    if (net::ib::Construct(num_hosts, &group, 1)) {
+        // only run if construction included this host in the group.
+
+        // we cannot run a truly threaded test anyway.
+        thread_function(group.get());
+
+        // needed for sync, otherwise independent tests run in parallel
+        group->Barrier();
+    }
+}
+
+/*[[[perl
+  require("tests/net/test_gen.pm");
+  generate_group_tests("IbGroup", "IbTest");
+  generate_flow_control_tests("IbGroup", "IbTest");
+  ]]]*/
+TEST(IbGroup, NoOperation) {
+    IbTest(TestNoOperation);
+}
+TEST(IbGroup, SendRecvCyclic) {
+    IbTest(TestSendRecvCyclic);
+}
+TEST(IbGroup, BroadcastIntegral) {
+    IbTest(TestBroadcastIntegral);
+}
+TEST(IbGroup, SendReceiveAll2All) {
+    IbTest(TestSendReceiveAll2All);
+}
+TEST(IbGroup, PrefixSumHypercube) {
+    IbTest(TestPrefixSumHypercube);
+}
+TEST(IbGroup, PrefixSumHypercubeString) {
+    IbTest(TestPrefixSumHypercubeString);
+}
+TEST(IbGroup, PrefixSum) {
+    IbTest(TestPrefixSum);
+}
+TEST(IbGroup, Broadcast) {
+    IbTest(TestBroadcast);
+}
+TEST(IbGroup, Reduce) {
+    IbTest(TestReduce);
+}
+TEST(IbGroup, ReduceString) {
+    IbTest(TestReduceString);
+}
+TEST(IbGroup, AllReduceString) {
+    IbTest(TestAllReduceString);
+}
+TEST(IbGroup, AllReduceHypercubeString) {
+    IbTest(TestAllReduceHypercubeString);
+}
+TEST(IbGroup, AllReduceEliminationString) {
+    IbTest(TestAllReduceEliminationString);
+}
+TEST(IbGroup, AllReduceRingVector) {
+    IbTest(TestAllReduceRingVector);
+}
+TEST(IbGroup, DispatcherSyncSendAsyncRead) {
+    IbTest(TestDispatcherSyncSendAsyncRead);
+}
+TEST(IbGroup, DispatcherLaunchAndTerminate) {
+    IbTest(TestDispatcherLaunchAndTerminate);
+}
+TEST(IbGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    IbTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
+TEST(IbGroup, SingleThreadPrefixSum) {
+    IbTest(TestSingleThreadPrefixSum);
+}
+TEST(IbGroup, SingleThreadVectorPrefixSum) {
+    IbTest(TestSingleThreadVectorPrefixSum);
+}
+TEST(IbGroup, SingleThreadBroadcast) {
+    IbTest(TestSingleThreadBroadcast);
+}
+TEST(IbGroup, MultiThreadBroadcast) {
+    IbTest(TestMultiThreadBroadcast);
+}
+TEST(IbGroup, MultiThreadLocalBroadcast) {
+    IbTest(TestMultiThreadLocalBroadcast);
+}
+TEST(IbGroup, MultiThreadReduce) {
+    IbTest(TestMultiThreadReduce);
+}
+TEST(IbGroup, SingleThreadAllReduce) {
+    IbTest(TestSingleThreadAllReduce);
+}
+TEST(IbGroup, MultiThreadAllReduce) {
+    IbTest(TestMultiThreadAllReduce);
+}
+TEST(IbGroup, MultiThreadPrefixSum) {
+    IbTest(TestMultiThreadPrefixSum);
+}
+TEST(IbGroup, MultiThreadBatch) {
+    IbTest(TestMultiThreadBatch);
+}
+TEST(IbGroup, PredecessorManyItems) {
+    IbTest(TestPredecessorManyItems);
+}
+TEST(IbGroup, PredecessorFewItems) {
+    IbTest(TestPredecessorFewItems);
+}
+TEST(IbGroup, PredecessorOneItem) {
+    IbTest(TestPredecessorOneItem);
+}
+TEST(IbGroup, HardcoreRaceConditionTest) {
+    IbTest(TestHardcoreRaceConditionTest);
+}
+TEST(IbGroup, AllGather) {
+    IbTest(TestAllGather);
+}
+TEST(IbGroup, AllGatherMultiThreaded) {
+    IbTest(TestAllGatherMultiThreaded);
+}
+TEST(IbGroup, AllGatherString) {
+    IbTest(TestAllGatherString);
+}
+// [[[end]]]
+
+/******************************************************************************/
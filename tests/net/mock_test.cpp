@@ -94,12 +94,18 @@ TEST(MockGroup, AllReduceHypercubeString) {
 TEST(MockGroup, AllReduceEliminationString) {
     MockTest(TestAllReduceEliminationString);
 }
+TEST(MockGroup, AllReduceRingVector) {
+    MockTest(TestAllReduceRingVector);
+}
 TEST(MockGroup, DispatcherSyncSendAsyncRead) {
     MockTest(TestDispatcherSyncSendAsyncRead);
 }
 TEST(MockGroup, DispatcherLaunchAndTerminate) {
     MockTest(TestDispatcherLaunchAndTerminate);
 }
+TEST(MockGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    MockTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
 TEST(MockGroup, SingleThreadPrefixSum) {
     MockTestLess(TestSingleThreadPrefixSum);
 }
@@ -112,6 +118,9 @@ TEST(MockGroup, SingleThreadBroadcast) {
 TEST(MockGroup, MultiThreadBroadcast) {
     MockTestLess(TestMultiThreadBroadcast);
 }
+TEST(MockGroup, MultiThreadLocalBroadcast) {
+    MockTestLess(TestMultiThreadLocalBroadcast);
+}
 TEST(MockGroup, MultiThreadReduce) {
     MockTestLess(TestMultiThreadReduce);
 }
@@ -124,6 +133,9 @@ TEST(MockGroup, MultiThreadAllReduce) {
 TEST(MockGroup, MultiThreadPrefixSum) {
     MockTestLess(TestMultiThreadPrefixSum);
 }
+TEST(MockGroup, MultiThreadBatch) {
+    MockTestLess(TestMultiThreadBatch);
+}
 TEST(MockGroup, PredecessorManyItems) {
     MockTestLess(TestPredecessorManyItems);
 }
@@ -84,12 +84,18 @@ TEST(MpiGroup, AllReduceHypercubeString) {
 TEST(MpiGroup, AllReduceEliminationString) {
     MpiTest(TestAllReduceEliminationString);
 }
+TEST(MpiGroup, AllReduceRingVector) {
+    MpiTest(TestAllReduceRingVector);
+}
 TEST(MpiGroup, DispatcherSyncSendAsyncRead) {
     MpiTest(TestDispatcherSyncSendAsyncRead);
 }
 TEST(MpiGroup, DispatcherLaunchAndTerminate) {
     MpiTest(TestDispatcherLaunchAndTerminate);
 }
+TEST(MpiGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    MpiTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
 TEST(MpiGroup, SingleThreadPrefixSum) {
     MpiTest(TestSingleThreadPrefixSum);
 }
@@ -102,6 +108,9 @@ TEST(MpiGroup, SingleThreadBroadcast) {
 TEST(MpiGroup, MultiThreadBroadcast) {
     MpiTest(TestMultiThreadBroadcast);
 }
+TEST(MpiGroup, MultiThreadLocalBroadcast) {
+    MpiTest(TestMultiThreadLocalBroadcast);
+}
 TEST(MpiGroup, MultiThreadReduce) {
     MpiTest(TestMultiThreadReduce);
 }
@@ -114,6 +123,9 @@ TEST(MpiGroup, MultiThreadAllReduce) {
 TEST(MpiGroup, MultiThreadPrefixSum) {
     MpiTest(TestMultiThreadPrefixSum);
 }
+TEST(MpiGroup, MultiThreadBatch) {
+    MpiTest(TestMultiThreadBatch);
+}
 TEST(MpiGroup, PredecessorManyItems) {
     MpiTest(TestPredecessorManyItems);
 }
@@ -137,4 +149,35 @@ TEST(MpiGroup, AllGatherString) {
 }
 // [[[end]]]
 
+//! send messages on two Groups in opposite orders: each Group has its own MPI
+//! communicator, hence a receive on one Group never matches the other's.
+TEST(MpiGroup, SeparateGroupCommunicators) {
+
+    size_t num_hosts = net::mpi::NumMpiProcesses();
+
+    net::DispatcherThread dispatcher(
+        std::make_unique<net::mpi::Dispatcher>(num_hosts), num_hosts);
+    std::unique_ptr<net::mpi::Group> groups[2];
+
+    if (net::mpi::Construct(num_hosts, dispatcher, groups, 2)) {
+        size_t id = groups[0]->my_host_rank();
+
+        for (size_t p = 0; p < num_hosts; ++p) {
+            if (p == id) continue;
+            groups[1]->SendTo(p, 1000 + id);
+            groups[0]->SendTo(p, id);
+        }
+        for (size_t p = 0; p < num_hosts; ++p) {
+            if (p == id) continue;
+            size_t res;
+            groups[0]->ReceiveFrom<size_t>(p, &res);
+            ASSERT_EQ(p, res);
+            groups[1]->ReceiveFrom<size_t>(p, &res);
+            ASSERT_EQ(1000 + p, res);
+        }
+    }
+
+    groups[0]->Barrier();
+}
+
 /******************************************************************************/
@@ -0,0 +1,181 @@
+/*******************************************************************************
+ * tests/net/shm_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/mem/manager.hpp>
+#include <thrill/net/dispatcher_thread.hpp>
+#include <thrill/net/shm/group.hpp>
+
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flow_control_test_base.hpp"
+#include "group_test_base.hpp"
+
+using namespace thrill;      // NOLINT
+
+static void LocalGroupTest(
+    const std::function<void(net::Group*)>& thread_function) {
+    // execute shared memory ring tests within this process
+    net::ExecuteGroupThreads(
+        net::shm::Group::ConstructLoopbackMesh(6),
+        thread_function);
+}
+
+/*[[[perl
+  require("tests/net/test_gen.pm");
+  generate_group_tests("ShmGroup", "LocalGroupTest");
+  generate_flow_control_tests("ShmGroup", "LocalGroupTest");
+  ]]]*/
+TEST(ShmGroup, NoOperation) {
+    LocalGroupTest(TestNoOperation);
+}
+TEST(ShmGroup, SendRecvCyclic) {
+    LocalGroupTest(TestSendRecvCyclic);
+}
+TEST(ShmGroup, BroadcastIntegral) {
+    LocalGroupTest(TestBroadcastIntegral);
+}
+TEST(ShmGroup, SendReceiveAll2All) {
+    LocalGroupTest(TestSendReceiveAll2All);
+}
+TEST(ShmGroup, PrefixSumHypercube) {
+    LocalGroupTest(TestPrefixSumHypercube);
+}
+TEST(ShmGroup, PrefixSumHypercubeString) {
+    LocalGroupTest(TestPrefixSumHypercubeString);
+}
+TEST(ShmGroup, PrefixSum) {
+    LocalGroupTest(TestPrefixSum);
+}
+TEST(ShmGroup, Broadcast) {
+    LocalGroupTest(TestBroadcast);
+}
+TEST(ShmGroup, Reduce) {
+    LocalGroupTest(TestReduce);
+}
+TEST(ShmGroup, ReduceString) {
+    LocalGroupTest(TestReduceString);
+}
+TEST(ShmGroup, AllReduceString) {
+    LocalGroupTest(TestAllReduceString);
+}
+TEST(ShmGroup, AllReduceHypercubeString) {
+    LocalGroupTest(TestAllReduceHypercubeString);
+}
+TEST(ShmGroup, AllReduceEliminationString) {
+    LocalGroupTest(TestAllReduceEliminationString);
+}
+TEST(ShmGroup, AllReduceRingVector) {
+    LocalGroupTest(TestAllReduceRingVector);
+}
+TEST(ShmGroup, DispatcherSyncSendAsyncRead) {
+    LocalGroupTest(TestDispatcherSyncSendAsyncRead);
+}
+TEST(ShmGroup, DispatcherLaunchAndTerminate) {
+    LocalGroupTest(TestDispatcherLaunchAndTerminate);
+}
+TEST(ShmGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    LocalGroupTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
+TEST(ShmGroup, SingleThreadPrefixSum) {
+    LocalGroupTest(TestSingleThreadPrefixSum);
+}
+TEST(ShmGroup, SingleThreadVectorPrefixSum) {
+    LocalGroupTest(TestSingleThreadVectorPrefixSum);
+}
+TEST(ShmGroup, SingleThreadBroadcast) {
+    LocalGroupTest(TestSingleThreadBroadcast);
+}
+TEST(ShmGroup, MultiThreadBroadcast) {
+    LocalGroupTest(TestMultiThreadBroadcast);
+}
+TEST(ShmGroup, MultiThreadLocalBroadcast) {
+    LocalGroupTest(TestMultiThreadLocalBroadcast);
+}
+TEST(ShmGroup, MultiThreadReduce) {
+    LocalGroupTest(TestMultiThreadReduce);
+}
+TEST(ShmGroup, SingleThreadAllReduce) {
+    LocalGroupTest(TestSingleThreadAllReduce);
+}
+TEST(ShmGroup, MultiThreadAllReduce) {
+    LocalGroupTest(TestMultiThreadAllReduce);
+}
+TEST(ShmGroup, MultiThreadPrefixSum) {
+    LocalGroupTest(TestMultiThreadPrefixSum);
+}
+TEST(ShmGroup, MultiThreadBatch) {
+    LocalGroupTest(TestMultiThreadBatch);
+}
+TEST(ShmGroup, PredecessorManyItems) {
+    LocalGroupTest(TestPredecessorManyItems);
+}
+TEST(ShmGroup, PredecessorFewItems) {
+    LocalGroupTest(TestPredecessorFewItems);
+}
+TEST(ShmGroup, PredecessorOneItem) {
+    LocalGroupTest(TestPredecessorOneItem);
+}
+TEST(ShmGroup, HardcoreRaceConditionTest) {
+    LocalGroupTest(TestHardcoreRaceConditionTest);
+}
+TEST(ShmGroup, AllGather) {
+    LocalGroupTest(TestAllGather);
+}
+TEST(ShmGroup, AllGatherMultiThreaded) {
+    LocalGroupTest(TestAllGatherMultiThreaded);
+}
+TEST(ShmGroup, AllGatherString) {
+    LocalGroupTest(TestAllGatherString);
+}
+// [[[end]]]
+
+//! connect hosts via named segments with Construct(), as separate processes
+//! would, and exchange messages larger than the rings.
+TEST(ShmGroup, ConstructNamedSegments) {
+    static constexpr size_t num_hosts = 4;
+    static constexpr size_t ring_size = 4096;
+
+    std::string name = "thrill-shm-test-" + std::to_string(getpid());
+
+    std::vector<std::thread> threads(num_hosts);
+    for (size_t r = 0; r < num_hosts; ++r) {
+        threads[r] = std::thread(
+            [r, &name]() {
+                std::unique_ptr<net::shm::Group> groups[2];
+                net::shm::Construct(name, r, num_hosts, groups, 2, ring_size);
+
+                for (size_t g = 0; g < 2; ++g) {
+                    net::Group& group = *groups[g];
+                    ASSERT_EQ(num_hosts, group.num_hosts());
+                    ASSERT_EQ(r, group.my_host_rank());
+
+                    std::vector<size_t> send(4 * ring_size, r + g);
+                    std::vector<size_t> recv(send.size());
+
+                    // exchange with the partner host, both directions are
+                    // interleaved, hence the rings cannot block.
+                    size_t partner = r ^ 1;
+                    group.connection(partner).SyncSendRecv(
+                        send.data(), send.size() * sizeof(size_t),
+                        recv.data(), recv.size() * sizeof(size_t));
+
+                    for (size_t x : recv)
+                        ASSERT_EQ(partner + g, x);
+                }
+            });
+    }
+    for (size_t r = 0; r < num_hosts; ++r)
+        threads[r].join();
+}
+
+/******************************************************************************/
@@ -11,14 +11,20 @@
 #include <gtest/gtest.h>
 #include <thrill/mem/manager.hpp>
 #include <thrill/net/dispatcher_thread.hpp>
+#include <thrill/net/tcp/construct.hpp>
+#include <thrill/net/tcp/epoll_dispatcher.hpp>
 #include <thrill/net/tcp/group.hpp>
 #include <thrill/net/tcp/select_dispatcher.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <random>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include <sys/socket.h>
+
 #include "flow_control_test_base.hpp"
 #include "group_test_base.hpp"
 
@@ -86,12 +92,18 @@ TEST(RealTcpGroup, AllReduceHypercubeString) {
 TEST(RealTcpGroup, AllReduceEliminationString) {
     RealGroupTest(TestAllReduceEliminationString);
 }
+TEST(RealTcpGroup, AllReduceRingVector) {
+    RealGroupTest(TestAllReduceRingVector);
+}
 TEST(RealTcpGroup, DispatcherSyncSendAsyncRead) {
     RealGroupTest(TestDispatcherSyncSendAsyncRead);
 }
 TEST(RealTcpGroup, DispatcherLaunchAndTerminate) {
     RealGroupTest(TestDispatcherLaunchAndTerminate);
 }
+TEST(RealTcpGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    RealGroupTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
 TEST(LocalTcpGroup, NoOperation) {
     LocalGroupTest(TestNoOperation);
 }
@@ -131,12 +143,18 @@ TEST(LocalTcpGroup, AllReduceHypercubeString) {
 TEST(LocalTcpGroup, AllReduceEliminationString) {
     LocalGroupTest(TestAllReduceEliminationString);
 }
+TEST(LocalTcpGroup, AllReduceRingVector) {
+    LocalGroupTest(TestAllReduceRingVector);
+}
 TEST(LocalTcpGroup, DispatcherSyncSendAsyncRead) {
     LocalGroupTest(TestDispatcherSyncSendAsyncRead);
 }
 TEST(LocalTcpGroup, DispatcherLaunchAndTerminate) {
     LocalGroupTest(TestDispatcherLaunchAndTerminate);
 }
+TEST(LocalTcpGroup, DispatcherAsyncWriteHeaderAndBlock) {
+    LocalGroupTest(TestDispatcherAsyncWriteHeaderAndBlock);
+}
 TEST(LocalTcpGroup, SingleThreadPrefixSum) {
     LocalGroupTest(TestSingleThreadPrefixSum);
 }
@@ -149,6 +167,9 @@ TEST(LocalTcpGroup, SingleThreadBroadcast) {
 TEST(LocalTcpGroup, MultiThreadBroadcast) {
     LocalGroupTest(TestMultiThreadBroadcast);
 }
+TEST(LocalTcpGroup, MultiThreadLocalBroadcast) {
+    LocalGroupTest(TestMultiThreadLocalBroadcast);
+}
 TEST(LocalTcpGroup, MultiThreadReduce) {
     LocalGroupTest(TestMultiThreadReduce);
 }
@@ -161,6 +182,9 @@ TEST(LocalTcpGroup, MultiThreadAllReduce) {
 TEST(LocalTcpGroup, MultiThreadPrefixSum) {
     LocalGroupTest(TestMultiThreadPrefixSum);
 }
+TEST(LocalTcpGroup, MultiThreadBatch) {
+    LocalGroupTest(TestMultiThreadBatch);
+}
 TEST(LocalTcpGroup, PredecessorManyItems) {
     LocalGroupTest(TestPredecessorManyItems);
 }
@@ -184,4 +208,203 @@ TEST(LocalTcpGroup, AllGatherString) {
 }
 // [[[end]]]
 
+//! exchange large messages between all hosts with asynchronous writes and reads
+//! on the given Dispatcher type, which need many partial socket operations.
+template <typename Dispatcher>
+static void TestDispatcherAsyncWriteRead(net::Group* net) {
+    static constexpr size_t size = 1024 * 1024;
+
+    Dispatcher dispatcher;
+    size_t received = 0;
+
+    for (size_t i = 0; i < net->num_hosts(); ++i) {
+        if (i == net->my_host_rank()) continue;
+
+        net::Buffer buffer(size);
+        std::fill(buffer.begin(), buffer.end(),
+                  static_cast<uint8_t>(net->my_host_rank()));
+        dispatcher.AsyncWrite(net->connection(i), /* seq */ 0,
+                              std::move(buffer));
+
+        dispatcher.AsyncRead(
+            net->connection(i), /* seq */ 0, size,
+            [i, &received](net::Connection&, net::Buffer&& b) {
+                ASSERT_EQ(size, b.size());
+                ASSERT_TRUE(std::all_of(
+                                b.begin(), b.end(),
+                                [i](uint8_t x) { return x == i; }));
+                ++received;
+            });
+    }
+
+    while (received < net->num_hosts() - 1 || dispatcher.HasAsyncWrites())
+        dispatcher.Dispatch();
+}
+
+TEST(LocalTcpGroup, SelectDispatcherAsyncWriteRead) {
+    LocalGroupTest(TestDispatcherAsyncWriteRead<net::tcp::SelectDispatcher>);
+}
+
+#if THRILL_HAVE_NET_EPOLL
+TEST(LocalTcpGroup, EPollDispatcherAsyncWriteRead) {
+    LocalGroupTest(TestDispatcherAsyncWriteRead<net::tcp::EPollDispatcher>);
+}
+#endif
+
+// construct a lazy and an eager group via localhost ports, the lazy group
+// connects to the peers on the first access by the collectives.
+TEST(RealTcpGroup, LazyConnect) {
+    static constexpr size_t num_hosts = 4;
+
+    std::default_random_engine generator(std::random_device { } ());
+    std::uniform_int_distribution<int> distribution(10000, 30000);
+    const size_t port_base = distribution(generator);
+
+    std::vector<std::string> endpoints;
+    for (size_t i = 0; i < num_hosts; ++i)
+        endpoints.push_back("127.0.0.1:" + std::to_string(port_base + i));
+
+    std::vector<std::thread> threads(num_hosts);
+    for (size_t i = 0; i < num_hosts; ++i) {
+        threads[i] = std::thread(
+            [i, &endpoints]() {
+                std::unique_ptr<net::tcp::Group> groups[2];
+                {
+                    net::tcp::SelectDispatcher dispatcher;
+                    net::tcp::Construct(dispatcher, i, endpoints, groups, 2,
+                                        /* num_lazy_groups */ 1);
+                }
+
+                for (size_t p = 0; p < num_hosts; ++p) {
+                    ASSERT_EQ(p == i, groups[0]->IsConnected(p));
+                    ASSERT_TRUE(groups[1]->IsConnected(p));
+                }
+
+                TestPrefixSumHypercube(groups[0].get());
+                TestSendReceiveAll2All(groups[0].get());
+                TestSendReceiveAll2All(groups[1].get());
+
+                for (size_t p = 0; p < num_hosts; ++p)
+                    ASSERT_TRUE(groups[0]->IsConnected(p));
+            });
+    }
+
+    for (size_t i = 0; i < num_hosts; ++i)
+        threads[i].join();
+}
+
+#if __linux__
+//! SO_PRIORITY of the socket of a Connection
+static int GetSocketPriority(net::tcp::Connection& connection) {
+    int priority = -1;
+    socklen_t len = sizeof(priority);
+    if (::getsockopt(connection.GetSocket().fd(), SOL_SOCKET, SO_PRIORITY,
+                     &priority, &len) != 0)
+        return -1;
+    return priority;
+}
+
+// set the priorities of a lazy flow group and an eager data group, the lazy
+// connections receive theirs when they are assigned to the group.
+TEST(RealTcpGroup, SocketPriority) {
+    static constexpr size_t num_hosts = 4;
+
+    std::default_random_engine generator(std::random_device { } ());
+    std::uniform_int_distribution<int> distribution(10000, 30000);
+    const size_t port_base = distribution(generator);
+
+    std::vector<std::string> endpoints;
+    for (size_t i = 0; i < num_hosts; ++i)
+        endpoints.push_back("127.0.0.1:" + std::to_string(port_base + i));
+
+    std::vector<std::thread> threads(num_hosts);
+    for (size_t i = 0; i < num_hosts; ++i) {
+        threads[i] = std::thread(
+            [i, &endpoints]() {
+                std::unique_ptr<net::tcp::Group> groups[2];
+                {
+                    net::tcp::SelectDispatcher dispatcher;
+                    net::tcp::Construct(dispatcher, i, endpoints, groups, 2,
+                                        /* num_lazy_groups */ 1);
+                }
+
+                groups[0]->SetSocketPriority(
+                    net::tcp::Socket::kPriorityInteractive);
+                groups[1]->SetSocketPriority(net::tcp::Socket::kPriorityBulk);
+
+                // connects the flow group lazily
+                TestSendReceiveAll2All(groups[0].get());
+                TestSendReceiveAll2All(groups[1].get());
+
+                for (size_t p = 0; p < num_hosts; ++p) {
+                    if (p == i) continue;
+                    ASSERT_EQ(net::tcp::Socket::kPriorityInteractive,
+                              GetSocketPriority(groups[0]->tcp_connection(p)));
+                    ASSERT_EQ(net::tcp::Socket::kPriorityBulk,
+                              GetSocketPriority(groups[1]->tcp_connection(p)));
+                }
+            });
+    }
+
+    for (size_t i = 0; i < num_hosts; ++i)
+        threads[i].join();
+}
+#endif
+
+// construct a larger mesh of two groups with the default dispatcher, in which
+// the last host starts late: the others retry their connects to it, and each
+// host accepts many connections per listener event.
+TEST(RealTcpGroup, ConstructMeshWithLateHost) {
+    static constexpr size_t num_hosts = 24;
+
+    std::default_random_engine generator(std::random_device { } ());
+    std::uniform_int_distribution<int> distribution(10000, 30000);
+    const size_t port_base = distribution(generator);
+
+    std::vector<std::string> endpoints;
+    for (size_t i = 0; i < num_hosts; ++i)
+        endpoints.push_back("127.0.0.1:" + std::to_string(port_base + i));
+
+    std::vector<std::thread> threads(num_hosts);
+    for (size_t i = 0; i < num_hosts; ++i) {
+        threads[i] = std::thread(
+            [i, &endpoints]() {
+                if (i == num_hosts - 1) {
+                    std::this_thread::sleep_for(
+                        std::chrono::milliseconds(500));
+                }
+
+                std::unique_ptr<net::tcp::Group> groups[2];
+                {
+                    std::unique_ptr<net::Dispatcher> dispatcher =
+                        net::tcp::Group::ConstructTcpDispatcher();
+                    net::tcp::Construct(*dispatcher, i, endpoints, groups, 2);
+                }
+
+                for (size_t g = 0; g < 2; ++g) {
+                    ASSERT_EQ(num_hosts, groups[g]->num_hosts());
+                    for (size_t p = 0; p < num_hosts; ++p)
+                        ASSERT_TRUE(groups[g]->IsConnected(p));
+                }
+
+                TestSendReceiveAll2All(groups[0].get());
+                TestSendReceiveAll2All(groups[1].get());
+            });
+    }
+
+    for (size_t i = 0; i < num_hosts; ++i)
+        threads[i].join();
+}
+
+#if THRILL_HAVE_NET_ZEROCOPY
+// send the large Blocks with MSG_ZEROCOPY over real TCP sockets
+TEST(RealTcpGroup, DispatcherAsyncWriteZeroCopy) {
+    RealGroupTest(
+        [](net::Group* net) {
+            static_cast<net::tcp::Group*>(net)->EnableZeroCopy();
+            TestDispatcherAsyncWriteHeaderAndBlock(net);
+        });
+}
+#endif
+
 /******************************************************************************/
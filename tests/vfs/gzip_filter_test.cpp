@@ -68,4 +68,54 @@ TEST(GZipFilterTest, WriteReadSingleFile) {
     }
 }
 
+TEST(GZipFilterTest, ParallelWriteReadSingleFile) {
+    vfs::TemporaryDirectory tmpdir;
+
+    {
+        vfs::WriteStreamPtr ws = vfs::SysOpenWriteStream(
+            tmpdir.get() + "/test.dat.gz");
+
+        vfs::WriteStreamPtr zs = vfs::MakeParallelGZipWriteFilter(ws, 3);
+
+        std::string test_string("test123abc");
+        for (size_t i = 0; i < 1000000; ++i) {
+            zs->write(test_string.data(), test_string.size());
+        }
+
+        for (size_t i = 0; i < 1000000; ++i) {
+            zs->write(&i, sizeof(i));
+        }
+
+        // put one more byte in
+        zs->write(test_string.data(), 1);
+
+        zs->close();
+    }
+    {
+        vfs::ReadStreamPtr rs = vfs::SysOpenReadStream(
+            tmpdir.get() + "/test.dat.gz");
+
+        vfs::ReadStreamPtr zs = vfs::MakeGZipReadFilter(rs);
+
+        char buffer[10 + 1];
+        for (size_t i = 0; i < 1000000; ++i) {
+            zs->read(buffer, 10);
+            buffer[10] = 0;
+            ASSERT_EQ(std::string(buffer), "test123abc");
+        }
+
+        for (size_t i = 0; i < 1000000; ++i) {
+            size_t r;
+            zs->read(&r, sizeof(r));
+            ASSERT_EQ(r, i);
+        }
+
+        // read beyond end-of-file
+        ssize_t rb = zs->read(buffer, 10);
+        ASSERT_EQ(rb, 1);
+
+        zs->close();
+    }
+}
+
 /******************************************************************************/
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * tests/vfs/locality_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/locality.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace thrill;
+
+static vfs::FileList MakeFileList(const std::vector<uint64_t>& sizes) {
+    vfs::FileList files;
+    uint64_t psum = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        vfs::FileInfo fi;
+        fi.type = vfs::Type::File;
+        fi.path = "hdfs://namenode/file" + std::to_string(i);
+        fi.size = sizes[i];
+        fi.size_ex_psum = psum;
+        psum += sizes[i];
+        files.emplace_back(fi);
+    }
+    files.total_size = psum;
+    files.contains_compressed = false;
+    files.contains_remote_uri = true;
+    return files;
+}
+
+//! calculate bytes per worker and check that pieces cover the files
+static std::vector<uint64_t> PieceLoads(
+    const vfs::FileList& files,
+    const std::vector<std::pair<uint64_t, size_t> >& pieces,
+    size_t num_workers) {
+    std::vector<uint64_t> load(num_workers);
+    EXPECT_EQ(0u, pieces.front().first);
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        uint64_t end = i + 1 < pieces.size()
+                       ? pieces[i + 1].first : files.total_size;
+        EXPECT_LT(pieces[i].first, end);
+        EXPECT_LT(pieces[i].second, num_workers);
+        load[pieces[i].second] += end - pieces[i].first;
+    }
+    return load;
+}
+
+TEST(Locality, AssignReplicaHosts) {
+    const uint64_t block = 128 * 1024 * 1024;
+    vfs::FileList files = MakeFileList({ 3 * block, 2 * block });
+
+    const char* replicas[5][2] = {
+        { "n1.cluster", "n2.cluster" }, { "n2.cluster", "n3.cluster" },
+        { "n1.cluster", "n3.cluster" }, { "n1.cluster", "n2.cluster" },
+        { "n2.cluster", "n3.cluster" }
+    };
+
+    std::vector<std::vector<vfs::FileBlockLocation> > locations(2);
+    for (size_t b = 0; b < 5; ++b) {
+        size_t f = b < 3 ? 0 : 1;
+        uint64_t begin = (b < 3 ? b : b - 3) * block;
+        locations[f].emplace_back(
+            vfs::FileBlockLocation {
+                common::Range(begin, begin + block),
+                { replicas[b][0], replicas[b][1] }
+            });
+    }
+
+    // short host names match the fully qualified ones
+    std::vector<std::string> worker_hosts = {
+        "n1", "n1", "n2", "n2", "n3", "n3"
+    };
+
+    auto pieces = vfs::AssignLocalityPieces(files, locations, worker_hosts);
+    std::vector<uint64_t> load = PieceLoads(files, pieces, 6);
+
+    // all pieces are read on a replica host
+    for (const auto& p : pieces) {
+        size_t f = p.first < files[1].size_ex_psum ? 0 : 1;
+        size_t b = (f == 0 ? 0 : 3) +
+                   (p.first - files[f].size_ex_psum) / block;
+        std::string host = worker_hosts[p.second] + ".cluster";
+        ASSERT_TRUE(host == replicas[b][0] || host == replicas[b][1]);
+    }
+
+    // and no worker exceeds its share by more than a piece
+    uint64_t share = files.total_size / 6;
+    for (const uint64_t& l : load) {
+        ASSERT_LE(l, share + share / 4 + 1);
+    }
+}
+
+TEST(Locality, AssignWithoutLocations) {
+    vfs::FileList files = MakeFileList({ 1000, 10, 5000 });
+
+    std::vector<std::vector<vfs::FileBlockLocation> > locations(3);
+    std::vector<std::string> worker_hosts = { "a", "a", "b", "b" };
+
+    auto pieces = vfs::AssignLocalityPieces(files, locations, worker_hosts);
+    std::vector<uint64_t> load = PieceLoads(files, pieces, 4);
+
+    for (const uint64_t& l : load) {
+        ASSERT_GE(l, files.total_size / 4 - files.total_size / 16);
+        ASSERT_LE(l, files.total_size / 4 + files.total_size / 16);
+    }
+}
+
+/******************************************************************************/
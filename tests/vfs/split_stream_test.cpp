@@ -0,0 +1,185 @@
+/*******************************************************************************
+ * tests/vfs/split_stream_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/split_stream.hpp>
+
+#include <gtest/gtest.h>
+#include <thrill/vfs/bzip2_filter.hpp>
+#include <thrill/vfs/sys_file.hpp>
+#include <thrill/vfs/temporary_directory.hpp>
+
+#if THRILL_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+//! generate lines of random length, including empty lines and a line longer
+//! than a bzip2 block, without newline at the end.
+static std::string GenerateLines(size_t num_lines) {
+    std::default_random_engine rng(42);
+    std::string text;
+    for (size_t i = 0; i < num_lines; ++i) {
+        if (i != 0) text += '\n';
+        size_t length = (i == num_lines / 2) ? 1000000 : rng() % 100;
+        for (size_t j = 0; j < length; ++j)
+            text += static_cast<char>('a' + rng() % 16);
+    }
+    return text;
+}
+
+static void WriteFile(const std::string& path, const std::string& data) {
+    vfs::WriteStreamPtr ws = vfs::SysOpenWriteStream(path);
+    ws->write(data.data(), data.size());
+    ws->close();
+}
+
+static std::string ReadFile(const std::string& path) {
+    vfs::ReadStreamPtr rs = vfs::SysOpenReadStream(path);
+    std::vector<char> buffer(1024 * 1024);
+    std::string data;
+    ssize_t rb;
+    while ((rb = rs->read(buffer.data(), buffer.size())) > 0)
+        data.append(buffer.data(), rb);
+    rs->close();
+    return data;
+}
+
+//! read the file in num_parts random ranges and compare the concatenation
+static void CheckSplits(const std::string& path, const std::string& text,
+                        size_t num_parts) {
+    size_t size = ReadFile(path).size();
+
+    std::default_random_engine rng(num_parts);
+    std::vector<size_t> cuts = { 0, size };
+    for (size_t i = 1; i < num_parts; ++i) cuts.push_back(rng() % size);
+    std::sort(cuts.begin(), cuts.end());
+
+    std::string result;
+    std::vector<char> buffer(12345);
+    for (size_t i = 0; i + 1 < cuts.size(); ++i) {
+        if (cuts[i] == cuts[i + 1]) continue;
+        vfs::ReadStreamPtr rs = vfs::OpenSplitLinesReadStream(
+            path, common::Range(cuts[i], cuts[i + 1]));
+        ssize_t rb;
+        while ((rb = rs->read(buffer.data(), buffer.size())) > 0)
+            result.append(buffer.data(), rb);
+        rs->close();
+    }
+
+    ASSERT_EQ(text.size(), result.size());
+    ASSERT_TRUE(text == result);
+}
+
+TEST(SplitStream, Uncompressed) {
+    vfs::TemporaryDirectory tmpdir;
+    std::string text = GenerateLines(100000);
+    std::string path = tmpdir.get() + "/test.txt";
+    WriteFile(path, text);
+
+    ASSERT_TRUE(vfs::IsSplittable(path));
+    for (size_t parts : { 1, 2, 5, 17 })
+        CheckSplits(path, text, parts);
+}
+
+#if THRILL_HAVE_BZIP2
+
+TEST(SplitStream, BZip2) {
+    vfs::TemporaryDirectory tmpdir;
+    std::string text = GenerateLines(100000);
+    std::string path = tmpdir.get() + "/test.txt.bz2";
+
+    // two concatenated bzip2 streams like pbzip2 writes, each with multiple
+    // blocks
+    std::string data;
+    for (size_t s = 0; s < 2; ++s) {
+        std::string part = tmpdir.get() + "/part.bz2";
+        vfs::WriteStreamPtr zs = vfs::MakeBZip2WriteFilter(
+            vfs::SysOpenWriteStream(part));
+        size_t half = text.size() / 2;
+        zs->write(text.data() + s * half, s == 0 ? half : text.size() - half);
+        zs->close();
+        data += ReadFile(part);
+    }
+    WriteFile(path, data);
+
+    ASSERT_TRUE(vfs::IsSplittable(path));
+    for (size_t parts : { 1, 2, 5, 17 })
+        CheckSplits(path, text, parts);
+}
+
+#endif // THRILL_HAVE_BZIP2
+
+#if THRILL_HAVE_ZLIB
+
+//! write text as BGZF file like bgzip, with an empty member at the end.
+static void WriteBgzf(const std::string& path, const std::string& text) {
+    vfs::WriteStreamPtr ws = vfs::SysOpenWriteStream(path);
+    std::vector<unsigned char> member(128 * 1024);
+
+    size_t pos = 0;
+    while (true) {
+        size_t size = std::min<size_t>(60000, text.size() - pos);
+
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        ASSERT_EQ(Z_OK, deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                     /* raw deflate */ -15, 8,
+                                     Z_DEFAULT_STRATEGY));
+        z.next_in = reinterpret_cast<Bytef*>(
+            const_cast<char*>(text.data() + pos));
+        z.avail_in = static_cast<uInt>(size);
+        z.next_out = member.data() + 18;
+        z.avail_out = static_cast<uInt>(member.size() - 26);
+        ASSERT_EQ(Z_STREAM_END, deflate(&z, Z_FINISH));
+        size_t csize = z.total_out;
+        deflateEnd(&z);
+
+        uint32_t crc = crc32(
+            0, reinterpret_cast<const Bytef*>(text.data() + pos), size);
+        size_t bsize = 18 + csize + 8 - 1;
+
+        const unsigned char header[18] = {
+            0x1F, 0x8B, 0x08, 0x04, 0, 0, 0, 0, 0, 0xFF, 6, 0, 'B', 'C', 2, 0,
+            static_cast<unsigned char>(bsize),
+            static_cast<unsigned char>(bsize >> 8)
+        };
+        std::copy(header, header + 18, member.data());
+        unsigned char* trailer = member.data() + 18 + csize;
+        for (size_t i = 0; i < 4; ++i) {
+            trailer[i] = static_cast<unsigned char>(crc >> (8 * i));
+            trailer[4 + i] = static_cast<unsigned char>(size >> (8 * i));
+        }
+        ws->write(member.data(), bsize + 1);
+
+        if (size == 0) break;
+        pos += size;
+    }
+    ws->close();
+}
+
+TEST(SplitStream, Bgzf) {
+    vfs::TemporaryDirectory tmpdir;
+    std::string text = GenerateLines(100000);
+    std::string path = tmpdir.get() + "/test.txt.gz";
+    WriteBgzf(path, text);
+
+    ASSERT_TRUE(vfs::IsSplittable(path));
+    for (size_t parts : { 1, 2, 5, 17, 100 })
+        CheckSplits(path, text, parts);
+}
+
+#endif // THRILL_HAVE_ZLIB
+
+/******************************************************************************/
@@ -11,6 +11,9 @@
 #include <thrill/vfs/sys_file.hpp>
 
 #include <gtest/gtest.h>
+#include <thrill/net/buffer_builder.hpp>
+#include <thrill/net/buffer_reader.hpp>
+#include <thrill/vfs/direct_file.hpp>
 #include <thrill/vfs/temporary_directory.hpp>
 
 #include <string>
@@ -63,4 +66,91 @@ TEST(SysFileTest, WriteReadSingleFile) {
     }
 }
 
+TEST(SysFileTest, GlobManyFiles) {
+    vfs::TemporaryDirectory tmpdir;
+
+    // enough files to stat() them in parallel
+    const size_t count = 300;
+    for (size_t i = 0; i < count; ++i) {
+        vfs::WriteStreamPtr ws = vfs::SysOpenWriteStream(
+            vfs::FillFilePattern(tmpdir.get() + "/file-####", 0, i));
+        std::string data(i, 'x');
+        ws->write(data.data(), data.size());
+    }
+
+    vfs::FileList files = vfs::Glob(tmpdir.get() + "/*", vfs::GlobType::File);
+    ASSERT_EQ(count, files.size());
+    ASSERT_EQ(count * (count - 1) / 2, files.total_size);
+
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(i, files[i].size);
+        ASSERT_EQ(i * (i - 1) / 2, files[i].size_ex_psum);
+    }
+
+    // walk the directory, and serialize the file list for broadcasting
+    vfs::FileList dir_files = vfs::Glob(tmpdir.get(), vfs::GlobType::File);
+    ASSERT_EQ(count, dir_files.size());
+
+    net::BufferBuilder bb;
+    dir_files.ThrillSerialize(bb);
+
+    net::BufferReader br(bb.data(), bb.size());
+    vfs::FileList copy = vfs::FileList::ThrillDeserialize(br);
+    ASSERT_EQ(files.size(), copy.size());
+    ASSERT_EQ(files.total_size, copy.total_size);
+    ASSERT_EQ(files.fingerprint(), copy.fingerprint());
+}
+
+#if defined(__linux__)
+TEST(SysFileTest, DirectWriteReadSingleFile) {
+    vfs::TemporaryDirectory tmpdir;
+
+    // more than the 4 buffers of 1 MiB, with an unaligned tail
+    const size_t count = 1000000;
+    {
+        vfs::WriteStreamPtr ws = vfs::SysOpenDirectWriteStream(
+            tmpdir.get() + "/test.dat", /* queue_depth */ 4);
+
+        std::string test_string("test123abc");
+        ws->write(test_string.data(), test_string.size());
+
+        for (size_t i = 0; i < count; ++i) {
+            ws->write(&i, sizeof(i));
+        }
+
+        ws->close();
+    }
+    {
+        vfs::ReadStreamPtr rs = vfs::SysOpenDirectReadStream(
+            tmpdir.get() + "/test.dat", common::Range(), /* queue_depth */ 4);
+
+        char buffer[10 + 1];
+        ASSERT_EQ(rs->read(buffer, 10), 10);
+        buffer[10] = 0;
+        ASSERT_EQ(std::string(buffer), "test123abc");
+
+        for (size_t i = 0; i < count; ++i) {
+            size_t r;
+            ASSERT_EQ(rs->read(&r, sizeof(r)), 8);
+            ASSERT_EQ(r, i);
+        }
+
+        // read beyond end-of-file
+        ASSERT_EQ(rs->read(buffer, 10), 0);
+    }
+    {
+        // seek to an unaligned offset
+        vfs::ReadStreamPtr rs = vfs::SysOpenDirectReadStream(
+            tmpdir.get() + "/test.dat",
+            common::Range(10 + 500000 * sizeof(size_t), 0), 2);
+
+        for (size_t i = 500000; i < count; ++i) {
+            size_t r;
+            ASSERT_EQ(rs->read(&r, sizeof(r)), 8);
+            ASSERT_EQ(r, i);
+        }
+    }
+}
+#endif
+
 /******************************************************************************/
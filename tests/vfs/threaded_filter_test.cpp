@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * tests/vfs/threaded_filter_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/threaded_filter.hpp>
+
+#include <gtest/gtest.h>
+#include <thrill/vfs/sys_file.hpp>
+#include <thrill/vfs/temporary_directory.hpp>
+
+#include <string>
+
+using namespace thrill;
+
+TEST(ThreadedFilterTest, ReadSingleFile) {
+    vfs::TemporaryDirectory tmpdir;
+
+    {
+        vfs::WriteStreamPtr ws = vfs::SysOpenWriteStream(
+            tmpdir.get() + "/test.dat");
+
+        std::string test_string("test123abc");
+        for (size_t i = 0; i < 100000; ++i) {
+            ws->write(test_string.data(), test_string.size());
+        }
+
+        for (size_t i = 0; i < 100000; ++i) {
+            ws->write(&i, sizeof(i));
+        }
+
+        // put one more byte in
+        ws->write(test_string.data(), 1);
+
+        ws->close();
+    }
+    {
+        vfs::ReadStreamPtr rs = vfs::SysOpenReadStream(
+            tmpdir.get() + "/test.dat");
+
+        // small buffers, such that reads cross buffer boundaries
+        vfs::ReadStreamPtr ts = vfs::MakeThreadedReadFilter(rs, 1000);
+
+        char buffer[10 + 1];
+        for (size_t i = 0; i < 100000; ++i) {
+            ASSERT_EQ(ts->read(buffer, 10), 10);
+            buffer[10] = 0;
+            ASSERT_EQ(std::string(buffer), "test123abc");
+        }
+
+        for (size_t i = 0; i < 100000; ++i) {
+            size_t r;
+            ts->read(&r, sizeof(r));
+            ASSERT_EQ(r, i);
+        }
+
+        // read beyond end-of-file
+        ssize_t rb = ts->read(buffer, 10);
+        ASSERT_EQ(rb, 1);
+
+        ts->close();
+    }
+}
+
+/******************************************************************************/
@@ -14,7 +14,11 @@
 #define THRILL_API_ACTION_NODE_HEADER
 
 #include <thrill/api/dia_base.hpp>
+#include <thrill/data/serialization.hpp>
+#include <thrill/net/buffer_builder.hpp>
+#include <thrill/net/buffer_reader.hpp>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -59,6 +63,42 @@ public:
     void SetConsumeCounter(size_t /* counter */) final {
         die("Setting .Keep() on Actions does not make sense.");
     }
+
+    //! \name Batched Execution, see WaitAll()
+    //! \{
+
+    //! Whether Execute() is a single AllReduce of a serializable value, which
+    //! WaitAll() may combine with those of other actions.
+    virtual bool CanBatchExecute() const { return false; }
+
+    //! Returns the serialized local value of the AllReduce in Execute().
+    virtual std::string BatchLocalValue() const { abort(); }
+
+    //! Combine two serialized values like the AllReduce in Execute().
+    virtual std::string BatchCombine(
+        const std::string& /* a */, const std::string& /* b */) const
+    { abort(); }
+
+    //! Set the result from the serialized global value.
+    virtual void BatchSetResult(const std::string& /* value */) { abort(); }
+
+    //! \}
+
+protected:
+    //! serialize a value for the batched execution
+    template <typename T>
+    static std::string BatchSerialize(const T& value) {
+        net::BufferBuilder bb;
+        data::Serialization<net::BufferBuilder, T>::Serialize(value, bb);
+        return bb.ToString();
+    }
+
+    //! deserialize a value of the batched execution
+    template <typename T>
+    static T BatchDeserialize(const std::string& str) {
+        net::BufferReader br(str);
+        return data::Serialization<net::BufferReader, T>::Deserialize(br);
+    }
 };
 
 template <typename ResultType>
@@ -113,6 +153,9 @@ public:
         return get();
     }
 
+    //! Returns the action node of the ActionFuture
+    ActionNode* node() const { return node_.get(); }
+
 private:
     //! shared pointer to the action node, which may not be executed yet.
     ActionResultNodePtr node_;
@@ -147,11 +190,68 @@ public:
         return wait();
     }
 
+    //! Returns the action node of the ActionFuture
+    ActionNode* node() const { return node_.get(); }
+
 private:
     //! shared pointer to the action node, which may not be executed yet.
     ActionNodePtr node_;
 };
 
+/*!
+ * Evaluate the DIA data-flow graph for all action nodes. The stages pushing
+ * into all actions are run first, and then the AllReduces of all actions which
+ * support batching, such as Size(), Sum(), Min(), Max(), and AllReduce(), are
+ * combined into a single collective operation. Actions which do not support
+ * batching are executed in the given order. All workers must pass the actions
+ * in the same order.
+ */
+inline void WaitAllActions(const std::vector<ActionNode*>& actions) {
+    std::vector<ActionNode*> batch;
+
+    for (ActionNode* node : actions) {
+        if (node->state() != DIAState::NEW ||
+            std::find(batch.begin(), batch.end(), node) != batch.end())
+            continue;
+
+        if (node->CanBatchExecute()) {
+            node->RunScope(/* execute_this */ false);
+            batch.push_back(node);
+        }
+        else {
+            node->RunScope();
+        }
+    }
+
+    if (batch.empty()) return;
+
+    std::vector<std::string> values;
+    values.reserve(batch.size());
+    for (ActionNode* node : batch)
+        values.emplace_back(node->BatchLocalValue());
+
+    values = batch.front()->context().net.AllReduce(
+        values,
+        [&batch](const std::vector<std::string>& a,
+                 const std::vector<std::string>& b) {
+            std::vector<std::string> out(a.size());
+            for (size_t i = 0; i < a.size(); ++i)
+                out[i] = batch[i]->BatchCombine(a[i], b[i]);
+            return out;
+        });
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i]->BatchSetResult(values[i]);
+        batch[i]->set_state(DIAState::EXECUTED);
+    }
+}
+
+//! Evaluate the DIA data-flow graph for all Futures, see WaitAllActions().
+template <typename... Futures>
+void WaitAll(Futures& ... futures) {
+    WaitAllActions(std::vector<ActionNode*>({ futures.node() ... }));
+}
+
 //! \}
 
 } // namespace api
@@ -160,6 +260,9 @@ private:
 template <typename ValueType = void>
 using Future = api::Future<ValueType>;
 
+//! imported from api namespace
+using api::WaitAll;
+
 } // namespace thrill
 
 #endif // !THRILL_API_ACTION_NODE_HEADER
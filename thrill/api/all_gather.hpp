@@ -16,12 +16,20 @@
 #include <thrill/api/action_node.hpp>
 #include <thrill/api/dia.hpp>
 
+#include <memory>
 #include <vector>
 
 namespace thrill {
 namespace api {
 
 /*!
+ * Node gathering all items on all workers. The items are serialized once into
+ * a local File, whose blocks are sent to the first worker of each host. It
+ * forwards the received blocks without deserializing them to all workers of
+ * its host, which share the ByteBlocks, hence each host receives one copy.
+ * In shared mode, the first worker deserializes the items once into a vector,
+ * which all workers of its host share read-only.
+ *
  * \ingroup api_layer
  */
 template <typename ValueType>
@@ -40,6 +48,21 @@ public:
                 { parent.id() }, { parent.node() }),
           parent_stack_empty_(ParentDIA::stack_empty),
           out_vector_(out_vector), ownership_(ownership) {
+        Register(parent);
+    }
+
+    template <typename ParentDIA>
+    AllGatherNode(const ParentDIA& parent,
+                  std::shared_ptr<const std::vector<ValueType> >* out_shared)
+        : Super(parent.ctx(), "AllGatherShared",
+                { parent.id() }, { parent.node() }),
+          parent_stack_empty_(ParentDIA::stack_empty),
+          out_vector_(nullptr), ownership_(false), out_shared_(out_shared) {
+        Register(parent);
+    }
+
+    template <typename ParentDIA>
+    void Register(const ParentDIA& parent) {
         auto pre_op_function = [this](const ValueType& input) {
                                    PreOp(input);
                                };
@@ -56,13 +79,11 @@ public:
     }
 
     void StartPreOp(size_t /* parent_index */) final {
-        emitters_ = stream_->GetWriters();
+        writer_ = file_.GetWriter();
     }
 
     void PreOp(const ValueType& element) {
-        for (size_t i = 0; i < emitters_.size(); i++) {
-            emitters_[i].Put(element);
-        }
+        writer_.Put(element);
     }
 
     bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
@@ -72,28 +93,72 @@ public:
                 << "due to non-empty function stack.";
             return false;
         }
-        for (size_t i = 0; i < emitters_.size(); i++) {
-            emitters_[i].AppendBlocks(file.blocks());
-        }
+        writer_.AppendBlocks(file.blocks());
         return true;
     }
 
     void StopPreOp(size_t /* parent_index */) final {
-        // data has been pushed during pre-op -> close emitters
-        emitters_.Close();
+        writer_.Close();
+
+        // send the blocks to the first worker of each host
+        data::CatStream::Writers emitters = stream_->GetWriters();
+        for (size_t host = 0; host < context_.num_hosts(); ++host) {
+            emitters[host * context_.workers_per_host()].AppendBlocks(
+                file_.blocks());
+        }
+        emitters.Close();
+        file_.Clear();
     }
 
-    //! Closes the output file
     void Execute() final {
-        auto reader = stream_->GetCatReader(/* consume */ true);
+        if (out_shared_) {
+            ExecuteShared();
+            return;
+        }
+
+        // stream from the first worker of each host to all workers on the host
+        data::CatStreamPtr host_stream = context_.GetNewCatStream(this);
+        data::CatStream::Writers host_writers = host_stream->GetWriters();
+
+        if (context_.local_worker_id() == 0) {
+            // forward the received blocks to all workers of this host.
+            size_t first = context_.host_rank() * context_.workers_per_host();
+            data::CatStream::ConsumeCatBlockSource source =
+                stream_->GetConsumeCatBlockSource();
+            for (data::PinnedBlock block = source.NextBlock(); block.IsValid();
+                 block = source.NextBlock()) {
+                std::vector<data::Block> blocks { block.ToBlock() };
+                for (size_t w = 0; w < context_.workers_per_host(); ++w)
+                    host_writers[first + w].AppendBlocks(blocks);
+            }
+        }
+        host_writers.Close();
+
+        auto reader = host_stream->GetCatReader(/* consume */ true);
         while (reader.HasNext()) {
             out_vector_->push_back(reader.template Next<ValueType>());
         }
         stream_.reset();
     }
 
+    //! the first worker of each host deserializes the items once and shares
+    //! the vector with the other workers.
+    void ExecuteShared() {
+        std::shared_ptr<std::vector<ValueType> > vec;
+        if (context_.local_worker_id() == 0) {
+            vec = std::make_shared<std::vector<ValueType> >();
+            auto reader = stream_->GetConsumeCatReader();
+            while (reader.HasNext()) {
+                vec->push_back(reader.template Next<ValueType>());
+            }
+        }
+        *out_shared_ = context_.net.LocalBroadcast(
+            std::shared_ptr<const std::vector<ValueType> >(std::move(vec)));
+        stream_.reset();
+    }
+
     const std::vector<ValueType>& result() const final {
-        return *out_vector_;
+        return out_shared_ ? **out_shared_ : *out_vector_;
     }
 
 private:
@@ -106,8 +171,15 @@ private:
     //! take ownership of vector
     bool ownership_;
 
+    //! pointer to the host-shared vector in shared mode
+    std::shared_ptr<const std::vector<ValueType> >* out_shared_ = nullptr;
+
+    //! local items, serialized once for all hosts
+    data::File file_ { context_.GetFile(this) };
+    data::File::Writer writer_;
+
+    //! stream to the first worker of each host
     data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
-    data::CatStream::Writers emitters_;
 };
 
 template <typename ValueType, typename Stack>
@@ -138,6 +210,22 @@ void DIA<ValueType, Stack>::AllGather(std::vector<ValueType>* out_vector) const
     node->RunScope();
 }
 
+template <typename ValueType, typename Stack>
+std::shared_ptr<const std::vector<ValueType> >
+DIA<ValueType, Stack>::AllGatherShared() const {
+    assert(IsValid());
+
+    using AllGatherNode = api::AllGatherNode<ValueType>;
+
+    std::shared_ptr<const std::vector<ValueType> > output;
+
+    auto node = tlx::make_counting<AllGatherNode>(*this, &output);
+
+    node->RunScope();
+
+    return output;
+}
+
 template <typename ValueType, typename Stack>
 Future<std::vector<ValueType> >
 DIA<ValueType, Stack>::AllGatherFuture() const {
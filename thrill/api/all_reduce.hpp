@@ -15,7 +15,9 @@
 
 #include <thrill/api/action_node.hpp>
 #include <thrill/api/dia.hpp>
+#include <thrill/common/functional.hpp>
 
+#include <string>
 #include <type_traits>
 
 namespace thrill {
@@ -59,7 +61,7 @@ public:
             sum_ = input;
         }
         else {
-            sum_ = reduce_function_(sum_, input);
+            common::ReduceAssign(reduce_function_, sum_, input);
         }
     }
 
@@ -74,6 +76,23 @@ public:
         return sum_;
     }
 
+    bool CanBatchExecute() const final { return true; }
+
+    std::string BatchLocalValue() const final {
+        return Super::BatchSerialize(sum_);
+    }
+
+    std::string BatchCombine(
+        const std::string& a, const std::string& b) const final {
+        return Super::BatchSerialize(
+            reduce_function_(Super::template BatchDeserialize<ValueType>(a),
+                             Super::template BatchDeserialize<ValueType>(b)));
+    }
+
+    void BatchSetResult(const std::string& value) final {
+        sum_ = Super::template BatchDeserialize<ValueType>(value);
+    }
+
 private:
     //! The sum function which is applied to two values.
     ReduceFunction reduce_function_;
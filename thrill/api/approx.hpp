@@ -0,0 +1,216 @@
+/*******************************************************************************
+ * thrill/api/approx.hpp
+ *
+ * Approximate aggregations on Bernoulli samples: SizeApprox(), SumApprox(), and
+ * SumByKeyApprox(), which scale the sample up and report confidence intervals.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_APPROX_HEADER
+#define THRILL_API_APPROX_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/bernoulli_sample.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/reduce_by_key.hpp>
+#include <thrill/common/functional.hpp>
+
+#include <array>
+#include <cmath>
+#include <ostream>
+#include <tuple>
+#include <utility>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Result of an approximate aggregation: the unbiased estimate and the
+ * confidence interval [lower, upper] around it.
+ */
+struct ApproxResult {
+    //! unbiased estimate of the exact result
+    double estimate;
+    //! lower and upper bound of the confidence interval
+    double lower, upper;
+    //! number of sampled items the estimate was computed from
+    size_t sample_size;
+    //! sampling rate
+    double p;
+    //! confidence level of the interval
+    double confidence;
+
+    //! half width of the confidence interval relative to the estimate
+    double relative_error() const {
+        return estimate != 0 ? (upper - estimate) / std::abs(estimate) : 0.0;
+    }
+
+    friend std::ostream& operator << (std::ostream& os, const ApproxResult& r) {
+        return os << r.estimate << " [" << r.lower << ", " << r.upper << "]"
+                  << " (p=" << r.p << " conf=" << r.confidence
+                  << " samples=" << r.sample_size << ")";
+    }
+};
+
+/*!
+ * Returns the two sided standard normal quantile z, such that P(|Z| <= z) =
+ * confidence, by bisection on erf().
+ */
+inline double ApproxZScore(double confidence) {
+    assert(confidence > 0.0 && confidence < 1.0);
+    double lo = 0.0, hi = 40.0;
+    for (size_t i = 0; i < 100; ++i) {
+        double mid = (lo + hi) / 2;
+        if (std::erf(mid / std::sqrt(2.0)) < confidence)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return (lo + hi) / 2;
+}
+
+/*!
+ * Computes the Horvitz-Thompson estimate of a sum from a Bernoulli sample with
+ * rate p: each sampled value is scaled by 1/p, and the variance is estimated
+ * by (1-p)/p^2 times the sampled sum of squares. The interval is the normal
+ * approximation, which needs a few dozen samples to be meaningful.
+ */
+inline ApproxResult ApproxEstimate(
+    size_t sample_size, double sum, double sum_squares,
+    double p, double confidence) {
+    double estimate = sum / p;
+    double stddev = std::sqrt((1.0 - p) * sum_squares) / p;
+    double z = ApproxZScore(confidence);
+    return ApproxResult {
+               estimate, estimate - z * stddev, estimate + z * stddev,
+               sample_size, p, confidence
+    };
+}
+
+/*!
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename ValueFunction>
+class ApproxSumNode final : public ActionResultNode<ApproxResult>
+{
+    static constexpr bool debug = false;
+
+    using Super = ActionResultNode<ApproxResult>;
+    using Super::context_;
+
+public:
+    template <typename ParentDIA>
+    ApproxSumNode(const ParentDIA& parent, const char* label,
+                  double p, double confidence,
+                  const ValueFunction& value_function)
+        : Super(parent.ctx(), label, { parent.id() }, { parent.node() }),
+          p_(p), confidence_(confidence), value_function_(value_function),
+          sampler_(p) {
+
+        // Hook PreOp(s): skipped items only decrement the sampler's counter
+        auto pre_op_fn = [this](const ValueType& input) {
+                             sampler_(input, [this](const ValueType& item) {
+                                          double v = value_function_(item);
+                                          ++local_[0], local_[1] += v;
+                                          local_[2] += v * v;
+                                      });
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void Execute() final {
+        std::array<double, 3> total = context_.net.AllReduce(
+            local_, common::ComponentSum<std::array<double, 3> >());
+
+        result_ = ApproxEstimate(static_cast<size_t>(total[0]),
+                                 total[1], total[2], p_, confidence_);
+
+        LOG << "ApproxSum: " << result_;
+    }
+
+    const ApproxResult& result() const final { return result_; }
+
+private:
+    //! sampling rate and confidence level
+    double p_, confidence_;
+    //! maps sampled items to the summed value
+    ValueFunction value_function_;
+    //! Bernoulli sampler using geometric skip values for small p
+    BernoulliSampleNode<ValueType> sampler_;
+    //! local number of samples, sum, and sum of squares
+    std::array<double, 3> local_ = { { 0.0, 0.0, 0.0 } };
+    //! global result
+    ApproxResult result_;
+};
+
+template <typename ValueType, typename Stack>
+ApproxResult DIA<ValueType, Stack>::SizeApprox(
+    double p, double confidence) const {
+    assert(IsValid());
+    assert(p > 0.0 && p <= 1.0);
+
+    auto one = [](const ValueType&) { return 1.0; };
+
+    auto node = tlx::make_counting<ApproxSumNode<ValueType, decltype(one)> >(
+        *this, "SizeApprox", p, confidence, one);
+    node->RunScope();
+    return node->result();
+}
+
+template <typename ValueType, typename Stack>
+template <typename ValueFunction>
+ApproxResult DIA<ValueType, Stack>::SumApprox(
+    double p, double confidence, const ValueFunction& value_function) const {
+    assert(IsValid());
+    assert(p > 0.0 && p <= 1.0);
+
+    auto node = tlx::make_counting<ApproxSumNode<ValueType, ValueFunction> >(
+        *this, "SumApprox", p, confidence, value_function);
+    node->RunScope();
+    return node->result();
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename ValueFunction>
+auto DIA<ValueType, Stack>::SumByKeyApprox(
+    double p, const KeyExtractor& key_extractor,
+    const ValueFunction& value_function, double confidence) const {
+    assert(IsValid());
+    assert(p > 0.0 && p <= 1.0);
+
+    using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
+    // number of samples, sum, and sum of squares
+    using Moments = std::tuple<size_t, double, double>;
+
+    return BernoulliSample(p)
+           .Map([key_extractor, value_function](const ValueType& item) {
+                    double v = value_function(item);
+                    return std::make_pair(key_extractor(item),
+                                          Moments(1, v, v * v));
+                })
+           .ReducePair([](const Moments& a, const Moments& b) {
+                           return Moments(std::get<0>(a) + std::get<0>(b),
+                                          std::get<1>(a) + std::get<1>(b),
+                                          std::get<2>(a) + std::get<2>(b));
+                       })
+           .Map([p, confidence](const std::pair<Key, Moments>& m) {
+                    return std::make_pair(
+                        m.first,
+                        ApproxEstimate(std::get<0>(m.second),
+                                       std::get<1>(m.second),
+                                       std::get<2>(m.second), p, confidence));
+                });
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_APPROX_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,560 @@
+/*******************************************************************************
+ * thrill/api/arrow_format.hpp
+ *
+ * Encoding of the Apache Arrow IPC stream format written by WriteArrowStream
+ * and read by ReadArrowStream, without depending on the Arrow libraries.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_ARROW_FORMAT_HEADER
+#define THRILL_API_ARROW_FORMAT_HEADER
+
+#include <thrill/net/buffer_builder.hpp>
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * \name Arrow IPC Stream Format
+ *
+ * An Arrow IPC stream is a sequence of encapsulated messages, each consisting
+ * of
+ *
+ * \verbatim
+ * [0xFFFFFFFF][int32 metadata size][Message flatbuffer, padded to 8][body]
+ * \endverbatim
+ *
+ * and is terminated by a message with metadata size zero. The first message
+ * contains the Schema, all following ones a RecordBatch, whose body holds the
+ * column buffers. Arithmetic columns are stored as Int or FloatingPoint arrays,
+ * whose value buffer is the raw array of the column, hence they are copied in
+ * and out with a single memcpy. String columns are stored as Utf8 arrays with
+ * int32 offsets. Columns have no nulls, and dictionaries and body compression
+ * are not supported.
+ *
+ * The flatbuffers of the messages are built and parsed by the minimal
+ * ArrowFlatBuilder and ArrowFlatTable below, which implement only the subset
+ * of FlatBuffers needed by Schema.fbs and Message.fbs.
+ *
+ * \{
+ */
+
+/*!
+ * Minimal FlatBuffers builder. Like the reference implementation, the buffer
+ * is built back to front, such that references always point forward. Objects
+ * are identified by their distance from the end of the buffer.
+ */
+class ArrowFlatBuilder
+{
+public:
+    //! current size of the buffer, the reference of the last object
+    uint32_t size() const { return static_cast<uint32_t>(buf_.size()); }
+
+    //! prepend zero padding, such that the buffer size is a multiple of align
+    //! after prepending size bytes.
+    void Align(size_t size, size_t align) {
+        size_t pad = (align - (buf_.size() + size) % align) % align;
+        buf_.insert(0, pad, '\0');
+    }
+
+    //! prepend an aligned little-endian scalar
+    template <typename Type>
+    void PushScalar(const Type& value) {
+        Align(sizeof(Type), sizeof(Type));
+        buf_.insert(0, reinterpret_cast<const char*>(&value), sizeof(Type));
+    }
+
+    //! prepend a forward offset to the object ref
+    void PushOffset(uint32_t ref) {
+        Align(sizeof(uint32_t), sizeof(uint32_t));
+        PushScalar<uint32_t>(size() + sizeof(uint32_t) - ref);
+    }
+
+    uint32_t CreateString(const std::string& str) {
+        Align(str.size() + 1, sizeof(uint32_t));
+        buf_.insert(0, 1, '\0');
+        buf_.insert(0, str);
+        PushScalar<uint32_t>(static_cast<uint32_t>(str.size()));
+        return size();
+    }
+
+    //! create a vector of references to tables or strings
+    uint32_t CreateOffsetVector(const std::vector<uint32_t>& refs) {
+        for (size_t i = refs.size(); i != 0; --i)
+            PushOffset(refs[i - 1]);
+        PushScalar<uint32_t>(static_cast<uint32_t>(refs.size()));
+        return size();
+    }
+
+    //! create a vector of structs of two int64 fields, e.g. FieldNode and
+    //! Buffer of Message.fbs.
+    uint32_t CreatePairVector(
+        const std::vector<std::pair<int64_t, int64_t> >& pairs) {
+        Align(pairs.size() * 2 * sizeof(int64_t), sizeof(int64_t));
+        for (size_t i = pairs.size(); i != 0; --i) {
+            buf_.insert(0, reinterpret_cast<const char*>(&pairs[i - 1].second),
+                        sizeof(int64_t));
+            buf_.insert(0, reinterpret_cast<const char*>(&pairs[i - 1].first),
+                        sizeof(int64_t));
+        }
+        PushScalar<uint32_t>(static_cast<uint32_t>(pairs.size()));
+        return size();
+    }
+
+    //! start a table, all referenced objects must have been created before.
+    void StartTable() {
+        fields_.clear();
+        table_start_ = size();
+    }
+
+    //! add a scalar field with the given id to the current table
+    template <typename Type>
+    void AddScalar(size_t id, const Type& value) {
+        PushScalar(value);
+        fields_.emplace_back(id, size());
+    }
+
+    //! add a reference field with the given id to the current table
+    void AddOffset(size_t id, uint32_t ref) {
+        PushOffset(ref);
+        fields_.emplace_back(id, size());
+    }
+
+    //! finish the current table by prepending its vtable
+    uint32_t EndTable() {
+        // placeholder for the offset to the vtable
+        PushScalar<int32_t>(0);
+        uint32_t table = size();
+
+        size_t num_fields = 0;
+        for (const std::pair<size_t, uint32_t>& f : fields_)
+            num_fields = std::max(num_fields, f.first + 1);
+
+        std::vector<uint16_t> vtable(num_fields, 0);
+        for (const std::pair<size_t, uint32_t>& f : fields_)
+            vtable[f.first] = static_cast<uint16_t>(table - f.second);
+
+        for (size_t i = num_fields; i != 0; --i)
+            PushScalar<uint16_t>(vtable[i - 1]);
+        PushScalar<uint16_t>(static_cast<uint16_t>(table - table_start_));
+        PushScalar<uint16_t>(static_cast<uint16_t>(4 + 2 * num_fields));
+
+        // the vtable lies before the table
+        int32_t soffset = static_cast<int32_t>(size() - table);
+        std::memcpy(&buf_[size() - table], &soffset, sizeof(soffset));
+        return table;
+    }
+
+    //! prepend the reference to the root table and return the buffer, whose
+    //! size is a multiple of eight.
+    std::string Finish(uint32_t root) {
+        Align(sizeof(uint32_t), 8);
+        PushOffset(root);
+        return std::move(buf_);
+    }
+
+private:
+    //! buffer built back to front
+    std::string buf_;
+    //! id and reference of the fields of the current table
+    std::vector<std::pair<size_t, uint32_t> > fields_;
+    //! size of the buffer when the current table was started
+    uint32_t table_start_ = 0;
+};
+
+/*!
+ * Minimal FlatBuffers reader: a view on a table in a buffer, whose accessors
+ * take the field ids of the schema. All accesses are checked against the
+ * buffer size.
+ */
+class ArrowFlatTable
+{
+public:
+    ArrowFlatTable(const std::string& buf, size_t pos)
+        : buf_(&buf), pos_(pos) {
+        vtable_ = pos_ - Read<int32_t>(pos_);
+        vtable_size_ = Read<uint16_t>(vtable_);
+    }
+
+    //! root table of the buffer
+    static ArrowFlatTable Root(const std::string& buf) {
+        ArrowFlatTable dummy(buf);
+        return ArrowFlatTable(buf, dummy.Deref(0));
+    }
+
+    //! whether the field is present
+    bool Has(size_t id) const { return Field(id) != 0; }
+
+    //! scalar field, or def if absent
+    template <typename Type>
+    Type Scalar(size_t id, const Type& def) const {
+        size_t f = Field(id);
+        return f ? Read<Type>(f) : def;
+    }
+
+    //! table field, which must be present
+    ArrowFlatTable Table(size_t id) const {
+        return ArrowFlatTable(*buf_, Deref(Required(id)));
+    }
+
+    //! string field, or empty if absent
+    std::string String(size_t id) const {
+        size_t f = Field(id);
+        if (!f) return std::string();
+        size_t pos = Deref(f);
+        uint32_t length = Read<uint32_t>(pos);
+        Check(pos + 4, length);
+        return buf_->substr(pos + 4, length);
+    }
+
+    //! number of elements of a vector field, zero if absent
+    size_t VectorSize(size_t id) const {
+        size_t f = Field(id);
+        return f ? Read<uint32_t>(Deref(f)) : 0;
+    }
+
+    //! element i of a vector field of tables
+    ArrowFlatTable VectorTable(size_t id, size_t i) const {
+        size_t pos = Deref(Required(id));
+        die_unless(i < Read<uint32_t>(pos));
+        return ArrowFlatTable(*buf_, Deref(pos + 4 + 4 * i));
+    }
+
+    //! element i of a vector field of two int64 structs
+    std::pair<int64_t, int64_t> VectorPair(size_t id, size_t i) const {
+        size_t pos = Deref(Required(id));
+        die_unless(i < Read<uint32_t>(pos));
+        size_t elem = pos + 4 + 2 * sizeof(int64_t) * i;
+        return std::make_pair(Read<int64_t>(elem),
+                              Read<int64_t>(elem + sizeof(int64_t)));
+    }
+
+private:
+    const std::string* buf_;
+    //! position of the table and its vtable
+    size_t pos_, vtable_ = 0;
+    //! size of the vtable in bytes
+    uint16_t vtable_size_ = 0;
+
+    explicit ArrowFlatTable(const std::string& buf)
+        : buf_(&buf), pos_(0) { }
+
+    void Check(size_t pos, size_t size) const {
+        if (pos > buf_->size() || size > buf_->size() - pos)
+            die("Arrow: invalid flatbuffer in message");
+    }
+
+    template <typename Type>
+    Type Read(size_t pos) const {
+        Check(pos, sizeof(Type));
+        Type value;
+        std::memcpy(&value, buf_->data() + pos, sizeof(Type));
+        return value;
+    }
+
+    //! follow the forward offset at pos
+    size_t Deref(size_t pos) const {
+        return pos + Read<uint32_t>(pos);
+    }
+
+    //! position of the field, or zero if absent
+    size_t Field(size_t id) const {
+        if (4 + 2 * id >= vtable_size_) return 0;
+        uint16_t offset = Read<uint16_t>(vtable_ + 4 + 2 * id);
+        return offset ? pos_ + offset : 0;
+    }
+
+    size_t Required(size_t id) const {
+        size_t f = Field(id);
+        if (!f) die("Arrow: required field " << id << " missing in message");
+        return f;
+    }
+};
+
+//! MessageHeader union type ids of Message.fbs
+enum class ArrowMessageType : uint8_t {
+    Schema = 1, DictionaryBatch = 2, RecordBatch = 3
+};
+
+//! Type union ids of Schema.fbs
+enum class ArrowTypeId : uint8_t {
+    Int = 2, FloatingPoint = 3, Binary = 4, Utf8 = 5
+};
+
+/*!
+ * Body of a RecordBatch message under construction: the concatenated column
+ * buffers, each padded to eight bytes, with their offsets and lengths, and the
+ * field node (length, null count) of each column.
+ */
+struct ArrowBody {
+    net::BufferBuilder                         data;
+    std::vector<std::pair<int64_t, int64_t> > buffers;
+    std::vector<std::pair<int64_t, int64_t> > nodes;
+
+    void AddBuffer(const void* ptr, size_t size) {
+        buffers.emplace_back(data.size(), size);
+        data.Append(ptr, size);
+        static const char zeros[8] = { 0 };
+        data.Append(zeros, (8 - size % 8) % 8);
+    }
+};
+
+/*!
+ * A RecordBatch read from a stream: the message and its body, from which the
+ * columns are decoded.
+ */
+struct ArrowBatchView {
+    //! RecordBatch table
+    ArrowFlatTable batch;
+    //! message body with the buffers
+    const std::string& body;
+
+    int64_t rows() const { return batch.Scalar<int64_t>(0, 0); }
+
+    //! check the field node of column, which must have rows items and no nulls
+    void CheckNode(size_t column) const {
+        std::pair<int64_t, int64_t> node = batch.VectorPair(1, column);
+        if (node.first != rows())
+            die("Arrow: column " << column << " has " << node.first
+                                 << " items instead of " << rows());
+        if (node.second != 0)
+            die("Arrow: column " << column << " has nulls, unsupported");
+    }
+
+    //! buffer index of the RecordBatch as pointer into the body
+    const char * Buffer(size_t index, size_t size) const {
+        std::pair<int64_t, int64_t> buf = batch.VectorPair(2, index);
+        if (buf.first < 0 || buf.second < static_cast<int64_t>(size) ||
+            static_cast<uint64_t>(buf.first) + size > body.size())
+            die("Arrow: buffer " << index << " exceeds the message body");
+        return body.data() + buf.first;
+    }
+};
+
+template <typename Type, typename Enable = void>
+struct ArrowColumnTraits {
+    static_assert(sizeof(Type) == 0,
+                  "Arrow: column type must be arithmetic or std::string");
+};
+
+template <typename Type>
+struct ArrowColumnTraits<
+    Type, typename std::enable_if<
+        std::is_arithmetic<Type>::value && !std::is_same<Type, bool>::value>
+    ::type>
+{
+    static_assert(!std::is_floating_point<Type>::value ||
+                  sizeof(Type) == 4 || sizeof(Type) == 8,
+                  "Arrow: only float and double are supported");
+
+    static constexpr ArrowTypeId type_id =
+        std::is_floating_point<Type>::value
+        ? ArrowTypeId::FloatingPoint : ArrowTypeId::Int;
+
+    //! validity and value buffers
+    static constexpr size_t num_buffers = 2;
+
+    //! build the Int or FloatingPoint table of the Type union
+    static uint32_t BuildType(ArrowFlatBuilder& fb) {
+        fb.StartTable();
+        if (std::is_floating_point<Type>::value) {
+            // Precision: SINGLE = 1, DOUBLE = 2
+            fb.AddScalar<int16_t>(0, sizeof(Type) == 4 ? 1 : 2);
+        }
+        else {
+            fb.AddScalar<int32_t>(0, 8 * sizeof(Type));
+            fb.AddScalar<uint8_t>(1, std::is_signed<Type>::value);
+        }
+        return fb.EndTable();
+    }
+
+    //! whether the Type union of a Field matches Type
+    static bool CheckType(uint8_t id, const ArrowFlatTable& type) {
+        if (id != static_cast<uint8_t>(type_id)) return false;
+        if (std::is_floating_point<Type>::value)
+            return type.Scalar<int16_t>(0, 0) == (sizeof(Type) == 4 ? 1 : 2);
+        return type.Scalar<int32_t>(0, 0) == 8 * sizeof(Type) &&
+               (type.Scalar<uint8_t>(1, 0) != 0) == std::is_signed<Type>::value;
+    }
+
+    static void Encode(const std::vector<Type>& v, ArrowBody& body) {
+        body.nodes.emplace_back(v.size(), 0);
+        body.AddBuffer(nullptr, 0);
+        body.AddBuffer(v.data(), v.size() * sizeof(Type));
+    }
+
+    static void Decode(const ArrowBatchView& view, size_t column,
+                       size_t buffer, std::vector<Type>& v) {
+        view.CheckNode(column);
+        size_t rows = view.rows();
+        v.resize(rows);
+        std::memcpy(v.data(), view.Buffer(buffer + 1, rows * sizeof(Type)),
+                    rows * sizeof(Type));
+    }
+};
+
+template <>
+struct ArrowColumnTraits<std::string>
+{
+    static constexpr ArrowTypeId type_id = ArrowTypeId::Utf8;
+
+    //! validity, offsets, and data buffers
+    static constexpr size_t num_buffers = 3;
+
+    //! build the empty Utf8 table of the Type union
+    static uint32_t BuildType(ArrowFlatBuilder& fb) {
+        fb.StartTable();
+        return fb.EndTable();
+    }
+
+    //! accepts Utf8 and Binary columns
+    static bool CheckType(uint8_t id, const ArrowFlatTable& /* type */) {
+        return id == static_cast<uint8_t>(ArrowTypeId::Utf8) ||
+               id == static_cast<uint8_t>(ArrowTypeId::Binary);
+    }
+
+    static void Encode(const std::vector<std::string>& v, ArrowBody& body) {
+        std::vector<int32_t> offsets(v.size() + 1);
+        size_t total = 0;
+        for (size_t i = 0; i < v.size(); ++i) {
+            offsets[i] = static_cast<int32_t>(total);
+            total += v[i].size();
+            if (total > static_cast<size_t>(
+                    std::numeric_limits<int32_t>::max()))
+                die("Arrow: string column exceeds 2 GiB in one batch");
+        }
+        offsets[v.size()] = static_cast<int32_t>(total);
+
+        body.nodes.emplace_back(v.size(), 0);
+        body.AddBuffer(nullptr, 0);
+        body.AddBuffer(offsets.data(), offsets.size() * sizeof(int32_t));
+
+        std::string data;
+        data.reserve(total);
+        for (const std::string& s : v) data += s;
+        body.AddBuffer(data.data(), data.size());
+    }
+
+    static void Decode(const ArrowBatchView& view, size_t column,
+                       size_t buffer, std::vector<std::string>& v) {
+        view.CheckNode(column);
+        size_t rows = view.rows();
+        v.resize(rows);
+        if (rows == 0) return;
+
+        std::vector<int32_t> offsets(rows + 1);
+        std::memcpy(offsets.data(),
+                    view.Buffer(buffer + 1, offsets.size() * sizeof(int32_t)),
+                    offsets.size() * sizeof(int32_t));
+        if (offsets[0] < 0 || offsets[rows] < offsets[0])
+            die("Arrow: invalid offsets of column " << column);
+
+        const char* data = view.Buffer(buffer + 2, offsets[rows]);
+        for (size_t i = 0; i < rows; ++i) {
+            if (offsets[i + 1] < offsets[i])
+                die("Arrow: invalid offsets of column " << column);
+            v[i].assign(data + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+    }
+};
+
+//! Encapsulate a Message with the given header table as stream message
+//! prefix: continuation marker, metadata size, and metadata.
+static inline std::string ArrowMessage(
+    ArrowFlatBuilder& fb, ArrowMessageType type, uint32_t header,
+    int64_t body_length) {
+    fb.StartTable();
+    fb.AddScalar<int64_t>(3, body_length);
+    fb.AddOffset(2, header);
+    // MetadataVersion V5
+    fb.AddScalar<int16_t>(0, 4);
+    fb.AddScalar<uint8_t>(1, static_cast<uint8_t>(type));
+    std::string meta = fb.Finish(fb.EndTable());
+
+    net::BufferBuilder bb;
+    bb.Put<uint32_t>(0xFFFFFFFF);
+    bb.Put<int32_t>(static_cast<int32_t>(meta.size()));
+    bb.AppendString(meta);
+    return bb.ToString();
+}
+
+//! Schema message of a stream of tuples of Columns, named by names.
+template <typename... Columns>
+std::string ArrowSchemaMessage(const std::vector<std::string>& names) {
+    static_assert(sizeof ... (Columns) > 0, "Arrow: tuple without columns");
+    die_unequal(names.size(), sizeof ... (Columns));
+
+    ArrowFlatBuilder fb;
+    uint8_t type_ids[] = {
+        static_cast<uint8_t>(ArrowColumnTraits<Columns>::type_id) ...
+    };
+    uint32_t types[] = { ArrowColumnTraits<Columns>::BuildType(fb) ... };
+
+    std::vector<uint32_t> fields;
+    for (size_t i = 0; i < names.size(); ++i) {
+        uint32_t name = fb.CreateString(names[i]);
+        uint32_t children = fb.CreateOffsetVector({ });
+        fb.StartTable();
+        fb.AddOffset(0, name);
+        fb.AddOffset(3, types[i]);
+        fb.AddOffset(5, children);
+        // nullable = false
+        fb.AddScalar<uint8_t>(1, 0);
+        fb.AddScalar<uint8_t>(2, type_ids[i]);
+        fields.push_back(fb.EndTable());
+    }
+    uint32_t field_vector = fb.CreateOffsetVector(fields);
+
+    fb.StartTable();
+    fb.AddOffset(1, field_vector);
+    // endianness = Little
+    fb.AddScalar<int16_t>(0, 0);
+    uint32_t schema = fb.EndTable();
+
+    return ArrowMessage(fb, ArrowMessageType::Schema, schema, 0);
+}
+
+//! RecordBatch message prefix of rows items, whose buffers are in body.
+static inline std::string ArrowRecordBatchMessage(
+    size_t rows, const ArrowBody& body) {
+    ArrowFlatBuilder fb;
+    uint32_t nodes = fb.CreatePairVector(body.nodes);
+    uint32_t buffers = fb.CreatePairVector(body.buffers);
+
+    fb.StartTable();
+    fb.AddScalar<int64_t>(0, rows);
+    fb.AddOffset(1, nodes);
+    fb.AddOffset(2, buffers);
+    uint32_t batch = fb.EndTable();
+
+    return ArrowMessage(fb, ArrowMessageType::RecordBatch, batch,
+                        body.data.size());
+}
+
+//! end-of-stream marker: continuation marker and metadata size zero
+static constexpr char arrow_end_of_stream[8] = {
+    '\xFF', '\xFF', '\xFF', '\xFF', 0, 0, 0, 0
+};
+
+//! \}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_ARROW_FORMAT_HEADER
+
+/******************************************************************************/
@@ -99,6 +99,7 @@ auto DIA<ValueType, Stack>::BernoulliSample(const double p) const {
         << "event" << "create"
         << "type" << "LOp"
         << "parents" << (common::Array<size_t>{ dia_id_ });
+    context().RegisterLOp(new_id, "BernoulliSample", dia_id_);
 
     auto new_stack = stack_.push(BernoulliSampleNode<ValueType>(p));
     return DIA<ValueType, decltype(new_stack)>(
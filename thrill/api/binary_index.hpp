@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * thrill/api/binary_index.hpp
+ *
+ * Block index footer of files written by WriteBinary.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_BINARY_INDEX_HEADER
+#define THRILL_API_BINARY_INDEX_HEADER
+
+#include <thrill/net/buffer_builder.hpp>
+#include <thrill/net/buffer_reader.hpp>
+#include <thrill/vfs/file_io.hpp>
+#include <tlx/die.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+//! magic trailer of the block index
+static constexpr char binary_index_magic[8] = {
+    'T', 'H', 'R', 'L', 'B', 'I', 'X', '1'
+};
+
+/*!
+ * Optional index appended to files written by WriteBinary. It lists for each
+ * serialized Block in the file its size, the offset of the first item starting
+ * in it, and the number of items starting in it. With it, ReadBinary can split
+ * files of variable-size items at item boundaries without scanning them, and
+ * map the Blocks directly from the file.
+ *
+ * \verbatim
+ * [blocks...][varint num_blocks][varint size, first_item, num_items]...
+ * [uint64_t index size][8 bytes magic "THRLBIX1"]
+ * \endverbatim
+ */
+class BinaryBlockIndex
+{
+public:
+    struct Entry {
+        //! size of the block in bytes
+        uint64_t size;
+        //! offset of first item starting in the block, or size if none does.
+        uint64_t first_item;
+        //! number of items starting in the block
+        uint64_t num_items;
+    };
+
+    //! blocks in file order
+    std::vector<Entry> blocks;
+
+    //! size of the data in the file before the index
+    uint64_t data_size() const {
+        uint64_t s = 0;
+        for (const Entry& e : blocks) s += e.size;
+        return s;
+    }
+
+    //! add a block
+    void Add(uint64_t size, uint64_t first_item, uint64_t num_items) {
+        blocks.emplace_back(
+            Entry { size, num_items ? first_item : size, num_items });
+    }
+
+    //! append the index to a stream after the blocks
+    void Write(vfs::WriteStream& stream) const {
+        net::BufferBuilder bb;
+        bb.PutVarint(blocks.size());
+        for (const Entry& e : blocks)
+            bb.PutVarint(e.size).PutVarint(e.first_item).PutVarint(e.num_items);
+
+        uint64_t index_size = bb.size();
+        bb.Put<uint64_t>(index_size);
+        bb.Append(binary_index_magic, sizeof(binary_index_magic));
+        stream.write(bb.data(), bb.size());
+    }
+
+    /*!
+     * Read the index from the end of a file of given size. Returns false if the
+     * file has no index.
+     */
+    bool Read(const std::string& path, uint64_t file_size) {
+        blocks.clear();
+        if (file_size < trailer_size_) return false;
+
+        std::string trailer = ReadRange(
+            path, file_size - trailer_size_, trailer_size_);
+
+        if (std::memcmp(trailer.data() + sizeof(uint64_t),
+                        binary_index_magic, sizeof(binary_index_magic)) != 0)
+            return false;
+
+        uint64_t index_size;
+        std::memcpy(&index_size, trailer.data(), sizeof(index_size));
+        if (index_size > file_size - trailer_size_)
+            die("ReadBinary: path " << path << " has an invalid block index");
+
+        std::string data = ReadRange(
+            path, file_size - trailer_size_ - index_size, index_size);
+
+        net::BufferReader br(data);
+        blocks.resize(br.GetVarint());
+        for (Entry& e : blocks) {
+            e.size = br.GetVarint();
+            e.first_item = br.GetVarint();
+            e.num_items = br.GetVarint();
+        }
+
+        if (data_size() + index_size + trailer_size_ != file_size)
+            die("ReadBinary: path " << path << " has an invalid block index");
+
+        return true;
+    }
+
+private:
+    //! size of trailer: index size and magic
+    static constexpr size_t trailer_size_ =
+        sizeof(uint64_t) + sizeof(binary_index_magic);
+
+    //! read size bytes at offset from the file
+    static std::string ReadRange(
+        const std::string& path, uint64_t offset, uint64_t size) {
+        std::string buffer(size, 0);
+        vfs::ReadStreamPtr rs = vfs::OpenReadStream(
+            path, common::Range(offset, offset + size));
+
+        size_t pos = 0;
+        while (pos < size) {
+            ssize_t rb = rs->read(&buffer[pos], size - pos);
+            if (rb <= 0)
+                die("ReadBinary: unexpected end of file in " << path);
+            pos += rb;
+        }
+        rs->close();
+        return buffer;
+    }
+};
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_BINARY_INDEX_HEADER
+
+/******************************************************************************/
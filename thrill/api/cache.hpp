@@ -15,8 +15,10 @@
 #include <thrill/api/collapse.hpp>
 #include <thrill/api/dia.hpp>
 #include <thrill/api/dia_node.hpp>
+#include <thrill/data/compressed_file.hpp>
 #include <thrill/data/file.hpp>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,7 +26,8 @@ namespace thrill {
 namespace api {
 
 /*!
- * A DOpNode which caches all items in an external file.
+ * A DOpNode which caches all items in an external file, or in a
+ * data::CompressedFile if a codec is given in the CacheOptions.
  *
  * \ingroup api_layer
  */
@@ -32,6 +35,8 @@ template <typename ValueType>
 class CacheNode final : public DIANode<ValueType>
 {
 public:
+    static constexpr bool debug = false;
+
     using Super = DIANode<ValueType>;
     using Super::context_;
 
@@ -39,17 +44,29 @@ public:
      * Constructor for a LOpNode. Sets the Context, parents and stack.
      */
     template <typename ParentDIA>
-    explicit CacheNode(const ParentDIA& parent)
+    explicit CacheNode(const ParentDIA& parent,
+                       const CacheOptions& options = CacheOptions())
         : Super(parent.ctx(), "Cache", { parent.id() }, { parent.node() }),
           parent_stack_empty_(ParentDIA::stack_empty) {
+        this->set_partitioning(parent.partitioning());
+        if (!options.codec.empty() && options.codec != "none") {
+            compressed_ = std::make_unique<data::CompressedFile>(
+                context_.block_pool(), context_.local_worker_id(),
+                options.codec);
+            compressed_writer_ = compressed_->GetWriter();
+        }
         auto save_fn = [this](const ValueType& input) {
-                           writer_.Put(input);
+                           if (compressed_)
+                               compressed_writer_.Put(input);
+                           else
+                               writer_.Put(input);
                        };
         auto lop_chain = parent.stack().push(save_fn).fold();
         parent.node()->AddChild(this, lop_chain);
     }
 
     bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
+        if (compressed_) return false;
         if (!parent_stack_empty_) {
             LOGC(common::g_debug_push_file)
                 << "Cache rejected File from parent "
@@ -64,20 +81,32 @@ public:
     void StopPreOp(size_t /* parent_index */) final {
         // Push local elements to children
         writer_.Close();
+        compressed_writer_.Close();
+        if (compressed_) {
+            sLOG << "Cache compressed" << compressed_->size_bytes()
+                 << "bytes to" << compressed_->stored_bytes();
+        }
     }
 
     void Execute() final { }
 
     void PushData(bool consume) final {
+        if (compressed_) {
+            data::CompressedFile::Reader reader = compressed_->GetReader();
+            this->PushReaderItems(reader, compressed_->num_items());
+            if (consume) compressed_->Clear();
+            return;
+        }
         this->PushFile(file_, consume);
     }
 
     void Dispose() final {
         file_.Clear();
+        if (compressed_) compressed_->Clear();
     }
 
     size_t NumItems() const {
-        return file_.num_items();
+        return compressed_ ? compressed_->num_items() : file_.num_items();
     }
 
 private:
@@ -85,6 +114,10 @@ private:
     data::File file_ { context_.GetFile(this) };
     //! Data writer to local file (only active in PreOp).
     data::File::Writer writer_ { file_.GetWriter() };
+    //! Compressed local data, if a codec was given.
+    std::unique_ptr<data::CompressedFile> compressed_;
+    //! Data writer to compressed_ (only active in PreOp).
+    data::CompressedFile::Writer compressed_writer_;
     //! Whether the parent stack is empty
     const bool parent_stack_empty_;
 };
@@ -106,6 +139,14 @@ DIA<ValueType> DIA<ValueType, Stack>::Cache() const {
         tlx::make_counting<api::CacheNode<ValueType> >(*this));
 }
 
+template <typename ValueType, typename Stack>
+DIA<ValueType> DIA<ValueType, Stack>::Cache(
+    const CacheOptions& options) const {
+    assert(IsValid());
+    return DIA<ValueType>(
+        tlx::make_counting<api::CacheNode<ValueType> >(*this, options));
+}
+
 } // namespace api
 } // namespace thrill
 
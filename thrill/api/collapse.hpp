@@ -39,6 +39,7 @@ public:
     explicit CollapseNode(const ParentDIA& parent)
         : Super(parent.ctx(), "Collapse", { parent.id() }, { parent.node() }),
           parent_stack_empty_(ParentDIA::stack_empty) {
+        this->set_partitioning(parent.partitioning());
         auto propagate_fn = [this](const ValueType& input) {
                                 this->PushItem(input);
                             };
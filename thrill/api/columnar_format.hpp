@@ -0,0 +1,190 @@
+/*******************************************************************************
+ * thrill/api/columnar_format.hpp
+ *
+ * On-disk layout of the column-oriented files written by WriteColumnar and read
+ * by ReadColumnar.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_COLUMNAR_FORMAT_HEADER
+#define THRILL_API_COLUMNAR_FORMAT_HEADER
+
+#include <thrill/net/buffer_builder.hpp>
+#include <thrill/net/buffer_reader.hpp>
+#include <tlx/die.hpp>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * \name Columnar File Format
+ *
+ * A columnar file consists of row groups followed by a footer:
+ *
+ * \verbatim
+ * [row group 0: chunk col 0][chunk col 1]...[row group 1: ...]...
+ * [footer][uint64_t footer size][8 bytes magic "THRLCOL1"]
+ * \endverbatim
+ *
+ * Each column chunk stores the values of one column of a row group:
+ * arithmetic columns as a raw array, string columns as varint length prefixed
+ * strings. The footer contains the type codes of all columns and, for each row
+ * group, the number of rows and for each column the byte offset, byte size,
+ * and the minimum and maximum value of the chunk. The statistics allow readers
+ * to skip row groups without touching their data.
+ *
+ * \{
+ */
+
+//! magic trailer of columnar files
+static constexpr char columnar_magic[8] = {
+    'T', 'H', 'R', 'L', 'C', 'O', 'L', '1'
+};
+
+//! size of trailer: footer size and magic
+static constexpr size_t columnar_trailer_size = sizeof(uint64_t) + 8;
+
+/*!
+ * Encoding of a column type. Only arithmetic types (except bool) and
+ * std::string are supported as column types.
+ */
+template <typename Type, typename Enable = void>
+struct ColumnTraits {
+    static_assert(sizeof(Type) == 0,
+                  "Columnar: column type must be arithmetic or std::string");
+};
+
+template <typename Type>
+struct ColumnTraits<
+    Type, typename std::enable_if<
+        std::is_arithmetic<Type>::value && !std::is_same<Type, bool>::value>
+    ::type>
+{
+    //! type code stored in the footer: class in high nibble, size in low.
+    static constexpr uint8_t type_code =
+        (std::is_floating_point<Type>::value ? 0x20 :
+         std::is_signed<Type>::value ? 0x10 : 0x00) | sizeof(Type);
+
+    static void Encode(const std::vector<Type>& v, net::BufferBuilder& bb) {
+        bb.Append(v.data(), v.size() * sizeof(Type));
+    }
+
+    static void Decode(net::BufferReader& br, size_t rows,
+                       std::vector<Type>& v) {
+        v.resize(rows);
+        br.Read(v.data(), rows * sizeof(Type));
+    }
+
+    static std::string EncodeValue(const Type& t) {
+        return std::string(reinterpret_cast<const char*>(&t), sizeof(t));
+    }
+
+    static Type DecodeValue(const std::string& s) {
+        die_unequal(s.size(), sizeof(Type));
+        Type t;
+        std::memcpy(&t, s.data(), sizeof(t));
+        return t;
+    }
+};
+
+template <>
+struct ColumnTraits<std::string>
+{
+    static constexpr uint8_t type_code = 0x30;
+
+    static void Encode(const std::vector<std::string>& v,
+                       net::BufferBuilder& bb) {
+        for (const std::string& s : v)
+            bb.PutString(s);
+    }
+
+    static void Decode(net::BufferReader& br, size_t rows,
+                       std::vector<std::string>& v) {
+        v.resize(rows);
+        for (size_t i = 0; i < rows; ++i)
+            v[i] = br.GetString();
+    }
+
+    static std::string EncodeValue(const std::string& s) { return s; }
+
+    static std::string DecodeValue(const std::string& s) { return s; }
+};
+
+//! Location and statistics of one column chunk in a row group
+struct ColumnChunkInfo {
+    //! byte offset of the chunk in the file
+    uint64_t    offset;
+    //! byte size of the chunk
+    uint64_t    size;
+    //! encoded minimum and maximum value in the chunk
+    std::string min, max;
+};
+
+//! Row group description in the footer
+struct RowGroupInfo {
+    //! number of rows in the group
+    uint64_t                     num_rows;
+    //! one entry per column
+    std::vector<ColumnChunkInfo> columns;
+};
+
+//! Footer of a columnar file
+struct ColumnarFooter {
+    //! type codes of the columns
+    std::vector<uint8_t>      types;
+    //! row groups in file order
+    std::vector<RowGroupInfo> row_groups;
+
+    void Serialize(net::BufferBuilder& bb) const {
+        bb.PutVarint(types.size());
+        for (const uint8_t& t : types)
+            bb.Put<uint8_t>(t);
+
+        bb.PutVarint(row_groups.size());
+        for (const RowGroupInfo& rg : row_groups) {
+            bb.PutVarint(rg.num_rows);
+            for (const ColumnChunkInfo& c : rg.columns) {
+                bb.PutVarint(c.offset).PutVarint(c.size);
+                bb.PutString(c.min).PutString(c.max);
+            }
+        }
+    }
+
+    static ColumnarFooter Deserialize(net::BufferReader& br) {
+        ColumnarFooter f;
+        f.types.resize(br.GetVarint());
+        for (uint8_t& t : f.types)
+            t = br.Get<uint8_t>();
+
+        f.row_groups.resize(br.GetVarint());
+        for (RowGroupInfo& rg : f.row_groups) {
+            rg.num_rows = br.GetVarint();
+            rg.columns.resize(f.types.size());
+            for (ColumnChunkInfo& c : rg.columns) {
+                c.offset = br.GetVarint();
+                c.size = br.GetVarint();
+                c.min = br.GetString();
+                c.max = br.GetString();
+            }
+        }
+        return f;
+    }
+};
+
+//! \}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_COLUMNAR_FORMAT_HEADER
+
+/******************************************************************************/
@@ -114,6 +114,23 @@ public:
     explicit ConcatNode(const std::initializer_list<ParentDIA>& parents)
         : ConcatNode(std::vector<ParentDIA>(parents)) { }
 
+    //! Constructor for the unordered variant with variadic parent parameter
+    //! pack.
+    template <typename ParentDIA0, typename... ParentDIAs>
+    ConcatNode(const struct UnorderedTag&,
+               const ParentDIA0& parent0, const ParentDIAs& ... parents)
+        : ConcatNode(parent0, parents...) {
+        unordered_ = true;
+    }
+
+    //! Constructor for the unordered variant with a std::vector of parents.
+    template <typename ParentDIA>
+    ConcatNode(const struct UnorderedTag&,
+               const std::vector<ParentDIA>& parents)
+        : ConcatNode(parents) {
+        unordered_ = true;
+    }
+
     void PrintWarning() {
         static bool warned_once = false;
         if (warned_once) return;
@@ -188,6 +205,8 @@ public:
     void Execute() final {
         LOG << "ConcatNode::Execute() processing";
 
+        if (unordered_) return ExecuteUnordered();
+
         using VectorSizeT = std::vector<size_t>;
 
         VectorSizeT local_sizes(num_inputs_);
@@ -277,6 +296,91 @@ public:
         }
     }
 
+    /*!
+     * Executes the unordered concat operation: the items are balanced with as
+     * few moves as possible. Each worker keeps its items up to its share of the
+     * total, and the surplus items of all workers, in rank order, fill up the
+     * workers below their share, also in rank order.
+     */
+    void ExecuteUnordered() {
+        using VectorSizeT = std::vector<size_t>;
+
+        const size_t num_workers = context_.num_workers();
+        const size_t my_rank = context_.my_rank();
+
+        size_t local_size = 0;
+        for (size_t i = 0; i < num_inputs_; ++i)
+            local_size += files_[i].num_items();
+
+        // collect the number of items on all workers
+        VectorSizeT sizes(num_workers);
+        sizes[my_rank] = local_size;
+        sizes = context_.net.AllReduce(
+            sizes, common::ComponentSum<VectorSizeT>());
+
+        size_t total_items = 0;
+        for (size_t p = 0; p < num_workers; ++p)
+            total_items += sizes[p];
+
+        // rank of my first surplus item among those of all workers, and the
+        // ranges of surplus ranks filling the deficits of the workers.
+        size_t surplus_begin = 0;
+        VectorSizeT deficit_begin(num_workers + 1, 0);
+        for (size_t p = 0; p < num_workers; ++p) {
+            size_t share = common::CalculateLocalRange(
+                total_items, num_workers, p).size();
+            if (p < my_rank && sizes[p] > share)
+                surplus_begin += sizes[p] - share;
+            deficit_begin[p + 1] =
+                deficit_begin[p] + (share > sizes[p] ? share - sizes[p] : 0);
+        }
+
+        size_t keep = std::min(
+            local_size, context_.CalculateLocalRange(total_items).size());
+        size_t surplus_end = surplus_begin + local_size - keep;
+
+        // boundaries of the items for each worker in the local sequence of all
+        // files, which is in any order.
+        VectorSizeT bounds(num_workers + 1, 0);
+        for (size_t p = 0; p < num_workers; ++p) {
+            size_t amount = 0;
+            if (p == my_rank) {
+                amount = keep;
+            }
+            else {
+                size_t begin = std::max(surplus_begin, deficit_begin[p]);
+                size_t end = std::min(surplus_end, deficit_begin[p + 1]);
+                if (begin < end) amount = end - begin;
+            }
+            bounds[p + 1] = bounds[p] + amount;
+        }
+        assert(bounds[num_workers] == local_size);
+
+        LOG << "ExecuteUnordered() sizes " << sizes << " bounds " << bounds;
+
+        streams_.reserve(num_inputs_);
+        for (size_t i = 0; i < num_inputs_; ++i)
+            streams_.emplace_back(context_.GetNewCatStream(this));
+
+        // scatter each file's part of the boundaries.
+        size_t file_begin = 0;
+        for (size_t in = 0; in < num_inputs_; ++in) {
+            size_t file_end = file_begin + files_[in].num_items();
+
+            std::vector<size_t> offsets(num_workers + 1);
+            for (size_t p = 0; p <= num_workers; ++p) {
+                offsets[p] =
+                    std::min(std::max(bounds[p], file_begin), file_end)
+                    - file_begin;
+            }
+
+            streams_[in]->template ScatterConsume<ValueType>(
+                files_[in], offsets);
+
+            file_begin = file_end;
+        }
+    }
+
     void PushData(bool consume) final {
 
         size_t total = 0;
@@ -306,6 +410,9 @@ private:
     //! Whether the parent stack is empty
     const std::vector<bool> parent_stack_empty_;
 
+    //! Whether the order of the items may be changed, see ExecuteUnordered()
+    bool unordered_ = false;
+
     //! Files for intermediate storage
     std::vector<data::File> files_;
     //! Writers to intermediate files
@@ -383,6 +490,54 @@ auto Concat(const std::vector<DIA<ValueType> >& dias) {
     return DIA<ValueType>(tlx::make_counting<ConcatNode>(dias));
 }
 
+/*!
+ * Concat is a DOp, which concatenates any number of DIAs to a single DIA.  All
+ * input DIAs must contain the same type, which is also the output DIA's type.
+ *
+ * This variant balances all input data without preserving the order of the
+ * items: each worker keeps its items up to an equal share, and only the
+ * surplus is sent to the workers below their share. Items in the parents'
+ * Files are kept by reference.
+ *
+ * \param first_dia first DIA
+ * \param dias DIAs, which are concatd with the first DIA.
+ *
+ * \ingroup dia_dops_free
+ */
+template <typename FirstDIA, typename... DIAs>
+auto Concat(struct UnorderedTag const& unordered_tag,
+            const FirstDIA& first_dia, const DIAs& ... dias) {
+
+    tlx::vexpand((first_dia.AssertValid(), 0), (dias.AssertValid(), 0) ...);
+
+    using ValueType = typename FirstDIA::ValueType;
+
+    using ConcatNode = api::ConcatNode<ValueType>;
+
+    return DIA<ValueType>(
+        tlx::make_counting<ConcatNode>(unordered_tag, first_dia, dias...));
+}
+
+/*!
+ * Concat is a DOp, which concatenates any number of DIAs to a single DIA,
+ * balancing them without preserving the order of the items, see above.
+ *
+ * \param dias DIAs, which is concatenated.
+ *
+ * \ingroup dia_dops_free
+ */
+template <typename ValueType>
+auto Concat(struct UnorderedTag const& unordered_tag,
+            const std::vector<DIA<ValueType> >& dias) {
+
+    for (const DIA<ValueType>& d : dias)
+        d.AssertValid();
+
+    using ConcatNode = api::ConcatNode<ValueType>;
+
+    return DIA<ValueType>(tlx::make_counting<ConcatNode>(unordered_tag, dias));
+}
+
 template <typename ValueType, typename Stack>
 template <typename SecondDIA>
 auto DIA<ValueType, Stack>::Concat(
@@ -390,6 +545,14 @@ auto DIA<ValueType, Stack>::Concat(
     return api::Concat(*this, second_dia);
 }
 
+template <typename ValueType, typename Stack>
+template <typename SecondDIA>
+auto DIA<ValueType, Stack>::Concat(
+    struct UnorderedTag const& unordered_tag,
+    const SecondDIA& second_dia) const {
+    return api::Concat(unordered_tag, *this, second_dia);
+}
+
 } // namespace api
 
 //! imported from api namespace
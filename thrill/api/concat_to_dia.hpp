@@ -46,9 +46,7 @@ public:
     { }
 
     void PushData(bool /* consume */) final {
-        for (size_t i = 0; i < in_vector_.size(); ++i) {
-            this->PushItem(in_vector_[i]);
-        }
+        this->PushItems(in_vector_.begin(), in_vector_.end());
     }
 
     void Dispose() final {
@@ -12,6 +12,8 @@
 #include <thrill/api/context.hpp>
 
 #include <thrill/api/dia_base.hpp>
+#include <thrill/api/job_scheduler.hpp>
+#include <thrill/common/deferred_work.hpp>
 #include <thrill/common/linux_proc_stats.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/math.hpp>
@@ -20,21 +22,27 @@
 #include <thrill/common/string.hpp>
 #include <thrill/common/system_exception.hpp>
 #include <thrill/vfs/file_io.hpp>
+#include <thrill/vfs/locality.hpp>
 
 #include <foxxll/io/iostats.hpp>
 #include <foxxll/mng/config.hpp>
+#include <tlx/die.hpp>
 #include <tlx/math/abs_diff.hpp>
 #include <tlx/port/setenv.hpp>
 #include <tlx/string/format_si_iec_units.hpp>
 #include <tlx/string/parse_si_iec_units.hpp>
 #include <tlx/string/split.hpp>
+#include <tlx/unused.hpp>
 
 // mock net backend is always available -tb :)
 #include <thrill/net/mock/group.hpp>
 
+#if THRILL_HAVE_NET_SHM
+#include <thrill/net/shm/group.hpp>
+#endif
+
 #if THRILL_HAVE_NET_TCP
 #include <thrill/net/tcp/construct.hpp>
-#include <thrill/net/tcp/select_dispatcher.hpp>
 #endif
 
 #if THRILL_HAVE_NET_MPI
@@ -57,6 +65,17 @@
 
 #endif
 
+#if !defined(_MSC_VER)
+
+// for stat() of the directories in THRILL_DISKS
+#include <sys/stat.h>
+
+// for the disk calibration of MemoryConfig::autotune()
+#include <fcntl.h>
+#include <unistd.h>
+
+#endif
+
 #if __APPLE__
 
 // for sysctl()
@@ -73,8 +92,12 @@
 #endif
 
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <csignal>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <string>
 #include <thread>
@@ -97,19 +120,24 @@ ConstructLoopbackHostContexts(
     size_t num_hosts, size_t workers_per_host) {
 
     static constexpr size_t kGroupCount = net::Manager::kGroupCount;
+    const size_t num_stripes = FindNetStripes();
 
-    // construct three full mesh loopback cliques, deliver net::Groups.
-    std::array<std::vector<std::unique_ptr<NetGroup> >, kGroupCount> group;
+    // construct two full mesh loopback cliques, plus one for each additional
+    // stripe of the data group, deliver net::Groups.
+    std::vector<std::vector<std::unique_ptr<NetGroup> > > group(
+        kGroupCount + num_stripes - 1);
 
-    for (size_t g = 0; g < kGroupCount; ++g) {
+    for (size_t g = 0; g < group.size(); ++g) {
         group[g] = NetGroup::ConstructLoopbackMesh(num_hosts);
     }
 
+    // let the groups construct their dispatcher, which may be selected at
+    // runtime.
     std::vector<std::unique_ptr<net::DispatcherThread> > dispatcher;
     for (size_t h = 0; h < num_hosts; ++h) {
         dispatcher.emplace_back(
             std::make_unique<net::DispatcherThread>(
-                std::make_unique<typename NetGroup::Dispatcher>(), h));
+                group[0][h]->ConstructDispatcher(), h));
     }
 
     // construct host context
@@ -117,6 +145,9 @@ ConstructLoopbackHostContexts(
     std::vector<std::unique_ptr<HostContext> > host_context;
 
     for (size_t h = 0; h < num_hosts; h++) {
+        for (size_t g = kGroupCount; g < group.size(); ++g)
+            group[1][h]->AddStripe(std::move(group[g][h]));
+
         std::array<net::GroupPtr, kGroupCount> host_group = {
             { std::move(group[0][h]), std::move(group[1][h]) }
         };
@@ -201,6 +232,27 @@ static inline bool SetupBlockSize() {
     return true;
 }
 
+//! read a positive count from environment variable name, default is 1.
+static inline size_t FindEnvCount(const char* name, const char* what) {
+    const char* env = getenv(name);
+    if (!env || !*env) return 1;
+
+    char* endptr;
+    size_t result = std::strtoul(env, &endptr, 10);
+    if (!endptr || *endptr != 0 || result == 0) {
+        die("Thrill: environment variable"
+            << ' ' << name << '=' << env
+            << " is not a valid number of " << what << ".");
+    }
+    return result;
+}
+
+//! number of connections to each peer used by the data Multiplexer, read from
+//! THRILL_NET_STRIPES. The additional stripes are constructed as extra Groups.
+static inline size_t FindNetStripes() {
+    return FindEnvCount("THRILL_NET_STRIPES", "connection stripes");
+}
+
 static inline size_t FindWorkersPerHost(
     const char*& str_workers_per_host, const char*& env_workers_per_host) {
 
@@ -266,9 +318,10 @@ static inline size_t FindWorkersPerHost(
         }
     }
 
-    // last check: return std::thread::hardware_concurrency()
+    // last check: return the number of cores available to the process, which
+    // respects cpusets and cgroup cpu quotas of containers.
 
-    return std::thread::hardware_concurrency();
+    return common::GetAvailableCores();
 }
 
 static inline bool Initialize() {
@@ -459,7 +512,7 @@ int RunBackendLoopback(
 
         size_t last_core = core_offset + num_hosts * workers_per_host;
         if (!endptr || *endptr != 0 ||
-            last_core > std::thread::hardware_concurrency())
+            last_core > common::GetAvailableCpus().size())
         {
             std::cerr << "Thrill: environment variable"
                       << " THRILL_CORE_OFFSET=" << env_core_offset
@@ -600,14 +653,182 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
     if (!Initialize()) return -1;
 
     static constexpr size_t kGroupCount = net::Manager::kGroupCount;
+    const size_t num_stripes = FindNetStripes();
+
+    // connect the flow group lazily on demand, since its collectives only
+    // communicate with a few peers of each host.
+    const char* env_lazy = getenv("THRILL_TCP_LAZY");
+    const size_t num_lazy_groups =
+        (env_lazy && *env_lazy && strcmp(env_lazy, "0") != 0) ? 1 : 0;
+
+    // construct two TCP network groups plus one for each additional stripe of
+    // the data group, using a temporary dispatcher for the connection setup,
+    // which is epoll if available since select is limited to FD_SETSIZE.
+    std::vector<std::unique_ptr<net::tcp::Group> > groups(
+        kGroupCount + num_stripes - 1);
+    {
+        std::unique_ptr<net::Dispatcher> dispatcher =
+            net::tcp::Group::ConstructTcpDispatcher();
+        net::tcp::Construct(
+            *dispatcher, my_host_rank, hostlist,
+            groups.data(), groups.size(), num_lazy_groups);
+    }
 
-    // construct three TCP network groups
-    auto select_dispatcher = std::make_unique<net::tcp::SelectDispatcher>();
+    // the flow group carries the latency-bound collectives on its own sockets,
+    // let the kernel send its packets ahead of the Blocks of the data group.
+    groups[0]->SetSocketPriority(net::tcp::Socket::kPriorityInteractive);
+    for (size_t g = 1; g < groups.size(); ++g)
+        groups[g]->SetSocketPriority(net::tcp::Socket::kPriorityBulk);
+
+#if THRILL_HAVE_NET_ZEROCOPY
+    // send Blocks of the data group and its stripes with MSG_ZEROCOPY
+    const char* env_zerocopy = getenv("THRILL_TCP_ZEROCOPY");
+    if (env_zerocopy && *env_zerocopy && strcmp(env_zerocopy, "0") != 0) {
+        for (size_t g = 1; g < groups.size(); ++g) {
+            if (groups[g]->EnableZeroCopy() == 0 &&
+                groups[g]->num_hosts() > 1) {
+                std::cerr << "Thrill: THRILL_TCP_ZEROCOPY is not supported"
+                          << " by the kernel, sending with copies."
+                          << std::endl;
+                break;
+            }
+        }
+    }
+#endif
+
+    for (size_t g = kGroupCount; g < groups.size(); ++g)
+        groups[1]->AddStripe(std::move(groups[g]));
 
-    std::array<std::unique_ptr<net::tcp::Group>, kGroupCount> groups;
-    net::tcp::Construct(
-        *select_dispatcher, my_host_rank, hostlist,
-        groups.data(), net::Manager::kGroupCount);
+    // the dispatcher is selected by THRILL_TCP_DISPATCHER
+    auto dispatcher = std::make_unique<net::DispatcherThread>(
+        groups[0]->ConstructDispatcher(), my_host_rank);
+
+    std::array<net::GroupPtr, kGroupCount> host_groups = {
+        { std::move(groups[0]), std::move(groups[1]) }
+    };
+
+    // construct HostContext
+
+    HostContext host_context(
+        0, mem_config,
+        std::move(dispatcher), std::move(host_groups), workers_per_host);
+
+    std::vector<std::thread> threads(workers_per_host);
+
+    for (size_t worker = 0; worker < workers_per_host; worker++) {
+        threads[worker] = common::CreateThread(
+            [&host_context, &job_startpoint, worker] {
+                Context ctx(host_context, worker);
+                common::NameThisThread("worker " + std::to_string(worker));
+
+                ctx.Launch(job_startpoint);
+            });
+        common::SetCpuAffinity(threads[worker], worker);
+    }
+
+    // join worker threads
+    for (size_t i = 0; i < workers_per_host; i++) {
+        threads[i].join();
+    }
+
+    if (!Deinitialize()) return -1;
+
+    return 0;
+}
+#endif
+
+#if THRILL_HAVE_NET_SHM
+static inline
+int RunBackendShm(const std::function<void(Context&)>& job_startpoint) {
+
+    char* endptr;
+
+    // select environment variables
+
+    const char* env_rank = getenv("THRILL_RANK");
+    const char* env_hosts = getenv("THRILL_SHM_HOSTS");
+    const char* env_name = getenv("THRILL_SHM_NAME");
+
+    // parse environment variables
+
+    size_t my_host_rank = 0, num_hosts = 0;
+
+    if (env_hosts != nullptr && *env_hosts != 0) {
+        num_hosts = std::strtoul(env_hosts, &endptr, 10);
+
+        if (endptr == nullptr || *endptr != 0 || num_hosts == 0) {
+            std::cerr << "Thrill: environment variable"
+                      << " THRILL_SHM_HOSTS=" << env_hosts
+                      << " is not a valid number of processes."
+                      << std::endl;
+            return -1;
+        }
+    }
+    else {
+        std::cerr << "Thrill: environment variable THRILL_SHM_HOSTS"
+                  << " is required for shm network backend."
+                  << std::endl;
+        return -1;
+    }
+
+    if (env_rank != nullptr && *env_rank != 0) {
+        my_host_rank = std::strtoul(env_rank, &endptr, 10);
+
+        if (endptr == nullptr || *endptr != 0 || my_host_rank >= num_hosts) {
+            std::cerr << "Thrill: environment variable"
+                      << " THRILL_RANK=" << env_rank
+                      << " is not a valid rank below THRILL_SHM_HOSTS."
+                      << std::endl;
+            return -1;
+        }
+    }
+    else {
+        std::cerr << "Thrill: environment variable THRILL_RANK"
+                  << " is required for shm network backend."
+                  << std::endl;
+        return -1;
+    }
+
+    std::string name =
+        (env_name != nullptr && *env_name != 0) ? env_name : "thrill";
+
+    // determine number of local worker threads per process
+
+    const char* str_workers_per_host;
+    const char* env_workers_per_host;
+
+    size_t workers_per_host = FindWorkersPerHost(
+        str_workers_per_host, env_workers_per_host);
+
+    if (workers_per_host == 0)
+        return -1;
+
+    // detect memory config
+
+    MemoryConfig mem_config;
+    if (mem_config.setup_detect() < 0) return -1;
+    mem_config.print(workers_per_host);
+
+    // okay, configuration is good.
+
+    std::cerr << "Thrill: running in shm network with " << num_hosts
+              << " processes and " << workers_per_host << " workers per host"
+              << " as rank " << my_host_rank << " of segments " << name
+              << std::endl;
+
+    if (!Initialize()) return -1;
+
+    static constexpr size_t kGroupCount = net::Manager::kGroupCount;
+    const size_t num_stripes = FindNetStripes();
+
+    // construct the shared memory network groups and the data stripes
+    std::vector<std::unique_ptr<net::shm::Group> > groups(
+        kGroupCount + num_stripes - 1);
+    net::shm::Construct(name, my_host_rank, num_hosts,
+                        groups.data(), groups.size());
+
+    for (size_t g = kGroupCount; g < groups.size(); ++g)
+        groups[1]->AddStripe(std::move(groups[g]));
 
     std::array<net::GroupPtr, kGroupCount> host_groups = {
         { std::move(groups[0]), std::move(groups[1]) }
@@ -616,7 +837,7 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
     // construct HostContext
 
     auto dispatcher = std::make_unique<net::DispatcherThread>(
-        std::move(select_dispatcher), my_host_rank);
+        std::make_unique<net::shm::Dispatcher>(), my_host_rank);
 
     HostContext host_context(
         0, mem_config,
@@ -632,7 +853,6 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
 
                 ctx.Launch(job_startpoint);
             });
-        common::SetCpuAffinity(threads[worker], worker);
     }
 
     // join worker threads
@@ -700,8 +920,12 @@ int RunBackendMpi(const std::function<void(Context&)>& job_startpoint) {
     auto dispatcher = std::make_unique<net::DispatcherThread>(
         std::make_unique<net::mpi::Dispatcher>(num_hosts), mpi_rank);
 
-    std::array<std::unique_ptr<net::mpi::Group>, kGroupCount> groups;
-    net::mpi::Construct(num_hosts, *dispatcher, groups.data(), kGroupCount);
+    std::vector<std::unique_ptr<net::mpi::Group> > groups(
+        kGroupCount + FindNetStripes() - 1);
+    net::mpi::Construct(num_hosts, *dispatcher, groups.data(), groups.size());
+
+    for (size_t g = kGroupCount; g < groups.size(); ++g)
+        groups[1]->AddStripe(std::move(groups[g]));
 
     std::array<net::GroupPtr, kGroupCount> host_groups = {
         { std::move(groups[0]), std::move(groups[1]) }
@@ -774,9 +998,16 @@ int RunBackendIb(const std::function<void(Context&)>& job_startpoint) {
 
     static constexpr size_t kGroupCount = net::Manager::kGroupCount;
 
-    // construct two MPI network groups
-    std::array<std::unique_ptr<net::ib::Group>, kGroupCount> groups;
-    net::ib::Construct(num_hosts, groups.data(), kGroupCount);
+    // construct two IB network groups
+    auto dispatcher = std::make_unique<net::DispatcherThread>(
+        std::make_unique<net::ib::Dispatcher>(), mpi_rank);
+
+    std::vector<std::unique_ptr<net::ib::Group> > groups(
+        kGroupCount + FindNetStripes() - 1);
+    net::ib::Construct(num_hosts, groups.data(), groups.size());
+
+    for (size_t g = kGroupCount; g < groups.size(); ++g)
+        groups[1]->AddStripe(std::move(groups[g]));
 
     std::array<net::GroupPtr, kGroupCount> host_groups = {
         { std::move(groups[0]), std::move(groups[1]) }
@@ -784,7 +1015,8 @@ int RunBackendIb(const std::function<void(Context&)>& job_startpoint) {
 
     // construct HostContext
     HostContext host_context(
-        0, mem_config, std::move(host_groups), workers_per_host);
+        0, mem_config,
+        std::move(dispatcher), std::move(host_groups), workers_per_host);
 
     // launch worker threads
     std::vector<std::thread> threads(workers_per_host);
@@ -909,12 +1141,45 @@ public:
 };
 
 void FoxxllConfig::load_default_config() {
-    TLX_LOG1 << "foxxll: Using default disk configuration.";
-    foxxll::disk_config entry1(
-        default_disk_path(), 1000 * 1024 * 1024, default_disk_io_impl());
-    entry1.unlink_on_open = true;
-    entry1.autogrow = true;
-    add_disk(entry1);
+    // THRILL_DISKS: comma-separated directories or files, one per device
+    const char* env_disks = getenv("THRILL_DISKS");
+    if (!env_disks || !*env_disks) {
+        TLX_LOG1 << "foxxll: Using default disk configuration.";
+        foxxll::disk_config entry1(
+            default_disk_path(), 1000 * 1024 * 1024, default_disk_io_impl());
+        entry1.unlink_on_open = true;
+        entry1.autogrow = true;
+        add_disk(entry1);
+        return;
+    }
+
+    std::string file_name = default_disk_path();
+    file_name = file_name.substr(file_name.rfind('/') + 1);
+
+    for (const std::string& disk : tlx::split(',', env_disks)) {
+        if (disk.empty()) continue;
+        // place a temporary file into directories, otherwise use the path
+        std::string path = disk;
+#if !FOXXLL_WINDOWS
+        struct stat st;
+        if (stat(disk.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+            path = disk + "/" + file_name;
+#endif
+
+        // each disk gets its own device id, hence foxxll serves it by a
+        // dedicated request queue and I/O thread.
+        foxxll::disk_config entry(
+            path, 1000 * 1024 * 1024, default_disk_io_impl());
+        entry.unlink_on_open = true;
+        entry.autogrow = true;
+        add_disk(entry);
+    }
+
+    if (disks_number() == 0)
+        die("Thrill: environment variable THRILL_DISKS contains no disks.");
+
+    TLX_LOG1 << "foxxll: striping external memory across "
+             << disks_number() << " disks from THRILL_DISKS.";
 }
 
 std::string FoxxllConfig::default_disk_path() {
@@ -989,6 +1254,15 @@ int Run(const std::function<void(Context&)>& job_startpoint) {
 #endif
     }
 
+    if (strcmp(env_net, "shm") == 0) {
+#if THRILL_HAVE_NET_SHM
+        // shared memory network backend between processes on one host
+        return RunBackendShm(job_startpoint);
+#else
+        return RunNotSupported(env_net);
+#endif
+    }
+
     if (strcmp(env_net, "mpi") == 0) {
 #if THRILL_HAVE_NET_MPI
         // mpi network backend
@@ -1012,6 +1286,18 @@ int Run(const std::function<void(Context&)>& job_startpoint) {
     return -1;
 }
 
+int RunDaemon(
+    const std::map<std::string, std::function<void(Context&)> >& jobs,
+    const std::function<std::string()>& next_job) {
+    return Run([&](Context& ctx) { ctx.ServeJobs(jobs, next_job); });
+}
+
+int RunDaemon(
+    const std::map<std::string, std::function<void(Context&)> >& jobs,
+    JobScheduler& scheduler) {
+    return Run([&](Context& ctx) { ctx.ServeJobs(jobs, scheduler); });
+}
+
 /******************************************************************************/
 // MemoryConfig
 
@@ -1071,21 +1357,169 @@ int MemoryConfig::setup_detect() {
         else {
             sLOG1 << "getrlimit(): " << strerror(errno);
         }
+
+        // the memory limit of our cgroup, e.g. of a container, is what we get
+        size_t cgroup_limit = common::GetCgroupMemoryLimit();
+        if (cgroup_limit != 0 && cgroup_limit < ram_)
+            ram_ = cgroup_limit;
 #endif
     }
 
+    const char* env_compressed_ram = getenv("THRILL_COMPRESSED_RAM");
+
+    if (env_compressed_ram != nullptr && *env_compressed_ram != 0) {
+        uint64_t compressed64;
+        if (!tlx::parse_si_iec_units(env_compressed_ram, &compressed64)) {
+            std::cerr << "Thrill: environment variable"
+                      << " THRILL_COMPRESSED_RAM=" << env_compressed_ram
+                      << " is not a valid amount of RAM memory."
+                      << std::endl;
+            return -1;
+        }
+        ram_block_pool_compressed_ = static_cast<size_t>(compressed64);
+    }
+
+    const char* env_autotune = getenv("THRILL_AUTOTUNE");
+    if (env_autotune && *env_autotune && strcmp(env_autotune, "0") != 0)
+        autotune();
+
     apply();
 
     return 0;
 }
 
+//! seconds elapsed since start
+static inline double SecondsSince(
+    const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+//! measure the memcpy() bandwidth in bytes per second, best of four rounds.
+static inline double MeasureMemoryBandwidth() {
+    static constexpr size_t size = 64 * 1024 * 1024;
+    std::vector<char> src(size, 1), dst(size);
+
+    double best = 0;
+    for (size_t round = 0; round < 4; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        std::memcpy(dst.data(), src.data(), size);
+        best = std::max(best, static_cast<double>(size) / SecondsSince(start));
+        src[round] = dst[size - 1 - round];
+    }
+    return best;
+}
+
+/*!
+ * Measure the sequential write bandwidth of the first disk of THRILL_DISKS, or
+ * of /var/tmp where foxxll places its default disk, by writing and syncing a
+ * temporary file, and the latency of a synced 4 KiB write. Returns false if
+ * the directory is not writable.
+ */
+static inline bool MeasureDisk(double* bandwidth, double* latency) {
+#if !defined(_MSC_VER)
+    std::string dir = "/var/tmp";
+    const char* env_disks = getenv("THRILL_DISKS");
+    if (env_disks && *env_disks) {
+        // never write into raw devices or files given as disks
+        dir = tlx::split(',', env_disks).front();
+        struct stat st;
+        if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+            return false;
+    }
+
+    std::string path =
+        dir + "/thrill-autotune." + std::to_string(getpid()) + ".tmp";
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return false;
+    unlink(path.c_str());
+
+    static constexpr size_t chunk = 1024 * 1024, chunks = 32;
+    std::vector<char> data(chunk, 1);
+    bool ok = true;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < chunks && ok; ++i)
+        ok = write(fd, data.data(), chunk) == static_cast<ssize_t>(chunk);
+    ok = ok && fsync(fd) == 0;
+    *bandwidth = static_cast<double>(chunk * chunks) / SecondsSince(start);
+
+    static constexpr size_t syncs = 16;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < syncs && ok; ++i) {
+        ok = pwrite(fd, data.data(), 4096, i * 4096) == 4096 &&
+             fsync(fd) == 0;
+    }
+    *latency = SecondsSince(start) / syncs;
+
+    close(fd);
+    return ok;
+#else
+    tlx::unused(bandwidth, latency);
+    return false;
+#endif
+}
+
+void MemoryConfig::autotune() {
+    mem_bandwidth_ = MeasureMemoryBandwidth();
+
+    if (!MeasureDisk(&disk_bandwidth_, &disk_latency_)) {
+        disk_bandwidth_ = disk_latency_ = 0;
+        if (verbose_) {
+            std::cerr << "Thrill: THRILL_AUTOTUNE could not measure the disk,"
+                      << " keeping block size and RAM split." << std::endl;
+        }
+        return;
+    }
+
+    // blocks should take four times the disk's latency to transfer, such that
+    // the disk spends at most a fifth of its time waiting.
+    double block = 4 * disk_bandwidth_ * disk_latency_;
+    size_t block_size = 256 * 1024;
+    while (block_size < block && block_size < 16 * 1024 * 1024)
+        block_size *= 2;
+    data::default_block_size = block_size;
+
+    // keep two blocks in flight on each striped disk
+    size_t disks = 1;
+    const char* env_disks = getenv("THRILL_DISKS");
+    if (env_disks && *env_disks)
+        disks = std::max<size_t>(1, tlx::split(',', env_disks).size());
+    data::File::default_prefetch_size_ = 2 * disks * block_size;
+
+    // slow disks make spilling expensive: give the BlockPool half of the RAM
+    // at the cost of the workers' data structures.
+    if (disk_bandwidth_ < 512.0 * 1024 * 1024) {
+        block_pool_fraction_ = 1.0 / 2.0;
+        workers_fraction_ = 1.0 / 4.0;
+    }
+
+    if (verbose_) {
+        std::cerr
+            << "Thrill: autotune measured memory "
+            << tlx::format_iec_units(static_cast<uint64_t>(mem_bandwidth_))
+            << "B/s, disk "
+            << tlx::format_iec_units(static_cast<uint64_t>(disk_bandwidth_))
+            << "B/s with " << disk_latency_ * 1e3 << " ms latency:"
+            << " block_size=" << tlx::format_iec_units(block_size) << "B,"
+            << " prefetch="
+            << tlx::format_iec_units(data::File::default_prefetch_size_)
+            << "B." << std::endl;
+    }
+}
+
 void MemoryConfig::apply() {
     // divide up ram_
 
-    ram_workers_ = ram_ / 3;
-    ram_block_pool_hard_ = ram_ / 3;
+    ram_workers_ = static_cast<size_t>(ram_ * workers_fraction_);
+    size_t ram_block_pool = static_cast<size_t>(ram_ * block_pool_fraction_);
+    // the compressed tier takes at most half of the BlockPool's RAM
+    ram_block_pool_compressed_ =
+        std::min(ram_block_pool_compressed_, ram_block_pool / 2);
+    ram_block_pool_hard_ = ram_block_pool - ram_block_pool_compressed_;
     ram_block_pool_soft_ = ram_block_pool_hard_ * 9 / 10;
-    ram_floating_ = ram_ - ram_block_pool_hard_ - ram_workers_;
+    ram_floating_ = ram_ - ram_block_pool_hard_ - ram_block_pool_compressed_
+                    - ram_workers_;
 
     // set memory limit, only BlockPool is excluded from malloc tracking, as
     // only it uses bypassing allocators.
@@ -1098,6 +1532,7 @@ MemoryConfig MemoryConfig::divide(size_t hosts) const {
     mc.ram_ /= hosts;
     mc.ram_block_pool_hard_ /= hosts;
     mc.ram_block_pool_soft_ /= hosts;
+    mc.ram_block_pool_compressed_ /= hosts;
     mc.ram_workers_ /= hosts;
     // free floating memory is not divided by host, as it is measured overall
 
@@ -1111,6 +1546,8 @@ void MemoryConfig::print(size_t workers_per_host) const {
         << "Thrill: using "
         << tlx::format_iec_units(ram_) << "B RAM total,"
         << " BlockPool=" << tlx::format_iec_units(ram_block_pool_hard_) << "B,"
+        << " compressed="
+        << tlx::format_iec_units(ram_block_pool_compressed_) << "B,"
         << " workers="
         << tlx::format_iec_units(ram_workers_ / workers_per_host) << "B,"
         << " floating=" << tlx::format_iec_units(ram_floating_) << "B."
@@ -1138,14 +1575,129 @@ HostContext::HostContext(
     // write command line parameters to json log
     common::LogCmdlineParams(logger_);
 
+    if (mem_config_.mem_bandwidth_ != 0) {
+        logger_ << "class" << "MemoryConfig"
+                << "event" << "autotune"
+                << "mem_bandwidth" << mem_config_.mem_bandwidth_
+                << "disk_bandwidth" << mem_config_.disk_bandwidth_
+                << "disk_latency" << mem_config_.disk_latency_
+                << "block_size" << data::default_block_size
+                << "prefetch_size" << data::File::default_prefetch_size_
+                << "ram_block_pool" << mem_config_.ram_block_pool_hard_
+                << "ram_workers" << mem_config_.ram_workers_
+                << "ram_floating" << mem_config_.ram_floating_;
+    }
+
+    const char* env_metrics_port = getenv("THRILL_METRICS_PORT");
+    if (env_metrics_port && *env_metrics_port) {
+        char* endptr;
+        unsigned long port = std::strtoul(env_metrics_port, &endptr, 10);
+        if (!endptr || *endptr != 0 || port > 65535) {
+            die("Thrill: environment variable"
+                " THRILL_METRICS_PORT=" << env_metrics_port <<
+                " is not a valid port number.");
+        }
+        // mock hosts in one process listen on consecutive ports
+        if (port != 0) port += local_host_id;
+
+        metrics_server_ = std::make_unique<common::MetricsServer>(
+            static_cast<uint16_t>(port),
+            "host_rank=\"" + std::to_string(host_rank()) + "\"");
+        block_pool_.set_metrics(metrics_server_.get());
+
+        if (mem_config_.verbose_ && metrics_server_->port() != 0) {
+            std::cerr << "Thrill: serving metrics of host " << host_rank()
+                      << " on port " << metrics_server_->port() << std::endl;
+        }
+    }
+
+    const char* env_net_rate = getenv("THRILL_NET_RATE");
+    if (env_net_rate && *env_net_rate) {
+        char* endptr;
+        double rate = std::strtod(env_net_rate, &endptr);
+        if (!endptr || *endptr != 0 || rate < 0) {
+            die("Thrill: environment variable"
+                " THRILL_NET_RATE=" << env_net_rate <<
+                " is not a valid rate in MiB/s.");
+        }
+        data_multiplexer_.set_send_rate(rate * 1024 * 1024);
+    }
+
     if (mem_config_.enable_proc_profiler_)
-        StartLinuxProcStatsProfiler(*profiler_, logger_);
+        StartLinuxProcStatsProfiler(*profiler_, logger_, metrics_server_.get());
+
+    perf_counters_ = common::StartPerfCounterProfiler(*profiler_, logger_);
+    stack_sampler_ = common::StartStackSampler(*profiler_, logger_);
+    sharded_stats_ = common::StartShardedStats(
+        *profiler_, logger_, metrics_server_.get());
+
+    // workers waiting in the flow control barrier run their deferred work,
+    // then tasks of stragglers
+    flow_manager_.barrier().set_idle_function(
+        [this]() {
+            return common::DeferredWork::RunOne() ||
+            (task_pool_.num_threads() != 0 && task_pool_.HelpOne());
+        });
+
+    // compress blocks evicted to external memory
+    const char* env_block_codec = getenv("THRILL_BLOCK_CODEC");
+    if (env_block_codec && *env_block_codec)
+        block_pool_.set_codec(data::BlockCodec::Create(env_block_codec));
+
+    // keep evicted blocks compressed in RAM before writing them to disk
+    if (mem_config_.ram_block_pool_compressed_ != 0) {
+        if (!env_block_codec || !*env_block_codec) {
+            die("Thrill: environment variable THRILL_COMPRESSED_RAM"
+                " requires a codec set by THRILL_BLOCK_CODEC.");
+        }
+        block_pool_.set_compressed_ram_limit(
+            mem_config_.ram_block_pool_compressed_);
+    }
+
+    const char* env_arena = getenv("THRILL_HUGE_PAGE_ARENA");
+    if (env_arena && *env_arena) {
+        uint64_t arena_size;
+        if (!tlx::parse_si_iec_units(env_arena, &arena_size)) {
+            die("Thrill: environment variable"
+                " THRILL_HUGE_PAGE_ARENA=" << env_arena <<
+                " is not a valid amount of memory.");
+        }
+        block_pool_.EnableHugePageArena(static_cast<size_t>(arena_size));
+    }
+
+    const char* env_mmap_read = getenv("THRILL_MMAP_READ");
+    if (env_mmap_read && *env_mmap_read && strcmp(env_mmap_read, "0") != 0)
+        block_pool_.set_map_files(true);
+
+    const char* env_numa_local = getenv("THRILL_NUMA_LOCAL");
+    if (env_numa_local && *env_numa_local && strcmp(env_numa_local, "0") != 0)
+        block_pool_.set_numa_local(true);
 
     // run memory profiler only on local host 0 (especially for test runs)
     if (local_host_id == 0)
         mem::StartMemProfiler(*profiler_, logger_);
 }
 
+size_t HostContext::FindNetDispatchers() {
+    return FindEnvCount("THRILL_NET_DISPATCHERS", "dispatcher threads");
+}
+
+size_t HostContext::FindTaskThreads() {
+    const char* env = getenv("THRILL_TASK_THREADS");
+    if (!env || !*env) {
+        // all cores but one, the calling worker is the last.
+        return common::GetAvailableCores() - 1;
+    }
+
+    char* endptr;
+    size_t result = std::strtoul(env, &endptr, 10);
+    if (!endptr || *endptr != 0) {
+        die("Thrill: environment variable THRILL_TASK_THREADS=" << env
+            << " is not a valid number of threads.");
+    }
+    return result;
+}
+
 HostContext::~HostContext() {
     // stop dispatcher _before_ stopping multiplexer
     dispatcher_->Terminate();
@@ -1170,6 +1722,11 @@ std::string HostContext::MakeHostLogPath(size_t host_rank) {
     if (output == "stdout")
         return "/dev/stdout";
 
+    // binary traces with deferred formatting, see common::JsonTraceWriter
+    const char* env_format = getenv("THRILL_LOG_FORMAT");
+    if (env_format && std::string(env_format) == "trace")
+        return output + "-host-" + std::to_string(host_rank) + ".trace";
+
     return output + "-host-" + std::to_string(host_rank) + ".json";
 }
 
@@ -1186,11 +1743,73 @@ Context::Context(HostContext& host_context, size_t local_worker_id)
       net_manager_(host_context.net_manager()),
       flow_manager_(host_context.flow_manager()),
       block_pool_(host_context.block_pool()),
+      task_pool_(host_context.task_pool()),
       multiplexer_(host_context.data_multiplexer()),
+      perf_counters_(host_context.perf_counters()),
+      stack_sampler_(host_context.stack_sampler()),
+      metrics_server_(host_context.metrics_server()),
+      sharded_stats_(host_context.sharded_stats()),
       rng_(std::random_device { }
            () + (local_worker_id_ << 16)),
       base_logger_(&host_context.base_logger_) {
     assert(local_worker_id < workers_per_host());
+
+    // Contexts are constructed by their worker thread
+    if (perf_counters_)
+        perf_counters_->AddThread(my_rank());
+    if (stack_sampler_)
+        stack_sampler_->AddThread(my_rank());
+
+    const char* env_weights = getenv("THRILL_HOST_WEIGHTS");
+    if (env_weights && *env_weights)
+        InitializeWorkerWeights(env_weights);
+}
+
+void Context::InitializeWorkerWeights(const char* env) {
+    std::vector<double> weights;
+
+    if (strcmp(env, "auto") == 0) {
+        // weigh the hosts by their number of cores, which requires that all
+        // hosts set THRILL_HOST_WEIGHTS=auto.
+        weights = *net.AllGather(
+            static_cast<double>(common::GetAvailableCores()));
+    }
+    else {
+        std::vector<std::string> list = tlx::split(',', env);
+        if (list.size() != num_hosts()) {
+            die("Thrill: environment variable THRILL_HOST_WEIGHTS=" << env <<
+                " must contain one weight for each of the " << num_hosts() <<
+                " hosts, or be \"auto\".");
+        }
+        for (size_t w = 0; w < num_workers(); ++w) {
+            const std::string& str = list[w / workers_per_host()];
+            char* endptr;
+            double weight = std::strtod(str.c_str(), &endptr);
+            if (!endptr || *endptr != 0 || !(weight > 0)) {
+                die("Thrill: environment variable THRILL_HOST_WEIGHTS=" << env <<
+                    " contains the invalid weight \"" << str << "\".");
+            }
+            weights.push_back(weight);
+        }
+    }
+
+    double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+    worker_weight_prefix_.resize(num_workers() + 1);
+    worker_weight_prefix_[0] = 0.0;
+    double sum = 0.0;
+    for (size_t w = 0; w < num_workers(); ++w) {
+        sum += weights[w];
+        worker_weight_prefix_[w + 1] = sum / total;
+    }
+    worker_weight_prefix_[num_workers()] = 1.0;
+}
+
+Context::~Context() {
+    if (perf_counters_)
+        perf_counters_->RemoveThread();
+    if (stack_sampler_)
+        stack_sampler_->RemoveThread();
 }
 
 data::File Context::GetFile(DIABase* dia) {
@@ -1272,6 +1891,98 @@ struct OverallStats {
     }
 };
 
+std::vector<common::Range> Context::CalculateLocalityRanges(
+    const vfs::FileList& files) {
+
+    std::shared_ptr<std::vector<std::string> > worker_hosts =
+        net.AllGather(common::GetHostname());
+
+    std::vector<std::pair<uint64_t, size_t> > pieces;
+    if (my_rank() == 0) {
+        std::vector<std::vector<vfs::FileBlockLocation> > locations;
+        for (const vfs::FileInfo& fi : files)
+            locations.emplace_back(vfs::GetFileBlockLocations(fi.path));
+
+        pieces = vfs::AssignLocalityPieces(files, locations, *worker_hosts);
+    }
+    pieces = net.Broadcast(pieces);
+
+    // collect my pieces and merge adjacent ones
+    std::vector<common::Range> ranges;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        if (pieces[i].second != my_rank()) continue;
+
+        uint64_t end = i + 1 < pieces.size()
+                       ? pieces[i + 1].first : files.total_size;
+
+        if (!ranges.empty() && ranges.back().end == pieces[i].first)
+            ranges.back().end = end;
+        else
+            ranges.emplace_back(pieces[i].first, end);
+    }
+
+    return ranges;
+}
+
+vfs::FileList Context::Glob(const std::vector<std::string>& globlist,
+                            const vfs::GlobType& gtype, bool local_storage) {
+    vfs::FileList files;
+    if (local_storage) {
+        if (local_worker_id() == 0)
+            files = vfs::Glob(globlist, gtype);
+        return net.LocalBroadcast(files);
+    }
+    if (my_rank() == 0)
+        files = vfs::Glob(globlist, gtype);
+    return net.Broadcast(files);
+}
+
+ClusterMemoryStats Context::ExchangeMemoryStats() {
+    // only one worker per host contributes its host's BlockPool.
+    std::array<size_t, 7> local;
+    if (local_worker_id() == 0) {
+        size_t ram = block_pool_.total_ram_bytes();
+        size_t swapped = block_pool_.swapped_bytes();
+        local = { { ram, ram, ram, block_pool_.hard_ram_limit(),
+                    swapped, swapped, swapped != 0 } };
+    }
+    else {
+        local = { { std::numeric_limits<size_t>::max(), 0, 0, 0, 0, 0, 0 } };
+    }
+
+    std::array<size_t, 7> global = net.AllReduce(
+        local, [](const std::array<size_t, 7>& a,
+                  const std::array<size_t, 7>& b) {
+            return std::array<size_t, 7>{ {
+                std::min(a[0], b[0]), std::max(a[1], b[1]), a[2] + b[2],
+                a[3] + b[3], std::max(a[4], b[4]), a[5] + b[5], a[6] + b[6]
+            } };
+        });
+
+    ClusterMemoryStats stats;
+    stats.min_ram_bytes = global[0];
+    stats.max_ram_bytes = global[1];
+    stats.total_ram_bytes = global[2];
+    stats.total_ram_limit = global[3];
+    stats.max_swapped_bytes = global[4];
+    stats.total_swapped_bytes = global[5];
+    stats.swapping_hosts = global[6];
+
+    if (my_rank() == 0) {
+        logger_ << "class" << "Context"
+                << "event" << "memory-stats"
+                << "min_ram_bytes" << stats.min_ram_bytes
+                << "max_ram_bytes" << stats.max_ram_bytes
+                << "total_ram_bytes" << stats.total_ram_bytes
+                << "total_ram_limit" << stats.total_ram_limit
+                << "max_swapped_bytes" << stats.max_swapped_bytes
+                << "total_swapped_bytes" << stats.total_swapped_bytes
+                << "swapping_hosts" << stats.swapping_hosts;
+    }
+
+    return stats;
+}
+
 void Context::Launch(const std::function<void(Context&)>& job_startpoint) {
     logger_ << "class" << "Context"
             << "event" << "job-start";
@@ -1350,6 +2061,56 @@ void Context::Launch(const std::function<void(Context&)>& job_startpoint) {
     }
 }
 
+size_t Context::ServeJobs(
+    const std::map<std::string, std::function<void(Context&)> >& jobs,
+    const std::function<std::string()>& next_job) {
+
+    size_t num_jobs = 0;
+
+    while (true) {
+        // the master selects the next job for all workers
+        std::string name;
+        if (my_rank() == 0) name = next_job();
+        name = net.Broadcast(name);
+
+        if (name.empty()) break;
+
+        auto it = jobs.find(name);
+        if (it == jobs.end()) {
+            if (my_rank() == 0)
+                LOG1 << "Thrill: daemon skips unknown job " << name;
+            continue;
+        }
+
+        logger_ << "class" << "Context"
+                << "event" << "daemon-job-start"
+                << "name" << name;
+
+        common::StatsTimerStart timer;
+        it->second(*this);
+
+        // wait for all workers, such that the next job starts on a clean slate
+        net.Barrier();
+
+        logger_ << "class" << "Context"
+                << "event" << "daemon-job-done"
+                << "name" << name
+                << "elapsed" << timer;
+
+        ++num_jobs;
+    }
+
+    return num_jobs;
+}
+
+size_t Context::ServeJobs(
+    const std::map<std::string, std::function<void(Context&)> >& jobs,
+    JobScheduler& scheduler) {
+    if (my_rank() == 0)
+        scheduler.set_ram_limit(mem_config_.ram_workers_);
+    return ServeJobs(jobs, [&scheduler]() { return scheduler.Next(); });
+}
+
 } // namespace api
 } // namespace thrill
 
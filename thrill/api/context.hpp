@@ -17,12 +17,18 @@
 #include <thrill/common/config.hpp>
 #include <thrill/common/defines.hpp>
 #include <thrill/common/json_logger.hpp>
+#include <thrill/common/metrics_server.hpp>
+#include <thrill/common/perf_counters.hpp>
 #include <thrill/common/profile_task.hpp>
+#include <thrill/common/sharded_stats.hpp>
+#include <thrill/common/stack_sampler.hpp>
+#include <thrill/common/task_pool.hpp>
 #include <thrill/data/block_pool.hpp>
 #include <thrill/data/cat_stream.hpp>
 #include <thrill/data/file.hpp>
 #include <thrill/data/mix_stream.hpp>
 #include <thrill/data/multiplexer.hpp>
+#include <thrill/mem/stage_arena.hpp>
 #include <thrill/net/flow_control_channel.hpp>
 #include <thrill/net/flow_control_manager.hpp>
 #include <thrill/net/manager.hpp>
@@ -30,13 +36,24 @@
 #include <algorithm>
 #include <cassert>
 #include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
 #include <numeric>
 #include <random>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 namespace thrill {
+
+namespace vfs {
+struct FileList;
+enum class GlobType;
+} // namespace vfs
+
 namespace api {
 
 //! \ingroup api_layer
@@ -44,6 +61,7 @@ namespace api {
 
 // forward declarations
 class DIABase;
+class JobScheduler;
 
 class MemoryConfig
 {
@@ -57,6 +75,10 @@ public:
     MemoryConfig divide(size_t hosts) const;
     void apply();
 
+    //! measure memory and disk bandwidth, and choose block size, prefetch
+    //! size, and the RAM split from them. Enabled by THRILL_AUTOTUNE=1.
+    void autotune();
+
     void print(size_t workers_per_host) const;
 
     //! total amount of physical ram detected or THRILL_RAM
@@ -68,6 +90,10 @@ public:
     //! amount of RAM dedicated to data::BlockPool -- soft limit
     size_t ram_block_pool_soft_;
 
+    //! amount of RAM of data::BlockPool keeping evicted blocks compressed, set
+    //! by THRILL_COMPRESSED_RAM and taken from the hard limit. 0 disables it.
+    size_t ram_block_pool_compressed_ = 0;
+
     //! total amount of RAM for DIANode data structures such as the reduce
     //! tables. divide by the number of worker threads before use.
     size_t ram_workers_;
@@ -75,6 +101,14 @@ public:
     //! remaining free-floating RAM used for user and Thrill data structures.
     size_t ram_floating_;
 
+    //! fractions of ram_ for the BlockPool and the workers, set by autotune()
+    double block_pool_fraction_ = 1.0 / 3.0;
+    double workers_fraction_ = 1.0 / 3.0;
+
+    //! memcpy() and disk write bandwidth in bytes per second and the latency
+    //! of a synced disk write in seconds, measured by autotune(), or 0.
+    double mem_bandwidth_ = 0, disk_bandwidth_ = 0, disk_latency_ = 0;
+
     //! StageBuilder verbosity flag
     bool verbose_ = true;
 
@@ -141,10 +175,29 @@ public:
     //! data multiplexer transmits large amounts of data asynchronously.
     data::Multiplexer& data_multiplexer() { return data_multiplexer_; }
 
+    //! helper threads for parallel loops of all workers of the host
+    common::TaskPool& task_pool() { return task_pool_; }
+
+    //! hardware counter profiler, nullptr unless THRILL_PERF_COUNTERS is set.
+    common::PerfCounterProfiler* perf_counters() { return perf_counters_; }
+
+    //! stack sampler, nullptr unless THRILL_STACK_SAMPLES is set.
+    common::StackSampler* stack_sampler() { return stack_sampler_; }
+
+    //! live metrics server, nullptr unless THRILL_METRICS_PORT is set.
+    common::MetricsServer* metrics_server() { return metrics_server_.get(); }
+
+    //! always-on counters and timers of the host's workers
+    common::ShardedStats& sharded_stats() { return *sharded_stats_; }
+
 private:
     //! memory configuration
     MemoryConfig mem_config_;
 
+    //! live metrics server of the host, declared before profiler_ whose tasks
+    //! publish to it.
+    std::unique_ptr<common::MetricsServer> metrics_server_;
+
 public:
     //! \name Logging System
     //! \{
@@ -163,6 +216,15 @@ public:
     //! \}
 
 private:
+    //! hardware counter profiler of the worker threads, owned by profiler_
+    common::PerfCounterProfiler* perf_counters_ = nullptr;
+
+    //! stack sampler of the worker threads, owned by profiler_
+    common::StackSampler* stack_sampler_ = nullptr;
+
+    //! always-on counters and timers of the workers, owned by profiler_
+    common::ShardedStats* sharded_stats_ = nullptr;
+
     //! id among all _local_ hosts (in test program runs)
     size_t local_host_id_;
 
@@ -203,11 +265,47 @@ private:
     };
 #endif
 
+    //! number of dispatcher threads of the data multiplexer, read from
+    //! THRILL_NET_DISPATCHERS.
+    static size_t FindNetDispatchers();
+
     //! data multiplexer transmits large amounts of data asynchronously.
     data::Multiplexer data_multiplexer_ {
         mem_manager_, block_pool_,
-        *dispatcher_, net_manager_.GetDataGroup(), workers_per_host_
+        *dispatcher_, net_manager_.GetDataGroup(), workers_per_host_,
+        FindNetDispatchers()
+    };
+
+    //! number of helper threads of the TaskPool, read from THRILL_TASK_THREADS.
+    static size_t FindTaskThreads();
+
+    //! helper threads for parallel loops of all workers of the host
+    common::TaskPool task_pool_ { FindTaskThreads(), &logger_ };
+
+#if !THRILL_HAVE_THREAD_SANITIZER
+    //! register TaskPool's profiling method
+    common::ProfileTaskRegistration task_pool_profiler_ {
+        std::chrono::milliseconds(500), *profiler_, &task_pool_
     };
+#endif
+};
+
+/*!
+ * Memory usage of the BlockPools of all hosts, collected by
+ * Context::ExchangeMemoryStats(). Operators can use it to detect that a single
+ * skewed host spills to external memory while the others have free RAM.
+ */
+struct ClusterMemoryStats {
+    //! minimum and maximum number of RAM bytes used by a host's BlockPool
+    size_t min_ram_bytes = 0, max_ram_bytes = 0;
+    //! total number of RAM bytes used by all BlockPools
+    size_t total_ram_bytes = 0;
+    //! total hard RAM limit of all BlockPools
+    size_t total_ram_limit = 0;
+    //! maximum and total number of bytes swapped to external memory
+    size_t max_swapped_bytes = 0, total_swapped_bytes = 0;
+    //! number of hosts which swapped blocks to external memory
+    size_t swapping_hosts = 0;
 };
 
 /*!
@@ -223,9 +321,37 @@ class Context
 public:
     Context(HostContext& host_context, size_t local_worker_id);
 
+    //! non-copyable: delete copy-constructor
+    Context(const Context&) = delete;
+    //! non-copyable: delete assignment operator
+    Context& operator = (const Context&) = delete;
+
+    ~Context();
+
     //! method used to launch a job's main procedure. it wraps it in log output.
     void Launch(const std::function<void(Context&)>& job_startpoint);
 
+    /*!
+     * Serve a sequence of jobs on the same Context, which reuses the network
+     * groups, BlockPool, and reserved memory. The worker with rank 0 calls
+     * next_job() to receive the name of the next job, which is broadcast to
+     * all workers and executed from the jobs map. An empty name stops the
+     * loop, unknown names are skipped. Returns the number of jobs run.
+     */
+    size_t ServeJobs(
+        const std::map<std::string, std::function<void(Context&)> >& jobs,
+        const std::function<std::string()>& next_job);
+
+    /*!
+     * Serve the jobs requested from a JobScheduler, see the other
+     * ServeJobs(). The worker with rank 0 sets the scheduler's RAM limit to
+     * this host's RAM for DIA operations, and takes the jobs from Next(). The
+     * jobs are run one at a time on all workers.
+     */
+    size_t ServeJobs(
+        const std::map<std::string, std::function<void(Context&)> >& jobs,
+        JobScheduler& scheduler);
+
     //! \name System Information
     //! \{
 
@@ -247,6 +373,14 @@ public:
     //! memory limit of this worker Context for local data structures
     size_t mem_limit() const { return mem_limit_; }
 
+    //! Returns the number of hardware threads available to this worker for
+    //! parallel local work, e.g. common::ParallelSort: the cores of the host
+    //! are divided evenly among its workers.
+    size_t num_threads_per_worker() const {
+        return std::max<size_t>(
+            1, std::thread::hardware_concurrency() / workers_per_host());
+    }
+
     //! Global number of workers in the system.
     size_t num_workers() const {
         return num_hosts() * workers_per_host();
@@ -267,6 +401,23 @@ public:
     //! id among all _local_ hosts (in test program runs)
     size_t local_host_id() const { return local_host_id_; }
 
+    //! true if THRILL_HOST_WEIGHTS assigns capacity weights to the hosts,
+    //! which weighted distributions of items follow.
+    bool has_worker_weights() const {
+        return !worker_weight_prefix_.empty();
+    }
+
+    //! Fraction of all items which the workers [0,worker) receive in weighted
+    //! distributions of items, e.g. by Rebalance() or Sort(). Without weights,
+    //! this is worker / num_workers().
+    double worker_weight_prefix(size_t worker) const {
+        assert(worker <= num_workers());
+        if (worker_weight_prefix_.empty())
+            return static_cast<double>(worker)
+                   / static_cast<double>(num_workers());
+        return worker_weight_prefix_[worker];
+    }
+
 #ifndef SWIG
     //! Outputs the context as [host id]:[local worker id] to an std::ostream
     friend std::ostream& operator << (std::ostream& os, const Context& ctx) {
@@ -325,12 +476,58 @@ public:
 
     //! \}
 
+    //! \name Parallel Local Work
+    //! \{
+
+    //! host-wide pool of helper threads which join the parallel loops of the
+    //! workers, such that a straggler uses the cores of finished workers.
+    common::TaskPool& task_pool() { return task_pool_; }
+
+    /*!
+     * Run f(i) for all i in [begin,end) in parallel on this worker thread and
+     * the idle helper threads of the host's TaskPool. The range is split into
+     * chunks of at least min_chunk indices. f must not throw exceptions.
+     */
+    template <typename Function>
+    void parallel_for(size_t begin, size_t end, const Function& f,
+                      size_t min_chunk = 1) {
+        task_pool_.ParallelFor(begin, end, f, min_chunk);
+    }
+
+    //! \}
+
     //! host-global memory config
     const MemoryConfig& mem_config() const { return mem_config_; }
 
+    //! live metrics server of the host, nullptr unless THRILL_METRICS_PORT is
+    //! set.
+    common::MetricsServer* metrics_server() const { return metrics_server_; }
+
+    //! always-on counters and timers shared by the host's workers
+    common::ShardedStats& sharded_stats() const { return sharded_stats_; }
+
     //! returns the host-global memory manager
     mem::Manager& mem_manager() { return mem_manager_; }
 
+    /*!
+     * Returns an allocator of this worker's StageArena for temporary strings
+     * and vectors in user functions, e.g. as mem::arena_string or
+     * mem::arena_vector. Allocations are pointer bumps, and the memory is
+     * reused once all allocations are freed. They must not outlive the stage.
+     */
+    mem::StageArenaAllocator<char> stage_arena() {
+        return mem::StageArenaAllocator<char>(stage_arena_);
+    }
+
+    //! Release chunks of the StageArena, called by the StageBuilder after each
+    //! stage.
+    void ResetStageArena() {
+        if (!stage_arena_.Reset()) {
+            LOG1 << "StageArena: " << stage_arena_.live()
+                 << " allocations outlived the stage";
+        }
+    }
+
     net::Manager& net_manager() { return net_manager_; }
 
     //! given a global range [0,global_size) and p PEs to split the range, calculate
@@ -346,6 +543,36 @@ public:
             global_size, workers_per_host(), local_worker_id());
     }
 
+    /*!
+     * Distribute the bytes [0,files.total_size) of the files to workers such
+     * that workers read blocks stored on their own host by a distributed file
+     * system, see vfs::AssignLocalityPieces(). Collective operation, in which
+     * worker 0 queries the block locations. Returns the global byte ranges of
+     * this worker in increasing order.
+     */
+    std::vector<common::Range> CalculateLocalityRanges(
+        const vfs::FileList& files);
+
+    /*!
+     * Collective vfs::Glob(): worker 0 lists the files and broadcasts the
+     * FileList to all workers, instead of every worker listing and stat()ing
+     * the same files. With local_storage, the first worker of each host lists
+     * its host's files and shares them with the other workers on the host.
+     */
+    vfs::FileList Glob(const std::vector<std::string>& globlist,
+                       const vfs::GlobType& gtype, bool local_storage = false);
+
+    /*!
+     * Collectively broadcast a read-only variable, e.g. a lookup table used in
+     * a Map(), from the worker with rank origin to all workers. The value is
+     * constructed only once per host and shared by all its workers, see
+     * FlowControlChannel::SharedBroadcast().
+     */
+    template <typename T>
+    std::shared_ptr<const T> Broadcast(const T& value, size_t origin = 0) {
+        return net.SharedBroadcast(value, origin);
+    }
+
     //! Perform collectives and print min, max, mean, stdev, and all local
     //! values.
     template <typename Type>
@@ -374,6 +601,13 @@ public:
         }
     }
 
+    /*!
+     * Collectively gather the memory usage of the BlockPools of all hosts,
+     * which is logged by worker 0 to the JSON log. This is a collective
+     * operation and must be called by all workers.
+     */
+    ClusterMemoryStats ExchangeMemoryStats();
+
     //! return value of consume flag.
     bool consume() const { return consume_; }
 
@@ -390,6 +624,38 @@ public:
     //! Returns next_dia_id_ to generate DIA::id_ serial.
     size_t next_dia_id() { return ++last_dia_id_; }
 
+    //! \name Explain
+    //! \{
+
+    //! Register an LOp created by a DIA method, such that Explain() can show
+    //! the LOps fused into the function stacks.
+    void RegisterLOp(size_t dia_id, const char* label, size_t parent_id) {
+        lops_.emplace(dia_id, std::make_pair(label, parent_id));
+    }
+
+    //! Register a DIANode created in this worker, called by DIABase.
+    void RegisterDIANode(size_t dia_id, DIABase* node) {
+        dia_nodes_[dia_id] = node;
+    }
+
+    //! Remove a destroyed DIANode, called by DIABase.
+    void UnregisterDIANode(size_t dia_id) { dia_nodes_.erase(dia_id); }
+
+    //! Returns the chain from the DIANode of a DIA through all LOps fused into
+    //! its function stack, e.g. "Generate.1 -> Map.2 -> Filter.3".
+    std::string ExplainLOpChain(size_t dia_id) const;
+
+    /*!
+     * Write all DIANodes alive in this worker in order of their ids to os:
+     * their parents with the fused LOp chains, the consume/keep status, the
+     * estimated item size, the implementation chosen by the node, and, after
+     * the node was executed, the number of items and bytes it pushed. This is
+     * a local operation, use DIA::Explain() to also see the planned stages.
+     */
+    void Explain(std::ostream& os = std::cout) const;
+
+    //! \}
+
 private:
     //! id among all _local_ hosts (in test program runs)
     size_t local_host_id_;
@@ -418,15 +684,47 @@ private:
     //! data block pool
     data::BlockPool& block_pool_;
 
+    //! host-wide pool of helper threads
+    common::TaskPool& task_pool_;
+
     //! data::Multiplexer instance that is shared among workers
     data::Multiplexer& multiplexer_;
 
+    //! hardware counter profiler of the host, which counts this worker thread
+    common::PerfCounterProfiler* perf_counters_;
+
+    //! stack sampler of the host, which samples this worker thread
+    common::StackSampler* stack_sampler_;
+
+    //! live metrics server of the host
+    common::MetricsServer* metrics_server_;
+
+    //! always-on counters and timers of the host
+    common::ShardedStats& sharded_stats_;
+
+    //! prefix sums of the normalized capacity weights of the workers, empty
+    //! unless THRILL_HOST_WEIGHTS is set.
+    std::vector<double> worker_weight_prefix_;
+
+    //! parse THRILL_HOST_WEIGHTS into worker_weight_prefix_, collective if it
+    //! is "auto".
+    void InitializeWorkerWeights(const char* env);
+
+    //! arena for temporary objects of user functions of this worker
+    mem::StageArena stage_arena_ { mem_manager_ };
+
     //! flag to set which enables selective consumption of DIA contents!
     bool consume_ = false;
 
     //! the number of valid DIA ids. 0 is reserved for invalid.
     size_t last_dia_id_ = 0;
 
+    //! label and parent DIA id of each LOp created, for Explain()
+    std::map<size_t, std::pair<const char*, size_t> > lops_;
+
+    //! all DIANodes alive in this worker by their DIA id, for Explain()
+    std::map<size_t, DIABase*> dia_nodes_;
+
 public:
     //! \name Shared Objects
     //! \{
@@ -512,6 +810,14 @@ int RunCheckDieWithParent();
  */
 int RunCheckUnlinkBinary();
 
+/*!
+ * Install Thrill's foxxll disk configuration: if no .thrill disk configuration
+ * file is found, the blocks evicted to external memory are striped across the
+ * disks in THRILL_DISKS, or else stored in one file in /var/tmp. Must be called
+ * before any block is evicted.
+ */
+void RunSetupFoxxll();
+
 //! \}
 
 /*!
@@ -541,6 +847,30 @@ int RunCheckUnlinkBinary();
  */
 int Run(const std::function<void(Context&)>& job_startpoint);
 
+/*!
+ * Runs Thrill as a persistent daemon, which executes many short jobs without
+ * the process startup, network construction, and memory setup of each. The
+ * configuration is taken from the environment like in Run(). next_job() is
+ * called once per job on the worker with rank 0 and returns the name of a job
+ * in the jobs map, e.g. read from a pipe or a socket, or an empty string to
+ * terminate. See Context::ServeJobs().
+ *
+ * \returns 0 if execution was fine on all threads.
+ */
+int RunDaemon(
+    const std::map<std::string, std::function<void(Context&)> >& jobs,
+    const std::function<std::string()>& next_job);
+
+/*!
+ * Runs Thrill as a persistent daemon like RunDaemon() above, which executes
+ * the jobs requested from a JobScheduler, until it is closed.
+ *
+ * \returns 0 if execution was fine on all threads.
+ */
+int RunDaemon(
+    const std::map<std::string, std::function<void(Context&)> >& jobs,
+    JobScheduler& scheduler);
+
 //! \}
 
 } // namespace api
@@ -554,6 +884,9 @@ using api::Context;
 //! imported from api namespace
 using api::Run;
 
+//! imported from api namespace
+using api::RunDaemon;
+
 } // namespace thrill
 
 #endif // !THRILL_API_CONTEXT_HEADER
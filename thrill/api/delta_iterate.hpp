@@ -0,0 +1,135 @@
+/*******************************************************************************
+ * thrill/api/delta_iterate.hpp
+ *
+ * Delta iteration: propagate only changed items of a keyed state.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_DELTA_ITERATE_HEADER
+#define THRILL_API_DELTA_ITERATE_HEADER
+
+#include <thrill/api/cache.hpp>
+#include <thrill/api/concat_to_dia.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/reduce_by_key.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/common/logger.hpp>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+//! \ingroup api_layer
+//! \{
+
+/*!
+ * Run a delta iteration on a keyed state: instead of recomputing the state of
+ * all keys in each iteration, only the items whose value changed in the
+ * previous iteration (the delta) are passed to the step function.
+ *
+ * The state is held partitioned by key on the workers: the messages created by
+ * step from the delta are reduced by key with ReducePair(), which delivers all
+ * messages of a key to the worker owning the key's partition, whose state is
+ * then updated locally. Hence, only messages are shuffled, never the state.
+ * All keys which are not reached by a message keep their value without being
+ * touched.
+ *
+ * The iteration stops if no value changed, or after max_iterations, and
+ * returns all (key, value) pairs of the state.
+ *
+ * \param initial initial state pairs, which are also the first delta.
+ *
+ * \param step function DIA<std::pair<Key, Value> > (const
+ * DIA<std::pair<Key, Value> >& delta, size_t iter) creating messages to keys
+ * from the changed pairs.
+ *
+ * \param reduce_function Value (const Value&, const Value&) combining the
+ * messages to a key, and duplicate keys of initial.
+ *
+ * \param update_function bool (Value& value, const Value& message) updating
+ * the value of a key with the reduced message, returns true if the value
+ * changed. Messages to keys without state insert the message as new value,
+ * which counts as changed.
+ *
+ * \param max_iterations maximum number of iterations.
+ */
+template <typename Key, typename Value, typename Stack, typename StepFunction,
+          typename ReduceFunction, typename UpdateFunction>
+DIA<std::pair<Key, Value> > DeltaIterate(
+    const DIA<std::pair<Key, Value>, Stack>& initial,
+    const StepFunction& step,
+    const ReduceFunction& reduce_function,
+    const UpdateFunction& update_function,
+    size_t max_iterations = size_t(-1)) {
+    static constexpr bool debug = false;
+
+    using Pair = std::pair<Key, Value>;
+
+    Context& ctx = initial.ctx();
+
+    // local partition of the state, filled only by items delivered to this
+    // worker by ReducePair().
+    std::unordered_map<Key, Value> state;
+
+    DIA<Pair> delta =
+        initial
+        .ReducePair(reduce_function)
+        .Map([&state](const Pair& p) {
+                 state.emplace(p);
+                 return p;
+             })
+        .Cache();
+    delta.Execute();
+
+    for (size_t iter = 0; iter < max_iterations; ++iter) {
+        size_t delta_size = delta.Keep().Size();
+
+        sLOG << "DeltaIterate(): iteration" << iter
+             << "delta_size" << delta_size;
+
+        if (delta_size == 0) break;
+
+        DIA<Pair> next =
+            step(delta, iter)
+            .ReducePair(reduce_function)
+            .template FlatMap<Pair>(
+                [&state, &update_function](const Pair& m, auto emit) {
+                    auto it = state.find(m.first);
+                    if (it == state.end()) {
+                        state.emplace(m);
+                        emit(m);
+                    }
+                    else if (update_function(it->second, m.second)) {
+                        emit(Pair(it->first, it->second));
+                    }
+                })
+            .Cache();
+        next.Execute();
+
+        // releases the nodes of the previous iteration
+        delta = next;
+    }
+
+    std::vector<Pair> out(state.begin(), state.end());
+    return ConcatToDIA(ctx, std::move(out));
+}
+
+//! \}
+
+} // namespace api
+
+//! imported from api namespace
+using api::DeltaIterate;
+
+} // namespace thrill
+
+#endif // !THRILL_API_DELTA_ITERATE_HEADER
+
+/******************************************************************************/
@@ -26,8 +26,11 @@
 
 #include <cassert>
 #include <functional>
+#include <iostream>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -37,6 +40,9 @@ namespace api {
 //! \ingroup api_layer
 //! \{
 
+//! result of approximate aggregations, see approx.hpp
+struct ApproxResult;
+
 //! tag structure for ReduceByKey(), and ReduceToIndex()
 template <bool Value>
 struct VolatileKeyFlag {
@@ -90,6 +96,14 @@ struct NoRebalanceTag {
 //! global const NoRebalanceTag instance
 const struct NoRebalanceTag NoRebalanceTag;
 
+//! tag structure for Concat() and Generate()
+struct UnorderedTag {
+    UnorderedTag() { }
+};
+
+//! global const UnorderedTag instance
+const struct UnorderedTag UnorderedTag;
+
 //! tag structure for Read()
 struct LocalStorageTag {
     LocalStorageTag() { }
@@ -124,6 +138,50 @@ const struct LocationDetectionFlag<true> LocationDetectionTag;
 //! global const LocationDetectionFlag instance
 const struct LocationDetectionFlag<false> NoLocationDetectionTag;
 
+//! options of Cache()
+struct CacheOptions {
+    //! name of the data::BlockCodec compressing the cached Blocks in RAM,
+    //! e.g. "zlib", or "none".
+    std::string codec = "none";
+};
+
+/*!
+ * LOp function of Filter(). It is a named type such that StackKeepsPartitioning
+ * recognizes it: a filter neither moves items to other workers nor changes
+ * their keys or order.
+ */
+template <typename FilterArgument, typename FilterFunction>
+class FilterLOp
+{
+public:
+    explicit FilterLOp(const FilterFunction& filter_function)
+        : filter_function_(filter_function) { }
+
+    template <typename Emitter>
+    void operator () (const FilterArgument& input, Emitter emit_func) const {
+        if (filter_function_(input)) emit_func(input);
+    }
+
+private:
+    FilterFunction filter_function_;
+};
+
+//! test whether all LOps of a function stack keep the DIAPartitioning of the
+//! DIANode, which currently holds only for Filter().
+template <typename Stack>
+struct StackKeepsPartitioning : public std::false_type { };
+
+template <typename Input>
+struct StackKeepsPartitioning<tlx::FunctionStack<Input> >
+    : public std::true_type { };
+
+template <typename Input, typename FilterArgument, typename FilterFunction,
+          typename... Functors>
+struct StackKeepsPartitioning<
+    tlx::FunctionStack<Input, FilterLOp<FilterArgument, FilterFunction>,
+                       Functors...> >
+    : public StackKeepsPartitioning<tlx::FunctionStack<Input, Functors...> >{ };
+
 /*!
  * DIA is the interface between the user and the Thrill framework. A DIA can be
  * imagined as an immutable array, even though the data does not need to be
@@ -287,6 +345,14 @@ public:
     //! Returns label_
     const char * label() const { return label_; }
 
+    //! Returns how the items are distributed to the workers: that of the
+    //! DIANode, if the LOps of the stack keep it.
+    DIAPartitioning partitioning() const {
+        assert(IsValid());
+        return StackKeepsPartitioning<Stack>::value
+               ? node_->partitioning() : DIAPartitioning();
+    }
+
     //! \}
 
     /*!
@@ -338,6 +404,22 @@ public:
         return *this;
     }
 
+    /*!
+     * Write the execution plan of this DIA to os without executing anything:
+     * the stages which are run to compute its DIANode, each with the nodes it
+     * pushes into, and a description of each involved node (see
+     * Context::Explain()), followed by the LOps fused into this DIA's function
+     * stack. After execution, the nodes also show the number of items and
+     * bytes they pushed. This is a local operation.
+     */
+    const DIA& Explain(std::ostream& os = std::cout) const {
+        assert(IsValid());
+        node_->Explain(os);
+        if (!stack_empty)
+            os << "LOps: " << node_->context().ExplainLOpChain(dia_id_) << '\n';
+        return *this;
+    }
+
     //! \name Local Operations (LOps)
     //! \{
 
@@ -380,6 +462,7 @@ public:
             << "event" << "create"
             << "type" << "LOp"
             << "parents" << (common::Array<size_t>{ dia_id_ });
+        context().RegisterLOp(new_id, "Map", dia_id_);
 
         auto new_stack = stack_.push(conv_map_function);
         return DIA<MapResult, decltype(new_stack)>(
@@ -407,10 +490,8 @@ public:
 
         using FilterArgument
             = typename FunctionTraits<FilterFunction>::template arg_plain<0>;
-        auto conv_filter_function =
-            [filter_function](const FilterArgument& input, auto emit_func) {
-                if (filter_function(input)) emit_func(input);
-            };
+        FilterLOp<FilterArgument, FilterFunction> conv_filter_function(
+            filter_function);
 
         static_assert(
             std::is_convertible<ValueType, FilterArgument>::value,
@@ -425,6 +506,7 @@ public:
             << "event" << "create"
             << "type" << "LOp"
             << "parents" << (common::Array<size_t>{ dia_id_ });
+        context().RegisterLOp(new_id, "Filter", dia_id_);
 
         auto new_stack = stack_.push(conv_filter_function);
         return DIA<ValueType, decltype(new_stack)>(
@@ -467,6 +549,7 @@ public:
             << "event" << "create"
             << "type" << "LOp"
             << "parents" << (common::Array<size_t>{ dia_id_ });
+        context().RegisterLOp(new_id, "FlatMap", dia_id_);
 
         auto new_stack = stack_.push(flatmap_function);
         return DIA<ResultType, decltype(new_stack)>(
@@ -507,6 +590,14 @@ public:
      */
     size_t Size() const;
 
+    /*!
+     * Computes the number of distinct keys of all elements, see Distinct().
+     *
+     * \ingroup dia_actions
+     */
+    template <typename KeyExtractor>
+    size_t CountDistinct(const KeyExtractor& key_extractor) const;
+
     /*!
      * Lazily computes the total size of all elements across all workers.
      *
@@ -545,6 +636,16 @@ public:
      */
     Future<std::vector<ValueType> > AllGatherFuture() const;
 
+    /*!
+     * Returns the whole DIA in a read-only std::vector, which is constructed
+     * only once per host and shared by all its workers, e.g. as lookup table
+     * for a broadcast join in a following Map(). The memory needed hence does
+     * not grow with the number of workers per host.
+     *
+     * \ingroup dia_actions
+     */
+    std::shared_ptr<const std::vector<ValueType> > AllGatherShared() const;
+
     /*!
      * Print is an Action, which collects all data of the DIA at the worker 0
      * and prints using ostream serialization. It is implemented using Gather().
@@ -585,6 +686,33 @@ public:
      */
     auto Sample(size_t sample_size) const;
 
+    /*!
+     * WeightedSample is a DOp, which selects up to sample_size items randomly
+     * without replacement, where items are drawn with probability proportional
+     * to weight_function(item) (Algorithm A-ExpJ). Items with weight <= 0 are
+     * never selected. The sample is determined by local reservoirs and one
+     * AllReduce, and the items stay on their workers.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename WeightFunction>
+    auto WeightedSample(size_t sample_size,
+                        const WeightFunction& weight_function) const;
+
+    /*!
+     * StratifiedSample is a DOp, which selects up to sample_size items
+     * uniformly at random without replacement for each key returned by
+     * key_extractor. Keys must be comparable by operator <. The samples are
+     * determined by local reservoirs and one AllReduce, and the items stay on
+     * their workers, hence the number of keys times sample_size must fit into
+     * RAM.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor>
+    auto StratifiedSample(const KeyExtractor& key_extractor,
+                          size_t sample_size) const;
+
     /*!
      * AllReduce is an Action, which computes the reduction sum of all elements
      * globally and delivers the same value on all workers.
@@ -689,6 +817,42 @@ public:
         const SumFunction& sum_function = SumFunction(),
         const ValueType& initial_value = ValueType()) const;
 
+    /*!
+     * SizeApprox is an Action, which estimates the total number of elements
+     * from a Bernoulli sample with rate p. Non-sampled items are skipped
+     * directly after they leave the preceding LOps. Returns the scaled estimate
+     * and its confidence interval at the given confidence level.
+     *
+     * \ingroup dia_actions
+     */
+    ApproxResult SizeApprox(double p, double confidence = 0.95) const;
+
+    /*!
+     * SumApprox is an Action, which estimates the sum of value_function(item)
+     * of all elements from a Bernoulli sample with rate p. Returns the scaled
+     * estimate and its confidence interval at the given confidence level.
+     *
+     * \ingroup dia_actions
+     */
+    template <typename ValueFunction = common::Identity>
+    ApproxResult SumApprox(
+        double p, double confidence = 0.95,
+        const ValueFunction& value_function = ValueFunction()) const;
+
+    /*!
+     * SumByKeyApprox is a DOp, which estimates the sum of value_function(item)
+     * per key from a Bernoulli sample with rate p. Only the sampled items are
+     * reduced. Returns a DIA of std::pair<Key, ApproxResult>. Keys which were
+     * not sampled are missing, and intervals of keys with few samples are
+     * unreliable.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor, typename ValueFunction>
+    auto SumByKeyApprox(double p, const KeyExtractor& key_extractor,
+                        const ValueFunction& value_function,
+                        double confidence = 0.95) const;
+
     /*!
      * Min is an Action, which computes the minimum of all elements globally.
      *
@@ -782,6 +946,29 @@ public:
     template <size_t p>
     double HyperLogLog() const;
 
+    /*!
+     * ApproxQuantiles is an Action, which computes approximate quantiles of the
+     * DIA without sorting it. Each worker inserts its items into a KLL sketch
+     * of sketch_size items, and the sketches are merged using AllReduce. The
+     * rank error of the returned items is about 1.7 / sketch_size.
+     *
+     * \param phis Quantiles to compute, each in [0,1], e.g. 0.5 for the median.
+     *
+     * \param sketch_size Capacity of the top level of the KLL sketch.
+     *
+     * \param compare_function Function comparing two items.
+     *
+     * 
+eturns One item for each quantile in phis, or ValueType() if the DIA is
+     * empty.
+     *
+     * \ingroup dia_actions
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    std::vector<ValueType> ApproxQuantiles(
+        const std::vector<double>& phis, size_t sketch_size = 200,
+        const CompareFunction& compare_function = CompareFunction()) const;
+
     /*!
      * WriteLinesOne is an Action, which writes std::strings to a single output
      * file.
@@ -859,10 +1046,14 @@ public:
      *
      * \param max_file_size size limit of individual file.
      *
+     * \param block_index append an index of the Blocks to each file, with
+     * which ReadBinary splits files of variable-size items without scanning.
+     *
      * \ingroup dia_actions
      */
     void WriteBinary(const std::string& filepath,
-                     size_t max_file_size = 128* 1024* 1024) const;
+                     size_t max_file_size = 128* 1024* 1024,
+                     bool block_index = false) const;
 
     /*!
      * WriteBinary is a function, which writes a DIA to many files per
@@ -879,11 +1070,94 @@ public:
      *
      * \param max_file_size size limit of individual file.
      *
+     * \param block_index append an index of the Blocks to each file, with
+     * which ReadBinary splits files of variable-size items without scanning.
+     *
      * \ingroup dia_actions
      */
     Future<void> WriteBinaryFuture(
         const std::string& filepath,
-        size_t max_file_size = 128* 1024* 1024) const;
+        size_t max_file_size = 128* 1024* 1024,
+        bool block_index = false) const;
+
+    /*!
+     * WriteColumnar is a function, which writes a DIA of std::tuple items
+     * column-wise into one file per worker. Rows are grouped into row groups
+     * and each column chunk is stored with its minimum and maximum value, such
+     * that ReadColumnar can read only some columns and skip row groups.
+     *
+     * \param filepath Destination of the output file. `"$$$$$"` is replaced by
+     * the worker id, see WriteBinary.
+     *
+     * \param row_group_size number of rows in a row group.
+     *
+     * \ingroup dia_actions
+     */
+    void WriteColumnar(const std::string& filepath,
+                       size_t row_group_size = 1024* 1024) const;
+
+    /*!
+     * WriteColumnar is a function, which writes a DIA of std::tuple items
+     * column-wise into one file per worker. Rows are grouped into row groups
+     * and each column chunk is stored with its minimum and maximum value, such
+     * that ReadColumnar can read only some columns and skip row groups.
+     *
+     * \param filepath Destination of the output file. `"$$$$$"` is replaced by
+     * the worker id, see WriteBinary.
+     *
+     * \param row_group_size number of rows in a row group.
+     *
+     * \ingroup dia_actions
+     */
+    Future<void> WriteColumnarFuture(
+        const std::string& filepath,
+        size_t row_group_size = 1024* 1024) const;
+
+    /*!
+     * WriteArrowStream is a function, which writes a DIA of std::tuple items
+     * as an Apache Arrow IPC stream into one file per worker, which Arrow
+     * libraries read without parsing, e.g. pyarrow.ipc.open_stream(). The rows
+     * are written column-wise in record batches. The file may be a named pipe
+     * to a consuming process, or lie in shared memory, e.g. /dev/shm.
+     *
+     * \param filepath Destination of the output file. `"$$$$$"` is replaced by
+     * the worker id, see WriteBinary.
+     *
+     * \param column_names names of the columns in the schema, by default
+     * `"f0"`, `"f1"`, etc.
+     *
+     * \param batch_size number of rows in a record batch.
+     *
+     * \ingroup dia_actions
+     */
+    void WriteArrowStream(
+        const std::string& filepath,
+        const std::vector<std::string>& column_names =
+            std::vector<std::string>(),
+        size_t batch_size = 64* 1024) const;
+
+    /*!
+     * WriteArrowStream is a function, which writes a DIA of std::tuple items
+     * as an Apache Arrow IPC stream into one file per worker, which Arrow
+     * libraries read without parsing, e.g. pyarrow.ipc.open_stream(). The rows
+     * are written column-wise in record batches. The file may be a named pipe
+     * to a consuming process, or lie in shared memory, e.g. /dev/shm.
+     *
+     * \param filepath Destination of the output file. `"$$$$$"` is replaced by
+     * the worker id, see WriteBinary.
+     *
+     * \param column_names names of the columns in the schema, by default
+     * `"f0"`, `"f1"`, etc.
+     *
+     * \param batch_size number of rows in a record batch.
+     *
+     * \ingroup dia_actions
+     */
+    Future<void> WriteArrowStreamFuture(
+        const std::string& filepath,
+        const std::vector<std::string>& column_names =
+            std::vector<std::string>(),
+        size_t batch_size = 64* 1024) const;
 
     //! \}
 
@@ -1477,7 +1751,8 @@ public:
      *
      * \param groupby_function Reduce function, which defines how the key
      * buckets are grouped and processed.
-     *      input param: api::GroupByReader with functions HasNext() and Next()
+     *      input param: api::GroupByReader with functions HasNext() and Next(),
+     *      and ReadGroup() returning all items of the group in a reused vector
      *
      * \ingroup dia_dops
      */
@@ -1514,7 +1789,8 @@ public:
      *
      * \param groupby_function Reduce function, which defines how the key
      * buckets are grouped and processed.
-     *      input param: api::GroupByReader with functions HasNext() and Next()
+     *      input param: api::GroupByReader with functions HasNext() and Next(),
+     *      and ReadGroup() returning all items of the group in a reused vector
      *
      * \param hash_function Hash method for Keys
      *
@@ -1554,21 +1830,25 @@ public:
      *
      * \param groupby_function Reduce function, which defines how the key
      * buckets are grouped and processed.
-     *      input param: api::GroupByReader with functions HasNext() and Next()
+     *      input param: api::GroupByReader with functions HasNext() and Next(),
+     *      and ReadGroup() returning all items of the group in a reused vector
      *
      * \param hash_function Hash method for Keys
      *
+     * \param groupby_config GroupBy configuration, e.g. of the local grouping.
+     *
      * \ingroup dia_dops
      */
     template <typename ValueOut, bool LocationDetectionTagValue,
               typename KeyExtractor, typename GroupByFunction,
               typename HashFunction =
-                  std::hash<typename FunctionTraits<KeyExtractor>::result_type>
-              >
+                  std::hash<typename FunctionTraits<KeyExtractor>::result_type>,
+              typename GroupByConfig = class DefaultGroupByConfig>
     auto GroupByKey(const LocationDetectionFlag<LocationDetectionTagValue>&,
                     const KeyExtractor& key_extractor,
                     const GroupByFunction& groupby_function,
-                    const HashFunction& hash_function = HashFunction()) const;
+                    const HashFunction& hash_function = HashFunction(),
+                    const GroupByConfig& groupby_config = GroupByConfig()) const;
 
     /*!
      * GroupBy is a DOp, which groups elements of the DIA by its key.
@@ -1600,7 +1880,8 @@ public:
      *
      * \param groupby_function Reduce function, which defines how the key
      * buckets are grouped and processed.
-     *      input param: api::GroupByReader with functions HasNext() and Next()
+     *      input param: api::GroupByReader with functions HasNext() and Next(),
+     *      and ReadGroup() returning all items of the group in a reused vector
      *
      * \param size Resulting DIA size. Consequently, the key_extractor function
      * but always return < size for any element in the input DIA.
@@ -1617,6 +1898,59 @@ public:
                       const size_t size,
                       const ValueOut& neutral_element = ValueOut()) const;
 
+    /*!
+     * GroupByAccumulate is a DOp, which groups elements of the DIA by its key
+     * like GroupByKey, but folds the elements of each key incrementally into
+     * the state of an accumulator, instead of materializing all elements of a
+     * key. It is implemented using ReducePair, hence the states are already
+     * merged in the pre-phase, and the memory is O(#keys * state size).
+     *
+     * The Accumulator must provide a type State, which is serializable, and
+     * the methods
+     *   State Init(const Key& key) const;
+     *   void Add(State& state, const ValueType& value) const;
+     *   void Merge(State& state, const State& other) const;
+     *   ValueOut Finish(const Key& key, const State& state) const;
+     * Add() and Merge() must be associative and commutative in effect, since
+     * the elements of a key are folded in any order.
+     *
+     * \param key_extractor Key extractor function, which maps each element to a
+     * key of possibly different type.
+     *
+     * \param accumulator Accumulator with the methods above.
+     *
+     * \param reduce_config Reduce configuration of the ReducePair.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor, typename Accumulator,
+              typename ReduceConfig = class DefaultReduceConfig>
+    auto GroupByAccumulate(
+        const KeyExtractor& key_extractor,
+        const Accumulator& accumulator,
+        const ReduceConfig& reduce_config = ReduceConfig()) const;
+
+    /*!
+     * HyperLogLogByKey is a DOp, which approximately counts the distinct
+     * elements of each key. It groups the elements by key using ReducePair and
+     * returns a DIA of std::pair<Key, core::HyperLogLogRegisters<p> >, whose
+     * registers can be merged further or estimated using result().
+     *
+     * 	param p Number of bits to use for index. Should be between 4 and 13.
+     *
+     * \param key_extractor Key extractor function, which maps each element to a
+     * key of possibly different type.
+     *
+     * \param reduce_config Reduce configuration of the ReducePair.
+     *
+     * \ingroup dia_dops
+     */
+    template <size_t p, typename KeyExtractor,
+              typename ReduceConfig = class DefaultReduceConfig>
+    auto HyperLogLogByKey(
+        const KeyExtractor& key_extractor,
+        const ReduceConfig& reduce_config = ReduceConfig()) const;
+
     /*!
      * Zips two DIAs of equal size in style of functional programming by
      * applying zip_function to the i-th elements of both input DIAs to form the
@@ -1768,11 +2102,15 @@ public:
      * \param sort_algorithm Algorithm class used to sort items. Merging is
      * always done using a tournament tree with compare_function.
      *
+     * \param sort_config Optional methods of the sort, see DefaultSortConfig.
+     *
      * \ingroup dia_dops
      */
-    template <typename CompareFunction, typename SortAlgorithm>
+    template <typename CompareFunction, typename SortAlgorithm,
+              typename SortConfig = class DefaultSortConfig>
     auto Sort(const CompareFunction& compare_function,
-              const SortAlgorithm& sort_algorithm) const;
+              const SortAlgorithm& sort_algorithm,
+              const SortConfig& sort_config = SortConfig()) const;
 
     /*!
      * SortStable is a DOp, which sorts a given DIA stably according to the
@@ -1807,11 +2145,88 @@ public:
      * is always done using a tournament tree with compare_function. In order
      * for the sorting to be stable, this must be a stable sorting algorithm.
      *
+     * \param sort_config Optional methods of the sort, see DefaultSortConfig.
+     *
      * \ingroup dia_dops
      */
-    template <typename CompareFunction, typename SortAlgorithm>
+    template <typename CompareFunction, typename SortAlgorithm,
+              typename SortConfig = class DefaultSortConfig>
     auto SortStable(const CompareFunction& compare_function,
-                    const SortAlgorithm& sort_algorithm) const;
+                    const SortAlgorithm& sort_algorithm,
+                    const SortConfig& sort_config = SortConfig()) const;
+
+    /*!
+     * SortBy is a DOp, which sorts a given DIA by the keys extracted from its
+     * items. Each key is extracted only once and carried along with its item
+     * in the sort and the merge, which pays off for keys which are expensive
+     * to extract, e.g. if they are parsed from string records.
+     *
+     * \tparam KeyExtractor Type of the key_extractor function.
+     *  Should be (ValueType)->Key
+     *
+     * \tparam CompareFunction Type of the compare_function.
+     *  Should be (Key,Key)->bool
+     *
+     * \param key_extractor Function, which extracts the key of an item.
+     *
+     * \param compare_function Function, which compares two keys. Returns
+     * true, if first key is smaller than second. False otherwise.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor,
+              typename CompareFunction =
+                  std::less<typename FunctionTraits<KeyExtractor>::result_type> >
+    auto SortBy(const KeyExtractor& key_extractor,
+                const CompareFunction& compare_function =
+                    CompareFunction()) const;
+
+    /*!
+     * SortByKey is a DOp, which sorts a given DIA stably by the keys
+     * extracted from its items. Only (key, index) pairs are sorted globally,
+     * and the items are sent once to their destination, hence it is faster
+     * than Sort() for items much larger than their keys.
+     *
+     * \tparam KeyExtractor Type of the key_extractor function.
+     *  Should be (ValueType)->Key
+     *
+     * \tparam CompareFunction Type of the compare_function.
+     *  Should be (Key,Key)->bool
+     *
+     * \param key_extractor Function, which extracts the key of an item.
+     *
+     * \param compare_function Function, which compares two keys. Returns
+     * true, if first key is smaller than second. False otherwise.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor,
+              typename CompareFunction =
+                  std::less<typename FunctionTraits<KeyExtractor>::result_type> >
+    auto SortByKey(const KeyExtractor& key_extractor,
+                   const CompareFunction& compare_function =
+                       CompareFunction()) const;
+
+    /*!
+     * TopK is a DOp, which selects the k smallest items of the DIA according
+     * to the given compare_function, without sorting the whole DIA. Each
+     * worker keeps only its k smallest items, and only candidates which can be
+     * among the global k smallest are communicated. The result is sorted and
+     * located on worker 0.
+     *
+     * \tparam CompareFunction Type of the compare_function.
+     *  Should be (ValueType,ValueType)->bool
+     *
+     * \param k Number of items to select.
+     *
+     * \param compare_function Function, which compares two elements. Returns
+     * true, if first element is smaller than second. False otherwise.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    auto TopK(size_t k,
+              const CompareFunction& compare_function = CompareFunction()) const;
 
     /*!
      * Merge is a DOp, which merges two sorted DIAs to a single sorted DIA.
@@ -1833,6 +2248,30 @@ public:
     auto Merge(const SecondDIA& second_dia,
                const Comparator& comparator = Comparator()) const;
 
+    /*!
+     * MergeJoin is a DOp, which performs an inner join of this DIA and
+     * second_dia, which must both be sorted globally by their keys, e.g. by
+     * Sort() or Merge(). All pairs of items with equal keys are joined with
+     * the join function. Only items of keys spanning workers are moved, and
+     * the join is a streaming merge without hashing or sorting.
+     *
+     * \param second_dia DIA, which is joined with this DIA.
+     *
+     * \param key_extractor1 Key extractor for this DIA
+     *
+     * \param key_extractor2 Key extractor for second DIA
+     *
+     * \param join_function Join function applied to all equal key pairs
+     *
+     * \ingroup dia_dops
+     */
+    template <typename SecondDIA, typename KeyExtractor1,
+              typename KeyExtractor2, typename JoinFunction>
+    auto MergeJoin(const SecondDIA& second_dia,
+                   const KeyExtractor1& key_extractor1,
+                   const KeyExtractor2& key_extractor2,
+                   const JoinFunction& join_function) const;
+
     /*!
      * PrefixSum is a DOp, which computes the (inclusive) prefix sum of all
      * elements. The sum function defines how two elements are combined to a
@@ -1867,6 +2306,46 @@ public:
     auto ExPrefixSum(const SumFunction& sum_function = SumFunction(),
                      const ValueType& initial_element = ValueType()) const;
 
+    /*!
+     * SegmentedPrefixSum is a DOp, which computes the (inclusive) prefix sum of
+     * all elements, restarting with initial_element wherever the key of
+     * consecutive elements changes. Segments may span workers.
+     *
+     * \param key_extractor Key extractor function, keys are compared with ==.
+     *
+     * \param sum_function Sum function (any associative function).
+     *
+     * \param initial_element Initial element of each segment.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor,
+              typename SumFunction = std::plus<ValueType> >
+    auto SegmentedPrefixSum(
+        const KeyExtractor& key_extractor,
+        const SumFunction& sum_function = SumFunction(),
+        const ValueType& initial_element = ValueType()) const;
+
+    /*!
+     * SegmentedExPrefixSum is a DOp, which computes the exclusive prefix sum
+     * of all elements, restarting with initial_element wherever the key of
+     * consecutive elements changes. Segments may span workers.
+     *
+     * \param key_extractor Key extractor function, keys are compared with ==.
+     *
+     * \param sum_function Sum function (any associative function).
+     *
+     * \param initial_element Initial element of each segment.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor,
+              typename SumFunction = std::plus<ValueType> >
+    auto SegmentedExPrefixSum(
+        const KeyExtractor& key_extractor,
+        const SumFunction& sum_function = SumFunction(),
+        const ValueType& initial_element = ValueType()) const;
+
     /*!
      * Window is a DOp, which applies a window function to every k
      * consecutive items in a DIA. The window function is also given the index
@@ -1922,6 +2401,22 @@ public:
     auto Window(struct DisjointTag const&, size_t window_size,
                 const WindowFunction& window_function) const;
 
+    /*!
+     * WindowReduce is a DOp, which reduces every k consecutive items in a DIA
+     * with an associative reduce function, e.g. to calculate sliding sums,
+     * minima or maxima. It outputs one item for each full window, in order of
+     * the windows' first items, and takes O(1) amortized time per item.
+     *
+     * \param window_size the size k >= 2 of the windows.
+     *
+     * \param reduce_function Associative function reducing two items.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename ReduceFunction>
+    auto WindowReduce(size_t window_size,
+                      const ReduceFunction& reduce_function) const;
+
     /*!
      * FlatWindow is a DOp, which applies a window function to every k
      * consecutive items in a DIA. The window function is also given the index
@@ -1992,6 +2487,20 @@ public:
     template <typename SecondDIA>
     auto Concat(const SecondDIA& second_dia) const;
 
+    /*!
+     * Concat is a DOp, which concatenates any number of DIAs to a single DIA.
+     * All input DIAs must contain the same type, which is also the output DIA's
+     * type.
+     *
+     * This variant balances the items without preserving their order: each
+     * worker keeps its items up to an equal share and only the surplus items
+     * are sent to workers below their share.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename SecondDIA>
+    auto Concat(struct UnorderedTag const&, const SecondDIA& second_dia) const;
+
     /*!
      * Rebalance is a DOp, which rebalances a single DIA among all workers; in
      * general, this operation is needed only if previous steps are known to
@@ -2001,6 +2510,132 @@ public:
      */
     auto Rebalance() const;
 
+    /*!
+     * Repartition is a DOp, which sends each item to the worker returned by
+     * the partitioner, a function ValueType -> size_t in [0, num_workers). The
+     * items are streamed to their workers without storing them locally first.
+     *
+     * \param partitioner Function selecting the worker of an item.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename Partitioner>
+    auto Repartition(const Partitioner& partitioner) const;
+
+    /*!
+     * MapPartitions is a DOp, which calls the partition_function once on each
+     * worker with all its items, without any exchange. The function is called
+     * as partition_function(reader, emit), where reader has HasNext(), Next()
+     * and size() and reads the items directly from the node's data::File, and
+     * emit(ValueOut) outputs items.
+     *
+     * \tparam ValueOut Type of the output items.
+     *
+     * \param partition_function Function processing all items of a worker.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename ValueOut = ValueType, typename PartitionFunction>
+    auto MapPartitions(const PartitionFunction& partition_function) const;
+
+    /*!
+     * ReduceLocal is a DOp, which reduces all items of each worker to a single
+     * item with the reduce_function, without any exchange. The output DIA has
+     * one item on each worker which had items.
+     *
+     * \param reduce_function Reduce function, which must be associative.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename ReduceFunction>
+    auto ReduceLocal(const ReduceFunction& reduce_function) const;
+
+    /*!
+     * SemiJoin is a DOp, which outputs the items of this DIA whose key occurs
+     * among the keys of second_dia. Only keys are exchanged, the items of
+     * this DIA stay on their worker.
+     *
+     * \param second_dia DIA whose keys filter this DIA.
+     *
+     * \param key_extractor1 Key extractor for this DIA
+     *
+     * \param key_extractor2 Key extractor for second DIA
+     *
+     * \param hash_function Hash function of the key
+     *
+     * \param config Configuration, e.g. of the semi-join filter
+     *
+     * \ingroup dia_dops
+     */
+    template <typename SecondDIA, typename KeyExtractor1,
+              typename KeyExtractor2,
+              typename HashFunction =
+                  std::hash<typename FunctionTraits<KeyExtractor1>::result_type>,
+              typename SemiJoinConfig = class DefaultSemiJoinConfig>
+    auto SemiJoin(const SecondDIA& second_dia,
+                  const KeyExtractor1& key_extractor1,
+                  const KeyExtractor2& key_extractor2,
+                  const HashFunction& hash_function = HashFunction(),
+                  const SemiJoinConfig& config = SemiJoinConfig()) const;
+
+    /*!
+     * AntiJoin is a DOp, which outputs the items of this DIA whose key does
+     * not occur among the keys of second_dia, see SemiJoin().
+     *
+     * \ingroup dia_dops
+     */
+    template <typename SecondDIA, typename KeyExtractor1,
+              typename KeyExtractor2,
+              typename HashFunction =
+                  std::hash<typename FunctionTraits<KeyExtractor1>::result_type>,
+              typename SemiJoinConfig = class DefaultSemiJoinConfig>
+    auto AntiJoin(const SecondDIA& second_dia,
+                  const KeyExtractor1& key_extractor1,
+                  const KeyExtractor2& key_extractor2,
+                  const HashFunction& hash_function = HashFunction(),
+                  const SemiJoinConfig& config = SemiJoinConfig()) const;
+
+    /*!
+     * Distinct is a DOp, which outputs one item of each key. Items are first
+     * deduplicated locally, then core::DuplicateDetection finds the keys
+     * which occur on only one worker, whose items are output there. Only the
+     * items of the other keys are hash partitioned, which saves most of the
+     * communication for mostly unique keys.
+     *
+     * \param key_extractor Key extractor function, see ReduceByKey().
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor>
+    auto Distinct(const KeyExtractor& key_extractor) const;
+
+    /*!
+     * Distinct is a DOp, which outputs each distinct item once, see
+     * Distinct(key_extractor).
+     *
+     * \ingroup dia_dops
+     */
+    auto Distinct() const;
+
+    /*!
+     * RepartitionByKey is a DOp, which sends each item to the worker selected
+     * by the hash of its key. The result is marked as partitioned by the key
+     * extractor, hence following ReduceByKey() and GroupByKey() with the same
+     * key extractor object work locally without exchanging the items again.
+     *
+     * \param key_extractor Key extractor function, see ReduceByKey().
+     *
+     * \param hash_function Hash function of the key.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor,
+              typename HashFunction =
+                  std::hash<typename FunctionTraits<KeyExtractor>::result_type> >
+    auto RepartitionByKey(
+        const KeyExtractor& key_extractor,
+        const HashFunction& hash_function = HashFunction()) const;
+
     /*!
      * Create a CollapseNode which is mainly used to collapse the LOp chain into
      * a DIA<T> with an empty stack. This is most often necessary for iterative
@@ -2020,6 +2655,38 @@ public:
      */
     DIA<ValueType> Cache() const;
 
+    /*!
+     * Create a CacheNode as Cache(), which keeps the Blocks of items compressed
+     * with the codec given in options, such that more cached DIAs fit into
+     * RAM. The items are decompressed on each PushData(), a Block at a time.
+     *
+     * \ingroup dia_dops
+     */
+    DIA<ValueType> Cache(const CacheOptions& options) const;
+
+    /*!
+     * Persist materializes the DIA with WriteBinary into files in directory
+     * path, and returns a ReadBinary DIA of these files. The file names
+     * contain a fingerprint of the DIA's lineage: the labels of all nodes
+     * leading to this DIA and their source inputs, e.g. paths, sizes, and
+     * modification times of the files read by ReadLines or ReadBinary. If a
+     * later run finds completely written files with the same fingerprint, the
+     * lineage is not recomputed, and the files are read instead.
+     *
+     * The fingerprint does not cover the user functions, hence change version
+     * whenever the code computing the DIA changes. Files of outdated
+     * fingerprints are not removed.
+     *
+     * \param path Directory for the materialized files, which must be
+     * accessible to all workers.
+     *
+     * \param version User-defined version included in the fingerprint.
+     *
+     * \ingroup dia_dops
+     */
+    DIA<ValueType> Persist(const std::string& path,
+                           const std::string& version = std::string()) const;
+
     //! \}
 
 private:
@@ -2048,6 +2715,9 @@ private:
 //! imported from api namespace
 using api::DIA;
 
+//! imported from api namespace
+using api::CacheOptions;
+
 //! imported from api namespace
 using api::DisjointTag;
 
@@ -2072,6 +2742,9 @@ using api::PadTag;
 //! imported from api namespace
 using api::NoRebalanceTag;
 
+//! imported from api namespace
+using api::UnorderedTag;
+
 //! imported from api namespace
 using api::DuplicateDetectionFlag;
 
@@ -10,18 +10,27 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
+#include <thrill/api/action_node.hpp>
 #include <thrill/api/dia_base.hpp>
 #include <thrill/common/json_logger.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/metrics_server.hpp>
+#include <thrill/common/perf_counters.hpp>
+#include <thrill/common/sharded_counter.hpp>
+#include <thrill/common/stack_sampler.hpp>
 #include <thrill/common/stats_timer.hpp>
+#include <thrill/common/wait_stats.hpp>
 #include <thrill/mem/allocator.hpp>
+#include <thrill/mem/malloc_tracker.hpp>
 
 #include <algorithm>
 #include <chrono>
 #include <deque>
 #include <functional>
 #include <iomanip>
+#include <ostream>
 #include <set>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -32,6 +41,47 @@ namespace api {
 /******************************************************************************/
 // DIABase StageBuilder
 
+/*!
+ * Snapshot of the worker thread's wait times and the host's external memory
+ * volume at the start of a stage. The differences are logged with the stage's
+ * done event, from which json2profile finds the stragglers of each stage.
+ */
+class StageWaitStats
+{
+public:
+    explicit StageWaitStats(data::BlockPool& block_pool)
+        : block_pool_(block_pool),
+          begin_(common::ThreadWaitStats::Local()),
+          spill_write_(block_pool.total_spill_write_bytes()),
+          spill_read_(block_pool.total_spill_read_bytes()) { }
+
+    //! seconds waited for stream Blocks since the snapshot
+    double wait_net() const {
+        return (common::ThreadWaitStats::Local().net_ns - begin_.net_ns) / 1e9;
+    }
+
+    //! seconds spent in collectives since the snapshot
+    double wait_collective() const {
+        return (common::ThreadWaitStats::Local().collective_ns
+                - begin_.collective_ns) / 1e9;
+    }
+
+    //! bytes written to external memory by the host since the snapshot
+    size_t spill_write_bytes() const {
+        return block_pool_.total_spill_write_bytes() - spill_write_;
+    }
+
+    //! bytes read from external memory by the host since the snapshot
+    size_t spill_read_bytes() const {
+        return block_pool_.total_spill_read_bytes() - spill_read_;
+    }
+
+private:
+    data::BlockPool& block_pool_;
+    common::ThreadWaitStats begin_;
+    size_t spill_write_, spill_read_;
+};
+
 class Stage
 {
 public:
@@ -118,6 +168,54 @@ public:
         return children;
     }
 
+    /*!
+     * Tag of the malloc tracker for memory attribution: one per local worker,
+     * since the workers of a host execute the same stages concurrently. The
+     * tag is reset at the start of each Execute() and PushData(), hence its
+     * current and peak values are the net memory allocated by the stage.
+     * PushData() includes the PreOps of the targets.
+     */
+    size_t MallocTag() const {
+        return 1 + context_.local_worker_id() % (mem::kMallocTagCount - 1);
+    }
+
+    //! number of references RunScope() holds to each node while running the
+    //! stages: one in the stage set and one in the topological order.
+    static constexpr size_t kBuilderRefs = 2;
+
+    /*!
+     * Liveness check before PushData(): returns true if the node is only
+     * referenced by the StageBuilder (this Stage in RunScope()'s stage set and
+     * topological order) and by the parent lists of its children, but no DIA
+     * handle. Then no further child can be attached, and the data can be
+     * released while it is pushed. Children which forward data (Collapse,
+     * Union) may still get new children, hence they disable the check.
+     */
+    bool Unreferenced() const {
+        size_t internal_refs = kBuilderRefs;
+        for (DIABase* child : node_->children()) {
+            if (child->ForwardDataOnly()) return false;
+            for (const DIABasePtr& p : child->parents()) {
+                if (p.get() == node_.get()) ++internal_refs;
+            }
+        }
+        return node_->reference_count() == internal_refs;
+    }
+
+    //! publish the stage the worker is executing to the live metrics server
+    void SetMetricsStage(const char* event) {
+        if (common::MetricsServer* metrics = context_.metrics_server()) {
+            metrics->SetWorkerStage(context_.my_rank(), node_->dia_id(),
+                                    node_->label(), event);
+        }
+    }
+
+    //! mark the worker as idle on the live metrics server
+    void ClearMetricsStage() {
+        if (common::MetricsServer* metrics = context_.metrics_server())
+            metrics->SetWorkerStage(context_.my_rank(), 0, std::string(), "idle");
+    }
+
     void Execute() {
         sLOG << "START  (EXECUTE) stage" << *node_ << "targets" << TargetsString();
 
@@ -130,6 +228,7 @@ public:
 
         logger_ << "class" << "StageBuilder" << "event" << "execute-start"
                 << "targets" << target_ids;
+        SetMetricsStage("execute");
 
         DIAMemUse mem_use = node_->ExecuteMemUse();
         if (mem_use.is_max())
@@ -139,8 +238,18 @@ public:
         // old: acquire memory from BlockPool -tb
         // data::BlockPoolMemoryHolder mem_holder(context_.block_pool(), mem_use);
 
+        const size_t tag = MallocTag();
+        mem::malloc_tracker_reset_tag(tag);
+
+        StageWaitStats wait_stats(context_.block_pool());
         common::StatsTimerStart timer;
         try {
+            mem::MallocTagScope tag_scope(tag);
+            common::PerfCounterScope perf_scope(node_->dia_id());
+            common::StackSamplerScope sample_scope(
+                node_->dia_id(), node_->label());
+            common::ScopedTscTimer op_time(
+                node_->op_timer("thrill_op_execute_seconds"));
             node_->Execute();
         }
         catch (std::exception& e) {
@@ -150,12 +259,20 @@ public:
         }
         node_->set_state(DIAState::EXECUTED);
         timer.Stop();
+        context_.ResetStageArena();
 
         sLOG << "FINISH (EXECUTE) stage" << *node_ << "targets" << TargetsString()
              << "took" << timer << "ms";
 
         logger_ << "class" << "StageBuilder" << "event" << "execute-done"
-                << "targets" << target_ids << "elapsed" << timer;
+                << "targets" << target_ids << "elapsed" << timer
+                << "mem_current" << mem::malloc_tracker_tag_current(tag)
+                << "mem_peak" << mem::malloc_tracker_tag_peak(tag)
+                << "wait_net" << wait_stats.wait_net()
+                << "wait_collective" << wait_stats.wait_collective()
+                << "spill_write_bytes" << wait_stats.spill_write_bytes()
+                << "spill_read_bytes" << wait_stats.spill_read_bytes();
+        ClearMetricsStage();
 
         LOG << "DIA bytes: " << node_->context().block_pool().total_bytes();
     }
@@ -180,6 +297,7 @@ public:
 
         logger_ << "class" << "StageBuilder" << "event" << "pushdata-start"
                 << "targets" << target_ids;
+        SetMetricsStage("pushdata");
 
         // collect memory requests of source node and all targeted children
 
@@ -187,6 +305,7 @@ public:
 
         const size_t mem_limit = context_.mem_limit();
         std::vector<DIABase*> max_mem_nodes;
+        std::vector<size_t> max_mem_weights;
         size_t const_mem = 0;
 
         {
@@ -194,6 +313,7 @@ public:
             DIAMemUse m = node_->PushDataMemUse();
             if (m.is_max()) {
                 max_mem_nodes.emplace_back(node_.get());
+                max_mem_weights.emplace_back(m.weight());
             }
             else {
                 const_mem += m.limit();
@@ -206,6 +326,7 @@ public:
                 DIAMemUse m = target->PreOpMemUse();
                 if (m.is_max()) {
                     max_mem_nodes.emplace_back(target);
+                    max_mem_weights.emplace_back(m.weight());
                 }
                 else {
                     const_mem += m.limit();
@@ -221,11 +342,11 @@ public:
             abort();
         }
 
-        // distribute remaining memory to nodes requesting maximum RAM amount
+        // distribute remaining memory to nodes requesting maximum RAM amount,
+        // in proportion to their weights.
 
         if (!max_mem_nodes.empty()) {
             size_t remaining_mem = mem_limit - const_mem;
-            remaining_mem /= max_mem_nodes.size();
 
             if (context_.my_rank() == 0) {
                 LOG << "StageBuilder: distribute remaining worker memory "
@@ -233,8 +354,10 @@ public:
                     << max_mem_nodes.size() << " DIANodes";
             }
 
-            for (DIABase* target : max_mem_nodes) {
-                target->set_mem_limit(remaining_mem);
+            std::vector<size_t> shares =
+                DistributeMaxMemUse(remaining_mem, max_mem_weights);
+            for (size_t i = 0; i < max_mem_nodes.size(); ++i) {
+                max_mem_nodes[i]->set_mem_limit(shares[i]);
             }
 
             // update const_mem: later allocate the mem limit of this worker
@@ -247,8 +370,24 @@ public:
         // old: acquire memory from BlockPool
         // data::BlockPoolMemoryHolder mem_holder(context_.block_pool(), const_mem);
 
+        node_->set_unreferenced(Unreferenced());
+        if (node_->unreferenced()) {
+            sLOG << "StageBuilder: no references remain to" << *node_
+                 << "- consume during PushData()";
+        }
+
+        const size_t tag = MallocTag();
+        mem::malloc_tracker_reset_tag(tag);
+
+        StageWaitStats wait_stats(context_.block_pool());
         common::StatsTimerStart timer;
         try {
+            mem::MallocTagScope tag_scope(tag);
+            common::PerfCounterScope perf_scope(node_->dia_id());
+            common::StackSamplerScope sample_scope(
+                node_->dia_id(), node_->label());
+            common::ScopedTscTimer op_time(
+                node_->op_timer("thrill_op_pushdata_seconds"));
             node_->RunPushData();
         }
         catch (std::exception& e) {
@@ -259,12 +398,20 @@ public:
         }
         node_->RemoveAllChildren();
         timer.Stop();
+        context_.ResetStageArena();
 
         sLOG << "FINISH (PUSHDATA) stage" << *node_ << "targets" << TargetsString()
              << "took" << timer << "ms";
 
         logger_ << "class" << "StageBuilder" << "event" << "pushdata-done"
-                << "targets" << target_ids << "elapsed" << timer;
+                << "targets" << target_ids << "elapsed" << timer
+                << "mem_current" << mem::malloc_tracker_tag_current(tag)
+                << "mem_peak" << mem::malloc_tracker_tag_peak(tag)
+                << "wait_net" << wait_stats.wait_net()
+                << "wait_collective" << wait_stats.wait_collective()
+                << "spill_write_bytes" << wait_stats.spill_write_bytes()
+                << "spill_read_bytes" << wait_stats.spill_read_bytes();
+        ClearMetricsStage();
 
         LOG << "DIA bytes: " << node_->context().block_pool().total_bytes();
     }
@@ -378,7 +525,7 @@ static void TopoSortStages(mm_set<Stage>* stages, mem::vector<Stage>* result) {
     }
 }
 
-void DIABase::RunScope() {
+void DIABase::RunScope(bool execute_this) {
     static constexpr bool debug = Stage::debug;
 
     LOG << "DIABase::Execute() this=" << *this;
@@ -412,6 +559,10 @@ void DIABase::RunScope() {
         }
     }
 
+    // every node is referenced once by stages and once by toporder, these are
+    // the Stage::kBuilderRefs which Stage::Unreferenced() discounts.
+    die_unequal(stages.size(), toporder.size());
+
     assert(toporder.front().node_.get() == this);
 
     while (!toporder.empty())
@@ -427,7 +578,8 @@ void DIABase::RunScope() {
             mem::malloc_tracker_print_status();
 
         if (s.node_->state() == DIAState::NEW) {
-            s.Execute();
+            if (s.node_.get() != this || execute_this)
+                s.Execute();
             if (s.node_.get() != this)
                 s.PushData();
         }
@@ -442,6 +594,35 @@ void DIABase::RunScope() {
     }
 }
 
+/******************************************************************************/
+// DIAMemUse
+
+std::vector<size_t> DistributeMaxMemUse(
+    size_t remaining_mem, const std::vector<size_t>& weights) {
+
+    size_t known_weight = 0, num_known = 0;
+    for (const size_t& w : weights) {
+        known_weight += w;
+        num_known += (w != 0);
+    }
+    size_t default_weight =
+        num_known == 0 ? 1 : std::max<size_t>(1, known_weight / num_known);
+
+    size_t total_weight = 0;
+    for (const size_t& w : weights)
+        total_weight += (w != 0 ? w : default_weight);
+
+    std::vector<size_t> shares;
+    shares.reserve(weights.size());
+    for (const size_t& w : weights) {
+        shares.push_back(static_cast<size_t>(
+                             static_cast<double>(remaining_mem)
+                             * static_cast<double>(w != 0 ? w : default_weight)
+                             / static_cast<double>(total_weight)));
+    }
+    return shares;
+}
+
 /******************************************************************************/
 // DIABase
 
@@ -450,6 +631,157 @@ std::ostream& operator << (std::ostream& os, const DIABase& d) {
     return os << d.label() << '.' << d.dia_id();
 }
 
+/******************************************************************************/
+// Explain
+
+static const char * DIAStateName(const DIAState& state) {
+    switch (state) {
+    case DIAState::NEW:
+        return "NEW";
+    case DIAState::EXECUTED:
+        return "EXECUTED";
+    case DIAState::DISPOSED:
+        return "DISPOSED";
+    }
+    return "?";
+}
+
+common::ShardedCounter& DIABase::op_counter(const char* metric) {
+    return context_.sharded_stats().counter(
+        std::string(metric) + "{op=\"" + label() + "\"}");
+}
+
+common::ShardedCounter& DIABase::op_timer(const char* metric) {
+    return context_.sharded_stats().timer(
+        std::string(metric) + "{op=\"" + label() + "\"}");
+}
+
+void DIABase::ExplainNode(std::ostream& os) const {
+    os << *this << " [" << DIAStateName(state_) << ']';
+
+    if (ForwardDataOnly()) {
+        os << " forwards data";
+    }
+    else if (dynamic_cast<const ActionNode*>(this) == nullptr) {
+        // consume status as used by RunPushData()
+        if (!context_.consume())
+            os << " kept";
+        else if (consume_counter() == kNeverConsume)
+            os << " kept forever";
+        else if (consume_counter() == 0)
+            os << " consumed";
+        else
+            os << " consumed after " << consume_counter() << " PushData()";
+    }
+    os << '\n';
+
+    for (const size_t& id : parent_dia_ids_)
+        os << "    parent: " << context_.ExplainLOpChain(id) << '\n';
+
+    std::vector<DIABase*> children = this->children();
+    if (!children.empty()) {
+        os << "    children:";
+        for (DIABase* child : children)
+            os << ' ' << *child;
+        os << '\n';
+    }
+
+    std::string items = ExplainItems();
+    if (!items.empty())
+        os << "    " << items << '\n';
+
+    std::string impl = ExplainImpl();
+    if (!impl.empty())
+        os << "    impl: " << impl << '\n';
+
+    if (partitioning_.type() != DIAPartitioning::Type::NONE)
+        os << "    partitioning: " << partitioning_.str() << '\n';
+}
+
+void DIABase::Explain(std::ostream& os) {
+    if (ForwardDataOnly()) {
+        // like RunScope(): the parents of Collapse and Union are computed
+        for (const DIABasePtr& p : parents_)
+            p->Explain(os);
+        ExplainNode(os);
+        return;
+    }
+
+    mm_set<Stage> stages {
+        mem::Allocator<Stage>(mem_manager())
+    };
+    mem::vector<Stage> toporder {
+        mem::Allocator<Stage>(mem_manager())
+    };
+    if (state_ != DIAState::EXECUTED) {
+        FindStages(context_, DIABasePtr(this), &stages);
+        TopoSortStages(&stages, &toporder);
+    }
+
+    // output stages in the order RunScope() runs them
+    os << "Plan of " << *this << ':' << '\n';
+    size_t num = 0;
+    for (auto s = toporder.rbegin(); s != toporder.rend(); ++s) {
+        const DIABasePtr& node = s->node_;
+        if (node->ForwardDataOnly()) continue;
+
+        const char* action =
+            node->state() == DIAState::NEW ?
+            (node.get() == this ? "Execute()" : "Execute(), PushData()") :
+            "PushData()";
+        os << "  stage " << ++num << ": " << *node << ' ' << action;
+        if (node.get() != this)
+            os << " -> " << s->TargetsString();
+        os << '\n';
+    }
+    if (num == 0)
+        os << "  nothing to run, " << *this << " was already executed\n";
+
+    os << "Nodes:\n";
+    if (toporder.empty()) {
+        os << "  ";
+        ExplainNode(os);
+    }
+    for (auto s = toporder.rbegin(); s != toporder.rend(); ++s) {
+        os << "  ";
+        s->node_->ExplainNode(os);
+    }
+}
+
+/******************************************************************************/
+// Context Explain
+
+std::string Context::ExplainLOpChain(size_t dia_id) const {
+    // follow the LOps up to the DIANode
+    std::vector<std::pair<const char*, size_t> > chain;
+    auto it = lops_.find(dia_id);
+    while (it != lops_.end()) {
+        chain.emplace_back(it->second.first, dia_id);
+        dia_id = it->second.second;
+        it = lops_.find(dia_id);
+    }
+
+    std::ostringstream oss;
+    auto node = dia_nodes_.find(dia_id);
+    if (node != dia_nodes_.end())
+        oss << *node->second;
+    else
+        oss << "(destroyed)." << dia_id;
+
+    for (auto lop = chain.rbegin(); lop != chain.rend(); ++lop)
+        oss << " -> " << lop->first << '.' << lop->second;
+    return oss.str();
+}
+
+void Context::Explain(std::ostream& os) const {
+    os << "DIANodes of worker " << my_rank()
+       << (consume_ ? ", consume mode" : "") << ":\n";
+    for (const std::pair<const size_t, DIABase*>& n : dia_nodes_) {
+        os << "  ";
+        n.second->ExplainNode(os);
+    }
+}
+
 } // namespace api
 } // namespace thrill
 
@@ -18,7 +18,10 @@
 
 #include <thrill/api/context.hpp>
 
+#include <ostream>
 #include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
 
 namespace thrill {
@@ -56,12 +59,22 @@ public:
         : limit_(limit) { }
 
     //! Maximum available RAM requested (limit will be determined in
-    //! StageBuilder by detecting the DIANodes in a Stage)
-    static DIAMemUse Max() { return DIAMemUse(max_limit_); }
+    //! StageBuilder by detecting the DIANodes in a Stage). The remaining RAM
+    //! is distributed to the nodes in proportion to their weight, which should
+    //! be an estimate of the bytes the node stores per item pushed in the
+    //! Stage, or zero if unknown.
+    static DIAMemUse Max(size_t weight = 0) {
+        DIAMemUse m(max_limit_);
+        m.weight_ = weight;
+        return m;
+    }
 
     //! return amount of RAM reserved
     size_t limit() const { return limit_; }
 
+    //! return weight of a maximum RAM request, zero if unknown.
+    size_t weight() const { return weight_; }
+
     //! test if sentinel for maximum RAM request
     bool is_max() const { return limit_ == max_limit_; }
 
@@ -72,10 +85,110 @@ private:
     //! amount of RAM requested or reserved.
     size_t limit_;
 
+    //! weight of a maximum RAM request relative to other nodes in the Stage.
+    size_t weight_ = 0;
+
     //! sentinel for maximum available RAM.
     static constexpr size_t max_limit_ = static_cast<size_t>(-1);
 };
 
+/*!
+ * Distribute remaining_mem to the DIAMemUse::Max() requests of a Stage in
+ * proportion to their weights. Requests with unknown (zero) weight get the
+ * average of the known weights, hence equal shares if no weight is known.
+ */
+std::vector<size_t> DistributeMaxMemUse(
+    size_t remaining_mem, const std::vector<size_t>& weights);
+
+/*!
+ * Description of how the items of a DIANode are distributed to the workers,
+ * which DOps use to skip their exchange if the items are already partitioned
+ * by their key. After ReduceByKey() all items of a key are on one worker
+ * (HASH), after Sort() with LessByKey() the items are globally sorted by the
+ * key, and the items of a key may span adjacent workers (RANGE).
+ *
+ * The key is identified by the type of the key extractor, which is only
+ * recorded for stateless key extractors such as lambdas without captures.
+ * Hence, the partitioning is recognized if the same key extractor object, or a
+ * copy of it, is passed to both DOps.
+ */
+class DIAPartitioning
+{
+public:
+    enum class Type {
+        //! the distribution of the items is unknown
+        NONE,
+        //! all items of a key are on one worker
+        HASH,
+        //! the items are sorted globally by the key
+        RANGE
+    };
+
+    //! unknown partitioning
+    DIAPartitioning() = default;
+
+    //! all items of a key are on one worker
+    template <typename KeyExtractor>
+    static DIAPartitioning Hash() {
+        return DIAPartitioning(Type::HASH, KeyId<KeyExtractor>());
+    }
+
+    //! items are sorted globally by the key
+    template <typename KeyExtractor>
+    static DIAPartitioning Range() {
+        return DIAPartitioning(Type::RANGE, KeyId<KeyExtractor>());
+    }
+
+    //! items are sorted globally by a compare function, not by a known key
+    static DIAPartitioning RangeByCompare() {
+        return DIAPartitioning(Type::RANGE, nullptr);
+    }
+
+    //! the distribution type
+    Type type() const { return type_; }
+
+    //! test if all items of each key of KeyExtractor are on one worker
+    template <typename KeyExtractor>
+    bool IsHash() const {
+        return type_ == Type::HASH && SameKey(KeyId<KeyExtractor>());
+    }
+
+    //! test if items are sorted globally by the key of KeyExtractor
+    template <typename KeyExtractor>
+    bool IsRange() const {
+        return type_ == Type::RANGE && SameKey(KeyId<KeyExtractor>());
+    }
+
+    //! description for Explain()
+    const char * str() const {
+        if (type_ == Type::HASH)
+            return key_ ? "hash by key" : "hash by unknown key";
+        if (type_ == Type::RANGE)
+            return key_ ? "range by key" : "range by comparator";
+        return "none";
+    }
+
+private:
+    DIAPartitioning(Type type, const std::type_info* key)
+        : type_(type), key_(key) { }
+
+    //! distribution type
+    Type type_ = Type::NONE;
+
+    //! type of the key extractor, nullptr if unknown
+    const std::type_info* key_ = nullptr;
+
+    template <typename KeyExtractor>
+    static const std::type_info * KeyId() {
+        return std::is_empty<KeyExtractor>::value
+               ? &typeid(KeyExtractor) : nullptr;
+    }
+
+    bool SameKey(const std::type_info* key) const {
+        return key_ != nullptr && key != nullptr && *key_ == *key;
+    }
+};
+
 /*!
  * The DIABase is the untyped super class of DIANode. DIABases are used to build
  * the execution graph, which is used to execute the computation.
@@ -97,11 +210,12 @@ public:
             const std::initializer_list<size_t>& parent_ids,
             const std::initializer_list<DIABasePtr>& parents)
         : context_(ctx), dia_id_(ctx.next_dia_id()),
-          label_(label), parents_(parents) {
+          label_(label), parents_(parents), parent_dia_ids_(parent_ids) {
         logger_ << "class" << "DIABase"
                 << "event" << "create"
                 << "type" << "DOp"
                 << "parents" << parent_ids;
+        context_.RegisterDIANode(dia_id_, this);
     }
 
     /*!
@@ -112,11 +226,13 @@ public:
             std::vector<size_t>&& parent_ids,
             std::vector<DIABasePtr>&& parents)
         : context_(ctx), dia_id_(ctx.next_dia_id()),
-          label_(std::move(label)), parents_(std::move(parents)) {
+          label_(std::move(label)), parents_(std::move(parents)),
+          parent_dia_ids_(parent_ids) {
         logger_ << "class" << "DIABase"
                 << "event" << "create"
                 << "type" << "DOp"
                 << "parents" << parent_ids;
+        context_.RegisterDIANode(dia_id_, this);
     }
 
     //! non-copyable: delete copy-constructor
@@ -136,6 +252,7 @@ public:
         logger_ << "class" << "DIABase"
                 << "event" << "destroy"
                 << "parents" << parent_ids();
+        context_.UnregisterDIANode(dia_id_);
 
         // de-register at parents (if still hooked there)
         for (const DIABasePtr& p : parents_)
@@ -204,6 +321,37 @@ public:
     //! sub-classes.
     virtual void RemoveAllChildren() = 0;
 
+    //! Returns a fingerprint of the input read by a source node, e.g. of the
+    //! paths, sizes and modification times of the files, which is used by
+    //! DIA::Persist() to detect changed inputs. Zero for nodes whose output
+    //! only depends on their parents.
+    virtual uint64_t SourceFingerprint() const { return 0; }
+
+    //! Returns whether the node is a source scanning external input, e.g.
+    //! ReadLines() or ReadBinary(), which pushes long runs of items into its
+    //! children's function stacks. ReduceByKey() inserts them in batches.
+    virtual bool ScanSource() const { return false; }
+
+    //! \name Explain
+    //! \{
+
+    //! Virtual method describing the items of the node for Explain(): the
+    //! estimated item size, and the items pushed to the children so far.
+    virtual std::string ExplainItems() const { return std::string(); }
+
+    //! Virtual method describing the implementation chosen by the node for
+    //! Explain(), e.g. the reduce table or the sort algorithm.
+    virtual std::string ExplainImpl() const { return std::string(); }
+
+    //! Write a description of this node to os, see Context::Explain().
+    void ExplainNode(std::ostream& os) const;
+
+    //! Write the stages which RunScope() would run to compute this node, and
+    //! the description of each node involved to os.
+    void Explain(std::ostream& os);
+
+    //! \}
+
     //! Returns the api::Context of this DIABase.
     Context& context() {
         return context_;
@@ -219,6 +367,15 @@ public:
         return label_;
     }
 
+    //! Returns the host's always-on counter of metric for this node's
+    //! operation, e.g. thrill_op_items{op="Map"}. Takes a mutex, keep the
+    //! reference outside of loops.
+    common::ShardedCounter& op_counter(const char* metric);
+
+    //! Returns the host's always-on timer of metric for this node's operation,
+    //! for use with common::ScopedTscTimer.
+    common::ShardedCounter& op_timer(const char* metric);
+
     //! make ostream-able.
     friend std::ostream& operator << (std::ostream& os, const DIABase& d);
 
@@ -249,6 +406,13 @@ public:
         consume_counter_ = counter;
     }
 
+    //! Returns true if the StageBuilder found that no DIA refers to this node
+    //! anymore, hence its data can be consumed by the next PushData().
+    bool unreferenced() const { return unreferenced_; }
+
+    //! Set by the StageBuilder before PushData(), see unreferenced().
+    void set_unreferenced(bool unreferenced) { unreferenced_ = unreferenced; }
+
     //! Returns the parents of this DIABase.
     const std::vector<DIABasePtr>& parents() const {
         return parents_;
@@ -271,8 +435,9 @@ public:
     }
 
     //! Run Scope and parents such that this node (usually an ActionNode) is
-    //! EXECUTED.
-    void RunScope();
+    //! EXECUTED. If execute_this is false, all stages pushing into this node
+    //! are run, but its own Execute() is left to the caller, see WaitAll().
+    void RunScope(bool execute_this = true);
 
     //! Return the Context's memory manager
     mem::Manager& mem_manager() {
@@ -285,6 +450,12 @@ public:
 
     void set_mem_limit(const DIAMemUse& mem_limit) { mem_limit_ = mem_limit; }
 
+    //! Returns how the items of this node are distributed to the workers.
+    const DIAPartitioning& partitioning() const { return partitioning_; }
+
+    //! Set by DOps whose output is partitioned by a key.
+    void set_partitioning(const DIAPartitioning& p) { partitioning_ = p; }
+
 protected:
     //! \name Fixed DIA Information
     //! \{
@@ -309,14 +480,25 @@ protected:
     //! Parents of this DIABase.
     std::vector<DIABasePtr> parents_;
 
+    //! DIA ids of the parents as passed by the DOp, which are the ids of the
+    //! last LOps if the parents' function stacks are not empty.
+    std::vector<size_t> parent_dia_ids_;
+
     //! Amount of memory the current execution stage of the DIA implementation
     //! is allowed to use.
     DIAMemUse mem_limit_ = 0;
 
+    //! Distribution of the items of this node to the workers.
+    DIAPartitioning partitioning_;
+
     //! Consumption counter: when it reaches zero, PushData() is called with
     //! consume = true
     size_t consume_counter_ = 1;
 
+    //! no DIA refers to this node anymore: the current PushData() is the last
+    //! one, and is called with consume = true even without consume mode.
+    bool unreferenced_ = false;
+
     //! \}
 
 public:
@@ -17,6 +17,8 @@
 #include <tlx/delegate.hpp>
 
 #include <algorithm>
+#include <iterator>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -39,6 +41,10 @@ class DIANode : public DIABase
 public:
     using Callback = tlx::delegate<void (const ValueType&)>;
 
+    //! number of items pushed as a batch into the children by PushFile() and
+    //! PushGenerated(), if there are multiple children.
+    static constexpr size_t kPushBatchSize = 256;
+
     struct Child {
         //! reference to child node
         DIABase  * node;
@@ -135,8 +141,15 @@ public:
         if (consume_counter() > 0 && consume_counter() != kNeverConsume)
             DecConsumeCounter(1);
 
-        bool consume = context().consume() && consume_counter() == 0;
+        bool consume = unreferenced() ||
+                       (context().consume() && consume_counter() == 0);
+        ++num_push_data_;
+        size_t items_pushed = items_pushed_;
+        size_t file_bytes_pushed = file_bytes_pushed_;
         PushData(consume);
+        op_counter("thrill_op_items").Add(items_pushed_ - items_pushed);
+        op_counter("thrill_op_file_bytes").Add(
+            file_bytes_pushed_ - file_bytes_pushed);
         if (consume) Dispose();
 
         for (const Child& child : children_)
@@ -145,15 +158,37 @@ public:
 
     //! Method for derived classes to Push a single item to all children.
     void PushItem(const ValueType& item) const {
+        ++items_pushed_;
         for (const Child& child : children_) {
             if (child.callback)
                 child.callback(item);
         }
     }
 
+    /*!
+     * Method for derived classes to Push a batch of items [begin,end) to all
+     * children. The loop over the items is the inner loop, hence each child's
+     * fused function stack is run in a tight loop over the batch, instead of
+     * alternating between the children for each item. The children receive
+     * the items in the same order as with PushItem().
+     */
+    template <typename Iterator>
+    void PushItems(const Iterator& begin, const Iterator& end) const {
+        items_pushed_ += static_cast<size_t>(std::distance(begin, end));
+        for (const Child& child : children_) {
+            if (!child.callback) continue;
+            for (Iterator it = begin; it != end; ++it)
+                child.callback(*it);
+        }
+    }
+
     //! Method for derived classes to Push a whole File of ValueType items to
     //! all children.
     void PushFile(data::File& file, bool consume) const {
+        items_pushed_ += file.num_items();
+        file_items_pushed_ += file.num_items();
+        file_bytes_pushed_ += file.size_bytes();
+
         // iterate over children, push directly into those with data:File*
         std::vector<Child> nonfile_children;
         for (const Child& child : children_) {
@@ -166,21 +201,134 @@ public:
         if (nonfile_children.size() == 0) return;
 
         // push into remaining which have a function stack or no direct File*
-        data::File::Reader reader = file.GetReader(consume);
-        while (reader.HasNext()) {
-            ValueType item = reader.Next<ValueType>();
-            for (const Child& child : nonfile_children) {
-                if (child.callback)
-                    child.callback(item);
-            }
+        file.VisitReader(
+            consume, [&nonfile_children](auto& reader) {
+                PushReader(reader, nonfile_children);
+            });
+    }
+
+    //! Method for derived classes to Push all num_items ValueType items of a
+    //! BlockReader to all children, e.g. of a data::CompressedFile.
+    template <typename Reader>
+    void PushReaderItems(Reader& reader, size_t num_items) const {
+        items_pushed_ += num_items;
+        PushReader(reader, children_);
+    }
+
+    //! Method for derived classes to Push items generated by
+    //! generator(index) for all index in [begin,end) to all children. With
+    //! multiple children, the items are generated into batches of
+    //! kPushBatchSize items, which are pushed using PushItems(), otherwise
+    //! they are pushed one at a time.
+    template <typename Generator>
+    void PushGenerated(size_t begin, size_t end,
+                       Generator& generator) const {
+        if (num_callbacks() <= 1) {
+            for (size_t i = begin; i < end; ++i)
+                PushItem(generator(i));
+            return;
+        }
+
+        std::vector<ValueType> batch;
+        batch.reserve(std::min(end - begin, kPushBatchSize));
+        for (size_t i = begin; i < end; ) {
+            batch.clear();
+            size_t batch_end = std::min(end, i + kPushBatchSize);
+            for ( ; i < batch_end; ++i)
+                batch.emplace_back(generator(i));
+            PushItems(batch.begin(), batch.end());
         }
     }
 
+    //! Returns the number of children which have a callback.
+    size_t num_callbacks() const {
+        size_t num = 0;
+        for (const Child& child : children_)
+            num += (child.callback != nullptr);
+        return num;
+    }
+
+    //! Describe the serialized item size and the items pushed so far.
+    std::string ExplainItems() const override {
+        using Serialization =
+            data::Serialization<data::File::Writer, ValueType>;
+
+        std::ostringstream oss;
+        if (Serialization::is_fixed_size)
+            oss << "item " << Serialization::fixed_size << " bytes";
+        else
+            oss << "item ~" << sizeof(ValueType) << " bytes (variable)";
+
+        if (num_push_data_ != 0) {
+            // items pushed individually have the fixed size, otherwise
+            // estimate them by the average of those pushed from Files.
+            size_t other_items = items_pushed_ - file_items_pushed_;
+            double item_bytes =
+                Serialization::is_fixed_size ? Serialization::fixed_size :
+                file_items_pushed_ != 0 ?
+                static_cast<double>(file_bytes_pushed_) / file_items_pushed_ :
+                sizeof(ValueType);
+            bool exact = Serialization::is_fixed_size || other_items == 0;
+            size_t bytes = file_bytes_pushed_ +
+                           static_cast<size_t>(other_items * item_bytes);
+            oss << ", pushed " << items_pushed_ << " items "
+                << (exact ? "" : "~") << bytes << " bytes in "
+                << num_push_data_ << " PushData()";
+        }
+        return oss.str();
+    }
+
 protected:
     //! Callback functions from the child nodes.
     std::vector<Child> children_;
+
+    //! Push all items of reader to the given children, in batches of
+    //! kPushBatchSize items if there are multiple.
+    template <typename Reader>
+    static void PushReader(Reader& reader, const std::vector<Child>& children) {
+        if (children.size() == 1) {
+            const Child& child = children.front();
+            if (!child.callback) return;
+            while (reader.HasNext())
+                child.callback(reader.template Next<ValueType>());
+            return;
+        }
+
+        // with multiple children: deserialize a batch of items and push the
+        // batch into each child's function stack.
+        std::vector<ValueType> batch;
+        batch.reserve(kPushBatchSize);
+        while (reader.HasNext()) {
+            batch.clear();
+            while (reader.HasNext() && batch.size() < kPushBatchSize)
+                batch.emplace_back(reader.template Next<ValueType>());
+
+            for (const Child& child : children) {
+                if (!child.callback) continue;
+                for (const ValueType& item : batch)
+                    child.callback(item);
+            }
+        }
+    }
+
+    //! \name Statistics for Explain()
+    //! \{
+
+    //! number of items pushed to the children
+    mutable size_t items_pushed_ = 0;
+
+    //! number of items pushed from Files, and their serialized size
+    mutable size_t file_items_pushed_ = 0, file_bytes_pushed_ = 0;
+
+    //! number of RunPushData() calls
+    size_t num_push_data_ = 0;
+
+    //! \}
 };
 
+template <typename ValueType>
+constexpr size_t DIANode<ValueType>::kPushBatchSize;
+
 //! \}
 
 } // namespace api
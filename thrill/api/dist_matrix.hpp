@@ -0,0 +1,234 @@
+/*******************************************************************************
+ * thrill/api/dist_matrix.hpp
+ *
+ * Dense matrix whose rows are partitioned between the workers in blocks, with
+ * local matrix kernels and collectives for GEMV, GEMM, and aggregation.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_DIST_MATRIX_HEADER
+#define THRILL_API_DIST_MATRIX_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/concat_to_dia.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/matrix.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * ActionNode which collects the rows of a DIA of std::vector<Type> into one
+ * contiguous local row block.
+ *
+ * \ingroup api_layer
+ */
+template <typename Type>
+class DistMatrixBuildNode final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+public:
+    using Row = std::vector<Type>;
+
+    template <typename ParentDIA>
+    DistMatrixBuildNode(const ParentDIA& parent, size_t columns)
+        : ActionNode(parent.ctx(), "DistMatrix",
+                     { parent.id() }, { parent.node() }),
+          columns_(columns) {
+
+        auto pre_op_fn = [this](const Row& row) { PreOp(row); };
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void PreOp(const Row& row) {
+        if (row.size() != columns_)
+            die("DistMatrix: row of size " << row.size()
+                << " in matrix with " << columns_ << " columns");
+        data_.insert(data_.end(), row.begin(), row.end());
+    }
+
+    void Execute() final {
+        LOG << "DistMatrix: " << data_.size() / std::max<size_t>(columns_, 1)
+            << " local rows";
+    }
+
+    //! row-major contents of the local rows
+    std::vector<Type>& data() { return data_; }
+
+private:
+    //! number of columns of all rows
+    size_t columns_;
+    //! row-major contents of the local rows
+    std::vector<Type> data_;
+};
+
+/*!
+ * A dense rows x columns matrix, whose rows are partitioned between the
+ * workers in contiguous blocks, each stored as local common::Matrix. The rows
+ * keep the distribution of the DIA they were built from, hence the rows of a
+ * data set and a DistMatrix of it reside on the same worker.
+ *
+ * Vectors with one entry per row are distributed like the rows ("local"
+ * vectors), while vectors with one entry per column, and small matrices with
+ * as many rows as the columns, are replicated on all workers. Large vectors are
+ * aggregated with the segmented ring AllReduce.
+ *
+ * All methods returning replicated results are collective.
+ *
+ * \ingroup api_layer
+ */
+template <typename Type>
+class DistMatrix
+{
+    static constexpr bool debug = false;
+
+public:
+    using Row = std::vector<Type>;
+    using LocalMatrix = common::Matrix<Type>;
+
+    //! Builds the matrix from a DIA of rows, each with the given columns.
+    template <typename RowDIA>
+    DistMatrix(const RowDIA& rows, size_t columns)
+        : context_(rows.context()) {
+        static_assert(
+            std::is_convertible<typename RowDIA::ValueType, Row>::value,
+            "DistMatrix requires a DIA of std::vector<Type> rows");
+
+        auto node = tlx::make_counting<DistMatrixBuildNode<Type> >(
+            rows, columns);
+        node->RunScope();
+
+        size_t local_rows =
+            columns == 0 ? 0 : node->data().size() / columns;
+        local_ = LocalMatrix(local_rows, columns, std::move(node->data()));
+        Init();
+    }
+
+    //! Wraps local row blocks, which form the matrix in worker order.
+    DistMatrix(Context& ctx, LocalMatrix&& local)
+        : context_(ctx), local_(std::move(local)) {
+        Init();
+    }
+
+    //! global number of rows
+    size_t rows() const { return rows_; }
+
+    //! number of columns
+    size_t columns() const { return local_.columns(); }
+
+    //! global index of the first local row
+    size_t row_begin() const { return row_begin_; }
+
+    //! local row block
+    const LocalMatrix& local() const { return local_; }
+
+    //! local row block
+    LocalMatrix& local() { return local_; }
+
+    //! Returns the local part of A * x, with one entry per local row.
+    std::vector<Type> LocalGemv(const std::vector<Type>& x) const {
+        assert(x.size() == columns());
+        std::vector<Type> y(local_.rows());
+        local_.MultiplyVector(x.data(), y.data());
+        return y;
+    }
+
+    //! Returns A * x on all workers.
+    std::vector<Type> Gemv(const std::vector<Type>& x) const {
+        std::vector<Type> y(rows_);
+        local_.MultiplyVector(x.data(), y.data() + row_begin_);
+        return Aggregate(std::move(y));
+    }
+
+    /*!
+     * Returns transpose(A) * y on all workers, where y is a local vector with
+     * one entry per local row. This aggregates gradients of linear models, with
+     * y being the per-row loss derivatives.
+     */
+    std::vector<Type> TransposeGemv(const std::vector<Type>& local_y) const {
+        assert(local_y.size() == local_.rows());
+        std::vector<Type> x(columns());
+        local_.TransposeMultiplyVector(local_y.data(), x.data());
+        return Aggregate(std::move(x));
+    }
+
+    //! Returns A * B, where B is replicated, with the same row distribution.
+    DistMatrix Gemm(const LocalMatrix& b) const {
+        assert(b.rows() == columns());
+        return DistMatrix(context_, local_.Multiply(b), row_begin_, rows_);
+    }
+
+    /*!
+     * Returns transpose(A) * B on all workers, where B has the same row
+     * distribution, e.g. the Gram matrix transpose(A) * A.
+     */
+    LocalMatrix TransposeGemm(const DistMatrix& b) const {
+        assert(b.local_.rows() == local_.rows());
+        LocalMatrix c = local_.TransposeMultiply(b.local_);
+        std::vector<Type> data(c.data(), c.data() + c.size());
+        return LocalMatrix(c.rows(), c.columns(), Aggregate(std::move(data)));
+    }
+
+    //! Returns the rows as DIA, in the distribution of the matrix.
+    DIA<Row> Rows() const {
+        std::vector<Row> rows(local_.rows());
+        for (size_t i = 0; i < local_.rows(); ++i) {
+            const Type* row = local_.data() + i * columns();
+            rows[i].assign(row, row + columns());
+        }
+        return ConcatToDIA(context_, std::move(rows));
+    }
+
+private:
+    //! context of the workers
+    Context& context_;
+    //! local row block
+    LocalMatrix local_;
+    //! global index of the first local row
+    size_t row_begin_ = 0;
+    //! global number of rows
+    size_t rows_ = 0;
+
+    //! constructor with known row distribution
+    DistMatrix(Context& ctx, LocalMatrix&& local,
+               size_t row_begin, size_t rows)
+        : context_(ctx), local_(std::move(local)),
+          row_begin_(row_begin), rows_(rows) { }
+
+    //! calculate the global row offsets
+    void Init() {
+        row_begin_ = local_.rows();
+        rows_ = context_.net.ExPrefixSumTotal(row_begin_);
+        LOG << "DistMatrix: rows [" << row_begin_ << ","
+            << row_begin_ + local_.rows() << ") of " << rows_;
+    }
+
+    //! component-wise sum on all workers, large vectors use the ring
+    std::vector<Type> Aggregate(std::vector<Type>&& v) const {
+        return context_.net.AllReduce(
+            v, common::ComponentSum<std::vector<Type> >());
+    }
+};
+
+} // namespace api
+
+//! imported from api namespace
+using api::DistMatrix;
+
+} // namespace thrill
+
+#endif // !THRILL_API_DIST_MATRIX_HEADER
+
+/******************************************************************************/
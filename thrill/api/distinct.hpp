@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * thrill/api/distinct.hpp
+ *
+ * Distinct() and CountDistinct(), which remove items with duplicate keys using
+ * a ReduceNode with duplicate detection.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_DISTINCT_HEADER
+#define THRILL_API_DISTINCT_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/reduce_by_key.hpp>
+#include <thrill/api/size.hpp>
+
+#include <functional>
+#include <type_traits>
+
+namespace thrill {
+namespace api {
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor>
+auto DIA<ValueType, Stack>::Distinct(const KeyExtractor& key_extractor) const {
+    assert(IsValid());
+
+    static_assert(
+        std::is_same<
+            typename std::decay<typename common::FunctionTraits<KeyExtractor>::
+                                template arg<0> >::type,
+            ValueType>::value,
+        "KeyExtractor has the wrong input type");
+
+    using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
+
+    // keep any one item of each key
+    auto keep_first = [](const ValueType& a, const ValueType& /* b */) {
+                          return a;
+                      };
+
+    // the pre-phase removes duplicates locally, and duplicate detection
+    // keeps the keys which occur on only one worker there.
+    using ReduceNode = api::ReduceNode<
+        ValueType, KeyExtractor, decltype(keep_first), DefaultReduceConfig,
+        std::hash<Key>, std::equal_to<Key>,
+        /* VolatileKey */ false, /* UseDuplicateDetection */ true>;
+
+    auto node = tlx::make_counting<ReduceNode>(
+        *this, "Distinct", key_extractor, keep_first, DefaultReduceConfig(),
+        std::hash<Key>(), std::equal_to<Key>());
+
+    return DIA<ValueType>(node);
+}
+
+template <typename ValueType, typename Stack>
+auto DIA<ValueType, Stack>::Distinct() const {
+    return Distinct([](const ValueType& v) { return v; });
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor>
+size_t DIA<ValueType, Stack>::CountDistinct(
+    const KeyExtractor& key_extractor) const {
+    return Distinct(key_extractor).Size();
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_DISTINCT_HEADER
+
+/******************************************************************************/
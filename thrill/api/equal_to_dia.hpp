@@ -48,9 +48,8 @@ public:
     void PushData(bool /* consume */) final {
         common::Range local = context_.CalculateLocalRange(in_vector_.size());
 
-        for (size_t i = local.begin; i < local.end; ++i) {
-            this->PushItem(in_vector_[i]);
-        }
+        this->PushItems(in_vector_.begin() + local.begin,
+                        in_vector_.begin() + local.end);
     }
 
     void Dispose() final {
@@ -18,8 +18,12 @@
 #include <thrill/api/source_node.hpp>
 #include <thrill/common/logger.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
 #include <random>
 #include <type_traits>
+#include <vector>
 
 namespace thrill {
 namespace api {
@@ -29,6 +33,12 @@ namespace api {
  * according to a generator function. This function is used to generate a DIA of
  * a certain size by applying it to integers from 0 to size - 1.
  *
+ * With adaptive distribution, the indexes are generated in rounds, and each
+ * round after the first is split in proportion to the rates, in items per
+ * second, the workers reached in the previous round. Hence a slow worker,
+ * e.g. on a host with a noisy neighbour, receives fewer indexes, but the
+ * workers' items are no longer in index order.
+ *
  * \tparam ValueType Output type of the Generate operation.
  * \tparam GenerateNode Type of the generate function.
  * \ingroup api_layer
@@ -36,6 +46,8 @@ namespace api {
 template <typename ValueType, typename GenerateFunction>
 class GenerateNode final : public SourceNode<ValueType>
 {
+    static constexpr bool debug = false;
+
 public:
     using Super = SourceNode<ValueType>;
     using Super::context_;
@@ -46,18 +58,23 @@ public:
      */
     GenerateNode(Context& ctx,
                  GenerateFunction generate_function,
-                 size_t size)
-        : Super(ctx, "Generate"),
+                 size_t size, bool adaptive = false)
+        : Super(ctx, "Generate", /* recomputable */ true),
           generate_function_(generate_function),
-          size_(size)
+          size_(size), adaptive_(adaptive)
     { }
 
+    uint64_t SourceFingerprint() const final { return size_; }
+
     void PushData(bool /* consume */) final {
+        if (adaptive_) {
+            PushAdaptive();
+            return;
+        }
+
         common::Range local = context_.CalculateLocalRange(size_);
 
-        for (size_t i = local.begin; i < local.end; i++) {
-            this->PushItem(generate_function_(i));
-        }
+        this->PushGenerated(local.begin, local.end, generate_function_);
     }
 
 private:
@@ -65,6 +82,63 @@ private:
     GenerateFunction generate_function_;
     //! Size of the output DIA.
     size_t size_;
+    //! Split the indexes by the workers' rates instead of equally.
+    bool adaptive_;
+
+    //! number of rounds of adaptive distribution
+    static constexpr size_t kRounds = 3;
+
+    //! Generate the indexes in kRounds rounds: the first splits a sixteenth
+    //! of them equally, the following ones half of the remaining and finally
+    //! all remaining indexes in proportion to the rates of the last round.
+    void PushAdaptive() {
+        size_t num_workers = context_.num_workers();
+        size_t my_rank = context_.my_rank();
+
+        double rate = 1.0;
+        size_t offset = 0;
+        for (size_t round = 0; round < kRounds && offset < size_; ++round) {
+            std::shared_ptr<std::vector<double> > rates =
+                context_.net.AllGather(rate);
+
+            size_t remaining = size_ - offset;
+            size_t round_size =
+                round + 1 == kRounds ? remaining :
+                round == 0 ? std::max(remaining / 16,
+                                      std::min(remaining, num_workers)) :
+                (remaining + 1) / 2;
+
+            // all workers calculate the same boundaries from the same rates
+            double total = 0, prefix = 0;
+            for (size_t w = 0; w < num_workers; ++w) {
+                if (w == my_rank) prefix = total;
+                total += (*rates)[w];
+            }
+            auto boundary = [&](double r) {
+                                return offset + std::min(
+                                    round_size, static_cast<size_t>(
+                                        static_cast<double>(round_size)
+                                        * (r / total)));
+                            };
+            size_t begin = boundary(prefix);
+            size_t end = my_rank + 1 == num_workers ? offset + round_size
+                         : boundary(prefix + (*rates)[my_rank]);
+
+            auto start = std::chrono::steady_clock::now();
+            this->PushGenerated(begin, end, generate_function_);
+            double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+            // keep the previous rate if this worker generated nothing
+            if (end != begin)
+                rate = (end - begin) / std::max(seconds, 1e-6);
+
+            sLOG << "Generate: round" << round << "worker" << my_rank
+                 << "range" << begin << end << "rate" << rate;
+
+            offset += round_size;
+        }
+    }
 };
 
 /*!
@@ -110,6 +184,42 @@ auto Generate(Context& ctx, size_t size,
     return DIA<GenerateResult>(node);
 }
 
+/*!
+ * Generate is a Source-DOp, which creates a DIA of given size using a
+ * generator function, and distributes the indexes adaptively instead of in
+ * equal consecutive ranges: workers generating faster receive more of them,
+ * which bounds the delay of stragglers. The workers' items are not in index
+ * order, hence use it for unordered computations.
+ *
+ * \param ctx Reference to the Context object
+ *
+ * \param size Size of the output DIA
+ *
+ * \param generate_function Generator function, which maps `size_t` from
+ * `[0,size)` to elements. Input type has to be `size_t`.
+ *
+ * \ingroup dia_sources
+ */
+template <typename GenerateFunction>
+auto Generate(Context& ctx, struct UnorderedTag const&, size_t size,
+              const GenerateFunction& generate_function) {
+
+    using GenerateResult =
+        typename common::FunctionTraits<GenerateFunction>::result_type;
+
+    using GenerateNode =
+        api::GenerateNode<GenerateResult, GenerateFunction>;
+
+    static_assert(
+        common::FunctionTraits<GenerateFunction>::arity == 1,
+        "GenerateFunction must take exactly one parameter");
+
+    auto node = tlx::make_counting<GenerateNode>(
+        ctx, generate_function, size, /* adaptive */ true);
+
+    return DIA<GenerateResult>(node);
+}
+
 /*!
  * Generate is a Source-DOp, which creates a DIA of given size containing the
  * size_t indexes `[0,size)`.
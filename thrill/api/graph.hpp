@@ -0,0 +1,317 @@
+/*******************************************************************************
+ * thrill/api/graph.hpp
+ *
+ * Graph with a partitioned CSR adjacency and vertex-centric supersteps, which
+ * keeps vertex values in place between iterations.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_GRAPH_HEADER
+#define THRILL_API_GRAPH_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/concat_to_dia.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/data/cat_stream.hpp>
+#include <thrill/data/file.hpp>
+
+#include <tlx/vector_free.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * ActionNode which sends each edge (source, target) to the worker owning the
+ * source vertex and builds the local part of the CSR adjacency: offsets into
+ * the targets, which are written into a File.
+ *
+ * \ingroup api_layer
+ */
+class GraphBuildNode final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+public:
+    using Edge = std::pair<size_t, size_t>;
+
+    template <typename ParentDIA>
+    GraphBuildNode(const ParentDIA& parent, size_t num_vertices)
+        : ActionNode(parent.ctx(), "GraphBuild",
+                     { parent.id() }, { parent.node() }),
+          num_vertices_(num_vertices),
+          range_(common::CalculateLocalRange(
+                     num_vertices, context_.num_workers(), context_.my_rank())) {
+
+        auto pre_op_fn = [this](const Edge& e) { PreOp(e); };
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void StartPreOp(size_t /* parent_index */) final {
+        emitters_ = stream_->GetWriters();
+    }
+
+    void PreOp(const Edge& e) {
+        if (e.first >= num_vertices_ || e.second >= num_vertices_)
+            die("Graph: edge (" << e.first << "," << e.second << ")"
+                " out of range of " << num_vertices_ << " vertices");
+        emitters_[common::CalculatePartition(
+                      num_vertices_, context_.num_workers(), e.first)].Put(e);
+    }
+
+    void StopPreOp(size_t /* parent_index */) final {
+        emitters_.Close();
+    }
+
+    //! Bucket sorts the received edges by local source vertex.
+    void Execute() final {
+        std::vector<Edge> edges;
+        {
+            auto reader = stream_->GetCatReader(/* consume */ true);
+            while (reader.HasNext())
+                edges.emplace_back(reader.template Next<Edge>());
+        }
+        stream_.reset();
+
+        offsets_.assign(range_.size() + 1, 0);
+        for (const Edge& e : edges)
+            ++offsets_[e.first - range_.begin + 1];
+        for (size_t i = 1; i < offsets_.size(); ++i)
+            offsets_[i] += offsets_[i - 1];
+
+        std::vector<size_t> targets(edges.size());
+        {
+            std::vector<size_t> fill(offsets_.begin(), offsets_.end() - 1);
+            for (const Edge& e : edges)
+                targets[fill[e.first - range_.begin]++] = e.second;
+        }
+        tlx::vector_free(edges);
+
+        data::File::Writer writer = targets_.GetWriter();
+        for (const size_t& t : targets)
+            writer.Put(t);
+        writer.Close();
+
+        LOG << "GraphBuild: " << range_.size() << " local vertices with "
+            << targets.size() << " edges";
+    }
+
+    //! offsets of each local vertex's targets, with a sentinel
+    std::vector<size_t>& offsets() { return offsets_; }
+
+    //! targets of all out-edges of local vertices
+    data::File& targets() { return targets_; }
+
+private:
+    //! global number of vertices
+    size_t num_vertices_;
+    //! range of local vertices
+    common::Range range_;
+
+    //! CatStream for exchange
+    data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
+    data::CatStream::Writers emitters_;
+
+    std::vector<size_t> offsets_;
+    data::File targets_ { context_.GetFile(this) };
+};
+
+/*!
+ * A directed graph whose vertices 0..n-1 are range partitioned between the
+ * workers. Each worker holds the out-edges of its vertices as CSR adjacency,
+ * built once from a DIA of edges, with the targets in a data::File, and one
+ * value per local vertex, which is updated in place by Superstep().
+ *
+ * All methods except value() and out_degree() are collective.
+ *
+ * \ingroup api_layer
+ */
+template <typename VertexValue>
+class Graph
+{
+    static constexpr bool debug = false;
+
+public:
+    using VertexId = size_t;
+    //! (source, target) edge
+    using Edge = std::pair<VertexId, VertexId>;
+
+    /*!
+     * Builds the CSR adjacency from a DIA of Edges and sets all values to
+     * initial_value.
+     */
+    template <typename EdgeDIA>
+    Graph(const EdgeDIA& edges, size_t num_vertices,
+          const VertexValue& initial_value = VertexValue())
+        : context_(edges.context()),
+          num_vertices_(num_vertices),
+          range_(common::CalculateLocalRange(
+                     num_vertices, context_.num_workers(), context_.my_rank())),
+          graph_id_(context_.next_dia_id()),
+          values_(range_.size(), initial_value) {
+
+        static_assert(
+            std::is_convertible<typename EdgeDIA::ValueType, Edge>::value,
+            "Graph requires a DIA of std::pair<size_t, size_t> edges");
+
+        auto node = tlx::make_counting<GraphBuildNode>(edges, num_vertices);
+        node->RunScope();
+
+        offsets_ = std::move(node->offsets());
+        targets_ = std::move(node->targets());
+    }
+
+    //! non-copyable: delete copy-constructor
+    Graph(const Graph&) = delete;
+    //! non-copyable: delete assignment operator
+    Graph& operator = (const Graph&) = delete;
+    //! move-constructor: default
+    Graph(Graph&&) = default;
+
+    //! global number of vertices
+    size_t num_vertices() const { return num_vertices_; }
+
+    //! range of vertices on this worker
+    const common::Range& local_range() const { return range_; }
+
+    //! value of local vertex v
+    VertexValue& value(VertexId v) {
+        assert(range_.Contains(v));
+        return values_[v - range_.begin];
+    }
+
+    //! number of out-edges of local vertex v
+    size_t out_degree(VertexId v) const {
+        assert(range_.Contains(v));
+        return offsets_[v - range_.begin + 1] - offsets_[v - range_.begin];
+    }
+
+    /*!
+     * Runs one vertex-centric superstep:
+     *
+     * 1. For each local vertex v, send(v, value, out_degree, msg) is called.
+     * If it returns true, msg is sent along all out-edges of v.
+     *
+     * 2. All messages to a vertex are combined with combine(), starting with
+     * neutral. Messages to local vertices are combined directly, others are
+     * sent to their vertex's worker.
+     *
+     * 3. For each local vertex, apply(v, value, msg) updates the value in place
+     * with the combined messages, and returns whether it changed.
+     *
+     * Returns the global number of vertices whose value changed.
+     */
+    template <typename Message, typename SendFunction,
+              typename CombineFunction, typename ApplyFunction>
+    size_t Superstep(const SendFunction& send,
+                     const CombineFunction& combine,
+                     const ApplyFunction& apply,
+                     const Message& neutral) {
+
+        std::vector<Message> inbox(range_.size(), neutral);
+        const size_t num_workers = context_.num_workers();
+
+        data::CatStreamPtr stream = context_.GetNewCatStream(graph_id_);
+        {
+            data::CatStream::Writers writers = stream->GetWriters();
+            data::File::KeepReader reader = targets_.GetKeepReader();
+
+            Message msg = neutral;
+            for (size_t i = 0; i < range_.size(); ++i) {
+                const VertexId v = range_.begin + i;
+                size_t degree = offsets_[i + 1] - offsets_[i];
+                bool active = send(v, values_[i], degree, msg);
+
+                // targets are read in place, hence skipping them is cheap.
+                while (degree != 0) {
+                    std::pair<const size_t*, size_t> span =
+                        reader.template NextSpan<size_t>(degree);
+                    size_t single;
+                    if (span.second == 0) {
+                        single = reader.template Next<size_t>();
+                        span = std::make_pair(&single, size_t(1));
+                    }
+                    degree -= span.second;
+                    if (!active) continue;
+
+                    for (size_t j = 0; j < span.second; ++j) {
+                        const VertexId t = span.first[j];
+                        if (range_.Contains(t)) {
+                            inbox[t - range_.begin] =
+                                combine(inbox[t - range_.begin], msg);
+                        }
+                        else {
+                            writers[common::CalculatePartition(
+                                        num_vertices_, num_workers, t)]
+                            .Put(std::make_pair(t, msg));
+                        }
+                    }
+                }
+            }
+            writers.Close();
+        }
+
+        {
+            auto reader = stream->GetCatReader(/* consume */ true);
+            while (reader.HasNext()) {
+                auto m = reader.template Next<std::pair<VertexId, Message> >();
+                inbox[m.first - range_.begin] =
+                    combine(inbox[m.first - range_.begin], m.second);
+            }
+        }
+        stream.reset();
+
+        size_t changed = 0;
+        for (size_t i = 0; i < range_.size(); ++i) {
+            if (apply(range_.begin + i, values_[i], inbox[i]))
+                ++changed;
+        }
+
+        changed = context_.net.AllReduce(changed);
+        LOG << "Graph::Superstep() changed " << changed << " vertices";
+        return changed;
+    }
+
+    //! Returns a DIA of the vertex values, ordered by vertex id.
+    DIA<VertexValue> Vertices() const {
+        return ConcatToDIA(context_, values_);
+    }
+
+private:
+    //! context of the workers
+    Context& context_;
+    //! global number of vertices
+    size_t num_vertices_;
+    //! range of local vertices
+    common::Range range_;
+    //! id for the streams of supersteps
+    size_t graph_id_;
+
+    //! offsets of each local vertex's targets, with a sentinel
+    std::vector<size_t> offsets_;
+    //! targets of all out-edges of local vertices
+    data::File targets_ { context_.GetFile(graph_id_) };
+    //! values of local vertices
+    std::vector<VertexValue> values_;
+};
+
+} // namespace api
+
+//! imported from api namespace
+using api::Graph;
+
+} // namespace thrill
+
+#endif // !THRILL_API_GRAPH_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * thrill/api/group_by_accumulate.hpp
+ *
+ * GroupByKey variant which folds the items of each key incrementally into an
+ * accumulator state using ReduceByKey's tables.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_GROUP_BY_ACCUMULATE_HEADER
+#define THRILL_API_GROUP_BY_ACCUMULATE_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/reduce_by_key.hpp>
+#include <thrill/common/function_traits.hpp>
+
+#include <utility>
+
+namespace thrill {
+namespace api {
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename Accumulator, typename ReduceConfig>
+auto DIA<ValueType, Stack>::GroupByAccumulate(
+    const KeyExtractor& key_extractor,
+    const Accumulator& accumulator,
+    const ReduceConfig& reduce_config) const {
+    assert(IsValid());
+
+    using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
+    using State = typename Accumulator::State;
+    using KeyState = std::pair<Key, State>;
+
+    // create the state of each item, which is then merged into the states of
+    // equal keys in the pre-phase of ReducePair.
+    auto make_state =
+        [key_extractor, accumulator](const ValueType& v) {
+            Key key = key_extractor(v);
+            State state = accumulator.Init(key);
+            accumulator.Add(state, v);
+            return KeyState(std::move(key), std::move(state));
+        };
+
+    auto merge_states =
+        [accumulator](const State& a, const State& b) {
+            State state = a;
+            accumulator.Merge(state, b);
+            return state;
+        };
+
+    auto finish =
+        [accumulator](const KeyState& ks) {
+            return accumulator.Finish(ks.first, ks.second);
+        };
+
+    return Map(make_state)
+           .ReducePair(merge_states, reduce_config)
+           .Map(finish);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_GROUP_BY_ACCUMULATE_HEADER
+
+/******************************************************************************/
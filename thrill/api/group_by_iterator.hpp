@@ -35,7 +35,7 @@ namespace api {
 // forward declarations for friend classes
 template <typename ValueType,
           typename KeyExtractor, typename GroupFunction, typename HashFunction,
-          bool UseLocationDetection>
+          bool UseLocationDetection, typename GroupByConfig>
 class GroupByNode;
 
 template <typename ValueType,
@@ -51,7 +51,8 @@ class GroupByIterator
               typename T2,
               typename T3,
               typename T4,
-              bool T5>
+              bool T5,
+              typename T6>
     friend class GroupByNode;
 
     template <typename T1,
@@ -88,11 +89,26 @@ public:
 
     ValueIn Next() {
         assert(!is_reader_empty_);
-        ValueIn elem = elem_;
+        ValueIn elem = std::move(elem_);
         GetNextElem();
         return elem;
     }
 
+    /*!
+     * Reads the remaining items of the current group into a vector, which is
+     * reused for all groups of the worker, and returns it. Hence, no vector is
+     * allocated per group once the buffer has grown to the largest group. The
+     * items remain valid until ReadGroup() is called for the next group.
+     */
+    const std::vector<ValueIn>& ReadGroup() {
+        group_.clear();
+        while (HasNext()) {
+            group_.emplace_back(std::move(elem_));
+            GetNextElem();
+        }
+        return group_;
+    }
+
 private:
     bool HasNextForReal() {
         return !is_reader_empty_;
@@ -110,6 +126,8 @@ private:
     bool equal_key_;
     ValueIn elem_;
     Key key_;
+    //! buffer for ReadGroup(), reused for all groups
+    std::vector<ValueIn> group_;
 
     void GetNextElem() {
         if (reader_.HasNext()) {
@@ -135,7 +153,8 @@ class GroupByMultiwayMergeIterator
               typename T2,
               typename T3,
               typename T4,
-              bool T5>
+              bool T5,
+              typename T6>
     friend class GroupByNode;
 
     template <typename T1,
@@ -173,11 +192,26 @@ public:
 
     ValueIn Next() {
         assert(!is_reader_empty_);
-        ValueIn elem = elem_;
+        ValueIn elem = std::move(elem_);
         GetNextElem();
         return elem;
     }
 
+    /*!
+     * Reads the remaining items of the current group into a vector, which is
+     * reused for all groups of the worker, and returns it. Hence, no vector is
+     * allocated per group once the buffer has grown to the largest group. The
+     * items remain valid until ReadGroup() is called for the next group.
+     */
+    const std::vector<ValueIn>& ReadGroup() {
+        group_.clear();
+        while (HasNext()) {
+            group_.emplace_back(std::move(elem_));
+            GetNextElem();
+        }
+        return group_;
+    }
+
 private:
     bool HasNextForReal() {
         return !is_reader_empty_;
@@ -195,6 +229,8 @@ private:
     bool equal_key_;
     ValueIn elem_;
     Key key_;
+    //! buffer for ReadGroup(), reused for all groups
+    std::vector<ValueIn> group_;
 
     void GetNextElem() {
         if (reader_.HasNext()) {
@@ -19,7 +19,10 @@
 #include <thrill/api/dop_node.hpp>
 #include <thrill/api/group_by_iterator.hpp>
 #include <thrill/common/functional.hpp>
+#include <thrill/common/hash.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/porting.hpp>
+#include <thrill/core/hyperloglog.hpp>
 #include <thrill/core/location_detection.hpp>
 #include <thrill/core/reduce_functional.hpp>
 #include <thrill/data/file.hpp>
@@ -29,6 +32,9 @@
 #include <algorithm>
 #include <deque>
 #include <functional>
+#include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <typeinfo>
 #include <unordered_map>
@@ -38,12 +44,71 @@
 namespace thrill {
 namespace api {
 
+//! method of grouping the received items locally in GroupByKey
+enum class GroupByLocalPhase {
+    //! sort the items into runs and merge them, groups are output in key order
+    SORT,
+    //! reorder the items by a hash table of the keys, if the items and the
+    //! table fit into RAM, else sort. Groups are not output in key order.
+    HASH,
+    //! hash if the items and table fit into RAM and HyperLogLog estimates few
+    //! keys, else sort. Groups are output in key order only if sorted.
+    AUTO
+};
+
+//! configuration class for GroupByKey()
+class DefaultGroupByConfig
+{
+public:
+    //! method of grouping the received items
+    GroupByLocalPhase local_phase_ = GroupByLocalPhase::SORT;
+
+    //! with AUTO: hash only if the estimated number of distinct keys is at
+    //! most this fraction of the received items.
+    double hash_max_distinct_ratio_ = 0.25;
+
+    //! with location detection: store the hash of each key with the item in
+    //! the local pre-file, which saves hashing the key again in Execute() but
+    //! adds eight bytes per item to the file.
+    bool use_hash_cache_ = false;
+
+    //! with hash exchange and no location detection: receive and group the
+    //! items in an additional thread while the parent pushes them, such that
+    //! the main phase overlaps the parent's PushData().
+    bool use_post_thread_ = false;
+};
+
 /*!
+ * A DIANode which groups all items of a key and applies the group function to
+ * them. Items are hash partitioned to the workers, possibly with location
+ * detection.
+ *
+ * The received items are grouped either by sorting them into runs, which are
+ * merged, or, if they fit into RAM, by a hash table mapping each key to a
+ * group index, by which the items are reordered in O(n) such that equal keys
+ * are adjacent. The number of distinct keys is estimated with HyperLogLog, to
+ * bound the hash table's memory, and with GroupByLocalPhase::AUTO to select the
+ * hash grouping only for a moderate number of groups. If the items are spilled
+ * to disk while being received, or the hash table would exceed half of the
+ * memory limit, the sorting method is used. Only with sorting, which is the
+ * default, the groups are output in key order.
+ *
+ * With DefaultGroupByConfig::use_post_thread_, the main phase which receives
+ * the items runs in an additional thread started in StartPreOp(), hence it
+ * overlaps the parent's PushData(), and the CatStream's send limit provides
+ * backpressure. Execute() then only waits for it.
+ *
+ * If the input is already partitioned by the same key extractor, the exchange
+ * is skipped (see DIAPartitioning): with hash partitioning all items stay on
+ * their worker, and with range partitioning, which Sort() with LessByKey()
+ * produces, only the leading items of a key spanning several workers are sent
+ * to the first of them, and the sorted items are grouped in one pass.
+ *
  * \ingroup api_layer
  */
 template <typename ValueType,
           typename KeyExtractor, typename GroupFunction, typename HashFunction,
-          bool UseLocationDetection>
+          bool UseLocationDetection, typename GroupByConfig>
 class GroupByNode final : public DOpNode<ValueType>
 {
 private:
@@ -112,6 +177,26 @@ private:
         }
     };
 
+    //! how the items are brought to the worker grouping their key
+    enum class Exchange {
+        //! hash partition the items, possibly with location detection
+        HASH,
+        //! input is hash partitioned by the key, keep the items
+        LOCAL,
+        //! input is sorted by the key, move only keys spanning workers
+        RANGE
+    };
+
+    //! whether a worker has items, its first and its last key
+    using RangeInfo = std::tuple<bool, Key, Key>;
+
+    //! combine the RangeInfo of disjoint workers in AllReduce
+    struct RangeInfoMerge {
+        RangeInfo operator () (const RangeInfo& a, const RangeInfo& b) const {
+            return std::get<0>(a) ? a : b;
+        }
+    };
+
 public:
     /*!
      * Constructor for a GroupByNode. Sets the DataManager, parent, stack,
@@ -121,13 +206,21 @@ public:
     GroupByNode(const ParentDIA& parent,
                 const KeyExtractor& key_extractor,
                 const GroupFunction& groupby_function,
-                const HashFunction& hash_function = HashFunction())
+                const HashFunction& hash_function = HashFunction(),
+                const GroupByConfig& groupby_config = GroupByConfig())
         : Super(parent.ctx(), "GroupByKey", { parent.id() }, { parent.node() }),
           key_extractor_(key_extractor),
           groupby_function_(groupby_function),
           hash_function_(hash_function),
+          config_(groupby_config),
           location_detection_(parent.ctx(), Super::dia_id()),
           pre_file_(context_.GetFile(this)) {
+        const DIAPartitioning& partitioning = parent.partitioning();
+        if (partitioning.template IsHash<KeyExtractor>())
+            exchange_ = Exchange::LOCAL;
+        else if (partitioning.template IsRange<KeyExtractor>())
+            exchange_ = Exchange::RANGE;
+
         // Hook PreOp
         auto pre_op_fn = [=](const ValueIn& input) {
                              PreOp(input);
@@ -141,14 +234,38 @@ public:
     void StartPreOp(size_t /* parent_index */) final {
         emitters_ = stream_->GetWriters();
         pre_writer_ = pre_file_.GetWriter();
-        if (UseLocationDetection)
+        if (UseLocationDetection && exchange_ == Exchange::HASH)
             location_detection_.Initialize(DIABase::mem_limit_);
+        if (UsePostThread()) {
+            // start additional thread to receive from the stream
+            thread_ = common::CreateThread([this] { MainOp(); });
+        }
     }
 
     //! Send all elements to their designated PEs
     void PreOp(const ValueIn& v) {
+        if (exchange_ == Exchange::LOCAL) {
+            emitters_[context_.my_rank()].Put(v);
+            return;
+        }
+        if (exchange_ == Exchange::RANGE) {
+            // keep the items, and count those with the first key
+            const Key key = key_extractor_(v);
+            if (range_items_ == 0)
+                range_first_ = key;
+            if (range_leading_ == range_items_ && KeyEqual(key, range_first_))
+                ++range_leading_;
+            range_last_ = key;
+            ++range_items_;
+            pre_writer_.Put(v);
+            return;
+        }
         size_t hash = hash_function_(key_extractor_(v));
         if (UseLocationDetection) {
+            // optionally store the hash with the item, to not hash the key
+            // again in Execute()
+            if (config_.use_hash_cache_)
+                pre_writer_.Put(hash);
             pre_writer_.Put(v);
             location_detection_.Insert(HashCount { hash, 1 });
         }
@@ -160,10 +277,19 @@ public:
 
     void StopPreOp(size_t /* parent_index */) final {
         pre_writer_.Close();
+        if (UsePostThread()) {
+            // close the emitters and wait for the thread to receive all items
+            emitters_.Close();
+            thread_.join();
+        }
     }
 
     DIAMemUse PreOpMemUse() final {
-        return DIAMemUse::Max();
+        // the post thread receives the items in the PreOp, otherwise only the
+        // location detection's hash counters are kept.
+        if (UsePostThread())
+            return DIAMemUse::Max();
+        return DIAMemUse::Max(sizeof(size_t));
     }
 
     DIAMemUse ExecuteMemUse() final {
@@ -182,15 +308,24 @@ public:
     }
 
     void Execute() override {
-        if (UseLocationDetection) {
+        // items were already received by the post thread
+        if (UsePostThread()) return;
+
+        if (exchange_ == Exchange::RANGE) {
+            SendLeadingKeys();
+        }
+        else if (UseLocationDetection && exchange_ == Exchange::HASH) {
             std::unordered_map<size_t, size_t> target_processors;
             size_t max_hash = location_detection_.Flush(target_processors);
             auto file_reader = pre_file_.GetConsumeReader();
             while (file_reader.HasNext()) {
+                size_t hash = config_.use_hash_cache_
+                              ? file_reader.template Next<size_t>() : 0;
                 ValueIn in = file_reader.template Next<ValueIn>();
-                Key key = key_extractor_(in);
+                if (!config_.use_hash_cache_)
+                    hash = hash_function_(key_extractor_(in));
 
-                size_t hr = hash_function_(key) % max_hash;
+                size_t hr = hash % max_hash;
                 auto target_processor = target_processors.find(hr);
                 emitters_[target_processor->second].Put(in);
             }
@@ -293,10 +428,20 @@ public:
 
     void Dispose() override { }
 
+    std::string ExplainImpl() const final {
+        if (exchange_ == Exchange::LOCAL)
+            return "input partitioned by key, local grouping";
+        if (exchange_ == Exchange::RANGE)
+            return "input sorted by key, streaming grouping";
+        return UseLocationDetection ?
+               "hash exchange with location detection" : "hash exchange";
+    }
+
 private:
     KeyExtractor key_extractor_;
     GroupFunction groupby_function_;
     HashFunction hash_function_;
+    GroupByConfig config_;
 
     core::LocationDetection<HashCount> location_detection_;
 
@@ -311,6 +456,60 @@ private:
     data::File pre_file_;
     data::File::Writer pre_writer_;
 
+    //! exchange selected by the partitioning of the input
+    Exchange exchange_ = Exchange::HASH;
+
+    //! thread running MainOp() during the PreOp, with use_post_thread_
+    std::thread thread_;
+
+    //! whether MainOp() runs in thread_: only if all items are sent during
+    //! the PreOp.
+    bool UsePostThread() const {
+        return config_.use_post_thread_ && !UseLocationDetection &&
+               exchange_ != Exchange::RANGE;
+    }
+
+    //! with Exchange::RANGE: number of items, number of leading items with
+    //! the first key, and the first and last key
+    size_t range_items_ = 0, range_leading_ = 0;
+    Key range_first_, range_last_;
+
+    //! equality of keys as defined by the order of Sort() with LessByKey()
+    static bool KeyEqual(const Key& a, const Key& b) {
+        return !(a < b) && !(b < a);
+    }
+
+    /*!
+     * With Exchange::RANGE, the items of a key may span adjacent workers. The
+     * items of the first key are sent to the first worker holding the key,
+     * all others stay. Since the CatStream delivers in worker order, each
+     * worker receives its items in sorted order.
+     */
+    void SendLeadingKeys() {
+        const size_t my_rank = context_.my_rank();
+
+        std::vector<RangeInfo> infos(context_.num_workers());
+        infos[my_rank] = RangeInfo(range_items_ != 0, range_first_, range_last_);
+        infos = context_.net.AllReduce(
+            infos, common::ComponentSum<std::vector<RangeInfo>, RangeInfoMerge>());
+
+        // scan back over preceding workers ending with our first key, and
+        // past those consisting only of it.
+        size_t owner = my_rank;
+        for (size_t w = my_rank; w-- > 0; ) {
+            if (!std::get<0>(infos[w])) continue;
+            if (!KeyEqual(std::get<2>(infos[w]), range_first_)) break;
+            owner = w;
+            if (!KeyEqual(std::get<1>(infos[w]), range_first_)) break;
+        }
+
+        auto reader = pre_file_.GetConsumeReader();
+        for (size_t i = 0; reader.HasNext(); ++i) {
+            emitters_[i < range_leading_ ? owner : my_rank].Put(
+                reader.template Next<ValueIn>());
+        }
+    }
+
     void RunUserFunc(data::File& f, bool consume) {
         auto r = f.GetReader(consume);
         if (r.HasNext()) {
@@ -344,11 +543,96 @@ private:
         w.Close();
     }
 
+    //! precision of the HyperLogLog estimate of the number of keys
+    static constexpr size_t hll_precision_ = 12;
+
+    //! Group elements in a vector by a hash table and store them in a file
+    void HashGroupVectorToFile(std::vector<ValueIn>& v) {
+        totalsize_ += v.size();
+
+        // map each key to a group index, and count the items of each group
+        std::vector<size_t> position(v.size());
+        std::vector<size_t> group_begin;
+        {
+            std::unordered_map<Key, size_t, HashFunction> group_index(
+                16, hash_function_);
+            for (size_t i = 0; i < v.size(); ++i) {
+                auto it = group_index.emplace(
+                    key_extractor_(v[i]), group_index.size()).first;
+                if (it->second == group_begin.size())
+                    group_begin.push_back(0);
+                position[i] = it->second;
+                ++group_begin[it->second];
+            }
+        }
+
+        // exclusive prefix sum of group sizes, then place items stably
+        size_t sum = 0;
+        for (size_t& g : group_begin) {
+            size_t size = g;
+            g = sum;
+            sum += size;
+        }
+        std::vector<size_t> order(v.size());
+        for (size_t i = 0; i < v.size(); ++i)
+            order[group_begin[position[i]]++] = i;
+
+        sLOG << "GroupByKey: hash grouped" << v.size() << "items into"
+             << group_begin.size() << "groups";
+
+        tlx::vector_free(position);
+        tlx::vector_free(group_begin);
+
+        files_.emplace_back(context_.GetFile(this));
+        data::File::Writer w = files_.back().GetWriter();
+        for (const size_t& i : order) {
+            w.Put(v[i]);
+        }
+        w.Close();
+    }
+
+    //! Select grouping by hashing for the items in RAM, if nothing spilled.
+    bool UseHashGrouping(size_t num_items,
+                         core::HyperLogLogRegisters<hll_precision_>& hll) {
+        if (!files_.empty() || num_items == 0)
+            return false;
+        if (config_.local_phase_ == GroupByLocalPhase::SORT)
+            return false;
+
+        double distinct = hll.result();
+        // hash table nodes and two index arrays
+        double mem_use =
+            distinct * (sizeof(Key) + 4 * sizeof(void*))
+            + static_cast<double>(num_items) * 2 * sizeof(size_t);
+
+        sLOG << "GroupByKey: estimated" << distinct << "keys of"
+             << num_items << "items, hash grouping needs" << mem_use;
+
+        if (mem_use > static_cast<double>(DIABase::mem_limit_) / 2)
+            return false;
+        return config_.local_phase_ == GroupByLocalPhase::HASH ||
+               distinct <= config_.hash_max_distinct_ratio_ * num_items;
+    }
+
     //! Receive elements from other workers.
     void MainOp() {
         LOG << "running group by main op";
 
+        if (exchange_ == Exchange::RANGE) {
+            // items arrive sorted, store them as one run
+            files_.emplace_back(context_.GetFile(this));
+            data::File::Writer writer = files_.back().GetWriter();
+            auto reader = stream_->GetCatReader(/* consume */ true);
+            while (reader.HasNext())
+                writer.Put(reader.template Next<ValueIn>());
+            writer.Close();
+            stream_.reset();
+            return;
+        }
+
         std::vector<ValueIn> incoming;
+        core::HyperLogLogRegisters<hll_precision_> hll;
+        bool estimate = (config_.local_phase_ != GroupByLocalPhase::SORT);
 
         common::StatsTimerStart timer;
         // get incoming elements
@@ -358,11 +642,19 @@ private:
             if (mem::memory_exceeded) {
                 FlushVectorToFile(incoming);
                 incoming.clear();
+                estimate = false;
             }
             // store incoming element
             incoming.emplace_back(reader.template Next<ValueIn>());
+            if (estimate) {
+                size_t hash = hash_function_(key_extractor_(incoming.back()));
+                hll.insert_hash(common::Hash128to64(hash, 0));
+            }
         }
-        FlushVectorToFile(incoming);
+        if (UseHashGrouping(incoming.size(), hll))
+            HashGroupVectorToFile(incoming);
+        else
+            FlushVectorToFile(incoming);
         tlx::vector_free(incoming);
         LOG << "finished receiving elems";
         stream_.reset();
@@ -380,12 +672,14 @@ private:
 
 template <typename ValueType, typename Stack>
 template <typename ValueOut, bool LocationDetectionValue,
-          typename KeyExtractor, typename GroupFunction, typename HashFunction>
+          typename KeyExtractor, typename GroupFunction, typename HashFunction,
+          typename GroupByConfig>
 auto DIA<ValueType, Stack>::GroupByKey(
     const LocationDetectionFlag<LocationDetectionValue>&,
     const KeyExtractor& key_extractor,
     const GroupFunction& groupby_function,
-    const HashFunction& hash_function) const {
+    const HashFunction& hash_function,
+    const GroupByConfig& groupby_config) const {
 
     static_assert(
         std::is_same<
@@ -396,10 +690,10 @@ auto DIA<ValueType, Stack>::GroupByKey(
 
     using GroupByNode = api::GroupByNode<
         ValueOut, KeyExtractor, GroupFunction, HashFunction,
-        LocationDetectionValue>;
+        LocationDetectionValue, GroupByConfig>;
 
     auto node = tlx::make_counting<GroupByNode>(
-        *this, key_extractor, groupby_function, hash_function);
+        *this, key_extractor, groupby_function, hash_function, groupby_config);
 
     return DIA<ValueOut>(node);
 }
@@ -15,8 +15,12 @@
 
 #include <thrill/api/action_node.hpp>
 #include <thrill/api/dia.hpp>
+#include <thrill/api/reduce_by_key.hpp>
+#include <thrill/common/function_traits.hpp>
 #include <thrill/core/hyperloglog.hpp>
 
+#include <utility>
+
 namespace thrill {
 namespace api {
 
@@ -71,6 +75,36 @@ double DIA<ValueType, Stack>::HyperLogLog() const {
     return registers.result();
 }
 
+template <typename ValueType, typename Stack>
+template <size_t p, typename KeyExtractor, typename ReduceConfig>
+auto DIA<ValueType, Stack>::HyperLogLogByKey(
+    const KeyExtractor& key_extractor,
+    const ReduceConfig& reduce_config) const {
+    assert(IsValid());
+
+    using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
+    using Registers = core::HyperLogLogRegisters<p>;
+    using KeyRegisters = std::pair<Key, Registers>;
+
+    // each item becomes a sparse register set with one entry, which are then
+    // combined into the registers of equal keys in the pre-phase of
+    // ReducePair and switch to the dense format when they grow.
+    auto make_registers =
+        [key_extractor](const ValueType& v) {
+            Registers registers;
+            registers.insert(v);
+            return KeyRegisters(key_extractor(v), std::move(registers));
+        };
+
+    auto merge_registers =
+        [](const Registers& a, const Registers& b) {
+            return a + b;
+        };
+
+    return Map(make_registers)
+           .ReducePair(merge_registers, reduce_config);
+}
+
 } // namespace api
 } // namespace thrill
 
@@ -20,23 +20,80 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/common/stats_timer.hpp>
 #include <thrill/core/buffered_multiway_merge.hpp>
+#include <thrill/core/heavy_hitters.hpp>
 #include <thrill/core/location_detection.hpp>
+#include <thrill/core/semi_join_filter.hpp>
 #include <thrill/data/file.hpp>
 
 #include <algorithm>
+#include <array>
 #include <deque>
 #include <functional>
+#include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace thrill {
 namespace api {
 
+//! Configuration of InnerJoin
+class DefaultJoinConfig
+{
+public:
+    //! only with location detection: if the total size of one input is at
+    //! most this many bytes, and its hash table fits into half of the memory
+    //! limit of a host's workers, it is broadcast to all hosts into a hash
+    //! table and the other input is joined locally, instead of shuffling both.
+    //! 0 = disabled. The output order differs from the shuffling join.
+    size_t broadcast_max_bytes_ = 0;
+
+    //! build an in-memory hash table of the smaller received input, if it
+    //! fits, instead of sorting both inputs for a sort-merge join.
+    bool use_hash_join_ = true;
+
+    //! only without location detection: drop items of one input whose keys
+    //! do not occur in the other input before they are sent, using a
+    //! core::SemiJoinFilter of the other input's keys. 0 = disabled, 1 =
+    //! filter the first input, 2 = filter the second input. The filtered input
+    //! is stored locally first, hence it should be the larger one.
+    size_t semi_join_filter_ = 0;
+
+    //! only with location detection: detect keys whose items on one side
+    //! would overload their worker, using Misra-Gries summaries with
+    //! heavy_hitter_counters_ counters per worker and input. The items of the
+    //! heavy side of such a key remain on their worker, and the other side's
+    //! items are replicated to all workers.
+    bool use_heavy_hitters_ = false;
+    size_t heavy_hitter_counters_ = 64;
+};
+
 /*!
  * Performs an inner join between two DIAs. The key from each DIA element is
  * hereby extracted with a key extractor function. All pairs of elements with
  * equal keys from both  DIAs are then joined with the join function.
  *
+ * With location detection, both inputs are stored locally first. If then the
+ * total size of one input is at most JoinConfig::broadcast_max_bytes_, which
+ * is disabled by default, and its hash table fits into the memory limit, it is
+ * sent to the first worker of each host, which builds a hash table shared by
+ * the host's workers, and each worker probes it with its local part of the
+ * other input, which never crosses the network. Otherwise, both inputs are
+ * hash partitioned.
+ *
+ * With JoinConfig::use_heavy_hitters_, keys with very many items on one side
+ * are detected, and their items on that side are joined where they are stored,
+ * while the other side's items are replicated to all workers.
+ *
+ * Without location detection, JoinConfig::semi_join_filter_ selects an input
+ * which is stored locally first and filtered by a distributed bloom filter of
+ * the other input's keys, such that mostly items with join partners are sent.
+ *
+ * After partitioning, if the received part of one input fits into a hash table
+ * in the memory limit, a hash table is built of the smaller such part and
+ * probed with the other part, which is stored unsorted. Only if neither part
+ * fits, both are sorted into runs and merged.
+ *
  * \tparam KeyExtractor1 Type of the key_extractor1 function. This is a
  * function ValueType to the key type.
  *
@@ -57,7 +114,7 @@ namespace api {
 template <typename ValueType, typename FirstDIA, typename SecondDIA,
           typename KeyExtractor1, typename KeyExtractor2,
           typename JoinFunction, typename HashFunction,
-          bool UseLocationDetection>
+          bool UseLocationDetection, typename JoinConfig = DefaultJoinConfig>
 class JoinNode final : public DOpNode<ValueType>
 {
 private:
@@ -72,6 +129,12 @@ private:
     //! Key type of join. must be equal to the other key extractor
     using Key = typename common::FunctionTraits<KeyExtractor1>::result_type;
 
+    //! hash tables of the build input, either local or broadcast per host
+    using HashTable1 =
+        std::unordered_multimap<Key, InputTypeFirst, HashFunction>;
+    using HashTable2 =
+        std::unordered_multimap<Key, InputTypeSecond, HashFunction>;
+
     //! hash counter used by LocationDetection
     class HashCount
     {
@@ -134,14 +197,16 @@ public:
              const KeyExtractor1& key_extractor1,
              const KeyExtractor2& key_extractor2,
              const JoinFunction& join_function,
-             const HashFunction& hash_function)
+             const HashFunction& hash_function,
+             const JoinConfig& join_config = JoinConfig())
         : Super(parent1.ctx(), "Join",
                 { parent1.id(), parent2.id() },
                 { parent1.node(), parent2.node() }),
           key_extractor1_(key_extractor1),
           key_extractor2_(key_extractor2),
           join_function_(join_function),
-          hash_function_(hash_function) {
+          hash_function_(hash_function),
+          config_(join_config) {
         auto pre_op_fn1 = [this](const InputTypeFirst& input) {
                               PreOp1(input);
                           };
@@ -158,17 +223,30 @@ public:
 
     void Execute() final {
 
+        if (UseLocationDetection) {
+            build_side_ = SelectBroadcastSide();
+            if (build_side_ != 0) {
+                broadcast_ = true;
+                ExecuteBroadcast();
+                return;
+            }
+        }
+
         if (UseLocationDetection) {
             std::unordered_map<size_t, size_t> target_processors;
             size_t max_hash = location_detection_.Flush(target_processors);
             location_detection_.Dispose();
 
+            if (config_.use_heavy_hitters_)
+                DetectHeavyHitters();
+
             auto file1reader = pre_file1_.GetConsumeReader();
             while (file1reader.HasNext()) {
                 InputTypeFirst in1 = file1reader.template Next<InputTypeFirst>();
-                auto target_processor =
-                    target_processors.find(
-                        hash_function_(key_extractor1_(in1)) % max_hash);
+                size_t hash = hash_function_(key_extractor1_(in1));
+                if (SendHeavyItem(in1, hash, 1, hash_writers1_))
+                    continue;
+                auto target_processor = target_processors.find(hash % max_hash);
                 if (target_processor != target_processors.end()) {
                     hash_writers1_[target_processor->second].Put(in1);
                 }
@@ -177,13 +255,24 @@ public:
             auto file2reader = pre_file2_.GetConsumeReader();
             while (file2reader.HasNext()) {
                 InputTypeSecond in2 = file2reader.template Next<InputTypeSecond>();
-                auto target_processor =
-                    target_processors.find(
-                        hash_function_(key_extractor2_(in2)) % max_hash);
+                size_t hash = hash_function_(key_extractor2_(in2));
+                if (SendHeavyItem(in2, hash, 2, hash_writers2_))
+                    continue;
+                auto target_processor = target_processors.find(hash % max_hash);
                 if (target_processor != target_processors.end()) {
                     hash_writers2_[target_processor->second].Put(in2);
                 }
             }
+
+            heavy_local_side_.clear();
+        }
+        else if (config_.semi_join_filter_ == 1) {
+            FilterAndSend<InputTypeFirst>(
+                pre_file1_, hash_writers1_, key_extractor1_);
+        }
+        else if (config_.semi_join_filter_ == 2) {
+            FilterAndSend<InputTypeSecond>(
+                pre_file2_, hash_writers2_, key_extractor2_);
         }
 
         hash_writers1_.Close();
@@ -212,6 +301,29 @@ public:
 
     void PushData(bool consume) final {
 
+        if (build_side_ == 1) {
+            // probe the table of the first input with the second input, which
+            // is the local pre-file if broadcast, else the received files.
+            if (broadcast_) {
+                ProbeTable1(pre_file2_, consume);
+            }
+            else {
+                for (data::File& file : files2_)
+                    ProbeTable1(file, consume);
+            }
+            return;
+        }
+        if (build_side_ == 2) {
+            if (broadcast_) {
+                ProbeTable2(pre_file1_, consume);
+            }
+            else {
+                for (data::File& file : files1_)
+                    ProbeTable2(file, consume);
+            }
+            return;
+        }
+
         auto compare_function_1 =
             [this](const InputTypeFirst& in1, const InputTypeFirst& in2) {
                 return key_extractor1_(in1) < key_extractor1_(in2);
@@ -289,6 +401,10 @@ public:
     void Dispose() final {
         files1_.clear();
         files2_.clear();
+        pre_file1_.Clear();
+        pre_file2_.Clear();
+        hash_table1_.reset();
+        hash_table2_.reset();
     }
 
 private:
@@ -302,6 +418,21 @@ private:
     JoinFunction join_function_;
     HashFunction hash_function_;
 
+    //! stored join config
+    JoinConfig config_;
+
+    //! which input is put into a hash table: 0 = none (sort-merge join), 1 =
+    //! first, 2 = second.
+    size_t build_side_ = 0;
+
+    //! whether the build input was broadcast, and the other is local
+    bool broadcast_ = false;
+
+    //! hash table of the build input, if broadcast then shared by the host's
+    //! workers.
+    std::shared_ptr<HashTable1> hash_table1_;
+    std::shared_ptr<HashTable2> hash_table2_;
+
     //! data streams for inter-worker communication of DIA elements
     data::MixStreamPtr hash_stream1_ { context_.GetNewMixStream(this) };
     data::MixStream::Writers hash_writers1_ { hash_stream1_->GetWriters() };
@@ -317,13 +448,31 @@ private:
     core::LocationDetection<HashCount> location_detection_ { context_, Super::dia_id() };
     bool location_detection_initialized_ = false;
 
+    //! summaries of frequent hashes of both inputs
+    core::HeavyHitterSummary heavy_hitters1_ { config_.heavy_hitter_counters_ };
+    core::HeavyHitterSummary heavy_hitters2_ { config_.heavy_hitter_counters_ };
+
+    //! heavy hashes mapped to the input whose items remain local, the other
+    //! input's items are replicated.
+    std::unordered_map<size_t, size_t> heavy_local_side_;
+
+    //! semi-join filter of the keys of the input which is not filtered
+    core::SemiJoinFilter filter_ { context_, Super::dia_id() };
+
     void PreOp1(const InputTypeFirst& input) {
         size_t hash = hash_function_(key_extractor1_(input));
         if (UseLocationDetection) {
             pre_writer1_.Put(input);
             location_detection_.Insert(HashCount { hash, 1, /* dia_mask */ 1 });
+            if (config_.use_heavy_hitters_)
+                heavy_hitters1_.Insert(hash);
+        }
+        else if (config_.semi_join_filter_ == 1) {
+            pre_writer1_.Put(input);
         }
         else {
+            if (config_.semi_join_filter_ == 2)
+                filter_.Insert(hash);
             hash_writers1_[hash % context_.num_workers()].Put(input);
         }
     }
@@ -333,27 +482,323 @@ private:
         if (UseLocationDetection) {
             pre_writer2_.Put(input);
             location_detection_.Insert(HashCount { hash, 1, /* dia_mask */ 2 });
+            if (config_.use_heavy_hitters_)
+                heavy_hitters2_.Insert(hash);
+        }
+        else if (config_.semi_join_filter_ == 2) {
+            pre_writer2_.Put(input);
         }
         else {
+            if (config_.semi_join_filter_ == 1)
+                filter_.Insert(hash);
             hash_writers2_[hash % context_.num_workers()].Put(input);
         }
     }
 
-    //! Receive elements from other workers, create pre-sorted files
+    /*!
+     * Collectively sum the heavy hitter summaries. A hash is heavy if one
+     * input has at least half of the average number of items per worker with
+     * it, then that input's items remain local.
+     */
+    void DetectHeavyHitters() {
+        size_t total_items = context_.net.AllReduce(
+            heavy_hitters1_.num_items() + heavy_hitters2_.num_items());
+        size_t min_count = std::max<size_t>(
+            1, total_items / context_.num_workers() / 2);
+
+        using HashCountVector = core::HeavyHitterSummary::HashCountVector;
+        HashCountVector heavy1 = heavy_hitters1_.Flush(context_, min_count);
+        HashCountVector heavy2 = heavy_hitters2_.Flush(context_, min_count);
+
+        // pick the side with more items of a hash heavy on both sides
+        for (const auto& hc : heavy1)
+            heavy_local_side_[hc.first] = 1;
+        for (const auto& hc : heavy2) {
+            auto it = std::lower_bound(
+                heavy1.begin(), heavy1.end(),
+                std::make_pair(hc.first, size_t(0)));
+            if (it == heavy1.end() || it->first != hc.first ||
+                it->second < hc.second)
+                heavy_local_side_[hc.first] = 2;
+        }
+
+        sLOGC(context_.my_rank() == 0)
+            << "InnerJoin: detected" << heavy_local_side_.size()
+            << "heavy hitters with at least" << min_count << "items";
+    }
+
+    /*!
+     * Send item of input side if its hash is heavy: keep it local or replicate
+     * it to all workers. Returns false if the hash is not heavy.
+     */
+    template <typename ItemType>
+    bool SendHeavyItem(const ItemType& item, size_t hash, size_t side,
+                       data::MixStream::Writers& writers) {
+        if (heavy_local_side_.empty()) return false;
+
+        auto it = heavy_local_side_.find(hash);
+        if (it == heavy_local_side_.end()) return false;
+
+        if (it->second == side) {
+            writers[context_.my_rank()].Put(item);
+        }
+        else {
+            for (size_t w = 0; w < context_.num_workers(); ++w)
+                writers[w].Put(item);
+        }
+        return true;
+    }
+
+    /*!
+     * Exchange the semi-join filter, and send only the items of the locally
+     * stored input whose keys are contained in it.
+     */
+    template <typename ItemType, typename KeyExtractor>
+    void FilterAndSend(data::File& file, data::MixStream::Writers& writers,
+                       const KeyExtractor& key_extractor) {
+        filter_.Flush();
+
+        size_t num_sent = 0, num_items = file.num_items();
+
+        data::File::ConsumeReader reader = file.GetConsumeReader();
+        while (reader.HasNext()) {
+            ItemType item = reader.template Next<ItemType>();
+            size_t hash = hash_function_(key_extractor(item));
+            if (filter_.Contains(hash)) {
+                writers[hash % context_.num_workers()].Put(item);
+                ++num_sent;
+            }
+        }
+        filter_.Dispose();
+
+        sLOG << "InnerJoin: semi-join filter sent" << num_sent
+             << "of" << num_items << "items";
+    }
+
+    /*!
+     * Select the input to broadcast by the total sizes of the locally stored
+     * inputs: the smaller one, if it is at most broadcast_max_bytes_, and its
+     * hash table fits into half of the smallest memory limit of all workers
+     * times the workers per host, since one table is shared by a host.
+     */
+    size_t SelectBroadcastSide() {
+        if (config_.broadcast_max_bytes_ == 0) return 0;
+
+        // total bytes and items of both inputs, and minimum memory limit
+        using Sizes = std::array<size_t, 5>;
+        Sizes sizes = {
+            { pre_file1_.size_bytes(), pre_file2_.size_bytes(),
+              pre_file1_.num_items(), pre_file2_.num_items(),
+              DIABase::mem_limit_ }
+        };
+        sizes = context_.net.AllReduce(
+            sizes, [](const Sizes& a, const Sizes& b) {
+                return Sizes {
+                    { a[0] + b[0], a[1] + b[1], a[2] + b[2], a[3] + b[3],
+                      std::min(a[4], b[4]) }
+                };
+            });
+
+        sLOGC(context_.my_rank() == 0)
+            << "InnerJoin: total input sizes" << sizes[0] << sizes[1];
+
+        size_t host_mem = sizes[4] / 2 * context_.workers_per_host();
+        bool fit1 = sizes[0] <= config_.broadcast_max_bytes_ &&
+                    sizes[2] <= host_mem / TableItemBytes<InputTypeFirst>();
+        bool fit2 = sizes[1] <= config_.broadcast_max_bytes_ &&
+                    sizes[3] <= host_mem / TableItemBytes<InputTypeSecond>();
+
+        if (fit1 && (!fit2 || sizes[0] <= sizes[1]))
+            return 1;
+        if (fit2)
+            return 2;
+        return 0;
+    }
+
+    /*!
+     * Send all items of the small input to the first worker of each host,
+     * which builds a hash table of them and shares it among the host's
+     * workers. The large input remains in the local pre-file.
+     */
+    void ExecuteBroadcast() {
+        location_detection_.Dispose();
+
+        if (build_side_ == 1)
+            SendToHosts<InputTypeFirst>(pre_file1_, hash_writers1_);
+        else
+            SendToHosts<InputTypeSecond>(pre_file2_, hash_writers2_);
+
+        hash_writers1_.Close();
+        hash_writers2_.Close();
+
+        if (build_side_ == 1) {
+            hash_table1_ = ReceiveTable<HashTable1, InputTypeFirst>(
+                hash_stream1_, key_extractor1_);
+        }
+        else {
+            hash_table2_ = ReceiveTable<HashTable2, InputTypeSecond>(
+                hash_stream2_, key_extractor2_);
+        }
+
+        // the stream of the local input carried only close messages, wait for
+        // them and release both streams.
+        hash_stream1_->Close();
+        hash_stream2_->Close();
+        hash_stream1_.reset();
+        hash_stream2_.reset();
+    }
+
+    //! send all items of file to the first worker of each host
+    template <typename ItemType>
+    void SendToHosts(data::File& file, data::MixStream::Writers& writers) {
+        size_t workers_per_host = context_.workers_per_host();
+        data::File::ConsumeReader reader = file.GetConsumeReader();
+        while (reader.HasNext()) {
+            ItemType item = reader.template Next<ItemType>();
+            for (size_t h = 0; h < context_.num_hosts(); ++h)
+                writers[h * workers_per_host].Put(item);
+        }
+    }
+
+    //! build hash table of items received on the first worker of this host,
+    //! and share it among the host's workers.
+    template <typename Table, typename ItemType, typename KeyExtractor>
+    std::shared_ptr<Table> ReceiveTable(
+        data::MixStreamPtr& stream, const KeyExtractor& key_extractor) {
+        data::MixStream::MixReader reader =
+            stream->GetMixReader(/* consume */ true);
+
+        std::shared_ptr<Table> table;
+        if (context_.local_worker_id() == 0) {
+            table = std::make_shared<Table>(
+                /* bucket_count */ 16, hash_function_);
+            while (reader.HasNext()) {
+                ItemType item = reader.template Next<ItemType>();
+                Key key = key_extractor(item);
+                table->emplace(std::move(key), std::move(item));
+            }
+            sLOG << "InnerJoin: broadcast table with"
+                 << table->size() << "items";
+        }
+        return context_.net.LocalBroadcast(table);
+    }
+
+    /*!
+     * Receive elements from other workers. If one input fits into a hash
+     * table in RAM, the hash table is built of the smaller such input, and the
+     * other input is stored in unsorted files for probing. Otherwise, both
+     * inputs are stored in pre-sorted files for the sort-merge join.
+     *
+     * The memory limit is shared: each received input may occupy half of it,
+     * the first one only while it may still become the build input. The probe
+     * input is written to files before the hash table, which takes at most the
+     * other half, is built of the build input.
+     */
     void MainOp() {
         data::MixStream::MixReader reader1_ =
             hash_stream1_->GetMixReader(/* consume */ true);
 
         size_t capacity = DIABase::mem_limit_ / sizeof(InputTypeFirst) / 2;
 
-        ReceiveItems<InputTypeFirst>(capacity, reader1_, files1_, key_extractor1_);
+        std::vector<InputTypeFirst> vec1;
+        ReceiveItems<InputTypeFirst>(
+            capacity, reader1_, files1_, key_extractor1_, vec1,
+            /* sort */ true);
+
+        bool fit1 = config_.use_hash_join_ &&
+                    files1_.empty() && !mem::memory_exceeded &&
+                    vec1.size() <= HashCapacity<InputTypeFirst>();
+
+        // release the first input's half before receiving the second input,
+        // unless it may be the build input.
+        if (!fit1 && vec1.size())
+            SortAndWriteToFile(vec1, files1_, key_extractor1_);
+        if (!fit1)
+            tlx::vector_free(vec1);
 
         data::MixStream::MixReader reader2_ =
             hash_stream2_->GetMixReader(/* consume */ true);
 
         capacity = DIABase::mem_limit_ / sizeof(InputTypeSecond) / 2;
 
-        ReceiveItems<InputTypeSecond>(capacity, reader2_, files2_, key_extractor2_);
+        // if the first input is the build input, the second need not be
+        // sorted, unless it also fits and is smaller.
+        std::vector<InputTypeSecond> vec2;
+        ReceiveItems<InputTypeSecond>(
+            capacity, reader2_, files2_, key_extractor2_, vec2,
+            /* sort */ !fit1);
+
+        bool fit2 = config_.use_hash_join_ &&
+                    files2_.empty() && !mem::memory_exceeded &&
+                    vec2.size() <= HashCapacity<InputTypeSecond>();
+
+        if (fit1 && (!fit2 || vec1.size() <= vec2.size())) {
+            build_side_ = 1;
+            WriteToFile(vec2, files2_);
+            hash_table1_ = BuildTable<HashTable1>(vec1, key_extractor1_);
+        }
+        else if (fit2) {
+            build_side_ = 2;
+            // files1_ may be pre-sorted, which does not matter for probing
+            WriteToFile(vec1, files1_);
+            hash_table2_ = BuildTable<HashTable2>(vec2, key_extractor2_);
+        }
+        else {
+            if (vec2.size())
+                SortAndWriteToFile(vec2, files2_, key_extractor2_);
+            tlx::vector_free(vec2);
+        }
+
+        sLOG << "InnerJoin: local join with build_side_" << build_side_;
+    }
+
+    //! bytes per item of a hash table, which also stores a copy of the key
+    //! and a node with pointers for each item.
+    template <typename ItemType>
+    static constexpr size_t TableItemBytes() {
+        return sizeof(ItemType) + sizeof(Key) + 4 * sizeof(void*);
+    }
+
+    //! maximum number of items of the build input in a hash table
+    template <typename ItemType>
+    size_t HashCapacity() {
+        return DIABase::mem_limit_ / TableItemBytes<ItemType>() / 2;
+    }
+
+    //! build a hash table of the items in vec, which is freed
+    template <typename Table, typename ItemType, typename KeyExtractor>
+    std::shared_ptr<Table> BuildTable(
+        std::vector<ItemType>& vec, const KeyExtractor& key_extractor) {
+        std::shared_ptr<Table> table = std::make_shared<Table>(
+            vec.size(), hash_function_);
+        for (ItemType& item : vec) {
+            Key key = key_extractor(item);
+            table->emplace(std::move(key), std::move(item));
+        }
+        tlx::vector_free(vec);
+        return table;
+    }
+
+    //! probe the hash table of the first input with the second input in file
+    void ProbeTable1(data::File& file, bool consume) {
+        data::File::Reader reader = file.GetReader(consume);
+        while (reader.HasNext()) {
+            InputTypeSecond in2 = reader.template Next<InputTypeSecond>();
+            auto range = hash_table1_->equal_range(key_extractor2_(in2));
+            for (auto it = range.first; it != range.second; ++it)
+                this->PushItem(join_function_(it->second, in2));
+        }
+    }
+
+    //! probe the hash table of the second input with the first input in file
+    void ProbeTable2(data::File& file, bool consume) {
+        data::File::Reader reader = file.GetReader(consume);
+        while (reader.HasNext()) {
+            InputTypeFirst in1 = reader.template Next<InputTypeFirst>();
+            auto range = hash_table2_->equal_range(key_extractor1_(in1));
+            for (auto it = range.first; it != range.second; ++it)
+                this->PushItem(join_function_(in1, it->second));
+        }
     }
 
     template <typename ItemType>
@@ -449,7 +894,8 @@ private:
     }
 
     DIAMemUse PreOpMemUse() final {
-        return DIAMemUse::Max();
+        return DIAMemUse::Max(
+            std::max(sizeof(InputTypeFirst), sizeof(InputTypeSecond)));
     }
 
     void StartPreOp(size_t parent_index) final {
@@ -485,31 +931,33 @@ private:
     }
 
     DIAMemUse PushDataMemUse() final {
-        return DIAMemUse::Max();
+        return DIAMemUse::Max(
+            std::max(sizeof(InputTypeFirst), sizeof(InputTypeSecond)));
     }
 
     /*!
-     * Recieve all elements from a stream and write them to files sorted by key.
+     * Recieve all elements from a stream and write them to files, sorted by
+     * key if sort is set, whenever vec is full. The last items remain in vec.
      */
     template <typename ItemType, typename KeyExtractor>
     void ReceiveItems(
         size_t capacity, data::MixStream::MixReader& reader,
-        std::deque<data::File>& files, const KeyExtractor& key_extractor) {
+        std::deque<data::File>& files, const KeyExtractor& key_extractor,
+        std::vector<ItemType>& vec, bool sort) {
 
-        std::vector<ItemType> vec;
         vec.reserve(capacity);
 
         while (reader.HasNext()) {
             if (vec.size() < capacity) {
                 vec.push_back(reader.template Next<ItemType>());
             }
-            else {
+            else if (sort) {
                 SortAndWriteToFile(vec, files, key_extractor);
             }
+            else {
+                WriteToFile(vec, files);
+            }
         }
-
-        if (vec.size())
-            SortAndWriteToFile(vec, files, key_extractor);
     }
 
     /*!
@@ -642,6 +1090,22 @@ private:
         }
     }
 
+    /*!
+     * Writes all elements in a vector unsorted to a file, and frees it.
+     */
+    template <typename ItemType>
+    void WriteToFile(std::vector<ItemType>& vec, std::deque<data::File>& files) {
+        if (vec.size()) {
+            files.emplace_back(context_.GetFile(this));
+            auto writer = files.back().GetWriter();
+            for (const ItemType& elem : vec) {
+                writer.Put(elem);
+            }
+            writer.Close();
+        }
+        tlx::vector_free(vec);
+    }
+
     /*!
      * Sorts all elements in a vector and writes them to a file.
      */
@@ -696,6 +1160,8 @@ private:
  *
  * \param hash_function If necessary a hash funtion for Key
  *
+ * \param join_config Configuration, e.g. of the broadcast join
+ *
  * \ingroup dia_dops_free
  */
 template <
@@ -706,13 +1172,15 @@ template <
     typename KeyExtractor2,
     typename JoinFunction,
     typename HashFunction =
-        std::hash<typename common::FunctionTraits<KeyExtractor1>::result_type> >
+        std::hash<typename common::FunctionTraits<KeyExtractor1>::result_type>,
+    typename JoinConfig = DefaultJoinConfig>
 auto InnerJoin(
     const LocationDetectionFlag<LocationDetectionValue>&,
     const FirstDIA& first_dia, const SecondDIA& second_dia,
     const KeyExtractor1& key_extractor1, const KeyExtractor2& key_extractor2,
     const JoinFunction& join_function,
-    const HashFunction& hash_function = HashFunction()) {
+    const HashFunction& hash_function = HashFunction(),
+    const JoinConfig& join_config = JoinConfig()) {
 
     assert(first_dia.IsValid());
     assert(second_dia.IsValid());
@@ -757,11 +1225,11 @@ auto InnerJoin(
 
     using JoinNode = api::JoinNode<
         JoinResult, FirstDIA, SecondDIA, KeyExtractor1, KeyExtractor2,
-        JoinFunction, HashFunction, LocationDetectionValue>;
+        JoinFunction, HashFunction, LocationDetectionValue, JoinConfig>;
 
     auto node = tlx::make_counting<JoinNode>(
         first_dia, second_dia, key_extractor1, key_extractor2, join_function,
-        hash_function);
+        hash_function, join_config);
 
     return DIA<JoinResult>(node);
 }
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * thrill/api/iterate.hpp
+ *
+ * Loop construct for iterative algorithms on a DIA state.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_ITERATE_HEADER
+#define THRILL_API_ITERATE_HEADER
+
+#include <thrill/api/cache.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/common/logger.hpp>
+
+namespace thrill {
+namespace api {
+
+//! \ingroup api_layer
+//! \{
+
+/*!
+ * Run an iterative algorithm: the state DIA is replaced by body(state, iter)
+ * for iter = 0 .. iterations - 1, and the final state is returned.
+ *
+ * The state of each iteration is materialized with Cache() and executed
+ * before the next iteration is built. Hence, the DIA graph does not grow with
+ * the number of iterations, and the nodes of the previous iteration (including
+ * their reduce tables and data::Files) are released right away, such that
+ * their memory is reused by the next iteration. Loop-invariant inputs should be
+ * cached once outside the loop and captured by the body.
+ *
+ * \param iterations number of iterations to run
+ *
+ * \param initial initial state DIA
+ *
+ * \param body function DIA<ValueType> (const DIA<ValueType>& state, size_t
+ * iter) calculating the next state, which may also return a DIA with a
+ * function stack.
+ */
+template <typename ValueType, typename Stack, typename Body>
+DIA<ValueType> Iterate(size_t iterations,
+                       const DIA<ValueType, Stack>& initial, const Body& body) {
+    static constexpr bool debug = false;
+
+    DIA<ValueType> state = initial.Cache();
+
+    for (size_t iter = 0; iter < iterations; ++iter) {
+        DIA<ValueType> next = body(state, iter).Cache();
+        next.Execute();
+
+        sLOG << "Iterate(): finished iteration" << iter;
+
+        // releases the nodes of the previous iteration
+        state = next;
+    }
+
+    return state;
+}
+
+//! \}
+
+} // namespace api
+
+//! imported from api namespace
+using api::Iterate;
+
+} // namespace thrill
+
+#endif // !THRILL_API_ITERATE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * thrill/api/job_scheduler.cpp
+ *
+ * Shortest-job-first admission queue of job requests for a Thrill daemon,
+ * which admits them by their RAM.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/job_scheduler.hpp>
+
+#include <thrill/common/logger.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace thrill {
+namespace api {
+
+JobScheduler::JobScheduler(size_t ram_limit, double max_wait)
+    : ram_limit_(ram_limit),
+      max_wait_(std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(max_wait))) { }
+
+bool JobScheduler::Submit(
+    const std::string& name, size_t ram, double estimated_time) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Request r { name, ram, estimated_time, Clock::now() };
+    if (closed_ || !Admit(r)) {
+        ++num_rejected_;
+        return false;
+    }
+    queue_.emplace_back(std::move(r));
+    cv_.notify_one();
+    return true;
+}
+
+std::string JobScheduler::Next() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // drop requests exceeding a limit set after their submission
+        auto end = std::remove_if(
+            queue_.begin(), queue_.end(),
+            [this](const Request& r) {
+                if (Admit(r)) return false;
+                LOG1 << "JobScheduler: rejected job " << r.name
+                     << " requesting " << r.ram << " bytes RAM";
+                return true;
+            });
+        num_rejected_ += static_cast<size_t>(queue_.end() - end);
+        queue_.erase(end, queue_.end());
+
+        if (!queue_.empty()) break;
+        if (closed_) return std::string();
+        cv_.wait(lock);
+    }
+
+    // the oldest request, if it waited too long, otherwise the shortest, and
+    // the oldest among equally short ones.
+    auto it = queue_.begin();
+    if (Clock::now() - it->submitted <= max_wait_) {
+        it = std::min_element(
+            queue_.begin(), queue_.end(),
+            [](const Request& a, const Request& b) {
+                return a.estimated_time < b.estimated_time;
+            });
+    }
+
+    std::string name = std::move(it->name);
+    queue_.erase(it);
+    return name;
+}
+
+void JobScheduler::Close() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    closed_ = true;
+    cv_.notify_all();
+}
+
+void JobScheduler::set_ram_limit(size_t ram_limit) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ram_limit_ = ram_limit;
+}
+
+size_t JobScheduler::ram_limit() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return ram_limit_;
+}
+
+size_t JobScheduler::size() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+size_t JobScheduler::num_rejected() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return num_rejected_;
+}
+
+} // namespace api
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,142 @@
+/*******************************************************************************
+ * thrill/api/job_scheduler.hpp
+ *
+ * Shortest-job-first admission queue of job requests for a Thrill daemon,
+ * which admits them by their RAM.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_JOB_SCHEDULER_HEADER
+#define THRILL_API_JOB_SCHEDULER_HEADER
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+//! \ingroup api_layer
+//! \{
+
+/*!
+ * Queue of job requests for a daemon serving jobs with Context::ServeJobs()
+ * or RunDaemon(). Clients submit requests from any thread, e.g. one reading a
+ * socket, each with the name of the job, the RAM per host it needs for DIA
+ * operations, and an estimate of its run time.
+ *
+ * Next(), which the daemon's master calls for each job, returns the request
+ * with the shortest estimated run time, such that short jobs do not queue
+ * behind long ones. A request which waited longer than max_wait seconds is
+ * returned first regardless, hence long jobs do not starve. Requests are
+ * admitted only if their RAM does not exceed ram_limit(), which the daemon
+ * sets to MemoryConfig::ram_workers_ of its hosts. Others are rejected by
+ * Submit(), or dropped by Next() if the limit was set later.
+ *
+ * The scheduler only orders and admits jobs. They run one after another on
+ * all workers of the daemon, each with the full RAM of the hosts: jobs are not
+ * run concurrently on disjoint worker subsets, and the BlockPool is not
+ * partitioned among them.
+ */
+class JobScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! a job request
+    struct Request {
+        //! name of the job in the daemon's jobs map
+        std::string name;
+        //! RAM per host requested for DIA operations
+        size_t ram;
+        //! estimated run time in seconds
+        double estimated_time;
+        //! time of submission
+        Clock::time_point submitted;
+    };
+
+    //! Constructor with the RAM limit per host, 0 for none yet, and the
+    //! maximum wait in seconds before a request is preferred.
+    explicit JobScheduler(size_t ram_limit = 0, double max_wait = 60.0);
+
+    //! non-copyable: delete copy-constructor
+    JobScheduler(const JobScheduler&) = delete;
+    //! non-copyable: delete assignment operator
+    JobScheduler& operator = (const JobScheduler&) = delete;
+
+    //! Submit a job request. Returns false if it was rejected, because it
+    //! needs more RAM than the limit or the scheduler was closed.
+    bool Submit(const std::string& name, size_t ram = 0,
+                double estimated_time = 0);
+
+    //! Wait for the next admitted request and return its name. Returns an
+    //! empty string once the scheduler is closed and all requests were run.
+    std::string Next();
+
+    //! Accept no further requests, Next() returns the remaining ones.
+    void Close();
+
+    //! Set the RAM limit per host, 0 for none.
+    void set_ram_limit(size_t ram_limit);
+
+    //! \name Accessors
+    //! \{
+
+    //! RAM limit per host for admitted requests
+    size_t ram_limit() const;
+
+    //! number of waiting requests
+    size_t size() const;
+
+    //! number of rejected requests
+    size_t num_rejected() const;
+
+    //! \}
+
+private:
+    //! protects all members
+    mutable std::mutex mutex_;
+
+    //! signaled on Submit() and Close()
+    std::condition_variable cv_;
+
+    //! waiting requests in order of submission
+    std::vector<Request> queue_;
+
+    //! RAM limit per host, 0 for none
+    size_t ram_limit_;
+
+    //! maximum wait before a request is preferred
+    Clock::duration max_wait_;
+
+    //! whether Close() was called
+    bool closed_ = false;
+
+    //! number of rejected requests
+    size_t num_rejected_ = 0;
+
+    //! whether a request is admitted by the RAM limit
+    bool Admit(const Request& r) const {
+        return ram_limit_ == 0 || r.ram <= ram_limit_;
+    }
+};
+
+//! \}
+
+} // namespace api
+
+//! imported from api namespace
+using api::JobScheduler;
+
+} // namespace thrill
+
+#endif // !THRILL_API_JOB_SCHEDULER_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * thrill/api/map_partitions.hpp
+ *
+ * DIANode which applies a function to all items of each worker at once.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_MAP_PARTITIONS_HEADER
+#define THRILL_API_MAP_PARTITIONS_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/data/file.hpp>
+
+#include <utility>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Typed reader over the items of one worker, which MapPartitions() passes to
+ * the user function. Items are deserialized directly from the blocks of the
+ * node's data::File.
+ */
+template <typename ValueType>
+class MapPartitionsReader
+{
+public:
+    MapPartitionsReader(data::File::Reader&& reader, size_t size)
+        : reader_(std::move(reader)), size_(size) { }
+
+    //! whether another item is available
+    bool HasNext() { return reader_.HasNext(); }
+
+    //! read the next item
+    ValueType Next() { return reader_.template Next<ValueType>(); }
+
+    //! number of items of the worker
+    size_t size() const { return size_; }
+
+private:
+    data::File::Reader reader_;
+    size_t size_;
+};
+
+/*!
+ * A DIANode which stores the local items in a data::File, without any
+ * exchange, and runs the user function once over all of them in PushData().
+ * If the parent's function stack is empty, its File is taken over without
+ * copying the items.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename InputType, typename PartitionFunction>
+class MapPartitionsNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+public:
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    template <typename ParentDIA>
+    MapPartitionsNode(const ParentDIA& parent,
+                      const PartitionFunction& partition_function)
+        : Super(parent.ctx(), "MapPartitions",
+                { parent.id() }, { parent.node() }),
+          partition_function_(partition_function),
+          parent_stack_empty_(ParentDIA::stack_empty) {
+
+        auto save_fn = [this](const InputType& input) {
+                           writer_.Put(input);
+                       };
+        auto lop_chain = parent.stack().push(save_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
+        if (!parent_stack_empty_) {
+            LOGC(common::g_debug_push_file)
+                << "MapPartitions rejected File from parent "
+                << "due to non-empty function stack.";
+            return false;
+        }
+        assert(file_.num_items() == 0);
+        file_ = file.Copy();
+        return true;
+    }
+
+    void StopPreOp(size_t /* parent_index */) final {
+        writer_.Close();
+    }
+
+    void Execute() final { }
+
+    void PushData(bool consume) final {
+        MapPartitionsReader<InputType> reader(
+            file_.GetReader(consume), file_.num_items());
+        partition_function_(
+            reader, [this](const ValueType& item) { this->PushItem(item); });
+    }
+
+    void Dispose() final {
+        file_.Clear();
+    }
+
+private:
+    PartitionFunction partition_function_;
+
+    //! Local data file
+    data::File file_ { context_.GetFile(this) };
+    //! Data writer to local file (only active in PreOp).
+    data::File::Writer writer_ { file_.GetWriter() };
+    //! Whether the parent stack is empty
+    const bool parent_stack_empty_;
+};
+
+template <typename ValueType, typename Stack>
+template <typename ValueOut, typename PartitionFunction>
+auto DIA<ValueType, Stack>::MapPartitions(
+    const PartitionFunction& partition_function) const {
+    assert(IsValid());
+
+    using MapPartitionsNode =
+        api::MapPartitionsNode<ValueOut, ValueType, PartitionFunction>;
+    return DIA<ValueOut>(
+        tlx::make_counting<MapPartitionsNode>(*this, partition_function));
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_MAP_PARTITIONS_HEADER
+
+/******************************************************************************/
@@ -45,9 +45,10 @@ namespace api {
  * before merging, so each worker has the same amount of data when merge
  * finishes.
  *
- * The algorithm performs a distributed multi-sequence selection by picking
- * random pivots (from the largest remaining interval) for each DIA. The pivots
- * are selected via a global AllReduce. There is one pivot per DIA.
+ * The algorithm performs a distributed multi-sequence selection of all p-1
+ * splitters concurrently. In each round, kPivotsPerSplitter random pivots are
+ * sampled for each splitter, stratified over the largest remaining interval of
+ * all Files. The pivots are selected via a global AllReduce.
  *
  * Then the pivots are searched for in the interval [left,left + width) in each
  * local File's partition, where these are initialized with left = 0 and width =
@@ -55,9 +56,12 @@ namespace api {
  * the corresponding global_ranks of each pivot is calculated via a AllReduce.
  *
  * The global_ranks are then compared to the target_ranks (which are n/p *
- * rank). If global_ranks is smaller, the interval [left,left + width) is
- * reduced to [left,idx), where idx is the rank of the pivot in the local
- * File. If global_ranks is larger, the interval is reduced to [idx,left+width).
+ * rank). The interval [left,left + width) is reduced to the local ranks of the
+ * two pivots enclosing the target rank: the largest pivot with smaller global
+ * rank and the smallest pivot with larger global rank. Each round hence cuts
+ * the interval into kPivotsPerSplitter + 1 parts instead of two, which reduces
+ * the number of latency-bound rounds by a factor of log2(kPivotsPerSplitter +
+ * 1), while the local File searches remain cheap.
  *
  * left  -> width
  * V            V      V           V         V                   V
@@ -86,6 +90,9 @@ class MergeNode : public DOpNode<ValueType>
 
     static_assert(kNumInputs >= 2, "Merge requires at least two inputs.");
 
+    //! number of pivots sampled for each splitter in each round
+    static constexpr size_t kPivotsPerSplitter = 16;
+
 public:
     template <typename ParentDIA0, typename... ParentDIAs>
     MergeNode(const Comparator& comparator,
@@ -163,18 +170,19 @@ public:
 
         stats_.merge_timer_.Start();
 
-        // get inbound readers from all Channels
-        std::vector<data::CatStream::CatReader> readers;
-        readers.reserve(kNumInputs);
-
-        for (size_t i = 0; i < kNumInputs; i++)
-            readers.emplace_back(streams_[i]->GetCatReader(consume));
-
-        auto puller = core::make_multiway_merge_tree<ValueType>(
-            readers.begin(), readers.end(), comparator_);
-
-        while (puller.HasNext())
-            this->PushItem(puller.Next());
+        // get inbound readers from all Channels. The first consuming read
+        // takes the blocks from the queues with statically dispatched sources.
+        if (consume && !streams_read_) {
+            MergeStreams([](data::CatStream& stream) {
+                             return stream.GetConsumeCatReader();
+                         });
+        }
+        else {
+            MergeStreams([consume](data::CatStream& stream) {
+                             return stream.GetCatReader(consume);
+                         });
+        }
+        streams_read_ = true;
 
         stats_.merge_timer_.Stop();
 
@@ -193,6 +201,9 @@ private:
     //! Whether the parent stack is empty
     const std::array<bool, kNumInputs> parent_stack_empty_;
 
+    //! whether PushData() has read the streams_ of the last MainOp()
+    bool streams_read_ = false;
+
     //! Files for intermediate storage
     data::FilePtr files_[kNumInputs];
 
@@ -262,7 +273,7 @@ private:
         StatsTimer scatter_timer_;
         //! The count of all elements processed on this host.
         size_t result_size_ = 0;
-        //! The count of search iterations needed for balancing.
+        //! The count of search rounds needed for balancing.
         size_t iterations_ = 0;
 
         void PrintToSQLPlotTool(
@@ -320,15 +331,16 @@ private:
      * \param width The width of all search ranges for all files.  The first
      * index identifies the splitter, the second index identifies the file.
      *
-     * \param out_pivots The output pivots.
+     * \param out_pivots The output pivots, kPivotsPerSplitter for each
+     * splitter.
      */
     void SelectPivots(
         const std::vector<ArrayNumInputsSizeT>& left,
         const std::vector<ArrayNumInputsSizeT>& width,
         std::vector<Pivot>& out_pivots) {
 
-        // Select a random pivot for the largest range we have for each
-        // splitter.
+        // Select random pivots for the largest range we have for each
+        // splitter, one from each kPivotsPerSplitter-th of the range.
         for (size_t s = 0; s < width.size(); s++) {
             size_t mp = 0;
 
@@ -339,25 +351,30 @@ private:
                 }
             }
 
-            // We can leave pivot_elem uninitialized.  If it is not initialized
-            // below, then an other worker's pivot will be taken for this range,
-            // since our range is zero.
-            ValueType pivot_elem = ValueType();
-            size_t pivot_idx = left[s][mp];
+            for (size_t j = 0; j < kPivotsPerSplitter; j++) {
+                // We can leave pivot_elem uninitialized.  If it is not
+                // initialized below, then an other worker's pivot will be taken
+                // for this range, since our range is zero.
+                ValueType pivot_elem = ValueType();
+                size_t pivot_idx = left[s][mp];
+
+                if (width[s][mp] > 0) {
+                    pivot_idx = left[s][mp] + (
+                        j * width[s][mp] + context_.rng_() % width[s][mp])
+                                / kPivotsPerSplitter;
+                    assert(pivot_idx < files_[mp]->num_items());
+                    stats_.file_op_timer_.Start();
+                    pivot_elem =
+                        files_[mp]->template GetItemAt<ValueType>(pivot_idx);
+                    stats_.file_op_timer_.Stop();
+                }
 
-            if (width[s][mp] > 0) {
-                pivot_idx = left[s][mp] + (context_.rng_() % width[s][mp]);
-                assert(pivot_idx < files_[mp]->num_items());
-                stats_.file_op_timer_.Start();
-                pivot_elem = files_[mp]->template GetItemAt<ValueType>(pivot_idx);
-                stats_.file_op_timer_.Stop();
+                out_pivots[s * kPivotsPerSplitter + j] = Pivot {
+                    pivot_elem,
+                    pivot_idx,
+                    width[s][mp]
+                };
             }
-
-            out_pivots[s] = Pivot {
-                pivot_elem,
-                pivot_idx,
-                width[s][mp]
-            };
         }
 
         LOG << "local pivots: " << VToStr(out_pivots);
@@ -371,8 +388,9 @@ private:
     }
 
     /*!
-     * Calculates the global ranks of the given pivots.
-     * Additionally returns the local ranks so we can use them in the next step.
+     * Calculates the global ranks of the given pivots, where pivot i belongs to
+     * splitter i / kPivotsPerSplitter.  Additionally returns the local ranks
+     * so we can use them in the next step.
      */
     void GetGlobalRanks(
         const std::vector<Pivot>& pivots,
@@ -383,22 +401,23 @@ private:
 
         // Simply get the rank of each pivot in each file. Sum the ranks up
         // locally.
-        for (size_t s = 0; s < pivots.size(); s++) {
+        for (size_t k = 0; k < pivots.size(); k++) {
+            size_t s = k / kPivotsPerSplitter;
             size_t rank = 0;
             for (size_t i = 0; i < kNumInputs; i++) {
                 stats_.file_op_timer_.Start();
 
                 size_t idx = files_[i]->GetIndexOf(
-                    pivots[s].value, pivots[s].tie_idx,
+                    pivots[k].value, pivots[k].tie_idx,
                     left[s][i], left[s][i] + width[s][i],
                     comparator_);
 
                 stats_.file_op_timer_.Stop();
 
                 rank += idx;
-                out_local_ranks[s][i] = idx;
+                out_local_ranks[k][i] = idx;
             }
-            global_ranks[s] = rank;
+            global_ranks[k] = rank;
         }
 
         stats_.comm_timer_.Start();
@@ -409,11 +428,17 @@ private:
     }
 
     /*!
-     * Shrinks the search ranges according to the global ranks of the pivots.
+     * Shrinks the search ranges according to the global ranks of the pivots,
+     * and selects the pivot closest to the target rank of each splitter.
+     *
+     * The ranks of the pivots of one splitter are monotonic in every file,
+     * since the pivots are ordered by value and tie index. Hence the range of
+     * each file is reduced to the local ranks of the two pivots enclosing the
+     * target rank.
      *
      * \param global_ranks The global ranks of all pivots.
      *
-     * \param local_ranks The local ranks of each pivot in each file.
+     * \param pivot_ranks The local ranks of each pivot in each file.
      *
      * \param target_ranks The desired ranks of the splitters we are looking
      * for.
@@ -425,39 +450,87 @@ private:
      * \param width The width of all search ranges for all files.  The first
      * index identifies the splitter, the second index identifies the file.
      * This parameter will be modified.
+     *
+     * \param out_best_ranks The global rank of the pivot closest to the target
+     * rank of each splitter.
+     *
+     * \param out_local_ranks The local ranks of the pivot closest to the
+     * target rank of each splitter.
      */
     void SearchStep(
         const std::vector<size_t>& global_ranks,
-        const std::vector<ArrayNumInputsSizeT>& local_ranks,
+        const std::vector<ArrayNumInputsSizeT>& pivot_ranks,
         const std::vector<size_t>& target_ranks,
         std::vector<ArrayNumInputsSizeT>& left,
-        std::vector<ArrayNumInputsSizeT>& width) {
+        std::vector<ArrayNumInputsSizeT>& width,
+        std::vector<size_t>& out_best_ranks,
+        std::vector<ArrayNumInputsSizeT>& out_local_ranks) {
 
         for (size_t s = 0; s < width.size(); s++) {
-            for (size_t p = 0; p < width[s].size(); p++) {
+            ArrayNumInputsSizeT lo = left[s], hi;
+            for (size_t p = 0; p < width[s].size(); p++)
+                hi[p] = left[s][p] + width[s][p];
 
-                if (width[s][p] == 0)
-                    continue;
+            size_t best = s * kPivotsPerSplitter;
 
-                size_t local_rank = local_ranks[s][p];
-                size_t old_width = width[s][p];
-                assert(left[s][p] <= local_rank);
+            for (size_t j = 0; j < kPivotsPerSplitter; j++) {
+                size_t k = s * kPivotsPerSplitter + j;
 
-                if (global_ranks[s] < target_ranks[s]) {
-                    width[s][p] -= local_rank - left[s][p];
-                    left[s][p] = local_rank;
-                }
-                else if (global_ranks[s] >= target_ranks[s]) {
-                    width[s][p] = local_rank - left[s][p];
+                if (tlx::abs_diff(global_ranks[k], target_ranks[s]) <
+                    tlx::abs_diff(global_ranks[best], target_ranks[s]))
+                    best = k;
+
+                for (size_t p = 0; p < width[s].size(); p++) {
+
+                    if (width[s][p] == 0)
+                        continue;
+
+                    size_t local_rank = pivot_ranks[k][p];
+                    assert(left[s][p] <= local_rank);
+                    assert(local_rank <= left[s][p] + width[s][p]);
+
+                    if (global_ranks[k] < target_ranks[s])
+                        lo[p] = std::max(lo[p], local_rank);
+                    else
+                        hi[p] = std::min(hi[p], local_rank);
                 }
+            }
+
+            for (size_t p = 0; p < width[s].size(); p++) {
+                if (width[s][p] == 0)
+                    continue;
 
                 if (debug) {
-                    die_unless(width[s][p] <= old_width);
+                    die_unless(lo[p] <= hi[p]);
                 }
+                left[s][p] = lo[p];
+                width[s][p] = hi[p] - lo[p];
             }
+
+            out_best_ranks[s] = global_ranks[best];
+            out_local_ranks[s] = pivot_ranks[best];
         }
     }
 
+    //! Merges the readers returned by get_reader(stream) of all streams_ and
+    //! pushes the output.
+    template <typename GetReader>
+    void MergeStreams(const GetReader& get_reader) {
+        using Reader = decltype(get_reader(*streams_[0]));
+
+        std::vector<Reader> readers;
+        readers.reserve(kNumInputs);
+
+        for (size_t i = 0; i < kNumInputs; i++)
+            readers.emplace_back(get_reader(*streams_[i]));
+
+        auto puller = core::make_multiway_merge_tree<ValueType>(
+            readers.begin(), readers.end(), comparator_);
+
+        while (puller.HasNext())
+            this->PushItem(puller.Next());
+    }
+
     /*!
      * Receives elements from other workers and re-balance them, so each worker
      * has the same amount after merging.
@@ -521,14 +594,18 @@ private:
             stats_.comm_timer_.Stop();
         }
 
-        // buffer for the global ranks of selected pivots
-        std::vector<size_t> global_ranks(p - 1);
+        // buffer for the global ranks of selected pivots, and of the best
+        // pivot for each splitter
+        std::vector<size_t> global_ranks((p - 1) * kPivotsPerSplitter);
+        std::vector<size_t> best_ranks(p - 1);
 
         // Search range bounds.
         std::vector<ArrayNumInputsSizeT> left(p - 1), width(p - 1);
 
         // Auxillary arrays.
-        std::vector<Pivot> pivots(p - 1);
+        std::vector<Pivot> pivots((p - 1) * kPivotsPerSplitter);
+        std::vector<ArrayNumInputsSizeT> pivot_ranks(
+            (p - 1) * kPivotsPerSplitter);
         std::vector<ArrayNumInputsSizeT> local_ranks(p - 1);
 
         // Initialize all lefts with 0 and all widths with size of their
@@ -570,12 +647,16 @@ private:
 
             // Get global ranks and shrink ranges.
             stats_.search_step_timer_.Start();
-            GetGlobalRanks(pivots, global_ranks, local_ranks, left, width);
+            GetGlobalRanks(pivots, global_ranks, pivot_ranks, left, width);
 
             LOG << "global_ranks: " << global_ranks;
-            LOG << "local_ranks: " << local_ranks;
+            LOG << "pivot_ranks: " << pivot_ranks;
+
+            SearchStep(global_ranks, pivot_ranks, target_ranks, left, width,
+                       best_ranks, local_ranks);
 
-            SearchStep(global_ranks, local_ranks, target_ranks, left, width);
+            LOG << "best_ranks: " << best_ranks;
+            LOG << "local_ranks: " << local_ranks;
 
             if (debug) {
                 for (size_t q = 0; q < kNumInputs; q++) {
@@ -591,7 +672,7 @@ private:
             // We check for accuracy of kNumInputs + 1
             finished = true;
             for (size_t i = 0; i < p - 1; i++) {
-                size_t a = global_ranks[i], b = target_ranks[i];
+                size_t a = best_ranks[i], b = target_ranks[i];
                 if (tlx::abs_diff(a, b) > kNumInputs + 1) {
                     finished = false;
                     break;
@@ -610,6 +691,7 @@ private:
         // Initialize channels for distributing data.
         for (size_t j = 0; j < kNumInputs; j++)
             streams_[j] = context_.GetNewCatStream(this);
+        streams_read_ = false;
 
         stats_.scatter_timer_.Start();
 
@@ -0,0 +1,411 @@
+/*******************************************************************************
+ * thrill/api/merge_join.hpp
+ *
+ * DIANode for an inner join of two DIAs which are sorted by the join key.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_MERGE_JOIN_HEADER
+#define THRILL_API_MERGE_JOIN_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/function_traits.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/data/file.hpp>
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Performs an inner join of two DIAs, which are both globally sorted by their
+ * join keys, e.g. by Sort() or Merge(). Instead of hash partitioning both
+ * inputs, the first input stays on its workers, except for the leading items
+ * of a key which spans several workers, which are sent to the first of them.
+ * The second input is then split at the key ranges of the first input's
+ * workers with Scatter(), hence each item moves at most to the worker holding
+ * the range of its key. Both received inputs are still sorted and are joined
+ * in one streaming merge pass, without sorting or hash tables. Only the items
+ * of one key of the second input are held in RAM.
+ *
+ * Keys are compared with operator <. The order of the inputs is verified while
+ * receiving and joining them, and an unsorted input aborts the program.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename FirstDIA, typename SecondDIA,
+          typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction>
+class MergeJoinNode final : public DOpNode<ValueType>
+{
+private:
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using InputTypeFirst = typename FirstDIA::ValueType;
+    using InputTypeSecond = typename SecondDIA::ValueType;
+
+    //! Key type of join. must be equal to the other key extractor
+    using Key = typename common::FunctionTraits<KeyExtractor1>::result_type;
+
+    //! whether a worker has items of the first input, its first and last key
+    using RangeInfo = std::tuple<bool, Key, Key>;
+
+    //! combine the RangeInfo of disjoint workers in AllReduce
+    struct RangeInfoMerge {
+        RangeInfo operator () (const RangeInfo& a, const RangeInfo& b) const {
+            return std::get<0>(a) ? a : b;
+        }
+    };
+
+public:
+    /*!
+     * Constructor for a MergeJoinNode.
+     */
+    MergeJoinNode(const FirstDIA& parent1, const SecondDIA& parent2,
+                  const KeyExtractor1& key_extractor1,
+                  const KeyExtractor2& key_extractor2,
+                  const JoinFunction& join_function)
+        : Super(parent1.ctx(), "MergeJoin",
+                { parent1.id(), parent2.id() },
+                { parent1.node(), parent2.node() }),
+          key_extractor1_(key_extractor1),
+          key_extractor2_(key_extractor2),
+          join_function_(join_function) {
+        auto pre_op_fn1 = [this](const InputTypeFirst& input) {
+                              PreOp1(input);
+                          };
+
+        auto pre_op_fn2 = [this](const InputTypeSecond& input) {
+                              PreOp2(input);
+                          };
+
+        auto lop_chain1 = parent1.stack().push(pre_op_fn1).fold();
+        auto lop_chain2 = parent2.stack().push(pre_op_fn2).fold();
+        parent1.node()->AddChild(this, lop_chain1, 0);
+        parent2.node()->AddChild(this, lop_chain2, 1);
+    }
+
+    void StartPreOp(size_t parent_index) final {
+        if (parent_index == 0)
+            writer1_ = file1_.GetWriter();
+        else
+            writer2_ = file2_.GetWriter();
+    }
+
+    //! store item of the first input, and count the leading items of its
+    //! first key
+    void PreOp1(const InputTypeFirst& input) {
+        const Key key = key_extractor1_(input);
+        if (items1_ == 0) {
+            first1_ = key;
+        }
+        else if (key < last1_) {
+            die("MergeJoin: first input is not sorted by key");
+        }
+        if (leading1_ == items1_ && KeyEqual(key, first1_))
+            ++leading1_;
+        last1_ = key;
+        ++items1_;
+        writer1_.Put(input);
+    }
+
+    //! store item of the second input
+    void PreOp2(const InputTypeSecond& input) {
+        writer2_.Put(input);
+    }
+
+    void StopPreOp(size_t parent_index) final {
+        if (parent_index == 0)
+            writer1_.Close();
+        else
+            writer2_.Close();
+    }
+
+    void Execute() final {
+        const size_t p = context_.num_workers();
+        const size_t my_rank = context_.my_rank();
+
+        // collect the key ranges of the first input on all workers
+        std::vector<RangeInfo> infos(p);
+        infos[my_rank] = RangeInfo(items1_ != 0, first1_, last1_);
+        infos = context_.net.AllReduce(
+            infos, common::ComponentSum<std::vector<RangeInfo>, RangeInfoMerge>());
+
+        // determine the worker which joins the first key of each worker: the
+        // first worker holding the key.
+        owner_.resize(p);
+        const RangeInfo* prev = nullptr;
+        for (size_t w = 0; w < p; ++w) {
+            owner_[w] = w;
+            if (!std::get<0>(infos[w])) continue;
+            if (prev != nullptr) {
+                if (std::get<1>(infos[w]) < std::get<2>(*prev))
+                    die("MergeJoin: first input is not sorted by key");
+                if (KeyEqual(std::get<1>(infos[w]), std::get<2>(*prev)))
+                    owner_[w] = owner_[prev - infos.data()];
+            }
+            prev = &infos[w];
+            starts_.push_back(w);
+        }
+
+        stream1_ = context_.GetNewCatStream(this);
+        stream2_ = context_.GetNewCatStream(this);
+
+        // send the leading items of the first key to its owner, keep the rest
+        std::vector<size_t> offsets(p + 1);
+        for (size_t r = 0; r <= p; ++r) {
+            offsets[r] = r <= owner_[my_rank] ? 0 :
+                         r <= my_rank ? leading1_ : items1_;
+        }
+        LOG << "MergeJoin: scatter first input " << offsets;
+        stream1_->template ScatterConsume<InputTypeFirst>(file1_, offsets);
+
+        // split the second input at the key ranges of the first input
+        std::fill(offsets.begin(), offsets.end(), 0);
+        {
+            auto reader = file2_.GetKeepReader();
+            size_t prev_target = 0;
+            while (reader.HasNext()) {
+                size_t target = Target(
+                    infos, key_extractor2_(
+                        reader.template Next<InputTypeSecond>()));
+                if (target < prev_target)
+                    die("MergeJoin: second input is not sorted by key");
+                prev_target = target;
+                ++offsets[target + 1];
+            }
+        }
+        for (size_t r = 1; r <= p; ++r)
+            offsets[r] += offsets[r - 1];
+        LOG << "MergeJoin: scatter second input " << offsets;
+        stream2_->template ScatterConsume<InputTypeSecond>(file2_, offsets);
+    }
+
+    void PushData(bool consume) final {
+        auto reader1 = stream1_->GetCatReader(consume);
+        auto reader2 = stream2_->GetCatReader(consume);
+
+        if (!reader1.HasNext() || !reader2.HasNext()) return;
+
+        InputTypeFirst item1 = reader1.template Next<InputTypeFirst>();
+        InputTypeSecond item2 = reader2.template Next<InputTypeSecond>();
+        bool has1 = true, has2 = true;
+
+        // items of the second input with the current key
+        std::vector<InputTypeSecond> group2;
+
+        while (has1 && has2) {
+            const Key key1 = key_extractor1_(item1);
+            const Key key2 = key_extractor2_(item2);
+
+            if (key1 < key2) {
+                has1 = Advance1(reader1, item1, key1);
+            }
+            else if (key2 < key1) {
+                has2 = Advance2(reader2, item2, key2);
+            }
+            else {
+                // collect the second input's items of the key
+                do {
+                    group2.emplace_back(item2);
+                    has2 = Advance2(reader2, item2, key2);
+                } while (has2 && KeyEqual(key_extractor2_(item2), key1));
+
+                // join each item of the first input with the key with them
+                do {
+                    for (const InputTypeSecond& i2 : group2)
+                        this->PushItem(join_function_(item1, i2));
+                    has1 = Advance1(reader1, item1, key1);
+                } while (has1 && KeyEqual(key_extractor1_(item1), key1));
+
+                group2.clear();
+            }
+        }
+    }
+
+    void Dispose() final {
+        file1_.Clear();
+        file2_.Clear();
+        stream1_.reset();
+        stream2_.reset();
+    }
+
+    std::string ExplainImpl() const final {
+        return "sorted inputs, scatter of key ranges, streaming merge join";
+    }
+
+private:
+    KeyExtractor1 key_extractor1_;
+    KeyExtractor2 key_extractor2_;
+    JoinFunction join_function_;
+
+    //! local inputs
+    data::File file1_ { context_.GetFile(this) };
+    data::File file2_ { context_.GetFile(this) };
+    data::File::Writer writer1_, writer2_;
+
+    //! number of items of the first input, number of leading items with the
+    //! first key, and the first and last key
+    size_t items1_ = 0, leading1_ = 0;
+    Key first1_, last1_;
+
+    //! worker joining the first key of each worker's first input
+    std::vector<size_t> owner_;
+
+    //! workers having items of the first input, in rank order
+    std::vector<size_t> starts_;
+
+    //! streams exchanging the boundary items
+    data::CatStreamPtr stream1_, stream2_;
+
+    //! equality of keys as defined by the sort order
+    static bool KeyEqual(const Key& a, const Key& b) {
+        return !(a < b) && !(b < a);
+    }
+
+    //! worker which joins items of the second input with the given key: the
+    //! last worker whose first key of the first input is not larger. If the
+    //! key is its first key, which it sent away, then the key's owner.
+    size_t Target(const std::vector<RangeInfo>& infos, const Key& key) const {
+        auto it = std::upper_bound(
+            starts_.begin(), starts_.end(), key,
+            [&infos](const Key& k, const size_t& w) {
+                return k < std::get<1>(infos[w]);
+            });
+        if (it == starts_.begin()) return 0;
+        const size_t w = *(--it);
+        return KeyEqual(key, std::get<1>(infos[w])) ? owner_[w] : w;
+    }
+
+    //! read next item of the first input, and verify the order
+    template <typename Reader>
+    bool Advance1(Reader& reader, InputTypeFirst& item, const Key& key) {
+        if (!reader.HasNext()) return false;
+        item = reader.template Next<InputTypeFirst>();
+        if (key_extractor1_(item) < key)
+            die("MergeJoin: first input is not sorted by key");
+        return true;
+    }
+
+    //! read next item of the second input, and verify the order
+    template <typename Reader>
+    bool Advance2(Reader& reader, InputTypeSecond& item, const Key& key) {
+        if (!reader.HasNext()) return false;
+        item = reader.template Next<InputTypeSecond>();
+        if (key_extractor2_(item) < key)
+            die("MergeJoin: second input is not sorted by key");
+        return true;
+    }
+};
+
+/*!
+ * Performs an inner join of two DIAs, which must both be sorted globally by
+ * their keys, e.g. by Sort() or Merge(). All pairs of items with equal keys are
+ * joined with the join function. Only items of keys spanning workers are
+ * moved, see MergeJoinNode, and the result is sorted by the key.
+ *
+ * \param first_dia First DIA to join, sorted by key_extractor1.
+ *
+ * \param second_dia Second DIA to join, sorted by key_extractor2.
+ *
+ * \param key_extractor1 Key extractor for first DIA
+ *
+ * \param key_extractor2 Key extractor for second DIA
+ *
+ * \param join_function Join function applied to all equal key pairs
+ *
+ * \ingroup dia_dops_free
+ */
+template <typename FirstDIA, typename SecondDIA,
+          typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction>
+auto MergeJoin(
+    const FirstDIA& first_dia, const SecondDIA& second_dia,
+    const KeyExtractor1& key_extractor1, const KeyExtractor2& key_extractor2,
+    const JoinFunction& join_function) {
+
+    assert(first_dia.IsValid());
+    assert(second_dia.IsValid());
+
+    static_assert(
+        std::is_convertible<
+            typename FirstDIA::ValueType,
+            typename common::FunctionTraits<KeyExtractor1>::template arg<0>
+            >::value,
+        "Key Extractor 1 has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename SecondDIA::ValueType,
+            typename common::FunctionTraits<KeyExtractor2>::template arg<0>
+            >::value,
+        "Key Extractor 2 has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename common::FunctionTraits<KeyExtractor1>::result_type,
+            typename common::FunctionTraits<KeyExtractor2>::result_type
+            >::value,
+        "Keys have different types");
+
+    static_assert(
+        std::is_convertible<
+            typename FirstDIA::ValueType,
+            typename common::FunctionTraits<JoinFunction>::template arg<0>
+            >::value,
+        "Join Function has wrong input type in argument 0");
+
+    static_assert(
+        std::is_convertible<
+            typename SecondDIA::ValueType,
+            typename common::FunctionTraits<JoinFunction>::template arg<1>
+            >::value,
+        "Join Function has wrong input type in argument 1");
+
+    using JoinResult
+        = typename common::FunctionTraits<JoinFunction>::result_type;
+
+    using MergeJoinNode = api::MergeJoinNode<
+        JoinResult, FirstDIA, SecondDIA, KeyExtractor1, KeyExtractor2,
+        JoinFunction>;
+
+    auto node = tlx::make_counting<MergeJoinNode>(
+        first_dia, second_dia, key_extractor1, key_extractor2, join_function);
+
+    return DIA<JoinResult>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename SecondDIA, typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction>
+auto DIA<ValueType, Stack>::MergeJoin(
+    const SecondDIA& second_dia,
+    const KeyExtractor1& key_extractor1, const KeyExtractor2& key_extractor2,
+    const JoinFunction& join_function) const {
+    return api::MergeJoin(
+        *this, second_dia, key_extractor1, key_extractor2, join_function);
+}
+
+} // namespace api
+
+//! imported from api namespace
+using api::MergeJoin;
+
+} // namespace thrill
+
+#endif // !THRILL_API_MERGE_JOIN_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,408 @@
+/*******************************************************************************
+ * thrill/api/multiway_join.hpp
+ *
+ * DIANode for a join of many DIAs in one round, whose inputs are distributed
+ * to a HyperCube grid of workers.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_MULTIWAY_JOIN_HEADER
+#define THRILL_API_MULTIWAY_JOIN_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/function_traits.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/hash.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/string.hpp>
+#include <thrill/data/cat_stream.hpp>
+#include <thrill/data/file.hpp>
+
+#include <tlx/meta/call_for_range.hpp>
+#include <tlx/meta/call_foreach_with_index.hpp>
+#include <tlx/meta/vexpand.hpp>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+//! coordinate of a dimension which an input of MultiwayJoin() does not bind.
+static constexpr size_t kJoinAnyCoordinate = std::numeric_limits<size_t>::max();
+
+/*!
+ * A DIANode which joins many DIAs in one round by HyperCube (Shares)
+ * partitioning.
+ *
+ * Each join variable of the query is a dimension of a grid of workers. Every
+ * input maps its items to a coordinate in each dimension, e.g. the hash of the
+ * value of the variable, or to kJoinAnyCoordinate for the variables which it
+ * does not bind. An item is sent to all grid cells matching its coordinates,
+ * hence it is replicated along the dimensions it does not bind. All items
+ * which can join meet in the cell of the coordinates of their variables, and
+ * each result is found in exactly one cell.
+ *
+ * The number of cells in each dimension, its share, is chosen from the global
+ * input sizes such that the items received per worker are minimal, the
+ * product of the shares is at most the number of workers. Cyclic queries such
+ * as triangles are thus joined without the intermediate results of a cascade
+ * of binary joins.
+ *
+ * The join function is called on each worker with a std::vector of the
+ * received items of each input, and an emitter for results. Whether an input
+ * binds a dimension is taken from its first item, hence an input must bind the
+ * same dimensions in all items.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename JoinFunction,
+          typename CoordinateFunctions, size_t kDims, typename... InputTypes>
+class MultiwayJoinNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    static constexpr size_t kNumInputs = sizeof...(InputTypes);
+
+    template <size_t Index>
+    using InputN = typename std::tuple_element<
+        Index, std::tuple<InputTypes...> >::type;
+
+    using Coordinates = std::array<size_t, kDims>;
+    using ArraySizeT = std::array<size_t, kNumInputs>;
+
+    static_assert(kDims <= 64, "MultiwayJoin supports at most 64 dimensions");
+
+public:
+    template <typename ParentDIA0, typename... ParentDIAs>
+    MultiwayJoinNode(const JoinFunction& join_function,
+                     const CoordinateFunctions& coordinate_functions,
+                     const ParentDIA0& parent0, const ParentDIAs& ... parents)
+        : Super(parent0.ctx(), "MultiwayJoin",
+                { parent0.id(), parents.id() ... },
+                { parent0.node(), parents.node() ... }),
+          join_function_(join_function),
+          coordinate_functions_(coordinate_functions) {
+        files_.reserve(kNumInputs);
+        for (size_t i = 0; i < kNumInputs; ++i)
+            files_.emplace_back(context_.GetFile(this));
+        bound_.fill(0);
+        seen_.fill(false);
+
+        tlx::call_foreach_with_index(
+            RegisterParent(this), parent0, parents...);
+    }
+
+    void StartPreOp(size_t parent_index) final {
+        writers_[parent_index] = files_[parent_index].GetWriter();
+    }
+
+    void StopPreOp(size_t parent_index) final {
+        writers_[parent_index].Close();
+    }
+
+    void Execute() final {
+        ArraySizeT total;
+        for (size_t i = 0; i < kNumInputs; ++i)
+            total[i] = files_[i].num_items();
+        total = context_.net.AllReduce(total, common::ComponentSum<ArraySizeT>());
+
+        // dimensions bound by each input, known to all workers
+        bound_ = context_.net.AllReduce(
+            bound_, common::ComponentSum<
+                std::array<uint64_t, kNumInputs>, std::bit_or<uint64_t> >());
+
+        ChooseShares(total);
+
+        sLOG << "MultiwayJoin shares" << common::VecToStr(shares_);
+
+        tlx::call_for_range<kNumInputs>(
+            [=](auto index) {
+                (void)index;
+                this->ScatterInput<decltype(index)::index>();
+            });
+    }
+
+    void PushData(bool consume) final {
+        std::tuple<std::vector<InputTypes>...> inputs;
+        tlx::call_for_range<kNumInputs>(
+            [&](auto index) {
+                (void)index;
+                using Input = InputN<decltype(index)::index>;
+                auto& vec = std::get<decltype(index)::index>(inputs);
+                auto reader =
+                    streams_[decltype(index)::index]->GetCatReader(consume);
+                while (reader.HasNext())
+                    vec.emplace_back(reader.template Next<Input>());
+            });
+
+        auto emit = [this](const ValueType& output) {
+                        this->PushItem(output);
+                    };
+        CallJoin(inputs, emit, std::index_sequence_for<InputTypes...>());
+    }
+
+    void Dispose() final {
+        files_.clear();
+        for (size_t i = 0; i < kNumInputs; ++i)
+            streams_[i].reset();
+    }
+
+    //! Receive an item of input Index, and record the dimensions bound by
+    //! the first one.
+    template <size_t Index>
+    void PreOp(const InputN<Index>& input) {
+        if (!seen_[Index]) {
+            bound_[Index] = BoundMask(
+                std::get<Index>(coordinate_functions_)(input));
+            seen_[Index] = true;
+        }
+        writers_[Index].Put(input);
+    }
+
+private:
+    //! join function called with the vectors of items of each cell
+    JoinFunction join_function_;
+
+    //! tuple of functions mapping the items of each input to coordinates
+    CoordinateFunctions coordinate_functions_;
+
+    //! local items of each input
+    std::vector<data::File> files_;
+
+    //! writers to files_
+    data::File::Writer writers_[kNumInputs];
+
+    //! streams of the items of each input sent to the grid
+    data::CatStreamPtr streams_[kNumInputs];
+
+    //! bit mask of the dimensions bound by each input
+    std::array<uint64_t, kNumInputs> bound_;
+
+    //! whether bound_ was taken from a local item of each input
+    std::array<bool, kNumInputs> seen_;
+
+    //! number of cells in each dimension
+    Coordinates shares_;
+
+    //! Register PreOp hooks, instantiated and called for each parent
+    class RegisterParent
+    {
+    public:
+        explicit RegisterParent(MultiwayJoinNode* node) : node_(node) { }
+
+        template <typename Index, typename Parent>
+        void operator () (const Index&, Parent& parent) {
+            using Input = InputN<Index::index>;
+
+            static_assert(
+                std::is_convertible<typename Parent::ValueType, Input>::value,
+                "MultiwayJoin input type does not match input DIA");
+
+            MultiwayJoinNode* node = node_;
+            auto pre_op_fn = [node](const Input& input) -> void {
+                                 node->template PreOp<Index::index>(input);
+                             };
+
+            auto lop_chain = parent.stack().push(pre_op_fn).fold();
+            parent.node()->AddChild(node_, lop_chain, Index::index);
+        }
+
+    private:
+        MultiwayJoinNode* node_;
+    };
+
+    static uint64_t BoundMask(const Coordinates& c) {
+        uint64_t mask = 0;
+        for (size_t d = 0; d < kDims; ++d) {
+            if (c[d] != kJoinAnyCoordinate)
+                mask |= uint64_t(1) << d;
+        }
+        return mask;
+    }
+
+    //! Choose the shares whose product is at most the number of workers,
+    //! which minimize the expected number of items received per worker:
+    //! input i sends total[i] / (product of the shares of its bound
+    //! dimensions) items to each cell. Ties prefer fewer cells, hence fewer
+    //! replicas. Deterministic, hence identical on all workers.
+    void ChooseShares(const ArraySizeT& total) {
+        Coordinates current;
+        current.fill(1);
+        shares_.fill(1);
+        double best_load = Load(total, shares_);
+        size_t best_cells = 1;
+
+        std::function<void(size_t, size_t)> enumerate =
+            [&](size_t d, size_t cells) {
+                if (d == kDims) {
+                    double load = Load(total, current);
+                    if (load < best_load ||
+                        (load == best_load && cells < best_cells)) {
+                        best_load = load, best_cells = cells;
+                        shares_ = current;
+                    }
+                    return;
+                }
+                for (size_t s = 1; cells * s <= context_.num_workers(); ++s) {
+                    current[d] = s;
+                    enumerate(d + 1, cells * s);
+                }
+                current[d] = 1;
+            };
+        enumerate(0, 1);
+    }
+
+    //! expected number of items received per cell with the given shares
+    double Load(const ArraySizeT& total, const Coordinates& shares) const {
+        double load = 0;
+        for (size_t i = 0; i < kNumInputs; ++i) {
+            double cells = 1;
+            for (size_t d = 0; d < kDims; ++d) {
+                if (bound_[i] & (uint64_t(1) << d))
+                    cells *= static_cast<double>(shares[d]);
+            }
+            load += static_cast<double>(total[i]) / cells;
+        }
+        return load;
+    }
+
+    //! Send all items of input Index to the cells matching their coordinates,
+    //! the cells are numbered in mixed radix of the shares.
+    template <size_t Index>
+    void ScatterInput() {
+        using Input = InputN<Index>;
+
+        streams_[Index] = context_.GetNewCatStream(this);
+        data::CatStream::Writers writers = streams_[Index]->GetWriters();
+
+        size_t sent = 0;
+        auto reader = files_[Index].GetConsumeReader();
+        while (reader.HasNext()) {
+            Input item = reader.template Next<Input>();
+            Coordinates c = std::get<Index>(coordinate_functions_)(item);
+
+            // fixed part of the cell, and the replicated dimensions
+            size_t base = 0, stride = 1;
+            std::array<size_t, kDims> free_stride;
+            std::array<size_t, kDims> free_share;
+            size_t num_free = 0;
+            for (size_t d = 0; d < kDims; ++d) {
+                if (bound_[Index] & (uint64_t(1) << d)) {
+                    base += stride * (common::Hash128to64(d, c[d]) % shares_[d]);
+                }
+                else if (shares_[d] > 1) {
+                    free_stride[num_free] = stride;
+                    free_share[num_free] = shares_[d];
+                    ++num_free;
+                }
+                stride *= shares_[d];
+            }
+
+            // iterate over all coordinates of the replicated dimensions
+            std::array<size_t, kDims> pos;
+            pos.fill(0);
+            while (true) {
+                size_t cell = base;
+                for (size_t f = 0; f < num_free; ++f)
+                    cell += pos[f] * free_stride[f];
+                writers[cell].Put(item);
+                ++sent;
+
+                size_t f = 0;
+                while (f < num_free && ++pos[f] == free_share[f])
+                    pos[f++] = 0;
+                if (f == num_free) break;
+            }
+        }
+
+        sLOG << "MultiwayJoin input" << Index << "sent" << sent << "items";
+    }
+
+    template <typename Inputs, typename Emitter, size_t... Is>
+    void CallJoin(Inputs& inputs, Emitter& emit, std::index_sequence<Is...>) {
+        join_function_(std::get<Is>(inputs) ..., emit);
+    }
+};
+
+/*!
+ * Joins many DIAs in one round by HyperCube (Shares) partitioning, e.g. for
+ * cyclic queries such as triangles, whose cascades of binary InnerJoin()s
+ * materialize large intermediate results.
+ *
+ * Each item is mapped to a std::array of kDims coordinates by the coordinate
+ * function of its input, with one coordinate per join variable: usually the
+ * value or a hash of the variable, or kJoinAnyCoordinate if the input does not
+ * bind it. The items are replicated to a grid of workers, and the join function
+ * is called on each worker with a const std::vector of the items of each
+ * input received by the worker, and an emitter. It must join the items
+ * locally, and emit each result, which must agree on all variables.
+ *
+ * \tparam ValueType Type of the output DIA, which cannot be inferred from the
+ * join_function due to the emitter.
+ *
+ * \param coordinate_functions std::tuple of one coordinate function per input
+ * DIA, which map an item to std::array<size_t, kDims>.
+ *
+ * \param join_function Local join function, called with (inputs..., emit).
+ *
+ * \param first_dia the first input DIA.
+ *
+ * \param dias further input DIAs.
+ *
+ * \ingroup dia_dops_free
+ */
+template <typename ValueType, typename JoinFunction,
+          typename... CoordinateFunctions, typename FirstDIA,
+          typename... DIAs>
+auto MultiwayJoin(
+    const std::tuple<CoordinateFunctions...>& coordinate_functions,
+    const JoinFunction& join_function,
+    const FirstDIA& first_dia, const DIAs& ... dias) {
+
+    tlx::vexpand((first_dia.AssertValid(), 0), (dias.AssertValid(), 0) ...);
+
+    static_assert(sizeof...(CoordinateFunctions) == 1 + sizeof...(DIAs),
+                  "MultiwayJoin needs one coordinate function per input DIA");
+
+    using CoordinateTuple = std::tuple<CoordinateFunctions...>;
+    using Coordinates = typename std::decay<
+        typename common::FunctionTraits<
+            typename std::tuple_element<0, CoordinateTuple>::type>::result_type>
+                        ::type;
+
+    using MultiwayJoinNode = api::MultiwayJoinNode<
+        ValueType, JoinFunction, CoordinateTuple,
+        std::tuple_size<Coordinates>::value,
+        typename FirstDIA::ValueType, typename DIAs::ValueType...>;
+
+    auto node = tlx::make_counting<MultiwayJoinNode>(
+        join_function, coordinate_functions, first_dia, dias...);
+
+    return DIA<ValueType>(node);
+}
+
+} // namespace api
+
+//! imported from api namespace
+using api::MultiwayJoin;
+
+} // namespace thrill
+
+#endif // !THRILL_API_MULTIWAY_JOIN_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * thrill/api/persist.hpp
+ *
+ * Materialize a DIA on disk, and reuse it in later runs if its lineage did not
+ * change.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_PERSIST_HEADER
+#define THRILL_API_PERSIST_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/equal_to_dia.hpp>
+#include <thrill/api/read_binary.hpp>
+#include <thrill/api/write_binary.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/vfs/file_io.hpp>
+
+#include <tlx/siphash.hpp>
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * Calculate a fingerprint of the lineage of node: the labels of all nodes
+ * leading to node, and the SourceFingerprint() of each, e.g. the paths, sizes
+ * and modification times of input files.
+ */
+inline uint64_t LineageFingerprint(DIABase* node) {
+    std::ostringstream oss;
+    std::vector<DIABase*> stack { node };
+    while (!stack.empty()) {
+        DIABase* n = stack.back();
+        stack.pop_back();
+
+        oss << n->label() << '\0' << n->SourceFingerprint() << '\0'
+            << n->parents().size() << '\0';
+        for (const DIABasePtr& p : n->parents())
+            stack.push_back(p.get());
+    }
+    return tlx::siphash(oss.str());
+}
+
+template <typename ValueType, typename Stack>
+DIA<ValueType> DIA<ValueType, Stack>::Persist(
+    const std::string& path, const std::string& version) const {
+    assert(IsValid());
+    static constexpr bool debug = false;
+
+    Context& ctx = context();
+
+    uint64_t fingerprint =
+        tlx::siphash(std::to_string(LineageFingerprint(node_.get()))
+                     + '\0' + version);
+
+    std::ostringstream oss;
+    oss << path << "/persist-"
+        << std::hex << std::setw(16) << std::setfill('0') << fingerprint;
+    std::string prefix = oss.str();
+    std::string marker = prefix + ".done";
+
+    // all workers must take the same branch
+    size_t found = vfs::Glob(marker, vfs::GlobType::File).size() != 0;
+    found = ctx.net.AllReduce(found);
+
+    if (found != ctx.num_workers()) {
+        sLOG << "Persist: materializing lineage into" << prefix;
+
+        WriteBinary(prefix + "-$$$$$-#####.bin", 128 * 1024 * 1024,
+                    /* block_index */ true);
+        ctx.net.Barrier();
+
+        // write marker only after all workers finished writing.
+        if (ctx.my_rank() == 0) {
+            vfs::WriteStreamPtr stream = vfs::OpenWriteStream(marker);
+            stream->write(version.data(), version.size());
+            stream->close();
+        }
+        ctx.net.Barrier();
+    }
+    else {
+        sLOG << "Persist: reusing materialized lineage" << prefix;
+    }
+
+    // empty DIAs do not write any files
+    if (vfs::Glob(prefix + "-*.bin", vfs::GlobType::File).size() == 0)
+        return EqualToDIA(ctx, std::vector<ValueType>());
+
+    return ReadBinary<ValueType>(ctx, prefix + "-*.bin");
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_PERSIST_HEADER
+
+/******************************************************************************/
@@ -18,9 +18,51 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/data/file.hpp>
 
+#include <limits>
+#include <type_traits>
+#include <utility>
+
 namespace thrill {
 namespace api {
 
+//! Calls func for each remaining POD item of reader, reading the items in
+//! place inside the Blocks. The loops over the spans can be vectorized by the
+//! compiler for arithmetic types.
+template <typename ValueType, typename Reader, typename Function>
+void ScanItems(Reader& reader, const Function& func,
+               std::true_type /* pod */) {
+    while (reader.HasNext()) {
+        std::pair<const ValueType*, size_t> span =
+            reader.template NextSpan<ValueType>(
+                std::numeric_limits<size_t>::max());
+        // items spanning Block boundaries are deserialized
+        if (span.second == 0) {
+            func(reader.template Next<ValueType>());
+            continue;
+        }
+        for (const ValueType* it = span.first;
+             it != span.first + span.second; ++it)
+            func(*it);
+    }
+}
+
+//! Calls func for each remaining item of reader.
+template <typename ValueType, typename Reader, typename Function>
+void ScanItems(Reader& reader, const Function& func,
+               std::false_type /* pod */) {
+    while (reader.HasNext())
+        func(reader.template Next<ValueType>());
+}
+
+//! Calls func for each remaining item of reader, in place for POD items.
+template <typename ValueType, typename Reader, typename Function>
+void ScanItems(Reader& reader, const Function& func) {
+    ScanItems<ValueType>(
+        reader, func,
+        std::integral_constant<bool, std::is_pod<ValueType>::value &&
+                               !std::is_pointer<ValueType>::value>());
+}
+
 /*!
  * \ingroup api_layer
  */
@@ -70,10 +112,10 @@ public:
         file_ = file.Copy();
         // read File for prefix sum.
         auto reader = file_.GetKeepReader();
-        while (reader.HasNext()) {
-            local_sum_ = sum_function_(
-                local_sum_, reader.template Next<ValueType>());
-        }
+        ScanItems<ValueType>(
+            reader, [this](const ValueType& item) {
+                local_sum_ = sum_function_(local_sum_, item);
+            });
         return true;
     }
 
@@ -91,21 +133,21 @@ public:
 
     void PushData(bool consume) final {
         data::File::Reader reader = file_.GetReader(consume);
-        size_t num_items = file_.num_items();
 
+        ValueType sum = local_sum_;
         if (Inclusive) {
-            ValueType sum = local_sum_;
-            for (size_t i = 0; i < num_items; ++i) {
-                sum = sum_function_(sum, reader.Next<ValueType>());
-                this->PushItem(sum);
-            }
+            ScanItems<ValueType>(
+                reader, [this, &sum](const ValueType& item) {
+                    sum = sum_function_(sum, item);
+                    this->PushItem(sum);
+                });
         }
         else {
-            ValueType sum = local_sum_;
-            for (size_t i = 0; i < num_items; ++i) {
-                this->PushItem(sum);
-                sum = sum_function_(sum, reader.Next<ValueType>());
-            }
+            ScanItems<ValueType>(
+                reader, [this, &sum](const ValueType& item) {
+                    this->PushItem(sum);
+                    sum = sum_function_(sum, item);
+                });
         }
     }
 
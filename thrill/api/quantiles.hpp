@@ -0,0 +1,93 @@
+/*******************************************************************************
+ * thrill/api/quantiles.hpp
+ *
+ * Approximate quantiles of a DIA using mergeable KLL sketches.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_QUANTILES_HEADER
+#define THRILL_API_QUANTILES_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/core/quantile_sketch.hpp>
+
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename CompareFunction>
+class QuantileSketchNode final
+    : public ActionResultNode<core::QuantileSketch<ValueType, CompareFunction> >
+{
+    static constexpr bool debug = false;
+
+    using Sketch = core::QuantileSketch<ValueType, CompareFunction>;
+    using Super = ActionResultNode<Sketch>;
+    using Super::context_;
+
+public:
+    template <typename ParentDIA>
+    QuantileSketchNode(const ParentDIA& parent, const char* label,
+                       size_t sketch_size,
+                       const CompareFunction& compare_function)
+        : Super(parent.ctx(), label, { parent.id() }, { parent.node() }),
+          sketch_(sketch_size, compare_function) {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             sketch_.Insert(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    //! Merges the sketches of all workers.
+    void Execute() final {
+        sLOG << "QuantileSketchNode: local items" << sketch_.num_items()
+             << "retained" << sketch_.num_retained();
+        sketch_ = context_.net.AllReduce(sketch_);
+    }
+
+    //! Returns the merged sketch.
+    const Sketch& result() const final { return sketch_; }
+
+private:
+    Sketch sketch_;
+};
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+std::vector<ValueType> DIA<ValueType, Stack>::ApproxQuantiles(
+    const std::vector<double>& phis, size_t sketch_size,
+    const CompareFunction& compare_function) const {
+    assert(IsValid());
+
+    using QuantileSketchNode =
+        api::QuantileSketchNode<ValueType, CompareFunction>;
+
+    auto node = tlx::make_counting<QuantileSketchNode>(
+        *this, "ApproxQuantiles", sketch_size, compare_function);
+    node->RunScope();
+
+    const core::QuantileSketch<ValueType, CompareFunction>& sketch =
+        node->result();
+    if (sketch.empty())
+        return std::vector<ValueType>(phis.size(), ValueType());
+    return sketch.Quantiles(phis);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_QUANTILES_HEADER
+
+/******************************************************************************/
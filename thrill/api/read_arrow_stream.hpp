@@ -0,0 +1,264 @@
+/*******************************************************************************
+ * thrill/api/read_arrow_stream.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_READ_ARROW_STREAM_HEADER
+#define THRILL_API_READ_ARROW_STREAM_HEADER
+
+#include <thrill/api/arrow_format.hpp>
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/source_node.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/vfs/file_io.hpp>
+
+#include <tlx/string/join.hpp>
+#include <tlx/vector_free.hpp>
+
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+template <typename ValueType>
+class ReadArrowStreamNode
+{
+    static_assert(sizeof(ValueType) == 0,
+                  "ReadArrowStream: ValueType must be std::tuple<Types...>");
+};
+
+/*!
+ * A DIANode which reads Arrow IPC streams, e.g. written by WriteArrowStream or
+ * by pyarrow.ipc.new_stream(). The schema must consist of exactly the tuple's
+ * column types without nulls. Streams cannot be split, hence each file is read
+ * entirely by one worker, and the files are distributed to workers in
+ * contiguous ranges.
+ *
+ * \ingroup api_layer
+ */
+template <typename... Types>
+class ReadArrowStreamNode<std::tuple<Types...> > final
+    : public SourceNode<std::tuple<Types...> >
+{
+    static constexpr bool debug = false;
+
+public:
+    using ValueType = std::tuple<Types...>;
+    using Super = SourceNode<ValueType>;
+    using Super::context_;
+
+    //! number of columns
+    static constexpr size_t num_columns = sizeof ... (Types);
+
+    ReadArrowStreamNode(Context& ctx, const std::vector<std::string>& globlist)
+        : Super(ctx, "ReadArrowStream", /* recomputable */ true) {
+
+        vfs::FileList files = ctx.Glob(globlist, vfs::GlobType::File);
+
+        if (files.size() == 0) {
+            die("ReadArrowStream: no files found in globs: "
+                + tlx::join(' ', globlist));
+        }
+
+        fingerprint_ = files.fingerprint();
+
+        common::Range my_files = context_.CalculateLocalRange(files.size());
+        for (size_t i = my_files.begin; i < my_files.end; ++i) {
+            if (files[i].IsCompressed()) {
+                die("ReadArrowStream: cannot read compressed file "
+                    << files[i].path);
+            }
+            my_files_.emplace_back(files[i].path);
+        }
+
+        sLOG << "ReadArrowStreamNode:" << ctx.num_workers()
+             << "my_files" << my_files;
+    }
+
+    uint64_t SourceFingerprint() const final { return fingerprint_; }
+
+    void PushData(bool /* consume */) final {
+        for (const std::string& path : my_files_) {
+            LOG << "ReadArrowStreamNode::PushData() opening " << path;
+            ReadStream(path);
+        }
+
+        Super::logger_
+            << "class" << "ReadArrowStreamNode"
+            << "event" << "done"
+            << "total_bytes" << stats_total_bytes_
+            << "total_batches" << stats_total_batches_;
+    }
+
+    void Dispose() final {
+        tlx::vector_free(my_files_);
+    }
+
+private:
+    //! files read by this worker
+    std::vector<std::string> my_files_;
+
+    //! fingerprint of all files matched by the globs
+    uint64_t fingerprint_ = 0;
+
+    size_t stats_total_bytes_ = 0;
+    size_t stats_total_batches_ = 0;
+
+    //! read exactly size bytes, returns false at the end of the stream if
+    //! nothing was read.
+    bool ReadExact(vfs::ReadStream& rs, const std::string& path,
+                   void* data, size_t size) {
+        char* cdata = static_cast<char*>(data);
+        size_t pos = 0;
+        while (pos < size) {
+            ssize_t rb = rs.read(cdata + pos, size - pos);
+            if (rb <= 0) {
+                if (pos == 0) return false;
+                die("ReadArrowStream: unexpected end of stream in " << path);
+            }
+            pos += rb;
+        }
+        stats_total_bytes_ += size;
+        return true;
+    }
+
+    void ReadStream(const std::string& path) {
+        vfs::ReadStreamPtr rs = vfs::OpenReadStream(path);
+
+        bool has_schema = false;
+        std::string meta, body;
+        while (true) {
+            // continuation marker, which streams before Arrow 0.15 omit
+            int32_t meta_size;
+            if (!ReadExact(*rs, path, &meta_size, sizeof(meta_size))) break;
+            if (meta_size == -1 &&
+                !ReadExact(*rs, path, &meta_size, sizeof(meta_size))) break;
+            // end-of-stream marker
+            if (meta_size == 0) break;
+            if (meta_size < 0)
+                die("ReadArrowStream: invalid message in " << path);
+
+            meta.resize(meta_size);
+            ReadExact(*rs, path, &meta[0], meta.size());
+            ArrowFlatTable message = ArrowFlatTable::Root(meta);
+
+            int64_t body_size = message.Scalar<int64_t>(3, 0);
+            if (body_size < 0)
+                die("ReadArrowStream: invalid message in " << path);
+            body.resize(body_size);
+            if (body_size != 0)
+                ReadExact(*rs, path, &body[0], body.size());
+
+            uint8_t type = message.Scalar<uint8_t>(1, 0);
+            if (type == static_cast<uint8_t>(ArrowMessageType::Schema)) {
+                CheckSchema(path, message.Table(2));
+                has_schema = true;
+            }
+            else if (type ==
+                     static_cast<uint8_t>(ArrowMessageType::RecordBatch)) {
+                if (!has_schema)
+                    die("ReadArrowStream: record batch before schema in "
+                        << path);
+                PushBatch(path, ArrowBatchView { message.Table(2), body },
+                          std::index_sequence_for<Types...>());
+                stats_total_batches_++;
+            }
+            else if (type ==
+                     static_cast<uint8_t>(ArrowMessageType::DictionaryBatch)) {
+                die("ReadArrowStream: dictionaries are unsupported in "
+                    << path);
+            }
+        }
+        rs->close();
+    }
+
+    //! check that the schema's fields have the tuple's types
+    void CheckSchema(const std::string& path, const ArrowFlatTable& schema) {
+        if (schema.VectorSize(1) != num_columns) {
+            die("ReadArrowStream: stream " << path << " has "
+                                           << schema.VectorSize(1)
+                                           << " columns instead of "
+                                           << num_columns);
+        }
+        using CheckFunction = bool (*)(uint8_t, const ArrowFlatTable&);
+        CheckFunction checks[] = { &ArrowColumnTraits<Types>::CheckType ... };
+        for (size_t i = 0; i < num_columns; ++i) {
+            ArrowFlatTable field = schema.VectorTable(1, i);
+            if (field.Has(4))
+                die("ReadArrowStream: column " << i << " in stream " << path
+                                               << " is dictionary encoded");
+            uint8_t type_id = field.Scalar<uint8_t>(2, 0);
+            if (!checks[i](type_id, field.Table(3))) {
+                die("ReadArrowStream: column " << i << " (" << field.String(0)
+                                               << ") in stream " << path
+                                               << " has the wrong type");
+            }
+        }
+    }
+
+    //! decode the columns of a record batch and emit the rows
+    template <size_t... Is>
+    void PushBatch(const std::string& path, const ArrowBatchView& view,
+                   std::index_sequence<Is...>) {
+        if (view.batch.Has(3))
+            die("ReadArrowStream: compressed record batch in " << path);
+
+        // first buffer index of each column
+        size_t buffer[num_columns + 1] = { 0 };
+        size_t num_buffers[] = { ArrowColumnTraits<Types>::num_buffers ... };
+        for (size_t i = 0; i < num_columns; ++i)
+            buffer[i + 1] = buffer[i] + num_buffers[i];
+
+        std::tuple<std::vector<Types>...> cols;
+        int dummy[] = {
+            (ArrowColumnTraits<Types>::Decode(
+                 view, Is, buffer[Is], std::get<Is>(cols)), 0) ...
+        };
+        (void)dummy;
+
+        size_t rows = view.rows();
+        for (size_t r = 0; r < rows; ++r) {
+            this->PushItem(ValueType(std::move(std::get<Is>(cols)[r]) ...));
+        }
+    }
+};
+
+/*!
+ * ReadArrowStream is a DOp, which reads Apache Arrow IPC streams, e.g. written
+ * by WriteArrowStream or by Arrow libraries in other processes, and creates a
+ * DIA of std::tuple<Types...>. The arithmetic column buffers are copied into
+ * the columns as they are, without parsing items. Streams in shared memory
+ * (e.g. /dev/shm) are exchanged with other processes without disk I/O.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path of the files in the file system
+ *
+ * \ingroup dia_sources
+ */
+template <typename ValueType>
+DIA<ValueType> ReadArrowStream(Context& ctx, const std::string& filepath) {
+    auto node = tlx::make_counting<ReadArrowStreamNode<ValueType> >(
+        ctx, std::vector<std::string>{ filepath });
+
+    return DIA<ValueType>(node);
+}
+
+} // namespace api
+
+//! imported from api namespace
+using api::ReadArrowStream;
+
+} // namespace thrill
+
+#endif // !THRILL_API_READ_ARROW_STREAM_HEADER
+
+/******************************************************************************/
@@ -13,6 +13,7 @@
 #ifndef THRILL_API_READ_BINARY_HEADER
 #define THRILL_API_READ_BINARY_HEADER
 
+#include <thrill/api/binary_index.hpp>
 #include <thrill/api/context.hpp>
 #include <thrill/api/dia.hpp>
 #include <thrill/api/source_node.hpp>
@@ -20,8 +21,10 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_reader.hpp>
+#include <thrill/data/mapped_region.hpp>
 #include <thrill/net/buffer_builder.hpp>
 #include <thrill/vfs/file_io.hpp>
+#include <thrill/vfs/locality.hpp>
 
 #include <foxxll/io/syscall_file.hpp>
 #include <tlx/string/join.hpp>
@@ -81,17 +84,61 @@ public:
 
     ReadBinaryNode(Context& ctx, const std::vector<std::string>& globlist,
                    uint64_t size_limit, bool local_storage)
-        : Super(ctx, "ReadBinary") {
+        : Super(ctx, "ReadBinary", /* recomputable */ true) {
 
-        vfs::FileList files = vfs::Glob(globlist, vfs::GlobType::File);
+        vfs::FileList files =
+            ctx.Glob(globlist, vfs::GlobType::File, local_storage);
 
         if (files.size() == 0)
             die("ReadBinary: no files found in globs: " + tlx::join(' ', globlist));
 
+        fingerprint_ = files.fingerprint();
+
         if (size_limit != no_size_limit_)
             files.total_size = std::min(files.total_size, size_limit);
 
-        if (is_fixed_size_ && !files.contains_compressed)
+        BinaryBlockIndex index;
+
+        if (!files.contains_compressed &&
+            index.Read(files[0].path, files[0].size))
+        {
+            // use the block indexes written by WriteBinary to split files at
+            // item boundaries.
+
+            std::vector<common::Range> my_ranges;
+
+            if (local_storage) {
+                my_ranges.emplace_back(
+                    context_.CalculateLocalRangeOnHost(files.total_size));
+            }
+            else if (vfs::HasBlockLocations(files)) {
+                // read blocks of a distributed file system on the hosts
+                // storing them.
+                my_ranges = context_.CalculateLocalityRanges(files);
+            }
+            else {
+                my_ranges.emplace_back(
+                    context_.CalculateLocalRange(files.total_size));
+            }
+
+            for (const common::Range& my_range : my_ranges) {
+                sLOG << "ReadBinaryNode: indexed, my_range" << my_range;
+
+                for (size_t i = 0; i < files.size(); ++i) {
+                    if (files[i].size_inc_psum() <= my_range.begin ||
+                        files.size_ex_psum(i) >= my_range.end) continue;
+
+                    if (!index.Read(files[i].path, files[i].size)) {
+                        die("ReadBinary: path " + files[i].path +
+                            " has no block index");
+                    }
+
+                    AddIndexedFile(files[i], index, my_range,
+                                   files.contains_remote_uri);
+                }
+            }
+        }
+        else if (is_fixed_size_ && !files.contains_compressed)
         {
             // use fixed_size information to split binary files.
 
@@ -151,12 +198,23 @@ public:
                     my_files_.push_back(fi);
                 }
                 else {
-                    // new method: map blocks into a File using io layer
+                    // new method: map blocks into a File using io layer, or
+                    // view them zero-copy in a memory mapping of the file.
+
+                    data::BlockPool& block_pool = context_.block_pool();
+
+                    foxxll::file_ptr file;
+                    data::MappedRegionPtr mapping;
 
-                    foxxll::file_ptr file =
-                        tlx::make_counting<foxxll::syscall_file>(
+                    if (block_pool.map_files()) {
+                        mapping = tlx::make_counting<data::MappedRegion>(
+                            fi.path, fi.range.begin, fi.range.size());
+                    }
+                    else {
+                        file = tlx::make_counting<foxxll::syscall_file>(
                             fi.path,
                             foxxll::file::RDONLY | foxxll::file::NO_LOCK);
+                    }
 
                     size_t item_off = 0;
 
@@ -167,8 +225,10 @@ public:
                             off + data::default_block_size, fi.range.end) - off;
 
                         data::ByteBlockPtr bbp =
-                            context_.block_pool().MapExternalBlock(
-                                file, off, bsize);
+                            mapping
+                            ? block_pool.MapMemoryBlock(
+                                mapping, off - fi.range.begin, bsize)
+                            : block_pool.MapExternalBlock(file, off, bsize);
 
                         size_t item_num =
                             (bsize - item_off + fixed_size_ - 1) / fixed_size_;
@@ -226,6 +286,10 @@ public:
         : ReadBinaryNode(ctx, std::vector<std::string>{ glob }, size_limit,
                          local_storage) { }
 
+    uint64_t SourceFingerprint() const final { return fingerprint_; }
+
+    bool ScanSource() const final { return true; }
+
     void PushData(bool consume) final {
         LOG << "ReadBinaryNode::PushData() start " << *this
             << " consume=" << consume
@@ -267,9 +331,96 @@ private:
     bool use_ext_file_ = false;
     data::File ext_file_ { context_.GetFile(this) };
 
+    //! fingerprint of all files matched by the globs
+    uint64_t fingerprint_ = 0;
+
     size_t stats_total_bytes = 0;
     size_t stats_total_reads = 0;
 
+    //! Add the items of an indexed file whose first byte lies in my_range,
+    //! either by mapping its Blocks into ext_file_ or as FileInfo range.
+    void AddIndexedFile(const vfs::FileInfo& file,
+                        const BinaryBlockIndex& index,
+                        const common::Range& my_range, bool remote) {
+        // find the item boundaries [begin,end) in the file of the items
+        // starting in my_range.
+        uint64_t data_size = index.data_size();
+        uint64_t begin = data_size, end = data_size;
+        bool found_begin = false;
+
+        uint64_t off = 0;
+        for (const BinaryBlockIndex::Entry& e : index.blocks) {
+            if (e.num_items != 0) {
+                uint64_t first = off + e.first_item;
+                if (!found_begin && file.size_ex_psum + first >= my_range.begin)
+                    begin = first, found_begin = true;
+                if (file.size_ex_psum + first >= my_range.end) {
+                    end = first;
+                    break;
+                }
+            }
+            off += e.size;
+        }
+
+        sLOG << "ReadBinary: indexed file" << file.path
+             << "items range" << begin << end;
+
+        if (begin >= end) return;
+
+        if (remote || debug_no_extfile) {
+            my_files_.push_back(
+                FileInfo { file.path, common::Range(begin, end), false });
+            return;
+        }
+
+        // map Blocks into a File, the first one starts at the first item and
+        // the last one ends with the last item.
+
+        data::BlockPool& block_pool = context_.block_pool();
+
+        foxxll::file_ptr ffile;
+        data::MappedRegionPtr mapping;
+
+        if (block_pool.map_files()) {
+            mapping = tlx::make_counting<data::MappedRegion>(
+                file.path, begin, end - begin);
+        }
+        else {
+            ffile = tlx::make_counting<foxxll::syscall_file>(
+                file.path, foxxll::file::RDONLY | foxxll::file::NO_LOCK);
+        }
+
+        off = 0;
+        for (const BinaryBlockIndex::Entry& e : index.blocks) {
+            uint64_t pbegin = std::max(off, begin);
+            uint64_t pend = std::min(off + e.size, end);
+
+            if (pbegin < pend) {
+                size_t bsize = pend - pbegin;
+                uint64_t first = off + e.first_item;
+                bool has_items =
+                    e.num_items != 0 && first >= pbegin && first < pend;
+
+                data::ByteBlockPtr bbp =
+                    mapping
+                    ? block_pool.MapMemoryBlock(mapping, pbegin - begin, bsize)
+                    : block_pool.MapExternalBlock(ffile, pbegin, bsize);
+
+                data::Block block(
+                    std::move(bbp), 0, bsize,
+                    has_items ? first - pbegin : bsize,
+                    has_items ? e.num_items : 0,
+                    /* typecode_verify */ false);
+
+                LOG << "ReadBinary: adding Block " << block;
+                ext_file_.AppendBlock(std::move(block));
+            }
+            off += e.size;
+        }
+
+        use_ext_file_ = true;
+    }
+
     class VfsFileBlockSource
     {
     public:
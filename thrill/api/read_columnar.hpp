@@ -0,0 +1,339 @@
+/*******************************************************************************
+ * thrill/api/read_columnar.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_READ_COLUMNAR_HEADER
+#define THRILL_API_READ_COLUMNAR_HEADER
+
+#include <thrill/api/columnar_format.hpp>
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/source_node.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/net/buffer_reader.hpp>
+#include <thrill/vfs/file_io.hpp>
+
+#include <tlx/string/join.hpp>
+#include <tlx/vector_free.hpp>
+
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+template <typename ValueType, typename RowGroupFilter>
+class ReadColumnarNode
+{
+    static_assert(sizeof(ValueType) == 0,
+                  "ReadColumnar: ValueType must be std::tuple<Columns...>");
+};
+
+/*!
+ * A DIANode which reads files written by WriteColumnar. Only the column chunks
+ * of the projected columns are read from the files, and row groups for which
+ * the filter returns false on the min/max statistics are skipped entirely.
+ * Row groups are distributed to workers by their byte offset.
+ *
+ * \ingroup api_layer
+ */
+template <typename... Types, typename RowGroupFilter>
+class ReadColumnarNode<std::tuple<Types...>, RowGroupFilter> final
+    : public SourceNode<std::tuple<Types...> >
+{
+    static constexpr bool debug = false;
+
+public:
+    using ValueType = std::tuple<Types...>;
+    using Super = SourceNode<ValueType>;
+    using Super::context_;
+
+    //! number of projected columns
+    static constexpr size_t num_columns = sizeof ... (Types);
+
+    //! structure to store info on what to read from files
+    struct FileInfo {
+        std::string path;
+        //! size of the file
+        uint64_t    size;
+        //! global byte offset of the file
+        uint64_t    global_offset;
+    };
+
+    ReadColumnarNode(Context& ctx, const std::vector<std::string>& globlist,
+                     const std::vector<size_t>& columns,
+                     const RowGroupFilter& filter)
+        : Super(ctx, "ReadColumnar", /* recomputable */ true),
+          columns_(columns), filter_(filter) {
+
+        if (columns_.size() != num_columns) {
+            die("ReadColumnar: " << columns_.size() << " columns selected "
+                "for a tuple with " << num_columns << " fields");
+        }
+
+        vfs::FileList files = ctx.Glob(globlist, vfs::GlobType::File);
+
+        if (files.size() == 0)
+            die("ReadColumnar: no files found in globs: " + tlx::join(' ', globlist));
+
+        fingerprint_ = files.fingerprint();
+
+        my_range_ = context_.CalculateLocalRange(files.total_size);
+
+        sLOG << "ReadColumnarNode:" << ctx.num_workers()
+             << "my_range" << my_range_;
+
+        // keep all files which may contain row groups starting in my_range_
+        for (const vfs::FileInfo& fi : files) {
+            if (fi.size_inc_psum() <= my_range_.begin ||
+                fi.size_ex_psum >= my_range_.end) continue;
+
+            if (fi.IsCompressed())
+                die("ReadColumnar: cannot read compressed file " << fi.path);
+
+            my_files_.emplace_back(
+                FileInfo { fi.path, fi.size, fi.size_ex_psum });
+        }
+    }
+
+    uint64_t SourceFingerprint() const final { return fingerprint_; }
+
+    void PushData(bool /* consume */) final {
+        for (const FileInfo& file : my_files_) {
+            LOG << "ReadColumnarNode::PushData() opening " << file.path;
+
+            ColumnarFooter footer = ReadFooter(file);
+            CheckTypes(file, footer);
+
+            for (const RowGroupInfo& rg : footer.row_groups) {
+                if (rg.num_rows == 0) continue;
+
+                // row groups belong to the worker owning their first byte
+                uint64_t start = file.global_offset + rg.columns[0].offset;
+                if (start < my_range_.begin || start >= my_range_.end)
+                    continue;
+
+                if (!filter_(
+                        MakeStats(rg, /* max */ false,
+                                  std::index_sequence_for<Types...>()),
+                        MakeStats(rg, /* max */ true,
+                                  std::index_sequence_for<Types...>()))) {
+                    stats_skipped_groups_++;
+                    continue;
+                }
+
+                PushRowGroup(file, rg, std::index_sequence_for<Types...>());
+                stats_read_groups_++;
+            }
+        }
+
+        Super::logger_
+            << "class" << "ReadColumnarNode"
+            << "event" << "done"
+            << "total_bytes" << stats_total_bytes_
+            << "read_groups" << stats_read_groups_
+            << "skipped_groups" << stats_skipped_groups_;
+    }
+
+    void Dispose() final {
+        tlx::vector_free(my_files_);
+    }
+
+private:
+    //! column index in the file of each tuple field
+    std::vector<size_t> columns_;
+
+    //! predicate on min/max tuples of a row group
+    RowGroupFilter filter_;
+
+    //! global byte range of this worker, row groups starting in it are read
+    common::Range my_range_;
+
+    //! files containing the byte range
+    std::vector<FileInfo> my_files_;
+
+    //! fingerprint of all files matched by the globs
+    uint64_t fingerprint_ = 0;
+
+    size_t stats_total_bytes_ = 0;
+    size_t stats_read_groups_ = 0;
+    size_t stats_skipped_groups_ = 0;
+
+    //! read size bytes at offset from the file
+    std::string ReadRange(const std::string& path,
+                          uint64_t offset, uint64_t size) {
+        std::string buffer(size, 0);
+        vfs::ReadStreamPtr rs = vfs::OpenReadStream(
+            path, common::Range(offset, offset + size));
+
+        size_t pos = 0;
+        while (pos < size) {
+            ssize_t rb = rs->read(&buffer[pos], size - pos);
+            if (rb <= 0)
+                die("ReadColumnar: unexpected end of file in " << path);
+            pos += rb;
+        }
+        rs->close();
+
+        stats_total_bytes_ += size;
+        return buffer;
+    }
+
+    ColumnarFooter ReadFooter(const FileInfo& file) {
+        if (file.size < columnar_trailer_size)
+            die("ReadColumnar: file " << file.path << " is too small");
+
+        std::string trailer = ReadRange(
+            file.path, file.size - columnar_trailer_size,
+            columnar_trailer_size);
+
+        if (std::memcmp(trailer.data() + sizeof(uint64_t), columnar_magic,
+                        sizeof(columnar_magic)) != 0)
+            die("ReadColumnar: file " << file.path << " is not columnar");
+
+        uint64_t footer_size;
+        std::memcpy(&footer_size, trailer.data(), sizeof(footer_size));
+
+        if (footer_size > file.size - columnar_trailer_size)
+            die("ReadColumnar: file " << file.path << " has invalid footer");
+
+        std::string data = ReadRange(
+            file.path, file.size - columnar_trailer_size - footer_size,
+            footer_size);
+
+        net::BufferReader br(data);
+        return ColumnarFooter::Deserialize(br);
+    }
+
+    //! check that the selected columns exist and have the tuple's types
+    void CheckTypes(const FileInfo& file, const ColumnarFooter& footer) {
+        uint8_t types[] = { ColumnTraits<Types>::type_code ... };
+        for (size_t i = 0; i < num_columns; ++i) {
+            if (columns_[i] >= footer.types.size()) {
+                die("ReadColumnar: file " << file.path << " has only "
+                                          << footer.types.size() << " columns");
+            }
+            if (footer.types[columns_[i]] != types[i]) {
+                die("ReadColumnar: column " << columns_[i] << " in file "
+                                            << file.path << " has type code "
+                                            << unsigned(footer.types[columns_[i]])
+                                            << " instead of " << unsigned(types[i]));
+            }
+        }
+    }
+
+    //! decode the min or max statistics of the projected columns
+    template <size_t... Is>
+    ValueType MakeStats(const RowGroupInfo& rg, bool max,
+                        std::index_sequence<Is...>) const {
+        return ValueType(
+            ColumnTraits<Types>::DecodeValue(
+                max ? rg.columns[columns_[Is]].max
+                : rg.columns[columns_[Is]].min) ...);
+    }
+
+    template <typename Type>
+    void ReadColumn(const FileInfo& file, const ColumnChunkInfo& info,
+                    size_t rows, std::vector<Type>& column) {
+        std::string data = ReadRange(file.path, info.offset, info.size);
+        net::BufferReader br(data);
+        ColumnTraits<Type>::Decode(br, rows, column);
+    }
+
+    //! read the projected column chunks and emit the rows
+    template <size_t... Is>
+    void PushRowGroup(const FileInfo& file, const RowGroupInfo& rg,
+                      std::index_sequence<Is...>) {
+        std::tuple<std::vector<Types>...> cols;
+        int dummy[] = {
+            (ReadColumn(file, rg.columns[columns_[Is]], rg.num_rows,
+                        std::get<Is>(cols)), 0) ...
+        };
+        (void)dummy;
+
+        for (size_t r = 0; r < rg.num_rows; ++r) {
+            this->PushItem(ValueType(std::move(std::get<Is>(cols)[r]) ...));
+        }
+    }
+};
+
+/*!
+ * ReadColumnar is a DOp, which reads files written by WriteColumnar and
+ * creates a DIA of std::tuple<Types...>. Only the selected columns are read
+ * from disk, and row groups are skipped if filter(min, max) returns false for
+ * the tuples of minimum and maximum values of the selected columns in the row
+ * group. The filter only prunes whole row groups, the DIA may hence still
+ * contain rows which a row-level Filter() has to remove.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path of the files in the file system
+ * \param columns index of the column in the file for each tuple field
+ * \param filter predicate bool(const ValueType& min, const ValueType& max)
+ *
+ * \ingroup dia_sources
+ */
+template <typename ValueType, typename RowGroupFilter>
+DIA<ValueType> ReadColumnar(
+    Context& ctx, const std::string& filepath,
+    const std::vector<size_t>& columns, const RowGroupFilter& filter) {
+
+    auto node = tlx::make_counting<
+        ReadColumnarNode<ValueType, RowGroupFilter> >(
+        ctx, std::vector<std::string>{ filepath }, columns, filter);
+
+    return DIA<ValueType>(node);
+}
+
+/*!
+ * ReadColumnar is a DOp, which reads the selected columns of files written by
+ * WriteColumnar and creates a DIA of std::tuple<Types...>.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path of the files in the file system
+ * \param columns index of the column in the file for each tuple field
+ *
+ * \ingroup dia_sources
+ */
+template <typename ValueType>
+DIA<ValueType> ReadColumnar(
+    Context& ctx, const std::string& filepath,
+    const std::vector<size_t>& columns) {
+    return ReadColumnar<ValueType>(
+        ctx, filepath, columns,
+        [](const ValueType&, const ValueType&) { return true; });
+}
+
+/*!
+ * ReadColumnar is a DOp, which reads all columns of files written by
+ * WriteColumnar and creates a DIA of std::tuple<Types...>.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path of the files in the file system
+ *
+ * \ingroup dia_sources
+ */
+template <typename ValueType>
+DIA<ValueType> ReadColumnar(Context& ctx, const std::string& filepath) {
+    std::vector<size_t> columns(std::tuple_size<ValueType>::value);
+    for (size_t i = 0; i < columns.size(); ++i) columns[i] = i;
+    return ReadColumnar<ValueType>(ctx, filepath, columns);
+}
+
+} // namespace api
+
+//! imported from api namespace
+using api::ReadColumnar;
+
+} // namespace thrill
+
+#endif // !THRILL_API_READ_COLUMNAR_HEADER
+
+/******************************************************************************/
@@ -22,9 +22,14 @@
 #include <thrill/common/system_exception.hpp>
 #include <thrill/net/buffer_builder.hpp>
 #include <thrill/vfs/file_io.hpp>
+#include <thrill/vfs/locality.hpp>
+#include <thrill/vfs/split_stream.hpp>
 
+#include <tlx/container/string_view.hpp>
 #include <tlx/string/join.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,25 +39,28 @@ namespace api {
 
 /*!
  * A DIANode which performs a line-based Read operation. Reads a file from the
- * file system and delivers it as a DIA.
+ * file system and delivers it as a DIA. ValueType is either std::string, or
+ * tlx::string_view for the zero-copy mode of ReadLinesView(), in which the
+ * lines reference the read buffer.
  *
  * \ingroup api_layer
  */
-class ReadLinesNode final : public SourceNode<std::string>
+template <typename ValueType>
+class ReadLinesNode final : public SourceNode<ValueType>
 {
     static constexpr bool debug = false;
 
 public:
-    using Super = SourceNode<std::string>;
+    using Super = SourceNode<ValueType>;
     using Super::context_;
 
     //! Constructor for a ReadLinesNode. Sets the Context and file path.
     ReadLinesNode(Context& ctx, const std::vector<std::string>& globlist,
                   bool local_storage)
-        : Super(ctx, "ReadLines"),
+        : Super(ctx, "ReadLines", /* recomputable */ true),
           local_storage_(local_storage) {
 
-        filelist_ = vfs::Glob(globlist, vfs::GlobType::File);
+        filelist_ = ctx.Glob(globlist, vfs::GlobType::File, local_storage);
 
         if (filelist_.size() == 0)
             die("ReadLines: no files found in globs: " + tlx::join(' ', globlist));
@@ -66,19 +74,37 @@ public:
         : ReadLinesNode(ctx, std::vector<std::string>{ glob }, local_storage)
     { }
 
+    uint64_t SourceFingerprint() const final {
+        return filelist_.fingerprint();
+    }
+
+    bool ScanSource() const final { return true; }
+
     DIAMemUse PushDataMemUse() final {
         // InputLineIterators read files block-wise
         return data::default_block_size;
     }
 
     void PushData(bool /* consume */) final {
-        if (filelist_.contains_compressed) {
+        if (!local_storage_ && vfs::HasBlockLocations(filelist_)) {
+            // read the blocks of a distributed file system on the hosts
+            // storing them, parts of files are read with split streams.
+            InputLineIteratorCompressed it(
+                filelist_, *this,
+                context_.CalculateLocalityRanges(filelist_));
+
+            // Hook Read
+            while (it.HasNext()) {
+                PushLine(it.Next(), static_cast<ValueType*>(nullptr));
+            }
+        }
+        else if (filelist_.contains_compressed) {
             InputLineIteratorCompressed it(
                 filelist_, *this, local_storage_);
 
             // Hook Read
             while (it.HasNext()) {
-                this->PushItem(it.Next());
+                PushLine(it.Next(), static_cast<ValueType*>(nullptr));
             }
         }
         else {
@@ -87,7 +113,7 @@ public:
 
             // Hook Read
             while (it.HasNext()) {
-                this->PushItem(it.Next());
+                PushLine(it.Next(), static_cast<ValueType*>(nullptr));
             }
         }
     }
@@ -99,6 +125,20 @@ private:
     //! system.
     bool local_storage_;
 
+    //! String which lines are copied into for std::string items.
+    std::string line_;
+
+    //! push line as std::string, reusing the memory of line_
+    void PushLine(const tlx::string_view& line, std::string*) {
+        line_.assign(line.data(), line.size());
+        this->PushItem(line_);
+    }
+
+    //! push line as reference into the read buffer
+    void PushLine(const tlx::string_view& line, tlx::string_view*) {
+        this->PushItem(line);
+    }
+
     class InputLineIterator
     {
     public:
@@ -118,7 +158,8 @@ private:
     protected:
         //! Block read size
         const size_t read_size = data::default_block_size;
-        //! String, which Next() references to
+        //! String collecting lines which span blocks, which Next() then
+        //! references to
         std::string data_;
         //! Input files with size prefixsum.
         const vfs::FileList& files_;
@@ -140,6 +181,22 @@ private:
         size_t total_reads_ = 0;
         size_t total_elements_ = 0;
 
+        //! find next newline in [begin,end) with the vectorized memchr(), or
+        //! return nullptr.
+        static unsigned char * FindNewline(
+            unsigned char* begin, unsigned char* end) {
+            if (begin >= end) return nullptr;
+            return reinterpret_cast<unsigned char*>(
+                std::memchr(begin, '\n', end - begin));
+        }
+
+        //! reference to the characters [begin,end)
+        static tlx::string_view MakeView(
+            const unsigned char* begin, const unsigned char* end) {
+            return tlx::string_view(
+                reinterpret_cast<const char*>(begin), end - begin);
+        }
+
         bool ReadBlock(vfs::ReadStreamPtr& file,
                        net::BufferBuilder& buffer) {
             read_timer.Start();
@@ -214,11 +271,10 @@ private:
                 // find next newline, discard all previous data as previous
                 // worker already covers it
                 while (!found_n) {
-                    while (current_ < buffer_.end()) {
-                        if (TLX_UNLIKELY(*current_++ == '\n')) {
-                            found_n = true;
-                            break;
-                        }
+                    unsigned char* nl = FindNewline(current_, buffer_.end());
+                    if (nl != nullptr) {
+                        current_ = nl + 1;
+                        found_n = true;
                     }
                     // no newline found: read new data into buffer_builder
                     if (!found_n) {
@@ -233,21 +289,32 @@ private:
             data_.reserve(4 * 1024);
         }
 
-        //! returns the next element if one exists
+        //! returns the next element if one exists, which references the
+        //! buffer or data_ until the next call.
         //!
         //! does no checks whether a next element exists!
-        const std::string& Next() {
+        tlx::string_view Next() {
             total_elements_++;
+
+            // fast path: line is contained in the current block
+            unsigned char* nl = FindNewline(current_, buffer_.end());
+            if (TLX_LIKELY(nl != nullptr)) {
+                tlx::string_view line = MakeView(current_, nl);
+                current_ = nl + 1;
+                return line;
+            }
+
             data_.clear();
             while (true) {
-                while (TLX_LIKELY(current_ < buffer_.end())) {
-                    if (TLX_UNLIKELY(*current_ == '\n')) {
-                        current_++;
-                        return data_;
-                    }
-                    else {
-                        data_.push_back(*current_++);
-                    }
+                nl = FindNewline(current_, buffer_.end());
+                if (nl != nullptr) {
+                    data_.append(current_, nl);
+                    current_ = nl + 1;
+                    return tlx::string_view(data_.data(), data_.size());
+                }
+                if (current_ < buffer_.end()) {
+                    data_.append(current_, buffer_.end());
+                    current_ = buffer_.end();
                 }
                 offset_ += buffer_.size();
                 if (!ReadBlock(stream_, buffer_)) {
@@ -269,7 +336,7 @@ private:
                     }
 
                     if (data_.length()) {
-                        return data_;
+                        return tlx::string_view(data_.data(), data_.size());
                     }
                 }
             }
@@ -292,7 +359,15 @@ private:
         vfs::ReadStreamPtr stream_;
     };
 
-    //! InputLineIterator gives you access to lines of a file
+    /*!
+     * InputLineIterator for file lists containing compressed files. Files
+     * which vfs::IsSplittable() are read in parallel: each worker decodes the
+     * part of the file overlapping its byte range of the compressed data with a
+     * split stream, which delivers exactly the lines starting in its blocks.
+     * Other compressed files are read completely by the worker whose range
+     * contains the middle of the file. The iterator also reads the multiple
+     * ranges assigned to a worker by Context::CalculateLocalityRanges().
+     */
     class InputLineIteratorCompressed : public InputLineIterator
     {
     public:
@@ -311,131 +386,138 @@ private:
                     files.total_size);
             }
 
-            file_nr_ = 0;
-
-            while (file_nr_ < files_.size() &&
-                   (files_[file_nr_].size_inc_psum() +
-                    files_[file_nr_].size_ex_psum) / 2 <= my_range_.begin) {
-                ++file_nr_;
-            }
-
-            if (file_nr_ == files_.size()) {
-                LOG << "Start behind last file, not reading anything!";
-                return;
-            }
-
-            for (size_t i = file_nr_; i < files_.size(); i++) {
-                if ((files_[i].size_inc_psum() + files_[i].size_ex_psum) / 2
-                    == my_range_.end) {
-                    break;
-                }
-                if ((files_[i].size_inc_psum() + files_[i].size_ex_psum) / 2
-                    > my_range_.end) {
-                    my_range_.end = files_.size_ex_psum(i);
-                    break;
-                }
-            }
-
-            if (my_range_.begin >= my_range_.end) {
-                // No local files, set buffer size to 2, so HasNext() does not try to read
-                LOG << "ReadLines: my_range " << my_range_;
-                buffer_.Reserve(2);
-                buffer_.set_size(2);
-                current_ = buffer_.begin();
-                return;
-            }
-
-            sLOG << "ReadLines: opening compressed file" << file_nr_
-                 << "my_range" << my_range_;
-
-            stream_ = vfs::OpenReadStream(files_[file_nr_].path);
+            CollectParts({ my_range_ });
+        }
 
-            buffer_.Reserve(read_size);
-            ReadBlock(stream_, buffer_);
-            data_.reserve(4 * 1024);
+        //! Creates an instance of iterator that reads the lines starting in
+        //! the given global byte ranges.
+        InputLineIteratorCompressed(const vfs::FileList& files,
+                                    ReadLinesNode& node,
+                                    const std::vector<common::Range>& ranges)
+            : InputLineIterator(files, node) {
+            CollectParts(ranges);
         }
 
-        //! returns the next element if one exists
+        //! returns the next element if one exists, which references the
+        //! buffer or data_ until the next call.
         //!
         //! does no checks whether a next element exists!
-        const std::string& Next() {
+        tlx::string_view Next() {
             total_elements_++;
+
+            // fast path: line is contained in the current block
+            unsigned char* nl = FindNewline(current_, buffer_.end());
+            if (TLX_LIKELY(nl != nullptr)) {
+                tlx::string_view line = MakeView(current_, nl);
+                current_ = nl + 1;
+                return line;
+            }
+
             data_.clear();
             while (true) {
-                while (current_ < buffer_.end()) {
-                    if (TLX_UNLIKELY(*current_ == '\n')) {
-                        current_++;
-                        return data_;
-                    }
-                    else {
-                        data_.push_back(*current_++);
-                    }
+                nl = FindNewline(current_, buffer_.end());
+                if (nl != nullptr) {
+                    data_.append(current_, nl);
+                    current_ = nl + 1;
+                    return tlx::string_view(data_.data(), data_.size());
+                }
+                if (current_ < buffer_.end()) {
+                    data_.append(current_, buffer_.end());
+                    current_ = buffer_.end();
                 }
 
                 if (!ReadBlock(stream_, buffer_)) {
-                    LOG << "ReadLines: opening new compressed file!";
+                    // end of part: the last line has no newline
                     stream_->close();
-                    file_nr_++;
-
-                    if (file_nr_ < files_.size()) {
-                        stream_ = vfs::OpenReadStream(files_[file_nr_].path);
-                        ReadBlock(stream_, buffer_);
-                    }
-                    else {
-                        LOG << "ReadLines: reached last file";
-                        current_ = buffer_.begin();
-                    }
-
-                    if (data_.length()) {
-                        LOG << "ReadLines: end - returning string of length"
-                            << data_.length();
-                        return data_;
-                    }
+                    stream_.reset();
+                    return tlx::string_view(data_.data(), data_.size());
                 }
             }
         }
 
         //! returns true, if an element is available in local part
         bool HasNext() {
-            if (files_.size_ex_psum(file_nr_) >= my_range_.end) {
-                return false;
-            }
+            while (current_ >= buffer_.end()) {
+                if (stream_) {
+                    if (ReadBlock(stream_, buffer_)) break;
+                    stream_->close();
+                    stream_.reset();
+                }
+                if (part_nr_ >= parts_.size())
+                    return false;
+
+                const Part& p = parts_[part_nr_++];
+                file_nr_ = p.file_nr;
+
+                sLOG << "ReadLines: opening compressed file" << file_nr_
+                     << "range" << p.range << "split" << p.split;
 
-            // if block is fully read, read next block. needs to be done here
-            // as HasNext() has to know if file is finished
-            //         v-- no new line at end ||   v-- newline at end of file
-            if (current_ >= buffer_.end() || (current_ + 1 >= buffer_.end() && *current_ == '\n')) {
-                LOG << "ReadLines: new buffer in HasNext()";
-                ReadBlock(stream_, buffer_);
-                if (buffer_.size() > 1 || (buffer_.size() == 1 && buffer_[0] != '\n')) {
-                    return true;
+                if (p.split) {
+                    stream_ = vfs::OpenSplitLinesReadStream(
+                        files_[file_nr_].path, p.range);
                 }
                 else {
-                    LOG << "ReadLines: opening new file in HasNext()";
-                    // already at last file
-                    if (file_nr_ >= files_.size() - 1) {
-                        return false;
-                    }
-                    stream_->close();
-                    // if (this worker reads at least one more file)
-                    if (my_range_.end > files_[file_nr_].size_inc_psum()) {
-                        file_nr_++;
-                        stream_ = vfs::OpenReadStream(files_[file_nr_].path);
-                        ReadBlock(stream_, buffer_);
-                        return true;
+                    stream_ = vfs::OpenReadStream(files_[file_nr_].path);
+                }
+            }
+            return true;
+        }
+
+    private:
+        //! collect parts of files to read in the sorted global byte ranges
+        void CollectParts(const std::vector<common::Range>& ranges) {
+            for (const common::Range& range : ranges) {
+                for (file_nr_ = 0; file_nr_ < files_.size(); ++file_nr_) {
+                    const vfs::FileInfo& fi = files_[file_nr_];
+                    uint64_t begin = fi.size_ex_psum, end = fi.size_inc_psum();
+
+                    if (begin >= range.end) break;
+                    if (end <= range.begin) continue;
+
+                    if (vfs::IsSplittable(fi.path)) {
+                        parts_.emplace_back(
+                            file_nr_, common::Range(
+                                std::max<uint64_t>(begin, range.begin) - begin,
+                                std::min<uint64_t>(end, range.end) - begin),
+                            /* split */ true);
                     }
-                    else {
-                        return false;
+                    else if ((begin + end) / 2 >= range.begin &&
+                             (begin + end) / 2 < range.end) {
+                        parts_.emplace_back(
+                            file_nr_, common::Range(0, 0), /* split */ false);
                     }
                 }
             }
-            else {
-                return true;
-            }
+
+            sLOG << "ReadLines: reading" << parts_.size()
+                 << "file parts in" << ranges.size() << "ranges";
+
+            buffer_.Reserve(read_size);
+            buffer_.set_size(0);
+            current_ = buffer_.begin();
+            data_.reserve(4 * 1024);
         }
 
-    private:
-        //! File handle to files_[file_nr_]
+        //! part of a file to read
+        struct Part {
+            Part(size_t file_nr, const common::Range& range, bool split)
+                : file_nr(file_nr), range(range), split(split) { }
+
+            //! index of file in files_
+            size_t        file_nr;
+            //! byte range in the compressed file, if split
+            common::Range range;
+            //! whether to read a range with a split stream
+            bool          split;
+        };
+
+        //! parts of files to read
+        std::vector<Part> parts_;
+
+        //! index of next part to open
+        size_t part_nr_ = 0;
+
+        //! File handle to current part
         vfs::ReadStreamPtr stream_;
     };
 };
@@ -453,7 +535,7 @@ private:
  */
 DIA<std::string> ReadLines(Context& ctx, const std::string& filepath) {
     return DIA<std::string>(
-        tlx::make_counting<ReadLinesNode>(
+        tlx::make_counting<ReadLinesNode<std::string> >(
             ctx, filepath, /* local_storage */ false));
 }
 
@@ -471,7 +553,7 @@ DIA<std::string> ReadLines(Context& ctx, const std::string& filepath) {
 DIA<std::string> ReadLines(struct LocalStorageTag, Context& ctx,
                            const std::string& filepath) {
     return DIA<std::string>(
-        tlx::make_counting<ReadLinesNode>(
+        tlx::make_counting<ReadLinesNode<std::string> >(
             ctx, filepath, /* local_storage */ true));
 }
 
@@ -489,7 +571,7 @@ DIA<std::string> ReadLines(struct LocalStorageTag, Context& ctx,
 DIA<std::string> ReadLines(
     Context& ctx, const std::vector<std::string>& filepaths) {
     return DIA<std::string>(
-        tlx::make_counting<ReadLinesNode>(
+        tlx::make_counting<ReadLinesNode<std::string> >(
             ctx, filepaths, /* local_storage */ false));
 }
 
@@ -507,7 +589,74 @@ DIA<std::string> ReadLines(
 DIA<std::string> ReadLines(struct LocalStorageTag, Context& ctx,
                            const std::vector<std::string>& filepaths) {
     return DIA<std::string>(
-        tlx::make_counting<ReadLinesNode>(
+        tlx::make_counting<ReadLinesNode<std::string> >(
+            ctx, filepaths, /* local_storage */ true));
+}
+
+/*!
+ * ReadLinesView is a DOp, which reads lines of files from the file system like
+ * ReadLines(), but without copying them: the tlx::string_view items reference
+ * the read buffer and are valid only while they are pushed. Hence, they can
+ * only be consumed by fused local operations like Map() or FlatMap(), which
+ * avoids allocating a std::string per line.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path of the file in the file system
+ *
+ * \ingroup dia_sources
+ */
+DIA<tlx::string_view> ReadLinesView(Context& ctx, const std::string& filepath) {
+    return DIA<tlx::string_view>(
+        tlx::make_counting<ReadLinesNode<tlx::string_view> >(
+            ctx, filepath, /* local_storage */ false));
+}
+
+/*!
+ * ReadLinesView is a DOp, which reads lines of files from the file system like
+ * ReadLines(), but without copying them. See ReadLinesView() above.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path of the file in the file system
+ *
+ * \ingroup dia_sources
+ */
+DIA<tlx::string_view> ReadLinesView(struct LocalStorageTag, Context& ctx,
+                                    const std::string& filepath) {
+    return DIA<tlx::string_view>(
+        tlx::make_counting<ReadLinesNode<tlx::string_view> >(
+            ctx, filepath, /* local_storage */ true));
+}
+
+/*!
+ * ReadLinesView is a DOp, which reads lines of files from the file system like
+ * ReadLines(), but without copying them. See ReadLinesView() above.
+ *
+ * \param ctx Reference to the context object
+ * \param filepaths Path of the file in the file system
+ *
+ * \ingroup dia_sources
+ */
+DIA<tlx::string_view> ReadLinesView(
+    Context& ctx, const std::vector<std::string>& filepaths) {
+    return DIA<tlx::string_view>(
+        tlx::make_counting<ReadLinesNode<tlx::string_view> >(
+            ctx, filepaths, /* local_storage */ false));
+}
+
+/*!
+ * ReadLinesView is a DOp, which reads lines of files from the file system like
+ * ReadLines(), but without copying them. See ReadLinesView() above.
+ *
+ * \param ctx Reference to the context object
+ * \param filepaths Path of the file in the file system
+ *
+ * \ingroup dia_sources
+ */
+DIA<tlx::string_view> ReadLinesView(
+    struct LocalStorageTag, Context& ctx,
+    const std::vector<std::string>& filepaths) {
+    return DIA<tlx::string_view>(
+        tlx::make_counting<ReadLinesNode<tlx::string_view> >(
             ctx, filepaths, /* local_storage */ true));
 }
 
@@ -515,6 +664,7 @@ DIA<std::string> ReadLines(struct LocalStorageTag, Context& ctx,
 
 //! imported from api namespace
 using api::ReadLines;
+using api::ReadLinesView;
 
 } // namespace thrill
 
@@ -0,0 +1,169 @@
+/*******************************************************************************
+ * thrill/api/read_stream.cpp
+ *
+ * Unbounded sources of text lines, which are read in micro-batches, each
+ * becoming a DIA processed by the same operators as batch inputs.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/read_stream.hpp>
+
+#include <thrill/common/system_exception.hpp>
+
+#if THRILL_HAVE_NET_TCP
+#include <thrill/net/tcp/socket.hpp>
+#include <thrill/net/tcp/socket_address.hpp>
+#endif
+
+#include <tlx/die.hpp>
+#include <tlx/string/starts_with.hpp>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace thrill {
+namespace api {
+
+/******************************************************************************/
+// StreamPartition
+
+StreamPartition::StreamPartition(const std::string& source)
+    : source_(source) {
+    if (tlx::starts_with(source, "tcp://")) {
+#if THRILL_HAVE_NET_TCP
+        net::tcp::SocketAddress address(source.substr(6));
+        die_unless(address.IsValid());
+        net::tcp::Socket socket = net::tcp::Socket::Create();
+        if (socket.connect(address) != 0)
+            throw common::ErrnoException("Could not connect to " + source);
+        fd_ = ::dup(socket.fd());
+#else
+        die("StreamPartition: tcp sources are not supported: " << source);
+#endif
+    }
+    else {
+        fd_ = ::open(source.c_str(), O_RDONLY | O_NONBLOCK);
+    }
+    if (fd_ < 0)
+        throw common::ErrnoException("Could not open stream " + source);
+
+    int flags = ::fcntl(fd_, F_GETFL);
+    if (flags < 0 || ::fcntl(fd_, F_SETFL, flags | O_NONBLOCK) != 0)
+        throw common::ErrnoException("Error setting O_NONBLOCK on " + source);
+}
+
+StreamPartition::~StreamPartition() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool StreamPartition::Poll(std::vector<std::string>& out, size_t max_items) {
+    TakeRecords(out, max_items);
+    while (out.size() < max_items && ReadAvailable())
+        TakeRecords(out, max_items);
+
+    // the last record of an ended source may lack its newline
+    if (eof_ && out.size() < max_items && !buffer_.empty()) {
+        out.emplace_back(std::move(buffer_));
+        buffer_.clear();
+        ++offset_;
+    }
+
+    return !ended();
+}
+
+void StreamPartition::TakeRecords(
+    std::vector<std::string>& out, size_t max_items) {
+    size_t begin = 0;
+    while (out.size() < max_items) {
+        size_t end = buffer_.find('\n', begin);
+        if (end == std::string::npos) break;
+        out.emplace_back(buffer_, begin, end - begin);
+        begin = end + 1;
+        ++offset_;
+    }
+    buffer_.erase(0, begin);
+}
+
+bool StreamPartition::ReadAvailable() {
+    char data[64 * 1024];
+    ssize_t r = ::read(fd_, data, sizeof(data));
+    if (r > 0) {
+        buffer_.append(data, static_cast<size_t>(r));
+        return true;
+    }
+    if (r == 0) {
+        // end of socket or FIFO, or the current end of a regular file
+        eof_ = true;
+        return false;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        return false;
+    throw common::ErrnoException("Error reading stream " + source_);
+}
+
+/******************************************************************************/
+// MicroBatchSource
+
+MicroBatchSource::MicroBatchSource(
+    Context& ctx, const std::vector<std::string>& partitions,
+    size_t max_batch_items, const std::chrono::milliseconds& max_batch_wait)
+    : context_(ctx),
+      max_batch_items_(max_batch_items),
+      max_batch_wait_(max_batch_wait) {
+    for (size_t i = ctx.my_rank(); i < partitions.size();
+         i += ctx.num_workers()) {
+        partitions_.emplace_back(
+            std::make_unique<StreamPartition>(partitions[i]));
+    }
+}
+
+DIA<std::string> MicroBatchSource::NextBatch() {
+    auto deadline = std::chrono::steady_clock::now() + max_batch_wait_;
+
+    std::vector<std::string> lines;
+    std::vector<struct pollfd> pfds;
+    bool open;
+    while (true) {
+        // rotate the first partition, such that all are read when batches
+        // are full.
+        open = false;
+        pfds.clear();
+        for (size_t i = 0; i < partitions_.size(); ++i) {
+            StreamPartition& p =
+                *partitions_[(num_batches_ + i) % partitions_.size()];
+            if (p.ended()) continue;
+            if (p.Poll(lines, max_batch_items_)) {
+                open = true;
+                pfds.push_back(pollfd { p.fd(), POLLIN, 0 });
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!open || lines.size() >= max_batch_items_ || now >= deadline)
+            break;
+
+        // wait for more bytes on any partition, at most until the deadline
+        int timeout = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - now).count()) + 1;
+        if (::poll(pfds.data(), pfds.size(), timeout) < 0 && errno != EINTR)
+            throw common::ErrnoException("Error polling streams");
+    }
+    ++num_batches_;
+
+    ended_ = !context_.net.AllReduce(
+        open, [](const bool& a, const bool& b) { return a || b; });
+
+    return ConcatToDIA(context_, std::move(lines));
+}
+
+} // namespace api
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * thrill/api/read_stream.hpp
+ *
+ * Unbounded sources of text lines, which are read in micro-batches, each
+ * becoming a DIA processed by the same operators as batch inputs.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_READ_STREAM_HEADER
+#define THRILL_API_READ_STREAM_HEADER
+
+#include <thrill/api/concat_to_dia.hpp>
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/common/logger.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+//! \ingroup api_layer
+//! \{
+
+/*!
+ * One partition of an unbounded stream of newline-terminated records, similar
+ * to a Kafka partition, which is read by one worker. The source is either
+ * "tcp://host:port", to which a connection is made, or a path, e.g. of a
+ * FIFO. Sockets end when the writer closes them, FIFOs once no writer has
+ * them open, and regular files at their size when they are read to it.
+ *
+ * The descriptor and a partial last line are kept between polls, and offset()
+ * counts the records read so far.
+ */
+class StreamPartition
+{
+public:
+    //! open the source, throws if it cannot be opened.
+    explicit StreamPartition(const std::string& source);
+
+    //! non-copyable: delete copy-constructor
+    StreamPartition(const StreamPartition&) = delete;
+    //! non-copyable: delete assignment operator
+    StreamPartition& operator = (const StreamPartition&) = delete;
+
+    //! close the source
+    ~StreamPartition();
+
+    //! Append the available records to out, until out contains max_items
+    //! records, without waiting for more. Returns false once the source
+    //! ended and all its records were returned.
+    bool Poll(std::vector<std::string>& out, size_t max_items);
+
+    //! the source's name
+    const std::string& source() const { return source_; }
+
+    //! number of records read so far
+    size_t offset() const { return offset_; }
+
+    //! whether the source ended and all its records were returned
+    bool ended() const { return eof_ && buffer_.empty(); }
+
+    //! the non-blocking file descriptor, for waiting on it
+    int fd() const { return fd_; }
+
+private:
+    //! name of the source
+    std::string source_;
+
+    //! non-blocking file descriptor
+    int fd_ = -1;
+
+    //! whether the source returned its end
+    bool eof_ = false;
+
+    //! received bytes after the last complete record
+    std::string buffer_;
+
+    //! number of records read so far
+    size_t offset_ = 0;
+
+    //! move complete records from buffer_ to out, up to max_items
+    void TakeRecords(std::vector<std::string>& out, size_t max_items);
+
+    //! read available bytes into buffer_, returns false if none were
+    //! available.
+    bool ReadAvailable();
+};
+
+/*!
+ * An unbounded source of text lines, read by all workers in micro-batches.
+ * Partitions are assigned round-robin to workers, each worker keeps its
+ * partitions open between batches. NextBatch() gathers at most
+ * max_batch_items lines per worker, waiting at most max_batch_wait for
+ * them on all its partitions at once, and returns them as a DIA.
+ *
+ * The Context, hence the network connections, block pool, and thread pools,
+ * persist between batches, only the DIA nodes of each batch are new.
+ */
+class MicroBatchSource
+{
+public:
+    MicroBatchSource(
+        Context& ctx, const std::vector<std::string>& partitions,
+        size_t max_batch_items = 65536,
+        const std::chrono::milliseconds& max_batch_wait =
+            std::chrono::milliseconds(10));
+
+    //! Collective: read the next batch of lines of all workers.
+    DIA<std::string> NextBatch();
+
+    //! whether all partitions of all workers ended, known after NextBatch().
+    bool ended() const { return ended_; }
+
+    //! number of batches read
+    size_t num_batches() const { return num_batches_; }
+
+private:
+    //! the worker's Context
+    Context& context_;
+
+    //! partitions read by this worker
+    std::vector<std::unique_ptr<StreamPartition> > partitions_;
+
+    //! maximum number of lines per worker and batch
+    size_t max_batch_items_;
+
+    //! maximum time to wait for lines
+    std::chrono::milliseconds max_batch_wait_;
+
+    //! whether all partitions of all workers ended
+    bool ended_ = false;
+
+    //! number of batches read
+    size_t num_batches_ = 0;
+};
+
+/*!
+ * Micro-batch driver: reads batches from source and calls
+ * batch_function(DIA<std::string> batch, size_t index) for each, until all
+ * partitions ended, or batch_function returns false, which must happen on all
+ * workers, e.g. decided on the result of an action. Returns the number of
+ * batches.
+ */
+template <typename BatchFunction>
+size_t RunMicroBatches(MicroBatchSource& source,
+                       const BatchFunction& batch_function) {
+    static constexpr bool debug = false;
+
+    size_t index = 0;
+    while (true) {
+        DIA<std::string> batch = source.NextBatch();
+        bool proceed = batch_function(batch, index++);
+
+        sLOG << "RunMicroBatches(): finished batch" << index - 1;
+
+        if (!proceed || source.ended()) break;
+    }
+    return index;
+}
+
+//! \}
+
+} // namespace api
+
+//! imported from api namespace
+using api::MicroBatchSource;
+
+//! imported from api namespace
+using api::RunMicroBatches;
+
+} // namespace thrill
+
+#endif // !THRILL_API_READ_STREAM_HEADER
+
+/******************************************************************************/
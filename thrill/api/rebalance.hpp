@@ -81,10 +81,15 @@ public:
         const double pre_pe =
             static_cast<double>(global_size) / static_cast<double>(num_workers);
 
-        // calculate offset vector
+        // calculate offset vector, which follows the capacity weights of the
+        // workers if they are set.
         std::vector<size_t> offsets(num_workers + 1, 0);
         for (size_t p = 0; p < num_workers; ++p) {
-            size_t limit = static_cast<size_t>(static_cast<double>(p) * pre_pe);
+            size_t limit =
+                context_.has_worker_weights()
+                ? static_cast<size_t>(context_.worker_weight_prefix(p)
+                                      * static_cast<double>(global_size))
+                : static_cast<size_t>(static_cast<double>(p) * pre_pe);
             if (limit < local_rank) continue;
 
             offsets[p] = std::min(limit - local_rank, file_.num_items());
@@ -22,10 +22,17 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/core/reduce_by_hash_post_phase.hpp>
+#include <thrill/core/reduce_by_sort_post_phase.hpp>
+#include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_hash_cache.hpp>
 #include <thrill/core/reduce_pre_phase.hpp>
+#include <thrill/core/reduce_shared_pre_table.hpp>
+#include <thrill/core/two_level_exchange.hpp>
 #include <tlx/meta/is_std_pair.hpp>
 
 #include <functional>
+#include <memory>
+#include <string>
 #include <thread>
 #include <type_traits>
 #include <typeinfo>
@@ -69,16 +76,54 @@ private:
     using Super = DOpNode<ValueType>;
     using Super::context_;
 
-    using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
+    using UserKey = typename common::FunctionTraits<KeyExtractor>::result_type;
+
+    //! carry a hash of the key along with each item, which requires storing
+    //! the key separately in the TableItem.
+    static constexpr bool use_hash_cache_ = ReduceConfig::use_hash_cache_;
+
+    using HashCache = core::ReduceHashCacheSelect<
+        use_hash_cache_, UserKey, ValueType,
+        KeyExtractor, KeyHashFunction, KeyEqualFunction>;
+
+    //! key, key extractor and functions used by the reduce tables
+    using Key = typename HashCache::TableKey;
+    using TableKeyExtractor = typename HashCache::TableKeyExtractor;
+    using TableKeyHashFunction = typename HashCache::TableKeyHashFunction;
+    using TableKeyEqualFunction = typename HashCache::TableKeyEqualFunction;
+
+    static constexpr bool TableVolatileKey = VolatileKey || use_hash_cache_;
 
     using TableItem =
         typename std::conditional<
-            VolatileKey, std::pair<Key, ValueType>, ValueType>::type;
+            TableVolatileKey, std::pair<Key, ValueType>, ValueType>::type;
 
-    using HashIndexFunction = core::ReduceByHash<Key, KeyHashFunction>;
+    using HashIndexFunction = core::ReduceByHash<Key, TableKeyHashFunction>;
+
+    using MakeTableItem =
+        core::ReduceMakeTableItem<ValueType, TableItem, TableVolatileKey>;
 
     static constexpr bool use_mix_stream_ = ReduceConfig::use_mix_stream_;
     static constexpr bool use_post_thread_ = ReduceConfig::use_post_thread_;
+    static constexpr bool use_two_level_exchange_ =
+        ReduceConfig::use_two_level_exchange_;
+
+    //! reduce in a table shared by the host's workers first, which is not
+    //! compatible with the hash sets of duplicate detection.
+    static constexpr bool use_shared_pre_phase_ =
+        ReduceConfig::use_shared_pre_phase_ && !UseDuplicateDetection;
+
+    using SharedPreTable = core::ReduceSharedPreTable<
+        TableItem, Key, ValueType, TableKeyExtractor, ReduceFunction,
+        TableVolatileKey, HashIndexFunction, TableKeyEqualFunction>;
+
+    using TwoLevelExchange = core::TwoLevelExchange<TableItem>;
+
+    //! Writer type used by the PrePhase to emit items
+    using PreWriter = typename std::conditional<
+        use_two_level_exchange_,
+        typename TwoLevelExchange::Writer, data::Stream::Writer>::type;
+    using PreWriters = std::vector<PreWriter>;
 
     //! Emitter for PostPhase to push elements to next DIA object.
     class Emitter
@@ -106,26 +151,59 @@ public:
                const KeyHashFunction& key_hash_function,
                const KeyEqualFunction& key_equal_function)
         : Super(parent.ctx(), label, { parent.id() }, { parent.node() }),
-          mix_stream_(use_mix_stream_ ?
+          config_(config),
+          mix_stream_(use_mix_stream_ && !use_two_level_exchange_ ?
                       parent.ctx().GetNewMixStream(this) : nullptr),
-          cat_stream_(use_mix_stream_ ?
+          cat_stream_(use_mix_stream_ || use_two_level_exchange_ ?
                       nullptr : parent.ctx().GetNewCatStream(this)),
-          emitters_(use_mix_stream_ ?
-                    mix_stream_->GetWriters() : cat_stream_->GetWriters()),
+          exchange_(use_two_level_exchange_ ?
+                    new TwoLevelExchange(parent.ctx(), Super::dia_id())
+                    : nullptr),
+          emitters_(
+              GetEmitters(std::integral_constant<
+                              bool, use_two_level_exchange_>())),
           pre_phase_(
               context_, Super::dia_id(), parent.ctx().num_workers(),
-              key_extractor, reduce_function, emitters_, config,
-              HashIndexFunction(key_hash_function), key_equal_function,
-              key_hash_function),
+              HashCache::key_extractor(key_extractor, key_hash_function),
+              reduce_function, emitters_, config,
+              PreIndexFunction(
+                  parent.ctx(),
+                  HashCache::key_hash_function(key_hash_function)),
+              HashCache::key_equal_function(key_equal_function),
+              HashCache::key_hash_function(key_hash_function)),
           post_phase_(
-              context_, Super::dia_id(), key_extractor, reduce_function,
-              Emitter(this), config,
-              HashIndexFunction(key_hash_function), key_equal_function) {
+              context_, Super::dia_id(),
+              HashCache::key_extractor(key_extractor, key_hash_function),
+              reduce_function, Emitter(this), config,
+              HashIndexFunction(HashCache::key_hash_function(key_hash_function)),
+              HashCache::key_equal_function(key_equal_function)) {
+        // if all items of a key are already on one worker, e.g. after another
+        // ReduceByKey() with the same key, reduce them locally in the
+        // post-phase and skip the exchange.
+        local_ = parent.partitioning().template IsHash<KeyExtractor>();
+        this->set_partitioning(DIAPartitioning::Hash<KeyExtractor>());
+
+        // items scanned from a source, e.g. ReadLines() followed only by
+        // LOps, arrive in long runs: insert them into the pre-phase table in
+        // batches with prefetched slots.
+        if (parent.node()->ScanSource())
+            pre_phase_.set_batch_insert(true);
+
         // Hook PreOp: Locally hash elements of the current DIA onto buckets and
         // reduce each bucket to a single value, afterwards send data to another
         // worker given by the shuffle algorithm.
         auto pre_op_fn = [this](const ValueType& input) {
-                             return pre_phase_.Insert(input);
+                             if (local_) {
+                                 post_phase_.Insert(
+                                     MakeTableItem::Make(
+                                         input,
+                                         pre_phase_.table().key_extractor()));
+                                 return;
+                             }
+                             if (use_shared_pre_phase_ && shared_table_ &&
+                                 shared_table_->Insert(input))
+                                 return;
+                             pre_phase_.Insert(input);
                          };
         // close the function stack with our pre op and register it at
         // parent node for output
@@ -136,17 +214,20 @@ public:
     DIAMemUse PreOpMemUse() final {
         // request maximum RAM limit, the value is calculated by StageBuilder,
         // and set as DIABase::mem_limit_.
-        return DIAMemUse::Max();
+        return DIAMemUse::Max(sizeof(TableItem));
     }
 
     void StartPreOp(size_t /* parent_index */) final {
         LOG << *this << " running StartPreOp";
-        if (!use_post_thread_) {
+        if (local_) {
+            post_phase_.Initialize(DIABase::mem_limit_);
+        }
+        else if (!use_post_thread_) {
             // use pre_phase without extra thread
-            pre_phase_.Initialize(DIABase::mem_limit_);
+            pre_phase_.Initialize(StartSharedTable(DIABase::mem_limit_));
         }
         else {
-            pre_phase_.Initialize(DIABase::mem_limit_ / 2);
+            pre_phase_.Initialize(StartSharedTable(DIABase::mem_limit_ / 2));
             post_phase_.Initialize(DIABase::mem_limit_ / 2);
 
             // start additional thread to receive from the channel
@@ -156,6 +237,22 @@ public:
 
     void StopPreOp(size_t /* parent_index */) final {
         LOG << *this << " running StopPreOp";
+        if (local_) {
+            // no items were sent, wait only for the close messages
+            for (PreWriter& w : emitters_) w.Close();
+            ProcessChannel();
+            use_mix_stream_ ? mix_stream_.reset() : cat_stream_.reset();
+            exchange_.reset();
+            reduced_ = true;
+            return;
+        }
+        if (use_shared_pre_phase_ && shared_table_) {
+            // wait for all workers of the host to finish inserting, then send
+            // our slice of the shared table.
+            context_.net.LocalBarrier();
+            shared_table_->FlushSlice(context_.local_worker_id(), emitters_);
+            shared_table_.reset();
+        }
         // Flush hash table before the postOp
         pre_phase_.FlushAll();
         pre_phase_.CloseAll();
@@ -164,13 +261,14 @@ public:
             thread_.join();
             // deallocate stream if already processed
             use_mix_stream_ ? mix_stream_.reset() : cat_stream_.reset();
+            exchange_.reset();
         }
     }
 
     void Execute() final { }
 
     DIAMemUse PushDataMemUse() final {
-        return DIAMemUse::Max();
+        return DIAMemUse::Max(sizeof(TableItem));
     }
 
     void PushData(bool consume) final {
@@ -182,6 +280,7 @@ public:
 
             // deallocate stream if already processed
             use_mix_stream_ ? mix_stream_.reset() : cat_stream_.reset();
+            exchange_.reset();
 
             reduced_ = true;
         }
@@ -190,23 +289,26 @@ public:
 
     //! process the inbound data in the post reduce phase
     void ProcessChannel() {
-        if (use_mix_stream_)
+        if (use_two_level_exchange_)
+        {
+            auto reader = exchange_->GetReader(/* consume */ true);
+            sLOG << "reading two level exchange data"
+                 << "to push into post phase which flushes to" << this->dia_id();
+            post_phase_.InsertAll(reader);
+        }
+        else if (use_mix_stream_)
         {
             auto reader = mix_stream_->GetMixReader(/* consume */ true);
             sLOG << "reading data from" << mix_stream_->id()
                  << "to push into post phase which flushes to" << this->dia_id();
-            while (reader.HasNext()) {
-                post_phase_.Insert(reader.template Next<TableItem>());
-            }
+            post_phase_.InsertAll(reader);
         }
         else
         {
             auto reader = cat_stream_->GetCatReader(/* consume */ true);
             sLOG << "reading data from" << cat_stream_->id()
                  << "to push into post phase which flushes to" << this->dia_id();
-            while (reader.HasNext()) {
-                post_phase_.Insert(reader.template Next<TableItem>());
-            }
+            post_phase_.InsertAll(reader);
         }
     }
 
@@ -214,28 +316,119 @@ public:
         post_phase_.Dispose();
     }
 
+    std::string ExplainImpl() const final {
+        if (local_)
+            return "input partitioned by key, local reduce without exchange";
+        std::string s = "pre-phase table ";
+        s += core::ReduceTableImplName(ReduceConfig::table_impl_);
+        if (ReduceConfig::use_adaptive_bypass_) s += " with adaptive bypass";
+        if (pre_phase_.batch_insert()) s += ", batch insert";
+        if (use_shared_pre_phase_) s += ", shared pre-phase";
+        if (use_hash_cache_) s += ", hash cache";
+        s += use_two_level_exchange_ ? ", two level exchange" :
+             use_mix_stream_ ? ", MixStream" : ", CatStream";
+        s += ReduceConfig::use_sort_post_phase_ ?
+             ", sort post-phase" : ", hash post-phase";
+        if (ReduceConfig::use_grace_post_phase_) s += " (grace)";
+        if (UseDuplicateDetection) s += ", duplicate detection";
+        return s;
+    }
+
 private:
+    /*!
+     * Create the table shared by the workers of this host, which receives
+     * shared_pre_phase_ratio() of each worker's pre-phase memory, and return
+     * the remaining memory of the pre-phase.
+     */
+    size_t StartSharedTable(size_t limit_memory_bytes) {
+        if (!use_shared_pre_phase_ || context_.workers_per_host() <= 1)
+            return limit_memory_bytes;
+
+        size_t shared_bytes = static_cast<size_t>(
+            static_cast<double>(limit_memory_bytes)
+            * config_.shared_pre_phase_ratio());
+
+        std::shared_ptr<SharedPreTable> table;
+        if (context_.local_worker_id() == 0) {
+            const auto& t = pre_phase_.table();
+            table = std::make_shared<SharedPreTable>(
+                context_.num_workers(), context_.workers_per_host(),
+                shared_bytes * context_.workers_per_host(),
+                config_.limit_partition_fill_rate(),
+                t.key_extractor(), t.reduce_function(),
+                t.index_function(), t.key_equal_function());
+        }
+        shared_table_ = context_.net.LocalBroadcast(table);
+
+        return limit_memory_bytes - shared_bytes;
+    }
+
+    //! index function of the pre-phase, which maps the keys to the workers
+    //! following their capacity weights, if they are set.
+    static HashIndexFunction PreIndexFunction(
+        Context& ctx, const TableKeyHashFunction& hash_function) {
+        HashIndexFunction index_function(hash_function);
+        if (ctx.has_worker_weights()) {
+            std::vector<double> prefix(ctx.num_workers() + 1);
+            for (size_t w = 0; w <= ctx.num_workers(); ++w)
+                prefix[w] = ctx.worker_weight_prefix(w);
+            index_function.set_partition_weights(prefix);
+        }
+        return index_function;
+    }
+
+    //! create Writers of the two level exchange
+    PreWriters GetEmitters(std::true_type) {
+        return exchange_->GetWriters();
+    }
+
+    //! create Writers of either stream
+    PreWriters GetEmitters(std::false_type) {
+        return use_mix_stream_ ?
+               mix_stream_->GetWriters() : cat_stream_->GetWriters();
+    }
+
+    //! stored reduce config for the shared table
+    ReduceConfig config_;
+
     // pointers for both Mix and CatStream. only one is used, the other costs
     // only a null pointer.
     data::MixStreamPtr mix_stream_;
     data::CatStreamPtr cat_stream_;
+    //! two level exchange, replaces both streams if enabled
+    std::unique_ptr<TwoLevelExchange> exchange_;
 
-    data::Stream::Writers emitters_;
+    PreWriters emitters_;
     //! handle to additional thread for post phase
     std::thread thread_;
 
     core::ReducePrePhase<
-        TableItem, Key, ValueType, KeyExtractor,
-        ReduceFunction, VolatileKey, data::Stream::Writer, ReduceConfig,
-        HashIndexFunction, KeyEqualFunction, KeyHashFunction,
+        TableItem, Key, ValueType, TableKeyExtractor,
+        ReduceFunction, TableVolatileKey, PreWriter, ReduceConfig,
+        HashIndexFunction, TableKeyEqualFunction, TableKeyHashFunction,
         UseDuplicateDetection> pre_phase_;
 
-    core::ReduceByHashPostPhase<
-        TableItem, Key, ValueType, KeyExtractor, ReduceFunction, Emitter,
-        VolatileKey, ReduceConfig,
-        HashIndexFunction, KeyEqualFunction> post_phase_;
+    //! post-phase aggregating by hashing or, if selected, by sorting
+    using PostPhase = typename std::conditional<
+        ReduceConfig::use_sort_post_phase_,
+        core::ReduceBySortPostPhase<
+            TableItem, Key, ValueType, TableKeyExtractor, ReduceFunction,
+            Emitter, TableVolatileKey, ReduceConfig,
+            HashIndexFunction, TableKeyEqualFunction>,
+        core::ReduceByHashPostPhase<
+            TableItem, Key, ValueType, TableKeyExtractor, ReduceFunction,
+            Emitter, TableVolatileKey, ReduceConfig,
+            HashIndexFunction, TableKeyEqualFunction> >::type;
+
+    PostPhase post_phase_;
+
+    //! table shared by the workers of this host, if use_shared_pre_phase_
+    std::shared_ptr<SharedPreTable> shared_table_;
 
     bool reduced_ = false;
+
+    //! input is partitioned by the key, reduce only locally in the post-phase
+    bool local_ = false;
 };
 
 template <typename ValueType, typename Stack>
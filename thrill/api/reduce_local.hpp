@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * thrill/api/reduce_local.hpp
+ *
+ * DIANode which reduces the items of each worker to one item, without any
+ * exchange.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_REDUCE_LOCAL_HEADER
+#define THRILL_API_REDUCE_LOCAL_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/functional.hpp>
+
+#include <type_traits>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DIANode which reduces all items of a worker in the PreOp, hence nothing
+ * is stored, and outputs one item on each worker which has items.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename ReduceFunction>
+class ReduceLocalNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+public:
+    template <typename ParentDIA>
+    ReduceLocalNode(const ParentDIA& parent,
+                    const ReduceFunction& reduce_function)
+        : Super(parent.ctx(), "ReduceLocal", { parent.id() }, { parent.node() }),
+          reduce_function_(reduce_function) {
+        auto pre_op_fn = [this](const ValueType& input) {
+                             PreOp(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void PreOp(const ValueType& input) {
+        if (TLX_UNLIKELY(!has_sum_)) {
+            has_sum_ = true;
+            sum_ = input;
+        }
+        else {
+            common::ReduceAssign(reduce_function_, sum_, input);
+        }
+    }
+
+    void Execute() final { }
+
+    void PushData(bool /* consume */) final {
+        if (has_sum_)
+            this->PushItem(sum_);
+    }
+
+    void Dispose() final { }
+
+private:
+    //! The reduce function which is applied to two values.
+    ReduceFunction reduce_function_;
+    //! Local sum
+    ValueType sum_ = ValueType();
+    //! whether the worker had any items
+    bool has_sum_ = false;
+};
+
+template <typename ValueType, typename Stack>
+template <typename ReduceFunction>
+auto DIA<ValueType, Stack>::ReduceLocal(
+    const ReduceFunction& reduce_function) const {
+    assert(IsValid());
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<ReduceFunction>::template arg<0> >::value,
+        "ReduceFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<ReduceFunction>::template arg<1> >::value,
+        "ReduceFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<ReduceFunction>::result_type,
+            ValueType>::value,
+        "ReduceFunction has the wrong output type");
+
+    using ReduceLocalNode = api::ReduceLocalNode<ValueType, ReduceFunction>;
+    return DIA<ValueType>(
+        tlx::make_counting<ReduceLocalNode>(*this, reduce_function));
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_REDUCE_LOCAL_HEADER
+
+/******************************************************************************/
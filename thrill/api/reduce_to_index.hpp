@@ -23,9 +23,12 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/core/reduce_by_index_post_phase.hpp>
+#include <thrill/core/reduce_dense_pre_phase.hpp>
 #include <thrill/core/reduce_pre_phase.hpp>
 
 #include <functional>
+#include <memory>
+#include <string>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -76,6 +79,14 @@ class ReduceToIndexNode final : public DOpNode<ValueType>
     static constexpr bool use_mix_stream_ = ReduceConfig::use_mix_stream_;
     static constexpr bool use_post_thread_ = ReduceConfig::use_post_thread_;
 
+    using PrePhase = core::ReducePrePhase<
+        TableItem, Key, ValueType, KeyExtractor, ReduceFunction, VolatileKey,
+        data::Stream::Writer, ReduceConfig, core::ReduceByIndex<Key> >;
+
+    using DensePrePhase = core::ReduceDensePrePhase<
+        TableItem, Key, ValueType, KeyExtractor, ReduceFunction, VolatileKey,
+        data::Stream::Writer>;
+
 private:
     //! Emitter for PostPhase to push elements to next DIA object.
     class Emitter
@@ -109,11 +120,11 @@ public:
                       nullptr : parent.ctx().GetNewCatStream(this)),
           emitters_(use_mix_stream_ ?
                     mix_stream_->GetWriters() : cat_stream_->GetWriters()),
+          key_extractor_(key_extractor),
+          reduce_function_(reduce_function),
+          config_(config),
           result_size_(result_size),
-          pre_phase_(
-              context_, Super::dia_id(), context_.num_workers(),
-              key_extractor, reduce_function, emitters_,
-              config, core::ReduceByIndex<Key>(0, result_size)),
+          dense_bytes_(DensePrePhase::MemoryUse(result_size)),
           post_phase_(
               context_, Super::dia_id(),
               key_extractor, reduce_function, Emitter(this),
@@ -123,9 +134,11 @@ public:
         // worker given by the shuffle algorithm.
         auto pre_op_fn = [this](const ValueType& input) {
                              if (SkipPreReducePhase)
-                                 pre_phase_.InsertSkip(input);
+                                 pre_phase_->InsertSkip(input);
+                             else if (use_dense_pre_phase_)
+                                 dense_pre_phase_->Insert(input);
                              else
-                                 pre_phase_.Insert(input);
+                                 pre_phase_->Insert(input);
                          };
 
         // close the function stack with our pre op and register it at parent
@@ -137,30 +150,60 @@ public:
     DIAMemUse PreOpMemUse() final {
         // request maximum RAM limit, the value is calculated by StageBuilder,
         // and set as DIABase::mem_limit_.
-        return DIAMemUse::Max();
+        return DIAMemUse::Max(sizeof(TableItem));
     }
 
     void StartPreOp(size_t /* parent_index */) final {
+        // the dense array is charged to the pre-phase's share of the memory
+        // limit. Both pre-phases partition the index range equally, hence
+        // workers may choose differently.
+        size_t pre_mem_limit =
+            use_post_thread_ ? DIABase::mem_limit_ / 2 : DIABase::mem_limit_;
+        use_dense_pre_phase_ =
+            !SkipPreReducePhase &&
+            dense_bytes_ <= config_.dense_pre_phase_max_bytes() &&
+            dense_bytes_ <= pre_mem_limit;
+
+        if (use_dense_pre_phase_) {
+            dense_pre_phase_ = std::make_unique<DensePrePhase>(
+                context_.num_workers(), key_extractor_, reduce_function_,
+                emitters_, result_size_);
+            dense_pre_phase_->Initialize();
+            post_phase_.SetRange(
+                dense_pre_phase_->key_range(context_.my_rank()));
+
+            if (use_post_thread_) {
+                post_phase_.Initialize(DIABase::mem_limit_ - dense_bytes_);
+                thread_ = common::CreateThread([this] { ProcessChannel(); });
+            }
+            return;
+        }
+
+        pre_phase_ = std::make_unique<PrePhase>(
+            context_, Super::dia_id(), context_.num_workers(),
+            key_extractor_, reduce_function_, emitters_,
+            config_, core::ReduceByIndex<Key>(0, result_size_));
+
         if (!use_post_thread_) {
             // use pre_phase without extra thread
             if (!SkipPreReducePhase)
-                pre_phase_.Initialize(DIABase::mem_limit_);
+                pre_phase_->Initialize(DIABase::mem_limit_);
             else
-                pre_phase_.InitializeSkip();
+                pre_phase_->InitializeSkip();
 
             // re-parameterize with resulting key range on this worker - this is
             // only known after Initialize() of the pre_phase_.
-            post_phase_.SetRange(pre_phase_.key_range(context_.my_rank()));
+            post_phase_.SetRange(pre_phase_->key_range(context_.my_rank()));
         }
         else {
             if (!SkipPreReducePhase)
-                pre_phase_.Initialize(DIABase::mem_limit_ / 2);
+                pre_phase_->Initialize(DIABase::mem_limit_ / 2);
             else
-                pre_phase_.InitializeSkip();
+                pre_phase_->InitializeSkip();
 
             // re-parameterize with resulting key range on this worker - this is
             // only know after Initialize() of the pre_phase_.
-            post_phase_.SetRange(pre_phase_.key_range(context_.my_rank()));
+            post_phase_.SetRange(pre_phase_->key_range(context_.my_rank()));
             post_phase_.Initialize(DIABase::mem_limit_ / 2);
 
             // start additional thread to receive from the channel
@@ -171,9 +214,17 @@ public:
     void StopPreOp(size_t /* parent_index */) final {
         LOG << *this << " running StopPreOp";
         // Flush hash table before the postOp
-        if (!SkipPreReducePhase)
-            pre_phase_.FlushAll();
-        pre_phase_.CloseAll();
+        if (use_dense_pre_phase_) {
+            dense_pre_phase_->FlushAll();
+            dense_pre_phase_->CloseAll();
+            dense_pre_phase_.reset();
+        }
+        else {
+            if (!SkipPreReducePhase)
+                pre_phase_->FlushAll();
+            pre_phase_->CloseAll();
+            pre_phase_.reset();
+        }
         if (use_post_thread_) {
             // waiting for the additional thread to finish the reduce
             thread_.join();
@@ -185,7 +236,7 @@ public:
     void Execute() final { }
 
     DIAMemUse PushDataMemUse() final {
-        return DIAMemUse::Max();
+        return DIAMemUse::Max(sizeof(TableItem));
     }
 
     void PushData(bool consume) final {
@@ -229,6 +280,22 @@ public:
         post_phase_.Dispose();
     }
 
+    std::string ExplainImpl() const final {
+        std::string s = "pre-phase ";
+        if (SkipPreReducePhase)
+            s += "skipped";
+        else {
+            if (dense_bytes_ <= config_.dense_pre_phase_max_bytes())
+                s += "dense array of " + std::to_string(dense_bytes_) +
+                     " bytes if in memory limit, else ";
+            s += std::string("table ") +
+                 core::ReduceTableImplName(ReduceConfig::table_impl_);
+        }
+        s += use_mix_stream_ ? ", MixStream" : ", CatStream";
+        s += ", index post-phase of " + std::to_string(result_size_) + " items";
+        return s;
+    }
+
 private:
     // pointers for both Mix and CatStream. only one is used, the other costs
     // only a null pointer.
@@ -237,15 +304,27 @@ private:
 
     data::Stream::Writers emitters_;
 
+    //! user-defined functions and config, for the pre-phase constructed in
+    //! StartPreOp()
+    KeyExtractor key_extractor_;
+    ReduceFunction reduce_function_;
+    ReduceConfig config_;
+
     size_t result_size_;
 
+    //! bytes of the dense pre-phase's array of result_size_ items
+    size_t dense_bytes_;
+
+    //! whether the pre-phase reduces into a dense array instead of a table,
+    //! decided in StartPreOp() by the memory limit.
+    bool use_dense_pre_phase_ = false;
+
     //! handle to additional thread for post phase
     std::thread thread_;
 
-    core::ReducePrePhase<
-        TableItem, Key, ValueType, KeyExtractor, ReduceFunction, VolatileKey,
-        data::Stream::Writer, ReduceConfig, core::ReduceByIndex<Key>
-        > pre_phase_;
+    //! the pre-phase in use, only one of both is constructed
+    std::unique_ptr<PrePhase> pre_phase_;
+    std::unique_ptr<DensePrePhase> dense_pre_phase_;
 
     core::ReduceByIndexPostPhase<
         TableItem, Key, ValueType, KeyExtractor, ReduceFunction, Emitter,
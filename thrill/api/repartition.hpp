@@ -0,0 +1,148 @@
+/*******************************************************************************
+ * thrill/api/repartition.hpp
+ *
+ * DIANode which sends each item to the worker selected by a user partitioner.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_REPARTITION_HEADER
+#define THRILL_API_REPARTITION_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/data/cat_stream.hpp>
+
+#include <functional>
+#include <type_traits>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DIANode which sends each item to the worker returned by the partitioner.
+ * Items are written to the CatStream's writers in the PreOp, hence the input is
+ * not stored locally first. The received items are kept in the CatStream, and
+ * the order of items from one worker is preserved.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename Partitioner>
+class RepartitionNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+public:
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    template <typename ParentDIA>
+    RepartitionNode(const ParentDIA& parent,
+                    const Partitioner& partitioner,
+                    const DIAPartitioning& partitioning)
+        : Super(parent.ctx(), "Repartition", { parent.id() }, { parent.node() }),
+          partitioner_(partitioner) {
+        this->set_partitioning(partitioning);
+
+        auto pre_op_fn = [this](const ValueType& input) {
+                             PreOp(input);
+                         };
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void StartPreOp(size_t /* parent_index */) final {
+        emitters_ = stream_->GetWriters();
+    }
+
+    void PreOp(const ValueType& input) {
+        const size_t worker = partitioner_(input);
+        if (worker >= emitters_.size())
+            die("Repartition: partitioner returned worker " << worker
+                << " of " << emitters_.size());
+        emitters_[worker].Put(input);
+    }
+
+    void StopPreOp(size_t /* parent_index */) final {
+        emitters_.Close();
+    }
+
+    void Execute() final { }
+
+    void PushData(bool consume) final {
+        auto reader = stream_->GetCatReader(consume);
+        while (reader.HasNext()) {
+            this->PushItem(reader.template Next<ValueType>());
+        }
+    }
+
+    void Dispose() final {
+        stream_.reset();
+    }
+
+private:
+    Partitioner partitioner_;
+
+    //! CatStream for exchange
+    data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
+    data::CatStream::Writers emitters_;
+};
+
+template <typename ValueType, typename Stack>
+template <typename Partitioner>
+auto DIA<ValueType, Stack>::Repartition(const Partitioner& partitioner) const {
+    assert(IsValid());
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<Partitioner>::template arg<0> >::value,
+        "Partitioner has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<Partitioner>::result_type, size_t>::value,
+        "Partitioner has the wrong output type (should be size_t)");
+
+    using RepartitionNode = api::RepartitionNode<ValueType, Partitioner>;
+    return DIA<ValueType>(
+        tlx::make_counting<RepartitionNode>(
+            *this, partitioner, DIAPartitioning()));
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename HashFunction>
+auto DIA<ValueType, Stack>::RepartitionByKey(
+    const KeyExtractor& key_extractor,
+    const HashFunction& hash_function) const {
+    assert(IsValid());
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0> >::value,
+        "KeyExtractor has the wrong input type");
+
+    const size_t num_workers = context().num_workers();
+    auto partitioner =
+        [key_extractor, hash_function, num_workers](const ValueType& v) {
+            return hash_function(key_extractor(v)) % num_workers;
+        };
+
+    using RepartitionNode =
+        api::RepartitionNode<ValueType, decltype(partitioner)>;
+    return DIA<ValueType>(
+        tlx::make_counting<RepartitionNode>(
+            *this, partitioner, DIAPartitioning::Hash<KeyExtractor>()));
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_REPARTITION_HEADER
+
+/******************************************************************************/
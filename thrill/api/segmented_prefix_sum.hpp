@@ -0,0 +1,240 @@
+/*******************************************************************************
+ * thrill/api/segmented_prefix_sum.hpp
+ *
+ * DOp computing prefix sums which restart at every change of the key between
+ * consecutive items.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_SEGMENTED_PREFIX_SUM_HEADER
+#define THRILL_API_SEGMENTED_PREFIX_SUM_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/api/prefix_sum.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/data/file.hpp>
+
+#include <tuple>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename KeyExtractor, typename SumFunction,
+          bool Inclusive>
+class SegmentedPrefixSumNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
+
+    /*!
+     * Summary of a range of items for the ExPrefixSum collective: whether it
+     * is non-empty, whether it consists of a single segment, the first and
+     * last key, and the sum of the items of the last segment (without the
+     * initial element).
+     */
+    using Segment = std::tuple<bool, bool, Key, Key, ValueType>;
+
+public:
+    template <typename ParentDIA>
+    SegmentedPrefixSumNode(const ParentDIA& parent,
+                           const char* label,
+                           const KeyExtractor& key_extractor,
+                           const SumFunction& sum_function,
+                           const ValueType& initial_element)
+        : Super(parent.ctx(), label, { parent.id() }, { parent.node() }),
+          key_extractor_(key_extractor),
+          sum_function_(sum_function),
+          initial_element_(initial_element),
+          parent_stack_empty_(ParentDIA::stack_empty) {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             PreOp(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    //! PreOp: summarize the local segments and store items.
+    void PreOp(const ValueType& input) {
+        Summarize(input);
+        writer_.Put(input);
+    }
+
+    bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
+        if (!parent_stack_empty_) {
+            LOGC(common::g_debug_push_file)
+                << "SegmentedPrefixSum rejected File from parent "
+                << "due to non-empty function stack.";
+            return false;
+        }
+        // copy complete Block references to writer_
+        file_ = file.Copy();
+        auto reader = file_.GetKeepReader();
+        ScanItems<ValueType>(
+            reader, [this](const ValueType& item) { Summarize(item); });
+        return true;
+    }
+
+    void StopPreOp(size_t /* parent_index */) final {
+        writer_.Close();
+    }
+
+    //! Executes the segmented prefix sum over the workers' summaries.
+    void Execute() final {
+        LOG << "MainOp processing";
+
+        carry_ = context_.net.ExPrefixSum(
+            local_,
+            [this](const Segment& a, const Segment& b) {
+                return Combine(a, b);
+            },
+            Segment());
+    }
+
+    void PushData(bool consume) final {
+        data::File::Reader reader = file_.GetReader(consume);
+
+        // the preceding workers' last segment continues here if the keys match
+        bool has_prev = std::get<0>(carry_);
+        Key prev = std::get<3>(carry_);
+        ValueType sum = has_prev
+                        ? sum_function_(initial_element_, std::get<4>(carry_))
+                        : initial_element_;
+
+        ScanItems<ValueType>(
+            reader, [&](const ValueType& item) {
+                Key key = key_extractor_(item);
+                if (!has_prev || !(key == prev)) {
+                    sum = initial_element_;
+                    prev = key, has_prev = true;
+                }
+                if (Inclusive) {
+                    sum = sum_function_(sum, item);
+                    this->PushItem(sum);
+                }
+                else {
+                    this->PushItem(sum);
+                    sum = sum_function_(sum, item);
+                }
+            });
+    }
+
+    void Dispose() final {
+        file_.Clear();
+    }
+
+private:
+    //! Extracts the key of items which determines the segments
+    KeyExtractor key_extractor_;
+    //! The sum function which is applied to two elements.
+    SumFunction sum_function_;
+    //! Initial element of each segment.
+    const ValueType initial_element_;
+    //! Whether the parent stack is empty
+    const bool parent_stack_empty_;
+
+    //! Summary of the local items
+    Segment local_;
+    //! Summary of all items on preceding workers
+    Segment carry_;
+
+    //! Local data file
+    data::File file_ { context_.GetFile(this) };
+    //! Data writer to local file (only active in PreOp).
+    data::File::Writer writer_ { file_.GetWriter() };
+
+    //! Appends an item to the local summary
+    void Summarize(const ValueType& item) {
+        Key key = key_extractor_(item);
+        if (!std::get<0>(local_)) {
+            local_ = Segment(true, true, key, key, item);
+        }
+        else if (std::get<3>(local_) == key) {
+            std::get<4>(local_) = sum_function_(std::get<4>(local_), item);
+        }
+        else {
+            std::get<1>(local_) = false;
+            std::get<3>(local_) = key;
+            std::get<4>(local_) = item;
+        }
+    }
+
+    //! Associative combination of the summaries of two consecutive ranges
+    Segment Combine(const Segment& a, const Segment& b) const {
+        if (!std::get<0>(a)) return b;
+        if (!std::get<0>(b)) return a;
+
+        bool joined = std::get<3>(a) == std::get<2>(b);
+        return Segment(
+            true, std::get<1>(a) && std::get<1>(b) && joined,
+            std::get<2>(a), std::get<3>(b),
+            std::get<1>(b) && joined
+            ? sum_function_(std::get<4>(a), std::get<4>(b)) : std::get<4>(b));
+    }
+};
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename SumFunction>
+auto DIA<ValueType, Stack>::SegmentedPrefixSum(
+    const KeyExtractor& key_extractor,
+    const SumFunction& sum_function, const ValueType& initial_element) const {
+    assert(IsValid());
+
+    using SegmentedPrefixSumNode = api::SegmentedPrefixSumNode<
+        ValueType, KeyExtractor, SumFunction, /* Inclusive */ true>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0> >::value,
+        "KeyExtractor has the wrong input type");
+
+    auto node = tlx::make_counting<SegmentedPrefixSumNode>(
+        *this, "SegmentedPrefixSum", key_extractor, sum_function,
+        initial_element);
+
+    return DIA<ValueType>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename SumFunction>
+auto DIA<ValueType, Stack>::SegmentedExPrefixSum(
+    const KeyExtractor& key_extractor,
+    const SumFunction& sum_function, const ValueType& initial_element) const {
+    assert(IsValid());
+
+    using SegmentedPrefixSumNode = api::SegmentedPrefixSumNode<
+        ValueType, KeyExtractor, SumFunction, /* Inclusive */ false>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0> >::value,
+        "KeyExtractor has the wrong input type");
+
+    auto node = tlx::make_counting<SegmentedPrefixSumNode>(
+        *this, "SegmentedExPrefixSum", key_extractor, sum_function,
+        initial_element);
+
+    return DIA<ValueType>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_SEGMENTED_PREFIX_SUM_HEADER
+
+/******************************************************************************/
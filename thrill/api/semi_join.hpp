@@ -0,0 +1,313 @@
+/*******************************************************************************
+ * thrill/api/semi_join.hpp
+ *
+ * DIANode for semi-joins and anti-joins, which filter a DIA by whether the key
+ * of an item occurs in another DIA.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_SEMI_JOIN_HEADER
+#define THRILL_API_SEMI_JOIN_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/function_traits.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/core/semi_join_filter.hpp>
+#include <thrill/data/cat_stream.hpp>
+#include <thrill/data/file.hpp>
+
+#include <functional>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+//! Configuration of SemiJoin() and AntiJoin()
+class DefaultSemiJoinConfig
+{
+public:
+    //! exchange a core::SemiJoinFilter of the filter input's key hashes, such
+    //! that keys which certainly do not occur in it are not looked up. Each
+    //! worker receives a few bits per key of the filter input.
+    bool use_filter_ = true;
+};
+
+/*!
+ * A DIANode which outputs the items of the first DIA whose key occurs (Anti =
+ * false) or does not occur (Anti = true) among the keys of the second DIA.
+ * Items of the first DIA are never sent: they are stored locally, and only
+ * keys are exchanged.
+ *
+ * Each key of the second DIA is sent to the worker selected by its hash. Then
+ * each worker looks up the distinct keys of its first DIA items at these
+ * workers, which reply whether the key occurs. With
+ * SemiJoinConfig::use_filter_, a Golomb coded bloom filter of the second DIA's
+ * keys is exchanged first, and only keys which may occur are looked up. The
+ * looked up keys of a worker and the found ones are held in RAM.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename FirstDIA, typename SecondDIA,
+          typename KeyExtractor1, typename KeyExtractor2,
+          typename HashFunction, bool Anti, typename SemiJoinConfig>
+class SemiJoinNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using InputTypeSecond = typename SecondDIA::ValueType;
+
+    //! Key type of join. must be equal to the other key extractor
+    using Key = typename common::FunctionTraits<KeyExtractor1>::result_type;
+
+    using KeySet = std::unordered_set<Key, HashFunction>;
+
+public:
+    SemiJoinNode(const FirstDIA& parent1, const SecondDIA& parent2,
+                 const KeyExtractor1& key_extractor1,
+                 const KeyExtractor2& key_extractor2,
+                 const HashFunction& hash_function,
+                 const SemiJoinConfig& config)
+        : Super(parent1.ctx(), Anti ? "AntiJoin" : "SemiJoin",
+                { parent1.id(), parent2.id() },
+                { parent1.node(), parent2.node() }),
+          key_extractor1_(key_extractor1),
+          key_extractor2_(key_extractor2),
+          hash_function_(hash_function),
+          config_(config),
+          found_(16, hash_function) {
+        auto pre_op_fn1 = [this](const ValueType& input) {
+                              writer1_.Put(input);
+                          };
+
+        auto pre_op_fn2 = [this](const InputTypeSecond& input) {
+                              PreOp2(input);
+                          };
+
+        auto lop_chain1 = parent1.stack().push(pre_op_fn1).fold();
+        auto lop_chain2 = parent2.stack().push(pre_op_fn2).fold();
+        parent1.node()->AddChild(this, lop_chain1, 0);
+        parent2.node()->AddChild(this, lop_chain2, 1);
+    }
+
+    void StartPreOp(size_t parent_index) final {
+        if (parent_index == 0)
+            writer1_ = file1_.GetWriter();
+        else
+            key_writers_ = key_stream_->GetWriters();
+    }
+
+    //! send the key of the second input to the worker of its hash
+    void PreOp2(const InputTypeSecond& input) {
+        const Key key = key_extractor2_(input);
+        const size_t hash = hash_function_(key);
+        if (config_.use_filter_)
+            filter_.Insert(hash);
+        key_writers_[hash % key_writers_.size()].Put(key);
+    }
+
+    void StopPreOp(size_t parent_index) final {
+        if (parent_index == 0)
+            writer1_.Close();
+        else
+            key_writers_.Close();
+    }
+
+    void Execute() final {
+        const size_t p = context_.num_workers();
+
+        if (config_.use_filter_)
+            filter_.Flush();
+
+        // collect the keys of the second input of our hash range
+        KeySet keys(16, hash_function_);
+        {
+            auto reader = key_stream_->GetCatReader(/* consume */ true);
+            while (reader.HasNext())
+                keys.insert(reader.template Next<Key>());
+        }
+        key_stream_.reset();
+
+        // send each distinct candidate key of the first input to its worker,
+        // remembering the order of the queries per worker.
+        std::vector<std::vector<Key> > queries(p);
+        size_t num_queries = 0;
+        data::CatStreamPtr query_stream = context_.GetNewCatStream(this);
+        {
+            KeySet queried(16, hash_function_);
+            data::CatStream::Writers writers = query_stream->GetWriters();
+            auto reader = file1_.GetKeepReader();
+            while (reader.HasNext()) {
+                const Key key =
+                    key_extractor1_(reader.template Next<ValueType>());
+                const size_t hash = hash_function_(key);
+                if (config_.use_filter_ && !filter_.Contains(hash))
+                    continue;
+                if (!queried.insert(key).second)
+                    continue;
+                writers[hash % p].Put(key);
+                queries[hash % p].push_back(key);
+                ++num_queries;
+            }
+        }
+
+        // answer the queries of each worker in order
+        data::CatStreamPtr reply_stream = context_.GetNewCatStream(this);
+        {
+            data::CatStream::Writers writers = reply_stream->GetWriters();
+            std::vector<data::CatStream::Reader> readers =
+                query_stream->GetReaders();
+            for (size_t w = 0; w < p; ++w) {
+                while (readers[w].HasNext()) {
+                    const Key key = readers[w].template Next<Key>();
+                    writers[w].Put(keys.count(key) != 0);
+                }
+            }
+        }
+        query_stream.reset();
+        KeySet().swap(keys);
+
+        // collect the keys found in the second input
+        {
+            std::vector<data::CatStream::Reader> readers =
+                reply_stream->GetReaders();
+            for (size_t w = 0; w < p; ++w) {
+                for (const Key& key : queries[w]) {
+                    if (readers[w].template Next<bool>())
+                        found_.insert(key);
+                }
+                std::vector<Key>().swap(queries[w]);
+            }
+        }
+        reply_stream.reset();
+
+        sLOG << (Anti ? "AntiJoin" : "SemiJoin") << "queried" << num_queries
+             << "keys, found" << found_.size();
+    }
+
+    void PushData(bool consume) final {
+        auto reader = file1_.GetReader(consume);
+        while (reader.HasNext()) {
+            ValueType item = reader.template Next<ValueType>();
+            if ((found_.count(key_extractor1_(item)) != 0) != Anti)
+                this->PushItem(item);
+        }
+    }
+
+    void Dispose() final {
+        file1_.Clear();
+        filter_.Dispose();
+        KeySet().swap(found_);
+    }
+
+    std::string ExplainImpl() const final {
+        return config_.use_filter_ ?
+               "key lookups, semi-join filter" : "key lookups";
+    }
+
+private:
+    KeyExtractor1 key_extractor1_;
+    KeyExtractor2 key_extractor2_;
+    HashFunction hash_function_;
+    SemiJoinConfig config_;
+
+    //! local items of the first input
+    data::File file1_ { context_.GetFile(this) };
+    data::File::Writer writer1_;
+
+    //! keys of the second input, sent to the worker of their hash
+    data::CatStreamPtr key_stream_ { context_.GetNewCatStream(this) };
+    data::CatStream::Writers key_writers_;
+
+    //! bloom filter of the second input's keys
+    core::SemiJoinFilter filter_ { context_, Super::dia_id() };
+
+    //! keys of local items of the first input which occur in the second
+    KeySet found_;
+};
+
+//! common implementation of SemiJoin() and AntiJoin()
+template <bool Anti, typename FirstDIA, typename SecondDIA,
+          typename KeyExtractor1, typename KeyExtractor2,
+          typename HashFunction, typename SemiJoinConfig>
+auto SemiJoinImpl(
+    const FirstDIA& first_dia, const SecondDIA& second_dia,
+    const KeyExtractor1& key_extractor1, const KeyExtractor2& key_extractor2,
+    const HashFunction& hash_function, const SemiJoinConfig& config) {
+
+    assert(first_dia.IsValid());
+    assert(second_dia.IsValid());
+
+    static_assert(
+        std::is_convertible<
+            typename FirstDIA::ValueType,
+            typename common::FunctionTraits<KeyExtractor1>::template arg<0>
+            >::value,
+        "Key Extractor 1 has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename SecondDIA::ValueType,
+            typename common::FunctionTraits<KeyExtractor2>::template arg<0>
+            >::value,
+        "Key Extractor 2 has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename common::FunctionTraits<KeyExtractor2>::result_type,
+            typename common::FunctionTraits<KeyExtractor1>::result_type
+            >::value,
+        "Keys have different types");
+
+    using ValueType = typename FirstDIA::ValueType;
+
+    using SemiJoinNode = api::SemiJoinNode<
+        ValueType, FirstDIA, SecondDIA, KeyExtractor1, KeyExtractor2,
+        HashFunction, Anti, SemiJoinConfig>;
+
+    auto node = tlx::make_counting<SemiJoinNode>(
+        first_dia, second_dia, key_extractor1, key_extractor2,
+        hash_function, config);
+
+    return DIA<ValueType>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename SecondDIA, typename KeyExtractor1, typename KeyExtractor2,
+          typename HashFunction, typename SemiJoinConfig>
+auto DIA<ValueType, Stack>::SemiJoin(
+    const SecondDIA& second_dia,
+    const KeyExtractor1& key_extractor1, const KeyExtractor2& key_extractor2,
+    const HashFunction& hash_function, const SemiJoinConfig& config) const {
+    return SemiJoinImpl</* Anti */ false>(
+        *this, second_dia, key_extractor1, key_extractor2,
+        hash_function, config);
+}
+
+template <typename ValueType, typename Stack>
+template <typename SecondDIA, typename KeyExtractor1, typename KeyExtractor2,
+          typename HashFunction, typename SemiJoinConfig>
+auto DIA<ValueType, Stack>::AntiJoin(
+    const SecondDIA& second_dia,
+    const KeyExtractor1& key_extractor1, const KeyExtractor2& key_extractor2,
+    const HashFunction& hash_function, const SemiJoinConfig& config) const {
+    return SemiJoinImpl</* Anti */ true>(
+        *this, second_dia, key_extractor1, key_extractor2,
+        hash_function, config);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_SEMI_JOIN_HEADER
+
+/******************************************************************************/
@@ -18,6 +18,8 @@
 #include <thrill/api/dia.hpp>
 #include <thrill/net/group.hpp>
 
+#include <string>
+
 namespace thrill {
 namespace api {
 
@@ -74,6 +76,23 @@ public:
         return global_size_;
     }
 
+    bool CanBatchExecute() const final { return true; }
+
+    std::string BatchLocalValue() const final {
+        return Super::BatchSerialize(local_size_);
+    }
+
+    std::string BatchCombine(
+        const std::string& a, const std::string& b) const final {
+        return Super::BatchSerialize(
+            Super::template BatchDeserialize<size_t>(a)
+            + Super::template BatchDeserialize<size_t>(b));
+    }
+
+    void BatchSetResult(const std::string& value) final {
+        global_size_ = Super::template BatchDeserialize<size_t>(value);
+    }
+
 private:
     //! Whether the parent stack is empty
     const bool parent_stack_empty_;
@@ -17,12 +17,22 @@
 #include <thrill/api/context.hpp>
 #include <thrill/api/dia.hpp>
 #include <thrill/api/dop_node.hpp>
+#include <thrill/common/deferred_work.hpp>
+#include <thrill/common/interpolation_classifier.hpp>
+#include <thrill/common/item_memory_size.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/math.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/common/qsort.hpp>
 #include <thrill/common/reservoir_sampling.hpp>
+#include <thrill/common/sample_sort.hpp>
+#include <thrill/common/string_sort.hpp>
+#include <thrill/core/front_coded_string_stream.hpp>
+#include <thrill/core/lcp_multiway_merge.hpp>
 #include <thrill/core/multiway_merge.hpp>
+#include <thrill/core/packed_integer_stream.hpp>
+#include <thrill/core/parallel_multiway_merge.hpp>
+#include <thrill/core/two_level_exchange.hpp>
 #include <thrill/data/file.hpp>
 #include <thrill/net/group.hpp>
 
@@ -30,11 +40,15 @@
 #include <tlx/vector_free.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <deque>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <numeric>
 #include <random>
+#include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -42,6 +56,120 @@
 namespace thrill {
 namespace api {
 
+class DefaultSortAlgorithm;
+class DefaultStableSortAlgorithm;
+
+/*!
+ * Configuration class for Sort() and SortStable(), which selects optional
+ * methods at compile time. Derive from it and override the static members to
+ * enable them.
+ */
+class DefaultSortConfig
+{
+public:
+    //! check the global bucket sizes of the first splitters and run a second
+    //! splitter selection round with a larger sample if they are imbalanced.
+    //! This requires an extra scan of the local items.
+    static constexpr bool refine_splitters_ = false;
+
+    //! desired imbalance of the output, which sizes the splitter sample.
+    static constexpr double desired_imbalance_ = 0.1;
+
+    //! with refine_splitters_: maximum imbalance of the largest bucket
+    //! (relative to the average) before another splitter round is run.
+    static constexpr double max_imbalance_ = 0.25;
+
+    //! with refine_splitters_: factor by which the sample is enlarged in the
+    //! refinement round.
+    static constexpr size_t refine_oversampling_ = 4;
+
+    //! maximum number of samples collected by the AllGather in splitter
+    //! selection. Larger local samples are thinned out to regularly spaced
+    //! representatives.
+    static constexpr size_t max_gathered_samples_ = 1024 * 1024;
+
+    //! merge the sorted runs in PushData() with the helper threads of
+    //! Context::task_pool(). The merged pieces are written to Files first,
+    //! since items must be pushed sequentially.
+    static constexpr bool use_parallel_merge_ = false;
+
+    //! form runs with replacement selection once the received items do not
+    //! fit into RAM, which halves the number of runs on random input. The
+    //! SortAlgorithm is not used for these runs. Only used for unstable
+    //! sorting.
+    static constexpr bool use_replacement_selection_ = false;
+
+    //! exchange the items in two levels: first between hosts, then among the
+    //! workers of a host (see core::TwoLevelExchange). Only used for unstable
+    //! sorting, since the order of items is lost.
+    static constexpr bool use_two_level_exchange_ = false;
+
+    //! transmit integers, or pairs with integer keys, in
+    //! core::PackedIntegerChunks. The keys of each bucket lie between two
+    //! splitters, hence they are bit-packed relative to their minimum in fewer
+    //! bits. Not used with the two level exchange.
+    static constexpr bool use_packed_integer_exchange_ = false;
+
+    //! write the sorted runs of std::string items compared with std::less
+    //! front coded (see core::FrontCodedStringWriter), and merge them with
+    //! core::LcpMultiwayMergeTree, which skips the common prefixes of the
+    //! strings in comparisons. Not used with the parallel merge.
+    static constexpr bool use_front_coded_runs_ = false;
+
+    //! check before the exchange whether the local input is sorted. If all
+    //! workers' inputs are sorted, ordered across workers and balanced, the
+    //! exchange and the local sort are skipped. If they are only sorted
+    //! locally, stable sorting splits the received items into their natural
+    //! runs, which are merged instead of sorting them. This costs a scan of
+    //! the input if its sample is sorted, and an AllGather of the workers'
+    //! first and last items.
+    static constexpr bool detect_presorted_ = false;
+};
+
+/*!
+ * Compare function for Sort() which orders items by the key of a key extractor.
+ * Sorting with LessByKey(key_extractor) marks the result as range partitioned
+ * by the key, such that a following GroupByKey() with the same key extractor
+ * groups locally without exchanging all items, see DIAPartitioning.
+ */
+template <typename KeyExtractor>
+class KeyLess
+{
+public:
+    using Value =
+        typename common::FunctionTraits<KeyExtractor>::template arg_plain<0>;
+
+    explicit KeyLess(const KeyExtractor& key_extractor)
+        : key_extractor_(key_extractor) { }
+
+    bool operator () (const Value& a, const Value& b) const {
+        return key_extractor_(a) < key_extractor_(b);
+    }
+
+private:
+    KeyExtractor key_extractor_;
+};
+
+//! make a KeyLess compare function for Sort()
+template <typename KeyExtractor>
+KeyLess<KeyExtractor> LessByKey(const KeyExtractor& key_extractor) {
+    return KeyLess<KeyExtractor>(key_extractor);
+}
+
+//! partitioning of the output of Sort(): by the key with KeyLess, otherwise
+//! only by the compare function.
+template <typename CompareFunction>
+struct SortPartitioning {
+    static DIAPartitioning Get() { return DIAPartitioning::RangeByCompare(); }
+};
+
+template <typename KeyExtractor>
+struct SortPartitioning<KeyLess<KeyExtractor> >{
+    static DIAPartitioning Get() {
+        return DIAPartitioning::Range<KeyExtractor>();
+    }
+};
+
 /*!
  * A DIANode which performs a Sort operation. Sort sorts a DIA according to a
  * given compare function
@@ -54,13 +182,16 @@ namespace api {
  *
  * \tparam Stable Whether or not to use stable sorting mechanisms
  *
+ * \tparam SortConfig Optional methods, see DefaultSortConfig
+ *
  * \ingroup api_layer
  */
 template <
     typename ValueType,
     typename CompareFunction,
     typename SortAlgorithm,
-    bool Stable = false>
+    bool Stable = false,
+    typename SortConfig = DefaultSortConfig>
 class SortNode final : public DOpNode<ValueType>
 {
     static constexpr bool debug = false;
@@ -115,6 +246,83 @@ class SortNode final : public DOpNode<ValueType>
 
     static const bool use_background_thread_ = false;
 
+    //! Use common::InterpolationClassifier instead of the splitter tree to
+    //! classify integer items compared with std::less, if the splitters are
+    //! spread evenly enough over the key range.
+    static constexpr bool use_interpolation_classifier_ =
+        std::is_integral<ValueType>::value &&
+        !std::is_same<ValueType, bool>::value &&
+        std::is_same<CompareFunction, std::less<ValueType> >::value;
+
+    //! Placeholder for InterpolationClassifier for other types.
+    struct NoInterpolationClassifier {
+        NoInterpolationClassifier() = default;
+        NoInterpolationClassifier(const ValueType*, size_t) { }
+        bool good() const { return false; }
+        void Classify(const ValueType*, size_t, size_t*) const { }
+    };
+
+    using InterpolationClassifier = typename std::conditional<
+        use_interpolation_classifier_,
+        common::InterpolationClassifier<ValueType>,
+        NoInterpolationClassifier>::type;
+
+    //! form runs with replacement selection if the items do not fit into RAM
+    static constexpr bool use_replacement_selection_ =
+        SortConfig::use_replacement_selection_;
+
+    //! skip the exchange or the local sort for sorted inputs
+    static constexpr bool detect_presorted_ = SortConfig::detect_presorted_;
+
+    //! merge the sorted runs with the helper threads of the TaskPool
+    static constexpr bool use_parallel_merge_ = SortConfig::use_parallel_merge_;
+
+    //! exchange the items first between hosts, then among their workers
+    static constexpr bool use_two_level_exchange_ =
+        SortConfig::use_two_level_exchange_;
+
+    //! transmit the integer keys of each bucket bit-packed
+    static constexpr bool use_packed_integer_exchange_ =
+        SortConfig::use_packed_integer_exchange_;
+
+    using UsePackedIntegers = std::integral_constant<
+        bool, use_packed_integer_exchange_ &&
+        core::PackedIntegerTraits<ValueType>::is_packable>;
+
+    //! write sorted runs of strings front coded and merge them LCP-aware
+    static constexpr bool use_front_coded_runs_ =
+        SortConfig::use_front_coded_runs_;
+
+    using UseFrontCodedRuns = std::integral_constant<
+        bool, use_front_coded_runs_ &&
+        std::is_same<ValueType, std::string>::value &&
+        std::is_same<CompareFunction, std::less<std::string> >::value>;
+
+    //! writer and readers of the sorted runs in files_
+    using RunWriter = typename std::conditional<
+        UseFrontCodedRuns::value,
+        core::FrontCodedStringWriter<data::File::Writer>,
+        data::File::Writer>::type;
+    using RunKeepReader = typename std::conditional<
+        UseFrontCodedRuns::value,
+        core::FrontCodedStringReader<data::File::KeepReader>,
+        data::File::KeepReader>::type;
+    using RunConsumeReader = typename std::conditional<
+        UseFrontCodedRuns::value,
+        core::FrontCodedStringReader<data::File::ConsumeReader>,
+        data::File::ConsumeReader>::type;
+
+    //! Specialize sorting std::string items compared with std::less: the
+    //! local samples are truncated to their distinguishing prefixes before the
+    //! AllGather, and the items of each bucket are transmitted without the
+    //! common prefix of the bucket's splitters. Not used with the two level
+    //! exchange.
+    static constexpr bool use_string_sort_ =
+        std::is_same<ValueType, std::string>::value &&
+        std::is_same<CompareFunction, std::less<std::string> >::value;
+
+    using UseStringSort = std::integral_constant<bool, use_string_sort_>;
+
 public:
     /*!
      * Constructor for a sort node.
@@ -127,6 +335,8 @@ public:
           compare_function_(compare_function),
           sort_algorithm_(sort_algorithm),
           parent_stack_empty_(ParentDIA::stack_empty) {
+        this->set_partitioning(SortPartitioning<CompareFunction>::Get());
+
         // Hook PreOp(s)
         auto pre_op_fn = [this](const ValueType& input) {
                              PreOp(input);
@@ -223,7 +433,7 @@ public:
         }
         else if (files_.size() == 1) {
             local_size = files_[0].num_items();
-            this->PushFile(files_[0], consume);
+            PushRun(files_[0], consume, UseFrontCodedRuns());
         }
         else {
             size_t merge_degree, prefetch;
@@ -236,27 +446,49 @@ public:
                 PartialMultiwayMerge(merge_degree, prefetch);
             }
 
-            sLOGC(context_.my_rank() == 0)
-                << "Start multi-way-merge of" << files_.size() << "files"
-                << "with prefetch" << prefetch;
-
-            // construct output merger of remaining Files
-            std::vector<data::File::Reader> seq;
-            seq.reserve(files_.size());
-
-            for (size_t t = 0; t < files_.size(); ++t) {
-                seq.emplace_back(
-                    files_[t].GetReader(consume, /* prefetch */ 0));
+            common::TaskPool& pool = context_.task_pool();
+            size_t num_threads = pool.max_parallelism();
+
+            if (use_parallel_merge_ && !UseFrontCodedRuns::value &&
+                num_threads > 1) {
+                sLOGC(context_.my_rank() == 0)
+                    << "Start parallel multi-way-merge of" << files_.size()
+                    << "files with" << num_threads << "threads";
+
+                std::vector<data::File> pieces =
+                    core::parallel_multiway_merge<ValueType, Stable>(
+                        files_, compare_function_, num_threads,
+                        [this]() { return context_.GetFile(this); },
+                        /* oversampling */ 16, &pool);
+
+                if (consume) files_.clear();
+
+                for (data::File& piece : pieces) {
+                    data::File::ConsumeReader reader = piece.GetConsumeReader();
+                    while (reader.HasNext()) {
+                        this->PushItem(reader.template Next<ValueType>());
+                        local_size++;
+                    }
+                }
             }
-
-            StartPrefetch(seq, prefetch);
-
-            auto puller = MakeMultiwayMergeTree()(
-                seq.begin(), seq.end(), compare_function_);
-
-            while (puller.HasNext()) {
-                this->PushItem(puller.Next());
-                local_size++;
+            else {
+                sLOGC(context_.my_rank() == 0)
+                    << "Start multi-way-merge of" << files_.size() << "files"
+                    << "with prefetch" << prefetch;
+
+                // merge remaining Files with readers of a static block source
+                if (consume) {
+                    local_size += MergeRuns<RunConsumeReader>(
+                        prefetch, [](data::File& file) {
+                            return file.GetConsumeReader(/* prefetch */ 0);
+                        });
+                }
+                else {
+                    local_size += MergeRuns<RunKeepReader>(
+                        prefetch, [](data::File& file) {
+                            return file.GetKeepReader(/* prefetch */ 0);
+                        });
+                }
             }
         }
 
@@ -274,6 +506,21 @@ public:
         files_.clear();
     }
 
+    std::string ExplainImpl() const final {
+        std::string s = "sample sort, local ";
+        s += std::is_same<SortAlgorithm, DefaultSortAlgorithm>::value ?
+             "std::sort" :
+             std::is_same<SortAlgorithm, DefaultStableSortAlgorithm>::value ?
+             "std::stable_sort" : "custom SortAlgorithm";
+        if (Stable) s += ", stable";
+        if (use_interpolation_classifier_) s += ", interpolation classifier";
+        if (use_two_level_exchange_ && !Stable) s += ", two level exchange";
+        if (use_replacement_selection_ && !Stable)
+            s += ", replacement selection runs";
+        if (use_parallel_merge_) s += ", parallel merge";
+        return s;
+    }
+
 private:
     //! The comparison function which is applied to two elements.
     CompareFunction compare_function_;
@@ -295,7 +542,24 @@ private:
     size_t local_items_ = 0;
 
     //! epsilon
-    static constexpr double desired_imbalance_ = 0.1;
+    static constexpr double desired_imbalance_ =
+        SortConfig::desired_imbalance_;
+
+    //! run a second splitter selection round if the buckets are imbalanced
+    static constexpr bool refine_splitters_ = SortConfig::refine_splitters_;
+
+    //! maximum imbalance of the largest bucket (relative to the average)
+    //! before another splitter round is run.
+    static constexpr double max_imbalance_ = SortConfig::max_imbalance_;
+
+    //! factor by which the sample is enlarged in the refinement round.
+    static constexpr size_t refine_oversampling_ =
+        SortConfig::refine_oversampling_;
+
+    //! maximum number of samples collected by the AllGather in splitter
+    //! selection, larger local samples are thinned out regularly.
+    static constexpr size_t max_gathered_samples_ =
+        SortConfig::max_gathered_samples_;
 
     //! Sample vector: pairs of (sample,local index)
     std::vector<SampleIndexPair> samples_;
@@ -317,6 +581,15 @@ private:
     std::vector<data::File> files_;
     //! Total number of local elements after communication
     size_t local_out_size_ = 0;
+    //! Whether all items of this worker's bucket have the same key
+    bool equal_key_bucket_ = false;
+    //! First and last local input item, if it is sorted
+    ValueType first_item_, last_item_;
+    //! Whether the inputs of all workers are sorted and the items are received
+    //! from a CatStream, hence they consist of one sorted run per source
+    bool natural_runs_ = false;
+    //! model of the splitters for use_interpolation_classifier_
+    InterpolationClassifier interpolation_;
 
     //! \}
 
@@ -334,87 +607,216 @@ private:
 
     //! \}
 
-    void FindAndSendSplitters(
-        std::vector<SampleIndexPair>& splitters, size_t sample_size,
-        data::MixStreamPtr& sample_stream,
-        data::MixStream::Writers& sample_writers) {
+    //! Adapt the local sample to the global item count: each worker keeps a
+    //! random subsample proportional to its share of all items. Lightly loaded
+    //! workers otherwise send as many samples as heavy ones, which only adds
+    //! work on worker 0.
+    void AdaptSampleSize(size_t total_items) {
+        size_t global_sample_size =
+            res_sampler_.calc_sample_size(total_items) * context_.num_workers();
 
-        // Get samples from other workers
-        size_t num_total_workers = context_.num_workers();
+        size_t wanted = static_cast<size_t>(std::ceil(
+                                                static_cast<double>(global_sample_size)
+                                                * static_cast<double>(local_items_)
+                                                / static_cast<double>(total_items)));
 
-        std::vector<SampleIndexPair> samples;
-        samples.reserve(sample_size * num_total_workers);
+        if (wanted >= samples_.size()) return;
 
-        auto reader = sample_stream->GetMixReader(/* consume */ true);
+        sLOG << "AdaptSampleSize() reducing" << samples_.size()
+             << "samples to" << wanted;
 
-        while (reader.HasNext()) {
-            samples.push_back(reader.template Next<SampleIndexPair>());
+        std::shuffle(samples_.begin(), samples_.end(), context_.rng_);
+        samples_.resize(wanted);
+    }
+
+    //! Draw a fresh sample of the local items by random access.
+    void DrawSample(size_t sample_size) {
+        size_t pick_items = std::min(local_items_, sample_size);
+        samples_.clear();
+        if (pick_items == 0) return;
+        samples_.reserve(pick_items);
+        for (size_t i = 0; i < pick_items; ++i) {
+            size_t index = context_.rng_() % local_items_;
+            samples_.emplace_back(
+                unsorted_file_.GetItemAt<ValueType>(index), index);
         }
-        if (samples.size() == 0) return;
+    }
+
+    //! Select splitters from the samples of all workers. Each worker sorts its
+    //! local sample, and contributes regularly spaced representatives to an
+    //! AllGather. All workers then select the same splitters from the
+    //! collected representatives, hence there is no central worker which
+    //! sorts all samples and broadcasts the splitters. worker_items contains
+    //! the number of items on each worker.
+    void SelectSplitters(std::vector<SampleIndexPair>& splitters,
+                         size_t prefix_items,
+                         const std::vector<size_t>& worker_items) {
+
+        size_t num_total_workers = context_.num_workers();
 
-        LOG << "FindAndSendSplitters() samples.size()=" << samples.size();
+        // add the local prefix to index ranks and sort local samples
+        for (SampleIndexPair& sample : samples_)
+            sample.second += prefix_items;
 
-        // Find splitters
-        std::sort(samples.begin(), samples.end(),
+        std::sort(samples_.begin(), samples_.end(),
                   [this](
                       const SampleIndexPair& a, const SampleIndexPair& b) {
                       return LessSampleIndex(a, b);
                   });
 
-        double splitting_size = static_cast<double>(samples.size())
-                                / static_cast<double>(num_total_workers);
+        // pick representatives at regular positions if the sample is too large
+        size_t max_local = std::max<size_t>(
+            num_total_workers, max_gathered_samples_ / num_total_workers);
 
-        // Send splitters to other workers
-        for (size_t i = 1; i < num_total_workers; ++i) {
-            splitters.push_back(
-                samples[static_cast<size_t>(i * splitting_size)]);
-            for (size_t j = 1; j < num_total_workers; j++) {
-                sample_writers[j].Put(splitters.back());
+        std::vector<SampleIndexPair> local;
+        if (samples_.size() <= max_local) {
+            local = std::move(samples_);
+        }
+        else {
+            local.reserve(max_local);
+            for (size_t i = 0; i < max_local; ++i) {
+                local.push_back(
+                    samples_[(2 * i + 1) * samples_.size() / (2 * max_local)]);
             }
         }
+        tlx::vector_free(samples_);
 
-        for (size_t j = 1; j < num_total_workers; ++j)
-            sample_writers[j].Close();
-    }
-
-    class TreeBuilder
-    {
-    public:
-        ValueType* tree_;
-        const SampleIndexPair* samples_;
-        size_t index_ = 0;
-        size_t ssplitter_;
-
-        /*!
-         * Target: tree. Size of 'number of splitter'
-         * Source: sorted splitters. Size of 'number of splitter'
-         * Number of splitter
-         */
-        TreeBuilder(ValueType* splitter_tree,
-                    const SampleIndexPair* samples,
-                    size_t ssplitter)
-            : tree_(splitter_tree),
-              samples_(samples),
-              ssplitter_(ssplitter) {
-            if (ssplitter != 0)
-                recurse(samples, samples + ssplitter, 1);
-        }
-
-        void recurse(const SampleIndexPair* lo, const SampleIndexPair* hi,
-                     unsigned int treeidx) {
-            // pick middle element as splitter
-            const SampleIndexPair* mid = lo + (ssize_t)(hi - lo) / 2;
-            assert(mid < samples_ + ssplitter_);
-            tree_[treeidx] = mid->first;
-
-            if (2 * treeidx < ssplitter_)
-            {
-                const SampleIndexPair* midlo = mid, * midhi = mid + 1;
-                recurse(lo, midlo, 2 * treeidx + 0);
-                recurse(midhi, hi, 2 * treeidx + 1);
+        TruncateSamples(local, UseStringSort());
+
+        std::shared_ptr<std::vector<std::vector<SampleIndexPair> > > gathered =
+            context_.net.AllGather(local);
+        tlx::vector_free(local);
+
+        // concatenate the sorted samples of all workers, and merge them
+        // pairwise in rounds.
+        std::vector<SampleIndexPair> samples;
+        std::vector<size_t> bounds(1, 0);
+        for (const std::vector<SampleIndexPair>& v : *gathered) {
+            samples.insert(samples.end(), v.begin(), v.end());
+            bounds.push_back(samples.size());
+        }
+        gathered.reset();
+
+        auto less_sample =
+            [this](const SampleIndexPair& a, const SampleIndexPair& b) {
+                return LessSampleIndex(a, b);
+            };
+
+        size_t num_runs = bounds.size() - 1;
+        for (size_t step = 1; step < num_runs; step *= 2) {
+            for (size_t r = 0; r + step < num_runs; r += 2 * step) {
+                std::inplace_merge(
+                    samples.begin() + bounds[r],
+                    samples.begin() + bounds[r + step],
+                    samples.begin() + bounds[std::min(r + 2 * step, num_runs)],
+                    less_sample);
             }
         }
-    };
+        assert(std::is_sorted(samples.begin(), samples.end(), less_sample));
+
+        splitters.clear();
+        FindSplitters(splitters, samples, worker_items);
+    }
+
+    //! Find splitters among the sorted samples which are equally spaced in the
+    //! global rank of items. Deterministic, hence identical on all workers.
+    void FindSplitters(
+        std::vector<SampleIndexPair>& splitters,
+        const std::vector<SampleIndexPair>& samples,
+        const std::vector<size_t>& worker_items) {
+
+        size_t num_total_workers = context_.num_workers();
+
+        if (samples.size() == 0) return;
+
+        LOG << "FindSplitters() samples.size()=" << samples.size();
+
+        // prefix sums of the workers' items, used to determine the origin of a
+        // sample from its global index.
+        std::vector<size_t> worker_prefix(num_total_workers + 1, 0);
+        for (size_t w = 0; w < num_total_workers; ++w)
+            worker_prefix[w + 1] = worker_prefix[w] + worker_items[w];
+
+        auto sample_worker =
+            [&worker_prefix](const SampleIndexPair& s) -> size_t {
+                return std::upper_bound(
+                    worker_prefix.begin() + 1, worker_prefix.end(), s.second)
+                       - (worker_prefix.begin() + 1);
+            };
+
+        std::vector<size_t> worker_samples(num_total_workers, 0);
+        for (const SampleIndexPair& s : samples)
+            ++worker_samples[sample_worker(s)];
+
+        // select splitters at equidistant global ranks, or at the ranks given
+        // by the workers' capacity weights, where each sample represents the
+        // items of its worker divided by the worker's number of samples.
+        double splitting_size = static_cast<double>(worker_prefix.back())
+                                / static_cast<double>(num_total_workers);
+
+        auto splitter_rank =
+            [&](size_t i) {
+                if (!context_.has_worker_weights())
+                    return static_cast<double>(i) * splitting_size;
+                return context_.worker_weight_prefix(i)
+                       * static_cast<double>(worker_prefix.back());
+            };
+
+        double rank = 0;
+        size_t i = 1;
+        for (const SampleIndexPair& s : samples) {
+            size_t w = sample_worker(s);
+            rank += static_cast<double>(worker_items[w])
+                    / static_cast<double>(worker_samples[w]);
+            while (i < num_total_workers &&
+                   rank >= splitter_rank(i)) {
+                splitters.push_back(s);
+                ++i;
+            }
+        }
+        for ( ; i < num_total_workers; ++i)
+            splitters.push_back(samples.back());
+    }
+
+    //! Build splitter tree from splitters, adds sentinels to splitters.
+    void BuildTree(std::vector<SampleIndexPair>& splitters,
+                   std::vector<ValueType>& splitter_tree,
+                   size_t workers_algo) {
+        // code from SS2NPartition, slightly altered
+
+        splitter_tree.resize(workers_algo + 1);
+
+        // add sentinel splitters if fewer nodes than splitters.
+        for (size_t i = context_.num_workers(); i < workers_algo; i++) {
+            splitters.push_back(splitters.back());
+        }
+
+        common::BuildSplitterTree(
+            splitter_tree.data(), splitters.data(), workers_algo - 1,
+            [](const SampleIndexPair& s) { return s.first; });
+
+        if (use_interpolation_classifier_) {
+            std::vector<ValueType> values;
+            values.reserve(workers_algo - 1);
+            for (size_t i = 0; i < workers_algo - 1; ++i)
+                values.push_back(splitters[i].first);
+            interpolation_ = InterpolationClassifier(
+                values.data(), values.size());
+        }
+    }
+
+    //! Keeps the samples of other items unchanged.
+    static void TruncateSamples(std::vector<SampleIndexPair>&,
+                                std::false_type) { }
+
+    //! Truncates the sorted std::string samples to their distinguishing
+    //! prefixes, which keeps their order and reduces the AllGather volume.
+    static void TruncateSamples(std::vector<SampleIndexPair>& samples,
+                                std::true_type) {
+        common::TruncateDistinguishingPrefixes(
+            samples.begin(), samples.end(),
+            [](SampleIndexPair& s) -> std::string& { return s.first; });
+    }
 
     bool LessSampleIndex(const SampleIndexPair& a, const SampleIndexPair& b) {
         return compare_function_(a.first, b.first) || (
@@ -425,12 +827,89 @@ private:
         return !compare_function_(a.first, b.first) && a.second >= b.second;
     }
 
-    //! round n down by k where k is a power of two.
-    template <typename Integral>
-    static inline size_t RoundDown(Integral n, Integral k) {
-        return (n & ~(k - 1));
+    //! Whether the bucket of this worker lies between two splitters with equal
+    //! keys, which happens for keys heavier than a bucket. Due to the (sample,
+    //! index) tie-breaking, all its items then have this key and are spread
+    //! over all workers sharing the splitter key by global index ranges.
+    bool IsEqualKeyBucket(const std::vector<SampleIndexPair>& splitters) {
+        size_t w = context_.my_rank();
+        return w > 0 && w + 1 < context_.num_workers() &&
+               !compare_function_(splitters[w - 1].first, splitters[w].first);
     }
 
+    //! Classify all local items read from reader in batches, including the
+    //! (sample, index) tie-breaking, and call emit(bucket, item) for each.
+    template <typename Reader, typename Emit>
+    void ClassifyItems(
+        Reader& reader, const ValueType* const tree, size_t log_k,
+        const SampleIndexPair* const sorted_splitters, size_t prefix_items,
+        const Emit& emit) {
+
+        static constexpr size_t kBatchSize = 16;
+        std::vector<ValueType> batch(kBatchSize);
+        size_t bucket[kBatchSize];
+
+        for (size_t i = prefix_items; i < prefix_items + local_items_; )
+        {
+            size_t n = std::min(kBatchSize, prefix_items + local_items_ - i);
+
+            for (size_t t = 0; t < n; ++t)
+                batch[t] = reader.template Next<ValueType>();
+
+            if (use_interpolation_classifier_ && interpolation_.good()) {
+                // look up buckets in piecewise-linear model
+                interpolation_.Classify(batch.data(), n, bucket);
+            }
+            else {
+                // run items down the tree
+                common::ClassifySplitterTreeBatch(
+                    tree, log_k, batch.data(), n, bucket, compare_function_);
+            }
+
+            for (size_t t = 0; t < n; ++t, ++i)
+            {
+                size_t b = bucket[t];
+
+                while (b && EqualSampleGreaterIndex(
+                           sorted_splitters[b - 1],
+                           SampleIndexPair(batch[t], i))) {
+                    b--;
+                }
+
+                emit(b, batch[t]);
+            }
+        }
+    }
+
+    //! Calculate the maximum global bucket size relative to the average.
+    double GlobalImbalance(
+        const ValueType* const tree, size_t k, size_t log_k, size_t actual_k,
+        const SampleIndexPair* const sorted_splitters,
+        size_t prefix_items, size_t total_items) {
+
+        std::vector<size_t> histogram(k, 0);
+
+        data::File::KeepReader reader = unsorted_file_.GetKeepReader();
+        ClassifyItems(
+            reader, tree, log_k, sorted_splitters, prefix_items,
+            [&histogram](size_t b, const ValueType&) { ++histogram[b]; });
+
+        // the last bucket is sent to the last actual worker
+        histogram[actual_k - 1] += histogram[k - 1];
+        histogram.resize(actual_k);
+
+        histogram = context_.net.AllReduce(
+            histogram, common::ComponentSum<std::vector<size_t> >());
+
+        size_t max_bucket =
+            *std::max_element(histogram.begin(), histogram.end());
+
+        return static_cast<double>(max_bucket)
+               * static_cast<double>(actual_k)
+               / static_cast<double>(total_items) - 1.0;
+    }
+
+    template <typename Writers>
     void TransmitItems(
         // Tree of splitters, sizeof |splitter|
         const ValueType* const tree,
@@ -441,13 +920,11 @@ private:
         size_t actual_k,
         const SampleIndexPair* const sorted_splitters,
         size_t prefix_items,
-        TranmissionStreamPtr& data_stream) {
+        Writers& data_writers) {
 
         data::File::ConsumeReader unsorted_reader =
             unsorted_file_.GetConsumeReader();
 
-        auto data_writers = data_stream->GetWriters();
-
         // enlarge emitters array to next power of two to have direct access,
         // because we fill the splitter set up with sentinels == last splitter,
         // hence all items land in the last bucket.
@@ -456,82 +933,218 @@ private:
 
         data_writers.reserve(k);
         while (data_writers.size() < k)
-            data_writers.emplace_back(typename TranmissionStreamType::Writer());
+            data_writers.emplace_back(typename Writers::value_type());
 
         std::swap(data_writers[actual_k - 1], data_writers[k - 1]);
 
-        // classify all items (take two at once) and immediately transmit them.
+        // classify items and immediately transmit them. The BlockWriters
+        // already buffer items per destination.
+        ClassifyItems(
+            unsorted_reader, tree, log_k, sorted_splitters, prefix_items,
+            [&data_writers](size_t b, const ValueType& item) {
+                assert(data_writers[b].IsValid());
+                data_writers[b].Put(item);
+            });
+
+        // close writers and flush data
+        for (typename Writers::value_type& w : data_writers)
+            w.Close();
+    }
 
-        const size_t stepsize = 2;
+    //! Returns the writers unchanged without use_packed_integer_exchange_.
+    template <typename Writers>
+    static Writers PackWriters(Writers writers, std::false_type) {
+        return writers;
+    }
 
-        size_t i = prefix_items;
-        for ( ; i < prefix_items + RoundDown(local_items_, stepsize); i += stepsize)
-        {
-            // take two items
-            size_t j0 = 1;
-            ValueType el0 = unsorted_reader.Next<ValueType>();
+    //! Wraps the writers into core::PackedIntegerWriters.
+    template <typename Writers>
+    static auto PackWriters(Writers writers, std::true_type) {
+        return core::MakePackedIntegerWriters<ValueType>(std::move(writers));
+    }
 
-            size_t j1 = 1;
-            ValueType el1 = unsorted_reader.Next<ValueType>();
+    //! Returns the reader unchanged without use_packed_integer_exchange_.
+    template <typename Reader>
+    static Reader PackReader(Reader reader, std::false_type) {
+        return reader;
+    }
 
-            // run items down the tree
-            for (size_t l = 0; l < log_k; l++)
-            {
-                j0 = 2 * j0 + (compare_function_(el0, tree[j0]) ? 0 : 1);
-                j1 = 2 * j1 + (compare_function_(el1, tree[j1]) ? 0 : 1);
-            }
+    //! Wraps the reader into a core::PackedIntegerReader.
+    template <typename Reader>
+    static auto PackReader(Reader reader, std::true_type) {
+        return core::MakePackedIntegerReader<ValueType>(std::move(reader));
+    }
 
-            size_t b0 = j0 - k;
-            size_t b1 = j1 - k;
+    //! Length of the common prefix of all std::string items sent to worker w:
+    //! the LCP of the splitters enclosing its bucket. The first and the last
+    //! bucket are open.
+    size_t BucketPrefixLength(const std::vector<SampleIndexPair>& splitters,
+                              size_t w) const {
+        if (w == 0 || w + 1 >= context_.num_workers()) return 0;
+        return core::StringLcp(splitters[w - 1].first, splitters[w].first);
+    }
 
-            while (b0 && EqualSampleGreaterIndex(
-                       sorted_splitters[b0 - 1], SampleIndexPair(el0, i + 0))) {
-                b0--;
+    //! Returns the writers unchanged for other items.
+    template <typename Writers>
+    Writers StripPrefixes(Writers writers, const std::vector<SampleIndexPair>&,
+                          std::false_type) const {
+        return writers;
+    }
 
-                // LOG0 << "el0 equal match b0 " << b0
-                //      << " prefix_items " << prefix_items
-                //      << " lhs.first = " << sorted_splitters[b0 - 1].first
-                //      << " lhs.second = " << sorted_splitters[b0 - 1].second
-                //      << " rhs.first = " << el0
-                //      << " rhs.second = " << i;
-            }
+    //! Wraps the writers into core::StringSuffixWriters, which omit the common
+    //! prefix of their bucket.
+    template <typename Writers>
+    auto StripPrefixes(Writers writers,
+                       const std::vector<SampleIndexPair>& splitters,
+                       std::true_type) const {
+        using Writer = typename Writers::value_type;
+        std::vector<core::StringSuffixWriter<Writer> > out;
+        out.reserve(writers.size());
+        for (size_t w = 0; w < writers.size(); ++w) {
+            out.emplace_back(
+                std::move(writers[w]), BucketPrefixLength(splitters, w));
+        }
+        return out;
+    }
 
-            while (b1 && EqualSampleGreaterIndex(
-                       sorted_splitters[b1 - 1], SampleIndexPair(el1, i + 1))) {
-                b1--;
-            }
+    //! Returns the reader unchanged for other items.
+    template <typename Reader>
+    Reader AddPrefix(Reader reader, const std::vector<SampleIndexPair>&,
+                     std::false_type) const {
+        return reader;
+    }
+
+    //! Wraps the reader into a core::StringPrefixReader, which restores the
+    //! common prefix of this worker's bucket.
+    template <typename Reader>
+    auto AddPrefix(Reader reader,
+                   const std::vector<SampleIndexPair>& splitters,
+                   std::true_type) const {
+        size_t w = context_.my_rank();
+        size_t length = BucketPrefixLength(splitters, w);
+        return core::StringPrefixReader<Reader>(
+            std::move(reader),
+            length ? splitters[w].first.substr(0, length) : std::string());
+    }
+
+    //! Pushes the items of a plain sorted run.
+    void PushRun(data::File& file, bool consume, std::false_type) {
+        this->PushFile(file, consume);
+    }
 
-            assert(data_writers[b0].IsValid());
-            assert(data_writers[b1].IsValid());
+    //! Pushes the strings of a front coded sorted run.
+    void PushRun(data::File& file, bool consume, std::true_type) {
+        if (consume)
+            PushRunReader(RunConsumeReader(file.GetConsumeReader()));
+        else
+            PushRunReader(RunKeepReader(file.GetKeepReader()));
+    }
+
+    //! Pushes the items of a sorted run read by reader.
+    template <typename Reader>
+    void PushRunReader(Reader reader) {
+        while (reader.HasNext())
+            this->PushItem(reader.template Next<ValueType>());
+    }
 
-            data_writers[b0].Put(el0);
-            data_writers[b1].Put(el1);
+    //! Merges the sorted runs in files_, which are read by readers of type
+    //! Reader returned by get_reader(file), pushes the output and returns the
+    //! number of items.
+    template <typename Reader, typename GetReader>
+    size_t MergeRuns(size_t prefetch, const GetReader& get_reader) {
+        std::vector<Reader> seq;
+        seq.reserve(files_.size());
+
+        std::vector<size_t> sizes;
+        for (size_t t = 0; t < files_.size(); ++t) {
+            sizes.push_back(files_[t].size_bytes());
+            seq.emplace_back(get_reader(files_[t]));
         }
 
-        // last iteration of loop if we have an odd number of items.
-        for ( ; i < prefix_items + local_items_; i++)
-        {
-            size_t j0 = 1;
-            ValueType el0 = unsorted_reader.Next<ValueType>();
+        StartPrefetch(
+            seq, core::ProportionalPrefetch(
+                sizes, prefetch, data::default_block_size));
 
-            // run item down the tree
-            for (size_t l = 0; l < log_k; l++)
-            {
-                j0 = 2 * j0 + (compare_function_(el0, tree[j0]) ? 0 : 1);
-            }
+        auto puller = MakeRunMerger(seq, UseFrontCodedRuns());
 
-            size_t b0 = j0 - k;
+        size_t local_size = 0;
+        while (puller.HasNext()) {
+            this->PushItem(puller.Next());
+            local_size++;
+        }
+        return local_size;
+    }
 
-            while (b0 && EqualSampleGreaterIndex(
-                       sorted_splitters[b0 - 1], SampleIndexPair(el0, i))) {
-                b0--;
-            }
+    //! Returns a merger of plain sorted runs.
+    template <typename Reader>
+    auto MakeRunMerger(std::vector<Reader>& seq, std::false_type) const {
+        return MakeMultiwayMergeTree()(
+            seq.begin(), seq.end(), compare_function_);
+    }
 
-            assert(data_writers[b0].IsValid());
-            data_writers[b0].Put(el0);
+    //! Returns an LCP-aware merger of front coded sorted runs.
+    template <typename Reader>
+    auto MakeRunMerger(std::vector<Reader>& seq, std::true_type) const {
+        return core::make_lcp_multiway_merge_tree<Stable>(
+            seq.begin(), seq.end());
+    }
+
+    //! Writes the output of a merger of plain sorted runs.
+    template <typename Merger>
+    static void WriteMerged(Merger& puller, RunWriter& writer,
+                            std::false_type) {
+        while (puller.HasNext())
+            writer.Put(puller.Next());
+    }
+
+    //! Writes the output of an LCP-aware merger, whose LCPs with the previous
+    //! strings are known, into a front coded run.
+    template <typename Merger>
+    static void WriteMerged(Merger& puller, RunWriter& writer,
+                            std::true_type) {
+        while (puller.HasNext()) {
+            std::string s = puller.Next();
+            writer.Put(s, puller.lcp());
         }
+    }
 
-        // implicitly close writers and flush data
+    //! Transmit items to the writers and receive them from the stream returned
+    //! by get_reader(), possibly using a background thread.
+    template <typename Writers, typename GetReader>
+    void ExchangeItems(std::vector<ValueType>& splitter_tree,
+                       size_t workers_algo, size_t ceil_log,
+                       std::vector<SampleIndexPair>& splitters,
+                       size_t prefix_items, Writers data_writers,
+                       const GetReader& get_reader) {
+        std::thread thread;
+        if (use_background_thread_) {
+            // launch receiver thread.
+            thread = common::CreateThread(
+                [this, &get_reader]() {
+                    common::SetCpuAffinity(context_.local_worker_id());
+                    auto reader = get_reader();
+                    return ReceiveItems(reader);
+                });
+        }
+
+        TransmitItems(
+            splitter_tree.data(), // Tree. sizeof |splitter|
+            workers_algo,         // Number of buckets
+            ceil_log,
+            context_.num_workers(),
+            splitters.data(),
+            prefix_items,
+            data_writers);
+
+        tlx::vector_free(splitter_tree);
+
+        if (use_background_thread_) {
+            thread.join();
+        }
+        else {
+            auto reader = get_reader();
+            ReceiveItems(reader);
+        }
     }
 
     void MainOp() {
@@ -559,88 +1172,81 @@ private:
             return;
         }
 
-        // stream to send samples to process 0 and receive them back
-        data::MixStreamPtr sample_stream = context_.GetNewMixStream(this);
-
-        // Send all samples to worker 0.
-        data::MixStream::Writers sample_writers = sample_stream->GetWriters();
-
-        for (const SampleIndexPair& sample : samples_) {
-            // send samples but add the local prefix to index ranks
-            sample_writers[0].Put(
-                SampleIndexPair(sample.first, prefix_items + sample.second));
+        // number of items on all workers, used to weight their samples, and
+        // whether their input is sorted, in one collective.
+        std::vector<size_t> worker_items;
+        if (detect_presorted_) {
+            if (DetectPresorted(worker_items)) return;
         }
-        sample_writers[0].Close();
-        tlx::vector_free(samples_);
+        else {
+            worker_items = *context_.net.AllGather(local_items_);
+        }
+
+        AdaptSampleSize(total_items);
+        size_t sample_size = samples_.size();
 
         // Get the ceiling of log(num_total_workers), as SSSS needs 2^n buckets.
         size_t ceil_log = tlx::integer_log2_ceil(num_total_workers);
         size_t workers_algo = size_t(1) << ceil_log;
-        size_t splitter_count_algo = workers_algo - 1;
 
         std::vector<SampleIndexPair> splitters;
         splitters.reserve(workers_algo);
 
-        if (context_.my_rank() == 0) {
-            FindAndSendSplitters(splitters, samples_.size(),
-                                 sample_stream, sample_writers);
-        }
-        else {
-            // Close unused emitters
-            for (size_t j = 1; j < num_total_workers; j++) {
-                sample_writers[j].Close();
-            }
-            data::MixStream::MixReader reader =
-                sample_stream->GetMixReader(/* consume */ true);
-            while (reader.HasNext()) {
-                splitters.push_back(reader.template Next<SampleIndexPair>());
-            }
-        }
-        sample_writers.clear();
-        sample_stream.reset();
+        SelectSplitters(splitters, prefix_items, worker_items);
 
-        // code from SS2NPartition, slightly altered
+        std::vector<ValueType> splitter_tree;
+        BuildTree(splitters, splitter_tree, workers_algo);
 
-        std::vector<ValueType> splitter_tree(workers_algo + 1);
-
-        // add sentinel splitters if fewer nodes than splitters.
-        for (size_t i = num_total_workers; i < workers_algo; i++) {
-            splitters.push_back(splitters.back());
-        }
+        if (refine_splitters_ && num_total_workers > 1)
+        {
+            double imbalance = GlobalImbalance(
+                splitter_tree.data(), workers_algo, ceil_log,
+                num_total_workers, splitters.data(), prefix_items,
+                total_items);
 
-        TreeBuilder(splitter_tree.data(),
-                    splitters.data(),
-                    splitter_count_algo);
+            if (context_.my_rank() == 0)
+                sLOG << "Sort() splitter imbalance" << imbalance;
 
-        auto data_stream = context_.template GetNewStream<TranmissionStreamType>(this->dia_id());
+            if (imbalance > max_imbalance_) {
+                // second round with a larger sample
+                DrawSample(refine_oversampling_ * wanted_sample_size());
+                sample_size += samples_.size();
 
-        std::thread thread;
-        if (use_background_thread_) {
-            // launch receiver thread.
-            thread = common::CreateThread(
-                [this, &data_stream]() {
-                    common::SetCpuAffinity(context_.local_worker_id());
-                    return ReceiveItems(data_stream);
-                });
+                SelectSplitters(splitters, prefix_items, worker_items);
+                BuildTree(splitters, splitter_tree, workers_algo);
+            }
         }
 
-        TransmitItems(
-            splitter_tree.data(), // Tree. sizeof |splitter|
-            workers_algo,         // Number of buckets
-            ceil_log,
-            num_total_workers,
-            splitters.data(),
-            prefix_items,
-            data_stream);
+        equal_key_bucket_ = IsEqualKeyBucket(splitters);
 
-        tlx::vector_free(splitter_tree);
+        if (use_two_level_exchange_ && !Stable) {
+            core::TwoLevelExchange<ValueType> exchange(
+                context_, this->dia_id());
 
-        if (use_background_thread_)
-            thread.join();
-        else
-            ReceiveItems(data_stream);
+            ExchangeItems(
+                splitter_tree, workers_algo, ceil_log, splitters, prefix_items,
+                exchange.GetWriters(),
+                [&exchange]() { return exchange.GetReader(/* consume */ true); });
+        }
+        else {
+            auto data_stream =
+                context_.template GetNewStream<TranmissionStreamType>(
+                    this->dia_id());
+
+            ExchangeItems(
+                splitter_tree, workers_algo, ceil_log, splitters, prefix_items,
+                StripPrefixes(
+                    PackWriters(data_stream->GetWriters(), UsePackedIntegers()),
+                    splitters, UseStringSort()),
+                [this, &data_stream, &splitters]() {
+                    return AddPrefix(
+                        PackReader(data_stream->GetReader(/* consume */ true),
+                                   UsePackedIntegers()),
+                        splitters, UseStringSort());
+                });
 
-        data_stream.reset();
+            data_stream.reset();
+        }
 
         double balance = 0;
         if (local_out_size_ > 0) {
@@ -659,31 +1265,182 @@ private:
             << "workers" << num_total_workers
             << "local_out_size" << local_out_size_
             << "balance" << balance
-            << "sample_size" << samples_.size();
+            << "sample_size" << sample_size
+            << "equal_key_bucket" << equal_key_bucket_;
+    }
+
+    /*!
+     * Whether the local input is sorted, and sets first_item_ and last_item_
+     * if it is. The samples are checked in the order of their local indexes
+     * first, and only if they are sorted, unsorted_file_ is scanned until the
+     * first inversion. Hence unsorted input is usually rejected without
+     * reading it.
+     */
+    bool LocalInputSorted() {
+        if (local_items_ == 0) return true;
+
+        std::vector<const SampleIndexPair*> by_index;
+        by_index.reserve(samples_.size());
+        for (const SampleIndexPair& sample : samples_)
+            by_index.push_back(&sample);
+        std::sort(by_index.begin(), by_index.end(),
+                  [](const SampleIndexPair* a, const SampleIndexPair* b) {
+                      return a->second < b->second;
+                  });
+        for (size_t i = 1; i < by_index.size(); ++i) {
+            if (compare_function_(by_index[i]->first, by_index[i - 1]->first))
+                return false;
+        }
+
+        data::File::KeepReader reader = unsorted_file_.GetKeepReader();
+        ValueType prev = reader.template Next<ValueType>();
+        first_item_ = prev;
+        while (reader.HasNext()) {
+            ValueType item = reader.template Next<ValueType>();
+            if (compare_function_(item, prev)) return false;
+            prev = std::move(item);
+        }
+        last_item_ = std::move(prev);
+        return true;
     }
 
-    void ReceiveItems(TranmissionStreamPtr& data_stream) {
+    /*!
+     * Gathers the number of items of all workers into worker_items, and
+     * whether their inputs are sorted with their first and last items. If the
+     * whole input is sorted and the workers' items are balanced, the local
+     * items become the single sorted run and true is returned. If all inputs
+     * are only sorted locally, the received items are split into natural runs.
+     */
+    bool DetectPresorted(std::vector<size_t>& worker_items) {
+        using Info = std::tuple<size_t, bool, ValueType, ValueType>;
+
+        bool sorted = LocalInputSorted();
+        std::vector<Info> infos = *context_.net.AllGather(
+            Info(local_items_, sorted, first_item_, last_item_));
+
+        bool all_sorted = true, ordered = true;
+        const Info* prev = nullptr;
+        worker_items.resize(infos.size());
+        for (size_t w = 0; w < infos.size(); ++w) {
+            worker_items[w] = std::get<0>(infos[w]);
+            if (std::get<0>(infos[w]) == 0) continue;
+            all_sorted = all_sorted && std::get<1>(infos[w]);
+            if (prev && compare_function_(
+                    std::get<2>(infos[w]), std::get<3>(*prev)))
+                ordered = false;
+            prev = &infos[w];
+        }
+
+        // only the CatStream of stable sorting delivers the items of each
+        // source consecutively, a MixStream interleaves their Blocks.
+        natural_runs_ = all_sorted && Stable;
+        if (!all_sorted || !ordered) return false;
+
+        // skewed sorted input is exchanged to balance the output, with the
+        // received items merged as natural runs.
+        size_t total_items = std::accumulate(
+            worker_items.begin(), worker_items.end(), size_t(0));
+        size_t max_items = *std::max_element(
+            worker_items.begin(), worker_items.end());
+        if (static_cast<double>(max_items) * worker_items.size() >
+            (1.0 + desired_imbalance_) * total_items)
+            return false;
 
-        auto reader = data_stream->GetReader(/* consume */ true);
+        // the input is sorted: keep the items on their workers.
+        local_out_size_ = local_items_;
+        if (local_items_ != 0)
+            AdoptSortedInput(UseFrontCodedRuns());
+
+        Super::logger_
+            << "class" << "SortNode"
+            << "event" << "done"
+            << "workers" << context_.num_workers()
+            << "local_out_size" << local_out_size_
+            << "presorted" << true;
+        return true;
+    }
+
+    //! Makes the sorted unsorted_file_ the single plain sorted run.
+    void AdoptSortedInput(std::false_type) {
+        files_.emplace_back(std::move(unsorted_file_));
+    }
+
+    //! Writes the sorted unsorted_file_ into a single front coded run.
+    void AdoptSortedInput(std::true_type) {
+        files_.emplace_back(context_.GetFile(this));
+        RunWriter writer(files_.back().GetWriter());
+        data::File::ConsumeReader reader = unsorted_file_.GetConsumeReader();
+        while (reader.HasNext())
+            writer.Put(reader.template Next<ValueType>());
+        writer.Close();
+    }
+
+    template <typename Reader>
+    void ReceiveItems(Reader& reader) {
+
+        if (equal_key_bucket_) {
+            // all items are equal and arrive in order: no sorting or merging
+            WriteEqualKeyRun(reader);
+            return;
+        }
+
+        if (natural_runs_) {
+            // the items of each source arrive sorted: merge instead of sort
+            WriteNaturalRuns(reader);
+            return;
+        }
 
         LOG0 << "Writing files";
 
-        // M/2 such that the other half is used to prepare the next bulk
-        size_t capacity = DIABase::mem_limit_ / sizeof(ValueType) / 2;
-        size_t capacity_half = capacity / 2;
+        // the previous full vector, which is sorted and written as deferred
+        // work while the reader waits for further Blocks. Only one is pending
+        // at a time, hence the run files keep their order.
+        std::vector<ValueType> full;
+        const bool defer = !common::DeferredWork::running();
+
+        // M/2 such that the other half is used to prepare the next bulk. If
+        // runs are deferred, full and vec are resident at once, hence each
+        // run, including the heap memory of its items, gets half of that.
+        const size_t limit_bytes = DIABase::mem_limit_ / (defer ? 4 : 2);
+        size_t capacity = limit_bytes / sizeof(ValueType);
         std::vector<ValueType> vec;
         vec.reserve(capacity);
 
+        // heap memory of variable-size items in vec, which counts towards the
+        // memory limit like the vector itself.
+        using ItemMemory = common::ItemMemorySize<ValueType>;
+        size_t heap_bytes = 0;
+
         while (reader.HasNext()) {
-            if (vec.size() < capacity_half ||
-                (vec.size() < capacity && !mem::memory_exceeded)) {
+            size_t used_bytes = vec.size() * sizeof(ValueType) + heap_bytes;
+            if (used_bytes < limit_bytes / 2 ||
+                (used_bytes < limit_bytes && !mem::memory_exceeded)) {
                 vec.push_back(reader.template Next<ValueType>());
+                if (!ItemMemory::is_fixed)
+                    heap_bytes += ItemMemory::heap(vec.back());
+            }
+            else if (use_replacement_selection_ && !Stable) {
+                // items do not fit into RAM: continue with longer runs
+                common::DeferredWork::RunAll();
+                ReplacementSelection(vec, reader);
+            }
+            else if (defer) {
+                common::DeferredWork::RunAll();
+                assert(full.empty());
+                full.swap(vec);
+                vec.reserve(capacity);
+                common::DeferredWork::Post(
+                    [this, &full]() { SortAndWriteToFile(full); });
             }
             else {
                 SortAndWriteToFile(vec);
             }
+            if (vec.empty()) heap_bytes = 0;
         }
 
+        common::DeferredWork::RunAll();
+        tlx::vector_free(full);
+
         if (vec.size())
             SortAndWriteToFile(vec);
 
@@ -693,6 +1450,140 @@ private:
         }
     }
 
+    /*!
+     * Form runs from the items in vec and the remaining items of the reader
+     * with replacement selection: vec is used as a heap, from which the
+     * smallest item is written to the current run and replaced by the next
+     * input item. If the new item is smaller than the last written one, it is
+     * tagged for the next run. On random input, the runs are on average twice
+     * as large as the heap.
+     */
+    template <typename Reader>
+    void ReplacementSelection(std::vector<ValueType>& vec, Reader& reader) {
+
+        LOG << "ReplacementSelection() starting with heap of " << vec.size()
+            << " items into file #" << files_.size();
+
+        timer_sort_.Start();
+
+        //! heap items: (next run flag, item), the current run is false.
+        using RunItem = std::pair<bool, ValueType>;
+
+        std::vector<RunItem> heap;
+        heap.reserve(vec.size());
+        for (ValueType& v : vec)
+            heap.emplace_back(false, std::move(v));
+        tlx::vector_free(vec);
+
+        // max-heap comparator delivering the smallest item of the current run
+        auto heap_cmp =
+            [this](const RunItem& a, const RunItem& b) {
+                return a.first != b.first
+                       ? a.first : compare_function_(b.second, a.second);
+            };
+        std::make_heap(heap.begin(), heap.end(), heap_cmp);
+
+        size_t run_size = 0;
+        files_.emplace_back(context_.GetFile(this));
+        RunWriter writer(files_.back().GetWriter());
+
+        while (!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), heap_cmp);
+            RunItem& top = heap.back();
+
+            if (top.first) {
+                // current run is complete: all heap items belong to next run.
+                writer.Close();
+
+                Super::logger_
+                    << "class" << "SortNode"
+                    << "event" << "write_file"
+                    << "file_num" << (files_.size() - 1)
+                    << "items" << run_size;
+
+                for (RunItem& r : heap) r.first = false;
+                files_.emplace_back(context_.GetFile(this));
+                writer = RunWriter(files_.back().GetWriter());
+                run_size = 0;
+            }
+
+            writer.Put(top.second);
+            ++run_size, ++local_out_size_;
+
+            if (reader.HasNext()) {
+                ValueType next = reader.template Next<ValueType>();
+                top.first = compare_function_(next, top.second);
+                top.second = std::move(next);
+                std::push_heap(heap.begin(), heap.end(), heap_cmp);
+            }
+            else {
+                heap.pop_back();
+            }
+        }
+        writer.Close();
+
+        timer_sort_.Stop();
+
+        Super::logger_
+            << "class" << "SortNode"
+            << "event" << "write_file"
+            << "file_num" << (files_.size() - 1)
+            << "items" << run_size
+            << "timer_sort_" << timer_sort_;
+    }
+
+    //! Writes all items of an equal key bucket into a single run, which is
+    //! sorted, since the CatStream of a stable sort delivers them in the order
+    //! of their global index.
+    template <typename Reader>
+    void WriteEqualKeyRun(Reader& reader) {
+        files_.emplace_back(context_.GetFile(this));
+        RunWriter writer(files_.back().GetWriter());
+        size_t run_size = 0;
+        while (reader.HasNext()) {
+            writer.Put(reader.template Next<ValueType>());
+            ++run_size;
+        }
+        writer.Close();
+        local_out_size_ += run_size;
+
+        Super::logger_
+            << "class" << "SortNode"
+            << "event" << "write_equal_key_file"
+            << "items" << run_size;
+    }
+
+    //! Writes the received items into runs, which end where an item is
+    //! smaller than its predecessor. Since all sources sent sorted sequences
+    //! and the CatStream delivers them one after another, a run ends only
+    //! where the items of another source begin.
+    template <typename Reader>
+    void WriteNaturalRuns(Reader& reader) {
+        files_.emplace_back(context_.GetFile(this));
+        RunWriter writer(files_.back().GetWriter());
+        ValueType prev;
+        size_t run_size = 0;
+        while (reader.HasNext()) {
+            ValueType item = reader.template Next<ValueType>();
+            if (run_size != 0 && compare_function_(item, prev)) {
+                writer.Close();
+                files_.emplace_back(context_.GetFile(this));
+                writer = RunWriter(files_.back().GetWriter());
+                run_size = 0;
+            }
+            writer.Put(item);
+            prev = std::move(item);
+            ++run_size, ++local_out_size_;
+        }
+        writer.Close();
+
+        Super::logger_
+            << "class" << "SortNode"
+            << "event" << "natural_runs"
+            << "runs" << files_.size();
+    }
+
     void SortAndWriteToFile(std::vector<ValueType>& vec) {
 
         LOG << "SortAndWriteToFile() " << vec.size()
@@ -718,7 +1609,7 @@ private:
         write_time.Start();
 
         files_.emplace_back(context_.GetFile(this));
-        auto writer = files_.back().GetWriter();
+        RunWriter writer(files_.back().GetWriter());
         for (const ValueType& elem : vec) {
             writer.Put(elem);
         }
@@ -741,57 +1632,91 @@ private:
             << "write_time" << write_time;
     }
 
+    //! Merges one batch of Files planned by core::PlanMergeBatch(), which
+    //! minimizes the total volume of all merges. The merged File replaces the
+    //! batch at the position of its first File, hence the batches of stable
+    //! sorting, which are consecutive, keep the order of the runs.
     void PartialMultiwayMerge(size_t merge_degree, size_t prefetch) {
-        sLOG1 << "Partial multi-way-merge of" << files_.size()
-              << "files with degree" << merge_degree
-              << "and prefetch" << prefetch;
+        std::vector<size_t> sizes;
+        sizes.reserve(files_.size());
+        for (const data::File& f : files_)
+            sizes.push_back(f.size_bytes());
 
-        std::vector<data::File> new_files;
+        std::vector<size_t> batch =
+            core::PlanMergeBatch(sizes, merge_degree, /* consecutive */ Stable);
 
-        // merge batches of merge_degree Files into new_files
-        size_t fi;
-        for (fi = 0; fi + merge_degree < files_.size(); fi += merge_degree) {
-            // create merger for first merge_degree Files
-            std::vector<data::File::ConsumeReader> seq;
-            seq.reserve(merge_degree);
+        sLOG1 << "Partial multi-way-merge of" << batch.size()
+              << "of" << files_.size() << "files with degree" << merge_degree
+              << "and prefetch" << prefetch;
 
-            for (size_t t = 0; t < merge_degree; ++t) {
-                seq.emplace_back(
-                    files_[fi + t].GetConsumeReader(/* prefetch */ 0));
+        data::File merged = context_.GetFile(this);
+        {
+            // create merger for the Files of the batch
+            std::vector<RunConsumeReader> seq;
+            std::vector<size_t> batch_sizes;
+            seq.reserve(batch.size());
+
+            for (const size_t& i : batch) {
+                batch_sizes.push_back(sizes[i]);
+                seq.emplace_back(files_[i].GetConsumeReader(/* prefetch */ 0));
             }
 
-            StartPrefetch(seq, prefetch);
-
-            auto puller = MakeMultiwayMergeTree()(
-                seq.begin(), seq.end(), compare_function_);
+            StartPrefetch(
+                seq, core::ProportionalPrefetch(
+                    batch_sizes, prefetch, data::default_block_size));
 
-            // create new File for merged items
-            new_files.emplace_back(context_.GetFile(this));
-            auto writer = new_files.back().GetWriter();
+            auto puller = MakeRunMerger(seq, UseFrontCodedRuns());
 
-            while (puller.HasNext()) {
-                writer.Put(puller.Next());
-            }
+            RunWriter writer(merged.GetWriter());
+            WriteMerged(puller, writer, UseFrontCodedRuns());
             writer.Close();
 
             // merged files are cleared by the ConsumeReader
         }
 
-        // copy remaining files into new_files
-        for ( ; fi < files_.size(); ++fi) {
-            new_files.emplace_back(std::move(files_[fi]));
+        // replace the batch by the merged File
+        std::vector<data::File> new_files;
+        new_files.reserve(files_.size() - batch.size() + 1);
+        for (size_t i = 0, b = 0; i < files_.size(); ++i) {
+            if (b < batch.size() && batch[b] == i) {
+                if (b++ == 0) new_files.emplace_back(std::move(merged));
+            }
+            else {
+                new_files.emplace_back(std::move(files_[i]));
+            }
         }
-
         std::swap(files_, new_files);
     }
 };
 
+//! Whether the items of Iterator compared with CompareFunction are
+//! std::strings in lexicographic order, which the default SortAlgorithms sort
+//! with common::string_sort().
+template <typename Iterator, typename CompareFunction>
+using IsStringLess = std::integral_constant<
+    bool, std::is_same<typename std::iterator_traits<Iterator>::value_type,
+                       std::string>::value &&
+    std::is_same<CompareFunction, std::less<std::string> >::value>;
+
 class DefaultSortAlgorithm
 {
 public:
     template <typename Iterator, typename CompareFunction>
     void operator () (Iterator begin, Iterator end, CompareFunction cmp) const {
-        return std::sort(begin, end, cmp);
+        return Sort(begin, end, cmp, IsStringLess<Iterator, CompareFunction>());
+    }
+
+private:
+    template <typename Iterator, typename CompareFunction>
+    static void Sort(Iterator begin, Iterator end, CompareFunction cmp,
+                     std::false_type) {
+        std::sort(begin, end, cmp);
+    }
+
+    template <typename Iterator, typename CompareFunction>
+    static void Sort(Iterator begin, Iterator end, CompareFunction cmp,
+                     std::true_type) {
+        common::StringSort()(begin, end, cmp);
     }
 };
 
@@ -827,13 +1752,16 @@ auto DIA<ValueType, Stack>::Sort(const CompareFunction& compare_function) const
 }
 
 template <typename ValueType, typename Stack>
-template <typename CompareFunction, typename SortAlgorithm>
+template <typename CompareFunction, typename SortAlgorithm,
+          typename SortConfig>
 auto DIA<ValueType, Stack>::Sort(const CompareFunction& compare_function,
-                                 const SortAlgorithm& sort_algorithm) const {
+                                 const SortAlgorithm& sort_algorithm,
+                                 const SortConfig& /* sort_config */) const {
     assert(IsValid());
 
     using SortNode = api::SortNode<
-        ValueType, CompareFunction, SortAlgorithm>;
+        ValueType, CompareFunction, SortAlgorithm, /* Stable */ false,
+        SortConfig>;
 
     static_assert(
         std::is_convertible<
@@ -864,7 +1792,21 @@ class DefaultStableSortAlgorithm
 public:
     template <typename Iterator, typename CompareFunction>
     void operator () (Iterator begin, Iterator end, CompareFunction cmp) const {
-        return std::stable_sort(begin, end, cmp);
+        return Sort(begin, end, cmp, IsStringLess<Iterator, CompareFunction>());
+    }
+
+private:
+    template <typename Iterator, typename CompareFunction>
+    static void Sort(Iterator begin, Iterator end, CompareFunction cmp,
+                     std::false_type) {
+        std::stable_sort(begin, end, cmp);
+    }
+
+    //! equal strings are indistinguishable, hence any sort is stable
+    template <typename Iterator, typename CompareFunction>
+    static void Sort(Iterator begin, Iterator end, CompareFunction cmp,
+                     std::true_type) {
+        common::StringSort()(begin, end, cmp);
     }
 };
 
@@ -902,15 +1844,18 @@ auto DIA<ValueType, Stack>::SortStable(
 }
 
 template <typename ValueType, typename Stack>
-template <typename CompareFunction, typename SortAlgorithm>
+template <typename CompareFunction, typename SortAlgorithm,
+          typename SortConfig>
 auto DIA<ValueType, Stack>::SortStable(
     const CompareFunction& compare_function,
-    const SortAlgorithm& sort_algorithm) const {
+    const SortAlgorithm& sort_algorithm,
+    const SortConfig& /* sort_config */) const {
 
     assert(IsValid());
 
     using SortStableNode = api::SortNode<
-        ValueType, CompareFunction, SortAlgorithm, /* Stable */ true>;
+        ValueType, CompareFunction, SortAlgorithm, /* Stable */ true,
+        SortConfig>;
 
     static_assert(
         std::is_convertible<
@@ -936,6 +1881,53 @@ auto DIA<ValueType, Stack>::SortStable(
     return DIA<ValueType>(node);
 }
 
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename CompareFunction>
+auto DIA<ValueType, Stack>::SortBy(
+    const KeyExtractor& key_extractor,
+    const CompareFunction& compare_function) const {
+
+    assert(IsValid());
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0> >::value,
+        "KeyExtractor has the wrong input type");
+
+    using Key = typename std::decay<
+        typename FunctionTraits<KeyExtractor>::result_type>::type;
+
+    static_assert(
+        std::is_convertible<
+            Key,
+            typename FunctionTraits<CompareFunction>::template arg<0> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            Key,
+            typename FunctionTraits<CompareFunction>::template arg<1> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<CompareFunction>::result_type,
+            bool>::value,
+        "CompareFunction has the wrong output type (should be bool)");
+
+    // sort (key, item) pairs by the cached key, and drop the key on output
+    using KeyItem = std::pair<Key, ValueType>;
+
+    return Map([key_extractor](const ValueType& v) {
+                   return KeyItem(key_extractor(v), v);
+               })
+           .Sort([compare_function](const KeyItem& a, const KeyItem& b) {
+                     return compare_function(a.first, b.first);
+                 })
+           .Map([](const KeyItem& p) { return p.second; });
+}
+
 } // namespace api
 } // namespace thrill
 
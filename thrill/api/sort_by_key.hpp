@@ -0,0 +1,309 @@
+/*******************************************************************************
+ * thrill/api/sort_by_key.hpp
+ *
+ * DIANode for sorting large items by a key: only the keys are sorted globally,
+ * the items are permuted by a single exchange.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_SORT_BY_KEY_HEADER
+#define THRILL_API_SORT_BY_KEY_HEADER
+
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/function_traits.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/data/cat_stream.hpp>
+#include <thrill/data/file.hpp>
+
+#include <tlx/vector_free.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DIANode which sorts large items by a key extracted from them.
+ *
+ * Sort() moves the whole items through the local sort, the classification,
+ * the exchange, and the multiway merge. For items much larger than their keys,
+ * e.g. log records, SortByKey instead keeps the items in a local File and
+ * sorts only (key, global index) pairs: splitters are selected from a sample
+ * of the pairs, the pairs are exchanged and sorted by the receiving worker.
+ * Since each worker classifies its own pairs, it knows the destination of its
+ * items, and sends them in one final exchange. The items of each source arrive
+ * in the order of their global index, which is the tie-breaker of the sorted
+ * pairs, hence each item is placed directly at its rank, and is never moved by
+ * the local sort.
+ *
+ * The tie-breaker makes SortByKey stable. The items of each worker's output
+ * must fit into RAM.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename KeyExtractor, typename CompareFunction>
+class SortByKeyNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using Key = typename std::decay<
+        typename common::FunctionTraits<KeyExtractor>::result_type>::type;
+
+    //! pair of (key, global index) of an item, or of (key, receive position)
+    //! after the exchange.
+    using KeyIndexPair = std::pair<Key, size_t>;
+
+    //! number of samples per worker for splitter selection
+    static constexpr size_t kOversampling = 16;
+
+public:
+    template <typename ParentDIA>
+    SortByKeyNode(const ParentDIA& parent,
+                  const KeyExtractor& key_extractor,
+                  const CompareFunction& compare_function)
+        : Super(parent.ctx(), "SortByKey", { parent.id() }, { parent.node() }),
+          key_extractor_(key_extractor),
+          compare_function_(compare_function),
+          items_file_(context_.GetFile(this)) {
+        auto pre_op_fn = [this](const ValueType& input) {
+                             PreOp(input);
+                         };
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void StartPreOp(size_t /* parent_index */) final {
+        items_writer_ = items_file_.GetWriter();
+    }
+
+    void PreOp(const ValueType& input) {
+        keys_.emplace_back(key_extractor_(input), keys_.size());
+        items_writer_.Put(input);
+    }
+
+    void StopPreOp(size_t /* parent_index */) final {
+        items_writer_.Close();
+    }
+
+    DIAMemUse ExecuteMemUse() final {
+        return DIAMemUse::Max();
+    }
+
+    void Execute() final {
+        size_t num_workers = context_.num_workers();
+
+        // global indexes of the local items
+        size_t prefix = keys_.size();
+        size_t total = context_.net.ExPrefixSumTotal(prefix);
+        for (KeyIndexPair& k : keys_)
+            k.second += prefix;
+
+        std::vector<KeyIndexPair> splitters;
+        if (total != 0 && num_workers > 1)
+            SelectSplitters(splitters, total);
+
+        // classify the pairs, and send them to their buckets
+        std::vector<size_t> bucket(keys_.size());
+        {
+            data::CatStreamPtr stream = context_.GetNewCatStream(this);
+            data::CatStream::Writers writers = stream->GetWriters();
+
+            for (size_t i = 0; i < keys_.size(); ++i) {
+                bucket[i] = std::upper_bound(
+                    splitters.begin(), splitters.end(), keys_[i],
+                    [this](const KeyIndexPair& a, const KeyIndexPair& b) {
+                        return LessKeyIndex(a, b);
+                    }) - splitters.begin();
+                writers[bucket[i]].Put(keys_[i]);
+            }
+            writers.clear();
+            tlx::vector_free(keys_);
+
+            // the pairs of each source arrive in order of their global index,
+            // hence the receive position breaks ties just the same.
+            auto reader = stream->GetCatReader(/* consume */ true);
+            while (reader.HasNext()) {
+                keys_.emplace_back(reader.template Next<KeyIndexPair>());
+                keys_.back().second = keys_.size() - 1;
+            }
+        }
+
+        std::sort(keys_.begin(), keys_.end(),
+                  [this](const KeyIndexPair& a, const KeyIndexPair& b) {
+                      return LessKeyIndex(a, b);
+                  });
+
+        // rank of each item in the order in which it is received
+        std::vector<size_t> rank(keys_.size());
+        for (size_t r = 0; r < keys_.size(); ++r)
+            rank[keys_[r].second] = r;
+        tlx::vector_free(keys_);
+
+        sLOG << "SortByKeyNode::Execute() receiving" << rank.size() << "items";
+
+        // permute the items with a single exchange
+        data::CatStreamPtr stream = context_.GetNewCatStream(this);
+        data::CatStream::Writers writers = stream->GetWriters();
+        {
+            data::File::ConsumeReader reader = items_file_.GetConsumeReader();
+            for (size_t i = 0; reader.HasNext(); ++i)
+                writers[bucket[i]].Put(reader.template Next<ValueType>());
+        }
+        writers.clear();
+        tlx::vector_free(bucket);
+
+        items_.resize(rank.size());
+        auto reader = stream->GetCatReader(/* consume */ true);
+        for (size_t i = 0; reader.HasNext(); ++i)
+            items_[rank[i]] = reader.template Next<ValueType>();
+    }
+
+    void PushData(bool consume) final {
+        for (const ValueType& v : items_)
+            this->PushItem(v);
+        if (consume)
+            tlx::vector_free(items_);
+    }
+
+    void Dispose() final {
+        tlx::vector_free(items_);
+    }
+
+    std::string ExplainImpl() const final {
+        return "sample sort of (key, index) pairs, one item exchange";
+    }
+
+private:
+    //! extracts the key of an item
+    KeyExtractor key_extractor_;
+    //! compares two keys
+    CompareFunction compare_function_;
+
+    //! local items in the PreOp
+    data::File items_file_;
+    //! writer of items_file_
+    data::File::Writer items_writer_;
+
+    //! (key, local index) pairs of the local items
+    std::vector<KeyIndexPair> keys_;
+
+    //! sorted items after Execute()
+    std::vector<ValueType> items_;
+
+    //! order by key, then by index
+    bool LessKeyIndex(const KeyIndexPair& a, const KeyIndexPair& b) const {
+        if (compare_function_(a.first, b.first)) return true;
+        if (compare_function_(b.first, a.first)) return false;
+        return a.second < b.second;
+    }
+
+    //! Select num_workers - 1 splitters from a random sample of all pairs,
+    //! to which each worker contributes in proportion to its items. The
+    //! splitters are spaced by the workers' capacity weights, if set.
+    void SelectSplitters(std::vector<KeyIndexPair>& splitters, size_t total) {
+        size_t num_workers = context_.num_workers();
+
+        size_t sample_size = 0;
+        if (!keys_.empty()) {
+            sample_size = static_cast<size_t>(
+                std::ceil(static_cast<double>(kOversampling * num_workers)
+                          * static_cast<double>(keys_.size())
+                          / static_cast<double>(total)));
+        }
+
+        std::vector<KeyIndexPair> local;
+        local.reserve(sample_size);
+        for (size_t i = 0; i < sample_size; ++i)
+            local.push_back(keys_[context_.rng_() % keys_.size()]);
+
+        std::shared_ptr<std::vector<std::vector<KeyIndexPair> > > gathered =
+            context_.net.AllGather(local);
+        tlx::vector_free(local);
+
+        std::vector<KeyIndexPair> samples;
+        for (const std::vector<KeyIndexPair>& v : *gathered)
+            samples.insert(samples.end(), v.begin(), v.end());
+        gathered.reset();
+
+        std::sort(samples.begin(), samples.end(),
+                  [this](const KeyIndexPair& a, const KeyIndexPair& b) {
+                      return LessKeyIndex(a, b);
+                  });
+
+        for (size_t i = 1; i < num_workers; ++i) {
+            double fraction =
+                context_.has_worker_weights() ?
+                context_.worker_weight_prefix(i) :
+                static_cast<double>(i) / static_cast<double>(num_workers);
+            size_t pos = std::min(
+                samples.size() - 1, static_cast<size_t>(
+                    fraction * static_cast<double>(samples.size())));
+            splitters.push_back(samples[pos]);
+        }
+    }
+};
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor, typename CompareFunction>
+auto DIA<ValueType, Stack>::SortByKey(
+    const KeyExtractor& key_extractor,
+    const CompareFunction& compare_function) const {
+    assert(IsValid());
+
+    using SortByKeyNode =
+        api::SortByKeyNode<ValueType, KeyExtractor, CompareFunction>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0> >::value,
+        "KeyExtractor has the wrong input type");
+
+    using Key = typename FunctionTraits<KeyExtractor>::result_type;
+
+    static_assert(
+        std::is_convertible<
+            Key,
+            typename FunctionTraits<CompareFunction>::template arg<0> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            Key,
+            typename FunctionTraits<CompareFunction>::template arg<1> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<CompareFunction>::result_type,
+            bool>::value,
+        "CompareFunction has the wrong output type (should be bool)");
+
+    auto node = tlx::make_counting<SortByKeyNode>(
+        *this, key_extractor, compare_function);
+
+    return DIA<ValueType>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_SORT_BY_KEY_HEADER
+
+/******************************************************************************/
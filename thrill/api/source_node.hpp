@@ -26,9 +26,17 @@ class SourceNode : public DIANode<ValueType>
 public:
     using Super = DIANode<ValueType>;
 
-    SourceNode(Context& ctx, const char* label)
-        : Super(ctx, label, { /* parent_ids */ }, { /* parents */ })
-    { }
+    /*!
+     * Constructor of a SourceNode. Recomputable sources regenerate their items
+     * in each PushData(), e.g. by re-reading files or re-running a generator
+     * function, which is cheaper than caching them. They are never consumed,
+     * hence they can be pushed again without Keep() in consume mode.
+     */
+    SourceNode(Context& ctx, const char* label, bool recomputable = false)
+        : Super(ctx, label, { /* parent_ids */ }, { /* parents */ }) {
+        if (recomputable)
+            Super::consume_counter_ = Super::kNeverConsume;
+    }
 
     //! SourceNodes generally do not Execute, they only PushData.
     void Execute() override { }
@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * thrill/api/top_k.hpp
+ *
+ * DIANode for selecting the k smallest items of a DIA without sorting it.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_TOP_K_HEADER
+#define THRILL_API_TOP_K_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/binary_heap.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/data/cat_stream.hpp>
+
+#include <tlx/vector_free.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DIANode which selects the k smallest items according to a comparator.
+ *
+ * In the PreOp each worker keeps its k smallest items in a bounded max-heap.
+ * The largest of these is an upper bound for the global k-th item on every
+ * worker that has k candidates, hence the minimum of these bounds is
+ * determined by an AllReduce, and only candidates not larger than it are sent
+ * to worker 0. Worker 0 selects the k smallest and outputs them in sorted
+ * order, hence the resulting DIA is located entirely on worker 0.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename CompareFunction>
+class TopKNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    //! optional upper bound (exists, value) on the global k-th smallest item
+    using Bound = std::pair<bool, ValueType>;
+
+public:
+    template <typename ParentDIA>
+    TopKNode(const ParentDIA& parent, size_t k,
+             const CompareFunction& compare_function)
+        : Super(parent.ctx(), "TopK", { parent.id() }, { parent.node() }),
+          k_(k), compare_function_(compare_function),
+          heap_(compare_function) {
+        auto pre_op_fn = [this](const ValueType& input) {
+                             PreOp(input);
+                         };
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void PreOp(const ValueType& input) {
+        if (heap_.size() < k_) {
+            heap_.emplace(input);
+        }
+        else if (k_ != 0 && compare_function_(input, heap_.top())) {
+            heap_.pop();
+            heap_.emplace(input);
+        }
+    }
+
+    void Execute() final {
+        std::vector<ValueType>& candidates = heap_.container();
+
+        // determine best upper bound of the k-th item over all workers
+        Bound bound(candidates.size() == k_ && k_ != 0,
+                    candidates.size() ? heap_.top() : ValueType());
+
+        bound = context_.net.AllReduce(
+            bound,
+            [this](const Bound& a, const Bound& b) {
+                if (!a.first) return b;
+                if (!b.first) return a;
+                return compare_function_(b.second, a.second) ? b : a;
+            });
+
+        // send only candidates not larger than the bound to worker 0
+        data::CatStreamPtr stream = context_.GetNewCatStream(this);
+        data::CatStream::Writers writers = stream->GetWriters();
+
+        size_t sent = 0;
+        for (const ValueType& v : candidates) {
+            if (bound.first && compare_function_(bound.second, v)) continue;
+            writers[0].Put(v);
+            ++sent;
+        }
+        writers.clear();
+        tlx::vector_free(candidates);
+
+        sLOG << "TopKNode::Execute() sent" << sent << "candidates";
+
+        auto reader = stream->GetCatReader(/* consume */ true);
+        while (reader.HasNext())
+            result_.emplace_back(reader.template Next<ValueType>());
+        stream.reset();
+
+        if (result_.size() > k_) {
+            std::nth_element(result_.begin(), result_.begin() + k_,
+                             result_.end(), compare_function_);
+            result_.resize(k_);
+        }
+        std::sort(result_.begin(), result_.end(), compare_function_);
+    }
+
+    void PushData(bool consume) final {
+        for (const ValueType& v : result_)
+            this->PushItem(v);
+        if (consume)
+            tlx::vector_free(result_);
+    }
+
+    void Dispose() final {
+        tlx::vector_free(result_);
+    }
+
+private:
+    //! number of items to select
+    size_t k_;
+    //! comparator defining the order
+    CompareFunction compare_function_;
+    //! local k smallest items
+    common::BinaryHeap<ValueType, CompareFunction> heap_;
+    //! selected items on worker 0
+    std::vector<ValueType> result_;
+};
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+auto DIA<ValueType, Stack>::TopK(
+    size_t k, const CompareFunction& compare_function) const {
+    assert(IsValid());
+
+    using TopKNode = api::TopKNode<ValueType, CompareFunction>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<0> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<1> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<CompareFunction>::result_type,
+            bool>::value,
+        "CompareFunction has the wrong output type (should be bool)");
+
+    auto node = tlx::make_counting<TopKNode>(*this, k, compare_function);
+
+    return DIA<ValueType>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_TOP_K_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,257 @@
+/*******************************************************************************
+ * thrill/api/weighted_sample.hpp
+ *
+ * DOps drawing exact weighted samples and uniform samples per stratum from
+ * local reservoirs, which are merged by a single AllReduce of their keys.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_WEIGHTED_SAMPLE_HEADER
+#define THRILL_API_WEIGHTED_SAMPLE_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/reservoir_sampling.hpp>
+
+#include <tlx/vector_free.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DIANode which draws a weighted sample without replacement of up to
+ * sample_size items from each stratum of the items.
+ *
+ * In the PreOp each worker keeps one common::WeightedReservoirSampling per
+ * stratum (Algorithm A-ExpJ). As the items' random keys are independent, the
+ * global sample of a stratum consists of the sample_size largest keys of the
+ * local reservoirs. Hence the workers' candidates, consisting only of stratum,
+ * key, and a unique id, are merged by one AllReduce, which keeps the
+ * sample_size largest keys per stratum. Each worker then outputs its own
+ * selected items, and no items are shuffled.
+ *
+ * The merged candidates are replicated on all workers, hence the number of
+ * strata times sample_size must fit into RAM.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename StratumExtractor,
+          typename WeightFunction>
+class WeightedSampleNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using Stratum =
+        typename common::FunctionTraits<StratumExtractor>::result_type;
+
+    using Reservoir = common::WeightedReservoirSampling<
+        ValueType, std::mt19937_64>;
+    using Item = typename Reservoir::Item;
+
+    //! candidate of the global sample: (stratum, key, id), where the id is
+    //! my_rank + num_workers * local index.
+    using Candidate = std::tuple<Stratum, double, size_t>;
+
+public:
+    template <typename ParentDIA>
+    WeightedSampleNode(const ParentDIA& parent, const char* label,
+                       size_t sample_size,
+                       const StratumExtractor& stratum_extractor,
+                       const WeightFunction& weight_function)
+        : Super(parent.ctx(), label, { parent.id() }, { parent.node() }),
+          sample_size_(sample_size),
+          stratum_extractor_(stratum_extractor),
+          weight_function_(weight_function) {
+        auto pre_op_fn = [this](const ValueType& input) {
+                             PreOp(input);
+                         };
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void PreOp(const ValueType& input) {
+        Stratum stratum = stratum_extractor_(input);
+        auto it = strata_.lower_bound(stratum);
+        if (it == strata_.end() || strata_.key_comp()(stratum, it->first)) {
+            it = strata_.emplace_hint(
+                it, std::piecewise_construct, std::forward_as_tuple(stratum),
+                std::forward_as_tuple(sample_size_, rng_));
+        }
+        it->second.add(input, static_cast<double>(weight_function_(input)));
+    }
+
+    void Execute() final {
+        const size_t num_workers = context_.num_workers();
+
+        // collect local candidates, already ordered as the merge requires
+        std::vector<Candidate> candidates;
+        for (auto& s : strata_) {
+            std::vector<Item>& samples = s.second.samples();
+            for (Item& item : samples) {
+                candidates.emplace_back(
+                    s.first, item.first,
+                    context_.my_rank() + num_workers * local_.size());
+                local_.emplace_back(std::move(item.second));
+            }
+            tlx::vector_free(samples);
+        }
+        strata_.clear();
+        std::sort(candidates.begin(), candidates.end(), CandidateLess());
+
+        size_t num_local = local_.size();
+
+        candidates = context_.net.AllReduce(
+            candidates,
+            [this](const std::vector<Candidate>& a,
+                   const std::vector<Candidate>& b) {
+                return Merge(a, b);
+            });
+
+        // select local items, whose ids are contained in the global sample
+        selected_.assign(num_local, false);
+        for (const Candidate& c : candidates) {
+            if (std::get<2>(c) % num_workers == context_.my_rank())
+                selected_[std::get<2>(c) / num_workers] = true;
+        }
+
+        sLOG << "WeightedSampleNode::Execute() global sample"
+             << candidates.size() << "items, of which"
+             << std::count(selected_.begin(), selected_.end(), true)
+             << "of" << num_local << "local candidates";
+    }
+
+    void PushData(bool consume) final {
+        for (size_t i = 0; i < local_.size(); ++i) {
+            if (selected_[i])
+                this->PushItem(local_[i]);
+        }
+        if (consume) {
+            tlx::vector_free(local_);
+            tlx::vector_free(selected_);
+        }
+    }
+
+    void Dispose() final {
+        strata_.clear();
+        tlx::vector_free(local_);
+        tlx::vector_free(selected_);
+    }
+
+private:
+    //! number of items to sample per stratum
+    size_t sample_size_;
+    //! maps items to their stratum
+    StratumExtractor stratum_extractor_;
+    //! maps items to their weight
+    WeightFunction weight_function_;
+
+    //! random generator of the reservoirs
+    std::mt19937_64 rng_ { std::random_device { } () };
+    //! local reservoirs of the strata
+    std::map<Stratum, Reservoir> strata_;
+
+    //! local sampled items, indexed by the ids of their candidates
+    std::vector<ValueType> local_;
+    //! whether each local sampled item is in the global sample
+    std::vector<bool> selected_;
+
+    //! order candidates by stratum, then by decreasing key, then by id
+    struct CandidateLess {
+        bool operator () (const Candidate& a, const Candidate& b) const {
+            if (std::get<0>(a) < std::get<0>(b)) return true;
+            if (std::get<0>(b) < std::get<0>(a)) return false;
+            if (std::get<1>(a) != std::get<1>(b))
+                return std::get<1>(a) > std::get<1>(b);
+            return std::get<2>(a) < std::get<2>(b);
+        }
+    };
+
+    //! merge two sorted candidate lists, keeping sample_size_ per stratum
+    std::vector<Candidate> Merge(const std::vector<Candidate>& a,
+                                 const std::vector<Candidate>& b) const {
+        std::vector<Candidate> merged;
+        merged.reserve(a.size() + b.size());
+        std::merge(a.begin(), a.end(), b.begin(), b.end(),
+                   std::back_inserter(merged), CandidateLess());
+
+        std::vector<Candidate> out;
+        out.reserve(merged.size());
+        size_t count = 0;
+        for (size_t i = 0; i < merged.size(); ++i) {
+            if (i == 0 || std::get<0>(merged[i - 1]) < std::get<0>(merged[i]))
+                count = 0;
+            if (count++ < sample_size_)
+                out.emplace_back(merged[i]);
+        }
+        return out;
+    }
+};
+
+template <typename ValueType, typename Stack>
+template <typename WeightFunction>
+auto DIA<ValueType, Stack>::WeightedSample(
+    size_t sample_size, const WeightFunction& weight_function) const {
+    assert(IsValid());
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<WeightFunction>::template arg<0> >::value,
+        "WeightFunction has the wrong input type");
+
+    auto single_stratum = [](const ValueType&) { return size_t(0); };
+
+    using WeightedSampleNode = api::WeightedSampleNode<
+        ValueType, decltype(single_stratum), WeightFunction>;
+
+    auto node = tlx::make_counting<WeightedSampleNode>(
+        *this, "WeightedSample", sample_size, single_stratum, weight_function);
+
+    return DIA<ValueType>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor>
+auto DIA<ValueType, Stack>::StratifiedSample(
+    const KeyExtractor& key_extractor, size_t sample_size) const {
+    assert(IsValid());
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0> >::value,
+        "KeyExtractor has the wrong input type");
+
+    auto unit_weight = [](const ValueType&) { return 1.0; };
+
+    using WeightedSampleNode = api::WeightedSampleNode<
+        ValueType, KeyExtractor, decltype(unit_weight)>;
+
+    auto node = tlx::make_counting<WeightedSampleNode>(
+        *this, "StratifiedSample", sample_size, key_extractor, unit_weight);
+
+    return DIA<ValueType>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_WEIGHTED_SAMPLE_HEADER
+
+/******************************************************************************/
@@ -18,6 +18,8 @@
 #include <thrill/common/ring_buffer.hpp>
 #include <thrill/data/file.hpp>
 
+#include <tlx/vector_free.hpp>
+
 #include <algorithm>
 #include <vector>
 
@@ -113,6 +115,27 @@ public:
     }
 
 protected:
+    //! Collectively calculate first_rank_ and receive the last k - 1 items of
+    //! the preceding workers, which are returned.
+    std::vector<Input> ReceivePredecessors() {
+        // get rank of our first element
+        first_rank_ = context_.net.ExPrefixSum(file_.num_items());
+
+        // copy our last elements into a vector
+        std::vector<Input> my_last;
+        my_last.reserve(window_size_ - 1);
+
+        assert(window_.size() < window_size_);
+        window_.move_to(&my_last);
+
+        // collective operation: get k - 1 predecessors
+        std::vector<Input> pre =
+            context_.net.Predecessor(window_size_ - 1, my_last);
+
+        assert(pre.size() == std::min(window_size_ - 1, first_rank_));
+        return pre;
+    }
+
     //! Whether the parent stack is empty
     const bool parent_stack_empty_;
     //! Size k of the window
@@ -162,27 +185,13 @@ public:
     //! Executes the window operation by receiving k - 1 items from our
     //! preceding worker.
     void Execute() final {
-        // get rank of our first element
-        first_rank_ = context_.net.ExPrefixSum(file_.num_items());
-
-        // copy our last elements into a vector
-        std::vector<Input> my_last;
-        my_last.reserve(window_size_ - 1);
-
-        assert(window_.size() < window_size_);
-        window_.move_to(&my_last);
-
-        // collective operation: get k - 1 predecessors
-        std::vector<Input> pre =
-            context_.net.Predecessor(window_size_ - 1, my_last);
+        std::vector<Input> pre = Super::ReceivePredecessors();
 
         sLOG << "Window::MainOp()"
              << "first_rank_" << first_rank_
              << "window_size_" << window_size_
              << "pre.size()" << pre.size();
 
-        assert(pre.size() == std::min(window_size_ - 1, first_rank_));
-
         // put k - 1 predecessors back into window_
         for (size_t i = 0; i < pre.size(); ++i)
             window_.push_back(pre[i]);
@@ -381,6 +390,148 @@ auto DIA<ValueType, Stack>::Window(
 
 /******************************************************************************/
 
+/*!
+ * A DIANode which reduces every k consecutive items with an associative
+ * reduce function, in O(1) amortized time per item, instead of passing each
+ * window to a user function. The window items are kept in a queue implemented
+ * by two stacks: new items are pushed onto the back stack, of which the reduced
+ * value is kept, while the front stack holds the reduced values of all its
+ * suffixes. When the front stack runs empty, the back stack is moved over to
+ * it. Hence each item is combined at most three times. The reduce function
+ * need not be commutative.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename ReduceFunction>
+class WindowReduceNode final
+    : public BaseWindowNode<
+          ValueType, ValueType, ReduceFunction, ReduceFunction>
+{
+    using Super = BaseWindowNode<
+        ValueType, ValueType, ReduceFunction, ReduceFunction>;
+    using Super::debug;
+    using Super::context_;
+
+public:
+    template <typename ParentDIA>
+    WindowReduceNode(const ParentDIA& parent,
+                     const char* label, size_t window_size,
+                     const ReduceFunction& reduce_function)
+        : Super(parent, label, window_size,
+                reduce_function, reduce_function) { }
+
+    //! Executes the window operation by receiving k - 1 items from our
+    //! preceding worker.
+    void Execute() final {
+        std::vector<ValueType> pre = Super::ReceivePredecessors();
+
+        sLOG << "WindowReduce::MainOp()"
+             << "first_rank_" << first_rank_
+             << "window_size_" << window_size_
+             << "pre.size()" << pre.size();
+
+        for (size_t i = 0; i < pre.size(); ++i)
+            window_.push_back(pre[i]);
+    }
+
+    void PushData(bool consume) final {
+        data::File::Reader reader = file_.GetReader(consume);
+
+        // initialize the queue with the k - 1 predecessors
+        std::vector<ValueType> window;
+        window.reserve(window_size_);
+        window_.copy_to(&window);
+
+        front_.clear();
+        back_.clear();
+        for (const ValueType& v : window)
+            Push(v);
+        tlx::vector_free(window);
+
+        size_t num_items = file_.num_items();
+        for (size_t i = 0; i < num_items; ++i) {
+            Push(reader.template Next<ValueType>());
+
+            // only issue full window frames
+            if (front_.size() + back_.size() != window_size_) continue;
+
+            this->PushItem(Query());
+            Pop();
+        }
+
+        tlx::vector_free(front_);
+        tlx::vector_free(back_);
+    }
+
+private:
+    using Super::file_;
+    using Super::first_rank_;
+    using Super::window_;
+    using Super::window_size_;
+    using Super::window_function_;
+
+    //! suffix reductions of the older items, the top is the oldest item.
+    std::vector<ValueType> front_;
+    //! the newer items
+    std::vector<ValueType> back_;
+    //! reduction of all items in back_
+    ValueType back_sum_;
+
+    void Push(const ValueType& v) {
+        back_sum_ = back_.empty() ? v : window_function_(back_sum_, v);
+        back_.push_back(v);
+    }
+
+    void Pop() {
+        if (front_.empty()) {
+            // move back_ onto front_, calculating suffix reductions
+            for (size_t i = back_.size(); i != 0; --i) {
+                front_.push_back(
+                    front_.empty() ? back_[i - 1]
+                    : window_function_(back_[i - 1], front_.back()));
+            }
+            back_.clear();
+        }
+        front_.pop_back();
+    }
+
+    ValueType Query() {
+        if (front_.empty()) return back_sum_;
+        if (back_.empty()) return front_.back();
+        return window_function_(front_.back(), back_sum_);
+    }
+};
+
+template <typename ValueType, typename Stack>
+template <typename ReduceFunction>
+auto DIA<ValueType, Stack>::WindowReduce(
+    size_t window_size, const ReduceFunction& reduce_function) const {
+    assert(IsValid());
+    assert(window_size >= 2);
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<ReduceFunction>::template arg<0>
+            >::value,
+        "ReduceFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<ReduceFunction>::result_type,
+            ValueType>::value,
+        "ReduceFunction has the wrong output type");
+
+    using WindowNode = api::WindowReduceNode<ValueType, ReduceFunction>;
+
+    auto node = tlx::make_counting<WindowNode>(
+        *this, "WindowReduce", window_size, reduce_function);
+
+    return DIA<ValueType>(node);
+}
+
+/******************************************************************************/
+
 /*!
  * \ingroup api_layer
  */
@@ -409,21 +560,7 @@ public:
     //! Executes the window operation by receiving k - 1 items from our
     //! preceding worker.
     void Execute() final {
-        // get rank of our first element
-        first_rank_ = context_.net.ExPrefixSum(file_.num_items());
-
-        // copy our last elements into a vector
-        std::vector<Input> my_last;
-        my_last.reserve(window_size_ - 1);
-
-        assert(window_.size() < window_size_);
-        window_.move_to(&my_last);
-
-        // collective operation: get k - 1 predecessors
-        std::vector<Input> pre =
-            context_.net.Predecessor(window_size_ - 1, my_last);
-
-        assert(pre.size() == std::min(window_size_ - 1, first_rank_));
+        std::vector<Input> pre = Super::ReceivePredecessors();
 
         // calculate how many (up to  k - 1) predecessors to put into window_
 
@@ -0,0 +1,219 @@
+/*******************************************************************************
+ * thrill/api/write_arrow_stream.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_WRITE_ARROW_STREAM_HEADER
+#define THRILL_API_WRITE_ARROW_STREAM_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/arrow_format.hpp>
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/vfs/file_io.hpp>
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+template <typename ValueType>
+class WriteArrowStreamNode
+{
+    static_assert(sizeof(ValueType) == 0,
+                  "WriteArrowStream: DIA items must be std::tuple<Columns...>");
+};
+
+/*!
+ * Action node writing a DIA of tuples as one Arrow IPC stream per worker. The
+ * rows are collected column-wise into record batches of batch_size rows, whose
+ * column buffers are written as they are. Every worker writes a stream, even
+ * if it has no items, such that consumers of all streams terminate. See
+ * arrow_format.hpp for the layout.
+ *
+ * \ingroup api_layer
+ */
+template <typename... Columns>
+class WriteArrowStreamNode<std::tuple<Columns...> > final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+public:
+    using Super = ActionNode;
+    using Super::context_;
+
+    using ValueType = std::tuple<Columns...>;
+
+    //! number of columns
+    static constexpr size_t num_columns = sizeof ... (Columns);
+
+    template <typename ParentDIA>
+    WriteArrowStreamNode(const ParentDIA& parent,
+                         const std::string& path_out,
+                         const std::vector<std::string>& column_names,
+                         size_t batch_size)
+        : ActionNode(parent.ctx(), "WriteArrowStream",
+                     { parent.id() }, { parent.node() }),
+          out_pathbase_(path_out),
+          column_names_(column_names),
+          batch_size_(std::max<size_t>(batch_size, 1)) {
+        sLOG << "Creating write node.";
+
+        if (column_names_.empty()) {
+            for (size_t i = 0; i < num_columns; ++i)
+                column_names_.emplace_back("f" + std::to_string(i));
+        }
+        if (column_names_.size() != num_columns) {
+            die("WriteArrowStream: " << column_names_.size() << " column "
+                "names given for a tuple with " << num_columns << " fields");
+        }
+
+        auto pre_op_fn = [=](const ValueType& input) {
+                             return PreOp(input);
+                         };
+        // close the function stack with our pre op and register it at parent
+        // node for output
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    DIAMemUse PreOpMemUse() final {
+        // one record batch is buffered column-wise and once more encoded
+        return 2 * batch_size_ * sizeof(ValueType);
+    }
+
+    //! writer preop: distribute fields to the column buffers.
+    void PreOp(const ValueType& input) {
+        stats_total_elements_++;
+
+        if (!stream_) OpenStream();
+
+        PushRow(input, std::index_sequence_for<Columns...>());
+
+        if (++batch_rows_ >= batch_size_)
+            FlushBatch();
+    }
+
+    //! Flushes the last record batch and writes the end-of-stream marker.
+    void StopPreOp(size_t /* parent_index */) final {
+        if (!stream_) OpenStream();
+        if (batch_rows_ != 0) FlushBatch();
+
+        stream_->write(arrow_end_of_stream, sizeof(arrow_end_of_stream));
+        stream_->close();
+        stream_.reset();
+
+        Super::logger_
+            << "class" << "WriteArrowStreamNode"
+            << "total_elements" << stats_total_elements_
+            << "total_batches" << stats_total_batches_;
+    }
+
+    void Execute() final { }
+
+private:
+    //! Base path of the output file.
+    std::string out_pathbase_;
+
+    //! Names of the columns in the schema
+    std::vector<std::string> column_names_;
+
+    //! Number of rows in a record batch
+    size_t batch_size_;
+
+    //! output stream, opened with the first item
+    vfs::WriteStreamPtr stream_;
+
+    //! column buffers of the current record batch
+    std::tuple<std::vector<Columns>...> columns_;
+
+    //! number of rows in the current record batch
+    size_t batch_rows_ = 0;
+
+    size_t stats_total_elements_ = 0;
+    size_t stats_total_batches_ = 0;
+
+    void OpenStream() {
+        // construct path from pattern containing ### and $$$
+        std::string out_path = vfs::FillFilePattern(
+            out_pathbase_, context_.my_rank(), 0);
+
+        sLOG << "OpenStream() out_path" << out_path;
+
+        stream_ = vfs::OpenWriteStream(out_path);
+
+        std::string schema = ArrowSchemaMessage<Columns...>(column_names_);
+        stream_->write(schema.data(), schema.size());
+    }
+
+    template <size_t... Is>
+    void PushRow(const ValueType& t, std::index_sequence<Is...>) {
+        int dummy[] = {
+            (std::get<Is>(columns_).push_back(std::get<Is>(t)), 0) ...
+        };
+        (void)dummy;
+    }
+
+    //! append the buffers of each column to the body
+    template <size_t... Is>
+    void EncodeColumns(ArrowBody& body, std::index_sequence<Is...>) {
+        int dummy[] = {
+            (ArrowColumnTraits<Columns>::Encode(std::get<Is>(columns_), body),
+             std::get<Is>(columns_).clear(), 0) ...
+        };
+        (void)dummy;
+    }
+
+    void FlushBatch() {
+        ArrowBody body;
+        EncodeColumns(body, std::index_sequence_for<Columns...>());
+
+        std::string message = ArrowRecordBatchMessage(batch_rows_, body);
+        stream_->write(message.data(), message.size());
+        stream_->write(body.data.data(), body.data.size());
+
+        batch_rows_ = 0;
+        stats_total_batches_++;
+    }
+};
+
+template <typename ValueType, typename Stack>
+void DIA<ValueType, Stack>::WriteArrowStream(
+    const std::string& filepath, const std::vector<std::string>& column_names,
+    size_t batch_size) const {
+
+    using WriteArrowStreamNode = api::WriteArrowStreamNode<ValueType>;
+
+    auto node = tlx::make_counting<WriteArrowStreamNode>(
+        *this, filepath, column_names, batch_size);
+
+    node->RunScope();
+}
+
+template <typename ValueType, typename Stack>
+Future<void> DIA<ValueType, Stack>::WriteArrowStreamFuture(
+    const std::string& filepath, const std::vector<std::string>& column_names,
+    size_t batch_size) const {
+
+    using WriteArrowStreamNode = api::WriteArrowStreamNode<ValueType>;
+
+    auto node = tlx::make_counting<WriteArrowStreamNode>(
+        *this, filepath, column_names, batch_size);
+
+    return Future<void>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_WRITE_ARROW_STREAM_HEADER
+
+/******************************************************************************/
@@ -14,6 +14,7 @@
 #define THRILL_API_WRITE_BINARY_HEADER
 
 #include <thrill/api/action_node.hpp>
+#include <thrill/api/binary_index.hpp>
 #include <thrill/api/context.hpp>
 #include <thrill/api/dia.hpp>
 #include <thrill/common/string.hpp>
@@ -44,11 +45,12 @@ public:
     template <typename ParentDIA>
     WriteBinaryNode(const ParentDIA& parent,
                     const std::string& path_out,
-                    size_t max_file_size)
+                    size_t max_file_size, bool block_index)
         : ActionNode(parent.ctx(), "WriteBinary",
                      { parent.id() }, { parent.node() }),
           out_pathbase_(path_out),
-          max_file_size_(max_file_size) {
+          max_file_size_(max_file_size),
+          block_index_(block_index) {
         sLOG << "Creating write node.";
 
         block_size_ = std::min(data::default_block_size,
@@ -113,11 +115,13 @@ private:
         SysFileSink(api::Context& context,
                     size_t local_worker_id,
                     const std::string& path, size_t max_file_size,
+                    bool block_index,
                     size_t& stats_total_elements,
                     size_t& stats_total_writes)
             : BlockSink(context.block_pool(), local_worker_id),
               BoundedBlockSink(context.block_pool(), local_worker_id, max_file_size),
               stream_(vfs::OpenWriteStream(path)),
+              block_index_(block_index),
               stats_total_elements_(stats_total_elements),
               stats_total_writes_(stats_total_writes) { }
 
@@ -126,6 +130,8 @@ private:
             sLOG << "SysFileSink::AppendBlock()" << b;
             stats_total_writes_++;
             stream_->write(b.data_begin(), b.size());
+            if (block_index_)
+                index_.Add(b.size(), b.first_item_relative(), b.num_items());
         }
 
         void AppendBlock(const data::Block& block, bool is_last_block) {
@@ -139,11 +145,16 @@ private:
         }
 
         void Close() final {
+            if (block_index_)
+                index_.Write(*stream_);
             stream_->close();
         }
 
     private:
         vfs::WriteStreamPtr stream_;
+        //! whether to append a BinaryBlockIndex
+        bool block_index_;
+        BinaryBlockIndex index_;
         size_t& stats_total_elements_;
         size_t& stats_total_writes_;
     };
@@ -159,6 +170,9 @@ private:
     //! Maximum file size
     size_t max_file_size_;
 
+    //! Whether to append a block index to the files
+    bool block_index_;
+
     //! Block size used by BlockWriter
     size_t block_size_ = data::default_block_size;
 
@@ -181,7 +195,7 @@ private:
         writer_ = std::make_unique<Writer>(
             SysFileSink(
                 context_, context_.local_worker_id(),
-                out_path, max_file_size_,
+                out_path, max_file_size_, block_index_,
                 stats_total_elements_, stats_total_writes_),
             block_size_);
     }
@@ -189,24 +203,26 @@ private:
 
 template <typename ValueType, typename Stack>
 void DIA<ValueType, Stack>::WriteBinary(
-    const std::string& filepath, size_t max_file_size) const {
+    const std::string& filepath, size_t max_file_size,
+    bool block_index) const {
 
     using WriteBinaryNode = api::WriteBinaryNode<ValueType>;
 
     auto node = tlx::make_counting<WriteBinaryNode>(
-        *this, filepath, max_file_size);
+        *this, filepath, max_file_size, block_index);
 
     node->RunScope();
 }
 
 template <typename ValueType, typename Stack>
 Future<void> DIA<ValueType, Stack>::WriteBinaryFuture(
-    const std::string& filepath, size_t max_file_size) const {
+    const std::string& filepath, size_t max_file_size,
+    bool block_index) const {
 
     using WriteBinaryNode = api::WriteBinaryNode<ValueType>;
 
     auto node = tlx::make_counting<WriteBinaryNode>(
-        *this, filepath, max_file_size);
+        *this, filepath, max_file_size, block_index);
 
     return Future<void>(node);
 }
@@ -0,0 +1,225 @@
+/*******************************************************************************
+ * thrill/api/write_columnar.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_WRITE_COLUMNAR_HEADER
+#define THRILL_API_WRITE_COLUMNAR_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/columnar_format.hpp>
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/net/buffer_builder.hpp>
+#include <thrill/vfs/file_io.hpp>
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+template <typename ValueType>
+class WriteColumnarNode
+{
+    static_assert(sizeof(ValueType) == 0,
+                  "WriteColumnar: DIA items must be std::tuple<Columns...>");
+};
+
+/*!
+ * Action node writing a DIA of tuples into one columnar file per worker. The
+ * rows are collected column-wise into row groups of row_group_size rows, which
+ * are written with min/max statistics per column chunk. See
+ * columnar_format.hpp for the layout.
+ *
+ * \ingroup api_layer
+ */
+template <typename... Columns>
+class WriteColumnarNode<std::tuple<Columns...> > final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+public:
+    using Super = ActionNode;
+    using Super::context_;
+
+    using ValueType = std::tuple<Columns...>;
+
+    //! number of columns
+    static constexpr size_t num_columns = sizeof ... (Columns);
+
+    template <typename ParentDIA>
+    WriteColumnarNode(const ParentDIA& parent,
+                      const std::string& path_out,
+                      size_t row_group_size)
+        : ActionNode(parent.ctx(), "WriteColumnar",
+                     { parent.id() }, { parent.node() }),
+          out_pathbase_(path_out),
+          row_group_size_(std::max<size_t>(row_group_size, 1)) {
+        sLOG << "Creating write node.";
+
+        auto pre_op_fn = [=](const ValueType& input) {
+                             return PreOp(input);
+                         };
+        // close the function stack with our pre op and register it at parent
+        // node for output
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    DIAMemUse PreOpMemUse() final {
+        // one row group is buffered column-wise and once more encoded
+        return 2 * row_group_size_ * sizeof(ValueType);
+    }
+
+    //! writer preop: distribute fields to the column buffers.
+    void PreOp(const ValueType& input) {
+        stats_total_elements_++;
+
+        if (!stream_) OpenFile();
+
+        PushRow(input, std::index_sequence_for<Columns...>());
+
+        if (++group_rows_ >= row_group_size_)
+            FlushRowGroup();
+    }
+
+    //! Flushes the last row group and writes the footer.
+    void StopPreOp(size_t /* parent_index */) final {
+        if (stream_) {
+            if (group_rows_ != 0) FlushRowGroup();
+
+            net::BufferBuilder bb;
+            footer_.Serialize(bb);
+            uint64_t footer_size = bb.size();
+            bb.Put<uint64_t>(footer_size);
+            bb.Append(columnar_magic, sizeof(columnar_magic));
+            stream_->write(bb.data(), bb.size());
+            stream_->close();
+            stream_.reset();
+        }
+
+        Super::logger_
+            << "class" << "WriteColumnarNode"
+            << "total_elements" << stats_total_elements_
+            << "total_row_groups" << footer_.row_groups.size();
+    }
+
+    void Execute() final { }
+
+private:
+    //! Base path of the output file.
+    std::string out_pathbase_;
+
+    //! Number of rows in a row group
+    size_t row_group_size_;
+
+    //! output stream, opened with the first item
+    vfs::WriteStreamPtr stream_;
+
+    //! column buffers of the current row group
+    std::tuple<std::vector<Columns>...> columns_;
+
+    //! number of rows in the current row group
+    size_t group_rows_ = 0;
+
+    //! bytes written to stream_
+    uint64_t file_offset_ = 0;
+
+    //! footer collected while writing
+    ColumnarFooter footer_;
+
+    size_t stats_total_elements_ = 0;
+
+    void OpenFile() {
+        // construct path from pattern containing ### and $$$
+        std::string out_path = vfs::FillFilePattern(
+            out_pathbase_, context_.my_rank(), 0);
+
+        sLOG << "OpenFile() out_path" << out_path;
+
+        stream_ = vfs::OpenWriteStream(out_path);
+        footer_.types = { ColumnTraits<Columns>::type_code ... };
+    }
+
+    template <size_t... Is>
+    void PushRow(const ValueType& t, std::index_sequence<Is...>) {
+        int dummy[] = {
+            (std::get<Is>(columns_).push_back(std::get<Is>(t)), 0) ...
+        };
+        (void)dummy;
+    }
+
+    //! encode each column chunk of the row group and record its statistics
+    template <size_t... Is>
+    void WriteColumns(RowGroupInfo& rg, std::index_sequence<Is...>) {
+        int dummy[] = {
+            (WriteColumn(std::get<Is>(columns_), rg.columns[Is]), 0) ...
+        };
+        (void)dummy;
+    }
+
+    template <typename Type>
+    void WriteColumn(std::vector<Type>& column, ColumnChunkInfo& info) {
+        auto minmax = std::minmax_element(column.begin(), column.end());
+        info.min = ColumnTraits<Type>::EncodeValue(*minmax.first);
+        info.max = ColumnTraits<Type>::EncodeValue(*minmax.second);
+
+        net::BufferBuilder bb;
+        ColumnTraits<Type>::Encode(column, bb);
+        stream_->write(bb.data(), bb.size());
+
+        info.offset = file_offset_;
+        info.size = bb.size();
+        file_offset_ += bb.size();
+
+        column.clear();
+    }
+
+    void FlushRowGroup() {
+        RowGroupInfo rg;
+        rg.num_rows = group_rows_;
+        rg.columns.resize(num_columns);
+        WriteColumns(rg, std::index_sequence_for<Columns...>());
+        footer_.row_groups.emplace_back(std::move(rg));
+        group_rows_ = 0;
+    }
+};
+
+template <typename ValueType, typename Stack>
+void DIA<ValueType, Stack>::WriteColumnar(
+    const std::string& filepath, size_t row_group_size) const {
+
+    using WriteColumnarNode = api::WriteColumnarNode<ValueType>;
+
+    auto node = tlx::make_counting<WriteColumnarNode>(
+        *this, filepath, row_group_size);
+
+    node->RunScope();
+}
+
+template <typename ValueType, typename Stack>
+Future<void> DIA<ValueType, Stack>::WriteColumnarFuture(
+    const std::string& filepath, size_t row_group_size) const {
+
+    using WriteColumnarNode = api::WriteColumnarNode<ValueType>;
+
+    auto node = tlx::make_counting<WriteColumnarNode>(
+        *this, filepath, row_group_size);
+
+    return Future<void>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_WRITE_COLUMNAR_HEADER
+
+/******************************************************************************/
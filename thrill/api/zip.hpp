@@ -254,6 +254,89 @@ private:
         ZipNode* node_;
     };
 
+    //! maximum ratio of the largest part of an input's current distribution
+    //! to the balanced part, such that it may be kept as target distribution.
+    static constexpr double aligned_max_imbalance_ = 1.25;
+
+    //! target item ranks of the workers: worker i receives items [cuts_[i],
+    //! cuts_[i+1]) of all inputs. Empty if the items are balanced.
+    std::vector<size_t> cuts_;
+
+    //! balanced cut of worker i
+    size_t BalancedCut(size_t i) const {
+        double per_pe = static_cast<double>(result_size_)
+                        / static_cast<double>(context_.num_workers());
+        return static_cast<size_t>(std::ceil(i * per_pe));
+    }
+
+    /*!
+     * Select the target distribution: the current distribution of one of the
+     * inputs, if that moves fewer items than balancing all inputs and is not
+     * too imbalanced, e.g. if the inputs are almost aligned. Then only the
+     * items at the misaligned boundaries are sent to other workers.
+     */
+    void SelectTargetDistribution() {
+        using ArraySizeT1 = std::array<size_t, kNumInputs + 1>;
+
+        const size_t workers = context_.num_workers();
+        const size_t rank = context_.my_rank();
+
+        // range of local items in each input, and target ranges: those of
+        // each input, the last worker takes the remaining items.
+        ArraySizeT1 begin, end;
+        for (size_t i = 0; i < kNumInputs; ++i) {
+            begin[i] = std::min(result_size_, size_prefixsum_[i]);
+            end[i] = std::min(
+                result_size_, size_prefixsum_[i] + files_[i].num_items());
+        }
+        begin[kNumInputs] = BalancedCut(rank);
+        end[kNumInputs] = BalancedCut(rank + 1);
+
+        ArraySizeT1 kept, max_part;
+        for (size_t c = 0; c <= kNumInputs; ++c) {
+            size_t target_begin = begin[c];
+            size_t target_end = (rank + 1 == workers) ? result_size_ : end[c];
+
+            // number of local items which remain on this worker
+            kept[c] = 0;
+            for (size_t i = 0; i < kNumInputs; ++i) {
+                size_t lo = std::max(begin[i], target_begin);
+                size_t hi = std::min(end[i], target_end);
+                if (lo < hi) kept[c] += hi - lo;
+            }
+            max_part[c] = target_end - std::min(target_begin, target_end);
+        }
+
+        kept = context_.net.AllReduce(kept, common::ComponentSum<ArraySizeT1>());
+        max_part = context_.net.AllReduce(
+            max_part,
+            common::ComponentSum<ArraySizeT1, common::maximum<size_t> >());
+
+        size_t best = kNumInputs;
+        double max_allowed =
+            aligned_max_imbalance_ * static_cast<double>(max_part[kNumInputs]);
+        for (size_t c = 0; c < kNumInputs; ++c) {
+            if (static_cast<double>(max_part[c]) <= max_allowed &&
+                kept[c] > kept[best])
+                best = c;
+        }
+
+        sLOGC(rank == 0)
+            << "Zip(): target distribution" << best
+            << "keeps" << kept[best] << "of" << kNumInputs * result_size_
+            << "items local, balanced keeps" << kept[kNumInputs];
+
+        if (best != kNumInputs) {
+            // collect the begin of input best on all workers
+            std::vector<size_t> cuts(workers + 1, 0);
+            cuts[rank] = begin[best];
+            cuts = context_.net.AllReduce(
+                cuts, common::ComponentSum<std::vector<size_t> >());
+            cuts[workers] = result_size_;
+            cuts_ = std::move(cuts);
+        }
+    }
+
     //! Scatter items from DIA "Index" to other workers if necessary.
     template <size_t Index>
     void DoScatter() {
@@ -264,21 +347,17 @@ private:
         size_t local_end = std::min(
             result_size_, size_prefixsum_[Index] + files_[Index].num_items());
 
-        // number of elements per worker (double)
-        double per_pe =
-            static_cast<double>(result_size_) / static_cast<double>(workers);
         // offsets for scattering
         std::vector<size_t> offsets(workers + 1, 0);
 
         for (size_t i = 0; i <= workers; ++i) {
             // calculate range we have to send to each PE
-            size_t cut = static_cast<size_t>(std::ceil(i * per_pe));
+            size_t cut = cuts_.empty() ? BalancedCut(i) : cuts_[i];
             offsets[i] =
                 cut < local_begin ? 0 : std::min(cut, local_end) - local_begin;
         }
 
-        LOG << "per_pe=" << per_pe
-            << " offsets[" << Index << "] = " << offsets;
+        LOG << "offsets[" << Index << "] = " << offsets;
 
         // target stream id
         streams_[Index] = context_.GetNewCatStream(this);
@@ -342,6 +421,8 @@ private:
 
         if (result_size_ == 0) return;
 
+        SelectTargetDistribution();
+
         // perform scatters to exchange data, with different types.
         tlx::call_for_range<kNumInputs>(
             [=](auto index) {
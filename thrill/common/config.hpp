@@ -47,10 +47,22 @@ static constexpr bool g_debug_push_file = false;
 #define THRILL_HAVE_NET_TCP 1
 #endif
 
+#if !defined(_MSC_VER)
+#define THRILL_HAVE_NET_SHM 1
+#endif
+
 #if __linux__
 #define THRILL_HAVE_LINUXAIO_FILE 1
 #endif
 
+#if __linux__
+#define THRILL_HAVE_NET_EPOLL 1
+#endif
+
+#if __linux__
+#define THRILL_HAVE_NET_ZEROCOPY 1
+#endif
+
 #if defined(_MSC_VER)
 #define THRILL_WINDOWS 1
 #define THRILL_MSVC 1
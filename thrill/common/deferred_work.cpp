@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * thrill/common/deferred_work.cpp
+ *
+ * Per-thread queue of local work, which a worker runs instead of blocking in
+ * collectives, stream queues and pin requests.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/deferred_work.hpp>
+
+#include <deque>
+#include <utility>
+
+namespace thrill {
+namespace common {
+
+namespace {
+
+//! queue and reentrancy flag of a thread
+struct ThreadQueue {
+    std::deque<DeferredWork::Function> queue;
+    bool running = false;
+};
+
+ThreadQueue& LocalQueue() {
+    static thread_local ThreadQueue s_queue;
+    return s_queue;
+}
+
+} // namespace
+
+void DeferredWork::Post(Function&& f) {
+    LocalQueue().queue.emplace_back(std::move(f));
+}
+
+bool DeferredWork::RunOne() {
+    ThreadQueue& q = LocalQueue();
+    if (q.running || q.queue.empty()) return false;
+
+    Function f = std::move(q.queue.front());
+    q.queue.pop_front();
+
+    q.running = true;
+    try {
+        f();
+    }
+    catch (...) {
+        q.running = false;
+        throw;
+    }
+    q.running = false;
+    return true;
+}
+
+void DeferredWork::RunAll() {
+    while (RunOne()) { }
+}
+
+size_t DeferredWork::size() {
+    return LocalQueue().queue.size();
+}
+
+bool DeferredWork::running() {
+    return LocalQueue().running;
+}
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * thrill/common/deferred_work.hpp
+ *
+ * Per-thread queue of local work, which a worker runs instead of blocking in
+ * collectives, stream queues and pin requests.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_DEFERRED_WORK_HEADER
+#define THRILL_COMMON_DEFERRED_WORK_HEADER
+
+#include <cstddef>
+#include <functional>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * Queue of deferred work of the calling thread. A worker posts work which is
+ * not needed right away, e.g. Sort posts sorting and writing a full run while
+ * it receives the next one. When the worker would block waiting in a
+ * FlowControlChannel collective, on a stream's BlockQueue or on a PinRequest,
+ * it runs the queued work first, and only blocks once the queue is empty.
+ * Thereby waits on network or disk are overlapped with computation of the same
+ * worker, without further threads.
+ *
+ * Work is run to completion in FIFO order. It must be local: it must not enter
+ * collectives or read streams, since the workers would run it at different
+ * points. Waits inside running work block normally and do not run further
+ * work. All remaining work is run by RunAll(), which a worker must call before
+ * depending on the results.
+ */
+class DeferredWork
+{
+public:
+    using Function = std::function<void()>;
+
+    //! append work to the calling thread's queue
+    static void Post(Function&& f);
+
+    //! Run the first queued work of the calling thread, unless the thread is
+    //! already running deferred work. Returns true if work was run.
+    static bool RunOne();
+
+    //! run all queued work of the calling thread, including work posted by it.
+    static void RunAll();
+
+    //! number of queued works of the calling thread
+    static size_t size();
+
+    //! whether the calling thread is running deferred work, in which waits
+    //! block and further work posted is only run by a later RunAll().
+    static bool running();
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_DEFERRED_WORK_HEADER
+
+/******************************************************************************/
@@ -54,6 +54,19 @@ template <typename T>
 using is_trivially_copyable = std::is_trivially_copyable<T>;
 #endif
 
+/******************************************************************************/
+// prefetching
+
+//! Prefetches the cache line containing ptr for writing, e.g. the slot of an
+//! item which is inserted soon. No-op if __builtin_prefetch is unavailable.
+static inline void PrefetchWrite(const void* ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr, /* rw */ 1, /* locality */ 3);
+#else
+    (void)ptr;
+#endif
+}
+
 } // namespace common
 } // namespace thrill
 
@@ -88,6 +88,15 @@ inline auto MapVector(const std::vector<Type>& input, const Functor& f)
 
 /******************************************************************************/
 
+//! Combine the n components of b into a with op, in place. The plain loop is
+//! vectorized by the compiler for arithmetic types with inlined operations like
+//! std::plus, common::minimum, and common::maximum.
+template <typename Type, typename Operation>
+static inline void AccumulateComponents(
+    Type* a, const Type* b, size_t n, const Operation& op) {
+    for (size_t i = 0; i < n; ++i) a[i] = op(a[i], b[i]);
+}
+
 //! template for computing the component-wise sum of std::array or std::vector.
 template <typename ArrayType,
           typename Operation = std::plus<typename ArrayType::value_type> >
@@ -103,10 +112,14 @@ public:
     using ArrayType = std::array<Type, N>;
     explicit ComponentSum(const Operation& op = Operation()) : op_(op) { }
     ArrayType operator () (const ArrayType& a, const ArrayType& b) const {
-        ArrayType out;
-        for (size_t i = 0; i < N; ++i) out[i] = op_(a[i], b[i]);
+        ArrayType out = a;
+        Accumulate(out, b);
         return out;
     }
+    //! combine b into a in place, a = op(a, b) component-wise.
+    void Accumulate(ArrayType& a, const ArrayType& b) const {
+        AccumulateComponents(a.data(), b.data(), N, op_);
+    }
 
 private:
     Operation op_;
@@ -129,11 +142,65 @@ public:
             out.emplace_back(op_(a[i], b[i]));
         return out;
     }
+    //! combine b into a in place, a = op(a, b) component-wise.
+    void Accumulate(VectorType& a, const VectorType& b) const {
+        assert(a.size() == b.size());
+        a.resize(std::min(a.size(), b.size()));
+        Accumulate(a, 0, b);
+    }
+    //! combine b into the components [offset, offset + b.size()) of a.
+    void Accumulate(VectorType& a, size_t offset, const VectorType& b) const {
+        assert(offset + b.size() <= a.size());
+        for (size_t i = 0; i < b.size(); ++i)
+            a[offset + i] = op_(a[offset + i], b[i]);
+    }
 
 private:
     Operation op_;
 };
 
+//! Compute the component-wise minimum of std::array or std::vector.
+template <typename ArrayType>
+using ComponentMin =
+    ComponentSum<ArrayType, minimum<typename ArrayType::value_type> >;
+
+//! Compute the component-wise maximum of std::array or std::vector.
+template <typename ArrayType>
+using ComponentMax =
+    ComponentSum<ArrayType, maximum<typename ArrayType::value_type> >;
+
+/******************************************************************************/
+
+namespace detail {
+
+//! reduce in place, if the functor has an Accumulate() method.
+template <typename ReduceFunction, typename Type>
+static inline auto ReduceAssign(
+    ReduceFunction& reduce_function, Type& a, const Type& b, int)
+->decltype(reduce_function.Accumulate(a, b), void()) {
+    reduce_function.Accumulate(a, b);
+}
+
+//! reduce by assigning the result.
+template <typename ReduceFunction, typename Type>
+static inline void ReduceAssign(
+    ReduceFunction& reduce_function, Type& a, const Type& b, long) {
+    a = reduce_function(a, b);
+}
+
+} // namespace detail
+
+//! Reduce b into a, i.e. a = reduce_function(a, b). Functors with an
+//! Accumulate() method, like ComponentSum, combine in place without
+//! temporaries, all others are called and their result is assigned.
+template <typename ReduceFunction, typename Type>
+static inline void ReduceAssign(
+    ReduceFunction& reduce_function, Type& a, const Type& b) {
+    detail::ReduceAssign(reduce_function, a, b, 0);
+}
+
+/******************************************************************************/
+
 //! Compute the concatenation of two std::vector<T>s.
 template <typename Type>
 class VectorConcat
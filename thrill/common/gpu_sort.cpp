@@ -0,0 +1,38 @@
+/*******************************************************************************
+ * thrill/common/gpu_sort.cpp
+ *
+ * Host fallback of the device functions of GpuSort, used if the library is
+ * built without THRILL_USE_CUDA. The device implementation is in gpu_sort.cu.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/gpu_sort.hpp>
+
+namespace thrill {
+namespace common {
+namespace gpu_sort_local {
+
+#if !THRILL_HAVE_CUDA
+
+bool DeviceAvailable() {
+    return false;
+}
+
+bool SortKeyIndexes(const uint32_t*, uint32_t*, size_t) {
+    return false;
+}
+
+bool SortKeyIndexes(const uint64_t*, uint32_t*, size_t) {
+    return false;
+}
+
+#endif // !THRILL_HAVE_CUDA
+
+} // namespace gpu_sort_local
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,173 @@
+/*******************************************************************************
+ * thrill/common/gpu_sort.cu
+ *
+ * Device functions of GpuSort: stable sort of (key, index) pairs with Thrust.
+ * Compiled only with THRILL_USE_CUDA. This file does not include
+ * gpu_sort.hpp, which nvcc need not parse, hence the signatures must match.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <cuda_runtime.h>
+#include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
+#include <thrust/sort.h>
+#include <thrust/system_error.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace thrill {
+namespace common {
+namespace gpu_sort_local {
+
+namespace {
+
+//! number of pairs copied per chunk
+static const size_t kChunkItems = size_t(1) << 20;
+
+//! pinned host buffer, which is kept between calls
+class PinnedBuffer
+{
+public:
+    ~PinnedBuffer() {
+        if (data_) cudaFreeHost(data_);
+    }
+
+    char * Get(size_t size) {
+        if (size <= size_) return static_cast<char*>(data_);
+        if (data_) cudaFreeHost(data_);
+        data_ = nullptr, size_ = 0;
+        if (cudaMallocHost(&data_, size) != cudaSuccess) {
+            data_ = nullptr;
+            return nullptr;
+        }
+        size_ = size;
+        return static_cast<char*>(data_);
+    }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+//! two pinned buffers per thread, one for each CUDA stream
+thread_local PinnedBuffer s_pinned[2];
+
+template <typename Key>
+bool SortKeyIndexesImpl(const Key* keys, uint32_t* indexes, size_t size) {
+    const size_t chunk_bytes = kChunkItems * (sizeof(Key) + sizeof(uint32_t));
+
+    char* pinned[2] = { s_pinned[0].Get(chunk_bytes),
+                        s_pinned[1].Get(chunk_bytes) };
+    if (!pinned[0] || !pinned[1]) return false;
+
+    cudaStream_t streams[2];
+    if (cudaStreamCreate(&streams[0]) != cudaSuccess) return false;
+    if (cudaStreamCreate(&streams[1]) != cudaSuccess) {
+        cudaStreamDestroy(streams[0]);
+        return false;
+    }
+
+    bool ok = true;
+    try {
+        thrust::device_vector<Key> d_keys(size);
+        thrust::device_vector<uint32_t> d_indexes(size);
+        Key* d_keys_ptr = thrust::raw_pointer_cast(d_keys.data());
+        uint32_t* d_indexes_ptr = thrust::raw_pointer_cast(d_indexes.data());
+
+        // upload in chunks: filling one pinned buffer on the host overlaps
+        // with the transfer of the other.
+        for (size_t c = 0, offset = 0; offset < size && ok;
+             ++c, offset += kChunkItems) {
+            size_t s = c % 2, n = std::min(kChunkItems, size - offset);
+            ok = cudaStreamSynchronize(streams[s]) == cudaSuccess;
+
+            Key* pinned_keys = reinterpret_cast<Key*>(pinned[s]);
+            uint32_t* pinned_indexes = reinterpret_cast<uint32_t*>(
+                pinned[s] + kChunkItems * sizeof(Key));
+            std::memcpy(pinned_keys, keys + offset, n * sizeof(Key));
+            std::memcpy(pinned_indexes, indexes + offset,
+                        n * sizeof(uint32_t));
+
+            ok = ok &&
+                 cudaMemcpyAsync(d_keys_ptr + offset, pinned_keys,
+                                 n * sizeof(Key), cudaMemcpyHostToDevice,
+                                 streams[s]) == cudaSuccess &&
+                 cudaMemcpyAsync(d_indexes_ptr + offset, pinned_indexes,
+                                 n * sizeof(uint32_t), cudaMemcpyHostToDevice,
+                                 streams[s]) == cudaSuccess;
+        }
+        ok = ok && cudaStreamSynchronize(streams[0]) == cudaSuccess &&
+             cudaStreamSynchronize(streams[1]) == cudaSuccess;
+
+        if (ok) {
+            // radix sort on the device, stable for equal keys
+            thrust::stable_sort_by_key(
+                thrust::cuda::par.on(streams[0]),
+                d_keys.begin(), d_keys.end(), d_indexes.begin());
+            ok = cudaStreamSynchronize(streams[0]) == cudaSuccess;
+        }
+
+        // download the indexes in chunks: the transfer of one chunk overlaps
+        // with copying the previous one out of its pinned buffer.
+        size_t num_chunks = (size + kChunkItems - 1) / kChunkItems;
+        for (size_t c = 0; c < num_chunks + 1 && ok; ++c) {
+            if (c < num_chunks) {
+                size_t s = c % 2, offset = c * kChunkItems;
+                size_t n = std::min(kChunkItems, size - offset);
+                ok = cudaMemcpyAsync(
+                    pinned[s], d_indexes_ptr + offset, n * sizeof(uint32_t),
+                    cudaMemcpyDeviceToHost, streams[s]) == cudaSuccess;
+            }
+            if (c > 0 && ok) {
+                size_t s = (c - 1) % 2, offset = (c - 1) * kChunkItems;
+                size_t n = std::min(kChunkItems, size - offset);
+                ok = cudaStreamSynchronize(streams[s]) == cudaSuccess;
+                if (ok) {
+                    std::memcpy(indexes + offset, pinned[s],
+                                n * sizeof(uint32_t));
+                }
+            }
+        }
+    }
+    catch (const thrust::system_error&) {
+        ok = false;
+    }
+    catch (const std::bad_alloc&) {
+        ok = false;
+    }
+
+    cudaStreamDestroy(streams[0]);
+    cudaStreamDestroy(streams[1]);
+    return ok;
+}
+
+} // namespace
+
+bool DeviceAvailable() {
+    static const bool available = [] {
+                                      int count = 0;
+                                      return cudaGetDeviceCount(&count) ==
+                                             cudaSuccess && count > 0;
+                                  } ();
+    return available;
+}
+
+bool SortKeyIndexes(const uint32_t* keys, uint32_t* indexes, size_t size) {
+    return SortKeyIndexesImpl(keys, indexes, size);
+}
+
+bool SortKeyIndexes(const uint64_t* keys, uint32_t* indexes, size_t size) {
+    return SortKeyIndexesImpl(keys, indexes, size);
+}
+
+} // namespace gpu_sort_local
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * thrill/common/gpu_sort.hpp
+ *
+ * SortAlgorithm which sorts the integer keys of items on a CUDA device, and
+ * permutes the items on the host. Falls back to lsd_radix_sort() without a
+ * device.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_GPU_SORT_HEADER
+#define THRILL_COMMON_GPU_SORT_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/lsd_radix_sort.hpp>
+
+#include <tlx/unused.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace common {
+namespace gpu_sort_local {
+
+//! Returns true if the library was built with THRILL_USE_CUDA and a device is
+//! present. Checked once.
+bool DeviceAvailable();
+
+/*!
+ * Stably sort size pairs of (key, index) by key on the device. The keys and
+ * indexes are copied through pinned host buffers, which are kept per thread
+ * between calls, in chunks on two CUDA streams, such that uploads overlap with
+ * the host filling the next chunk. Only the indexes are returned in order.
+ * Returns false if the device failed, in which case indexes are undefined.
+ */
+bool SortKeyIndexes(const uint32_t* keys, uint32_t* indexes, size_t size);
+bool SortKeyIndexes(const uint64_t* keys, uint32_t* indexes, size_t size);
+
+} // namespace gpu_sort_local
+
+/*!
+ * SortAlgorithm class for use with api::Sort() and api::SortStable() for
+ * items with integer keys of up to 64 bits returned by key_extractor. The
+ * compare function of the Sort() must be the comparison of these keys, e.g.
+ * api::LessByKey().
+ *
+ * Only the keys and 32-bit indexes of the items are transferred to the
+ * device, which sorts them stably with a radix sort, hence the items may be of
+ * any type. The items are then permuted on the host. Runs of fewer than
+ * min_device_items, and all runs without a device, are sorted by
+ * lsd_radix_sort() on the host.
+ */
+template <typename KeyExtractor>
+class GpuSort
+{
+public:
+    explicit GpuSort(const KeyExtractor& key_extractor,
+                     size_t min_device_items = 1024 * 1024)
+        : key_extractor_(key_extractor),
+          min_device_items_(min_device_items) { }
+
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end,
+                      const CompareFunction& cmp) const {
+        using namespace lsd_radix_sort_local;
+        using ValueType = typename std::iterator_traits<Iterator>::value_type;
+        using Key = typename std::decay<
+            decltype(key_extractor_(std::declval<ValueType>()))>::type;
+        using Unsigned = typename RadixKey<Key>::Unsigned;
+
+        size_t size = static_cast<size_t>(end - begin);
+
+        if (sizeof(Unsigned) > 8 || size < min_device_items_ ||
+            size > UINT32_MAX || !gpu_sort_local::DeviceAvailable() ||
+            !SortOnDevice<Unsigned>(begin, size)) {
+            lsd_radix_sort(begin, end, key_extractor_);
+        }
+        assert(std::is_sorted(begin, end, cmp));
+        tlx::unused(cmp);
+    }
+
+private:
+    KeyExtractor key_extractor_;
+    size_t min_device_items_;
+
+    template <typename Unsigned, typename Iterator>
+    bool SortOnDevice(Iterator begin, size_t size) const {
+        using namespace lsd_radix_sort_local;
+        using ValueType = typename std::iterator_traits<Iterator>::value_type;
+        using Key = typename std::decay<
+            decltype(key_extractor_(std::declval<ValueType>()))>::type;
+        using DeviceKey = typename std::conditional<
+            sizeof(Unsigned) <= 4, uint32_t, uint64_t>::type;
+
+        std::vector<DeviceKey> keys(size);
+        std::vector<uint32_t> indexes(size);
+        for (size_t i = 0; i < size; ++i) {
+            keys[i] = static_cast<DeviceKey>(
+                RadixKey<Key>::Get(key_extractor_(begin[i])));
+            indexes[i] = static_cast<uint32_t>(i);
+        }
+
+        if (!gpu_sort_local::SortKeyIndexes(keys.data(), indexes.data(), size))
+            return false;
+
+        // permute the items into sorted order on the host
+        std::vector<ValueType> sorted;
+        sorted.reserve(size);
+        for (size_t i = 0; i < size; ++i)
+            sorted.emplace_back(std::move(begin[indexes[i]]));
+        std::move(sorted.begin(), sorted.end(), begin);
+        return true;
+    }
+};
+
+//! make a GpuSort SortAlgorithm
+template <typename KeyExtractor>
+GpuSort<KeyExtractor> MakeGpuSort(
+    const KeyExtractor& key_extractor, size_t min_device_items = 1024 * 1024) {
+    return GpuSort<KeyExtractor>(key_extractor, min_device_items);
+}
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_GPU_SORT_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,142 @@
+/*******************************************************************************
+ * thrill/common/interpolation_classifier.hpp
+ *
+ * Classification of integer keys into buckets defined by sorted splitters
+ * using a piecewise-linear model of the splitters' distribution: a table of
+ * equal-width key segments is looked up with one subtraction and division,
+ * followed by a short linear correction step.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_INTERPOLATION_CLASSIFIER_HEADER
+#define THRILL_COMMON_INTERPOLATION_CLASSIFIER_HEADER
+
+#include <thrill/common/logger.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * Classifies integers x into buckets b in [0,num_splitters] with
+ * splitter[b-1] <= x < splitter[b], exactly like running down a splitter tree
+ * (see ClassifySplitterTree()).
+ *
+ * The key range [splitter[0],splitter[n-1]] is divided into
+ * SegmentsPerSplitter * n segments of equal width. For each segment the bucket
+ * of its first key is precomputed, which is a piecewise-linear approximation of
+ * the splitters' CDF. An item is classified by calculating its segment, and
+ * then advancing past the few splitters inside the segment.
+ *
+ * If the splitters are too clustered, e.g. for skewed key distributions, too
+ * many splitters fall into one segment and good() returns false. The caller
+ * should then use a splitter tree instead.
+ */
+template <typename Integer, size_t SegmentsPerSplitter = 4>
+class InterpolationClassifier
+{
+    static_assert(std::is_integral<Integer>::value &&
+                  !std::is_same<Integer, bool>::value,
+                  "InterpolationClassifier requires a non-bool integral type");
+
+    static constexpr bool debug = false;
+
+public:
+    using Unsigned = typename std::make_unsigned<Integer>::type;
+
+    //! maximum number of splitters in one segment for good() to be true.
+    static constexpr size_t kMaxCorrection = 8;
+
+    InterpolationClassifier() = default;
+
+    //! Build the model from num_splitters sorted splitters.
+    InterpolationClassifier(const Integer* splitters, size_t num_splitters)
+        : splitters_(splitters, splitters + num_splitters) {
+
+        if (num_splitters == 0) return;
+
+        min_ = splitters_.front();
+        Unsigned range =
+            static_cast<Unsigned>(splitters_.back())
+            - static_cast<Unsigned>(min_);
+        if (range == 0) return;
+
+        size_t num_segments = SegmentsPerSplitter * num_splitters;
+        width_ = range / num_segments + 1;
+        num_segments = range / width_ + 1;
+
+        table_.resize(num_segments + 1);
+
+        size_t max_correction = 0;
+        size_t b = 0;
+        for (size_t s = 0; s <= num_segments; ++s) {
+            // bucket of the first key of segment s (capped at the last)
+            Unsigned start_off =
+                s < num_segments ? static_cast<Unsigned>(s * width_) : range;
+            Integer start = static_cast<Integer>(
+                static_cast<Unsigned>(min_) + start_off);
+            while (b < num_splitters && !(start < splitters_[b])) ++b;
+            table_[s] = b;
+            if (s > 0)
+                max_correction = std::max(max_correction, b - table_[s - 1]);
+        }
+
+        good_ = (max_correction <= kMaxCorrection);
+
+        sLOG << "InterpolationClassifier() splitters" << num_splitters
+             << "segments" << num_segments << "width" << width_
+             << "max_correction" << max_correction << "good" << good_;
+    }
+
+    //! Whether the model classifies with few correction steps.
+    bool good() const { return good_; }
+
+    //! Classify item x into a bucket.
+    size_t Classify(const Integer& x) const {
+        if (x < min_) return 0;
+        // all splitters are equal (or there are none)
+        if (table_.empty()) return splitters_.size();
+        Unsigned off = static_cast<Unsigned>(x) - static_cast<Unsigned>(min_);
+        size_t s = std::min<Unsigned>(off / width_, table_.size() - 1);
+        size_t b = table_[s];
+        while (b < splitters_.size() && !(x < splitters_[b])) ++b;
+        return b;
+    }
+
+    //! Classify a batch of n items into bucket[].
+    void Classify(const Integer* items, size_t n, size_t* bucket) const {
+        for (size_t i = 0; i < n; ++i)
+            bucket[i] = Classify(items[i]);
+    }
+
+private:
+    //! sorted splitters
+    std::vector<Integer> splitters_;
+
+    //! smallest splitter, start of the first segment
+    Integer min_ = Integer();
+
+    //! width of each segment in keys
+    Unsigned width_ = 1;
+
+    //! bucket of the first key of each segment
+    std::vector<size_t> table_;
+
+    //! whether the model was built successfully
+    bool good_ = false;
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_INTERPOLATION_CLASSIFIER_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * thrill/common/item_memory_size.hpp
+ *
+ * Estimation of the heap memory owned by variable-size items.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_ITEM_MEMORY_SIZE_HEADER
+#define THRILL_COMMON_ITEM_MEMORY_SIZE_HEADER
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * Trait to estimate the heap memory owned by an item beyond sizeof(T), which
+ * operators add to sizeof(T) when checking their memory limit. Types with
+ * is_fixed = true own no heap memory and need no per-item accounting. The
+ * default is fixed, hence user types with heap payload may specialize the
+ * trait.
+ */
+template <typename T, typename Enable = void>
+struct ItemMemorySize {
+    //! whether the items own no heap memory
+    static constexpr bool is_fixed = true;
+
+    //! heap memory owned by the item in bytes
+    static size_t heap(const T&) { return 0; }
+};
+
+//! returns the heap memory owned by the item beyond sizeof(T)
+template <typename T>
+size_t item_heap_size(const T& t) {
+    return ItemMemorySize<T>::heap(t);
+}
+
+//! returns the estimated memory used by the item, including sizeof(T)
+template <typename T>
+size_t item_memory_size(const T& t) {
+    return sizeof(T) + ItemMemorySize<T>::heap(t);
+}
+
+template <typename Char, typename Traits, typename Alloc>
+struct ItemMemorySize<std::basic_string<Char, Traits, Alloc> > {
+    static constexpr bool is_fixed = false;
+
+    static size_t heap(const std::basic_string<Char, Traits, Alloc>& s) {
+        // short strings are stored inside the object
+        size_t bytes = (s.capacity() + 1) * sizeof(Char);
+        return bytes > sizeof(s) ? bytes : 0;
+    }
+};
+
+template <typename T, typename Alloc>
+struct ItemMemorySize<std::vector<T, Alloc> > {
+    static constexpr bool is_fixed = false;
+
+    static size_t heap(const std::vector<T, Alloc>& v) {
+        size_t bytes = v.capacity() * sizeof(T);
+        if (!ItemMemorySize<T>::is_fixed) {
+            for (const T& t : v) bytes += ItemMemorySize<T>::heap(t);
+        }
+        return bytes;
+    }
+};
+
+template <typename T, size_t N>
+struct ItemMemorySize<std::array<T, N> > {
+    static constexpr bool is_fixed = ItemMemorySize<T>::is_fixed;
+
+    static size_t heap(const std::array<T, N>& a) {
+        size_t bytes = 0;
+        if (!is_fixed) {
+            for (const T& t : a) bytes += ItemMemorySize<T>::heap(t);
+        }
+        return bytes;
+    }
+};
+
+template <typename U, typename V>
+struct ItemMemorySize<std::pair<U, V> > {
+    static constexpr bool is_fixed =
+        ItemMemorySize<U>::is_fixed && ItemMemorySize<V>::is_fixed;
+
+    static size_t heap(const std::pair<U, V>& p) {
+        return ItemMemorySize<U>::heap(p.first)
+               + ItemMemorySize<V>::heap(p.second);
+    }
+};
+
+//! conjunction of the is_fixed flags of tuple components
+constexpr bool item_memory_size_all(std::initializer_list<bool> list) {
+    for (const bool& b : list) {
+        if (!b) return false;
+    }
+    return true;
+}
+
+template <typename... Args>
+struct ItemMemorySize<std::tuple<Args...> > {
+private:
+    template <size_t... Is>
+    static size_t heap_impl(const std::tuple<Args...>& t,
+                            std::index_sequence<Is...>) {
+        size_t bytes = 0;
+        using Expander = int[];
+        (void)Expander {
+            0, (bytes += ItemMemorySize<Args>::heap(std::get<Is>(t)), 0) ...
+        };
+        return bytes;
+    }
+
+public:
+    static constexpr bool is_fixed =
+        item_memory_size_all({ true, ItemMemorySize<Args>::is_fixed ... });
+
+    static size_t heap(const std::tuple<Args...>& t) {
+        return heap_impl(t, std::index_sequence_for<Args...>());
+    }
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_ITEM_MEMORY_SIZE_HEADER
+
+/******************************************************************************/
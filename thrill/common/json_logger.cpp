@@ -15,6 +15,7 @@
 #include <thrill/common/string.hpp>
 
 #include <tlx/die.hpp>
+#include <tlx/string/ends_with.hpp>
 
 #include <cerrno>
 #include <chrono>
@@ -22,6 +23,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -44,6 +46,17 @@ JsonLogger::JsonLogger(const std::string& path) {
         return;
     }
 
+    if (tlx::ends_with(path, ".trace")) {
+        std::unique_ptr<std::ostream> os =
+            std::make_unique<std::ofstream>(path.c_str(), std::ios::binary);
+        if (!os->good()) {
+            die("Could not open binary trace output: "
+                << path << " : " << strerror(errno));
+        }
+        trace_ = std::make_unique<JsonTraceWriter>(std::move(os));
+        return;
+    }
+
     os_ = std::make_unique<std::ofstream>(path.c_str());
     if (!os_->good()) {
         die("Could not open json log output: "
@@ -65,8 +78,24 @@ JsonLine JsonLogger::line() {
         return out;
     }
 
+    static std::ofstream dummy_of_;
+
+    if (trace_) {
+        // binary trace: encode into the thread's record without locking
+        JsonLine out(this, dummy_of_, &trace_->BeginRecord());
+        out.PutChar('{');
+
+        out << "ts"
+            << std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        if (!common_.str_.empty())
+            out << common_;
+
+        return out;
+    }
+
     if (!os_) {
-        static std::ofstream dummy_of_;
         return JsonLine(this, dummy_of_);
     }
 
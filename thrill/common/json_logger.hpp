@@ -14,10 +14,12 @@
 #ifndef THRILL_COMMON_JSON_LOGGER_HEADER
 #define THRILL_COMMON_JSON_LOGGER_HEADER
 
+#include <thrill/common/json_trace.hpp>
 #include <tlx/meta/call_foreach.hpp>
 
 #include <array>
 #include <cassert>
+#include <cstring>
 #include <initializer_list>
 #include <memory>
 #include <mutex>
@@ -72,7 +74,9 @@ public:
     //! open JsonLogger with ofstream uninitialized to discard log output.
     JsonLogger() = default;
 
-    //! open JsonLogger with ofstream. if path is empty, output goes to stdout
+    //! open JsonLogger with ofstream. if path is empty, output goes to stdout.
+    //! If path ends with ".trace", lines are written in the binary format of
+    //! JsonTraceWriter.
     explicit JsonLogger(const std::string& path);
 
     //! open JsonLogger with a super logger
@@ -105,6 +109,9 @@ public:
     //! common items outputted to each line
     JsonVerbatim common_;
 
+    //! binary trace backend of top loggers, replaces os_
+    std::unique_ptr<JsonTraceWriter> trace_;
+
     //! friends for sending to os_
     friend class JsonLine;
 
@@ -119,10 +126,11 @@ public:
 class JsonLine
 {
 public:
-    //! ctor: bind output
-    JsonLine(JsonLogger* logger, std::ostream& os)
-        : logger_(logger), os_(os) {
-        if (logger)
+    //! ctor: bind output, either text to os or a binary trace record.
+    JsonLine(JsonLogger* logger, std::ostream& os,
+             std::string* record = nullptr)
+        : logger_(logger), os_(os), record_(record) {
+        if (logger && !record)
             lock_ = std::unique_lock<std::mutex>(logger_->mutex_);
     }
 
@@ -133,7 +141,8 @@ public:
     //! move-constructor: unlink pointer
     JsonLine(JsonLine&& o)
         : logger_(o.logger_), lock_(std::move(o.lock_)),
-          os_(o.os_), items_(o.items_), sub_dict_(o.sub_dict_)
+          os_(o.os_), record_(o.record_), items_(o.items_),
+          sub_dict_(o.sub_dict_)
     { o.logger_ = nullptr; }
 
     struct ArrayTag { };
@@ -147,13 +156,13 @@ public:
         // write key
         operator << (t.str_);
         PutSeparator();
-        os_ << '{';
+        PutChar('{');
         items_ = 0;
         return *this;
     }
 
     JsonLine& operator << (const JsonEndObj&) {
-        os_ << '}';
+        PutChar('}');
         return *this;
     }
 
@@ -164,17 +173,29 @@ public:
 
     //! close the line
     void Close() {
-        if (logger_ && items_ != 0) {
+        if (logger_ && record_) {
+            if (items_ != 0) {
+                assert(items_ % 2 == 0);
+                record_->push_back('}');
+                logger_->trace_->CommitRecord();
+            }
+            else {
+                logger_->trace_->AbortRecord();
+            }
+            logger_ = nullptr;
+            items_ = 0;
+        }
+        else if (logger_ && items_ != 0) {
             assert(items_ % 2 == 0);
             os_ << '}' << std::endl;
             items_ = 0;
         }
         else if (!logger_ && sub_dict_) {
-            os_ << '}';
+            PutChar('}');
             sub_dict_ = false;
         }
         else if (!logger_ && sub_array_) {
-            os_ << ']';
+            PutChar(']');
             sub_array_ = false;
         }
     }
@@ -188,7 +209,7 @@ public:
         // write key
         operator << (key);
         PutSeparator();
-        os_ << '{';
+        PutChar('{');
         return JsonLine(DictionaryTag(), *this);
     }
 
@@ -198,15 +219,15 @@ public:
         // write key
         operator << (key);
         PutSeparator();
-        os_ << '[';
+        PutChar('[');
         return JsonLine(ArrayTag(), *this);
     }
 
     //! return JsonLine has sub-dictionary of this one
     JsonLine obj() {
         if (items_ > 0)
-            os_ << ',';
-        os_ << '{';
+            PutChar(',');
+        PutChar('{');
         items_++;
         return JsonLine(DictionaryTag(), *this);
     }
@@ -214,35 +235,94 @@ public:
     //! put an items separator (either ',' or ':') and increment counter.
     void PutSeparator() {
         if (items_ > 0) {
-            os_ << (items_ % 2 == 0 ? ',' : ':');
+            PutChar(items_ % 2 == 0 ? ',' : ':');
         }
         items_++;
     }
 
-    void PutEscapedChar(char ch) {
+    static void PutEscapedChar(std::ostream& os, char ch) {
         // from: http://stackoverflow.com/a/7725289
         switch (ch) {
-        case '\\': os_ << '\\' << '\\';
+        case '\\': os << '\\' << '\\';
             break;
-        case '"': os_ << '\\' << '"';
+        case '"': os << '\\' << '"';
             break;
-        case '/': os_ << '\\' << '/';
+        case '/': os << '\\' << '/';
             break;
-        case '\b': os_ << '\\' << 'b';
+        case '\b': os << '\\' << 'b';
             break;
-        case '\f': os_ << '\\' << 'f';
+        case '\f': os << '\\' << 'f';
             break;
-        case '\n': os_ << '\\' << 'n';
+        case '\n': os << '\\' << 'n';
             break;
-        case '\r': os_ << '\\' << 'r';
+        case '\r': os << '\\' << 'r';
             break;
-        case '\t': os_ << '\\' << 't';
+        case '\t': os << '\\' << 't';
             break;
-        default: os_ << ch;
+        default: os << ch;
             break;
         }
     }
 
+    //! output a structural character of the JSON line
+    void PutChar(char ch) {
+        if (record_)
+            record_->push_back(ch);
+        else
+            os_ << ch;
+    }
+
+    void PutInt(long long value) {
+        if (record_)
+            JsonTraceAppendInt(*record_, value);
+        else
+            os_ << value;
+    }
+
+    void PutUInt(unsigned long long value) {
+        if (record_)
+            JsonTraceAppendUInt(*record_, value);
+        else
+            os_ << value;
+    }
+
+    void PutDouble(double value) {
+        if (record_)
+            JsonTraceAppendDouble(*record_, value);
+        else
+            os_ << value;
+    }
+
+    void PutBool(bool value) {
+        if (record_)
+            record_->push_back(static_cast<char>(
+                                   value ? JsonTraceTag::True
+                                   : JsonTraceTag::False));
+        else
+            os_ << (value ? "true" : "false");
+    }
+
+    //! output a string with quotes, escaping is deferred for traces.
+    void PutString(const char* data, size_t size) {
+        if (record_) {
+            JsonTraceAppendString(*record_, JsonTraceTag::String, data, size);
+            return;
+        }
+        os_ << '"';
+        for (const char* s = data; s != data + size; ++s)
+            PutEscapedChar(os_, *s);
+        os_ << '"';
+    }
+
+    //! output verbatim JSON text
+    void PutVerbatim(const std::string& str) {
+        if (record_)
+            JsonTraceAppendString(
+                *record_, JsonTraceTag::Verbatim, str.data(), str.size());
+        else
+            os_ << str;
+    }
+
 private:
     //! when destructed this object is delivered to the output.
     JsonLogger* logger_ = nullptr;
@@ -252,16 +332,19 @@ private:
 
     //! construct sub-dictionary
     JsonLine(struct DictionaryTag, JsonLine& parent)
-        : os_(parent.os_), sub_dict_(true) { }
+        : os_(parent.os_), record_(parent.record_), sub_dict_(true) { }
 
     //! construct sub-dictionary
     JsonLine(struct ArrayTag, JsonLine& parent)
-        : os_(parent.os_), sub_array_(true) { }
+        : os_(parent.os_), record_(parent.record_), sub_array_(true) { }
 
 public:
     //! reference to output stream
     std::ostream& os_;
 
+    //! binary trace record to append to instead of os_, if not nullptr.
+    std::string* record_ = nullptr;
+
     //! items counter for output stream
     size_t items_ = 0;
 
@@ -277,120 +360,115 @@ public:
 
 static inline
 JsonLine& Put(JsonLine& line, bool const& value) {
-    line.os_ << (value ? "true" : "false");
+    line.PutBool(value);
     return line;
 }
 
 static inline
 JsonLine& Put(JsonLine& line, int const& value) {
-    line.os_ << value;
+    line.PutInt(value);
     return line;
 }
 
 static inline
 JsonLine& Put(JsonLine& line, unsigned int const& value) {
-    line.os_ << value;
+    line.PutUInt(value);
     return line;
 }
 
 static inline
 JsonLine& Put(JsonLine& line, long const& value) {
-    line.os_ << value;
+    line.PutInt(value);
     return line;
 }
 
 static inline
 JsonLine& Put(JsonLine& line, unsigned long const& value) {
-    line.os_ << value;
+    line.PutUInt(value);
     return line;
 }
 
 static inline
 JsonLine& Put(JsonLine& line, long long const& value) {
-    line.os_ << value;
+    line.PutInt(value);
     return line;
 }
 
 static inline
 JsonLine& Put(JsonLine& line, unsigned long long const& value) {
-    line.os_ << value;
+    line.PutUInt(value);
     return line;
 }
 
 static inline
 JsonLine& Put(JsonLine& line, double const& value) {
-    line.os_ << value;
+    line.PutDouble(value);
     return line;
 }
 
 static inline
 JsonLine& Put(JsonLine& line, const char* const& str) {
-    line.os_ << '"';
-    for (const char* s = str; *s; ++s) line.PutEscapedChar(*s);
-    line.os_ << '"';
+    line.PutString(str, std::strlen(str));
     return line;
 }
 
 static inline
 JsonLine& Put(JsonLine& line, std::string const& str) {
-    line.os_ << '"';
-    for (std::string::const_iterator i = str.begin(); i != str.end(); ++i)
-        line.PutEscapedChar(*i);
-    line.os_ << '"';
+    line.PutString(str.data(), str.size());
     return line;
 }
 
 template <typename Type, std::size_t N>
 static inline
 JsonLine& Put(JsonLine& line, const Type (& arr)[N]) {
-    line.os_ << '[';
+    line.PutChar('[');
     for (size_t i = 0; i < N; ++i) {
-        if (i != 0) line.os_ << ',';
+        if (i != 0) line.PutChar(',');
         Put(line, arr[i]);
     }
-    line.os_ << ']';
+    line.PutChar(']');
     return line;
 }
 
 template <typename Type>
 static inline
 JsonLine& Put(JsonLine& line, std::initializer_list<Type> const& list) {
-    line.os_ << '[';
+    line.PutChar('[');
     for (typename std::initializer_list<Type>::const_iterator it = list.begin();
          it != list.end(); ++it) {
         if (it != list.begin())
-            line.os_ << ',';
+            line.PutChar(',');
         Put(line, *it);
     }
-    line.os_ << ']';
+    line.PutChar(']');
     return line;
 }
 
 template <typename Type>
 static inline
 JsonLine& Put(JsonLine& line, std::vector<Type> const& vec) {
-    line.os_ << '[';
+    line.PutChar('[');
     for (typename std::vector<Type>::const_iterator it = vec.begin();
          it != vec.end(); ++it) {
         if (it != vec.begin())
-            line.os_ << ',';
+            line.PutChar(',');
         Put(line, *it);
     }
-    line.os_ << ']';
+    line.PutChar(']');
     return line;
 }
 
 template <typename Type, std::size_t N>
 static inline
 JsonLine& Put(JsonLine& line, std::array<Type, N> const& arr) {
-    line.os_ << '[';
+    line.PutChar('[');
     for (typename std::array<Type, N>::const_iterator it = arr.begin();
          it != arr.end(); ++it) {
         if (it != arr.begin())
-            line.os_ << ',';
+            line.PutChar(',');
         Put(line, *it);
     }
-    line.os_ << ']';
+    line.PutChar(']');
     return line;
 }
 
@@ -398,7 +476,7 @@ static inline
 JsonLine& Put(JsonLine& line, JsonVerbatim const& verbatim) {
     // undo increment of item counter
     --line.items_;
-    line.os_ << verbatim.str_;
+    line.PutVerbatim(verbatim.str_);
     return line;
 }
 
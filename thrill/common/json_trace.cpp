@@ -0,0 +1,250 @@
+/*******************************************************************************
+ * thrill/common/json_trace.cpp
+ *
+ * Binary trace backend of JsonLogger: per-thread ring buffers of records with
+ * deferred JSON formatting.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/json_trace.hpp>
+
+#include <thrill/common/json_logger.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/******************************************************************************/
+// JsonTraceWriter
+
+//! single-producer single-consumer byte ring of a thread
+struct JsonTraceWriter::Ring {
+    explicit Ring(size_t size) : buffer(size) { }
+
+    //! ring memory
+    std::vector<char> buffer;
+    //! total bytes written, only changed by the producer
+    std::atomic<size_t> head { 0 };
+    //! total bytes consumed, only changed by the flusher
+    std::atomic<size_t> tail { 0 };
+
+    //! record currently built by the thread
+    std::string record;
+
+    //! copy data into the ring at total position pos
+    void Write(size_t pos, const char* data, size_t size) {
+        size_t off = pos % buffer.size();
+        size_t first = std::min(size, buffer.size() - off);
+        std::copy(data, data + first, buffer.data() + off);
+        std::copy(data + first, data + size, buffer.data());
+    }
+};
+
+static std::atomic<uint64_t> s_trace_writer_id { 0 };
+
+JsonTraceWriter::JsonTraceWriter(
+    std::unique_ptr<std::ostream> os, size_t ring_size)
+    : id_(++s_trace_writer_id), os_(std::move(os)), ring_size_(ring_size) {
+    os_->write(json_trace_magic, sizeof(json_trace_magic));
+    thread_ = std::thread([this]() { Worker(); });
+}
+
+JsonTraceWriter::~JsonTraceWriter() {
+    terminate_ = true;
+    cv_.notify_one();
+    thread_.join();
+}
+
+JsonTraceWriter::Ring& JsonTraceWriter::LocalRing() {
+    // rings of the thread by writer id, ids are never reused.
+    static thread_local std::vector<std::pair<uint64_t, Ring*> > s_rings;
+
+    for (const std::pair<uint64_t, Ring*>& r : s_rings) {
+        if (r.first == id_) return *r.second;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    rings_.emplace_back(std::make_unique<Ring>(ring_size_));
+    s_rings.emplace_back(id_, rings_.back().get());
+    return *rings_.back();
+}
+
+std::string& JsonTraceWriter::BeginRecord() {
+    Ring& ring = LocalRing();
+    ring.record.clear();
+    return ring.record;
+}
+
+void JsonTraceWriter::AbortRecord() {
+    LocalRing().record.clear();
+}
+
+void JsonTraceWriter::CommitRecord() {
+    Ring& ring = LocalRing();
+
+    std::string header;
+    JsonTraceAppendVarint(header, ring.record.size());
+    size_t total = header.size() + ring.record.size();
+
+    if (total > ring_size_ / 2) {
+        // oversized record: write directly after the thread's earlier ones
+        std::unique_lock<std::mutex> lock(mutex_);
+        DrainRing(ring);
+        os_->write(header.data(), header.size());
+        os_->write(ring.record.data(), ring.record.size());
+        ring.record.clear();
+        return;
+    }
+
+    size_t head = ring.head.load(std::memory_order_relaxed);
+    while (head + total - ring.tail.load(std::memory_order_acquire)
+           > ring_size_) {
+        ++stalls_;
+        cv_.notify_one();
+        std::this_thread::yield();
+    }
+
+    ring.Write(head, header.data(), header.size());
+    ring.Write(head + header.size(), ring.record.data(), ring.record.size());
+    ring.head.store(head + total, std::memory_order_release);
+    ring.record.clear();
+}
+
+void JsonTraceWriter::DrainRing(Ring& ring) {
+    size_t head = ring.head.load(std::memory_order_acquire);
+    size_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (head == tail) return;
+
+    size_t off = tail % ring_size_;
+    size_t size = head - tail;
+    size_t first = std::min(size, ring_size_ - off);
+    os_->write(ring.buffer.data() + off, first);
+    os_->write(ring.buffer.data(), size - first);
+
+    ring.tail.store(head, std::memory_order_release);
+}
+
+void JsonTraceWriter::Worker() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!terminate_) {
+        cv_.wait_for(lock, std::chrono::milliseconds(10));
+        for (std::unique_ptr<Ring>& ring : rings_)
+            DrainRing(*ring);
+    }
+    // final drain after terminate_, producers have stopped.
+    for (std::unique_ptr<Ring>& ring : rings_)
+        DrainRing(*ring);
+    os_->flush();
+}
+
+/******************************************************************************/
+// JsonTraceReader
+
+JsonTraceReader::JsonTraceReader(FILE* in) : in_(in) {
+    char magic[sizeof(json_trace_magic)];
+    if (fread(magic, sizeof(magic), 1, in_) != 1 ||
+        std::memcmp(magic, json_trace_magic, sizeof(magic)) != 0)
+        die("JsonTraceReader: input is not a binary trace");
+}
+
+bool JsonTraceReader::Next(std::string& line) {
+    // read record size
+    uint64_t size = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        int c = getc(in_);
+        if (c == EOF) {
+            if (shift == 0) return false;
+            die("JsonTraceReader: truncated record");
+        }
+        size |= static_cast<uint64_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) break;
+    }
+
+    record_.resize(size);
+    if (size != 0 && fread(&record_[0], size, 1, in_) != 1)
+        die("JsonTraceReader: truncated record");
+
+    const char* p = record_.data(), * end = p + record_.size();
+
+    auto get_varint =
+        [&]() {
+            uint64_t v = 0;
+            for (unsigned shift = 0; ; shift += 7) {
+                die_unless(p < end);
+                uint8_t c = static_cast<uint8_t>(*p++);
+                v |= static_cast<uint64_t>(c & 0x7F) << shift;
+                if ((c & 0x80) == 0) return v;
+            }
+        };
+
+    std::ostringstream os;
+    while (p < end) {
+        uint8_t c = static_cast<uint8_t>(*p++);
+        if (c < 0x80) {
+            os << static_cast<char>(c);
+            continue;
+        }
+        switch (static_cast<JsonTraceTag>(c)) {
+        case JsonTraceTag::Int: {
+            uint64_t v = get_varint();
+            os << static_cast<long long>((v >> 1) ^ (~(v & 1) + 1));
+            break;
+        }
+        case JsonTraceTag::UInt:
+            os << static_cast<unsigned long long>(get_varint());
+            break;
+        case JsonTraceTag::Double: {
+            double v;
+            die_unless(p + sizeof(v) <= end);
+            std::memcpy(&v, p, sizeof(v));
+            p += sizeof(v);
+            os << v;
+            break;
+        }
+        case JsonTraceTag::String: {
+            uint64_t len = get_varint();
+            die_unless(p + len <= end);
+            os << '"';
+            for (const char* s = p; s != p + len; ++s)
+                JsonLine::PutEscapedChar(os, *s);
+            os << '"';
+            p += len;
+            break;
+        }
+        case JsonTraceTag::Verbatim: {
+            uint64_t len = get_varint();
+            die_unless(p + len <= end);
+            os.write(p, len);
+            p += len;
+            break;
+        }
+        case JsonTraceTag::True:
+            os << "true";
+            break;
+        case JsonTraceTag::False:
+            os << "false";
+            break;
+        default:
+            die("JsonTraceReader: invalid tag " << unsigned(c));
+        }
+    }
+
+    line = os.str();
+    return true;
+}
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
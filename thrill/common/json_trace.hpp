@@ -0,0 +1,201 @@
+/*******************************************************************************
+ * thrill/common/json_trace.hpp
+ *
+ * Binary trace backend of JsonLogger: per-thread ring buffers of records with
+ * deferred JSON formatting.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_JSON_TRACE_HEADER
+#define THRILL_COMMON_JSON_TRACE_HEADER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+//! magic at the beginning of binary trace files
+static constexpr char json_trace_magic[8] = {
+    'T', 'H', 'R', 'L', 'T', 'R', 'C', '1'
+};
+
+/*!
+ * Tags of values in binary trace records. The structural characters of the
+ * JSON line, {}[],: are stored verbatim as ASCII, all values are tagged and
+ * formatted only when decoding.
+ */
+enum class JsonTraceTag : uint8_t {
+    //! zigzag varint
+    Int = 0x80,
+    //! varint
+    UInt = 0x81,
+    //! 8 bytes IEEE double
+    Double = 0x82,
+    //! varint length and unescaped bytes
+    String = 0x83,
+    //! varint length and bytes of verbatim JSON text
+    Verbatim = 0x84,
+    True = 0x85,
+    False = 0x86
+};
+
+//! append a varint to a trace record
+static inline void JsonTraceAppendVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+//! append a tagged value to a trace record
+static inline void JsonTraceAppendInt(std::string& out, int64_t v) {
+    out.push_back(static_cast<char>(JsonTraceTag::Int));
+    JsonTraceAppendVarint(
+        out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+static inline void JsonTraceAppendUInt(std::string& out, uint64_t v) {
+    out.push_back(static_cast<char>(JsonTraceTag::UInt));
+    JsonTraceAppendVarint(out, v);
+}
+
+static inline void JsonTraceAppendDouble(std::string& out, double v) {
+    out.push_back(static_cast<char>(JsonTraceTag::Double));
+    char buf[sizeof(v)];
+    std::memcpy(buf, &v, sizeof(v));
+    out.append(buf, sizeof(v));
+}
+
+static inline void JsonTraceAppendString(
+    std::string& out, JsonTraceTag tag, const char* data, size_t size) {
+    out.push_back(static_cast<char>(tag));
+    JsonTraceAppendVarint(out, size);
+    out.append(data, size);
+}
+
+/*!
+ * JsonTraceWriter collects the records of all threads logging to a JsonLogger
+ * in one lock-free single-producer ring buffer per thread, which a background
+ * thread drains into the output stream. Logging threads only encode their
+ * values into a thread-local record and copy it into their ring, they never
+ * take a lock or format numbers. If a ring is full, the thread waits for the
+ * flusher.
+ *
+ * \verbatim
+ * file: [8 bytes magic "THRLTRC1"][varint size, record bytes]...
+ * \endverbatim
+ *
+ * Records of different threads are interleaved in the file, use the "ts" field
+ * to order them.
+ */
+class JsonTraceWriter
+{
+public:
+    //! default size of each thread's ring buffer
+    static constexpr size_t default_ring_size = 256 * 1024;
+
+    //! start writer and background thread to output stream
+    explicit JsonTraceWriter(std::unique_ptr<std::ostream> os,
+                             size_t ring_size = default_ring_size);
+
+    //! non-copyable: delete copy-constructor
+    JsonTraceWriter(const JsonTraceWriter&) = delete;
+    //! non-copyable: delete assignment operator
+    JsonTraceWriter& operator = (const JsonTraceWriter&) = delete;
+
+    //! stop background thread and write all remaining records
+    ~JsonTraceWriter();
+
+    //! return empty record buffer of the calling thread
+    std::string& BeginRecord();
+
+    //! pass the calling thread's record to the ring buffer
+    void CommitRecord();
+
+    //! discard the calling thread's record
+    void AbortRecord();
+
+    //! number of times a thread waited for space in its ring buffer
+    size_t stalls() const { return stalls_.load(); }
+
+private:
+    struct Ring;
+
+    //! unique id of this writer for thread-local ring lookup
+    const uint64_t id_;
+
+    //! output stream, accessed only by the holder of mutex_
+    std::unique_ptr<std::ostream> os_;
+
+    //! size of each ring buffer
+    size_t ring_size_;
+
+    //! mutex protecting rings_ and os_
+    std::mutex mutex_;
+
+    //! ring buffers of all threads, never deallocated before the writer
+    std::vector<std::unique_ptr<Ring> > rings_;
+
+    //! wakes flusher when a thread waits for space
+    std::condition_variable cv_;
+
+    //! flag to stop flusher
+    std::atomic<bool> terminate_ { false };
+
+    //! counter of waits for ring space
+    std::atomic<size_t> stalls_ { 0 };
+
+    //! background flusher
+    std::thread thread_;
+
+    //! return the ring of the calling thread, create it if needed
+    Ring& LocalRing();
+
+    //! write records in ring to os_, requires mutex_.
+    void DrainRing(Ring& ring);
+
+    //! flusher thread
+    void Worker();
+};
+
+/*!
+ * Decoder of binary trace files, which formats the records into the same JSON
+ * lines JsonLogger writes in text mode.
+ */
+class JsonTraceReader
+{
+public:
+    //! start reading the trace, checks the magic.
+    explicit JsonTraceReader(FILE* in);
+
+    //! decode next record into line (without newline), returns false at end.
+    bool Next(std::string& line);
+
+private:
+    FILE* in_;
+
+    //! buffer of the current record
+    std::string record_;
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_JSON_TRACE_HEADER
+
+/******************************************************************************/
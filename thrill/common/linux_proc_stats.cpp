@@ -15,6 +15,7 @@
 
 #include <thrill/common/json_logger.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/metrics_server.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/common/profile_task.hpp>
 #include <thrill/common/profile_thread.hpp>
@@ -25,8 +26,10 @@
 #include <tlx/string/starts_with.hpp>
 #include <tlx/string/trim.hpp>
 
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <istream>
 #include <limits>
 #include <string>
 #include <vector>
@@ -50,7 +53,8 @@ class LinuxProcStats final : public ProfileTask
     static constexpr bool debug = false;
 
 public:
-    explicit LinuxProcStats(JsonLogger& logger) : logger_(logger) {
+    LinuxProcStats(JsonLogger& logger, MetricsServer* metrics)
+        : logger_(logger), metrics_(metrics) {
 
         sc_pagesize_ = sysconf(_SC_PAGESIZE);
 
@@ -59,6 +63,12 @@ public:
         file_diskstats_.open("/proc/diskstats");
         file_meminfo_.open("/proc/meminfo");
 
+        cgroup_memory_limit_ = GetCgroupMemoryLimit();
+        std::vector<std::string> usage = GetCgroupFiles(
+            "memory", "memory.usage_in_bytes", "memory.current");
+        if (!usage.empty())
+            file_cgroup_memory_.open(usage.front());
+
         pid_t mypid = getpid();
         file_pid_stat_.open("/proc/" + std::to_string(mypid) + "/stat");
         file_pid_io_.open("/proc/" + std::to_string(mypid) + "/io");
@@ -119,6 +129,9 @@ private:
     //! reference to JsonLogger for output
     JsonLogger& logger_;
 
+    //! live metrics server or nullptr
+    MetricsServer* metrics_;
+
     //! open file handle to /proc/stat
     std::ifstream file_stat_;
     //! open file handle to /proc/net/dev
@@ -131,6 +144,11 @@ private:
     std::ifstream file_diskstats_;
     //! open file handle to /proc/meminfo
     std::ifstream file_meminfo_;
+    //! open file handle to the memory usage of our cgroup
+    std::ifstream file_cgroup_memory_;
+
+    //! memory limit of our cgroup, zero if none
+    size_t cgroup_memory_limit_;
 
     //! last time point called
     steady_clock::time_point tp_last_;
@@ -574,6 +592,13 @@ void LinuxProcStats::read_net_dev(
             << "net_tx_pkts" << sum.tx_pkts
             << "net_rx_speed" << static_cast<double>(sum.rx_bytes) / elapsed
             << "net_tx_speed" << static_cast<double>(sum.tx_bytes) / elapsed;
+
+        if (metrics_) {
+            metrics_->Set("thrill_net_speed{dir=\"rx\"}",
+                          static_cast<double>(sum.rx_bytes) / elapsed);
+            metrics_->Set("thrill_net_speed{dir=\"tx\"}",
+                          static_cast<double>(sum.tx_bytes) / elapsed);
+        }
     }
 }
 
@@ -848,20 +873,59 @@ void LinuxProcStats::read_meminfo(JsonLine& out) {
             }
         }
     }
+
+    // the host's memory above is not the limit in a container
+    if (cgroup_memory_limit_ != 0)
+        mem << "cgroup_limit" << cgroup_memory_limit_;
+
+    if (file_cgroup_memory_.is_open()) {
+        file_cgroup_memory_.clear();
+        file_cgroup_memory_.seekg(0);
+        size_t used;
+        if (file_cgroup_memory_ >> used)
+            mem << "cgroup_used" << used;
+    }
 }
 
-void StartLinuxProcStatsProfiler(ProfileThread& sched, JsonLogger& logger) {
+void StartLinuxProcStatsProfiler(ProfileThread& sched, JsonLogger& logger,
+                                 MetricsServer* metrics) {
     sched.Add(std::chrono::seconds(1),
-              new LinuxProcStats(logger), /* own_task */ true);
+              new LinuxProcStats(logger, metrics), /* own_task */ true);
+}
+
+size_t GetCgroupMemoryLimit() {
+    size_t limit = 0;
+    for (const std::string& fn : GetCgroupFiles(
+             "memory", "memory.limit_in_bytes", "memory.max")) {
+        std::ifstream in(fn);
+        size_t value = ParseCgroupMemoryLimit(in);
+        if (value != 0 && (limit == 0 || value < limit))
+            limit = value;
+    }
+    return limit;
 }
 
 #else
 
-void StartLinuxProcStatsProfiler(ProfileThread&, JsonLogger&)
+void StartLinuxProcStatsProfiler(ProfileThread&, JsonLogger&, MetricsServer*)
 { }
 
+size_t GetCgroupMemoryLimit() {
+    return 0;
+}
+
 #endif  // __linux__
 
+size_t ParseCgroupMemoryLimit(std::istream& in) {
+    // cgroup v2 writes "max", v1 a huge number if there is no limit.
+    std::string str;
+    if (!(in >> str) || str == "max") return 0;
+    char* endptr;
+    unsigned long long value = strtoull(str.c_str(), &endptr, 10);
+    if (*endptr != 0 || value >= (1ull << 60)) return 0;
+    return static_cast<size_t>(value);
+}
+
 } // namespace common
 } // namespace thrill
 
@@ -15,15 +15,29 @@
 #ifndef THRILL_COMMON_LINUX_PROC_STATS_HEADER
 #define THRILL_COMMON_LINUX_PROC_STATS_HEADER
 
+#include <cstddef>
+#include <istream>
+
 namespace thrill {
 namespace common {
 
 // forward declarations
 class JsonLogger;
+class MetricsServer;
 class ProfileThread;
 
-//! launch profiler task
-void StartLinuxProcStatsProfiler(ProfileThread& sched, JsonLogger& logger);
+//! launch profiler task, which also publishes the network rate to metrics if
+//! given.
+void StartLinuxProcStatsProfiler(ProfileThread& sched, JsonLogger& logger,
+                                 MetricsServer* metrics = nullptr);
+
+//! get the memory limit of the cgroup (v1 or v2) of the process, which is the
+//! smallest limit of it and its ancestors. Zero if unlimited or unknown.
+size_t GetCgroupMemoryLimit();
+
+//! parse the contents of a cgroup v2 memory.max or v1 memory.limit_in_bytes
+//! file. Zero if it contains "max", the huge number of v1, or garbage.
+size_t ParseCgroupMemoryLimit(std::istream& in);
 
 } // namespace common
 } // namespace thrill
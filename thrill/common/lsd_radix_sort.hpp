@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * thrill/common/lsd_radix_sort.hpp
+ *
+ * Stable least-significant-digit radix sort of items with 32, 64, or 128-bit
+ * integer keys using 8-bit digits. The histograms of all digits are counted in
+ * one pass, passes in which all items have the same digit are skipped, and
+ * small items are scattered through software write-combining buffers. Requires
+ * n extra items of memory.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_LSD_RADIX_SORT_HEADER
+#define THRILL_COMMON_LSD_RADIX_SORT_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/parallel_sort.hpp>
+
+#include <tlx/unused.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace common {
+namespace lsd_radix_sort_local {
+
+//! maps integer keys to unsigned integers of the same order
+template <typename Key, typename Enable = void>
+struct RadixKey;
+
+template <typename Key>
+struct RadixKey<Key, typename std::enable_if<
+                    std::is_integral<Key>::value &&
+                    std::is_unsigned<Key>::value>::type> {
+    using Unsigned = Key;
+    static Unsigned Get(const Key& k) { return k; }
+};
+
+template <typename Key>
+struct RadixKey<Key, typename std::enable_if<
+                    std::is_integral<Key>::value &&
+                    std::is_signed<Key>::value>::type> {
+    using Unsigned = typename std::make_unsigned<Key>::type;
+    //! flip the sign bit, such that negative keys come first
+    static Unsigned Get(const Key& k) {
+        return static_cast<Unsigned>(k) ^
+               (Unsigned(1) << (8 * sizeof(Key) - 1));
+    }
+};
+
+#if defined(__SIZEOF_INT128__)
+template <>
+struct RadixKey<unsigned __int128> {
+    using Unsigned = unsigned __int128;
+    static Unsigned Get(const Unsigned& k) { return k; }
+};
+#endif
+
+//! histogram of one 8-bit digit
+using Histogram = std::array<size_t, 256>;
+
+/*!
+ * Scatter src[lo,hi) to dst by digit, advancing the bucket offsets. Trivially
+ * copyable items of up to 32 bytes are collected in a cache line per bucket
+ * and written in bursts, which avoids read-for-ownership misses on 256
+ * scattered destinations.
+ */
+template <typename ValueType, typename DigitFunction>
+void Scatter(ValueType* src, size_t lo, size_t hi, ValueType* dst,
+             Histogram& offsets, const DigitFunction& digit,
+             std::true_type /* write_combining */) {
+    static constexpr size_t kItems = 64 / sizeof(ValueType);
+    using Storage = typename std::aligned_storage<
+              sizeof(ValueType), alignof(ValueType)>::type;
+
+    std::vector<Storage> storage(256 * kItems);
+    ValueType* buffer = reinterpret_cast<ValueType*>(storage.data());
+    std::array<size_t, 256> fill;
+    fill.fill(0);
+
+    for (size_t i = lo; i < hi; ++i) {
+        size_t d = digit(src[i]);
+        std::memcpy(buffer + d * kItems + fill[d], src + i, sizeof(ValueType));
+        if (++fill[d] == kItems) {
+            std::memcpy(dst + offsets[d], buffer + d * kItems,
+                        kItems * sizeof(ValueType));
+            offsets[d] += kItems;
+            fill[d] = 0;
+        }
+    }
+    for (size_t d = 0; d < 256; ++d) {
+        std::memcpy(dst + offsets[d], buffer + d * kItems,
+                    fill[d] * sizeof(ValueType));
+        offsets[d] += fill[d];
+    }
+}
+
+//! Scatter src[lo,hi) to dst by digit, advancing the bucket offsets.
+template <typename ValueType, typename DigitFunction>
+void Scatter(ValueType* src, size_t lo, size_t hi, ValueType* dst,
+             Histogram& offsets, const DigitFunction& digit,
+             std::false_type /* write_combining */) {
+    for (size_t i = lo; i < hi; ++i)
+        dst[offsets[digit(src[i])]++] = std::move(src[i]);
+}
+
+} // namespace lsd_radix_sort_local
+
+/*!
+ * Stable LSD radix sort of the contiguous range [begin,end) by the integer keys
+ * returned by key_extractor, which may be signed or unsigned integers of up to
+ * 64 bits, or unsigned __int128. With num_threads > 1 (including the calling
+ * thread), or a TaskPool, each pass is counted and scattered in parallel.
+ */
+template <typename Iterator, typename KeyExtractor>
+void lsd_radix_sort(Iterator begin, Iterator end,
+                    const KeyExtractor& key_extractor,
+                    size_t num_threads = 1, TaskPool* pool = nullptr) {
+
+    using namespace lsd_radix_sort_local;
+    using parallel_sort_local::RunTasks;
+
+    static constexpr bool debug = false;
+
+    using ValueType = typename std::iterator_traits<Iterator>::value_type;
+    using Key = typename std::decay<
+              decltype(key_extractor(std::declval<ValueType>()))>::type;
+    using Unsigned = typename RadixKey<Key>::Unsigned;
+
+    static constexpr size_t kPasses = sizeof(Unsigned);
+    //! minimum size of each thread's part, below it fewer threads are used.
+    static constexpr size_t kMinPartSize = 65536;
+
+    using WriteCombining = std::integral_constant<
+              bool, std::is_trivially_copyable<ValueType>::value &&
+              sizeof(ValueType) <= 32>;
+
+    const size_t size = end - begin;
+    if (size < 64) {
+        std::stable_sort(begin, end,
+                         [&](const ValueType& a, const ValueType& b) {
+                             return RadixKey<Key>::Get(key_extractor(a)) <
+                                    RadixKey<Key>::Get(key_extractor(b));
+                         });
+        return;
+    }
+
+    if (pool) num_threads = pool->max_parallelism();
+    num_threads = std::max<size_t>(
+        1, std::min(num_threads, size / kMinPartSize));
+
+    //! part boundaries of the threads
+    std::vector<size_t> parts(num_threads + 1);
+    for (size_t t = 0; t <= num_threads; ++t)
+        parts[t] = size * t / num_threads;
+
+    ValueType* data = &*begin;
+    std::vector<ValueType> buffer(size);
+
+    // count histograms of all digits in one pass per thread
+    std::vector<Histogram> hist(num_threads * kPasses);
+    RunTasks(num_threads, num_threads,
+             [&](size_t t) {
+                 Histogram* h = hist.data() + t * kPasses;
+                 for (size_t p = 0; p < kPasses; ++p) h[p].fill(0);
+                 for (size_t i = parts[t]; i < parts[t + 1]; ++i) {
+                     Unsigned k = RadixKey<Key>::Get(key_extractor(data[i]));
+                     for (size_t p = 0; p < kPasses; ++p)
+                         ++h[p][static_cast<size_t>(k >> (8 * p)) & 0xFF];
+                 }
+             }, pool);
+
+    ValueType* src = data, * dst = buffer.data();
+    bool first_pass = true;
+
+    std::vector<Histogram> offsets(num_threads);
+    for (size_t p = 0; p < kPasses; ++p)
+    {
+        // global histogram of the digit
+        Histogram total;
+        total.fill(0);
+        for (size_t t = 0; t < num_threads; ++t) {
+            for (size_t d = 0; d < 256; ++d)
+                total[d] += hist[t * kPasses + p][d];
+        }
+
+        // skip passes in which all items have the same digit
+        if (*std::max_element(total.begin(), total.end()) == size)
+            continue;
+
+        auto digit = [&key_extractor, p](const ValueType& v) {
+                         return static_cast<size_t>(
+                             RadixKey<Key>::Get(key_extractor(v)) >> (8 * p))
+                                & 0xFF;
+                     };
+
+        // the items of each thread's part have moved after the first pass,
+        // hence the parts' histograms must be recounted.
+        if (num_threads > 1 && !first_pass) {
+            RunTasks(num_threads, num_threads,
+                     [&](size_t t) {
+                         Histogram& h = hist[t * kPasses + p];
+                         h.fill(0);
+                         for (size_t i = parts[t]; i < parts[t + 1]; ++i)
+                             ++h[digit(src[i])];
+                     }, pool);
+        }
+
+        // bucket offsets of each thread: its buckets follow those of the
+        // preceding threads
+        size_t sum = 0;
+        for (size_t d = 0; d < 256; ++d) {
+            for (size_t t = 0; t < num_threads; ++t) {
+                offsets[t][d] = sum;
+                sum += hist[t * kPasses + p][d];
+            }
+        }
+
+        RunTasks(num_threads, num_threads,
+                 [&](size_t t) {
+                     Scatter(src, parts[t], parts[t + 1], dst, offsets[t],
+                             digit, WriteCombining());
+                 }, pool);
+
+        sLOG << "lsd_radix_sort() pass" << p << "size" << size;
+
+        std::swap(src, dst);
+        first_pass = false;
+    }
+
+    if (src != data) {
+        RunTasks(num_threads, num_threads,
+                 [&](size_t t) {
+                     std::move(src + parts[t], src + parts[t + 1],
+                               data + parts[t]);
+                 }, pool);
+    }
+}
+
+/*!
+ * SortAlgorithm class for use with api::Sort() and api::SortStable() which
+ * calls lsd_radix_sort() with the given key extractor. The compare function of
+ * the Sort() must be the comparison of these keys, e.g. api::LessByKey().
+ */
+template <typename KeyExtractor>
+class LsdRadixSort
+{
+public:
+    explicit LsdRadixSort(const KeyExtractor& key_extractor,
+                          size_t num_threads = 1)
+        : key_extractor_(key_extractor), num_threads_(num_threads) { }
+
+    //! construct with a TaskPool, whose idle helper threads sort the parts
+    LsdRadixSort(const KeyExtractor& key_extractor, TaskPool& pool)
+        : key_extractor_(key_extractor),
+          num_threads_(pool.max_parallelism()), pool_(&pool) { }
+
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end,
+                      const CompareFunction& cmp) const {
+        lsd_radix_sort(begin, end, key_extractor_, num_threads_, pool_);
+        assert(std::is_sorted(begin, end, cmp));
+        tlx::unused(cmp);
+    }
+
+private:
+    KeyExtractor key_extractor_;
+    const size_t num_threads_;
+    TaskPool* pool_ = nullptr;
+};
+
+//! make a LsdRadixSort SortAlgorithm
+template <typename KeyExtractor>
+LsdRadixSort<KeyExtractor> MakeLsdRadixSort(
+    const KeyExtractor& key_extractor, size_t num_threads = 1) {
+    return LsdRadixSort<KeyExtractor>(key_extractor, num_threads);
+}
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_LSD_RADIX_SORT_HEADER
+
+/******************************************************************************/
@@ -55,7 +55,10 @@ public:
     size_t columns() const { return columns_; }
 
     //! raw data of matrix
-    Type * data() const { return data_.data(); }
+    Type * data() { return data_.data(); }
+
+    //! raw data of matrix
+    const Type * data() const { return data_.data(); }
 
     //! size of matrix raw data (rows * columns)
     size_t size() const { return data_.size(); }
@@ -105,6 +108,83 @@ public:
         return *this;
     }
 
+    /*!
+     * Computes y = this * x, where x has columns() and y has rows() entries.
+     * The inner loop runs over contiguous memory, such that the compiler can
+     * vectorize it.
+     */
+    void MultiplyVector(const Type* x, Type* y) const {
+        for (size_t i = 0; i < rows_; ++i) {
+            const Type* row = data_.data() + i * columns_;
+            Type sum = Type();
+            for (size_t k = 0; k < columns_; ++k)
+                sum += row[k] * x[k];
+            y[i] = sum;
+        }
+    }
+
+    /*!
+     * Computes x += transpose(this) * y, where y has rows() and x has
+     * columns() entries.
+     */
+    void TransposeMultiplyVector(const Type* y, Type* x) const {
+        for (size_t i = 0; i < rows_; ++i) {
+            const Type* row = data_.data() + i * columns_;
+            const Type yi = y[i];
+            for (size_t k = 0; k < columns_; ++k)
+                x[k] += yi * row[k];
+        }
+    }
+
+    /*!
+     * Returns this * b, computed in cache blocks of rows of this and rows of b.
+     * The innermost loop runs over contiguous rows of b and the result.
+     */
+    Matrix Multiply(const Matrix& b) const {
+        assert(columns_ == b.rows_);
+        Matrix c(rows_, b.columns_);
+        const size_t n = b.columns_;
+
+        for (size_t i0 = 0; i0 < rows_; i0 += kBlockRows) {
+            size_t i1 = std::min(i0 + kBlockRows, rows_);
+            for (size_t k0 = 0; k0 < columns_; k0 += kBlockInner) {
+                size_t k1 = std::min(k0 + kBlockInner, columns_);
+                for (size_t i = i0; i < i1; ++i) {
+                    Type* crow = c.data_.data() + i * n;
+                    for (size_t k = k0; k < k1; ++k) {
+                        const Type aik = data_[i * columns_ + k];
+                        const Type* brow = b.data_.data() + k * n;
+                        for (size_t j = 0; j < n; ++j)
+                            crow[j] += aik * brow[j];
+                    }
+                }
+            }
+        }
+        return c;
+    }
+
+    /*!
+     * Returns transpose(this) * b, where b has the same number of rows. Both
+     * are traversed row by row, adding the outer products of their rows.
+     */
+    Matrix TransposeMultiply(const Matrix& b) const {
+        assert(rows_ == b.rows_);
+        Matrix c(columns_, b.columns_);
+        const size_t n = b.columns_;
+
+        for (size_t r = 0; r < rows_; ++r) {
+            const Type* arow = data_.data() + r * columns_;
+            const Type* brow = b.data_.data() + r * n;
+            for (size_t i = 0; i < columns_; ++i) {
+                const Type ari = arow[i];
+                Type* crow = c.data_.data() + i * n;
+                for (size_t j = 0; j < n; ++j)
+                    crow[j] += ari * brow[j];
+            }
+        }
+        return c;
+    }
+
     //! equality operator
     bool operator == (const Matrix& b) const noexcept {
         if (rows() != b.rows() || columns() != b.columns()) return false;
@@ -148,6 +228,9 @@ public:
     }
 
 private:
+    //! rows of this and inner dimension of cache blocks in Multiply()
+    static constexpr size_t kBlockRows = 64, kBlockInner = 256;
+
     //! number of rows in matrix
     size_t rows_ = 0;
     //! number of columns in matrix
@@ -0,0 +1,259 @@
+/*******************************************************************************
+ * thrill/common/metrics_server.cpp
+ *
+ * Embedded HTTP server which exposes live metrics of a host in the Prometheus
+ * text format.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/metrics_server.hpp>
+
+#include <thrill/common/config.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if THRILL_HAVE_NET_TCP
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#endif
+
+namespace thrill {
+namespace common {
+
+//! escape a Prometheus label value
+static std::string EscapeLabel(const std::string& s) {
+    std::string out;
+    for (const char& c : s) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        }
+        else if (c == '\n') {
+            out += "\\n";
+        }
+        else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+MetricsServer::~MetricsServer() {
+    terminate_ = true;
+    if (thread_.joinable())
+        thread_.join();
+#if THRILL_HAVE_NET_TCP
+    if (fd_ >= 0)
+        ::close(fd_);
+#endif
+}
+
+void MetricsServer::Set(const std::string& name, double value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    gauges_[name] = value;
+}
+
+void MetricsServer::SetWorkerStage(size_t worker_rank, size_t dia_id,
+                                   const std::string& label, const char* event) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    WorkerStage& w = workers_[worker_rank];
+    if (w.dia_id != 0 && dia_id == 0)
+        ++w.stages;
+    w.dia_id = dia_id;
+    w.label = label;
+    w.event = event;
+    w.start = std::chrono::steady_clock::now();
+}
+
+std::string MetricsServer::Render() {
+    // lines of each metric family, which must be output together
+    std::map<std::string, std::vector<std::string> > families;
+
+    auto add =
+        [&](const std::string& name, const std::string& labels, double value) {
+            std::ostringstream line;
+            line.precision(17);
+            line << name << '{' << host_labels_;
+            if (!labels.empty())
+                line << (host_labels_.empty() ? "" : ",") << labels;
+            line << "} " << value;
+            families[name].emplace_back(line.str());
+        };
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (const std::pair<const std::string, double>& g : gauges_) {
+        std::string::size_type brace = g.first.find('{');
+        if (brace == std::string::npos) {
+            add(g.first, std::string(), g.second);
+        }
+        else {
+            // strip braces of labels given with the name
+            add(g.first.substr(0, brace),
+                g.first.substr(brace + 1, g.first.size() - brace - 2),
+                g.second);
+        }
+    }
+
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+
+    for (const std::pair<const size_t, WorkerStage>& w : workers_) {
+        std::string worker = "worker_rank=\"" + std::to_string(w.first) + "\"";
+        add("thrill_worker_stage",
+            worker + ",dia_id=\"" + std::to_string(w.second.dia_id) +
+            "\",label=\"" + EscapeLabel(w.second.label) +
+            "\",event=\"" + w.second.event + "\"", 1);
+        add("thrill_worker_stage_seconds", worker,
+            w.second.dia_id == 0 ? 0.0 :
+            std::chrono::duration<double>(now - w.second.start).count());
+        add("thrill_worker_stages", worker,
+            static_cast<double>(w.second.stages));
+    }
+
+    lock.unlock();
+
+    std::ostringstream os;
+    for (const std::pair<const std::string, std::vector<std::string> >& f
+         : families) {
+        os << "# TYPE " << f.first << " gauge\n";
+        for (const std::string& line : f.second)
+            os << line << '\n';
+    }
+    return os.str();
+}
+
+#if THRILL_HAVE_NET_TCP
+
+MetricsServer::MetricsServer(uint16_t port, const std::string& host_labels)
+    : host_labels_(host_labels) {
+
+    fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd_ < 0) {
+        std::cerr << "Thrill: could not create metrics socket: "
+                  << strerror(errno) << std::endl;
+        return;
+    }
+
+    int on = 1;
+    ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    socklen_t addr_len = sizeof(addr);
+    if (::bind(fd_, reinterpret_cast<struct sockaddr*>(&addr), addr_len) != 0 ||
+        ::listen(fd_, 16) != 0 ||
+        ::getsockname(
+            fd_, reinterpret_cast<struct sockaddr*>(&addr), &addr_len) != 0) {
+        std::cerr << "Thrill: could not serve metrics on port " << port
+                  << ": " << strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return;
+    }
+
+    port_ = ntohs(addr.sin_port);
+    thread_ = std::thread([this]() { Worker(); });
+}
+
+void MetricsServer::Worker() {
+    while (!terminate_) {
+        struct pollfd pfd;
+        pfd.fd = fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        // wake up regularly to check terminate_
+        if (::poll(&pfd, 1, 100) <= 0) continue;
+
+        int conn = ::accept(fd_, nullptr, nullptr);
+        if (conn < 0) continue;
+        Serve(conn);
+        ::close(conn);
+    }
+}
+
+void MetricsServer::Serve(int conn) {
+    // do not let a slow client block the server for long
+    struct timeval tv;
+    tv.tv_sec = 1, tv.tv_usec = 0;
+    ::setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    // read request header
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < 16 * 1024) {
+        ssize_t rb = ::recv(conn, buffer, sizeof(buffer), 0);
+        if (rb <= 0) break;
+        request.append(buffer, static_cast<size_t>(rb));
+    }
+
+    std::string status, body;
+    if (request.compare(0, 13, "GET /metrics ") == 0 ||
+        request.compare(0, 6, "GET / ") == 0) {
+        status = "200 OK";
+        body = Render();
+    }
+    else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    std::string response =
+        "HTTP/1.0 " + status + "\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+
+#ifdef MSG_NOSIGNAL
+    int flags = MSG_NOSIGNAL;
+#else
+    int flags = 0;
+#endif
+
+    for (size_t pos = 0; pos < response.size(); ) {
+        ssize_t wb = ::send(conn, response.data() + pos,
+                            response.size() - pos, flags);
+        if (wb <= 0) break;
+        pos += static_cast<size_t>(wb);
+    }
+}
+
+#else
+
+MetricsServer::MetricsServer(uint16_t, const std::string& host_labels)
+    : host_labels_(host_labels) {
+    std::cerr << "Thrill: the metrics server is not supported on this platform."
+              << std::endl;
+}
+
+void MetricsServer::Worker() { }
+
+void MetricsServer::Serve(int) { }
+
+#endif // THRILL_HAVE_NET_TCP
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * thrill/common/metrics_server.hpp
+ *
+ * Embedded HTTP server which exposes live metrics of a host in the Prometheus
+ * text format.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_METRICS_SERVER_HEADER
+#define THRILL_COMMON_METRICS_SERVER_HEADER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * MetricsServer keeps the latest values of gauges, which the ProfileTasks of
+ * the host set whenever they run, and the stage each worker is executing. A
+ * background thread answers HTTP requests for /metrics with all values in the
+ * Prometheus text exposition format, so that monitoring can scrape running
+ * jobs instead of parsing the JSON logs afterwards.
+ *
+ * Gauge names may contain Prometheus labels, e.g. `thrill_io_bytes{op="read"}`,
+ * the server adds the host's labels to all of them.
+ */
+class MetricsServer
+{
+public:
+    //! listen on the port on all interfaces, port 0 chooses a free one. host
+    //! labels are added to each metric, e.g. `host_rank="0"`.
+    MetricsServer(uint16_t port, const std::string& host_labels);
+
+    //! non-copyable: delete copy-constructor
+    MetricsServer(const MetricsServer&) = delete;
+    //! non-copyable: delete assignment operator
+    MetricsServer& operator = (const MetricsServer&) = delete;
+
+    //! stop the server thread
+    ~MetricsServer();
+
+    //! port the server listens on, 0 if the socket could not be opened.
+    uint16_t port() const { return port_; }
+
+    //! set current value of a gauge
+    void Set(const std::string& name, double value);
+
+    //! set the stage a worker is executing, dia_id 0 if it is idle.
+    void SetWorkerStage(size_t worker_rank, size_t dia_id,
+                        const std::string& label, const char* event);
+
+    //! output all metrics in Prometheus text format
+    std::string Render();
+
+private:
+    //! stage currently executed by a worker
+    struct WorkerStage {
+        size_t dia_id = 0;
+        std::string label;
+        const char* event = "idle";
+        std::chrono::steady_clock::time_point start;
+        //! number of finished stages
+        size_t stages = 0;
+    };
+
+    //! labels added to all metrics
+    std::string host_labels_;
+
+    //! listening socket
+    int fd_ = -1;
+
+    //! bound port
+    uint16_t port_ = 0;
+
+    //! mutex protecting gauges_ and workers_
+    std::mutex mutex_;
+
+    //! current gauge values by name
+    std::map<std::string, double> gauges_;
+
+    //! stage of each worker of the host, indexed by worker rank
+    std::map<size_t, WorkerStage> workers_;
+
+    //! flag to stop the server thread
+    std::atomic<bool> terminate_ { false };
+
+    //! server thread
+    std::thread thread_;
+
+    //! server thread loop
+    void Worker();
+
+    //! answer one HTTP request on the connection
+    void Serve(int conn);
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_METRICS_SERVER_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,209 @@
+/*******************************************************************************
+ * thrill/common/mpsc_queue.hpp
+ *
+ * Lock-free multiple producer single consumer queue, whose consumer parks on a
+ * futex only when the queue is empty.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_MPSC_QUEUE_HEADER
+#define THRILL_COMMON_MPSC_QUEUE_HEADER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+#if __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace thrill {
+namespace common {
+
+/*!
+ * A lock-free queue for multiple producers and a single consumer, with the
+ * push() / emplace() / pop() / try_pop() interface of ConcurrentBoundedQueue.
+ *
+ * Producers push nodes onto a lock-free stack with one compare-and-swap. The
+ * consumer takes the whole stack with one exchange and reverses it into a
+ * private batch, from which the following pops are served without any atomic
+ * operation. Items are delivered in the order in which their pushes took
+ * effect, hence items pushed by one thread remain in order.
+ *
+ * Only when the stack is empty, pop() parks the consumer on a futex. It first
+ * announces itself in sleeping_ and then checks the stack once more, and a
+ * producer wakes it if it sees the announcement after its push, hence no
+ * wake-up is lost. Producers only pay for a syscall if the consumer sleeps.
+ * On other systems the consumer yields instead of parking.
+ *
+ * StyleGuide is violated, because signatures are expected to match those of
+ * std::queue.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    struct Node {
+        T     value;
+        Node* next;
+    };
+
+    //! top of the stack of pushed nodes, the most recent push first.
+    std::atomic<Node*> head_ { nullptr };
+
+    //! futex word: 1 while the consumer is parked or about to park.
+    std::atomic<uint32_t> sleeping_ { 0 };
+
+    //! batch of nodes taken by the consumer, in push order.
+    Node* batch_ = nullptr;
+
+public:
+    //! default constructor
+    MpscQueue() = default;
+
+    //! non-copyable: delete copy-constructor
+    MpscQueue(const MpscQueue&) = delete;
+    //! non-copyable: delete assignment operator
+    MpscQueue& operator = (const MpscQueue&) = delete;
+
+    //! move-constructor, must not run concurrently with other operations.
+    MpscQueue(MpscQueue&& other)
+        : head_(other.head_.exchange(nullptr)),
+          batch_(other.batch_) {
+        other.batch_ = nullptr;
+    }
+
+    //! destructor: delete the remaining items.
+    ~MpscQueue() {
+        DeleteList(batch_);
+        DeleteList(head_.load());
+    }
+
+    //! Pushes a copy of source onto back of the queue.
+    void push(const T& source) {
+        PushNode(new Node { source, nullptr });
+    }
+
+    //! Pushes given element into the queue by utilizing element's move
+    //! constructor
+    void push(T&& elem) {
+        PushNode(new Node { std::move(elem), nullptr });
+    }
+
+    //! Pushes a new element into the queue. The element is constructed with
+    //! given arguments.
+    template <typename... Arguments>
+    void emplace(Arguments&& ... args) {
+        PushNode(new Node { T(std::forward<Arguments>(args) ...), nullptr });
+    }
+
+    //! Returns: true if queue has no items; false otherwise. Only exact for
+    //! the consumer thread.
+    bool empty() const {
+        return batch_ == nullptr && head_.load() == nullptr;
+    }
+
+    //! If value is available, pops it from the queue, move it to destination,
+    //! destroying the original position. Otherwise does nothing. Consumer only.
+    bool try_pop(T& destination) {
+        if (!batch_ && !TakeBatch())
+            return false;
+        PopNode(destination);
+        return true;
+    }
+
+    //! If value is available, pops it from the queue, move it to
+    //! destination. If no item is in the queue, wait until there is one.
+    //! Consumer only.
+    void pop(T& destination) {
+        while (!batch_ && !TakeBatch())
+            Park();
+        PopNode(destination);
+    }
+
+private:
+    void PushNode(Node* node) {
+        Node* head = head_.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!head_.compare_exchange_weak(
+                     head, node, std::memory_order_seq_cst,
+                     std::memory_order_relaxed));
+
+        // wake the consumer, if it announced to park before our push.
+        if (sleeping_.load(std::memory_order_seq_cst) != 0) {
+            sleeping_.store(0, std::memory_order_seq_cst);
+#if __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sleeping_),
+                    FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+        }
+    }
+
+    //! take all pushed nodes and reverse them into the batch, returns false
+    //! if there were none.
+    bool TakeBatch() {
+        Node* list = head_.exchange(nullptr, std::memory_order_seq_cst);
+        if (!list) return false;
+        Node* batch = nullptr;
+        while (list) {
+            Node* next = list->next;
+            list->next = batch;
+            batch = list;
+            list = next;
+        }
+        batch_ = batch;
+        return true;
+    }
+
+    void PopNode(T& destination) {
+        Node* node = batch_;
+        batch_ = node->next;
+        destination = std::move(node->value);
+        delete node;
+    }
+
+    //! sleep until a producer pushes, may return spuriously.
+    void Park() {
+        sleeping_.store(1, std::memory_order_seq_cst);
+        if (head_.load(std::memory_order_seq_cst) == nullptr) {
+#if __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sleeping_),
+                    FUTEX_WAIT_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+            std::this_thread::yield();
+#endif
+        }
+        sleeping_.store(0, std::memory_order_seq_cst);
+    }
+
+    static void DeleteList(Node* node) {
+        while (node) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_MPSC_QUEUE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,306 @@
+/*******************************************************************************
+ * thrill/common/parallel_sort.hpp
+ *
+ * Parallel multiway mergesort using a fixed number of threads: sort p runs
+ * concurrently, then merge pairs of runs in log(p) rounds. Each pairwise merge
+ * is itself split into pieces using co-ranking binary searches, such that all
+ * threads are busy in all rounds. Requires n extra items of memory.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_PARALLEL_SORT_HEADER
+#define THRILL_COMMON_PARALLEL_SORT_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/porting.hpp>
+#include <thrill/common/task_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace common {
+namespace parallel_sort_local {
+
+/*!
+ * Run function f(i) for i in [0,num_tasks) on num_threads threads, the calling
+ * thread being one of them. Tasks are fetched from an atomic counter. If a
+ * TaskPool is given, the tasks are run by its idle helper threads instead.
+ */
+template <typename Function>
+void RunTasks(size_t num_tasks, size_t num_threads, const Function& f,
+              TaskPool* pool = nullptr) {
+    if (pool) {
+        pool->Run(num_tasks, f);
+        return;
+    }
+    num_threads = std::min(num_tasks, num_threads);
+    if (num_threads <= 1) {
+        for (size_t i = 0; i < num_tasks; ++i) f(i);
+        return;
+    }
+
+    std::atomic<size_t> next_task { 0 };
+    auto worker = [&]() {
+                      size_t i;
+                      while ((i = next_task++) < num_tasks) f(i);
+                  };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; ++t)
+        threads.emplace_back(CreateThread(worker));
+    worker();
+    for (std::thread& t : threads) t.join();
+}
+
+/*!
+ * Calculate the co-rank of rank k in the stable merge of [a,a+na) and
+ * [b,b+nb): returns i such that the first k output elements are a[0,i) and
+ * b[0,k-i). Equal elements are taken from a first.
+ */
+template <typename Iterator, typename Comparator>
+size_t CoRank(size_t k, Iterator a, size_t na, Iterator b, size_t nb,
+              const Comparator& cmp) {
+    size_t lo = k > nb ? k - nb : 0, hi = std::min(k, na);
+    while (lo < hi) {
+        size_t i = (lo + hi) / 2, j = k - i;
+        // if a[i] <= b[j-1], then a[i] must be in the first k output items.
+        if (j > 0 && !cmp(b[j - 1], a[i]))
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+//! SubSorter calling std::sort()
+struct StdSort {
+    template <typename Iterator, typename Comparator>
+    void operator () (Iterator begin, Iterator end,
+                      const Comparator& cmp) const {
+        std::sort(begin, end, cmp);
+    }
+};
+
+//! SubSorter calling std::stable_sort()
+struct StdStableSort {
+    template <typename Iterator, typename Comparator>
+    void operator () (Iterator begin, Iterator end,
+                      const Comparator& cmp) const {
+        std::stable_sort(begin, end, cmp);
+    }
+};
+
+} // namespace parallel_sort_local
+
+/*!
+ * Sort the iterator range [begin,end) using num_threads threads (including the
+ * calling thread). The algorithm is a stable parallel mergesort if the
+ * SubSorter is stable. Runs are sorted using the SubSorter, which defaults to
+ * std::sort(), and are called as sub_sort(begin, end, cmp). If a TaskPool is
+ * given, the num_threads runs are processed by its helper threads.
+ */
+template <typename Iterator,
+          typename Comparator =
+              std::less<typename std::iterator_traits<Iterator>::value_type>,
+          typename SubSorter = parallel_sort_local::StdSort>
+void parallel_mergesort(
+    Iterator begin, Iterator end, const Comparator& cmp, size_t num_threads,
+    const SubSorter& sub_sort = SubSorter(), TaskPool* pool = nullptr) {
+
+    using value_type = typename std::iterator_traits<Iterator>::value_type;
+    using parallel_sort_local::RunTasks;
+    using parallel_sort_local::CoRank;
+
+    static constexpr bool debug = false;
+
+    //! minimum size of each thread's run, below it fewer threads are used.
+    static constexpr size_t kMinRunSize = 16384;
+
+    const size_t size = end - begin;
+    num_threads = std::max<size_t>(
+        1, std::min(num_threads, size / kMinRunSize));
+
+    if (num_threads <= 1) {
+        sub_sort(begin, end, cmp);
+        return;
+    }
+
+    sLOG << "parallel_mergesort() size" << size << "threads" << num_threads;
+
+    //! run boundaries
+    std::vector<size_t> runs(num_threads + 1);
+    for (size_t t = 0; t <= num_threads; ++t)
+        runs[t] = size * t / num_threads;
+
+    // sort runs concurrently
+    RunTasks(num_threads, num_threads,
+             [&](size_t t) {
+                 sub_sort(begin + runs[t], begin + runs[t + 1], cmp);
+             }, pool);
+
+    // merge pairs of runs back and forth between begin and buffer
+    std::vector<value_type> buffer(size);
+    bool in_buffer = false;
+
+    //! description of a merge piece: two input ranges and an output position
+    struct Piece {
+        size_t a_begin, a_end, b_begin, b_end, out;
+    };
+    std::vector<Piece> pieces;
+
+    while (runs.size() > 2)
+    {
+        pieces.clear();
+        std::vector<size_t> new_runs;
+        new_runs.reserve(runs.size() / 2 + 2);
+
+        for (size_t r = 0; r + 1 < runs.size(); r += 2)
+        {
+            new_runs.push_back(runs[r]);
+
+            if (r + 2 >= runs.size()) {
+                // odd run out: copy over as a single piece
+                pieces.emplace_back(
+                    Piece { runs[r], runs[r + 1], runs[r + 1], runs[r + 1],
+                            runs[r] });
+                continue;
+            }
+
+            size_t a = runs[r], na = runs[r + 1] - runs[r];
+            size_t b = runs[r + 1], nb = runs[r + 2] - runs[r + 1];
+
+            // split merge into pieces proportional to its share of the data
+            size_t num_pieces = std::max<size_t>(
+                1, (num_threads * (na + nb) + size - 1) / size);
+
+            size_t prev_i = 0, prev_k = 0;
+            for (size_t p = 1; p <= num_pieces; ++p)
+            {
+                size_t k = (na + nb) * p / num_pieces, i;
+                if (in_buffer)
+                    i = CoRank(k, buffer.begin() + a, na,
+                               buffer.begin() + b, nb, cmp);
+                else
+                    i = CoRank(k, begin + a, na, begin + b, nb, cmp);
+
+                pieces.emplace_back(
+                    Piece { a + prev_i, a + i,
+                            b + (prev_k - prev_i), b + (k - i), a + prev_k });
+                prev_i = i, prev_k = k;
+            }
+        }
+        new_runs.push_back(size);
+
+        // execute merge pieces
+        RunTasks(pieces.size(), num_threads,
+                 [&](size_t p) {
+                     const Piece& pc = pieces[p];
+                     if (in_buffer) {
+                         std::merge(
+                             std::make_move_iterator(buffer.begin() + pc.a_begin),
+                             std::make_move_iterator(buffer.begin() + pc.a_end),
+                             std::make_move_iterator(buffer.begin() + pc.b_begin),
+                             std::make_move_iterator(buffer.begin() + pc.b_end),
+                             begin + pc.out, cmp);
+                     }
+                     else {
+                         std::merge(
+                             std::make_move_iterator(begin + pc.a_begin),
+                             std::make_move_iterator(begin + pc.a_end),
+                             std::make_move_iterator(begin + pc.b_begin),
+                             std::make_move_iterator(begin + pc.b_end),
+                             buffer.begin() + pc.out, cmp);
+                     }
+                 }, pool);
+
+        in_buffer = !in_buffer;
+        std::swap(runs, new_runs);
+    }
+
+    if (in_buffer) {
+        // move items back in parallel
+        RunTasks(num_threads, num_threads,
+                 [&](size_t t) {
+                     size_t lo = size * t / num_threads;
+                     size_t hi = size * (t + 1) / num_threads;
+                     std::move(buffer.begin() + lo, buffer.begin() + hi,
+                               begin + lo);
+                 }, pool);
+    }
+}
+
+/*!
+ * SortAlgorithm class for use with api::Sort() which calls
+ * parallel_mergesort() with a fixed number of threads. Use
+ * Context::num_threads_per_worker() to sort with the cores not assigned to a
+ * worker, or Context::task_pool() to borrow the idle cores of the host.
+ */
+class ParallelSort
+{
+public:
+    //! construct with number of threads, 0 = std::thread::hardware_concurrency()
+    explicit ParallelSort(size_t num_threads = 0)
+        : num_threads_(num_threads != 0
+                       ? num_threads : std::thread::hardware_concurrency()) { }
+
+    //! construct with a TaskPool, whose idle helper threads sort the runs
+    explicit ParallelSort(TaskPool& pool)
+        : num_threads_(pool.max_parallelism()), pool_(&pool) { }
+
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end,
+                      const CompareFunction& cmp) const {
+        parallel_mergesort(begin, end, cmp, num_threads_,
+                           parallel_sort_local::StdSort(), pool_);
+    }
+
+private:
+    const size_t num_threads_;
+    TaskPool* pool_ = nullptr;
+};
+
+/*!
+ * SortAlgorithm class for use with api::SortStable() which calls
+ * parallel_mergesort() with std::stable_sort() on the runs.
+ */
+class ParallelStableSort
+{
+public:
+    //! construct with number of threads, 0 = std::thread::hardware_concurrency()
+    explicit ParallelStableSort(size_t num_threads = 0)
+        : num_threads_(num_threads != 0
+                       ? num_threads : std::thread::hardware_concurrency()) { }
+
+    //! construct with a TaskPool, whose idle helper threads sort the runs
+    explicit ParallelStableSort(TaskPool& pool)
+        : num_threads_(pool.max_parallelism()), pool_(&pool) { }
+
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end,
+                      const CompareFunction& cmp) const {
+        parallel_mergesort(begin, end, cmp, num_threads_,
+                           parallel_sort_local::StdStableSort(), pool_);
+    }
+
+private:
+    const size_t num_threads_;
+    TaskPool* pool_ = nullptr;
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_PARALLEL_SORT_HEADER
+
+/******************************************************************************/
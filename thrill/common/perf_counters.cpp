@@ -0,0 +1,291 @@
+/*******************************************************************************
+ * thrill/common/perf_counters.cpp
+ *
+ * Profiling Task which reads hardware performance counters of the worker
+ * threads via Linux's perf_event_open() and attributes them to DIA nodes.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/perf_counters.hpp>
+
+#include <thrill/common/json_logger.hpp>
+#include <thrill/common/profile_thread.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+
+#if __linux__
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+namespace thrill {
+namespace common {
+
+//! DIA node the calling thread is working on
+static thread_local size_t s_thread_dia_id = 0;
+
+//! field names of the events in the log
+static const char* s_perf_event_names[PerfCounterProfiler::NumEvents] = {
+    "cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"
+};
+
+#if __linux__
+
+//! counters of one worker thread
+struct PerfCounterProfiler::Thread {
+    using Counts = std::array<uint64_t, NumEvents>;
+
+    explicit Thread(size_t rank) : worker_rank(rank) {
+        fd.fill(-1);
+        last.fill(0);
+    }
+
+    ~Thread() {
+        for (const int& f : fd) {
+            if (f >= 0) close(f);
+        }
+    }
+
+    //! worker rank of the thread
+    size_t worker_rank;
+
+    //! perf event file descriptors, -1 if not supported
+    std::array<int, NumEvents> fd;
+
+    //! mutex protecting the following, taken by the thread when switching DIA
+    //! nodes and by the ProfileThread when reporting
+    std::mutex mutex;
+
+    //! counter values at the last read
+    Counts last;
+
+    //! DIA node the thread is working on
+    size_t dia_id = 0;
+
+    //! counts accumulated per DIA node since the last report
+    std::map<size_t, Counts> pending;
+
+    //! read counter, scaled up if the kernel multiplexed it with others
+    static uint64_t Read(int f) {
+        // value, time_enabled, time_running
+        uint64_t v[3];
+        if (::read(f, v, sizeof(v)) != sizeof(v) || v[2] == 0) return 0;
+        if (v[2] >= v[1]) return v[0];
+        return static_cast<uint64_t>(
+            static_cast<double>(v[0]) * v[1] / v[2]);
+    }
+
+    //! add the counts since the last read to the current DIA node, requires
+    //! mutex.
+    void Attribute() {
+        Counts& c = pending.emplace(dia_id, Counts { }).first->second;
+        for (size_t e = 0; e < NumEvents; ++e) {
+            if (fd[e] < 0) continue;
+            uint64_t v = Read(fd[e]);
+            // scaled values are estimates and may decrease
+            if (v > last[e]) {
+                c[e] += v - last[e];
+                last[e] = v;
+            }
+        }
+    }
+};
+
+PerfCounterProfiler::Thread*& PerfCounterProfiler::LocalThread() {
+    static thread_local Thread* s_thread = nullptr;
+    return s_thread;
+}
+
+//! open a user space counter of the calling thread on any CPU
+static int OpenPerfEvent(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = type;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+#ifdef PERF_FLAG_FD_CLOEXEC
+    unsigned long flags = PERF_FLAG_FD_CLOEXEC;
+#else
+    unsigned long flags = 0;
+#endif
+
+    return static_cast<int>(
+        syscall(__NR_perf_event_open, &attr, /* pid */ 0, /* cpu */ -1,
+                /* group_fd */ -1, flags));
+}
+
+PerfCounterProfiler::PerfCounterProfiler(JsonLogger& logger)
+    : logger_(logger) { }
+
+PerfCounterProfiler::~PerfCounterProfiler() = default;
+
+bool PerfCounterProfiler::AddThread(size_t worker_rank) {
+    if (LocalThread() != nullptr) return true;
+
+    static const std::pair<uint32_t, uint64_t> events[NumEvents] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        // generic cache misses are last level cache misses on most CPUs
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE,
+          PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) }
+    };
+
+    std::unique_ptr<Thread> t = std::make_unique<Thread>(worker_rank);
+    bool any = false;
+    int error = 0;
+    for (size_t e = 0; e < NumEvents; ++e) {
+        t->fd[e] = OpenPerfEvent(events[e].first, events[e].second);
+        if (t->fd[e] >= 0)
+            any = true;
+        else
+            error = errno;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!any) {
+        if (!warned_) {
+            std::cerr << "Thrill: could not open hardware performance counters"
+                      << " for THRILL_PERF_COUNTERS: " << strerror(error)
+                      << ", see /proc/sys/kernel/perf_event_paranoid"
+                      << std::endl;
+            warned_ = true;
+        }
+        return false;
+    }
+
+    // start counting from here
+    t->dia_id = s_thread_dia_id;
+    t->Attribute();
+    t->pending.clear();
+
+    LocalThread() = t.get();
+    threads_.emplace_back(std::move(t));
+    return true;
+}
+
+void PerfCounterProfiler::RemoveThread() {
+    Thread* t = LocalThread();
+    if (t == nullptr) return;
+    LocalThread() = nullptr;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Report(*t);
+    threads_.erase(
+        std::find_if(threads_.begin(), threads_.end(),
+                     [t](const std::unique_ptr<Thread>& p) {
+                         return p.get() == t;
+                     }));
+}
+
+size_t PerfCounterProfiler::SetThreadDIA(size_t dia_id) {
+    size_t prev = s_thread_dia_id;
+    s_thread_dia_id = dia_id;
+
+    if (Thread* t = LocalThread()) {
+        std::unique_lock<std::mutex> lock(t->mutex);
+        t->Attribute();
+        t->dia_id = dia_id;
+    }
+    return prev;
+}
+
+void PerfCounterProfiler::Report(Thread& t) {
+    std::map<size_t, Thread::Counts> pending;
+    {
+        std::unique_lock<std::mutex> lock(t.mutex);
+        t.Attribute();
+        std::swap(pending, t.pending);
+    }
+
+    for (const std::pair<const size_t, Thread::Counts>& p : pending) {
+        if (p.second[Cycles] == 0 && p.second[Instructions] == 0) continue;
+
+        JsonLine out = logger_.line();
+        out << "class" << "PerfCounters"
+            << "event" << "profile"
+            << "worker_rank" << t.worker_rank
+            << "dia_id" << p.first;
+        for (size_t e = 0; e < NumEvents; ++e) {
+            if (t.fd[e] >= 0)
+                out << s_perf_event_names[e] << p.second[e];
+        }
+    }
+}
+
+void PerfCounterProfiler::RunTask(const std::chrono::steady_clock::time_point&) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (std::unique_ptr<Thread>& t : threads_)
+        Report(*t);
+}
+
+#else
+
+struct PerfCounterProfiler::Thread { };
+
+PerfCounterProfiler::PerfCounterProfiler(JsonLogger& logger)
+    : logger_(logger) { }
+
+PerfCounterProfiler::~PerfCounterProfiler() = default;
+
+bool PerfCounterProfiler::AddThread(size_t) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!warned_) {
+        std::cerr << "Thrill: THRILL_PERF_COUNTERS requires Linux's"
+                  << " perf_event_open()." << std::endl;
+        warned_ = true;
+    }
+    return false;
+}
+
+void PerfCounterProfiler::RemoveThread() { }
+
+size_t PerfCounterProfiler::SetThreadDIA(size_t dia_id) {
+    size_t prev = s_thread_dia_id;
+    s_thread_dia_id = dia_id;
+    return prev;
+}
+
+void PerfCounterProfiler::Report(Thread&) { }
+
+void PerfCounterProfiler::RunTask(const std::chrono::steady_clock::time_point&)
+{ }
+
+#endif  // __linux__
+
+PerfCounterProfiler* StartPerfCounterProfiler(
+    ProfileThread& sched, JsonLogger& logger) {
+    const char* env = getenv("THRILL_PERF_COUNTERS");
+    if (!env || !*env || strcmp(env, "0") == 0) return nullptr;
+
+    PerfCounterProfiler* task = new PerfCounterProfiler(logger);
+    sched.Add(std::chrono::seconds(1), task, /* own_task */ true);
+    return task;
+}
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
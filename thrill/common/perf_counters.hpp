@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * thrill/common/perf_counters.hpp
+ *
+ * Profiling Task which reads hardware performance counters of the worker
+ * threads via Linux's perf_event_open() and attributes them to DIA nodes.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_PERF_COUNTERS_HEADER
+#define THRILL_COMMON_PERF_COUNTERS_HEADER
+
+#include <thrill/common/profile_task.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+// forward declarations
+class JsonLogger;
+class ProfileThread;
+
+/*!
+ * Counts cycles, instructions, LLC misses, branch misses, and dTLB misses of
+ * each registered worker thread in user space. The counters are read whenever
+ * the thread switches to another DIA node, and the differences are attributed
+ * to the node the thread was working on (dia_id 0 outside of stages). Every
+ * second, the accumulated counts are written as "PerfCounters" events, from
+ * which json2profile calculates IPC and misses per kilo-instruction of each
+ * DIA node.
+ *
+ * Opening the counters may be refused by the kernel, see
+ * /proc/sys/kernel/perf_event_paranoid, in which case a warning is printed
+ * once and the thread is not counted.
+ */
+class PerfCounterProfiler final : public ProfileTask
+{
+public:
+    //! hardware events counted
+    enum Event {
+        Cycles, Instructions, LlcMisses, BranchMisses, DtlbMisses, NumEvents
+    };
+
+    explicit PerfCounterProfiler(JsonLogger& logger);
+
+    //! non-copyable: delete copy-constructor
+    PerfCounterProfiler(const PerfCounterProfiler&) = delete;
+    //! non-copyable: delete assignment operator
+    PerfCounterProfiler& operator = (const PerfCounterProfiler&) = delete;
+
+    ~PerfCounterProfiler();
+
+    //! open the counters of the calling worker thread. Returns false if the
+    //! kernel does not allow any of them.
+    bool AddThread(size_t worker_rank);
+
+    //! report and close the counters of the calling worker thread
+    void RemoveThread();
+
+    //! set the DIA node the calling thread is working on, returns the previous
+    //! one. Cheap if the thread is not counted.
+    static size_t SetThreadDIA(size_t dia_id);
+
+    //! method called by ProfileThread.
+    void RunTask(const std::chrono::steady_clock::time_point& tp) final;
+
+private:
+    struct Thread;
+
+    //! output logger
+    JsonLogger& logger_;
+
+    //! mutex protecting threads_
+    std::mutex mutex_;
+
+    //! counters of all registered threads
+    std::vector<std::unique_ptr<Thread> > threads_;
+
+    //! whether the warning about refused counters was printed
+    bool warned_ = false;
+
+    //! counters of the calling thread, if registered
+    static Thread*& LocalThread();
+
+    //! write accumulated counts of a thread to the log
+    void Report(Thread& t);
+};
+
+/*!
+ * RAII scope attributing the hardware counters of the calling thread to a DIA
+ * node, used by the StageBuilder around Execute() and PushData().
+ */
+class PerfCounterScope
+{
+public:
+    explicit PerfCounterScope(size_t dia_id)
+        : prev_(PerfCounterProfiler::SetThreadDIA(dia_id)) { }
+
+    //! non-copyable: delete copy-constructor
+    PerfCounterScope(const PerfCounterScope&) = delete;
+    //! non-copyable: delete assignment operator
+    PerfCounterScope& operator = (const PerfCounterScope&) = delete;
+
+    ~PerfCounterScope() { PerfCounterProfiler::SetThreadDIA(prev_); }
+
+private:
+    size_t prev_;
+};
+
+//! launch profiler task if THRILL_PERF_COUNTERS is set, returns nullptr
+//! otherwise. The task is owned by the ProfileThread.
+PerfCounterProfiler* StartPerfCounterProfiler(
+    ProfileThread& sched, JsonLogger& logger);
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_PERF_COUNTERS_HEADER
+
+/******************************************************************************/
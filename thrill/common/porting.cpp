@@ -20,6 +20,9 @@
 
 #include <fcntl.h>
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #include <mutex>
 #include <sstream>
@@ -30,6 +33,10 @@
 
 #include <unistd.h>
 
+#if __linux__
+#include <sys/syscall.h>
+#endif
+
 #else
 
 #include <io.h>
@@ -118,16 +125,18 @@ static size_t getIntFromEnv(const char *name, size_t default_val) {
 }
 
 static size_t queryCpuId(size_t in_cpu_id) {
+  // pin only to the cpus available to the process, e.g. in a container.
+  const std::vector<size_t> &cpus = GetAvailableCpus();
   auto fromId = getIntFromEnv("THRILL_BIND_START", 0);
   auto stride = getIntFromEnv("THRILL_BIND_STRIDE", 1);
-  assert(std::thread::hardware_concurrency() % stride == 0);
-  size_t cpu_id = in_cpu_id % (std::thread::hardware_concurrency() / stride);
-  size_t physical_id = fromId + stride * cpu_id;
-  if (physical_id >= std::thread::hardware_concurrency()) {
+  assert(cpus.size() % stride == 0);
+  size_t cpu_id = in_cpu_id % (cpus.size() / stride);
+  size_t index = fromId + stride * cpu_id;
+  if (index >= cpus.size()) {
     LOG1 << "Impossible";
     std::abort();
   }
-  return physical_id;
+  return cpus[index];
 }
 
 void SetCpuAffinity(std::thread &thread, size_t cpu_id) {
@@ -164,6 +173,163 @@ void SetCpuAffinity(size_t cpu_id) {
 #endif
 }
 
+size_t GetNumaNodeCount() {
+#if __linux__
+  // count /sys/devices/system/node/node<N> directories
+  DIR *dir = opendir("/sys/devices/system/node");
+  if (dir == nullptr)
+    return 1;
+
+  size_t count = 0;
+  while (struct dirent *de = ts_readdir(dir)) {
+    if (strncmp(de->d_name, "node", 4) == 0 && isdigit(de->d_name[4]))
+      ++count;
+  }
+  closedir(dir);
+  return count != 0 ? count : 1;
+#else
+  return 1;
+#endif
+}
+
+size_t GetNumaNode() {
+#if __linux__ && defined(SYS_getcpu)
+  unsigned cpu = 0, node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+    return 0;
+  return node;
+#else
+  return 0;
+#endif
+}
+
+bool BindMemoryToNumaNode(void *addr, size_t size, size_t node) {
+#if __linux__ && defined(SYS_mbind) && !THRILL_ON_TRAVIS
+  // constants from <numaif.h>, which is only available with libnuma
+  static constexpr int mpol_preferred = 1;
+  static constexpr unsigned mpol_mf_move = 1 << 1;
+
+  // node mask for up to 256 nodes
+  static constexpr size_t bits = 8 * sizeof(unsigned long);
+  unsigned long nodemask[256 / bits] = {0};
+  if (node >= 256)
+    return false;
+  nodemask[node / bits] |= 1UL << (node % bits);
+
+  // maxnode counts one more than the number of bits used by the kernel
+  return syscall(SYS_mbind, addr, size, mpol_preferred, nodemask, 256 + 1,
+                 mpol_mf_move) == 0;
+#else
+  tlx::unused(addr);
+  tlx::unused(size);
+  tlx::unused(node);
+  return false;
+#endif
+}
+
+const std::vector<size_t> &GetAvailableCpus() {
+  static const std::vector<size_t> cpus = []() {
+    std::vector<size_t> result;
+#if __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    if (sched_getaffinity(0, sizeof(cpuset), &cpuset) == 0) {
+      for (size_t i = 0; i < CPU_SETSIZE; ++i) {
+        if (CPU_ISSET(i, &cpuset))
+          result.push_back(i);
+      }
+    }
+#endif
+    if (result.empty()) {
+      for (size_t i = 0; i < std::max(1u, std::thread::hardware_concurrency());
+           ++i)
+        result.push_back(i);
+    }
+    return result;
+  }();
+  return cpus;
+}
+
+std::vector<std::string> GetCgroupFiles(const std::string &controller,
+                                        const std::string &file_v1,
+                                        const std::string &file_v2) {
+  std::vector<std::string> result;
+#if __linux__
+  // lines of /proc/self/cgroup are "id:controllers:path", v2 has no
+  // controllers.
+  std::ifstream in("/proc/self/cgroup");
+  std::string line, base, path;
+  while (std::getline(in, line)) {
+    std::string::size_type c1 = line.find(':');
+    std::string::size_type c2 = line.find(':', c1 + 1);
+    if (c1 == std::string::npos || c2 == std::string::npos)
+      continue;
+    std::string controllers = line.substr(c1 + 1, c2 - c1 - 1);
+
+    bool match = false;
+    std::istringstream cs(controllers);
+    std::string name;
+    while (std::getline(cs, name, ','))
+      match = match || name == controller;
+
+    if (match) {
+      base = "/sys/fs/cgroup/" + controllers, path = line.substr(c2 + 1);
+      break;
+    }
+    if (controllers.empty() && base.empty())
+      path = line.substr(c2 + 1);
+  }
+  const std::string &file = base.empty() ? file_v2 : file_v1;
+  if (base.empty())
+    base = "/sys/fs/cgroup";
+
+  // walk up the hierarchy. in a container with its own cgroup namespace the
+  // path may not exist, but the container's cgroup is mounted at the root.
+  while (true) {
+    std::string dir = base + path;
+    if (dir.back() != '/')
+      dir += '/';
+    std::string fn = dir + file;
+    if (std::ifstream(fn).good())
+      result.push_back(fn);
+    if (path.empty() || path == "/")
+      break;
+    path = path.substr(0, path.rfind('/'));
+  }
+#else
+  tlx::unused(controller);
+  tlx::unused(file_v1);
+  tlx::unused(file_v2);
+#endif
+  return result;
+}
+
+size_t GetAvailableCores() {
+  size_t cores = GetAvailableCpus().size();
+#if __linux__
+  // cgroup v2: "cpu.max" contains "<quota> <period>" or "max <period>"
+  for (const std::string &fn : GetCgroupFiles("cpu", "cpu.cfs_quota_us",
+                                              "cpu.max")) {
+    std::ifstream in(fn);
+    std::string quota_str;
+    long long quota = -1, period = 100000;
+    if (!(in >> quota_str) || quota_str == "max")
+      continue;
+    quota = atoll(quota_str.c_str());
+    if (!(in >> period)) {
+      // cgroup v1: period in a separate file, quota -1 means no limit
+      std::ifstream pin(fn.substr(0, fn.rfind('/')) + "/cpu.cfs_period_us");
+      if (!(pin >> period))
+        continue;
+    }
+    if (quota <= 0 || period <= 0)
+      continue;
+    cores = std::min<size_t>(cores, (quota + period - 1) / period);
+  }
+#endif
+  return std::max<size_t>(cores, 1);
+}
+
 std::string GetHostname() {
 #if __linux__
   char buffer[64];
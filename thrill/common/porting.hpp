@@ -23,6 +23,7 @@ using ssize_t = SSIZE_T;
 #include <string>
 #include <system_error>
 #include <thread>
+#include <vector>
 
 #include <dirent.h>
 
@@ -62,6 +63,33 @@ void SetCpuAffinity(std::thread& thread, size_t cpu_id);
 //! set cpu/core affinity of current thread
 void SetCpuAffinity(size_t cpu_id);
 
+//! get number of NUMA nodes of the host, 1 if unknown
+size_t GetNumaNodeCount();
+
+//! get NUMA node of the cpu the current thread runs on, 0 if unknown
+size_t GetNumaNode();
+
+//! set the memory policy of [addr, addr + size) to prefer NUMA node node and
+//! move already allocated pages there. addr and size must be page aligned.
+//! returns false if not supported or failed.
+bool BindMemoryToNumaNode(void* addr, size_t size, size_t node);
+
+//! get the ids of the cpus the process may run on, which is the affinity mask
+//! of the calling thread at the first call, e.g. the cpuset of a container.
+//! All cpus if unknown.
+const std::vector<size_t>& GetAvailableCpus();
+
+//! get the number of cores usable by the process: the available cpus, limited
+//! by the cpu quota of its cgroup (v1 or v2), rounded up. At least one.
+size_t GetAvailableCores();
+
+//! get the paths of a file in the cgroup of the process and in its ancestors,
+//! starting with its own cgroup, which exist. Uses the cgroup v1 hierarchy of
+//! controller if mounted, else file_v2 in the unified v2 hierarchy.
+std::vector<std::string> GetCgroupFiles(
+    const std::string& controller,
+    const std::string& file_v1, const std::string& file_v2);
+
 //! get hostname
 std::string GetHostname();
 
@@ -15,9 +15,12 @@
 
 #include <thrill/common/logger.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
 #include <random>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -322,6 +325,107 @@ private:
     }
 };
 
+/*!
+ * Implementation of weighted reservoir sampling without replacement using
+ * Algorithm A-ExpJ from Efraimidis and Spirakis: "Weighted random sampling with
+ * a reservoir", IPL 2006. Each item with weight w gets the key u^(1/w) for a
+ * uniform random u, and the items with the largest keys form the sample. Once
+ * the reservoir is full, exponential jumps skip items by their accumulated
+ * weight, such that only O(size * log(n / size)) random numbers are drawn.
+ *
+ * Keys are stored as log(u) / w, which preserves their order and does not
+ * underflow for large weights. Items with weight <= 0 are never sampled. As
+ * the keys are independent, reservoirs of disjoint streams are merged by
+ * selecting the largest keys of their union.
+ */
+template <typename Type, typename RNG = std::default_random_engine>
+class WeightedReservoirSampling
+{
+public:
+    //! sampled item with its logarithmic key
+    using Item = std::pair<double, Type>;
+
+    //! initialize weighted reservoir sampler
+    WeightedReservoirSampling(size_t size, RNG& rng)
+        : size_(size), rng_(rng) {
+        samples_.reserve(size_);
+    }
+
+    //! visit item with weight, maybe add it to the sample.
+    void add(const Type& item, double weight) {
+        ++count_;
+        if (!(weight > 0.0) || size_ == 0) return;
+
+        if (samples_.size() < size_) {
+            // if reservoir is too small then store item
+            samples_.emplace_back(std::log(uniform_open()) / weight, item);
+            std::push_heap(samples_.begin(), samples_.end(), KeyGreater());
+            if (samples_.size() == size_)
+                calc_next_jump();
+            return;
+        }
+
+        jump_ -= weight;
+        if (jump_ > 0.0) return;
+
+        // jump elapsed: the item replaces the item with the smallest key. Its
+        // key is drawn conditioned on exceeding the smallest key T, by drawing
+        // u uniform in (T^w, 1).
+        double tw = std::exp(samples_.front().first * weight);
+        double u = tw + (1.0 - tw) * uniform_open();
+
+        std::pop_heap(samples_.begin(), samples_.end(), KeyGreater());
+        samples_.back() = Item(std::log(u) / weight, item);
+        std::push_heap(samples_.begin(), samples_.end(), KeyGreater());
+
+        calc_next_jump();
+    }
+
+    //! size of reservoir
+    size_t size() const { return size_; }
+
+    //! number of items seen
+    size_t count() const { return count_; }
+
+    //! access to samples and their keys, in heap order
+    const std::vector<Item>& samples() const { return samples_; }
+
+    //! access to samples and their keys, in heap order
+    std::vector<Item>& samples() { return samples_; }
+
+private:
+    //! size of reservoir
+    size_t size_;
+    //! number of items seen
+    size_t count_ = 0;
+    //! remaining weight to skip until the next sample
+    double jump_ = 0.0;
+    //! reservoir: min-heap of the keys
+    std::vector<Item> samples_;
+    //! source of randomness
+    RNG& rng_;
+    //! uniform [0.0, 1.0) distribution
+    std::uniform_real_distribution<double> uniform;
+
+    //! comparator making the smallest key the top of the heap
+    struct KeyGreater {
+        bool operator () (const Item& a, const Item& b) const {
+            return a.first > b.first;
+        }
+    };
+
+    //! uniform random value in (0.0, 1.0]
+    double uniform_open() { return 1.0 - uniform(rng_); }
+
+    //! draw the weight to skip: log(u) / log(T) for the smallest key T
+    void calc_next_jump() {
+        double min_key = samples_.front().first;
+        jump_ = min_key < 0.0
+                ? std::log(uniform_open()) / min_key
+                : std::numeric_limits<double>::infinity();
+    }
+};
+
 } // namespace common
 } // namespace thrill
 
@@ -0,0 +1,378 @@
+/*******************************************************************************
+ * thrill/common/sample_sort.hpp
+ *
+ * In-place super scalar samplesort: items are classified using a branchless
+ * descent of an implicit binary splitter tree, with an additional equality
+ * bucket for each splitter, and then permuted in-place into their buckets using
+ * cycle leader swaps. The bucket oracle requires n extra bytes of memory, the
+ * items themselves are never copied to a second array.
+ *
+ * The splitter tree construction is shared with api::SortNode.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_SAMPLE_SORT_HEADER
+#define THRILL_COMMON_SAMPLE_SORT_HEADER
+
+#include <thrill/common/logger.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace thrill {
+namespace common {
+
+namespace sample_sort_local {
+
+template <typename ValueType, typename Sample, typename GetValue>
+void BuildSplitterTreeRecurse(
+    ValueType* tree, const Sample* samples, size_t num_splitters,
+    const GetValue& get_value,
+    const Sample* lo, const Sample* hi, size_t treeidx) {
+    // pick middle element as splitter
+    const Sample* mid = lo + (hi - lo) / 2;
+    assert(mid < samples + num_splitters);
+    tree[treeidx] = get_value(*mid);
+
+    if (2 * treeidx < num_splitters)
+    {
+        BuildSplitterTreeRecurse(tree, samples, num_splitters, get_value,
+                                 lo, mid, 2 * treeidx + 0);
+        BuildSplitterTreeRecurse(tree, samples, num_splitters, get_value,
+                                 mid + 1, hi, 2 * treeidx + 1);
+    }
+}
+
+} // namespace sample_sort_local
+
+/*!
+ * Build an implicit binary splitter tree from num_splitters = 2^k - 1 sorted
+ * samples. The tree is stored in tree[1..num_splitters], the children of node
+ * j are 2j and 2j+1. Values are extracted from the samples using get_value().
+ */
+template <typename ValueType, typename Sample, typename GetValue>
+void BuildSplitterTree(ValueType* tree, const Sample* samples,
+                       size_t num_splitters, const GetValue& get_value) {
+    if (num_splitters == 0) return;
+    sample_sort_local::BuildSplitterTreeRecurse(
+        tree, samples, num_splitters, get_value,
+        samples, samples + num_splitters, 1);
+}
+
+/*!
+ * Classify an item by running it down a splitter tree of depth log_k without
+ * branches. Returns the bucket index in [0,2^log_k): bucket b contains items x
+ * with splitter[b-1] <= x < splitter[b].
+ */
+template <typename ValueType, typename Comparator>
+static inline
+size_t ClassifySplitterTree(const ValueType* tree, size_t log_k,
+                            const ValueType& item, const Comparator& cmp) {
+    size_t j = 1;
+    for (size_t l = 0; l < log_k; ++l)
+        j = 2 * j + (cmp(item, tree[j]) ? 0 : 1);
+    return j - (size_t(1) << log_k);
+}
+
+/*!
+ * Classify a batch of n items by running them down a splitter tree of depth
+ * log_k, as ClassifySplitterTree(). The items' descents are interleaved level
+ * by level, which lets the processor overlap the tree lookups of independent
+ * items. Specialized with AVX2 gathers for 64-bit integers and std::less.
+ */
+template <typename ValueType, typename Comparator>
+struct SplitterTreeBatchClassifier {
+    static void Classify(
+        const ValueType* tree, size_t log_k, const ValueType* items, size_t n,
+        size_t* bucket, const Comparator& cmp) {
+        for (size_t i = 0; i < n; ++i) bucket[i] = 1;
+        for (size_t l = 0; l < log_k; ++l) {
+            for (size_t i = 0; i < n; ++i) {
+                bucket[i] = 2 * bucket[i]
+                            + (cmp(items[i], tree[bucket[i]]) ? 0 : 1);
+            }
+        }
+        for (size_t i = 0; i < n; ++i) bucket[i] -= (size_t(1) << log_k);
+    }
+};
+
+#if defined(__AVX2__)
+
+namespace sample_sort_local {
+
+//! std::less for which the AVX2 specializations below do not match, used to
+//! classify the remaining items of a batch.
+template <typename Integer>
+struct ScalarLess : public std::less<Integer> { };
+
+/*!
+ * AVX2 classification of 64-bit integer keys: four items per step, tree nodes
+ * are fetched using gather instructions. For unsigned keys the sign bit is
+ * flipped, since AVX2 only has signed 64-bit compares.
+ */
+template <typename Integer, bool Unsigned>
+struct SplitterTreeBatchClassifierAVX2 {
+    static void Classify(
+        const Integer* tree, size_t log_k, const Integer* items, size_t n,
+        size_t* bucket) {
+
+        const __m256i flip = _mm256_set1_epi64x(
+            Unsigned ? static_cast<long long>(0x8000000000000000ull) : 0);
+        const __m256i one = _mm256_set1_epi64x(1);
+        const long long* ltree = reinterpret_cast<const long long*>(tree);
+
+        size_t i = 0;
+        for ( ; i + 4 <= n; i += 4) {
+            __m256i key = _mm256_xor_si256(
+                _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(items + i)), flip);
+            __m256i j = one;
+            for (size_t l = 0; l < log_k; ++l) {
+                __m256i splitter = _mm256_xor_si256(
+                    _mm256_i64gather_epi64(ltree, j, 8), flip);
+                // lt = (key < splitter) ? -1 : 0; j = 2 * j + 1 + lt
+                __m256i lt = _mm256_cmpgt_epi64(splitter, key);
+                j = _mm256_add_epi64(
+                    _mm256_add_epi64(_mm256_add_epi64(j, j), one), lt);
+            }
+            j = _mm256_sub_epi64(j, _mm256_set1_epi64x(
+                                     static_cast<long long>(1) << log_k));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(bucket + i), j);
+        }
+
+        // classify remaining items
+        SplitterTreeBatchClassifier<Integer, ScalarLess<Integer> >::Classify(
+            tree, log_k, items + i, n - i, bucket + i, ScalarLess<Integer>());
+    }
+};
+
+} // namespace sample_sort_local
+
+template <>
+struct SplitterTreeBatchClassifier<uint64_t, std::less<uint64_t> > {
+    static void Classify(
+        const uint64_t* tree, size_t log_k, const uint64_t* items, size_t n,
+        size_t* bucket, const std::less<uint64_t>&) {
+        sample_sort_local::SplitterTreeBatchClassifierAVX2<
+            uint64_t, true>::Classify(tree, log_k, items, n, bucket);
+    }
+};
+
+template <>
+struct SplitterTreeBatchClassifier<int64_t, std::less<int64_t> > {
+    static void Classify(
+        const int64_t* tree, size_t log_k, const int64_t* items, size_t n,
+        size_t* bucket, const std::less<int64_t>&) {
+        sample_sort_local::SplitterTreeBatchClassifierAVX2<
+            int64_t, false>::Classify(tree, log_k, items, n, bucket);
+    }
+};
+
+#endif // defined(__AVX2__)
+
+//! Classify a batch of n items using SplitterTreeBatchClassifier.
+template <typename ValueType, typename Comparator>
+static inline
+void ClassifySplitterTreeBatch(
+    const ValueType* tree, size_t log_k, const ValueType* items, size_t n,
+    size_t* bucket, const Comparator& cmp) {
+    SplitterTreeBatchClassifier<ValueType, Comparator>::Classify(
+        tree, log_k, items, n, bucket, cmp);
+}
+
+namespace sample_sort_local {
+
+//! number of items classified at once
+static constexpr size_t kClassifyBatch = 16;
+
+//! whether Iterator addresses contiguous items, which are classified in
+//! batches directly from the range: pointers and std::vector iterators.
+template <typename Iterator,
+          typename ValueType =
+              typename std::iterator_traits<Iterator>::value_type>
+struct IsContiguousIterator
+    : public std::integral_constant<
+          bool, std::is_pointer<Iterator>::value ||
+          (std::is_same<Iterator,
+                        typename std::vector<ValueType>::iterator>::value &&
+           !std::is_same<ValueType, bool>::value)>{ };
+
+//! maximum number of splitter tree levels: 2*2^7 buckets fit into the uint8_t
+//! oracle (regular and equality buckets).
+static constexpr size_t kMaxLogBuckets = 7;
+
+//! ranges smaller than this are sorted with std::sort()
+static constexpr size_t kBaseCaseSize = 1024;
+
+//! oversampling factor: number of samples per bucket
+static constexpr size_t kOversampling = 4;
+
+template <typename Iterator, typename Comparator, typename RNG>
+void SampleSortInPlace(Iterator begin, Iterator end, const Comparator& cmp,
+                       uint8_t* oracle, size_t depth_limit, RNG& rng) {
+
+    using ValueType = typename std::iterator_traits<Iterator>::value_type;
+
+    const size_t size = end - begin;
+    if (size < kBaseCaseSize || depth_limit == 0)
+        return std::sort(begin, end, cmp);
+
+    // select number of buckets k = 2^log_k depending on size
+    size_t log_k = 1;
+    while (log_k < kMaxLogBuckets &&
+           (size_t(1) << (log_k + 1)) * kOversampling * 16 < size)
+        ++log_k;
+
+    const size_t k = size_t(1) << log_k;
+
+    // draw a random sample and select equidistant splitters
+    std::vector<ValueType> samples;
+    size_t sample_size = kOversampling * k - 1;
+    samples.reserve(sample_size);
+    for (size_t i = 0; i < sample_size; ++i)
+        samples.emplace_back(begin[rng() % size]);
+    std::sort(samples.begin(), samples.end(), cmp);
+
+    std::vector<ValueType> splitters;
+    splitters.reserve(k - 1);
+    for (size_t i = 1; i < k; ++i)
+        splitters.emplace_back(samples[i * kOversampling - 1]);
+    std::vector<ValueType>().swap(samples);
+
+    if (!cmp(splitters.front(), splitters.back())) {
+        // all splitters are equal: three-way partition with a single pivot
+        Iterator lt = std::partition(
+            begin, end, [&](const ValueType& x) {
+                return cmp(x, splitters.front());
+            });
+        Iterator gt = std::partition(
+            lt, end, [&](const ValueType& x) {
+                return !cmp(splitters.front(), x);
+            });
+        SampleSortInPlace(begin, lt, cmp, oracle, depth_limit - 1, rng);
+        SampleSortInPlace(gt, end, cmp, oracle, depth_limit - 1, rng);
+        return;
+    }
+
+    std::vector<ValueType> tree(k);
+    BuildSplitterTree(tree.data(), splitters.data(), k - 1,
+                      [](const ValueType& v) { return v; });
+
+    // classify items into 2k-1 buckets: odd buckets collect items equal to a
+    // splitter, they precede the regular bucket of larger items.
+    size_t bkt_size[2 * (size_t(1) << kMaxLogBuckets)] = { 0 };
+
+    size_t batch[kClassifyBatch];
+    for (size_t i = 0; i < size; i += kClassifyBatch) {
+        size_t n = std::min(kClassifyBatch, size - i);
+        ClassifySplitterTreeBatch(
+            tree.data(), log_k, std::addressof(*(begin + i)), n, batch, cmp);
+        for (size_t t = 0; t < n; ++t) {
+            size_t b = batch[t];
+            b = 2 * b - (b > 0 && !cmp(splitters[b - 1], begin[i + t]) ? 1 : 0);
+            oracle[i + t] = static_cast<uint8_t>(b);
+            ++bkt_size[b];
+        }
+    }
+
+    // inclusive prefix sum
+    size_t bkt_index[2 * (size_t(1) << kMaxLogBuckets)];
+    bkt_index[0] = bkt_size[0];
+    size_t last_bkt_size = bkt_size[0];
+    for (size_t i = 1; i < 2 * k; ++i) {
+        bkt_index[i] = bkt_index[i - 1] + bkt_size[i];
+        if (bkt_size[i]) last_bkt_size = bkt_size[i];
+    }
+
+    // permute in-place
+    for (size_t i = 0, j; i < size - last_bkt_size; )
+    {
+        ValueType v = std::move(begin[i]);
+        uint8_t vc = oracle[i];
+        while ((j = --bkt_index[vc]) > i)
+        {
+            using std::swap;
+            swap(v, begin[j]);
+            swap(vc, oracle[j]);
+        }
+        begin[i] = std::move(v);
+        i += bkt_size[vc];
+    }
+
+    // recurse into regular buckets, equality buckets are done
+    size_t bsum = 0;
+    for (size_t i = 0; i < 2 * k; bsum += bkt_size[i++]) {
+        if ((i & 1) != 0 || bkt_size[i] <= 1) continue;
+        SampleSortInPlace(begin + bsum, begin + bsum + bkt_size[i],
+                          cmp, oracle, depth_limit - 1, rng);
+    }
+}
+
+} // namespace sample_sort_local
+
+/*!
+ * Sort the iterator range [begin,end) using in-place super scalar
+ * samplesort. Requires n bytes of extra memory for the bucket oracle, items
+ * are never copied to a temporary array. Not stable. The range must be
+ * contiguous, i.e. pointers or std::vector iterators.
+ */
+template <typename Iterator,
+          typename Comparator =
+              std::less<typename std::iterator_traits<Iterator>::value_type> >
+void sample_sort_in_place(Iterator begin, Iterator end,
+                          const Comparator& cmp = Comparator()) {
+
+    static_assert(sample_sort_local::IsContiguousIterator<Iterator>::value,
+                  "sample_sort_in_place() requires contiguous iterators");
+
+    const size_t size = end - begin;
+    if (size < sample_sort_local::kBaseCaseSize)
+        return std::sort(begin, end, cmp);
+
+    // recursion depth limit, after which std::sort() takes over.
+    size_t depth_limit = 2;
+    for (size_t n = size; n > 1; n >>= sample_sort_local::kMaxLogBuckets)
+        depth_limit += 2;
+
+    std::minstd_rand rng(static_cast<unsigned>(size));
+
+    std::vector<uint8_t> oracle(size);
+    sample_sort_local::SampleSortInPlace(
+        begin, end, cmp, oracle.data(), depth_limit, rng);
+}
+
+/*!
+ * SortAlgorithm class for use with api::Sort() which calls
+ * sample_sort_in_place().
+ */
+class SampleSort
+{
+public:
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end,
+                      const CompareFunction& cmp) const {
+        sample_sort_in_place(begin, end, cmp);
+    }
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_SAMPLE_SORT_HEADER
+
+/******************************************************************************/
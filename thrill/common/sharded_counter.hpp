@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * thrill/common/sharded_counter.hpp
+ *
+ * Always-on counters sharded over threads, and timers reading the time stamp
+ * counter, whose costs are low enough for hot paths.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_SHARDED_COUNTER_HEADER
+#define THRILL_COMMON_SHARDED_COUNTER_HEADER
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace thrill {
+namespace common {
+
+//! read the CPU's time stamp counter, or a nanosecond clock on other
+//! architectures. Convert ticks with TscNanosPerTick().
+static inline uint64_t ReadTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/*!
+ * Nanoseconds per tick of ReadTsc(). The ratio is measured against
+ * steady_clock since the first call, hence it becomes more exact the later it
+ * is called. The first call waits a millisecond for a first estimate, it
+ * should be made by the ProfileThread aggregating the timers, and not by
+ * workers.
+ */
+inline double TscNanosPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+    using steady_clock = std::chrono::steady_clock;
+    struct Start {
+        steady_clock::time_point time = steady_clock::now();
+        uint64_t tsc = ReadTsc();
+    };
+    static const Start start;
+
+    steady_clock::time_point now;
+    uint64_t tsc;
+    do {
+        now = steady_clock::now();
+        tsc = ReadTsc();
+    } while (now - start.time < std::chrono::milliseconds(1));
+
+    if (tsc <= start.tsc) return 1.0;
+    return static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - start.time).count()) / static_cast<double>(tsc - start.tsc);
+#else
+    return 1.0;
+#endif
+}
+
+/*!
+ * A counter incremented concurrently by many threads, which is read rarely,
+ * e.g. by a ProfileTask. Each thread adds to its own shard, hence the threads
+ * do not contend for the cache line as with a single std::atomic. Shards are
+ * chosen round-robin when a thread first uses any ShardedCounter, if there
+ * are more threads than shards, some share a shard.
+ *
+ * Shards are padded to 128 bytes, which keeps them on different cache lines
+ * (and adjacent line pairs) without over-aligned allocation.
+ */
+class ShardedCounter
+{
+public:
+    //! number of shards
+    static constexpr size_t kShards = 32;
+
+    ShardedCounter() = default;
+
+    //! non-copyable: delete copy-constructor
+    ShardedCounter(const ShardedCounter&) = delete;
+    //! non-copyable: delete assignment operator
+    ShardedCounter& operator = (const ShardedCounter&) = delete;
+
+    //! add value to the calling thread's shard
+    void Add(uint64_t value) {
+        shards_[ThreadShard()].value.fetch_add(
+            value, std::memory_order_relaxed);
+    }
+
+    //! add value to the calling thread's shard
+    ShardedCounter& operator += (uint64_t value) {
+        Add(value);
+        return *this;
+    }
+
+    //! increment the calling thread's shard
+    ShardedCounter& operator ++ () {
+        Add(1);
+        return *this;
+    }
+
+    //! sum of all shards, not a snapshot while others add.
+    uint64_t value() const {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < kShards; ++i)
+            sum += shards_[i].value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> value { 0 };
+        char                  padding[128 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    Shard shards_[kShards];
+
+    //! shard of the calling thread, assigned on first use
+    static size_t ThreadShard() {
+        static std::atomic<size_t> s_next_shard { 0 };
+        static thread_local size_t s_shard =
+            s_next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return s_shard;
+    }
+};
+
+/*!
+ * RAII timer adding the ReadTsc() ticks of its lifetime to a ShardedCounter.
+ * Costs two rdtsc instructions and one uncontended atomic add.
+ */
+class ScopedTscTimer
+{
+public:
+    explicit ScopedTscTimer(ShardedCounter& ticks)
+        : ticks_(ticks), start_(ReadTsc()) { }
+
+    //! non-copyable: delete copy-constructor
+    ScopedTscTimer(const ScopedTscTimer&) = delete;
+    //! non-copyable: delete assignment operator
+    ScopedTscTimer& operator = (const ScopedTscTimer&) = delete;
+
+    ~ScopedTscTimer() {
+        ticks_.Add(ReadTsc() - start_);
+    }
+
+private:
+    ShardedCounter& ticks_;
+    uint64_t start_;
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_SHARDED_COUNTER_HEADER
+
+/******************************************************************************/
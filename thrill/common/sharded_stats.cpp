@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * thrill/common/sharded_stats.cpp
+ *
+ * Profiling Task aggregating named ShardedCounters of a host into the JSON log
+ * and the metrics server.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/sharded_stats.hpp>
+
+#include <thrill/common/json_logger.hpp>
+#include <thrill/common/metrics_server.hpp>
+#include <thrill/common/profile_thread.hpp>
+
+#include <string>
+
+namespace thrill {
+namespace common {
+
+ShardedStats::ShardedStats(JsonLogger& logger, MetricsServer* metrics)
+    : logger_(logger), metrics_(metrics) { }
+
+ShardedStats::~ShardedStats() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Report();
+}
+
+ShardedCounter& ShardedStats::counter(const std::string& name) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::unique_ptr<ShardedCounter>& c = counters_[name];
+    if (!c) c = std::make_unique<ShardedCounter>();
+    return *c;
+}
+
+ShardedCounter& ShardedStats::timer(const std::string& name) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::unique_ptr<ShardedCounter>& c = timers_[name];
+    if (!c) c = std::make_unique<ShardedCounter>();
+    return *c;
+}
+
+void ShardedStats::RunTask(const std::chrono::steady_clock::time_point&) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Report();
+}
+
+void ShardedStats::Report() {
+    if (counters_.empty() && timers_.empty()) return;
+
+    double seconds_per_tick = TscNanosPerTick() / 1e9;
+
+    JsonLine out = logger_.line();
+    out << "class" << "ShardedStats"
+        << "event" << "profile";
+
+    for (const auto& c : counters_) {
+        uint64_t value = c.second->value();
+        out << c.first << value;
+        if (metrics_)
+            metrics_->Set(c.first, static_cast<double>(value));
+    }
+    for (const auto& t : timers_) {
+        double value = static_cast<double>(t.second->value())
+                       * seconds_per_tick;
+        out << t.first << value;
+        if (metrics_)
+            metrics_->Set(t.first, value);
+    }
+}
+
+ShardedStats* StartShardedStats(ProfileThread& sched, JsonLogger& logger,
+                                MetricsServer* metrics) {
+    ShardedStats* task = new ShardedStats(logger, metrics);
+    sched.Add(std::chrono::seconds(1), task, /* own_task */ true);
+    return task;
+}
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * thrill/common/sharded_stats.hpp
+ *
+ * Profiling Task aggregating named ShardedCounters of a host into the JSON log
+ * and the metrics server.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_SHARDED_STATS_HEADER
+#define THRILL_COMMON_SHARDED_STATS_HEADER
+
+#include <thrill/common/profile_task.hpp>
+#include <thrill/common/sharded_counter.hpp>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace thrill {
+namespace common {
+
+// forward declarations
+class JsonLogger;
+class MetricsServer;
+class ProfileThread;
+
+/*!
+ * Registry of always-on counters and timers shared by all workers of a host,
+ * e.g. the items, bytes, and time of each DIA operation. Looking up a counter
+ * by name takes a mutex, hence callers keep the reference and only add to it
+ * in hot paths. Every second, the ProfileThread sums the shards of all
+ * counters, and writes them as "ShardedStats" event and as gauges of the
+ * metrics server. Timers count ReadTsc() ticks and are reported in seconds.
+ *
+ * Names may contain Prometheus labels, e.g. `thrill_op_items{op="Map"}`.
+ */
+class ShardedStats final : public ProfileTask
+{
+public:
+    ShardedStats(JsonLogger& logger, MetricsServer* metrics);
+
+    //! non-copyable: delete copy-constructor
+    ShardedStats(const ShardedStats&) = delete;
+    //! non-copyable: delete assignment operator
+    ShardedStats& operator = (const ShardedStats&) = delete;
+
+    //! writes a last report
+    ~ShardedStats();
+
+    //! counter with the given name, created on first use.
+    ShardedCounter& counter(const std::string& name);
+
+    //! timer counting ReadTsc() ticks with the given name, created on first
+    //! use. Use it with ScopedTscTimer.
+    ShardedCounter& timer(const std::string& name);
+
+    //! method called by ProfileThread.
+    void RunTask(const std::chrono::steady_clock::time_point& tp) final;
+
+private:
+    //! output logger
+    JsonLogger& logger_;
+
+    //! metrics server, may be nullptr
+    MetricsServer* metrics_;
+
+    //! mutex protecting the maps
+    std::mutex mutex_;
+
+    //! counters and timers by name
+    std::map<std::string, std::unique_ptr<ShardedCounter> >
+    counters_, timers_;
+
+    //! sum the counters and report them, requires the mutex.
+    void Report();
+};
+
+//! launch profiler task which reports the host's ShardedStats, which are
+//! owned by the ProfileThread.
+ShardedStats* StartShardedStats(ProfileThread& sched, JsonLogger& logger,
+                                MetricsServer* metrics = nullptr);
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_SHARDED_STATS_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,358 @@
+/*******************************************************************************
+ * thrill/common/stack_sampler.cpp
+ *
+ * Profiling Task which samples the call stacks of the worker threads with
+ * SIGPROF and writes them as folded stacks per DIA node.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/stack_sampler.hpp>
+
+#include <thrill/common/json_logger.hpp>
+#include <thrill/common/profile_thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#if __linux__
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// glibc before 2.26 does not name the thread id field of sigevent
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+#endif
+
+namespace thrill {
+namespace common {
+
+//! DIA node the calling thread is working on, read by the signal handler
+static thread_local size_t s_thread_dia_id = 0;
+static thread_local const char* s_thread_dia_label = nullptr;
+
+std::pair<size_t, const char*> StackSampler::SetThreadDIA(
+    size_t dia_id, const char* label) {
+    std::pair<size_t, const char*> prev(s_thread_dia_id, s_thread_dia_label);
+    s_thread_dia_label = label;
+    s_thread_dia_id = dia_id;
+    return prev;
+}
+
+#if __linux__
+
+//! sample buffer of one worker thread
+struct StackSampler::Thread {
+    //! maximum number of stack frames recorded
+    static constexpr size_t kMaxDepth = 48;
+
+    //! number of samples in the ring buffer, which must suffice for one
+    //! second of samples.
+    static constexpr size_t kCapacity = 256;
+
+    //! frames of the signal handler and the signal trampoline, which are
+    //! skipped
+    static constexpr size_t kSkipFrames = 2;
+
+    //! one stack sample
+    struct Sample {
+        size_t      dia_id;
+        const char* label;
+        int         depth;
+        void        * frames[kMaxDepth];
+    };
+
+    explicit Thread(size_t rank)
+        : worker_rank(rank), samples(new Sample[kCapacity]) { }
+
+    //! worker rank of the thread
+    size_t worker_rank;
+
+    //! CPU time timer of the thread
+    timer_t timer;
+
+    //! ring buffer of samples, written by the signal handler and read by the
+    //! ProfileThread.
+    std::unique_ptr<Sample[]> samples;
+
+    //! number of samples written and read
+    std::atomic<size_t> write { 0 }, read { 0 };
+
+    //! number of samples dropped because the buffer was full
+    std::atomic<size_t> dropped { 0 };
+};
+
+StackSampler::Thread*& StackSampler::LocalThread() {
+    static thread_local Thread* s_thread = nullptr;
+    return s_thread;
+}
+
+void StackSampler::SignalHandler(int) {
+    int saved_errno = errno;
+
+    Thread* t = LocalThread();
+    if (t != nullptr) {
+        size_t w = t->write.load(std::memory_order_relaxed);
+        if (w - t->read.load(std::memory_order_acquire) >= Thread::kCapacity) {
+            t->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            Thread::Sample& s = t->samples[w % Thread::kCapacity];
+            s.dia_id = s_thread_dia_id;
+            s.label = s_thread_dia_label;
+            s.depth = backtrace(s.frames, Thread::kMaxDepth);
+            t->write.store(w + 1, std::memory_order_release);
+        }
+    }
+
+    errno = saved_errno;
+}
+
+StackSampler::StackSampler(JsonLogger& logger, size_t frequency)
+    : logger_(logger),
+      interval_ns_(static_cast<long>(
+                       1000000000 / std::max<size_t>(1, frequency))) { }
+
+StackSampler::~StackSampler() = default;
+
+bool StackSampler::AddThread(size_t worker_rank) {
+    if (LocalThread() != nullptr) return true;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // install the handler once for the process, it ignores signals of threads
+    // which are not sampled.
+    static bool s_handler_installed = false;
+    static std::mutex s_handler_mutex;
+    {
+        std::unique_lock<std::mutex> handler_lock(s_handler_mutex);
+        if (!s_handler_installed) {
+            struct sigaction sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_handler = &SignalHandler;
+            sa.sa_flags = SA_RESTART;
+            sigemptyset(&sa.sa_mask);
+            sigaction(SIGPROF, &sa, nullptr);
+            s_handler_installed = true;
+        }
+    }
+
+    // the first backtrace() loads the unwinder, which must not happen in the
+    // signal handler.
+    void* warmup[2];
+    backtrace(warmup, 2);
+
+    std::unique_ptr<Thread> t = std::make_unique<Thread>(worker_rank);
+
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGPROF;
+    sev.sigev_notify_thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &t->timer) != 0) {
+        if (!warned_) {
+            std::cerr << "Thrill: could not create timer for"
+                      << " THRILL_STACK_SAMPLES: " << strerror(errno)
+                      << std::endl;
+            warned_ = true;
+        }
+        return false;
+    }
+
+    // touch the thread local variables, which may allocate them, before the
+    // signal handler reads them.
+    SetThreadDIA(s_thread_dia_id, s_thread_dia_label);
+    LocalThread() = t.get();
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    struct itimerspec its;
+    its.it_interval.tv_sec = interval_ns_ / 1000000000;
+    its.it_interval.tv_nsec = interval_ns_ % 1000000000;
+    its.it_value = its.it_interval;
+    timer_settime(t->timer, 0, &its, nullptr);
+
+    threads_.emplace_back(std::move(t));
+    return true;
+}
+
+void StackSampler::RemoveThread() {
+    Thread* t = LocalThread();
+    if (t == nullptr) return;
+
+    timer_delete(t->timer);
+    // a signal still pending is ignored by the handler
+    LocalThread() = nullptr;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Report(*t);
+    threads_.erase(
+        std::find_if(threads_.begin(), threads_.end(),
+                     [t](const std::unique_ptr<Thread>& p) {
+                         return p.get() == t;
+                     }));
+}
+
+const std::string& StackSampler::Symbol(void* addr) {
+    auto it = symbols_.find(addr);
+    if (it != symbols_.end()) return it->second;
+
+    std::string name;
+    Dl_info info;
+    memset(&info, 0, sizeof(info));
+    dladdr(addr, &info);
+    if (info.dli_sname != nullptr) {
+        int status;
+        char* demangled =
+            abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        name = (status == 0 && demangled) ? demangled : info.dli_sname;
+        free(demangled);
+    }
+    else if (info.dli_fname != nullptr) {
+        // unexported function: output the object and offset
+        const char* base = strrchr(info.dli_fname, '/');
+        std::ostringstream oss;
+        oss << (base ? base + 1 : info.dli_fname) << "+0x" << std::hex
+            << (reinterpret_cast<uintptr_t>(addr)
+            - reinterpret_cast<uintptr_t>(info.dli_fbase));
+        name = oss.str();
+    }
+    else {
+        std::ostringstream oss;
+        oss << addr;
+        name = oss.str();
+    }
+
+    // ';' separates the frames of folded stacks
+    std::replace(name.begin(), name.end(), ';', ',');
+
+    return symbols_.emplace(addr, std::move(name)).first->second;
+}
+
+void StackSampler::Report(Thread& t) {
+    // count distinct folded stacks per DIA node
+    std::map<std::pair<size_t, std::string>, size_t> stacks;
+    std::map<size_t, const char*> labels;
+
+    size_t r = t.read.load(std::memory_order_relaxed);
+    size_t w = t.write.load(std::memory_order_acquire);
+
+    for ( ; r != w; ++r) {
+        const Thread::Sample& s = t.samples[r % Thread::kCapacity];
+
+        std::string folded;
+        for (int i = s.depth - 1; i >= static_cast<int>(Thread::kSkipFrames);
+             --i) {
+            // return addresses point behind the call instruction, except the
+            // one interrupted by the signal.
+            void* addr = s.frames[i];
+            if (i != static_cast<int>(Thread::kSkipFrames))
+                addr = reinterpret_cast<char*>(addr) - 1;
+            if (!folded.empty()) folded += ';';
+            folded += Symbol(addr);
+        }
+
+        ++stacks[std::make_pair(s.dia_id, folded)];
+        labels[s.dia_id] = s.label;
+    }
+    t.read.store(w, std::memory_order_release);
+
+    size_t dropped = t.dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped != 0)
+        stacks[std::make_pair(size_t(0), std::string("[dropped]"))] += dropped;
+
+    for (const auto& s : stacks) {
+        const char* label = labels[s.first.first];
+        logger_ << "class" << "StackSamples"
+                << "event" << "profile"
+                << "worker_rank" << t.worker_rank
+                << "dia_id" << s.first.first
+                << "label" << (label ? label : "")
+                << "samples" << s.second
+                << "stack" << s.first.second;
+    }
+}
+
+void StackSampler::RunTask(const std::chrono::steady_clock::time_point&) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (std::unique_ptr<Thread>& t : threads_)
+        Report(*t);
+}
+
+#else
+
+struct StackSampler::Thread { };
+
+StackSampler::StackSampler(JsonLogger& logger, size_t)
+    : logger_(logger), interval_ns_(0) { }
+
+StackSampler::~StackSampler() = default;
+
+bool StackSampler::AddThread(size_t) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!warned_) {
+        std::cerr << "Thrill: THRILL_STACK_SAMPLES requires Linux's"
+                  << " per-thread CPU time timers." << std::endl;
+        warned_ = true;
+    }
+    return false;
+}
+
+void StackSampler::RemoveThread() { }
+
+void StackSampler::SignalHandler(int) { }
+
+const std::string& StackSampler::Symbol(void*) {
+    static const std::string empty;
+    return empty;
+}
+
+void StackSampler::Report(Thread&) { }
+
+void StackSampler::RunTask(const std::chrono::steady_clock::time_point&)
+{ }
+
+#endif  // __linux__
+
+StackSampler* StartStackSampler(ProfileThread& sched, JsonLogger& logger) {
+    const char* env = getenv("THRILL_STACK_SAMPLES");
+    if (!env || !*env) return nullptr;
+
+    char* endptr;
+    unsigned long frequency = strtoul(env, &endptr, 10);
+    if (*endptr != 0) {
+        std::cerr << "Thrill: could not parse THRILL_STACK_SAMPLES=" << env
+                  << " as frequency in Hz." << std::endl;
+        return nullptr;
+    }
+    if (frequency == 0) return nullptr;
+
+    StackSampler* task = new StackSampler(logger, frequency);
+    sched.Add(std::chrono::seconds(1), task, /* own_task */ true);
+    return task;
+}
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
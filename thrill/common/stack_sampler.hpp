@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * thrill/common/stack_sampler.hpp
+ *
+ * Profiling Task which samples the call stacks of the worker threads with
+ * SIGPROF and writes them as folded stacks per DIA node.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_STACK_SAMPLER_HEADER
+#define THRILL_COMMON_STACK_SAMPLER_HEADER
+
+#include <thrill/common/profile_task.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+// forward declarations
+class JsonLogger;
+class ProfileThread;
+
+/*!
+ * Samples the call stacks of the registered worker threads at a low frequency.
+ * Each thread gets a timer on its own CPU time, which sends SIGPROF to the
+ * thread, hence only threads running on a CPU are sampled. The signal handler
+ * records the stack addresses and the DIA node the thread is working on into
+ * a lock-free ring buffer of the thread.
+ *
+ * Every second, the samples are symbolized and written as "StackSamples"
+ * events, one for each DIA node and distinct stack, with the stack in the
+ * folded format "root;...;leaf" of flame graph tools. json2profile -f outputs
+ * the folded stacks of all workers with the DIA node as root frame, from
+ * which flame graphs per operator are drawn.
+ *
+ * Function names are resolved with dladdr(), hence static functions are only
+ * found if the program is linked with -rdynamic.
+ */
+class StackSampler final : public ProfileTask
+{
+public:
+    //! sample each thread with frequency samples per second of CPU time
+    StackSampler(JsonLogger& logger, size_t frequency);
+
+    //! non-copyable: delete copy-constructor
+    StackSampler(const StackSampler&) = delete;
+    //! non-copyable: delete assignment operator
+    StackSampler& operator = (const StackSampler&) = delete;
+
+    ~StackSampler();
+
+    //! start sampling the calling worker thread. Returns false if the timer
+    //! could not be created.
+    bool AddThread(size_t worker_rank);
+
+    //! report the samples and stop sampling the calling worker thread
+    void RemoveThread();
+
+    //! set the DIA node the calling thread is working on, which is recorded
+    //! with its samples. Returns the previous one.
+    static std::pair<size_t, const char*> SetThreadDIA(
+        size_t dia_id, const char* label);
+
+    //! method called by ProfileThread.
+    void RunTask(const std::chrono::steady_clock::time_point& tp) final;
+
+private:
+    struct Thread;
+
+    //! output logger
+    JsonLogger& logger_;
+
+    //! sampling interval in nanoseconds
+    long interval_ns_;
+
+    //! mutex protecting threads_ and symbols_
+    std::mutex mutex_;
+
+    //! sample buffers of all registered threads
+    std::vector<std::unique_ptr<Thread> > threads_;
+
+    //! cache of resolved function names by address
+    std::unordered_map<void*, std::string> symbols_;
+
+    //! whether the warning about failed timers was printed
+    bool warned_ = false;
+
+    //! sample buffer of the calling thread, if registered
+    static Thread*& LocalThread();
+
+    //! SIGPROF signal handler
+    static void SignalHandler(int signum);
+
+    //! resolve the function name of an address, requires mutex_
+    const std::string& Symbol(void* addr);
+
+    //! write the samples of a thread to the log, requires mutex_
+    void Report(Thread& t);
+};
+
+/*!
+ * RAII scope recording the DIA node in the stack samples of the calling thread,
+ * used by the StageBuilder around Execute() and PushData().
+ */
+class StackSamplerScope
+{
+public:
+    StackSamplerScope(size_t dia_id, const char* label)
+        : prev_(StackSampler::SetThreadDIA(dia_id, label)) { }
+
+    //! non-copyable: delete copy-constructor
+    StackSamplerScope(const StackSamplerScope&) = delete;
+    //! non-copyable: delete assignment operator
+    StackSamplerScope& operator = (const StackSamplerScope&) = delete;
+
+    ~StackSamplerScope() {
+        StackSampler::SetThreadDIA(prev_.first, prev_.second);
+    }
+
+private:
+    std::pair<size_t, const char*> prev_;
+};
+
+//! launch profiler task if THRILL_STACK_SAMPLES is set to a frequency in Hz,
+//! returns nullptr otherwise. The task is owned by the ProfileThread.
+StackSampler* StartStackSampler(ProfileThread& sched, JsonLogger& logger);
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_STACK_SAMPLER_HEADER
+
+/******************************************************************************/
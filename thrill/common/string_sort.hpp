@@ -0,0 +1,238 @@
+/*******************************************************************************
+ * thrill/common/string_sort.hpp
+ *
+ * Sorting of std::string ranges with an MSD radix sort and a multikey
+ * quicksort, which both cache the characters at the current depth, hence
+ * common prefixes are never compared twice.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_STRING_SORT_HEADER
+#define THRILL_COMMON_STRING_SORT_HEADER
+
+#include <tlx/unused.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace common {
+namespace string_sort_local {
+
+//! character at depth of s plus one, or zero for the end of s, such that
+//! shorter strings come first
+static inline uint16_t CharAt(const std::string& s, size_t depth) {
+    return depth < s.size()
+           ? static_cast<uint16_t>(static_cast<unsigned char>(s[depth]) + 1)
+           : 0;
+}
+
+//! number of distinct CharAt() values
+static constexpr size_t K = 257;
+
+//! below this size, ranges are sorted by insertion sort
+static constexpr size_t kInsertionSize = 16;
+
+//! above this size, ranges are sorted by MSD radix sort
+static constexpr size_t kRadixSize = 1 << 14;
+
+//! insertion sort of strings, whose first depth characters are equal
+template <typename Iterator>
+void InsertionSort(Iterator begin, Iterator end, size_t depth) {
+    for (Iterator i = begin + 1; i < end; ++i) {
+        std::string tmp = std::move(*i);
+        Iterator j = i;
+        while (j != begin &&
+               (j - 1)->compare(depth, std::string::npos,
+                                tmp, depth, std::string::npos) > 0) {
+            *j = std::move(*(j - 1));
+            --j;
+        }
+        *j = std::move(tmp);
+    }
+}
+
+template <typename Iterator>
+void MultikeyQuicksort(Iterator begin, uint16_t* cache, size_t n,
+                       size_t depth, bool cached);
+
+/*!
+ * MSD radix sort of n strings, whose first depth characters are equal, using
+ * cache for the characters at depth.
+ */
+template <typename Iterator>
+void RadixSort(Iterator begin, uint16_t* cache, size_t n, size_t depth) {
+    for (size_t i = 0; i < n; ++i)
+        cache[i] = CharAt(begin[i], depth);
+
+    std::array<size_t, K> bkt_size;
+    bkt_size.fill(0);
+    for (size_t i = 0; i < n; ++i)
+        ++bkt_size[cache[i]];
+
+    // exclusive bucket ends, then permute in-place
+    std::array<size_t, K> bkt_index;
+    size_t sum = 0;
+    for (size_t c = 0; c < K; ++c)
+        sum += bkt_size[c], bkt_index[c] = sum;
+
+    for (size_t i = 0; i < n; ) {
+        std::string v = std::move(begin[i]);
+        uint16_t vc = cache[i];
+        size_t j;
+        while ((j = --bkt_index[vc]) > i) {
+            using std::swap;
+            swap(v, begin[j]);
+            swap(vc, cache[j]);
+        }
+        begin[i] = std::move(v);
+        cache[i] = vc;
+        i += bkt_size[vc];
+    }
+
+    // bucket zero contains ended, equal strings
+    size_t bsum = bkt_size[0];
+    for (size_t c = 1; c < K; bsum += bkt_size[c++]) {
+        if (bkt_size[c] <= 1) continue;
+        MultikeyQuicksort(begin + bsum, cache + bsum, bkt_size[c], depth + 1,
+                          /* cached */ false);
+    }
+}
+
+/*!
+ * Multikey quicksort of n strings, whose first depth characters are equal,
+ * using cache for the characters at depth. If cached, the cache already
+ * contains these characters.
+ */
+template <typename Iterator>
+void MultikeyQuicksort(Iterator begin, uint16_t* cache, size_t n,
+                       size_t depth, bool cached) {
+    while (n > kInsertionSize) {
+        if (n >= kRadixSize)
+            return RadixSort(begin, cache, n, depth);
+
+        if (!cached) {
+            for (size_t i = 0; i < n; ++i)
+                cache[i] = CharAt(begin[i], depth);
+        }
+
+        // median of three pivot character
+        uint16_t a = cache[0], b = cache[n / 2], c = cache[n - 1];
+        uint16_t pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+        // three-way partition into [0,lt) < pivot, [lt,gt) == pivot, [gt,n)
+        size_t lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            if (cache[i] < pivot) {
+                std::swap(begin[lt], begin[i]);
+                std::swap(cache[lt], cache[i]);
+                ++lt, ++i;
+            }
+            else if (cache[i] > pivot) {
+                --gt;
+                std::swap(begin[i], begin[gt]);
+                std::swap(cache[i], cache[gt]);
+            }
+            else {
+                ++i;
+            }
+        }
+
+        MultikeyQuicksort(begin, cache, lt, depth, /* cached */ true);
+        MultikeyQuicksort(begin + gt, cache + gt, n - gt, depth,
+                          /* cached */ true);
+
+        // continue with the equal part at the next character, unless the
+        // strings ended.
+        if (pivot == 0) return;
+        begin += lt, cache += lt, n = gt - lt;
+        ++depth, cached = false;
+    }
+    if (n > 1)
+        InsertionSort(begin, begin + n, depth);
+}
+
+} // namespace string_sort_local
+
+/*!
+ * Sort the std::string range [begin,end) lexicographically as std::less, with
+ * a multikey quicksort, whose large subproblems are sorted by MSD radix sort.
+ * Both cache the characters at the current depth in n extra 16-bit words.
+ */
+template <typename Iterator>
+void string_sort(Iterator begin, Iterator end) {
+    using namespace string_sort_local;
+
+    const size_t n = end - begin;
+    if (n <= 1) return;
+
+    std::vector<uint16_t> cache(n);
+    MultikeyQuicksort(begin, cache.data(), n, /* depth */ 0,
+                      /* cached */ false);
+}
+
+/*!
+ * SortAlgorithm class for use with api::Sort() of std::string items compared
+ * with std::less, which calls string_sort().
+ */
+class StringSort
+{
+public:
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end,
+                      const CompareFunction& cmp) const {
+        static_assert(
+            std::is_same<CompareFunction, std::less<std::string> >::value,
+            "StringSort requires std::less<std::string>");
+        string_sort(begin, end);
+        assert(std::is_sorted(begin, end, cmp));
+        tlx::unused(cmp);
+    }
+};
+
+/*!
+ * Truncate each string of the sorted range [begin,end) to its distinguishing
+ * prefix: the shortest prefix which differs from the neighbouring strings.
+ * The range remains sorted, and different strings remain different.
+ */
+template <typename Iterator, typename GetString>
+void TruncateDistinguishingPrefixes(Iterator begin, Iterator end,
+                                    const GetString& get_string) {
+    const size_t n = end - begin;
+    if (n == 0) return;
+
+    auto lcp = [](const std::string& a, const std::string& b) {
+                   size_t i = 0, m = std::min(a.size(), b.size());
+                   while (i < m && a[i] == b[i]) ++i;
+                   return i;
+               };
+
+    // lcps with the previous and the next string, before truncation
+    size_t lcp_prev = 0;
+    for (size_t i = 0; i < n; ++i) {
+        std::string& s = get_string(begin[i]);
+        size_t lcp_next =
+            i + 1 < n ? lcp(s, get_string(begin[i + 1])) : 0;
+        size_t length = std::max(lcp_prev, lcp_next) + 1;
+        lcp_prev = lcp_next;
+        if (length < s.size()) s.resize(length);
+    }
+}
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_STRING_SORT_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * thrill/common/task_pool.cpp
+ *
+ * Host-wide pool of helper threads, which execute the tasks of parallel loops
+ * together with the calling worker threads.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/task_pool.hpp>
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/porting.hpp>
+
+#include <string>
+
+namespace thrill {
+namespace common {
+
+TaskPool::TaskPool(size_t num_threads, JsonLogger* logger)
+    : logger_(logger) {
+    threads_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads_.emplace_back(
+            CreateThread(
+                [this, i]() {
+                    NameThisThread("task " + std::to_string(i));
+                    Worker();
+                }));
+    }
+}
+
+TaskPool::~TaskPool() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    terminate_ = true;
+    cv_jobs_.notify_all();
+    lock.unlock();
+
+    for (std::thread& t : threads_)
+        t.join();
+}
+
+size_t TaskPool::Work(Job& job) {
+    size_t i, count = 0;
+    while ((i = job.next++) < job.num_tasks) {
+        (*job.f)(i);
+        ++count;
+    }
+    return count;
+}
+
+void TaskPool::RemoveJob(Job* job) {
+    auto it = std::find(jobs_.begin(), jobs_.end(), job);
+    if (it != jobs_.end()) {
+        jobs_.erase(it);
+        num_jobs_.store(jobs_.size(), std::memory_order_relaxed);
+    }
+}
+
+void TaskPool::Run(size_t num_tasks, const std::function<void(size_t)>& f) {
+    if (num_tasks <= 1 || threads_.empty()) {
+        for (size_t i = 0; i < num_tasks; ++i) f(i);
+        return;
+    }
+
+    Job job;
+    job.f = &f;
+    job.num_tasks = num_tasks;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobs_.push_back(&job);
+    num_jobs_.store(jobs_.size(), std::memory_order_relaxed);
+    cv_jobs_.notify_all();
+    lock.unlock();
+
+    Work(job);
+
+    // all tasks are taken: wait for the helpers to finish theirs.
+    lock.lock();
+    RemoveJob(&job);
+    cv_done_.wait(lock, [&job]() { return job.helpers == 0; });
+}
+
+void TaskPool::Worker() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!terminate_)
+    {
+        if (jobs_.empty()) {
+            cv_jobs_.wait(lock);
+            continue;
+        }
+
+        Job* job = jobs_[next_job_++ % jobs_.size()];
+        if (job->next >= job->num_tasks) {
+            // no tasks left, the caller waits for the running ones.
+            RemoveJob(job);
+            continue;
+        }
+
+        ++job->helpers;
+        lock.unlock();
+
+        helper_tasks_ += Work(*job);
+
+        lock.lock();
+        RemoveJob(job);
+        if (--job->helpers == 0)
+            cv_done_.notify_all();
+    }
+}
+
+bool TaskPool::HelpOne() {
+    // quick check without the lock, since waiting threads call this often.
+    if (num_jobs_.load(std::memory_order_relaxed) == 0) return false;
+
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || jobs_.empty()) return false;
+
+    Job* job = jobs_[next_job_++ % jobs_.size()];
+    size_t i = job->next++;
+    if (i >= job->num_tasks) {
+        RemoveJob(job);
+        return false;
+    }
+
+    ++job->helpers;
+    lock.unlock();
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    (*job->f)(i);
+
+    lent_time_ += std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    ++lent_tasks_;
+
+    lock.lock();
+    if (--job->helpers == 0)
+        cv_done_.notify_all();
+
+    return true;
+}
+
+void TaskPool::RunTask(const std::chrono::steady_clock::time_point&) {
+    logger_ << "class" << "TaskPool"
+            << "event" << "profile"
+            << "num_threads" << threads_.size()
+            << "jobs" << num_jobs_.load()
+            << "helper_tasks" << helper_tasks_.exchange(0)
+            << "lent_tasks" << lent_tasks_.exchange(0)
+            << "lent_time" << lent_time_.exchange(0);
+}
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,170 @@
+/*******************************************************************************
+ * thrill/common/task_pool.hpp
+ *
+ * Host-wide pool of helper threads, which execute the tasks of parallel loops
+ * together with the calling worker threads.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_TASK_POOL_HEADER
+#define THRILL_COMMON_TASK_POOL_HEADER
+
+#include <thrill/common/json_logger.hpp>
+#include <thrill/common/profile_task.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * A pool of helper threads shared by all workers of a host. A worker calls
+ * Run() with a number of tasks, which are fetched from an atomic counter by
+ * the worker itself and by all idle helper threads. The helpers are
+ * distributed round-robin over the concurrently running loops, hence a
+ * straggler worker receives all helpers once the other workers are finished or
+ * blocked in a collective. If all workers run loops, each performs at least
+ * its own tasks, and at most num_threads() additional threads are busy.
+ *
+ * Workers waiting in a ThreadBarrierTree lend their cores by calling HelpOne()
+ * instead of only spinning, such that the time of stragglers and waiting
+ * workers is overlapped.
+ *
+ * Tasks must not throw exceptions.
+ */
+class TaskPool : public ProfileTask
+{
+    static constexpr bool debug = false;
+
+public:
+    //! construct with num_threads helper threads, possibly zero.
+    explicit TaskPool(
+        size_t num_threads = std::max<size_t>(
+            1, std::thread::hardware_concurrency()) - 1,
+        JsonLogger* logger = nullptr);
+
+    //! non-copyable: delete copy-constructor
+    TaskPool(const TaskPool&) = delete;
+    //! non-copyable: delete assignment operator
+    TaskPool& operator = (const TaskPool&) = delete;
+
+    //! stop and join all helper threads
+    ~TaskPool();
+
+    //! number of helper threads
+    size_t num_threads() const { return threads_.size(); }
+
+    //! maximum number of threads working on one Run(), including the caller.
+    size_t max_parallelism() const { return threads_.size() + 1; }
+
+    /*!
+     * Run f(i) for i in [0,num_tasks) on the calling thread and the idle
+     * helper threads. Returns when all tasks are done.
+     */
+    void Run(size_t num_tasks, const std::function<void(size_t)>& f);
+
+    /*!
+     * Run f(i) for all i in [begin,end), where the range is split into
+     * chunks of at least min_chunk indices, such that each participating
+     * thread gets a few chunks for load balancing.
+     */
+    template <typename Function>
+    void ParallelFor(size_t begin, size_t end, const Function& f,
+                     size_t min_chunk = 1) {
+        if (begin >= end) return;
+        size_t size = end - begin;
+        size_t num_chunks = std::max<size_t>(
+            1, std::min(size / std::max<size_t>(min_chunk, 1),
+                        4 * max_parallelism()));
+        Run(num_chunks,
+            [&](size_t c) {
+                size_t lo = begin + size * c / num_chunks;
+                size_t hi = begin + size * (c + 1) / num_chunks;
+                for (size_t i = lo; i < hi; ++i) f(i);
+            });
+    }
+
+    /*!
+     * Run one task of a running loop on the calling thread, if there is one.
+     * Called by threads which wait for others, e.g. in a barrier. Returns true
+     * if a task was run.
+     */
+    bool HelpOne();
+
+    //! profile the tasks run by helpers and by waiting threads, called by the
+    //! ProfileThread.
+    void RunTask(const std::chrono::steady_clock::time_point& tp) final;
+
+private:
+    //! a running parallel loop
+    struct Job {
+        //! task function
+        const std::function<void(size_t)>* f;
+        //! number of tasks
+        size_t num_tasks;
+        //! next task to fetch
+        std::atomic<size_t> next { 0 };
+        //! number of helper threads working on the job, protected by mutex_
+        size_t helpers = 0;
+    };
+
+    //! helper threads
+    std::vector<std::thread> threads_;
+
+    //! mutex protecting jobs_ and the helpers counters
+    std::mutex mutex_;
+
+    //! signals new jobs to the helpers
+    std::condition_variable cv_jobs_;
+
+    //! signals the callers that helpers left their job
+    std::condition_variable cv_done_;
+
+    //! jobs with tasks left
+    std::vector<Job*> jobs_;
+
+    //! round-robin index into jobs_
+    size_t next_job_ = 0;
+
+    //! flag to terminate the helpers
+    bool terminate_ = false;
+
+    //! number of entries in jobs_, read without the mutex by HelpOne()
+    std::atomic<size_t> num_jobs_ { 0 };
+
+    //! json logger for profiling
+    JsonLogger logger_;
+
+    //! number of tasks run by the helper threads
+    std::atomic<size_t> helper_tasks_ { 0 };
+
+    //! number of tasks and time in microseconds lent by waiting threads
+    std::atomic<size_t> lent_tasks_ { 0 }, lent_time_ { 0 };
+
+    //! fetch and run tasks of job until none are left, returns their number
+    static size_t Work(Job& job);
+
+    //! remove job from jobs_ if it is still listed, with mutex_ held.
+    void RemoveJob(Job* job);
+
+    //! main function of the helper threads
+    void Worker();
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_TASK_POOL_HEADER
+
+/******************************************************************************/
@@ -13,9 +13,23 @@
 #ifndef THRILL_COMMON_THREAD_BARRIER_HEADER
 #define THRILL_COMMON_THREAD_BARRIER_HEADER
 
+#include <thrill/common/config.hpp>
 #include <tlx/thread_barrier_mutex.hpp>
 #include <tlx/thread_barrier_spin.hpp>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace thrill {
 namespace common {
 
@@ -26,6 +40,252 @@ using ThreadBarrier = tlx::ThreadBarrierMutex;
 using ThreadBarrier = tlx::ThreadBarrierSpin;
 #endif
 
+/*!
+ * A combining tree barrier for a fixed set of threads with ids [0,n). Each
+ * thread owns a cache-line-padded slot, on which it waits for the arrival of
+ * its children in the tree, before signaling its own arrival to its parent.
+ * Thread 0 is the root: it runs the lambda, and then releases all threads by
+ * incrementing the generation counter, on which the waiting threads spin. Hence
+ * no cache line is written by more than fan_in threads per generation.
+ *
+ * The subtree of each thread contains a contiguous range of ids starting with
+ * the thread itself, and the children are ordered by id. Thereby,
+ * wait_combine() can reduce values of all threads in the order of their ids up
+ * the tree.
+ *
+ * An idle function may be set, which the threads call while spinning, e.g. to
+ * lend their core to the tasks of stragglers via TaskPool::HelpOne(). While it
+ * finds no work, the threads back off by pausing and then yielding their core,
+ * since workers of all hosts may share the cores of one machine.
+ */
+class ThreadBarrierTree
+{
+public:
+    //! default maximum number of children per thread
+    static constexpr size_t default_fan_in = 4;
+
+    explicit ThreadBarrierTree(size_t thread_count,
+                               size_t fan_in = default_fan_in)
+        : slots_(thread_count), parent_(thread_count, 0),
+          children_(thread_count) {
+        assert(thread_count > 0 && fan_in > 0);
+        Build(0, thread_count, fan_in);
+    }
+
+    //! non-copyable: delete copy-constructor
+    ThreadBarrierTree(const ThreadBarrierTree&) = delete;
+    //! non-copyable: delete assignment operator
+    ThreadBarrierTree& operator = (const ThreadBarrierTree&) = delete;
+
+    /*!
+     * Waits for all threads to arrive at the barrier. Before the arrival of
+     * thread id is signaled to its parent, combine(child) is called by thread
+     * id for each of its children in the order of their ids, after the child
+     * arrived. The lambda is called by thread 0 after all threads arrived and
+     * before any thread is released.
+     */
+    template <typename Combine, typename Lambda>
+    void wait_combine(size_t id, Combine combine, Lambda lambda) {
+        assert(id < slots_.size());
+        const size_t this_step = step_.load(std::memory_order_acquire);
+
+        // wait for children, which increment our slot once per generation.
+        const std::vector<size_t>& children = children_[id];
+        const size_t expected = children.size() * (this_step + 1);
+        std::atomic<size_t>& arrived = slots_[id].arrived;
+        size_t spins = 0;
+        while (arrived.load(std::memory_order_acquire) < expected) {
+            Idle(spins);
+        }
+
+        for (const size_t& child : children)
+            combine(child);
+
+        if (id != 0) {
+            // signal arrival to parent and wait for release by the root.
+            slots_[parent_[id]].arrived.fetch_add(
+                1, std::memory_order_acq_rel);
+            while (step_.load(std::memory_order_acquire) == this_step) {
+                Idle(spins);
+            }
+        }
+        else {
+            lambda();
+            step_.store(this_step + 1, std::memory_order_release);
+        }
+    }
+
+    //! Waits for all threads to arrive, then runs lambda on thread 0.
+    template <typename Lambda>
+    void wait(size_t id, Lambda lambda) {
+        return wait_combine(id, [](size_t) { }, lambda);
+    }
+
+    //! Waits for all threads to arrive at the barrier.
+    void wait(size_t id) {
+        return wait(id, []() { });
+    }
+
+    //! Return generation step counter
+    size_t step() const {
+        return step_.load(std::memory_order_acquire);
+    }
+
+    //! Set a function called by waiting threads, which returns true if it did
+    //! some work. Must be set before the threads use the barrier.
+    void set_idle_function(const std::function<bool()>& idle) {
+        idle_ = idle;
+    }
+
+private:
+    //! arrival counter of a thread, alone in a cache line
+    struct Slot {
+        alignas(g_cache_line_size) std::atomic<size_t> arrived { 0 };
+    };
+
+    //! arrival counters, one slot per thread
+    std::vector<Slot> slots_;
+
+    //! parent of each thread in the tree
+    std::vector<size_t> parent_;
+
+    //! ordered children of each thread in the tree
+    std::vector<std::vector<size_t> > children_;
+
+    //! generation counter, incremented by the root to release all threads
+    alignas(g_cache_line_size) std::atomic<size_t> step_ { 0 };
+
+    //! function called while spinning, may be empty
+    std::function<bool()> idle_;
+
+    //! number of pauses while spinning before yielding the core
+    static constexpr size_t max_spins_ = 64;
+
+    //! run the idle function, and back off if it did no work: pause for the
+    //! first max_spins_ calls, then yield the core.
+    void Idle(size_t& spins) {
+        if (idle_ && idle_()) {
+            spins = 0;
+            return;
+        }
+        if (spins < max_spins_) {
+            ++spins;
+#if defined(__SSE2__)
+            _mm_pause();
+#endif
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+    //! construct tree for ids [begin,end) rooted at begin: the remaining ids
+    //! are split into at most fan_in contiguous subtrees.
+    void Build(size_t begin, size_t end, size_t fan_in) {
+        size_t rest = end - begin - 1;
+        size_t sub = (rest + fan_in - 1) / fan_in;
+        for (size_t c = begin + 1; c < end; c += sub) {
+            parent_[c] = begin;
+            children_[begin].push_back(c);
+            Build(c, std::min(c + sub, end), fan_in);
+        }
+    }
+};
+
+/*!
+ * A barrier with the interface of ThreadBarrierTree, in which threads block on
+ * a mutex and condition variable instead of spinning. Thread 0 combines the
+ * values of all other threads in the order of their ids. Used instead of
+ * ThreadBarrierTree with the thread sanitizer, which slows down spinning
+ * threads considerably. The idle function is not called.
+ */
+class ThreadBarrierCombineMutex
+{
+public:
+    explicit ThreadBarrierCombineMutex(size_t thread_count)
+        : thread_count_(thread_count) {
+        assert(thread_count > 0);
+    }
+
+    //! non-copyable: delete copy-constructor
+    ThreadBarrierCombineMutex(const ThreadBarrierCombineMutex&) = delete;
+    //! non-copyable: delete assignment operator
+    ThreadBarrierCombineMutex& operator = (
+        const ThreadBarrierCombineMutex&) = delete;
+
+    //! Waits for all threads to arrive, then thread 0 calls combine(i) for
+    //! all other threads i in order and runs the lambda, before any thread is
+    //! released.
+    template <typename Combine, typename Lambda>
+    void wait_combine(size_t id, Combine combine, Lambda lambda) {
+        assert(id < thread_count_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        const size_t this_step = step_.load(std::memory_order_acquire);
+
+        if (++arrived_ == thread_count_)
+            cv_.notify_all();
+
+        if (id != 0) {
+            cv_.wait(lock, [&]() {
+                         return step_.load(std::memory_order_acquire)
+                         != this_step;
+                     });
+            return;
+        }
+
+        cv_.wait(lock, [&]() { return arrived_ == thread_count_; });
+        for (size_t i = 1; i < thread_count_; ++i)
+            combine(i);
+        lambda();
+
+        arrived_ = 0;
+        step_.store(this_step + 1, std::memory_order_release);
+        cv_.notify_all();
+    }
+
+    //! Waits for all threads to arrive, then runs lambda on thread 0.
+    template <typename Lambda>
+    void wait(size_t id, Lambda lambda) {
+        return wait_combine(id, [](size_t) { }, lambda);
+    }
+
+    //! Waits for all threads to arrive at the barrier.
+    void wait(size_t id) {
+        return wait(id, []() { });
+    }
+
+    //! Return generation step counter
+    size_t step() const {
+        return step_.load(std::memory_order_acquire);
+    }
+
+    //! Ignored, waiting threads block.
+    void set_idle_function(const std::function<bool()>& /* idle */) { }
+
+private:
+    //! number of threads
+    size_t thread_count_;
+
+    //! protects arrived_ and the release of a generation
+    std::mutex mutex_;
+
+    //! signaled when all threads arrived, and when they are released
+    std::condition_variable cv_;
+
+    //! number of threads arrived in the current generation
+    size_t arrived_ = 0;
+
+    //! generation counter, incremented by thread 0 to release all threads
+    std::atomic<size_t> step_ { 0 };
+};
+
+// select combining thread barrier implementation.
+#if THRILL_HAVE_THREAD_SANITIZER
+using ThreadBarrierCombine = ThreadBarrierCombineMutex;
+#else
+using ThreadBarrierCombine = ThreadBarrierTree;
+#endif
+
 } // namespace common
 } // namespace thrill
 
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * thrill/common/wait_stats.hpp
+ *
+ * Per-thread accumulated wait times of workers, which the StageBuilder reports
+ * for each stage.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_WAIT_STATS_HEADER
+#define THRILL_COMMON_WAIT_STATS_HEADER
+
+#include <chrono>
+#include <cstdint>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * Time the calling thread has spent blocked in the data and net layers, in
+ * nanoseconds. Worker threads accumulate it forever, the StageBuilder takes the
+ * difference around each stage. Nested waits are only counted once.
+ */
+class ThreadWaitStats
+{
+public:
+    //! waiting for Blocks to arrive in stream queues
+    uint64_t net_ns = 0;
+
+    //! inside collective operations of the FlowControlChannel
+    uint64_t collective_ns = 0;
+
+    //! nesting depth of running WaitTimers
+    uint32_t depth = 0;
+
+    //! the calling thread's wait statistics
+    static ThreadWaitStats& Local() {
+        static thread_local ThreadWaitStats s_stats;
+        return s_stats;
+    }
+};
+
+/*!
+ * RAII timer adding its lifetime to a field of the calling thread's
+ * ThreadWaitStats, unless another WaitTimer is already running in the thread.
+ */
+template <uint64_t ThreadWaitStats::* Field>
+class WaitTimer
+{
+public:
+    WaitTimer() : stats_(ThreadWaitStats::Local()) {
+        if (stats_.depth++ == 0)
+            start_ = std::chrono::steady_clock::now();
+    }
+
+    //! non-copyable: delete copy-constructor
+    WaitTimer(const WaitTimer&) = delete;
+    //! non-copyable: delete assignment operator
+    WaitTimer& operator = (const WaitTimer&) = delete;
+
+    ~WaitTimer() {
+        if (--stats_.depth == 0) {
+            stats_.*Field +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_).count();
+        }
+    }
+
+private:
+    ThreadWaitStats& stats_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+//! time waiting for stream Blocks
+using NetWaitTimer = WaitTimer<&ThreadWaitStats::net_ns>;
+
+//! time spent in collectives and barriers
+using CollectiveWaitTimer = WaitTimer<&ThreadWaitStats::collective_ns>;
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_WAIT_STATS_HEADER
+
+/******************************************************************************/
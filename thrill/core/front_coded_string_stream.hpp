@@ -0,0 +1,281 @@
+/*******************************************************************************
+ * thrill/core/front_coded_string_stream.hpp
+ *
+ * Stream writers and readers which front code sorted sequences of strings:
+ * each string is stored as the length of the longest common prefix (LCP) with
+ * its predecessor and the remaining suffix. Also adapters which omit a prefix
+ * shared by all strings, e.g. of the strings between two splitters.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_FRONT_CODED_STRING_STREAM_HEADER
+#define THRILL_CORE_FRONT_CODED_STRING_STREAM_HEADER
+
+#include <thrill/data/serialization.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace thrill {
+namespace core {
+
+//! Returns the length of the longest common prefix of a and b, whose first
+//! offset characters are known to be equal.
+static inline size_t StringLcp(const std::string& a, const std::string& b,
+                               size_t offset = 0) {
+    size_t n = std::min(a.size(), b.size());
+    assert(offset <= n);
+    while (offset < n && a[offset] == b[offset]) ++offset;
+    return offset;
+}
+
+/*!
+ * Item of a front coded string stream: the LCP with the preceding string of
+ * the stream and the remaining suffix.
+ */
+struct FrontCodedString {
+    //! length of the common prefix with the preceding string
+    size_t lcp;
+    //! remaining characters after the common prefix
+    std::string suffix;
+
+    static constexpr bool thrill_is_fixed_size = false;
+    static constexpr size_t thrill_fixed_size = 0;
+
+    //! serialization with Thrill's serializer: the LCP as varint, then suffix
+    template <typename Archive>
+    void ThrillSerialize(Archive& ar) const {
+        ar.PutVarint(lcp);
+        data::Serialization<Archive, std::string>::Serialize(suffix, ar);
+    }
+
+    //! deserialization with Thrill's serializer
+    template <typename Archive>
+    static FrontCodedString ThrillDeserialize(Archive& ar) {
+        FrontCodedString item;
+        item.lcp = ar.GetVarint();
+        item.suffix =
+            data::Serialization<Archive, std::string>::Deserialize(ar);
+        return item;
+    }
+};
+
+/*!
+ * Writer adapter, which front codes the strings put into it, and puts them as
+ * FrontCodedString items into the underlying writer, e.g. a File::Writer. The
+ * strings should be sorted, otherwise the common prefixes are short, but any
+ * sequence is restored by FrontCodedStringReader. Each string remains one item
+ * of the underlying File.
+ */
+template <typename Writer>
+class FrontCodedStringWriter
+{
+public:
+    FrontCodedStringWriter() = default;
+
+    explicit FrontCodedStringWriter(Writer&& writer)
+        : writer_(std::move(writer)) { }
+
+    //! non-copyable: delete copy-constructor
+    FrontCodedStringWriter(const FrontCodedStringWriter&) = delete;
+    //! non-copyable: delete assignment operator
+    FrontCodedStringWriter& operator = (const FrontCodedStringWriter&) = delete;
+    //! move-constructor: default
+    FrontCodedStringWriter(FrontCodedStringWriter&&) = default;
+    //! move-assignment operator: default
+    FrontCodedStringWriter& operator = (FrontCodedStringWriter&&) = default;
+
+    //! whether the underlying writer is valid
+    bool IsValid() const { return writer_.IsValid(); }
+
+    //! append a string
+    FrontCodedStringWriter& Put(const std::string& s) {
+        return Put(s, first_ ? 0 : StringLcp(prev_, s));
+    }
+
+    //! append a string, whose LCP with the previously put string is known,
+    //! e.g. from an LcpMultiwayMergeTree.
+    FrontCodedStringWriter& Put(const std::string& s, size_t lcp) {
+        assert(lcp == (first_ ? 0 : StringLcp(prev_, s)));
+        item_.lcp = lcp;
+        item_.suffix.assign(s, lcp, std::string::npos);
+        writer_.Put(item_);
+        prev_.assign(s);
+        first_ = false;
+        return *this;
+    }
+
+    //! close the underlying writer
+    void Close() {
+        writer_.Close();
+    }
+
+private:
+    //! underlying writer
+    Writer writer_;
+    //! previously put string
+    std::string prev_;
+    //! whether no string was put yet
+    bool first_ = true;
+    //! reused item, whose suffix keeps its capacity
+    FrontCodedString item_;
+};
+
+/*!
+ * Reader adapter, which restores the strings written by FrontCodedStringWriter
+ * from the underlying reader. Additionally delivers the LCP of each string
+ * with its predecessor, which LcpMultiwayMergeTree uses to skip common
+ * prefixes in comparisons.
+ */
+template <typename Reader>
+class FrontCodedStringReader
+{
+public:
+    explicit FrontCodedStringReader(Reader&& reader)
+        : reader_(std::move(reader)) { }
+
+    //! whether another string is available
+    bool HasNext() { return reader_.HasNext(); }
+
+    //! read the next string
+    template <typename Type>
+    std::string Next() {
+        static_assert(std::is_same<Type, std::string>::value,
+                      "Invalid Next() call");
+        FrontCodedString item = reader_.template Next<FrontCodedString>();
+        assert(item.lcp <= current_.size());
+        current_.resize(item.lcp);
+        current_.append(item.suffix);
+        lcp_ = item.lcp;
+        return current_;
+    }
+
+    //! LCP of the last string read with its predecessor, zero for the first.
+    size_t lcp() const { return lcp_; }
+
+    //! underlying reader's source, e.g. for data::StartPrefetch()
+    auto& source() { return reader_.source(); }
+
+private:
+    //! underlying reader
+    Reader reader_;
+    //! last string read
+    std::string current_;
+    //! LCP of current_ with its predecessor
+    size_t lcp_ = 0;
+};
+
+/*!
+ * Writer adapter for strings which all begin with a common prefix of known
+ * length, e.g. the strings between two sorted splitters, which share the
+ * splitters' LCP. Only the suffixes are put into the underlying writer, as
+ * std::string items. A default constructed adapter is invalid.
+ */
+template <typename Writer>
+class StringSuffixWriter
+{
+public:
+    StringSuffixWriter() = default;
+
+    StringSuffixWriter(Writer&& writer, size_t prefix_length)
+        : writer_(std::move(writer)), prefix_length_(prefix_length) { }
+
+    //! non-copyable: delete copy-constructor
+    StringSuffixWriter(const StringSuffixWriter&) = delete;
+    //! non-copyable: delete assignment operator
+    StringSuffixWriter& operator = (const StringSuffixWriter&) = delete;
+    //! move-constructor: default
+    StringSuffixWriter(StringSuffixWriter&&) = default;
+    //! move-assignment operator: default
+    StringSuffixWriter& operator = (StringSuffixWriter&&) = default;
+
+    //! whether the underlying writer is valid
+    bool IsValid() const { return writer_.IsValid(); }
+
+    //! append a string, which begins with the common prefix
+    StringSuffixWriter& Put(const std::string& s) {
+        assert(s.size() >= prefix_length_);
+        if (prefix_length_ == 0) {
+            writer_.Put(s);
+        }
+        else {
+            suffix_.assign(s, prefix_length_, std::string::npos);
+            writer_.Put(suffix_);
+        }
+        return *this;
+    }
+
+    //! close the underlying writer
+    void Close() {
+        writer_.Close();
+    }
+
+private:
+    //! underlying writer
+    Writer writer_;
+    //! length of the omitted common prefix
+    size_t prefix_length_ = 0;
+    //! reused suffix buffer
+    std::string suffix_;
+};
+
+/*!
+ * Reader adapter, which prepends the common prefix omitted by
+ * StringSuffixWriter to the strings read from the underlying reader.
+ */
+template <typename Reader>
+class StringPrefixReader
+{
+public:
+    StringPrefixReader(Reader&& reader, const std::string& prefix)
+        : reader_(std::move(reader)), prefix_(prefix) { }
+
+    //! whether another string is available
+    bool HasNext() { return reader_.HasNext(); }
+
+    //! read the next string
+    template <typename Type>
+    std::string Next() {
+        static_assert(std::is_same<Type, std::string>::value,
+                      "Invalid Next() call");
+        if (prefix_.empty())
+            return reader_.template Next<std::string>();
+        std::string suffix = reader_.template Next<std::string>();
+        std::string s;
+        s.reserve(prefix_.size() + suffix.size());
+        s.append(prefix_).append(suffix);
+        return s;
+    }
+
+private:
+    //! underlying reader
+    Reader reader_;
+    //! common prefix of all strings
+    std::string prefix_;
+};
+
+//! Wrap a writer into a FrontCodedStringWriter.
+template <typename Writer>
+FrontCodedStringWriter<Writer> MakeFrontCodedStringWriter(Writer writer) {
+    return FrontCodedStringWriter<Writer>(std::move(writer));
+}
+
+//! Wrap a reader into a FrontCodedStringReader.
+template <typename Reader>
+FrontCodedStringReader<Reader> MakeFrontCodedStringReader(Reader reader) {
+    return FrontCodedStringReader<Reader>(std::move(reader));
+}
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_FRONT_CODED_STRING_STREAM_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,135 @@
+/*******************************************************************************
+ * thrill/core/heavy_hitters.hpp
+ *
+ * Detection of frequent hashes using Misra-Gries summaries
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_HEAVY_HITTERS_HEADER
+#define THRILL_CORE_HEAVY_HITTERS_HEADER
+
+#include <thrill/api/context.hpp>
+#include <thrill/common/logger.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A Misra-Gries summary of the hashes inserted on a worker, which keeps at most
+ * num_counters counters. Each hash occurring more than n / (num_counters + 1)
+ * times in n inserts is guaranteed to have a counter, which underestimates its
+ * frequency by at most that number.
+ *
+ * Flush() collectively sums the counters of all workers, which is used to
+ * detect heavy hitter keys in operations such as api::InnerJoin(), which would
+ * otherwise send all items of a hot key to a single worker.
+ */
+class HeavyHitterSummary
+{
+    static constexpr bool debug = false;
+
+public:
+    //! pair of hash and count
+    using HashCount = std::pair<size_t, size_t>;
+    using HashCountVector = std::vector<HashCount>;
+
+    explicit HeavyHitterSummary(size_t num_counters)
+        : num_counters_(num_counters) { }
+
+    //! Count an occurrence of hash.
+    void Insert(size_t hash) {
+        ++num_items_;
+
+        auto it = counters_.find(hash);
+        if (it != counters_.end()) {
+            ++it->second;
+            return;
+        }
+        if (counters_.size() < num_counters_) {
+            counters_.emplace(hash, 1);
+            return;
+        }
+
+        // decrement all counters, which is amortized by the inserts
+        for (auto jt = counters_.begin(); jt != counters_.end(); ) {
+            if (--jt->second == 0)
+                jt = counters_.erase(jt);
+            else
+                ++jt;
+        }
+    }
+
+    //! Returns the number of inserted hashes.
+    size_t num_items() const { return num_items_; }
+
+    /*!
+     * Collectively sum the counters of all workers, and return the hashes whose
+     * total count is at least min_count, sorted by hash.
+     */
+    HashCountVector Flush(Context& context, size_t min_count) {
+        HashCountVector vec(counters_.begin(), counters_.end());
+        std::sort(vec.begin(), vec.end());
+        counters_.clear();
+
+        vec = context.net.AllReduce(vec, MergeSum);
+
+        vec.erase(std::remove_if(vec.begin(), vec.end(),
+                                 [min_count](const HashCount& hc) {
+                                     return hc.second < min_count;
+                                 }),
+                  vec.end());
+
+        sLOG << "HeavyHitterSummary: found" << vec.size()
+             << "hashes with at least" << min_count << "items";
+
+        return vec;
+    }
+
+    //! merge two sorted vectors of counters, summing the counts of equal hashes
+    static HashCountVector MergeSum(
+        const HashCountVector& a, const HashCountVector& b) {
+        HashCountVector out;
+        out.reserve(a.size() + b.size());
+
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size()) {
+            if (a[i].first < b[j].first)
+                out.emplace_back(a[i++]);
+            else if (b[j].first < a[i].first)
+                out.emplace_back(b[j++]);
+            else {
+                out.emplace_back(a[i].first, a[i].second + b[j].second);
+                ++i, ++j;
+            }
+        }
+        out.insert(out.end(), a.begin() + i, a.end());
+        out.insert(out.end(), b.begin() + j, b.end());
+        return out;
+    }
+
+private:
+    //! maximum number of counters
+    size_t num_counters_;
+
+    //! number of inserted hashes
+    size_t num_items_ = 0;
+
+    //! counters of the summary
+    std::unordered_map<size_t, size_t> counters_;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_HEAVY_HITTERS_HEADER
+
+/******************************************************************************/
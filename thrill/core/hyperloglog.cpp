@@ -17,9 +17,14 @@
 #include <thrill/net/buffer_builder.hpp>
 #include <thrill/net/buffer_reader.hpp>
 
+#include <algorithm>
 #include <climits>
 #include <limits>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace thrill {
 namespace core {
 namespace hyperloglog {
@@ -1590,57 +1595,6 @@ public:
     }
 };
 
-template <typename ForwardIt>
-class SparseListIterator
-    : public common::ItemReaderToolsBase<SparseListIterator<ForwardIt> >,
-      public std::iterator<std::forward_iterator_tag, uint32_t, std::ptrdiff_t,
-                           void, void>
-{
-    ForwardIt iterator;
-    uint32_t lastVal = 0;
-    static_assert(std::is_same<typename ForwardIt::value_type, uint8_t>::value,
-                  "ForwardIt must return uint8_t");
-
-public:
-    explicit SparseListIterator(ForwardIt it) : iterator(it) { }
-    uint8_t GetByte() { return *iterator++; }
-    uint8_t PeekByte(size_t i) const { return iterator[i]; }
-    SparseListIterator<ForwardIt>& operator ++ () {
-        lastVal = lastVal + this->GetVarint32();
-        return *this;
-    }
-    SparseListIterator<ForwardIt> operator ++ (int) {
-        SparseListIterator<ForwardIt> prev(*this);
-        ++*this;
-        return prev;
-    }
-    uint32_t operator * () const {
-        return lastVal + this->PeekVarint32();
-    }
-    bool operator == (const SparseListIterator<ForwardIt>& other) const {
-        return iterator == other.iterator;
-    }
-    bool operator != (const SparseListIterator<ForwardIt>& other) const {
-        return !(*this == other);
-    }
-};
-
-template <typename ForwardIt>
-SparseListIterator<ForwardIt> makeSparseListIterator(ForwardIt it) {
-    return SparseListIterator<ForwardIt>(it);
-}
-
-class DecodedSparseList
-{
-    const std::vector<uint8_t>& sparseListBuffer_;
-
-public:
-    DecodedSparseList(const std::vector<uint8_t>& sparseListBuf)
-        : sparseListBuffer_(sparseListBuf) { }
-    auto begin() { return makeSparseListIterator(sparseListBuffer_.begin()); }
-    auto end() { return makeSparseListIterator(sparseListBuffer_.end()); }
-};
-
 std::vector<uint8_t> encodeSparseList(const std::vector<uint32_t>& sparseList) {
     if (sparseList.empty()) {
         return { };
@@ -1659,14 +1613,52 @@ std::vector<uint8_t> encodeSparseList(const std::vector<uint32_t>& sparseList) {
     return sparseListBuffer_;
 }
 
+/*!
+ * Calls f(value) for each value of the varint and difference encoded sparse
+ * list, decoding each byte once.
+ */
+template <typename Function>
+void forEachSparseList(const std::vector<uint8_t>& sparseList, Function f) {
+    const uint8_t* it = sparseList.data();
+    const uint8_t* end = it + sparseList.size();
+    uint32_t value = 0;
+    while (it != end) {
+        uint32_t v = *it++;
+        if (v & 0x80) {
+            v &= 0x7F;
+            uint32_t u, shift = 7;
+            do {
+                u = *it++;
+                v |= (u & 0x7F) << shift;
+                shift += 7;
+            } while (u & 0x80);
+        }
+        value += v;
+        f(value);
+    }
+}
+
 std::vector<uint32_t> decodeSparseList(const std::vector<uint8_t>& sparseList) {
     std::vector<uint32_t> decoded;
-    for (auto val : core::hyperloglog::DecodedSparseList(sparseList)) {
-        decoded.emplace_back(val);
-    }
+    decoded.reserve(sparseList.size());
+    forEachSparseList(sparseList, [&](uint32_t val) {
+                          decoded.emplace_back(val);
+                      });
     return decoded;
 }
 
+//! table of 2^-r for register values r, which are always below 64
+struct NegativePowersOfTwo {
+    double value[64];
+
+    NegativePowersOfTwo() {
+        for (size_t r = 0; r < 64; ++r)
+            value[r] = std::ldexp(1.0, -static_cast<int>(r));
+    }
+};
+
+static const NegativePowersOfTwo s_negative_powers;
+
 } // namespace hyperloglog
 
 /******************************************************************************/
@@ -1677,19 +1669,15 @@ void HyperLogLogRegisters<p>::toDense() {
     assert(format_ == HyperLogLogRegisterFormat::SPARSE);
     format_ = HyperLogLogRegisterFormat::DENSE;
     entries_.resize(1 << p, 0);
-    for (auto val : hyperloglog::DecodedSparseList(sparseListBuffer_)) {
-        auto decoded = hyperloglog::decodeHash<25, p>(val);
-        auto entry = entries_[decoded.first];
-        auto value = std::max(entry, decoded.second);
-        entries_[decoded.first] = value;
-    }
-
-    for (auto& val : deltaSet_) {
-        auto decoded = hyperloglog::decodeHash<25, p>(val);
-        auto entry = entries_[decoded.first];
-        auto value = std::max(entry, decoded.second);
-        entries_[decoded.first] = value;
-    }
+    uint8_t* entries = entries_.data();
+    auto insertSparse = [entries](HyperLogLogSparseRegister val) {
+                            auto decoded = hyperloglog::decodeHash<25, p>(val);
+                            entries[decoded.first] = std::max(
+                                entries[decoded.first], decoded.second);
+                        };
+
+    hyperloglog::forEachSparseList(sparseListBuffer_, insertSparse);
+    std::for_each(deltaSet_.begin(), deltaSet_.end(), insertSparse);
     sparseListBuffer_.clear();
     deltaSet_.clear();
     sparseListBuffer_.shrink_to_fit();
@@ -1743,13 +1731,14 @@ void HyperLogLogRegisters<p>::insert_hash(const uint64_t& hash_value) {
 
 template <size_t p>
 void HyperLogLogRegisters<p>::mergeSparse() {
-    hyperloglog::DecodedSparseList sparseList(sparseListBuffer_);
+    std::vector<HyperLogLogSparseRegister> sparseList =
+        hyperloglog::decodeSparseList(sparseListBuffer_);
     assert(std::is_sorted(sparseList.begin(), sparseList.end()));
     std::sort(deltaSet_.begin(), deltaSet_.end());
-    std::vector<HyperLogLogSparseRegister> resultVec;
+    std::vector<HyperLogLogSparseRegister> resultVec(
+        sparseList.size() + deltaSet_.size());
     std::merge(sparseList.begin(), sparseList.end(),
-               deltaSet_.begin(), deltaSet_.end(),
-               std::back_inserter(resultVec));
+               deltaSet_.begin(), deltaSet_.end(), resultVec.begin());
     deltaSet_.clear();
     deltaSet_.shrink_to_fit();
     std::vector<HyperLogLogSparseRegister> vec = hyperloglog::mergeSameIndices<25>(resultVec);
@@ -1762,8 +1751,22 @@ void HyperLogLogRegisters<p>::mergeDense(const HyperLogLogRegisters<p>& b) {
     assert(format_ == HyperLogLogRegisterFormat::DENSE);
     const size_t m = 1 << p;
     assert(m == size() && m == b.size());
-    for (size_t i = 0; i < m; ++i) {
-        entries_[i] = std::max(entries_[i], b.entries_[i]);
+    uint8_t* a_entries = entries_.data();
+    const uint8_t* b_entries = b.entries_.data();
+    size_t i = 0;
+#if defined(__SSE2__)
+    // byte-wise maximum of 16 registers at once
+    for ( ; i + 16 <= m; i += 16) {
+        __m128i x = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(a_entries + i));
+        __m128i y = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(b_entries + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a_entries + i),
+                         _mm_max_epu8(x, y));
+    }
+#endif
+    for ( ; i < m; ++i) {
+        a_entries[i] = std::max(a_entries[i], b_entries[i]);
     }
 }
 
@@ -1781,13 +1784,25 @@ double HyperLogLogRegisters<p>::result() {
     const size_t m = 1 << p;
     assert(size() == m);
 
-    double E = 0.0;
-    unsigned V = 0;
+    // count the register values in four interleaved histograms, to break the
+    // dependency chains of equal values, then sum up 2^-r per value.
+    uint32_t histogram[4][64] = { };
+    const uint8_t* entries = entries_.data();
+    for (size_t i = 0; i < m; i += 4) {
+        ++histogram[0][entries[i]];
+        ++histogram[1][entries[i + 1]];
+        ++histogram[2][entries[i + 2]];
+        ++histogram[3][entries[i + 3]];
+    }
 
-    for (const uint64_t& entry : entries_) {
-        E += std::pow(2.0, -static_cast<double>(entry));
-        V += (entry == 0 ? 1 : 0);
+    double E = 0.0;
+    for (size_t r = 0; r < 64; ++r) {
+        uint32_t count = histogram[0][r] + histogram[1][r] +
+                         histogram[2][r] + histogram[3][r];
+        E += count * hyperloglog::s_negative_powers.value[r];
     }
+    unsigned V = histogram[0][0] + histogram[1][0] +
+                 histogram[2][0] + histogram[3][0];
 
     E = hyperloglog::alpha<p>() * m * m / E;
     double E_ = E;
@@ -1821,9 +1836,13 @@ HyperLogLogRegisters<p>::operator + (const HyperLogLogRegisters<p>& regs2) const
 
         HyperLogLogRegisters<p> result = *this;
 
-        hyperloglog::DecodedSparseList sparseList2(regs2.sparseListBuffer_);
-        std::copy(sparseList2.begin(), sparseList2.end(),
-                  std::back_inserter(result.deltaSet_));
+        result.deltaSet_.reserve(
+            result.deltaSet_.size() + regs2.sparseListBuffer_.size() +
+            regs2.deltaSet_.size());
+        hyperloglog::forEachSparseList(
+            regs2.sparseListBuffer_, [&](HyperLogLogSparseRegister val) {
+                result.deltaSet_.emplace_back(val);
+            });
         std::copy(regs2.deltaSet_.begin(), regs2.deltaSet_.end(),
                   std::back_inserter(result.deltaSet_));
         result.mergeSparse();
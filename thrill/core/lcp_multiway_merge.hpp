@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * thrill/core/lcp_multiway_merge.hpp
+ *
+ * Multiway merge of sorted string sequences with an LCP-aware loser tree, which
+ * skips the common prefixes of the strings in comparisons.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_LCP_MULTIWAY_MERGE_HEADER
+#define THRILL_CORE_LCP_MULTIWAY_MERGE_HEADER
+
+#include <thrill/core/front_coded_string_stream.hpp>
+
+#include <tlx/math/round_to_power_of_two.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Multiway merge of sorted sequences of std::string in the order of std::less,
+ * with a loser tree whose nodes store the LCP of their loser with the winner
+ * which beat it. The readers deliver the LCP of each string with their
+ * previous one via lcp(), e.g. FrontCodedStringReader.
+ *
+ * All strings in the tree are at least as large as the last output string w,
+ * and when w is replaced by the next string of its sequence, all nodes on the
+ * leaf's path store LCPs relative to w. Of two strings with LCPs ha > hb
+ * relative to w, the first is smaller, hence characters are only compared if
+ * both LCPs are equal, and then beginning after the common prefix. The merge
+ * delivers the LCP of each output string with the previous one, which e.g.
+ * FrontCodedStringWriter uses directly.
+ *
+ * If Stable, equal strings are delivered in the order of their sequences.
+ */
+template <typename ReaderIterator, bool Stable = false>
+class LcpMultiwayMergeTree
+{
+public:
+    LcpMultiwayMergeTree(ReaderIterator readers_begin,
+                         ReaderIterator readers_end)
+        : readers_(readers_begin),
+          num_inputs_(readers_end - readers_begin),
+          k_(tlx::round_up_to_power_of_two(std::max<size_t>(num_inputs_, 1))),
+          current_(k_), done_(k_, true),
+          losers_(k_), loser_lcp_(k_) {
+
+        for (size_t t = 0; t < num_inputs_; ++t) {
+            if (readers_[t].HasNext()) {
+                current_[t] = readers_[t].template Next<std::string>();
+                done_[t] = false;
+            }
+        }
+        std::tie(winner_, winner_lcp_) = Build(1);
+    }
+
+    //! whether another string is available
+    bool HasNext() const { return !done_[winner_]; }
+
+    //! take the next smallest string out
+    std::string Next() {
+        assert(HasNext());
+        size_t top = winner_;
+        std::string res = std::move(current_[top]);
+        lcp_ = winner_lcp_;
+
+        // replace with the next string of the sequence, whose LCP with res is
+        // known from the reader
+        size_t c = top, hc = 0;
+        if (readers_[top].HasNext()) {
+            current_[top] = readers_[top].template Next<std::string>();
+            hc = readers_[top].lcp();
+        }
+        else {
+            done_[top] = true;
+        }
+
+        // replay the matches on the path to the root
+        for (size_t node = (top + k_) / 2; node >= 1; node /= 2) {
+            size_t l = losers_[node], hl = loser_lcp_[node], lcp;
+            if (!Wins(c, hc, l, hl, lcp)) {
+                losers_[node] = c;
+                std::swap(c, l);
+                hc = hl;
+            }
+            loser_lcp_[node] = lcp;
+        }
+        winner_ = c, winner_lcp_ = hc;
+
+        return res;
+    }
+
+    //! LCP of the last string delivered by Next() with its predecessor, zero
+    //! for the first.
+    size_t lcp() const { return lcp_; }
+
+private:
+    //! readers of the sequences
+    ReaderIterator readers_;
+    //! number of sequences
+    size_t num_inputs_;
+    //! number of leaves, a power of two
+    size_t k_;
+
+    //! current string of each sequence
+    std::vector<std::string> current_;
+    //! whether each sequence is exhausted, or a padding leaf
+    std::vector<bool> done_;
+
+    //! sequence of the loser at each inner node
+    std::vector<size_t> losers_;
+    //! LCP of the loser at each inner node with the string which beat it
+    std::vector<size_t> loser_lcp_;
+
+    //! sequence of the overall winner
+    size_t winner_ = 0;
+    //! LCP of the overall winner with the last output string
+    size_t winner_lcp_ = 0;
+    //! LCP of the last output string with its predecessor
+    size_t lcp_ = 0;
+
+    /*!
+     * Match of sequences a and b, whose strings have LCPs ha and hb with the
+     * same string not larger than either. Returns whether a wins, and the LCP
+     * of the loser with the winner.
+     */
+    bool Wins(size_t a, size_t ha, size_t b, size_t hb, size_t& lcp) const {
+        if (done_[a] || done_[b]) {
+            lcp = 0;
+            return done_[b] && (!done_[a] || a < b);
+        }
+        if (ha != hb) {
+            lcp = std::min(ha, hb);
+            return ha > hb;
+        }
+        const std::string& sa = current_[a], & sb = current_[b];
+        lcp = StringLcp(sa, sb, ha);
+        if (lcp == sa.size())
+            return lcp < sb.size() || !Stable || a < b;
+        if (lcp == sb.size())
+            return false;
+        return static_cast<unsigned char>(sa[lcp]) <
+               static_cast<unsigned char>(sb[lcp]);
+    }
+
+    //! play the initial matches of the subtree at node, returns its winner and
+    //! the winner's LCP with the empty string.
+    std::pair<size_t, size_t> Build(size_t node) {
+        if (node >= k_) return std::make_pair(node - k_, size_t(0));
+
+        std::pair<size_t, size_t> a = Build(2 * node);
+        std::pair<size_t, size_t> b = Build(2 * node + 1);
+
+        size_t lcp;
+        if (Wins(a.first, a.second, b.first, b.second, lcp)) {
+            losers_[node] = b.first, loser_lcp_[node] = lcp;
+            return a;
+        }
+        losers_[node] = a.first, loser_lcp_[node] = lcp;
+        return b;
+    }
+};
+
+/*!
+ * Sequential LCP-aware multi-way merge of sorted std::string sequences, whose
+ * readers deliver the LCP of each string with its predecessor, e.g.
+ * FrontCodedStringReaders.
+ *
+ * \param seqs_begin Begin iterator of reader sequence.
+ * \param seqs_end End iterator of reader sequence.
+ * \tparam Stable Whether equal strings are taken in the order of the readers.
+ */
+template <bool Stable = false, typename ReaderIterator>
+auto make_lcp_multiway_merge_tree(
+    ReaderIterator seqs_begin, ReaderIterator seqs_end) {
+
+    assert(seqs_end - seqs_begin >= 1);
+    return LcpMultiwayMergeTree<ReaderIterator, Stable>(seqs_begin, seqs_end);
+}
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_LCP_MULTIWAY_MERGE_HEADER
+
+/******************************************************************************/
@@ -17,6 +17,7 @@
 
 #include <thrill/common/function_traits.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/lsd_radix_sort.hpp>
 #include <thrill/common/stats_timer.hpp>
 #include <thrill/core/delta_stream.hpp>
 #include <thrill/core/golomb_bit_stream.hpp>
@@ -66,6 +67,14 @@ private:
     size_t modulo_ = 1;
 };
 
+/*!
+ * Detects for each hash of the inserted HashCounts the worker holding most of
+ * its items. The HashCounts are collected in a vector, radix sorted, and
+ * aggregated, then sent as Golomb-coded deltas to the worker responsible for
+ * the hash range, which multiway merges them. Only if the vector exceeds half
+ * of the memory limit are all items inserted into a ReduceTable, which may
+ * spill to disk.
+ */
 template <typename HashCount>
 class LocationDetection
 {
@@ -172,19 +181,31 @@ public:
     }
 
     /*!
-     * Initializes the table to the memory limit size.
+     * Sets the memory limit, the table is only initialized if the items
+     * exceed half of it.
      *
      * \param limit_memory_bytes Memory limit in bytes
      */
     void Initialize(size_t limit_memory_bytes) {
-        table_.Initialize(limit_memory_bytes);
+        limit_memory_bytes_ = limit_memory_bytes;
+        max_direct_items_ = limit_memory_bytes / 2 / sizeof(HashCount);
     }
 
     /*!
-     * Inserts a HashCount item into the table.
+     * Inserts a HashCount item into the vector, or the table once the vector
+     * has overflowed.
      */
     void Insert(const HashCount& item) {
-        table_.Insert(item);
+        if (use_table_) {
+            table_.Insert(item);
+            return;
+        }
+        if (hash_occ_.size() >= max_direct_items_)
+            SwitchToTable();
+        if (use_table_)
+            table_.Insert(item);
+        else
+            hash_occ_.emplace_back(item);
     }
 
     /*!
@@ -192,31 +213,17 @@ public:
      */
     size_t Flush(std::unordered_map<size_t, size_t>& target_processors) {
 
-        size_t num_items = table_.num_items();
-        if (table_.has_spilled_data_on_partition(0)) {
-            num_items += table_.partition_files()[0].num_items();
-        }
+        // all workers must take the same path, since both contain collectives
+        bool use_table =
+            context_.net.AllReduce(size_t(use_table_ ? 1 : 0)) != 0;
+        if (use_table && !use_table_)
+            SwitchToTable();
 
         // golomb code parameters
-        size_t upper_bound_uniques = context_.net.AllReduce(num_items);
         double fpr_parameter = 8;
         size_t golomb_param = (size_t)fpr_parameter;
-        size_t max_hash = golomb_param * upper_bound_uniques;
-
-        emit_.SetModulo(max_hash);
-        hash_occ_.reserve(num_items);
-        table_.FlushAll();
-
-        if (table_.has_spilled_data_on_partition(0)) {
-            data::File::Reader reader =
-                table_.partition_files()[0].GetReader(true);
-
-            while (reader.HasNext()) {
-                emit_.Emit(0, reader.Next<HashCount>());
-            }
-        }
-
-        std::sort(hash_occ_.begin(), hash_occ_.end());
+        size_t max_hash =
+            use_table ? FlushTable(golomb_param) : FlushDirect(golomb_param);
 
         data::CatStreamPtr golomb_data_stream =
             context_.GetNewCatStream(dia_id_);
@@ -226,6 +233,7 @@ public:
                              context_.num_workers(),
                              max_hash);
 
+        size_t num_items = hash_occ_.size();
         tlx::vector_free(hash_occ_);
 
         // get inbound Golomb/delta-encoded hash stream
@@ -361,8 +369,89 @@ public:
         tlx::vector_free(hash_occ_);
     }
 
-    //! Target vector for vector emitter
+private:
+    /*!
+     * Reduces the hashes in the collected vector modulo max_hash and sorts
+     * them, returns max_hash. The hashes are first sorted and aggregated
+     * completely to count the local unique hashes for the bound.
+     */
+    size_t FlushDirect(size_t golomb_param) {
+        auto hash = [](const HashCount& hc) { return hc.hash; };
+
+        common::lsd_radix_sort(hash_occ_.begin(), hash_occ_.end(), hash);
+        hash_occ_.resize(AggregateSorted());
+
+        size_t upper_bound_uniques = context_.net.AllReduce(hash_occ_.size());
+        size_t max_hash = golomb_param * upper_bound_uniques;
+
+        for (HashCount& hc : hash_occ_)
+            hc.hash %= max_hash;
+
+        common::lsd_radix_sort(hash_occ_.begin(), hash_occ_.end(), hash);
+
+        LOG << "LocationDetection: " << hash_occ_.size()
+            << " unique local hashes without table";
+        return max_hash;
+    }
+
+    //! Flushes the table into the vector modulo max_hash and sorts it.
+    size_t FlushTable(size_t golomb_param) {
+        size_t num_items = table_.num_items();
+        if (table_.has_spilled_data_on_partition(0)) {
+            num_items += table_.partition_files()[0].num_items();
+        }
+
+        size_t upper_bound_uniques = context_.net.AllReduce(num_items);
+        size_t max_hash = golomb_param * upper_bound_uniques;
+
+        emit_.SetModulo(max_hash);
+        hash_occ_.reserve(num_items);
+        table_.FlushAll();
+
+        if (table_.has_spilled_data_on_partition(0)) {
+            data::File::Reader reader =
+                table_.partition_files()[0].GetReader(true);
+
+            while (reader.HasNext()) {
+                emit_.Emit(0, reader.Next<HashCount>());
+            }
+        }
+
+        std::sort(hash_occ_.begin(), hash_occ_.end());
+        return max_hash;
+    }
+
+    //! Sums up runs of equal hashes in the sorted vector, returns the new size.
+    size_t AggregateSorted() {
+        size_t out = 0;
+        for (size_t i = 0; i < hash_occ_.size(); ++out) {
+            HashCount total = hash_occ_[i++];
+            while (i < hash_occ_.size() && hash_occ_[i].hash == total.hash)
+                total += hash_occ_[i++];
+            hash_occ_[out] = total;
+        }
+        return out;
+    }
+
+    //! Moves all collected items into the table, which is initialized first.
+    void SwitchToTable() {
+        LOG << "LocationDetection: switching to table after "
+            << hash_occ_.size() << " items";
+        table_.Initialize(limit_memory_bytes_);
+        use_table_ = true;
+        for (const HashCount& hc : hash_occ_)
+            table_.Insert(hc);
+        tlx::vector_free(hash_occ_);
+    }
+
+    //! Collected items, or target vector for vector emitter
     std::vector<HashCount> hash_occ_;
+    //! Whether the items are inserted into the table
+    bool use_table_ = false;
+    //! Memory limit of the table
+    size_t limit_memory_bytes_ = 0;
+    //! Maximum number of items collected in the vector
+    size_t max_direct_items_ = 0;
     //! Emitter to vector
     Emitter emit_;
     //! Thrill context
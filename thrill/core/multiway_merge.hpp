@@ -15,6 +15,7 @@
 #include <tlx/container/loser_tree.hpp>
 
 #include <algorithm>
+#include <cassert>
 #include <functional>
 #include <utility>
 #include <vector>
@@ -115,6 +116,118 @@ private:
     std::vector<std::pair<bool, ValueType> > current_;
 };
 
+/*!
+ * Multiway merge tree which pulls batches of up to BatchSize items from each
+ * input Reader into a local buffer, instead of reading one item at a time
+ * whenever it is taken out of the loser tree. This keeps the deserialization
+ * of each input in tight loops over one block, and the loser tree operates on
+ * the cache-resident buffers.
+ */
+template <
+    typename ValueType,
+    typename ReaderIterator,
+    typename Comparator,
+    bool Stable = false,
+    size_t BatchSize = 256>
+class BatchedMultiwayMergeTree
+{
+public:
+    using Reader = typename std::iterator_traits<ReaderIterator>::value_type;
+
+    using LoserTreeType = tlx::LoserTree<Stable, ValueType, Comparator>;
+
+    BatchedMultiwayMergeTree(
+        ReaderIterator readers_begin, ReaderIterator readers_end,
+        const Comparator& comp)
+        : readers_(readers_begin),
+          num_inputs_(static_cast<unsigned>(readers_end - readers_begin)),
+          remaining_inputs_(num_inputs_),
+          lt_(static_cast<unsigned>(num_inputs_), comp),
+          buffer_(num_inputs_), pos_(num_inputs_, 0) {
+
+        for (unsigned t = 0; t < num_inputs_; ++t)
+        {
+            buffer_[t].reserve(BatchSize);
+            if (TLX_LIKELY(Refill(t))) {
+                lt_.insert_start(&buffer_[t][0], t, false);
+            }
+            else {
+                lt_.insert_start(nullptr, t, true);
+                assert(remaining_inputs_ > 0);
+                --remaining_inputs_;
+            }
+        }
+
+        lt_.init();
+    }
+
+    bool HasNext() const {
+        return (remaining_inputs_ != 0);
+    }
+
+    std::pair<ValueType, unsigned> NextWithSource() {
+        unsigned top = lt_.min_source();
+        ValueType res = Next();
+        return std::make_pair(std::move(res), top);
+    }
+
+    ValueType Next() {
+
+        // take next smallest element out
+        unsigned top = lt_.min_source();
+        ValueType res = std::move(buffer_[top][pos_[top]]);
+
+        if (TLX_LIKELY(++pos_[top] < buffer_[top].size() || Refill(top))) {
+            lt_.delete_min_insert(&buffer_[top][pos_[top]], false);
+        }
+        else {
+            lt_.delete_min_insert(nullptr, true);
+            assert(remaining_inputs_ > 0);
+            --remaining_inputs_;
+        }
+
+        return res;
+    }
+
+private:
+    ReaderIterator readers_;
+    unsigned num_inputs_;
+    size_t remaining_inputs_;
+
+    LoserTreeType lt_;
+    //! buffered items of each input
+    std::vector<std::vector<ValueType> > buffer_;
+    //! position of current item in each buffer
+    std::vector<size_t> pos_;
+
+    //! read the next batch of items from input t, returns false if it is empty
+    bool Refill(unsigned t) {
+        std::vector<ValueType>& buf = buffer_[t];
+        buf.clear();
+        pos_[t] = 0;
+        Reader& reader = readers_[t];
+        while (buf.size() < BatchSize && reader.HasNext())
+            buf.emplace_back(reader.template Next<ValueType>());
+        return !buf.empty();
+    }
+};
+
+/*!
+ * Sequential multi-way merging of Readers, which pulls batches of items from
+ * each input, see BatchedMultiwayMergeTree.
+ */
+template <typename ValueType, bool Stable = false, typename ReaderIterator,
+          typename Comparator = std::less<ValueType> >
+auto make_batched_multiway_merge_tree(
+    ReaderIterator seqs_begin, ReaderIterator seqs_end,
+    const Comparator& comp = Comparator()) {
+
+    assert(seqs_end - seqs_begin >= 1);
+    return BatchedMultiwayMergeTree<
+        ValueType, ReaderIterator, Comparator, Stable>(
+        seqs_begin, seqs_end, comp);
+}
+
 /*!
  * Sequential multi-way merging switch for a file writer as output
  *
@@ -164,6 +277,74 @@ auto make_stable_multiway_merge_tree(
         seqs_begin, seqs_end, comp);
 }
 
+/*!
+ * Plans the next merge of sorted runs with the given sizes, of which more than
+ * merge_degree remain, such that the total volume of all merges is minimal, as
+ * in Huffman coding: the first merge takes so many runs that all later merges,
+ * including the final one, take merge_degree runs, and each merge takes the
+ * smallest runs. If consecutive, e.g. for stable merging, the batch is the
+ * window of consecutive runs with the smallest total size. Returns the indexes
+ * of the batch in ascending order.
+ */
+static inline std::vector<size_t> PlanMergeBatch(
+    const std::vector<size_t>& sizes, size_t merge_degree, bool consecutive) {
+
+    const size_t n = sizes.size();
+    merge_degree = std::max<size_t>(merge_degree, 2);
+    assert(n > merge_degree);
+
+    size_t m = (n - 1) % (merge_degree - 1) + 1;
+    if (m == 1) m = merge_degree;
+
+    std::vector<size_t> batch(m);
+    if (consecutive) {
+        size_t sum = 0, best = 0, best_sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += sizes[i];
+            if (i >= m) sum -= sizes[i - m];
+            if (i + 1 >= m && (i + 1 == m || sum < best_sum))
+                best = i + 1 - m, best_sum = sum;
+        }
+        for (size_t i = 0; i < m; ++i) batch[i] = best + i;
+    }
+    else {
+        std::vector<size_t> order(n);
+        for (size_t i = 0; i < n; ++i) order[i] = i;
+        std::partial_sort(order.begin(), order.begin() + m, order.end(),
+                          [&sizes](size_t a, size_t b) {
+                              return sizes[a] < sizes[b] ||
+                              (sizes[a] == sizes[b] && a < b);
+                          });
+        std::copy(order.begin(), order.begin() + m, batch.begin());
+        std::sort(batch.begin(), batch.end());
+    }
+    return batch;
+}
+
+/*!
+ * Divides a prefetch budget of prefetch bytes per run among the runs of a
+ * merge in proportion to their sizes, since the merge consumes them at rates
+ * proportional to their sizes. Each run gets at least one block.
+ */
+static inline std::vector<size_t> ProportionalPrefetch(
+    const std::vector<size_t>& sizes, size_t prefetch, size_t block_size) {
+
+    size_t total = 0;
+    for (const size_t& s : sizes) total += s;
+
+    std::vector<size_t> out(sizes.size(), prefetch);
+    if (total == 0) return out;
+
+    double budget = static_cast<double>(prefetch * sizes.size());
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        out[i] = std::max(
+            block_size, static_cast<size_t>(
+                budget * static_cast<double>(sizes[i])
+                / static_cast<double>(total)));
+    }
+    return out;
+}
+
 } // namespace core
 } // namespace thrill
 
@@ -0,0 +1,432 @@
+/*******************************************************************************
+ * thrill/core/packed_integer_stream.hpp
+ *
+ * Chunks of integers, or pairs with integer keys, which are serialized as
+ * deltas in varint encoding or bit-packed relative to their minimum, and stream
+ * writers and readers which transparently collect items in such chunks.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_PACKED_INTEGER_STREAM_HEADER
+#define THRILL_CORE_PACKED_INTEGER_STREAM_HEADER
+
+#include <thrill/data/serialization.hpp>
+
+#include <tlx/die.hpp>
+#include <tlx/math/clz.hpp>
+#include <tlx/unused.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+//! Encoding of the keys of a PackedIntegerChunk
+enum class IntegerStreamCodec {
+    //! keys as fixed size integers
+    Raw,
+    //! differences of ascending keys in varint encoding
+    DeltaVarint,
+    //! keys minus their minimum, bit-packed with the width of the range
+    BitPacked,
+    //! the smallest of the above for each chunk
+    Auto
+};
+
+/*!
+ * Traits of items packable into a PackedIntegerChunk: integers of up to 64 bits
+ * and std::pair with such an integer as first. Keys are mapped to uint64_t
+ * preserving their order, the pair's second is serialized as usual.
+ */
+template <typename Type, typename Enable = void>
+struct PackedIntegerTraits {
+    static constexpr bool is_packable = false;
+};
+
+template <typename Type>
+struct PackedIntegerTraits<Type, typename std::enable_if<
+                               std::is_integral<Type>::value &&
+                               sizeof(Type) <= sizeof(uint64_t)>::type> {
+    static constexpr bool is_packable = true;
+
+    //! offset flipping the sign bit of signed keys
+    static constexpr uint64_t flip =
+        std::is_signed<Type>::value ? uint64_t(1) << 63 : 0;
+
+    static uint64_t GetKey(const Type& t) {
+        return std::is_signed<Type>::value
+               ? static_cast<uint64_t>(static_cast<int64_t>(t)) ^ flip
+               : static_cast<uint64_t>(t);
+    }
+
+    template <typename Archive>
+    static void PutRest(const Type&, Archive&) { }
+
+    template <typename Archive>
+    static Type Make(uint64_t key, Archive&) {
+        return std::is_signed<Type>::value
+               ? static_cast<Type>(static_cast<int64_t>(key ^ flip))
+               : static_cast<Type>(key);
+    }
+};
+
+template <typename Key, typename Value>
+struct PackedIntegerTraits<std::pair<Key, Value>, typename std::enable_if<
+                               PackedIntegerTraits<Key>::is_packable>::type> {
+    static constexpr bool is_packable = true;
+
+    using Type = std::pair<Key, Value>;
+
+    static uint64_t GetKey(const Type& t) {
+        return PackedIntegerTraits<Key>::GetKey(t.first);
+    }
+
+    template <typename Archive>
+    static void PutRest(const Type& t, Archive& ar) {
+        data::Serialization<Archive, Value>::Serialize(t.second, ar);
+    }
+
+    template <typename Archive>
+    static Type Make(uint64_t key, Archive& ar) {
+        Key k = PackedIntegerTraits<Key>::Make(key, ar);
+        return Type(k, data::Serialization<Archive, Value>::Deserialize(ar));
+    }
+};
+
+/*!
+ * A chunk of integers, or pairs with integer keys, which is serialized as a
+ * single item with its keys encoded by an IntegerStreamCodec. Ascending keys,
+ * e.g. sorted runs, are stored as varint deltas. Keys of a small range, e.g.
+ * the items of one bucket after splitter classification, are bit-packed
+ * relative to their minimum, like the frame of reference blocks of SIMD-BP128.
+ * With IntegerStreamCodec::Auto, the smallest encoding is selected for each
+ * chunk, hence arbitrary keys never take more than a few bytes extra.
+ *
+ * Writers collect items with push_back() and Put() the chunk when it is full,
+ * readers Next() the chunk and use operator []. PackedIntegerWriter and
+ * PackedIntegerReader do both transparently.
+ */
+template <typename Type>
+class PackedIntegerChunk
+{
+    using Traits = PackedIntegerTraits<Type>;
+    static_assert(Traits::is_packable,
+                  "PackedIntegerChunk requires integers or pairs with "
+                  "integer keys");
+
+public:
+    explicit PackedIntegerChunk(
+        IntegerStreamCodec codec = IntegerStreamCodec::Auto)
+        : codec_(codec) { }
+
+    //! number of items in the chunk
+    size_t size() const { return items_.size(); }
+
+    //! whether the chunk is empty
+    bool empty() const { return items_.empty(); }
+
+    //! reserve space for n items
+    void reserve(size_t n) { items_.reserve(n); }
+
+    //! remove all items
+    void clear() { items_.clear(); }
+
+    //! append an item
+    void push_back(const Type& t) { items_.push_back(t); }
+
+    //! item i
+    const Type& operator [] (size_t i) const { return items_[i]; }
+
+    //! items of the chunk
+    const std::vector<Type>& items() const { return items_; }
+
+    //! codec used for serialization
+    IntegerStreamCodec codec() const { return codec_; }
+
+    /**************************************************************************/
+
+    static constexpr bool thrill_is_fixed_size = false;
+    static constexpr size_t thrill_fixed_size = 0;
+
+    //! serialization with Thrill's serializer: the size, the codec, the keys,
+    //! then the remaining fields of the items.
+    template <typename Archive>
+    void ThrillSerialize(Archive& ar) const {
+        size_t n = items_.size();
+        ar.PutVarint(n);
+        if (n == 0) return;
+
+        uint64_t min_key = Traits::GetKey(items_[0]), max_key = min_key;
+        bool ascending = true;
+        size_t delta_bytes = VarintSize(min_key);
+        for (size_t i = 1; i < n; ++i) {
+            uint64_t prev = Traits::GetKey(items_[i - 1]);
+            uint64_t key = Traits::GetKey(items_[i]);
+            min_key = std::min(min_key, key);
+            max_key = std::max(max_key, key);
+            if (key < prev) ascending = false;
+            else delta_bytes += VarintSize(key - prev);
+        }
+
+        size_t width = BitWidth(max_key - min_key);
+        size_t packed_bytes =
+            VarintSize(min_key) + 1 + (n * width + 63) / 64 * 8;
+
+        IntegerStreamCodec codec = codec_;
+        if (codec == IntegerStreamCodec::DeltaVarint && !ascending)
+            codec = IntegerStreamCodec::BitPacked;
+        if (codec == IntegerStreamCodec::Auto) {
+            codec = IntegerStreamCodec::BitPacked;
+            if (ascending && delta_bytes <= packed_bytes)
+                codec = IntegerStreamCodec::DeltaVarint;
+            else if (packed_bytes >= n * sizeof(uint64_t))
+                codec = IntegerStreamCodec::Raw;
+        }
+        ar.PutByte(static_cast<uint8_t>(codec));
+
+        if (codec == IntegerStreamCodec::DeltaVarint) {
+            uint64_t prev = 0;
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t key = Traits::GetKey(items_[i]);
+                ar.PutVarint(key - prev);
+                prev = key;
+            }
+        }
+        else if (codec == IntegerStreamCodec::BitPacked) {
+            ar.PutVarint(min_key);
+            ar.PutByte(static_cast<uint8_t>(width));
+            uint64_t acc = 0;
+            size_t fill = 0;
+            for (size_t i = 0; i < n && width != 0; ++i) {
+                uint64_t v = Traits::GetKey(items_[i]) - min_key;
+                acc |= v << fill;
+                fill += width;
+                if (fill >= 64) {
+                    ar.template PutRaw<uint64_t>(acc);
+                    fill -= 64;
+                    acc = fill ? v >> (width - fill) : 0;
+                }
+            }
+            if (fill != 0)
+                ar.template PutRaw<uint64_t>(acc);
+        }
+        else {
+            for (size_t i = 0; i < n; ++i)
+                ar.template PutRaw<uint64_t>(Traits::GetKey(items_[i]));
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            Traits::PutRest(items_[i], ar);
+    }
+
+    //! deserialization with Thrill's serializer
+    template <typename Archive>
+    static PackedIntegerChunk ThrillDeserialize(Archive& ar) {
+        size_t n = ar.GetVarint();
+        PackedIntegerChunk c;
+        if (n == 0) return c;
+
+        c.codec_ = static_cast<IntegerStreamCodec>(ar.GetByte());
+        std::vector<uint64_t> keys(n);
+
+        if (c.codec_ == IntegerStreamCodec::DeltaVarint) {
+            uint64_t prev = 0;
+            for (size_t i = 0; i < n; ++i)
+                keys[i] = prev = prev + ar.GetVarint();
+        }
+        else if (c.codec_ == IntegerStreamCodec::BitPacked) {
+            uint64_t min_key = ar.GetVarint();
+            size_t width = ar.GetByte();
+            die_unless(width <= 64);
+
+            std::vector<uint64_t> words((n * width + 63) / 64);
+            ar.Read(words.data(), words.size() * sizeof(uint64_t));
+
+            const uint64_t mask =
+                width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+            size_t word = 0, bit = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (width == 0) {
+                    keys[i] = min_key;
+                    continue;
+                }
+                uint64_t v = words[word] >> bit;
+                if (bit + width > 64)
+                    v |= words[word + 1] << (64 - bit);
+                keys[i] = min_key + (v & mask);
+                bit += width;
+                if (bit >= 64) bit -= 64, ++word;
+            }
+        }
+        else {
+            die_unless(c.codec_ == IntegerStreamCodec::Raw);
+            for (size_t i = 0; i < n; ++i)
+                keys[i] = ar.template GetRaw<uint64_t>();
+        }
+
+        c.items_.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            c.items_.emplace_back(Traits::Make(keys[i], ar));
+        return c;
+    }
+
+private:
+    //! encoding requested for serialization, or used by the deserialized chunk
+    IntegerStreamCodec codec_;
+    //! items of the chunk
+    std::vector<Type> items_;
+
+    //! number of bytes of v in varint encoding
+    static size_t VarintSize(uint64_t v) {
+        return v == 0 ? 1 : (BitWidth(v) + 6) / 7;
+    }
+
+    //! number of bits needed to represent v
+    static size_t BitWidth(uint64_t v) {
+        return v == 0 ? 0 : 64 - tlx::clz(v);
+    }
+};
+
+/*!
+ * Writer adapter, which collects items in PackedIntegerChunks of chunk_size
+ * items and puts them into the underlying writer, e.g. a File::Writer or a
+ * Stream's BlockWriter. The pending chunk is written by Flush() and Close(),
+ * or when the adapter is destroyed. A default constructed adapter is invalid.
+ */
+template <typename Writer, typename Type>
+class PackedIntegerWriter
+{
+public:
+    //! default number of items in a chunk
+    static constexpr size_t default_chunk_size = 128;
+
+    PackedIntegerWriter() = default;
+
+    explicit PackedIntegerWriter(
+        Writer&& writer,
+        IntegerStreamCodec codec = IntegerStreamCodec::Auto,
+        size_t chunk_size = default_chunk_size)
+        : writer_(std::move(writer)), chunk_(codec), chunk_size_(chunk_size) {
+        chunk_.reserve(chunk_size_);
+    }
+
+    //! non-copyable: delete copy-constructor
+    PackedIntegerWriter(const PackedIntegerWriter&) = delete;
+    //! non-copyable: delete assignment operator
+    PackedIntegerWriter& operator = (const PackedIntegerWriter&) = delete;
+    //! move-constructor: default
+    PackedIntegerWriter(PackedIntegerWriter&&) = default;
+    //! move-assignment operator: default
+    PackedIntegerWriter& operator = (PackedIntegerWriter&&) = default;
+
+    ~PackedIntegerWriter() {
+        if (writer_.IsValid()) Flush();
+    }
+
+    //! whether the underlying writer is valid
+    bool IsValid() const { return writer_.IsValid(); }
+
+    //! append an item, the chunk is put into the writer when full
+    PackedIntegerWriter& Put(const Type& item) {
+        chunk_.push_back(item);
+        if (chunk_.size() >= chunk_size_) Flush();
+        return *this;
+    }
+
+    //! put the pending chunk into the writer
+    void Flush() {
+        if (chunk_.empty()) return;
+        writer_.Put(chunk_);
+        chunk_.clear();
+    }
+
+    //! put the pending chunk and close the writer
+    void Close() {
+        if (writer_.IsValid()) Flush();
+        writer_.Close();
+    }
+
+private:
+    //! underlying writer
+    Writer writer_;
+    //! pending chunk
+    PackedIntegerChunk<Type> chunk_;
+    //! number of items in a chunk
+    size_t chunk_size_ = default_chunk_size;
+};
+
+/*!
+ * Reader adapter, which reads the PackedIntegerChunks written by
+ * PackedIntegerWriter from the underlying reader and delivers their items.
+ */
+template <typename Reader, typename Type>
+class PackedIntegerReader
+{
+public:
+    explicit PackedIntegerReader(Reader&& reader)
+        : reader_(std::move(reader)) { }
+
+    //! whether another item is available
+    bool HasNext() {
+        while (pos_ == chunk_.size()) {
+            if (!reader_.HasNext()) return false;
+            chunk_ = reader_.template Next<PackedIntegerChunk<Type> >();
+            pos_ = 0;
+        }
+        return true;
+    }
+
+    //! read the next item
+    template <typename Type2>
+    Type Next() {
+        static_assert(std::is_same<Type, Type2>::value, "Invalid Next() call");
+        bool has_next = HasNext();
+        assert(has_next);
+        tlx::unused(has_next);
+        return chunk_[pos_++];
+    }
+
+private:
+    //! underlying reader
+    Reader reader_;
+    //! current chunk
+    PackedIntegerChunk<Type> chunk_;
+    //! position of the next item in chunk_
+    size_t pos_ = 0;
+};
+
+//! Wrap each writer of a vector, e.g. the Writers of a Stream, into a
+//! PackedIntegerWriter.
+template <typename Type, typename Writers>
+std::vector<PackedIntegerWriter<typename Writers::value_type, Type> >
+MakePackedIntegerWriters(Writers writers,
+                         IntegerStreamCodec codec = IntegerStreamCodec::Auto) {
+    std::vector<PackedIntegerWriter<typename Writers::value_type, Type> > out;
+    out.reserve(writers.size());
+    for (typename Writers::value_type& w : writers)
+        out.emplace_back(std::move(w), codec);
+    return out;
+}
+
+//! Wrap a reader into a PackedIntegerReader.
+template <typename Type, typename Reader>
+PackedIntegerReader<Reader, Type> MakePackedIntegerReader(Reader reader) {
+    return PackedIntegerReader<Reader, Type>(std::move(reader));
+}
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_PACKED_INTEGER_STREAM_HEADER
+
+/******************************************************************************/
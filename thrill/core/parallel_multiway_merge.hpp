@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * thrill/core/parallel_multiway_merge.hpp
+ *
+ * Multi-threaded multiway merge of sorted Files: the output is split into
+ * pieces by splitters selected from a regular sample of all Files, and the
+ * pieces are merged concurrently into separate Files.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_PARALLEL_MULTIWAY_MERGE_HEADER
+#define THRILL_CORE_PARALLEL_MULTIWAY_MERGE_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/parallel_sort.hpp>
+#include <thrill/core/multiway_merge.hpp>
+#include <thrill/data/file.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Reader adapter which delivers at most a fixed number of items of the
+ * underlying Reader.
+ */
+template <typename Reader>
+class LimitedReader
+{
+public:
+    LimitedReader(Reader&& reader, size_t limit)
+        : reader_(std::move(reader)), remaining_(limit) { }
+
+    bool HasNext() { return remaining_ != 0 && reader_.HasNext(); }
+
+    template <typename T>
+    T Next() {
+        assert(remaining_ > 0);
+        --remaining_;
+        return reader_.template Next<T>();
+    }
+
+private:
+    Reader reader_;
+    size_t remaining_;
+};
+
+/*!
+ * Merge the sorted Files using num_threads threads. The merge is split into
+ * pieces by num_threads - 1 splitters, which are selected from a regular
+ * sample of oversampling * num_threads items of each File. Splitter positions
+ * in the Files are located by binary search, and each piece is merged by one
+ * thread using a BatchedMultiwayMergeTree into a File created by
+ * make_file(). The concatenation of the returned Files is the sorted union of
+ * the inputs, which are not consumed.
+ *
+ * Items equal to a splitter all belong to the same piece, hence the merge is
+ * stable if Stable is set. If a TaskPool is given, the pieces are merged by its
+ * idle helper threads instead of num_threads new threads.
+ */
+template <typename ValueType, bool Stable = false,
+          typename Comparator = std::less<ValueType>, typename MakeFile>
+std::vector<data::File> parallel_multiway_merge(
+    const std::vector<data::File>& files, const Comparator& comp,
+    size_t num_threads, const MakeFile& make_file,
+    size_t oversampling = 16, common::TaskPool* pool = nullptr) {
+
+    static constexpr bool debug = false;
+
+    num_threads = std::max<size_t>(1, num_threads);
+    size_t num_files = files.size();
+
+    // select splitters from a regular sample of all files
+    std::vector<ValueType> samples;
+    size_t sample_per_file = oversampling * num_threads;
+    for (const data::File& f : files) {
+        size_t n = f.num_items();
+        if (n == 0) continue;
+        size_t s = std::min(n, sample_per_file);
+        for (size_t i = 0; i < s; ++i) {
+            samples.emplace_back(
+                f.template GetItemAt<ValueType>((2 * i + 1) * n / (2 * s)));
+        }
+    }
+    std::sort(samples.begin(), samples.end(), comp);
+
+    std::vector<ValueType> splitters;
+    if (samples.size()) {
+        for (size_t t = 1; t < num_threads; ++t)
+            splitters.emplace_back(samples[t * samples.size() / num_threads]);
+    }
+    size_t num_pieces = splitters.size() + 1;
+
+    sLOG << "parallel_multiway_merge() files" << num_files
+         << "pieces" << num_pieces << "samples" << samples.size();
+
+    // locate splitters in each file by binary search: bounds[p][f] is the
+    // first item of file f in piece p.
+    std::vector<std::vector<size_t> > bounds(
+        num_pieces + 1, std::vector<size_t>(num_files));
+
+    for (size_t f = 0; f < num_files; ++f) {
+        bounds[0][f] = 0;
+        bounds[num_pieces][f] = files[f].num_items();
+    }
+
+    common::parallel_sort_local::RunTasks(
+        num_files, num_threads,
+        [&](size_t f) {
+            size_t left = 0;
+            for (size_t p = 1; p < num_pieces; ++p) {
+                left = files[f].GetIndexOf(
+                    splitters[p - 1], /* tie */ 0,
+                    left, files[f].num_items(), comp);
+                bounds[p][f] = left;
+            }
+        }, pool);
+
+    // merge pieces concurrently
+    std::vector<data::File> output;
+    output.reserve(num_pieces);
+    for (size_t p = 0; p < num_pieces; ++p)
+        output.emplace_back(make_file());
+
+    using Reader = LimitedReader<data::File::KeepReader>;
+
+    common::parallel_sort_local::RunTasks(
+        num_pieces, num_threads,
+        [&](size_t p) {
+            std::vector<Reader> seq;
+            seq.reserve(num_files);
+            for (size_t f = 0; f < num_files; ++f) {
+                seq.emplace_back(
+                    files[f].template GetReaderAt<ValueType>(bounds[p][f]),
+                    bounds[p + 1][f] - bounds[p][f]);
+            }
+
+            auto puller = make_batched_multiway_merge_tree<ValueType, Stable>(
+                seq.begin(), seq.end(), comp);
+
+            data::File::Writer writer = output[p].GetWriter();
+            while (puller.HasNext())
+                writer.Put(puller.Next());
+        }, pool);
+
+    return output;
+}
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_PARALLEL_MULTIWAY_MERGE_HEADER
+
+/******************************************************************************/
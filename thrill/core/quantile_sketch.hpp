@@ -0,0 +1,251 @@
+/*******************************************************************************
+ * thrill/core/quantile_sketch.hpp
+ *
+ * Mergeable KLL sketch for approximate quantiles
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_QUANTILE_SKETCH_HEADER
+#define THRILL_CORE_QUANTILE_SKETCH_HEADER
+
+#include <thrill/data/serialization.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A KLL sketch (Karnin, Lang, Liberty: "Optimal Quantile Approximation in
+ * Streams") for approximate quantiles of a stream of items. The sketch keeps a
+ * hierarchy of compactors: level h holds items of weight 2^h, and the capacity
+ * of the levels decreases geometrically by 2/3 from the top level, which has
+ * capacity k. A full level is sorted and every second item is promoted to the
+ * next level. The rank error is about 1.7 / k with high probability, using
+ * O(k) items of memory.
+ *
+ * Two sketches are merged using operator +, hence the sketches of all workers
+ * can be combined with AllReduce. Compactions choose their offset from the
+ * sketch's own state instead of random coins, such that merges are
+ * deterministic and all workers arrive at the same result.
+ */
+template <typename ValueType, typename CompareFunction = std::less<ValueType> >
+class QuantileSketch
+{
+public:
+    explicit QuantileSketch(
+        size_t k = 200,
+        const CompareFunction& compare_function = CompareFunction())
+        : k_(std::max<size_t>(k, 8)), compare_function_(compare_function),
+          levels_(1) {
+        UpdateCapacity();
+    }
+
+    //! Insert an item into the sketch.
+    void Insert(const ValueType& value) {
+        levels_[0].push_back(value);
+        ++num_items_;
+        if (++num_retained_ > capacity_)
+            Compress();
+    }
+
+    //! Returns the number of inserted items.
+    size_t num_items() const { return num_items_; }
+
+    //! Returns the number of items retained by the sketch.
+    size_t num_retained() const { return num_retained_; }
+
+    //! Returns true if no items were inserted.
+    bool empty() const { return num_items_ == 0; }
+
+    //! Merge the items of another sketch into this one.
+    QuantileSketch& operator += (const QuantileSketch& b) {
+        if (levels_.size() < b.levels_.size()) {
+            levels_.resize(b.levels_.size());
+            UpdateCapacity();
+        }
+        for (size_t h = 0; h < b.levels_.size(); ++h) {
+            levels_[h].insert(levels_[h].end(),
+                              b.levels_[h].begin(), b.levels_[h].end());
+        }
+        num_items_ += b.num_items_;
+        num_retained_ += b.num_retained_;
+        num_compactions_ += b.num_compactions_;
+
+        while (num_retained_ > capacity_)
+            Compress();
+        return *this;
+    }
+
+    //! Merge two sketches, used by AllReduce.
+    QuantileSketch operator + (const QuantileSketch& b) const {
+        QuantileSketch out = *this;
+        out += b;
+        return out;
+    }
+
+    /*!
+     * Returns the approximate phi-quantile, phi in [0,1], of the inserted
+     * items, i.e. the smallest retained item whose estimated rank is at least
+     * phi * num_items(). Must not be called on an empty sketch.
+     */
+    ValueType Quantile(double phi) const {
+        return Quantiles(std::vector<double>(1, phi)).front();
+    }
+
+    //! Returns the approximate quantiles for all phi in phis, see Quantile().
+    std::vector<ValueType> Quantiles(const std::vector<double>& phis) const {
+        assert(!empty());
+
+        // collect retained items with their weight, and sort them
+        std::vector<std::pair<ValueType, size_t> > items;
+        items.reserve(num_retained_);
+        for (size_t h = 0; h < levels_.size(); ++h) {
+            for (const ValueType& v : levels_[h])
+                items.emplace_back(v, size_t(1) << h);
+        }
+        std::sort(items.begin(), items.end(),
+                  [this](const std::pair<ValueType, size_t>& a,
+                         const std::pair<ValueType, size_t>& b) {
+                      return compare_function_(a.first, b.first);
+                  });
+
+        // prefix sums of the weights are the estimated ranks. The total weight
+        // equals num_items_, since each compaction keeps half of an even
+        // number of items with twice the weight.
+        std::vector<size_t> ranks(items.size());
+        size_t rank = 0;
+        for (size_t i = 0; i < items.size(); ++i) {
+            rank += items[i].second;
+            ranks[i] = rank;
+        }
+
+        std::vector<ValueType> out;
+        out.reserve(phis.size());
+        for (const double& phi : phis) {
+            double target = std::max(0.0, std::min(1.0, phi)) * rank;
+            size_t i = std::lower_bound(
+                ranks.begin(), ranks.end(), target,
+                [](const size_t& r, const double& t) { return r < t; })
+                       - ranks.begin();
+            out.emplace_back(items[std::min(i, items.size() - 1)].first);
+        }
+        return out;
+    }
+
+    /**************************************************************************/
+
+    static constexpr bool thrill_is_fixed_size = false;
+    static constexpr size_t thrill_fixed_size = 0;
+
+    //! serialization with Thrill's serializer
+    template <typename Archive>
+    void ThrillSerialize(Archive& ar) const {
+        ar.PutVarint(k_);
+        ar.PutVarint(num_items_);
+        ar.PutVarint(num_compactions_);
+        data::Serialization<Archive, std::vector<std::vector<ValueType> > >
+        ::Serialize(levels_, ar);
+    }
+
+    //! deserialization with Thrill's serializer
+    template <typename Archive>
+    static QuantileSketch ThrillDeserialize(Archive& ar) {
+        QuantileSketch s(ar.GetVarint());
+        s.num_items_ = ar.GetVarint();
+        s.num_compactions_ = ar.GetVarint();
+        s.levels_ =
+            data::Serialization<Archive, std::vector<std::vector<ValueType> > >
+            ::Deserialize(ar);
+        s.num_retained_ = 0;
+        for (const std::vector<ValueType>& level : s.levels_)
+            s.num_retained_ += level.size();
+        s.UpdateCapacity();
+        return s;
+    }
+
+private:
+    //! capacity of level h
+    size_t Capacity(size_t h) const {
+        size_t depth = levels_.size() - 1 - h;
+        return std::max<size_t>(
+            2, static_cast<size_t>(
+                std::ceil(k_ * std::pow(2.0 / 3.0, depth))));
+    }
+
+    //! recalculate the total capacity of all levels
+    void UpdateCapacity() {
+        capacity_ = 0;
+        for (size_t h = 0; h < levels_.size(); ++h)
+            capacity_ += Capacity(h);
+    }
+
+    //! compact the lowest level which is full
+    void Compress() {
+        for (size_t h = 0; h < levels_.size(); ++h) {
+            if (levels_[h].size() >= Capacity(h)) {
+                Compact(h);
+                return;
+            }
+        }
+    }
+
+    //! sort level h and promote every second item to level h + 1.
+    void Compact(size_t h) {
+        if (h + 1 == levels_.size()) {
+            levels_.emplace_back();
+            UpdateCapacity();
+        }
+
+        std::vector<ValueType>& level = levels_[h];
+        std::sort(level.begin(), level.end(), compare_function_);
+
+        // with an odd number of items, the largest one stays on the level
+        size_t even = level.size() & ~size_t(1);
+        size_t offset = (num_compactions_++ + h) & 1;
+
+        std::vector<ValueType>& next = levels_[h + 1];
+        for (size_t i = offset; i < even; i += 2)
+            next.emplace_back(std::move(level[i]));
+
+        level.erase(level.begin(), level.begin() + even);
+        num_retained_ -= even / 2;
+    }
+
+    //! capacity of the top level
+    size_t k_;
+
+    //! comparator of the items
+    CompareFunction compare_function_;
+
+    //! compactor levels, level h contains items of weight 2^h
+    std::vector<std::vector<ValueType> > levels_;
+
+    //! number of inserted items
+    size_t num_items_ = 0;
+
+    //! number of items in all levels
+    size_t num_retained_ = 0;
+
+    //! number of compactions, used to alternate the offset
+    size_t num_compactions_ = 0;
+
+    //! total capacity of all levels
+    size_t capacity_ = 0;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_QUANTILE_SKETCH_HEADER
+
+/******************************************************************************/
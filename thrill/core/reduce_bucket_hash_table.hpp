@@ -257,12 +257,15 @@ public:
          * \return true if a new key was inserted to the table
      */
     bool Insert(const TableItem& kv) {
+        return Insert(kv, calculate_index(kv));
+    }
+
+    //! Inserts a value with its index calculated beforehand.
+    bool Insert(const TableItem& kv, const typename IndexFunction::Result& h) {
 
         while (TLX_UNLIKELY(mem::memory_exceeded && num_items_ != 0))
             SpillAnyPartition();
 
-        typename IndexFunction::Result h = calculate_index(kv);
-
         size_t local_index = h.local_index(num_buckets_per_partition_);
 
         assert(h.partition_id < num_partitions_);
@@ -281,7 +284,7 @@ public:
                 // if item and key equals, then reduce.
                 if (key_equal_function_(key(kv), key(*bi)))
                 {
-                    *bi = reduce(*bi, kv);
+                    reduce_into(*bi, kv);
                     return false;
                 }
             }
@@ -18,10 +18,13 @@
 
 #include <thrill/api/context.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/parallel_sort.hpp>
 #include <thrill/core/reduce_bucket_hash_table.hpp>
+#include <thrill/core/hyperloglog.hpp>
 #include <thrill/core/reduce_functional.hpp>
 #include <thrill/core/reduce_old_probing_hash_table.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_swiss_hash_table.hpp>
 #include <thrill/data/file.hpp>
 
 #include <algorithm>
@@ -57,10 +60,27 @@ public:
         VolatileKey, ReduceConfig,
         IndexFunction, KeyEqualFunction>::type;
 
+    //! whether to split spilled partitions by estimated distinct keys
+    static constexpr bool use_grace_post_phase_ =
+        ReduceConfig::use_grace_post_phase_;
+
+    //! whether to insert items from readers in batches with prefetched slots
+    static constexpr bool use_batch_insert_ =
+        ReduceConfig::use_batch_insert_;
+
     /*!
      * A data structure which takes an arbitrary value and extracts a key using
      * a key extractor function from that value. Afterwards, the value is hashed
      * based on the key into some slot.
+     *
+     * If partitions overflow, they are spilled into Files, which are
+     * re-reduced iteratively until all fit into memory. With
+     * use_grace_post_phase_ (grace hash join style) the number of distinct
+     * keys of each partition is estimated by a HyperLogLog sketch. Before
+     * re-reducing, each spilled File is split by hash into as many Files as
+     * needed for their keys to fit into a table using the whole memory limit,
+     * which is the share of the BlockPool assigned to this DIA. Hence, unless
+     * the estimate is too far off, only one re-reduce pass is needed.
      */
     ReduceByHashPostPhase(
         Context& ctx, size_t dia_id,
@@ -85,12 +105,32 @@ public:
 
     void Initialize(size_t limit_memory_bytes) {
         table_.Initialize(limit_memory_bytes);
+        if (use_grace_post_phase_)
+            grace_hll_.resize(table_.num_partitions());
     }
 
     bool Insert(const TableItem& kv) {
+        if (use_grace_post_phase_) {
+            // reconstruct the full hash value of the key for the sketch
+            typename IndexFunction::Result h = table_.calculate_index(kv);
+            grace_hll_[h.partition_id].insert_hash(
+                h.remaining_hash * table_.num_partitions() + h.partition_id);
+            return table_.Insert(kv, h);
+        }
         return table_.Insert(kv);
     }
 
+    //! Inserts all items of a reader, in batches if use_batch_insert_.
+    template <typename Reader>
+    void InsertAll(Reader& reader) {
+        if (!use_batch_insert_ || use_grace_post_phase_) {
+            while (reader.HasNext())
+                Insert(reader.template Next<TableItem>());
+            return;
+        }
+        InsertBatches(table_, reader);
+    }
+
     //! Flushes all items in the whole table.
     template <bool DoCache>
     void Flush(bool consume, data::File::Writer* writer = nullptr) {
@@ -99,6 +139,8 @@ public:
         // list of remaining files, containing only partially reduced item pairs
         // or items
         std::vector<data::File> remaining_files;
+        // estimated number of distinct keys in remaining_files
+        std::vector<double> remaining_distinct;
 
         // read primary hash table, since ReduceByHash delivers items in any
         // order, we can just emit items from fully reduced partitions.
@@ -119,6 +161,8 @@ public:
                         << file.num_items() << " partially reduced items";
 
                     remaining_files.emplace_back(std::move(file));
+                    if (use_grace_post_phase_)
+                        remaining_distinct.push_back(grace_hll_[id].result());
                 }
                 else {
                     LOG << "partition " << id << " contains "
@@ -145,9 +189,127 @@ public:
 
         assert(consume && "Items were spilled hence Flushing must consume");
 
-        // if partially reduce files remain, create new hash tables to process
-        // them iteratively.
+        if (use_grace_post_phase_) {
+            remaining_files = GraceSplit(remaining_files, remaining_distinct);
+            tlx::vector_free(grace_hll_);
+        }
+
+        auto emit = [this, writer](const TableItem& p) {
+                        if (DoCache) writer->Put(p);
+                        emitter_.Emit(p);
+                    };
+
+        // with post_phase_threads = 0 the files are re-reduced by the host's
+        // TaskPool, otherwise by a fixed number of threads.
+        size_t num_threads = config_.post_phase_threads();
+        common::TaskPool* pool = nullptr;
+        if (num_threads == 0) {
+            pool = &table_.ctx().task_pool();
+            num_threads = pool->max_parallelism();
+        }
+        num_threads = std::min(num_threads, remaining_files.size());
+
+        if (num_threads <= 1) {
+            num_passes_ = ReReduce(
+                remaining_files, table_.limit_memory_bytes(), emit);
+        }
+        else {
+            // re-reduce the files concurrently, each thread with its share of
+            // the memory limit. The output of each file is buffered and then
+            // emitted by this thread in file order.
+            size_t num_files = remaining_files.size();
+
+            sLOG << "ReducePostPhase: re-reducing" << num_files
+                 << "spilled files with" << num_threads << "threads";
+
+            std::vector<data::File> outputs;
+            outputs.reserve(num_files);
+            for (size_t i = 0; i < num_files; ++i)
+                outputs.emplace_back(table_.ctx().GetFile(table_.dia_id()));
+
+            std::vector<size_t> passes(num_files);
+            size_t limit_memory_bytes =
+                table_.limit_memory_bytes() / num_threads;
+
+            common::parallel_sort_local::RunTasks(
+                num_files, num_threads,
+                [&](size_t i) {
+                    std::vector<data::File> files;
+                    files.emplace_back(std::move(remaining_files[i]));
+                    data::File::Writer w = outputs[i].GetWriter();
+                    passes[i] = ReReduce(
+                        files, limit_memory_bytes,
+                        [&w](const TableItem& p) { w.Put(p); });
+                }, pool);
+
+            num_passes_ = *std::max_element(passes.begin(), passes.end());
+
+            for (data::File& f : outputs) {
+                data::File::ConsumeReader reader = f.GetConsumeReader();
+                while (reader.HasNext())
+                    emit(reader.Next<TableItem>());
+            }
+        }
+
+        LOG << "Flushed items";
+    }
+
+    //! Push data into emitter
+    void PushData(bool consume = false) {
+        if (!cache_)
+        {
+            if (!table_.has_spilled_data()) {
+                // no items were spilled to disk, hence we can emit all data
+                // from RAM.
+                Flush</* DoCache */ false>(consume);
+            }
+            else {
+                // items were spilled, hence the reduce table must be emptied
+                // and we have to cache the output stream.
+                cache_ = table_.ctx().GetFilePtr(table_.dia_id());
+                data::File::Writer writer = cache_->GetWriter();
+                Flush</* DoCache */ true>(true, &writer);
+            }
+        }
+        else
+        {
+            // previous PushData() has stored data in cache_
+            cache_->VisitReader(
+                consume, [this](auto& reader) {
+                    while (reader.HasNext())
+                        emitter_.Emit(reader.template Next<TableItem>());
+                });
+        }
+    }
+
+    void Dispose() {
+        table_.Dispose();
+        if (cache_) cache_.reset();
+    }
+
+    //! \name Accessors
+    //! \{
+
+    //! Returns mutable reference to first table_
+    Table& table() { return table_; }
+
+    //! Returns the total num of items in the table.
+    size_t num_items() const { return table_.num_items(); }
+
+    //! Returns the number of re-reduce passes over spilled items
+    size_t num_passes() const { return num_passes_; }
+
+    //! \}
 
+private:
+    /*!
+     * If partially reduced files remain, create new hash tables to process
+     * them iteratively, using limit_memory_bytes each. Fully reduced items are
+     * passed to emit(). Returns the number of iterations.
+     */
+    template <typename Emit>
+    size_t ReReduce(std::vector<data::File>& remaining_files,
+                    size_t limit_memory_bytes, const Emit& emit) {
         size_t iteration = 1;
 
         while (remaining_files.size())
@@ -166,7 +328,7 @@ public:
                 IndexFunction(iteration, table_.index_function()),
                 table_.key_equal_function());
 
-            subtable.Initialize(table_.limit_memory_bytes());
+            subtable.Initialize(limit_memory_bytes);
 
             size_t num_subfile = 0;
 
@@ -178,8 +340,12 @@ public:
 
                 data::File::ConsumeReader reader = file.GetConsumeReader();
 
-                while (reader.HasNext()) {
-                    subtable.Insert(reader.Next<TableItem>());
+                if (use_batch_insert_) {
+                    InsertBatches(subtable, reader);
+                }
+                else {
+                    while (reader.HasNext())
+                        subtable.Insert(reader.Next<TableItem>());
                 }
 
                 // after insertion, flush fully reduced partitions and save
@@ -208,10 +374,8 @@ public:
 
                         subtable.FlushPartitionEmit(
                             id, /* consume */ true, /* grow */ false,
-                            [this, writer](
-                                const size_t& partition_id, const TableItem& p) {
-                                if (DoCache) writer->Put(p);
-                                emitter_.Emit(partition_id, p);
+                            [&emit](const size_t&, const TableItem& p) {
+                                emit(p);
                             });
                     }
                 }
@@ -221,52 +385,85 @@ public:
             ++iteration;
         }
 
-        LOG << "Flushed items";
+        return iteration - 1;
     }
 
-    //! Push data into emitter
-    void PushData(bool consume = false) {
-        if (!cache_)
+    /*!
+     * Split each spilled File into as many Files as required for its
+     * estimated number of distinct keys to fit into a table which uses the
+     * whole memory limit.
+     */
+    std::vector<data::File> GraceSplit(
+        std::vector<data::File>& files, const std::vector<double>& distinct) {
+
+        // number of items which fit into a table using the whole memory
+        // limit, with some headroom for hash imbalance and estimation error.
+        double capacity = std::max(
+            1.0, static_cast<double>(table_.limit_memory_bytes())
+            * config_.limit_partition_fill_rate()
+            / static_cast<double>(sizeof(TableItem)) / 1.5);
+
+        // use a different hash salt than the subtables
+        IndexFunction split_function(
+            /* salt */ size_t(-1), table_.index_function());
+
+        std::vector<data::File> output;
+
+        for (size_t i = 0; i < files.size(); ++i)
         {
-            if (!table_.has_spilled_data()) {
-                // no items were spilled to disk, hence we can emit all data
-                // from RAM.
-                Flush</* DoCache */ false>(consume);
-            }
-            else {
-                // items were spilled, hence the reduce table must be emptied
-                // and we have to cache the output stream.
-                cache_ = table_.ctx().GetFilePtr(table_.dia_id());
-                data::File::Writer writer = cache_->GetWriter();
-                Flush</* DoCache */ true>(true, &writer);
+            size_t fan_out = static_cast<size_t>(
+                std::ceil(distinct[i] / capacity));
+
+            sLOG << "ReducePostPhase: spilled file" << i
+                 << "with" << files[i].num_items() << "items"
+                 << "estimated" << distinct[i] << "distinct keys"
+                 << "fan_out" << fan_out;
+
+            if (fan_out <= 1) {
+                output.emplace_back(std::move(files[i]));
+                continue;
             }
-        }
-        else
-        {
-            // previous PushData() has stored data in cache_
-            data::File::Reader reader = cache_->GetReader(consume);
-            while (reader.HasNext())
-                emitter_.Emit(reader.Next<TableItem>());
-        }
-    }
 
-    void Dispose() {
-        table_.Dispose();
-        if (cache_) cache_.reset();
-    }
+            std::vector<data::File> parts;
+            std::vector<data::File::Writer> writers;
+            for (size_t p = 0; p < fan_out; ++p) {
+                parts.emplace_back(table_.ctx().GetFile(table_.dia_id()));
+                writers.emplace_back(parts.back().GetWriter());
+            }
 
-    //! \name Accessors
-    //! \{
+            data::File::ConsumeReader reader = files[i].GetConsumeReader();
+            while (reader.HasNext()) {
+                TableItem item = reader.Next<TableItem>();
+                size_t p = split_function(
+                    table_.key(item), fan_out, 1, fan_out).partition_id;
+                writers[p].Put(item);
+            }
+            writers.clear();
 
-    //! Returns mutable reference to first table_
-    Table& table() { return table_; }
+            for (data::File& f : parts)
+                output.emplace_back(std::move(f));
+        }
 
-    //! Returns the total num of items in the table.
-    size_t num_items() const { return table_.num_items(); }
+        return output;
+    }
 
-    //! \}
+    //! Inserts all items of a reader into a table with
+    //! ReduceTableInsertBatch().
+    template <typename Reader>
+    static void InsertBatches(Table& table, Reader& reader) {
+        static constexpr size_t batch_size = ReduceConfig::batch_insert_size_;
+        TableItem batch[batch_size];
+        size_t n = 0;
+        while (reader.HasNext()) {
+            batch[n] = reader.template Next<TableItem>();
+            if (++n == batch_size) {
+                ReduceTableInsertBatch(table, batch, n);
+                n = 0;
+            }
+        }
+        ReduceTableInsertBatch(table, batch, n);
+    }
 
-private:
     //! Stored reduce config to initialize the subtable.
     ReduceConfig config_;
 
@@ -278,6 +475,12 @@ private:
 
     //! File for storing data in-case we need multiple re-reduce levels.
     data::FilePtr cache_;
+
+    //! distinct key sketches of the partitions for use_grace_post_phase_
+    std::vector<HyperLogLogRegisters<7> > grace_hll_;
+
+    //! number of re-reduce passes of the last Flush()
+    size_t num_passes_ = 0;
 };
 
 } // namespace core
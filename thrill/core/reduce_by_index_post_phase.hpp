@@ -150,7 +150,7 @@ public:
             if (item_key != neutral_element_key_) {
                 // normal index
                 if (key(items_[offset]) == item_key) {
-                    items_[offset] = reduce(items_[offset], kv);
+                    reduce_into(items_[offset], kv);
                     return false;
                 }
                 else {
@@ -161,7 +161,7 @@ public:
             else {
                 // special handling for element with neutral index
                 if (neutral_element_index_occupied_) {
-                    items_[offset] = reduce(items_[offset], kv);
+                    reduce_into(items_[offset], kv);
                     return false;
                 }
                 else {
@@ -193,9 +193,11 @@ public:
 
         if (cache_) {
             // previous PushData() has stored data in cache_
-            data::File::Reader reader = cache_->GetReader(consume);
-            while (reader.HasNext())
-                emitter_.Emit(reader.Next<TableItem>());
+            cache_->VisitReader(
+                consume, [this](auto& reader) {
+                    while (reader.HasNext())
+                        emitter_.Emit(reader.template Next<TableItem>());
+                });
             return;
         }
 
@@ -279,8 +281,8 @@ private:
         return MakeTableItem::GetKey(t, key_extractor_);
     }
 
-    TableItem reduce(const TableItem& a, const TableItem& b) {
-        return MakeTableItem::Reduce(a, b, reduce_function_);
+    void reduce_into(TableItem& a, const TableItem& b) {
+        MakeTableItem::ReduceInto(a, b, reduce_function_);
     }
 
     //! Context
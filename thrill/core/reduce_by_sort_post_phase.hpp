@@ -0,0 +1,337 @@
+/*******************************************************************************
+ * thrill/core/reduce_by_sort_post_phase.hpp
+ *
+ * Sort-based aggregation with support for reduce.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_BY_SORT_POST_PHASE_HEADER
+#define THRILL_CORE_REDUCE_BY_SORT_POST_PHASE_HEADER
+
+#include <thrill/api/context.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/core/multiway_merge.hpp>
+#include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_table.hpp>
+#include <thrill/data/file.hpp>
+
+#include <tlx/vector_free.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A post-phase for ReduceByKey which aggregates by sorting instead of hashing,
+ * enabled by ReduceConfig::use_sort_post_phase_. It has the same interface as
+ * ReduceByHashPostPhase.
+ *
+ * Items are collected in a vector using the whole memory limit. When it is
+ * full, the vector is sorted by key, adjacent items with equal keys are
+ * reduced, and the result is written as a sorted run into a File. PushData()
+ * merges all runs using the multiway merge tree and reduces adjacent items
+ * with equal keys on the fly. If there are more runs than can be merged at
+ * once, batches of runs are merged and reduced into longer runs first.
+ *
+ * Hence, each item is written and read exactly once per merge level, which
+ * makes the I/O volume predictable, unlike iterated hash re-reduction of
+ * spilled partitions. The Key must be ordered by KeyCompareFunction, items are
+ * output in key order.
+ */
+template <typename TableItem, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction, typename Emitter,
+          const bool VolatileKey,
+          typename ReduceConfig_ = DefaultReduceConfig,
+          typename IndexFunction = ReduceByHash<Key>,
+          typename KeyEqualFunction = std::equal_to<Key>,
+          typename KeyCompareFunction = std::less<Key> >
+class ReduceBySortPostPhase
+{
+    static constexpr bool debug = false;
+
+public:
+    using ReduceConfig = ReduceConfig_;
+    using PhaseEmitter = ReducePostPhaseEmitter<
+        TableItem, Value, Emitter, VolatileKey>;
+    using MakeTableItem = ReduceMakeTableItem<Value, TableItem, VolatileKey>;
+
+    ReduceBySortPostPhase(
+        Context& ctx, size_t dia_id,
+        const KeyExtractor& key_extractor,
+        const ReduceFunction& reduce_function,
+        const Emitter& emit,
+        const ReduceConfig& /* config */ = ReduceConfig(),
+        const IndexFunction& /* index_function */ = IndexFunction(),
+        const KeyEqualFunction& key_equal_function = KeyEqualFunction(),
+        const KeyCompareFunction& key_compare_function = KeyCompareFunction())
+        : ctx_(ctx), dia_id_(dia_id),
+          key_extractor_(key_extractor),
+          reduce_function_(reduce_function),
+          emitter_(emit),
+          key_equal_function_(key_equal_function),
+          key_compare_function_(key_compare_function) { }
+
+    //! non-copyable: delete copy-constructor
+    ReduceBySortPostPhase(const ReduceBySortPostPhase&) = delete;
+    //! non-copyable: delete assignment operator
+    ReduceBySortPostPhase& operator = (const ReduceBySortPostPhase&) = delete;
+
+    void Initialize(size_t limit_memory_bytes) {
+        limit_items_ = std::max<size_t>(
+            1, limit_memory_bytes / sizeof(TableItem));
+        items_.reserve(limit_items_);
+    }
+
+    void Insert(const TableItem& kv) {
+        items_.emplace_back(kv);
+        if (items_.size() >= limit_items_)
+            WriteRun();
+    }
+
+    //! Inserts all items of a reader.
+    template <typename Reader>
+    void InsertAll(Reader& reader) {
+        while (reader.HasNext())
+            Insert(reader.template Next<TableItem>());
+    }
+
+    //! Push data into emitter
+    void PushData(bool consume = false) {
+        if (cache_)
+        {
+            // previous PushData() has stored data in cache_
+            cache_->VisitReader(
+                consume, [this](auto& reader) {
+                    while (reader.HasNext())
+                        emitter_.Emit(reader.template Next<TableItem>());
+                });
+        }
+        else if (runs_.size() == 0)
+        {
+            // all items fit into RAM: sort and reduce them in place.
+            if (!sorted_) {
+                SortAndReduce();
+                sorted_ = true;
+            }
+            for (const TableItem& p : items_)
+                emitter_.Emit(p);
+            if (consume)
+                tlx::vector_free(items_);
+        }
+        else
+        {
+            // items were spilled into runs, hence the vector must be emptied
+            // and we have to cache the output stream.
+            if (items_.size())
+                WriteRun();
+            tlx::vector_free(items_);
+
+            size_t merge_degree, prefetch;
+
+            // merge and reduce batches of runs if necessary
+            while (std::tie(merge_degree, prefetch) =
+                       ctx_.block_pool().MaxMergeDegreePrefetch(runs_.size()),
+                   runs_.size() > merge_degree)
+            {
+                PartialMergeReduce(merge_degree, prefetch);
+            }
+
+            cache_ = ctx_.GetFilePtr(dia_id_);
+            data::File::Writer writer = cache_->GetWriter();
+
+            MergeReduce(runs_, prefetch,
+                        [this, &writer](const TableItem& p) {
+                            writer.Put(p);
+                            emitter_.Emit(p);
+                        });
+            runs_.clear();
+        }
+    }
+
+    void Dispose() {
+        tlx::vector_free(items_);
+        runs_.clear();
+        if (cache_) cache_.reset();
+    }
+
+    //! \name Accessors
+    //! \{
+
+    //! Returns the number of items held in RAM.
+    size_t num_items() const { return items_.size(); }
+
+    //! Returns the number of sorted runs written so far.
+    size_t num_runs() const { return num_runs_; }
+
+    //! \}
+
+private:
+    //! extract the key of a table item
+    Key key(const TableItem& t) {
+        return MakeTableItem::GetKey(t, key_extractor_);
+    }
+
+    //! sort the items in RAM by key and reduce adjacent items with equal keys
+    void SortAndReduce() {
+        std::sort(items_.begin(), items_.end(),
+                  [this](const TableItem& a, const TableItem& b) {
+                      return key_compare_function_(key(a), key(b));
+                  });
+
+        if (items_.size() == 0) return;
+
+        size_t out = 0;
+        for (size_t i = 1; i < items_.size(); ++i) {
+            if (key_equal_function_(key(items_[out]), key(items_[i]))) {
+                MakeTableItem::ReduceInto(
+                    items_[out], items_[i], reduce_function_);
+            }
+            else {
+                items_[++out] = items_[i];
+            }
+        }
+        items_.erase(items_.begin() + out + 1, items_.end());
+    }
+
+    //! sort and reduce the items in RAM and write them as a sorted run
+    void WriteRun() {
+        size_t num_inserted = items_.size();
+        SortAndReduce();
+
+        sLOG << "ReduceBySortPostPhase: writing run" << runs_.size()
+             << "with" << items_.size() << "items reduced from"
+             << num_inserted;
+
+        runs_.emplace_back(ctx_.GetFile(dia_id_));
+        data::File::Writer writer = runs_.back().GetWriter();
+        for (const TableItem& p : items_)
+            writer.Put(p);
+        writer.Close();
+
+        items_.clear();
+        ++num_runs_;
+    }
+
+    /*!
+     * Merge the sorted runs in files and pass the merged items to emit(), after
+     * reducing adjacent items with equal keys. The files are consumed.
+     */
+    template <typename Emit>
+    void MergeReduce(std::vector<data::File>& files, size_t prefetch,
+                     const Emit& emit) {
+        if (files.size() == 0) return;
+
+        std::vector<data::File::ConsumeReader> seq;
+        seq.reserve(files.size());
+        for (data::File& file : files)
+            seq.emplace_back(file.GetConsumeReader(/* prefetch */ 0));
+
+        data::StartPrefetch(seq, prefetch);
+
+        auto puller = make_multiway_merge_tree<TableItem>(
+            seq.begin(), seq.end(),
+            [this](const TableItem& a, const TableItem& b) {
+                return key_compare_function_(key(a), key(b));
+            });
+
+        if (!puller.HasNext()) return;
+
+        TableItem current = puller.Next();
+        while (puller.HasNext()) {
+            TableItem next = puller.Next();
+            if (key_equal_function_(key(current), key(next))) {
+                MakeTableItem::ReduceInto(current, next, reduce_function_);
+            }
+            else {
+                emit(current);
+                current = std::move(next);
+            }
+        }
+        emit(current);
+    }
+
+    //! merge and reduce batches of merge_degree runs into longer runs
+    void PartialMergeReduce(size_t merge_degree, size_t prefetch) {
+        sLOG << "ReduceBySortPostPhase: partial merge of" << runs_.size()
+             << "runs with degree" << merge_degree
+             << "and prefetch" << prefetch;
+
+        std::vector<data::File> new_runs;
+
+        size_t fi;
+        for (fi = 0; fi + merge_degree < runs_.size(); fi += merge_degree) {
+            std::vector<data::File> batch;
+            for (size_t t = 0; t < merge_degree; ++t)
+                batch.emplace_back(std::move(runs_[fi + t]));
+
+            new_runs.emplace_back(ctx_.GetFile(dia_id_));
+            data::File::Writer writer = new_runs.back().GetWriter();
+
+            MergeReduce(batch, prefetch,
+                        [&writer](const TableItem& p) { writer.Put(p); });
+            writer.Close();
+        }
+
+        // copy remaining runs into new_runs
+        for ( ; fi < runs_.size(); ++fi)
+            new_runs.emplace_back(std::move(runs_[fi]));
+
+        std::swap(runs_, new_runs);
+    }
+
+    //! Context
+    Context& ctx_;
+
+    //! Associated DIA id
+    size_t dia_id_;
+
+    //! Key extractor function for extracting a key from a value.
+    KeyExtractor key_extractor_;
+
+    //! Reduce function for reducing two values.
+    ReduceFunction reduce_function_;
+
+    //! Emitters used to parameterize hash table for output to next DIA node.
+    PhaseEmitter emitter_;
+
+    //! Comparator function for keys.
+    KeyEqualFunction key_equal_function_;
+
+    //! Order function for keys.
+    KeyCompareFunction key_compare_function_;
+
+    //! vector of unsorted items in RAM
+    std::vector<TableItem> items_;
+
+    //! maximum number of items in RAM before a run is written
+    size_t limit_items_ = 1;
+
+    //! whether items_ were sorted and reduced, if no runs were written
+    bool sorted_ = false;
+
+    //! sorted and reduced runs of items
+    std::vector<data::File> runs_;
+
+    //! number of runs written
+    size_t num_runs_ = 0;
+
+    //! File for storing data in-case runs were written.
+    data::FilePtr cache_;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_BY_SORT_POST_PHASE_HEADER
+
+/******************************************************************************/
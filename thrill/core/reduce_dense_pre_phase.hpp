@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * thrill/core/reduce_dense_pre_phase.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_DENSE_PRE_PHASE_HEADER
+#define THRILL_CORE_REDUCE_DENSE_PRE_PHASE_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_pre_phase.hpp>
+
+#include <tlx/vector_free.hpp>
+
+#include <cassert>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A pre-phase for ReduceToIndex with small index ranges [0,size): instead of a
+ * hash table, items are reduced directly into a dense array of all size
+ * indexes, with a bit vector marking the touched indexes. The index range is
+ * split evenly among the partitions, and FlushAll() sends the touched items of
+ * each partition's slice in index order.
+ *
+ * Only touched items are sent, since the neutral element of ReduceToIndex need
+ * not be an identity of the ReduceFunction.
+ */
+template <typename TableItem, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction,
+          const bool VolatileKey, typename BlockWriter>
+class ReduceDensePrePhase
+{
+    static constexpr bool debug = false;
+
+public:
+    using Emitter = ReducePrePhaseEmitter<TableItem, VolatileKey, BlockWriter>;
+    using MakeTableItem = ReduceMakeTableItem<Value, TableItem, VolatileKey>;
+
+    ReduceDensePrePhase(size_t num_partitions,
+                        KeyExtractor key_extractor,
+                        ReduceFunction reduce_function,
+                        std::vector<BlockWriter>& emit,
+                        size_t size)
+        : emit_(emit),
+          key_extractor_(key_extractor),
+          reduce_function_(reduce_function),
+          num_partitions_(num_partitions),
+          range_(0, size) {
+        assert(num_partitions == emit.size());
+    }
+
+    //! non-copyable: delete copy-constructor
+    ReduceDensePrePhase(const ReduceDensePrePhase&) = delete;
+    //! non-copyable: delete assignment operator
+    ReduceDensePrePhase& operator = (const ReduceDensePrePhase&) = delete;
+
+    //! Bytes allocated by Initialize() for size indexes
+    static size_t MemoryUse(size_t size) {
+        return size * sizeof(TableItem) + (size + 7) / 8;
+    }
+
+    //! Allocate the dense array
+    void Initialize() {
+        items_.resize(range_.size());
+        touched_.resize(range_.size(), false);
+    }
+
+    //! Reduce item into the dense array, returns true if the index is new.
+    bool Insert(const Value& v) {
+        TableItem t = MakeTableItem::Make(v, key_extractor_);
+        Key k = MakeTableItem::GetKey(t, key_extractor_);
+        assert(k < range_.end);
+
+        if (!touched_[k]) {
+            touched_[k] = true;
+            items_[k] = t;
+            ++num_items_;
+            return true;
+        }
+        MakeTableItem::ReduceInto(items_[k], t, reduce_function_);
+        return false;
+    }
+
+    //! Send the touched items of all partitions
+    void FlushAll() {
+        for (size_t id = 0; id < num_partitions_; ++id) {
+            common::Range r = key_range(id);
+            for (size_t k = r.begin; k < r.end; ++k) {
+                if (touched_[k])
+                    emit_.Emit(id, items_[k]);
+            }
+        }
+
+        sLOG << "ReduceDensePrePhase::FlushAll()"
+             << "sent" << num_items_ << "of" << range_.size() << "indexes";
+
+        tlx::vector_free(items_);
+        tlx::vector_free(touched_);
+        num_items_ = 0;
+    }
+
+    //! Closes all emitter
+    void CloseAll() {
+        emit_.CloseAll();
+        tlx::vector_free(items_);
+        tlx::vector_free(touched_);
+    }
+
+    //! \name Accessors
+    //! \{
+
+    //! Returns the number of touched indexes.
+    size_t num_items() const { return num_items_; }
+
+    //! calculate key range for the given output partition
+    common::Range key_range(size_t partition_id) const
+    { return range_.Partition(partition_id, num_partitions_); }
+
+    //! \}
+
+private:
+    //! Emitters for output to network.
+    Emitter emit_;
+
+    //! extractor function which maps a value to it's key
+    KeyExtractor key_extractor_;
+
+    //! reduce function for two values
+    ReduceFunction reduce_function_;
+
+    //! number of output partitions
+    size_t num_partitions_;
+
+    //! index range
+    common::Range range_;
+
+    //! dense array of items, valid only at touched indexes
+    std::vector<TableItem> items_;
+
+    //! indexes at which an item was reduced
+    std::vector<bool> touched_;
+
+    //! number of touched indexes
+    size_t num_items_ = 0;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_DENSE_PRE_PHASE_HEADER
+
+/******************************************************************************/
@@ -17,9 +17,15 @@
 #define THRILL_CORE_REDUCE_FUNCTIONAL_HEADER
 
 #include <thrill/common/defines.hpp>
+#include <thrill/common/functional.hpp>
 #include <thrill/common/hash.hpp>
 #include <thrill/common/math.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
 namespace thrill {
 namespace core {
 
@@ -55,7 +61,25 @@ public:
 
     ReduceByHash(
         const uint64_t& salt, const ReduceByHash& other)
-        : salt_(salt), hash_function_(other.hash_function_) { }
+        : salt_(salt), hash_function_(other.hash_function_),
+          bounds_(other.bounds_) { }
+
+    /*!
+     * Assign the hash values to partitions in proportion to the given prefix
+     * sums of normalized weights, e.g. Context::worker_weight_prefix(), instead
+     * of uniformly. Partition i receives the hash range [prefix[i],
+     * prefix[i+1]) * 2^64. Only used if the number of partitions matches.
+     */
+    void set_partition_weights(const std::vector<double>& prefix) {
+        assert(prefix.size() >= 2);
+        auto bounds = std::make_shared<std::vector<uint64_t> >();
+        for (size_t i = 1; i + 1 < prefix.size(); ++i) {
+            bounds->push_back(static_cast<uint64_t>(
+                                  static_cast<long double>(prefix[i])
+                                  * 18446744073709551616.0L));
+        }
+        bounds_ = std::move(bounds);
+    }
 
     Result operator () (
         const Key& k,
@@ -65,7 +89,15 @@ public:
 
         uint64_t hash = common::Hash128to64(salt_, hash_function_(k));
 
-        size_t partition_id = hash % num_partitions;
+        size_t partition_id;
+        if (bounds_ && bounds_->size() + 1 == num_partitions) {
+            partition_id =
+                std::upper_bound(bounds_->begin(), bounds_->end(), hash)
+                - bounds_->begin();
+        }
+        else {
+            partition_id = hash % num_partitions;
+        }
         size_t remaining_hash = hash / num_partitions;
 
         return Result { partition_id, remaining_hash };
@@ -74,6 +106,10 @@ public:
 private:
     uint64_t salt_;
     HashFunction hash_function_;
+
+    //! upper bounds of the hash ranges of all but the last partition, if the
+    //! partitions are weighted.
+    std::shared_ptr<const std::vector<uint64_t> > bounds_;
 };
 
 /*!
@@ -176,6 +212,12 @@ public:
         return reduce_function(a, b);
     }
 
+    template <typename ReduceFunction>
+    static void ReduceInto(TableItem& a, const TableItem& b,
+                           ReduceFunction& reduce_function) {
+        common::ReduceAssign(reduce_function, a, b);
+    }
+
     template <typename Emitter>
     static void Put(const TableItem& p, Emitter& emit) {
         emit(p);
@@ -202,6 +244,12 @@ public:
         return TableItem(a.first, reduce_function(a.second, b.second));
     }
 
+    template <typename ReduceFunction>
+    static void ReduceInto(TableItem& a, const TableItem& b,
+                           ReduceFunction& reduce_function) {
+        common::ReduceAssign(reduce_function, a.second, b.second);
+    }
+
     template <typename Emitter>
     static void Put(const TableItem& p, Emitter& emit) {
         emit(p.second);
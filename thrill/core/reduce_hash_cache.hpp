@@ -0,0 +1,175 @@
+/*******************************************************************************
+ * thrill/core/reduce_hash_cache.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_HASH_CACHE_HEADER
+#define THRILL_CORE_REDUCE_HASH_CACHE_HEADER
+
+#include <thrill/data/serialization.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A key together with a 32-bit hash of it, which is calculated once in the
+ * ReducePrePhase and then carried along in the reduce tables and the data
+ * streams, such that the post-phase on the receiving worker need not hash the
+ * key again. The hash is also compared before the keys themselves.
+ */
+template <typename Key>
+struct ReduceHashedKey {
+    //! cached hash of the key
+    uint32_t hash;
+    //! the key
+    Key      key;
+
+    //! order by hash first, then by the keys, which keeps equal keys adjacent.
+    bool operator < (const ReduceHashedKey& b) const {
+        if (hash != b.hash) return hash < b.hash;
+        return key < b.key;
+    }
+};
+
+/*!
+ * Selects the key type, key extractor, hash function, and equality function
+ * of the reduce tables, depending on whether hashes are cached. Without
+ * caching, the user functions are passed through.
+ */
+template <bool UseHashCache, typename Key, typename Value,
+          typename KeyExtractor, typename KeyHashFunction,
+          typename KeyEqualFunction>
+class ReduceHashCacheSelect
+{
+public:
+    using TableKey = Key;
+    using TableKeyExtractor = KeyExtractor;
+    using TableKeyHashFunction = KeyHashFunction;
+    using TableKeyEqualFunction = KeyEqualFunction;
+
+    static const KeyExtractor& key_extractor(
+        const KeyExtractor& key_extractor,
+        const KeyHashFunction& /* key_hash_function */) {
+        return key_extractor;
+    }
+
+    static const KeyHashFunction& key_hash_function(
+        const KeyHashFunction& key_hash_function) {
+        return key_hash_function;
+    }
+
+    static const KeyEqualFunction& key_equal_function(
+        const KeyEqualFunction& key_equal_function) {
+        return key_equal_function;
+    }
+};
+
+template <typename Key, typename Value,
+          typename KeyExtractor, typename KeyHashFunction,
+          typename KeyEqualFunction>
+class ReduceHashCacheSelect<
+        true, Key, Value, KeyExtractor, KeyHashFunction, KeyEqualFunction>
+{
+public:
+    using TableKey = ReduceHashedKey<Key>;
+
+    //! extracts the key and hashes it
+    class TableKeyExtractor
+    {
+    public:
+        TableKeyExtractor(const KeyExtractor& key_extractor,
+                          const KeyHashFunction& key_hash_function)
+            : key_extractor_(key_extractor),
+              key_hash_function_(key_hash_function) { }
+
+        TableKey operator () (const Value& v) const {
+            Key k = key_extractor_(v);
+            uint32_t h = static_cast<uint32_t>(key_hash_function_(k));
+            return TableKey { h, std::move(k) };
+        }
+
+    private:
+        KeyExtractor key_extractor_;
+        KeyHashFunction key_hash_function_;
+    };
+
+    //! returns the cached hash
+    class TableKeyHashFunction
+    {
+    public:
+        size_t operator () (const TableKey& k) const { return k.hash; }
+    };
+
+    //! compares the cached hashes, and only if equal the keys
+    class TableKeyEqualFunction
+    {
+    public:
+        explicit TableKeyEqualFunction(
+            const KeyEqualFunction& key_equal_function)
+            : key_equal_function_(key_equal_function) { }
+
+        bool operator () (const TableKey& a, const TableKey& b) const {
+            return a.hash == b.hash && key_equal_function_(a.key, b.key);
+        }
+
+    private:
+        KeyEqualFunction key_equal_function_;
+    };
+
+    static TableKeyExtractor key_extractor(
+        const KeyExtractor& key_extractor,
+        const KeyHashFunction& key_hash_function) {
+        return TableKeyExtractor(key_extractor, key_hash_function);
+    }
+
+    static TableKeyHashFunction key_hash_function(
+        const KeyHashFunction& /* key_hash_function */) {
+        return TableKeyHashFunction();
+    }
+
+    static TableKeyEqualFunction key_equal_function(
+        const KeyEqualFunction& key_equal_function) {
+        return TableKeyEqualFunction(key_equal_function);
+    }
+};
+
+} // namespace core
+
+namespace data {
+
+//! serialization of non-POD hashed keys, POD keys are copied verbatim.
+template <typename Archive, typename Key>
+struct Serialization<Archive, core::ReduceHashedKey<Key>,
+                     typename std::enable_if<
+                         !std::is_pod<core::ReduceHashedKey<Key> >::value
+                         >::type> {
+    static void Serialize(const core::ReduceHashedKey<Key>& x, Archive& ar) {
+        Serialization<Archive, uint32_t>::Serialize(x.hash, ar);
+        Serialization<Archive, Key>::Serialize(x.key, ar);
+    }
+    static core::ReduceHashedKey<Key> Deserialize(Archive& ar) {
+        uint32_t h = Serialization<Archive, uint32_t>::Deserialize(ar);
+        Key k = Serialization<Archive, Key>::Deserialize(ar);
+        return core::ReduceHashedKey<Key>{ h, std::move(k) };
+    }
+    static constexpr bool   is_fixed_size =
+        Serialization<Archive, Key>::is_fixed_size;
+    static constexpr size_t fixed_size =
+        sizeof(uint32_t) + Serialization<Archive, Key>::fixed_size;
+};
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_HASH_CACHE_HEADER
+
+/******************************************************************************/
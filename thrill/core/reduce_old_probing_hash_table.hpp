@@ -169,12 +169,15 @@ public:
          * \return true if a new key was inserted to the table
      */
     bool Insert(const TableItem& kv) {
+        return Insert(kv, calculate_index(kv));
+    }
+
+    //! Inserts a value with its index calculated beforehand.
+    bool Insert(const TableItem& kv, const typename IndexFunction::Result& h) {
 
         while (TLX_UNLIKELY(mem::memory_exceeded && num_items_ != 0))
             SpillAnyPartition();
 
-        typename IndexFunction::Result h = calculate_index(kv);
-
         assert(h.partition_id < num_partitions_);
 
         if (key_equal_function_(key(kv), Key())) {
@@ -187,7 +190,7 @@ public:
                 sentinel_partition_ = h.partition_id;
             }
             else {
-                sentinel = reduce(sentinel, kv);
+                reduce_into(sentinel, kv);
             }
             ++items_per_partition_[h.partition_id];
             ++num_items_;
@@ -211,7 +214,7 @@ public:
         {
             if (key_equal_function_(key(*iter), key(kv)))
             {
-                *iter = reduce(*iter, kv);
+                reduce_into(*iter, kv);
                 return false;
             }
 
@@ -0,0 +1,564 @@
+/*******************************************************************************
+ * thrill/core/reduce_pod_probing_hash_table.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_POD_PROBING_HASH_TABLE_HEADER
+#define THRILL_CORE_REDUCE_POD_PROBING_HASH_TABLE_HEADER
+
+#include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_table.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Trait whether keys of type Key are equal exactly if their bytes are equal.
+ * True for integral and enum types, specialize it for other plain structs
+ * without padding.
+ */
+template <typename Key>
+struct ReducePodKey
+    : public std::integral_constant<
+          bool, std::is_integral<Key>::value || std::is_enum<Key>::value>{ };
+
+/*!
+ * Trait whether ReduceTableImpl::PROBING uses a ReducePodProbingHashTable:
+ * trivially copyable keys of 4, 8, or 16 bytes, which are compared with
+ * std::equal_to and fulfill ReducePodKey.
+ */
+template <typename Key, typename KeyEqualFunction>
+struct ReduceUsePodProbingHashTable
+    : public std::integral_constant<
+          bool,
+          ReducePodKey<Key>::value &&
+          std::is_trivially_copyable<Key>::value &&
+          (sizeof(Key) == 4 || sizeof(Key) == 8 || sizeof(Key) == 16) &&
+          std::is_same<KeyEqualFunction, std::equal_to<Key> >::value>{ };
+
+/*!
+ * A linear probing hash table like ReduceProbingHashTable, which is specialized
+ * for small POD keys (see ReducePodKey) and stores keys and values in separate
+ * arrays (structure of arrays). Probing hence only touches the densely packed
+ * key array and compares keys bitwise, without calling the KeyExtractor on
+ * stored items or the KeyEqualFunction. Empty slots are marked by the sentinel
+ * key Key(), items with the sentinel key are reduced into an extra slot.
+ *
+ * For VolatileKey tables, the value array stores only the Value, otherwise the
+ * whole TableItem with the key duplicated in the key array.
+ */
+template <typename TableItem, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction, typename Emitter,
+          const bool VolatileKey,
+          typename ReduceConfig_,
+          typename IndexFunction,
+          typename KeyEqualFunction = std::equal_to<Key> >
+class ReducePodProbingHashTable
+    : public ReduceTable<TableItem, Key, Value,
+                         KeyExtractor, ReduceFunction, Emitter,
+                         VolatileKey, ReduceConfig_,
+                         IndexFunction, KeyEqualFunction>
+{
+    using Super = ReduceTable<TableItem, Key, Value,
+                              KeyExtractor, ReduceFunction, Emitter,
+                              VolatileKey, ReduceConfig_, IndexFunction,
+                              KeyEqualFunction>;
+    using Super::debug;
+
+    //! type stored in the value array
+    using StoredValue =
+        typename std::conditional<VolatileKey, Value, TableItem>::type;
+
+public:
+    using ReduceConfig = ReduceConfig_;
+
+    ReducePodProbingHashTable(
+        Context& ctx, size_t dia_id,
+        const KeyExtractor& key_extractor,
+        const ReduceFunction& reduce_function,
+        Emitter& emitter,
+        size_t num_partitions,
+        const ReduceConfig& config = ReduceConfig(),
+        bool immediate_flush = false,
+        const IndexFunction& index_function = IndexFunction(),
+        const KeyEqualFunction& key_equal_function = KeyEqualFunction())
+        : Super(ctx, dia_id,
+                key_extractor, reduce_function, emitter,
+                num_partitions, config, immediate_flush,
+                index_function, key_equal_function)
+    { assert(num_partitions > 0); }
+
+    //! Construct the hash table itself. fill the key array with sentinels.
+    //! have one extra value slot beyond the end for reducing the sentinel
+    //! itself.
+    void Initialize(size_t limit_memory_bytes) {
+        assert(!keys_);
+
+        limit_memory_bytes_ = limit_memory_bytes;
+
+        num_buckets_per_partition_ = std::max<size_t>(
+            1,
+            (size_t)(static_cast<double>(limit_memory_bytes_)
+                     / static_cast<double>(sizeof(Key) + sizeof(StoredValue))
+                     / static_cast<double>(num_partitions_)));
+
+        num_buckets_ = num_buckets_per_partition_ * num_partitions_;
+
+        assert(num_buckets_per_partition_ > 0);
+        assert(num_buckets_ > 0);
+
+        partition_size_.resize(
+            num_partitions_,
+            std::min(size_t(config_.initial_items_per_partition_),
+                     num_buckets_per_partition_));
+
+        double limit_fill_rate = config_.limit_partition_fill_rate();
+
+        assert(limit_fill_rate >= 0.0 && limit_fill_rate <= 1.0
+               && "limit_partition_fill_rate must be between 0.0 and 1.0. "
+               "with a fill rate of 0.0, items are immediately flushed.");
+
+        limit_items_per_partition_.resize(
+            num_partitions_,
+            static_cast<size_t>(
+                static_cast<double>(partition_size_[0]) * limit_fill_rate));
+
+        // allocate the arrays, values are only constructed in used slots. the
+        // + 1 value is for the sentinel's slot.
+
+        keys_ = static_cast<Key*>(
+            operator new (num_buckets_ * sizeof(Key)));
+        values_ = static_cast<StoredValue*>(
+            operator new ((num_buckets_ + 1) * sizeof(StoredValue)));
+
+        for (size_t id = 0; id < num_partitions_; ++id) {
+            Key* iter = keys_ + id * num_buckets_per_partition_;
+            std::fill(iter, iter + partition_size_[id], Key());
+        }
+    }
+
+    ~ReducePodProbingHashTable() {
+        if (keys_) Dispose();
+    }
+
+    /*!
+     * Inserts a value into the table, potentially reducing it in case both the
+     * key of the value already in the table and the key of the value to be
+     * inserted are the same.
+     *
+     * \param kv Value to be inserted into the table.
+     *
+     * \return true if a new key was inserted to the table
+     */
+    bool Insert(const TableItem& kv) {
+        return Insert(kv, calculate_index(kv));
+    }
+
+    //! Inserts a value with its index calculated beforehand.
+    bool Insert(const TableItem& kv, const typename IndexFunction::Result& h) {
+
+        assert(h.partition_id < num_partitions_);
+
+        const Key k = key(kv);
+
+        if (TLX_UNLIKELY(IsSentinel(k))) {
+            // handle pairs with sentinel key specially by reducing into last
+            // element of values.
+            StoredValue& sentinel = values_[num_buckets_];
+            if (sentinel_partition_ == invalid_partition_) {
+                // first occurrence of sentinel key
+                new (&sentinel)StoredValue(MakeValue(kv, VolatileTag()));
+                sentinel_partition_ = h.partition_id;
+            }
+            else {
+                ReduceValue(sentinel, kv, VolatileTag());
+                return false;
+            }
+            ++items_per_partition_[h.partition_id];
+            ++num_items_;
+
+            while (TLX_UNLIKELY(
+                       items_per_partition_[h.partition_id] >
+                       limit_items_per_partition_[h.partition_id])) {
+                GrowAndRehash(h.partition_id);
+            }
+
+            return true;
+        }
+
+        // calculate local index depending on the current subtable's size
+        size_t local_index = h.local_index(partition_size_[h.partition_id]);
+
+        size_t offset = h.partition_id * num_buckets_per_partition_;
+        Key* pbegin = keys_ + offset;
+        Key* pend = pbegin + partition_size_[h.partition_id];
+
+        Key* begin_iter = pbegin + local_index;
+        Key* iter = begin_iter;
+
+        while (!IsSentinel(*iter))
+        {
+            if (KeyEqual(*iter, k))
+            {
+                ReduceValue(values_[iter - keys_], kv, VolatileTag());
+                return false;
+            }
+
+            ++iter;
+
+            // wrap around if beyond the current partition
+            if (TLX_UNLIKELY(iter == pend))
+                iter = pbegin;
+
+            // flush partition and retry, if all slots are reserved
+            if (TLX_UNLIKELY(iter == begin_iter)) {
+                GrowAndRehash(h.partition_id);
+                return Insert(kv, h);
+            }
+        }
+
+        // insert new pair
+        *iter = k;
+        new (values_ + (iter - keys_))StoredValue(MakeValue(kv, VolatileTag()));
+
+        // increase counter for partition
+        ++items_per_partition_[h.partition_id];
+        ++num_items_;
+
+        while (TLX_UNLIKELY(
+                   items_per_partition_[h.partition_id] >=
+                   limit_items_per_partition_[h.partition_id])) {
+            LOG << "Grow due to "
+                << items_per_partition_[h.partition_id] << " >= "
+                << limit_items_per_partition_[h.partition_id]
+                << " among " << partition_size_[h.partition_id];
+            GrowAndRehash(h.partition_id);
+        }
+
+        return true;
+    }
+
+    //! Prefetches the first key and value probed by Insert(kv, h).
+    void Prefetch(const typename IndexFunction::Result& h) const {
+        size_t index = h.partition_id * num_buckets_per_partition_ +
+                       h.local_index(partition_size_[h.partition_id]);
+        common::PrefetchWrite(keys_ + index);
+        common::PrefetchWrite(values_ + index);
+    }
+
+    //! Deallocate items and memory
+    void Dispose() {
+        if (!keys_) return;
+
+        // dispose the values by destructor
+
+        for (size_t id = 0; id < num_partitions_; ++id) {
+            size_t begin = id * num_buckets_per_partition_;
+            size_t end = begin + partition_size_[id];
+
+            for (size_t i = begin; i != end; ++i) {
+                if (!IsSentinel(keys_[i]))
+                    values_[i].~StoredValue();
+            }
+        }
+
+        if (sentinel_partition_ != invalid_partition_) {
+            values_[num_buckets_].~StoredValue();
+            sentinel_partition_ = invalid_partition_;
+        }
+
+        operator delete (keys_);
+        operator delete (values_);
+        keys_ = nullptr;
+        values_ = nullptr;
+
+        Super::Dispose();
+    }
+
+    void GrowAndRehash(size_t partition_id) {
+
+        size_t old_size = partition_size_[partition_id];
+        GrowPartition(partition_id);
+        if (partition_size_[partition_id] == old_size) {
+            SpillPartition(partition_id);
+            return;
+        }
+
+        if (partition_size_[partition_id] % old_size != 0) {
+            // in place rehashing won't work properly so we spill rather than
+            // potentially blasting memory limits by using an extra vector for
+            // temporary item storage
+            SpillPartition(partition_id);
+            return;
+        }
+
+        // initialize indexes of old range - the second half is still empty
+        size_t begin = partition_id * num_buckets_per_partition_;
+        size_t i = begin;
+        size_t end = begin + old_size;
+
+        bool passed_first_half = false;
+        bool found_hole = false;
+        while (!passed_first_half || !found_hole) {
+            bool is_empty = IsSentinel(keys_[i]);
+            if (!is_empty) {
+                --items_per_partition_[partition_id];
+                --num_items_;
+                TableItem item = MakeItem(i, VolatileTag());
+                keys_[i] = Key();
+                values_[i].~StoredValue();
+                Insert(item);
+            }
+
+            i++;
+            found_hole = passed_first_half && is_empty;
+            passed_first_half = passed_first_half || i == end;
+        }
+    }
+
+    //! Grow a partition after a spill or flush (if possible)
+    void GrowPartition(size_t partition_id) {
+
+        if (TLX_UNLIKELY(mem::memory_exceeded)) {
+            SpillPartition(partition_id);
+            return;
+        }
+
+        if (partition_size_[partition_id] == num_buckets_per_partition_)
+            return;
+
+        size_t new_size = std::min(
+            num_buckets_per_partition_, 2 * partition_size_[partition_id]);
+
+        sLOG << "Growing partition" << partition_id
+             << "from" << partition_size_[partition_id] << "to" << new_size
+             << "limit_items" << new_size * config_.limit_partition_fill_rate();
+
+        // initialize new keys
+
+        Key* pbegin = keys_ + partition_id * num_buckets_per_partition_;
+        std::fill(pbegin + partition_size_[partition_id], pbegin + new_size,
+                  Key());
+
+        partition_size_[partition_id] = new_size;
+        limit_items_per_partition_[partition_id]
+            = new_size * config_.limit_partition_fill_rate();
+    }
+
+    //! \name Spilling Mechanisms to External Memory Files
+    //! \{
+
+    //! Spill all items of a partition into an external memory File.
+    void SpillPartition(size_t partition_id) {
+
+        if (immediate_flush_) {
+            return FlushPartition(
+                partition_id, /* consume */ true, /* grow */ !mem::memory_exceeded);
+        }
+
+        LOG << "Spilling " << items_per_partition_[partition_id]
+            << " items of partition with id: " << partition_id;
+
+        if (items_per_partition_[partition_id] == 0)
+            return;
+
+        data::File::Writer writer = partition_files_[partition_id].GetWriter();
+
+        FlushPartitionEmit(
+            partition_id, /* consume */ true, /* grow */ false,
+            [&writer](const size_t&, const TableItem& p) { writer.Put(p); });
+
+        LOG << "Spilled items of partition with id: " << partition_id;
+    }
+
+    //! Spill all items of an arbitrary partition into an external memory File.
+    void SpillAnyPartition() {
+        // maybe make a policy later -tb
+        return SpillLargestPartition();
+    }
+
+    //! Spill all items of the largest partition into an external memory File.
+    void SpillLargestPartition() {
+        // get partition with max size
+        size_t size_max = 0, index = 0;
+
+        for (size_t i = 0; i < num_partitions_; ++i)
+        {
+            if (items_per_partition_[i] > size_max)
+            {
+                size_max = items_per_partition_[i];
+                index = i;
+            }
+        }
+
+        if (size_max == 0) {
+            return;
+        }
+
+        return SpillPartition(index);
+    }
+
+    //! \}
+
+    //! \name Flushing Mechanisms to Next Stage or Phase
+    //! \{
+
+    template <typename Emit>
+    void FlushPartitionEmit(
+        size_t partition_id, bool consume, bool grow, Emit emit) {
+
+        LOG << "Flushing " << items_per_partition_[partition_id]
+            << " items of partition: " << partition_id;
+
+        if (sentinel_partition_ == partition_id) {
+            emit(partition_id, MakeSentinelItem(VolatileTag()));
+            if (consume) {
+                values_[num_buckets_].~StoredValue();
+                sentinel_partition_ = invalid_partition_;
+            }
+        }
+
+        size_t begin = partition_id * num_buckets_per_partition_;
+        size_t end = begin + partition_size_[partition_id];
+
+        for (size_t i = begin; i != end; ++i)
+        {
+            if (!IsSentinel(keys_[i])) {
+                emit(partition_id, MakeItem(i, VolatileTag()));
+
+                if (consume) {
+                    keys_[i] = Key();
+                    values_[i].~StoredValue();
+                }
+            }
+        }
+
+        if (consume) {
+            // reset partition specific counter
+            num_items_ -= items_per_partition_[partition_id];
+            items_per_partition_[partition_id] = 0;
+            assert(num_items_ == this->num_items_calc());
+        }
+
+        LOG << "Done flushed items of partition: " << partition_id;
+
+        if (grow)
+            GrowPartition(partition_id);
+    }
+
+    void FlushPartition(size_t partition_id, bool consume, bool grow) {
+        FlushPartitionEmit(
+            partition_id, consume, grow,
+            [this](const size_t& partition_id, const TableItem& p) {
+                this->emitter_.Emit(partition_id, p);
+            });
+    }
+
+    void FlushAll() {
+        for (size_t i = 0; i < num_partitions_; ++i) {
+            FlushPartition(i, /* consume */ true, /* grow */ false);
+        }
+    }
+
+    //! \}
+
+public:
+    using Super::calculate_index;
+
+private:
+    using Super::config_;
+    using Super::immediate_flush_;
+    using Super::index_function_;
+    using Super::items_per_partition_;
+    using Super::key;
+    using Super::limit_memory_bytes_;
+    using Super::num_buckets_;
+    using Super::num_buckets_per_partition_;
+    using Super::num_items_;
+    using Super::num_partitions_;
+    using Super::partition_files_;
+    using Super::reduce_function_;
+
+    using VolatileTag = std::integral_constant<bool, VolatileKey>;
+
+    //! \name Switches for VolatileKey
+    //! \{
+
+    static bool KeyEqual(const Key& a, const Key& b) {
+        return std::memcmp(&a, &b, sizeof(Key)) == 0;
+    }
+
+    static bool IsSentinel(const Key& k) {
+        return KeyEqual(k, Key());
+    }
+
+    static const Value& MakeValue(const TableItem& kv, std::true_type) {
+        return kv.second;
+    }
+    static const TableItem& MakeValue(const TableItem& kv, std::false_type) {
+        return kv;
+    }
+
+    void ReduceValue(StoredValue& v, const TableItem& kv, std::true_type) {
+        common::ReduceAssign(reduce_function_, v, kv.second);
+    }
+    void ReduceValue(StoredValue& v, const TableItem& kv, std::false_type) {
+        common::ReduceAssign(reduce_function_, v, kv);
+    }
+
+    TableItem MakeItem(size_t i, std::true_type) const {
+        return TableItem(keys_[i], values_[i]);
+    }
+    TableItem MakeItem(size_t i, std::false_type) const {
+        return values_[i];
+    }
+
+    TableItem MakeSentinelItem(std::true_type) const {
+        return TableItem(Key(), values_[num_buckets_]);
+    }
+    TableItem MakeSentinelItem(std::false_type) const {
+        return values_[num_buckets_];
+    }
+
+    //! \}
+
+    //! Storing the keys, Key() marks empty slots.
+    Key* keys_ = nullptr;
+
+    //! Storing the values, constructed only in slots with non-empty keys.
+    StoredValue* values_ = nullptr;
+
+    //! Current sizes of the partitions because the valid allocated areas grow
+    std::vector<size_t> partition_size_;
+
+    //! Current limits on the number of items in a partitions, different for
+    //! different partitions, because the valid allocated areas grow.
+    std::vector<size_t> limit_items_per_partition_;
+
+    //! sentinel for invalid partition or no sentinel.
+    static constexpr size_t invalid_partition_ = size_t(-1);
+
+    //! store the partition id of the sentinel key. implicitly this also stored
+    //! whether the sentinel key was found and reduced into
+    //! values_[num_buckets_].
+    size_t sentinel_partition_ = invalid_partition_;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_POD_PROBING_HASH_TABLE_HEADER
+
+/******************************************************************************/
@@ -20,10 +20,12 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/common/math.hpp>
 #include <thrill/core/duplicate_detection.hpp>
+#include <thrill/core/hyperloglog.hpp>
 #include <thrill/core/reduce_bucket_hash_table.hpp>
 #include <thrill/core/reduce_functional.hpp>
 #include <thrill/core/reduce_old_probing_hash_table.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_swiss_hash_table.hpp>
 #include <thrill/data/block_reader.hpp>
 #include <thrill/data/block_writer.hpp>
 #include <thrill/data/file.hpp>
@@ -122,10 +124,44 @@ public:
         KeyExtractor, ReduceFunction, Emitter,
         VolatileKey, ReduceConfig, IndexFunction, KeyEqualFunction>::type;
 
+    //! whether to sample the first items and maybe switch to pass-through
+    static constexpr bool use_auto_ =
+        ReduceConfig::table_impl_ == ReduceTableImpl::AUTO;
+
+    //! whether to bypass the table for partitions with low hit rate
+    static constexpr bool use_adaptive_bypass_ =
+        ReduceConfig::use_adaptive_bypass_;
+
+    //! whether items can be inserted in batches with prefetched slots
+    static constexpr bool allow_batch_insert_ =
+        !use_auto_ && !use_adaptive_bypass_;
+
+    //! number of items in a batch
+    static constexpr size_t batch_size_ = ReduceConfig::batch_insert_size_;
+
     /*!
      * A data structure which takes an arbitrary value and extracts a key using
      * a key extractor function from that value. Afterwards, the value is hashed
      * based on the key into some slot.
+     *
+     * With ReduceTableImpl::AUTO, the number of distinct keys among the first
+     * auto_sample_size_ items is estimated using a HyperLogLog sketch. If the
+     * ratio of distinct keys is at least auto_pass_through_ratio_, hardly any
+     * items combine, hence the table is flushed and released, and all further
+     * items are emitted directly to their partition's writer.
+     *
+     * With use_adaptive_bypass_, the fraction of inserted items which are
+     * reduced into an existing item is monitored for each partition. After
+     * bypass_window_ items, if the hit rate is below bypass_hit_rate_, the
+     * partition is flushed and further items bypass the table: they only pass
+     * through a small direct-mapped combine cache of bypass_cache_size_ items,
+     * which catches hot keys, and evicted items are emitted.
+     *
+     * With ReduceConfig::use_batch_insert_ or set_batch_insert(), items are
+     * collected in batches of batch_size_. The indexes of a batch are
+     * calculated together, the table slots are prefetched, and then the items
+     * are inserted, such that the cache misses of a batch overlap. Insert()
+     * then returns true for all items.
      */
     ReducePrePhase(Context& ctx, size_t dia_id,
                    size_t num_partitions,
@@ -139,12 +175,23 @@ public:
                    bool duplicates = false)
         : emit_(emit),
           key_extractor_(key_extractor),
+          hash_function_(hash_function),
           table_(ctx, dia_id,
                  key_extractor, reduce_function, emit_,
                  num_partitions, config, !duplicates,
-                 index_function, key_equal_function) {
-
-        tlx::unused(hash_function);
+                 index_function, key_equal_function),
+          auto_sample_size_(config.auto_sample_size()),
+          auto_pass_through_ratio_(config.auto_pass_through_ratio()),
+          bypass_window_(config.bypass_window()),
+          bypass_hit_rate_(config.bypass_hit_rate()) {
+
+        if (use_adaptive_bypass_) {
+            bypass_inserts_.resize(num_partitions, 0);
+            bypass_hits_.resize(num_partitions, 0);
+            bypassed_.resize(num_partitions, 0);
+            bypass_cache_.resize(
+                std::max<size_t>(1, config.bypass_cache_size()));
+        }
 
         sLOG << "creating ReducePrePhase with" << emit.size() << "output emitters";
 
@@ -166,7 +213,28 @@ public:
 
     bool Insert(const Value& v) {
         // for VolatileKey this makes std::pair and extracts the key
-        return table_.Insert(MakeTableItem::Make(v, table_.key_extractor()));
+        TableItem t = MakeTableItem::Make(v, table_.key_extractor());
+
+        if (use_auto_) {
+            if (TLX_UNLIKELY(auto_sampled_ < auto_sample_size_))
+                SampleKey(table_.key(t));
+            if (pass_through_) {
+                emit_.Emit(table_.calculate_index(t).partition_id, t);
+                return true;
+            }
+        }
+
+        if (use_adaptive_bypass_)
+            return InsertAdaptive(t);
+
+        if (allow_batch_insert_ && batch_insert_) {
+            batch_[batch_items_] = t;
+            if (++batch_items_ == batch_size_)
+                InsertBatch();
+            return true;
+        }
+
+        return table_.Insert(t);
     }
 
     void InsertSkip(const Value& v) {
@@ -177,19 +245,31 @@ public:
 
     //! Flush all partitions
     void FlushAll() {
-        for (size_t id = 0; id < table_.num_partitions(); ++id) {
-            FlushPartition(id, /* consume */ true, /* grow */ false);
+        // in pass-through mode the table was already flushed and released
+        if (pass_through_) return;
+        InsertBatch();
+        // worker i flushes partition i + r in step r, such that the workers
+        // do not all send to the same worker at once.
+        size_t num_partitions = table_.num_partitions();
+        size_t first = table_.ctx().my_rank();
+        for (size_t r = 0; r < num_partitions; ++r) {
+            FlushPartition((first + r) % num_partitions,
+                           /* consume */ true, /* grow */ false);
         }
     }
 
     //! Flushes a partition
     void FlushPartition(size_t partition_id, bool consume, bool grow) {
+        if (use_adaptive_bypass_ && consume)
+            FlushBypassCache(partition_id);
+        InsertBatch();
         table_.FlushPartition(partition_id, consume, grow);
         // data is flushed immediately, there is no spilled data
     }
 
     //! Closes all emitter
     void CloseAll() {
+        InsertBatch();
         emit_.CloseAll();
         table_.Dispose();
     }
@@ -200,10 +280,30 @@ public:
     //! Returns the total num of items in the table.
     size_t num_items() const { return table_.num_items(); }
 
+    //! Returns the first-level table, e.g. for its functions
+    const Table& table() const { return table_; }
+
     //! calculate key range for the given output partition
     common::Range key_range(size_t partition_id)
     { return table_.key_range(partition_id); }
 
+    //! Insert items in batches, if the ReduceConfig allows it. Must be called
+    //! before the first Insert().
+    void set_batch_insert(bool batch_insert) {
+        batch_insert_ = allow_batch_insert_ && batch_insert;
+    }
+
+    //! Returns whether items are inserted in batches
+    bool batch_insert() const { return batch_insert_; }
+
+    //! Returns whether AUTO switched to pass-through mode
+    bool pass_through() const { return pass_through_; }
+
+    //! Returns whether the table is bypassed for a partition
+    bool bypassed(size_t partition_id) const {
+        return use_adaptive_bypass_ && bypassed_[partition_id];
+    }
+
     //! \}
 
 protected:
@@ -213,8 +313,164 @@ protected:
     //! extractor function which maps a value to it's key
     KeyExtractor key_extractor_;
 
+    //! hash function for keys
+    HashFunction hash_function_;
+
     //! the first-level hash table implementation
     Table table_;
+
+    //! \name Automatic Pass-Through Selection
+    //! \{
+
+    //! number of items to sample
+    size_t auto_sample_size_;
+
+    //! distinct ratio threshold for pass-through
+    double auto_pass_through_ratio_;
+
+    //! number of items sampled so far
+    size_t auto_sampled_ = 0;
+
+    //! sketch of the sampled keys
+    HyperLogLogRegisters<7> auto_hll_;
+
+    //! whether items are emitted without combining
+    bool pass_through_ = false;
+
+    //! Add a key to the sample, and decide on pass-through after the last.
+    void SampleKey(const Key& key) {
+        // std::hash is often the identity, hence mix the bits for HyperLogLog
+        auto_hll_.insert_hash(
+            common::Hash128to64(0x9E3779B97F4A7C15ull, hash_function_(key)));
+
+        if (++auto_sampled_ != auto_sample_size_) return;
+
+        double ratio = auto_hll_.result() / static_cast<double>(auto_sampled_);
+
+        sLOG << "ReducePrePhase AUTO: estimated distinct ratio" << ratio
+             << "of" << auto_sampled_ << "items";
+
+        if (ratio < auto_pass_through_ratio_) return;
+
+        for (size_t id = 0; id < table_.num_partitions(); ++id)
+            FlushPartition(id, /* consume */ true, /* grow */ false);
+        table_.Dispose();
+        pass_through_ = true;
+    }
+
+    //! \}
+
+    //! \name Batched Insertion
+    //! \{
+
+    //! whether items are inserted in batches
+    bool batch_insert_ =
+        allow_batch_insert_ && ReduceConfig::use_batch_insert_;
+
+    //! items of the current batch
+    TableItem batch_[allow_batch_insert_ ? batch_size_ : 1];
+
+    //! number of items in the current batch
+    size_t batch_items_ = 0;
+
+    //! Insert the items of the current batch with ReduceTableInsertBatch().
+    void InsertBatch() {
+        if (!allow_batch_insert_ || batch_items_ == 0) return;
+
+        ReduceTableInsertBatch(table_, batch_, batch_items_);
+        batch_items_ = 0;
+    }
+
+    //! \}
+
+    //! \name Adaptive Bypass of the Table
+    //! \{
+
+    //! marks an empty slot of the combine cache
+    static constexpr size_t invalid_partition_ = size_t(-1);
+
+    //! slot of the combine cache
+    struct BypassSlot {
+        //! partition of the item, or invalid_partition_ if empty
+        size_t partition_id = invalid_partition_;
+        TableItem item;
+    };
+
+    //! number of items in the evaluation window
+    size_t bypass_window_;
+
+    //! hit rate threshold for bypassing
+    double bypass_hit_rate_;
+
+    //! items inserted into each partition during its evaluation window
+    std::vector<size_t> bypass_inserts_;
+
+    //! items reduced in each partition during its evaluation window
+    std::vector<size_t> bypass_hits_;
+
+    //! whether the table is bypassed for each partition
+    std::vector<uint8_t> bypassed_;
+
+    //! direct-mapped combine cache in front of bypassed partitions
+    std::vector<BypassSlot> bypass_cache_;
+
+    //! Insert with hit rate monitoring or through the combine cache.
+    bool InsertAdaptive(const TableItem& t) {
+        typename IndexFunction::Result h = table_.calculate_index(t);
+        size_t partition_id = h.partition_id;
+
+        if (!bypassed_[partition_id]) {
+            bool inserted = table_.Insert(t);
+            if (bypass_inserts_[partition_id] >= bypass_window_)
+                return inserted;
+
+            bypass_hits_[partition_id] += !inserted;
+            if (++bypass_inserts_[partition_id] != bypass_window_)
+                return inserted;
+
+            double hit_rate =
+                static_cast<double>(bypass_hits_[partition_id])
+                / static_cast<double>(bypass_window_);
+
+            sLOG << "ReducePrePhase partition" << partition_id
+                 << "hit rate" << hit_rate;
+
+            if (hit_rate < bypass_hit_rate_) {
+                bypassed_[partition_id] = 1;
+                table_.FlushPartition(
+                    partition_id, /* consume */ true, /* grow */ false);
+            }
+            return inserted;
+        }
+
+        BypassSlot& slot =
+            bypass_cache_[h.local_index(bypass_cache_.size())];
+
+        if (slot.partition_id == partition_id &&
+            table_.key_equal_function()(table_.key(slot.item), table_.key(t))) {
+            table_.reduce_into(slot.item, t);
+            return false;
+        }
+
+        if (slot.partition_id != invalid_partition_)
+            emit_.Emit(slot.partition_id, slot.item);
+
+        slot.partition_id = partition_id;
+        slot.item = t;
+        return true;
+    }
+
+    //! Emit all items of a partition held in the combine cache.
+    void FlushBypassCache(size_t partition_id) {
+        for (BypassSlot& slot : bypass_cache_) {
+            if (slot.partition_id != partition_id) continue;
+            emit_.Emit(partition_id, slot.item);
+            slot.partition_id = invalid_partition_;
+            slot.item = TableItem();
+        }
+    }
+
+    //! \}
 };
 
 template <typename TableItem, typename Key, typename Value,
@@ -265,8 +521,7 @@ public:
                    const HashFunction hash_function = HashFunction())
         : Super(ctx, dia_id, num_partitions, key_extractor, reduce_function,
                 emit, config, index_function, equal_to_function, hash_function,
-                /*duplicates*/ true),
-          hash_function_(hash_function) { }
+                /*duplicates*/ true) { }
 
     void Insert(const Value& v) {
         if (Super::table_.Insert(
@@ -283,8 +538,12 @@ public:
                                                  Super::table_.ctx(),
                                                  Super::table_.dia_id());
 
-        for (size_t id = 0; id < Super::table_.num_partitions(); ++id) {
-            FlushPartition(id, /* consume */ true, /* grow */ false);
+        // rotated flush order, see ReducePrePhase::FlushAll()
+        size_t num_partitions = Super::table_.num_partitions();
+        size_t first = Super::table_.ctx().my_rank();
+        for (size_t r = 0; r < num_partitions; ++r) {
+            FlushPartition((first + r) % num_partitions,
+                           /* consume */ true, /* grow */ false);
         }
     }
 
@@ -332,7 +591,7 @@ public:
     //! \name Duplicate Detection
     //! \{
 
-    HashFunction hash_function_;
+    using Super::hash_function_;
     //! Hashes of all keys.
     std::vector<size_t> hashes_;
     //! All elements occuring on more than one worker. (Elements not appearing here
@@ -15,11 +15,13 @@
 #define THRILL_CORE_REDUCE_PROBING_HASH_TABLE_HEADER
 
 #include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_pod_probing_hash_table.hpp>
 #include <thrill/core/reduce_table.hpp>
 
 #include <algorithm>
 #include <functional>
 #include <limits>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -120,9 +122,14 @@ public:
                "limit_memory_bytes must be greater than or equal to 0. "
                "A byte size of zero results in exactly one item per partition");
 
+        // with variable-size items, part of the memory is reserved for their
+        // heap memory.
+        const size_t table_memory_bytes =
+            Super::SplitHeapMemoryLimit(limit_memory_bytes_);
+
         num_buckets_per_partition_ = std::max<size_t>(
             1,
-            (size_t)(static_cast<double>(limit_memory_bytes_)
+            (size_t)(static_cast<double>(table_memory_bytes)
                      / static_cast<double>(sizeof(TableItem))
                      / static_cast<double>(num_partitions_)));
 
@@ -188,8 +195,12 @@ public:
      * \return true if a new key was inserted to the table
      */
     bool Insert(const TableItem& kv) {
+        return Insert(kv, calculate_index(kv));
+    }
+
+    //! Inserts a value with its index calculated beforehand.
+    bool Insert(const TableItem& kv, const typename IndexFunction::Result& h) {
 
-        typename IndexFunction::Result h = calculate_index(kv);
         assert(h.partition_id < num_partitions_);
 
         if (TLX_UNLIKELY(key_equal_function_(key(kv), Key()))) {
@@ -200,14 +211,20 @@ public:
                 // first occurrence of sentinel key
                 new (&sentinel)TableItem(kv);
                 sentinel_partition_ = h.partition_id;
+                Super::HeapAdd(h.partition_id, sentinel);
             }
             else {
-                sentinel = reduce(sentinel, kv);
+                size_t old_heap = Super::heap_size(sentinel);
+                reduce_into(sentinel, kv);
+                Super::HeapUpdate(h.partition_id, old_heap, sentinel);
+                SpillHeapExceeded();
                 return false;
             }
             ++items_per_partition_[h.partition_id];
             ++num_items_;
 
+            SpillHeapExceeded();
+
             while (TLX_UNLIKELY(
                        items_per_partition_[h.partition_id] >
                        limit_items_per_partition_[h.partition_id])) {
@@ -230,7 +247,10 @@ public:
         {
             if (key_equal_function_(key(*iter), key(kv)))
             {
-                *iter = reduce(*iter, kv);
+                size_t old_heap = Super::heap_size(*iter);
+                reduce_into(*iter, kv);
+                Super::HeapUpdate(h.partition_id, old_heap, *iter);
+                SpillHeapExceeded();
                 return false;
             }
 
@@ -243,7 +263,7 @@ public:
             // flush partition and retry, if all slots are reserved
             if (TLX_UNLIKELY(iter == begin_iter)) {
                 GrowAndRehash(h.partition_id);
-                return Insert(kv);
+                return Insert(kv, h);
             }
         }
 
@@ -253,6 +273,10 @@ public:
         // increase counter for partition
         ++items_per_partition_[h.partition_id];
         ++num_items_;
+        Super::HeapAdd(h.partition_id, *iter);
+
+        // spill before growing, since rehashing must not spill
+        SpillHeapExceeded();
 
         while (TLX_UNLIKELY(
                    items_per_partition_[h.partition_id] >=
@@ -267,6 +291,13 @@ public:
         return true;
     }
 
+    //! Prefetches the first slot probed by Insert(kv, h).
+    void Prefetch(const typename IndexFunction::Result& h) const {
+        common::PrefetchWrite(
+            items_ + h.partition_id * num_buckets_per_partition_ +
+            h.local_index(partition_size_[h.partition_id]));
+    }
+
     //! Deallocate items and memory
     void Dispose() {
         if (!items_) return;
@@ -321,6 +352,7 @@ public:
             if (!is_empty) {
                 --items_per_partition_[partition_id];
                 --num_items_;
+                Super::HeapRemove(partition_id, *iter);
                 TableItem item = std::move(*iter);
                 new (iter)TableItem();
                 Insert(item);
@@ -403,11 +435,23 @@ public:
         // reset partition specific counter
         num_items_ -= items_per_partition_[partition_id];
         items_per_partition_[partition_id] = 0;
+        Super::HeapClear(partition_id);
         assert(num_items_ == this->num_items_calc());
 
         LOG << "Spilled items of partition with id: " << partition_id;
     }
 
+    //! Spill the partitions with most heap memory while the heap memory of
+    //! variable-size items exceeds its limit.
+    void SpillHeapExceeded() {
+        while (TLX_UNLIKELY(Super::heap_exceeded())) {
+            size_t partition_id = Super::LargestHeapPartition();
+            LOG << "Spilling partition " << partition_id
+                << " due to heap memory " << Super::heap_bytes();
+            SpillPartition(partition_id);
+        }
+    }
+
     //! Spill all items of an arbitrary partition into an external memory File.
     void SpillAnyPartition() {
         // maybe make a policy later -tb
@@ -472,6 +516,7 @@ public:
             // reset partition specific counter
             num_items_ -= items_per_partition_[partition_id];
             items_per_partition_[partition_id] = 0;
+            Super::HeapClear(partition_id);
             assert(num_items_ == this->num_items_calc());
         }
 
@@ -544,6 +589,31 @@ class ReduceTableSelect<
         TableItem, Key, Value, KeyExtractor, ReduceFunction,
         Emitter, VolatileKey, ReduceConfig, IndexFunction, KeyEqualFunction>
 {
+public:
+    //! small POD keys use the specialized structure of arrays table
+    using type = typename std::conditional<
+        ReduceUsePodProbingHashTable<Key, KeyEqualFunction>::value,
+        ReducePodProbingHashTable<
+            TableItem, Key, Value, KeyExtractor, ReduceFunction,
+            Emitter, VolatileKey, ReduceConfig,
+            IndexFunction, KeyEqualFunction>,
+        ReduceProbingHashTable<
+            TableItem, Key, Value, KeyExtractor, ReduceFunction,
+            Emitter, VolatileKey, ReduceConfig,
+            IndexFunction, KeyEqualFunction> >::type;
+};
+
+//! AUTO uses the probing table for combining, see ReducePrePhase
+template <typename TableItem, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction,
+          typename Emitter, const bool VolatileKey,
+          typename ReduceConfig, typename IndexFunction,
+          typename KeyEqualFunction>
+class ReduceTableSelect<
+        ReduceTableImpl::AUTO,
+        TableItem, Key, Value, KeyExtractor, ReduceFunction,
+        Emitter, VolatileKey, ReduceConfig, IndexFunction, KeyEqualFunction>
+{
 public:
     using type = ReduceProbingHashTable<
         TableItem, Key, Value, KeyExtractor, ReduceFunction,
@@ -0,0 +1,217 @@
+/*******************************************************************************
+ * thrill/core/reduce_shared_pre_table.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_SHARED_PRE_TABLE_HEADER
+#define THRILL_CORE_REDUCE_SHARED_PRE_TABLE_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/core/reduce_functional.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A fixed size linear probing reduce table shared by all workers of a host in
+ * the ReducePrePhase of ReduceByKey, enabled by
+ * ReduceConfig::use_shared_pre_phase_. Items of keys which occur on several
+ * workers of the host are hence combined before they are sent over the
+ * network.
+ *
+ * Slots are claimed and updated concurrently by the workers' threads using a
+ * spin lock in each slot, such that only inserts of equal keys contend. Slots
+ * are never freed while inserting, hence a key is found at the same probe
+ * position by all threads. The table does not grow and is not flushed while
+ * inserting: once the fill limit is reached, Insert() returns false for new
+ * keys, and the worker passes the item to its private ReducePrePhase. Items
+ * of hot keys usually claim their slots early.
+ *
+ * After all workers stopped inserting, each worker sends a slice of the
+ * table to the destination workers using its own BlockWriters.
+ */
+template <typename TableItem, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction,
+          const bool VolatileKey, typename IndexFunction,
+          typename KeyEqualFunction>
+class ReduceSharedPreTable
+{
+    static constexpr bool debug = false;
+
+public:
+    using MakeTableItem = ReduceMakeTableItem<Value, TableItem, VolatileKey>;
+
+    /*!
+     * Construct table with num_partitions outputs, shared by num_workers
+     * workers, using limit_memory_bytes in total.
+     */
+    ReduceSharedPreTable(size_t num_partitions, size_t num_workers,
+                         size_t limit_memory_bytes,
+                         double limit_fill_rate,
+                         const KeyExtractor& key_extractor,
+                         const ReduceFunction& reduce_function,
+                         const IndexFunction& index_function,
+                         const KeyEqualFunction& key_equal_function)
+        : num_partitions_(num_partitions),
+          num_workers_(num_workers),
+          key_extractor_(key_extractor),
+          reduce_function_(reduce_function),
+          index_function_(index_function),
+          key_equal_function_(key_equal_function) {
+
+        num_slots_ = std::max<size_t>(
+            num_workers, limit_memory_bytes / sizeof(Slot));
+        limit_items_ = static_cast<size_t>(
+            static_cast<double>(num_slots_) * limit_fill_rate);
+        slots_.reset(new Slot[num_slots_]);
+
+        sLOG << "ReduceSharedPreTable: num_slots_" << num_slots_
+             << "limit_items_" << limit_items_;
+    }
+
+    //! non-copyable: delete copy-constructor
+    ReduceSharedPreTable(const ReduceSharedPreTable&) = delete;
+    //! non-copyable: delete assignment operator
+    ReduceSharedPreTable& operator = (const ReduceSharedPreTable&) = delete;
+
+    /*!
+     * Reduce an item into the table, called concurrently by the workers.
+     * Returns false if the key was not found and the table is full.
+     */
+    bool Insert(const Value& v) {
+        // for VolatileKey this makes std::pair and extracts the key
+        TableItem kv = MakeTableItem::Make(v, key_extractor_);
+        Key k = key(kv);
+        typename IndexFunction::Result h =
+            index_function_(k, num_partitions_, 0, 0);
+
+        for (size_t i = h.local_index(num_slots_), probes = 0;
+             probes < num_slots_; ++probes)
+        {
+            Slot& s = slots_[i];
+            s.Lock();
+
+            if (!s.used) {
+                if (num_items_.load(std::memory_order_relaxed)
+                    >= limit_items_) {
+                    s.Unlock();
+                    return false;
+                }
+                ++num_items_;
+                s.item = kv;
+                s.used = true;
+                s.Unlock();
+                return true;
+            }
+
+            if (key_equal_function_(key(s.item), k)) {
+                MakeTableItem::ReduceInto(s.item, kv, reduce_function_);
+                s.Unlock();
+                return true;
+            }
+
+            s.Unlock();
+            if (++i == num_slots_) i = 0;
+        }
+
+        return false;
+    }
+
+    /*!
+     * Send the items in slice worker of the table to their partitions via
+     * emit. Must only be called after all workers finished inserting.
+     */
+    template <typename BlockWriter>
+    void FlushSlice(size_t worker, std::vector<BlockWriter>& emit) {
+        common::Range r =
+            common::CalculateLocalRange(num_slots_, num_workers_, worker);
+
+        size_t num_flushed = 0;
+        for (size_t i = r.begin; i < r.end; ++i) {
+            Slot& s = slots_[i];
+            if (!s.used) continue;
+
+            size_t partition_id =
+                index_function_(key(s.item), num_partitions_, 0, 0)
+                .partition_id;
+            emit[partition_id].Put(s.item);
+            ++num_flushed;
+        }
+
+        sLOG << "ReduceSharedPreTable::FlushSlice()" << worker
+             << "sent" << num_flushed << "items";
+    }
+
+    //! Returns the number of items in the table.
+    size_t num_items() const { return num_items_.load(); }
+
+private:
+    //! a slot of the table, with a spin lock.
+    struct Slot {
+        std::atomic<bool> locked { false };
+        bool              used = false;
+        TableItem         item;
+
+        void Lock() {
+            while (locked.exchange(true, std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+        void Unlock() {
+            locked.store(false, std::memory_order_release);
+        }
+    };
+
+    //! extract the key of a table item
+    Key key(const TableItem& t) {
+        return MakeTableItem::GetKey(t, key_extractor_);
+    }
+
+    //! number of output partitions
+    size_t num_partitions_;
+
+    //! number of workers flushing slices
+    size_t num_workers_;
+
+    //! Key extractor function for extracting a key from a value.
+    KeyExtractor key_extractor_;
+
+    //! Reduce function for reducing two values.
+    ReduceFunction reduce_function_;
+
+    //! Index Calculation functions: Hash or ByIndex.
+    IndexFunction index_function_;
+
+    //! Comparator function for keys.
+    KeyEqualFunction key_equal_function_;
+
+    //! array of slots
+    std::unique_ptr<Slot[]> slots_;
+
+    //! number of slots
+    size_t num_slots_;
+
+    //! maximum number of items before Insert() rejects new keys
+    size_t limit_items_;
+
+    //! number of used slots
+    std::atomic<size_t> num_items_ { 0 };
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_SHARED_PRE_TABLE_HEADER
+
+/******************************************************************************/
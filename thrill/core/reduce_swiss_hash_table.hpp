@@ -0,0 +1,588 @@
+/*******************************************************************************
+ * thrill/core/reduce_swiss_hash_table.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_SWISS_HASH_TABLE_HEADER
+#define THRILL_CORE_REDUCE_SWISS_HASH_TABLE_HEADER
+
+#include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_table.hpp>
+
+#include <tlx/math/ffs.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A group of 16 control bytes of a ReduceSwissHashTable. Each control byte is
+ * either kEmpty or the 7-bit fingerprint of the item in the corresponding slot.
+ * Match() returns a bit mask of the bytes equal to a given byte, which is
+ * calculated with one SSE2 compare, or a SWAR fallback without SSE2.
+ */
+class ReduceSwissGroup
+{
+public:
+    //! number of slots per group
+    static constexpr size_t kSize = 16;
+
+    //! control byte of an empty slot
+    static constexpr uint8_t kEmpty = 0x80;
+
+    //! Returns bit mask of the control bytes in ctrl[0,16) equal to b.
+    static uint32_t Match(const uint8_t* ctrl, uint8_t b) {
+#if defined(__SSE2__)
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        __m128i cmp = _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(b)));
+        return static_cast<uint32_t>(_mm_movemask_epi8(cmp));
+#else
+        uint32_t mask = 0;
+        for (size_t half = 0; half < 2; ++half) {
+            uint64_t x;
+            std::memcpy(&x, ctrl + 8 * half, 8);
+            // zero bytes of x ^ pattern mark equal bytes
+            x ^= uint64_t(0x0101010101010101) * b;
+            uint64_t z = ~(((x & uint64_t(0x7F7F7F7F7F7F7F7F))
+                            + uint64_t(0x7F7F7F7F7F7F7F7F))
+                           | x | uint64_t(0x7F7F7F7F7F7F7F7F));
+            // gather the high bits of the bytes into a mask
+            for (size_t i = 0; i < 8; ++i)
+                mask |= static_cast<uint32_t>((z >> (8 * i + 7)) & 1)
+                        << (8 * half + i);
+        }
+        return mask;
+#endif
+    }
+};
+
+/*!
+ * A data structure which takes an arbitrary value and extracts a key using a
+ * key extractor function from that value. A key may also be provided initially
+ * as part of a key/value pair, not requiring to extract a key.
+ *
+ * This is an open addressing hash table in the style of Swiss tables: each
+ * slot has a control byte in a separate array which is either empty or holds
+ * 7 bits of the item's hash, its fingerprint. Slots are probed in groups of 16
+ * (see ReduceSwissGroup), so one vector compare against the fingerprint
+ * selects the few candidate slots whose full keys need to be compared, and a
+ * second compare finds the empty slots. Probing proceeds linearly across
+ * groups, and stops at the first group containing an empty slot.
+ *
+ * In contrast to ReduceProbingHashTable, no sentinel key is needed, and keys
+ * are only read if the fingerprints match, which avoids most cache misses on
+ * the item array. Items are never deleted individually, hence no tombstones
+ * are required.
+ *
+ * Each partition has its own item and control arrays, which grow by doubling
+ * from initial_items_per_partition_ up to the size calculated from the memory
+ * limit. Slot and fingerprint are both derived from
+ * IndexFunction::Result::local_index(), which works for ReduceByHash and
+ * ReduceByIndex.
+ */
+template <typename TableItem, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction, typename Emitter,
+          const bool VolatileKey,
+          typename ReduceConfig_,
+          typename IndexFunction,
+          typename KeyEqualFunction = std::equal_to<Key> >
+class ReduceSwissHashTable
+    : public ReduceTable<TableItem, Key, Value,
+                         KeyExtractor, ReduceFunction, Emitter,
+                         VolatileKey, ReduceConfig_,
+                         IndexFunction, KeyEqualFunction>
+{
+    using Super = ReduceTable<TableItem, Key, Value,
+                              KeyExtractor, ReduceFunction, Emitter,
+                              VolatileKey, ReduceConfig_, IndexFunction,
+                              KeyEqualFunction>;
+    using Super::debug;
+
+    using Group = ReduceSwissGroup;
+
+    //! number of hash bits used for the fingerprint
+    static constexpr size_t fingerprint_bits_ = 7;
+
+public:
+    using ReduceConfig = ReduceConfig_;
+
+    ReduceSwissHashTable(
+        Context& ctx, size_t dia_id,
+        const KeyExtractor& key_extractor,
+        const ReduceFunction& reduce_function,
+        Emitter& emitter,
+        size_t num_partitions,
+        const ReduceConfig& config = ReduceConfig(),
+        bool immediate_flush = false,
+        const IndexFunction& index_function = IndexFunction(),
+        const KeyEqualFunction& key_equal_function = KeyEqualFunction())
+        : Super(ctx, dia_id,
+                key_extractor, reduce_function, emitter,
+                num_partitions, config, immediate_flush,
+                index_function, key_equal_function)
+    { assert(num_partitions > 0); }
+
+    //! Construct the hash table itself: allocate the initial item and control
+    //! arrays of all partitions.
+    void Initialize(size_t limit_memory_bytes) {
+        assert(items_.empty());
+
+        limit_memory_bytes_ = limit_memory_bytes;
+
+        // calculate num_buckets_per_partition_ from the memory limit and the
+        // number of partitions required, each slot also costs a control byte.
+        // Partitions always consist of whole groups.
+
+        num_buckets_per_partition_ = std::max<size_t>(
+            1,
+            (size_t)(static_cast<double>(limit_memory_bytes_)
+                     / static_cast<double>(sizeof(TableItem) + 1)
+                     / static_cast<double>(num_partitions_)
+                     / static_cast<double>(Group::kSize)));
+        num_buckets_per_partition_ *= Group::kSize;
+
+        num_buckets_ = num_buckets_per_partition_ * num_partitions_;
+
+        assert(num_buckets_per_partition_ > 0);
+        assert(num_buckets_ > 0);
+
+        size_t initial_size = std::min(
+            RoundUpToGroup(config_.initial_items_per_partition_),
+            num_buckets_per_partition_);
+
+        items_.resize(num_partitions_, nullptr);
+        ctrl_.resize(num_partitions_, nullptr);
+        partition_size_.resize(num_partitions_, 0);
+        limit_items_per_partition_.resize(num_partitions_, 0);
+
+        for (size_t id = 0; id < num_partitions_; ++id)
+            AllocatePartition(id, initial_size);
+    }
+
+    ~ReduceSwissHashTable() {
+        if (!items_.empty()) Dispose();
+    }
+
+    /*!
+     * Inserts a value into the table, potentially reducing it in case both the
+     * key of the value already in the table and the key of the value to be
+     * inserted are the same.
+     *
+     * An insert may trigger a growth of the partition, or a spill if the
+     * partition cannot grow any more.
+     *
+     * \param kv Value to be inserted into the table.
+     *
+     * \return true if a new key was inserted to the table
+     */
+    bool Insert(const TableItem& kv) {
+        return Insert(kv, calculate_index(kv));
+    }
+
+    //! Inserts a value with its index calculated beforehand.
+    bool Insert(const TableItem& kv, const typename IndexFunction::Result& h) {
+
+        assert(h.partition_id < num_partitions_);
+
+        size_t partition_id = h.partition_id;
+
+        // get slot index and fingerprint from one local index calculation
+        size_t size = partition_size_[partition_id];
+        size_t index = h.local_index(size << fingerprint_bits_);
+        uint8_t fp = static_cast<uint8_t>(
+            index & ((size_t(1) << fingerprint_bits_) - 1));
+
+        size_t num_groups = size / Group::kSize;
+        size_t group = (index >> fingerprint_bits_) / Group::kSize;
+
+        for (size_t n = 0; n < num_groups; ++n)
+        {
+            uint8_t* ctrl = ctrl_[partition_id] + group * Group::kSize;
+            TableItem* items = items_[partition_id] + group * Group::kSize;
+
+            for (uint32_t m = Group::Match(ctrl, fp); m != 0; m &= m - 1) {
+                TableItem& slot = items[tlx::ffs(m) - 1];
+                if (key_equal_function_(key(slot), key(kv))) {
+                    reduce_into(slot, kv);
+                    return false;
+                }
+            }
+
+            uint32_t empty = Group::Match(ctrl, Group::kEmpty);
+            if (empty != 0) {
+                size_t i = tlx::ffs(empty) - 1;
+                new (items + i)TableItem(kv);
+                ctrl[i] = fp;
+
+                ++items_per_partition_[partition_id];
+                ++num_items_;
+
+                while (TLX_UNLIKELY(
+                           items_per_partition_[partition_id] >=
+                           limit_items_per_partition_[partition_id])) {
+                    LOG << "Grow due to "
+                        << items_per_partition_[partition_id] << " >= "
+                        << limit_items_per_partition_[partition_id]
+                        << " among " << partition_size_[partition_id];
+                    if (!GrowAndRehash(partition_id)) break;
+                }
+
+                return true;
+            }
+
+            // wrap around if beyond the current partition
+            if (TLX_UNLIKELY(++group == num_groups))
+                group = 0;
+        }
+
+        // all slots are reserved: grow or spill, and retry
+        GrowAndRehash(partition_id);
+        return Insert(kv, h);
+    }
+
+    //! Prefetches the control bytes of the first group probed by Insert(kv, h).
+    void Prefetch(const typename IndexFunction::Result& h) const {
+        size_t size = partition_size_[h.partition_id];
+        size_t group = (h.local_index(size << fingerprint_bits_)
+                        >> fingerprint_bits_) / Group::kSize;
+        common::PrefetchWrite(ctrl_[h.partition_id] + group * Group::kSize);
+        common::PrefetchWrite(items_[h.partition_id] + group * Group::kSize);
+    }
+
+    //! Deallocate items and memory
+    void Dispose() {
+        if (items_.empty()) return;
+
+        for (size_t id = 0; id < num_partitions_; ++id)
+            DeallocatePartition(id);
+
+        tlx::vector_free(items_);
+        tlx::vector_free(ctrl_);
+        tlx::vector_free(partition_size_);
+        tlx::vector_free(limit_items_per_partition_);
+
+        Super::Dispose();
+    }
+
+    /*!
+     * Double the size of a partition and reinsert its items. While rehashing,
+     * the old and new arrays of this one partition exist simultaneously. If
+     * the partition cannot grow, it is spilled instead. Returns false if the
+     * partition was spilled (and is hence empty).
+     */
+    bool GrowAndRehash(size_t partition_id) {
+
+        if (TLX_UNLIKELY(mem::memory_exceeded) ||
+            partition_size_[partition_id] == num_buckets_per_partition_) {
+            SpillPartition(partition_id);
+            return false;
+        }
+
+        size_t old_size = partition_size_[partition_id];
+        TableItem* old_items = items_[partition_id];
+        uint8_t* old_ctrl = ctrl_[partition_id];
+
+        size_t new_size = std::min(
+            num_buckets_per_partition_, 2 * old_size);
+
+        sLOG << "Growing partition" << partition_id
+             << "from" << old_size << "to" << new_size
+             << "limit_items" << new_size * config_.limit_partition_fill_rate();
+
+        AllocatePartition(partition_id, new_size);
+
+        num_items_ -= items_per_partition_[partition_id];
+        items_per_partition_[partition_id] = 0;
+
+        // reinsert items, this cannot trigger another growth since the new
+        // limit is twice the old one.
+        for (size_t i = 0; i < old_size; ++i) {
+            if (old_ctrl[i] == Group::kEmpty) continue;
+            InsertNew(partition_id, std::move(old_items[i]));
+            old_items[i].~TableItem();
+        }
+
+        operator delete (old_items);
+        delete[] old_ctrl;
+
+        return true;
+    }
+
+    //! \name Spilling Mechanisms to External Memory Files
+    //! \{
+
+    //! Spill all items of a partition into an external memory File.
+    void SpillPartition(size_t partition_id) {
+
+        if (immediate_flush_) {
+            return FlushPartition(
+                partition_id, /* consume */ true, /* grow */ !mem::memory_exceeded);
+        }
+
+        LOG << "Spilling " << items_per_partition_[partition_id]
+            << " items of partition with id: " << partition_id;
+
+        if (items_per_partition_[partition_id] == 0)
+            return;
+
+        data::File::Writer writer = partition_files_[partition_id].GetWriter();
+
+        TableItem* items = items_[partition_id];
+        uint8_t* ctrl = ctrl_[partition_id];
+
+        for (size_t i = 0; i < partition_size_[partition_id]; ++i) {
+            if (ctrl[i] == Group::kEmpty) continue;
+            writer.Put(items[i]);
+            items[i].~TableItem();
+            ctrl[i] = Group::kEmpty;
+        }
+
+        // reset partition specific counter
+        num_items_ -= items_per_partition_[partition_id];
+        items_per_partition_[partition_id] = 0;
+        assert(num_items_ == this->num_items_calc());
+
+        LOG << "Spilled items of partition with id: " << partition_id;
+    }
+
+    //! Spill all items of an arbitrary partition into an external memory File.
+    void SpillAnyPartition() {
+        // maybe make a policy later -tb
+        return SpillLargestPartition();
+    }
+
+    //! Spill all items of the largest partition into an external memory File.
+    void SpillLargestPartition() {
+        // get partition with max size
+        size_t size_max = 0, index = 0;
+
+        for (size_t i = 0; i < num_partitions_; ++i)
+        {
+            if (items_per_partition_[i] > size_max)
+            {
+                size_max = items_per_partition_[i];
+                index = i;
+            }
+        }
+
+        if (size_max == 0) {
+            return;
+        }
+
+        return SpillPartition(index);
+    }
+
+    //! \}
+
+    //! \name Flushing Mechanisms to Next Stage or Phase
+    //! \{
+
+    template <typename Emit>
+    void FlushPartitionEmit(
+        size_t partition_id, bool consume, bool grow, Emit emit) {
+
+        LOG << "Flushing " << items_per_partition_[partition_id]
+            << " items of partition: " << partition_id;
+
+        TableItem* items = items_[partition_id];
+        uint8_t* ctrl = ctrl_[partition_id];
+
+        for (size_t i = 0; i < partition_size_[partition_id]; ++i)
+        {
+            if (ctrl[i] == Group::kEmpty) continue;
+
+            emit(partition_id, items[i]);
+
+            if (consume) {
+                items[i].~TableItem();
+                ctrl[i] = Group::kEmpty;
+            }
+        }
+
+        if (consume) {
+            // reset partition specific counter
+            num_items_ -= items_per_partition_[partition_id];
+            items_per_partition_[partition_id] = 0;
+            assert(num_items_ == this->num_items_calc());
+        }
+
+        LOG << "Done flushed items of partition: " << partition_id;
+
+        if (grow)
+            GrowPartition(partition_id);
+    }
+
+    void FlushPartition(size_t partition_id, bool consume, bool grow) {
+        FlushPartitionEmit(
+            partition_id, consume, grow,
+            [this](const size_t& partition_id, const TableItem& p) {
+                this->emitter_.Emit(partition_id, p);
+            });
+    }
+
+    void FlushAll() {
+        for (size_t i = 0; i < num_partitions_; ++i) {
+            FlushPartition(i, /* consume */ true, /* grow */ false);
+        }
+    }
+
+    //! \}
+
+public:
+    using Super::calculate_index;
+
+private:
+    using Super::config_;
+    using Super::immediate_flush_;
+    using Super::index_function_;
+    using Super::items_per_partition_;
+    using Super::key;
+    using Super::key_equal_function_;
+    using Super::limit_memory_bytes_;
+    using Super::num_buckets_;
+    using Super::num_buckets_per_partition_;
+    using Super::num_items_;
+    using Super::num_partitions_;
+    using Super::partition_files_;
+    using Super::reduce;
+
+    //! item arrays of the partitions, only slots with non-empty control bytes
+    //! contain constructed items.
+    std::vector<TableItem*> items_;
+
+    //! control byte arrays of the partitions
+    std::vector<uint8_t*> ctrl_;
+
+    //! Current sizes of the partitions because the arrays grow
+    std::vector<size_t> partition_size_;
+
+    //! Current limits on the number of items in a partitions, different for
+    //! different partitions, because the arrays grow.
+    std::vector<size_t> limit_items_per_partition_;
+
+    static size_t RoundUpToGroup(size_t n) {
+        return std::max<size_t>(
+            Group::kSize, (n + Group::kSize - 1) / Group::kSize * Group::kSize);
+    }
+
+    //! Allocate empty arrays of the given size for a partition, the old
+    //! arrays are not freed.
+    void AllocatePartition(size_t partition_id, size_t size) {
+        assert(size % Group::kSize == 0);
+
+        items_[partition_id] = static_cast<TableItem*>(
+            operator new (size * sizeof(TableItem)));
+        ctrl_[partition_id] = new uint8_t[size];
+        std::fill(ctrl_[partition_id], ctrl_[partition_id] + size,
+                  Group::kEmpty);
+
+        partition_size_[partition_id] = size;
+        limit_items_per_partition_[partition_id] =
+            static_cast<size_t>(
+                static_cast<double>(size) * config_.limit_partition_fill_rate());
+    }
+
+    //! Destroy items and free the arrays of a partition.
+    void DeallocatePartition(size_t partition_id) {
+        TableItem* items = items_[partition_id];
+        uint8_t* ctrl = ctrl_[partition_id];
+        if (!items) return;
+
+        for (size_t i = 0; i < partition_size_[partition_id]; ++i) {
+            if (ctrl[i] != Group::kEmpty)
+                items[i].~TableItem();
+        }
+
+        operator delete (items);
+        delete[] ctrl;
+        items_[partition_id] = nullptr;
+        ctrl_[partition_id] = nullptr;
+    }
+
+    //! Grow an empty partition after a spill or flush (if possible)
+    void GrowPartition(size_t partition_id) {
+
+        if (TLX_UNLIKELY(mem::memory_exceeded))
+            return;
+
+        if (partition_size_[partition_id] == num_buckets_per_partition_)
+            return;
+
+        assert(items_per_partition_[partition_id] == 0);
+
+        size_t new_size = std::min(
+            num_buckets_per_partition_, 2 * partition_size_[partition_id]);
+
+        DeallocatePartition(partition_id);
+        AllocatePartition(partition_id, new_size);
+    }
+
+    //! Insert an item whose key is known not to be in the partition, without
+    //! checking fill limits. Used for rehashing.
+    void InsertNew(size_t partition_id, TableItem&& kv) {
+        typename IndexFunction::Result h = calculate_index(kv);
+        assert(h.partition_id == partition_id);
+
+        size_t size = partition_size_[partition_id];
+        size_t index = h.local_index(size << fingerprint_bits_);
+        uint8_t fp = static_cast<uint8_t>(
+            index & ((size_t(1) << fingerprint_bits_) - 1));
+
+        size_t num_groups = size / Group::kSize;
+        size_t group = (index >> fingerprint_bits_) / Group::kSize;
+
+        while (true) {
+            uint8_t* ctrl = ctrl_[partition_id] + group * Group::kSize;
+            uint32_t empty = Group::Match(ctrl, Group::kEmpty);
+            if (empty != 0) {
+                size_t i = tlx::ffs(empty) - 1;
+                new (items_[partition_id] + group * Group::kSize + i)
+                TableItem(std::move(kv));
+                ctrl[i] = fp;
+                ++items_per_partition_[partition_id];
+                ++num_items_;
+                return;
+            }
+            if (++group == num_groups) group = 0;
+        }
+    }
+};
+
+template <typename TableItem, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction,
+          typename Emitter, const bool VolatileKey,
+          typename ReduceConfig, typename IndexFunction,
+          typename KeyEqualFunction>
+class ReduceTableSelect<
+        ReduceTableImpl::SWISS,
+        TableItem, Key, Value, KeyExtractor, ReduceFunction,
+        Emitter, VolatileKey, ReduceConfig, IndexFunction, KeyEqualFunction>
+{
+public:
+    using type = ReduceSwissHashTable<
+        TableItem, Key, Value, KeyExtractor, ReduceFunction,
+        Emitter, VolatileKey, ReduceConfig,
+        IndexFunction, KeyEqualFunction>;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_SWISS_HASH_TABLE_HEADER
+
+/******************************************************************************/
@@ -14,11 +14,14 @@
 #define THRILL_CORE_REDUCE_TABLE_HEADER
 
 #include <thrill/api/context.hpp>
+#include <thrill/common/defines.hpp>
+#include <thrill/common/item_memory_size.hpp>
 #include <thrill/core/reduce_functional.hpp>
 
 #include <tlx/vector_free.hpp>
 
 #include <algorithm>
+#include <cassert>
 #include <functional>
 #include <limits>
 #include <utility>
@@ -27,11 +30,30 @@
 namespace thrill {
 namespace core {
 
-//! Enum class to select a hash table implementation.
+//! Enum class to select a hash table implementation. AUTO uses a PROBING
+//! table, but lets the ReducePrePhase switch to pass-through mode if a sample
+//! of the first items shows that the keys rarely combine.
 enum class ReduceTableImpl {
-    PROBING, OLD_PROBING, BUCKET
+    PROBING, OLD_PROBING, BUCKET, SWISS, AUTO
 };
 
+//! Returns the name of a ReduceTableImpl, e.g. for DIA::Explain().
+static inline const char * ReduceTableImplName(const ReduceTableImpl& impl) {
+    switch (impl) {
+    case ReduceTableImpl::PROBING:
+        return "PROBING";
+    case ReduceTableImpl::OLD_PROBING:
+        return "OLD_PROBING";
+    case ReduceTableImpl::BUCKET:
+        return "BUCKET";
+    case ReduceTableImpl::SWISS:
+        return "SWISS";
+    case ReduceTableImpl::AUTO:
+        return "AUTO";
+    }
+    return "?";
+}
+
 /*!
  * Configuration class to define operational parameters of reduce hash tables
  * and reduce phases. Most members can be defined static constexpr or be mutable
@@ -48,6 +70,44 @@ public:
     //! relative to the maximum possible number.
     double bucket_rate_ = 0.6;
 
+    //! only for AUTO: number of items at the start of the pre-phase whose
+    //! distinct keys are estimated.
+    size_t auto_sample_size_ = 100000;
+
+    //! only for AUTO: switch to pass-through if the estimated ratio of
+    //! distinct keys in the sample is at least this.
+    double auto_pass_through_ratio_ = 0.8;
+
+    //! only for adaptive bypass: number of items inserted into a partition
+    //! before its hit rate is evaluated.
+    size_t bypass_window_ = 4096;
+
+    //! only for adaptive bypass: bypass the table for a partition if less than
+    //! this fraction of its items were reduced.
+    double bypass_hit_rate_ = 0.05;
+
+    //! only for adaptive bypass: number of slots of the combine cache in front
+    //! of bypassed partitions.
+    size_t bypass_cache_size_ = 256;
+
+    //! number of threads re-reducing spilled partitions in the post-phase, 0
+    //! means the idle helper threads of Context::task_pool().
+    size_t post_phase_threads_ = 1;
+
+    //! only for ReduceToIndex: reduce into a dense array of all indexes in the
+    //! pre-phase instead of a hash table, if it needs at most this many bytes.
+    size_t dense_pre_phase_max_bytes_ = 16 * 1024 * 1024;
+
+    //! only for shared pre-phase: fraction of each worker's pre-phase memory
+    //! contributed to the table shared by the host's workers.
+    double shared_pre_phase_ratio_ = 0.25;
+
+    //! only for ProbingHashTable with variable-size items: fraction of the
+    //! memory limit reserved for the heap memory of the items, the slot array
+    //! is sized from the remainder. Items which own little heap memory, e.g.
+    //! short strings in their inline buffer, need a smaller reserve.
+    double heap_memory_fraction_ = 0.5;
+
     //! select the hash table in the reduce phase by enum
     static constexpr ReduceTableImpl table_impl_ = ReduceTableImpl::PROBING;
 
@@ -62,10 +122,50 @@ public:
     //! of items delivered in the ReduceFunction arbitrary.
     static constexpr bool use_mix_stream_ = true;
 
+    //! insert items into the ReducePrePhase's and ReduceByHashPostPhase's
+    //! tables in batches: the indexes of a batch are calculated together and
+    //! their slots prefetched, then the items are inserted. Not used with AUTO
+    //! or adaptive bypass in the pre phase.
+    static constexpr bool use_batch_insert_ = false;
+
+    //! number of items in a batch with use_batch_insert_
+    static constexpr size_t batch_insert_size_ = 32;
+
     //! use an additional thread in ReduceNode and ReduceToIndexNode to process
     //! the pre and post phases simultaneously.
     static constexpr bool use_post_thread_ = true;
 
+    //! exchange items in ReduceNode in two levels, first between hosts, then
+    //! among the workers of a host, see TwoLevelExchange. This implies the
+    //! arbitrary item order of use_mix_stream_.
+    static constexpr bool use_two_level_exchange_ = false;
+
+    //! let the ReducePrePhase monitor the hit rate of each partition and
+    //! bypass the table for partitions in which items rarely reduce.
+    static constexpr bool use_adaptive_bypass_ = false;
+
+    //! let the ReduceByHashPostPhase split spilled partitions up front into as
+    //! many files as needed by their estimated number of distinct keys, such
+    //! that they are re-reduced in a single pass.
+    static constexpr bool use_grace_post_phase_ = false;
+
+    //! only for ReduceByKey: aggregate in the post-phase by sorting runs and
+    //! merging them, see ReduceBySortPostPhase, instead of hashing. This
+    //! requires an ordered Key.
+    static constexpr bool use_sort_post_phase_ = false;
+
+    //! only for ReduceByKey: calculate a 32-bit hash of each key once in the
+    //! pre-phase and carry it along with the item in the tables and streams,
+    //! such that the post-phase need not hash the key again, see
+    //! ReduceHashedKey. The hash is also compared before the keys. This pays
+    //! off for expensive hash functions, e.g. of strings.
+    static constexpr bool use_hash_cache_ = false;
+
+    //! only for ReduceByKey: reduce items in a table shared by all workers of
+    //! a host first, see ReduceSharedPreTable, which combines hot keys of the
+    //! host's workers before sending them. Not used with duplicate detection.
+    static constexpr bool use_shared_pre_phase_ = false;
+
     //! \name Accessors
     //! \{
 
@@ -76,6 +176,34 @@ public:
     //! Returns bucket_rate_
     double bucket_rate() const { return bucket_rate_; }
 
+    //! Returns auto_sample_size_
+    size_t auto_sample_size() const { return auto_sample_size_; }
+
+    //! Returns auto_pass_through_ratio_
+    double auto_pass_through_ratio() const { return auto_pass_through_ratio_; }
+
+    //! Returns bypass_window_
+    size_t bypass_window() const { return bypass_window_; }
+
+    //! Returns bypass_hit_rate_
+    double bypass_hit_rate() const { return bypass_hit_rate_; }
+
+    //! Returns bypass_cache_size_
+    size_t bypass_cache_size() const { return bypass_cache_size_; }
+
+    //! Returns post_phase_threads_
+    size_t post_phase_threads() const { return post_phase_threads_; }
+
+    //! Returns dense_pre_phase_max_bytes_
+    size_t dense_pre_phase_max_bytes() const
+    { return dense_pre_phase_max_bytes_; }
+
+    //! Returns shared_pre_phase_ratio_
+    double shared_pre_phase_ratio() const { return shared_pre_phase_ratio_; }
+
+    //! Returns heap_memory_fraction_
+    double heap_memory_fraction() const { return heap_memory_fraction_; }
+
     //! \}
 };
 
@@ -110,6 +238,9 @@ public:
             VolatileKey, std::pair<Key, Value>, Value>::type;
     using MakeTableItem = ReduceMakeTableItem<Value, TableItem, VolatileKey>;
 
+    //! estimation of heap memory owned by variable-size TableItems
+    using ItemMemory = common::ItemMemorySize<TableItem>;
+
     ReduceTable(
         Context& ctx, size_t dia_id,
         const KeyExtractor& key_extractor,
@@ -133,6 +264,9 @@ public:
 
         assert(num_partitions > 0);
 
+        if (!ItemMemory::is_fixed)
+            heap_per_partition_.resize(num_partitions_, 0);
+
         // allocate Files for each partition to spill into. TODO(tb): switch to
         // FilePtr ondemand
 
@@ -152,6 +286,7 @@ public:
     void Dispose() {
         tlx::vector_free(partition_files_);
         tlx::vector_free(items_per_partition_);
+        tlx::vector_free(heap_per_partition_);
     }
 
     //! Initialize table for SkipPreReducePhase
@@ -253,6 +388,76 @@ public:
 
     //! \}
 
+    //! \name Heap Memory of Variable-Size Items
+    //! \{
+
+    //! split memory limit into table and heap memory, returns the table part.
+    //! The heap memory of variable-size items gets the fraction
+    //! heap_memory_fraction() of the ReduceConfig, tables of fixed-size items
+    //! use all memory for the table.
+    size_t SplitHeapMemoryLimit(size_t limit_memory_bytes) {
+        if (ItemMemory::is_fixed) return limit_memory_bytes;
+        limit_heap_bytes_ = static_cast<size_t>(
+            static_cast<double>(limit_memory_bytes)
+            * config_.heap_memory_fraction());
+        return limit_memory_bytes - limit_heap_bytes_;
+    }
+
+    //! heap memory owned by the item, zero for fixed-size items.
+    size_t heap_size(const TableItem& t) const {
+        return ItemMemory::is_fixed ? 0 : ItemMemory::heap(t);
+    }
+
+    //! count item added to partition
+    void HeapAdd(size_t partition_id, const TableItem& t) {
+        if (ItemMemory::is_fixed) return;
+        size_t bytes = ItemMemory::heap(t);
+        heap_per_partition_[partition_id] += bytes;
+        heap_bytes_ += bytes;
+    }
+
+    //! update partition after item, which had old_bytes heap memory, changed.
+    void HeapUpdate(size_t partition_id, size_t old_bytes, const TableItem& t) {
+        if (ItemMemory::is_fixed) return;
+        size_t bytes = ItemMemory::heap(t);
+        heap_per_partition_[partition_id] += bytes - old_bytes;
+        heap_bytes_ += bytes - old_bytes;
+    }
+
+    //! count item removed from partition
+    void HeapRemove(size_t partition_id, const TableItem& t) {
+        if (ItemMemory::is_fixed) return;
+        size_t bytes = ItemMemory::heap(t);
+        heap_per_partition_[partition_id] -= bytes;
+        heap_bytes_ -= bytes;
+    }
+
+    //! reset heap memory of partition after it was spilled or flushed
+    void HeapClear(size_t partition_id) {
+        if (ItemMemory::is_fixed) return;
+        heap_bytes_ -= heap_per_partition_[partition_id];
+        heap_per_partition_[partition_id] = 0;
+    }
+
+    //! whether the heap memory of the items exceeds its limit
+    bool heap_exceeded() const {
+        return !ItemMemory::is_fixed && heap_bytes_ > limit_heap_bytes_;
+    }
+
+    //! partition with most heap memory
+    size_t LargestHeapPartition() const {
+        assert(!ItemMemory::is_fixed);
+        return static_cast<size_t>(
+            std::max_element(heap_per_partition_.begin(),
+                             heap_per_partition_.end())
+            - heap_per_partition_.begin());
+    }
+
+    //! Returns the heap memory of the items in the table
+    size_t heap_bytes() const { return heap_bytes_; }
+
+    //! \}
+
     //! \name Switches for VolatileKey
     //! \{
 
@@ -264,11 +469,31 @@ public:
         return MakeTableItem::Reduce(a, b, reduce_function_);
     }
 
+    //! reduce b into a in place, without a temporary TableItem.
+    void reduce_into(TableItem& a, const TableItem& b) const {
+        MakeTableItem::ReduceInto(a, b, reduce_function_);
+    }
+
     typename IndexFunction::Result calculate_index(const TableItem& kv) const {
         return index_function_(
             key(kv), num_partitions_, num_buckets_per_partition_, num_buckets_);
     }
 
+    /*!
+     * Calculates the indexes of n items into out. The independent hash
+     * calculations of a batch overlap in the pipeline, and may be vectorized
+     * by the compiler. The indexes stay valid until the table is initialized
+     * again.
+     */
+    void calculate_indexes(const TableItem* kv, size_t n,
+                           typename IndexFunction::Result* out) const {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = calculate_index(kv[i]);
+    }
+
+    //! Prefetches the slot of an index, implemented by open addressing tables.
+    void Prefetch(const typename IndexFunction::Result& /* h */) const { }
+
     //! \}
 
 protected:
@@ -333,6 +558,15 @@ protected:
     //! Current number of items per partition.
     std::vector<size_t> items_per_partition_;
 
+    //! Heap memory of variable-size items per partition, empty if fixed.
+    std::vector<size_t> heap_per_partition_;
+
+    //! Total heap memory of variable-size items.
+    size_t heap_bytes_ = 0;
+
+    //! Limit on heap_bytes_ before a partition is spilled.
+    size_t limit_heap_bytes_ = 0;
+
     //! \}
 };
 
@@ -347,6 +581,29 @@ template <ReduceTableImpl ImplSelect,
           typename KeyEqualFunction = std::equal_to<Key> >
 class ReduceTableSelect;
 
+/*!
+ * Inserts n items into a ReduceTable in one batch: their indexes are
+ * calculated together, the slots of all items are prefetched, and then the
+ * items are inserted. The cache misses of the batch thus overlap, which pays
+ * off for tables larger than the last level cache. n must not exceed
+ * ReduceConfig::batch_insert_size_.
+ */
+template <typename Table>
+void ReduceTableInsertBatch(
+    Table& table, const typename Table::TableItem* kv, size_t n) {
+    using IndexResult = decltype(table.calculate_index(*kv));
+    static constexpr size_t batch_size =
+        Table::ReduceConfig::batch_insert_size_;
+    assert(n <= batch_size);
+
+    IndexResult index[batch_size];
+    table.calculate_indexes(kv, n, index);
+    for (size_t i = 0; i < n; ++i)
+        table.Prefetch(index[i]);
+    for (size_t i = 0; i < n; ++i)
+        table.Insert(kv[i], index[i]);
+}
+
 } // namespace core
 } // namespace thrill
 
@@ -0,0 +1,167 @@
+/*******************************************************************************
+ * thrill/core/semi_join_filter.hpp
+ *
+ * Distributed Golomb coded single shot bloom filter of the keys of one input of
+ * a join.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_SEMI_JOIN_FILTER_HEADER
+#define THRILL_CORE_SEMI_JOIN_FILTER_HEADER
+
+#include <thrill/api/context.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/core/delta_stream.hpp>
+#include <thrill/core/golomb_bit_stream.hpp>
+
+#include <tlx/vector_free.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A semi-join filter: the hashes of the keys of one input of a join are
+ * inserted on all workers, and after Flush() each worker can check whether an
+ * item of the other input may have a join partner, and otherwise drop it before
+ * it is sent over the network.
+ *
+ * Internally, this is a Golomb encoded distributed single shot bloom filter,
+ * like the one of DuplicateDetection: the hashes are taken modulo fpr_parameter
+ * times the total number of hashes, and each worker sends its sorted hashes
+ * Golomb/delta-encoded to all workers, which set the bits of a bitset. Hence,
+ * the filter has a false positive rate of about 1/fpr_parameter, but no false
+ * negatives, and each key costs about log2(fpr_parameter) + 2 bits per worker.
+ *
+ * Should only be used if the filter input has few keys compared to the items of
+ * the filtered input, e.g. for a join of a fact table with a filtered dimension.
+ */
+class SemiJoinFilter
+{
+    static constexpr bool debug = false;
+
+private:
+    using GolombBitStreamWriter =
+        core::GolombBitStreamWriter<data::CatStream::Writer>;
+
+    using GolombBitStreamReader =
+        core::GolombBitStreamReader<data::CatStream::Reader>;
+
+    using GolumbDeltaWriter =
+        core::DeltaStreamWriter<GolombBitStreamWriter, size_t, /* offset */ 1>;
+
+    using GolumbDeltaReader =
+        core::DeltaStreamReader<GolombBitStreamReader, size_t, /* offset */ 1>;
+
+public:
+    //! Parameter for false positive rate (FPR: 1/fpr_parameter)
+    static constexpr size_t fpr_parameter = 8;
+
+    SemiJoinFilter(Context& context, size_t dia_id)
+        : context_(context), dia_id_(dia_id) { }
+
+    //! Insert the hash of a key of the filter input.
+    void Insert(size_t hash) {
+        hashes_.push_back(hash);
+    }
+
+    /*!
+     * Collectively exchange the inserted hashes of all workers, after which
+     * Contains() may be called.
+     */
+    void Flush() {
+        std::sort(hashes_.begin(), hashes_.end());
+        hashes_.erase(std::unique(hashes_.begin(), hashes_.end()),
+                      hashes_.end());
+
+        size_t upper_bound_uniques = context_.net.AllReduce(hashes_.size());
+        max_hash_ = upper_bound_uniques * fpr_parameter;
+
+        sLOG << "SemiJoinFilter: upper_bound_uniques" << upper_bound_uniques
+             << "max_hash_" << max_hash_;
+
+        // no keys on any worker: nothing passes the filter
+        if (max_hash_ == 0) {
+            tlx::vector_free(hashes_);
+            return;
+        }
+
+        for (size_t& h : hashes_)
+            h %= max_hash_;
+        std::sort(hashes_.begin(), hashes_.end());
+
+        size_t golomb_param = fpr_parameter;
+
+        data::CatStreamPtr stream = context_.GetNewCatStream(dia_id_);
+        {
+            data::CatStream::Writers writers = stream->GetWriters();
+
+            for (size_t i = 0; i < context_.num_workers(); ++i) {
+                GolombBitStreamWriter golomb_writer(writers[i], golomb_param);
+                GolumbDeltaWriter delta_writer(
+                    golomb_writer,
+                    /* initial */ size_t(-1) /* cancels with +1 bias */);
+
+                size_t prev_hash = size_t(-1);
+                for (const size_t& h : hashes_) {
+                    if (h == prev_hash) continue;
+                    delta_writer.Put(h);
+                    prev_hash = h;
+                }
+            }
+        }
+        tlx::vector_free(hashes_);
+
+        bits_.resize(max_hash_, false);
+
+        std::vector<data::CatStream::Reader> readers = stream->GetReaders();
+
+        for (data::CatStream::Reader& reader : readers)
+        {
+            GolombBitStreamReader golomb_reader(reader, golomb_param);
+            GolumbDeltaReader delta_reader(
+                golomb_reader, /* initial */ size_t(-1) /* cancels at +1 */);
+
+            while (delta_reader.HasNext()) {
+                size_t hash = delta_reader.Next<size_t>();
+                assert(hash < bits_.size());
+                bits_[hash] = true;
+            }
+        }
+    }
+
+    //! Check whether the key with this hash may be in the filter input.
+    bool Contains(size_t hash) const {
+        return max_hash_ != 0 && bits_[hash % max_hash_];
+    }
+
+    void Dispose() {
+        tlx::vector_free(hashes_);
+        tlx::vector_free(bits_);
+    }
+
+private:
+    //! Thrill context
+    Context& context_;
+    //! Id of the DIA node, used for the data streams
+    size_t dia_id_;
+    //! hashes inserted on this worker
+    std::vector<size_t> hashes_;
+    //! modulo of all hashes in the filter
+    size_t max_hash_ = 0;
+    //! bitset of hashes of all workers
+    std::vector<bool> bits_;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_SEMI_JOIN_FILTER_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,195 @@
+/*******************************************************************************
+ * thrill/core/two_level_exchange.hpp
+ *
+ * Hierarchical all-to-all exchange of items: items are first sent between
+ * hosts to the worker with the same local id on the destination host, and then
+ * redistributed among the workers of each host via the loopback of the
+ * data::Multiplexer.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_TWO_LEVEL_EXCHANGE_HEADER
+#define THRILL_CORE_TWO_LEVEL_EXCHANGE_HEADER
+
+#include <thrill/api/context.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/data/mix_stream.hpp>
+
+#include <tlx/die.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Two-level all-to-all exchange of items of type ItemType. Instead of sending
+ * blocks from every worker to every other worker, a worker with local id l
+ * sends all items destined for host h to worker l on host h. That worker then
+ * forwards the items to their final worker on host h. Each worker hence writes
+ * only to num_hosts() + workers_per_host() destinations, which yields fewer
+ * and better filled blocks on large clusters. The order of received items is
+ * arbitrary, like with a MixStream.
+ *
+ * The Writer handles returned by GetWriters() can be plugged in place of
+ * BlockWriters, e.g. into a ReducePrePhase. After all writers are closed,
+ * GetReader() forwards the items received from other hosts and returns a
+ * reader of the items destined for this worker.
+ */
+template <typename ItemType>
+class TwoLevelExchange
+{
+    static constexpr bool debug = false;
+
+public:
+    //! items sent between hosts are tagged with the final local worker id.
+    using HostItem = std::pair<size_t, ItemType>;
+
+    using MixReader = data::MixStream::MixReader;
+
+    //! BlockWriter-like handle which sends items to one destination worker.
+    class Writer
+    {
+    public:
+        //! default constructor: an invalid, closed Writer
+        Writer() : exchange_(nullptr), worker_(0), closed_(true) { }
+
+        Writer(TwoLevelExchange* exchange, size_t worker)
+            : exchange_(exchange), worker_(worker) { }
+
+        //! send an item to the destination worker
+        Writer& Put(const ItemType& item) {
+            exchange_->Put(worker_, item);
+            return *this;
+        }
+
+        //! flush the underlying host writer
+        void Flush() { exchange_->Flush(worker_); }
+
+        //! close this handle, the host writers are closed when all handles are
+        void Close() {
+            if (closed_) return;
+            closed_ = true;
+            exchange_->CloseOne();
+        }
+
+        bool IsValid() const { return exchange_ != nullptr; }
+
+    private:
+        TwoLevelExchange* exchange_;
+        size_t worker_;
+        bool closed_ = false;
+    };
+
+    using Writers = std::vector<Writer>;
+
+    TwoLevelExchange(api::Context& context, size_t dia_id)
+        : context_(context),
+          host_stream_(context.GetNewMixStream(dia_id)),
+          local_stream_(context.GetNewMixStream(dia_id)),
+          host_writers_(host_stream_->GetWriters()),
+          num_open_(context.num_workers()) { }
+
+    //! non-copyable: delete copy-constructor
+    TwoLevelExchange(const TwoLevelExchange&) = delete;
+    //! non-copyable: delete assignment operator
+    TwoLevelExchange& operator = (const TwoLevelExchange&) = delete;
+
+    //! Returns one Writer handle for each destination worker.
+    Writers GetWriters() {
+        Writers writers;
+        writers.reserve(context_.num_workers());
+        for (size_t w = 0; w < context_.num_workers(); ++w)
+            writers.emplace_back(this, w);
+        return writers;
+    }
+
+    //! Send item to global worker.
+    void Put(size_t worker, const ItemType& item) {
+        size_t wph = context_.workers_per_host();
+        host_writers_[HostProxy(worker)].Put(
+            HostItem(worker % wph, item));
+    }
+
+    //! Flush writer towards the host of worker.
+    void Flush(size_t worker) {
+        host_writers_[HostProxy(worker)].Flush();
+    }
+
+    //! Close all writers, this is done automatically when all Writer handles
+    //! are closed.
+    void Close() {
+        for (data::MixStream::Writer& w : host_writers_)
+            w.Close();
+        num_open_ = 0;
+    }
+
+    /*!
+     * Forward items received from other hosts to the local workers, and return
+     * a reader for the items destined for this worker. Must be called exactly
+     * once on each worker after the writers are closed (or concurrently from a
+     * receiver thread).
+     */
+    MixReader GetReader(bool consume) {
+        die_unless(!forwarded_);
+        forwarded_ = true;
+
+        size_t base = context_.host_rank() * context_.workers_per_host();
+
+        data::MixStream::Writers local_writers = local_stream_->GetWriters();
+        {
+            MixReader reader = host_stream_->GetMixReader(/* consume */ true);
+            while (reader.HasNext()) {
+                HostItem hi = reader.template Next<HostItem>();
+                local_writers[base + hi.first].Put(hi.second);
+            }
+        }
+        local_writers.clear();
+        host_stream_.reset();
+
+        sLOG << "TwoLevelExchange::GetReader() forwarding done";
+
+        return local_stream_->GetMixReader(consume);
+    }
+
+private:
+    //! context
+    api::Context& context_;
+
+    //! stream between hosts, first level
+    data::MixStreamPtr host_stream_;
+
+    //! stream between workers on the same host, second level
+    data::MixStreamPtr local_stream_;
+
+    //! writers of host_stream_
+    data::MixStream::Writers host_writers_;
+
+    //! number of Writer handles not yet closed
+    size_t num_open_;
+
+    //! whether GetReader() was called
+    bool forwarded_ = false;
+
+    //! Returns the worker with our local id on the host of worker.
+    size_t HostProxy(size_t worker) const {
+        size_t wph = context_.workers_per_host();
+        return (worker / wph) * wph + context_.local_worker_id();
+    }
+
+    void CloseOne() {
+        if (num_open_ != 0 && --num_open_ == 0) Close();
+    }
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_TWO_LEVEL_EXCHANGE_HEADER
+
+/******************************************************************************/
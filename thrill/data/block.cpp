@@ -9,6 +9,7 @@
  ******************************************************************************/
 
 #include <thrill/data/block.hpp>
+#include <thrill/common/deferred_work.hpp>
 #include <thrill/data/block_pool.hpp>
 
 #include <string>
@@ -64,6 +65,9 @@ std::ostream& operator << (std::ostream& os, const PinnedBlock& b) {
 PinnedBlock PinRequest::Wait() {
     if (ready_) return block_;
 
+    // run deferred work of the worker while the block is read
+    while (!ready_.load() && common::DeferredWork::RunOne()) { }
+
     std::unique_lock<std::mutex> lock(block_pool_->mutex_);
     while (!ready_.load())
         block_pool_->cv_read_complete_.wait(lock);
@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * thrill/data/block_codec.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/data/block_codec.hpp>
+
+#include <tlx/die.hpp>
+
+#if THRILL_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace thrill {
+namespace data {
+
+#if THRILL_HAVE_ZLIB
+
+/*!
+ * zlib codec with the fastest compression level, which still reduces text and
+ * tuple data considerably.
+ */
+class ZlibBlockCodec final : public BlockCodec
+{
+public:
+    const char * name() const final { return "zlib"; }
+
+    size_t Compress(const Byte* data, size_t size,
+                    Byte* out, size_t out_size) const final {
+        uLongf dest_len = out_size;
+        int err = compress2(out, &dest_len, data, size, Z_BEST_SPEED);
+        if (err == Z_BUF_ERROR) return 0;
+        die_unequal(err, Z_OK);
+        return dest_len;
+    }
+
+    bool Decompress(const Byte* data, size_t size,
+                    Byte* out, size_t out_size) const final {
+        uLongf dest_len = out_size;
+        int err = uncompress(out, &dest_len, data, size);
+        return err == Z_OK && dest_len == out_size;
+    }
+};
+
+#endif  // THRILL_HAVE_ZLIB
+
+std::unique_ptr<BlockCodec> BlockCodec::Create(const std::string& name) {
+    if (name.empty() || name == "none")
+        return nullptr;
+#if THRILL_HAVE_ZLIB
+    if (name == "zlib")
+        return std::make_unique<ZlibBlockCodec>();
+#endif
+    die("BlockCodec: unknown or unavailable codec \"" << name << "\"");
+}
+
+} // namespace data
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * thrill/data/block_codec.hpp
+ *
+ * Pluggable compression codecs for ByteBlocks evicted to external memory.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_BLOCK_CODEC_HEADER
+#define THRILL_DATA_BLOCK_CODEC_HEADER
+
+#include <thrill/data/byte_block.hpp>
+
+#include <memory>
+#include <string>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+/*!
+ * Interface of a codec compressing the raw bytes of a ByteBlock, used by the
+ * BlockPool when evicting blocks to external memory. Codecs must be thread-safe,
+ * since they are invoked by all workers of a host.
+ */
+class BlockCodec
+{
+public:
+    virtual ~BlockCodec() { }
+
+    //! name of the codec
+    virtual const char * name() const = 0;
+
+    /*!
+     * Compress size bytes at data into out, which has space for out_size
+     * bytes. Returns the size of the compressed data, or zero if it did not
+     * fit into out_size bytes, in which case the block is stored raw.
+     */
+    virtual size_t Compress(const Byte* data, size_t size,
+                            Byte* out, size_t out_size) const = 0;
+
+    /*!
+     * Decompress size bytes at data into out, which must receive exactly
+     * out_size bytes. Returns false if the data is corrupt.
+     */
+    virtual bool Decompress(const Byte* data, size_t size,
+                            Byte* out, size_t out_size) const = 0;
+
+    /*!
+     * Create a codec by name: "zlib" (if compiled with zlib), or "none" or ""
+     * for no compression, which returns nullptr. Dies on unknown names.
+     */
+    static std::unique_ptr<BlockCodec> Create(const std::string& name);
+};
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_BLOCK_CODEC_HEADER
+
+/******************************************************************************/
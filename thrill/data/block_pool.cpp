@@ -10,9 +10,11 @@
 
 #include <thrill/common/logger.hpp>
 #include <thrill/common/math.hpp>
+#include <thrill/common/porting.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_pool.hpp>
 #include <thrill/mem/aligned_allocator.hpp>
+#include <thrill/mem/huge_page_arena.hpp>
 #include <thrill/mem/pool.hpp>
 
 #include <foxxll/io/file.hpp>
@@ -26,6 +28,7 @@
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <list>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -239,6 +242,80 @@ using ReadingMap = std::unordered_map<
     mem::GPoolAllocator<
         std::pair<ByteBlock* const, PinRequestPtr> > >;
 
+/*!
+ * Set of the unpinned blocks in memory, from which the victims for eviction
+ * are selected. Blocks with EvictionHint::Reusable are evicted in LRU
+ * order. Blocks which were passed by a sequential or consuming File reader are
+ * kept in a separate scan list, which is evicted first and in MRU order: a
+ * repeated scan of a File needs its first blocks first, and consumed blocks are
+ * not needed again by their reader. Hence, a large scan does not evict the
+ * reusable blocks, similar to the A1 queue of 2Q.
+ */
+class UnpinnedBlockSet
+{
+public:
+    //! insert an unpinned block into the list according to its hint
+    void put(ByteBlock* block_ptr) {
+        if (block_ptr->eviction_hint() == EvictionHint::Reusable) {
+            lru_.put(block_ptr);
+        }
+        else {
+            scan_.push_back(block_ptr);
+            scan_index_.emplace(block_ptr, std::prev(scan_.end()));
+        }
+    }
+
+    //! check whether the block is in the set
+    bool exists(ByteBlock* block_ptr) const {
+        return lru_.exists(block_ptr) ||
+               scan_index_.find(block_ptr) != scan_index_.end();
+    }
+
+    //! remove the block from the set, it must exist
+    void erase(ByteBlock* block_ptr) {
+        auto it = scan_index_.find(block_ptr);
+        if (it == scan_index_.end()) {
+            lru_.erase(block_ptr);
+            return;
+        }
+        scan_.erase(it->second);
+        scan_index_.erase(it);
+    }
+
+    //! remove and return the next victim for eviction
+    ByteBlock * pop() {
+        if (scan_.empty())
+            return lru_.pop();
+
+        ByteBlock* block_ptr = scan_.back();
+        scan_.pop_back();
+        scan_index_.erase(block_ptr);
+        return block_ptr;
+    }
+
+    //! number of blocks in the set
+    size_t size() const { return lru_.size() + scan_.size(); }
+
+    //! number of blocks in the scan list
+    size_t scan_size() const { return scan_.size(); }
+
+private:
+    using ScanList = std::list<ByteBlock*, mem::GPoolAllocator<ByteBlock*> >;
+
+    //! reusable blocks in LRU order
+    tlx::LruCacheSet<ByteBlock*, mem::GPoolAllocator<ByteBlock*> > lru_;
+
+    //! blocks passed by scans, the most recent one at the back
+    ScanList scan_;
+
+    //! index of blocks in scan_
+    std::unordered_map<
+        ByteBlock*, ScanList::iterator,
+        std::hash<ByteBlock*>, std::equal_to<>,
+        mem::GPoolAllocator<
+            std::pair<ByteBlock* const, ScanList::iterator> > > scan_index_;
+};
+
 class BlockPool::Data
 {
 public:
@@ -256,9 +333,61 @@ public:
     //! print a message on the first block evicted to external memory
     bool notify_em_used_ = false;
 
+    //! codec compressing evicted blocks, or nullptr
+    std::unique_ptr<BlockCodec> codec_;
+
+    //! alignment of compressed blocks in external memory, for direct I/O.
+    static constexpr size_t kCompressAlignment = 4096;
+
+    //! total number of raw bytes of blocks evicted compressed
+    size_t compressed_raw_bytes_ = 0;
+
+    //! total number of bytes written of blocks evicted compressed
+    size_t compressed_bytes_ = 0;
+
+    //! budget of evicted blocks kept compressed in RAM instead of being
+    //! written to external memory, 0 disables this tier.
+    size_t compressed_ram_limit_ = 0;
+
+    //! number of bytes of the compressed blocks kept in RAM
+    Counter compressed_ram_bytes_;
+
+    //! set of ByteBlocks evicted compressed into RAM.
+    std::unordered_set<
+        ByteBlock*, std::hash<ByteBlock*>, std::equal_to<>,
+        mem::GPoolAllocator<ByteBlock*> > compressed_ram_;
+
+    //! set of ByteBlocks currently being compressed for eviction outside of
+    //! the lock, which pins and deletions must wait for.
+    std::unordered_set<
+        ByteBlock*, std::hash<ByteBlock*>, std::equal_to<>,
+        mem::GPoolAllocator<ByteBlock*> > compressing_;
+
+    //! signaled when a block is removed from compressing_
+    std::condition_variable cv_compressed_;
+
+    //! number of bytes of blocks mapped from files by MapMemoryBlock()
+    size_t mapped_bytes_ = 0;
+
+    //! place the memory of new ByteBlocks on the NUMA node of the allocating
+    //! worker thread
+    bool numa_local_ = false;
+
+    //! bytes of ByteBlocks allocated on each NUMA node
+    std::vector<size_t> numa_allocated_bytes_;
+
+    //! NUMA node each local worker last allocated on, -1 if none yet
+    std::vector<int> worker_numa_node_;
+
+    //! number of times a worker allocated on a different node than before,
+    //! i.e. its thread was migrated between sockets
+    size_t worker_numa_migrations_ = 0;
+
+    //! number of ByteBlock allocations which could not be bound to a node
+    size_t numa_bind_failures_ = 0;
+
     //! list of all blocks that are _in_memory_ but are _not_ pinned.
-    tlx::LruCacheSet<
-        ByteBlock*, mem::GPoolAllocator<ByteBlock*> > unpinned_blocks_;
+    UnpinnedBlockSet unpinned_blocks_;
 
     //! set of ByteBlocks currently begin written to EM.
     WritingMap writing_;
@@ -280,10 +409,21 @@ public:
     //! reference to io block manager
     foxxll::block_manager* bm_;
 
+    //! number of blocks evicted, which stripes consecutive blocks across the
+    //! disks round-robin.
+    size_t em_stripe_ = 0;
+
     //! Allocator for ByteBlocks such that they are aligned for faster
     //! I/O. Allocations are counted via mem_manager_.
     mem::AlignedAllocator<Byte, mem::Allocator<char> > aligned_alloc_;
 
+    //! memory manager of the BlockPool, counts arena slots in use
+    mem::Manager& mem_manager_;
+
+    //! optional arena of huge page backed slots, used for blocks of its slot
+    //! size, all other sizes are allocated by aligned_alloc_.
+    std::unique_ptr<mem::HugePageArena> arena_;
+
     //! next unique File id
     std::atomic<size_t> next_file_id_ { 0 };
 
@@ -305,6 +445,9 @@ public:
     //! number of bytes currently being read from to EM.
     Counter reading_bytes_;
 
+    //! total number of bytes written to and read back from EM
+    size_t spill_write_bytes_ = 0, spill_read_bytes_ = 0;
+
     //! total number of ByteBlocks allocated
     size_t total_byte_blocks_ = 0;
 
@@ -333,27 +476,80 @@ public:
           hard_ram_limit_(hard_ram_limit),
           bm_(foxxll::block_manager::get_instance()),
           aligned_alloc_(mem::Allocator<char>(block_pool.mem_manager_)),
+          mem_manager_(block_pool.mem_manager_),
           pin_count_(workers_per_host) { }
 
+    //! Allocate memory of a ByteBlock, from the arena if possible.
+    Byte * AllocateBlockData(size_t size) {
+        if (arena_ && size == arena_->slot_size()) {
+            if (Byte* data = static_cast<Byte*>(arena_->allocate())) {
+                mem_manager_.add(size);
+                return data;
+            }
+        }
+        return aligned_alloc_.allocate(size);
+    }
+
+    //! Deallocate memory of a ByteBlock allocated by AllocateBlockData().
+    void DeallocateBlockData(Byte* data, size_t size) {
+        if (arena_ && arena_->contains(data)) {
+            arena_->deallocate(data);
+            mem_manager_.subtract(size);
+            return;
+        }
+        aligned_alloc_.deallocate(data, size);
+    }
+
     //! Updates the memory manager for internal memory. If the hard limit is
     //! reached, the call is blocked intil memory is free'd
     void IntRequestInternalMemory(std::unique_lock<std::mutex>& lock, size_t size);
 
+    //! Count the NUMA placement of a ByteBlock allocated by a worker.
+    void IntCountNumaAllocation(size_t local_worker_id, size_t numa_node,
+                                bool numa_bound, size_t size);
+
     //! Updates the memory manager for the internal memory, wakes up waiting
     //! BlockPool::RequestInternalMemory calls
     void IntReleaseInternalMemory(size_t size);
 
+    //! Request size bytes for a buffer used while evicting a block, without
+    //! evicting further blocks or waiting, since eviction is run by
+    //! IntRequestInternalMemory(). Returns false if the buffer would exceed
+    //! the hard RAM limit.
+    bool IntTryRequestInternalMemory(size_t size);
+
     //! Unpins a block. If all pins are removed, the block might be swapped.
     //! Returns immediately. Actual unpinning is async.
     void IntUnpinBlock(
         BlockPool& bp, ByteBlock* block_ptr, size_t local_worker_id);
 
     //! Evict a block from the lru list into external memory
-    foxxll::request_ptr IntEvictBlockLRU();
+    foxxll::request_ptr IntEvictBlockLRU(std::unique_lock<std::mutex>& lock);
 
     //! Evict a block into external memory. The block must be unpinned and not
-    //! swapped.
-    foxxll::request_ptr IntEvictBlock(ByteBlock* block_ptr);
+    //! swapped. With a codec, the lock is released while compressing.
+    foxxll::request_ptr IntEvictBlock(
+        std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr);
+
+    //! Keep an evicted block compressed to csize bytes in em_buffer_ in RAM,
+    //! and release its uncompressed memory. The csize bytes must have been
+    //! requested.
+    foxxll::request_ptr IntKeepCompressed(ByteBlock* block_ptr, size_t csize);
+
+    //! Wait while a block is being compressed for eviction.
+    void IntWaitCompressing(
+        std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr) {
+        while (compressing_.count(block_ptr))
+            cv_compressed_.wait(lock);
+    }
+
+    //! Deallocate a ByteBlock's em_buffer_ of size bytes, whose memory is
+    //! counted in total_ram_bytes_ like the blocks.
+    void IntDeallocateBuffer(ByteBlock* block_ptr, size_t size) {
+        DeallocateBlockData(block_ptr->em_buffer_, size);
+        block_ptr->em_buffer_ = nullptr;
+        IntReleaseInternalMemory(size);
+    }
 
     //! \name Block Statistics
     //! \{
@@ -464,6 +660,7 @@ BlockPool::~BlockPool() {
     die_unequal(d_->total_ram_bytes_, 0u);
     die_unequal(d_->total_bytes_, 0u);
     die_unequal(d_->unpinned_blocks_.size(), 0u);
+    die_unequal(d_->compressed_ram_.size(), 0u);
 
     LOGC(debug_pin)
         << "~BlockPool()"
@@ -480,6 +677,34 @@ BlockPool::~BlockPool() {
         std::find(s_blockpools.begin(), s_blockpools.end(), this));
 }
 
+void BlockPool::set_codec(std::unique_ptr<BlockCodec> codec) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    d_->codec_ = std::move(codec);
+}
+
+void BlockPool::set_compressed_ram_limit(size_t limit) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    d_->compressed_ram_limit_ = limit;
+}
+
+void BlockPool::EnableHugePageArena(size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    assert(d_->int_total_blocks() == 0);
+    d_->arena_ = std::make_unique<mem::HugePageArena>(
+        default_block_size, size / default_block_size);
+    LOG1 << "BlockPool: huge page arena of " << d_->arena_->num_slots()
+         << " blocks of " << default_block_size << " bytes"
+         << (d_->arena_->hugetlb() ? " with explicit" : " with transparent")
+         << " huge pages";
+}
+
+void BlockPool::set_numa_local(bool numa_local) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    d_->numa_local_ = numa_local;
+    d_->numa_allocated_bytes_.resize(common::GetNumaNodeCount());
+    d_->worker_numa_node_.resize(workers_per_host_, -1);
+}
+
 PinnedByteBlockPtr
 BlockPool::AllocateByteBlock(size_t size, size_t local_worker_id) {
     assert(local_worker_id < workers_per_host_);
@@ -494,15 +719,31 @@ BlockPool::AllocateByteBlock(size_t size, size_t local_worker_id) {
     }
 
     d_->IntRequestInternalMemory(lock, size);
+    bool numa_local = d_->numa_local_;
 
     // allocate block memory. -- unlock mutex for that time, since it may
     // require block eviction.
     lock.unlock();
-    Byte* data = d_->aligned_alloc_.allocate(size);
+    Byte* data = d_->AllocateBlockData(size);
     LOGC(debug_alloc)
         << "ByteBlock aligned_alloc: " << (void*)data << " size " << size;
+
+    // the allocator may return memory first touched by a thread on another
+    // socket, hence move it to the node of this worker, which writes it.
+    size_t numa_node = 0;
+    bool numa_bound = false;
+    if (numa_local) {
+        numa_node = common::GetNumaNode();
+        numa_bound =
+            reinterpret_cast<uintptr_t>(data) % THRILL_DEFAULT_ALIGN == 0 &&
+            size % THRILL_DEFAULT_ALIGN == 0 &&
+            common::BindMemoryToNumaNode(data, size, numa_node);
+    }
     lock.lock();
 
+    if (numa_local)
+        d_->IntCountNumaAllocation(local_worker_id, numa_node, numa_bound, size);
+
     // create tlx::CountingPtr, no need for special make_shared()-equivalent
     PinnedByteBlockPtr block_ptr(
         mem::GPool().make<ByteBlock>(this, data, size), local_worker_id);
@@ -525,6 +766,28 @@ BlockPool::AllocateByteBlock(size_t size, size_t local_worker_id) {
     return block_ptr;
 }
 
+ByteBlockPtr BlockPool::MapMemoryBlock(
+    const MappedRegionPtr& mapping, size_t offset, size_t size) {
+    assert(offset + size <= mapping->size());
+    std::unique_lock<std::mutex> lock(mutex_);
+    // the mapped pages belong to the OS page cache, hence they are not
+    // requested from the internal memory limit.
+    ByteBlockPtr block_ptr(
+        mem::GPool().make<ByteBlock>(this, mapping, offset, size));
+    ++d_->total_byte_blocks_;
+    d_->total_bytes_ += size;
+    d_->max_total_bytes_ = std::max(d_->max_total_bytes_, d_->total_bytes_.value);
+    d_->mapped_bytes_ += size;
+
+    LOGC(debug_blc)
+        << "BlockPool::MapMemoryBlock()"
+        << " ptr=" << block_ptr.get()
+        << " offset=" << offset
+        << " size=" << size;
+
+    return block_ptr;
+}
+
 ByteBlockPtr BlockPool::MapExternalBlock(
     const foxxll::file_ptr& file, uint64_t offset, size_t size) {
     std::unique_lock<std::mutex> lock(mutex_);
@@ -551,6 +814,10 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
 
     ByteBlock* block_ptr = block.byte_block().get();
 
+    // readers set another hint after receiving the pin
+    if (block_ptr->total_pins_ == 0)
+        block_ptr->set_eviction_hint(EvictionHint::Reusable);
+
     if (block_ptr->pin_count_[local_worker_id] > 0) {
         // We may get a Block who's underlying is already pinned, since
         // PinnedBlock become Blocks when transfered between Files or delivered
@@ -588,6 +855,9 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
                                  this, PinnedBlock(block, local_worker_id)));
     }
 
+    // wait if the block is being compressed for eviction, it is written next.
+    d_->IntWaitCompressing(lock, block_ptr);
+
     // check that not writing the block.
     WritingMap::iterator write_it;
     while ((write_it = d_->writing_.find(block_ptr)) != d_->writing_.end()) {
@@ -635,10 +905,12 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
     {
         // unpinned block in memory, no need to load from EM.
 
-        // remove from unpinned list
-        die_unless(d_->unpinned_blocks_.exists(block_ptr));
-        d_->unpinned_blocks_.erase(block_ptr);
-        d_->unpinned_bytes_ -= block_ptr->size();
+        // remove from unpinned list, which never contains mapped blocks.
+        if (!block_ptr->is_mapped()) {
+            die_unless(d_->unpinned_blocks_.exists(block_ptr));
+            d_->unpinned_blocks_.erase(block_ptr);
+            d_->unpinned_bytes_ -= block_ptr->size();
+        }
 
         IntIncBlockPinCount(block_ptr, local_worker_id);
         d_->pin_count_.Increment(local_worker_id, block_ptr->size());
@@ -652,13 +924,18 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
                                  this, PinnedBlock(block, local_worker_id)));
     }
 
+    if (d_->compressed_ram_.count(block_ptr))
+        return IntPinCompressedBlock(lock, block, local_worker_id);
+
     // else need to initiate an async read to get the data.
 
     die_unless(block_ptr->em_bid_.storage);
 
     // maybe blocking call until memory is available, this also swaps out other
-    // blocks.
-    d_->IntRequestInternalMemory(lock, block_ptr->size());
+    // blocks. Compressed blocks also need a buffer to read into.
+    d_->IntRequestInternalMemory(
+        lock, block_ptr->size() +
+        (block_ptr->em_compressed_size_ != 0 ? block_ptr->em_bid_.size : 0));
 
     // the requested memory is already counted as a pin.
     d_->pin_count_.Increment(local_worker_id, block_ptr->size());
@@ -673,7 +950,13 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
     // allocate block memory.
     lock.unlock();
     Byte* data = read->byte_block()->data_ =
-        d_->aligned_alloc_.allocate(block_ptr->size());
+        d_->AllocateBlockData(block_ptr->size());
+    // compressed blocks are read into a temporary buffer
+    Byte* read_data = data;
+    if (block_ptr->em_compressed_size_ != 0) {
+        read_data = block_ptr->em_buffer_ =
+            d_->AllocateBlockData(block_ptr->em_bid_.size);
+    }
     lock.lock();
 
     if (!block_ptr->ext_file_) {
@@ -690,7 +973,7 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
     read->req_ =
         block_ptr->em_bid_.storage->aread(
             // parameters for the read
-            data, block_ptr->em_bid_.offset, block_ptr->size(),
+            read_data, block_ptr->em_bid_.offset, block_ptr->em_bid_.size,
             // construct an immediate CompletionHandler callback
             foxxll::completion_handler::make<
                 PinRequest, &PinRequest::OnComplete>(*read));
@@ -700,6 +983,57 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
     return read;
 }
 
+PinRequestPtr BlockPool::IntPinCompressedBlock(
+    std::unique_lock<std::mutex>& lock,
+    const Block& block, size_t local_worker_id) {
+
+    ByteBlock* block_ptr = block.byte_block().get();
+    size_t block_size = block_ptr->size();
+
+    // take the block out of the compressed tier and register the pin as a read,
+    // such that other threads pinning it meanwhile wait for the decompression.
+    d_->compressed_ram_.erase(block_ptr);
+    d_->compressed_ram_bytes_ -= block_ptr->em_compressed_size_;
+
+    PinRequestPtr read(
+        mem::GPool().make<PinRequest>(
+            this, PinnedBlock(block, local_worker_id), /* ready */ false));
+    d_->reading_[block_ptr] = read;
+
+    // maybe blocking call until memory is available, this also swaps out other
+    // blocks.
+    d_->IntRequestInternalMemory(lock, block_size);
+
+    // the requested memory is already counted as a pin.
+    d_->pin_count_.Increment(local_worker_id, block_size);
+
+    LOGC(debug_em)
+        << "BlockPool::PinBlock block=" << block
+        << " decompressed from internal memory"
+        << d_->pin_count_;
+
+    // allocate and decompress outside of the lock, the compressed buffer is
+    // owned by the read.
+    lock.unlock();
+    Byte* data = d_->AllocateBlockData(block_size);
+    die_unless(d_->codec_->Decompress(
+                   block_ptr->em_buffer_, block_ptr->em_compressed_size_,
+                   data, block_size));
+    lock.lock();
+
+    block_ptr->data_ = data;
+    d_->IntDeallocateBuffer(block_ptr, block_ptr->em_compressed_size_);
+    block_ptr->em_compressed_size_ = 0;
+
+    IntIncBlockPinCount(block_ptr, local_worker_id);
+
+    read->ready_ = true;
+    cv_read_complete_.notify_all();
+    d_->reading_.erase(block_ptr);
+
+    return read;
+}
+
 std::pair<size_t, size_t> BlockPool::MaxMergeDegreePrefetch(size_t num_files) {
     size_t avail_bytes = hard_ram_limit() / workers_per_host_ / 2;
     size_t avail_blocks = avail_bytes / default_block_size;
@@ -722,11 +1056,21 @@ void PinRequest::OnComplete(foxxll::request* req, bool success) {
 
 void BlockPool::OnReadComplete(
     PinRequest* read, foxxll::request* req, bool success) {
-    std::unique_lock<std::mutex> lock(mutex_);
-
     ByteBlock* block_ptr = read->block_.byte_block().get();
     size_t block_size = block_ptr->size();
 
+    // decompress outside of the lock, the block is still owned by the read.
+    if (success && block_ptr->em_compressed_size_ != 0) {
+        die_unless(d_->codec_->Decompress(
+                       block_ptr->em_buffer_, block_ptr->em_compressed_size_,
+                       block_ptr->data_, block_size));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (block_ptr->em_buffer_)
+        d_->IntDeallocateBuffer(block_ptr, block_ptr->em_bid_.size);
+
     LOGC(debug_em)
         << "OnReadComplete():"
         << " req " << req << " block " << *block_ptr
@@ -748,7 +1092,7 @@ void BlockPool::OnReadComplete(
         sLOGC(debug_alloc)
             << "ByteBlock  deallocate"
             << (void*)read->byte_block()->data_ << "size" << block_size;
-        d_->aligned_alloc_.deallocate(read->byte_block()->data_, block_size);
+        d_->DeallocateBlockData(read->byte_block()->data_, block_size);
 
         d_->IntReleaseInternalMemory(block_size);
 
@@ -764,8 +1108,10 @@ void BlockPool::OnReadComplete(
         IntIncBlockPinCount(block_ptr, read->block_.local_worker_id_);
 
         if (!block_ptr->ext_file_) {
+            d_->spill_read_bytes_ += block_size;
             d_->bm_->delete_block(block_ptr->em_bid_);
             block_ptr->em_bid_ = foxxll::BID<0>();
+            block_ptr->em_compressed_size_ = 0;
         }
     }
 
@@ -852,6 +1198,10 @@ void BlockPool::Data::IntUnpinBlock(
         return;
     }
 
+    // mapped blocks are never evicted, the OS pages them in and out.
+    if (block_ptr->is_mapped())
+        return;
+
     // if all per-thread pins are zero, allow this Block to be swapped out.
     die_unless(!unpinned_blocks_.exists(block_ptr));
     unpinned_blocks_.put(block_ptr);
@@ -931,6 +1281,26 @@ size_t BlockPool::swapped_blocks() noexcept {
     return d_->swapped_.size();
 }
 
+size_t BlockPool::swapped_bytes() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->swapped_bytes_.value;
+}
+
+size_t BlockPool::total_spill_write_bytes() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->spill_write_bytes_;
+}
+
+size_t BlockPool::total_spill_read_bytes() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->spill_read_bytes_;
+}
+
+size_t BlockPool::total_ram_bytes() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->total_ram_bytes_.value;
+}
+
 size_t BlockPool::reading_blocks() noexcept {
     std::unique_lock<std::mutex> lock(mutex_);
     return d_->reading_.size();
@@ -951,6 +1321,25 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
     // delete pin_count_ -> mark block as being deleted
     block_ptr->pin_count_.clear();
 
+    // wait if the block is being compressed for eviction
+    d_->IntWaitCompressing(lock, block_ptr);
+
+    if (block_ptr->is_mapped())
+    {
+        LOGC(debug_blc)
+            << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
+            << " mapped block, release mapping.";
+
+        block_ptr->data_ = nullptr;
+        block_ptr->mapping_.reset();
+        d_->mapped_bytes_ -= block_ptr->size();
+
+        --d_->total_byte_blocks_;
+        d_->total_bytes_ -= block_ptr->size();
+        d_->cv_total_byte_blocks_.notify_all();
+        return;
+    }
+
     do {
         if (block_ptr->in_memory())
         {
@@ -1025,7 +1414,7 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
         sLOGC(debug_alloc)
             << "ByteBlock deallocate"
             << (void*)block_ptr->data_ << "size" << block_ptr->size();
-        d_->aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        d_->DeallocateBlockData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         d_->IntReleaseInternalMemory(block_ptr->size());
@@ -1052,11 +1441,23 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
         sLOGC(debug_alloc)
             << "ByteBlock deallocate"
             << (void*)block_ptr->data_ << "size" << block_ptr->size();
-        d_->aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        d_->DeallocateBlockData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         d_->IntReleaseInternalMemory(block_ptr->size());
     }
+    else if (d_->compressed_ram_.count(block_ptr))
+    {
+        LOGC(debug_blc)
+            << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
+            << " block compressed in internal memory, release buffer";
+
+        d_->compressed_ram_.erase(block_ptr);
+        d_->compressed_ram_bytes_ -= block_ptr->em_compressed_size_;
+
+        d_->IntDeallocateBuffer(block_ptr, block_ptr->em_compressed_size_);
+        block_ptr->em_compressed_size_ = 0;
+    }
     else
     {
         LOGC(debug_blc)
@@ -1107,7 +1508,7 @@ void BlockPool::Data::IntRequestInternalMemory(
            total_ram_bytes_ + requested_bytes_ > soft_ram_limit_ + writing_bytes_)
     {
         // evict blocks: schedule async writing which increases writing_bytes_.
-        IntEvictBlockLRU();
+        IntEvictBlockLRU(lock);
     }
 
     // wait up to 60 seconds for other threads to free up memory or pins
@@ -1123,7 +1524,7 @@ void BlockPool::Data::IntRequestInternalMemory(
                total_ram_bytes_ + requested_bytes_ > hard_ram_limit_ + writing_bytes_)
         {
             // evict blocks: schedule async writing which increases writing_bytes_.
-            IntEvictBlockLRU();
+            IntEvictBlockLRU(lock);
         }
 
         cv_memory_change_.wait_for(lock, std::chrono::seconds(1));
@@ -1186,7 +1587,7 @@ void BlockPool::AdviseFree(size_t size) {
            d_->total_ram_bytes_ + d_->requested_bytes_ + size > d_->hard_ram_limit_ + d_->writing_bytes_)
     {
         // evict blocks: schedule async writing which increases writing_bytes_.
-        d_->IntEvictBlockLRU();
+        d_->IntEvictBlockLRU(lock);
     }
 }
 void BlockPool::ReleaseInternalMemory(size_t size) {
@@ -1207,6 +1608,14 @@ void BlockPool::Data::IntReleaseInternalMemory(size_t size) {
     cv_memory_change_.notify_all();
 }
 
+bool BlockPool::Data::IntTryRequestInternalMemory(size_t size) {
+    if (hard_ram_limit_ != 0 && total_ram_bytes_ + size > hard_ram_limit_)
+        return false;
+
+    total_ram_bytes_ += size;
+    return true;
+}
+
 void BlockPool::EvictBlock(ByteBlock* block_ptr) {
     std::unique_lock<std::mutex> lock(mutex_);
 
@@ -1216,7 +1625,7 @@ void BlockPool::EvictBlock(ByteBlock* block_ptr) {
     d_->unpinned_blocks_.erase(block_ptr);
     d_->unpinned_bytes_ -= block_ptr->size();
 
-    d_->IntEvictBlock(block_ptr);
+    d_->IntEvictBlock(lock, block_ptr);
 }
 
 foxxll::request_ptr BlockPool::GetAnyWriting() {
@@ -1227,10 +1636,11 @@ foxxll::request_ptr BlockPool::GetAnyWriting() {
 
 foxxll::request_ptr BlockPool::EvictBlockLRU() {
     std::unique_lock<std::mutex> lock(mutex_);
-    return d_->IntEvictBlockLRU();
+    return d_->IntEvictBlockLRU(lock);
 }
 
-foxxll::request_ptr BlockPool::Data::IntEvictBlockLRU() {
+foxxll::request_ptr BlockPool::Data::IntEvictBlockLRU(
+    std::unique_lock<std::mutex>& lock) {
 
     if (!unpinned_blocks_.size()) return foxxll::request_ptr();
 
@@ -1238,10 +1648,11 @@ foxxll::request_ptr BlockPool::Data::IntEvictBlockLRU() {
     die_unless(block_ptr);
     unpinned_bytes_ -= block_ptr->size();
 
-    return IntEvictBlock(block_ptr);
+    return IntEvictBlock(lock, block_ptr);
 }
 
-foxxll::request_ptr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
+foxxll::request_ptr BlockPool::Data::IntEvictBlock(
+    std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr) {
 
     // die_unless(block_ptr->block_pool_ == this);
 
@@ -1256,13 +1667,62 @@ foxxll::request_ptr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
         sLOGC(debug_alloc)
             << "ByteBlock deallocate"
             << (void*)block_ptr->data_ << "size" << block_ptr->size();
-        aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        DeallocateBlockData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         IntReleaseInternalMemory(block_ptr->size());
         return foxxll::request_ptr();
     }
 
+    die_unless(block_ptr->em_bid_.storage == nullptr);
+
+    // compress the block into a temporary buffer if a codec is set, and store
+    // it compressed if this saves at least one alignment unit.
+    Byte* write_data = block_ptr->data_;
+    size_t write_size = block_ptr->size();
+
+    // the block is written uncompressed if there is no RAM for the
+    // temporary buffer.
+    if (codec_ && IntTryRequestInternalMemory(block_ptr->size())) {
+        // compress outside of the lock: the block is neither unpinned nor
+        // being written meanwhile, hence pins and deletions wait for it, and
+        // its bytes count as being written.
+        compressing_.insert(block_ptr);
+        writing_bytes_ += block_ptr->size();
+
+        lock.unlock();
+        Byte* buffer = AllocateBlockData(block_ptr->size());
+        size_t csize = codec_->Compress(
+            block_ptr->data_, block_ptr->size(), buffer, block_ptr->size());
+        lock.lock();
+
+        block_ptr->em_buffer_ = buffer;
+        compressing_.erase(block_ptr);
+        writing_bytes_ -= block_ptr->size();
+        cv_compressed_.notify_all();
+
+        size_t asize = (csize + kCompressAlignment - 1)
+                       / kCompressAlignment * kCompressAlignment;
+
+        if (csize != 0 && asize < block_ptr->size() &&
+            compressed_ram_bytes_ + csize <= compressed_ram_limit_ &&
+            IntTryRequestInternalMemory(csize)) {
+            // keep the block compressed in RAM while the tier and the RAM
+            // limit have room.
+            return IntKeepCompressed(block_ptr, csize);
+        }
+        else if (csize != 0 && asize < block_ptr->size()) {
+            block_ptr->em_compressed_size_ = csize;
+            write_data = block_ptr->em_buffer_;
+            write_size = asize;
+            compressed_raw_bytes_ += block_ptr->size();
+            compressed_bytes_ += asize;
+        }
+        else {
+            IntDeallocateBuffer(block_ptr, block_ptr->size());
+        }
+    }
+
     if (!notify_em_used_) {
         std::cerr << "Thrill: evicting first Block to external memory. "
             "Be aware, that unexpected" << std::endl;
@@ -1271,11 +1731,9 @@ foxxll::request_ptr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
         notify_em_used_ = true;
     }
 
-    die_unless(block_ptr->em_bid_.storage == nullptr);
-
     // allocate EM block
-    block_ptr->em_bid_.size = block_ptr->size();
-    bm_->new_block(foxxll::fully_random(), block_ptr->em_bid_);
+    block_ptr->em_bid_.size = write_size;
+    bm_->new_block(foxxll::striping(), block_ptr->em_bid_, em_stripe_++);
 
     LOGC(debug_em)
         << "EvictBlock(): " << block_ptr << " - " << *block_ptr
@@ -1286,7 +1744,7 @@ foxxll::request_ptr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
     // initiate writing to EM.
     foxxll::request_ptr req =
         block_ptr->em_bid_.storage->awrite(
-            block_ptr->data_, block_ptr->em_bid_.offset, block_ptr->size(),
+            write_data, block_ptr->em_bid_.offset, write_size,
             // construct an immediate CompletionHandler callback
             foxxll::completion_handler::make<
                 ByteBlock, &ByteBlock::OnWriteComplete>(block_ptr));
@@ -1294,6 +1752,35 @@ foxxll::request_ptr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
     return (writing_[block_ptr] = std::move(req));
 }
 
+foxxll::request_ptr BlockPool::Data::IntKeepCompressed(
+    ByteBlock* block_ptr, size_t csize) {
+
+    LOGC(debug_em)
+        << "EvictBlock(): " << block_ptr << " - " << *block_ptr
+        << " compressed to " << csize << " bytes in internal memory";
+
+    // copy the compressed data into a buffer of its size, which was already
+    // requested.
+    Byte* buffer = AllocateBlockData(csize);
+    std::copy(block_ptr->em_buffer_, block_ptr->em_buffer_ + csize, buffer);
+    IntDeallocateBuffer(block_ptr, block_ptr->size());
+    block_ptr->em_buffer_ = buffer;
+    block_ptr->em_compressed_size_ = csize;
+
+    compressed_ram_.insert(block_ptr);
+    compressed_ram_bytes_ += csize;
+
+    // release memory
+    sLOGC(debug_alloc)
+        << "ByteBlock deallocate"
+        << (void*)block_ptr->data_ << "size" << block_ptr->size();
+    DeallocateBlockData(block_ptr->data_, block_ptr->size());
+    block_ptr->data_ = nullptr;
+
+    IntReleaseInternalMemory(block_ptr->size());
+    return foxxll::request_ptr();
+}
+
 void BlockPool::OnWriteComplete(
     ByteBlock* block_ptr, foxxll::request* req, bool success) {
     std::unique_lock<std::mutex> lock(mutex_);
@@ -1308,6 +1795,9 @@ void BlockPool::OnWriteComplete(
     die_unequal(d_->writing_.erase(block_ptr), 1u);
     d_->writing_bytes_ -= block_ptr->size();
 
+    if (block_ptr->em_buffer_)
+        d_->IntDeallocateBuffer(block_ptr, block_ptr->size());
+
     if (!success)
     {
         // request was canceled. this is not an I/O error, but intentional,
@@ -1322,6 +1812,7 @@ void BlockPool::OnWriteComplete(
 
         d_->bm_->delete_block(block_ptr->em_bid_);
         block_ptr->em_bid_ = foxxll::BID<0>();
+        block_ptr->em_compressed_size_ = 0;
     }
     else
     {
@@ -1329,18 +1820,40 @@ void BlockPool::OnWriteComplete(
 
         d_->swapped_.insert(block_ptr);
         d_->swapped_bytes_ += block_ptr->size();
+        d_->spill_write_bytes_ += block_ptr->size();
 
         // release memory
         sLOGC(debug_alloc)
             << "ByteBlock deallocate"
             << (void*)block_ptr->data_ << "size" << block_ptr->size();
-        d_->aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        d_->DeallocateBlockData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         d_->IntReleaseInternalMemory(block_ptr->size());
     }
 }
 
+void BlockPool::Data::IntCountNumaAllocation(
+    size_t local_worker_id, size_t numa_node, bool numa_bound, size_t size) {
+    if (!numa_bound) {
+        ++numa_bind_failures_;
+        return;
+    }
+    if (numa_node >= numa_allocated_bytes_.size())
+        numa_allocated_bytes_.resize(numa_node + 1);
+    numa_allocated_bytes_[numa_node] += size;
+
+    int& worker_node = worker_numa_node_[local_worker_id];
+    if (worker_node >= 0 && worker_node != static_cast<int>(numa_node)) {
+        LOGC(debug_blc)
+            << "BlockPool: worker " << local_worker_id
+            << " migrated from NUMA node " << worker_node
+            << " to " << numa_node;
+        ++worker_numa_migrations_;
+    }
+    worker_node = static_cast<int>(numa_node);
+}
+
 void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
     std::unique_lock<std::mutex> lock(mutex_);
 
@@ -1373,6 +1886,7 @@ void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
             << "pinned_blocks" << d_->pin_count_.total_pins_
             << "pinned_bytes" << pinned_bytes
             << "unpinned_blocks" << d_->unpinned_blocks_.size()
+            << "unpinned_scan_blocks" << d_->unpinned_blocks_.scan_size()
             << "unpinned_bytes" << unpinned_bytes
             << "swapped_blocks" << d_->swapped_.size()
             << "swapped_bytes" << d_->swapped_bytes_.hmax_update()
@@ -1392,7 +1906,59 @@ void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
             << "wr_ops" << stp.get_write_count()
             << "wr_bytes" << stp.get_write_bytes()
             << "wr_speed" << static_cast<double>(stp.get_write_bytes()) / elapsed
-            << "disk_allocation" << d_->bm_->current_allocation();
+            << "disk_allocation" << d_->bm_->current_allocation()
+            << "compressed_raw_bytes" << d_->compressed_raw_bytes_
+            << "compressed_bytes" << d_->compressed_bytes_
+            << "compressed_ram_blocks" << d_->compressed_ram_.size()
+            << "compressed_ram_bytes" << d_->compressed_ram_bytes_.hmax_update()
+            << "mapped_bytes" << d_->mapped_bytes_;
+
+    if (metrics_) {
+        metrics_->Set("thrill_block_pool_total_bytes",
+                      static_cast<double>(d_->int_total_bytes()));
+        metrics_->Set("thrill_block_pool_ram_bytes", static_cast<double>(
+                          unpinned_bytes + pinned_bytes +
+                          writing_bytes + reading_bytes));
+        metrics_->Set("thrill_block_pool_pinned_blocks",
+                      static_cast<double>(d_->pin_count_.total_pins_));
+        metrics_->Set("thrill_block_pool_swapped_blocks",
+                      static_cast<double>(d_->swapped_.size()));
+        metrics_->Set("thrill_block_pool_swapped_bytes",
+                      static_cast<double>(d_->swapped_bytes_.value));
+        metrics_->Set("thrill_block_pool_writing_blocks",
+                      static_cast<double>(d_->writing_.size()));
+        metrics_->Set("thrill_block_pool_reading_blocks",
+                      static_cast<double>(d_->reading_.size()));
+        metrics_->Set("thrill_io_ops_total{op=\"read\"}",
+                      static_cast<double>(stf.get_read_count()));
+        metrics_->Set("thrill_io_ops_total{op=\"write\"}",
+                      static_cast<double>(stf.get_write_count()));
+        metrics_->Set("thrill_io_bytes_total{op=\"read\"}",
+                      static_cast<double>(stf.get_read_bytes()));
+        metrics_->Set("thrill_io_bytes_total{op=\"write\"}",
+                      static_cast<double>(stf.get_write_bytes()));
+        metrics_->Set("thrill_io_speed{op=\"read\"}",
+                      static_cast<double>(stp.get_read_bytes()) / elapsed);
+        metrics_->Set("thrill_io_speed{op=\"write\"}",
+                      static_cast<double>(stp.get_write_bytes()) / elapsed);
+    }
+
+    if (d_->arena_) {
+        logger_ << "class" << "BlockPool"
+                << "event" << "arena"
+                << "arena_slots" << d_->arena_->num_slots()
+                << "arena_free_slots" << d_->arena_->free_slots()
+                << "arena_hugetlb" << d_->arena_->hugetlb();
+    }
+
+    if (d_->numa_local_) {
+        logger_ << "class" << "BlockPool"
+                << "event" << "numa"
+                << "numa_allocated_bytes" << d_->numa_allocated_bytes_
+                << "worker_numa_nodes" << d_->worker_numa_node_
+                << "worker_numa_migrations" << d_->worker_numa_migrations_
+                << "numa_bind_failures" << d_->numa_bind_failures_;
+    }
 }
 
 size_t BlockPool::next_file_id() {
@@ -13,9 +13,12 @@
 #define THRILL_DATA_BLOCK_POOL_HEADER
 
 #include <thrill/common/json_logger.hpp>
+#include <thrill/common/metrics_server.hpp>
 #include <thrill/common/profile_task.hpp>
 #include <thrill/data/block.hpp>
+#include <thrill/data/block_codec.hpp>
 #include <thrill/data/byte_block.hpp>
+#include <thrill/data/mapped_region.hpp>
 #include <thrill/mem/manager.hpp>
 
 #include <foxxll/io/request.hpp>
@@ -78,6 +81,37 @@ public:
     //! Checks that all blocks were freed
     ~BlockPool();
 
+    //! Set the codec compressing blocks evicted to external memory, nullptr
+    //! for none. Must be called before any block is evicted.
+    void set_codec(std::unique_ptr<BlockCodec> codec);
+
+    //! Keep blocks evicted with the codec compressed in RAM, up to limit bytes
+    //! of compressed data, before writing further ones to external memory. The
+    //! blocks are decompressed when pinned. Zero disables this tier. The
+    //! compressed blocks count towards the BlockPool's RAM.
+    void set_compressed_ram_limit(size_t limit);
+
+    //! Allocate ByteBlocks of the default block size from an arena of size
+    //! bytes of huge page backed memory, which recycles freed blocks without
+    //! system calls. Must be called before any block is allocated.
+    void EnableHugePageArena(size_t size);
+
+    //! Place the memory of ByteBlocks allocated by a worker on the NUMA node
+    //! the worker thread runs on, and report placements in the profile.
+    void set_numa_local(bool numa_local);
+
+    //! Let ReadBinary() map local files into memory and view them zero-copy
+    //! with MapMemoryBlock(), instead of reading them via MapExternalBlock().
+    void set_map_files(bool map_files) {
+        map_files_ = map_files && MappedRegion::supported();
+    }
+
+    //! whether ReadBinary() maps local files into memory
+    bool map_files() const { return map_files_; }
+
+    //! Publish the counters of the profile also to a live metrics server.
+    void set_metrics(common::MetricsServer* metrics) { metrics_ = metrics; }
+
     //! return number of workers per host
     size_t workers_per_host() const { return workers_per_host_; }
 
@@ -117,6 +151,12 @@ public:
     ByteBlockPtr MapExternalBlock(
         const foxxll::file_ptr& file, uint64_t offset, size_t size);
 
+    //! Create a byte block viewing [offset, offset + size) of a memory mapped
+    //! file region without copying. The block is not counted against the RAM
+    //! limits and never evicted, since the OS page cache manages its pages.
+    ByteBlockPtr MapMemoryBlock(
+        const MappedRegionPtr& mapping, size_t offset, size_t size);
+
     //! Increment a ByteBlock's pin count, requires the pin count to be > 0.
     void IncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id);
 
@@ -157,6 +197,18 @@ public:
     //! Total number of swapped blocks
     size_t swapped_blocks() noexcept;
 
+    //! Total number of bytes of swapped blocks
+    size_t swapped_bytes() noexcept;
+
+    //! Total number of bytes in internal memory counted against the limits
+    size_t total_ram_bytes() noexcept;
+
+    //! Total number of bytes of blocks written to external memory so far
+    size_t total_spill_write_bytes() noexcept;
+
+    //! Total number of bytes of blocks read back from external memory so far
+    size_t total_spill_read_bytes() noexcept;
+
     //! Total number of blocks currently begin read from EM.
     size_t reading_blocks() noexcept;
 
@@ -193,6 +245,12 @@ private:
     //! number of workers per host
     size_t workers_per_host_;
 
+    //! whether ReadBinary() maps local files into memory
+    bool map_files_ = false;
+
+    //! live metrics server or nullptr
+    common::MetricsServer* metrics_ = nullptr;
+
     //! a counter pair where one value is held as the max until written to stats
     struct Counter;
 
@@ -208,6 +266,11 @@ private:
     //! Increment a ByteBlock's pin count - without locking the mutex
     void IntIncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id);
 
+    //! Pins a block kept compressed in RAM by decompressing it.
+    PinRequestPtr IntPinCompressedBlock(
+        std::unique_lock<std::mutex>& lock,
+        const Block& block, size_t local_worker_id);
+
     //! callback for async write of blocks during eviction
     void OnWriteComplete(ByteBlock* block_ptr, foxxll::request* req, bool success);
 
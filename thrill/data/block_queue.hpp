@@ -15,7 +15,9 @@
 
 #include <thrill/common/atomic_movable.hpp>
 #include <thrill/common/concurrent_bounded_queue.hpp>
+#include <thrill/common/deferred_work.hpp>
 #include <thrill/common/stats_timer.hpp>
+#include <thrill/common/wait_stats.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_reader.hpp>
 #include <thrill/data/block_writer.hpp>
@@ -92,7 +94,13 @@ public:
     Block Pop() {
         if (read_closed_) return Block();
         Block b;
-        queue_.pop(b);
+        // run deferred work of the worker while no Block is available
+        while (!queue_.try_pop(b)) {
+            if (common::DeferredWork::RunOne()) continue;
+            common::NetWaitTimer wait_timer;
+            queue_.pop(b);
+            break;
+        }
         read_closed_ = !b.IsValid();
         return b;
     }
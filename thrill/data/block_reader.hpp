@@ -24,6 +24,7 @@
 
 #include <algorithm>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -113,6 +114,30 @@ public:
         return Serialization<BlockReader, T>::Deserialize(*this);
     }
 
+    /*!
+     * Returns a pointer to up to n consecutive POD items T inside the current
+     * block, without copying them, and advances the item cursor past them. The
+     * pointer remains valid until the reader moves to the next block. Returns
+     * zero items at the end, and if the next item spans a block boundary or
+     * self verification is enabled: then the next item must be read with
+     * Next() if HasNext() is true.
+     */
+    template <typename T>
+    std::pair<const T*, size_t> NextSpan(size_t n) {
+        static_assert(std::is_pod<T>::value,
+                      "NextSpan() can only return POD items.");
+
+        if ((self_verify && typecode_verify_) || !HasNext())
+            return std::pair<const T*, size_t>(nullptr, 0);
+
+        size_t k = std::min(std::min(n, num_items_),
+                            static_cast<size_t>(end_ - current_) / sizeof(T));
+        const T* span = reinterpret_cast<const T*>(current_);
+        current_ += k * sizeof(T);
+        num_items_ -= k;
+        return std::make_pair(span, k);
+    }
+
     //! HasNext() returns true if at least one more item is available.
     TLX_ATTRIBUTE_ALWAYS_INLINE
     bool HasNext() {
@@ -15,6 +15,8 @@
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_pool.hpp>
 
+#include <vector>
+
 namespace thrill {
 namespace data {
 
@@ -90,6 +92,15 @@ public:
         return AppendBlock(std::move(b).MoveToBlock(), is_last_block);
     }
 
+    //! Appends a sequence of (unpinned) Blocks, the last of which is marked as
+    //! is_last_block.
+    virtual void AppendBlocks(const std::vector<Block>& blocks) {
+        for (std::vector<Block>::const_iterator bi = blocks.begin();
+             bi != blocks.end(); ++bi) {
+            AppendBlock(*bi, /* is_last_block */ bi + 1 == blocks.end());
+        }
+    }
+
     //! local worker id to associate pinned block with
     size_t local_worker_id() const { return local_worker_id_; }
 
@@ -18,9 +18,11 @@
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_sink.hpp>
 #include <thrill/data/serialization.hpp>
+#include <tlx/counting_ptr.hpp>
 #include <tlx/die.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
 #include <string>
 #include <vector>
@@ -41,6 +43,53 @@ public:
     FullException() : std::exception() { }
 };
 
+/*!
+ * A memory budget shared by a group of BlockWriters, e.g. the writers of one
+ * worker to all targets of a Stream. Each writer charges the size of the next
+ * block it will allocate, and doubles the block size only while the budget
+ * admits it. Hence, writers to heavy targets grow to large blocks, while those
+ * to sparse targets keep small blocks, and the total buffer memory of the group
+ * stays below the limit (plus one start block per writer).
+ */
+class BlockWriterBudget : public tlx::ReferenceCounter
+{
+public:
+    explicit BlockWriterBudget(size_t limit) : limit_(limit) { }
+
+    //! total number of bytes the writers may charge
+    size_t limit() const { return limit_; }
+
+    //! number of bytes currently charged
+    size_t used() const { return used_.load(std::memory_order_relaxed); }
+
+    //! charge size bytes regardless of the limit
+    void Charge(size_t size) { used_ += size; }
+
+    //! charge size bytes if they fit into the limit, returns false otherwise.
+    bool TryCharge(size_t size) {
+        size_t used = used_.load(std::memory_order_relaxed);
+        do {
+            if (used + size > limit_) return false;
+        } while (!used_.compare_exchange_weak(used, used + size));
+        return true;
+    }
+
+    //! return size bytes charged before
+    void Release(size_t size) {
+        assert(used_ >= size);
+        used_ -= size;
+    }
+
+private:
+    //! total number of bytes the writers may charge
+    size_t limit_;
+
+    //! number of bytes currently charged
+    std::atomic<size_t> used_ { 0 };
+};
+
+using BlockWriterBudgetPtr = tlx::CountingPtr<BlockWriterBudget>;
+
 /*!
  * BlockWriter contains a temporary Block object into which a) any serializable
  * item can be stored or b) any arbitrary integral data can be appended. It
@@ -67,6 +116,15 @@ public:
         assert(max_block_size_ > 0);
     }
 
+    //! Start build (appending blocks) to a sink, growing the block size up to
+    //! max_block_size while the shared budget admits it.
+    BlockWriter(BlockSink&& sink, size_t max_block_size,
+                const BlockWriterBudgetPtr& budget)
+        : BlockWriter(std::move(sink), max_block_size) {
+        budget_ = budget;
+        if (budget_) budget_->Charge(block_size_);
+    }
+
     //! default constructor
     BlockWriter() = default;
 
@@ -87,6 +145,7 @@ public:
           sink_queue_(std::move(bw.sink_queue_)),
           block_size_(std::move(bw.block_size_)),
           max_block_size_(std::move(bw.max_block_size_)),
+          budget_(std::move(bw.budget_)),
           closed_(std::move(bw.closed_)) {
         // set closed flag -> disables destructor
         bw.closed_ = true;
@@ -106,6 +165,7 @@ public:
         sink_queue_ = std::move(bw.sink_queue_);
         block_size_ = std::move(bw.block_size_);
         max_block_size_ = std::move(bw.max_block_size_);
+        budget_ = std::move(bw.budget_);
         closed_ = std::move(bw.closed_);
         // set closed flag -> disables destructor
         bw.closed_ = true;
@@ -123,6 +183,10 @@ public:
         closed_ = true;
         Flush();
         sink_.Close();
+        if (budget_) {
+            budget_->Release(block_size_);
+            budget_.reset();
+        }
     }
 
     //! Return whether an actual BlockSink is attached.
@@ -171,10 +235,7 @@ public:
     //! current one if need be).
     void AppendBlocks(const std::vector<Block>& blocks) {
         Flush();
-        for (std::vector<Block>::const_iterator bi = blocks.begin();
-             bi != blocks.end(); ++bi) {
-            sink_.AppendBlock(*bi, /* is_last_block */ bi + 1 == blocks.end());
-        }
+        sink_.AppendBlocks(blocks);
     }
 
     //! Directly write Blocks to the underlying BlockSink (after flushing the
@@ -229,6 +290,47 @@ public:
             return PutSafe<T, true>(x);
     }
 
+    /*!
+     * Put n POD items from an array, equivalent to n calls of Put(). Whole runs
+     * of items are copied up to the end of the current block at once, without
+     * the per-item checks, only items spanning a block boundary are put
+     * individually. Falls back to Put() for self verification and sinks whose
+     * allocation can fail.
+     */
+    template <typename T>
+    BlockWriter& PutItems(const T* items, size_t n) {
+        static_assert(std::is_pod<T>::value,
+                      "PutItems() can only copy POD items.");
+        assert(!closed_);
+
+        if (self_verify || BlockSink::allocate_can_fail_) {
+            for (size_t i = 0; i < n; ++i) Put<T>(items[i]);
+            return *this;
+        }
+
+        while (n != 0) {
+            if (TLX_UNLIKELY(current_ == end_))
+                Flush(), AllocateBlock();
+
+            size_t fit = std::min(n, (end_ - current_) / sizeof(T));
+            if (TLX_UNLIKELY(fit == 0)) {
+                // next item spans the block boundary
+                PutUnsafe<T>(*items++), --n;
+                continue;
+            }
+
+            if (nitems_ == 0)
+                first_offset_ = current_ - bytes_->begin();
+            nitems_ += fit;
+
+            const Byte* data = reinterpret_cast<const Byte*>(items);
+            std::copy(data, data + fit * sizeof(T), current_);
+            current_ += fit * sizeof(T);
+            items += fit, n -= fit;
+        }
+        return *this;
+    }
+
     //! appends a complete item, or fails safely with a FullException.
     template <typename T, bool NoSelfVerify = false>
     TLX_ATTRIBUTE_ALWAYS_INLINE
@@ -413,8 +515,9 @@ private:
             throw FullException();
         }
         sLOG << "AllocateBlock(): good, got" << bytes_.get();
-        // increase block size, up to max.
-        if (2 * block_size_ < max_block_size_)
+        // increase block size, up to max, and as far as the budget allows.
+        if (2 * block_size_ < max_block_size_ &&
+            (!budget_ || budget_->TryCharge(block_size_)))
             block_size_ *= 2;
 
         current_ = bytes_->begin();
@@ -455,6 +558,9 @@ private:
     //! size of data blocks to construct
     size_t max_block_size_;
 
+    //! budget shared with other writers, charged with block_size_, or nullptr
+    BlockWriterBudgetPtr budget_;
+
     //! Flag if Close was called explicitly
     bool closed_ = false;
 };
@@ -42,6 +42,15 @@ ByteBlock::ByteBlock(
       ext_file_(ext_file)
 { }
 
+ByteBlock::ByteBlock(
+    BlockPool* block_pool, const MappedRegionPtr& mapping,
+    size_t offset, size_t size)
+    : data_(mapping->data() + offset), size_(size),
+      block_pool_(block_pool),
+      pin_count_(block_pool_->workers_per_host()),
+      mapping_(mapping)
+{ }
+
 void ByteBlock::Deleter::operator () (ByteBlock* bb) const {
     sLOG << "ByteBlock[" << bb << "]::deleter()"
          << "pin_count_" << bb->pin_count_str();
@@ -82,7 +91,8 @@ std::ostream& operator << (std::ostream& os, const ByteBlock& b) {
        << " size_=" << b.size_
        << " block_pool_=" << b.block_pool_
        << " total_pins_=" << b.total_pins_
-       << " ext_file_=" << b.ext_file_;
+       << " ext_file_=" << b.ext_file_
+       << " mapped=" << b.is_mapped();
     return os << "]";
 }
 
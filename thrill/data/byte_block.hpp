@@ -12,12 +12,14 @@
 #ifndef THRILL_DATA_BYTE_BLOCK_HEADER
 #define THRILL_DATA_BYTE_BLOCK_HEADER
 
+#include <thrill/data/mapped_region.hpp>
 #include <thrill/mem/pool.hpp>
 
 #include <foxxll/io/file.hpp>
 #include <foxxll/mng/bid.hpp>
 #include <tlx/counting_ptr.hpp>
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -39,6 +41,18 @@ using Byte = uint8_t;
 // forward declarations.
 class BlockPool;
 
+//! Hints of readers about the future use of a ByteBlock, which the BlockPool
+//! uses to select blocks to evict.
+enum class EvictionHint : uint8_t {
+    //! the block may be accessed again at any time: evicted in LRU order.
+    Reusable,
+    //! the block was passed by a sequential scan, which will not return to it
+    //! before reading all following blocks.
+    Sequential,
+    //! the block was read by a consuming reader, which will not read it again.
+    ConsumeOnce
+};
+
 /*!
  * A ByteBlock is the basic storage units of containers like File, BlockQueue,
  * etc. It consists of a fixed number of bytes without any type and meta
@@ -86,6 +100,24 @@ public:
     //! Returns whether the ByteBlock is in an external file.
     bool has_ext_file() const { return ext_file_.get() != nullptr; }
 
+    //! Returns whether the ByteBlock's data is a read-only memory mapping of a
+    //! file, which is never evicted by the BlockPool.
+    bool is_mapped() const { return mapping_.get() != nullptr; }
+
+    //! external memory block, valid while the block is evicted
+    const foxxll::BID<0>& em_bid() const { return em_bid_; }
+
+    //! Returns the eviction hint of the last reader.
+    EvictionHint eviction_hint() const {
+        return eviction_hint_.load(std::memory_order_relaxed);
+    }
+
+    //! Set the eviction hint, used by File readers and the Multiplexer while the
+    //! block is pinned.
+    void set_eviction_hint(EvictionHint hint) {
+        eviction_hint_.store(hint, std::memory_order_relaxed);
+    }
+
     //! return current pin count
     size_t pin_count(size_t local_worker_id) const {
         return pin_count_[local_worker_id];
@@ -132,10 +164,26 @@ private:
     //! offset into the file, and (unfortunately) also the size.
     foxxll::BID<0> em_bid_;
 
+    //! size of the data in em_bid_ if it was compressed by the BlockPool's
+    //! BlockCodec, zero if stored raw.
+    size_t em_compressed_size_ = 0;
+
+    //! temporary buffer holding the compressed data while it is being written
+    //! to or read from external memory, or while the block is kept compressed
+    //! in RAM.
+    Byte* em_buffer_ = nullptr;
+
+    //! hint of the last reader for selecting blocks to evict
+    std::atomic<EvictionHint> eviction_hint_ { EvictionHint::Reusable };
+
     //! shared pointer to external file, if this is != nullptr then the Block
     //! was created for directly reading binary files.
     foxxll::file_ptr ext_file_;
 
+    //! memory mapping data_ points into, if the Block was mapped zero-copy from
+    //! a file.
+    MappedRegionPtr mapping_;
+
     // BlockPool is a friend to call ctor and to manipulate data_.
     friend class BlockPool;
     // Block is a friend to call {Increase,Reduce}PinCount()
@@ -162,6 +210,10 @@ private:
     ByteBlock(BlockPool* block_pool, const foxxll::file_ptr& ext_file,
               int64_t offset, size_t size);
 
+    //! Constructor to initialize ByteBlock as a view into a memory mapping.
+    ByteBlock(BlockPool* block_pool, const MappedRegionPtr& mapping,
+              size_t offset, size_t size);
+
     friend std::ostream& operator << (std::ostream& os, const ByteBlock& b);
 
     //! forwarded to block_pool_
@@ -94,6 +94,12 @@ CatStreamData::Writers CatStreamData::GetWriters() {
     if (block_size == 0 || block_size > default_block_size)
         block_size = default_block_size;
 
+    // the writers share a budget of block_size per target: writers to heavy
+    // targets grow their blocks up to default_block_size, while writers to
+    // sparse targets keep small blocks.
+    BlockWriterBudgetPtr budget =
+        tlx::make_counting<BlockWriterBudget>(block_size * num_workers());
+
     {
         std::unique_lock<std::mutex> lock(multiplexer_.mutex_);
         multiplexer_.active_streams_++;
@@ -107,6 +113,7 @@ CatStreamData::Writers CatStreamData::GetWriters() {
         << " hard_ram_limit=" << hard_ram_limit
         << " block_size_base=" << block_size_base
         << " block_size=" << block_size
+        << " budget=" << budget->limit()
         << " active_streams=" << multiplexer_.active_streams_
         << " max_active_streams=" << multiplexer_.max_active_streams_;
 
@@ -130,7 +137,7 @@ CatStreamData::Writers CatStreamData::GetWriters() {
                         id_,
                         my_host_rank(), local_worker_id_,
                         host, worker),
-                    block_size);
+                    default_block_size, budget);
             }
             else {
                 result.emplace_back(
@@ -142,7 +149,7 @@ CatStreamData::Writers CatStreamData::GetWriters() {
                         id_,
                         my_host_rank(), local_worker_id_,
                         host, worker),
-                    block_size);
+                    default_block_size, budget);
             }
         }
     }
@@ -190,6 +197,26 @@ CatStreamData::CatReader CatStreamData::GetReader(bool consume) {
     return GetCatReader(consume);
 }
 
+CatStreamData::ConsumeCatBlockSource
+CatStreamData::GetConsumeCatBlockSource() {
+    rx_timespan_.StartEventually();
+
+    // construct vector of BlockQueueSources to read from queues_.
+    std::vector<BlockQueueSource> result;
+    result.reserve(num_workers());
+
+    for (size_t worker = 0; worker < num_workers(); ++worker) {
+        assert(!queues_[worker].read_closed());
+        result.emplace_back(queues_[worker], local_worker_id_);
+    }
+
+    return ConsumeCatBlockSource(std::move(result));
+}
+
+CatStreamData::ConsumeCatReader CatStreamData::GetConsumeCatReader() {
+    return ConsumeCatBlockReader(GetConsumeCatBlockSource());
+}
+
 void CatStreamData::Close() {
     if (is_closed_) return;
     is_closed_ = true;
@@ -242,6 +269,7 @@ struct CatStreamData::SeqReordering {
 
 void CatStreamData::OnStreamBlock(size_t from, uint32_t seq, Block&& b) {
     assert(from < queues_.size());
+    std::unique_lock<std::mutex> lock = LockReceive();
     rx_timespan_.StartEventually();
 
     LOG << "OnCatStreamBlock"
@@ -358,6 +386,14 @@ CatStream::CatReader CatStream::GetReader(bool consume) {
     return ptr_->GetReader(consume);
 }
 
+CatStream::ConsumeCatBlockSource CatStream::GetConsumeCatBlockSource() {
+    return ptr_->GetConsumeCatBlockSource();
+}
+
+CatStream::ConsumeCatReader CatStream::GetConsumeCatReader() {
+    return ptr_->GetConsumeCatReader();
+}
+
 } // namespace data
 } // namespace thrill
 
@@ -63,8 +63,12 @@ public:
     using CatBlockSource = data::CatBlockSource<DynBlockSource>;
     using CatBlockReader = BlockReader<CatBlockSource>;
 
+    using ConsumeCatBlockSource = data::CatBlockSource<BlockQueueSource>;
+    using ConsumeCatBlockReader = BlockReader<ConsumeCatBlockSource>;
+
     using Reader = BlockQueueReader;
     using CatReader = CatBlockReader;
+    using ConsumeCatReader = ConsumeCatBlockReader;
 
     using Handle = CatStream;
 
@@ -109,6 +113,15 @@ public:
     //! Open a CatReader (function name matches a method in File and MixStream).
     CatReader GetReader(bool consume);
 
+    //! Gets a consuming CatBlockSource of the incoming queues, e.g. to forward
+    //! the received blocks. The queues must not have been read before.
+    ConsumeCatBlockSource GetConsumeCatBlockSource();
+
+    //! Creates a consuming CatReader, whose block sources are the queues
+    //! themselves and hence dispatched statically, unlike those of
+    //! GetCatReader(). The queues must not have been read before.
+    ConsumeCatReader GetConsumeCatReader();
+
     //! shuts the stream down.
     void Close() final;
 
@@ -159,6 +172,8 @@ public:
     using Reader = CatStreamData::Reader;
 
     using CatReader = CatStreamData::CatReader;
+    using ConsumeCatBlockSource = CatStreamData::ConsumeCatBlockSource;
+    using ConsumeCatReader = CatStreamData::ConsumeCatReader;
 
     explicit CatStream(const CatStreamDataPtr& ptr);
 
@@ -191,6 +206,15 @@ public:
     //! Open a CatReader (function name matches a method in File and MixStream).
     CatReader GetReader(bool consume);
 
+    //! Gets a consuming CatBlockSource of the incoming queues, e.g. to forward
+    //! the received blocks. The queues must not have been read before.
+    ConsumeCatBlockSource GetConsumeCatBlockSource();
+
+    //! Creates a consuming CatReader, whose block sources are the queues
+    //! themselves and hence dispatched statically. The queues must not have
+    //! been read before.
+    ConsumeCatReader GetConsumeCatReader();
+
 private:
     CatStreamDataPtr ptr_;
 };
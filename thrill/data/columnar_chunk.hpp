@@ -0,0 +1,181 @@
+/*******************************************************************************
+ * thrill/data/columnar_chunk.hpp
+ *
+ * Column-wise (structure of arrays) serialization of tuples of PODs.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_COLUMNAR_CHUNK_HEADER
+#define THRILL_DATA_COLUMNAR_CHUNK_HEADER
+
+#include <thrill/data/serialization.hpp>
+
+#include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+//! whether all Types are trivially copyable
+template <typename... Types>
+constexpr bool AllTriviallyCopyable() {
+    bool copyable[] = { std::is_trivially_copyable<Types>::value ... };
+    for (bool c : copyable) {
+        if (!c) return false;
+    }
+    return true;
+}
+
+/*!
+ * A chunk of tuples stored column-wise: each field of the tuples is held in a
+ * separate contiguous array. A ColumnarChunk is serialized as a single item,
+ * which contains the number of tuples followed by the raw array of each
+ * column. Hence, in a Block the fields are stored column by column, and a
+ * reader can access a single column as contiguous memory, e.g. for vectorized
+ * key extraction, while the homogeneous columns compress better with a
+ * BlockCodec than row-wise tuples.
+ *
+ * All fields must be trivially copyable. Writers collect tuples with
+ * push_back() and Put() the chunk when it is full, readers Next() the chunk
+ * and use column<I>() or operator [].
+ */
+template <typename... Types>
+class ColumnarChunk
+{
+    static_assert(sizeof ... (Types) > 0, "ColumnarChunk needs fields");
+    static_assert(AllTriviallyCopyable<Types...>(),
+                  "ColumnarChunk fields must be trivially copyable");
+
+public:
+    //! tuple type of the rows
+    using Tuple = std::tuple<Types...>;
+
+    //! type of column I
+    template <size_t I>
+    using ColumnType = typename std::tuple_element<I, Tuple>::type;
+
+    //! number of columns
+    static constexpr size_t num_columns = sizeof ... (Types);
+
+    //! number of tuples in the chunk
+    size_t size() const { return std::get<0>(columns_).size(); }
+
+    //! whether the chunk is empty
+    bool empty() const { return size() == 0; }
+
+    //! reserve space for n tuples in all columns
+    void reserve(size_t n) {
+        ForEachColumn([n](auto& column) { column.reserve(n); });
+    }
+
+    //! remove all tuples
+    void clear() {
+        ForEachColumn([](auto& column) { column.clear(); });
+    }
+
+    //! append a tuple, distributing its fields to the columns
+    void push_back(const Tuple& t) {
+        PushBack(t, std::index_sequence_for<Types...>());
+    }
+
+    //! reassemble tuple i from the columns
+    Tuple operator [] (size_t i) const {
+        assert(i < size());
+        return GetTuple(i, std::index_sequence_for<Types...>());
+    }
+
+    //! contiguous array of field I of all tuples
+    template <size_t I>
+    const std::vector<ColumnType<I> >& column() const {
+        return std::get<I>(columns_);
+    }
+
+    /**************************************************************************/
+
+    static constexpr bool thrill_is_fixed_size = false;
+    static constexpr size_t thrill_fixed_size = 0;
+
+    //! serialization with Thrill's serializer: the size, then each column raw.
+    template <typename Archive>
+    void ThrillSerialize(Archive& ar) const {
+        ar.PutVarint(size());
+        ForEachColumn(
+            [&ar](const auto& column) {
+                ar.Append(column.data(),
+                          column.size() * sizeof(column.front()));
+            });
+    }
+
+    //! deserialization with Thrill's serializer
+    template <typename Archive>
+    static ColumnarChunk ThrillDeserialize(Archive& ar) {
+        ColumnarChunk c;
+        size_t n = ar.GetVarint();
+        c.ForEachColumn(
+            [&ar, n](auto& column) {
+                column.resize(n);
+                ar.Read(column.data(), n * sizeof(column.front()));
+            });
+        return c;
+    }
+
+private:
+    //! the arrays of the fields
+    std::tuple<std::vector<Types>...> columns_;
+
+    //! call f for each column
+    template <typename Functor>
+    void ForEachColumn(const Functor& f) {
+        ForEachColumn(f, std::index_sequence_for<Types...>());
+    }
+
+    //! call f for each column
+    template <typename Functor>
+    void ForEachColumn(const Functor& f) const {
+        ForEachColumn(f, std::index_sequence_for<Types...>());
+    }
+
+    template <typename Functor, size_t... Is>
+    void ForEachColumn(const Functor& f, std::index_sequence<Is...>) {
+        int dummy[] = { (f(std::get<Is>(columns_)), 0) ... };
+        (void)dummy;
+    }
+
+    template <typename Functor, size_t... Is>
+    void ForEachColumn(const Functor& f, std::index_sequence<Is...>) const {
+        int dummy[] = { (f(std::get<Is>(columns_)), 0) ... };
+        (void)dummy;
+    }
+
+    template <size_t... Is>
+    void PushBack(const Tuple& t, std::index_sequence<Is...>) {
+        int dummy[] = {
+            (std::get<Is>(columns_).push_back(std::get<Is>(t)), 0) ...
+        };
+        (void)dummy;
+    }
+
+    template <size_t... Is>
+    Tuple GetTuple(size_t i, std::index_sequence<Is...>) const {
+        return Tuple(std::get<Is>(columns_)[i] ...);
+    }
+};
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_COLUMNAR_CHUNK_HEADER
+
+/******************************************************************************/
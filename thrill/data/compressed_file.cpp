@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * thrill/data/compressed_file.cpp
+ *
+ * A sequence of Blocks kept compressed by a BlockCodec, which are decompressed
+ * on the fly by its reader.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/data/compressed_file.hpp>
+
+#include <thrill/data/block_pool.hpp>
+
+#include <tlx/die.hpp>
+
+#include <cstring>
+
+namespace thrill {
+namespace data {
+
+/******************************************************************************/
+// CompressedFile
+
+CompressedFile::CompressedFile(
+    BlockPool& block_pool, size_t local_worker_id, const std::string& codec)
+    : BlockSink(block_pool, local_worker_id),
+      codec_(BlockCodec::Create(codec)) { }
+
+void CompressedFile::AppendBlock(const Block& b, bool is_last_block) {
+    if (b.size() == 0) return;
+    AppendPinnedBlock(b.PinWait(local_worker_id_), is_last_block);
+}
+
+void CompressedFile::AppendBlock(Block&& b, bool is_last_block) {
+    if (b.size() == 0) return;
+    AppendPinnedBlock(b.PinWait(local_worker_id_), is_last_block);
+}
+
+void CompressedFile::AppendPinnedBlock(
+    PinnedBlock&& b, bool /* is_last_block */) {
+    if (b.size() == 0) return;
+
+    num_items_ += b.num_items();
+    size_bytes_ += b.size();
+
+    size_t compressed_size = 0;
+    if (codec_) {
+        buffer_.resize(b.size());
+        compressed_size = codec_->Compress(
+            b.data_begin(), b.size(), buffer_.data(), buffer_.size());
+        if (compressed_size >= b.size()) compressed_size = 0;
+    }
+
+    if (compressed_size == 0) {
+        // keep the Block uncompressed
+        stored_bytes_ += b.size();
+        blocks_.emplace_back(
+            Entry { b.ToBlock(), 0, b.size(), b.first_item_relative(),
+                    b.num_items(), b.typecode_verify() });
+        return;
+    }
+
+    PinnedByteBlockPtr bytes =
+        block_pool()->AllocateByteBlock(compressed_size, local_worker_id_);
+    std::memcpy(bytes->data(), buffer_.data(), compressed_size);
+    stored_bytes_ += compressed_size;
+
+    blocks_.emplace_back(
+        Entry { PinnedBlock(std::move(bytes), 0, compressed_size, 0, 0,
+                            b.typecode_verify()).ToBlock(),
+                compressed_size, b.size(), b.first_item_relative(),
+                b.num_items(), b.typecode_verify() });
+}
+
+CompressedFile::Writer CompressedFile::GetWriter(size_t block_size) {
+    return Writer(CompressedFileBlockSink(this), block_size);
+}
+
+CompressedFile::Reader CompressedFile::GetReader() {
+    return Reader(CompressedFileBlockSource(*this, local_worker_id_));
+}
+
+void CompressedFile::Clear() {
+    std::vector<Entry>().swap(blocks_);
+    std::vector<Byte>().swap(buffer_);
+    num_items_ = size_bytes_ = stored_bytes_ = 0;
+}
+
+/******************************************************************************/
+// CompressedFileBlockSource
+
+PinnedBlock CompressedFileBlockSource::NextBlock() {
+    if (current_block_ >= file_.blocks_.size())
+        return PinnedBlock();
+
+    const CompressedFile::Entry& e = file_.blocks_[current_block_++];
+    PinnedBlock stored = e.block.PinWait(local_worker_id_);
+    if (e.compressed_size == 0)
+        return stored;
+
+    PinnedByteBlockPtr bytes =
+        file_.block_pool()->AllocateByteBlock(e.size, local_worker_id_);
+    die_unless(file_.codec_->Decompress(
+                   stored.data_begin(), e.compressed_size,
+                   bytes->data(), e.size));
+
+    return PinnedBlock(std::move(bytes), 0, e.size, e.first_item,
+                       e.num_items, e.typecode_verify);
+}
+
+Block CompressedFileBlockSource::NextBlockUnpinned() {
+    return NextBlock().ToBlock();
+}
+
+PinnedBlock CompressedFileBlockSource::AcquirePin(const Block& block) {
+    return block.PinWait(local_worker_id_);
+}
+
+} // namespace data
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,213 @@
+/*******************************************************************************
+ * thrill/data/compressed_file.hpp
+ *
+ * A sequence of Blocks kept compressed by a BlockCodec, which are decompressed
+ * on the fly by its reader.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_COMPRESSED_FILE_HEADER
+#define THRILL_DATA_COMPRESSED_FILE_HEADER
+
+#include <thrill/data/block.hpp>
+#include <thrill/data/block_codec.hpp>
+#include <thrill/data/block_reader.hpp>
+#include <thrill/data/block_sink.hpp>
+#include <thrill/data/block_writer.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+class CompressedFileBlockSink;
+class CompressedFileBlockSource;
+
+/*!
+ * A CompressedFile is an ordered sequence of Blocks like a File, but each Block
+ * appended by its Writer is compressed with a BlockCodec into a new, smaller
+ * ByteBlock right away, and the uncompressed one is released. The compressed
+ * ByteBlocks are managed by the BlockPool like all others, hence they may also
+ * be evicted. Its Reader decompresses one Block at a time.
+ *
+ * Blocks which the codec cannot shrink are kept uncompressed, as are all with
+ * the codec "none".
+ */
+class CompressedFile : public BlockSink
+{
+public:
+    using Writer = BlockWriter<CompressedFileBlockSink>;
+    using Reader = BlockReader<CompressedFileBlockSource>;
+
+    //! Constructor from BlockPool with a BlockCodec name, see
+    //! BlockCodec::Create().
+    CompressedFile(BlockPool& block_pool, size_t local_worker_id,
+                   const std::string& codec);
+
+    //! non-copyable: delete copy-constructor
+    CompressedFile(const CompressedFile&) = delete;
+    //! non-copyable: delete assignment operator
+    CompressedFile& operator = (const CompressedFile&) = delete;
+
+    //! \name Methods of a BlockSink
+    //! \{
+
+    void AppendBlock(const Block& b, bool is_last_block) final;
+
+    void AppendBlock(Block&& b, bool is_last_block) final;
+
+    //! compress the Block while it is still pinned by the BlockWriter.
+    void AppendPinnedBlock(PinnedBlock&& b, bool is_last_block) final;
+
+    void Close() final { }
+
+    static constexpr bool allocate_can_fail_ = false;
+
+    //! \}
+
+    //! Get BlockWriter.
+    Writer GetWriter(size_t block_size = default_block_size);
+
+    //! Get BlockReader, which keeps the Blocks.
+    Reader GetReader();
+
+    //! Free all Blocks.
+    void Clear();
+
+    //! Return the number of items.
+    size_t num_items() const { return num_items_; }
+
+    //! Return the number of bytes of the uncompressed Blocks.
+    size_t size_bytes() const { return size_bytes_; }
+
+    //! Return the number of bytes of the stored Blocks.
+    size_t stored_bytes() const { return stored_bytes_; }
+
+    //! Return whether the CompressedFile contains no items.
+    bool empty() const { return num_items_ == 0; }
+
+private:
+    //! a stored Block and the layout of the uncompressed Block
+    struct Entry {
+        //! compressed data in [0,compressed_size), or the uncompressed Block
+        Block block;
+        //! size of compressed data, zero if block is uncompressed
+        size_t compressed_size;
+        //! size of uncompressed data
+        size_t size;
+        //! offset of the first item in the uncompressed data
+        size_t first_item;
+        //! number of items starting in the Block
+        size_t num_items;
+        //! whether the items have typecodes
+        bool typecode_verify;
+    };
+
+    //! codec, nullptr for none
+    std::unique_ptr<BlockCodec> codec_;
+
+    //! stored Blocks
+    std::vector<Entry> blocks_;
+
+    //! buffer receiving compressed data
+    std::vector<Byte> buffer_;
+
+    //! total number of items
+    size_t num_items_ = 0;
+
+    //! total size of uncompressed Blocks
+    size_t size_bytes_ = 0;
+
+    //! total size of stored Blocks
+    size_t stored_bytes_ = 0;
+
+    //! for access to blocks_ and codec_
+    friend class CompressedFileBlockSource;
+};
+
+/*!
+ * BlockSink which interfaces to a CompressedFile
+ */
+class CompressedFileBlockSink final : public BlockSink
+{
+public:
+    CompressedFileBlockSink()
+        : BlockSink(nullptr, -1), file_(nullptr) { }
+
+    explicit CompressedFileBlockSink(CompressedFile* file)
+        : BlockSink(file->block_pool(), file->local_worker_id()),
+          file_(file) { }
+
+    void AppendBlock(const Block& b, bool is_last_block) final {
+        return file_->AppendBlock(b, is_last_block);
+    }
+
+    void AppendBlock(Block&& b, bool is_last_block) final {
+        return file_->AppendBlock(std::move(b), is_last_block);
+    }
+
+    void AppendPinnedBlock(PinnedBlock&& b, bool is_last_block) final {
+        return file_->AppendPinnedBlock(std::move(b), is_last_block);
+    }
+
+    void Close() final {
+        if (file_) file_->Close();
+    }
+
+    //! return whether a CompressedFile is attached
+    bool IsValid() const { return file_ != nullptr; }
+
+    static constexpr bool allocate_can_fail_ = false;
+
+private:
+    CompressedFile* file_;
+};
+
+/*!
+ * A BlockSource reading the Blocks of a CompressedFile, which are
+ * decompressed into new ByteBlocks one at a time.
+ */
+class CompressedFileBlockSource
+{
+public:
+    CompressedFileBlockSource(const CompressedFile& file,
+                              size_t local_worker_id)
+        : file_(file), local_worker_id_(local_worker_id) { }
+
+    //! Advance to the next Block, decompressed.
+    PinnedBlock NextBlock();
+
+    //! Get next Block unpinned, used by GetItemBatch.
+    Block NextBlockUnpinned();
+
+    //! Acquire Pin for Block returned from NextBlockUnpinned
+    PinnedBlock AcquirePin(const Block& block);
+
+private:
+    //! file to read Blocks from
+    const CompressedFile& file_;
+
+    //! local worker id reading the CompressedFile
+    size_t local_worker_id_;
+
+    //! index of next Block
+    size_t current_block_ = 0;
+};
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_COMPRESSED_FILE_HEADER
+
+/******************************************************************************/
@@ -10,6 +10,7 @@
 
 #include <thrill/data/file.hpp>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 
@@ -101,6 +102,50 @@ std::ostream& operator << (std::ostream& os, const File& f) {
     return os << "]]";
 }
 
+/******************************************************************************/
+// Adaptive Prefetch
+
+/*!
+ * Adapt the prefetch depth of a reader to its rate of consumption, called
+ * before the reader refills its prefetch queue, if the reader shares a
+ * PrefetchBudget with the other readers of a merge. If the next block is not
+ * loaded yet, the reader stalls on I/O and the depth is increased by one block,
+ * up to twice the requested depth, if the budget has the bytes. If the next two
+ * blocks are already loaded, the reader is slower than the disk and the depth
+ * is decreased by one block, down to half the requested depth, giving the bytes
+ * to the budget. Hence, in a merge of many Files the fast consumers receive
+ * deeper prefetch than the slow ones, while the total prefetch of all readers
+ * stays within the sum of the requested sizes.
+ */
+static void AdaptPrefetch(const std::deque<PinRequestPtr>& fetching_blocks,
+                          size_t requested_size, size_t* prefetch_size,
+                          PrefetchBudget* budget) {
+    if (!budget || fetching_blocks.empty()) return;
+
+    if (!fetching_blocks.front()->ready()) {
+        if (*prefetch_size + default_block_size <= 2 * requested_size &&
+            budget->Take(default_block_size))
+            *prefetch_size += default_block_size;
+    }
+    else if (fetching_blocks.size() >= 2 && fetching_blocks[1]->ready()) {
+        size_t min_size = std::max(requested_size / 2, size_t(1));
+        if (*prefetch_size > min_size) {
+            size_t delta =
+                std::min(*prefetch_size - min_size, default_block_size);
+            *prefetch_size -= delta;
+            budget->Give(delta);
+        }
+    }
+}
+
+//! Give the prefetch bytes of an exhausted reader to the shared budget.
+static void ReleasePrefetch(size_t* prefetch_size, PrefetchBudgetPtr* budget) {
+    if (!*budget) return;
+    (*budget)->Give(*prefetch_size);
+    *prefetch_size = 0;
+    budget->reset();
+}
+
 /******************************************************************************/
 // KeepFileBlockSource
 
@@ -109,7 +154,7 @@ KeepFileBlockSource::KeepFileBlockSource(
     size_t prefetch_size,
     size_t first_block, size_t first_item)
     : file_(file), local_worker_id_(local_worker_id),
-      prefetch_size_(prefetch_size),
+      prefetch_size_(prefetch_size), requested_prefetch_size_(prefetch_size),
       fetching_bytes_(0),
       first_block_(first_block), current_block_(first_block),
       first_item_(first_item)
@@ -129,6 +174,7 @@ Block KeepFileBlockSource::MakeNextBlock() {
 }
 
 void KeepFileBlockSource::Prefetch(size_t prefetch_size) {
+    requested_prefetch_size_ = prefetch_size;
     if (prefetch_size >= prefetch_size_) {
         prefetch_size_ = prefetch_size;
         // prefetch #desired bytes
@@ -147,16 +193,23 @@ void KeepFileBlockSource::Prefetch(size_t prefetch_size) {
 }
 
 PinnedBlock KeepFileBlockSource::NextBlock() {
-    if (current_block_ >= file_.num_blocks() && fetching_blocks_.empty())
+    if (current_block_ >= file_.num_blocks() && fetching_blocks_.empty()) {
+        ReleasePrefetch(&prefetch_size_, &budget_);
         return PinnedBlock();
+    }
 
     if (prefetch_size_ == 0)
     {
         // operate without prefetching
-        return MakeNextBlock().PinWait(local_worker_id_);
+        PinnedBlock b = MakeNextBlock().PinWait(local_worker_id_);
+        b.byte_block()->set_eviction_hint(EvictionHint::Sequential);
+        return b;
     }
     else
     {
+        AdaptPrefetch(fetching_blocks_, requested_prefetch_size_,
+                      &prefetch_size_, budget_.get());
+
         // prefetch #desired bytes
         while (fetching_bytes_ < prefetch_size_ &&
                current_block_ < file_.num_blocks())
@@ -170,6 +223,7 @@ PinnedBlock KeepFileBlockSource::NextBlock() {
         PinnedBlock b = fetching_blocks_.front()->Wait();
         fetching_bytes_ -= b.size();
         fetching_blocks_.pop_front();
+        b.byte_block()->set_eviction_hint(EvictionHint::Sequential);
         return b;
     }
 }
@@ -199,7 +253,7 @@ PinnedBlock KeepFileBlockSource::AcquirePin(const Block& block) {
 ConsumeFileBlockSource::ConsumeFileBlockSource(
     File* file, size_t local_worker_id, size_t prefetch_size)
     : file_(file), local_worker_id_(local_worker_id),
-      prefetch_size_(prefetch_size),
+      prefetch_size_(prefetch_size), requested_prefetch_size_(prefetch_size),
       fetching_bytes_(0) {
     Prefetch(prefetch_size_);
 }
@@ -207,12 +261,15 @@ ConsumeFileBlockSource::ConsumeFileBlockSource(
 ConsumeFileBlockSource::ConsumeFileBlockSource(ConsumeFileBlockSource&& s)
     : file_(s.file_), local_worker_id_(s.local_worker_id_),
       prefetch_size_(s.prefetch_size_),
+      requested_prefetch_size_(s.requested_prefetch_size_),
+      budget_(std::move(s.budget_)),
       fetching_blocks_(std::move(s.fetching_blocks_)),
       fetching_bytes_(s.fetching_bytes_) {
     s.file_ = nullptr;
 }
 
 void ConsumeFileBlockSource::Prefetch(size_t prefetch_size) {
+    requested_prefetch_size_ = prefetch_size;
     if (prefetch_size >= prefetch_size_) {
         prefetch_size_ = prefetch_size;
         // prefetch #desired bytes
@@ -231,16 +288,23 @@ void ConsumeFileBlockSource::Prefetch(size_t prefetch_size) {
 
 PinnedBlock ConsumeFileBlockSource::NextBlock() {
     assert(file_);
-    if (file_->blocks_.empty() && fetching_blocks_.empty())
+    if (file_->blocks_.empty() && fetching_blocks_.empty()) {
+        ReleasePrefetch(&prefetch_size_, &budget_);
         return PinnedBlock();
+    }
 
     // operate without prefetching
     if (prefetch_size_ == 0) {
         PinRequestPtr f = file_->blocks_.front().Pin(local_worker_id_);
         file_->blocks_.pop_front();
-        return f->Wait();
+        PinnedBlock b = f->Wait();
+        b.byte_block()->set_eviction_hint(EvictionHint::ConsumeOnce);
+        return b;
     }
 
+    AdaptPrefetch(fetching_blocks_, requested_prefetch_size_, &prefetch_size_,
+                  budget_.get());
+
     // prefetch #desired bytes
     while (fetching_bytes_ < prefetch_size_ && !file_->blocks_.empty()) {
         Block& b = file_->blocks_.front();
@@ -253,6 +317,7 @@ PinnedBlock ConsumeFileBlockSource::NextBlock() {
     PinnedBlock b = fetching_blocks_.front()->Wait();
     fetching_bytes_ -= b.size();
     fetching_blocks_.pop_front();
+    b.byte_block()->set_eviction_hint(EvictionHint::ConsumeOnce);
     return b;
 }
 
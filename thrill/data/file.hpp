@@ -19,14 +19,19 @@
 #include <thrill/data/block_sink.hpp>
 #include <thrill/data/block_writer.hpp>
 #include <thrill/data/dyn_block_reader.hpp>
+#include <thrill/net/buffer_reader.hpp>
 
 #include <tlx/die.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <deque>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace thrill {
@@ -39,6 +44,39 @@ class FileBlockSink;
 class KeepFileBlockSource;
 class ConsumeFileBlockSource;
 
+/*!
+ * Prefetch bytes shared by the readers of one merge, which StartPrefetch()
+ * attaches to them. A reader which decreases its prefetch depth gives the bytes
+ * to the budget, and a reader which increases it must take them from the
+ * budget. Hence the total prefetch of the readers never exceeds the sum of the
+ * requested prefetch sizes.
+ */
+class PrefetchBudget
+{
+public:
+    //! Take bytes from the budget, returns false if not available.
+    bool Take(size_t bytes) {
+        size_t free = free_.load(std::memory_order_relaxed);
+        while (free >= bytes) {
+            if (free_.compare_exchange_weak(
+                    free, free - bytes, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    //! Give bytes to the budget
+    void Give(size_t bytes) {
+        free_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+private:
+    //! bytes available to the readers
+    std::atomic<size_t> free_ { 0 };
+};
+
+using PrefetchBudgetPtr = std::shared_ptr<PrefetchBudget>;
+
 /*!
  * A File is an ordered sequence of Block objects for storing items. By using
  * the Block indirection, the File can be composed using existing Block objects
@@ -162,6 +200,28 @@ public:
     ConsumeReader GetConsumeReader(
         size_t prefetch_size = File::default_prefetch_size_);
 
+    /*!
+     * Call visitor(reader) with a ConsumeReader or a KeepReader for the
+     * beginning of File. Unlike the DynBlockReader of GetReader(), their block
+     * source is known statically, hence the compiler inlines the block
+     * advancement into the visitor's loop.
+     *
+     * \attention If consume is true, the reader consumes the File's contents
+     * UNCONDITIONALLY, as with GetReader().
+     */
+    template <typename Visitor>
+    void VisitReader(bool consume, const Visitor& visitor,
+                     size_t prefetch_size = File::default_prefetch_size_) {
+        if (consume) {
+            ConsumeReader reader = GetConsumeReader(prefetch_size);
+            visitor(reader);
+        }
+        else {
+            KeepReader reader = GetKeepReader(prefetch_size);
+            visitor(reader);
+        }
+    }
+
     //! Get BlockReader seeked to the corresponding item index
     template <typename ItemType>
     KeepReader GetReaderAt(
@@ -203,7 +263,8 @@ public:
     }
 
     //! Get item at the corresponding position. Do not use this
-    //! method for reading multiple successive items.
+    //! method for reading multiple successive items. Fixed-size items are
+    //! deserialized directly at their offset in the block.
     template <typename ItemType>
     ItemType GetItemAt(size_t index) const;
 
@@ -213,9 +274,9 @@ public:
      * value can be used to make a decision in case of many successive equal
      * elements.  The tie is compared with the local rank of the element.
      *
-     * WARNING: This method uses GetItemAt combined with a binary search and is
-     * therefore not efficient. The method should be reimplemented in near
-     * future.
+     * Fixed-size items are probed by a binary search at their offsets in the
+     * pinned blocks. For variable-size items, the binary search probes the
+     * first item of each block, and then reads the items of one block.
      */
     template <typename ItemType, typename CompareFunction = std::less<ItemType> >
     size_t GetIndexOf(const ItemType& item, size_t tie,
@@ -228,9 +289,9 @@ public:
      * value can be used to make a decision in case of many successive equal
      * elements.  The tie is compared with the local rank of the element.
      *
-     * WARNING: This method uses GetItemAt combined with a binary search and is
-     * therefore not efficient. The method should be reimplemented in near
-     * future.
+     * Fixed-size items are probed by a binary search at their offsets in the
+     * pinned blocks. For variable-size items, the binary search probes the
+     * first item of each block, and then reads the items of one block.
      */
     template <typename ItemType, typename CompareFunction = std::less<ItemType> >
     size_t GetIndexOf(const ItemType& item, size_t tie,
@@ -252,6 +313,18 @@ public:
     void set_dia_id(size_t dia_id) { dia_id_ = dia_id; }
 
 private:
+    //! Deserialize the fixed-size item at index directly from its block,
+    //! which is pinned into pinned, unless it is already pinned_block. Items
+    //! spanning a block boundary are read with a KeepReader.
+    template <typename ItemType>
+    ItemType GetItemAt(size_t index, PinnedBlock& pinned,
+                       size_t& pinned_block, std::true_type /* fixed */) const;
+
+    //! Read the variable-size item at index with a KeepReader.
+    template <typename ItemType>
+    ItemType GetItemAt(size_t index, PinnedBlock& pinned,
+                       size_t& pinned_block, std::false_type /* fixed */) const;
+
     //! unique file id
     size_t id_;
 
@@ -358,6 +431,10 @@ public:
     //! Perform prefetch
     void Prefetch(size_t prefetch_size);
 
+    //! Adapt the prefetch depth within the budget shared with other readers.
+    void set_prefetch_budget(const PrefetchBudgetPtr& budget)
+    { budget_ = budget; }
+
     //! Advance to next block of file, delivers current_ and end_ for
     //! BlockReader
     PinnedBlock NextBlock();
@@ -384,9 +461,15 @@ private:
     //! local worker id reading the File
     size_t local_worker_id_;
 
-    //! number of bytes of prefetch for reader
+    //! number of bytes of prefetch for reader, adapted to the consumption
     size_t prefetch_size_;
 
+    //! number of bytes of prefetch requested via Prefetch()
+    size_t requested_prefetch_size_;
+
+    //! budget shared with other readers, no adaptation if empty
+    PrefetchBudgetPtr budget_;
+
     //! current prefetch operations
     std::deque<PinRequestPtr> fetching_blocks_;
 
@@ -431,6 +514,10 @@ public:
     //! Perform prefetch
     void Prefetch(size_t prefetch_size);
 
+    //! Adapt the prefetch depth within the budget shared with other readers.
+    void set_prefetch_budget(const PrefetchBudgetPtr& budget)
+    { budget_ = budget; }
+
     //! Get the next block of file.
     PinnedBlock NextBlock();
 
@@ -451,9 +538,15 @@ private:
     //! local worker id reading the File
     size_t local_worker_id_;
 
-    //! number of bytes of prefetch for reader
+    //! number of bytes of prefetch for reader, adapted to the consumption
     size_t prefetch_size_;
 
+    //! number of bytes of prefetch requested via Prefetch()
+    size_t requested_prefetch_size_;
+
+    //! budget shared with other readers, no adaptation if empty
+    PrefetchBudgetPtr budget_;
+
     //! current prefetch operations
     std::deque<PinRequestPtr> fetching_blocks_;
 
@@ -467,11 +560,15 @@ typename File::KeepReader
 File::GetReaderAt(size_t index, size_t prefetch_size) const {
     static constexpr bool debug = false;
 
-    // perform binary search for item block with largest exclusive size
-    // prefixsum less or equal to index.
+    // perform binary search for the block in which item index starts, or
+    // the last one for the end of the File.
     auto it =
-        std::lower_bound(num_items_sum_.begin(), num_items_sum_.end(), index);
+        std::upper_bound(num_items_sum_.begin(), num_items_sum_.end(), index);
 
+    if (it == num_items_sum_.end()) {
+        it = std::lower_bound(
+            num_items_sum_.begin(), num_items_sum_.end(), index);
+    }
     if (it == num_items_sum_.end())
         die("Access beyond end of File?");
 
@@ -525,11 +622,57 @@ File::GetReaderAt(size_t index, size_t prefetch_size) const {
 }
 
 template <typename ItemType>
-ItemType File::GetItemAt(size_t index) const {
+ItemType File::GetItemAt(size_t index, PinnedBlock& pinned,
+                         size_t& pinned_block, std::true_type) const {
+    using Serialization = data::Serialization<net::BufferReader, ItemType>;
+
+    auto it =
+        std::upper_bound(num_items_sum_.begin(), num_items_sum_.end(), index);
+    if (it == num_items_sum_.end())
+        die("Access beyond end of File?");
+
+    size_t b = it - num_items_sum_.begin();
+    size_t items_before = b == 0 ? 0 : num_items_sum_[b - 1];
+    const Block& block = blocks_[b];
+
+    const size_t verify_size = block.typecode_verify() ? sizeof(size_t) : 0;
+    const size_t item_size = verify_size + Serialization::fixed_size;
+    const size_t offset =
+        block.first_item_relative() + (index - items_before) * item_size;
+
+    if (offset + item_size > block.size()) {
+        // item continues in the next block
+        return GetItemAt<ItemType>(index, pinned, pinned_block,
+                                   std::false_type());
+    }
+
+    if (!pinned.IsValid() || pinned_block != b) {
+        pinned = block.PinWait(local_worker_id_);
+        pinned_block = b;
+    }
+
+    net::BufferReader br(pinned.data_begin() + offset, item_size);
+    br.Skip(verify_size);
+    return Serialization::Deserialize(br);
+}
+
+template <typename ItemType>
+ItemType File::GetItemAt(size_t index, PinnedBlock& /* pinned */,
+                         size_t& /* pinned_block */, std::false_type) const {
     KeepReader reader = this->GetReaderAt<ItemType>(index, /* prefetch */ 0);
     return reader.Next<ItemType>();
 }
 
+template <typename ItemType>
+ItemType File::GetItemAt(size_t index) const {
+    PinnedBlock pinned;
+    size_t pinned_block = 0;
+    return GetItemAt<ItemType>(
+        index, pinned, pinned_block,
+        std::integral_constant<
+            bool, Serialization<KeepReader, ItemType>::is_fixed_size>());
+}
+
 template <typename ItemType, typename CompareFunction>
 size_t File::GetIndexOf(
     const ItemType& item, size_t tie, size_t left, size_t right,
@@ -551,18 +694,70 @@ size_t File::GetIndexOf(
     assert(left <= num_items());
     assert(right <= num_items());
 
-    // Use a binary search to find the item.
-    while (left < right) {
-        size_t mid = (right + left) >> 1;
-        LOG << "left: " << left << "right: " << right << "mid: " << mid;
-        ItemType cur = GetItemAt<ItemType>(mid);
-        LOG << "Item at mid: " << cur;
-        if (less(item, cur) ||
-            (!less(item, cur) && !less(cur, item) && tie <= mid)) {
-            right = mid;
+    // whether the item is inserted at or before index with item cur there
+    auto before = [&](const ItemType& cur, size_t index) {
+                      return less(item, cur) ||
+                             (!less(item, cur) && !less(cur, item) &&
+                              tie <= index);
+                  };
+
+    using IsFixedSize = std::integral_constant<
+              bool, Serialization<KeepReader, ItemType>::is_fixed_size>;
+
+    if (IsFixedSize::value) {
+        // binary search probing the items directly in the pinned blocks
+        PinnedBlock pinned;
+        size_t pinned_block = 0;
+        while (left < right) {
+            size_t mid = (right + left) >> 1;
+            LOG << "left: " << left << "right: " << right << "mid: " << mid;
+            if (before(GetItemAt<ItemType>(
+                           mid, pinned, pinned_block, IsFixedSize()), mid))
+                right = mid;
+            else
+                left = mid + 1;
+        }
+        LOG << "found insert position at: " << left;
+        return left;
+    }
+
+    // binary search over the blocks whose first item lies in [left,right),
+    // which probes only items at the start of blocks.
+    size_t block_left = std::upper_bound(
+        num_items_sum_.begin(), num_items_sum_.end(), left)
+                        - num_items_sum_.begin() + 1;
+    size_t block_right = std::lower_bound(
+        num_items_sum_.begin(), num_items_sum_.end(), right)
+                         - num_items_sum_.begin() + 1;
+    block_right = std::min(block_right, num_items_sum_.size());
+
+    while (block_left < block_right) {
+        size_t mid = (block_left + block_right) >> 1;
+        size_t start = num_items_sum_[mid - 1];
+        LOG << "left: " << left << "right: " << right
+            << "block: " << mid << "start: " << start;
+        if (start < left) {
+            block_left = mid + 1;
+        }
+        else if (start >= right) {
+            block_right = mid;
+        }
+        else if (before(GetItemAt<ItemType>(start), start)) {
+            right = start;
+            block_right = mid;
         }
         else {
-            left = mid + 1;
+            left = start + 1;
+            block_left = mid + 1;
+        }
+    }
+
+    // the remaining items start in one block: read them sequentially.
+    if (left < right) {
+        KeepReader reader = GetReaderAt<ItemType>(left, /* prefetch */ 0);
+        for ( ; left < right; ++left) {
+            if (before(reader.template Next<ItemType>(), left))
+                break;
         }
     }
 
@@ -580,9 +775,13 @@ std::vector<Block> File::GetItemRange(size_t begin, size_t end) const {
            .template GetItemBatch<ItemType>(end - begin);
 }
 
-//! Take a vector of Readers and prefetch equally from them
+//! Take a vector of Readers and prefetch equally from them. The readers
+//! adapt their prefetch depths within a shared PrefetchBudget.
 template <typename Reader>
 void StartPrefetch(std::vector<Reader>& readers, size_t prefetch_size) {
+    PrefetchBudgetPtr budget = std::make_shared<PrefetchBudget>();
+    for (Reader& r : readers)
+        r.source().set_prefetch_budget(budget);
     for (size_t p = default_block_size; p < prefetch_size;
          p += default_block_size)
     {
@@ -593,6 +792,32 @@ void StartPrefetch(std::vector<Reader>& readers, size_t prefetch_size) {
         r.source().Prefetch(prefetch_size);
 }
 
+//! Take a vector of Readers and prefetch prefetch_sizes[i] bytes from reader
+//! i, in rounds of one block per reader. The readers adapt their prefetch
+//! depths within a shared PrefetchBudget.
+template <typename Reader>
+void StartPrefetch(std::vector<Reader>& readers,
+                   const std::vector<size_t>& prefetch_sizes) {
+    assert(readers.size() == prefetch_sizes.size());
+    PrefetchBudgetPtr budget = std::make_shared<PrefetchBudget>();
+    for (Reader& r : readers)
+        r.source().set_prefetch_budget(budget);
+    size_t max_size = 0;
+    for (const size_t& p : prefetch_sizes)
+        max_size = std::max(max_size, p);
+
+    for (size_t p = default_block_size; p < max_size;
+         p += default_block_size)
+    {
+        for (size_t i = 0; i < readers.size(); ++i) {
+            if (p < prefetch_sizes[i])
+                readers[i].source().Prefetch(p);
+        }
+    }
+    for (size_t i = 0; i < readers.size(); ++i)
+        readers[i].source().Prefetch(prefetch_sizes[i]);
+}
+
 //! \}
 
 } // namespace data
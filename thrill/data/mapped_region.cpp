@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * thrill/data/mapped_region.cpp
+ *
+ * Read-only memory mapping of a file region, shared by ByteBlocks.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/data/mapped_region.hpp>
+
+#include <thrill/common/system_exception.hpp>
+
+#include <tlx/die.hpp>
+#include <tlx/unused.hpp>
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace thrill {
+namespace data {
+
+MappedRegion::MappedRegion(
+    const std::string& path, uint64_t offset, size_t size)
+    : size_(size) {
+#if !defined(_MSC_VER)
+    if (size == 0) return;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw common::ErrnoException("MappedRegion: cannot open " + path);
+
+    // mmap() offsets must be page aligned
+    uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t map_offset = offset / page_size * page_size;
+    map_size_ = static_cast<size_t>(offset - map_offset) + size;
+
+    map_ = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd,
+                static_cast<off_t>(map_offset));
+    ::close(fd);
+
+    if (map_ == MAP_FAILED)
+        throw common::ErrnoException("MappedRegion: cannot mmap " + path);
+
+    // blocks of the region are scanned once, in order
+    madvise(map_, map_size_, MADV_SEQUENTIAL);
+
+    data_ = static_cast<uint8_t*>(map_) + (offset - map_offset);
+#else
+    tlx::unused(path, offset);
+    die("MappedRegion: mmap() is not supported on this platform.");
+#endif
+}
+
+MappedRegion::~MappedRegion() {
+#if !defined(_MSC_VER)
+    if (map_)
+        munmap(map_, map_size_);
+#endif
+}
+
+bool MappedRegion::supported() {
+#if !defined(_MSC_VER)
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace data
+} // namespace thrill
+
+/******************************************************************************/
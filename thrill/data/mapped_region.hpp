@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * thrill/data/mapped_region.hpp
+ *
+ * Read-only memory mapping of a file region, shared by ByteBlocks.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_MAPPED_REGION_HEADER
+#define THRILL_DATA_MAPPED_REGION_HEADER
+
+#include <tlx/counting_ptr.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace thrill {
+namespace data {
+
+/*!
+ * A read-only memory mapping of the region [offset, offset + size) of a local
+ * file. ByteBlocks created by BlockPool::MapMemoryBlock() point directly into
+ * the mapping and hold a reference to it, hence the data is read without a copy
+ * into block memory, and the OS page cache loads and evicts the pages. The
+ * mapping is released when the last ByteBlock referencing it is destroyed.
+ */
+class MappedRegion : public tlx::ReferenceCounter
+{
+public:
+    //! Map region of the file path, throws common::ErrnoException if the file
+    //! cannot be mapped.
+    MappedRegion(const std::string& path, uint64_t offset, size_t size);
+
+    //! non-copyable: delete copy-constructor
+    MappedRegion(const MappedRegion&) = delete;
+    //! non-copyable: delete assignment operator
+    MappedRegion& operator = (const MappedRegion&) = delete;
+
+    //! unmap the region
+    ~MappedRegion();
+
+    //! pointer to the first byte of the region
+    uint8_t * data() const { return data_; }
+
+    //! size of the region
+    size_t size() const { return size_; }
+
+    //! whether the region of the file can be memory mapped, i.e. the system
+    //! supports mmap().
+    static bool supported();
+
+private:
+    //! begin of the mapping, which starts at a page boundary.
+    void* map_ = nullptr;
+
+    //! size of the mapping
+    size_t map_size_ = 0;
+
+    //! first byte of the requested region inside the mapping
+    uint8_t* data_ = nullptr;
+
+    //! size of the requested region
+    size_t size_;
+};
+
+using MappedRegionPtr = tlx::CountingPtr<MappedRegion>;
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_MAPPED_REGION_HEADER
+
+/******************************************************************************/
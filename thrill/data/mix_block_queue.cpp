@@ -9,6 +9,9 @@
  ******************************************************************************/
 
 #include <thrill/data/mix_block_queue.hpp>
+
+#include <thrill/common/deferred_work.hpp>
+#include <thrill/common/wait_stats.hpp>
 #include <thrill/data/mix_stream.hpp>
 
 #include <vector>
@@ -72,7 +75,13 @@ MixBlockQueue::SrcBlockPair MixBlockQueue::Pop() {
             size_t(-1), Block()
         };
     SrcBlockPair b;
-    mix_queue_.pop(b);
+    // run deferred work of the worker while no Block is available
+    while (!mix_queue_.try_pop(b)) {
+        if (common::DeferredWork::RunOne()) continue;
+        common::NetWaitTimer wait_timer;
+        mix_queue_.pop(b);
+        break;
+    }
     if (!b.block.IsValid()) {
         LOG << "MixBlockQueue()"
             << " read_open_ " << read_open_ << " -> " << read_open_ - 1;
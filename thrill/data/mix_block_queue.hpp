@@ -13,8 +13,8 @@
 #define THRILL_DATA_MIX_BLOCK_QUEUE_HEADER
 
 #include <thrill/common/atomic_movable.hpp>
-#include <thrill/common/concurrent_bounded_queue.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/mpsc_queue.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_queue.hpp>
 #include <thrill/data/block_reader.hpp>
@@ -41,7 +41,9 @@ using MixStreamDataPtr = tlx::CountingPtr<MixStreamData>;
  *
  * When Blocks arrive from the net, the Multiplexer pushes (src, Blocks) pairs
  * to MixChannel, which pushes them into a MixBlockQueue. The
- * MixBlockQueue stores these in a ConcurrentBoundedQueue for atomic reading.
+ * MixBlockQueue stores these in a lock-free MpscQueue, into which the
+ * dispatcher thread and the local writers push without contending on a lock,
+ * and from which the single reader takes all pending pairs at once.
  *
  * When the MixChannel should be read, MixBlockQueueReader is used, which
  * retrieves Blocks from the queue. The Reader contains one complete BlockReader
@@ -121,7 +123,7 @@ private:
     size_t local_worker_id_;
 
     //! the main mix queue, containing the block in the reception order.
-    common::ConcurrentBoundedQueue<SrcBlockPair> mix_queue_;
+    common::MpscQueue<SrcBlockPair> mix_queue_;
 
     //! total number of workers in system.
     size_t num_workers_;
@@ -57,6 +57,12 @@ MixStreamData::Writers MixStreamData::GetWriters() {
     if (block_size == 0 || block_size > default_block_size)
         block_size = default_block_size;
 
+    // the writers share a budget of block_size per target: writers to heavy
+    // targets grow their blocks up to default_block_size, while writers to
+    // sparse targets keep small blocks.
+    BlockWriterBudgetPtr budget =
+        tlx::make_counting<BlockWriterBudget>(block_size * num_workers());
+
     {
         std::unique_lock<std::mutex> lock(multiplexer_.mutex_);
         multiplexer_.active_streams_++;
@@ -70,6 +76,7 @@ MixStreamData::Writers MixStreamData::GetWriters() {
         << " hard_ram_limit=" << hard_ram_limit
         << " block_size_base=" << block_size_base
         << " block_size=" << block_size
+        << " budget=" << budget->limit()
         << " active_streams=" << multiplexer_.active_streams_
         << " max_active_streams=" << multiplexer_.max_active_streams_;
 
@@ -91,7 +98,7 @@ MixStreamData::Writers MixStreamData::GetWriters() {
                         id_,
                         my_host_rank(), local_worker_id_,
                         host, worker),
-                    block_size);
+                    default_block_size, budget);
             }
             else {
                 result.emplace_back(
@@ -103,7 +110,7 @@ MixStreamData::Writers MixStreamData::GetWriters() {
                         id_,
                         my_host_rank(), local_worker_id_,
                         host, worker),
-                    block_size);
+                    default_block_size, budget);
             }
         }
     }
@@ -167,6 +174,7 @@ struct MixStreamData::SeqReordering {
 
 void MixStreamData::OnStreamBlock(size_t from, uint32_t seq, Block&& b) {
     assert(from < num_workers());
+    std::unique_lock<std::mutex> lock = LockReceive();
     rx_timespan_.StartEventually();
 
     sLOG << "MixStreamData::OnStreamBlock" << b
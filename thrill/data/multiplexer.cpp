@@ -20,7 +20,11 @@
 #include <tlx/math/round_to_power_of_two.hpp>
 
 #include <algorithm>
+#include <chrono>
+#include <map>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -117,23 +121,42 @@ struct Multiplexer::Data {
     //! Streams have an ID in block headers. (worker id, stream id)
     Repository<StreamSetBase>         stream_sets_;
 
-    //! array of number of open requests
+    //! array of number of open requests, indexed by stripe * num_hosts + peer
     std::vector<std::atomic<size_t> > ongoing_requests_;
 
-    explicit Data(size_t num_hosts, size_t workers_per_host)
+    //! number of all-workers close messages received per (stream id, sender
+    //! worker), which are sent once on each stripe.
+    std::map<std::pair<size_t, size_t>, size_t> all_workers_close_;
+
+    //! end of the time slots reserved by PaceSend() for each peer host, in
+    //! nanoseconds of steady_clock.
+    std::vector<std::atomic<int64_t> > next_send_;
+
+    explicit Data(size_t num_links, size_t workers_per_host, size_t num_hosts)
         : stream_sets_(workers_per_host),
-          ongoing_requests_(num_hosts) { }
+          ongoing_requests_(num_links),
+          next_send_(num_hosts) { }
 };
 
 Multiplexer::Multiplexer(mem::Manager& mem_manager, BlockPool& block_pool,
                          net::DispatcherThread& dispatcher, net::Group& group,
-                         size_t workers_per_host)
+                         size_t workers_per_host, size_t num_dispatchers)
     : mem_manager_(mem_manager),
       block_pool_(block_pool),
       dispatcher_(dispatcher),
       group_(group),
+      num_stripes_(group_.num_stripes()),
       workers_per_host_(workers_per_host),
-      d_(std::make_unique<Data>(group_.num_hosts(), workers_per_host)) {
+      d_(std::make_unique<Data>(
+             group_.num_hosts() * num_stripes_, workers_per_host,
+             group_.num_hosts())) {
+
+    // launch additional dispatcher threads, which take over some stripes
+    for (size_t i = 1; i < num_dispatchers; ++i) {
+        dispatchers_.emplace_back(
+            std::make_unique<net::DispatcherThread>(
+                group_.ConstructDispatcher(), group_.my_host_rank()));
+    }
 
     num_parallel_async_ = group_.num_parallel_async();
     if (num_parallel_async_ == 0) {
@@ -152,10 +175,12 @@ Multiplexer::Multiplexer(mem::Manager& mem_manager, BlockPool& block_pool,
     if (send_size_limit_ < 2 * default_block_size)
         send_size_limit_ = 2 * default_block_size;
 
-    // launch initial async reads
-    for (size_t id = 0; id < group_.num_hosts(); id++) {
-        if (id == group_.my_host_rank()) continue;
-        AsyncReadMultiplexerHeader(id, group_.connection(id));
+    // launch initial async reads on all stripes
+    for (size_t stripe = 0; stripe < num_stripes_; ++stripe) {
+        for (size_t id = 0; id < group_.num_hosts(); id++) {
+            if (id == group_.my_host_rank()) continue;
+            AsyncReadMultiplexerHeader(id, stripe, connection(id, stripe));
+        }
     }
 }
 
@@ -175,9 +200,14 @@ void Multiplexer::Close() {
 }
 
 Multiplexer::~Multiplexer() {
+    // stop additional dispatchers, the main one was stopped by the HostContext
+    for (auto& d : dispatchers_)
+        d->Terminate();
+
     if (!closed_)
         Close();
 
+    group_.CloseStripes();
     group_.Close();
 }
 
@@ -277,27 +307,70 @@ common::JsonLogger& Multiplexer::logger() {
     return block_pool_.logger();
 }
 
+void Multiplexer::PaceSend(size_t peer, size_t size) {
+    if (send_rate_ == 0) return;
+    assert(peer < d_->next_send_.size());
+
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t duration = static_cast<int64_t>(
+        static_cast<double>(size) * 1e9 / send_rate_);
+
+    // reserve the next time slot of the peer, which starts now if the link
+    // was idle.
+    std::atomic<int64_t>& next = d_->next_send_[peer];
+    int64_t start = next.load(std::memory_order_relaxed), slot;
+    do {
+        slot = std::max(start, now);
+    } while (!next.compare_exchange_weak(
+                 start, slot + duration, std::memory_order_relaxed));
+
+    if (slot > now)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(slot - now));
+}
+
 /******************************************************************************/
 
-void Multiplexer::AsyncReadMultiplexerHeader(size_t peer, Connection& s) {
+void Multiplexer::AsyncReadMultiplexerHeader(
+    size_t peer, size_t stripe, Connection& s) {
+
+    std::atomic<size_t>& ongoing =
+        d_->ongoing_requests_[stripe * num_hosts() + peer];
 
-    while (d_->ongoing_requests_[peer] < num_parallel_async_) {
+    while (ongoing < num_parallel_async_) {
         uint32_t seq = 42 + (s.rx_seq_.fetch_add(2) & 0xFFFF);
-        dispatcher_.AsyncRead(
+        dispatcher(peer, stripe).AsyncRead(
             s, seq, MultiplexerHeader::total_size,
-            [this, peer, seq](Connection& s, net::Buffer&& buffer) {
-                return OnMultiplexerHeader(peer, seq, s, std::move(buffer));
+            [this, peer, stripe, seq](Connection& s, net::Buffer&& buffer) {
+                return OnMultiplexerHeader(
+                    peer, stripe, seq, s, std::move(buffer));
             });
 
-        d_->ongoing_requests_[peer]++;
+        ongoing++;
     }
 }
 
+bool Multiplexer::OnAllWorkersClose(size_t stream_id, size_t sender_worker) {
+    if (num_stripes_ == 1) return true;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto key = std::make_pair(stream_id, sender_worker);
+    if (++d_->all_workers_close_[key] < num_stripes_)
+        return false;
+
+    d_->all_workers_close_.erase(key);
+    return true;
+}
+
 void Multiplexer::OnMultiplexerHeader(
-    size_t peer, uint32_t seq, Connection& s, net::Buffer&& buffer) {
+    size_t peer, size_t stripe, uint32_t seq, Connection& s,
+    net::Buffer&& buffer) {
+
+    std::atomic<size_t>& ongoing =
+        d_->ongoing_requests_[stripe * num_hosts() + peer];
 
-    die_unless(d_->ongoing_requests_[peer] > 0);
-    d_->ongoing_requests_[peer]--;
+    die_unless(ongoing > 0);
+    ongoing--;
 
     // received invalid Buffer: the connection has closed?
     if (!buffer.IsValid()) return;
@@ -324,7 +397,12 @@ void Multiplexer::OnMultiplexerHeader(
 
     if (header.magic == MagicByte::CatStreamBlock)
     {
-        if (header.IsAllWorkers()) {
+        if (header.IsAllWorkers() &&
+            !OnAllWorkersClose(id, header.sender_worker)) {
+            sLOG << "end of all stream on" << s << "CatStream" << id
+                 << "waiting for other stripes";
+        }
+        else if (header.IsAllWorkers()) {
             sLOG << "end of all stream on" << s << "CatStream" << id
                  << " my_host_rank=" << my_host_rank()
                  << " peer_host_rank=" << header.sender_worker / workers_per_host();
@@ -373,19 +451,25 @@ void Multiplexer::OnMultiplexerHeader(
                 alloc_size, local_worker);
             sLOG << "new PinnedByteBlockPtr bytes=" << *bytes;
 
-            d_->ongoing_requests_[peer]++;
+            ongoing++;
 
-            dispatcher_.AsyncRead(
+            dispatcher(peer, stripe).AsyncRead(
                 s, seq + 1, header.size, std::move(bytes),
-                [this, peer, header, stream](
+                [this, peer, stripe, header, stream](
                     Connection& s, PinnedByteBlockPtr&& bytes) {
-                    OnCatStreamBlock(peer, s, header, stream, std::move(bytes));
+                    OnCatStreamBlock(
+                        peer, stripe, s, header, stream, std::move(bytes));
                 });
         }
     }
     else if (header.magic == MagicByte::MixStreamBlock)
     {
-        if (header.IsAllWorkers()) {
+        if (header.IsAllWorkers() &&
+            !OnAllWorkersClose(id, header.sender_worker)) {
+            sLOG << "end of all stream on" << s << "MixStream" << id
+                 << "waiting for other stripes";
+        }
+        else if (header.IsAllWorkers()) {
             sLOG << "end of all stream on" << s << "MixStream" << id
                  << " my_host_rank=" << my_host_rank()
                  << " peer_host_rank=" << header.sender_worker / workers_per_host();
@@ -431,13 +515,14 @@ void Multiplexer::OnMultiplexerHeader(
             PinnedByteBlockPtr bytes = block_pool_.AllocateByteBlock(
                 alloc_size, local_worker);
 
-            d_->ongoing_requests_[peer]++;
+            ongoing++;
 
-            dispatcher_.AsyncRead(
+            dispatcher(peer, stripe).AsyncRead(
                 s, seq + 1, header.size, std::move(bytes),
-                [this, peer, header, stream](
+                [this, peer, stripe, header, stream](
                     Connection& s, PinnedByteBlockPtr&& bytes) mutable {
-                    OnMixStreamBlock(peer, s, header, stream, std::move(bytes));
+                    OnMixStreamBlock(
+                        peer, stripe, s, header, stream, std::move(bytes));
                 });
         }
     }
@@ -445,21 +530,37 @@ void Multiplexer::OnMultiplexerHeader(
         die("Invalid magic byte in MultiplexerHeader");
     }
 
-    AsyncReadMultiplexerHeader(peer, s);
+    AsyncReadMultiplexerHeader(peer, stripe, s);
+}
+
+//! mark a block received from a remote sender for eviction
+static void MarkReceivedBlock(const PinnedByteBlockPtr& bytes) {
+    // A receiver reads the blocks of a sender in the order they arrive, hence
+    // when the BlockPool must evict queued blocks, the last received ones are
+    // read latest and should go first. LRU order would instead evict the
+    // oldest blocks, which are read next. The Sequential hint places the block
+    // into the MRU scan list of the BlockPool.
+    bytes->set_eviction_hint(EvictionHint::Sequential);
 }
 
 void Multiplexer::OnCatStreamBlock(
-    size_t peer, Connection& s, const StreamMultiplexerHeader& header,
+    size_t peer, size_t stripe, Connection& s,
+    const StreamMultiplexerHeader& header,
     const CatStreamDataPtr& stream, PinnedByteBlockPtr&& bytes) {
 
-    die_unless(d_->ongoing_requests_[peer] > 0);
-    d_->ongoing_requests_[peer]--;
+    std::atomic<size_t>& ongoing =
+        d_->ongoing_requests_[stripe * num_hosts() + peer];
+
+    die_unless(ongoing > 0);
+    ongoing--;
 
     sLOG << "Multiplexer::OnCatStreamBlock()"
          << "got block" << *bytes << "seq" << header.seq << "on" << s
          << "in CatStream" << header.stream_id
          << "from worker" << header.sender_worker;
 
+    MarkReceivedBlock(bytes);
+
     stream->OnStreamBlock(
         header.sender_worker, header.seq,
         Block(std::move(bytes).ReleasePin(), /* begin */ 0, header.size,
@@ -469,21 +570,27 @@ void Multiplexer::OnCatStreamBlock(
     if (header.is_last_block)
         stream->OnStreamBlock(header.sender_worker, header.seq + 1, Block());
 
-    AsyncReadMultiplexerHeader(peer, s);
+    AsyncReadMultiplexerHeader(peer, stripe, s);
 }
 
 void Multiplexer::OnMixStreamBlock(
-    size_t peer, Connection& s, const StreamMultiplexerHeader& header,
+    size_t peer, size_t stripe, Connection& s,
+    const StreamMultiplexerHeader& header,
     const MixStreamDataPtr& stream, PinnedByteBlockPtr&& bytes) {
 
-    die_unless(d_->ongoing_requests_[peer] > 0);
-    d_->ongoing_requests_[peer]--;
+    std::atomic<size_t>& ongoing =
+        d_->ongoing_requests_[stripe * num_hosts() + peer];
+
+    die_unless(ongoing > 0);
+    ongoing--;
 
     sLOG << "Multiplexer::OnMixStreamBlock()"
          << "got block" << *bytes << "seq" << header.seq << "on" << s
          << "in MixStream" << header.stream_id
          << "from worker" << header.sender_worker;
 
+    MarkReceivedBlock(bytes);
+
     stream->OnStreamBlock(
         header.sender_worker, header.seq,
         Block(std::move(bytes).ReleasePin(), /* begin */ 0, header.size,
@@ -493,7 +600,7 @@ void Multiplexer::OnMixStreamBlock(
     if (header.is_last_block)
         stream->OnStreamBlock(header.sender_worker, header.seq + 1, Block());
 
-    AsyncReadMultiplexerHeader(peer, s);
+    AsyncReadMultiplexerHeader(peer, stripe, s);
 }
 
 CatStreamDataPtr Multiplexer::CatLoopback(
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <atomic>
 #include <memory>
+#include <vector>
 
 namespace thrill {
 namespace data {
@@ -69,9 +70,12 @@ class Multiplexer
     static constexpr bool debug = false;
 
 public:
+    //! Construct Multiplexer on group. If num_dispatchers > 1, additional
+    //! DispatcherThreads are launched, and the connections (including their
+    //! stripes) are distributed round-robin among dispatcher and them.
     Multiplexer(mem::Manager& mem_manager, BlockPool& block_pool,
                 net::DispatcherThread& dispatcher, net::Group& group,
-                size_t workers_per_host);
+                size_t workers_per_host, size_t num_dispatchers = 1);
 
     //! non-copyable: delete copy-constructor
     Multiplexer(const Multiplexer&) = delete;
@@ -110,12 +114,43 @@ public:
     //! Get the JsonLogger from the BlockPool
     common::JsonLogger& logger();
 
-    //! get network dispatcher
+    //! get main network dispatcher
     net::DispatcherThread& dispatcher() { return dispatcher_; }
 
+    //! get network dispatcher which owns the stripe of the connection to peer
+    net::DispatcherThread& dispatcher(size_t peer, size_t stripe) {
+        size_t i = (stripe * num_hosts() + peer) % (1 + dispatchers_.size());
+        return i == 0 ? dispatcher_ : *dispatchers_[i - 1];
+    }
+
+    //! number of dispatcher threads serving the connections
+    size_t num_dispatchers() const { return 1 + dispatchers_.size(); }
+
     //! get network group connection
     net::Group& group() { return group_; }
 
+    //! number of connection stripes to each peer
+    size_t num_stripes() const { return num_stripes_; }
+
+    //! get stripe of the connection to peer
+    net::Connection& connection(size_t peer, size_t stripe) {
+        return group_.stripe_connection(peer, stripe);
+    }
+
+    //! Limit the rate at which Blocks are sent to each peer host to the given
+    //! bytes per second, 0 disables the limit. Must be set before the streams
+    //! are used.
+    void set_send_rate(double bytes_per_second) {
+        send_rate_ = bytes_per_second;
+    }
+
+    //! bytes per second sent to each peer host, 0 if unlimited.
+    double send_rate() const { return send_rate_; }
+
+    //! Reserves the transmission of size bytes to peer within the send rate,
+    //! and sleeps until the reserved time slot begins.
+    void PaceSend(size_t peer, size_t size);
+
     //! \name CatStreamData
     //! \{
 
@@ -157,9 +192,15 @@ private:
     //! never leaves the data components!
     net::DispatcherThread& dispatcher_;
 
+    //! additional dispatcher threads, each owning some connection stripes
+    std::vector<std::unique_ptr<net::DispatcherThread> > dispatchers_;
+
     //! Holds NetConnections for outgoing Streams
     net::Group& group_;
 
+    //! number of connection stripes to each peer
+    size_t num_stripes_;
+
     //! Number of workers per host
     size_t workers_per_host_;
 
@@ -175,6 +216,9 @@ private:
     //! Calculated send queue size limit for StreamData semaphores
     size_t send_size_limit_;
 
+    //! bytes per second sent to each peer host, 0 if unlimited.
+    double send_rate_ = 0;
+
     //! number of active Cat/MixStreams
     std::atomic<size_t> active_streams_ { 0 };
 
@@ -215,21 +259,29 @@ private:
 
     //! expects the next MultiplexerHeader from a socket and passes to
     //! OnMultiplexerHeader
-    void AsyncReadMultiplexerHeader(size_t peer, Connection& s);
+    void AsyncReadMultiplexerHeader(size_t peer, size_t stripe, Connection& s);
 
     //! parses MultiplexerHeader and decides whether to receive Block or close
     //! Stream
     void OnMultiplexerHeader(
-        size_t peer, uint32_t seq, Connection& s, net::Buffer&& buffer);
+        size_t peer, size_t stripe, uint32_t seq, Connection& s,
+        net::Buffer&& buffer);
+
+    //! count the all-workers close message of a stream from a peer, which is
+    //! sent on all stripes. Returns true when it arrived on all stripes, hence
+    //! all Blocks sent before it were received.
+    bool OnAllWorkersClose(size_t stream_id, size_t sender_worker);
 
     //! Receives and dispatches a Block to a CatStreamData
     void OnCatStreamBlock(
-        size_t peer, Connection& s, const StreamMultiplexerHeader& header,
+        size_t peer, size_t stripe, Connection& s,
+        const StreamMultiplexerHeader& header,
         const CatStreamDataPtr& stream, PinnedByteBlockPtr&& bytes);
 
     //! Receives and dispatches a Block to a MixStream
     void OnMixStreamBlock(
-        size_t peer, Connection& s, const StreamMultiplexerHeader& header,
+        size_t peer, size_t stripe, Connection& s,
+        const StreamMultiplexerHeader& header,
         const MixStreamDataPtr& stream, PinnedByteBlockPtr&& bytes);
 };
 
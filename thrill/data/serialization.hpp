@@ -181,7 +181,11 @@ struct Serialization<Archive, std::tuple<Args...> > {
 /*********************** Serialization of vector ******************************/
 
 template <typename Archive, typename T>
-struct Serialization<Archive, std::vector<T> > {
+struct Serialization<Archive, std::vector<T>,
+                     typename std::enable_if<
+                         !std::is_pod<T>::value || std::is_pointer<T>::value
+                         || std::is_same<T, bool>::value
+                         >::type> {
     static void Serialize(const std::vector<T>& x, Archive& ar) {
         ar.PutVarint(x.size());
         for (typename std::vector<T>::const_iterator it = x.begin();
@@ -200,6 +204,28 @@ struct Serialization<Archive, std::vector<T> > {
     static constexpr size_t fixed_size = 0;
 };
 
+//! fast path for vectors of PODs: the items are stored exactly as by PutRaw(),
+//! but copied as one run of bytes instead of one call per item.
+template <typename Archive, typename T>
+struct Serialization<Archive, std::vector<T>,
+                     typename std::enable_if<
+                         std::is_pod<T>::value && !std::is_pointer<T>::value
+                         && !std::is_same<T, bool>::value
+                         >::type> {
+    static void Serialize(const std::vector<T>& x, Archive& ar) {
+        ar.PutVarint(x.size());
+        ar.Append(x.data(), x.size() * sizeof(T));
+    }
+    static std::vector<T> Deserialize(Archive& ar) {
+        size_t size = ar.GetVarint();
+        std::vector<T> out(size);
+        ar.Read(out.data(), size * sizeof(T));
+        return out;
+    }
+    static constexpr bool   is_fixed_size = false;
+    static constexpr size_t fixed_size = 0;
+};
+
 /*********************** Serialization of array *******************************/
 
 template <typename Archive, typename T, size_t N>
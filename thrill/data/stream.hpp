@@ -22,6 +22,7 @@
 #include <thrill/data/stream_sink.hpp>
 
 #include <mutex>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -194,6 +195,40 @@ public:
         }
     }
 
+    /*!
+     * Moves a batch of items to the worker with the given rank, which must run
+     * on this host, without serializing them into Blocks. This is a typed
+     * loopback channel for items which are expensive to serialize, such as
+     * strings or vectors, when many workers share one process.
+     *
+     * The batches are delivered separately from the items written into the
+     * Stream: they must be posted before the Writer to the worker is closed,
+     * and the worker takes them with TakeLocal() after it has read all items
+     * from this worker. Hence the order between batches and written items is up
+     * to the user.
+     */
+    template <typename ItemType>
+    void PostLocal(size_t worker_rank, std::vector<ItemType>&& items) {
+        data().template PostLocal<ItemType>(worker_rank, std::move(items));
+    }
+
+    /*!
+     * Takes the batches of items posted to this worker by the worker with the
+     * given rank on this host via PostLocal(). Must be called after reading all
+     * items written by that worker, which also guarantees that its Writer was
+     * closed.
+     */
+    template <typename ItemType>
+    std::vector<std::vector<ItemType> > TakeLocal(size_t worker_rank) {
+        return data().template TakeLocal<ItemType>(worker_rank);
+    }
+
+    //! true if the worker with the given rank runs on this host, and hence can
+    //! receive batches via PostLocal().
+    bool is_local_worker(size_t worker_rank) const {
+        return data().is_local_worker(worker_rank);
+    }
+
     /**************************************************************************/
 
     //! \name Statistics
@@ -35,6 +35,12 @@ StreamData::StreamData(StreamSetBase* stream_set_base,
 
 StreamData::~StreamData() = default;
 
+std::unique_lock<std::mutex> StreamData::LockReceive() {
+    if (multiplexer_.num_dispatchers() == 1)
+        return std::unique_lock<std::mutex>();
+    return std::unique_lock<std::mutex>(rx_mutex_);
+}
+
 void StreamData::OnWriterClosed(size_t peer_worker_rank, bool sent) {
     ++writers_closed_;
 
@@ -58,6 +64,19 @@ void StreamData::OnWriterClosed(size_t peer_worker_rank, bool sent) {
     }
 }
 
+void StreamData::OnWriterStats(size_t peer_worker_rank,
+                               size_t items, size_t bytes, size_t blocks) {
+    if (tx_items_per_worker_.empty()) {
+        tx_items_per_worker_.resize(num_workers());
+        tx_bytes_per_worker_.resize(num_workers());
+        tx_blocks_per_worker_.resize(num_workers());
+    }
+    assert(peer_worker_rank < num_workers());
+    tx_items_per_worker_[peer_worker_rank] += items;
+    tx_bytes_per_worker_[peer_worker_rank] += bytes;
+    tx_blocks_per_worker_[peer_worker_rank] += blocks;
+}
+
 void StreamData::OnAllWritersClosed() {
     multiplexer_.logger()
         << "class" << "StreamData"
@@ -79,7 +98,10 @@ void StreamData::OnAllWritersClosed() {
         << "rx_int_blocks" << rx_int_blocks_
         << "tx_int_items" << tx_int_items_
         << "tx_int_bytes" << tx_int_bytes_
-        << "tx_int_blocks" << tx_int_blocks_;
+        << "tx_int_blocks" << tx_int_blocks_
+        << "tx_items_per_worker" << tx_items_per_worker_
+        << "tx_bytes_per_worker" << tx_bytes_per_worker_
+        << "tx_blocks_per_worker" << tx_blocks_per_worker_;
 }
 
 /******************************************************************************/
@@ -199,11 +221,15 @@ void StreamSet<StreamData>::OnWriterClosed(size_t peer_worker_rank, bool sent) {
         net::Buffer buffer = bb.ToBuffer();
         assert(buffer.size() == MultiplexerHeader::total_size);
 
-        net::Connection& conn = multiplexer_.group().connection(peer_host_rank);
+        // send the final close on all stripes, behind the Blocks sent on them.
+        for (size_t stripe = 0; stripe < multiplexer_.num_stripes(); ++stripe) {
+            net::Connection& conn =
+                multiplexer_.connection(peer_host_rank, stripe);
 
-        multiplexer_.dispatcher().AsyncWrite(
-            conn, 42 + (conn.tx_seq_.fetch_add(2) & 0xFFFF),
-            std::move(buffer));
+            multiplexer_.dispatcher(peer_host_rank, stripe).AsyncWrite(
+                conn, 42 + (conn.tx_seq_.fetch_add(2) & 0xFFFF),
+                net::Buffer(buffer.data(), buffer.size()));
+        }
     }
 }
 
@@ -18,9 +18,13 @@
 #include <thrill/data/block_writer.hpp>
 #include <thrill/data/file.hpp>
 #include <thrill/data/multiplexer.hpp>
+#include <tlx/die.hpp>
 #include <tlx/semaphore.hpp>
 
+#include <memory>
 #include <mutex>
+#include <typeinfo>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -122,9 +126,29 @@ public:
     //! messages to remote hosts
     void OnWriterClosed(size_t peer_worker_rank, bool sent);
 
+    //! method called from StreamSink when it is closed with the totals it sent
+    //! to the peer worker, which are logged in the per-worker traffic arrays.
+    void OnWriterStats(size_t peer_worker_rank,
+                       size_t items, size_t bytes, size_t blocks);
+
     //! method called when all StreamSink writers have finished
     void OnAllWritersClosed();
 
+    //! true if the worker with the given rank runs on this host.
+    bool is_local_worker(size_t worker_rank) const {
+        return worker_rank / workers_per_host() == my_host_rank();
+    }
+
+    //! Moves a batch of items to a worker on this host, without serializing
+    //! them, see Stream::PostLocal().
+    template <typename ItemType>
+    inline void PostLocal(size_t worker_rank, std::vector<ItemType>&& items);
+
+    //! Takes the batches of items moved to this worker by the given worker on
+    //! this host, see Stream::TakeLocal().
+    template <typename ItemType>
+    inline std::vector<std::vector<ItemType> > TakeLocal(size_t worker_rank);
+
     /*------------------------------------------------------------------------*/
     ///////// expose these members - getters would be too java-ish /////////////
 
@@ -148,6 +172,11 @@ public:
     std::atomic<size_t>
     tx_int_items_ { 0 }, tx_int_bytes_ { 0 }, tx_int_blocks_ { 0 };
 
+    //! items, bytes, and blocks sent to each worker by this worker's
+    //! StreamSinks, including loopback. Filled when the sinks are closed.
+    std::vector<size_t> tx_items_per_worker_, tx_bytes_per_worker_,
+        tx_blocks_per_worker_;
+
     //! Timers from creation of stream until rx / tx direction is closed.
     common::StatsTimerStart tx_lifetime_, rx_lifetime_;
 
@@ -176,6 +205,14 @@ protected:
     //! reference to multiplexer
     Multiplexer& multiplexer_;
 
+    //! serializes OnStreamBlock() if it is called by multiple dispatcher
+    //! threads, see LockReceive().
+    std::mutex rx_mutex_;
+
+    //! Lock rx_mutex_ if more than one dispatcher thread delivers Blocks,
+    //! otherwise return an unlocked lock.
+    std::unique_lock<std::mutex> LockReceive();
+
     //! number of remaining expected stream closing operations. Required to know
     //! when to stop rx_lifetime
     std::atomic<size_t> remaining_closing_blocks_;
@@ -211,8 +248,84 @@ public:
     //! method called from StreamSink when it is closed, used to aggregate Close
     //! messages to remote hosts
     virtual void OnWriterClosed(size_t peer_worker_rank, bool sent) = 0;
+
+    //! Appends a batch of items to the slot from local worker from to local
+    //! worker to.
+    template <typename ItemType>
+    void PostLocal(size_t from, size_t to, size_t workers_per_host,
+                   std::vector<ItemType>&& items) {
+        using Batches = std::vector<std::vector<ItemType> >;
+        std::unique_lock<std::mutex> lock(local_mutex_);
+        LocalSlot& slot = local_slot(from, to, workers_per_host);
+        if (!slot.batches) {
+            slot.batches = std::make_shared<Batches>();
+            slot.type = &typeid(ItemType);
+        }
+        die_unless(*slot.type == typeid(ItemType));
+        static_cast<Batches*>(slot.batches.get())->emplace_back(
+            std::move(items));
+    }
+
+    //! Removes the batches of items from local worker from to local worker to.
+    template <typename ItemType>
+    std::vector<std::vector<ItemType> > TakeLocal(
+        size_t from, size_t to, size_t workers_per_host) {
+        using Batches = std::vector<std::vector<ItemType> >;
+        std::unique_lock<std::mutex> lock(local_mutex_);
+        LocalSlot& slot = local_slot(from, to, workers_per_host);
+        if (!slot.batches) return Batches();
+        die_unless(*slot.type == typeid(ItemType));
+        Batches batches = std::move(*static_cast<Batches*>(slot.batches.get()));
+        slot = LocalSlot();
+        return batches;
+    }
+
+private:
+    //! type-erased std::vector<std::vector<ItemType> > of batches
+    struct LocalSlot {
+        std::shared_ptr<void> batches;
+        const std::type_info* type = nullptr;
+    };
+
+    //! batches moved between the local workers, indexed by from * workers per
+    //! host + to.
+    std::vector<LocalSlot> local_slots_;
+
+    //! mutex protecting local_slots_
+    std::mutex local_mutex_;
+
+    //! returns the slot from local worker from to local worker to, requires
+    //! local_mutex_.
+    LocalSlot& local_slot(size_t from, size_t to, size_t workers_per_host) {
+        assert(from < workers_per_host && to < workers_per_host);
+        if (local_slots_.empty())
+            local_slots_.resize(workers_per_host * workers_per_host);
+        return local_slots_[from * workers_per_host + to];
+    }
 };
 
+template <typename ItemType>
+void StreamData::PostLocal(size_t worker_rank, std::vector<ItemType>&& items) {
+    die_unless(is_local_worker(worker_rank));
+    tx_int_items_ += items.size();
+    stream_set_base_->PostLocal(
+        local_worker_id_, worker_rank % workers_per_host(), workers_per_host(),
+        std::move(items));
+}
+
+template <typename ItemType>
+std::vector<std::vector<ItemType> >
+StreamData::TakeLocal(size_t worker_rank) {
+    die_unless(is_local_worker(worker_rank));
+    std::vector<std::vector<ItemType> > batches =
+        stream_set_base_->TakeLocal<ItemType>(
+            worker_rank % workers_per_host(), local_worker_id_,
+            workers_per_host());
+    for (const std::vector<ItemType>& b : batches)
+        rx_int_items_ += b.size();
+    return batches;
+}
+
 /*!
  * Simple structure that holds a all stream instances for the workers on the
  * local host for a given stream id.
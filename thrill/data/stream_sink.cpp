@@ -17,6 +17,9 @@
 
 #include <tlx/string/hexdump.hpp>
 
+#include <deque>
+#include <vector>
+
 namespace thrill {
 namespace data {
 
@@ -223,8 +226,18 @@ void StreamSink::AppendPinnedBlock(PinnedBlock&& block, bool is_last_block) {
     stream_->tx_net_blocks_++;
     byte_counter_ += buffer.size();
 
-    stream_->multiplexer_.dispatcher_.AsyncWrite(
-        *connection_, 42 + (connection_->tx_seq_.fetch_add(2) & 0xFFFF),
+    // stripe Blocks round-robin over the connections to the peer, the
+    // receiver restores the order via the sequence numbers.
+    Multiplexer& multiplexer = stream_->multiplexer_;
+    multiplexer.PaceSend(peer_rank_, send_size);
+    size_t stripe = (block_counter_ - 1 + local_worker_id_)
+                    % multiplexer.num_stripes();
+    net::Connection& conn = stripe == 0
+                            ? *connection_
+                            : multiplexer.connection(peer_rank_, stripe);
+
+    multiplexer.dispatcher(peer_rank_, stripe).AsyncWrite(
+        conn, 42 + (conn.tx_seq_.fetch_add(2) & 0xFFFF),
         // send out Buffer and Block, guaranteed to be successive
         std::move(buffer), std::move(block),
         [s = stream_, send_size](net::Connection&) {
@@ -242,12 +255,37 @@ void StreamSink::AppendPinnedBlock(PinnedBlock&& block, bool is_last_block) {
             << " to=" << peer_worker_rank()
             << " (host=" << peer_rank_ << ")";
 
-        stream_->OnWriterClosed(peer_worker_rank(), /* sent */ true);
+        OnClosed(/* sent */ true);
 
         Finalize();
     }
 }
 
+void StreamSink::AppendBlocks(const std::vector<Block>& blocks) {
+    if (block_queue_ || target_mix_stream_)
+        return BlockSink::AppendBlocks(blocks);
+
+    // pin up to File::default_prefetch_size_ bytes of Blocks ahead
+    std::deque<PinRequestPtr> pins;
+    size_t next = 0, pinned_bytes = 0;
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        while (next < blocks.size() &&
+               (next == i || pinned_bytes < File::default_prefetch_size_)) {
+            pins.emplace_back(blocks[next].Pin(local_worker_id()));
+            pinned_bytes += blocks[next].size();
+            ++next;
+        }
+
+        PinnedBlock b = pins.front()->Wait();
+        pins.pop_front();
+        pinned_bytes -= blocks[i].size();
+
+        AppendPinnedBlock(std::move(b),
+                          /* is_last_block */ i + 1 == blocks.size());
+    }
+}
+
 void StreamSink::Close() {
     if (closed_) return;
     closed_ = true;
@@ -263,22 +301,28 @@ void StreamSink::Close() {
     if (block_queue_) {
         // StreamData statistics for internal transfer
         stream_->tx_int_blocks_++;
-        stream_->OnWriterClosed(peer_worker_rank(), /* sent */ true);
+        OnClosed(/* sent */ true);
         return block_queue_->Close();
     }
     if (target_mix_stream_) {
         // StreamData statistics for internal transfer
         stream_->tx_int_blocks_++;
-        stream_->OnWriterClosed(peer_worker_rank(), /* sent */ true);
+        OnClosed(/* sent */ true);
         return target_mix_stream_->OnStreamBlock(
             my_worker_rank(), block_counter_ - 1, Block());
     }
 
-    stream_->OnWriterClosed(peer_worker_rank(), /* sent */ false);
+    OnClosed(/* sent */ false);
 
     Finalize();
 }
 
+void StreamSink::OnClosed(bool sent) {
+    stream_->OnWriterStats(
+        peer_worker_rank(), item_counter_, byte_counter_, block_counter_);
+    stream_->OnWriterClosed(peer_worker_rank(), sent);
+}
+
 void StreamSink::Finalize() {
     logger()
         << "class" << "StreamSink"
@@ -79,6 +79,11 @@ public:
     //! Appends data to the StreamSink.  Data may be sent but may be delayed.
     void AppendPinnedBlock(PinnedBlock&& block, bool is_last_block) final;
 
+    //! Appends a sequence of Blocks. For network transfers, the Blocks are
+    //! pinned ahead asynchronously, such that reading swapped out Blocks
+    //! overlaps with sending the previous ones.
+    void AppendBlocks(const std::vector<Block>& blocks) final;
+
     //! Closes the connection
     void Close() final;
 
@@ -139,6 +144,9 @@ private:
     size_t byte_counter_ = 0;
     size_t block_counter_ = 0;
     common::StatsTimerStart timespan_;
+
+    //! pass the sink's totals and the close to the StreamData
+    void OnClosed(bool sent);
 };
 
 //! \}
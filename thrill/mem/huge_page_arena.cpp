@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * thrill/mem/huge_page_arena.cpp
+ *
+ * Arena of fixed-size slots in huge page backed memory.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/mem/huge_page_arena.hpp>
+
+#include <thrill/common/logger.hpp>
+
+#if !defined(_MSC_VER)
+#include <sys/mman.h>
+#endif
+
+namespace thrill {
+namespace mem {
+
+HugePageArena::HugePageArena(size_t slot_size, size_t num_slots)
+    : slot_size_(slot_size) {
+#if !defined(_MSC_VER)
+    // round the slots up to whole huge pages
+    size_t size = (slot_size * num_slots + huge_page_size - 1)
+                  / huge_page_size * huge_page_size;
+    if (size == 0) return;
+
+#if defined(MAP_HUGETLB)
+    // first try explicit huge pages, which are already aligned
+    region_ = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (region_ != MAP_FAILED) {
+        region_size_ = size;
+        begin_ = static_cast<char*>(region_);
+        hugetlb_ = true;
+    }
+#endif
+
+    if (!hugetlb_) {
+        // map one huge page more, such that the slots can be aligned
+        region_size_ = size + huge_page_size;
+        region_ = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (region_ == MAP_FAILED) {
+            LOG1 << "HugePageArena: could not map " << region_size_ << " bytes";
+            region_ = nullptr;
+            region_size_ = 0;
+            return;
+        }
+        uintptr_t addr = reinterpret_cast<uintptr_t>(region_);
+        addr = (addr + huge_page_size - 1) / huge_page_size * huge_page_size;
+        begin_ = reinterpret_cast<char*>(addr);
+#if defined(MADV_HUGEPAGE)
+        madvise(begin_, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    num_slots_ = num_slots;
+    free_list_.reserve(num_slots_);
+    // push in reverse, such that the slots are handed out in address order
+    for (size_t i = num_slots_; i != 0; --i)
+        free_list_.push_back(begin_ + (i - 1) * slot_size_);
+#else
+    (void)num_slots;
+#endif
+}
+
+HugePageArena::~HugePageArena() {
+#if !defined(_MSC_VER)
+    if (region_)
+        munmap(region_, region_size_);
+#endif
+}
+
+} // namespace mem
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * thrill/mem/huge_page_arena.hpp
+ *
+ * Arena of fixed-size slots in huge page backed memory.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_MEM_HUGE_PAGE_ARENA_HEADER
+#define THRILL_MEM_HUGE_PAGE_ARENA_HEADER
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace thrill {
+namespace mem {
+
+/*!
+ * An arena of equally sized slots in one memory region, which is mapped with
+ * explicit huge pages (MAP_HUGETLB) if available, or else with transparent huge
+ * pages (madvise(MADV_HUGEPAGE)). Free slots are kept in a free-list, hence
+ * allocating and deallocating a slot are pointer pushes and pops without
+ * system calls and page faults after the first use. The BlockPool uses the
+ * arena for ByteBlocks of the default block size, which are allocated and freed
+ * at high rates.
+ */
+class HugePageArena
+{
+public:
+    //! size of huge pages, to which the region is aligned
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+    //! Map a region of num_slots slots of slot_size bytes. If mapping fails,
+    //! the arena is empty and all allocations fail.
+    HugePageArena(size_t slot_size, size_t num_slots);
+
+    //! non-copyable: delete copy-constructor
+    HugePageArena(const HugePageArena&) = delete;
+    //! non-copyable: delete assignment operator
+    HugePageArena& operator = (const HugePageArena&) = delete;
+
+    //! unmap the region
+    ~HugePageArena();
+
+    //! size of the slots
+    size_t slot_size() const { return slot_size_; }
+
+    //! number of slots in the arena
+    size_t num_slots() const { return num_slots_; }
+
+    //! number of currently free slots
+    size_t free_slots() const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return free_list_.size();
+    }
+
+    //! true if the region is backed by explicit huge pages
+    bool hugetlb() const { return hugetlb_; }
+
+    //! true if ptr points into a slot of the arena
+    bool contains(const void* ptr) const {
+        const char* p = static_cast<const char*>(ptr);
+        return p >= begin_ && p < begin_ + num_slots_ * slot_size_;
+    }
+
+    //! allocate a slot, returns nullptr if all slots are used.
+    void * allocate() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (free_list_.empty()) return nullptr;
+        void* ptr = free_list_.back();
+        free_list_.pop_back();
+        return ptr;
+    }
+
+    //! return a slot to the free-list
+    void deallocate(void* ptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        free_list_.push_back(ptr);
+    }
+
+private:
+    //! size of the slots
+    size_t slot_size_;
+
+    //! number of slots
+    size_t num_slots_ = 0;
+
+    //! mapped region (including alignment to huge pages)
+    void* region_ = nullptr;
+
+    //! size of the mapped region
+    size_t region_size_ = 0;
+
+    //! begin of the first slot
+    char* begin_ = nullptr;
+
+    //! whether the region is backed by explicit huge pages
+    bool hugetlb_ = false;
+
+    //! mutex protecting the free-list
+    mutable std::mutex mutex_;
+
+    //! free slots, allocated at construction: never reallocated.
+    std::vector<void*> free_list_;
+};
+
+} // namespace mem
+} // namespace thrill
+
+#endif // !THRILL_MEM_HUGE_PAGE_ARENA_HEADER
+
+/******************************************************************************/
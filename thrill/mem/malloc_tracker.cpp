@@ -18,6 +18,7 @@
 #include <thrill/mem/malloc_tracker.hpp>
 #include <tlx/backtrace.hpp>
 #include <tlx/define.hpp>
+#include <tlx/unused.hpp>
 
 #if __linux__ || __APPLE__ || __FreeBSD__
 
@@ -199,6 +200,82 @@ void update_peak(ssize_t float_curr, ssize_t base_curr) {
         peak_bytes = float_curr + base_curr;
 }
 
+/******************************************************************************/
+// Per-tag memory attribution
+
+//! net and peak memory counted for a tag, padded to avoid false sharing
+struct alignas(64) TagStats {
+    CounterType current;
+    CounterType peak;
+};
+
+static TagStats tag_stats[kMallocTagCount];
+
+#if HAVE_THREAD_LOCAL
+//! current tag of the thread and bytes not yet added to its TagStats
+static thread_local size_t tl_tag = 0;
+static thread_local ssize_t tl_tag_bytes = 0;
+//! smaller than tl_delay_threshold, since it determines the peak's precision
+static const ssize_t tl_tag_threshold = 64 * 1024;
+#endif
+
+//! add the thread-local bytes of the current tag to its TagStats
+ATTRIBUTE_NO_SANITIZE
+static void flush_tag_statistics() {
+#if HAVE_THREAD_LOCAL
+    TagStats& ts = tag_stats[tl_tag];
+    ssize_t mycurr = sync_add_and_fetch(ts.current, tl_tag_bytes);
+    if (mycurr > ts.peak)
+        ts.peak = mycurr;
+    tl_tag_bytes = 0;
+#endif
+}
+
+//! count allocation or free in the thread's current tag
+ATTRIBUTE_NO_SANITIZE
+static inline void tag_count(ssize_t delta) {
+#if HAVE_THREAD_LOCAL
+    tl_tag_bytes += delta;
+    if (tl_tag_bytes > tl_tag_threshold || tl_tag_bytes < -tl_tag_threshold)
+        flush_tag_statistics();
+#else
+    tlx::unused(delta);
+#endif
+}
+
+ATTRIBUTE_NO_SANITIZE
+size_t malloc_tracker_set_tag(size_t tag) {
+#if HAVE_THREAD_LOCAL
+    flush_tag_statistics();
+    size_t prev = tl_tag;
+    tl_tag = tag % kMallocTagCount;
+    return prev;
+#else
+    tlx::unused(tag);
+    return 0;
+#endif
+}
+
+ATTRIBUTE_NO_SANITIZE
+ssize_t malloc_tracker_tag_current(size_t tag) {
+    flush_tag_statistics();
+    return get(tag_stats[tag % kMallocTagCount].current);
+}
+
+ATTRIBUTE_NO_SANITIZE
+ssize_t malloc_tracker_tag_peak(size_t tag) {
+    flush_tag_statistics();
+    return get(tag_stats[tag % kMallocTagCount].peak);
+}
+
+ATTRIBUTE_NO_SANITIZE
+void malloc_tracker_reset_tag(size_t tag) {
+    flush_tag_statistics();
+    TagStats& ts = tag_stats[tag % kMallocTagCount];
+    ts.current = 0;
+    ts.peak = 0;
+}
+
 ATTRIBUTE_NO_SANITIZE
 void flush_memory_statistics() {
 #if HAVE_THREAD_LOCAL
@@ -226,6 +303,7 @@ static void inc_count(size_t inc) {
     tl_stats.total_allocs++;
     tl_stats.current_allocs++;
     tl_stats.bytes += inc;
+    tag_count(inc);
 
     if (tl_stats.bytes > tl_delay_threshold)
         flush_memory_statistics();
@@ -249,6 +327,7 @@ static void dec_count(size_t dec) {
 #if HAVE_THREAD_LOCAL
     tl_stats.current_allocs--;
     tl_stats.bytes -= dec;
+    tag_count(-static_cast<ssize_t>(dec));
 
     if (tl_stats.bytes < -tl_delay_threshold)
         flush_memory_statistics();
@@ -495,6 +574,7 @@ void * bypass_malloc(size_t size) noexcept {
 #endif
 
     ssize_t mycurr = sync_add_and_fetch(base_curr, size);
+    tag_count(size);
 
     total_bytes += size;
     update_peak(float_curr, mycurr);
@@ -536,6 +616,7 @@ void bypass_free(void* ptr, size_t size) noexcept {
 #endif
 
     ssize_t mycurr = sync_sub_and_fetch(base_curr, size);
+    tag_count(-static_cast<ssize_t>(size));
 
     sync_sub_and_fetch(current_allocs, 1);
 
@@ -590,6 +671,7 @@ void * bypass_aligned_alloc(size_t alignment, size_t size) noexcept {
 #endif
 
     ssize_t mycurr = sync_add_and_fetch(base_curr, size);
+    tag_count(size);
 
     total_bytes += size;
     update_peak(float_curr, mycurr);
@@ -631,6 +713,7 @@ void bypass_aligned_free(void* ptr, size_t size) noexcept {
 #endif
 
     ssize_t mycurr = sync_sub_and_fetch(base_curr, size);
+    tag_count(-static_cast<ssize_t>(size));
 
     sync_sub_and_fetch(current_allocs, 1);
 
@@ -72,6 +72,50 @@ void malloc_tracker_print_status();
 //! user function which prints new unfreed areas to stdout since the last call
 void malloc_tracker_print_leaks();
 
+//! \name Scoped Memory Attribution
+//! \{
+
+//! number of attribution tags, tag 0 collects untagged allocations.
+static constexpr size_t kMallocTagCount = 256;
+
+//! set the attribution tag of the calling thread, returns the previous tag.
+//! Allocations and frees of the thread are counted for this tag, frees are
+//! hence credited to the freeing thread's tag.
+size_t malloc_tracker_set_tag(size_t tag);
+
+//! returns the net amount of memory counted for tag since its last reset
+ssize_t malloc_tracker_tag_current(size_t tag);
+
+//! returns the peak net amount of memory counted for tag since its last reset
+ssize_t malloc_tracker_tag_peak(size_t tag);
+
+//! resets the current and peak memory of tag to zero
+void malloc_tracker_reset_tag(size_t tag);
+
+/*!
+ * Scope guard which sets the attribution tag of the calling thread and restores
+ * the previous tag when leaving the scope.
+ */
+class MallocTagScope
+{
+public:
+    explicit MallocTagScope(size_t tag)
+        : prev_(malloc_tracker_set_tag(tag)) { }
+
+    //! non-copyable: delete copy-constructor
+    MallocTagScope(const MallocTagScope&) = delete;
+    //! non-copyable: delete assignment operator
+    MallocTagScope& operator = (const MallocTagScope&) = delete;
+
+    ~MallocTagScope() { malloc_tracker_set_tag(prev_); }
+
+private:
+    //! previous tag to restore
+    size_t prev_;
+};
+
+//! \}
+
 //! launch profiler task
 void StartMemProfiler(common::ProfileThread& sched, common::JsonLogger& logger);
 
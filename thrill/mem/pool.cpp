@@ -24,7 +24,7 @@ namespace mem {
 /******************************************************************************/
 
 Pool& GPool() {
-    static Pool* pool = new Pool();
+    static Pool* pool = new Pool(16384, /* thread_cache */ true);
     return *pool;
 }
 
@@ -383,9 +383,58 @@ void Pool::ObjectPool::self_verify() {
     die_unequal(total_used, total_slots_ - total_free_);
 }
 
+/******************************************************************************/
+// Pool::ThreadCache
+
+struct Pool::ThreadCache {
+    //! number of size classes of small items
+    static constexpr size_t num_classes = 4;
+    //! number of items moved between the cache and an ObjectPool at once
+    static constexpr size_t batch_size = 32;
+    //! maximum number of free items per size class in the cache
+    static constexpr size_t max_items = 4 * batch_size;
+
+    //! free item, the next pointer is stored inside the item
+    struct Item {
+        Item* next;
+    };
+
+    //! Pool this cache belongs to
+    Pool* pool = nullptr;
+    //! singly-linked lists of free items
+    Item* list[num_classes] = { nullptr, nullptr, nullptr, nullptr };
+    //! number of items in each list
+    size_t count[num_classes] = { 0, 0, 0, 0 };
+
+    void push(size_t c, void* ptr) {
+        Item* item = reinterpret_cast<Item*>(ptr);
+        item->next = list[c];
+        list[c] = item;
+        ++count[c];
+    }
+
+    void * pop(size_t c) {
+        Item* item = list[c];
+        list[c] = item->next;
+        --count[c];
+        return item;
+    }
+
+    ~ThreadCache() {
+        if (pool) pool->FlushThreadCache(*this);
+    }
+};
+
+thread_local Pool::ThreadCache Pool::thread_cache_;
+
 /******************************************************************************/
 // internal methods
 
+//! determine size class of small items
+static inline size_t calc_object_class(size_t bytes) {
+    return bytes <= 32 ? 0 : bytes <= 64 ? 1 : bytes <= 128 ? 2 : 3;
+}
+
 //! determine bin for size.
 static inline size_t calc_bin_for_size(size_t size) {
     if (size == 0)
@@ -405,8 +454,9 @@ static inline size_t bin_lower_bound(size_t bin) {
 /******************************************************************************/
 // Pool
 
-Pool::Pool(size_t default_arena_size) noexcept
-    : default_arena_size_(default_arena_size) {
+Pool::Pool(size_t default_arena_size, bool thread_cache) noexcept
+    : use_thread_cache_(thread_cache),
+      default_arena_size_(default_arena_size) {
     std::unique_lock<std::mutex> lock(mutex_);
 
     for (size_t i = 0; i < num_bins + 1; ++i)
@@ -613,6 +663,31 @@ void Pool::IntDeallocateAll() {
     min_free_ = 0;
 }
 
+Pool::ObjectPool* Pool::object_pool(size_t c) {
+    switch (c) {
+    case 0: return object_32_;
+    case 1: return object_64_;
+    case 2: return object_128_;
+    default: return object_256_;
+    }
+}
+
+Pool::ThreadCache* Pool::GetThreadCache() {
+    ThreadCache& tc = thread_cache_;
+    // bind the thread's cache to the first Pool using it
+    if (TLX_UNLIKELY(tc.pool == nullptr))
+        tc.pool = this;
+    return tc.pool == this ? &tc : nullptr;
+}
+
+void Pool::FlushThreadCache(ThreadCache& tc) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (size_t c = 0; c < ThreadCache::num_classes; ++c) {
+        while (tc.list[c] != nullptr)
+            object_pool(c)->deallocate(tc.pop(c));
+    }
+}
+
 size_t Pool::max_size() const noexcept {
     return sizeof(Slot) * std::numeric_limits<uint32_t>::max();
 }
@@ -624,6 +699,20 @@ size_t Pool::bytes_per_arena(size_t arena_size) {
 void* Pool::allocate(size_t bytes) {
     // return malloc(bytes);
 
+    if (bytes <= 256 && use_thread_cache_ && !debug_check_pairing) {
+        if (ThreadCache* tc = GetThreadCache()) {
+            size_t c = calc_object_class(bytes);
+            if (tc->list[c] == nullptr) {
+                // refill a batch of items from the ObjectPool
+                std::unique_lock<std::mutex> lock(mutex_);
+                ObjectPool* pool = object_pool(c);
+                for (size_t i = 0; i < ThreadCache::batch_size; ++i)
+                    tc->push(c, pool->allocate());
+            }
+            return tc->pop(c);
+        }
+    }
+
     std::unique_lock<std::mutex> lock(mutex_);
 
     if (debug) {
@@ -702,6 +791,21 @@ void Pool::deallocate(void* ptr, size_t bytes) {
 
     if (ptr == nullptr) return;
 
+    if (bytes <= 256 && use_thread_cache_ && !debug_check_pairing) {
+        if (ThreadCache* tc = GetThreadCache()) {
+            size_t c = calc_object_class(bytes);
+            tc->push(c, ptr);
+            if (tc->count[c] > ThreadCache::max_items) {
+                // return a batch of items to the ObjectPool
+                std::unique_lock<std::mutex> lock(mutex_);
+                ObjectPool* pool = object_pool(c);
+                for (size_t i = 0; i < ThreadCache::batch_size; ++i)
+                    pool->deallocate(tc->pop(c));
+            }
+            return;
+        }
+    }
+
     std::unique_lock<std::mutex> lock(mutex_);
     if (debug) {
         std::cout << "Pool::deallocate() ptr " << ptr
@@ -70,6 +70,12 @@ namespace mem {
  * For faster allocation, Arenas are categorized into many bins. Bin k always
  * contains all Arenas with log_2(k) to log_2(k+1)-1 free space in them. On
  * allocation and deallocation, the Arenas are moved between bins.
+ *
+ * Small items of up to 256 bytes are kept in ObjectPools of fixed size
+ * classes. If enabled (as in the GPool()), each thread additionally caches
+ * freed small items of the Pool in lock-free singly-linked lists per size
+ * class. The lists are refilled from and returned to the ObjectPools in
+ * batches while holding the mutex, and flushed back when the thread ends.
  */
 class Pool
 {
@@ -80,8 +86,11 @@ class Pool
     static constexpr size_t check_limit = 4 * 1024 * 1024;
 
 public:
-    //! construct with base allocator
-    explicit Pool(size_t default_arena_size = 16384) noexcept;
+    //! construct with base allocator, optionally with per-thread caches of
+    //! small items. A Pool with thread caches must outlive all threads using
+    //! it, since their caches are flushed when the threads end.
+    explicit Pool(size_t default_arena_size = 16384,
+                  bool thread_cache = false) noexcept;
 
     //! non-copyable: delete copy-constructor
     Pool(const Pool&) = delete;
@@ -139,6 +148,16 @@ private:
     //! pool of equally sized items
     class ObjectPool;
 
+    //! per-thread cache of free small items
+    struct ThreadCache;
+
+    //! the cache of the current thread, which belongs to the first Pool with
+    //! thread caches used by the thread.
+    static thread_local ThreadCache thread_cache_;
+
+    //! whether small items are cached per thread
+    bool use_thread_cache_;
+
     //! mutex to protect data structures (remove this if you use it in another
     //! context than Thrill).
     std::mutex mutex_;
@@ -182,6 +201,16 @@ private:
 
     //! deallocate all Arenas
     void IntDeallocateAll();
+
+    //! return ObjectPool of size class c (32, 64, 128, 256 bytes)
+    ObjectPool * object_pool(size_t c);
+
+    //! return thread cache of this Pool, or nullptr if the thread is bound to
+    //! another Pool.
+    ThreadCache * GetThreadCache();
+
+    //! return all items in a thread cache to the ObjectPools
+    void FlushThreadCache(ThreadCache& tc);
 };
 
 //! singleton instance of global pool for I/O data structures
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * thrill/mem/stage_arena.cpp
+ *
+ * Monotonic bump allocator for temporary objects of user functions.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/logger.hpp>
+#include <thrill/mem/malloc_tracker.hpp>
+#include <thrill/mem/stage_arena.hpp>
+
+#include <algorithm>
+
+namespace thrill {
+namespace mem {
+
+StageArena::StageArena(Manager& manager, size_t chunk_size)
+    : manager_(manager), chunk_size_(chunk_size) { }
+
+StageArena::~StageArena() {
+    if (live_ != 0) {
+        LOG1 << "~StageArena(): " << live_ << " allocations are still live";
+    }
+    for (Chunk& c : chunks_) {
+        manager_.subtract(c.size);
+        bypass_free(c.begin, c.size);
+    }
+}
+
+void* StageArena::AllocateSlow(size_t size, size_t alignment) {
+    // try the following chunks, which are free after a rewind
+    while (chunk_index_ + 1 < chunks_.size()) {
+        ++chunk_index_;
+        begin_ = cur_ =
+                     reinterpret_cast<uintptr_t>(chunks_[chunk_index_].begin);
+        end_ = cur_ + chunks_[chunk_index_].size;
+
+        uintptr_t p = (cur_ + alignment - 1) & ~(alignment - 1);
+        if (p + size <= end_) {
+            cur_ = p + size;
+            ++live_;
+            return reinterpret_cast<void*>(p);
+        }
+    }
+
+    // allocate a new chunk, with space for oversized allocations
+    size_t chunk_size = std::max(chunk_size_, size + alignment);
+    char* begin = static_cast<char*>(bypass_malloc(chunk_size));
+    if (!begin)
+        throw std::bad_alloc();
+    manager_.add(chunk_size);
+
+    sLOG << "StageArena::AllocateSlow() new chunk" << chunks_.size()
+         << "size" << chunk_size;
+
+    chunks_.emplace_back(Chunk { begin, chunk_size });
+    chunk_index_ = chunks_.size() - 1;
+    capacity_ += chunk_size;
+
+    begin_ = cur_ = reinterpret_cast<uintptr_t>(begin);
+    end_ = cur_ + chunk_size;
+
+    uintptr_t p = (cur_ + alignment - 1) & ~(alignment - 1);
+    cur_ = p + size;
+    ++live_;
+    return reinterpret_cast<void*>(p);
+}
+
+bool StageArena::Reset() {
+    if (live_ != 0) {
+        sLOG << "StageArena::Reset()" << live_ << "allocations are live";
+        return false;
+    }
+    while (chunks_.size() > 1) {
+        Chunk& c = chunks_.back();
+        manager_.subtract(c.size);
+        bypass_free(c.begin, c.size);
+        capacity_ -= c.size;
+        chunks_.pop_back();
+    }
+    Rewind();
+    return true;
+}
+
+} // namespace mem
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,220 @@
+/*******************************************************************************
+ * thrill/mem/stage_arena.hpp
+ *
+ * Monotonic bump allocator for temporary objects of user functions.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_MEM_STAGE_ARENA_HEADER
+#define THRILL_MEM_STAGE_ARENA_HEADER
+
+#include <thrill/mem/allocator_base.hpp>
+#include <thrill/mem/manager.hpp>
+#include <tlx/define/likely.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace thrill {
+namespace mem {
+
+/*!
+ * A monotonic arena of memory chunks, from which allocations are taken by
+ * bumping a pointer. Deallocation only decrements the number of live
+ * allocations; when it reaches zero, the pointer is rewound to the first chunk.
+ * Hence temporary strings and vectors built in a user function for each item
+ * reuse the same memory. The last allocation is also rolled back when it is
+ * deallocated, which makes a growing vector cheaper.
+ *
+ * The chunks are allocated with bypass_malloc() and accounted in a Manager.
+ * Reset() releases all but the first chunk. The StageBuilder calls it at the
+ * end of each stage, so arena memory must not be kept beyond a stage. The
+ * arena is not thread-safe: each worker Context has its own.
+ */
+class StageArena
+{
+    static constexpr bool debug = false;
+
+public:
+    //! default size of the chunks
+    static constexpr size_t default_chunk_size = 64 * 1024;
+
+    //! construct an empty arena, chunks are allocated lazily.
+    explicit StageArena(Manager& manager,
+                        size_t chunk_size = default_chunk_size);
+
+    //! non-copyable: delete copy-constructor
+    StageArena(const StageArena&) = delete;
+    //! non-copyable: delete assignment operator
+    StageArena& operator = (const StageArena&) = delete;
+
+    //! release all chunks
+    ~StageArena();
+
+    //! allocate size bytes aligned to alignment, which must be a power of two.
+    void * allocate(size_t size,
+                    size_t alignment = alignof(std::max_align_t)) {
+        uintptr_t p = (cur_ + alignment - 1) & ~(alignment - 1);
+        if (TLX_LIKELY(p + size <= end_ && p >= cur_)) {
+            cur_ = p + size;
+            ++live_;
+            return reinterpret_cast<void*>(p);
+        }
+        return AllocateSlow(size, alignment);
+    }
+
+    //! deallocate an allocation of size bytes.
+    void deallocate(void* ptr, size_t size) noexcept {
+        assert(live_ > 0);
+        uintptr_t p = reinterpret_cast<uintptr_t>(ptr);
+        if (p + size == cur_ && p >= begin_) cur_ = p;
+        if (--live_ == 0) Rewind();
+    }
+
+    //! Release all chunks but the first, if there are no live allocations.
+    //! Returns false if allocations are still live.
+    bool Reset();
+
+    //! number of live allocations
+    size_t live() const { return live_; }
+
+    //! total size of the chunks
+    size_t capacity() const { return capacity_; }
+
+private:
+    //! Manager for accounting the chunks
+    Manager& manager_;
+
+    //! size of newly allocated chunks
+    size_t chunk_size_;
+
+    //! allocated chunk
+    struct Chunk {
+        char   * begin;
+        size_t size;
+    };
+
+    //! chunks of the arena, taken in order
+    std::vector<Chunk> chunks_;
+
+    //! index of the current chunk
+    size_t chunk_index_ = 0;
+
+    //! begin, bump pointer, and end of current chunk
+    uintptr_t begin_ = 0, cur_ = 0, end_ = 0;
+
+    //! number of live allocations
+    size_t live_ = 0;
+
+    //! total size of chunks_
+    size_t capacity_ = 0;
+
+    //! rewind the bump pointer to the first chunk
+    void Rewind() {
+        chunk_index_ = 0;
+        if (chunks_.empty()) {
+            begin_ = cur_ = end_ = 0;
+            return;
+        }
+        begin_ = cur_ = reinterpret_cast<uintptr_t>(chunks_[0].begin);
+        end_ = cur_ + chunks_[0].size;
+    }
+
+    //! switch to the next chunk large enough or allocate a new one
+    void * AllocateSlow(size_t size, size_t alignment);
+};
+
+/*!
+ * Allocator for STL containers taking memory from a StageArena, which is
+ * compatible with mem::Allocator.
+ */
+template <typename Type>
+class StageArenaAllocator : public tlx::AllocatorBase<Type>
+{
+public:
+    using value_type = Type;
+    using pointer = Type *;
+    using const_pointer = const Type *;
+    using reference = Type&;
+    using const_reference = const Type&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    //! C++11 type flag
+    using is_always_equal = std::false_type;
+
+    //! Return allocator for different type.
+    template <typename U>
+    struct rebind { using other = StageArenaAllocator<U>; };
+
+    //! Construct StageArenaAllocator with StageArena object
+    explicit StageArenaAllocator(StageArena& arena) noexcept
+        : arena_(&arena) { }
+
+    //! copy-constructor
+    StageArenaAllocator(const StageArenaAllocator&) noexcept = default;
+
+    //! copy-constructor from a rebound allocator
+    template <typename OtherType>
+    StageArenaAllocator(const StageArenaAllocator<OtherType>& other) noexcept
+        : arena_(other.arena_) { }
+
+    //! copy-assignment operator
+    StageArenaAllocator& operator = (const StageArenaAllocator&) noexcept
+        = default;
+
+    //! Attempts to allocate a block of storage with a size large enough to
+    //! contain n elements of member type value_type, and returns a pointer to
+    //! the first element.
+    pointer allocate(size_type n, const void* /* hint */ = nullptr) {
+        if (n > this->max_size())
+            throw std::bad_alloc();
+        return static_cast<Type*>(
+            arena_->allocate(n * sizeof(Type), alignof(Type)));
+    }
+
+    //! Releases a block of storage previously allocated with member allocate
+    //! and not yet released.
+    void deallocate(pointer p, size_type n) const noexcept {
+        arena_->deallocate(p, n * sizeof(Type));
+    }
+
+    //! pointer to StageArena object
+    StageArena* arena_;
+
+    //! Compare to another allocator of same type
+    template <typename Other>
+    bool operator == (const StageArenaAllocator<Other>& other) const noexcept {
+        return (arena_ == other.arena_);
+    }
+
+    //! Compare to another allocator of same type
+    template <typename Other>
+    bool operator != (const StageArenaAllocator<Other>& other) const noexcept {
+        return (arena_ != other.arena_);
+    }
+};
+
+//! string with StageArena allocator
+using arena_string = std::basic_string<
+          char, std::char_traits<char>, StageArenaAllocator<char> >;
+
+//! vector with StageArena allocator
+template <typename T>
+using arena_vector = std::vector<T, StageArenaAllocator<T> >;
+
+} // namespace mem
+} // namespace thrill
+
+#endif // !THRILL_MEM_STAGE_ARENA_HEADER
+
+/******************************************************************************/
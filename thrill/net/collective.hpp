@@ -25,7 +25,11 @@
 #include <tlx/math/is_power_of_two.hpp>
 #include <tlx/math/round_to_power_of_two.hpp>
 
+#include <algorithm>
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace thrill {
 namespace net {
@@ -349,7 +353,7 @@ void Group::Reduce(T& value, size_t root, BinarySumOp sum_op) {
                  << shifted_rank << "<-" << shifted_rank + d;
             T recv_data;
             ReceiveFrom((my_rank + d) % num_hosts, &recv_data);
-            value = sum_op(value, recv_data);
+            common::ReduceAssign(sum_op, value, recv_data);
         }
     }
 }
@@ -386,7 +390,7 @@ void Group::AllReduceAtRoot(T& value, BinarySumOp sum_op) {
         for (size_t p = 1; p < num_hosts(); ++p) {
             T recv_value;
             ReceiveFrom(p, &recv_value);
-            value = sum_op(value, recv_value);
+            common::ReduceAssign(sum_op, value, recv_value);
         }
         // send reduced value back to all peers
         for (size_t p = 1; p < num_hosts(); ++p) {
@@ -431,11 +435,12 @@ void Group::AllReduceHypercube(T& value, BinarySumOp sum_op) {
             T recv_data;
             if (my_host_rank() & d) {
                 connection(peer).SendReceive(&value, &recv_data);
-                value = sum_op(recv_data, value);
+                common::ReduceAssign(sum_op, recv_data, value);
+                value = std::move(recv_data);
             }
             else {
                 connection(peer).ReceiveSend(value, &recv_data);
-                value = sum_op(value, recv_data);
+                common::ReduceAssign(sum_op, value, recv_data);
             }
 
             // LOG << "ALL_REDUCE_HYPERCUBE: Host " << my_host_rank()
@@ -462,15 +467,17 @@ void Group::AllReduceElimination(T& value, BinarySumOp sum_op) {
 }
 
 template <typename T, typename BinarySumOp>
-T Group::SendReceiveReduce(size_t peer, const T& value, BinarySumOp sum_op) {
+void Group::SendReceiveReduce(size_t peer, T& value, BinarySumOp sum_op) {
     T recv_data;
     if (my_host_rank() > peer) {
+        // reduce directly on the receive buffer
         connection(peer).SendReceive(&value, &recv_data);
-        return sum_op(recv_data, value);
+        common::ReduceAssign(sum_op, recv_data, value);
+        value = std::move(recv_data);
     }
     else {
         connection(peer).ReceiveSend(value, &recv_data);
-        return sum_op(value, recv_data);
+        common::ReduceAssign(sum_op, value, recv_data);
     }
 }
 
@@ -490,7 +497,7 @@ void Group::AllReduceEliminationProcess(
         // only hypercube
         size_t peer = host_id ^ group_size;
         if (peer < remaining_hosts) {
-            value = SendReceiveReduce(peer, value, sum_op);
+            SendReceiveReduce(peer, value, sum_op);
         }
     }
     else {
@@ -508,27 +515,30 @@ void Group::AllReduceEliminationProcess(
 
                 T recv_data;
                 ReceiveFrom(peer, &recv_data);
-                if (my_host_rank() > peer)
-                    value = sum_op(recv_data, value);
-                else
-                    value = sum_op(value, recv_data);
+                if (my_host_rank() > peer) {
+                    common::ReduceAssign(sum_op, recv_data, value);
+                    value = std::move(recv_data);
+                }
+                else {
+                    common::ReduceAssign(sum_op, value, recv_data);
+                }
 
                 // important for gathering
                 send_to = peer;
 
                 peer = host_id ^ group_size;
-                value = SendReceiveReduce(peer, value, sum_op);
+                SendReceiveReduce(peer, value, sum_op);
             }
             else if (host_group == group_count - 3) {
                 size_t peer = host_id ^ group_size;
-                value = SendReceiveReduce(peer, value, sum_op);
+                SendReceiveReduce(peer, value, sum_op);
             }
         }
         else {
             // no elimination, execute hypercube
             size_t peer = host_id ^ group_size;
             if (peer < remaining_hosts) {
-                value = SendReceiveReduce(peer, value, sum_op);
+                SendReceiveReduce(peer, value, sum_op);
             }
         }
         remaining_hosts -= group_size;
@@ -546,6 +556,76 @@ void Group::AllReduceEliminationProcess(
     }
 }
 
+/*!
+ * Perform an All-Reduce of a std::vector with a component-wise reduction using
+ * the ring algorithm: the vector is cut into num_hosts() segments, which are
+ * first reduced while passing them around the ring (reduce-scatter), and then
+ * passed around the ring again to distribute the fully reduced segments
+ * (all-gather). Each host hence sends only 2 (p-1)/p times the vector size in
+ * 2 (p-1) steps, instead of the whole vector in each of the log p steps of the
+ * hypercube and elimination algorithms. The segments are reduced in rotated
+ * order, hence the component operation must be commutative.
+ *
+ * \param value The vector to be added to the aggregation, must have the same
+ * size on all hosts.
+ *
+ * \param sum_op The component-wise summation operator
+ */
+template <typename T, typename Operation>
+void Group::AllReduceRing(
+    std::vector<T>& value,
+    common::ComponentSum<std::vector<T>, Operation> sum_op) {
+
+    const size_t num_hosts = this->num_hosts();
+    const size_t my_rank = my_host_rank();
+    if (num_hosts <= 1) return;
+
+    const size_t next = (my_rank + 1) % num_hosts;
+    const size_t prev = (my_rank + num_hosts - 1) % num_hosts;
+
+    // boundaries of the segments
+    auto begin = [&](size_t seg) {
+                     return value.size() * seg / num_hosts;
+                 };
+
+    // send segment send_seg to the next and receive a segment from the previous
+    // host. Host 1 always receives first, hence the ring cannot block.
+    std::vector<T> out, in;
+    auto exchange = [&](size_t send_seg) {
+                        out.assign(value.begin() + begin(send_seg),
+                                   value.begin() + begin(send_seg + 1));
+                        if (my_rank % 2 == 0) {
+                            SendTo(next, out);
+                            ReceiveFrom(prev, &in);
+                        }
+                        else {
+                            ReceiveFrom(prev, &in);
+                            SendTo(next, out);
+                        }
+                    };
+
+    // reduce-scatter: afterwards segment (my_rank + 1) is fully reduced.
+    for (size_t s = 0; s < num_hosts - 1; ++s) {
+        size_t send_seg = (my_rank + num_hosts - s) % num_hosts;
+        size_t recv_seg = (my_rank + num_hosts - s - 1) % num_hosts;
+        exchange(send_seg);
+
+        // reduce the received segment in place, the operation is commutative.
+        assert(in.size() == begin(recv_seg + 1) - begin(recv_seg));
+        sum_op.Accumulate(value, begin(recv_seg), in);
+    }
+
+    // all-gather: pass the reduced segments around the ring.
+    for (size_t s = 0; s < num_hosts - 1; ++s) {
+        size_t send_seg = (my_rank + 1 + num_hosts - s) % num_hosts;
+        size_t recv_seg = (my_rank + num_hosts - s) % num_hosts;
+        exchange(send_seg);
+
+        assert(in.size() == begin(recv_seg + 1) - begin(recv_seg));
+        std::copy(in.begin(), in.end(), value.begin() + begin(recv_seg));
+    }
+}
+
 //! select allreduce implementation (often due to total number of processors)
 template <typename T, typename BinarySumOp>
 void Group::AllReduceSelect(T& value, BinarySumOp sum_op) {
@@ -557,6 +637,36 @@ void Group::AllReduceSelect(T& value, BinarySumOp sum_op) {
         AllReduceAtRoot(value, sum_op);*/
 }
 
+//! whether the component operation of a ComponentSum is commutative, such that
+//! AllReduceRing() may be used.
+template <typename Operation>
+struct IsCommutativeOperation : public std::false_type { };
+
+template <typename T>
+struct IsCommutativeOperation<std::plus<T> >: public std::true_type { };
+
+template <typename T>
+struct IsCommutativeOperation<std::multiplies<T> >: public std::true_type { };
+
+template <typename T>
+struct IsCommutativeOperation<common::minimum<T> >: public std::true_type { };
+
+template <typename T>
+struct IsCommutativeOperation<common::maximum<T> >: public std::true_type { };
+
+//! select allreduce implementation for component-wise sums of vectors: large
+//! vectors are reduced with the ring algorithm.
+template <typename T, typename Operation>
+void Group::AllReduceSelect(
+    std::vector<T>& value,
+    common::ComponentSum<std::vector<T>, Operation> sum_op) {
+    if (IsCommutativeOperation<Operation>::value && num_hosts() > 2 &&
+        value.size() * sizeof(T) >= kAllReduceRingMinSize)
+        AllReduceRing(value, sum_op);
+    else
+        AllReduceElimination(value, sum_op);
+}
+
 /*!
  * Perform an All-Reduce on the workers.  This is done by aggregating all values
  * according to a summation operator and sending them backto all workers.
@@ -98,6 +98,23 @@ public:
     virtual ssize_t SendOne(const void* data, size_t size,
                             Flags flags = NoFlags) = 0;
 
+    //! Non-blocking send of a (data,size) message without copying the data, if
+    //! HasZeroCopy(). The data must then remain unchanged until
+    //! ZeroCopyCompleted() counts past the number of the send call, which is
+    //! stored in id. The default implementation copies via SendOne().
+    virtual ssize_t SendOneZeroCopy(const void* data, size_t size,
+                                    uint32_t* id) {
+        *id = 0;
+        return SendOne(data, size);
+    }
+
+    //! Returns true if SendOneZeroCopy() transmits without copying.
+    virtual bool HasZeroCopy() const { return false; }
+
+    //! Poll completion notifications and return the number of finished
+    //! zero-copy send calls.
+    virtual uint32_t ZeroCopyCompleted() { return 0; }
+
     //! Send any serializable POD item T. if sending fails, a net::Exception is
     //! thrown.
     template <typename T>
@@ -400,12 +400,17 @@ private:
 class AsyncWriteBlock
 {
 public:
+    //! minimum size of Blocks sent without copying, if the Connection supports
+    //! it. Smaller sends are cheaper to copy than to track.
+    static constexpr size_t zerocopy_min_size = 16 * 1024;
+
     //! Construct block writer with callback
     AsyncWriteBlock(Connection& conn, data::PinnedBlock&& block,
                     const AsyncWriteCallback& callback)
         : conn_(&conn),
           block_(std::move(block)),
-          callback_(callback) {
+          callback_(callback),
+          zerocopy_(conn.HasZeroCopy() && block_.size() >= zerocopy_min_size) {
         LOGC(debug_async)
             << "AsyncWriteBlock()"
             << " block_.size()=" << block_.size()
@@ -435,15 +440,25 @@ public:
             << " offset=" << written_size_
             << " size=" << block_.size() - written_size_;
 
-        ssize_t r = conn_->SendOne(
-            block_.data_begin() + written_size_,
-            block_.size() - written_size_);
+        ssize_t r;
+        if (zerocopy_) {
+            r = conn_->SendOneZeroCopy(
+                block_.data_begin() + written_size_,
+                block_.size() - written_size_, &zerocopy_id_);
+        }
+        else {
+            r = conn_->SendOne(
+                block_.data_begin() + written_size_,
+                block_.size() - written_size_);
+        }
 
         if (r <= 0) {
             if (errno == EINTR || errno == EAGAIN) return true;
 
             // signal artificial IsDone, for clean up.
             written_size_ = block_.size();
+            // the data will not arrive, hence do not wait for completion.
+            zerocopy_ = false;
 
             if (errno == EPIPE) {
                 LOG1 << "AsyncWriteBlock() got EPIPE";
@@ -472,8 +487,19 @@ public:
             callback_(*conn_);
             callback_ = AsyncWriteCallback();
         }
-        // release Pin
-        block_.Reset();
+        // release Pin, unless the kernel still transmits from the Block.
+        if (!zerocopy_)
+            block_.Reset();
+    }
+
+    //! true if the Block was sent without copying and the Pin must be held
+    //! until the transmission has completed.
+    bool IsZeroCopy() const { return zerocopy_; }
+
+    //! check if the zero-copy transmission has completed, given the number of
+    //! completed zero-copy send calls on the Connection.
+    bool IsZeroCopyDone(uint32_t completed) const {
+        return static_cast<int32_t>(completed - zerocopy_id_) > 0;
     }
 
     //! Returns conn_
@@ -497,6 +523,12 @@ private:
 
     //! functional object to call once data is complete
     AsyncWriteCallback callback_;
+
+    //! whether the Block is sent with SendOneZeroCopy()
+    bool zerocopy_;
+
+    //! number of the last zero-copy send call on the Connection
+    uint32_t zerocopy_id_ = 0;
 };
 
 /******************************************************************************/
@@ -558,6 +590,11 @@ public:
     //! Cancel all callbacks on a given connection.
     virtual void Cancel(Connection& c) = 0;
 
+    //! Returns true if the Connections are byte streams without message
+    //! boundaries, such that successive writes may be merged into one buffer.
+    //! Message-based transports must keep each write separate.
+    virtual bool IsByteStream() const { return false; }
+
     //! \}
 
     //! \name Asynchronous Data Reader/Writer Callbacks
@@ -688,7 +725,11 @@ public:
         if (terminate_) return;
 
         // calculate time until next timer event
-        if (timer_pq_.empty()) {
+        if (!async_zerocopy_.empty()) {
+            // zero-copy completions are polled, see ReapZeroCopy().
+            DispatchOne(milliseconds(1));
+        }
+        else if (timer_pq_.empty()) {
             LOG << "Dispatch(): empty timer queue - selecting for 10s";
             DispatchOne(milliseconds(10000));
         }
@@ -714,8 +755,33 @@ public:
             async_read_block_.pop_front();
         }
         while (async_write_block_.size() && async_write_block_.front().IsDone()) {
+            // keep zero-copy sent Blocks pinned until the kernel is done.
+            if (async_write_block_.front().IsZeroCopy())
+                async_zerocopy_.emplace_back(
+                    std::move(async_write_block_.front()));
             async_write_block_.pop_front();
         }
+
+        if (!async_zerocopy_.empty())
+            ReapZeroCopy();
+    }
+
+    //! Release the Pins of zero-copy sent Blocks whose transmission the
+    //! kernel reported as completed.
+    void ReapZeroCopy() {
+        Connection* conn = nullptr;
+        uint32_t completed = 0;
+        for (auto it = async_zerocopy_.begin(); it != async_zerocopy_.end(); ) {
+            // poll the notifications only once per Connection
+            if (it->connection() != conn) {
+                conn = it->connection();
+                completed = conn->ZeroCopyCompleted();
+            }
+            if (it->IsZeroCopyDone(completed))
+                it = async_zerocopy_.erase(it);
+            else
+                ++it;
+        }
     }
 
     //! Loop over Dispatch() until terminate_ flag is set.
@@ -740,6 +806,11 @@ public:
         return (async_write_.size() != 0) || (async_write_block_.size() != 0);
     }
 
+    //! Check whether Blocks sent without copying are still pinned.
+    bool HasZeroCopyWrites() const {
+        return async_zerocopy_.size() != 0;
+    }
+
     //! \}
 
 protected:
@@ -804,6 +875,11 @@ protected:
     //! deque of asynchronous writers
     std::deque<AsyncWriteBlock,
                mem::GPoolAllocator<AsyncWriteBlock> > async_write_block_;
+
+    //! deque of finished asynchronous writers, which hold the Pins of Blocks
+    //! sent without copying until the kernel reports their completion.
+    std::deque<AsyncWriteBlock,
+               mem::GPoolAllocator<AsyncWriteBlock> > async_zerocopy_;
 };
 
 //! \}
@@ -12,6 +12,7 @@
 #include <thrill/net/dispatcher_thread.hpp>
 #include <thrill/net/group.hpp>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 #include <vector>
@@ -113,6 +114,18 @@ void DispatcherThread::AsyncWrite(
     // the following captures the move-only buffer in a lambda.
     Enqueue([=, &c,
              b1 = std::move(buffer), b2 = std::move(block)]() mutable {
+                if (b2.size() <= coalesce_block_size &&
+                    dispatcher_->IsByteStream()) {
+                    // copy small blocks behind the header, which saves one
+                    // send() call and possibly one packet.
+                    Buffer b(b1.size() + b2.size());
+                    std::copy(b1.begin(), b1.end(), b.begin());
+                    std::copy(b2.data_begin(), b2.data_end(),
+                              b.begin() + b1.size());
+                    b2.Reset();
+                    dispatcher_->AsyncWrite(c, seq, std::move(b), done_cb);
+                    return;
+                }
                 dispatcher_->AsyncWrite(c, seq, std::move(b1));
                 dispatcher_->AsyncWrite(c, seq + 1, std::move(b2), done_cb);
             });
@@ -142,7 +155,8 @@ void DispatcherThread::Work() {
     common::SetCpuAffinity(std::thread::hardware_concurrency() - 1);
 
     while (!terminate_ ||
-           dispatcher_->HasAsyncWrites() || !jobqueue_.empty())
+           dispatcher_->HasAsyncWrites() || dispatcher_->HasZeroCopyWrites() ||
+           !jobqueue_.empty())
     {
         // process jobs in jobqueue_
         {
@@ -62,6 +62,9 @@ class DispatcherThread
     static constexpr bool debug = false;
 
 public:
+    //! maximum size of blocks which are coalesced with their header
+    static constexpr size_t coalesce_block_size = 16 * 1024;
+
     //! Signature of async jobs to be run by the dispatcher thread.
     using Job = tlx::delegate<void (), mem::GPoolAllocator<char> >;
 
@@ -124,7 +127,8 @@ public:
     //! asynchronously write TWO buffers and callback when delivered. The
     //! buffer2 are MOVED into the async writer. This is most useful to write a
     //! header and a payload Buffers that are hereby guaranteed to be written in
-    //! order.
+    //! order. On byte stream connections, blocks up to coalesce_block_size are
+    //! copied behind the header into one buffer and sent with a single write.
     void AsyncWrite(Connection& c, uint32_t seq,
                     Buffer&& buffer, data::PinnedBlock&& block,
                     const AsyncWriteCallback& done_cb = AsyncWriteCallback());
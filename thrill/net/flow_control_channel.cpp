@@ -10,6 +10,7 @@
 
 #include <thrill/net/flow_control_channel.hpp>
 
+#include <cassert>
 #include <functional>
 
 namespace thrill {
@@ -20,7 +21,7 @@ namespace net {
 
 FlowControlChannel::FlowControlChannel(
     Group& group, size_t local_id, size_t thread_count,
-    common::ThreadBarrier& barrier, LocalData* shmem,
+    common::ThreadBarrierCombine& barrier, LocalData* shmem,
     std::atomic<size_t>& generation)
     : group_(group),
       host_rank_(group_.my_host_rank()), num_hosts_(group_.num_hosts()),
@@ -54,7 +55,7 @@ void FlowControlChannel::Barrier() {
     LOG << "FCC::Barrier() ENTER count=" << count_barrier_;
 
     barrier_.wait(
-        [&]() {
+        local_id_, [&]() {
             RunTimer net_timer(timer_communication_);
 
             LOG << "FCC::Barrier() COMMUNICATE BEGIN"
@@ -72,7 +73,44 @@ void FlowControlChannel::Barrier() {
 }
 
 void FlowControlChannel::LocalBarrier() {
-    barrier_.wait();
+    common::CollectiveWaitTimer wait_timer;
+    barrier_.wait(local_id_);
+}
+
+/******************************************************************************/
+// FlowControlChannel::Batch
+
+void FlowControlChannel::Batch::Execute() {
+    if (values_.empty()) return;
+
+    auto sum_op =
+        [this](const std::vector<std::string>& a,
+               const std::vector<std::string>& b) {
+            assert(a.size() == b.size());
+            std::vector<std::string> out(a.size());
+            for (size_t i = 0; i < a.size(); ++i)
+                out[i] = combines_[i](a[i], b[i]);
+            return out;
+        };
+
+    std::vector<std::string> prefix, total;
+    if (has_prefix_sum_) {
+        prefix = values_;
+        total = channel_.ExPrefixSumTotal(prefix, sum_op, initials_);
+    }
+    else {
+        prefix = initials_;
+        total = channel_.AllReduce(values_, sum_op);
+    }
+
+    for (size_t i = 0; i < results_.size(); ++i)
+        results_[i](prefix[i], total[i]);
+
+    values_.clear();
+    initials_.clear();
+    combines_.clear();
+    results_.clear();
+    has_prefix_sum_ = false;
 }
 
 /******************************************************************************/
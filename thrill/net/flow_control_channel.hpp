@@ -17,12 +17,14 @@
 #include <thrill/common/functional.hpp>
 #include <thrill/common/stats_timer.hpp>
 #include <thrill/common/thread_barrier.hpp>
+#include <thrill/common/wait_stats.hpp>
 #include <thrill/net/group.hpp>
 
 #include <algorithm>
 #include <array>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <utility>
@@ -40,10 +42,17 @@ namespace net {
  * This wraps a raw net group, adds multi-worker/thread support, and should be
  * used for flow control with integral types.
  *
+ * The local worker threads synchronize using a combining tree barrier with one
+ * cache-line-padded slot per thread: reductions are combined up the tree by the
+ * worker threads, and only thread 0 communicates via the net::Group. With the
+ * thread sanitizer, a blocking mutex barrier is used instead.
+ *
  * Important notice on threading: It is not allowed to call two different
  * methods of two different instances of FlowControlChannel simultaniously by
  * different threads, since the internal synchronization state (the barrier) is
- * shared globally.
+ * shared by all channels of a FlowControlChannelManager. Channels of different
+ * FlowControlChannelManagers, which use different net::Groups, are independent
+ * and may be used concurrently.
  */
 class FlowControlChannel
 {
@@ -68,8 +77,16 @@ private:
 
     //! Timer or FakeTimer
     using Timer = common::StatsTimerBaseStopped<enable_stats>;
-    //! RIAA class for running the timer
-    using RunTimer = common::RunTimer<Timer>;
+    //! RIAA class for running the timer, which also counts the time as
+    //! collective wait of the worker thread.
+    class RunTimer : public common::RunTimer<Timer>
+    {
+    public:
+        explicit RunTimer(Timer& timer) : common::RunTimer<Timer>(timer) { }
+
+    private:
+        common::CollectiveWaitTimer wait_timer_;
+    };
 
     //! Synchronization timer
     Timer timer_prefixsum_;
@@ -89,9 +106,9 @@ private:
     common::AtomicMovable<size_t> count_predecessor_ { 0 };
     common::AtomicMovable<size_t> count_barrier_ { 0 };
 
-    //! The shared barrier used to synchronize between worker threads on this
-    //! node.
-    common::ThreadBarrier& barrier_;
+    //! The shared combining barrier used to synchronize between worker threads
+    //! on this node.
+    common::ThreadBarrierCombine& barrier_;
 
     //! Thread local data structure: aligned such that no cache line is
     //! shared. The actual vector is in the FlowControlChannelManager.
@@ -187,7 +204,7 @@ public:
     //! Creates a new instance of this class, wrapping a net::Group.
     FlowControlChannel(
         Group& group, size_t local_id, size_t thread_count,
-        common::ThreadBarrier& barrier, LocalData* shmem,
+        common::ThreadBarrierCombine& barrier, LocalData* shmem,
         std::atomic<size_t>& generation);
 
     //! Return the associated net::Group. USE AT YOUR OWN RISK.
@@ -247,7 +264,7 @@ public:
         SetLocalShared(step, &local_value);
 
         barrier_.wait(
-            [&]() {
+            local_id_, [&]() {
                 RunTimer net_timer(timer_communication_);
 
                 LOG << "FCC::PrefixSum() COMMUNICATE BEGIN"
@@ -362,7 +379,7 @@ public:
         SetLocalShared(step, &result);
 
         barrier_.wait(
-            [&]() {
+            local_id_, [&]() {
                 RunTimer net_timer(timer_communication_);
 
                 LOG << "FCC::ExPrefixSumTotal() COMMUNICATE BEGIN"
@@ -442,7 +459,7 @@ public:
         }
 
         barrier_.wait(
-            [&]() {
+            local_id_, [&]() {
                 LOG << "FCC::Broadcast() COMMUNICATE BEGIN"
                     << " count=" << count_broadcast_;
 
@@ -461,6 +478,77 @@ public:
         return local;
     }
 
+    /*!
+     * Broadcasts a value of a copyable type T from the worker with local id
+     * origin to all other workers on the same host. No network communication
+     * is performed, hence T need not be serializable, and may e.g. be a
+     * std::shared_ptr to a data structure shared by the host's workers.
+     *
+     * \param value The value to broadcast. This value is ignored for each
+     * worker except the origin.
+     *
+     * \param origin Local worker id to broadcast value from.
+     *
+     * \return The value of the origin.
+     */
+    template <typename T>
+    T TLX_ATTRIBUTE_WARN_UNUSED_RESULT
+    LocalBroadcast(const T& value, size_t origin = 0) {
+
+        T local = value;
+
+        size_t step = GetNextStep();
+        SetLocalShared(step, &local);
+
+        barrier_.wait(
+            local_id_, [&]() {
+                // copy from origin to all others
+                T res = *GetLocalShared<T>(step, origin);
+                for (size_t i = 0; i < thread_count_; i++) {
+                    *GetLocalShared<T>(step, i) = res;
+                }
+            });
+
+        return local;
+    }
+
+    /*!
+     * Broadcasts a value of a serializable type T from the worker with rank
+     * origin to all other workers, but only one copy of the value is
+     * constructed per host and shared read-only by all workers on the host.
+     * Hence the memory needed does not grow with the number of workers per
+     * host, as it does with Broadcast().
+     *
+     * \param value The value to broadcast. This value is ignored for each
+     * worker except the origin.
+     *
+     * \param origin Worker rank to broadcast value from.
+     *
+     * \return A reference counted pointer to the host's copy of the value.
+     */
+    template <typename T>
+    std::shared_ptr<const T> TLX_ATTRIBUTE_WARN_UNUSED_RESULT
+    SharedBroadcast(const T& value, size_t origin = 0) {
+
+        RunTimer run_timer(timer_broadcast_);
+        if (enable_stats || debug) ++count_broadcast_;
+
+        // the primary thread of each host receives the value and wraps it
+        size_t primary_pe = origin % thread_count_;
+
+        std::shared_ptr<const T> shared;
+        if (local_id_ == primary_pe) {
+            T local = value;
+            {
+                RunTimer net_timer(timer_communication_);
+                group_.Broadcast(local, origin / thread_count_);
+            }
+            shared = std::make_shared<const T>(std::move(local));
+        }
+
+        return LocalBroadcast(shared, primary_pe);
+    }
+
     /*!
      * Gathers the value of a serializable type T over all workers and
      * provides result to all workers as a shared pointer to a
@@ -487,7 +575,7 @@ public:
         SetLocalShared(step, &local);
 
         barrier_.wait(
-            [&]() {
+            local_id_, [&]() {
                 RunTimer net_timer(timer_communication_);
 
                 size_t n = num_workers();
@@ -553,18 +641,21 @@ public:
         size_t step = GetNextStep();
         SetLocalShared(step, &local);
 
-        barrier_.wait(
+        barrier_.wait_combine(
+            local_id_,
+            [&](size_t child) {
+                // local reduce of the subtree of child up the barrier's tree
+                common::ReduceAssign(
+                    sum_op, local, *GetLocalShared<T>(step, child));
+            },
             [&]() {
                 RunTimer net_timer(timer_communication_);
 
                 LOG << "FCC::Reduce() COMMUNICATE BEGIN"
                     << " count=" << count_reduce_;
 
-                // local reduce
+                // local sum was reduced into the value of thread 0
                 T local_sum = *GetLocalShared<T>(step, 0);
-                for (size_t i = 1; i < thread_count_; i++) {
-                    local_sum = sum_op(local_sum, *GetLocalShared<T>(step, i));
-                }
 
                 // global reduce
                 group_.Reduce(local_sum, root / thread_count_, sum_op);
@@ -607,18 +698,21 @@ public:
         size_t step = GetNextStep();
         SetLocalShared(step, &local);
 
-        barrier_.wait(
+        barrier_.wait_combine(
+            local_id_,
+            [&](size_t child) {
+                // local reduce of the subtree of child up the barrier's tree
+                common::ReduceAssign(
+                    sum_op, local, *GetLocalShared<T>(step, child));
+            },
             [&]() {
                 RunTimer net_timer(timer_communication_);
 
                 LOG << "FCC::AllReduce() COMMUNICATE BEGIN"
                     << " count=" << count_allreduce_;
 
-                // local reduce
+                // local sum was reduced into the value of thread 0
                 T local_sum = *GetLocalShared<T>(step, 0);
-                for (size_t i = 1; i < thread_count_; i++) {
-                    local_sum = sum_op(local_sum, *GetLocalShared<T>(step, i));
-                }
 
                 // global reduce
                 group_.AllReduce(local_sum, sum_op);
@@ -764,12 +858,13 @@ public:
         }
 
         // await until all threads have retrieved their value.
-        barrier_.wait([this]() {
-                          LOG << "FCC::Predecessor() COMMUNICATE"
-                              << " count=" << count_predecessor_;
+        barrier_.wait(
+            local_id_, [this]() {
+                LOG << "FCC::Predecessor() COMMUNICATE"
+                    << " count=" << count_predecessor_;
 
-                          generation_++;
-                      });
+                generation_++;
+            });
 
         LOG << "FCC::Predecessor() EXIT count=" << count_predecessor_;
 
@@ -781,6 +876,140 @@ public:
 
     //! A trivial local thread barrier
     void LocalBarrier();
+
+    //! Collects several collective operations, which are executed in one
+    //! round, see below.
+    class Batch;
+};
+
+/*!
+ * Collects several AllReduce, Broadcast, and PrefixSum operations, which are
+ * then executed in a single collective round over a vector of serialized
+ * values by Execute(), instead of one latency round per operation. All workers
+ * must add the same operations in the same order. The values are written back
+ * into the pointed-to variables by Execute().
+ *
+ * The empty string is used as neutral element of all operations, hence all
+ * values must have a non-empty serialization.
+ */
+class FlowControlChannel::Batch
+{
+public:
+    explicit Batch(FlowControlChannel& channel)
+        : channel_(channel) { }
+
+    //! Add an AllReduce of *value, see FlowControlChannel::AllReduce().
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    void AllReduce(T* value, const BinarySumOp& sum_op = BinarySumOp()) {
+        Add(Serialize(*value), std::string(), MakeCombine<T>(sum_op),
+            [value](const std::string& /* prefix */, const std::string& total) {
+                *value = Deserialize<T>(total);
+            });
+    }
+
+    //! Add a Broadcast of *value from worker origin, see
+    //! FlowControlChannel::Broadcast().
+    template <typename T>
+    void Broadcast(T* value, size_t origin = 0) {
+        Add(channel_.my_rank() == origin ? Serialize(*value) : std::string(),
+            std::string(),
+            [](const std::string& a, const std::string& b) {
+                return a.empty() ? b : a;
+            },
+            [value](const std::string& /* prefix */, const std::string& total) {
+                *value = Deserialize<T>(total);
+            });
+    }
+
+    //! Add an inclusive prefix sum of *value, see
+    //! FlowControlChannel::PrefixSum().
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    void PrefixSum(T* value, const BinarySumOp& sum_op = BinarySumOp(),
+                   const T& initial = T()) {
+        auto combine = MakeCombine<T>(sum_op);
+        std::string local = Serialize(*value);
+        Add(local, Serialize(initial), combine,
+            [value, combine, local](
+                const std::string& prefix, const std::string& /* total */) {
+                *value = Deserialize<T>(combine(prefix, local));
+            });
+        has_prefix_sum_ = true;
+    }
+
+    //! Add an exclusive prefix sum of *value, see
+    //! FlowControlChannel::ExPrefixSum().
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    void ExPrefixSum(T* value, const BinarySumOp& sum_op = BinarySumOp(),
+                     const T& initial = T()) {
+        Add(Serialize(*value), Serialize(initial), MakeCombine<T>(sum_op),
+            [value](const std::string& prefix, const std::string& /* total */) {
+                *value = Deserialize<T>(prefix);
+            });
+        has_prefix_sum_ = true;
+    }
+
+    //! Returns the number of collected operations.
+    size_t size() const { return values_.size(); }
+
+    //! Execute all collected operations in one collective round, and clear
+    //! the batch.
+    void Execute();
+
+private:
+    using Combine =
+        std::function<std::string(const std::string&, const std::string&)>;
+    using SetResult =
+        std::function<void(const std::string&, const std::string&)>;
+
+    //! the flow control channel to run the collective on
+    FlowControlChannel& channel_;
+
+    //! serialized local values of the operations
+    std::vector<std::string> values_;
+
+    //! serialized initial values of the operations
+    std::vector<std::string> initials_;
+
+    //! combine functions of the serialized values
+    std::vector<Combine> combines_;
+
+    //! functions setting the result values
+    std::vector<SetResult> results_;
+
+    //! true if any prefix sum was added, then an ExPrefixSumTotal is required.
+    bool has_prefix_sum_ = false;
+
+    void Add(const std::string& value, const std::string& initial,
+             const Combine& combine, const SetResult& result) {
+        values_.emplace_back(value);
+        initials_.emplace_back(initial);
+        combines_.emplace_back(combine);
+        results_.emplace_back(result);
+    }
+
+    //! make a combine function of serialized values from sum_op
+    template <typename T, typename BinarySumOp>
+    static Combine MakeCombine(const BinarySumOp& sum_op) {
+        return [sum_op](const std::string& a, const std::string& b) {
+                   if (a.empty()) return b;
+                   if (b.empty()) return a;
+                   return Serialize(
+                       T(sum_op(Deserialize<T>(a), Deserialize<T>(b))));
+               };
+    }
+
+    template <typename T>
+    static std::string Serialize(const T& value) {
+        BufferBuilder bb;
+        data::Serialization<BufferBuilder, T>::Serialize(value, bb);
+        return bb.ToString();
+    }
+
+    template <typename T>
+    static T Deserialize(const std::string& str) {
+        BufferReader br(str);
+        return data::Serialization<BufferReader, T>::Deserialize(br);
+    }
 };
 
 /******************************************************************************/
@@ -29,9 +29,9 @@ namespace net {
 class FlowControlChannelManager
 {
 private:
-    //! The shared barrier used to synchronize between worker threads on this
-    //! node.
-    common::ThreadBarrier barrier_;
+    //! The shared combining barrier used to synchronize between worker threads
+    //! on this node.
+    common::ThreadBarrierCombine barrier_;
 
     //! The flow control channels associated with this node.
     std::vector<FlowControlChannel> channels_;
@@ -78,6 +78,9 @@ public:
     FlowControlChannel& GetFlowControlChannel(size_t thread_id) {
         return channels_[thread_id];
     }
+
+    //! the shared barrier of the flow control channels
+    common::ThreadBarrierCombine& barrier() { return barrier_; }
 };
 
 //! \}
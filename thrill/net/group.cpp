@@ -71,7 +71,7 @@ net::Traffic Manager::Traffic() const {
         Group& group = *groups_[g];
 
         for (size_t h = 0; h < group.num_hosts(); ++h) {
-            if (h == group.my_host_rank()) continue;
+            if (h == group.my_host_rank() || !group.IsConnected(h)) continue;
 
             total_tx += group.connection(h).tx_bytes_;
             total_rx += group.connection(h).rx_bytes_;
@@ -105,7 +105,7 @@ void Manager::RunTask(const std::chrono::steady_clock::time_point& tp) {
         std::vector<size_t> rx_per_host(group.num_hosts());
 
         for (size_t h = 0; h < group.num_hosts(); ++h) {
-            if (h == group.my_host_rank()) continue;
+            if (h == group.my_host_rank() || !group.IsConnected(h)) continue;
 
             Connection& conn = group.connection(h);
 
@@ -23,8 +23,10 @@
 #include <thrill/net/connection.hpp>
 
 #include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <functional>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -74,6 +76,11 @@ public:
     //! Return Connection to client id.
     virtual Connection& connection(size_t id) = 0;
 
+    //! Return whether the Connection to client id is established. Groups with
+    //! lazy connection setup return false for peers which were not contacted
+    //! yet, since connection(id) would connect them.
+    virtual bool IsConnected(size_t /* id */) const { return true; }
+
     //! Close
     virtual void Close() = 0;
 
@@ -99,6 +106,39 @@ public:
 
     //! \}
 
+    //! \name Connection Stripes
+    //! \{
+
+    /*!
+     * Add a Group of the same hosts, whose connections are used as an
+     * additional stripe of the connections to each peer. The data Multiplexer
+     * distributes Blocks round-robin over the stripes, such that multiple
+     * connections per peer can be served by multiple dispatcher threads.
+     */
+    void AddStripe(std::unique_ptr<Group> group) {
+        assert(group->num_hosts() == num_hosts());
+        assert(group->my_host_rank() == my_host_rank());
+        stripes_.emplace_back(std::move(group));
+    }
+
+    //! Number of connections to each peer, including connection(id).
+    size_t num_stripes() const { return 1 + stripes_.size(); }
+
+    //! Return Connection stripe to client id, stripe 0 is connection(id).
+    Connection& stripe_connection(size_t id, size_t stripe) {
+        assert(stripe < num_stripes());
+        if (stripe == 0) return connection(id);
+        return stripes_[stripe - 1]->connection(id);
+    }
+
+    //! Close the connections of the additional stripes
+    void CloseStripes() {
+        for (std::unique_ptr<Group>& g : stripes_)
+            g->Close();
+    }
+
+    //! \}
+
     //! \name Convenience Functions
     //! \{
 
@@ -204,20 +244,33 @@ public:
     template <typename T, typename BinarySumOp = std::plus<T> >
     void AllReduceElimination(T& value, BinarySumOp sum_op = BinarySumOp());
 
+    //! minimum size in bytes of vectors reduced with AllReduceRing() instead
+    //! of AllReduceElimination() by AllReduceSelect().
+    static constexpr size_t kAllReduceRingMinSize = 64 * 1024;
+
+    template <typename T, typename Operation>
+    void AllReduceSelect(
+        std::vector<T>& value,
+        common::ComponentSum<std::vector<T>, Operation> sum_op);
+
+    template <typename T, typename Operation>
+    void AllReduceRing(
+        std::vector<T>& value,
+        common::ComponentSum<std::vector<T>, Operation> sum_op);
+
     /**************************************************************************/
 
 protected:
     /*!
      * Helper method for AllReduce(). Sends, receives, and reduces a
-     * serializable type from the given peer and returns the value after
-     * reduction
+     * serializable type from the given peer into value.
      *
      * \param peer   The peer to exchange the fixed length type with.
      * \param value  Reference to the value exchange.
      * \param sum_op Reduction operation.
      */
     template <typename T, typename BinarySumOp>
-    T SendReceiveReduce(size_t peer, const T& value, BinarySumOp sum_op);
+    void SendReceiveReduce(size_t peer, T& value, BinarySumOp sum_op);
 
     //! Helper method for AllReduce().
     template <typename T, typename BinarySumOp>
@@ -231,6 +284,9 @@ protected:
     //! our rank in the network group
     size_t my_rank_;
 
+    //! Groups holding the additional connection stripes
+    std::vector<std::unique_ptr<Group> > stripes_;
+
     //! \name Virtual Synchronous Collectives to Override Implementations
     //! \{
 
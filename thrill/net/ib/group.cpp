@@ -0,0 +1,621 @@
+/*******************************************************************************
+ * thrill/net/ib/group.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/net/ib/group.hpp>
+
+#include <thrill/common/logger.hpp>
+#include <thrill/net/exception.hpp>
+#include <thrill/net/mpi/group.hpp>
+
+#include <tlx/die.hpp>
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+namespace thrill {
+namespace net {
+namespace ib {
+
+/******************************************************************************/
+// ib::Device
+
+/*!
+ * The opened InfiniBand device with its protection domain and the attributes
+ * of the used port, shared by all Groups of the process.
+ */
+class Device
+{
+    static constexpr bool debug = false;
+
+public:
+    //! port of the device which is used
+    static constexpr uint8_t port = 1;
+
+    //! open the first InfiniBand device
+    Device() {
+        int num_devices = 0;
+        ibv_device** list = ibv_get_device_list(&num_devices);
+        if (!list || num_devices == 0) {
+            if (list) ibv_free_device_list(list);
+            throw Exception("No InfiniBand device found");
+        }
+
+        context_ = ibv_open_device(list[0]);
+        std::string name = ibv_get_device_name(list[0]);
+        ibv_free_device_list(list);
+        if (!context_)
+            throw Exception("Could not open InfiniBand device " + name, errno);
+
+        pd_ = ibv_alloc_pd(context_);
+        if (!pd_)
+            throw Exception("Could not allocate InfiniBand protection domain",
+                            errno);
+
+        if (ibv_query_port(context_, port, &port_attr_) != 0)
+            throw Exception("Could not query InfiniBand port", errno);
+
+        sLOG << "ib::Device opened" << name << "lid" << port_attr_.lid;
+    }
+
+    //! non-copyable: delete copy-constructor
+    Device(const Device&) = delete;
+    //! non-copyable: delete assignment operator
+    Device& operator = (const Device&) = delete;
+
+    ~Device() {
+        if (pd_) ibv_dealloc_pd(pd_);
+        if (context_) ibv_close_device(context_);
+    }
+
+    ibv_context * context() const { return context_; }
+    ibv_pd * pd() const { return pd_; }
+    const ibv_port_attr& port_attr() const { return port_attr_; }
+
+private:
+    //! device context
+    ibv_context* context_ = nullptr;
+
+    //! protection domain of all memory regions and queue pairs
+    ibv_pd* pd_ = nullptr;
+
+    //! attributes of the port
+    ibv_port_attr port_attr_;
+};
+
+/******************************************************************************/
+// ib::Connection
+
+//! offsets of the fields of a Slot, used for remote addresses
+static const uint64_t kSlotHead = offsetof(Slot, head);
+static const uint64_t kSlotTail = offsetof(Slot, tail);
+static const uint64_t kSlotData = sizeof(Slot);
+
+Connection::~Connection() {
+    if (qp_) ibv_destroy_qp(qp_);
+}
+
+bool Connection::readable() const {
+    return rx_slot_->head.load(std::memory_order_acquire) != rx_tail_;
+}
+
+bool Connection::writable() const {
+    return tx_head_ - rx_slot_->tail.load(std::memory_order_acquire)
+           < group_->ring_size_;
+}
+
+std::string Connection::ToString() const {
+    return "peer: " + std::to_string(peer_);
+}
+
+std::ostream& Connection::OutputOstream(std::ostream& os) const {
+    return os << "[ib::Connection"
+              << " group=" << group_
+              << " peer=" << peer_
+              << "]";
+}
+
+void Connection::PostWrite(const void* local, uint64_t remote, size_t size,
+                           bool is_inline) {
+    // limit the work requests in the send queue: all unsignalled ones finish
+    // before the next signalled one.
+    while (outstanding_ + 1 >= Group::max_send_wr / Group::signal_interval)
+        group_->PollCompletions();
+
+    ibv_sge sge;
+    sge.addr = reinterpret_cast<uint64_t>(local);
+    sge.length = static_cast<uint32_t>(size);
+    sge.lkey = group_->mr_->lkey;
+
+    ibv_send_wr wr;
+    memset(&wr, 0, sizeof(wr));
+    wr.wr_id = peer_;
+    wr.sg_list = &sge;
+    wr.num_sge = 1;
+    wr.opcode = IBV_WR_RDMA_WRITE;
+    wr.wr.rdma.remote_addr = remote;
+    wr.wr.rdma.rkey = remote_rkey_;
+
+    if (is_inline)
+        wr.send_flags |= IBV_SEND_INLINE;
+
+    if (++unsignalled_ >= Group::signal_interval) {
+        wr.send_flags |= IBV_SEND_SIGNALED;
+        unsignalled_ = 0;
+        ++outstanding_;
+    }
+
+    ibv_send_wr* bad_wr;
+    int r = ibv_post_send(qp_, &wr, &bad_wr);
+    if (r != 0)
+        throw Exception("ib::Connection could not post RDMA write", r);
+}
+
+size_t Connection::TrySend(const void* data, size_t size) {
+    size_t ring_size = group_->ring_size_;
+
+    uint64_t tail = rx_slot_->tail.load(std::memory_order_acquire);
+    size = std::min(size, ring_size - (tx_head_ - tail));
+    if (size == 0) return 0;
+
+    // copy into the staging area at the same position as in the peer's ring,
+    // which is only reused after the peer consumed the data.
+    const uint8_t* cdata = static_cast<const uint8_t*>(data);
+    size_t pos = tx_head_ % ring_size;
+    size_t first = std::min(size, ring_size - pos);
+
+    std::copy(cdata, cdata + first, tx_staging_ + pos);
+    PostWrite(tx_staging_ + pos, remote_slot_ + kSlotData + pos, first, false);
+
+    if (first != size) {
+        std::copy(cdata + first, cdata + size, tx_staging_);
+        PostWrite(tx_staging_, remote_slot_ + kSlotData, size - first, false);
+    }
+
+    // RDMA writes on one reliable connected queue pair are placed in order,
+    // hence the peer sees the new head only after the data.
+    tx_head_ += size;
+    PostWrite(&tx_head_, remote_slot_ + kSlotHead, sizeof(tx_head_), true);
+
+    tx_bytes_ += size;
+    return size;
+}
+
+size_t Connection::TryRecv(void* out_data, size_t size) {
+    size_t ring_size = group_->ring_size_;
+
+    uint64_t head = rx_slot_->head.load(std::memory_order_acquire);
+    size = std::min(size, static_cast<size_t>(head - rx_tail_));
+    if (size == 0) return 0;
+
+    uint8_t* cdata = static_cast<uint8_t*>(out_data);
+    const uint8_t* area = rx_slot_->data();
+    size_t pos = rx_tail_ % ring_size;
+    size_t first = std::min(size, ring_size - pos);
+    std::copy(area + pos, area + pos + first, cdata);
+    std::copy(area, area + (size - first), cdata + first);
+
+    // return the space to the peer
+    rx_tail_ += size;
+    PostWrite(&rx_tail_, remote_slot_ + kSlotTail, sizeof(rx_tail_), true);
+
+    rx_bytes_ += size;
+    return size;
+}
+
+void Connection::SyncSend(const void* data, size_t size, Flags /* flags */) {
+    const uint8_t* cdata = static_cast<const uint8_t*>(data);
+    while (size != 0) {
+        size_t n = TrySend(cdata, size);
+        if (n == 0) {
+            group_->PollCompletions();
+            std::this_thread::yield();
+            continue;
+        }
+        cdata += n, size -= n;
+    }
+    // set errno : success (other syscalls may have failed)
+    errno = 0;
+}
+
+ssize_t Connection::SendOne(const void* data, size_t size, Flags /* flags */) {
+    if (size == 0) return 0;
+    size_t n = TrySend(data, size);
+    if (n == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    errno = 0;
+    return static_cast<ssize_t>(n);
+}
+
+void Connection::SyncRecv(void* out_data, size_t size) {
+    uint8_t* cdata = static_cast<uint8_t*>(out_data);
+    while (size != 0) {
+        size_t n = TryRecv(cdata, size);
+        if (n == 0) {
+            group_->PollCompletions();
+            std::this_thread::yield();
+            continue;
+        }
+        cdata += n, size -= n;
+    }
+    errno = 0;
+}
+
+ssize_t Connection::RecvOne(void* out_data, size_t size) {
+    if (size == 0) return 0;
+    size_t n = TryRecv(out_data, size);
+    if (n == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    errno = 0;
+    return static_cast<ssize_t>(n);
+}
+
+void Connection::SyncSendRecv(const void* send_data, size_t send_size,
+                              void* recv_data, size_t recv_size) {
+    // interleave sending and receiving, since the message may be larger than
+    // the rings, and the peer may also send first.
+    const uint8_t* sdata = static_cast<const uint8_t*>(send_data);
+    uint8_t* rdata = static_cast<uint8_t*>(recv_data);
+    while (send_size != 0 || recv_size != 0) {
+        size_t s = TrySend(sdata, send_size);
+        sdata += s, send_size -= s;
+        size_t r = TryRecv(rdata, recv_size);
+        rdata += r, recv_size -= r;
+        if (s == 0 && r == 0) {
+            group_->PollCompletions();
+            std::this_thread::yield();
+        }
+    }
+    errno = 0;
+}
+
+void Connection::SyncRecvSend(const void* send_data, size_t send_size,
+                              void* recv_data, size_t recv_size) {
+    // the order does not matter, since both directions are interleaved.
+    return SyncSendRecv(send_data, send_size, recv_data, recv_size);
+}
+
+/******************************************************************************/
+// ib::Group
+
+Group::Group(const std::shared_ptr<Device>& device, size_t my_rank,
+             size_t group_size, size_t ring_size)
+    : net::Group(my_rank), device_(device),
+      num_hosts_(group_size), ring_size_(ring_size) {
+
+    conns_ = new Connection[num_hosts_];
+
+    cq_ = ibv_create_cq(device_->context(),
+                        static_cast<int>(num_hosts_ * max_send_wr),
+                        nullptr, nullptr, 0);
+    if (!cq_)
+        throw Exception("Could not create InfiniBand completion queue", errno);
+
+    // allocate and register the inbound Slots and the staging areas
+    memory_size_ = num_hosts_ * (SlotStride() + ring_size_);
+    void* memory;
+    if (posix_memalign(&memory, 4096, memory_size_) != 0)
+        throw Exception("Could not allocate InfiniBand ring buffers");
+    memory_ = static_cast<uint8_t*>(memory);
+    std::fill(memory_, memory_ + memory_size_, 0);
+
+    mr_ = ibv_reg_mr(device_->pd(), memory_, memory_size_,
+                     IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+    if (!mr_)
+        throw Exception("Could not register InfiniBand memory", errno);
+
+    for (size_t i = 0; i < num_hosts_; ++i) {
+        Connection& c = conns_[i];
+        c.group_ = this;
+        c.peer_ = i;
+        c.rx_slot_ = reinterpret_cast<Slot*>(memory_ + i * SlotStride());
+        c.tx_staging_ = memory_ + num_hosts_ * SlotStride() + i * ring_size_;
+
+        ibv_qp_init_attr init_attr;
+        memset(&init_attr, 0, sizeof(init_attr));
+        init_attr.send_cq = cq_;
+        init_attr.recv_cq = cq_;
+        init_attr.qp_type = IBV_QPT_RC;
+        init_attr.cap.max_send_wr = max_send_wr;
+        init_attr.cap.max_recv_wr = 1;
+        init_attr.cap.max_send_sge = 1;
+        init_attr.cap.max_recv_sge = 1;
+        init_attr.cap.max_inline_data = 64;
+
+        c.qp_ = ibv_create_qp(device_->pd(), &init_attr);
+        if (!c.qp_)
+            throw Exception("Could not create InfiniBand queue pair", errno);
+
+        ibv_qp_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.qp_state = IBV_QPS_INIT;
+        attr.pkey_index = 0;
+        attr.port_num = Device::port;
+        attr.qp_access_flags = IBV_ACCESS_REMOTE_WRITE;
+
+        int r = ibv_modify_qp(
+            c.qp_, &attr,
+            IBV_QP_STATE | IBV_QP_PKEY_INDEX | IBV_QP_PORT |
+            IBV_QP_ACCESS_FLAGS);
+        if (r != 0)
+            throw Exception("Could not initialize InfiniBand queue pair", r);
+    }
+}
+
+Group::~Group() {
+    delete[] conns_;
+    if (mr_) ibv_dereg_mr(mr_);
+    free(memory_);
+    if (cq_) ibv_destroy_cq(cq_);
+}
+
+size_t Group::num_hosts() const {
+    return num_hosts_;
+}
+
+net::Connection& Group::connection(size_t peer) {
+    assert(peer < num_hosts_);
+    return conns_[peer];
+}
+
+void Group::Close() { }
+
+std::unique_ptr<net::Dispatcher> Group::ConstructDispatcher() const {
+    // construct ib::Dispatcher
+    return std::make_unique<Dispatcher>();
+}
+
+size_t Group::SlotStride() const {
+    // round up to cache lines
+    return (sizeof(Slot) + ring_size_ + 63) / 64 * 64;
+}
+
+void Group::PollCompletions() {
+    ibv_wc wc[16];
+    int n;
+    while ((n = ibv_poll_cq(cq_, 16, wc)) > 0) {
+        for (int i = 0; i < n; ++i) {
+            if (wc[i].status != IBV_WC_SUCCESS) {
+                throw Exception(
+                    "ib::Group RDMA write to peer "
+                    + std::to_string(wc[i].wr_id) + " failed: "
+                    + ibv_wc_status_str(wc[i].status));
+            }
+            assert(wc[i].wr_id < num_hosts_);
+            --conns_[wc[i].wr_id].outstanding_;
+        }
+    }
+    if (n < 0)
+        throw Exception("Could not poll InfiniBand completion queue");
+}
+
+Group::Endpoint Group::LocalEndpoint(size_t peer) const {
+    Endpoint e;
+    e.lid = device_->port_attr().lid;
+    e.qpn = conns_[peer].qp_->qp_num;
+    e.rkey = mr_->rkey;
+    e.addr = reinterpret_cast<uint64_t>(conns_[peer].rx_slot_);
+    return e;
+}
+
+void Group::Connect(size_t peer, const Endpoint& remote) {
+    Connection& c = conns_[peer];
+    c.remote_slot_ = remote.addr;
+    c.remote_rkey_ = remote.rkey;
+
+    // ready to receive
+    ibv_qp_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_state = IBV_QPS_RTR;
+    attr.path_mtu = device_->port_attr().active_mtu;
+    attr.dest_qp_num = remote.qpn;
+    attr.rq_psn = 0;
+    attr.max_dest_rd_atomic = 1;
+    attr.min_rnr_timer = 12;
+    attr.ah_attr.is_global = 0;
+    attr.ah_attr.dlid = static_cast<uint16_t>(remote.lid);
+    attr.ah_attr.sl = 0;
+    attr.ah_attr.src_path_bits = 0;
+    attr.ah_attr.port_num = Device::port;
+
+    int r = ibv_modify_qp(
+        c.qp_, &attr,
+        IBV_QP_STATE | IBV_QP_AV | IBV_QP_PATH_MTU | IBV_QP_DEST_QPN |
+        IBV_QP_RQ_PSN | IBV_QP_MAX_DEST_RD_ATOMIC | IBV_QP_MIN_RNR_TIMER);
+    if (r != 0)
+        throw Exception("Could not connect InfiniBand queue pair (RTR)", r);
+
+    // ready to send
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_state = IBV_QPS_RTS;
+    attr.timeout = 14;
+    attr.retry_cnt = 7;
+    attr.rnr_retry = 7;
+    attr.sq_psn = 0;
+    attr.max_rd_atomic = 1;
+
+    r = ibv_modify_qp(
+        c.qp_, &attr,
+        IBV_QP_STATE | IBV_QP_TIMEOUT | IBV_QP_RETRY_CNT | IBV_QP_RNR_RETRY |
+        IBV_QP_SQ_PSN | IBV_QP_MAX_QP_RD_ATOMIC);
+    if (r != 0)
+        throw Exception("Could not connect InfiniBand queue pair (RTS)", r);
+
+    sLOG << "ib::Group rank" << my_rank_ << "connected to" << peer
+         << "lid" << remote.lid << "qpn" << remote.qpn;
+}
+
+bool Construct(size_t group_size, std::unique_ptr<Group>* groups,
+               size_t group_count) {
+    static constexpr bool debug = false;
+
+    size_t num_procs = NumMpiProcesses();
+    size_t my_rank = MpiRank();
+    die_unless(group_size <= num_procs);
+
+    // all processes take part in the exchange, even if not in the Groups.
+    bool member = my_rank < group_size;
+
+    std::vector<Group::Endpoint> local(group_count * group_size);
+    std::vector<Group::Endpoint> all(num_procs * local.size());
+
+    if (member) {
+        auto device = std::make_shared<Device>();
+        for (size_t g = 0; g < group_count; ++g) {
+            groups[g] = std::make_unique<Group>(device, my_rank, group_size);
+            for (size_t i = 0; i < group_size; ++i)
+                local[g * group_size + i] = groups[g]->LocalEndpoint(i);
+        }
+    }
+
+    // exchange the Endpoints. This happens during startup, before any
+    // mpi::Group is used, hence the MPI calls need not be serialized.
+    int bytes = static_cast<int>(local.size() * sizeof(Group::Endpoint));
+    int r = MPI_Allgather(local.data(), bytes, MPI_BYTE,
+                          all.data(), bytes, MPI_BYTE, MPI_COMM_WORLD);
+    if (r != MPI_SUCCESS)
+        throw Exception("Error during MPI_Allgather()", r);
+
+    if (member) {
+        for (size_t g = 0; g < group_count; ++g) {
+            for (size_t i = 0; i < group_size; ++i) {
+                groups[g]->Connect(
+                    i, all[(i * group_count + g) * group_size + my_rank]);
+            }
+        }
+    }
+
+    // wait until all queue pairs are ready to receive
+    r = MPI_Barrier(MPI_COMM_WORLD);
+    if (r != MPI_SUCCESS)
+        throw Exception("Error during MPI_Barrier()", r);
+
+    sLOG << "ib::Construct() rank" << my_rank << "member" << member;
+    return member;
+}
+
+size_t NumMpiProcesses() {
+    return mpi::NumMpiProcesses();
+}
+
+size_t MpiRank() {
+    return mpi::MpiRank();
+}
+
+/******************************************************************************/
+// ib::Dispatcher
+
+Dispatcher::Dispatcher()
+    : net::Dispatcher()
+{ }
+
+Dispatcher::~Dispatcher()
+{ }
+
+void Dispatcher::AddRead(net::Connection& _c, const Callback& read_cb) {
+    assert(dynamic_cast<Connection*>(&_c));
+    Connection& c = static_cast<Connection&>(_c);
+    watch_[&c].read_cb.emplace_back(read_cb);
+}
+
+void Dispatcher::AddWrite(net::Connection& _c, const Callback& write_cb) {
+    assert(dynamic_cast<Connection*>(&_c));
+    Connection& c = static_cast<Connection&>(_c);
+    watch_[&c].write_cb.emplace_back(write_cb);
+}
+
+void Dispatcher::Cancel(net::Connection& _c) {
+    assert(dynamic_cast<Connection*>(&_c));
+    Connection& c = static_cast<Connection&>(_c);
+    auto it = watch_.find(&c);
+    if (it == watch_.end()) return;
+    // the Watch is removed by DispatchOne()
+    it->second.read_cb.clear();
+    it->second.write_cb.clear();
+}
+
+void Dispatcher::Interrupt() {
+    // DispatchOne() never blocks, hence there is nothing to interrupt.
+}
+
+void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
+
+    // reap completions of the Groups, which frees send queue entries and
+    // reports failed RDMA writes.
+    std::set<Group*> groups;
+    for (auto& w : watch_)
+        groups.insert(w.first->group());
+    for (Group* g : groups)
+        g->PollCompletions();
+
+    bool progress = false;
+
+    for (auto it = watch_.begin(); it != watch_.end(); ) {
+        Connection* c = it->first;
+        Watch& w = it->second;
+
+        // callbacks may add new callbacks, but never remove watches.
+        if (!w.read_cb.empty() && c->readable()) {
+            progress = true;
+            bool ret = true;
+            try {
+                ret = w.read_cb.front()();
+            }
+            catch (std::exception& e) {
+                LOG1 << "Dispatcher: exception " << typeid(e).name()
+                     << "in read callback.";
+                LOG1 << "  what(): " << e.what();
+                throw;
+            }
+            if (!ret && !w.read_cb.empty()) w.read_cb.pop_front();
+        }
+
+        if (!w.write_cb.empty() && c->writable()) {
+            progress = true;
+            bool ret = true;
+            try {
+                ret = w.write_cb.front()();
+            }
+            catch (std::exception& e) {
+                LOG1 << "Dispatcher: exception " << typeid(e).name()
+                     << "in write callback.";
+                LOG1 << "  what(): " << e.what();
+                throw;
+            }
+            if (!ret && !w.write_cb.empty()) w.write_cb.pop_front();
+        }
+
+        if (w.read_cb.empty() && w.write_cb.empty())
+            it = watch_.erase(it);
+        else
+            ++it;
+    }
+
+    // busy-waiting loop like the mpi::Dispatcher, but let other threads run.
+    if (!progress)
+        std::this_thread::yield();
+}
+
+} // namespace ib
+} // namespace net
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,342 @@
+/*******************************************************************************
+ * thrill/net/ib/group.hpp
+ *
+ * Implementation of a network via InfiniBand verbs: reliable connected queue
+ * pairs transfer data with RDMA writes into ring buffers in registered memory of
+ * the peers. All classes: Group, Connection, and Dispatcher are in this file
+ * since they are tightly interdependent. The hosts are bootstrapped via MPI.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_NET_IB_GROUP_HEADER
+#define THRILL_NET_IB_GROUP_HEADER
+
+#include <thrill/net/dispatcher.hpp>
+#include <thrill/net/group.hpp>
+
+#include <infiniband/verbs.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace net {
+namespace ib {
+
+//! \addtogroup net_ib InfiniBand Network API
+//! \ingroup net
+//! \{
+
+class Group;
+class Dispatcher;
+class Device;
+
+/*!
+ * Inbound slot of a Connection in the registered memory of a Group. The slot
+ * is written only by the peer via RDMA: the data area is a ring buffer, head is
+ * the number of bytes the peer wrote into the ring, and tail is the number of
+ * bytes the peer consumed from the ring it receives from us.
+ */
+struct Slot {
+    //! total bytes written by the peer into data
+    alignas(64) std::atomic<uint64_t> head;
+    //! total bytes read by the peer from our ring in its memory
+    alignas(64) std::atomic<uint64_t> tail;
+
+    //! data area following the Slot
+    uint8_t * data() { return reinterpret_cast<uint8_t*>(this + 1); }
+};
+
+/*!
+ * A connection via a reliable connected InfiniBand queue pair. Each direction
+ * is a byte stream through a ring buffer in the receiver's registered memory,
+ * which the sender fills with RDMA writes from a registered staging copy,
+ * followed by an inline RDMA write of the new head counter. The receiver polls
+ * the head counter in its memory and returns free space by RDMA writing its
+ * tail counter to the sender.
+ */
+class Connection final : public net::Connection
+{
+public:
+    //! destroy the queue pair
+    ~Connection();
+
+    //! true if data can be received from the rx ring
+    bool readable() const;
+
+    //! true if data can be written into the peer's ring
+    bool writable() const;
+
+    //! Group of the Connection, which owns the completion queue
+    Group * group() const { return group_; }
+
+    //! \name Base Status Functions
+    //! \{
+
+    bool IsValid() const final { return qp_ != nullptr; }
+
+    std::string ToString() const final;
+
+    std::ostream& OutputOstream(std::ostream& os) const final;
+
+    //! \}
+
+    //! \name Send Functions
+    //! \{
+
+    void SyncSend(
+        const void* data, size_t size, Flags /* flags */ = NoFlags) final;
+
+    ssize_t SendOne(
+        const void* data, size_t size, Flags flags = NoFlags) final;
+
+    //! \}
+
+    //! \name Receive Functions
+    //! \{
+
+    void SyncRecv(void* out_data, size_t size) final;
+
+    ssize_t RecvOne(void* out_data, size_t size) final;
+
+    //! \}
+
+    //! \name Paired SendReceive Methods
+    //! \{
+
+    void SyncSendRecv(const void* send_data, size_t send_size,
+                      void* recv_data, size_t recv_size) final;
+    void SyncRecvSend(const void* send_data, size_t send_size,
+                      void* recv_data, size_t recv_size) final;
+
+    //! \}
+
+private:
+    //! for access to the queue pair and the ring addresses
+    friend class Group;
+
+    //! Reference to our group.
+    Group* group_ = nullptr;
+
+    //! Outgoing peer id of this Connection.
+    size_t peer_ = size_t(-1);
+
+    //! reliable connected queue pair to the peer
+    ibv_qp* qp_ = nullptr;
+
+    //! inbound slot in our registered memory, written by the peer
+    Slot* rx_slot_ = nullptr;
+
+    //! registered staging copy of the ring in the peer's memory
+    uint8_t* tx_staging_ = nullptr;
+
+    //! address of our inbound slot in the peer's registered memory
+    uint64_t remote_slot_ = 0;
+
+    //! remote key of the peer's registered memory
+    uint32_t remote_rkey_ = 0;
+
+    //! total bytes written into the peer's ring
+    uint64_t tx_head_ = 0;
+
+    //! total bytes read from our rx ring
+    uint64_t rx_tail_ = 0;
+
+    //! RDMA writes posted since the last signalled one
+    size_t unsignalled_ = 0;
+
+    //! signalled RDMA writes whose completion was not yet polled
+    size_t outstanding_ = 0;
+
+    //! post an RDMA write of size bytes from local to the remote address, if
+    //! inline the local data is copied immediately and need not be registered.
+    void PostWrite(const void* local, uint64_t remote, size_t size,
+                   bool is_inline);
+
+    //! copy as much as possible into the peer's ring, returns the bytes written.
+    size_t TrySend(const void* data, size_t size);
+
+    //! copy as much as possible from the rx ring, returns the bytes read.
+    size_t TryRecv(void* out_data, size_t size);
+};
+
+/*!
+ * A Group of hosts connected via InfiniBand. Each Group has its own completion
+ * queue and one registered memory region, which contains the inbound Slots and
+ * the staging copies of the outbound rings of all Connections.
+ */
+class Group final : public net::Group
+{
+    static constexpr bool debug = false;
+
+public:
+    //! default size of each ring buffer
+    static constexpr size_t default_ring_size = 1024 * 1024;
+
+    //! maximum RDMA writes posted per queue pair before polling completions
+    static constexpr size_t max_send_wr = 256;
+
+    //! every signal_interval-th RDMA write is signalled
+    static constexpr size_t signal_interval = 32;
+
+    //! \name Base Functions
+    //! \{
+
+    //! Initialize a Group for the given size and rank, allocates and registers
+    //! the memory and creates the queue pairs.
+    Group(const std::shared_ptr<Device>& device, size_t my_rank,
+          size_t group_size, size_t ring_size = default_ring_size);
+
+    ~Group();
+
+    size_t num_hosts() const final;
+
+    net::Connection& connection(size_t peer) final;
+
+    void Close() final;
+
+    using Dispatcher = ib::Dispatcher;
+
+    std::unique_ptr<net::Dispatcher> ConstructDispatcher() const final;
+
+    //! \}
+
+    //! size of the ring buffers
+    size_t ring_size() const { return ring_size_; }
+
+    /*!
+     * Poll the completion queue and account finished signalled RDMA writes to
+     * their Connections. Throws an Exception if an RDMA write failed.
+     */
+    void PollCompletions();
+
+    //! local address and keys for the peers, exchanged by Construct()
+    struct Endpoint {
+        //! local identifier of the port
+        uint32_t lid;
+        //! number of the queue pair to the peer
+        uint32_t qpn;
+        //! remote key of the registered memory
+        uint32_t rkey;
+        //! address of the peer's inbound Slot
+        uint64_t addr;
+    };
+
+    //! local Endpoint for the Connection to peer
+    Endpoint LocalEndpoint(size_t peer) const;
+
+    //! connect the queue pair of the Connection to peer to the remote Endpoint
+    void Connect(size_t peer, const Endpoint& remote);
+
+private:
+    //! for access to the completion queue and memory region
+    friend class Connection;
+
+    //! the device context shared by all Groups
+    std::shared_ptr<Device> device_;
+
+    //! number of hosts
+    size_t num_hosts_;
+
+    //! size of each ring
+    size_t ring_size_;
+
+    //! completion queue of all queue pairs of this Group
+    ibv_cq* cq_ = nullptr;
+
+    //! registered memory: inbound Slots followed by staging areas
+    uint8_t* memory_ = nullptr;
+
+    //! size of memory_
+    size_t memory_size_ = 0;
+
+    //! memory region of memory_
+    ibv_mr* mr_ = nullptr;
+
+    //! vector of connection objects to peers
+    Connection* conns_;
+
+    //! distance of the inbound Slots in memory_
+    size_t SlotStride() const;
+};
+
+/*!
+ * Connect group_size hosts of the MPI processes via InfiniBand, where the
+ * queue pair endpoints are exchanged using MPI. Constructs group_count
+ * ib::Group objects at once. Like mpi::Construct(), hosts whose MPI rank is not
+ * less than group_size are not included in the Groups and return false.
+ */
+bool Construct(size_t group_size, std::unique_ptr<Group>* groups,
+               size_t group_count);
+
+/*!
+ * Return the number of MPI processes. This is the maximum group size.
+ */
+size_t NumMpiProcesses();
+
+//! Return the rank of this process in the MPI COMM WORLD.
+size_t MpiRank();
+
+/*!
+ * A Dispatcher which polls the rings of the watched Connections and the
+ * completion queues of their Groups. Like the mpi::Dispatcher it runs a
+ * busy-waiting loop, since RDMA writes cause no notification at the receiver.
+ */
+class Dispatcher final : public net::Dispatcher
+{
+    static constexpr bool debug = false;
+
+public:
+    //! type for file descriptor readiness callbacks
+    using Callback = AsyncCallback;
+
+    Dispatcher();
+    ~Dispatcher();
+
+    //! \name Implementation of Virtual Methods
+    //! \{
+
+    void AddRead(net::Connection& _c, const Callback& read_cb) final;
+
+    void AddWrite(net::Connection& _c, const Callback& write_cb) final;
+
+    void Cancel(net::Connection& _c) final;
+
+    //! the rings are byte streams, hence writes may be coalesced.
+    bool IsByteStream() const final { return true; }
+
+    void Interrupt() final;
+
+    void DispatchOne(const std::chrono::milliseconds& timeout) final;
+
+    //! \}
+
+private:
+    //! callback queues per watched connection
+    struct Watch {
+        std::deque<Callback, mem::GPoolAllocator<Callback> > read_cb, write_cb;
+    };
+
+    //! watched connections
+    std::map<Connection*, Watch> watch_;
+};
+
+//! \}
+
+} // namespace ib
+} // namespace net
+} // namespace thrill
+
+#endif // !THRILL_NET_IB_GROUP_HEADER
+
+/******************************************************************************/
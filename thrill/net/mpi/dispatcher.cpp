@@ -20,9 +20,6 @@ namespace thrill {
 namespace net {
 namespace mpi {
 
-//! The Grand MPI Library Invocation Mutex (The GMLIM)
-extern std::mutex g_mutex;
-
 //! number of simultaneous transfers
 static const size_t g_simultaneous = 32;
 
@@ -46,7 +43,7 @@ Dispatcher::~Dispatcher() {
         << " mpi_async_.size()=" << mpi_async_.size();
 
     // lock the GMLIM
-    std::unique_lock<std::mutex> lock(g_mutex);
+    std::unique_lock<std::mutex> lock = LockMpi();
 
     for (size_t i = 0; i < mpi_async_requests_.size(); ++i) {
         int r = MPI_Cancel(&mpi_async_requests_[i]);
@@ -61,12 +58,12 @@ Dispatcher::~Dispatcher() {
 MPI_Request Dispatcher::ISend(
     Connection& c, uint32_t seq, const void* data, size_t size) {
     // lock the GMLIM
-    std::unique_lock<std::mutex> lock(g_mutex);
+    std::unique_lock<std::mutex> lock = LockMpi();
 
     MPI_Request request;
     int r = MPI_Isend(const_cast<void*>(data), static_cast<int>(size), MPI_BYTE,
                       c.peer(), static_cast<int>(seq),
-                      MPI_COMM_WORLD, &request);
+                      GroupComm(c.group()->group_tag()), &request);
 
     if (r != MPI_SUCCESS)
         throw Exception("Error during MPI_Isend()", r);
@@ -83,12 +80,12 @@ MPI_Request Dispatcher::ISend(
 MPI_Request Dispatcher::IRecv(
     Connection& c, uint32_t seq, void* data, size_t size) {
     // lock the GMLIM
-    std::unique_lock<std::mutex> lock(g_mutex);
+    std::unique_lock<std::mutex> lock = LockMpi();
 
     MPI_Request request;
     int r = MPI_Irecv(data, static_cast<int>(size), MPI_BYTE,
                       c.peer(), static_cast<int>(seq),
-                      MPI_COMM_WORLD, &request);
+                      GroupComm(c.group()->group_tag()), &request);
 
     if (r != MPI_SUCCESS)
         throw Exception("Error during MPI_Irecv()", r);
@@ -271,15 +268,15 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
         die_unless(mpi_async_.size() == mpi_async_out_.size());
         die_unless(mpi_async_.size() == mpi_status_out_.size());
 
-        // lock the GMLIM
-        std::unique_lock<std::mutex> lock(g_mutex);
-
 #if 1
         int out_count;
 
         sLOG << "DispatchOne(): MPI_Testsome()"
              << " mpi_async_requests_=" << mpi_async_requests_.size();
 
+        // lock the GMLIM
+        std::unique_lock<std::mutex> lock = LockMpi();
+
         int r = MPI_Testsome(
             // in: Length of array_of_requests (integer).
             static_cast<int>(mpi_async_requests_.size()),
@@ -294,7 +291,7 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
             // of status).
             mpi_status_out_.data());
 
-        lock.unlock();
+        if (lock) lock.unlock();
 
         if (r != MPI_SUCCESS)
             throw Exception("Error during MPI_Testsome()", r);
@@ -377,6 +374,9 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
         int out_index = 0, out_flag = 0;
         MPI_Status out_status;
 
+        // lock the GMLIM
+        std::unique_lock<std::mutex> lock = LockMpi();
+
         // (mpi_async_requests_.size() >= 10)
         sLOG0 << "DispatchOne(): MPI_Testany()"
               << " mpi_async_requests_=" << mpi_async_requests_.size();
@@ -393,16 +393,16 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
             // out: Status object (status).
             &out_status /* MPI_STATUS_IGNORE */);
 
+        if (lock) lock.unlock();
+
         if (r != MPI_SUCCESS)
             throw Exception("Error during MPI_Testany()", r);
 
         if (out_flag == 0) {
             // nothing returned
-            lock.unlock();
         }
         else {
             die_unless((unsigned)out_index < mpi_async_requests_.size());
-            lock.unlock();
 
             LOG << "DispatchOne(): MPI_Testany() out_flag=" << out_flag
                 << " done #" << out_index
@@ -454,7 +454,7 @@ void Dispatcher::DispatchOne(const std::chrono::milliseconds& /* timeout */) {
 
         {
             // lock the GMLIM
-            std::unique_lock<std::mutex> lock(g_mutex);
+            std::unique_lock<std::mutex> lock = LockMpi();
 
             int r = MPI_Iprobe(MPI_ANY_SOURCE, /* group_tag */ 0,
                                MPI_COMM_WORLD, &flag, &status);
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -36,6 +37,25 @@ namespace mpi {
 
 #define THRILL_NET_MPI_QUEUES 1
 
+//! The Grand MPI Library Invocation Mutex (The GMLIM)
+extern std::mutex g_mutex;
+
+//! whether the MPI library was initialized with MPI_THREAD_MULTIPLE, then
+//! threads may call it concurrently and the GMLIM is not needed.
+extern bool g_thread_multiple;
+
+//! Lock the GMLIM before calling the MPI library, unless it runs with
+//! MPI_THREAD_MULTIPLE, in which case the returned lock is empty.
+static inline std::unique_lock<std::mutex> LockMpi() {
+    if (g_thread_multiple) return std::unique_lock<std::mutex>();
+    return std::unique_lock<std::mutex>(g_mutex);
+}
+
+//! Return the MPI communicator of the Group with given group tag. Each Group
+//! has its own duplicate of MPI_COMM_WORLD, such that messages of different
+//! Groups with equal sequence tags are never matched with each other.
+MPI_Comm GroupComm(int group_tag);
+
 //! Signature of async MPI request callbacks.
 using AsyncRequestCallback = tlx::delegate<
     void (MPI_Status&), mem::GPoolAllocator<char> >;
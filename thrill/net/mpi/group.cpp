@@ -13,6 +13,8 @@
 
 #include <mpi.h>
 
+#include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <mutex>
 #include <string>
@@ -25,6 +27,17 @@ namespace mpi {
 //! The Grand MPI Library Invocation Mutex (The GMLIM)
 std::mutex g_mutex;
 
+//! whether the MPI library was initialized with MPI_THREAD_MULTIPLE
+bool g_thread_multiple = false;
+
+//! MPI communicators of the Groups, indexed by group tag
+static std::vector<MPI_Comm> g_comms;
+
+MPI_Comm GroupComm(int group_tag) {
+    assert(static_cast<size_t>(group_tag) < g_comms.size());
+    return g_comms[group_tag];
+}
+
 /******************************************************************************/
 // mpi::Exception
 
@@ -64,6 +77,18 @@ void Connection::SyncSend(const void* data, size_t size, Flags /* flags */) {
 
     assert(size <= std::numeric_limits<int>::max());
 
+    if (g_thread_multiple) {
+        // send directly from this thread instead of via the dispatcher
+        int r = MPI_Send(const_cast<void*>(data), static_cast<int>(size),
+                         MPI_BYTE, peer_, /* seq */ 0,
+                         GroupComm(group_->group_tag()));
+        if (r != MPI_SUCCESS)
+            throw Exception("Error during MPI_Send()", r);
+
+        tx_bytes_ += size;
+        return;
+    }
+
     bool done = false;
     group_->dispatcher().RunInThread(
         [=, &done](net::Dispatcher& dispatcher) {
@@ -93,6 +118,27 @@ void Connection::SyncRecv(void* out_data, size_t size) {
 
     assert(size <= std::numeric_limits<int>::max());
 
+    if (g_thread_multiple) {
+        // receive directly in this thread instead of via the dispatcher
+        MPI_Status status;
+        int r = MPI_Recv(out_data, static_cast<int>(size), MPI_BYTE,
+                         peer_, /* seq */ 0,
+                         GroupComm(group_->group_tag()), &status);
+        if (r != MPI_SUCCESS)
+            throw Exception("Error during MPI_Recv()", r);
+
+        int count;
+        r = MPI_Get_count(&status, MPI_BYTE, &count);
+        if (r != MPI_SUCCESS)
+            throw Exception("Error during MPI_Get_count()", r);
+
+        if (static_cast<size_t>(count) != size)
+            throw Exception("Error during SyncRecv(): message truncated?");
+
+        rx_bytes_ += size;
+        return;
+    }
+
     bool done = false;
     group_->dispatcher().RunInThread(
         [=, &done](net::Dispatcher& dispatcher) {
@@ -136,6 +182,31 @@ void Connection::SyncSendRecv(const void* send_data, size_t send_size,
     assert(send_size <= std::numeric_limits<int>::max());
     assert(recv_size <= std::numeric_limits<int>::max());
 
+    if (g_thread_multiple) {
+        // exchange directly in this thread instead of via the dispatcher
+        MPI_Status status;
+        int r = MPI_Sendrecv(
+            const_cast<void*>(send_data), static_cast<int>(send_size),
+            MPI_BYTE, peer_, /* seq */ 0,
+            recv_data, static_cast<int>(recv_size),
+            MPI_BYTE, peer_, /* seq */ 0,
+            GroupComm(group_->group_tag()), &status);
+        if (r != MPI_SUCCESS)
+            throw Exception("Error during MPI_Sendrecv()", r);
+
+        int count;
+        r = MPI_Get_count(&status, MPI_BYTE, &count);
+        if (r != MPI_SUCCESS)
+            throw Exception("Error during MPI_Get_count()", r);
+
+        if (static_cast<size_t>(count) != recv_size)
+            throw Exception("Error during SyncSendRecv(): message truncated?");
+
+        tx_bytes_ += send_size;
+        rx_bytes_ += recv_size;
+        return;
+    }
+
     unsigned done = 0;
     group_->dispatcher().RunInThread(
         [=, &done](net::Dispatcher& dispatcher) {
@@ -192,14 +263,14 @@ void Group::Barrier() {
     bool done = false;
     dispatcher_.RunInThread(
         [=, &done](net::Dispatcher& dispatcher) {
-            std::unique_lock<std::mutex> lock(g_mutex);
+            std::unique_lock<std::mutex> lock = LockMpi();
 
             MPI_Request request;
             int r = MPI_Ibarrier(MPI_COMM_WORLD, &request);
             if (r != MPI_SUCCESS)
                 throw Exception("Error during MPI_Barrier()", r);
 
-            lock.unlock();
+            if (lock) lock.unlock();
 
             auto& disp = static_cast<mpi::Dispatcher&>(dispatcher);
             disp.AddAsyncRequest(
@@ -216,7 +287,7 @@ void Group::WaitForRequest(MpiCall call) {
     bool done = false;
     dispatcher_.RunInThread(
         [=, &done](net::Dispatcher& dispatcher) {
-            std::unique_lock<std::mutex> lock(g_mutex);
+            std::unique_lock<std::mutex> lock = LockMpi();
 
             MPI_Request request;
             int r = call(request);
@@ -224,7 +295,7 @@ void Group::WaitForRequest(MpiCall call) {
             if (r != MPI_SUCCESS)
                 throw Exception("Error during WaitForRequest", r);
 
-            lock.unlock();
+            if (lock) lock.unlock();
 
             auto& disp = static_cast<mpi::Dispatcher&>(dispatcher);
             disp.AddAsyncRequest(
@@ -634,6 +705,10 @@ void Group::AllReduceMaximumUnsignedLongLong(unsigned long long& value) {
 static inline void Deinitialize() {
     std::unique_lock<std::mutex> lock(g_mutex);
 
+    for (MPI_Comm& comm : g_comms)
+        MPI_Comm_free(&comm);
+    g_comms.clear();
+
     MPI_Finalize();
 }
 
@@ -650,15 +725,30 @@ static inline void Initialize() {
         int argc = 1;
         const char* argv[] = { "thrill", nullptr };
 
+        // MPI_THREAD_MULTIPLE is slower in many MPI libraries, hence it is
+        // only requested on demand.
+        const char* env_multiple = getenv("THRILL_MPI_THREAD_MULTIPLE");
+        bool want_multiple =
+            env_multiple && *env_multiple && strcmp(env_multiple, "0") != 0;
+
         int provided;
-        int r = MPI_Init_thread(&argc, reinterpret_cast<char***>(&argv),
-                                MPI_THREAD_SERIALIZED, &provided);
+        int r = MPI_Init_thread(
+            &argc, reinterpret_cast<char***>(&argv),
+            want_multiple ? MPI_THREAD_MULTIPLE : MPI_THREAD_SERIALIZED,
+            &provided);
         if (r != MPI_SUCCESS)
             throw Exception("Error during MPI_Init_thread()", r);
 
         if (provided < MPI_THREAD_SERIALIZED)
             die("ERROR: MPI_Init_thread() only provided= " << provided);
 
+        g_thread_multiple = (provided >= MPI_THREAD_MULTIPLE);
+
+        if (want_multiple && !g_thread_multiple) {
+            LOG1 << "Thrill: MPI_Init_thread() did not provide"
+                 << " MPI_THREAD_MULTIPLE, serializing MPI calls.";
+        }
+
         // register atexit method
         atexit(&Deinitialize);
     }
@@ -691,6 +781,15 @@ bool Construct(size_t group_size, DispatcherThread& dispatcher,
     if (group_size > static_cast<size_t>(num_mpi_hosts))
         throw Exception("mpi::Construct(): fewer MPI processes than hosts requested.");
 
+    // duplicate MPI_COMM_WORLD once for each Group tag, this is collective
+    while (g_comms.size() < group_count) {
+        MPI_Comm comm;
+        r = MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+        if (r != MPI_SUCCESS)
+            throw Exception("Error during MPI_Comm_dup()", r);
+        g_comms.push_back(comm);
+    }
+
     for (size_t i = 0; i < group_count; i++) {
         groups[i] = std::make_unique<Group>(my_rank, i, group_size, dispatcher);
     }
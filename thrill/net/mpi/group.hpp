@@ -5,7 +5,9 @@
  * peers. Since MPI implementations are very bad at multi-threading, this
  * implementation is not recommended: it sequentialized all calls to the MPI
  * library (such that it does not deadlock), which _requires_ a busy-waiting
- * loop for new messages.
+ * loop for new messages. If THRILL_MPI_THREAD_MULTIPLE is set and the library
+ * provides MPI_THREAD_MULTIPLE, the calls are not serialized and synchronous
+ * sends and receives are issued directly by the calling threads.
  *
  * Due to this restriction, the mpi::Group allows only **one Thrill host**
  * within a system process. We cannot start independent test threads as MPI
@@ -78,6 +80,9 @@ public:
     //! return the MPI peer number
     int peer() const { return peer_; }
 
+    //! return the Group of this Connection
+    Group * group() const { return group_; }
+
     std::string ToString() const final;
 
     std::ostream& OutputOstream(std::ostream& os) const final;
@@ -130,9 +135,9 @@ private:
 
 /*!
  * A net group backed by virtual MPI connection. As MPI already sets up
- * communication, not much is done. Each Group communicates using a unique MPI
- * tag, the group id. Each host's rank within the group is plaining its MPI
- * rank.
+ * communication, not much is done. Each Group communicates using its own
+ * duplicate of MPI_COMM_WORLD, selected by the group tag. Each host's rank
+ * within the group is plaining its MPI rank.
  */
 class Group final : public net::Group
 {
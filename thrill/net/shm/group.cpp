@@ -0,0 +1,676 @@
+/*******************************************************************************
+ * thrill/net/shm/group.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/net/shm/group.hpp>
+
+#include <thrill/common/logger.hpp>
+#include <thrill/net/exception.hpp>
+
+#include <tlx/die.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+namespace thrill {
+namespace net {
+namespace shm {
+
+/******************************************************************************/
+// shm::Doorbell
+
+void Doorbell::Ring() {
+    seq_.fetch_add(1, std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_seq_cst) == 0) return;
+#if __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAKE,
+            INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+void Doorbell::Wait(uint32_t seen, const std::chrono::milliseconds& timeout) {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    if (seq_.load(std::memory_order_seq_cst) == seen) {
+#if __linux__
+        struct timespec ts;
+        ts.tv_sec = timeout.count() / 1000;
+        ts.tv_nsec = (timeout.count() % 1000) * 1000000;
+        // not FUTEX_PRIVATE: the Doorbell is shared between processes.
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAIT,
+                seen, &ts, nullptr, 0);
+#else
+        std::this_thread::sleep_for(
+            std::min(timeout, std::chrono::milliseconds(1)));
+#endif
+    }
+    waiters_.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+/******************************************************************************/
+// shm::Ring
+
+/*!
+ * Single producer single consumer ring buffer in shared memory. The data area
+ * follows the Ring object. head_ and tail_ are absolute byte counters, which
+ * are only incremented by the producer and the consumer, respectively.
+ */
+class Ring
+{
+public:
+    explicit Ring(size_t size) : size_(size) { }
+
+    //! number of bytes which can be read
+    size_t available() const {
+        return head_.load(std::memory_order_acquire)
+               - tail_.load(std::memory_order_relaxed);
+    }
+
+    //! number of bytes which can be written
+    size_t free() const {
+        return size_ - (head_.load(std::memory_order_relaxed)
+                        - tail_.load(std::memory_order_acquire));
+    }
+
+    //! copy up to size bytes into the ring, returns the bytes written.
+    size_t Write(const void* data, size_t size) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        size = std::min(size, free());
+        if (size == 0) return 0;
+
+        const uint8_t* cdata = static_cast<const uint8_t*>(data);
+        size_t pos = head % size_;
+        size_t first = std::min(size, size_ - pos);
+        std::copy(cdata, cdata + first, area() + pos);
+        std::copy(cdata + first, cdata + size, area());
+
+        head_.store(head + size, std::memory_order_release);
+        return size;
+    }
+
+    //! copy up to size bytes from the ring, returns the bytes read.
+    size_t Read(void* out_data, size_t size) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        size = std::min(size, available());
+        if (size == 0) return 0;
+
+        uint8_t* cdata = static_cast<uint8_t*>(out_data);
+        size_t pos = tail % size_;
+        size_t first = std::min(size, size_ - pos);
+        std::copy(area() + pos, area() + pos + first, cdata);
+        std::copy(area(), area() + (size - first), cdata + first);
+
+        tail_.store(tail + size, std::memory_order_release);
+        return size;
+    }
+
+private:
+    //! total bytes written by the producer
+    alignas(64) std::atomic<uint64_t> head_ { 0 };
+
+    //! total bytes read by the consumer
+    alignas(64) std::atomic<uint64_t> tail_ { 0 };
+
+    //! size of the data area
+    size_t size_;
+
+    //! data area following the Ring object
+    uint8_t * area() { return reinterpret_cast<uint8_t*>(this + 1); }
+};
+
+/******************************************************************************/
+// shm::Segment
+
+/*!
+ * A host's shared memory segment: a header with the host's Doorbell, followed
+ * by num_rings inbound Rings. The Segment object is the process-local mapping.
+ */
+class Segment
+{
+    static constexpr bool debug = false;
+
+public:
+    //! magic value written into the header after initialization
+    static constexpr uint64_t magic = 0x544852494C4C5348ull;
+
+    //! header at the beginning of the shared memory
+    struct Header {
+        //! magic value, set after the rings are initialized
+        std::atomic<uint64_t> magic;
+        //! number of peers which attached to the segment
+        std::atomic<uint32_t> attached;
+        //! number of rings
+        uint64_t              num_rings;
+        //! size of the data area of each ring
+        uint64_t              ring_size;
+        //! the host's Doorbell
+        alignas(64) Doorbell doorbell;
+    };
+
+    //! create and initialize a segment. If name is empty, the segment is
+    //! anonymous and can only be shared within this process.
+    static std::shared_ptr<Segment> Create(
+        const std::string& name, size_t num_rings, size_t ring_size) {
+
+        size_t size = RoundUp(sizeof(Header))
+                      + num_rings * RingStride(ring_size);
+        void* base;
+
+        if (name.empty()) {
+            base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        }
+        else {
+            int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0 && errno == EEXIST) {
+                // remove stale segment of a previous run
+                LOG1 << "shm::Segment: removing stale segment " << name;
+                shm_unlink(name.c_str());
+                fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            }
+            if (fd < 0)
+                throw Exception("Could not create shm segment " + name, errno);
+
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                int err = errno;
+                ::close(fd);
+                shm_unlink(name.c_str());
+                throw Exception("Could not resize shm segment " + name, err);
+            }
+            base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+            ::close(fd);
+        }
+
+        if (base == MAP_FAILED)
+            throw Exception("Could not map shm segment " + name, errno);
+
+        std::shared_ptr<Segment> s(new Segment(base, size, name));
+
+        Header* h = new (base)Header();
+        h->attached = 0;
+        h->num_rings = num_rings;
+        h->ring_size = ring_size;
+        for (size_t i = 0; i < num_rings; ++i)
+            new (s->ring(i))Ring(ring_size);
+
+        h->magic.store(magic, std::memory_order_release);
+
+        sLOG << "shm::Segment created" << name << "size" << size;
+        return s;
+    }
+
+    //! open the initialized segment of a peer, returns nullptr if it does not
+    //! exist (yet).
+    static std::shared_ptr<Segment> Open(const std::string& name) {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) return nullptr;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 ||
+            static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            ::close(fd);
+            return nullptr;
+        }
+
+        size_t size = static_cast<size_t>(st.st_size);
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (base == MAP_FAILED)
+            throw Exception("Could not map shm segment " + name, errno);
+
+        // the segment is not owned, hence it is not unlinked.
+        std::shared_ptr<Segment> s(new Segment(base, size, std::string()));
+        if (s->header()->magic.load(std::memory_order_acquire) != magic)
+            return nullptr;
+
+        sLOG << "shm::Segment opened" << name << "size" << size;
+        return s;
+    }
+
+    //! non-copyable: delete copy-constructor
+    Segment(const Segment&) = delete;
+    //! non-copyable: delete assignment operator
+    Segment& operator = (const Segment&) = delete;
+
+    //! unmap the segment
+    ~Segment() {
+        munmap(base_, size_);
+    }
+
+    //! header of the segment
+    Header * header() const { return static_cast<Header*>(base_); }
+
+    //! the host's Doorbell
+    Doorbell * doorbell() const { return &header()->doorbell; }
+
+    //! the i-th inbound Ring
+    Ring * ring(size_t i) const {
+        return reinterpret_cast<Ring*>(
+            static_cast<uint8_t*>(base_) + RoundUp(sizeof(Header))
+            + i * RingStride(header()->ring_size));
+    }
+
+    //! remove the name of an owned segment, the mappings remain valid.
+    void Unlink() {
+        if (name_.empty()) return;
+        shm_unlink(name_.c_str());
+        name_.clear();
+    }
+
+private:
+    Segment(void* base, size_t size, const std::string& name)
+        : base_(base), size_(size), name_(name) { }
+
+    //! round up to cache lines
+    static size_t RoundUp(size_t size) {
+        return (size + 63) / 64 * 64;
+    }
+
+    //! distance of Rings in the segment
+    static size_t RingStride(size_t ring_size) {
+        return RoundUp(sizeof(Ring) + ring_size);
+    }
+
+    //! mapped memory
+    void* base_;
+
+    //! size of the mapping
+    size_t size_;
+
+    //! name of an owned segment which is not yet unlinked
+    std::string name_;
+};
+
+/******************************************************************************/
+// shm::Connection
+
+void Connection::Initialize(Group* group, size_t peer,
+                            Ring* tx_ring, Ring* rx_ring,
+                            Doorbell* my_bell, Doorbell* peer_bell) {
+    group_ = group;
+    peer_ = peer;
+    tx_ring_ = tx_ring;
+    rx_ring_ = rx_ring;
+    my_bell_ = my_bell;
+    peer_bell_ = peer_bell;
+}
+
+bool Connection::readable() const {
+    return rx_ring_->available() != 0;
+}
+
+bool Connection::writable() const {
+    return tx_ring_->free() != 0;
+}
+
+std::string Connection::ToString() const {
+    return "peer: " + std::to_string(peer_);
+}
+
+std::ostream& Connection::OutputOstream(std::ostream& os) const {
+    return os << "[shm::Connection"
+              << " group=" << group_
+              << " peer=" << peer_
+              << "]";
+}
+
+size_t Connection::TrySend(const void* data, size_t size) {
+    size_t n = tx_ring_->Write(data, size);
+    if (n != 0) {
+        // wake up the peer waiting for data
+        peer_bell_->Ring();
+        tx_bytes_ += n;
+    }
+    return n;
+}
+
+size_t Connection::TryRecv(void* out_data, size_t size) {
+    size_t n = rx_ring_->Read(out_data, size);
+    if (n != 0) {
+        // wake up the peer waiting for space
+        peer_bell_->Ring();
+        rx_bytes_ += n;
+    }
+    return n;
+}
+
+void Connection::SyncSend(const void* data, size_t size, Flags /* flags */) {
+    const uint8_t* cdata = static_cast<const uint8_t*>(data);
+    while (size != 0) {
+        uint32_t seen = my_bell_->Get();
+        size_t n = TrySend(cdata, size);
+        if (n == 0) {
+            my_bell_->Wait(seen, std::chrono::milliseconds(100));
+            continue;
+        }
+        cdata += n, size -= n;
+    }
+    // set errno : success (other syscalls may have failed)
+    errno = 0;
+}
+
+ssize_t Connection::SendOne(const void* data, size_t size, Flags /* flags */) {
+    if (size == 0) return 0;
+    size_t n = TrySend(data, size);
+    if (n == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    errno = 0;
+    return static_cast<ssize_t>(n);
+}
+
+void Connection::SyncRecv(void* out_data, size_t size) {
+    uint8_t* cdata = static_cast<uint8_t*>(out_data);
+    while (size != 0) {
+        uint32_t seen = my_bell_->Get();
+        size_t n = TryRecv(cdata, size);
+        if (n == 0) {
+            my_bell_->Wait(seen, std::chrono::milliseconds(100));
+            continue;
+        }
+        cdata += n, size -= n;
+    }
+    errno = 0;
+}
+
+ssize_t Connection::RecvOne(void* out_data, size_t size) {
+    if (size == 0) return 0;
+    size_t n = TryRecv(out_data, size);
+    if (n == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    errno = 0;
+    return static_cast<ssize_t>(n);
+}
+
+void Connection::SyncSendRecv(const void* send_data, size_t send_size,
+                              void* recv_data, size_t recv_size) {
+    // interleave sending and receiving, since the message may be larger than
+    // the rings, and the peer may also send first.
+    const uint8_t* sdata = static_cast<const uint8_t*>(send_data);
+    uint8_t* rdata = static_cast<uint8_t*>(recv_data);
+    while (send_size != 0 || recv_size != 0) {
+        uint32_t seen = my_bell_->Get();
+        size_t s = TrySend(sdata, send_size);
+        sdata += s, send_size -= s;
+        size_t r = TryRecv(rdata, recv_size);
+        rdata += r, recv_size -= r;
+        if (s == 0 && r == 0)
+            my_bell_->Wait(seen, std::chrono::milliseconds(100));
+    }
+    errno = 0;
+}
+
+void Connection::SyncRecvSend(const void* send_data, size_t send_size,
+                              void* recv_data, size_t recv_size) {
+    // the order does not matter, since both directions are interleaved.
+    return SyncSendRecv(send_data, send_size, recv_data, recv_size);
+}
+
+/******************************************************************************/
+// shm::Group
+
+Group::Group(size_t my_rank, size_t group_size)
+    : net::Group(my_rank), segments_(group_size) {
+    conns_ = new Connection[group_size];
+}
+
+Group::~Group() {
+    delete[] conns_;
+}
+
+size_t Group::num_hosts() const {
+    return segments_.size();
+}
+
+net::Connection& Group::connection(size_t peer) {
+    assert(peer < segments_.size());
+    return conns_[peer];
+}
+
+void Group::Close() { }
+
+std::unique_ptr<net::Dispatcher> Group::ConstructDispatcher() const {
+    // construct shm::Dispatcher
+    return std::make_unique<Dispatcher>();
+}
+
+void Group::Initialize(
+    const std::vector<std::shared_ptr<Segment> >& segments, size_t group) {
+    assert(segments.size() == segments_.size());
+    segments_ = segments;
+
+    size_t n = segments_.size();
+    for (size_t i = 0; i < n; ++i) {
+        conns_[i].Initialize(
+            this, i,
+            // our inbound ring in the peer's segment
+            segments_[i]->ring(group * n + my_rank_),
+            // the peer's inbound ring in our segment
+            segments_[my_rank_]->ring(group * n + i),
+            segments_[my_rank_]->doorbell(), segments_[i]->doorbell());
+    }
+}
+
+std::vector<std::unique_ptr<Group> >
+Group::ConstructLoopbackMesh(size_t num_hosts) {
+
+    // anonymous segments can be shared among threads
+    std::vector<std::shared_ptr<Segment> > segments(num_hosts);
+    for (size_t i = 0; i < num_hosts; ++i) {
+        segments[i] = Segment::Create(
+            std::string(), num_hosts, default_ring_size);
+    }
+
+    std::vector<std::unique_ptr<Group> > groups(num_hosts);
+
+    for (size_t i = 0; i < num_hosts; ++i) {
+        groups[i] = std::make_unique<Group>(i, num_hosts);
+        groups[i]->Initialize(segments, 0);
+        for (size_t j = 0; j < num_hosts; ++j)
+            groups[i]->conns_[j].is_loopback_ = true;
+    }
+
+    return groups;
+}
+
+void Construct(const std::string& name, size_t my_rank, size_t num_hosts,
+               std::unique_ptr<Group>* groups, size_t group_count,
+               size_t ring_size) {
+    static constexpr bool debug = false;
+
+    die_unless(my_rank < num_hosts);
+
+    //! time to wait for peers to create and attach to the segments
+    static constexpr auto timeout = std::chrono::seconds(60);
+
+    auto SegmentName = [&name](size_t rank) {
+                           return "/" + name + "-" + std::to_string(rank);
+                       };
+
+    std::vector<std::shared_ptr<Segment> > segments(num_hosts);
+    segments[my_rank] = Segment::Create(
+        SegmentName(my_rank), group_count * num_hosts, ring_size);
+
+    // open the segments of all peers, which may not exist yet
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < num_hosts; ++i) {
+        if (i == my_rank) continue;
+
+        while (!(segments[i] = Segment::Open(SegmentName(i)))) {
+            if (std::chrono::steady_clock::now() - start > timeout) {
+                throw Exception(
+                    "Timeout waiting for shm segment " + SegmentName(i));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        Segment::Header* h = segments[i]->header();
+        if (h->num_rings != group_count * num_hosts ||
+            h->ring_size != ring_size) {
+            throw Exception(
+                "shm segment " + SegmentName(i) + " has a different layout");
+        }
+        h->attached.fetch_add(1);
+
+        sLOG << "shm::Construct() rank" << my_rank << "attached to" << i;
+    }
+
+    // wait for all peers to attach, then remove our segment's name.
+    while (segments[my_rank]->header()->attached.load() != num_hosts - 1) {
+        if (std::chrono::steady_clock::now() - start > timeout) {
+            segments[my_rank]->Unlink();
+            throw Exception("Timeout waiting for peers to attach to "
+                            + SegmentName(my_rank));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    segments[my_rank]->Unlink();
+
+    for (size_t g = 0; g < group_count; ++g) {
+        groups[g] = std::make_unique<Group>(my_rank, num_hosts);
+        groups[g]->Initialize(segments, g);
+    }
+}
+
+/******************************************************************************/
+// shm::Dispatcher
+
+Dispatcher::Dispatcher()
+    : net::Dispatcher(), bell_(&local_bell_)
+{ }
+
+Dispatcher::~Dispatcher()
+{ }
+
+Dispatcher::Watch& Dispatcher::GetWatch(Connection* c) {
+    Doorbell* bell = bell_.load();
+    if (bell == &local_bell_)
+        bell_ = c->my_bell();
+    else if (bell != c->my_bell())
+        mixed_bells_ = true;
+    return watch_[c];
+}
+
+void Dispatcher::AddRead(net::Connection& _c, const Callback& read_cb) {
+    assert(dynamic_cast<Connection*>(&_c));
+    Connection& c = static_cast<Connection&>(_c);
+    GetWatch(&c).read_cb.emplace_back(read_cb);
+}
+
+void Dispatcher::AddWrite(net::Connection& _c, const Callback& write_cb) {
+    assert(dynamic_cast<Connection*>(&_c));
+    Connection& c = static_cast<Connection&>(_c);
+    GetWatch(&c).write_cb.emplace_back(write_cb);
+}
+
+void Dispatcher::Cancel(net::Connection& _c) {
+    assert(dynamic_cast<Connection*>(&_c));
+    Connection& c = static_cast<Connection&>(_c);
+    auto it = watch_.find(&c);
+    if (it == watch_.end()) return;
+    // the Watch is removed by DispatchOne()
+    it->second.read_cb.clear();
+    it->second.write_cb.clear();
+}
+
+void Dispatcher::Interrupt() {
+    local_bell_.Ring();
+    Doorbell* bell = bell_.load();
+    if (bell != &local_bell_)
+        bell->Ring();
+}
+
+void Dispatcher::DispatchOne(const std::chrono::milliseconds& timeout) {
+
+    // read the Doorbell before checking the rings, such that no wake-up is
+    // lost between checking and waiting.
+    Doorbell* bell = bell_.load();
+    uint32_t seen = bell->Get();
+
+    bool progress = false;
+
+    for (auto it = watch_.begin(); it != watch_.end(); ) {
+        Connection* c = it->first;
+        Watch& w = it->second;
+
+        // callbacks may add new callbacks, but never remove watches.
+        if (!w.read_cb.empty() && c->readable()) {
+            progress = true;
+            bool ret = true;
+            try {
+                ret = w.read_cb.front()();
+            }
+            catch (std::exception& e) {
+                LOG1 << "Dispatcher: exception " << typeid(e).name()
+                     << "in read callback.";
+                LOG1 << "  what(): " << e.what();
+                throw;
+            }
+            if (!ret && !w.read_cb.empty()) w.read_cb.pop_front();
+        }
+
+        if (!w.write_cb.empty() && c->writable()) {
+            progress = true;
+            bool ret = true;
+            try {
+                ret = w.write_cb.front()();
+            }
+            catch (std::exception& e) {
+                LOG1 << "Dispatcher: exception " << typeid(e).name()
+                     << "in write callback.";
+                LOG1 << "  what(): " << e.what();
+                throw;
+            }
+            if (!ret && !w.write_cb.empty()) w.write_cb.pop_front();
+        }
+
+        if (w.read_cb.empty() && w.write_cb.empty())
+            it = watch_.erase(it);
+        else
+            ++it;
+    }
+
+    if (progress) return;
+
+    sLOG << "DispatchOne wait";
+
+    if (mixed_bells_) {
+        // rings of other segments are not signalled on our Doorbell
+        bell->Wait(seen, std::min(timeout, std::chrono::milliseconds(1)));
+    }
+    else {
+        bell->Wait(seen, timeout);
+    }
+}
+
+} // namespace shm
+} // namespace net
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,289 @@
+/*******************************************************************************
+ * thrill/net/shm/group.hpp
+ *
+ * Implementation of a network between processes on one host via shared memory
+ * ring buffers. All classes: Group, Connection, and Dispatcher are in this file
+ * since they are tightly interdependent.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_NET_SHM_GROUP_HEADER
+#define THRILL_NET_SHM_GROUP_HEADER
+
+#include <thrill/net/dispatcher.hpp>
+#include <thrill/net/group.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace net {
+namespace shm {
+
+//! \addtogroup net_shm Shared Memory Network API
+//! \ingroup net
+//! \{
+
+class Group;
+class Dispatcher;
+class Segment;
+class Ring;
+
+/*!
+ * A wake-up counter in shared memory. Each host has one Doorbell, which is
+ * rung by its peers whenever they write data into or read data from one of the
+ * host's rings. Waiting threads sleep on the Doorbell using futexes, which
+ * also work across processes.
+ */
+class Doorbell
+{
+public:
+    //! current counter value, which must be read before checking the rings.
+    uint32_t Get() const { return seq_.load(std::memory_order_acquire); }
+
+    //! increment the counter and wake up all waiting threads
+    void Ring();
+
+    //! wait until the counter differs from seen, or the timeout expired.
+    void Wait(uint32_t seen, const std::chrono::milliseconds& timeout);
+
+private:
+    //! wake-up counter
+    std::atomic<uint32_t> seq_ { 0 };
+
+    //! number of threads sleeping in Wait(), Ring() skips the syscall if zero.
+    std::atomic<uint32_t> waiters_ { 0 };
+};
+
+/*!
+ * A connection via shared memory: each Connection has a single producer single
+ * consumer ring buffer for each direction. Both rings are byte streams, which
+ * are written and read partially by SendOne() and RecvOne() when they are full
+ * or empty.
+ */
+class Connection final : public net::Connection
+{
+public:
+    //! connect to the peer via the given ring buffers
+    void Initialize(Group* group, size_t peer, Ring* tx_ring, Ring* rx_ring,
+                    Doorbell* my_bell, Doorbell* peer_bell);
+
+    //! true if data can be received from the rx ring
+    bool readable() const;
+
+    //! true if data can be written into the tx ring
+    bool writable() const;
+
+    //! the Doorbell of this host, used for waiting
+    Doorbell* my_bell() const { return my_bell_; }
+
+    //! \name Base Status Functions
+    //! \{
+
+    bool IsValid() const final { return tx_ring_ != nullptr; }
+
+    std::string ToString() const final;
+
+    std::ostream& OutputOstream(std::ostream& os) const final;
+
+    //! \}
+
+    //! \name Send Functions
+    //! \{
+
+    void SyncSend(
+        const void* data, size_t size, Flags /* flags */ = NoFlags) final;
+
+    ssize_t SendOne(
+        const void* data, size_t size, Flags flags = NoFlags) final;
+
+    //! \}
+
+    //! \name Receive Functions
+    //! \{
+
+    void SyncRecv(void* out_data, size_t size) final;
+
+    ssize_t RecvOne(void* out_data, size_t size) final;
+
+    //! \}
+
+    //! \name Paired SendReceive Methods
+    //! \{
+
+    void SyncSendRecv(const void* send_data, size_t send_size,
+                      void* recv_data, size_t recv_size) final;
+    void SyncRecvSend(const void* send_data, size_t send_size,
+                      void* recv_data, size_t recv_size) final;
+
+    //! \}
+
+private:
+    //! for access to is_loopback_
+    friend class Group;
+
+    //! Reference to our group.
+    Group* group_ = nullptr;
+
+    //! Outgoing peer id of this Connection.
+    size_t peer_ = size_t(-1);
+
+    //! ring buffer to the peer, located in the peer's segment
+    Ring* tx_ring_ = nullptr;
+
+    //! ring buffer from the peer, located in our segment
+    Ring* rx_ring_ = nullptr;
+
+    //! Doorbell of this host
+    Doorbell* my_bell_ = nullptr;
+
+    //! Doorbell of the peer
+    Doorbell* peer_bell_ = nullptr;
+
+    //! copy as much as possible to the tx ring, returns the bytes written.
+    size_t TrySend(const void* data, size_t size);
+
+    //! copy as much as possible from the rx ring, returns the bytes read.
+    size_t TryRecv(void* out_data, size_t size);
+};
+
+/*!
+ * A Group of processes on one host, which communicate via ring buffers in
+ * shared memory. Each host maps one shared memory segment containing its
+ * Doorbell and the inbound rings from all peers in all Groups, and maps the
+ * segments of all peers to write into their rings.
+ */
+class Group final : public net::Group
+{
+    static constexpr bool debug = false;
+
+public:
+    //! default size of each ring buffer
+    static constexpr size_t default_ring_size = 1024 * 1024;
+
+    //! \name Base Functions
+    //! \{
+
+    //! Initialize a Group for the given size and rank
+    Group(size_t my_rank, size_t group_size);
+
+    ~Group();
+
+    size_t num_hosts() const final;
+
+    net::Connection& connection(size_t peer) final;
+
+    void Close() final;
+
+    using Dispatcher = shm::Dispatcher;
+
+    std::unique_ptr<net::Dispatcher> ConstructDispatcher() const final;
+
+    //! \}
+
+    /*!
+     * Construct a shared memory network with num_hosts peers within this
+     * process and deliver Group contexts for each of them.
+     */
+    static std::vector<std::unique_ptr<Group> > ConstructLoopbackMesh(
+        size_t num_hosts);
+
+    //! connect the group to the rings of group number group in the segments,
+    //! called by Construct() and ConstructLoopbackMesh().
+    void Initialize(const std::vector<std::shared_ptr<Segment> >& segments,
+                    size_t group);
+
+private:
+    //! shared memory segments of all hosts, indexed by rank
+    std::vector<std::shared_ptr<Segment> > segments_;
+
+    //! vector of connection objects to peers
+    Connection* conns_;
+};
+
+/*!
+ * Connect the processes on this host, which are identified by my_rank in
+ * [0,num_hosts) and share the common name, via shared memory segments named
+ * "/name-rank". Construct group_count net::Group objects at once. The call
+ * blocks until all peers attached to the segment of this host, afterwards the
+ * segment's name is unlinked.
+ */
+void Construct(const std::string& name, size_t my_rank, size_t num_hosts,
+               std::unique_ptr<Group>* groups, size_t group_count,
+               size_t ring_size = Group::default_ring_size);
+
+/*!
+ * A Dispatcher which polls the ring buffers of the watched Connections and
+ * sleeps on the host's Doorbell if no callback made progress.
+ */
+class Dispatcher final : public net::Dispatcher
+{
+    static constexpr bool debug = false;
+
+public:
+    //! type for file descriptor readiness callbacks
+    using Callback = AsyncCallback;
+
+    Dispatcher();
+    ~Dispatcher();
+
+    //! \name Implementation of Virtual Methods
+    //! \{
+
+    void AddRead(net::Connection& _c, const Callback& read_cb) final;
+
+    void AddWrite(net::Connection& _c, const Callback& write_cb) final;
+
+    void Cancel(net::Connection& _c) final;
+
+    //! shared memory rings are byte streams, hence writes may be coalesced.
+    bool IsByteStream() const final { return true; }
+
+    void Interrupt() final;
+
+    void DispatchOne(const std::chrono::milliseconds& timeout) final;
+
+    //! \}
+
+private:
+    //! callback queues per watched connection
+    struct Watch {
+        std::deque<Callback, mem::GPoolAllocator<Callback> > read_cb, write_cb;
+    };
+
+    //! watched connections
+    std::map<Connection*, Watch> watch_;
+
+    //! Doorbell to wait on: that of the watched Connections, or local_bell_.
+    std::atomic<Doorbell*> bell_;
+
+    //! Doorbell used before any Connection is watched
+    Doorbell local_bell_;
+
+    //! whether Connections with different Doorbells are watched, in which case
+    //! waits are bounded to poll all rings.
+    bool mixed_bells_ = false;
+
+    //! register Connection and take over its Doorbell
+    Watch& GetWatch(Connection* c);
+};
+
+//! \}
+
+} // namespace shm
+} // namespace net
+} // namespace thrill
+
+#endif // !THRILL_NET_SHM_GROUP_HEADER
+
+/******************************************************************************/
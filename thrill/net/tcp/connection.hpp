@@ -19,6 +19,14 @@
 #include <thrill/net/connection.hpp>
 #include <thrill/net/tcp/socket.hpp>
 
+#if THRILL_HAVE_NET_ZEROCOPY
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+// requires struct timespec
+#include <linux/errqueue.h>
+#endif
+
 #include <cassert>
 #include <cerrno>
 #include <cstdio>
@@ -42,6 +50,19 @@ enum ConnectionState : unsigned {
 #define MSG_MORE 0
 #endif
 
+#if THRILL_HAVE_NET_ZEROCOPY
+// Older C library headers do not know zero-copy sends (Linux 4.14).
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#endif
+
 /*!
  * Connection is a rich point-to-point socket connection to another client
  * (worker, master, or whatever). Messages are fixed-length integral items or
@@ -77,6 +98,11 @@ public:
           state_(other.state_),
           group_id_(other.group_id_),
           peer_id_(other.peer_id_) {
+#if THRILL_HAVE_NET_ZEROCOPY
+        zerocopy_ = other.zerocopy_;
+        zerocopy_sent_ = other.zerocopy_sent_;
+        zerocopy_done_ = other.zerocopy_done_;
+#endif
         other.state_ = ConnectionState::Invalid;
     }
 
@@ -90,6 +116,11 @@ public:
         state_ = other.state_;
         group_id_ = other.group_id_;
         peer_id_ = other.peer_id_;
+#if THRILL_HAVE_NET_ZEROCOPY
+        zerocopy_ = other.zerocopy_;
+        zerocopy_sent_ = other.zerocopy_sent_;
+        zerocopy_done_ = other.zerocopy_done_;
+#endif
 
         other.state_ = ConnectionState::Invalid;
         return *this;
@@ -180,6 +211,74 @@ public:
         return wb;
     }
 
+#if THRILL_HAVE_NET_ZEROCOPY
+    //! Enable sending with MSG_ZEROCOPY on the socket, returns false if the
+    //! kernel does not support it.
+    bool EnableZeroCopy() {
+        int one = 1;
+        if (setsockopt(GetSocket().fd(), SOL_SOCKET, SO_ZEROCOPY,
+                       &one, sizeof(one)) != 0) {
+            LOG << "Connection::EnableZeroCopy() failed: " << strerror(errno);
+            return false;
+        }
+        zerocopy_ = true;
+        return true;
+    }
+
+    bool HasZeroCopy() const final { return zerocopy_; }
+
+    ssize_t SendOneZeroCopy(const void* data, size_t size,
+                            uint32_t* id) final {
+        ssize_t wb = socket_.send_one(
+            data, size, MSG_DONTWAIT | MSG_ZEROCOPY);
+        if (wb < 0 && errno == ENOBUFS) {
+            // out of option memory for notifications: copy this one, which
+            // needs no completion beyond the previous zero-copy send.
+            *id = zerocopy_sent_ - 1;
+            return SendOne(data, size, NoFlags);
+        }
+        if (wb > 0) {
+            tx_bytes_ += wb;
+            *id = zerocopy_sent_++;
+        }
+        return wb;
+    }
+
+    uint32_t ZeroCopyCompleted() final {
+        // read all notifications from the socket's error queue. Each one
+        // reports a range of send call numbers, which TCP delivers in order.
+        char control[128];
+        struct msghdr msg;
+        while (true) {
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            if (recvmsg(GetSocket().fd(), &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+                break;
+
+            for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr;
+                 cm = CMSG_NXTHDR(&msg, cm)) {
+                if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                      (cm->cmsg_level == SOL_IPV6 &&
+                       cm->cmsg_type == IPV6_RECVERR)))
+                    continue;
+
+                struct sock_extended_err serr;
+                memcpy(&serr, CMSG_DATA(cm), sizeof(serr));
+                if (serr.ee_errno != 0 ||
+                    serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                    continue;
+
+                uint32_t next = serr.ee_data + 1;
+                if (static_cast<int32_t>(next - zerocopy_done_) > 0)
+                    zerocopy_done_ = next;
+            }
+        }
+        return zerocopy_done_;
+    }
+#endif
+
     void SyncRecv(void* out_data, size_t size) final {
         SetNonBlocking(false);
         if (socket_.recv(out_data, size) != static_cast<ssize_t>(size))
@@ -238,6 +337,17 @@ private:
 
     //! The id of the worker this connection is connected to.
     size_t peer_id_ = size_t(-1);
+
+#if THRILL_HAVE_NET_ZEROCOPY
+    //! whether MSG_ZEROCOPY was enabled on the socket
+    bool zerocopy_ = false;
+
+    //! number of successful zero-copy send calls
+    uint32_t zerocopy_sent_ = 0;
+
+    //! number of zero-copy send calls reported as completed
+    uint32_t zerocopy_done_ = 0;
+#endif
 };
 
 // \}
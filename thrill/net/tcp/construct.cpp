@@ -12,13 +12,15 @@
 #include <thrill/net/tcp/connection.hpp>
 #include <thrill/net/tcp/construct.hpp>
 #include <thrill/net/tcp/group.hpp>
-#include <thrill/net/tcp/select_dispatcher.hpp>
 
 #include <tlx/die.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <deque>
 #include <map>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -29,16 +31,34 @@ namespace tcp {
 //! \addtogroup net_tcp TCP Socket API
 //! \{
 
+//! Represents a welcome message that is exchanged by Connections during
+//! network initialization.
+struct WelcomeMsg {
+    //! the Thrill signature flag.
+    uint64_t thrill_sign;
+
+    //! the id of the Group associated with the sending Connection.
+    size_t   group_id;
+
+    //! the id of the worker associated with the sending Connection.
+    size_t   id;
+};
+
+//! The Thrill signature flag - introduced by Master Timo.
+static constexpr uint64_t thrill_sign = 0x0C7A0C7A0C7A0C7A;
+
 class Construction
 {
     static constexpr bool debug = false;
 
 public:
-    Construction(SelectDispatcher& dispatcher,
-                 std::unique_ptr<Group>* groups, size_t group_count)
+    Construction(net::Dispatcher& dispatcher,
+                 std::unique_ptr<Group>* groups, size_t group_count,
+                 size_t num_lazy_groups)
         : dispatcher_(dispatcher),
           groups_(groups),
-          group_count_(group_count)
+          group_count_(group_count),
+          num_lazy_groups_(num_lazy_groups)
     { }
 
     /*!
@@ -65,6 +85,15 @@ public:
         std::vector<SocketAddress> address_list
             = GetAddressList(endpoints);
 
+        // Lazy groups share one connector, the listener stays open for it.
+        if (num_lazy_groups_ != 0) {
+            die_unless(num_lazy_groups_ < group_count_);
+            lazy_ = std::make_shared<LazyConnector>(
+                my_rank_, address_list, groups_, num_lazy_groups_);
+            for (size_t i = 0; i < num_lazy_groups_; i++)
+                groups_[i]->EnableLazy(lazy_, i);
+        }
+
         // Create listening socket.
         {
             Socket listen_socket = Socket::Create();
@@ -80,13 +109,20 @@ public:
                 throw Exception("Could not listen on socket "
                                 + lsa.ToStringHostPort(), errno);
 
+            // accept all pending connections in one callback
+            listen_socket.SetNonBlocking(true);
+
             listener_ = Connection(std::move(listen_socket));
         }
 
         LOG << "Client " << my_rank_ << " listening: " << endpoints[my_rank_];
 
-        // Initiate connections to all hosts with higher id.
-        for (uint32_t g = 0; g < group_count_; g++) {
+        num_expected_ =
+            (group_count_ - num_lazy_groups_) * (endpoints.size() - 1);
+
+        // Initiate non-blocking connections to all hosts with higher id at
+        // once, the handshakes are driven by the dispatcher.
+        for (size_t g = num_lazy_groups_; g < group_count_; g++) {
             for (size_t id = my_rank_ + 1; id < address_list.size(); ++id) {
                 AsyncConnect(g, id, address_list[id]);
             }
@@ -107,12 +143,17 @@ public:
 
         dispatcher_.Cancel(listener_);
 
-        // All connected, Dispose listener.
-        listener_.Close();
+        // All connected, Dispose listener or hand it to the lazy groups.
+        if (lazy_) {
+            lazy_->SetListener(std::move(listener_));
+        }
+        else {
+            listener_.Close();
+        }
 
         LOG << "Client " << my_rank_ << " done";
 
-        for (size_t j = 0; j < group_count_; j++) {
+        for (size_t j = num_lazy_groups_; j < group_count_; j++) {
             // output list of file descriptors connected to partners
             for (size_t i = 0; i != address_list.size(); ++i) {
                 if (i == my_rank_) continue;
@@ -128,7 +169,7 @@ private:
     mem::Manager mem_manager_ { nullptr, "Construction" };
 
     //! Dispatcher instance used by this Manager to perform async operations.
-    SelectDispatcher& dispatcher_;
+    net::Dispatcher& dispatcher_;
 
     //! Link to groups to initialize
     std::unique_ptr<Group>* groups_;
@@ -136,6 +177,12 @@ private:
     //! number of groups to initialize
     size_t group_count_;
 
+    //! number of leading groups which connect on demand
+    size_t num_lazy_groups_;
+
+    //! connector shared by the lazy groups
+    std::shared_ptr<LazyConnector> lazy_;
+
     //! The rank associated with the local worker.
     size_t my_rank_ = size_t(-1);
 
@@ -150,32 +197,33 @@ private:
     //! Connection is moved out of the deque into the right Group.
     std::deque<Connection> connections_;
 
+    //! number of Connections in state Connected
+    size_t num_connected_ = 0;
+
+    //! number of Connections to establish
+    size_t num_expected_ = 0;
+
     //! Array of connect timeouts which are exponentially increased from 10msec
-    //! on failed connects.
+    //! on failed connects, up to max_timeout_.
     std::map<GroupNodeIdPair, size_t> timeouts_;
 
     //! start connect backoff at 10msec
     const size_t initial_timeout_ = 10;
 
-    //! maximum connect backoff, after which the program fails. Total waiting
-    //! time is about 2 * final_timeout_ (in millisec).
-    const size_t final_timeout_ = 40960;
-
-    //! Represents a welcome message that is exchanged by Connections during
-    //! network initialization.
-    struct WelcomeMsg {
-        //! the Thrill signature flag.
-        uint64_t thrill_sign;
+    //! maximum connect backoff. Peers which are started later are detected
+    //! after at most this delay, which keeps the startup of large clusters
+    //! short.
+    const size_t max_timeout_ = 320;
 
-        //! the id of the Group associated with the sending Connection.
-        size_t   group_id;
-
-        //! the id of the worker associated with the sending Connection.
-        size_t   id;
+    //! total time of connect retries, after which the program fails.
+    const std::chrono::milliseconds connect_deadline_ {
+        std::chrono::seconds(80)
     };
 
-    //! The Thrill signature flag - introduced by Master Timo.
-    static constexpr uint64_t thrill_sign = 0x0C7A0C7A0C7A0C7A;
+    //! start of the construction, for connect_deadline_
+    std::chrono::steady_clock::time_point start_time_ {
+        std::chrono::steady_clock::now()
+    };
 
     /*!
      * Converts a Thrill endpoint list into a list of socket address.
@@ -208,21 +256,13 @@ private:
      * \return True if initialization is finished, else false.
      */
     bool IsInitializationFinished() {
+        return num_connected_ == num_expected_;
+    }
 
-        for (size_t g = 0; g < group_count_; g++) {
-
-            for (size_t id = 0; id < groups_[g]->num_hosts(); ++id) {
-                if (id == my_rank_) continue;
-
-                // Just checking the state works since this implicitey checks the
-                // size. Unset connections have state ConnectionState::Invalid.
-                if (groups_[g]->tcp_connection(id).state()
-                    != ConnectionState::Connected)
-                    return false;
-            }
-        }
-
-        return true;
+    //! set Connection state to Connected and count it
+    void SetConnected(Connection& tcp) {
+        tcp.set_state(ConnectionState::Connected);
+        ++num_connected_;
     }
 
     /*!
@@ -306,7 +346,7 @@ private:
             tcp.set_state(ConnectionState::HelloSent);
         }
         else if (tcp.state() == ConnectionState::HelloReceived) {
-            tcp.set_state(ConnectionState::Connected);
+            SetConnected(tcp);
         }
         else {
             die("State mismatch: " + std::to_string(tcp.state()));
@@ -323,9 +363,10 @@ private:
         }
         else {
             // exponential backoff of reconnects.
-            it->second = 2 * it->second;
+            it->second = std::min(2 * it->second, max_timeout_);
 
-            if (it->second >= final_timeout_) {
+            if (std::chrono::steady_clock::now() - start_time_
+                >= connect_deadline_) {
                 throw Exception("Timeout error connecting to client "
                                 + std::to_string(id) + " via "
                                 + address.ToStringHostPort());
@@ -455,7 +496,7 @@ private:
         die_unequal(tcp.peer_id(), msg->id);
         die_unequal(tcp.group_id(), msg->group_id);
 
-        tcp.set_state(ConnectionState::Connected);
+        SetConnected(tcp);
     }
 
     /*!
@@ -483,6 +524,12 @@ private:
         die_unless(msg_in->group_id < group_count_);
         die_unless(msg_in->id < groups_[msg_in->group_id]->num_hosts());
 
+        if (msg_in->group_id < num_lazy_groups_) {
+            // a peer which finished construction early connected lazily.
+            lazy_->Assign(tcp, msg_in->group_id, msg_in->id);
+            return;
+        }
+
         die_unequal(groups_[msg_in->group_id]->tcp_connection(msg_in->id).state(),
                     ConnectionState::Invalid);
 
@@ -517,43 +564,175 @@ private:
         assert(dynamic_cast<Connection*>(&conn));
         Connection& tcp = static_cast<Connection&>(conn);
 
-        // accept listening socket
-        connections_.emplace_back(tcp.GetSocket().accept());
-        die_unless(connections_.back().GetSocket().IsValid());
+        // accept all pending connections on the non-blocking listener
+        while (true)
+        {
+            Socket socket = tcp.GetSocket().accept();
+            if (!socket.IsValid()) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK ||
+                    errno == EINTR || errno == ECONNABORTED)
+                    break;
+                throw Exception("Error accepting connection", errno);
+            }
 
-        tcp.set_state(ConnectionState::TransportConnected);
+            connections_.emplace_back(std::move(socket));
 
-        LOG << "OnIncomingConnection() " << my_rank_ << " accepted connection"
-            << " fd=" << connections_.back().GetSocket().fd()
-            << " from=" << connections_.back().GetPeerAddress();
+            tcp.set_state(ConnectionState::TransportConnected);
 
-        // wait for welcome message from other side
-        dispatcher_.AsyncRead(
-            connections_.back(), /* seq */ 0, sizeof(WelcomeMsg),
-            AsyncReadBufferCallback::make<
-                Construction, &Construction::OnIncomingWelcomeAndReply>(this));
+            LOG << "OnIncomingConnection() " << my_rank_
+                << " accepted connection"
+                << " fd=" << connections_.back().GetSocket().fd()
+                << " from=" << connections_.back().GetPeerAddress();
+
+            // wait for welcome message from other side
+            dispatcher_.AsyncRead(
+                connections_.back(), /* seq */ 0, sizeof(WelcomeMsg),
+                AsyncReadBufferCallback::make<
+                    Construction,
+                    &Construction::OnIncomingWelcomeAndReply>(this));
+        }
 
         // wait for more connections.
         return true;
     }
 };
 
+/******************************************************************************/
+// LazyConnector
+
+LazyConnector::LazyConnector(
+    size_t my_rank, const std::vector<SocketAddress>& addresses,
+    std::unique_ptr<Group>* groups, size_t num_lazy_groups)
+    : my_rank_(my_rank), addresses_(addresses) {
+    for (size_t g = 0; g < num_lazy_groups; ++g)
+        groups_.push_back(groups[g].get());
+}
+
+void LazyConnector::SetListener(Connection&& listener) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    listener_ = std::move(listener);
+    // accept blocks until a peer connects
+    listener_.SetNonBlocking(false);
+}
+
+void LazyConnector::Connect(size_t group, size_t peer) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    assert(group < groups_.size());
+
+    // the peer may have been accepted while waiting for another one.
+    if (groups_[group]->IsConnected(peer)) return;
+
+    if (my_rank_ < peer)
+        ActiveConnect(group, peer);
+    else
+        AcceptUntil(group, peer);
+}
+
+void LazyConnector::Assign(Connection& connection, size_t group, size_t peer) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    AssignLocked(connection, group, peer);
+}
+
+void LazyConnector::AssignLocked(
+    Connection& connection, size_t group, size_t peer) {
+    die_unless(group < groups_.size());
+    die_unless(peer != my_rank_);
+
+    Group& g = *groups_[group];
+    die_unless(!g.IsConnected(peer));
+
+    connection.set_group_id(group);
+    connection.set_peer_id(peer);
+    connection.set_state(ConnectionState::Connected);
+
+    g.AssignConnection(connection);
+    g.connected_[peer].store(true, std::memory_order_release);
+
+    LOG << "LazyConnector: " << my_rank_ << " connected"
+        << " group " << group << " peer " << peer;
+}
+
+void LazyConnector::ActiveConnect(size_t group, size_t peer) {
+    const SocketAddress& address = addresses_[peer];
+
+    // all listeners are open after the construction, but retry on refusals
+    // in case the peer's accept queue overflows.
+    size_t timeout = 10;
+    Connection conn;
+    while (true) {
+        conn = Connection(Socket::Create());
+        if (conn.GetSocket().connect(address) == 0) break;
+
+        int err = errno;
+        if (err != ECONNREFUSED && err != ETIMEDOUT && err != EINTR) {
+            throw Exception("Error connecting lazily to client "
+                            + std::to_string(peer) + " via "
+                            + address.ToStringHostPort(), err);
+        }
+
+        LOG << "LazyConnector: connect to " << address.ToStringHostPort()
+            << " failed with error " << err
+            << ", retrying in " << timeout << "msec";
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        timeout = std::min<size_t>(2 * timeout, 320);
+    }
+
+    // send welcome message, the peer does not reply.
+    const WelcomeMsg hello = { thrill_sign, group, my_rank_ };
+    conn.SyncSend(&hello, sizeof(hello), net::Connection::NoFlags);
+
+    AssignLocked(conn, group, peer);
+}
+
+void LazyConnector::AcceptUntil(size_t group, size_t peer) {
+    die_unless(listener_.IsValid());
+
+    while (!groups_[group]->IsConnected(peer))
+    {
+        Socket socket = listener_.GetSocket().accept();
+        if (!socket.IsValid()) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            throw Exception("Error accepting lazy connection", errno);
+        }
+
+        Connection conn(std::move(socket));
+
+        // the welcome message is sent immediately after connecting.
+        WelcomeMsg msg;
+        conn.SyncRecv(&msg, sizeof(msg));
+
+        die_unequal(msg.thrill_sign, uint64_t(thrill_sign));
+        die_unless(msg.id < my_rank_);
+
+        LOG << "LazyConnector: " << my_rank_ << " accepted"
+            << " group " << msg.group_id << " peer " << msg.id;
+
+        AssignLocked(conn, msg.group_id, msg.id);
+    }
+}
+
+/******************************************************************************/
+
 //! Connect to peers via endpoints using TCP sockets. Construct a group_count
 //! tcp::Group objects at once. Within each Group this host has my_rank.
-void Construct(SelectDispatcher& dispatcher, size_t my_rank,
+void Construct(net::Dispatcher& dispatcher, size_t my_rank,
                const std::vector<std::string>& endpoints,
-               std::unique_ptr<Group>* groups, size_t group_count) {
-    Construction(dispatcher, groups, group_count)
+               std::unique_ptr<Group>* groups, size_t group_count,
+               size_t num_lazy_groups) {
+    Construction(dispatcher, groups, group_count, num_lazy_groups)
     .Initialize(my_rank, endpoints);
 }
 
 //! Connect to peers via endpoints using TCP sockets. Construct a group_count
 //! net::Group objects at once. Within each Group this host has my_rank.
 std::vector<std::unique_ptr<net::Group> >
-Construct(SelectDispatcher& dispatcher, size_t my_rank,
-          const std::vector<std::string>& endpoints, size_t group_count) {
+Construct(net::Dispatcher& dispatcher, size_t my_rank,
+          const std::vector<std::string>& endpoints, size_t group_count,
+          size_t num_lazy_groups) {
     std::vector<std::unique_ptr<tcp::Group> > tcp_groups(group_count);
-    Construction(dispatcher, &tcp_groups[0], tcp_groups.size())
+    Construction(dispatcher, &tcp_groups[0], tcp_groups.size(),
+                 num_lazy_groups)
     .Initialize(my_rank, endpoints);
     std::vector<std::unique_ptr<net::Group> > groups(group_count);
     std::move(tcp_groups.begin(), tcp_groups.end(), groups.begin());
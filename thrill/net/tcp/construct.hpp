@@ -13,9 +13,13 @@
 #ifndef THRILL_NET_TCP_CONSTRUCT_HEADER
 #define THRILL_NET_TCP_CONSTRUCT_HEADER
 
+#include <thrill/net/dispatcher.hpp>
+#include <thrill/net/tcp/connection.hpp>
 #include <thrill/net/tcp/group.hpp>
+#include <thrill/net/tcp/socket_address.hpp>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -26,17 +30,80 @@ namespace tcp {
 //! \addtogroup net_tcp TCP Socket API
 //! \{
 
-//! Connect to peers via endpoints using TCP sockets. Construct a group_count
-//! tcp::Group objects at once. Within each Group this host has my_rank.
-void Construct(SelectDispatcher& dispatcher, size_t my_rank,
+/*!
+ * Establishes the Connections of lazy Groups on demand. The listener socket of
+ * the construction is kept open. The host with lower rank actively connects to
+ * the peer and sends a welcome message, the host with higher rank accepts
+ * connections until the one from the peer arrives, and assigns the others to
+ * their Groups. Since collectives are symmetric, the peer eventually requires
+ * the Connection as well, and no reply is needed.
+ */
+class LazyConnector
+{
+    static constexpr bool debug = false;
+
+public:
+    LazyConnector(size_t my_rank, const std::vector<SocketAddress>& addresses,
+                  std::unique_ptr<Group>* groups, size_t num_lazy_groups);
+
+    //! non-copyable: delete copy-constructor
+    LazyConnector(const LazyConnector&) = delete;
+    //! non-copyable: delete assignment operator
+    LazyConnector& operator = (const LazyConnector&) = delete;
+
+    //! take over the listener after the construction of the eager Groups
+    void SetListener(Connection&& listener);
+
+    //! establish the Connection of group to peer, blocks until it is ready.
+    void Connect(size_t group, size_t peer);
+
+    //! assign a Connection accepted during construction to its lazy Group
+    void Assign(Connection& connection, size_t group, size_t peer);
+
+private:
+    //! serializes connects and accepts of all lazy Groups
+    std::mutex mutex_;
+
+    //! rank of this host
+    size_t my_rank_;
+
+    //! addresses of all hosts
+    std::vector<SocketAddress> addresses_;
+
+    //! lazy Groups, indexed by group id
+    std::vector<Group*> groups_;
+
+    //! listener for incoming connections
+    Connection listener_;
+
+    //! assign the Connection to the Group and mark it connected
+    void AssignLocked(Connection& connection, size_t group, size_t peer);
+
+    //! actively connect to peer and send the welcome message
+    void ActiveConnect(size_t group, size_t peer);
+
+    //! accept connections until the one of group to peer is established
+    void AcceptUntil(size_t group, size_t peer);
+};
+
+/*!
+ * Connect to peers via endpoints using TCP sockets. Construct a group_count
+ * tcp::Group objects at once. Within each Group this host has my_rank. The
+ * connections to all peers are set up concurrently with non-blocking sockets,
+ * driven by the dispatcher. The first num_lazy_groups Groups connect to each
+ * peer on demand via a LazyConnector, at least one Group must be eager.
+ */
+void Construct(net::Dispatcher& dispatcher, size_t my_rank,
                const std::vector<std::string>& endpoints,
-               std::unique_ptr<Group>* groups, size_t group_count);
+               std::unique_ptr<Group>* groups, size_t group_count,
+               size_t num_lazy_groups = 0);
 
 //! Connect to peers via endpoints using TCP sockets. Construct a group_count
 //! net::Group objects at once. Within each Group this host has my_rank.
 std::vector<std::unique_ptr<net::Group> >
-Construct(SelectDispatcher& dispatcher, size_t my_rank,
-          const std::vector<std::string>& endpoints, size_t group_count);
+Construct(net::Dispatcher& dispatcher, size_t my_rank,
+          const std::vector<std::string>& endpoints, size_t group_count,
+          size_t num_lazy_groups = 0);
 
 //! \}
 
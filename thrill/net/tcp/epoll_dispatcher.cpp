@@ -0,0 +1,194 @@
+/*******************************************************************************
+ * thrill/net/tcp/epoll_dispatcher.cpp
+ *
+ * Asynchronous callback wrapper around epoll()
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/net/tcp/epoll_dispatcher.hpp>
+
+#if THRILL_HAVE_NET_EPOLL
+
+#include <thrill/common/porting.hpp>
+#include <thrill/net/tcp/socket.hpp>
+#include <tlx/die.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <limits>
+
+namespace thrill {
+namespace net {
+namespace tcp {
+
+EPollDispatcher::EPollDispatcher()
+    : net::Dispatcher(), events_(64) {
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0)
+        throw Exception("EPollDispatcher() could not create epoll fd", errno);
+
+    // allocate self-pipe
+    common::MakePipe(self_pipe_);
+
+    if (!Socket::SetNonBlocking(self_pipe_[0], true)) {
+        LOG1 << "EPollDispatcher() cannot set up self-pipe for non-blocking reads";
+    }
+
+    // Ignore PIPE signals (received when writing to closed sockets)
+    signal(SIGPIPE, SIG_IGN);
+
+    // wait interrupts via self-pipe.
+    AddRead(self_pipe_[0],
+            Callback::make<EPollDispatcher,
+                           & EPollDispatcher::SelfPipeCallback>(this));
+}
+
+EPollDispatcher::~EPollDispatcher() {
+    ::close(self_pipe_[0]);
+    ::close(self_pipe_[1]);
+    ::close(epoll_fd_);
+}
+
+void EPollDispatcher::Update(int fd) {
+    Watch& w = watch_[fd];
+
+    uint32_t events = (w.read_cb.empty() ? 0 : EPOLLIN)
+                      | (w.write_cb.empty() ? 0 : EPOLLOUT);
+    if (events == w.events) return;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+
+    if (events == 0) {
+        // may fail if the fd was already closed, which also unregisters it.
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &ev);
+        w.events = 0;
+        return;
+    }
+
+    int op = w.events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    int r = epoll_ctl(epoll_fd_, op, fd, &ev);
+    if (r != 0 && op == EPOLL_CTL_MOD && errno == ENOENT) {
+        // the fd was closed and reused without Cancel()
+        r = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+    else if (r != 0 && op == EPOLL_CTL_ADD && errno == EEXIST) {
+        r = epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+    }
+    if (r != 0)
+        throw Exception("EPollDispatcher() epoll_ctl() failed", errno);
+
+    sLOG << "EPollDispatcher::Update() fd" << fd << "events" << events;
+    w.events = events;
+}
+
+void EPollDispatcher::Cancel(net::Connection& c) {
+    assert(dynamic_cast<Connection*>(&c));
+    Connection& tc = static_cast<Connection&>(c);
+    int fd = tc.GetSocket().fd();
+    Watch& w = GetWatch(fd);
+
+    if (w.read_cb.size() == 0 && w.write_cb.size() == 0)
+        LOG << "EPollDispatcher::Cancel() fd=" << fd
+            << " called with no callbacks registered.";
+
+    w.read_cb.clear();
+    w.write_cb.clear();
+    Update(fd);
+}
+
+//! Run one iteration of dispatching epoll_wait().
+void EPollDispatcher::DispatchOne(const std::chrono::milliseconds& timeout) {
+
+    int timeout_ms = static_cast<int>(
+        std::min<int64_t>(timeout.count(), std::numeric_limits<int>::max()));
+
+    int r = epoll_wait(epoll_fd_, events_.data(),
+                       static_cast<int>(events_.size()), timeout_ms);
+
+    if (r < 0) {
+        // if we caught a signal, this is intended to interrupt epoll_wait().
+        if (errno == EINTR) {
+            LOG << "Dispatch(): epoll_wait() was interrupted due to a signal.";
+            return;
+        }
+
+        throw Exception("EPollDispatcher::DispatchOne() failed!", errno);
+    }
+
+    for (int i = 0; i < r; ++i)
+    {
+        int fd = events_[i].data.fd;
+        uint32_t events = events_[i].events;
+
+        // errors and hang-ups are handled by the callbacks, which see them as
+        // failed reads or writes, like with select().
+        uint32_t error = events & (EPOLLERR | EPOLLHUP);
+
+        // the std::vector may regrow when callback handlers are called,
+        // hence the pointer into watch_ is reset after each callback.
+        Watch* w = &watch_[fd];
+
+        if ((events & EPOLLIN) || error) {
+            // run read callbacks until one returns true (in which case it
+            // wants to be called again), or the read_cb list is empty.
+            while (w->read_cb.size() && w->read_cb.front()() == false) {
+                w = &watch_[fd];
+                w->read_cb.pop_front();
+            }
+            w = &watch_[fd];
+        }
+
+        if ((events & EPOLLOUT) || error) {
+            // run write callbacks until one returns true (in which case it
+            // wants to be called again), or the write_cb list is empty.
+            while (w->write_cb.size() && w->write_cb.front()() == false) {
+                w = &watch_[fd];
+                w->write_cb.pop_front();
+            }
+            w = &watch_[fd];
+        }
+
+        // stop listening for events without callbacks.
+        Update(fd);
+    }
+
+    // all slots were used: grow the event buffer for the next call.
+    if (static_cast<size_t>(r) == events_.size())
+        events_.resize(2 * events_.size());
+}
+
+void EPollDispatcher::Interrupt() {
+    // send one byte to wake up epoll_wait(), see SelectDispatcher::Interrupt().
+    ssize_t wb;
+    while ((wb = write(self_pipe_[1], this, 1)) == 0) {
+        LOG1 << "WakeUp: error sending to self-pipe: " << errno;
+    }
+    die_unless(wb == 1);
+}
+
+bool EPollDispatcher::SelfPipeCallback() {
+    while (read(self_pipe_[0],
+                self_pipe_buffer_, sizeof(self_pipe_buffer_)) > 0) {
+        /* repeat, until empty pipe */
+    }
+    return true;
+}
+
+} // namespace tcp
+} // namespace net
+} // namespace thrill
+
+#endif // THRILL_HAVE_NET_EPOLL
+
+/******************************************************************************/
@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * thrill/net/tcp/epoll_dispatcher.hpp
+ *
+ * Asynchronous callback wrapper around epoll()
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_NET_TCP_EPOLL_DISPATCHER_HEADER
+#define THRILL_NET_TCP_EPOLL_DISPATCHER_HEADER
+
+#include <thrill/common/config.hpp>
+
+#if THRILL_HAVE_NET_EPOLL
+
+#include <thrill/common/logger.hpp>
+#include <thrill/mem/allocator.hpp>
+#include <thrill/net/connection.hpp>
+#include <thrill/net/dispatcher.hpp>
+#include <thrill/net/exception.hpp>
+#include <thrill/net/tcp/connection.hpp>
+#include <tlx/delegate.hpp>
+
+#include <sys/epoll.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace thrill {
+namespace net {
+namespace tcp {
+
+//! \addtogroup net_tcp TCP Socket API
+//! \{
+
+/*!
+ * EPollDispatcher is a drop-in replacement for the SelectDispatcher using
+ * Linux's epoll(). The file descriptors stay registered in the kernel, hence
+ * each DispatchOne() costs O(ready fds) instead of O(fds) and there is no
+ * FD_SETSIZE limit. The registered event mask of a fd is only changed with
+ * epoll_ctl() when its read or write callback queue becomes empty or
+ * non-empty.
+ */
+class EPollDispatcher final : public net::Dispatcher
+{
+    static constexpr bool debug = false;
+
+public:
+    //! type for file descriptor readiness callbacks
+    using Callback = AsyncCallback;
+
+    //! constructor
+    EPollDispatcher();
+
+    //! non-copyable: delete copy-constructor
+    EPollDispatcher(const EPollDispatcher&) = delete;
+    //! non-copyable: delete assignment operator
+    EPollDispatcher& operator = (const EPollDispatcher&) = delete;
+
+    ~EPollDispatcher();
+
+    //! Register a buffered read callback.
+    void AddRead(int fd, const Callback& read_cb) {
+        Watch& w = GetWatch(fd);
+        w.read_cb.emplace_back(read_cb);
+        Update(fd);
+    }
+
+    //! Register a buffered read callback.
+    void AddRead(net::Connection& c, const Callback& read_cb) final {
+        assert(dynamic_cast<Connection*>(&c));
+        Connection& tc = static_cast<Connection&>(c);
+        return AddRead(tc.GetSocket().fd(), read_cb);
+    }
+
+    //! Register a buffered write callback.
+    void AddWrite(net::Connection& c, const Callback& write_cb) final {
+        assert(dynamic_cast<Connection*>(&c));
+        Connection& tc = static_cast<Connection&>(c);
+        int fd = tc.GetSocket().fd();
+        Watch& w = GetWatch(fd);
+        w.write_cb.emplace_back(write_cb);
+        Update(fd);
+    }
+
+    //! Cancel all callbacks on a given fd.
+    void Cancel(net::Connection& c) final;
+
+    //! TCP sockets are byte streams, hence writes may be coalesced.
+    bool IsByteStream() const final { return true; }
+
+    //! Run one iteration of dispatching epoll_wait().
+    void DispatchOne(const std::chrono::milliseconds& timeout) final;
+
+    //! Interrupt the current epoll_wait() via self-pipe
+    void Interrupt() final;
+
+private:
+    //! epoll file descriptor
+    int epoll_fd_;
+
+    //! self-pipe to wake up epoll_wait().
+    int self_pipe_[2];
+
+    //! buffer to receive one byte signals from self-pipe
+    char self_pipe_buffer_[32];
+
+    //! callback queues and registered event mask per file descriptor
+    struct Watch {
+        //! events currently registered with epoll_ctl(), zero if none.
+        uint32_t events = 0;
+        //! queue of callbacks for fd.
+        std::deque<Callback, mem::GPoolAllocator<Callback> >
+                 read_cb, write_cb;
+    };
+
+    //! handlers for all registered file descriptors, indexed by fd like in
+    //! the SelectDispatcher.
+    std::vector<Watch> watch_;
+
+    //! buffer for the ready events returned by epoll_wait()
+    std::vector<struct epoll_event> events_;
+
+    //! grow table if needed and return the Watch of fd
+    Watch& GetWatch(int fd) {
+        assert(fd >= 0);
+        if (static_cast<size_t>(fd) >= watch_.size())
+            watch_.resize(fd + 1);
+        return watch_[fd];
+    }
+
+    //! register the events of the non-empty callback queues of fd
+    void Update(int fd);
+
+    //! Self-pipe callback
+    bool SelfPipeCallback();
+};
+
+//! \}
+
+} // namespace tcp
+} // namespace net
+} // namespace thrill
+
+#endif // THRILL_HAVE_NET_EPOLL
+
+#endif // !THRILL_NET_TCP_EPOLL_DISPATCHER_HEADER
+
+/******************************************************************************/
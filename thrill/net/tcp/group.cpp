@@ -14,9 +14,12 @@
 
 #include <thrill/common/logger.hpp>
 #include <thrill/net/tcp/construct.hpp>
+#include <thrill/net/tcp/epoll_dispatcher.hpp>
 #include <thrill/net/tcp/group.hpp>
 #include <thrill/net/tcp/select_dispatcher.hpp>
 
+#include <cstdlib>
+#include <cstring>
 #include <random>
 #include <string>
 #include <thread>
@@ -29,10 +32,37 @@ namespace tcp {
 
 std::unique_ptr<Dispatcher>
 Group::ConstructDispatcher() const {
+    return ConstructTcpDispatcher();
+}
+
+std::unique_ptr<Dispatcher> Group::ConstructTcpDispatcher() {
+    // select the dispatcher via THRILL_TCP_DISPATCHER, default: epoll if
+    // available, otherwise select.
+    const char* env_dispatcher = getenv("THRILL_TCP_DISPATCHER");
+
+    if (env_dispatcher && *env_dispatcher &&
+        strcmp(env_dispatcher, "select") != 0 &&
+        strcmp(env_dispatcher, "epoll") != 0) {
+        LOG1 << "Thrill: unknown THRILL_TCP_DISPATCHER=" << env_dispatcher
+             << ", using default.";
+    }
+
+#if THRILL_HAVE_NET_EPOLL
+    if (!env_dispatcher || strcmp(env_dispatcher, "select") != 0) {
+        // construct tcp::EPollDispatcher
+        return std::make_unique<EPollDispatcher>();
+    }
+#endif
+
     // construct tcp::SelectDispatcher
     return std::make_unique<SelectDispatcher>();
 }
 
+void Group::LazyConnect(size_t id) {
+    assert(lazy_);
+    lazy_->Connect(lazy_group_id_, id);
+}
+
 std::vector<std::unique_ptr<Group> > Group::ConstructLoopbackMesh(
     size_t num_hosts) {
 
@@ -19,11 +19,14 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/net/group.hpp>
 #include <thrill/net/tcp/connection.hpp>
+#include <tlx/define/likely.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -35,6 +38,7 @@ namespace tcp {
 //! \{
 
 class SelectDispatcher;
+class LazyConnector;
 
 /*!
  * Collection of NetConnections to workers, allows point-to-point client
@@ -93,6 +97,10 @@ public:
             throw Exception("Group::Connection() requested "
                             "connection to self.");
 
+        // connect lazily on first access
+        if (TLX_UNLIKELY(lazy_ && !IsConnected(id)))
+            LazyConnect(id);
+
         // return Connection to client id.
         return connections_[id];
     }
@@ -101,10 +109,33 @@ public:
         return tcp_connection(id);
     }
 
+    bool IsConnected(size_t id) const final {
+        return !lazy_ || connected_[id].load(std::memory_order_acquire);
+    }
+
+    /*!
+     * Switch the Group to lazy connection setup: the Connections to the peers
+     * are established by the LazyConnector on the first access via
+     * connection(id). Called by Construct() for groups with id less than
+     * num_lazy_groups.
+     */
+    void EnableLazy(const std::shared_ptr<LazyConnector>& lazy,
+                    size_t group_id) {
+        lazy_ = lazy;
+        lazy_group_id_ = group_id;
+        connected_.reset(new std::atomic<bool>[connections_.size()]);
+        for (size_t i = 0; i != connections_.size(); ++i)
+            connected_[i] = (i == my_rank_);
+    }
+
     using Dispatcher = tcp::SelectDispatcher;
 
     std::unique_ptr<net::Dispatcher> ConstructDispatcher() const final;
 
+    //! Construct the dispatcher selected by THRILL_TCP_DISPATCHER: epoll if
+    //! available, otherwise select. Also used for the connection setup.
+    static std::unique_ptr<net::Dispatcher> ConstructTcpDispatcher();
+
     /*!
      * Assigns a connection to this net group.  This method swaps the net
      * connection to memory managed by this group.  The reference given to that
@@ -121,9 +152,13 @@ public:
                             "invalid client id "
                             + std::to_string(connection.peer_id()));
 
-        connections_[connection.peer_id()] = std::move(connection);
+        size_t id = connection.peer_id();
+        connections_[id] = std::move(connection);
 
-        return connections_[connection.peer_id()];
+        if (socket_priority_ >= 0)
+            connections_[id].GetSocket().SetPriority(socket_priority_);
+
+        return connections_[id];
     }
 
     //! Return number of connections in this group (= number computing hosts)
@@ -131,6 +166,30 @@ public:
         return connections_.size();
     }
 
+#if THRILL_HAVE_NET_ZEROCOPY
+    //! Enable zero-copy sends on all connections, returns the number of
+    //! connections which support them.
+    size_t EnableZeroCopy() {
+        size_t count = 0;
+        for (size_t i = 0; i != connections_.size(); ++i) {
+            if (i == my_rank_ || !connections_[i].IsValid()) continue;
+            if (connections_[i].EnableZeroCopy()) ++count;
+        }
+        return count;
+    }
+#endif
+
+    //! Set the SO_PRIORITY of the sockets of all connections, including those
+    //! assigned later by lazy connecting. Must be called before the Group is
+    //! used concurrently.
+    void SetSocketPriority(int priority) {
+        socket_priority_ = priority;
+        for (size_t i = 0; i != connections_.size(); ++i) {
+            if (i == my_rank_ || !connections_[i].IsValid()) continue;
+            connections_[i].GetSocket().SetPriority(priority);
+        }
+    }
+
     //! Closes all client connections
     void Close() {
         for (size_t i = 0; i != connections_.size(); ++i)
@@ -142,6 +201,8 @@ public:
         }
 
         connections_.clear();
+        connected_.reset();
+        lazy_.reset();
     }
 
     //! Closes all client connections
@@ -152,8 +213,27 @@ public:
     //! \}
 
 private:
+    //! for marking lazily established connections
+    friend class LazyConnector;
+
     //! Connections to all other clients in the Group.
     std::vector<Connection> connections_;
+
+    //! shared connector of lazy groups, nullptr if all are connected.
+    std::shared_ptr<LazyConnector> lazy_;
+
+    //! flags whether the connection to each peer is established for lazy
+    //! groups, set after the Connection was assigned.
+    std::unique_ptr<std::atomic<bool>[]> connected_;
+
+    //! id of this Group in the LazyConnector
+    size_t lazy_group_id_ = 0;
+
+    //! SO_PRIORITY of the connections' sockets, or -1 for the default.
+    int socket_priority_ = -1;
+
+    //! establish the Connection to id via the LazyConnector
+    void LazyConnect(size_t id);
 };
 
 //! \}
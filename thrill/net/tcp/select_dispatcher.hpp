@@ -167,6 +167,9 @@ public:
         w.active = false;
     }
 
+    //! TCP sockets are byte streams, hence writes may be coalesced.
+    bool IsByteStream() const final { return true; }
+
     //! Run one iteration of dispatching select().
     void DispatchOne(const std::chrono::milliseconds& timeout) final;
 
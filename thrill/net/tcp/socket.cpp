@@ -12,6 +12,8 @@
 
 #include <thrill/net/tcp/socket.hpp>
 
+#include <tlx/unused.hpp>
+
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -128,6 +130,28 @@ void Socket::SetRcvBuf(size_t size) {
 #endif
 }
 
+void Socket::SetPriority(int priority) {
+    assert(IsValid());
+
+#if __linux__
+    /*
+     * SO_PRIORITY Set the protocol-defined priority for all packets to be sent
+     * on this socket. Linux uses this value to order the networking queues:
+     * packets with a higher priority may be processed first depending on the
+     * selected device queueing discipline. Setting a priority outside the
+     * range 0 to 6 requires the CAP_NET_ADMIN capability.
+     */
+    if (::setsockopt(fd_, SOL_SOCKET, SO_PRIORITY,
+                     &priority, sizeof(priority)) != 0)
+    {
+        LOG << "Cannot set SO_PRIORITY on socket fd " << fd_
+            << ": " << strerror(errno);
+    }
+#else
+    tlx::unused(priority);
+#endif
+}
+
 } // namespace tcp
 } // namespace net
 } // namespace thrill
@@ -596,6 +596,18 @@ public:
     //! Set SO_RCVBUF socket option.
     void SetRcvBuf(size_t size);
 
+    //! Set SO_PRIORITY socket option, which selects the band of the packets
+    //! in the kernel's queueing discipline.
+    void SetPriority(int priority);
+
+    //! SO_PRIORITY of latency-sensitive traffic (TC_PRIO_INTERACTIVE), which
+    //! the default qdisc sends ahead of the other bands.
+    static constexpr int kPriorityInteractive = 6;
+
+    //! SO_PRIORITY of bulk traffic (TC_PRIO_BULK), which the default qdisc
+    //! sends last.
+    static constexpr int kPriorityBulk = 2;
+
     //! \}
 
 private:
@@ -19,44 +19,70 @@ print "#include <$_>\n" foreach sort glob("thrill/api/"."*.hpp");
 #include <thrill/api/action_node.hpp>
 #include <thrill/api/all_gather.hpp>
 #include <thrill/api/all_reduce.hpp>
+#include <thrill/api/approx.hpp>
 #include <thrill/api/bernoulli_sample.hpp>
+#include <thrill/api/binary_index.hpp>
 #include <thrill/api/cache.hpp>
 #include <thrill/api/collapse.hpp>
+#include <thrill/api/columnar_format.hpp>
 #include <thrill/api/concat.hpp>
 #include <thrill/api/concat_to_dia.hpp>
 #include <thrill/api/context.hpp>
+#include <thrill/api/delta_iterate.hpp>
 #include <thrill/api/dia.hpp>
 #include <thrill/api/dia_base.hpp>
 #include <thrill/api/dia_node.hpp>
+#include <thrill/api/dist_matrix.hpp>
+#include <thrill/api/distinct.hpp>
 #include <thrill/api/distribute.hpp>
 #include <thrill/api/dop_node.hpp>
 #include <thrill/api/equal_to_dia.hpp>
 #include <thrill/api/ex_prefix_sum.hpp>
 #include <thrill/api/gather.hpp>
 #include <thrill/api/generate.hpp>
+#include <thrill/api/graph.hpp>
+#include <thrill/api/group_by_accumulate.hpp>
 #include <thrill/api/group_by_iterator.hpp>
 #include <thrill/api/group_by_key.hpp>
 #include <thrill/api/group_to_index.hpp>
 #include <thrill/api/hyperloglog.hpp>
 #include <thrill/api/inner_join.hpp>
+#include <thrill/api/iterate.hpp>
+#include <thrill/api/map_partitions.hpp>
 #include <thrill/api/max.hpp>
 #include <thrill/api/merge.hpp>
+#include <thrill/api/merge_join.hpp>
+#include <thrill/api/multiway_join.hpp>
 #include <thrill/api/min.hpp>
+#include <thrill/api/persist.hpp>
 #include <thrill/api/prefix_sum.hpp>
 #include <thrill/api/print.hpp>
+#include <thrill/api/quantiles.hpp>
+#include <thrill/api/read_arrow_stream.hpp>
 #include <thrill/api/read_binary.hpp>
+#include <thrill/api/read_columnar.hpp>
 #include <thrill/api/read_lines.hpp>
+#include <thrill/api/read_stream.hpp>
 #include <thrill/api/rebalance.hpp>
 #include <thrill/api/reduce_by_key.hpp>
+#include <thrill/api/reduce_local.hpp>
 #include <thrill/api/reduce_to_index.hpp>
+#include <thrill/api/repartition.hpp>
 #include <thrill/api/sample.hpp>
+#include <thrill/api/segmented_prefix_sum.hpp>
+#include <thrill/api/semi_join.hpp>
 #include <thrill/api/size.hpp>
 #include <thrill/api/sort.hpp>
+#include <thrill/api/sort_by_key.hpp>
 #include <thrill/api/source_node.hpp>
 #include <thrill/api/sum.hpp>
+#include <thrill/api/top_k.hpp>
 #include <thrill/api/union.hpp>
+#include <thrill/api/weighted_sample.hpp>
 #include <thrill/api/window.hpp>
+#include <thrill/api/write_arrow_stream.hpp>
 #include <thrill/api/write_binary.hpp>
+#include <thrill/api/write_columnar.hpp>
 #include <thrill/api/write_lines.hpp>
 #include <thrill/api/write_lines_one.hpp>
 #include <thrill/api/zip.hpp>
@@ -0,0 +1,559 @@
+/*******************************************************************************
+ * thrill/vfs/direct_file.cpp
+ *
+ * Unbuffered file streams using O_DIRECT and io_uring
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/direct_file.hpp>
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/system_exception.hpp>
+
+#include <tlx/die.hpp>
+#include <tlx/unused.hpp>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if THRILL_HAVE_IO_URING
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+#if defined(__linux__)
+
+//! alignment of O_DIRECT offsets, sizes, and buffers
+static constexpr size_t kDirectAlign = 4096;
+
+//! size of each request
+static constexpr size_t kDirectChunk = 1024 * 1024;
+
+/******************************************************************************/
+// IoQueue - minimal io_uring submission and completion queue
+
+/*!
+ * Queue of asynchronous pread/pwrite requests on a private io_uring, which is
+ * driven directly via the system calls. If the kernel does not provide
+ * io_uring with IORING_OP_READ/WRITE (Linux < 5.6) or it is disabled, the
+ * requests are performed synchronously in Submit().
+ */
+class IoQueue
+{
+    static constexpr bool debug = false;
+
+public:
+    explicit IoQueue(size_t depth) {
+#if THRILL_HAVE_IO_URING
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+
+        ring_fd_ = static_cast<int>(
+            syscall(__NR_io_uring_setup, static_cast<unsigned>(depth), &p));
+        if (ring_fd_ < 0) {
+            LOG << "IoQueue: io_uring_setup() failed: " << strerror(errno);
+            return;
+        }
+        if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+            // kernel too old for IORING_OP_READ and IORING_OP_WRITE
+            ::close(ring_fd_);
+            ring_fd_ = -1;
+            return;
+        }
+
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        if (p.features & IORING_FEAT_SINGLE_MMAP)
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+
+        sq_ptr_ = Map(sq_size_, IORING_OFF_SQ_RING);
+        cq_ptr_ = (p.features & IORING_FEAT_SINGLE_MMAP)
+                  ? sq_ptr_ : Map(cq_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = reinterpret_cast<io_uring_sqe*>(
+            Map(sqes_size_, IORING_OFF_SQES));
+
+        sq_tail_ = reinterpret_cast<unsigned*>(sq_ptr_ + p.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq_ptr_ + p.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq_ptr_ + p.sq_off.array);
+
+        cq_head_ = reinterpret_cast<unsigned*>(cq_ptr_ + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq_ptr_ + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq_ptr_ + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq_ptr_ + p.cq_off.cqes);
+#else
+        tlx::unused(depth);
+#endif
+    }
+
+    //! non-copyable: delete copy-constructor
+    IoQueue(const IoQueue&) = delete;
+    //! non-copyable: delete assignment operator
+    IoQueue& operator = (const IoQueue&) = delete;
+
+    ~IoQueue() {
+#if THRILL_HAVE_IO_URING
+        if (ring_fd_ < 0) return;
+        munmap(sqes_, sqes_size_);
+        if (cq_ptr_ != sq_ptr_)
+            munmap(cq_ptr_, cq_size_);
+        munmap(sq_ptr_, sq_size_);
+        ::close(ring_fd_);
+#endif
+    }
+
+    //! submit a read or write of size bytes at offset, tagged for Wait().
+    void Submit(bool write, int fd, void* buf, size_t size, uint64_t offset,
+                uint64_t tag) {
+#if THRILL_HAVE_IO_URING
+        if (ring_fd_ >= 0) {
+            unsigned tail = *sq_tail_;
+            unsigned index = tail & sq_mask_;
+
+            io_uring_sqe* sqe = &sqes_[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buf);
+            sqe->len = static_cast<uint32_t>(size);
+            sqe->off = offset;
+            sqe->user_data = tag;
+
+            sq_array_[index] = index;
+            __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+            Enter(/* to_submit */ 1, /* min_complete */ 0, 0);
+            return;
+        }
+#endif
+        ssize_t r = write ? ::pwrite(fd, buf, size, offset)
+                    : ::pread(fd, buf, size, offset);
+        done_.emplace_back(tag, r < 0 ? -errno : r);
+    }
+
+    //! wait for a completed request, returns its tag and its result: the
+    //! number of bytes transferred or -errno.
+    void Wait(uint64_t* tag, ssize_t* result) {
+#if THRILL_HAVE_IO_URING
+        if (ring_fd_ >= 0) {
+            while (true) {
+                unsigned head = *cq_head_;
+                if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                    const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                    *tag = cqe.user_data;
+                    *result = cqe.res;
+                    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+                    return;
+                }
+                Enter(/* to_submit */ 0, /* min_complete */ 1,
+                      IORING_ENTER_GETEVENTS);
+            }
+        }
+#endif
+        die_unless(!done_.empty());
+        *tag = done_.front().first;
+        *result = done_.front().second;
+        done_.pop_front();
+    }
+
+private:
+    //! completions of requests performed synchronously
+    std::deque<std::pair<uint64_t, ssize_t> > done_;
+
+#if THRILL_HAVE_IO_URING
+    //! io_uring file descriptor, or -1 if not available
+    int ring_fd_ = -1;
+
+    //! mapped submission and completion rings
+    char* sq_ptr_ = nullptr, * cq_ptr_ = nullptr;
+    size_t sq_size_ = 0, cq_size_ = 0;
+
+    //! mapped submission queue entries
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    //! pointers into the submission ring
+    unsigned* sq_tail_ = nullptr, * sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+
+    //! pointers into the completion ring
+    unsigned* cq_head_ = nullptr, * cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    char * Map(size_t size, off_t offset) {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+        if (p == MAP_FAILED)
+            throw common::ErrnoException("IoQueue: mmap() failed", errno);
+        return reinterpret_cast<char*>(p);
+    }
+
+    void Enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        while (syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                       min_complete, flags, nullptr, 0) < 0) {
+            if (errno != EINTR) {
+                throw common::ErrnoException(
+                          "IoQueue: io_uring_enter() failed", errno);
+            }
+        }
+    }
+#endif
+};
+
+/******************************************************************************/
+
+//! request buffer with O_DIRECT alignment
+struct DirectSlot {
+    explicit DirectSlot(size_t size) {
+        void* p;
+        if (posix_memalign(&p, kDirectAlign, size) != 0)
+            throw std::bad_alloc();
+        data = reinterpret_cast<char*>(p);
+    }
+
+    //! non-copyable: delete copy-constructor
+    DirectSlot(const DirectSlot&) = delete;
+    //! non-copyable: delete assignment operator
+    DirectSlot& operator = (const DirectSlot&) = delete;
+
+    ~DirectSlot() {
+        free(data);
+    }
+
+    //! aligned buffer of kDirectChunk bytes
+    char* data;
+    //! file offset of the request
+    uint64_t offset = 0;
+    //! bytes of the request, or bytes valid after a read
+    size_t size = 0;
+    //! bytes consumed by read(), or bytes filled by write()
+    size_t pos = 0;
+    //! result of the request: bytes transferred or -errno
+    ssize_t result = 0;
+    //! whether a request was submitted
+    bool pending = false;
+    //! whether the request completed
+    bool done = false;
+};
+
+//! open with O_DIRECT, or without it, if the file system does not support it.
+static int OpenDirect(const std::string& path, int flags) {
+    int fd = ::open(path.c_str(), flags | O_DIRECT | O_CLOEXEC, 0666);
+    if (fd < 0 && errno == EINVAL) {
+        // e.g. tmpfs
+        fd = ::open(path.c_str(), flags | O_CLOEXEC, 0666);
+    }
+    return fd;
+}
+
+/******************************************************************************/
+// DirectReadStream
+
+/*!
+ * Reads a file sequentially with queue_depth outstanding aligned requests. The
+ * slots are consumed in the order of the file offsets, and a consumed slot is
+ * immediately reissued for the next chunk.
+ */
+class DirectReadStream final : public virtual ReadStream
+{
+public:
+    DirectReadStream(int fd, uint64_t offset, uint64_t file_size,
+                     size_t depth)
+        : fd_(fd), file_size_(file_size), queue_(depth) {
+        for (size_t i = 0; i < depth; ++i)
+            slots_.emplace_back(new DirectSlot(kDirectChunk));
+
+        // first request starts aligned, then skip to the offset
+        next_offset_ = offset - offset % kDirectAlign;
+        skip_ = offset - next_offset_;
+
+        for (size_t i = 0; i < depth; ++i)
+            Issue(i);
+    }
+
+    ~DirectReadStream() {
+        close();
+    }
+
+    ssize_t read(void* data, size_t size) final {
+        char* out = reinterpret_cast<char*>(data);
+        size_t done = 0;
+
+        while (done < size)
+        {
+            DirectSlot& s = *slots_[head_];
+            if (!s.pending) break;
+
+            while (!s.done)
+                Complete();
+
+            if (s.result < 0) {
+                throw common::ErrnoException(
+                          "DirectReadStream: read failed",
+                          static_cast<int>(-s.result));
+            }
+            s.size = static_cast<size_t>(s.result);
+            if (s.size < kDirectChunk && s.offset + s.size < file_size_) {
+                throw common::SystemException(
+                          "DirectReadStream: short read in file");
+            }
+
+            if (s.pos < s.size) {
+                size_t n = std::min(size - done, s.size - s.pos);
+                std::copy(s.data + s.pos, s.data + s.pos + n, out + done);
+                s.pos += n, done += n;
+                if (s.pos < s.size) break;
+            }
+
+            // slot consumed: reissue for the next chunk
+            Issue(head_);
+            head_ = (head_ + 1) % slots_.size();
+        }
+
+        return done;
+    }
+
+    void close() final {
+        if (fd_ < 0) return;
+
+        // wait for requests in flight, which write into our buffers
+        for (std::unique_ptr<DirectSlot>& s : slots_) {
+            while (s->pending && !s->done)
+                Complete();
+        }
+
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    //! file descriptor
+    int fd_;
+    //! size of the file at opening
+    uint64_t file_size_;
+    //! request queue
+    IoQueue queue_;
+    //! request buffers, consumed round-robin
+    std::vector<std::unique_ptr<DirectSlot> > slots_;
+    //! slot read next
+    size_t head_ = 0;
+    //! offset of the next request
+    uint64_t next_offset_;
+    //! bytes to skip in the first request
+    size_t skip_;
+
+    //! submit request for the next chunk into slot i, if not at end of file
+    void Issue(size_t i) {
+        DirectSlot& s = *slots_[i];
+        s.done = false, s.result = 0;
+        s.pending = (next_offset_ < file_size_);
+        if (!s.pending) return;
+
+        s.offset = next_offset_;
+        s.size = 0;
+        s.pos = skip_;
+        skip_ = 0;
+        queue_.Submit(/* write */ false, fd_, s.data, kDirectChunk,
+                      s.offset, i);
+        next_offset_ += kDirectChunk;
+    }
+
+    //! wait for one completion and store its result
+    void Complete() {
+        uint64_t tag;
+        ssize_t result;
+        queue_.Wait(&tag, &result);
+        slots_[tag]->result = result;
+        slots_[tag]->done = true;
+    }
+};
+
+ReadStreamPtr SysOpenDirectReadStream(
+    const std::string& path, const common::Range& range, size_t queue_depth) {
+
+    int fd = OpenDirect(path, O_RDONLY);
+    if (fd < 0)
+        throw common::ErrnoException("Cannot open file " + path, errno);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw common::ErrnoException("Cannot stat file " + path, err);
+    }
+
+    return tlx::make_counting<DirectReadStream>(
+        fd, range.begin, static_cast<uint64_t>(st.st_size),
+        std::max<size_t>(queue_depth, 1));
+}
+
+/******************************************************************************/
+// DirectWriteStream
+
+/*!
+ * Writes a file sequentially from queue_depth aligned buffers. A full buffer
+ * is submitted, and the next one is filled while it is written. On close() the
+ * last buffer is padded to the alignment, and the file is truncated to the
+ * number of bytes written.
+ */
+class DirectWriteStream final : public virtual WriteStream
+{
+public:
+    DirectWriteStream(int fd, size_t depth)
+        : fd_(fd), queue_(depth) {
+        for (size_t i = 0; i < depth; ++i)
+            slots_.emplace_back(new DirectSlot(kDirectChunk));
+    }
+
+    ~DirectWriteStream() {
+        close();
+    }
+
+    ssize_t write(const void* data, const size_t size) final {
+        const char* in = reinterpret_cast<const char*>(data);
+        size_t done = 0;
+
+        while (done < size)
+        {
+            DirectSlot& s = *slots_[current_];
+            if (s.pending)
+                WaitSlot(s);
+
+            size_t n = std::min(size - done, kDirectChunk - s.pos);
+            std::copy(in + done, in + done + n, s.data + s.pos);
+            s.pos += n, done += n;
+
+            if (s.pos == kDirectChunk) {
+                Flush(current_, kDirectChunk);
+                current_ = (current_ + 1) % slots_.size();
+            }
+        }
+
+        return size;
+    }
+
+    void close() final {
+        if (fd_ < 0) return;
+
+        // write the tail padded to the alignment
+        DirectSlot& s = *slots_[current_];
+        if (!s.pending && s.pos != 0) {
+            size_t padded = (s.pos + kDirectAlign - 1) / kDirectAlign
+                            * kDirectAlign;
+            std::fill(s.data + s.pos, s.data + padded, 0);
+            Flush(current_, padded);
+        }
+
+        for (std::unique_ptr<DirectSlot>& t : slots_) {
+            if (t->pending)
+                WaitSlot(*t);
+        }
+
+        if (::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+            throw common::ErrnoException(
+                      "DirectWriteStream: ftruncate() failed", errno);
+        }
+
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    //! file descriptor
+    int fd_;
+    //! request queue
+    IoQueue queue_;
+    //! request buffers, filled round-robin
+    std::vector<std::unique_ptr<DirectSlot> > slots_;
+    //! slot filled next
+    size_t current_ = 0;
+    //! offset of the next request
+    uint64_t next_offset_ = 0;
+    //! number of data bytes written
+    uint64_t size_ = 0;
+
+    //! submit the filled slot i with size bytes
+    void Flush(size_t i, size_t size) {
+        DirectSlot& s = *slots_[i];
+        s.offset = next_offset_;
+        s.size = size;
+        s.pending = true, s.done = false;
+        queue_.Submit(/* write */ true, fd_, s.data, size, s.offset, i);
+        next_offset_ += size;
+        size_ += s.pos;
+    }
+
+    //! wait until the request of slot s completed and check it
+    void WaitSlot(DirectSlot& s) {
+        while (!s.done) {
+            uint64_t tag;
+            ssize_t result;
+            queue_.Wait(&tag, &result);
+            slots_[tag]->result = result;
+            slots_[tag]->done = true;
+        }
+        s.pending = false;
+        s.pos = 0;
+
+        if (s.result < 0) {
+            throw common::ErrnoException(
+                      "DirectWriteStream: write failed",
+                      static_cast<int>(-s.result));
+        }
+        if (static_cast<size_t>(s.result) != s.size) {
+            throw common::SystemException(
+                      "DirectWriteStream: short write in file");
+        }
+    }
+};
+
+WriteStreamPtr SysOpenDirectWriteStream(
+    const std::string& path, size_t queue_depth) {
+
+    int fd = OpenDirect(path, O_CREAT | O_WRONLY | O_TRUNC);
+    if (fd < 0)
+        throw common::ErrnoException("Cannot create file " + path, errno);
+
+    return tlx::make_counting<DirectWriteStream>(
+        fd, std::max<size_t>(queue_depth, 1));
+}
+
+/******************************************************************************/
+
+#else   // !defined(__linux__)
+
+ReadStreamPtr SysOpenDirectReadStream(
+    const std::string&, const common::Range&, size_t) {
+    die("O_DIRECT file streams are only available on Linux.");
+}
+
+WriteStreamPtr SysOpenDirectWriteStream(const std::string&, size_t) {
+    die("O_DIRECT file streams are only available on Linux.");
+}
+
+#endif
+
+} // namespace vfs
+} // namespace thrill
+
+/******************************************************************************/
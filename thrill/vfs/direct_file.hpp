@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * thrill/vfs/direct_file.hpp
+ *
+ * Unbuffered file streams using O_DIRECT and io_uring
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_VFS_DIRECT_FILE_HEADER
+#define THRILL_VFS_DIRECT_FILE_HEADER
+
+#include <thrill/vfs/file_io.hpp>
+
+#include <string>
+
+namespace thrill {
+namespace vfs {
+
+/*!
+ * Open an uncompressed file for reading with O_DIRECT, bypassing the page
+ * cache. The stream keeps queue_depth aligned read requests of 1 MiB in flight
+ * via io_uring, or issues them synchronously with pread() if io_uring is not
+ * available. If the file system does not support O_DIRECT, the file is read
+ * through the page cache in the same way.
+ *
+ * \param path Path to open
+ *
+ * \param range Byte range to read. Only range.begin is used to seek to, the
+ * stream ends at the end of the file.
+ *
+ * \param queue_depth number of outstanding requests
+ */
+ReadStreamPtr SysOpenDirectReadStream(
+    const std::string& path, const common::Range& range, size_t queue_depth);
+
+/*!
+ * Open an uncompressed file for writing with O_DIRECT, bypassing the page
+ * cache. Data is collected in queue_depth aligned buffers of 1 MiB, which are
+ * written asynchronously via io_uring while the next ones are filled. The
+ * unaligned tail is padded and truncated on close().
+ *
+ * \param path Path to open
+ *
+ * \param queue_depth number of outstanding requests
+ */
+WriteStreamPtr SysOpenDirectWriteStream(
+    const std::string& path, size_t queue_depth);
+
+} // namespace vfs
+} // namespace thrill
+
+#endif // !THRILL_VFS_DIRECT_FILE_HEADER
+
+/******************************************************************************/
@@ -15,16 +15,26 @@
 #include <thrill/vfs/bzip2_filter.hpp>
 #include <thrill/vfs/gzip_filter.hpp>
 #include <thrill/vfs/hdfs3_file.hpp>
+#include <thrill/vfs/lz4_filter.hpp>
 #include <thrill/vfs/s3_file.hpp>
 #include <thrill/vfs/sys_file.hpp>
+#include <thrill/vfs/threaded_filter.hpp>
+#include <thrill/vfs/zstd_filter.hpp>
 
 #include <tlx/die.hpp>
+#include <tlx/siphash.hpp>
 #include <tlx/string/ends_with.hpp>
 #include <tlx/string/ssprintf.hpp>
 #include <tlx/string/starts_with.hpp>
 
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -49,7 +59,8 @@ bool IsCompressed(const std::string& path) {
            tlx::ends_with(path, ".bz2") ||
            tlx::ends_with(path, ".xz") ||
            tlx::ends_with(path, ".lzo") ||
-           tlx::ends_with(path, ".lz4");
+           tlx::ends_with(path, ".lz4") ||
+           tlx::ends_with(path, ".zst");
 }
 
 bool IsRemoteUri(const std::string& path) {
@@ -125,7 +136,72 @@ std::string FillFilePattern(const std::string& pathbase,
 
 /******************************************************************************/
 
+//! run the file system specific glob of a single pattern
+static void GlobPattern(const std::string& path, const GlobType& gtype,
+                        FileList& filelist) {
+    if (tlx::starts_with(path, "file://")) {
+        // remove the file:// prefix
+        SysGlob(path.substr(7), gtype, filelist);
+    }
+    else if (tlx::starts_with(path, "s3://")) {
+        S3Glob(path, gtype, filelist);
+    }
+    else if (tlx::starts_with(path, "hdfs://")) {
+        Hdfs3Glob(path, gtype, filelist);
+    }
+    else {
+        SysGlob(path, gtype, filelist);
+    }
+}
+
+/*!
+ * Cache of glob results keyed by pattern and GlobType, which is enabled by
+ * setting THRILL_GLOB_CACHE_TTL to the number of seconds entries stay valid.
+ * Listing large S3 or HDFS directories takes many round trips, and jobs often
+ * read the same input repeatedly.
+ */
+class GlobCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    GlobCache() {
+        const char* env = getenv("THRILL_GLOB_CACHE_TTL");
+        if (env && *env)
+            ttl_ = std::chrono::seconds(std::strtoul(env, nullptr, 10));
+    }
+
+    bool enabled() const { return ttl_.count() != 0; }
+
+    //! append the cached files of the pattern, returns false on a miss.
+    bool Lookup(const std::string& key, FileList& filelist) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end()) return false;
+        if (Clock::now() - it->second.first > ttl_) {
+            map_.erase(it);
+            return false;
+        }
+        filelist.insert(filelist.end(),
+                        it->second.second.begin(), it->second.second.end());
+        return true;
+    }
+
+    void Insert(const std::string& key, std::vector<FileInfo> files) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        map_[key] = std::make_pair(Clock::now(), std::move(files));
+    }
+
+private:
+    std::chrono::seconds ttl_ { 0 };
+    std::mutex mutex_;
+    std::map<std::string,
+             std::pair<Clock::time_point, std::vector<FileInfo> > > map_;
+};
+
 FileList Glob(const std::vector<std::string>& globlist, const GlobType& gtype) {
+    static GlobCache s_cache;
+
     FileList filelist;
 
     // run through globs and collect files. The sub-Glob() methods must only
@@ -133,19 +209,19 @@ FileList Glob(const std::vector<std::string>& globlist, const GlobType& gtype) {
     // calculated afterwards.
     for (const std::string& path : globlist)
     {
-        if (tlx::starts_with(path, "file://")) {
-            // remove the file:// prefix
-            SysGlob(path.substr(7), gtype, filelist);
-        }
-        else if (tlx::starts_with(path, "s3://")) {
-            S3Glob(path, gtype, filelist);
-        }
-        else if (tlx::starts_with(path, "hdfs://")) {
-            Hdfs3Glob(path, gtype, filelist);
-        }
-        else {
-            SysGlob(path, gtype, filelist);
+        if (!s_cache.enabled()) {
+            GlobPattern(path, gtype, filelist);
+            continue;
         }
+
+        std::string key =
+            std::to_string(static_cast<int>(gtype)) + ':' + path;
+        if (s_cache.Lookup(key, filelist)) continue;
+
+        size_t begin = filelist.size();
+        GlobPattern(path, gtype, filelist);
+        s_cache.Insert(key, std::vector<FileInfo>(
+                           filelist.begin() + begin, filelist.end()));
     }
 
     // calculate exclusive prefix sum and overall stats
@@ -173,11 +249,18 @@ FileList Glob(const std::string& glob, const GlobType& gtype) {
     return Glob(std::vector<std::string>{ glob }, gtype);
 }
 
+uint64_t FileList::fingerprint() const {
+    std::ostringstream oss;
+    for (const FileInfo& fi : *this)
+        oss << fi.path << '\0' << fi.size << '\0' << fi.mtime << '\0';
+    return tlx::siphash(oss.str());
+}
+
 /******************************************************************************/
 
 ReadStream::~ReadStream() { }
 
-ReadStreamPtr OpenReadStream(
+ReadStreamPtr OpenRawReadStream(
     const std::string& path, const common::Range& range) {
 
     ReadStreamPtr p;
@@ -194,20 +277,51 @@ ReadStreamPtr OpenReadStream(
         p = SysOpenReadStream(path, range);
     }
 
+    return p;
+}
+
+ReadStreamPtr OpenReadStream(
+    const std::string& path, const common::Range& range) {
+
+    ReadStreamPtr p = OpenRawReadStream(path, range);
+
+    // decompress on a helper thread, concurrently to the consumer
     if (tlx::ends_with(path, ".gz")) {
-        p = MakeGZipReadFilter(p);
+        p = MakeThreadedReadFilter(MakeGZipReadFilter(p));
         die_unless(range.begin == 0 || "Cannot seek in compressed streams.");
     }
     else if (tlx::ends_with(path, ".bz2")) {
-        p = MakeBZip2ReadFilter(p);
+        p = MakeThreadedReadFilter(MakeBZip2ReadFilter(p));
+        die_unless(range.begin == 0 || "Cannot seek in compressed streams.");
+    }
+    else if (tlx::ends_with(path, ".zst")) {
+        p = MakeThreadedReadFilter(MakeZStdReadFilter(p));
+        die_unless(range.begin == 0 || "Cannot seek in compressed streams.");
+    }
+#if THRILL_HAVE_LZ4
+    else if (tlx::ends_with(path, ".lz4")) {
+        p = MakeThreadedReadFilter(MakeLZ4ReadFilter(p));
         die_unless(range.begin == 0 || "Cannot seek in compressed streams.");
     }
+#endif
 
     return p;
 }
 
 WriteStream::~WriteStream() { }
 
+//! number of threads compressing each .gz and .zst output stream
+static size_t CompressThreads() {
+    const char* env = getenv("THRILL_COMPRESS_THREADS");
+    if (env == nullptr || *env == 0) return 4;
+
+    char* endptr;
+    size_t threads = std::strtoul(env, &endptr, 10);
+    if (*endptr != 0)
+        die("Invalid THRILL_COMPRESS_THREADS: " << env);
+    return threads;
+}
+
 WriteStreamPtr OpenWriteStream(const std::string& path) {
 
     WriteStreamPtr p;
@@ -225,11 +339,23 @@ WriteStreamPtr OpenWriteStream(const std::string& path) {
     }
 
     if (tlx::ends_with(path, ".gz")) {
-        p = MakeGZipWriteFilter(p);
+        size_t threads = CompressThreads();
+        if (threads == 0)
+            p = MakeGZipWriteFilter(p);
+        else
+            p = MakeParallelGZipWriteFilter(p, threads);
     }
     else if (tlx::ends_with(path, ".bz2")) {
         p = MakeBZip2WriteFilter(p);
     }
+    else if (tlx::ends_with(path, ".zst")) {
+        p = MakeZStdWriteFilter(p, CompressThreads());
+    }
+#if THRILL_HAVE_LZ4
+    else if (tlx::ends_with(path, ".lz4")) {
+        p = MakeLZ4WriteFilter(p);
+    }
+#endif
 
     return p;
 }
@@ -42,7 +42,7 @@ std::string FillFilePattern(const std::string& pathbase,
                             size_t worker, size_t file_part);
 
 //! Returns true, if file at filepath is compressed (e.g, ends with
-//! '.{gz,bz2,xz,lzo}')
+//! '.{gz,bz2,xz,lzo,lz4,zst}')
 bool IsCompressed(const std::string& path);
 
 //! Returns true, if file at filepath is a remote uri like s3:// or hdfs://
@@ -63,6 +63,8 @@ struct FileInfo {
     uint64_t    size;
     //! exclusive prefix sum of file sizes.
     uint64_t    size_ex_psum;
+    //! modification time of file in seconds since the epoch, zero if unknown.
+    uint64_t    mtime = 0;
 
     //! inclusive prefix sum of file sizes.
     uint64_t size_inc_psum() const { return size_ex_psum + size; }
@@ -73,18 +75,42 @@ struct FileInfo {
 
     //! compare FileInfo by path
     bool operator < (const FileInfo& b) const { return path < b.path; }
+
+    //! serialization with Thrill's serializer, e.g. to broadcast FileLists.
+    static constexpr bool thrill_is_fixed_size = false;
+    static constexpr size_t thrill_fixed_size = 0;
+
+    template <typename Archive>
+    void ThrillSerialize(Archive& ar) const {
+        ar.PutVarint(type == Type::File ? 0 : 1);
+        ar.PutString(path);
+        ar.PutVarint(size);
+        ar.PutVarint(size_ex_psum);
+        ar.PutVarint(mtime);
+    }
+
+    template <typename Archive>
+    static FileInfo ThrillDeserialize(Archive& ar) {
+        FileInfo fi;
+        fi.type = ar.GetVarint() == 0 ? Type::File : Type::Directory;
+        fi.path = ar.GetString();
+        fi.size = ar.GetVarint();
+        fi.size_ex_psum = ar.GetVarint();
+        fi.mtime = ar.GetVarint();
+        return fi;
+    }
 };
 
 //! List of file info and additional overall info.
 struct FileList : public std::vector<FileInfo> {
     //! total size of files
-    uint64_t total_size;
+    uint64_t total_size = 0;
 
     //! whether the list contains a compressed file.
-    bool     contains_compressed;
+    bool     contains_compressed = false;
 
     //! whether the list contains a remote-uri file.
-    bool     contains_remote_uri;
+    bool     contains_remote_uri = false;
 
     //! inclusive prefix sum of file sizes (only for symmetry with ex_psum)
     uint64_t size_inc_psum(size_t i) const
@@ -93,6 +119,36 @@ struct FileList : public std::vector<FileInfo> {
     //! exclusive prefix sum of file sizes with total_size as sentinel
     uint64_t size_ex_psum(size_t i) const
     { return i < size() ? operator [] (i).size_ex_psum : total_size; }
+
+    //! hash of the paths, sizes, and modification times of all files, which
+    //! changes if any of the files is modified.
+    uint64_t fingerprint() const;
+
+    //! serialization with Thrill's serializer, e.g. to broadcast FileLists.
+    static constexpr bool thrill_is_fixed_size = false;
+    static constexpr size_t thrill_fixed_size = 0;
+
+    template <typename Archive>
+    void ThrillSerialize(Archive& ar) const {
+        ar.PutVarint(size());
+        for (const FileInfo& fi : *this)
+            fi.ThrillSerialize(ar);
+        ar.PutVarint(total_size);
+        ar.PutVarint(contains_compressed);
+        ar.PutVarint(contains_remote_uri);
+    }
+
+    template <typename Archive>
+    static FileList ThrillDeserialize(Archive& ar) {
+        FileList files;
+        files.resize(ar.GetVarint());
+        for (FileInfo& fi : files)
+            fi = FileInfo::ThrillDeserialize(ar);
+        files.total_size = ar.GetVarint();
+        files.contains_compressed = ar.GetVarint() != 0;
+        files.contains_remote_uri = ar.GetVarint() != 0;
+        return files;
+    }
 };
 
 //! Type of objects to include in glob result.
@@ -106,7 +162,9 @@ FileList Glob(const std::string& glob, const GlobType& gtype = GlobType::All);
 
 /*!
  * Reads a glob path list and deliver a file list, sizes, and prefixsums (in
- * bytes) for all matching files.
+ * bytes) for all matching files. If THRILL_GLOB_CACHE_TTL is set, the results
+ * of each glob pattern are cached in the process for that many seconds. Use
+ * Context::Glob() to enumerate the files once for all workers.
  */
 FileList Glob(const std::vector<std::string>& globlist,
               const GlobType& gtype = GlobType::All);
@@ -161,6 +219,13 @@ using WriteStreamPtr = tlx::CountingPtr<WriteStream>;
 ReadStreamPtr OpenReadStream(
     const std::string& path, const common::Range& range = common::Range());
 
+/*!
+ * Construct reader for given path uri like OpenReadStream(), but without
+ * decompressing files, hence the range may also seek in compressed files.
+ */
+ReadStreamPtr OpenRawReadStream(
+    const std::string& path, const common::Range& range = common::Range());
+
 WriteStreamPtr OpenWriteStream(const std::string& path);
 
 /******************************************************************************/
@@ -10,12 +10,21 @@
 
 #include <thrill/vfs/gzip_filter.hpp>
 
+#include <thrill/common/porting.hpp>
+
 #include <tlx/die.hpp>
 
 #if THRILL_HAVE_ZLIB
 #include <zlib.h>
 #endif
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace thrill {
@@ -162,6 +171,244 @@ WriteStreamPtr MakeGZipWriteFilter(const WriteStreamPtr& stream) {
     return tlx::make_counting<GZipWriteFilter>(stream);
 }
 
+/******************************************************************************/
+// ParallelGZipWriteFilter - BGZF compressor using multiple threads
+
+/*!
+ * Compresses the output in parallel like pigz, but as independent gzip members
+ * in the BGZF format of bgzip, which any gzip decoder reads as one file. Each
+ * member contains 65280 bytes of input. The input is cut into batches of
+ * members, which the threads compress while the writer continues. The
+ * compressed batches are written in order, and the writer blocks while
+ * 2 * num_threads batches are pending, which bounds the memory. BGZF files can
+ * be read in parallel ranges by ReadLines, see OpenSplitLinesReadStream().
+ */
+class ParallelGZipWriteFilter final : public virtual WriteStream
+{
+public:
+    ParallelGZipWriteFilter(const WriteStreamPtr& output, size_t num_threads)
+        : output_(output), num_threads_(std::max<size_t>(num_threads, 1)) {
+        input_.reserve(batch_size);
+        for (size_t i = 0; i < num_threads_; ++i) {
+            threads_.emplace_back(
+                common::CreateThread([this]() { Worker(); }));
+        }
+    }
+
+    ~ParallelGZipWriteFilter() {
+        close();
+    }
+
+    ssize_t write(const void* data, const size_t size) final {
+        const char* d = reinterpret_cast<const char*>(data);
+        size_t remain = size;
+        while (remain > 0) {
+            size_t wb = std::min(remain, batch_size - input_.size());
+            input_.insert(input_.end(), d, d + wb);
+            d += wb, remain -= wb;
+
+            if (input_.size() == batch_size)
+                Submit();
+        }
+        return size;
+    }
+
+    void close() final {
+        if (closed_) return;
+
+        if (!input_.empty())
+            Submit();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        WriteDone(lock, /* all */ true);
+        terminate_ = true;
+        cv_jobs_.notify_all();
+        lock.unlock();
+
+        for (std::thread& t : threads_)
+            t.join();
+
+        // BGZF end-of-file marker: an empty member
+        std::vector<Bytef> eof;
+        CompressMember(nullptr, 0, eof);
+        output_->write(eof.data(), eof.size());
+        output_->close();
+
+        closed_ = true;
+    }
+
+private:
+    //! input bytes per member
+    static constexpr size_t member_size = 65280;
+
+    //! input bytes per batch
+    static constexpr size_t batch_size = 16 * member_size;
+
+    //! batch of members
+    struct Job {
+        //! input data
+        std::vector<char>  input;
+        //! compressed members
+        std::vector<Bytef> output;
+        //! whether a thread took the job
+        bool               taken = false;
+        //! whether output is complete
+        bool               done = false;
+    };
+
+    //! output stream for writing data somewhere
+    WriteStreamPtr output_;
+
+    //! number of compression threads
+    size_t num_threads_;
+
+    //! compression threads
+    std::vector<std::thread> threads_;
+
+    //! input of the current batch
+    std::vector<char> input_;
+
+    //! mutex protecting jobs_ and terminate_
+    std::mutex mutex_;
+
+    //! signals new jobs or termination to the threads
+    std::condition_variable cv_jobs_;
+
+    //! signals finished jobs to the writer
+    std::condition_variable cv_done_;
+
+    //! batches in output order, the Job objects must not move.
+    std::deque<std::unique_ptr<Job> > jobs_;
+
+    //! termination flag
+    bool terminate_ = false;
+
+    //! if the stream was closed
+    bool closed_ = false;
+
+    //! queue current batch, write finished ones
+    void Submit() {
+        std::unique_ptr<Job> job = std::make_unique<Job>();
+        job->input.swap(input_);
+        input_.reserve(batch_size);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobs_.emplace_back(std::move(job));
+        cv_jobs_.notify_one();
+
+        WriteDone(lock, /* all */ false);
+    }
+
+    //! write finished jobs at the front of jobs_, wait until less than 2 *
+    //! num_threads_ are pending, or until all are written.
+    void WriteDone(std::unique_lock<std::mutex>& lock, bool all) {
+        while (!jobs_.empty())
+        {
+            if (!jobs_.front()->done) {
+                if (!all && jobs_.size() < 2 * num_threads_) return;
+                cv_done_.wait(lock);
+                continue;
+            }
+
+            std::unique_ptr<Job> job = std::move(jobs_.front());
+            jobs_.pop_front();
+
+            lock.unlock();
+            output_->write(job->output.data(), job->output.size());
+            lock.lock();
+        }
+    }
+
+    //! main function of the compression threads
+    void Worker() {
+        common::NameThisThread("gzip-compress");
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            Job* job = nullptr;
+            for (std::unique_ptr<Job>& j : jobs_) {
+                if (!j->taken) {
+                    job = j.get();
+                    break;
+                }
+            }
+            if (job == nullptr) {
+                if (terminate_) break;
+                cv_jobs_.wait(lock);
+                continue;
+            }
+
+            job->taken = true;
+            lock.unlock();
+
+            for (size_t pos = 0; pos < job->input.size(); pos += member_size) {
+                CompressMember(
+                    job->input.data() + pos,
+                    std::min(member_size, job->input.size() - pos),
+                    job->output);
+            }
+
+            lock.lock();
+            job->done = true;
+            cv_done_.notify_one();
+        }
+    }
+
+    //! append a BGZF member with size bytes of data to output
+    static void CompressMember(
+        const char* data, size_t size, std::vector<Bytef>& output) {
+        // header with extra subfield 'BC' containing the member size - 1
+        static const Bytef header[18] = {
+            0x1F, 0x8B, 0x08, 0x04, 0, 0, 0, 0, 0, 0xFF, 6, 0, 'B', 'C', 2, 0,
+            0, 0
+        };
+
+        size_t begin = output.size();
+        // incompressible data may grow by a few bytes in stored blocks
+        output.resize(begin + 18 + member_size + 1024 + 8);
+        std::copy(header, header + 18, output.data() + begin);
+
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        // windowBits = -15: raw deflate data
+        int err = deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               -15, /* memLevel */ 8, Z_DEFAULT_STRATEGY);
+        die_unequal(err, Z_OK);
+
+        z.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(data));
+        z.avail_in = static_cast<uInt>(size);
+        z.next_out = output.data() + begin + 18;
+        z.avail_out = static_cast<uInt>(output.size() - begin - 18 - 8);
+
+        err = deflate(&z, Z_FINISH);
+        die_unequal(err, Z_STREAM_END);
+        size_t csize = z.total_out;
+        deflateEnd(&z);
+
+        uLong crc = crc32(0, reinterpret_cast<const Bytef*>(data),
+                          static_cast<uInt>(size));
+
+        size_t bsize = 18 + csize + 8 - 1;
+        die_unless(bsize < 65536);
+        output[begin + 16] = static_cast<Bytef>(bsize);
+        output[begin + 17] = static_cast<Bytef>(bsize >> 8);
+
+        Bytef* trailer = output.data() + begin + 18 + csize;
+        for (size_t i = 0; i < 4; ++i) {
+            trailer[i] = static_cast<Bytef>(crc >> (8 * i));
+            trailer[4 + i] = static_cast<Bytef>(size >> (8 * i));
+        }
+        output.resize(begin + bsize + 1);
+    }
+};
+
+WriteStreamPtr MakeParallelGZipWriteFilter(
+    const WriteStreamPtr& stream, size_t num_threads) {
+    die_unless(stream);
+    return tlx::make_counting<ParallelGZipWriteFilter>(stream, num_threads);
+}
+
 /******************************************************************************/
 // GZipReadFilter - on-the-fly gzip decompressor
 
@@ -268,6 +515,11 @@ WriteStreamPtr MakeGZipWriteFilter(const WriteStreamPtr&) {
         "because Thrill was built without zlib.");
 }
 
+WriteStreamPtr MakeParallelGZipWriteFilter(const WriteStreamPtr&, size_t) {
+    die(".gz compression is not available, "
+        "because Thrill was built without zlib.");
+}
+
 ReadStreamPtr MakeGZipReadFilter(const ReadStreamPtr&) {
     die(".gz decompression is not available, "
         "because Thrill was built without zlib.");
@@ -23,6 +23,11 @@ ReadStreamPtr MakeGZipReadFilter(const ReadStreamPtr& stream);
 
 WriteStreamPtr MakeGZipWriteFilter(const WriteStreamPtr& stream);
 
+//! Construct a gzip compressor writing BGZF members, which are compressed by
+//! num_threads threads in parallel.
+WriteStreamPtr MakeParallelGZipWriteFilter(
+    const WriteStreamPtr& stream, size_t num_threads);
+
 } // namespace vfs
 } // namespace thrill
 
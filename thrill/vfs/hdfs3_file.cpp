@@ -21,6 +21,7 @@
 #endif
 
 #include <algorithm>
+#include <cstdlib>
 #include <limits>
 #include <mutex>
 #include <string>
@@ -97,6 +98,14 @@ hdfsFS Hdfs3FindConnection(const std::string& hostport) {
     if (user)
         hdfsBuilderSetUserName(builder, user);
 
+    // read blocks stored on this host directly from the local disk via the
+    // data node's domain socket, bypassing the TCP data transfer.
+    const char* socket_path = getenv("THRILL_HDFS_DOMAIN_SOCKET");
+    if (socket_path && *socket_path) {
+        hdfsBuilderConfSetStr(builder, "dfs.client.read.shortcircuit", "true");
+        hdfsBuilderConfSetStr(builder, "dfs.domain.socket.path", socket_path);
+    }
+
     hdfsFS hdfs = hdfsBuilderConnect(builder);
     if (!hdfs)
         die("Could not connect to HDFS server \"" << hostport << "\""
@@ -166,6 +175,54 @@ void Hdfs3Glob(const std::string& _path, const GlobType& gtype,
     hdfsFreeFileInfo(list, num_entries);
 }
 
+/******************************************************************************/
+// Block Locations of HDFS Files
+
+std::vector<FileBlockLocation> Hdfs3GetFileBlockLocations(
+    const std::string& _path) {
+
+    std::string path = _path;
+    // crop off hdfs://
+    die_unless(tlx::starts_with(path, "hdfs://"));
+    path = path.substr(7);
+
+    // split uri into host/path
+    std::vector<std::string> splitted = tlx::split('/', path, 2);
+    die_unless(splitted.size() == 2);
+
+    // prepend root /
+    splitted[1] = "/" + splitted[1];
+
+    hdfsFS fs = Hdfs3FindConnection(splitted[0]);
+
+    hdfsFileInfo* info = hdfsGetPathInfo(fs, splitted[1].c_str());
+    if (!info)
+        die("Could not stat HDFS file \"" << _path << "\": " << hdfsGetLastError());
+    tOffset size = info->mSize;
+    hdfsFreeFileInfo(info, 1);
+
+    int num_blocks = 0;
+    BlockLocation* blocks = hdfsGetFileBlockLocations(
+        fs, splitted[1].c_str(), 0, size, &num_blocks);
+
+    std::vector<FileBlockLocation> locations;
+    if (!blocks) return locations;
+
+    for (int i = 0; i < num_blocks; ++i) {
+        FileBlockLocation loc;
+        loc.range = common::Range(
+            blocks[i].offset, blocks[i].offset + blocks[i].length);
+        for (int h = 0; h < blocks[i].numOfNodes; ++h)
+            loc.hosts.emplace_back(blocks[i].hosts[h]);
+        // sort replicas, since the name node orders them by distance
+        std::sort(loc.hosts.begin(), loc.hosts.end());
+        locations.emplace_back(std::move(loc));
+    }
+
+    hdfsFreeFileBlockLocations(blocks, num_blocks);
+    return locations;
+}
+
 /******************************************************************************/
 // Stream Reading from HDFS
 
@@ -310,6 +367,11 @@ WriteStreamPtr Hdfs3OpenWriteStream(const std::string& /* path */) {
     die("hdfs:// is not available, because Thrill was built without libhdfs3.");
 }
 
+std::vector<FileBlockLocation> Hdfs3GetFileBlockLocations(
+    const std::string& /* path */) {
+    die("hdfs:// is not available, because Thrill was built without libhdfs3.");
+}
+
 #endif  // !THRILL_HAVE_LIBHDFS3
 
 } // namespace vfs
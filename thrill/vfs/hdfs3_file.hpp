@@ -13,8 +13,10 @@
 #define THRILL_VFS_HDFS3_FILE_HEADER
 
 #include <thrill/vfs/file_io.hpp>
+#include <thrill/vfs/locality.hpp>
 
 #include <string>
+#include <vector>
 
 namespace thrill {
 namespace vfs {
@@ -35,6 +37,10 @@ ReadStreamPtr Hdfs3OpenReadStream(
 WriteStreamPtr Hdfs3OpenWriteStream(
     const std::string& path);
 
+//! Query the data nodes storing the blocks of an HDFS file
+std::vector<FileBlockLocation> Hdfs3GetFileBlockLocations(
+    const std::string& path);
+
 } // namespace vfs
 } // namespace thrill
 
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * thrill/vfs/locality.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/locality.hpp>
+
+#include <thrill/vfs/hdfs3_file.hpp>
+
+#include <tlx/die.hpp>
+#include <tlx/math/div_ceil.hpp>
+#include <tlx/string/starts_with.hpp>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+bool HasBlockLocations(const FileList& files) {
+    for (const FileInfo& fi : files) {
+        if (tlx::starts_with(fi.path, "hdfs://")) return true;
+    }
+    return false;
+}
+
+std::vector<FileBlockLocation> GetFileBlockLocations(const std::string& path) {
+    if (tlx::starts_with(path, "hdfs://"))
+        return Hdfs3GetFileBlockLocations(path);
+    return std::vector<FileBlockLocation>();
+}
+
+//! compare host names, allowing one to be the short name of the other.
+static bool SameHost(const std::string& a, const std::string& b) {
+    if (a.size() == b.size()) return a == b;
+    const std::string& s = a.size() < b.size() ? a : b;
+    const std::string& l = a.size() < b.size() ? b : a;
+    return tlx::starts_with(l, s) && l[s.size()] == '.';
+}
+
+std::vector<std::pair<uint64_t, size_t> > AssignLocalityPieces(
+    const FileList& files,
+    const std::vector<std::vector<FileBlockLocation> >& locations,
+    const std::vector<std::string>& worker_hosts) {
+
+    size_t num_workers = worker_hosts.size();
+    die_unless(num_workers > 0);
+    die_unless(locations.size() == files.size());
+
+    uint64_t total_size = files.total_size;
+    uint64_t piece_limit =
+        std::max<uint64_t>(total_size / (4 * num_workers), 1);
+    uint64_t load_limit = tlx::div_ceil(total_size, num_workers);
+    load_limit += load_limit / 8;
+
+    // group workers by host name
+    std::vector<std::string> hosts;
+    std::vector<std::vector<size_t> > host_workers;
+    for (size_t w = 0; w < num_workers; ++w) {
+        size_t h = std::find(hosts.begin(), hosts.end(), worker_hosts[w])
+                   - hosts.begin();
+        if (h == hosts.size()) {
+            hosts.emplace_back(worker_hosts[w]);
+            host_workers.emplace_back();
+        }
+        host_workers[h].push_back(w);
+    }
+
+    std::vector<uint64_t> load(num_workers, 0);
+    std::vector<std::pair<uint64_t, size_t> > pieces;
+
+    // cut global range [begin,end) into pieces and assign them
+    auto assign =
+        [&](uint64_t begin, uint64_t end,
+            const std::vector<std::string>& replicas) {
+            end = std::min(end, total_size);
+            if (begin >= end) return;
+
+            uint64_t num = tlx::div_ceil(end - begin, piece_limit);
+            for (uint64_t p = 0; p < num; ++p) {
+                uint64_t pbegin = begin + (end - begin) * p / num;
+                uint64_t pend = begin + (end - begin) * (p + 1) / num;
+                uint64_t size = pend - pbegin;
+
+                size_t best = num_workers;
+                for (size_t h = 0; h < hosts.size(); ++h) {
+                    bool replica = false;
+                    for (const std::string& r : replicas)
+                        replica = replica || SameHost(hosts[h], r);
+                    if (!replica) continue;
+
+                    for (const size_t& w : host_workers[h]) {
+                        if (load[w] + size > load_limit) continue;
+                        if (best == num_workers || load[w] < load[best])
+                            best = w;
+                    }
+                }
+                if (best == num_workers) {
+                    best = std::min_element(load.begin(), load.end())
+                           - load.begin();
+                }
+
+                load[best] += size;
+                pieces.emplace_back(pbegin, best);
+            }
+        };
+
+    static const std::vector<std::string> no_hosts;
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint64_t base = files[i].size_ex_psum, size = files[i].size;
+        uint64_t off = 0;
+
+        for (const FileBlockLocation& loc : locations[i]) {
+            uint64_t b = std::max<uint64_t>(off, loc.range.begin);
+            uint64_t e = std::min<uint64_t>(loc.range.end, size);
+            if (b >= e) continue;
+
+            assign(base + off, base + b, no_hosts);
+            assign(base + b, base + e, loc.hosts);
+            off = e;
+        }
+        assign(base + off, base + size, no_hosts);
+    }
+
+    return pieces;
+}
+
+} // namespace vfs
+} // namespace thrill
+
+/******************************************************************************/
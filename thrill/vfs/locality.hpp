@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * thrill/vfs/locality.hpp
+ *
+ * Block locations of files on distributed file systems and locality-aware
+ * assignment of byte ranges to workers.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_VFS_LOCALITY_HEADER
+#define THRILL_VFS_LOCALITY_HEADER
+
+#include <thrill/vfs/file_io.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+//! Hosts storing replicas of a byte range of a file.
+struct FileBlockLocation {
+    //! byte range in the file
+    common::Range            range;
+    //! names of hosts storing a replica
+    std::vector<std::string> hosts;
+};
+
+//! Returns true if the file list contains files for which
+//! GetFileBlockLocations() returns block locations, currently hdfs:// files.
+bool HasBlockLocations(const FileList& files);
+
+/*!
+ * Query the hosts storing the blocks of the file at path. Returns an empty list
+ * for file systems without block locations.
+ */
+std::vector<FileBlockLocation> GetFileBlockLocations(const std::string& path);
+
+/*!
+ * Assign the bytes [0,files.total_size) of a file list to workers, preferring
+ * workers on the hosts storing replicas of the data. The files are cut into
+ * pieces of at most total_size / (4 * num_workers) bytes along the block
+ * locations, and each piece is given to the least loaded worker on a replica
+ * host, unless that worker would exceed its fair share by more than an
+ * eighth. Otherwise the piece goes to the least loaded worker overall.
+ *
+ * \param files the file list with prefix sums
+ *
+ * \param locations block locations of each file, may be empty for a file.
+ *
+ * \param worker_hosts host name of each worker
+ *
+ * \return the pieces as pairs (global begin offset, worker), sorted by offset.
+ * A piece ends at the begin of the next one or at files.total_size.
+ */
+std::vector<std::pair<uint64_t, size_t> > AssignLocalityPieces(
+    const FileList& files,
+    const std::vector<std::vector<FileBlockLocation> >& locations,
+    const std::vector<std::string>& worker_hosts);
+
+} // namespace vfs
+} // namespace thrill
+
+#endif // !THRILL_VFS_LOCALITY_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,218 @@
+/*******************************************************************************
+ * thrill/vfs/lz4_filter.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/lz4_filter.hpp>
+
+#include <tlx/die.hpp>
+
+#if THRILL_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+#if THRILL_HAVE_LZ4
+
+/******************************************************************************/
+// LZ4WriteFilter - on-the-fly lz4 frame compressor
+
+class LZ4WriteFilter final : public virtual WriteStream
+{
+public:
+    explicit LZ4WriteFilter(const WriteStreamPtr& output)
+        : output_(output) {
+        LZ4F_errorCode_t err =
+            LZ4F_createCompressionContext(&cctx_, LZ4F_VERSION);
+        die_unless(!LZ4F_isError(err));
+
+        memset(&prefs_, 0, sizeof(prefs_));
+        prefs_.frameInfo.blockSizeID = LZ4F_max4MB;
+        prefs_.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+
+        // output buffer, large enough for any update of input_chunk bytes
+        buffer_.resize(LZ4F_compressBound(input_chunk, &prefs_));
+
+        size_t n = LZ4F_compressBegin(
+            cctx_, buffer_.data(), buffer_.size(), &prefs_);
+        Check(n);
+        output_->write(buffer_.data(), n);
+    }
+
+    ~LZ4WriteFilter() {
+        close();
+    }
+
+    ssize_t write(const void* data, const size_t size) final {
+        const char* d = reinterpret_cast<const char*>(data);
+        size_t remain = size;
+
+        while (remain != 0) {
+            size_t chunk = std::min(remain, input_chunk);
+            size_t n = LZ4F_compressUpdate(
+                cctx_, buffer_.data(), buffer_.size(), d, chunk, nullptr);
+            Check(n);
+            if (n != 0)
+                output_->write(buffer_.data(), n);
+            d += chunk, remain -= chunk;
+        }
+
+        return size;
+    }
+
+    void close() final {
+        if (!cctx_) return;
+
+        size_t n = LZ4F_compressEnd(
+            cctx_, buffer_.data(), buffer_.size(), nullptr);
+        Check(n);
+        output_->write(buffer_.data(), n);
+
+        output_->close();
+
+        LZ4F_freeCompressionContext(cctx_);
+        cctx_ = nullptr;
+    }
+
+private:
+    //! maximum input bytes passed to each LZ4F_compressUpdate()
+    static constexpr size_t input_chunk = 1024 * 1024;
+
+    //! lz4 frame context
+    LZ4F_cctx* cctx_ = nullptr;
+
+    //! frame preferences
+    LZ4F_preferences_t prefs_;
+
+    //! compression buffer, flushed to output after each call
+    std::vector<char> buffer_;
+
+    //! output stream for writing data somewhere
+    WriteStreamPtr output_;
+
+    static void Check(size_t code) {
+        if (LZ4F_isError(code)) {
+            die("LZ4WriteFilter: " << LZ4F_getErrorName(code) <<
+                " while compressing");
+        }
+    }
+};
+
+WriteStreamPtr MakeLZ4WriteFilter(const WriteStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<LZ4WriteFilter>(stream);
+}
+
+/******************************************************************************/
+// LZ4ReadFilter - on-the-fly lz4 frame decompressor
+
+class LZ4ReadFilter : public virtual ReadStream
+{
+public:
+    explicit LZ4ReadFilter(const ReadStreamPtr& input)
+        : input_(input) {
+        LZ4F_errorCode_t err =
+            LZ4F_createDecompressionContext(&dctx_, LZ4F_VERSION);
+        die_unless(!LZ4F_isError(err));
+
+        // input buffer
+        buffer_.resize(2 * 1024 * 1024);
+    }
+
+    ~LZ4ReadFilter() {
+        close();
+    }
+
+    ssize_t read(void* data, size_t size) final {
+        char* out = reinterpret_cast<char*>(data);
+        size_t done = 0;
+
+        while (done != size)
+        {
+            if (in_pos_ == in_size_ && !flushing_) {
+                // input buffer empty, so read from input_
+                ssize_t rb = input_->read(buffer_.data(), buffer_.size());
+                if (rb <= 0) break;
+                in_size_ = rb, in_pos_ = 0;
+            }
+
+            // continues with the next frame after the end of one
+            size_t out_size = size - done;
+            size_t in_size = in_size_ - in_pos_;
+            size_t err = LZ4F_decompress(
+                dctx_, out + done, &out_size,
+                buffer_.data() + in_pos_, &in_size, nullptr);
+            if (LZ4F_isError(err)) {
+                die("LZ4ReadFilter: " << LZ4F_getErrorName(err) <<
+                    " while decompressing");
+            }
+            in_pos_ += in_size, done += out_size;
+
+            // the output filled up, the context may hold more decoded data
+            flushing_ = (done == size);
+        }
+
+        return done;
+    }
+
+    void close() final {
+        if (!dctx_) return;
+
+        LZ4F_freeDecompressionContext(dctx_);
+        input_->close();
+
+        dctx_ = nullptr;
+    }
+
+private:
+    //! lz4 frame context
+    LZ4F_dctx* dctx_ = nullptr;
+
+    //! decompression buffer, filled from the input when empty
+    std::vector<char> buffer_;
+
+    //! filled and consumed bytes of buffer_
+    size_t in_size_ = 0, in_pos_ = 0;
+
+    //! whether the last call filled the output and must be repeated without
+    //! new input to flush the context
+    bool flushing_ = false;
+
+    //! input stream for reading data from somewhere
+    ReadStreamPtr input_;
+};
+
+ReadStreamPtr MakeLZ4ReadFilter(const ReadStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<LZ4ReadFilter>(stream);
+}
+
+/******************************************************************************/
+
+#else   // !THRILL_HAVE_LZ4
+
+WriteStreamPtr MakeLZ4WriteFilter(const WriteStreamPtr&) {
+    die(".lz4 compression is not available, "
+        "because Thrill was built without liblz4.");
+}
+
+ReadStreamPtr MakeLZ4ReadFilter(const ReadStreamPtr&) {
+    die(".lz4 decompression is not available, "
+        "because Thrill was built without liblz4.");
+}
+
+#endif
+
+} // namespace vfs
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,29 @@
+/*******************************************************************************
+ * thrill/vfs/lz4_filter.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_VFS_LZ4_FILTER_HEADER
+#define THRILL_VFS_LZ4_FILTER_HEADER
+
+#include <thrill/vfs/file_io.hpp>
+
+#include <string>
+
+namespace thrill {
+namespace vfs {
+
+ReadStreamPtr MakeLZ4ReadFilter(const ReadStreamPtr& stream);
+
+WriteStreamPtr MakeLZ4WriteFilter(const WriteStreamPtr& stream);
+
+} // namespace vfs
+} // namespace thrill
+
+#endif // !THRILL_VFS_LZ4_FILTER_HEADER
+
+/******************************************************************************/
@@ -12,9 +12,11 @@
 #include <thrill/vfs/s3_file.hpp>
 
 #include <thrill/common/logger.hpp>
+#include <thrill/common/porting.hpp>
 #include <thrill/common/string.hpp>
 
 #include <tlx/die.hpp>
+#include <tlx/string/parse_si_iec_units.hpp>
 #include <tlx/string/split.hpp>
 #include <tlx/string/starts_with.hpp>
 
@@ -23,8 +25,14 @@
 #endif
 
 #include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -289,6 +297,33 @@ void S3Glob(const std::string& _path, const GlobType& gtype,
 /******************************************************************************/
 // Stream Reading from S3
 
+//! wait for activity on the sockets of a request context using select(), then
+//! run the callbacks of the requests.
+static void S3RunRequestContext(
+    S3RequestContext* req_ctx, int* remaining_requests) {
+    // perform a select() waiting on new data
+    fd_set read_fds, write_fds, except_fds;
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    FD_ZERO(&except_fds);
+    int max_fd;
+
+    S3Status status = S3_get_request_context_fdsets(
+        req_ctx, &read_fds, &write_fds, &except_fds, &max_fd);
+    die_unless(status == S3StatusOK);
+
+    if (max_fd != -1) {
+        int64_t timeout = S3_get_request_context_timeout(req_ctx);
+        struct timeval tv = { timeout / 1000, (timeout % 1000) * 1000 };
+        int r = select(max_fd + 1, &read_fds, &write_fds, &except_fds,
+                       /* timeout */ (timeout == -1) ? 0 : &tv);
+        die_unless(r >= 0);
+    }
+
+    // run callbacks
+    S3_runonce_request_context(req_ctx, remaining_requests);
+}
+
 class S3ReadStream : public ReadStream
 {
 public:
@@ -360,27 +395,7 @@ public:
         while (status_ == S3StatusOK &&
                output_ < output_end_ && remaining_requests)
         {
-            // perform a select() waiting on new data
-            fd_set read_fds, write_fds, except_fds;
-            FD_ZERO(&read_fds);
-            FD_ZERO(&write_fds);
-            FD_ZERO(&except_fds);
-            int max_fd;
-
-            S3Status status = S3_get_request_context_fdsets(
-                req_ctx_, &read_fds, &write_fds, &except_fds, &max_fd);
-            die_unless(status == S3StatusOK);
-
-            if (max_fd != -1) {
-                int64_t timeout = S3_get_request_context_timeout(req_ctx_);
-                struct timeval tv = { timeout / 1000, (timeout % 1000) * 1000 };
-                int r = select(max_fd + 1, &read_fds, &write_fds, &except_fds,
-                               /* timeout */ (timeout == -1) ? 0 : &tv);
-                die_unless(r >= 0);
-            }
-
-            // run callbacks
-            S3_runonce_request_context(req_ctx_, &remaining_requests);
+            S3RunRequestContext(req_ctx_, &remaining_requests);
         }
 
         return output_ - output_begin;
@@ -462,6 +477,256 @@ private:
     }
 };
 
+/******************************************************************************/
+
+/*!
+ * Reads a byte range of an S3 object with multiple concurrent ranged GETs. The
+ * range is split into chunks of chunk_size bytes, of which up to parallel are
+ * requested ahead of the consumer on a common request context. Chunks are
+ * delivered in order, and a new request is issued whenever the consumer
+ * finishes a chunk, hence the buffered data is bounded by parallel *
+ * chunk_size bytes.
+ */
+class S3ParallelReadStream : public ReadStream
+{
+public:
+    S3ParallelReadStream(const std::string& bucket, const std::string& key,
+                         uint64_t start_byte, uint64_t byte_count,
+                         size_t chunk_size, size_t parallel)
+        : bucket_(bucket), key_(key),
+          next_byte_(start_byte), end_byte_(start_byte + byte_count),
+          chunk_size_(std::max<size_t>(chunk_size, 1)),
+          parallel_(std::max<size_t>(parallel, 1)) {
+
+        FillS3BucketContext(bucket_context_, bucket_);
+
+        memset(&handler_, 0, sizeof(handler_));
+        handler_.responseHandler.propertiesCallback =
+            &ResponsePropertiesCallback;
+        handler_.responseHandler.completeCallback =
+            &S3ParallelReadStream::ResponseCompleteCallback;
+        handler_.getObjectDataCallback =
+            &S3ParallelReadStream::GetObjectDataCallback;
+
+        // create request context
+        S3Status status = S3_create_request_context(&req_ctx_);
+        if (status != S3StatusOK || req_ctx_ == nullptr)
+            die("S3_create_request_context() failed.");
+
+        IssueRequests();
+    }
+
+    //! non-copyable: delete copy-constructor
+    S3ParallelReadStream(const S3ParallelReadStream&) = delete;
+    //! non-copyable: delete assignment operator
+    S3ParallelReadStream& operator = (const S3ParallelReadStream&) = delete;
+
+    ~S3ParallelReadStream() override {
+        close();
+    }
+
+    ssize_t read(void* data, size_t size) final {
+        assert(req_ctx_);
+
+        uint8_t* output_begin = reinterpret_cast<uint8_t*>(data);
+        uint8_t* output = output_begin;
+        uint8_t* output_end = output + size;
+
+        while (output < output_end && !chunks_.empty())
+        {
+            Chunk& c = *chunks_.front();
+
+            // copy data received for the front chunk
+            size_t wb = std::min<size_t>(
+                output_end - output, c.buffer.size() - c.read_pos);
+            std::copy(c.buffer.begin() + c.read_pos,
+                      c.buffer.begin() + c.read_pos + wb, output);
+            output += wb;
+            c.read_pos += wb;
+
+            if (c.read_pos < c.buffer.size())
+                continue;
+
+            if (c.done) {
+                if (c.status != S3StatusOK)
+                    die("S3-ERROR during read: "
+                        << S3_get_status_name(c.status));
+                if (c.buffer.size() != c.size)
+                    die("S3-ERROR during read: short chunk of "
+                        << c.buffer.size() << " instead of " << c.size
+                        << " bytes");
+
+                // chunk finished by consumer: request the next one
+                chunks_.pop_front();
+                IssueRequests();
+                continue;
+            }
+
+            // wait for more callbacks to deliver data
+            int remaining_requests;
+            S3RunRequestContext(req_ctx_, &remaining_requests);
+        }
+
+        return output - output_begin;
+    }
+
+    void close() final {
+        if (req_ctx_ == nullptr) return;
+
+        S3_destroy_request_context(req_ctx_);
+        req_ctx_ = nullptr;
+        chunks_.clear();
+    }
+
+private:
+    //! a ranged GET request and its reception buffer
+    struct Chunk {
+        //! size of the range requested
+        size_t               size;
+        //! data received, its capacity is reserved to size
+        std::vector<uint8_t> buffer;
+        //! bytes of buffer already delivered to the consumer
+        size_t               read_pos = 0;
+        //! set by the completion callback
+        bool                 done = false;
+        //! status of the request
+        S3Status             status = S3StatusOK;
+    };
+
+    //! request context shared by all outstanding requests
+    S3RequestContext* req_ctx_ = nullptr;
+
+    //! bucket for download
+    std::string bucket_;
+
+    //! bucket key for download
+    std::string key_;
+
+    //! bucket context referencing bucket_
+    S3BucketContext bucket_context_;
+
+    //! callbacks for the requests
+    S3GetObjectHandler handler_;
+
+    //! first byte not yet requested, and end of range
+    uint64_t next_byte_, end_byte_;
+
+    //! size of each ranged request
+    size_t chunk_size_;
+
+    //! maximum number of chunks buffered or in flight
+    size_t parallel_;
+
+    //! chunks in order of the range, the Chunk objects are request cookies and
+    //! must not move.
+    std::deque<std::unique_ptr<Chunk> > chunks_;
+
+    //! issue requests until parallel_ chunks are outstanding
+    void IssueRequests() {
+        while (chunks_.size() < parallel_ && next_byte_ < end_byte_)
+        {
+            uint64_t size = std::min<uint64_t>(
+                chunk_size_, end_byte_ - next_byte_);
+
+            chunks_.emplace_back(std::make_unique<Chunk>());
+            Chunk* c = chunks_.back().get();
+            c->size = size;
+            c->buffer.reserve(size);
+
+            sLOG << "S3ParallelReadStream: request" << key_
+                 << "bytes" << next_byte_ << "+" << size;
+
+            // issue request but do not wait for data
+            S3_get_object(
+                &bucket_context_, key_.c_str(), /* get_conditions */ nullptr,
+                next_byte_, size, /* request_context */ req_ctx_,
+                /* timeoutMs */ 0, &handler_, c);
+
+            next_byte_ += size;
+        }
+    }
+
+    //! completion callback, check for errors
+    static void ResponseCompleteCallback(
+        S3Status status, const S3ErrorDetails* error, void* cookie) {
+        Chunk* c = reinterpret_cast<Chunk*>(cookie);
+        c->status = status;
+        c->done = true;
+
+        if (status != S3StatusOK && status != S3StatusInterrupted)
+            LibS3LogError(status, error);
+    }
+
+    //! callback receiving data, append to the chunk's buffer
+    static S3Status GetObjectDataCallback(
+        int bufferSize, const char* buffer, void* cookie) {
+        Chunk* c = reinterpret_cast<Chunk*>(cookie);
+        if (c->buffer.size() + bufferSize > c->size)
+            return S3StatusAbortedByCallback;
+        c->buffer.insert(c->buffer.end(), buffer, buffer + bufferSize);
+        return S3StatusOK;
+    }
+};
+
+//! determine the size of an S3 object with a HEAD request, returns zero on
+//! errors, which then surface in the read stream.
+static uint64_t S3ObjectSize(
+    const std::string& bucket, const std::string& key) {
+    S3BucketContext bucket_context;
+    FillS3BucketContext(bucket_context, bucket);
+
+    struct Result {
+        uint64_t size = 0;
+        S3Status status = S3StatusOK;
+    } result;
+
+    S3ResponseHandler handler;
+    memset(&handler, 0, sizeof(handler));
+
+    handler.propertiesCallback =
+        [](const S3ResponseProperties* properties, void* cookie) {
+            ResponsePropertiesCallback(properties, cookie);
+            reinterpret_cast<Result*>(cookie)->size =
+                properties->contentLength;
+            return S3StatusOK;
+        };
+    handler.completeCallback =
+        [](S3Status status, const S3ErrorDetails* error, void* cookie) {
+            reinterpret_cast<Result*>(cookie)->status = status;
+            if (status != S3StatusOK)
+                LibS3LogError(status, error);
+        };
+
+    S3_head_object(&bucket_context, key.c_str(),
+                   /* request_context */ nullptr, /* timeoutMs */ 0,
+                   &handler, &result);
+
+    return result.status == S3StatusOK ? result.size : 0;
+}
+
+//! size of the ranged requests of S3ParallelReadStream
+static size_t S3ReadChunkSize() {
+    const char* env = getenv("THRILL_S3_CHUNK_SIZE");
+    if (env == nullptr || *env == 0) return 16 * 1024 * 1024;
+
+    uint64_t size;
+    if (!tlx::parse_si_iec_units(env, &size) || size == 0)
+        die("Invalid THRILL_S3_CHUNK_SIZE: " << env);
+    return size;
+}
+
+//! number of concurrent requests of S3ParallelReadStream and S3WriteStream
+static size_t S3Parallel() {
+    const char* env = getenv("THRILL_S3_PARALLEL");
+    if (env == nullptr || *env == 0) return 4;
+
+    char* endptr;
+    size_t parallel = std::strtoul(env, &endptr, 10);
+    if (*endptr != 0)
+        die("Invalid THRILL_S3_PARALLEL: " << env);
+    return parallel;
+}
+
 ReadStreamPtr S3OpenReadStream(
     const std::string& path, const common::Range& range) {
 
@@ -473,6 +738,21 @@ ReadStreamPtr S3OpenReadStream(
     // split uri into host/path
     std::vector<std::string> splitted = tlx::split('/', path_, 2);
 
+    // split large ranges into concurrent requests, open ranges end at the
+    // object size.
+    size_t chunk_size = S3ReadChunkSize();
+    size_t parallel = S3Parallel();
+    if (parallel > 1) {
+        uint64_t end = range.end;
+        if (end == 0) end = S3ObjectSize(splitted[0], splitted[1]);
+
+        if (end > range.begin && end - range.begin > chunk_size) {
+            return tlx::make_counting<S3ParallelReadStream>(
+                splitted[0], splitted[1], range.begin, end - range.begin,
+                chunk_size, parallel);
+        }
+    }
+
     return tlx::make_counting<S3ReadStream>(
         splitted[0], splitted[1],
         /* start_byte */ range.begin,
@@ -481,13 +761,20 @@ ReadStreamPtr S3OpenReadStream(
 
 /******************************************************************************/
 
+/*!
+ * Writes an S3 object as multipart upload. Filled parts are queued and uploaded
+ * by parallel background threads, while the worker continues to produce data.
+ * The writer blocks while parallel parts are queued or in flight, hence the
+ * memory of the stream is bounded by (parallel + 1) * part size. With parallel
+ * = 0 the parts are uploaded synchronously by the writer.
+ */
 class S3WriteStream : public WriteStream
 {
 public:
     S3WriteStream(const std::string& bucket, const std::string& key,
-                  S3PutProperties* put_properties = nullptr)
+                  size_t parallel, S3PutProperties* put_properties = nullptr)
         : bucket_(bucket), key_(key),
-          put_properties_(put_properties) {
+          put_properties_(put_properties), parallel_(parallel) {
 
         S3BucketContext bucket_context;
         FillS3BucketContext(bucket_context, bucket);
@@ -507,6 +794,15 @@ public:
         S3_initiate_multipart(
             &bucket_context, key_.c_str(), put_properties, &handler,
             /* request_context */ nullptr, /* timeoutMs */ 0, this);
+
+        if (status_ != S3StatusOK || upload_id_.empty())
+            die("S3-ERROR initiating multipart upload of " << key_);
+
+        // start uploader threads
+        for (size_t i = 0; i < parallel_; ++i) {
+            threads_.emplace_back(
+                common::CreateThread([this]() { UploadThread(); }));
+        }
     }
 
     ~S3WriteStream() override {
@@ -540,6 +836,19 @@ public:
         if (!buffer_.empty())
             UploadMultipart();
 
+        // wait for the queued and running part uploads
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            finished_ = true;
+            cv_queue_.notify_all();
+        }
+        for (std::thread& t : threads_)
+            t.join();
+        threads_.clear();
+
+        if (status_ != S3StatusOK)
+            die("S3-ERROR during upload: " << S3_get_status_name(status_));
+
         LOG1 << "commit multipart";
 
         // construct commit XML
@@ -609,15 +918,54 @@ private:
     //! output buffer, if this grows to 16 MiB a part upload is initiated.
     std::vector<uint8_t> buffer_;
 
-    //! current upload position in buffer_ or other memory areas
+    //! current upload position of the commit message
     const uint8_t* upload_;
 
     //! end position of upload area
     const uint8_t* upload_end_;
 
-    //! list of ETags of uploaded multiparts
+    //! list of ETags of uploaded multiparts, indexed by sequence number - 1
     std::vector<std::string> part_etag_;
 
+    //! a multipart piece to upload
+    struct Part {
+        //! sequence number of the part
+        int                  seq;
+        //! data of the part
+        std::vector<uint8_t> data;
+        //! current upload position in data
+        const uint8_t        * upload;
+        //! ETag returned by S3
+        std::string          etag;
+        //! status of the upload request
+        S3Status             status = S3StatusOK;
+    };
+
+    //! number of uploader threads
+    size_t parallel_;
+
+    //! uploader threads
+    std::vector<std::thread> threads_;
+
+    //! mutex protecting queue_, busy_, finished_, status_, and part_etag_
+    //! while the uploader threads run
+    std::mutex mutex_;
+
+    //! signals new parts or finished_ to the uploaders
+    std::condition_variable cv_queue_;
+
+    //! signals the writer that a part upload is done
+    std::condition_variable cv_done_;
+
+    //! filled parts waiting for an uploader
+    std::deque<Part> queue_;
+
+    //! number of parts currently uploading
+    size_t busy_ = 0;
+
+    //! flag that no more parts are queued
+    bool finished_ = false;
+
     /**************************************************************************/
 
     //! completion callback, check for errors
@@ -653,9 +1001,69 @@ private:
 
     /**************************************************************************/
 
+    //! hand buffer_ to the uploaders, or upload it synchronously.
     void UploadMultipart() {
-        LOG1 << "S3-INFO - Upload multipart[" << upload_seq_ << "]"
-             << " size " << buffer_.size();
+        Part part;
+        part.seq = upload_seq_++;
+        part.data.swap(buffer_);
+        buffer_.reserve(buffer_max_);
+
+        if (parallel_ == 0) {
+            UploadPart(part);
+            FinishPart(part);
+            return;
+        }
+
+        // wait for a free slot, which bounds the buffered parts
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_done_.wait(lock, [this]() {
+                          return queue_.size() + busy_ < parallel_;
+                      });
+        queue_.emplace_back(std::move(part));
+        cv_queue_.notify_one();
+    }
+
+    //! main function of the uploader threads
+    void UploadThread() {
+        common::NameThisThread("s3-upload");
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            cv_queue_.wait(lock, [this]() {
+                               return !queue_.empty() || finished_;
+                           });
+            if (queue_.empty()) break;
+
+            Part part = std::move(queue_.front());
+            queue_.pop_front();
+            ++busy_;
+            lock.unlock();
+
+            UploadPart(part);
+
+            lock.lock();
+            FinishPart(part);
+            --busy_;
+            cv_done_.notify_one();
+        }
+    }
+
+    //! store the ETag and status of an uploaded part
+    void FinishPart(const Part& part) {
+        if (part.status != S3StatusOK) {
+            status_ = part.status;
+            return;
+        }
+        if (part_etag_.size() < static_cast<size_t>(part.seq))
+            part_etag_.resize(part.seq);
+        part_etag_[part.seq - 1] = part.etag;
+    }
+
+    //! synchronous upload of a multi part piece
+    void UploadPart(Part& part) {
+        LOG1 << "S3-INFO - Upload multipart[" << part.seq << "]"
+             << " size " << part.data.size();
 
         S3BucketContext bucket_context;
         FillS3BucketContext(bucket_context, bucket_);
@@ -665,37 +1073,46 @@ private:
         memset(&handler, 0, sizeof(handler));
 
         handler.responseHandler.propertiesCallback =
-            &S3WriteStream::MultipartPropertiesCallback;
+            &S3WriteStream::PartPropertiesCallback;
         handler.responseHandler.completeCallback =
-            &S3WriteStream::ResponseCompleteCallback;
+            &S3WriteStream::PartCompleteCallback;
         handler.putObjectDataCallback =
-            &S3WriteStream::PutObjectDataCallback;
+            &S3WriteStream::PartDataCallback;
 
-        // synchronous upload of multi part data
-        upload_ = buffer_.data();
-        upload_end_ = buffer_.data() + buffer_.size();
+        part.upload = part.data.data();
         S3_upload_part(&bucket_context, key_.c_str(), put_properties_,
-                       &handler, upload_seq_++, upload_id_.c_str(),
-                       /* partContentLength */ buffer_.size(),
+                       &handler, part.seq, upload_id_.c_str(),
+                       /* partContentLength */ part.data.size(),
                        /* request_context */ nullptr,
-                       /* timeoutMs */ 0, this);
+                       /* timeoutMs */ 0, &part);
+    }
 
-        buffer_.clear();
+    static S3Status PartPropertiesCallback(
+        const S3ResponseProperties* properties, void* cookie) {
+        Part* part = reinterpret_cast<Part*>(cookie);
+        if (properties->eTag != nullptr)
+            part->etag = properties->eTag;
+        // output properties
+        return ResponsePropertiesCallback(properties, nullptr);
     }
 
-    S3Status MultipartPropertiesCallback(
-        const S3ResponseProperties* properties) {
+    static void PartCompleteCallback(
+        S3Status status, const S3ErrorDetails* error, void* cookie) {
+        Part* part = reinterpret_cast<Part*>(cookie);
+        part->status = status;
 
-        part_etag_.emplace_back(properties->eTag);
-        // output properties
-        ResponsePropertiesCallback(properties, nullptr);
-        return S3StatusOK;
+        if (status != S3StatusOK)
+            LibS3LogError(status, error);
     }
 
-    static S3Status MultipartPropertiesCallback(
-        const S3ResponseProperties* properties, void* cookie) {
-        S3WriteStream* t = reinterpret_cast<S3WriteStream*>(cookie);
-        return t->MultipartPropertiesCallback(properties);
+    static int PartDataCallback(int bufferSize, char* buffer, void* cookie) {
+        Part* part = reinterpret_cast<Part*>(cookie);
+        const uint8_t* end = part->data.data() + part->data.size();
+        size_t wb = std::min(
+            static_cast<intptr_t>(bufferSize), end - part->upload);
+        std::copy(part->upload, part->upload + wb, buffer);
+        part->upload += wb;
+        return wb;
     }
 
     int PutObjectDataCallback(int bufferSize, char* buffer) {
@@ -723,7 +1140,8 @@ WriteStreamPtr S3OpenWriteStream(const std::string& path) {
     // split uri into host/path
     std::vector<std::string> splitted = tlx::split('/', path_, 2);
 
-    return tlx::make_counting<S3WriteStream>(splitted[0], splitted[1]);
+    return tlx::make_counting<S3WriteStream>(
+        splitted[0], splitted[1], /* parallel */ S3Parallel());
 }
 
 #else   // !THRILL_HAVE_LIBS3
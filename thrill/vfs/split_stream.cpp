@@ -0,0 +1,669 @@
+/*******************************************************************************
+ * thrill/vfs/split_stream.cpp
+ *
+ * Streams decoding the lines of a byte range of compressed files, which consist
+ * of independently decodable blocks, such that workers can read disjoint
+ * ranges in parallel.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/split_stream.hpp>
+
+#include <thrill/common/logger.hpp>
+
+#include <tlx/define/likely.hpp>
+#include <tlx/die.hpp>
+#include <tlx/string/ends_with.hpp>
+
+#if THRILL_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if THRILL_HAVE_BZIP2
+#include <bzlib.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+/******************************************************************************/
+// SplitLinesReadStream - cuts the decoded blocks of a range at line boundaries
+
+/*!
+ * Base class of the split streams. Subclasses deliver the decoded data of the
+ * file block-wise, starting with the first block which starts in the range,
+ * and mark whether each block is owned by the range. This class skips the
+ * partial first line, if the range does not start the file, delivers the owned
+ * blocks, and the data of further blocks up to the next newline.
+ */
+class SplitLinesReadStream : public virtual ReadStream
+{
+public:
+    explicit SplitLinesReadStream(bool at_file_start)
+        : state_(at_file_start ? State::Own : State::Skip) { }
+
+    ssize_t read(void* data, size_t size) final {
+        char* output = reinterpret_cast<char*>(data);
+        size_t done = 0;
+
+        while (done < size && state_ != State::Done)
+        {
+            if (pos_ == block_.size()) {
+                bool owned;
+                if (!NextBlock(block_, &owned,
+                               /* skip_unowned */ state_ == State::Skip)) {
+                    state_ = State::Done;
+                    break;
+                }
+                pos_ = 0;
+
+                if (!owned) {
+                    // the first newline lies beyond the range: nothing to
+                    // deliver, the previous range delivers the line.
+                    if (state_ == State::Skip) {
+                        state_ = State::Done;
+                        break;
+                    }
+                    state_ = State::Tail;
+                }
+                continue;
+            }
+
+            char* begin = block_.data() + pos_;
+            char* end = block_.data() + block_.size();
+
+            if (state_ == State::Skip) {
+                // drop the partial line, which the previous range delivers
+                char* nl = std::find(begin, end, '\n');
+                pos_ = nl - block_.data();
+                if (nl != end) {
+                    ++pos_;
+                    state_ = State::Own;
+                }
+            }
+            else if (state_ == State::Own) {
+                size_t wb = std::min<size_t>(size - done, end - begin);
+                std::copy(begin, begin + wb, output + done);
+                done += wb, pos_ += wb;
+            }
+            else {
+                // deliver the rest of the last line started in the range
+                char* stop = begin + std::min<size_t>(size - done, end - begin);
+                char* nl = std::find(begin, stop, '\n');
+                if (nl != stop) {
+                    stop = nl + 1;
+                    state_ = State::Done;
+                }
+                std::copy(begin, stop, output + done);
+                done += stop - begin, pos_ += stop - begin;
+            }
+        }
+
+        return done;
+    }
+
+protected:
+    /*!
+     * Decode the next block into block, and set owned if it starts in the
+     * range. If skip_unowned is set and the block is not owned, it need not be
+     * decoded. Returns false at the end of the file.
+     */
+    virtual bool NextBlock(
+        std::vector<char>& block, bool* owned, bool skip_unowned) = 0;
+
+private:
+    //! Skip: dropping the partial first line, Own: delivering owned blocks,
+    //! Tail: delivering up to the next newline, Done: end of stream.
+    enum class State { Skip, Own, Tail, Done };
+
+    //! current state
+    State state_;
+
+    //! current decoded block
+    std::vector<char> block_;
+
+    //! delivered position in block_
+    size_t pos_ = 0;
+};
+
+/******************************************************************************/
+// SplitInput - buffer of raw input data
+
+//! Buffer of raw data read from the range's start offset on.
+class SplitInput
+{
+public:
+    explicit SplitInput(const ReadStreamPtr& input) : input_(input) { }
+
+    //! try to buffer n bytes after the current position, returns the number of
+    //! available bytes, which is less than n only at the end of the file.
+    size_t Want(size_t n) {
+        if (avail() >= n || eof_) return avail();
+
+        // compact buffer
+        buffer_.erase(buffer_.begin(), buffer_.begin() + pos_);
+        pos_ = 0;
+
+        while (avail() < n && !eof_) {
+            size_t old_size = buffer_.size();
+            buffer_.resize(old_size + std::max(n - avail(), size_t(read_size)));
+            ssize_t rb = input_->read(
+                buffer_.data() + old_size, buffer_.size() - old_size);
+            if (rb < 0)
+                die("SplitLinesReadStream: read error");
+            buffer_.resize(old_size + rb);
+            if (rb == 0) eof_ = true;
+        }
+        return avail();
+    }
+
+    //! buffered data at the current position
+    const uint8_t * data() const { return buffer_.data() + pos_; }
+
+    //! number of bytes buffered after the current position
+    size_t avail() const { return buffer_.size() - pos_; }
+
+    //! offset of the current position from the range's begin
+    uint64_t offset() const { return offset_; }
+
+    //! advance the current position by n bytes, which must be buffered.
+    void Skip(size_t n) {
+        assert(n <= avail());
+        pos_ += n, offset_ += n;
+    }
+
+    //! close the input stream
+    void close() { input_->close(); }
+
+private:
+    //! size of reads from input_
+    static constexpr size_t read_size = 1024 * 1024;
+
+    //! raw input stream
+    ReadStreamPtr input_;
+
+    //! buffered data
+    std::vector<uint8_t> buffer_;
+
+    //! current position in buffer_
+    size_t pos_ = 0;
+
+    //! offset of pos_ from the range's begin
+    uint64_t offset_ = 0;
+
+    //! flag that input_ returned EOF
+    bool eof_ = false;
+};
+
+//! size of the range, or infinite if the range has no end
+static uint64_t SplitRangeSize(const common::Range& range) {
+    return range.end == 0 ? std::numeric_limits<uint64_t>::max()
+           : range.size();
+}
+
+/******************************************************************************/
+// PlainSplitStream - ranges of uncompressed files
+
+class PlainSplitStream final : public SplitLinesReadStream
+{
+public:
+    PlainSplitStream(const std::string& path, const common::Range& range)
+        : SplitLinesReadStream(range.begin == 0),
+          input_(OpenRawReadStream(path, common::Range(range.begin, 0))),
+          remain_(SplitRangeSize(range)) { }
+
+    ~PlainSplitStream() {
+        close();
+    }
+
+    void close() final {
+        if (!input_) return;
+        input_->close();
+        input_.reset();
+    }
+
+protected:
+    bool NextBlock(std::vector<char>& block, bool* owned,
+                   bool /* skip_unowned */) final {
+        // cut the block at the end of the range
+        size_t size = remain_ != 0
+                      ? std::min(remain_, uint64_t(block_size)) : block_size;
+        block.resize(size);
+        ssize_t rb = input_->read(block.data(), size);
+        if (rb < 0)
+            die("SplitLinesReadStream: read error");
+        if (rb == 0) return false;
+
+        block.resize(rb);
+        *owned = (remain_ != 0);
+        remain_ -= std::min<uint64_t>(remain_, rb);
+        return true;
+    }
+
+private:
+    //! size of the blocks read
+    static constexpr size_t block_size = 2 * 1024 * 1024;
+
+    //! raw input stream
+    ReadStreamPtr input_;
+
+    //! remaining bytes of the range
+    uint64_t remain_;
+};
+
+/******************************************************************************/
+// BgzfSplitStream - ranges of BGZF files, which are series of small gzip members
+
+//! check for a BGZF member header, returns the size of the member or zero.
+static size_t BgzfMemberSize(const uint8_t* p) {
+    // gzip magic, deflate, FEXTRA; XLEN = 6; subfield 'BC' of length 2
+    if (p[0] != 0x1F || p[1] != 0x8B || p[2] != 0x08 || p[3] != 0x04 ||
+        p[10] != 6 || p[11] != 0 || p[12] != 'B' || p[13] != 'C' ||
+        p[14] != 2 || p[15] != 0)
+        return 0;
+    // BSIZE = total member size - 1
+    return (static_cast<size_t>(p[16]) | (static_cast<size_t>(p[17]) << 8)) + 1;
+}
+
+//! size of a BGZF member header
+static constexpr size_t kBgzfHeaderSize = 18;
+
+#if THRILL_HAVE_ZLIB
+
+class BgzfSplitStream final : public SplitLinesReadStream
+{
+public:
+    BgzfSplitStream(const std::string& path, const common::Range& range)
+        : SplitLinesReadStream(range.begin == 0),
+          input_(OpenRawReadStream(path, common::Range(range.begin, 0))),
+          range_size_(SplitRangeSize(range)),
+          synced_(range.begin == 0) { }
+
+    ~BgzfSplitStream() {
+        close();
+    }
+
+    void close() final {
+        if (closed_) return;
+        input_.close();
+        closed_ = true;
+    }
+
+protected:
+    bool NextBlock(std::vector<char>& block, bool* owned,
+                   bool skip_unowned) final {
+        if (!synced_) {
+            if (!Sync()) return false;
+            synced_ = true;
+        }
+
+        if (input_.Want(kBgzfHeaderSize) < kBgzfHeaderSize) return false;
+
+        size_t size = BgzfMemberSize(input_.data());
+        if (size < kBgzfHeaderSize + 8)
+            die("BgzfSplitStream: invalid BGZF member header");
+        if (input_.Want(size) < size)
+            die("BgzfSplitStream: truncated BGZF member");
+
+        *owned = input_.offset() < range_size_;
+        if (!*owned && skip_unowned) return true;
+
+        const uint8_t* p = input_.data();
+        // ISIZE: decoded size modulo 2^32, at most 64 KiB in BGZF
+        size_t isize =
+            static_cast<size_t>(p[size - 4]) |
+            (static_cast<size_t>(p[size - 3]) << 8) |
+            (static_cast<size_t>(p[size - 2]) << 16) |
+            (static_cast<size_t>(p[size - 1]) << 24);
+        // one more byte, which must remain unused
+        block.resize(isize + 1);
+
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        // windowBits = 15 (largest) + 16 (gzip header)
+        int err = inflateInit2(&z, 15 + 16);
+        die_unequal(err, Z_OK);
+
+        z.next_in = const_cast<Bytef*>(p);
+        z.avail_in = static_cast<uInt>(size);
+        z.next_out = reinterpret_cast<Bytef*>(block.data());
+        z.avail_out = static_cast<uInt>(block.size());
+
+        err = inflate(&z, Z_FINISH);
+        inflateEnd(&z);
+        if (err != Z_STREAM_END || z.avail_out != 1)
+            die("BgzfSplitStream: error decoding BGZF member");
+        block.resize(isize);
+
+        input_.Skip(size);
+        return true;
+    }
+
+private:
+    //! raw input
+    SplitInput input_;
+
+    //! size of the range
+    uint64_t range_size_;
+
+    //! whether input_ is positioned at a member header
+    bool synced_;
+
+    //! whether the input was closed
+    bool closed_ = false;
+
+    //! find the first member header after the range's begin, which is
+    //! confirmed by a following header or the end of the file.
+    bool Sync() {
+        while (true)
+        {
+            size_t avail = input_.Want(kBgzfHeaderSize);
+            if (avail < kBgzfHeaderSize) return false;
+
+            size_t size = BgzfMemberSize(input_.data());
+            if (size >= kBgzfHeaderSize + 8) {
+                size_t next = input_.Want(size + kBgzfHeaderSize);
+                if (next == size ||
+                    (next >= size + kBgzfHeaderSize &&
+                     BgzfMemberSize(input_.data() + size) != 0))
+                    return true;
+            }
+            input_.Skip(1);
+        }
+    }
+};
+
+#endif // THRILL_HAVE_ZLIB
+
+/******************************************************************************/
+// BZip2SplitStream - ranges of bzip2 files, split at block magic numbers
+
+#if THRILL_HAVE_BZIP2
+
+/*!
+ * bzip2 blocks start with a 48-bit magic number, which is not byte aligned.
+ * This stream finds the magic numbers by scanning all bit offsets, and decodes
+ * each block by wrapping it into a single-block bzip2 stream, like bzip2recover
+ * does: a header, the block's bits, the end-of-stream magic, and the stream
+ * CRC, which equals the block's CRC for a single block. Concatenated bzip2
+ * streams, as written by pbzip2, are handled by skipping end-of-stream magics.
+ */
+class BZip2SplitStream final : public SplitLinesReadStream
+{
+    static constexpr bool debug = false;
+
+public:
+    BZip2SplitStream(const std::string& path, const common::Range& range)
+        : SplitLinesReadStream(range.begin == 0),
+          input_(OpenRawReadStream(path, common::Range(range.begin, 0))),
+          range_size_(SplitRangeSize(range)) {
+        InitTable();
+    }
+
+    ~BZip2SplitStream() {
+        close();
+    }
+
+    void close() final {
+        if (closed_) return;
+        input_.close();
+        closed_ = true;
+    }
+
+protected:
+    bool NextBlock(std::vector<char>& block, bool* owned,
+                   bool skip_unowned) final {
+        bool eos;
+        if (!have_block_) {
+            // find the next block magic, skipping end-of-stream magics
+            uint64_t from = search_bit_;
+            do {
+                if (!FindMagic(from, &block_bit_, &eos)) return false;
+                from = block_bit_ + 48;
+            } while (eos);
+            have_block_ = true;
+        }
+
+        *owned = block_bit_ / 8 < range_size_;
+        if (!*owned && skip_unowned) return true;
+
+        uint64_t end_bit;
+        if (!FindMagic(block_bit_ + 48, &end_bit, &eos))
+            die("BZip2SplitStream: truncated bzip2 block");
+
+        sLOG << "BZip2SplitStream: block at bit" << block_bit_
+             << "size" << (end_bit - block_bit_) / 8 << "owned" << *owned;
+
+        DecodeBlock(block_bit_, end_bit, block);
+
+        if (eos) {
+            have_block_ = false;
+            search_bit_ = end_bit + 48;
+        }
+        else {
+            block_bit_ = end_bit;
+        }
+
+        // discard input before next block or search position
+        uint64_t keep = (have_block_ ? block_bit_ : search_bit_) / 8;
+        input_.Skip(keep - input_.offset());
+        return true;
+    }
+
+private:
+    //! magic number starting a block (BCD pi)
+    static constexpr uint64_t kBlockMagic = 0x314159265359ull;
+
+    //! magic number ending a stream (BCD sqrt(pi))
+    static constexpr uint64_t kEosMagic = 0x177245385090ull;
+
+    //! raw input
+    SplitInput input_;
+
+    //! size of the range
+    uint64_t range_size_;
+
+    //! bit offset of the current block's magic, if have_block_
+    uint64_t block_bit_ = 0;
+
+    //! bit offset to search the next block from, if !have_block_
+    uint64_t search_bit_ = 0;
+
+    //! whether block_bit_ is valid
+    bool have_block_ = false;
+
+    //! whether the input was closed
+    bool closed_ = false;
+
+    //! candidate bit shifts of the magics for the second byte at or after a
+    //! magic's start: bits 0-7 for kBlockMagic and bits 8-15 for kEosMagic.
+    uint16_t table_[256];
+
+    //! decoding buffer: the block wrapped as bzip2 stream
+    std::vector<char> stream_;
+
+    void InitTable() {
+        std::fill(table_, table_ + 256, 0);
+        for (unsigned s = 0; s < 8; ++s) {
+            table_[(kBlockMagic >> (32 + s)) & 0xFF] |= (1u << s);
+            table_[(kEosMagic >> (32 + s)) & 0xFF] |= (1u << (8 + s));
+        }
+    }
+
+    //! read the 64 bits starting at byte p big-endian
+    static uint64_t Load64(const uint8_t* p) {
+        uint64_t w = 0;
+        for (size_t i = 0; i < 8; ++i) w = (w << 8) | p[i];
+        return w;
+    }
+
+    /*!
+     * Find the first block or end-of-stream magic which starts at bit offset
+     * from or later. Returns false if the file ends without one.
+     */
+    bool FindMagic(uint64_t from, uint64_t* pos, bool* eos) {
+        uint64_t byte = from / 8;
+        unsigned min_shift = from % 8;
+
+        while (true)
+        {
+            assert(byte >= input_.offset());
+            size_t rel = byte - input_.offset();
+            size_t avail = input_.Want(rel + 8 + 64 * 1024);
+            if (avail < rel + 8) return false;
+
+            const uint8_t* data = input_.data();
+            for ( ; rel + 8 <= avail; ++rel, min_shift = 0)
+            {
+                unsigned cand = table_[data[rel + 1]];
+                if (TLX_LIKELY(cand == 0)) continue;
+
+                uint64_t w = Load64(data + rel);
+                for (unsigned s = min_shift; s < 8; ++s) {
+                    uint64_t v = (w >> (16 - s)) & 0xFFFFFFFFFFFFull;
+                    if ((cand & (1u << s)) && v == kBlockMagic) {
+                        *pos = 8 * (input_.offset() + rel) + s;
+                        *eos = false;
+                        return true;
+                    }
+                    if ((cand & (1u << (8 + s))) && v == kEosMagic) {
+                        *pos = 8 * (input_.offset() + rel) + s;
+                        *eos = true;
+                        return true;
+                    }
+                }
+            }
+            byte = input_.offset() + rel;
+        }
+    }
+
+    //! read n <= 32 bits starting at bit offset pos
+    uint32_t GetBits(uint64_t pos, unsigned n) const {
+        const uint8_t* p = input_.data() + (pos / 8 - input_.offset());
+        uint64_t w = Load64(p);
+        return static_cast<uint32_t>(
+            (w >> (64 - n - pos % 8)) & ((uint64_t(1) << n) - 1));
+    }
+
+    //! decode the block in bits [begin,end) into block
+    void DecodeBlock(uint64_t begin, uint64_t end, std::vector<char>& block) {
+        // FindMagic() buffered the 8 bytes following the block
+        uint32_t crc = GetBits(begin + 48, 32);
+
+        // wrap block into a bzip2 stream
+        stream_.clear();
+        stream_.insert(stream_.end(), { 'B', 'Z', 'h', '9' });
+
+        uint64_t acc = 0;
+        unsigned bits = 0;
+        auto put_bits =
+            [&](uint64_t v, unsigned n) {
+                acc = (acc << n) | v, bits += n;
+                while (bits >= 8) {
+                    bits -= 8;
+                    stream_.push_back(static_cast<char>(acc >> bits));
+                }
+            };
+
+        uint64_t pos = begin;
+        for ( ; pos + 32 <= end; pos += 32) put_bits(GetBits(pos, 32), 32);
+        if (pos < end)
+            put_bits(GetBits(pos, end - pos), static_cast<unsigned>(end - pos));
+        put_bits(kEosMagic, 48);
+        put_bits(crc, 32);
+        if (bits != 0) put_bits(0, 8 - bits);
+
+        // decompress
+        bz_stream bz;
+        memset(&bz, 0, sizeof(bz));
+        int err = BZ2_bzDecompressInit(&bz, /* verbosity */ 0, /* small */ 0);
+        die_unequal(err, BZ_OK);
+
+        bz.next_in = stream_.data();
+        bz.avail_in = static_cast<unsigned>(stream_.size());
+
+        block.resize(std::max<size_t>(block.capacity(), 1024 * 1024));
+        size_t produced = 0;
+        while (true)
+        {
+            bz.next_out = block.data() + produced;
+            bz.avail_out = static_cast<unsigned>(block.size() - produced);
+            err = BZ2_bzDecompress(&bz);
+            produced = block.size() - bz.avail_out;
+
+            if (err == BZ_STREAM_END) break;
+            if (err != BZ_OK)
+                die("BZip2SplitStream: error " << err << " decoding block");
+            if (bz.avail_out == 0)
+                block.resize(2 * block.size());
+            else if (bz.avail_in == 0)
+                die("BZip2SplitStream: truncated block");
+        }
+        BZ2_bzDecompressEnd(&bz);
+
+        block.resize(produced);
+    }
+};
+
+#endif // THRILL_HAVE_BZIP2
+
+/******************************************************************************/
+
+bool IsSplittable(const std::string& path) {
+    if (tlx::ends_with(path, ".bz2")) {
+#if THRILL_HAVE_BZIP2
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    if (tlx::ends_with(path, ".gz")) {
+#if THRILL_HAVE_ZLIB
+        // check for BGZF header
+        ReadStreamPtr rs = OpenRawReadStream(path);
+        uint8_t header[kBgzfHeaderSize];
+        size_t size = 0;
+        ssize_t rb;
+        while (size < kBgzfHeaderSize &&
+               (rb = rs->read(header + size, kBgzfHeaderSize - size)) > 0)
+            size += rb;
+        rs->close();
+        return size == kBgzfHeaderSize && BgzfMemberSize(header) != 0;
+#else
+        return false;
+#endif
+    }
+
+    return !IsCompressed(path);
+}
+
+ReadStreamPtr OpenSplitLinesReadStream(
+    const std::string& path, const common::Range& range) {
+#if THRILL_HAVE_BZIP2
+    if (tlx::ends_with(path, ".bz2"))
+        return tlx::make_counting<BZip2SplitStream>(path, range);
+#endif
+#if THRILL_HAVE_ZLIB
+    if (tlx::ends_with(path, ".gz"))
+        return tlx::make_counting<BgzfSplitStream>(path, range);
+#endif
+    die_unless(!IsCompressed(path));
+    return tlx::make_counting<PlainSplitStream>(path, range);
+}
+
+} // namespace vfs
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,52 @@
+/*******************************************************************************
+ * thrill/vfs/split_stream.hpp
+ *
+ * Streams decoding the lines of a byte range of compressed files, which consist
+ * of independently decodable blocks, such that workers can read disjoint
+ * ranges in parallel.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_VFS_SPLIT_STREAM_HEADER
+#define THRILL_VFS_SPLIT_STREAM_HEADER
+
+#include <thrill/vfs/file_io.hpp>
+
+#include <string>
+
+namespace thrill {
+namespace vfs {
+
+/*!
+ * Returns true if the file at path can be read in byte ranges with
+ * OpenSplitLinesReadStream(). These are uncompressed files, bzip2 files, whose
+ * blocks are found by their magic numbers, and .gz files in the BGZF format
+ * written by bgzip, which are series of small gzip members. For .gz files the
+ * first bytes are read to check for the BGZF header.
+ */
+bool IsSplittable(const std::string& path);
+
+/*!
+ * Open a stream delivering the lines of the file at path which belong to the
+ * byte range [b,e) of the raw (compressed) file. The file is decoded in units
+ * of blocks: bzip2 blocks, BGZF members, or the raw bytes for uncompressed
+ * files. The range owns all blocks which start at a byte in [b,e), and the
+ * lines starting in the decoded data of these blocks: if the range does not
+ * start the file, the stream skips data up to the first newline like the
+ * uncompressed ReadLines does, and it continues to deliver data after the
+ * range's last block up to the next newline. Hence, the streams of a partition
+ * of the file into ranges deliver each line exactly once, and in order.
+ */
+ReadStreamPtr OpenSplitLinesReadStream(
+    const std::string& path, const common::Range& range);
+
+} // namespace vfs
+} // namespace thrill
+
+#endif // !THRILL_VFS_SPLIT_STREAM_HEADER
+
+/******************************************************************************/
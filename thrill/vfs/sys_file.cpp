@@ -15,6 +15,7 @@
 #include <thrill/common/porting.hpp>
 #include <thrill/common/string.hpp>
 #include <thrill/common/system_exception.hpp>
+#include <thrill/vfs/direct_file.hpp>
 #include <thrill/vfs/simple_glob.hpp>
 
 #include <tlx/die.hpp>
@@ -44,7 +45,11 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace thrill {
@@ -52,6 +57,42 @@ namespace vfs {
 
 /******************************************************************************/
 
+/*!
+ * stat() all paths of the list into stats and return the errno of each call,
+ * or zero. Long lists are processed by multiple threads, since on network file
+ * systems each stat() is a round trip to the metadata server.
+ */
+static std::vector<int> SysStatList(const std::vector<std::string>& list,
+                                    std::vector<struct stat>& stats) {
+    static constexpr size_t min_per_thread = 64;
+    static constexpr size_t max_threads = 16;
+
+    stats.resize(list.size());
+    std::vector<int> errors(list.size(), 0);
+
+    std::atomic<size_t> next { 0 };
+    auto worker =
+        [&]() {
+            size_t i;
+            while ((i = next++) < list.size()) {
+                if (::stat(list[i].c_str(), &stats[i]) != 0)
+                    errors[i] = errno;
+            }
+        };
+
+    size_t num_threads =
+        std::min(list.size() / min_per_thread, max_threads);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& t : threads)
+        t.join();
+
+    return errors;
+}
+
 static void SysGlobWalkRecursive(const std::string& path, FileList& filelist) {
 #if defined(_MSC_VER)
 
@@ -106,7 +147,6 @@ static void SysGlobWalkRecursive(const std::string& path, FileList& filelist) {
         throw common::ErrnoException("Could not read directory " + path);
 
     struct dirent* de;
-    struct stat st;
 
     std::vector<std::string> list;
 
@@ -122,9 +162,14 @@ static void SysGlobWalkRecursive(const std::string& path, FileList& filelist) {
     // sort file names
     std::sort(list.begin(), list.end());
 
-    for (const std::string& entry : list) {
-        if (stat(entry.c_str(), &st) != 0)
-            throw common::ErrnoException("Could not lstat() " + entry);
+    std::vector<struct stat> stats;
+    std::vector<int> errors = SysStatList(list, stats);
+
+    for (size_t i = 0; i < list.size(); ++i) {
+        const std::string& entry = list[i];
+        const struct stat& st = stats[i];
+        if (errors[i] != 0)
+            throw common::ErrnoException("Could not stat() " + entry, errors[i]);
 
         if (S_ISDIR(st.st_mode)) {
             // descend into directories
@@ -135,6 +180,7 @@ static void SysGlobWalkRecursive(const std::string& path, FileList& filelist) {
             fi.type = Type::File;
             fi.path = entry;
             fi.size = static_cast<uint64_t>(st.st_size);
+            fi.mtime = static_cast<uint64_t>(st.st_mtime);
             filelist.emplace_back(fi);
         }
     }
@@ -167,10 +213,14 @@ void SysGlob(const std::string& path, const GlobType& gtype,
     std::sort(list.begin(), list.end());
 
     // stat files to collect size information
-    struct stat filestat;
-    for (const std::string& file : list)
+    std::vector<struct stat> stats;
+    std::vector<int> errors = SysStatList(list, stats);
+
+    for (size_t i = 0; i < list.size(); ++i)
     {
-        if (::stat(file.c_str(), &filestat) != 0) {
+        const std::string& file = list[i];
+        const struct stat& filestat = stats[i];
+        if (errors[i] != 0) {
             die("ERROR: could not stat() path " + file);
         }
 
@@ -180,6 +230,7 @@ void SysGlob(const std::string& path, const GlobType& gtype,
                 fi.type = Type::File;
                 fi.path = file;
                 fi.size = static_cast<uint64_t>(filestat.st_size);
+                fi.mtime = static_cast<uint64_t>(filestat.st_mtime);
                 filelist.emplace_back(fi);
             }
         }
@@ -320,6 +371,19 @@ void SysFile::close() {
 
 /******************************************************************************/
 
+//! number of outstanding O_DIRECT requests per uncompressed file stream, zero
+//! to use the page cache.
+static size_t SysDirectIo() {
+    const char* env = getenv("THRILL_DIRECT_IO");
+    if (env == nullptr || *env == 0) return 0;
+
+    char* endptr;
+    size_t depth = std::strtoul(env, &endptr, 10);
+    if (*endptr != 0)
+        die("Invalid THRILL_DIRECT_IO: " << env);
+    return depth;
+}
+
 ReadStreamPtr SysOpenReadStream(
     const std::string& path, const common::Range& range) {
 
@@ -342,11 +406,19 @@ ReadStreamPtr SysOpenReadStream(
     else if (tlx::ends_with(path, ".lzo")) {
         decompressor = "lzop";
     }
+    // with liblz4, OpenReadStream() decodes .lz4 with LZ4ReadFilter
+#if !THRILL_HAVE_LZ4
     else if (tlx::ends_with(path, ".lz4")) {
         decompressor = "lz4";
     }
+#endif
     else {
         // not a compressed file
+        if (size_t depth = SysDirectIo()) {
+            ::close(fd);
+            return SysOpenDirectReadStream(path, range, depth);
+        }
+
         common::PortSetCloseOnExec(fd);
 
         sLOG << "SysFile::OpenForRead(): filefd" << fd;
@@ -432,11 +504,19 @@ WriteStreamPtr SysOpenWriteStream(const std::string& path) {
     else if (tlx::ends_with(path, ".lzo")) {
         compressor = "lzop";
     }
+    // with liblz4, OpenWriteStream() encodes .lz4 with LZ4WriteFilter
+#if !THRILL_HAVE_LZ4
     else if (tlx::ends_with(path, ".lz4")) {
         compressor = "lz4";
     }
+#endif
     else {
         // not a compressed file
+        if (size_t depth = SysDirectIo()) {
+            ::close(fd);
+            return SysOpenDirectWriteStream(path, depth);
+        }
+
         common::PortSetCloseOnExec(fd);
 
         sLOG << "SysFile::OpenForWrite(): filefd" << fd;
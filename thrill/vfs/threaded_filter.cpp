@@ -0,0 +1,202 @@
+/*******************************************************************************
+ * thrill/vfs/threaded_filter.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/threaded_filter.hpp>
+
+#include <thrill/common/porting.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+/******************************************************************************/
+// ThreadedReadFilter - reads the input stream on a helper thread
+
+/*!
+ * Reads the input stream on a helper thread into two alternating buffers. While
+ * the consumer copies data out of one buffer, the helper thread fills the
+ * other, hence a decompressing input such as GZipReadFilter runs concurrently
+ * to the worker parsing its output. Exceptions of the input stream are
+ * rethrown by read().
+ */
+class ThreadedReadFilter final : public virtual ReadStream
+{
+public:
+    ThreadedReadFilter(const ReadStreamPtr& input, size_t buffer_size)
+        : input_(input) {
+        for (size_t i = 0; i < 2; ++i)
+            buffer_[i].data.resize(std::max<size_t>(buffer_size, 1));
+        thread_ = common::CreateThread([this]() { Worker(); });
+    }
+
+    ~ThreadedReadFilter() {
+        close();
+    }
+
+    ssize_t read(void* data, size_t size) final {
+        char* out = reinterpret_cast<char*>(data);
+        size_t done = 0;
+
+        while (done < size)
+        {
+            if (!acquired_) {
+                // wait for the helper thread to fill the next buffer
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!buffer_[current_].full && !eof_ && !error_)
+                    cv_.wait(lock);
+
+                if (!buffer_[current_].full) {
+                    if (error_)
+                        std::rethrow_exception(error_);
+                    break;
+                }
+                acquired_ = true;
+            }
+
+            Buffer& b = buffer_[current_];
+            size_t n = std::min(size - done, b.size - b.pos);
+            std::copy(b.data.data() + b.pos, b.data.data() + b.pos + n,
+                      out + done);
+            b.pos += n, done += n;
+
+            if (b.pos == b.size) {
+                // return consumed buffer to the helper thread
+                std::unique_lock<std::mutex> lock(mutex_);
+                b.full = false;
+                cv_.notify_all();
+                current_ ^= 1;
+                acquired_ = false;
+            }
+        }
+
+        return done;
+    }
+
+    void close() final {
+        if (closed_) return;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        terminate_ = true;
+        cv_.notify_all();
+        lock.unlock();
+
+        thread_.join();
+        input_->close();
+
+        closed_ = true;
+    }
+
+private:
+    //! one of the two alternating buffers
+    struct Buffer {
+        //! buffer memory
+        std::vector<char> data;
+        //! bytes filled by the helper thread
+        size_t            size = 0;
+        //! bytes consumed by read()
+        size_t            pos = 0;
+        //! whether the buffer belongs to the consumer
+        bool              full = false;
+    };
+
+    //! input stream for reading data from somewhere
+    ReadStreamPtr input_;
+
+    //! double buffers
+    Buffer buffer_[2];
+
+    //! buffer currently read by the consumer
+    size_t current_ = 0;
+
+    //! whether the consumer holds the full buffer current_
+    bool acquired_ = false;
+
+    //! helper thread reading the input
+    std::thread thread_;
+
+    //! mutex protecting the full flags and the following flags
+    std::mutex mutex_;
+
+    //! signals filled or consumed buffers
+    std::condition_variable cv_;
+
+    //! whether the input is exhausted
+    bool eof_ = false;
+
+    //! exception thrown by the input stream
+    std::exception_ptr error_;
+
+    //! termination flag
+    bool terminate_ = false;
+
+    //! if the stream was closed
+    bool closed_ = false;
+
+    //! main function of the helper thread
+    void Worker() {
+        common::NameThisThread("vfs-read-ahead");
+
+        size_t next = 0;
+        while (true)
+        {
+            Buffer& b = buffer_[next];
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (b.full && !terminate_)
+                    cv_.wait(lock);
+                if (terminate_) return;
+            }
+
+            // fill the buffer completely, unless the input ends
+            size_t size = 0;
+            try {
+                while (size < b.data.size()) {
+                    ssize_t rb = input_->read(
+                        b.data.data() + size, b.data.size() - size);
+                    if (rb <= 0) break;
+                    size += rb;
+                }
+            }
+            catch (...) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                error_ = std::current_exception();
+                cv_.notify_all();
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (size == 0) {
+                eof_ = true;
+                cv_.notify_all();
+                return;
+            }
+            b.size = size, b.pos = 0, b.full = true;
+            cv_.notify_all();
+            next ^= 1;
+        }
+    }
+};
+
+ReadStreamPtr MakeThreadedReadFilter(
+    const ReadStreamPtr& stream, size_t buffer_size) {
+    die_unless(stream);
+    return tlx::make_counting<ThreadedReadFilter>(stream, buffer_size);
+}
+
+} // namespace vfs
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,29 @@
+/*******************************************************************************
+ * thrill/vfs/threaded_filter.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_VFS_THREADED_FILTER_HEADER
+#define THRILL_VFS_THREADED_FILTER_HEADER
+
+#include <thrill/vfs/file_io.hpp>
+
+namespace thrill {
+namespace vfs {
+
+//! Construct a reader which reads the stream on a helper thread into two
+//! alternating buffers of buffer_size bytes, such that a decompressing stream
+//! runs concurrently to the consumer.
+ReadStreamPtr MakeThreadedReadFilter(
+    const ReadStreamPtr& stream, size_t buffer_size = 2 * 1024 * 1024);
+
+} // namespace vfs
+} // namespace thrill
+
+#endif // !THRILL_VFS_THREADED_FILTER_HEADER
+
+/******************************************************************************/
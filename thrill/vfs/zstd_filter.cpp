@@ -0,0 +1,197 @@
+/*******************************************************************************
+ * thrill/vfs/zstd_filter.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/zstd_filter.hpp>
+
+#include <tlx/die.hpp>
+
+#if THRILL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+#if THRILL_HAVE_ZSTD
+
+/******************************************************************************/
+// ZStdWriteFilter - on-the-fly zstd compressor
+
+class ZStdWriteFilter final : public virtual WriteStream
+{
+public:
+    ZStdWriteFilter(const WriteStreamPtr& output, size_t num_threads)
+        : output_(output) {
+        cctx_ = ZSTD_createCCtx();
+        die_unless(cctx_);
+
+        size_t err = ZSTD_CCtx_setParameter(
+            cctx_, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+        die_unless(!ZSTD_isError(err));
+
+        // fails if libzstd was built without multithreading, which is fine.
+        if (num_threads > 1) {
+            ZSTD_CCtx_setParameter(
+                cctx_, ZSTD_c_nbWorkers, static_cast<int>(num_threads));
+        }
+
+        // output buffer
+        buffer_.resize(ZSTD_CStreamOutSize());
+    }
+
+    ~ZStdWriteFilter() {
+        close();
+    }
+
+    ssize_t write(const void* data, const size_t size) final {
+        ZSTD_inBuffer in = { data, size, 0 };
+
+        while (in.pos != in.size)
+            Compress(in, ZSTD_e_continue);
+
+        return size;
+    }
+
+    void close() final {
+        if (!cctx_) return;
+
+        ZSTD_inBuffer in = { nullptr, 0, 0 };
+        while (Compress(in, ZSTD_e_end) != 0) { }
+
+        output_->close();
+
+        ZSTD_freeCCtx(cctx_);
+        cctx_ = nullptr;
+    }
+
+private:
+    //! zstd context
+    ZSTD_CCtx* cctx_;
+
+    //! compression buffer, flushed to output after each call
+    std::vector<char> buffer_;
+
+    //! output stream for writing data somewhere
+    WriteStreamPtr output_;
+
+    //! run compressor once, write output, return the bytes left to flush.
+    size_t Compress(ZSTD_inBuffer& in, ZSTD_EndDirective mode) {
+        ZSTD_outBuffer out = { buffer_.data(), buffer_.size(), 0 };
+
+        size_t remain = ZSTD_compressStream2(cctx_, &out, &in, mode);
+        if (ZSTD_isError(remain)) {
+            die("ZStdWriteFilter: " << ZSTD_getErrorName(remain) <<
+                " while compressing");
+        }
+
+        if (out.pos != 0)
+            output_->write(buffer_.data(), out.pos);
+
+        return remain;
+    }
+};
+
+WriteStreamPtr MakeZStdWriteFilter(
+    const WriteStreamPtr& stream, size_t num_threads) {
+    die_unless(stream);
+    return tlx::make_counting<ZStdWriteFilter>(stream, num_threads);
+}
+
+/******************************************************************************/
+// ZStdReadFilter - on-the-fly zstd decompressor
+
+class ZStdReadFilter : public virtual ReadStream
+{
+public:
+    explicit ZStdReadFilter(const ReadStreamPtr& input)
+        : input_(input) {
+        dctx_ = ZSTD_createDCtx();
+        die_unless(dctx_);
+
+        // input buffer
+        buffer_.resize(ZSTD_DStreamInSize());
+        in_ = { buffer_.data(), 0, 0 };
+    }
+
+    ~ZStdReadFilter() {
+        close();
+    }
+
+    ssize_t read(void* data, size_t size) final {
+        ZSTD_outBuffer out = { data, size, 0 };
+
+        while (out.pos != out.size)
+        {
+            if (in_.pos == in_.size) {
+                // input buffer empty, so read from input_
+                ssize_t rb = input_->read(buffer_.data(), buffer_.size());
+                if (rb <= 0) break;
+                in_.size = rb, in_.pos = 0;
+            }
+
+            // continues with the next frame after the end of one
+            size_t err = ZSTD_decompressStream(dctx_, &out, &in_);
+            if (ZSTD_isError(err)) {
+                die("ZStdReadFilter: " << ZSTD_getErrorName(err) <<
+                    " while decompressing");
+            }
+        }
+
+        return out.pos;
+    }
+
+    void close() final {
+        if (!dctx_) return;
+
+        ZSTD_freeDCtx(dctx_);
+        input_->close();
+
+        dctx_ = nullptr;
+    }
+
+private:
+    //! zstd context
+    ZSTD_DCtx* dctx_;
+
+    //! decompression buffer, filled from the input when empty
+    std::vector<char> buffer_;
+
+    //! current position in buffer_
+    ZSTD_inBuffer in_;
+
+    //! input stream for reading data from somewhere
+    ReadStreamPtr input_;
+};
+
+ReadStreamPtr MakeZStdReadFilter(const ReadStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<ZStdReadFilter>(stream);
+}
+
+/******************************************************************************/
+
+#else   // !THRILL_HAVE_ZSTD
+
+WriteStreamPtr MakeZStdWriteFilter(const WriteStreamPtr&, size_t) {
+    die(".zst compression is not available, "
+        "because Thrill was built without libzstd.");
+}
+
+ReadStreamPtr MakeZStdReadFilter(const ReadStreamPtr&) {
+    die(".zst decompression is not available, "
+        "because Thrill was built without libzstd.");
+}
+
+#endif
+
+} // namespace vfs
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,32 @@
+/*******************************************************************************
+ * thrill/vfs/zstd_filter.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_VFS_ZSTD_FILTER_HEADER
+#define THRILL_VFS_ZSTD_FILTER_HEADER
+
+#include <thrill/vfs/file_io.hpp>
+
+#include <string>
+
+namespace thrill {
+namespace vfs {
+
+ReadStreamPtr MakeZStdReadFilter(const ReadStreamPtr& stream);
+
+//! Construct a zstd compressor, which uses num_threads worker threads of
+//! libzstd if it was built with multithreading support.
+WriteStreamPtr MakeZStdWriteFilter(
+    const WriteStreamPtr& stream, size_t num_threads = 0);
+
+} // namespace vfs
+} // namespace thrill
+
+#endif // !THRILL_VFS_ZSTD_FILTER_HEADER
+
+/******************************************************************************/